@@ -1165,6 +1165,32 @@ int bsp_psram_auto_calib(char *name, uint8_t *sck, uint8_t *dqs)
     return -1;
 }
 
+/**
+ * @brief PSRAM set sck and dqs delay.
+ * @param name name of PSRAM controller.
+ * @param sck sck delay.
+ * @param dqs dqs delay.
+ * @return 0 if success.
+ */
+int bsp_psram_set_delay(char *name, uint8_t sck, uint8_t dqs)
+{
+    return -1;
+}
+
+/**
+ * @brief Get PSRAM memory base address.
+ * @param name name of PSRAM controller.
+ * @return base address, 0 if not found.
+ */
+uint32_t bsp_psram_get_base(char *name)
+{
+    int i = psram_name2id(name);
+    if (i < 0)
+        return 0;
+
+    return bf0_psram_cfg[i].base_addr;
+}
+
 /**
  * @brief Wait psram hardware idle.
  * @return none.
@@ -1506,6 +1532,45 @@ int bsp_psram_auto_calib(char *name, uint8_t *sck, uint8_t *dqs)
     return -1;
 }
 
+/**
+ * @brief PSRAM set sck and dqs delay, e.g. restore result of bsp_psram_auto_calib.
+ * @param name name of PSRAM controller.
+ * @param sck sck delay.
+ * @param dqs dqs delay.
+ * @return 0 if success.
+ */
+int bsp_psram_set_delay(char *name, uint8_t sck, uint8_t dqs)
+{
+    int i = psram_name2id(name);
+    if (i < 0)
+        return -1;
+
+#if defined(SF32LB56X) || defined(SF32LB52X)
+    HAL_MPI_SET_DQS_DELAY(&bf0_psram_handle[i].qspi_handle, dqs);
+    HAL_MPI_SET_SCK(&bf0_psram_handle[i].qspi_handle, sck, 0);
+    /* same settle time as after auto calibration */
+    HAL_Delay_us(50);
+
+    return 0;
+#endif
+
+    return -1;
+}
+
+/**
+ * @brief Get PSRAM memory base address.
+ * @param name name of PSRAM controller.
+ * @return base address, 0 if not found.
+ */
+uint32_t bsp_psram_get_base(char *name)
+{
+    int i = psram_name2id(name);
+    if (i < 0)
+        return 0;
+
+    return bf0_psram_cfg[i].base_addr;
+}
+
 /**
  * @brief Wait psram hardware idle.
  * @return none.
@@ -212,6 +212,22 @@ void BSP_GPIO_Set(int pin, int val, int is_porta);
     */
     int bsp_psram_auto_calib(char *name, uint8_t *sck, uint8_t *dqs);
 
+    /**
+    * @brief PSRAM set sck and dqs delay.
+    * @param name name of PSRAM controller.
+    * @param sck sck delay.
+    * @param dqs dqs delay.
+    * @return 0 if success.
+    */
+    int bsp_psram_set_delay(char *name, uint8_t sck, uint8_t dqs);
+
+    /**
+    * @brief Get PSRAM memory base address.
+    * @param name name of PSRAM controller.
+    * @return base address, 0 if not found.
+    */
+    uint32_t bsp_psram_get_base(char *name);
+
     /**
     * @brief Wait psram hardware idle.
     * @return none.
@@ -228,6 +244,8 @@ void BSP_GPIO_Set(int pin, int val, int is_porta);
     #define bsp_psram_exit_low_power(name) -1
     #define bsp_psram_set_pasr(name,top,deno) -1
     #define bsp_psram_auto_calib(name,sck,dqs) -1
+    #define bsp_psram_set_delay(name,sck,dqs) -1
+    #define bsp_psram_get_base(name) 0
     #define bsp_psram_wait_idle(name)
 
 #endif
@@ -95,6 +95,11 @@ rt_timer_t p_timer;
 
 static datac_handle_t pin_irq_service = DATA_CLIENT_INVALID_HANDLE;
 static uint8_t pin_irq_service_connect_state = 0; // 0 - not connect, 1 - connecting, 2 - connected, 3 - connect error
+static int32_t quad_steps;
+
+#ifndef ENCODE_BATCH_MS
+    #define ENCODE_BATCH_MS 30
+#endif
 
 static rt_err_t dk05e01t_f412_init(rt_device_t dev)
 {
@@ -120,36 +125,17 @@ static rt_size_t wheel_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size
 
 static int irq_pin_service_callback(data_callback_arg_t *arg)
 {
-    if (MSG_SERVICE_DATA_NTF_IND == arg->msg_id)
+    if (PIN_MSG_BATCH_IND == arg->msg_id)
     {
-        rt_err_t ret;
-        pin_common_msg_t pin_msg;
-        RT_ASSERT(arg != NULL);
-        RT_ASSERT(sizeof(pin_common_msg_t) == arg->data_len);
-        memcpy(&pin_msg, arg->data, arg->data_len);
-        RT_ASSERT(pin_msg.id == ENCODE_INPUT_PIN_A);
-        LOG_I("wheel irq_pin_service ntf ind");
-        if (1 == rt_pin_read(ENCODE_INPUT_PIN_A))
-        {
-            int b = rt_pin_read(ENCODE_INPUT_PIN_B);
-            if (0 == b)
-                diff ++;
-            else
-                diff --;
-            LOG_D("wheel pinB=%d", b);
-        }
-        else
-        {
-            //Invalid pinA state, ignore it.
-            LOG_D("wheel invalid");
-        }
-        data_msg_t msg;
-        pin_common_msg_t *p_pin_msg;
-        p_pin_msg = (pin_common_msg_t *) data_service_init_msg(&msg, PIN_MSG_ENABLE_IRQ_REQ, sizeof(pin_common_msg_t));
-        p_pin_msg->id = ENCODE_INPUT_PIN_A;
-
-        ret = datac_send_msg(pin_irq_service, &msg);
-        LOG_I("wheel irq on ret %d", ret);
+        pin_batch_msg_t *batch = (pin_batch_msg_t *)arg->data;
+        RT_ASSERT(batch != NULL);
+        RT_ASSERT(batch->id == ENCODE_INPUT_PIN_A);
+
+        /* 4 quadrature transitions per detent, keep the remainder for next batch */
+        quad_steps += batch->quad_steps;
+        diff += quad_steps / 4;
+        quad_steps %= 4;
+        LOG_D("wheel edges=%d steps=%d", batch->edges, batch->quad_steps);
     }
     else if (MSG_SERVICE_SUBSCRIBE_RSP == arg->msg_id)
     {
@@ -210,10 +196,14 @@ static rt_err_t wheel_open(struct rt_device *dev, rt_uint16_t oflag)
 
     pin_config_msg_t config;
 
+    /* Both phases decoded by pin service, steps are pushed once every ENCODE_BATCH_MS instead of one message per edge */
+    memset(&config, 0, sizeof(config));
     config.id = ENCODE_INPUT_PIN_A;
     config.mode = PIN_MODE_INPUT;
-    config.irq_mode = PIN_IRQ_MODE_RISING;
-    config.flag = PIN_SERVICE_FLAG_SET_IRQ_MODE | PIN_SERVICE_FLAG_AUTO_DISABLE_IRQ;
+    config.irq_mode = PIN_IRQ_MODE_RISING_FALLING;
+    config.flag = PIN_SERVICE_FLAG_SET_IRQ_MODE | PIN_SERVICE_FLAG_QUAD;
+    config.batch_ms = ENCODE_BATCH_MS;
+    config.pin_b = ENCODE_INPUT_PIN_B;
 
     RT_ASSERT(DATA_CLIENT_INVALID_HANDLE != pin_irq_service);
     ret = datac_config(pin_irq_service, sizeof(pin_config_msg_t), (uint8_t *)&config);
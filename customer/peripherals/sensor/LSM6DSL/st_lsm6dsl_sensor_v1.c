@@ -12,8 +12,15 @@
 #define SENSOR_ACC_RANGE_8G   8000
 #define SENSOR_ACC_RANGE_16G  16000
 
+#ifndef LSM6DSL_FIFO_BATCH_MAX
+    #define LSM6DSL_FIFO_BATCH_MAX  32     /* Samples read from FIFO in one bus transfer */
+#endif
+#define LSM6DSL_FIFO_SAMPLE_WORDS   3      /* x, y, z of accelerometer */
+#define LSM6DSL_FIFO_ODR_DEFAULT    104
+
 static LSM6DSL_Object_t lsm6dsl;
 static struct rt_i2c_bus_device *i2c_bus_dev;
+static rt_uint8_t lsm6dsl_fifo_buf[LSM6DSL_FIFO_BATCH_MAX * LSM6DSL_FIFO_SAMPLE_WORDS * 2];
 
 static int32_t rt_func_ok(void)
 {
@@ -131,6 +138,10 @@ static rt_err_t _lsm6dsl_set_odr(rt_sensor_t sensor, rt_uint16_t odr)
     if (sensor->info.type == RT_SENSOR_CLASS_ACCE)
     {
         LSM6DSL_ACC_SetOutputDataRate(&lsm6dsl, odr);
+        if (sensor->config.mode == RT_SENSOR_MODE_FIFO)
+        {
+            LSM6DSL_FIFO_Set_ODR_Value(&lsm6dsl, odr);
+        }
         LOG_D("acce set odr %d", odr);
     }
     else if (sensor->info.type == RT_SENSOR_CLASS_GYRO)
@@ -142,6 +153,36 @@ static rt_err_t _lsm6dsl_set_odr(rt_sensor_t sensor, rt_uint16_t odr)
     return RT_EOK;
 }
 
+/* Raise INT1 when FIFO reaches watermark, so HCPU wakes up once per batch */
+static rt_err_t _lsm6dsl_set_fifo_wm(rt_sensor_t sensor, rt_uint16_t wm)
+{
+    lsm6dsl_reg_t reg;
+
+    if (sensor->info.type != RT_SENSOR_CLASS_ACCE || wm == 0 || wm > LSM6DSL_FIFO_BATCH_MAX)
+    {
+        return -RT_EINVAL;
+    }
+
+    if (LSM6DSL_FIFO_Set_Watermark_Level(&lsm6dsl, wm * LSM6DSL_FIFO_SAMPLE_WORDS) != LSM6DSL_OK)
+    {
+        return -RT_ERROR;
+    }
+
+    if (lsm6dsl_read_reg(&lsm6dsl.Ctx, LSM6DSL_INT1_CTRL, &reg.byte, 1) != LSM6DSL_OK)
+    {
+        return -RT_ERROR;
+    }
+    reg.int1_ctrl.int1_fth = 1;
+    reg.int1_ctrl.int1_full_flag = 0;
+    if (lsm6dsl_write_reg(&lsm6dsl.Ctx, LSM6DSL_INT1_CTRL, &reg.byte, 1) != LSM6DSL_OK)
+    {
+        return -RT_ERROR;
+    }
+
+    LOG_D("fifo watermark %d", wm);
+    return RT_EOK;
+}
+
 static rt_err_t _lsm6dsl_acc_set_mode(rt_sensor_t sensor, rt_uint8_t mode)
 {
     if (mode == RT_SENSOR_MODE_POLLING)
@@ -154,9 +195,21 @@ static rt_err_t _lsm6dsl_acc_set_mode(rt_sensor_t sensor, rt_uint8_t mode)
     }
     else if (mode == RT_SENSOR_MODE_FIFO)
     {
-        LSM6DSL_FIFO_Set_Mode(&lsm6dsl, LSM6DSL_FIFO_MODE);
+        if (sensor->info.type != RT_SENSOR_CLASS_ACCE)
+        {
+            return -RT_ERROR;
+        }
 
-        LSM6DSL_FIFO_Set_INT1_FIFO_Full(&lsm6dsl, 1);
+        /* Bypass flushes old content, then stream so no sample is lost between batches */
+        LSM6DSL_FIFO_Set_Mode(&lsm6dsl, LSM6DSL_BYPASS_MODE);
+        LSM6DSL_FIFO_ACC_Set_Decimation(&lsm6dsl, LSM6DSL_FIFO_XL_NO_DEC);
+        LSM6DSL_FIFO_GYRO_Set_Decimation(&lsm6dsl, LSM6DSL_FIFO_GY_DISABLE);
+        LSM6DSL_FIFO_Set_ODR_Value(&lsm6dsl, sensor->config.odr ? sensor->config.odr : LSM6DSL_FIFO_ODR_DEFAULT);
+        if (_lsm6dsl_set_fifo_wm(sensor, sensor->fifo_wm ? sensor->fifo_wm : sensor->info.fifo_max) != RT_EOK)
+        {
+            return -RT_ERROR;
+        }
+        LSM6DSL_FIFO_Set_Mode(&lsm6dsl, LSM6DSL_STREAM_MODE);
 
         LOG_D("set mode to RT_SENSOR_MODE_FIFO");
     }
@@ -271,23 +324,41 @@ static rt_size_t _lsm6dsl_polling_get_data(rt_sensor_t sensor, struct rt_sensor_
 
 static rt_size_t _lsm6dsl_acc_fifo_get_data(rt_sensor_t sensor, struct rt_sensor_data *data, rt_size_t len)
 {
-    LSM6DSL_Axes_t acce;
-    rt_uint8_t i;
+    rt_uint16_t words;
+    rt_size_t num, i;
+    float sensitivity;
+    rt_uint8_t *p = lsm6dsl_fifo_buf;
 
-    for (i = 0; i < len; i++)
+    if (LSM6DSL_FIFO_Get_Num_Samples(&lsm6dsl, &words) != LSM6DSL_OK
+            || LSM6DSL_ACC_GetSensitivity(&lsm6dsl, &sensitivity) != LSM6DSL_OK)
     {
-        if (LSM6DSL_ACC_GetAxes(&lsm6dsl, &acce) == 0)
-        {
-            data[i].type = RT_SENSOR_CLASS_ACCE;
-            data[i].data.acce.x = acce.x;
-            data[i].data.acce.y = acce.y;
-            data[i].data.acce.z = acce.z;
-            data[i].timestamp = rt_sensor_get_ts();
-        }
-        else
-            break;
+        return 0;
+    }
+
+    num = words / LSM6DSL_FIFO_SAMPLE_WORDS;
+    if (num > len)
+        num = len;
+    if (num > LSM6DSL_FIFO_BATCH_MAX)
+        num = LSM6DSL_FIFO_BATCH_MAX;
+    if (num == 0)
+        return 0;
+
+    /* Read whole batch in one transfer, FIFO output register advances by itself, long transfer goes by I2C DMA */
+    if (lsm6dsl_read_reg(&lsm6dsl.Ctx, LSM6DSL_FIFO_DATA_OUT_L, lsm6dsl_fifo_buf, num * LSM6DSL_FIFO_SAMPLE_WORDS * 2) != LSM6DSL_OK)
+    {
+        return 0;
     }
-    return i;
+
+    for (i = 0; i < num; i++, p += LSM6DSL_FIFO_SAMPLE_WORDS * 2)
+    {
+        data[i].type = RT_SENSOR_CLASS_ACCE;
+        data[i].data.acce.x = (rt_int32_t)((float)(rt_int16_t)(p[0] | (p[1] << 8)) * sensitivity);
+        data[i].data.acce.y = (rt_int32_t)((float)(rt_int16_t)(p[2] | (p[3] << 8)) * sensitivity);
+        data[i].data.acce.z = (rt_int32_t)((float)(rt_int16_t)(p[4] | (p[5] << 8)) * sensitivity);
+    }
+    rt_sensor_fifo_timestamp(sensor, data, num);
+
+    return num;
 }
 
 static RT_SIZE_TYPE lsm6dsl_fetch_data(struct rt_sensor_device *sensor, void *buf, rt_size_t len)
@@ -332,6 +403,9 @@ static rt_err_t lsm6dsl_control(struct rt_sensor_device *sensor, int cmd, void *
         break;
     case RT_SENSOR_CTRL_SELF_TEST:
         break;
+    case RT_SENSOR_CTRL_SET_FIFO_WM:
+        result = _lsm6dsl_set_fifo_wm(sensor, (rt_uint32_t)args & 0xffff);
+        break;
     default:
         return -RT_ERROR;
     }
@@ -364,11 +438,12 @@ int rt_hw_lsm6dsl_init(const char *name, struct rt_sensor_config *cfg)
         sensor_acce->info.range_max  = SENSOR_ACC_RANGE_16G;
         sensor_acce->info.range_min  = SENSOR_ACC_RANGE_2G;
         sensor_acce->info.period_min = 5;
+        sensor_acce->info.fifo_max   = LSM6DSL_FIFO_BATCH_MAX;
 
         rt_memcpy(&sensor_acce->config, cfg, sizeof(struct rt_sensor_config));
         sensor_acce->ops = &sensor_ops;
 
-        result = rt_hw_sensor_register(sensor_acce, name, RT_DEVICE_FLAG_RDWR, RT_NULL);
+        result = rt_hw_sensor_register(sensor_acce, name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_FIFO_RX, RT_NULL);
         if (result != RT_EOK)
         {
             LOG_E("device register err code: %d", result);
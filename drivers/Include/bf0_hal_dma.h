@@ -163,6 +163,19 @@ typedef enum
 /**
   * @brief  DMA handle Structure definition
   */
+/**
+  * @brief  Node of DMA linked list transfer.
+  * @note   DMAC has no descriptor fetch, so nodes are loaded by software in transfer complete interrupt.
+  *         Direction, data width and increment mode of all nodes follow DMA_InitTypeDef of handle.
+  */
+typedef struct __DMA_LinkNodeTypeDef
+{
+    uint32_t SrcAddress;                                                               /*!< Source address                       */
+    uint32_t DstAddress;                                                               /*!< Destination address                  */
+    uint32_t Counts;                                                                   /*!< Counts of data transfer action       */
+    struct __DMA_LinkNodeTypeDef *Next;                                                /*!< Next node, NULL for last node        */
+} DMA_LinkNodeTypeDef;
+
 typedef struct __DMA_HandleTypeDef
 {
     DMA_Channel_TypeDef    *Instance;                                                  /*!< Register base address                */
@@ -199,6 +212,8 @@ typedef struct __DMA_HandleTypeDef
     uint8_t                SrcWidth;                                                   /*!< Src width, 0: 1 byte, 1: 2bytes, 2: 4bytes */
     uint8_t                DstWidth;                                                   /*!< Dst width, 0: 1 byte, 1: 2bytes, 2: 4bytes */
 #endif /* DMA_SUPPORT_DYN_CHANNEL_ALLOC */
+    DMA_LinkNodeTypeDef    *pNextNode;                                                 /*!< Next node of linked list transfer   */
+    void (* ListCpltCallback)(struct __DMA_HandleTypeDef *hdma);                       /*!< Complete callback of linked list transfer, saved from XferCpltCallback */
 } DMA_HandleTypeDef;
 
 /**
@@ -850,6 +865,33 @@ HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, ui
   * @retval HAL status
   */
 HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t Counts);
+
+/**
+  * @brief  Start linked list transfer with interrupt enabled, XferCpltCallback is called once after last node.
+  * @note   Next node is started in transfer complete interrupt of previous one, so there is a short gap
+  *         between nodes. Circular mode is not supported. Nodes must be kept until transfer is done.
+  * @param  hdma pointer to a DMA_HandleTypeDef structure that contains
+  *               the configuration information for the specified DMA Channel.
+  * @param  pList first node of list
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_DMA_Start_List_IT(DMA_HandleTypeDef *hdma, DMA_LinkNodeTypeDef *pList);
+
+/**
+  * @brief  Abort linked list transfer, remaining nodes are dropped.
+  * @param  hdma pointer to a DMA_HandleTypeDef structure that contains
+  *               the configuration information for the specified DMA Channel.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_DMA_Abort_List(DMA_HandleTypeDef *hdma);
+
+/**
+  * @brief  Link nodes of array into list, last node ends list.
+  * @param  pNodes node array
+  * @param  Num number of nodes
+  * @retval None
+  */
+void HAL_DMA_LinkNodes(DMA_LinkNodeTypeDef *pNodes, uint32_t Num);
 /**
   * @brief  Abort the DMA Transfer.
   * @param  hdma pointer to a DMA_HandleTypeDef structure that contains
@@ -357,6 +357,8 @@ typedef struct
     EPIC_YUVCfgTypeDef  yuv;  /**< YUV data*/
 
     uint16_t lookup_table_size;  /**< Lookup table color numbers*/
+    /** Content of 'lookup_table' never changes, it's not loaded again if still in hardware table */
+    uint8_t lookup_table_cached;
 } EPIC_BlendingDataType;
 
 typedef struct
@@ -402,6 +404,8 @@ typedef struct
     EPIC_YUVCfgTypeDef  yuv;  /**< YUV data*/
 
     uint16_t lookup_table_size;  /**< Lookup table color numbers, maximum is 'EPIC_MAX_LOOKUP_TABLE_CNT' */
+    /** Content of 'lookup_table' never changes, it's not loaded again if still in hardware table */
+    uint8_t lookup_table_cached;
     /****** Keep above members as same as struct 'EPIC_BlendingDataType'  *************/
 
     uint8_t alpha;              /**< Layer global alpha*/
@@ -786,6 +790,17 @@ HAL_StatusTypeDef HAL_EPIC_FillGrad(EPIC_HandleTypeDef *epic, EPIC_GradCfgTypeDe
  */
 void HAL_EPIC_LayerConfigInit(EPIC_LayerConfigTypeDef *layer);
 
+#ifdef EPIC_SUPPORT_L8
+/**
+ * @brief  Forget lookup tables cached in hardware, they are shared by all handles of the hardware.
+ *         Must be called if content of a table used with 'lookup_table_cached' is changed.
+ *
+ * @param epic EPIC handle
+ * @retval None
+ */
+void HAL_EPIC_InvalidateL8Table(EPIC_HandleTypeDef *epic);
+#endif /* EPIC_SUPPORT_L8 */
+
 
 /**  input_layer[0]: bottom layer, input_layer[1] is on top of input_layer[0]
  *   input_layer[2] is on top of input_layer[1], ...
@@ -97,6 +97,16 @@ extern "C" {
   */
 #define QSPI_NOR_BLK64_SIZE            (0X10000)
 
+/**
+  * @brief  FLASHEx nor erase/program suspend and resume opcode
+  */
+#ifndef SPI_NOR_CMD_SUSPEND
+#define SPI_NOR_CMD_SUSPEND            (0x75)
+#endif
+#ifndef SPI_NOR_CMD_RESUME
+#define SPI_NOR_CMD_RESUME             (0x7A)
+#endif
+
 /**
  * @brief  FLASHEx max 128MB(1Gb) to make different flash address not accross
  *  we also use it to align local flash address by ~()
@@ -123,6 +133,16 @@ extern "C" {
   */
 #define SPI_NAND_BLK_SIZE                    (0x20000)
 
+/**
+  * @brief  NAND read page cache sequential/last command, not in command table
+  */
+#ifndef SPI_NAND_CMD_CACHE_READ_SEQ
+#define SPI_NAND_CMD_CACHE_READ_SEQ          (0x31)
+#endif
+#ifndef SPI_NAND_CMD_CACHE_READ_END
+#define SPI_NAND_CMD_CACHE_READ_END          (0x3F)
+#endif
+
 #define NAND_CACHE_USE_MEMCPY           (0)  /*!< NAND cache copy use sys memcpy     */
 #define NAND_CACHE_USE_EXTDMA           (1)  /*!< NAND cache copy use ext-dma        */
 #define NAND_CACHE_USE_CDMA             (2)  /*!< NAND cache copy use common dma     */
@@ -509,6 +529,36 @@ int HAL_QSPIEX_BLK64_ERASE(FLASH_HandleTypeDef *hflash, uint32_t addr);
 */
 int HAL_QSPIEX_CHIP_ERASE(FLASH_HandleTypeDef *hflash);
 
+/**
+  * @brief  issue nor flash sector or block64 erase and return without waiting done
+  * @param  hflash  FLASH handle
+  * @param  addr start address
+  * @param  size erase unit, QSPI_NOR_SECT_SIZE or QSPI_NOR_BLK64_SIZE
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_ERASE_START(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size);
+
+/**
+  * @brief  check nor flash write in progress
+  * @param  hflash  FLASH handle
+  * @retval true if erase or program not finished
+*/
+bool HAL_QSPIEX_IS_BUSY(FLASH_HandleTypeDef *hflash);
+
+/**
+  * @brief  suspend nor flash erase/program and wait flash readable
+  * @param  hflash  FLASH handle
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_SUSPEND(FLASH_HandleTypeDef *hflash);
+
+/**
+  * @brief  resume suspended nor flash erase/program
+  * @param  hflash  FLASH handle
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_RESUME(FLASH_HandleTypeDef *hflash);
+
 /**
   * @}
   */
@@ -613,6 +663,19 @@ int HAL_NAND_WRITE_WITHOOB(FLASH_HandleTypeDef *handle, uint32_t addr,
                            const uint8_t *buff, uint32_t len, const uint8_t *oob_buf, uint32_t olen);
 
 
+/**
+  * @brief  Read continuous pages with cache read sequential, chip loads next page
+  *         from array while current page read out from cache.
+  * @note   Chip should support SPI_NAND_CMD_CACHE_READ_SEQ/SPI_NAND_CMD_CACHE_READ_END commands,
+  *         pages should be in one block, oob not read.
+  * @param  handle  FLASH handle
+  * @param  addr page aligned address
+  * @param  dbuff data buffer
+  * @param  pages page count
+  * @retval data length, less than pages * page size if ecc fail
+*/
+int HAL_NAND_CACHE_READ_SEQ(FLASH_HandleTypeDef *handle, uint32_t addr, uint8_t *dbuff, uint32_t pages);
+
 /**
  * @brief  Enable/Disable NAND buf mode.
  * @param  handle  FLASH handle
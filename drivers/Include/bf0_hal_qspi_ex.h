@@ -97,6 +97,16 @@ extern "C" {
   */
 #define QSPI_NOR_BLK64_SIZE            (0X10000)
 
+/**
+  * @brief  FLASHEx nor erase/program suspend and resume opcode
+  */
+#ifndef SPI_NOR_CMD_SUSPEND
+#define SPI_NOR_CMD_SUSPEND            (0x75)
+#endif
+#ifndef SPI_NOR_CMD_RESUME
+#define SPI_NOR_CMD_RESUME             (0x7A)
+#endif
+
 /**
  * @brief  FLASHEx max 128MB(1Gb) to make different flash address not accross
  *  we also use it to align local flash address by ~()
@@ -449,6 +459,36 @@ int HAL_QSPIEX_BLK64_ERASE(FLASH_HandleTypeDef *hflash, uint32_t addr);
 */
 int HAL_QSPIEX_CHIP_ERASE(FLASH_HandleTypeDef *hflash);
 
+/**
+  * @brief  issue nor flash sector or block64 erase and return without waiting done
+  * @param  hflash  FLASH handle
+  * @param  addr start address
+  * @param  size erase unit, QSPI_NOR_SECT_SIZE or QSPI_NOR_BLK64_SIZE
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_ERASE_START(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size);
+
+/**
+  * @brief  check nor flash write in progress
+  * @param  hflash  FLASH handle
+  * @retval true if erase or program not finished
+*/
+bool HAL_QSPIEX_IS_BUSY(FLASH_HandleTypeDef *hflash);
+
+/**
+  * @brief  suspend nor flash erase/program and wait flash readable
+  * @param  hflash  FLASH handle
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_SUSPEND(FLASH_HandleTypeDef *hflash);
+
+/**
+  * @brief  resume suspended nor flash erase/program
+  * @param  hflash  FLASH handle
+  * @retval 0 if success
+*/
+int HAL_QSPIEX_RESUME(FLASH_HandleTypeDef *hflash);
+
 /**
   * @}
   */
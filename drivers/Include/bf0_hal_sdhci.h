@@ -303,6 +303,15 @@ typedef struct
     uint32_t addr;      /*!<  SD address */
 } hal_sdhci_adma_des_line_t;
 
+/**
+  * @brief  scatter-gather segment of ADMA transfer
+  */
+typedef struct
+{
+    uint32_t addr;      /*!<  segment address, 4 bytes aligned */
+    uint32_t len;       /*!<  segment length in bytes */
+} SDHCI_SgTypeDef;
+
 /**
   * @brief  SDHCI Initial structure
   */
@@ -533,6 +542,18 @@ void hal_sdhci_transfer_pio(SDHCI_HandleTypeDef *handle, uint8_t is_read, uint8_
   */
 int hal_sdhci_adma_table_pre(SDHCI_HandleTypeDef *handle, uint8_t *data, uint32_t size);
 
+/**
+  * @brief prepare adma table for scatter-gather segments, all segments are done in one transfer.
+  * @param handle SDHCI handle.
+  * @param sg segment list.
+  * @param num number of segments.
+  * @param max_desc size of descriptor table in lines including end line, 0 for no check.
+  * @param boundary split line at address of multiple of boundary (power of 2), 0 for no split.
+  * @retval 0 if successful, -1 if descriptor table is too small.
+  */
+int hal_sdhci_adma_table_sg(SDHCI_HandleTypeDef *handle, const SDHCI_SgTypeDef *sg, uint32_t num,
+                            uint32_t max_desc, uint32_t boundary);
+
 /**
   * @brief enable irq of transfer bits.
   * @param handle SDHCI handle.
@@ -89,6 +89,8 @@ extern "C" {
 #define FACTORY_CFG_ID_USERK1           27      /*!< User special code  */
 #define FACTORY_CFG_ID_USERK2           28      /*!< User special code  */
 #define FACTORY_CFG_ID_USERK3           29      /*!< User special code  */
+#define FACTORY_CFG_ID_FLASH_MODE       30      /*!< NOR flash read mode selected at runtime */
+#define FACTORY_CFG_ID_PSRAM_CAL        31      /*!< PSRAM sck/dqs delay calibrated at runtime */
 #define FACTORY_CFG_ID_UNINIT           0xFF    /*!< Uninitialized ID */
 
 #define CFG_USER_SIZE            (256)
@@ -177,6 +179,41 @@ typedef struct
     uint8_t mpi2_mode;
 } FACTORY_CFG_SIP_MOD_T;
 
+#define FACTORY_CFG_FLASH_MODE_NUM      (2)
+
+typedef struct
+{
+    uint32_t dev_id;     /*!< Flash id the mode was validated on, 0 for unused entry. */
+    uint8_t  flash_id;   /*!< Flash controller index. */
+    uint8_t  dtr;        /*!< 1 if DTR read passed validation, 0 if it failed. */
+    uint8_t  rx_cfg;     /*!< DTR rx clock invert and delay. */
+    uint8_t  reserved;
+} FACTORY_CFG_FLASH_MODE_ITEM_T;
+
+typedef struct
+{
+    FACTORY_CFG_FLASH_MODE_ITEM_T item[FACTORY_CFG_FLASH_MODE_NUM];
+} FACTORY_CFG_FLASH_MODE_T;
+
+#define FACTORY_CFG_PSRAM_CAL_NUM       (2)
+
+typedef struct
+{
+    uint32_t clk;        /*!< PSRAM clock the delay was calibrated at, 0 for unused entry. */
+    uint8_t  psram_id;   /*!< Last char of controller name, e.g. '1' for psram1. */
+    uint8_t  dvfs;       /*!< DVFS mode, i.e. core voltage, 0 if not available. */
+    int8_t   temp;       /*!< Temperature in degree when calibrated. */
+    uint8_t  sck;        /*!< Calibrated sck delay. */
+    uint8_t  dqs;        /*!< Calibrated dqs delay. */
+    uint8_t  reserved;
+    uint16_t full_us;    /*!< Time of full calibration in us. */
+} FACTORY_CFG_PSRAM_CAL_ITEM_T;
+
+typedef struct
+{
+    FACTORY_CFG_PSRAM_CAL_ITEM_T item[FACTORY_CFG_PSRAM_CAL_NUM];
+} FACTORY_CFG_PSRAM_CAL_T;
+
 typedef struct
 {
     int32_t  maxPower;
@@ -55,6 +55,7 @@ typedef struct
 } Sifli_NandBBM; //Nand Flash Bad block management
 
 typedef void (*bbm_log_func)(const char *fmt, ...);
+typedef uint32_t (*bbm_crc_func)(const uint8_t *buf, uint32_t size);
 
 
 /**
@@ -71,6 +72,13 @@ int bbm_write_page(int blk, int page, uint8_t *data, uint8_t *spare, uint32_t sp
 
 int bbm_erase_block(int blk);
 
+/**
+ * @brief Get physical block of logic block.
+ * @param[in] log_blk: logic block.
+ * @return physical block, -1 if logic block out of range.
+ */
+int bbm_get_phy_blk(uint16_t log_blk);
+
 int port_read_page(int blk, int page, int offset, uint8_t *buff, uint32_t size, uint8_t *spare, uint32_t spare_len);
 
 int port_write_page(int blk, int page, uint8_t *data, uint8_t *spare, uint32_t spare_len);
@@ -92,6 +100,12 @@ void *bbm_get_context(uint8_t idx);
 
 void bbm_register_log(bbm_log_func log_func);
 
+/**
+ * @brief Replace software CRC-32 of bbm table, e.g. by CRC engine.
+ * @param[in] crc_func: CRC-32 (reflected, init and xorout 0xFFFFFFFF), NULL for software.
+ */
+void bbm_register_crc(bbm_crc_func crc_func);
+
 #ifdef BBM_TABLE_AUTO_TEST
 
 typedef enum
@@ -929,6 +929,104 @@ __EXIT:
     return status;
 }
 
+/* Transfer complete of a list node, load next node or finish list */
+static void DMA_ListXferCplt(DMA_HandleTypeDef *hdma)
+{
+    DMA_LinkNodeTypeDef *node = hdma->pNextNode;
+
+    if (NULL != node)
+    {
+        hdma->pNextNode = node->Next;
+        if (HAL_OK == HAL_DMA_Start_IT(hdma, node->SrcAddress, node->DstAddress, node->Counts))
+        {
+            return;
+        }
+
+        hdma->pNextNode = NULL;
+        hdma->XferCpltCallback = hdma->ListCpltCallback;
+        hdma->ErrorCode = HAL_DMA_ERROR_TE;
+        if (NULL != hdma->XferErrorCallback)
+        {
+            hdma->XferErrorCallback(hdma);
+        }
+        return;
+    }
+
+    hdma->XferCpltCallback = hdma->ListCpltCallback;
+    if (NULL != hdma->XferCpltCallback)
+    {
+        hdma->XferCpltCallback(hdma);
+    }
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_List_IT(DMA_HandleTypeDef *hdma, DMA_LinkNodeTypeDef *pList)
+{
+    HAL_StatusTypeDef status;
+
+    if ((NULL == hdma) || (NULL == pList) || (DMA_CIRCULAR == hdma->Init.Mode))
+    {
+        return HAL_ERROR;
+    }
+
+    if (HAL_DMA_STATE_READY != hdma->State)
+    {
+        return HAL_BUSY;
+    }
+
+    /* Hook complete callback, it is restored before the last callback so handle could be reused for normal transfer */
+    if (DMA_ListXferCplt != hdma->XferCpltCallback)
+    {
+        hdma->ListCpltCallback = hdma->XferCpltCallback;
+    }
+    hdma->XferCpltCallback = DMA_ListXferCplt;
+    hdma->pNextNode = pList->Next;
+
+    status = HAL_DMA_Start_IT(hdma, pList->SrcAddress, pList->DstAddress, pList->Counts);
+    if (HAL_OK != status)
+    {
+        hdma->pNextNode = NULL;
+        hdma->XferCpltCallback = hdma->ListCpltCallback;
+    }
+
+    return status;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort_List(DMA_HandleTypeDef *hdma)
+{
+    uint32_t mask;
+
+    if (NULL == hdma)
+    {
+        return HAL_ERROR;
+    }
+
+    mask = HAL_DisableInterrupt();
+    hdma->pNextNode = NULL;
+    if (DMA_ListXferCplt == hdma->XferCpltCallback)
+    {
+        hdma->XferCpltCallback = hdma->ListCpltCallback;
+    }
+    HAL_EnableInterrupt(mask);
+
+    return HAL_DMA_Abort(hdma);
+}
+
+void HAL_DMA_LinkNodes(DMA_LinkNodeTypeDef *pNodes, uint32_t Num)
+{
+    uint32_t i;
+
+    if ((NULL == pNodes) || (0 == Num))
+    {
+        return;
+    }
+
+    for (i = 0; i < Num - 1; i++)
+    {
+        pNodes[i].Next = &pNodes[i + 1];
+    }
+    pNodes[Num - 1].Next = NULL;
+}
+
 /**
   * @brief  Abort the DMA Transfer.
   * @param  hdma pointer to a DMA_HandleTypeDef structure that contains
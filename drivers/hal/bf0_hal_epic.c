@@ -1273,14 +1273,20 @@ static HAL_StatusTypeDef EPIC_Apply_YUV_on_layer(EPIC_HandleTypeDef *hepic,
 
 
 #ifndef SF32LB55X
+/* Source of content in hardware lookup tables if it's cached, shared by normal and shadow handles */
+static const uint8_t *EPIC_LTabSrc[EPIC_LOOKUP_TABLES];
+static uint16_t EPIC_LTabSrcSize[EPIC_LOOKUP_TABLES];
+
 /**
- * @brief  Allocate free lookup table
+ * @brief  Allocate free lookup table, prefer the one already holding pLTab
  *
+ * @param  hepic EPIC handle
  * @param  epic EPIC instance
+ * @param  pLTab lookup table to be loaded
  *
  * @retval Free lookup table id
  */
-static uint32_t EPIC_Allocate_L8Table(EPIC_TypeDef *epic)
+static uint32_t EPIC_Allocate_L8Table(EPIC_HandleTypeDef *hepic, EPIC_TypeDef *epic, const uint8_t *pLTab)
 {
 #if (1 == EPIC_LOOKUP_TABLES)
     uint32_t free_tables[1] = {1};
@@ -1305,10 +1311,15 @@ static uint32_t EPIC_Allocate_L8Table(EPIC_TypeDef *epic)
     {
         if ((EPIC_VL_CFG_ACTIVE | EPIC_VL_CFG_FMT_L8) == (Vlayer_x->CFG & (EPIC_VL_CFG_ACTIVE_Msk | EPIC_VL_CFG_FORMAT_Msk)))
         {
-            free_tables[(layer_x->MISC_CFG & EPIC_VL_MISC_CFG_CLUT_SEL_Msk) >> EPIC_VL_MISC_CFG_CLUT_SEL_Pos] = 0;
+            free_tables[(Vlayer_x->MISC_CFG & EPIC_VL_MISC_CFG_CLUT_SEL_Msk) >> EPIC_VL_MISC_CFG_CLUT_SEL_Pos] = 0;
         }
     }
 
+    for (uint32_t i = 0; i < (sizeof(free_tables) / sizeof(free_tables[0])); i++)
+    {
+        if (free_tables[i] && (pLTab == EPIC_LTabSrc[i])) return i;
+    }
+
     for (uint32_t i = 0; i < (sizeof(free_tables) / sizeof(free_tables[0])); i++)
     {
         if (free_tables[i]) return i;
@@ -1317,7 +1328,8 @@ static uint32_t EPIC_Allocate_L8Table(EPIC_TypeDef *epic)
     return UINT32_MAX;
 }
 
-static HAL_StatusTypeDef EPIC_Overwrite_L8Table(EPIC_HandleTypeDef *hepic, uint32_t tab_id, uint8_t *pLTab, uint16_t LTab_Cnt)
+static HAL_StatusTypeDef EPIC_Overwrite_L8Table(EPIC_HandleTypeDef *hepic, uint32_t tab_id, uint8_t *pLTab, uint16_t LTab_Cnt,
+        uint8_t cached)
 {
     HAL_ASSERT(EPIC_LOOKUP_TABLES > tab_id);
     HAL_ASSERT(hepic->LTab[tab_id]);
@@ -1328,6 +1340,14 @@ static HAL_StatusTypeDef EPIC_Overwrite_L8Table(EPIC_HandleTypeDef *hepic, uint3
         return HAL_ERROR;
     }
     if (LTab_Cnt > EPIC_MAX_LOOKUP_TABLE_CNT) LTab_Cnt = EPIC_MAX_LOOKUP_TABLE_CNT;
+
+    if (cached && (pLTab == EPIC_LTabSrc[tab_id]) && (LTab_Cnt <= EPIC_LTabSrcSize[tab_id]))
+    {
+        return HAL_OK;
+    }
+    EPIC_LTabSrc[tab_id] = cached ? pLTab : NULL;
+    EPIC_LTabSrcSize[tab_id] = LTab_Cnt;
+
     if (hepic->RamInstance_used)
     {
         hepic->RamLTab[tab_id] = pLTab;
@@ -1550,10 +1570,10 @@ static HAL_StatusTypeDef EPIC_ConfigLayer(EPIC_HandleTypeDef *hepic, EPIC_LAYER_
 #ifndef SF32LB55X
     if (EPIC_COLOR_L8 == config->color_mode)
     {
-        uint32_t tab_id = EPIC_Allocate_L8Table(hepic->Instance);
+        uint32_t tab_id = EPIC_Allocate_L8Table(hepic, hepic->Instance, config->lookup_table);
 
         HAL_ASSERT(tab_id <= (EPIC_L0_MISC_CFG_CLUT_SEL_Msk >> EPIC_L0_MISC_CFG_CLUT_SEL_Pos));
-        EPIC_Overwrite_L8Table(hepic, tab_id, config->lookup_table, config->lookup_table_size);
+        EPIC_Overwrite_L8Table(hepic, tab_id, config->lookup_table, config->lookup_table_size, config->lookup_table_cached);
         layer_x->MISC_CFG &= ~EPIC_L0_MISC_CFG_CLUT_SEL_Msk;
         layer_x->MISC_CFG |= MAKE_REG_VAL(tab_id, EPIC_L0_MISC_CFG_CLUT_SEL_Msk, EPIC_L0_MISC_CFG_CLUT_SEL_Pos);
     }
@@ -2778,10 +2798,10 @@ static HAL_StatusTypeDef EPIC_ConfigVideoLayer(EPIC_HandleTypeDef *epic_handle,
 
     if (EPIC_COLOR_L8 == config->color_mode)
     {
-        uint32_t tab_id = EPIC_Allocate_L8Table(epic);
+        uint32_t tab_id = EPIC_Allocate_L8Table(epic_handle, epic, config->lookup_table);
 
         HAL_ASSERT(tab_id <= (EPIC_VL_MISC_CFG_CLUT_SEL_Msk >> EPIC_VL_MISC_CFG_CLUT_SEL_Pos));
-        EPIC_Overwrite_L8Table(epic_handle, tab_id, config->lookup_table, config->lookup_table_size);
+        EPIC_Overwrite_L8Table(epic_handle, tab_id, config->lookup_table, config->lookup_table_size, config->lookup_table_cached);
         Vlayer_x->MISC_CFG &= ~EPIC_VL_MISC_CFG_CLUT_SEL_Msk;
         Vlayer_x->MISC_CFG |= MAKE_REG_VAL(tab_id, EPIC_VL_MISC_CFG_CLUT_SEL_Msk, EPIC_VL_MISC_CFG_CLUT_SEL_Pos);
     }
@@ -3698,6 +3718,7 @@ HAL_StatusTypeDef HAL_EPIC_Init(EPIC_HandleTypeDef *epic)
         epic->RamLTab[i] = NULL;
         epic->RamLTabSize[i] = 0;
     }
+    HAL_EPIC_InvalidateL8Table(epic);
 #endif /* EPIC_SUPPORT_L8 */
 
 #ifndef SF32LB55X
@@ -3756,6 +3777,18 @@ void HAL_EPIC_LayerConfigInit(EPIC_LayerConfigTypeDef *layer)
     HAL_EPIC_RotDataInit(&(layer->transform_cfg));
 }
 
+#ifdef EPIC_SUPPORT_L8
+void HAL_EPIC_InvalidateL8Table(EPIC_HandleTypeDef *epic)
+{
+    HAL_ASSERT(NULL != epic);
+    for (uint32_t i = 0; i < EPIC_LOOKUP_TABLES; i++)
+    {
+        EPIC_LTabSrc[i] = NULL;
+        EPIC_LTabSrcSize[i] = 0;
+    }
+}
+#endif /* EPIC_SUPPORT_L8 */
+
 
 /**
  * @brief  Start blending in polling mode
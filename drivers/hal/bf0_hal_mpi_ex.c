@@ -962,6 +962,95 @@ __HAL_ROM_USED int HAL_NAND_READ_WITHOOB(FLASH_HandleTypeDef *handle, uint32_t a
     return dlen + olen;
 }
 
+static void nand_wait_oip(FLASH_HandleTypeDef *handle)
+{
+    int busy;
+
+    HAL_FLASH_WRITE_DLEN(handle, 1);
+    do
+    {
+        HAL_Delay_us_(5);
+        HAL_FLASH_ISSUE_CMD(handle, SPI_FLASH_CMD_RDSR, handle->ctable->status_reg);
+        busy = HAL_FLASH_READ32(handle) & 0x1;
+    }
+    while (busy);
+}
+
+int HAL_NAND_CACHE_READ_SEQ(FLASH_HandleTypeDef *handle, uint32_t addr, uint8_t *dbuff, uint32_t pages)
+{
+    uint32_t pagesize, blksize, cache_base, i;
+    int res;
+
+    if (handle == NULL || handle->ctable == NULL || dbuff == NULL || pages == 0)
+        return 0;
+
+    pagesize = HAL_NAND_PAGE_SIZE(handle);
+    blksize = HAL_NAND_BLOCK_SIZE(handle);
+    if (addr >= handle->base)
+        addr -= handle->base;
+
+    // page aligned and in one block, sequential cache read does not cross block
+    if ((addr & (pagesize - 1)) || ((addr & (blksize - 1)) + pages * pagesize > blksize))
+    {
+        handle->ErrorCode = 2;
+        return 0;
+    }
+    handle->ErrorCode = 0;
+
+    cache_base = handle->base;
+    if (((addr & SPI_NAND_BLK_SIZE) != 0) && (handle->wakeup != 0)) // only 2K page need plane select now
+        cache_base |= (1 << 12);
+
+    if (handle->Mode == HAL_FLASH_NOR_MODE)
+    {
+        HAL_FLASH_SET_AHB_RCMD(handle, handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].cmd);
+        HAL_FLASH_CFG_AHB_RCMD(handle, handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].data_mode,
+                               handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].dummy_cycle, handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].ab_size,
+                               handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].ab_mode, handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].addr_size,
+                               handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].addr_mode, handle->ctable->cmd_cfg[SPI_FLASH_CMD_FREAD].ins_mode);
+    }
+    else
+    {
+        HAL_FLASH_SET_AHB_RCMD(handle, handle->ctable->cmd_cfg[NAND_READ_CMD].cmd);
+        HAL_FLASH_CFG_AHB_RCMD(handle,  handle->ctable->cmd_cfg[NAND_READ_CMD].data_mode,
+                               handle->ctable->cmd_cfg[NAND_READ_CMD].dummy_cycle, handle->ctable->cmd_cfg[NAND_READ_CMD].ab_size,
+                               handle->ctable->cmd_cfg[NAND_READ_CMD].ab_mode, handle->ctable->cmd_cfg[NAND_READ_CMD].addr_size,
+                               handle->ctable->cmd_cfg[NAND_READ_CMD].addr_mode, handle->ctable->cmd_cfg[NAND_READ_CMD].ins_mode);
+    }
+
+    // load first page to data register
+    HAL_FLASH_ISSUE_CMD(handle, SPI_FLASH_CMD_PREAD, (addr / pagesize) & 0xffffff);
+    HAL_Delay_us_(20);
+    nand_wait_oip(handle);
+
+    for (i = 0; i < pages; i++)
+    {
+        // move data register to cache, for sequential command chip start loading next page at the same time
+        HAL_FLASH_MANUAL_CMD(handle, 0, 0, 0, 0, 0, 0, 0, 1);
+        HAL_FLASH_SET_CMD(handle, (i + 1 < pages) ? SPI_NAND_CMD_CACHE_READ_SEQ : SPI_NAND_CMD_CACHE_READ_END, 0);
+        nand_wait_oip(handle);
+
+        res = HAL_NAND_GET_ECC_RESULT(handle);
+        if (res != 0)
+        {
+            handle->ErrorCode = res | 0x8000;
+            // stop loading, chip may be still busy with next page
+            if (i + 1 < pages)
+            {
+                HAL_FLASH_MANUAL_CMD(handle, 0, 0, 0, 0, 0, 0, 0, 1);
+                HAL_FLASH_SET_CMD(handle, SPI_NAND_CMD_CACHE_READ_END, 0);
+                nand_wait_oip(handle);
+            }
+            break;
+        }
+
+        SCB_InvalidateDCache_by_Addr((void *)cache_base, pagesize);
+        memcpy(dbuff + i * pagesize, (const void *)cache_base, pagesize);
+    }
+
+    return i * pagesize;
+}
+
 
 __HAL_ROM_USED int HAL_NAND_WRITE_PAGE(FLASH_HandleTypeDef *handle, uint32_t addr, const uint8_t *buff, uint32_t len)
 {
@@ -2161,6 +2250,64 @@ exit:
     return ret;
 }
 
+int HAL_QSPIEX_ERASE_START(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
+{
+    SPI_FLASH_CMD_E ecmd;
+
+    if (!flash_handle_valid(hflash))
+        return -1;
+
+    if (size == QSPI_NOR_BLK64_SIZE)
+        ecmd = (hflash->size > NOR_FLASH_MAX_3B_SIZE) ? SPI_FLASH_CMD_BE4BA : SPI_FLASH_CMD_BE64;
+    else if (size == QSPI_NOR_SECT_SIZE)
+        ecmd = (hflash->size > NOR_FLASH_MAX_3B_SIZE) ? SPI_FLASH_CMD_SE4BA : SPI_FLASH_CMD_SE;
+    else
+        return -1;
+
+    HAL_FLASH_ISSUE_CMD(hflash, SPI_FLASH_CMD_WREN, addr);
+    if (HAL_FLASH_ISSUE_CMD(hflash, ecmd, addr) != 0)
+        return -1;
+
+    return 0;
+}
+
+bool HAL_QSPIEX_IS_BUSY(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return false;
+
+    HAL_FLASH_WRITE_DLEN(hflash, 1);
+    HAL_FLASH_ISSUE_CMD(hflash, SPI_FLASH_CMD_RDSR, 0);
+
+    return !HAL_FLASH_IS_PROG_DONE(hflash);
+}
+
+int HAL_QSPIEX_SUSPEND(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return -1;
+
+    // Suspend is not in command table, all supported NOR chips use same opcode
+    HAL_FLASH_MANUAL_CMD(hflash, 0, 0, 0, 0, 0, 0, 0, 1);
+    HAL_FLASH_SET_CMD(hflash, SPI_NOR_CMD_SUSPEND, 0);
+
+    // WIP clear after tSUS, flash can be read then
+    while (HAL_QSPIEX_IS_BUSY(hflash));
+
+    return 0;
+}
+
+int HAL_QSPIEX_RESUME(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return -1;
+
+    HAL_FLASH_MANUAL_CMD(hflash, 0, 0, 0, 0, 0, 0, 0, 1);
+    HAL_FLASH_SET_CMD(hflash, SPI_NOR_CMD_RESUME, 0);
+
+    return 0;
+}
+
 __HAL_ROM_USED int nor_erase_rom(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
 {
     uint32_t al_size;
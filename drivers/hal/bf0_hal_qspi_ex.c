@@ -1853,6 +1853,67 @@ __HAL_ROM_USED int HAL_QSPIEX_CHIP_ERASE(FLASH_HandleTypeDef *hflash)
     return 0;
 }
 
+int HAL_QSPIEX_ERASE_START(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
+{
+    SPI_FLASH_CMD_E ecmd;
+    bool addr4b;
+
+    if (!flash_handle_valid(hflash))
+        return -1;
+
+    addr4b = ((hflash->size > NOR_FLASH_MAX_3B_SIZE) && (hflash->dualFlash == 0))
+             || (hflash->size > NOR_FLASH_MAX_3B_SIZE * 2);
+    if (size == (QSPI_NOR_BLK64_SIZE << hflash->dualFlash))
+        ecmd = addr4b ? SPI_FLASH_CMD_BE4BA : SPI_FLASH_CMD_BE64;
+    else if (size == (QSPI_NOR_SECT_SIZE << hflash->dualFlash))
+        ecmd = addr4b ? SPI_FLASH_CMD_SE4BA : SPI_FLASH_CMD_SE;
+    else
+        return -1;
+
+    HAL_FLASH_ISSUE_CMD(hflash, SPI_FLASH_CMD_WREN, addr);
+    if (HAL_FLASH_ISSUE_CMD(hflash, ecmd, addr) != 0)
+        return -1;
+
+    return 0;
+}
+
+bool HAL_QSPIEX_IS_BUSY(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return false;
+
+    HAL_FLASH_WRITE_DLEN(hflash, 1 << hflash->dualFlash);
+    HAL_FLASH_ISSUE_CMD(hflash, SPI_FLASH_CMD_RDSR, 0);
+
+    return !HAL_FLASH_IS_PROG_DONE(hflash);
+}
+
+int HAL_QSPIEX_SUSPEND(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return -1;
+
+    // Suspend is not in command table, all supported NOR chips use same opcode
+    HAL_FLASH_MANUAL_CMD(hflash, 0, 0, 0, 0, 0, 0, 0, 1);
+    HAL_FLASH_SET_CMD(hflash, SPI_NOR_CMD_SUSPEND, 0);
+
+    // WIP clear after tSUS, flash can be read then
+    while (HAL_QSPIEX_IS_BUSY(hflash));
+
+    return 0;
+}
+
+int HAL_QSPIEX_RESUME(FLASH_HandleTypeDef *hflash)
+{
+    if (hflash == NULL)
+        return -1;
+
+    HAL_FLASH_MANUAL_CMD(hflash, 0, 0, 0, 0, 0, 0, 0, 1);
+    HAL_FLASH_SET_CMD(hflash, SPI_NOR_CMD_RESUME, 0);
+
+    return 0;
+}
+
 __HAL_ROM_USED int nor_erase_rom(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
 {
     uint32_t al_size;
@@ -385,54 +385,51 @@ static void hal_sdhci_set_adma_desc(uint8_t *desc, uint32_t addr, int len, unsig
 
 int hal_sdhci_adma_table_pre(SDHCI_HandleTypeDef *handle,
                              uint8_t *data, uint32_t size)
+{
+    SDHCI_SgTypeDef sg;
+
+    sg.addr = (uint32_t)data;
+    sg.len = size;
+
+    return hal_sdhci_adma_table_sg(handle, &sg, 1, 0, 0);
+}
+
+int hal_sdhci_adma_table_sg(SDHCI_HandleTypeDef *handle, const SDHCI_SgTypeDef *sg, uint32_t num,
+                            uint32_t max_desc, uint32_t boundary)
 {
     uint8_t *desc;
-    uint32_t addr, buffer;
-    uint32_t len, offset, remain;
+    uint32_t addr, len, remain;
+    uint32_t i, lines;
 
     desc = handle->Init.adma_desc;
-    remain = size;
-    offset = 0;
-    buffer = (uint32_t)data;
+    lines = 0;
 
-    while (offset < size)
+    for (i = 0; i < num; i++)
     {
-        addr = buffer + offset;
-        len = remain > SDHCI_ADMA_MAX_SIZE ? SDHCI_ADMA_MAX_SIZE : remain;
-
-        /* tran, valid */
-        hal_sdhci_set_adma_desc(desc, addr, len, 0x21);
-        desc += 8;
-        offset += len; //(len - offset) > SDHCI_ADMA_MAX_SIZE ? SDHCI_ADMA_MAX_SIZE : (len - offset);
-        remain -= len;
-
-        /*
-         * If this triggers then we have a calculation bug
-         * somewhere. :/
-         */
-        //ASSERT((desc - handle->adma_desc) < (128 * 2 + 1) * 4);
-    }
-
-    if (0) //(SDHCI_QUIRK_NO_ENDATTR_IN_NOPDESC)
-    {
-        /*
-         * Mark the last descriptor as the terminating descriptor
-         */
-        if (desc != handle->Init.adma_desc)
+        addr = sg[i].addr;
+        remain = sg[i].len;
+        while (remain > 0)
         {
-            desc -= 8;
-            desc[0] |= 0x2; /* end */
+            len = remain > SDHCI_ADMA_MAX_SIZE ? SDHCI_ADMA_MAX_SIZE : remain;
+            /* keep line inside one boundary window */
+            if (boundary && (((addr & (boundary - 1)) + len) > boundary))
+                len = boundary - (addr & (boundary - 1));
+
+            /* keep one line for end */
+            if (max_desc && (lines + 1 >= max_desc))
+                return -1;
+
+            /* tran, valid */
+            hal_sdhci_set_adma_desc(desc, addr, len, 0x21);
+            desc += 8;
+            lines++;
+            addr += len;
+            remain -= len;
         }
     }
-    else
-    {
-        /*
-         * Add a terminating entry.
-         */
 
-        /* nop, end, valid */
-        hal_sdhci_set_adma_desc(desc, 0, 0, 0x3);
-    }
+    /* nop, end, valid */
+    hal_sdhci_set_adma_desc(desc, 0, 0, 0x3);
 
     return 0;
 }
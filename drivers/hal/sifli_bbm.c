@@ -21,9 +21,14 @@ static uint32_t bbm_blk_size = 0x20000;
 static uint32_t bbm_page_size = 2048;
 static int gbbm_init_flag = 0;
 
+// logic to physical remap lookup, open addressing with linear probe on logic block
+#define BBM_REMAP_HASH_SIZE         (256)   // power of 2, larger than 2 times of max map table size
+static uint8_t bbm_remap_hash[BBM_REMAP_HASH_SIZE];    // index + 1 in stru_tbl, 0 for empty
+
 uint8_t *bbm_page_cache;
 
 static bbm_log_func g_bbm_dlog = NULL;
+static bbm_crc_func g_bbm_crc = NULL;
 
 
 #define BBM_ASSERT(a)      \
@@ -79,6 +84,8 @@ if((g_bbm_dlog != NULL) && (BBM_DBG_LV >= BBM_DBG_LV_DBG))   \
 static int bbm_write_talbe(int tid, uint16_t blk);
 static uint16_t bbm_replace_blk(uint8_t idx);
 static int bbm_get_page_num(uint32_t blk);
+static void bbm_remap_rebuild(void);
+static int bbm_save_table(void);
 
 
 static const unsigned int crc32tab[] =
@@ -152,6 +159,10 @@ static const unsigned int crc32tab[] =
 uint32_t bbm_crc_check(const uint8_t *buf, uint32_t size)
 {
     unsigned int i, crc;
+
+    if (g_bbm_crc)
+        return g_bbm_crc(buf, size);
+
     crc = 0xFFFFFFFF;
 
     for (i = 0; i < size; i++)
@@ -215,7 +226,6 @@ static int bbm_map_check(Sifli_NandBBM *bbm_table)
 static int bbm_map_new_blk(uint16_t bblk)
 {
     int bad, cnt, i;
-    int nblk1, nblk2;
 
     // found an idle node or the block using node
     cnt = 0;
@@ -276,6 +286,17 @@ static int bbm_map_new_blk(uint16_t bblk)
         BBM_ASSERT(0);
     }
 
+    bbm_remap_rebuild();
+
+    return (int)(bbm_local[0].stru_tbl[cnt].physical_blk); // 0;
+}
+
+// Map table changed by bbm_map_new_blk only in memory, write both tables to flash once
+// after a good block found, so a run of failed replace blocks do not rewrite table each time
+static int bbm_save_table(void)
+{
+    int nblk1, nblk2;
+
     bbm_local[0].hdr_crc = bbm_crc_check((const uint8_t *)(&bbm_local[0]), 16);
     bbm_local[0].tbl_crc = bbm_crc_check((const uint8_t *)(&(bbm_local[0].stru_tbl)), sizeof(Sifli_MapTbl) * (bkup_blk - 4));
     memcpy((void *)&bbm_local[1], (void *)&bbm_local[0], sizeof(Sifli_NandBBM));
@@ -331,7 +352,7 @@ static int bbm_map_new_blk(uint16_t bblk)
     bbm_ctx.cur_blk[0] = nblk1;
     bbm_ctx.cur_blk[1] = nblk2;
 
-    return (int)(bbm_local[0].stru_tbl[cnt].physical_blk); // 0;
+    return 0;
 }
 
 static int bbm_get_page_num(uint32_t blk)
@@ -880,6 +901,11 @@ void bbm_register_log(bbm_log_func log_func)
     g_bbm_dlog = log_func;
 }
 
+void bbm_register_crc(bbm_crc_func crc_func)
+{
+    g_bbm_crc = crc_func;
+}
+
 int sif_bbm_init(uint32_t total, uint8_t *cache)
 {
     int sta, v1, v2;
@@ -947,15 +973,35 @@ int sif_bbm_init(uint32_t total, uint8_t *cache)
         BBM_ERR("detect result %d not reasonable\n", sta);
         BBM_ASSERT(0);
     }
+    bbm_remap_rebuild();
     BBM_INFO("BBM MEM: ctx %p, map1 %p, map2 %p \n", (void *)&bbm_ctx, (void *)&bbm_local[0], (void *)&bbm_local[1]);
 
     BBM_INFO("sif_bbm_init done\n");
     return 0;
 }
 
+static void bbm_remap_rebuild(void)
+{
+    int i;
+    uint32_t h;
+
+    memset(bbm_remap_hash, 0, sizeof(bbm_remap_hash));
+    for (i = 0; i < (int)(bkup_blk - 4); i++)
+    {
+        if ((bbm_local[0].stru_tbl[i].logic_blk == 0) && (bbm_local[0].stru_tbl[i].physical_blk == 0)) // valid table end
+            break;
+
+        h = bbm_local[0].stru_tbl[i].logic_blk & (BBM_REMAP_HASH_SIZE - 1);
+        while (bbm_remap_hash[h] != 0)
+            h = (h + 1) & (BBM_REMAP_HASH_SIZE - 1);
+        bbm_remap_hash[h] = i + 1;
+    }
+}
+
 int bbm_get_phy_blk(uint16_t log_blk)
 {
     int i, res;
+    uint32_t h;
 
     if (log_blk >= user_blk)
         return -1;
@@ -964,8 +1010,10 @@ int bbm_get_phy_blk(uint16_t log_blk)
         return 0;
 
     res = log_blk;
-    for (i = 0; i < (int)(bkup_blk - 4); i++)
+    h = log_blk & (BBM_REMAP_HASH_SIZE - 1);
+    while (bbm_remap_hash[h] != 0)
     {
+        i = bbm_remap_hash[h] - 1;
         if (bbm_local[0].stru_tbl[i].logic_blk == log_blk)
         {
             res = bbm_local[0].stru_tbl[i].physical_blk;
@@ -976,10 +1024,7 @@ int bbm_get_phy_blk(uint16_t log_blk)
             }
             break;
         }
-        else if ((bbm_local[0].stru_tbl[i].logic_blk == 0) && (bbm_local[0].stru_tbl[i].physical_blk == 0)) // not find in valid table
-        {
-            break;
-        }
+        h = (h + 1) & (BBM_REMAP_HASH_SIZE - 1);
     }
 
     return res;
@@ -1100,6 +1145,7 @@ retry:
                     return 0;
                 }
             }
+            bbm_save_table();
 #if 0   // ignore pages after this page, as FORESEE AE said, nand can not write back
             for (i = page + 1; i < bbm_blk_size / bbm_page_size; i++)
             {
@@ -1170,6 +1216,7 @@ int bbm_erase_block(int blk)
                 res = port_erase_block(blk2);
             }
             while (res != 0);
+            bbm_save_table();
             BBM_ERR("Map blk %d to blk %d when erase\n", blk, blk2);
         }
         else
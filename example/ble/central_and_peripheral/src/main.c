@@ -643,6 +643,21 @@ static void ble_app_display_adv_context(ble_gap_ext_adv_report_ind_t *ind, uint8
     rt_free(adv_info_str);
 }
 
+static void ble_app_adv_report(app_env_t *env, ble_gap_ext_adv_report_ind_t *ind)
+{
+    if (ble_app_adv_filter(env, ind) == true)
+        return;
+
+    if (ind->rssi < env->scan_rssi)
+        return;
+
+    if (env->adv_count == BLE_APP_MAX_ADV_COUNT)
+        return;
+
+    ble_app_adv_add(env, ind);
+    ble_app_display_adv_context(ind, env->adv_count);
+}
+
 static void ble_app_display_connected_device(app_env_t *env)
 {
     LOG_I("Total connected %d devices", env->conn_count);
@@ -922,18 +937,15 @@ int ble_app_event_handler(uint16_t event_id, uint8_t *data, uint16_t len, uint32
     case BLE_GAP_EXT_ADV_REPORT_IND:
     {
         ble_gap_ext_adv_report_ind_t *ind = (ble_gap_ext_adv_report_ind_t *)data;
-        if (ble_app_adv_filter(env, ind) == true)
-            break;
-
-        if (ind->rssi < env->scan_rssi)
-            break;
-
-        if (env->adv_count == BLE_APP_MAX_ADV_COUNT)
-        {
-            break;
-        }
-        ble_app_adv_add(env, ind);
-        ble_app_display_adv_context(ind, env->adv_count);
+        ble_app_adv_report(env, ind);
+        break;
+    }
+    case BLE_GAP_EXT_ADV_REPORT_BATCH_IND:
+    {
+        ble_gap_ext_adv_report_batch_ind_t *batch = (ble_gap_ext_adv_report_batch_ind_t *)data;
+        ble_gap_ext_adv_report_ind_t *ind = (ble_gap_ext_adv_report_ind_t *)batch->data;
+        for (uint16_t i = 0; i < batch->count; i++, ind = BLE_GAP_ADV_REPORT_NEXT(ind))
+            ble_app_adv_report(env, ind);
         break;
     }
     case SIBLES_SEARCH_SVC_RSP:
@@ -1139,10 +1151,39 @@ int cmd_diss(int argc, char *argv[])
             {
                 ble_gap_scan_stop();
             }
+            else if (strcmp(argv[2], "filter") == 0 && argc > 5)
+            {
+                ble_gap_scan_filter_t filter = {0};
+                filter.rssi_min = atoi(argv[3]);
+                filter.dup_timeout_ms = atoi(argv[4]);
+                filter.batch_ms = atoi(argv[5]);
+                if (argc > 6)
+                {
+                    // UUID in same byte order as advertising data
+                    filter.uuid_len = strlen(argv[6]) / 2;
+                    if (filter.uuid_len <= ATT_UUID_128_LEN)
+                        hex2data(argv[6], filter.uuid, filter.uuid_len);
+                }
+                LOG_I("Set scan filter %d", ble_gap_scan_set_filter(&filter));
+            }
+            else if (strcmp(argv[2], "nofilter") == 0)
+            {
+                ble_gap_scan_set_filter(NULL);
+            }
+            else if (strcmp(argv[2], "stat") == 0)
+            {
+                ble_gap_scan_filter_stat_t stat;
+                ble_gap_scan_get_filter_stat(&stat, 0);
+                LOG_I("Scan filter: received %d, rssi %d, miss %d, dup %d dropped, delivered %d in %d batches",
+                      stat.received, stat.rssi_dropped, stat.miss_dropped, stat.dup_dropped,
+                      stat.delivered, stat.batches);
+            }
             else
             {
                 LOG_I("Scan start: diss scan start [dup, 0/1] [interval, ms] [window, ms] [duration, ms] [received_rssi]");
                 LOG_I("Scan stop: diss scan stop");
+                LOG_I("Scan filter: diss scan filter [rssi_min] [dup_timeout, ms] [batch, ms] [uuid, little endian hex]");
+                LOG_I("Scan filter off: diss scan nofilter, statistics: diss scan stat");
             }
         }
         else if (strcmp(argv[1], "search_svc") == 0)
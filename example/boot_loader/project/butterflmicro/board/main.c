@@ -88,14 +88,21 @@ void dfu_boot_img_in_flash(int flashid)
     int coreid = DFU_FLASH_IMG_IDX(flashid);
     struct image_header_enc *img_hdr = &(sec_config_cache.imgs[coreid]);
     struct sec_configuration *sec_config = &sec_config_cache;
+    secboot_timing_t *timing = SECBOOT_TIMING;
 
     if (img_hdr->flags & DFU_FLAG_ENC)
     {
         uint32_t is_flash = 1;
+#ifdef PKG_SIFLI_MBEDTLS_BOOT
+        uint32_t hashed = 0;
+        ALIGN(4)
+        uint8_t img_hash[32];
+#endif
 
         /* verify public sig_key hash */
         if (sifli_sigkey_pub_verify(sec_config->sig_pub_key, DFU_SIG_KEY_SIZE))
             sifli_secboot_exception(SECBOOT_SIGKEY_PUB_ERR);
+        sifli_boot_timing_mark(&timing->sigkey);
 
         if (coreid < 4 * CORE_MAX)
         {
@@ -125,14 +132,30 @@ void dfu_boot_img_in_flash(int flashid)
                     /* copy encrypted key to ram as AES_ACC cannot access flash */
                     memcpy(dfu_key, img_hdr->key, sizeof(dfu_key));
                     sifli_hw_dec_key(dfu_key, dfu_key1, sizeof(dfu_key1));
+#ifdef PKG_SIFLI_MBEDTLS_BOOT
+                    /* Read, decrypt and hash chunk by chunk, hash runs while next chunk is read */
+                    if (sifli_img_load_hash(src, (uint8_t *)dest, img_hdr->length, dfu_key1, img_hash))
+                        sifli_secboot_exception(SECBOOT_IMG_HASH_SIG_ERR);
+                    hashed = 1;
+#else
                     g_flash_read(src, (const int8_t *)dest, img_hdr->length);
                     sifli_hw_dec(dfu_key1, (uint8_t *)dest, (uint8_t *)dest, img_hdr->length, 0);
+#endif
                 }
+                timing->img_size = img_hdr->length;
+                timing->in_place = is_addr_in_nor(dest);
 #ifdef PKG_SIFLI_MBEDTLS_BOOT
-                /* verify image hash signature */
-                if (sifli_img_sig_hash_verify(img_hdr->sig, sec_config->sig_pub_key, (uint8_t *)dest, img_hdr->length))
+                /* verify image hash signature, image in XIP is hashed in place */
+                if (!hashed && sifli_img_load_hash(0, (uint8_t *)dest, img_hdr->length, NULL, img_hash))
+                    sifli_secboot_exception(SECBOOT_IMG_HASH_SIG_ERR);
+                sifli_boot_timing_mark(&timing->load);
+                if (sifli_img_sig_verify(img_hdr->sig, sec_config->sig_pub_key, img_hash))
                     sifli_secboot_exception(SECBOOT_IMG_HASH_SIG_ERR);
+                sifli_boot_timing_mark(&timing->verify);
+#else
+                sifli_boot_timing_mark(&timing->load);
 #endif
+                sifli_boot_timing_mark(&timing->jump);
                 run_img(dest);
             }
         }
@@ -146,6 +169,10 @@ void dfu_boot_img_in_flash(int flashid)
                 HAL_FLASH_ALIAS_CFG(boot_handle, dest, img_hdr->length, src - dest);
             else if (src != dest)
                 g_flash_read(src, (const int8_t *)dest, img_hdr->length);
+            timing->img_size = img_hdr->length;
+            timing->in_place = is_addr_in_nor(dest);
+            sifli_boot_timing_mark(&timing->load);
+            sifli_boot_timing_mark(&timing->jump);
             run_img(dest);
         }
     }
@@ -153,6 +180,7 @@ void dfu_boot_img_in_flash(int flashid)
 
 void boot_images_help()
 {
+    sifli_boot_timing_init();
     if (sec_config_cache.magic == SEC_CONFIG_MAGIC)
     {
 #ifdef  CFG_BOOTROM
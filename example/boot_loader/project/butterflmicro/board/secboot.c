@@ -7,6 +7,7 @@
     #include "mbedtls/cipher.h"
     #include "mbedtls/pk.h"
 #endif
+#include "boot_flash.h"
 #include "secboot.h"
 
 /* out buf size must more than 32 byte */
@@ -44,6 +45,86 @@ int sifli_hash_calculate(uint8_t *in, uint32_t in_size, uint8_t *out, uint8_t al
     return 0;
 }
 
+static int secboot_hash_wait(void)
+{
+    uint32_t irq;
+
+    while (hwp_aes_acc->STATUS & AES_ACC_STATUS_HASH_BUSY);
+    irq = hwp_aes_acc->IRQ;
+    hwp_aes_acc->IRQ = irq & (AES_ACC_IRQ_HASH_BUS_ERR_STAT | AES_ACC_IRQ_HASH_PAD_ERR_STAT | AES_ACC_IRQ_HASH_DONE_STAT);
+
+    return (irq & (AES_ACC_IRQ_HASH_BUS_ERR_STAT | AES_ACC_IRQ_HASH_PAD_ERR_STAT)) ? -1 : 0;
+}
+
+/* Start SHA256 of next chunk and return at once, done is polled by secboot_hash_wait() */
+static int secboot_hash_start(uint8_t *in, uint32_t done, uint32_t len, int last, uint8_t *out)
+{
+    HAL_StatusTypeDef r;
+    uint32_t mask;
+
+    /* Resume from result of previous chunk */
+    if (done)
+        HAL_HASH_result(out);
+    HAL_HASH_init(done ? (uint32_t *)out : NULL, HASH_ALGO_SHA256, done);
+
+    /* No AES interrupt handler in bootloader, keep interrupt disabled */
+    mask = __get_PRIMASK();
+    __disable_irq();
+    r = HAL_HASH_run_IT(in, len, last);
+    NVIC_DisableIRQ(AES_IRQn);
+    NVIC_ClearPendingIRQ(AES_IRQn);
+    __set_PRIMASK(mask);
+
+    return (HAL_OK == r) ? 0 : -1;
+}
+
+int sifli_img_load_hash(uint32_t src, uint8_t *dest, uint32_t size, uint8_t *dec_key, uint8_t *out)
+{
+    uint32_t off, len;
+    int busy = 0;
+
+    if (!dest || !size || !out)
+        return -1;
+
+    for (off = 0; off < size; off += len)
+    {
+        len = (size - off) > SECBOOT_LOAD_CHUNK ? SECBOOT_LOAD_CHUNK : (size - off);
+        /* Hash of previous chunk runs in hardware while this one is read */
+        if (src)
+            g_flash_read(src + off, (const int8_t *)(dest + off), len);
+        if (busy && secboot_hash_wait())
+            return -1;
+        /* AES and HASH share AES_ACC, decrypt only after previous hash is done */
+        if (dec_key)
+            sifli_hw_dec(dec_key, dest + off, dest + off, len, off);
+        if (secboot_hash_start(dest + off, off, len, (off + len) >= size, out))
+            return -1;
+        busy = 1;
+    }
+
+    if (secboot_hash_wait())
+        return -1;
+    HAL_HASH_result(out);
+
+    return 0;
+}
+
+void sifli_boot_timing_mark(uint32_t *phase)
+{
+    secboot_timing_t *t = SECBOOT_TIMING;
+
+    *phase = HAL_GTIMER_READ() - t->start;
+}
+
+void sifli_boot_timing_init(void)
+{
+    secboot_timing_t *t = SECBOOT_TIMING;
+
+    memset(t, 0, sizeof(*t));
+    t->magic = SECBOOT_TIMING_MAGIC;
+    t->start = HAL_GTIMER_READ();
+}
+
 int sifli_hash_verify(uint8_t *data, uint32_t data_size, uint8_t *hash, uint32_t hash_size)
 {
     uint8_t hash_out[32] = {0};
@@ -76,13 +157,19 @@ int sifli_sigkey_pub_verify(uint8_t *sigkey, uint32_t key_size)
 int sifli_img_sig_hash_verify(uint8_t *img_hash_sig, uint8_t *sig_pub_key, uint8_t *image, uint32_t img_size)
 {
     uint8_t img_hash[32] = {0};
-    mbedtls_pk_context pk;
 
-    /*1.calculate image hash*/
-    if (sifli_hash_calculate(image, img_size, img_hash, HASH_ALGO_SHA256))
+    /*1.calculate image hash, in place without copy*/
+    if (sifli_img_load_hash(0, image, img_size, NULL, img_hash))
         return -1;
 
     /*2.verify image hash digital signature*/
+    return sifli_img_sig_verify(img_hash_sig, sig_pub_key, img_hash);
+}
+
+int sifli_img_sig_verify(uint8_t *img_hash_sig, uint8_t *sig_pub_key, uint8_t *img_hash)
+{
+    mbedtls_pk_context pk;
+
     mbedtls_pk_init(&pk);
     if (mbedtls_pk_parse_public_key(&pk, sig_pub_key, DFU_SIG_KEY_SIZE))
         return -1;
@@ -6,9 +6,39 @@
 #define SECBOOT_SIGKEY_PUB_ERR      1
 #define SECBOOT_IMG_HASH_SIG_ERR    2
 
+/* Image is read, decrypted and hashed in chunks, must be multiple of 64 */
+#ifndef SECBOOT_LOAD_CHUNK
+    #define SECBOOT_LOAD_CHUNK      (32 * 1024)
+#endif
+
+/* Boot phase timings left in retention memory for application, in GTIMER ticks from start */
+#define SECBOOT_TIMING_MAGIC        0x54425342  /* "BSBT" */
+#ifndef SECBOOT_TIMING_ADDR
+    #define SECBOOT_TIMING_ADDR     (HPSYS_RETM_BASE + HPSYS_RETM_SIZE - sizeof(secboot_timing_t))
+#endif
+#define SECBOOT_TIMING              ((secboot_timing_t *)(SECBOOT_TIMING_ADDR))
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t start;         /* GTIMER when boot_images_help started */
+    uint32_t sigkey;        /* public key checked */
+    uint32_t load;          /* image copied, decrypted and hashed, or hashed in place */
+    uint32_t verify;        /* signature verified */
+    uint32_t jump;          /* before jump to image */
+    uint32_t img_size;
+    uint32_t in_place;      /* 1 if image verified in XIP without copy */
+} secboot_timing_t;
+
 extern void boot_uart_tx(USART_TypeDef *uart, uint8_t *data, int len);
 void sifli_secboot_exception(uint8_t excpt);
 int sifli_sigkey_pub_verify(uint8_t *sigkey, uint32_t key_size);
 int sifli_img_sig_hash_verify(uint8_t *img_hash_sig, uint8_t *sig_pub_key, uint8_t *image, uint32_t img_size);
+int sifli_img_sig_verify(uint8_t *img_hash_sig, uint8_t *sig_pub_key, uint8_t *img_hash);
+/* Read image from flash at src to dest and calculate SHA256 of plaintext to out, hash of one chunk overlaps
+   read of next one. dec_key is plaintext key of encrypted image or NULL. If src is 0, dest is hashed in place. */
+int sifli_img_load_hash(uint32_t src, uint8_t *dest, uint32_t size, uint8_t *dec_key, uint8_t *out);
+void sifli_boot_timing_init(void);
+void sifli_boot_timing_mark(uint32_t *phase);
 #endif /* __SECBOOT_H__ */
 
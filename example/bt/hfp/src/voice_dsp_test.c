@@ -0,0 +1,185 @@
+/**
+  ******************************************************************************
+  * @file   voice_dsp_test.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2025 - 2025,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Bit exactness and cycle count of HFP voice kernels against their scalar reference.
+ *   voice_dsp_test [loops]
+ * CVSD filters must match exactly, PLC pitch search is compared with the float reference
+ * whose rounding may rarely pick a neighbour lag.
+ */
+#include <rtthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "board.h"
+
+#if defined(AUDIO_BT_AUDIO) && defined(BF0_HCPU)
+#include "audio_cvsd.h"
+#include "audio_filter.h"
+#include "audio_msbc_plc.h"
+
+#define CVSD_FRAME_SAMPLES      60      /* 7.5ms at 8k */
+#define CVSD_BIT_SAMPLES        (CVSD_FRAME_SAMPLES * 8)
+
+static int16_t vt_in[FIR_FILTER_LENGTH + CVSD_BIT_SAMPLES];
+static int16_t vt_ref[CVSD_BIT_SAMPLES];
+static int16_t vt_out[CVSD_BIT_SAMPLES];
+
+static uint32_t vt_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+static void vt_signal(int16_t *buf, int len, int seed)
+{
+    /* a few harmonics plus noise, like voiced speech */
+    float f0 = 0.01f + (seed % 7) * 0.004f;
+    for (int i = 0; i < len; i++)
+    {
+        float v = 0.0f;
+        for (int h = 1; h <= 4; h++)
+            v += sinf(f0 * h * i + h) / h;
+        buf[i] = (int16_t)(9000.0f * v) + (rand() % 1024) - 512;
+    }
+}
+
+static void vt_report(const char *name, uint32_t ref, uint32_t opt, int loops, int bad)
+{
+    rt_kprintf("%-12s ref %7d opt %7d cycles %3d.%02dx %s\n", name, ref / loops, opt / loops,
+               opt ? ref / opt : 0, opt ? (ref * 100 / opt) % 100 : 0, bad ? "MISMATCH" : "exact");
+}
+
+static int voice_dsp_test(int argc, char **argv)
+{
+    int loops = (argc > 1) ? atoi(argv[1]) : 20;
+    uint32_t t, ref, opt;
+    int bad, agree;
+    LowcFE_c *lc;
+    cvsd_t cvsd;
+    uint32_t bits[CVSD_FRAME_SAMPLES / 4];
+
+    if (loops <= 0)
+        loops = 1;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* uplink interpolation, 8k to 64k */
+    ref = opt = 0;
+    bad = 0;
+    for (int n = 0; n < loops; n++)
+    {
+        vt_signal(vt_in, FIR_FILTER_LENGTH + CVSD_FRAME_SAMPLES, n);
+        t = vt_cycles();
+        interpolation_x8_c(vt_in, FIR_FILTER_LENGTH + CVSD_FRAME_SAMPLES, vt_ref, CVSD_BIT_SAMPLES);
+        ref += vt_cycles() - t;
+        t = vt_cycles();
+        interpolation_x8(vt_in, FIR_FILTER_LENGTH + CVSD_FRAME_SAMPLES, vt_out, CVSD_BIT_SAMPLES);
+        opt += vt_cycles() - t;
+        bad += memcmp(vt_ref, vt_out, sizeof(vt_out)) != 0;
+    }
+    vt_report("interp_x8", ref, opt, loops, bad);
+
+    /* downlink decimation, 64k to 8k */
+    ref = opt = 0;
+    bad = 0;
+    for (int n = 0; n < loops; n++)
+    {
+        vt_signal(vt_in, FIR_FILTER_LENGTH + CVSD_BIT_SAMPLES, n);
+        t = vt_cycles();
+        decimation_x8_c(vt_in, FIR_FILTER_LENGTH + CVSD_BIT_SAMPLES, vt_ref, CVSD_FRAME_SAMPLES);
+        ref += vt_cycles() - t;
+        t = vt_cycles();
+        decimation_x8(vt_in, FIR_FILTER_LENGTH + CVSD_BIT_SAMPLES, vt_out, CVSD_FRAME_SAMPLES);
+        opt += vt_cycles() - t;
+        bad += memcmp(vt_ref, vt_out, CVSD_FRAME_SAMPLES * sizeof(int16_t)) != 0;
+    }
+    vt_report("decim_x8", ref, opt, loops, bad);
+
+    /* CVSD itself is a bit serial recurrence, only its cost is shown */
+    cvsdInit(&cvsd);
+    t = vt_cycles();
+    for (int n = 0; n < loops; n++)
+        cvsdEncode(&cvsd, vt_in, CVSD_BIT_SAMPLES, (unsigned int *)bits);
+    ref = vt_cycles() - t;
+    cvsdInit(&cvsd);
+    t = vt_cycles();
+    for (int n = 0; n < loops; n++)
+        cvsdDecode(&cvsd, (const unsigned char *)bits, CVSD_FRAME_SAMPLES, vt_out);
+    opt = vt_cycles() - t;
+    rt_kprintf("cvsd         encode %7d decode %7d cycles per frame\n", ref / loops, opt / loops);
+
+    /* PLC pitch search, CVSD (8k) and mSBC (16k) configuration */
+    lc = rt_malloc(sizeof(LowcFE_c));
+    if (lc == NULL)
+        return -RT_ENOMEM;
+    for (int m = 0; m < 2; m++)
+    {
+        ref = opt = 0;
+        agree = 0;
+        for (int n = 0; n < loops; n++)
+        {
+            if (m)
+                msbc_g711plc_construct(lc);
+            else
+                cvsd_g711plc_construct(lc);
+            vt_signal(lc->history, lc->historylen, n);
+            t = vt_cycles();
+            int p_ref = g711plc_pitch_estimate(lc, 1);
+            ref += vt_cycles() - t;
+            t = vt_cycles();
+            int p_opt = g711plc_pitch_estimate(lc, 0);
+            opt += vt_cycles() - t;
+            agree += (p_ref == p_opt);
+        }
+        vt_report(m ? "pitch_msbc" : "pitch_cvsd", ref, opt, loops, 0);
+        rt_kprintf("             pitch agrees with float %d/%d\n", agree, loops);
+    }
+    rt_free(lc);
+
+    return 0;
+}
+MSH_CMD_EXPORT(voice_dsp_test, HFP voice kernel exactness and cycles);
+#endif
@@ -66,6 +66,7 @@ void HAL_MspInit(void)
 #include "bts2_app_inc.h"
 #include "ble_connection_manager.h"
 #include "bt_connection_manager.h"
+#include "bt_lwip.h"
 
 #include "ulog.h"
 
@@ -277,6 +278,9 @@ static void pan_cmd(int argc, char **argv)
     // only valid after connection setup but phone didn't enable pernal hop
     else if (strcmp(argv[1], "conn_pan") == 0)
         bt_app_connect_pan_timeout_handle(NULL);
+    // traffic, throughput and cpu usage since last "stat", run it around iperf
+    else if (strcmp(argv[1], "stat") == 0)
+        bt_lwip_pan_stat();
 }
 MSH_CMD_EXPORT(pan_cmd, Connect PAN to last paired device);
 
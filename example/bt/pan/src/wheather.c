@@ -113,77 +113,45 @@ int check_internet_access()
 
 int http_weather_data_parse(char *json_data)
 {
-
-    uint8_t i, j;
+    uint8_t i;
     uint8_t result_array_size = 0;
-    uint8_t now_array_size = 0;
-    uint32_t temperature = 0;
-
-    cJSON *item = NULL;
     cJSON *root = NULL;
-    cJSON *results_root = NULL;
-    cJSON *now_root = NULL;
-    user_seniverse_config_t user_sen_config;
+    cJSON_Arena arena;
+    user_seniverse_config_t user_sen_config = {0};
 
-    root = cJSON_Parse(json_data);   /*json_data 为心知天气的原始数据*/
+    /* 在原始数据上原地解析, 节点从 arena 分配, 字符串值直接指向 json_data, 无需逐个释放 */
+    cJSON_InitArena(&arena, 0);
+    root = cJSON_ParseArena(&arena, json_data, 0, true);   /*json_data 为心知天气的原始数据*/
     if (!root)
     {
         rt_kprintf("Error before: [%s]\n", cJSON_GetErrorPtr());
+        cJSON_FreeArena(&arena);
         return  -1;
     }
 
-
     cJSON *Presult = cJSON_GetObjectItem(root, "results");  /*results 的键值对为数组，*/
     result_array_size = cJSON_GetArraySize(Presult);  /*求results键值对数组中有多少个元素*/
     for (i = 0; i < result_array_size; i++)
     {
         cJSON *item_results = cJSON_GetArrayItem(Presult, i);
-        char *sresults = cJSON_PrintUnformatted(item_results);
-        results_root = cJSON_Parse(sresults);
-
-        if (!results_root)
-        {
-            rt_kprintf("Error before: [%s]\n", cJSON_GetErrorPtr());
-            return  -1;
-        }
-        cJSON *Plocation = cJSON_GetObjectItem(results_root, "location");
-
-        item = cJSON_GetObjectItem(Plocation, "id");
-        user_sen_config.id = cJSON_Print(item);
-
-        item = cJSON_GetObjectItem(Plocation, "name");
-        user_sen_config.name = cJSON_Print(item);
+        cJSON *Plocation = cJSON_GetObjectItem(item_results, "location");
 
-        item = cJSON_GetObjectItem(Plocation, "country");
-        user_sen_config.country = cJSON_Print(item);
-
-        item = cJSON_GetObjectItem(Plocation, "path");
-        user_sen_config.path = cJSON_Print(item);
-
-        item = cJSON_GetObjectItem(Plocation, "timezone");
-        user_sen_config.timezone = cJSON_Print(item);
-
-        item = cJSON_GetObjectItem(Plocation, "timezone_offset");
-        user_sen_config.timezone_offset = cJSON_Print(item);
+        user_sen_config.id = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "id"));
+        user_sen_config.name = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "name"));
+        user_sen_config.country = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "country"));
+        user_sen_config.path = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "path"));
+        user_sen_config.timezone = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "timezone"));
+        user_sen_config.timezone_offset = cJSON_GetStringValue(cJSON_GetObjectItem(Plocation, "timezone_offset"));
 
         /*-------------------------------------------------------------------*/
-        cJSON *Pnow = cJSON_GetObjectItem(results_root, "now");
-
-        item = cJSON_GetObjectItem(Pnow, "text");
-        user_sen_config.now_config.txt = cJSON_Print(item);
+        cJSON *Pnow = cJSON_GetObjectItem(item_results, "now");
 
-        item = cJSON_GetObjectItem(Pnow, "code");
-        user_sen_config.now_config.code = cJSON_Print(item);
-
-        item = cJSON_GetObjectItem(Pnow, "temperature");
-        user_sen_config.now_config.temperature = cJSON_Print(item);
+        user_sen_config.now_config.txt = cJSON_GetStringValue(cJSON_GetObjectItem(Pnow, "text"));
+        user_sen_config.now_config.code = cJSON_GetStringValue(cJSON_GetObjectItem(Pnow, "code"));
+        user_sen_config.now_config.temperature = cJSON_GetStringValue(cJSON_GetObjectItem(Pnow, "temperature"));
 
         /*-------------------------------------------------------------------*/
-        item = cJSON_GetObjectItem(results_root, "last_update");
-        user_sen_config.last_update = cJSON_Print(item);
-
-        cJSON_Delete(results_root);  /*每次调用cJSON_Parse函数后，都要释放内存*/
-
+        user_sen_config.last_update = cJSON_GetStringValue(cJSON_GetObjectItem(item_results, "last_update"));
     }
 
     rt_kprintf("id:%s\n", user_sen_config.id);
@@ -196,7 +164,8 @@ int http_weather_data_parse(char *json_data)
     rt_kprintf("code:%s\n", user_sen_config.now_config.code);
     rt_kprintf("temperature:%s\n", user_sen_config.now_config.temperature);
     rt_kprintf("last_update:%s\n", user_sen_config.last_update);
-    cJSON_Delete(root);/*每次调用cJSON_Parse函数后，都要释放内存*/
+    rt_kprintf("json parse: %d bytes used, %d bytes allocated\n", arena.used, arena.allocated);
+    cJSON_FreeArena(&arena);/*一次释放所有节点*/
 
     return  0;
 }
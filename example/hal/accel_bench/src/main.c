@@ -0,0 +1,800 @@
+#include "rtthread.h"
+#include "bf0_hal.h"
+#include "drv_io.h"
+#include "stdio.h"
+#include "string.h"
+#include "stdlib.h"
+#include "math.h"
+#include "board.h"
+#ifdef PKG_USING_MBEDTLS
+    #include "mbedtls/aes.h"
+    #include "mbedtls/sha1.h"
+    #include "mbedtls/sha256.h"
+#endif
+
+#define DBG_TAG "acc_bench"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
+
+/* Hardware accelerator benchmark. Each case runs on the engine in polling mode and, where there is one,
+   on CPU with a plain C (or mbedtls) equivalent of the same job.
+   Besides the table, each case prints one CSV line for regression tracking:
+   @bench,<engine>,<case>,<bytes>,<hw_ns>,<hw_cycles>,<sw_ns>,<sw_cycles>
+   times and cycles are per op, sw fields are 0 if there is no software equivalent ---------------*/
+
+#define BENCH_BUF_SIZE      (64 * 1024)
+#define BENCH_MIN_US        (200 * 1000)        /* each case is repeated for at least this long */
+#define BENCH_MAX_ITER      (10000)
+
+typedef void (*bench_op_t)(uint32_t arg);
+
+typedef struct
+{
+    uint32_t iter;
+    uint32_t us;                /* total of iter ops */
+    uint32_t cycles;
+} bench_result_t;
+
+static uint8_t *buf_a, *buf_b;
+
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void bench_cycle_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/* Run op once to warm up cache and get iteration count, then repeat it with scheduler locked */
+static void bench_run(bench_op_t op, uint32_t arg, bench_result_t *r)
+{
+    uint32_t start, cyc, i;
+
+    start = HAL_GTIMER_READ();
+    op(arg);
+    r->iter = BENCH_MIN_US / (elapsed_us(start) + 1) + 1;
+    if (r->iter > BENCH_MAX_ITER)
+        r->iter = BENCH_MAX_ITER;
+
+    rt_enter_critical();
+    cyc = DWT->CYCCNT;
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < r->iter; i++)
+        op(arg);
+    r->us = elapsed_us(start);
+    r->cycles = DWT->CYCCNT - cyc;
+    rt_exit_critical();
+
+    if (r->us == 0)
+        r->us = 1;
+}
+
+static uint32_t result_ns(bench_result_t *r)
+{
+    return r->iter ? (uint32_t)((uint64_t)r->us * 1000 / r->iter) : 0;
+}
+
+static uint32_t result_cycles(bench_result_t *r)
+{
+    return r->iter ? r->cycles / r->iter : 0;
+}
+
+/* MB/s in 0.01 unit, 1 byte/us is 1 MB/s */
+static uint32_t result_mbps(uint32_t bytes, bench_result_t *r)
+{
+    return (uint32_t)((uint64_t)bytes * r->iter * 100 / r->us);
+}
+
+static void report_header(void)
+{
+    rt_kprintf("%-6s %-18s %8s | %9s %9s %10s | %9s %10s | %7s\n", "engine", "case", "bytes",
+               "hw MB/s", "hw op/s", "hw cyc/op", "sw MB/s", "sw cyc/op", "speedup");
+}
+
+static void report(const char *engine, const char *name, uint32_t bytes, bench_result_t *hw, bench_result_t *sw)
+{
+    uint32_t hw_mbps = result_mbps(bytes, hw);
+
+    rt_kprintf("%-6s %-18s %8d | %6d.%02d %9d %10d | ", engine, name, bytes,
+               hw_mbps / 100, hw_mbps % 100, (uint32_t)((uint64_t)hw->iter * 1000000 / hw->us), result_cycles(hw));
+    if (sw && sw->iter)
+    {
+        uint32_t sw_mbps = result_mbps(bytes, sw);
+        uint32_t speedup = (uint32_t)((uint64_t)result_ns(sw) * 10 / (result_ns(hw) + 1));
+
+        rt_kprintf("%6d.%02d %10d | %5d.%dx\n", sw_mbps / 100, sw_mbps % 100, result_cycles(sw),
+                   speedup / 10, speedup % 10);
+    }
+    else
+    {
+        rt_kprintf("%9s %10s | %7s\n", "-", "-", "-");
+    }
+
+    rt_kprintf("@bench,%s,%s,%d,%d,%d,%d,%d\n", engine, name, bytes, result_ns(hw), result_cycles(hw),
+               sw ? result_ns(sw) : 0, sw ? result_cycles(sw) : 0);
+}
+
+static void fill_random(uint8_t *buf, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++)
+        buf[i] = (uint8_t)rand();
+}
+
+/* EPIC: fill, blend and rotate of square RGB565 area -----------------------------------------*/
+#ifdef HAL_EPIC_MODULE_ENABLED
+static EPIC_HandleTypeDef epic_handle;
+static EZIP_HandleTypeDef ezip_handle;
+
+static const uint16_t epic_size[] = {64, 128, 180};
+
+static void epic_layer_init(EPIC_BlendingDataType *layer, uint8_t *data, uint16_t n)
+{
+    HAL_EPIC_BlendDataInit(layer);
+    layer->data = data;
+    layer->x_offset = 0;
+    layer->y_offset = 0;
+    layer->width = n;
+    layer->height = n;
+    layer->total_width = n;
+    layer->color_mode = EPIC_COLOR_RGB565;
+    layer->color_en = false;
+}
+
+static void epic_fill_hw(uint32_t n)
+{
+    EPIC_FillingCfgTypeDef cfg;
+
+    HAL_EPIC_FillDataInit(&cfg);
+    cfg.start = buf_b;
+    cfg.color_mode = EPIC_COLOR_RGB565;
+    cfg.width = n;
+    cfg.height = n;
+    cfg.total_width = n;
+    cfg.color_r = 0x12;
+    cfg.color_g = 0x34;
+    cfg.color_b = 0x56;
+    cfg.alpha = 255;
+    HAL_EPIC_FillStart(&epic_handle, &cfg);
+}
+
+static void epic_fill_sw(uint32_t n)
+{
+    uint16_t *p = (uint16_t *)buf_b;
+    uint32_t i;
+
+    for (i = 0; i < n * n; i++)
+        p[i] = 0x11AA;
+}
+
+static void epic_blend_hw(uint32_t n)
+{
+    EPIC_BlendingDataType fg, bg, dst;
+
+    epic_layer_init(&fg, buf_a, n);
+    epic_layer_init(&bg, buf_b, n);
+    epic_layer_init(&dst, buf_b, n);
+    HAL_EPIC_BlendStart(&epic_handle, &fg, &bg, &dst, 128);
+}
+
+static void epic_blend_sw(uint32_t n)
+{
+    const uint16_t *fg = (const uint16_t *)buf_a;
+    uint16_t *bg = (uint16_t *)buf_b;
+    uint32_t i, a = 128;
+
+    for (i = 0; i < n * n; i++)
+    {
+        uint32_t f = fg[i], b = bg[i];
+        uint32_t r = (((f >> 11) * a) + ((b >> 11) * (256 - a))) >> 8;
+        uint32_t g = ((((f >> 5) & 0x3F) * a) + (((b >> 5) & 0x3F) * (256 - a))) >> 8;
+        uint32_t bl = (((f & 0x1F) * a) + ((b & 0x1F) * (256 - a))) >> 8;
+
+        bg[i] = (uint16_t)((r << 11) | (g << 5) | bl);
+    }
+}
+
+static void epic_rotate_hw(uint32_t n)
+{
+    EPIC_BlendingDataType fg, bg, dst;
+    EPIC_TransformCfgTypeDef cfg;
+
+    epic_layer_init(&fg, buf_a, n);
+    epic_layer_init(&bg, buf_b, n);
+    epic_layer_init(&dst, buf_b, n);
+    HAL_EPIC_RotDataInit(&cfg);
+    cfg.angle = 300;
+    cfg.pivot_x = n / 2;
+    cfg.pivot_y = n / 2;
+    HAL_EPIC_Rotate(&epic_handle, &cfg, &fg, &bg, &dst, 255);
+}
+
+/* Nearest neighbour rotation by 30 degree around center, Q16 fixed point */
+static void epic_rotate_sw(uint32_t n)
+{
+    const int32_t c = 56756, s = 32768;     /* cos/sin(30) in Q16 */
+    const uint16_t *src = (const uint16_t *)buf_a;
+    uint16_t *dst = (uint16_t *)buf_b;
+    int32_t half = n / 2;
+    int32_t x, y;
+
+    for (y = 0; y < (int32_t)n; y++)
+    {
+        int32_t sx = -(half * c) + (y - half) * s + (half << 16);
+        int32_t sy = (half * s) + (y - half) * c + (half << 16);
+
+        for (x = 0; x < (int32_t)n; x++, sx += c, sy -= s)
+        {
+            int32_t ix = sx >> 16, iy = sy >> 16;
+
+            if ((uint32_t)ix < n && (uint32_t)iy < n)
+                dst[y * n + x] = src[iy * n + ix];
+        }
+    }
+}
+
+static void bench_epic(void)
+{
+    bench_result_t hw, sw;
+    char name[24];
+    uint32_t i, n;
+
+    epic_handle.hezip = &ezip_handle;
+    epic_handle.hezip->Instance = EZIP;
+    HAL_EZIP_Init(epic_handle.hezip);
+    epic_handle.Instance = hwp_epic;
+    HAL_EPIC_Init(&epic_handle);
+
+    fill_random(buf_a, BENCH_BUF_SIZE);
+    fill_random(buf_b, BENCH_BUF_SIZE);
+    for (i = 0; i < sizeof(epic_size) / sizeof(epic_size[0]); i++)
+    {
+        n = epic_size[i];
+
+        rt_snprintf(name, sizeof(name), "fill_%dx%d", n, n);
+        bench_run(epic_fill_hw, n, &hw);
+        bench_run(epic_fill_sw, n, &sw);
+        report("epic", name, n * n * 2, &hw, &sw);
+
+        rt_snprintf(name, sizeof(name), "blend_%dx%d", n, n);
+        bench_run(epic_blend_hw, n, &hw);
+        bench_run(epic_blend_sw, n, &sw);
+        report("epic", name, n * n * 2, &hw, &sw);
+
+        rt_snprintf(name, sizeof(name), "rotate30_%dx%d", n, n);
+        bench_run(epic_rotate_hw, n, &hw);
+        bench_run(epic_rotate_sw, n, &sw);
+        report("epic", name, n * n * 2, &hw, &sw);
+    }
+}
+#endif /* HAL_EPIC_MODULE_ENABLED */
+
+/* EZIP: decode 88x88 ARGB565 image to AHB ---------------------------------------------------*/
+#ifdef HAL_EZIP_MODULE_ENABLED
+ALIGN(4)
+static const uint8_t ezip_img[] =
+{
+#include "img_clock_565A_s_ezip.dat"
+};
+#define EZIP_IMG_W      (88)
+#define EZIP_IMG_H      (88)
+
+static EZIP_HandleTypeDef ezip_bench_handle;
+
+static void ezip_decode_hw(uint32_t arg)
+{
+    EZIP_DecodeConfigTypeDef config = {0};
+
+    config.input = (uint8_t *)ezip_img;
+    config.output = buf_a;
+    config.start_x = 0;
+    config.start_y = 0;
+    config.width = EZIP_IMG_W;
+    config.height = EZIP_IMG_H;
+    config.work_mode = HAL_EZIP_MODE_EZIP;
+    config.output_mode = HAL_EZIP_OUTPUT_AHB;
+    HAL_EZIP_Decode(&ezip_bench_handle, &config);
+}
+
+static void bench_ezip(void)
+{
+    bench_result_t hw;
+
+    ezip_bench_handle.Instance = EZIP;
+    HAL_EZIP_Init(&ezip_bench_handle);
+
+    bench_run(ezip_decode_hw, 0, &hw);
+    /* report output size, input is sizeof(ezip_img) */
+    report("ezip", "argb565_88x88", EZIP_IMG_W * EZIP_IMG_H * 3, &hw, NULL);
+}
+#endif /* HAL_EZIP_MODULE_ENABLED */
+
+/* FFT: 16bit complex FFT of each supported length ------------------------------------------*/
+#if defined(HAL_FFT_MODULE_ENABLED) && defined(hwp_fft1)
+#define SW_FFT_MAX      (4096)
+
+static FFT_HandleTypeDef fft_handle;
+static int16_t sw_fft_tw[SW_FFT_MAX];       /* cos, -sin pairs of SW_FFT_MAX / 2 points */
+
+static void fft_hw(uint32_t len_type)
+{
+    FFT_ConfigTypeDef config;
+
+    memset(&config, 0, sizeof(config));
+    config.bitwidth = FFT_BW_16BIT;
+    config.fft_length = (FFT_FFTLengthTypeDef)len_type;
+    config.input_data = buf_a;
+    config.output_data = buf_b;
+    HAL_FFT_StartFFT(&fft_handle, &config);
+}
+
+/* Radix-2 Q15 FFT with 1/2 scaling each stage, same input/output buffers as hardware */
+static void fft_sw(uint32_t len_type)
+{
+    uint32_t n = 16 << len_type;
+    uint32_t *w = (uint32_t *)buf_b;
+    int16_t *x = (int16_t *)buf_b;
+    uint32_t i, j, k, len, half, step, bit;
+
+    memcpy(buf_b, buf_a, n * 4);
+    for (i = 1, j = 0; i < n; i++)
+    {
+        for (bit = n >> 1; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            uint32_t t = w[i];
+            w[i] = w[j];
+            w[j] = t;
+        }
+    }
+
+    for (len = 2; len <= n; len <<= 1)
+    {
+        half = len >> 1;
+        step = SW_FFT_MAX / len;
+        for (i = 0; i < n; i += len)
+        {
+            for (k = 0; k < half; k++)
+            {
+                int16_t *a = &x[2 * (i + k)];
+                int16_t *b = &x[2 * (i + k + half)];
+                int32_t wr = sw_fft_tw[2 * k * step], wi = sw_fft_tw[2 * k * step + 1];
+                int32_t tr = (b[0] * wr - b[1] * wi) >> 15;
+                int32_t ti = (b[0] * wi + b[1] * wr) >> 15;
+                int32_t ar = a[0], ai = a[1];
+
+                a[0] = (int16_t)((ar + tr) >> 1);
+                a[1] = (int16_t)((ai + ti) >> 1);
+                b[0] = (int16_t)((ar - tr) >> 1);
+                b[1] = (int16_t)((ai - ti) >> 1);
+            }
+        }
+    }
+}
+
+static void bench_fft(void)
+{
+    bench_result_t hw, sw;
+    char name[24];
+    uint32_t i, n;
+
+    HAL_RCC_EnableModule(RCC_MOD_FFT1);
+    fft_handle.Instance = hwp_fft1;
+    HAL_FFT_Init(&fft_handle);
+
+    for (i = 0; i < SW_FFT_MAX / 2; i++)
+    {
+        sw_fft_tw[2 * i] = (int16_t)(cosf(2 * 3.14159265f * i / SW_FFT_MAX) * 32767);
+        sw_fft_tw[2 * i + 1] = (int16_t)(-sinf(2 * 3.14159265f * i / SW_FFT_MAX) * 32767);
+    }
+
+    fill_random(buf_a, BENCH_BUF_SIZE);
+    for (i = FFT_LEN_64; i <= FFT1_LEN_MAX; i++)
+    {
+        n = 16 << i;
+        rt_snprintf(name, sizeof(name), "cfft16_%d", n);
+        bench_run(fft_hw, i, &hw);
+        bench_run(fft_sw, i, &sw);
+        report("fft", name, n * 4, &hw, &sw);
+    }
+}
+#endif /* HAL_FFT_MODULE_ENABLED && hwp_fft1 */
+
+/* FACC: 16bit FIR over 1024 samples with different taps ------------------------------------*/
+#if defined(HAL_FACC_MODULE_ENABLED) && defined(hwp_facc1)
+#define FIR_SAMPLES     (1024)
+
+static FACC_HandleTypeDef facc_handle;
+static int16_t fir_coef[64];
+
+static void facc_fir_hw(uint32_t taps)
+{
+    FACC_ConfigTypeDef cfg = {0};
+
+    cfg.mod_sel = 0;        /* fir */
+    cfg.fp_sel = 0;         /* 16bit */
+    HAL_FACC_Config(&facc_handle, &cfg);
+    HAL_FACC_SetCoeffFir(&facc_handle, (uint8_t *)fir_coef, taps * sizeof(int16_t));
+    HAL_FACC_Start(&facc_handle, buf_a, buf_b, FIR_SAMPLES * sizeof(int16_t));
+}
+
+static void facc_fir_sw(uint32_t taps)
+{
+    const int16_t *x = (const int16_t *)buf_a;
+    int16_t *y = (int16_t *)buf_b;
+    uint32_t n, k;
+
+    for (n = 0; n < FIR_SAMPLES; n++)
+    {
+        int32_t acc = 0;
+
+        for (k = 0; k < taps && k <= n; k++)
+            acc += fir_coef[k] * x[n - k];
+        acc >>= 15;
+        y[n] = (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+    }
+}
+
+static void bench_facc(void)
+{
+    static const uint8_t taps[] = {8, 16, 32, 64};
+    bench_result_t hw, sw;
+    char name[24];
+    uint32_t i;
+
+    HAL_RCC_EnableModule(RCC_MOD_FACC1);
+    facc_handle.Instance = hwp_facc1;
+    HAL_FACC_Init(&facc_handle);
+
+    for (i = 0; i < sizeof(fir_coef) / sizeof(fir_coef[0]); i++)
+        fir_coef[i] = (int16_t)(rand() % 2048 - 1024);
+    fill_random(buf_a, FIR_SAMPLES * sizeof(int16_t));
+
+    for (i = 0; i < sizeof(taps); i++)
+    {
+        rt_snprintf(name, sizeof(name), "fir16_%dtap", taps[i]);
+        bench_run(facc_fir_hw, taps[i], &hw);
+        bench_run(facc_fir_sw, taps[i], &sw);
+        report("facc", name, FIR_SAMPLES * sizeof(int16_t), &hw, &sw);
+    }
+    HAL_FACC_DeInit(&facc_handle);
+}
+#endif /* HAL_FACC_MODULE_ENABLED && hwp_facc1 */
+
+/* AES and HASH: modes and sizes, compared with mbedtls if it's built ------------------------*/
+#ifdef HAL_AES_MODULE_ENABLED
+ALIGN(4) static uint8_t aes_key[32] = "0123456789abcdef0123456789abcde";
+ALIGN(4) static uint8_t aes_iv[16] = "fedcba987654321";
+static uint32_t aes_mode, aes_key_size;
+
+static void aes_hw(uint32_t size)
+{
+    HAL_AES_init((uint32_t *)aes_key, aes_key_size, (uint32_t *)aes_iv, aes_mode);
+    HAL_AES_run(AES_ENC, buf_a, buf_b, size);
+}
+
+#ifdef PKG_USING_MBEDTLS
+static void aes_sw(uint32_t size)
+{
+    mbedtls_aes_context ctx;
+    uint8_t iv[16], stream[16];
+    size_t off = 0;
+    uint32_t i;
+
+    memcpy(iv, aes_iv, sizeof(iv));
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, aes_key, aes_key_size * 8);
+    if (AES_MODE_ECB == aes_mode)
+    {
+        for (i = 0; i < size; i += 16)
+            mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, buf_a + i, buf_b + i);
+    }
+#ifdef MBEDTLS_CIPHER_MODE_CBC
+    else if (AES_MODE_CBC == aes_mode)
+    {
+        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, size, iv, buf_a, buf_b);
+    }
+#endif
+#ifdef MBEDTLS_CIPHER_MODE_CTR
+    else if (AES_MODE_CTR == aes_mode)
+    {
+        mbedtls_aes_crypt_ctr(&ctx, size, &off, iv, stream, buf_a, buf_b);
+    }
+#endif
+    mbedtls_aes_free(&ctx);
+}
+#endif /* PKG_USING_MBEDTLS */
+
+static uint8_t hash_algo;
+
+static void hash_hw(uint32_t size)
+{
+    uint8_t result[32];
+
+    HAL_HASH_reset();
+    HAL_HASH_init(NULL, hash_algo, 0);
+    HAL_HASH_run(buf_a, size, 1);
+    HAL_HASH_result(result);
+}
+
+#ifdef PKG_USING_MBEDTLS
+static void hash_sw(uint32_t size)
+{
+    uint8_t result[32];
+
+    if (HASH_ALGO_SHA1 == hash_algo)
+        mbedtls_sha1(buf_a, size, result);
+    else
+        mbedtls_sha256(buf_a, size, result, HASH_ALGO_SHA224 == hash_algo);
+}
+#endif /* PKG_USING_MBEDTLS */
+
+static void bench_aes(void)
+{
+    static const uint32_t sizes[] = {1024, 16 * 1024};
+    static const struct
+    {
+        const char *name;
+        uint32_t mode;
+        uint32_t key_size;
+    } modes[] =
+    {
+        {"ecb128", AES_MODE_ECB, 16},
+        {"cbc128", AES_MODE_CBC, 16},
+        {"ctr128", AES_MODE_CTR, 16},
+        {"cbc256", AES_MODE_CBC, 32},
+    };
+    static const struct
+    {
+        const char *name;
+        uint8_t algo;
+    } algos[] =
+    {
+        {"sha1", HASH_ALGO_SHA1},
+        {"sha224", HASH_ALGO_SHA224},
+        {"sha256", HASH_ALGO_SHA256},
+        {"sm3", HASH_ALGO_SM3},
+    };
+    bench_result_t hw, sw;
+    char name[24];
+    uint32_t i, j;
+
+    fill_random(buf_a, BENCH_BUF_SIZE);
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        aes_mode = modes[i].mode;
+        aes_key_size = modes[i].key_size;
+        for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++)
+        {
+            rt_snprintf(name, sizeof(name), "%s_%d", modes[i].name, sizes[j]);
+            memset(&sw, 0, sizeof(sw));
+            HAL_AES_reset();
+            bench_run(aes_hw, sizes[j], &hw);
+#ifdef PKG_USING_MBEDTLS
+            bench_run(aes_sw, sizes[j], &sw);
+#endif
+            report("aes", name, sizes[j], &hw, &sw);
+        }
+    }
+
+    for (i = 0; i < sizeof(algos) / sizeof(algos[0]); i++)
+    {
+        hash_algo = algos[i].algo;
+        for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++)
+        {
+            rt_snprintf(name, sizeof(name), "%s_%d", algos[i].name, sizes[j]);
+            memset(&sw, 0, sizeof(sw));
+            bench_run(hash_hw, sizes[j], &hw);
+#ifdef PKG_USING_MBEDTLS
+            if (HASH_ALGO_SM3 != hash_algo)
+                bench_run(hash_sw, sizes[j], &sw);
+#endif
+            report("hash", name, sizes[j], &hw, &sw);
+        }
+    }
+}
+#endif /* HAL_AES_MODULE_ENABLED */
+
+/* NN_ACC: 3x3 int8 convolution, stride 1, padding 1 ------------------------------------------*/
+#if defined(HAL_NNACC_MODULE_ENABLED) && defined(hwp_nnacc)
+#define NN_WT_MAX       (3 * 3 * 64)
+#define NN_ROUND(sh)    ((((uint32_t)1) << (sh)) >> 1)
+
+static NNACC_HandleTypeDef nn_handle;
+static NNACC_ConfigTypeDef nn_cfg;
+static int8_t nn_wt[NN_WT_MAX];
+static int8_t nn_bias[64];
+
+static void nn_hw(uint32_t arg)
+{
+    HAL_NNACC_Start(&nn_handle, &nn_cfg);
+}
+
+/* Same loops as CMSIS-NN reference, HWC layout, weight of conv2d is [out_ch][ky][kx][in_ch] */
+static void nn_sw(uint32_t arg)
+{
+    NNACC_ConfigTypeDef *c = &nn_cfg;
+    int depthwise = (HAL_NNACC_MODE_DEPTHWISE_CONV2D == c->mode);
+    int oy, ox, oc, ky, kx, ic;
+
+    for (oy = 0; oy < c->out_dim_y; oy++)
+        for (ox = 0; ox < c->out_dim_x; ox++)
+            for (oc = 0; oc < c->out_ch_num; oc++)
+            {
+                int32_t acc = ((int32_t)c->bias[oc] << c->bias_shift) + NN_ROUND(c->out_shift);
+
+                for (ky = 0; ky < c->kernel_dim_y; ky++)
+                    for (kx = 0; kx < c->kernel_dim_x; kx++)
+                    {
+                        int iy = c->stride_y * oy + ky - c->padding_y;
+                        int ix = c->stride_x * ox + kx - c->padding_x;
+                        const int8_t *in;
+
+                        if (iy < 0 || ix < 0 || iy >= c->in_dim_y || ix >= c->in_dim_x)
+                            continue;
+                        in = c->input + (iy * c->in_dim_x + ix) * c->in_ch_num;
+                        if (depthwise)
+                        {
+                            acc += in[oc] * c->wt[(ky * c->kernel_dim_x + kx) * c->out_ch_num + oc];
+                        }
+                        else
+                        {
+                            const int8_t *wt = c->wt + ((oc * c->kernel_dim_y + ky) * c->kernel_dim_x + kx) * c->in_ch_num;
+
+                            for (ic = 0; ic < c->in_ch_num; ic++)
+                                acc += in[ic] * wt[ic];
+                        }
+                    }
+                c->output[(oy * c->out_dim_x + ox) * c->out_ch_num + oc] = (int8_t)__SSAT(acc >> c->out_shift, 8);
+            }
+}
+
+static void bench_nn(void)
+{
+    static const struct
+    {
+        HAL_NNACC_ModeTypeDef mode;
+        uint16_t dim, in_ch, out_ch;
+    } shapes[] =
+    {
+        {HAL_NNACC_MODE_DEPTHWISE_CONV2D, 32, 16, 16},
+        {HAL_NNACC_MODE_DEPTHWISE_CONV2D, 16, 32, 32},
+        {HAL_NNACC_MODE_DEPTHWISE_CONV2D,  8, 64, 64},
+        {HAL_NNACC_MODE_CONV2D,           16,  8,  8},
+        {HAL_NNACC_MODE_CONV2D,            8, 16, 4},
+    };
+    bench_result_t hw, sw;
+    char name[24];
+    uint32_t i, macs;
+
+    nn_handle.instance = hwp_nnacc;
+#ifdef SF32LB55X
+    HAL_RCC_EnableModule(RCC_MOD_NNACC);
+#else
+    if (hwp_nnacc1 == nn_handle.instance)
+        HAL_RCC_EnableModule(RCC_MOD_NNACC1);
+    else
+        HAL_RCC_EnableModule(RCC_MOD_NNACC2);
+#endif /* SF32LB55X */
+    if (HAL_OK != HAL_NNACC_Init(&nn_handle))
+    {
+        LOG_E("nnacc init fail");
+        return;
+    }
+
+    fill_random((uint8_t *)nn_wt, sizeof(nn_wt));
+    fill_random((uint8_t *)nn_bias, sizeof(nn_bias));
+    fill_random(buf_a, BENCH_BUF_SIZE);
+    for (i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+    {
+        memset(&nn_cfg, 0, sizeof(nn_cfg));
+        nn_cfg.mode = shapes[i].mode;
+        nn_cfg.input = (const int8_t *)buf_a;
+        nn_cfg.output = (int8_t *)buf_b;
+        nn_cfg.wt = nn_wt;
+        nn_cfg.bias = nn_bias;
+        nn_cfg.in_dim_x = nn_cfg.in_dim_y = shapes[i].dim;
+        nn_cfg.out_dim_x = nn_cfg.out_dim_y = shapes[i].dim;
+        nn_cfg.in_ch_num = shapes[i].in_ch;
+        nn_cfg.out_ch_num = shapes[i].out_ch;
+        nn_cfg.kernel_dim_x = nn_cfg.kernel_dim_y = 3;
+        nn_cfg.padding_x = nn_cfg.padding_y = 1;
+        nn_cfg.stride_x = nn_cfg.stride_y = 1;
+        nn_cfg.bias_shift = 0;
+        nn_cfg.out_shift = 7;
+
+        macs = shapes[i].dim * shapes[i].dim * 9 * shapes[i].out_ch;
+        if (HAL_NNACC_MODE_CONV2D == shapes[i].mode)
+            macs *= shapes[i].in_ch;
+        rt_snprintf(name, sizeof(name), "%s_%dx%dx%d_%d", (HAL_NNACC_MODE_CONV2D == shapes[i].mode) ? "conv" : "dw",
+                    shapes[i].dim, shapes[i].dim, shapes[i].in_ch, shapes[i].out_ch);
+        bench_run(nn_hw, 0, &hw);
+        bench_run(nn_sw, 0, &sw);
+        /* bytes column is MAC count for NN cases, MB/s reads as M MAC/s */
+        report("nn", name, macs, &hw, &sw);
+    }
+}
+#endif /* HAL_NNACC_MODULE_ENABLED && hwp_nnacc */
+
+static const char *chip_name(void)
+{
+#if defined(SF32LB52X)
+    return "SF32LB52X";
+#elif defined(SF32LB55X)
+    return "SF32LB55X";
+#elif defined(SF32LB56X)
+    return "SF32LB56X";
+#elif defined(SF32LB58X)
+    return "SF32LB58X";
+#else
+    return "unknown";
+#endif
+}
+
+static int acc_bench(int argc, char **argv)
+{
+    const char *engine = (argc > 1) ? argv[1] : "all";
+    int all = (0 == strcmp(engine, "all"));
+
+    if (NULL == buf_a)
+        buf_a = rt_malloc_align(BENCH_BUF_SIZE, 32);
+    if (NULL == buf_b)
+        buf_b = rt_malloc_align(BENCH_BUF_SIZE, 32);
+    if (NULL == buf_a || NULL == buf_b)
+    {
+        LOG_E("no buffer");
+        return -1;
+    }
+
+    bench_cycle_init();
+    srand(1);
+    rt_kprintf("@bench_cfg,%s,hclk=%d\n", chip_name(), HAL_RCC_GetHCLKFreq(CORE_ID_DEFAULT));
+    report_header();
+
+#ifdef HAL_EPIC_MODULE_ENABLED
+    if (all || 0 == strcmp(engine, "epic"))
+        bench_epic();
+#endif
+#ifdef HAL_EZIP_MODULE_ENABLED
+    if (all || 0 == strcmp(engine, "ezip"))
+        bench_ezip();
+#endif
+#if defined(HAL_FFT_MODULE_ENABLED) && defined(hwp_fft1)
+    if (all || 0 == strcmp(engine, "fft"))
+        bench_fft();
+#endif
+#if defined(HAL_FACC_MODULE_ENABLED) && defined(hwp_facc1)
+    if (all || 0 == strcmp(engine, "facc"))
+        bench_facc();
+#endif
+#ifdef HAL_AES_MODULE_ENABLED
+    if (all || 0 == strcmp(engine, "aes"))
+        bench_aes();
+#endif
+#if defined(HAL_NNACC_MODULE_ENABLED) && defined(hwp_nnacc)
+    if (all || 0 == strcmp(engine, "nn"))
+        bench_nn();
+#endif
+    rt_kprintf("@bench_end\n");
+
+    return 0;
+}
+MSH_CMD_EXPORT(acc_bench, acc_bench [all|epic|ezip|fft|facc|aes|nn]: accelerator benchmark);
+
+int main(void)
+{
+    rt_kprintf("Use acc_bench to start\n");
+
+    while (1)
+    {
+        rt_thread_mdelay(10000);    // Let system breath.
+    }
+    return 0;
+}
@@ -0,0 +1,513 @@
+#include "rtthread.h"
+#include "bf0_hal.h"
+#include "drv_io.h"
+#include "stdio.h"
+#include "string.h"
+#include "stdlib.h"
+#include "board.h"
+#include "mem_section.h"
+#ifdef BSP_USING_SPI_FLASH
+    #include "drv_flash.h"
+#endif
+#ifdef BSP_USING_PSRAM
+    #include "drv_psram.h"
+#endif
+
+#define DBG_TAG "mem_bench"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
+
+/* Memory benchmark, for each memory region and cache mode measures sequential and random
+   bandwidth/latency by CPU, and copy from/to SRAM by CPU, DMA and EXT_DMA.
+   Besides the table, each result prints one CSV line for regression tracking:
+   @mem,<core>,<region>,<cache>,<test>,<bytes>,<us>,<ops>
+   'mem_bench erase <addr>' measures XIP read latency while NOR sector is being erased -------*/
+
+#ifndef MEM_BENCH_SIZE
+    #define MEM_BENCH_SIZE      (32 * 1024)     /* bytes tested in each region, also DMA copy size */
+#endif
+#ifndef MEM_BENCH_LOOP
+    #define MEM_BENCH_LOOP      (16)
+#endif
+#define MEM_BENCH_RAND_NUM      (1024)
+#ifndef MEM_BENCH_NOR_CACHE_ON
+    #define MEM_BENCH_NOR_CACHE_ON  FLASH_CACHE_ENABLE      /* mode restored after cache off test */
+#endif
+#define MEM_BENCH_XIP_SPAN      (512 * 1024)    /* XIP range read by erase test */
+#define MEM_BENCH_STALL_US      (50)            /* XIP read slower than this is counted as stall */
+
+#ifdef SOC_BF0_HCPU
+    #define MEM_BENCH_CORE      "hcpu"
+    #define MEM_BENCH_DMA       DMA1_Channel8
+#else
+    #define MEM_BENCH_CORE      "lcpu"
+    #define MEM_BENCH_DMA       DMA2_Channel8
+#endif
+
+#define MEM_F_RO        (1 << 0)    /* read only, e.g. XIP */
+#define MEM_F_NOR       (1 << 1)    /* NOR flash, cache set by rt_flash_set_cache */
+#define MEM_F_NAND      (1 << 2)    /* no XIP, read by rt_nand_read */
+
+typedef struct
+{
+    const char *name;
+    uint32_t addr;
+    uint32_t size;
+    uint32_t flags;
+} mem_region_t;
+
+static uint8_t *sram_buf;
+static uint32_t rand_ofs[MEM_BENCH_RAND_NUM];
+static volatile uint32_t sink;
+static const char *cur_cache;
+
+#ifdef BSP_USING_PSRAM
+L2_NON_RET_BSS_SECT(mem_bench, ALIGN(32) static uint8_t psram_buf[MEM_BENCH_SIZE]);
+#endif
+
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void report_header(void)
+{
+    rt_kprintf("%-6s %-5s %-14s %9s %9s\n", "region", "cache", "test", "MB/s", "ns/op");
+}
+
+/* ops is number of accesses for latency, 0 if only bandwidth is meaningful */
+static void report(const mem_region_t *r, const char *test, uint32_t bytes, uint32_t us, uint32_t ops)
+{
+    uint32_t mbps;
+
+    if (us == 0)
+        us = 1;
+    mbps = (uint32_t)((uint64_t)bytes * 100 / us);
+    rt_kprintf("%-6s %-5s %-14s %6d.%02d ", r->name, cur_cache, test, mbps / 100, mbps % 100);
+    if (ops)
+        rt_kprintf("%9d\n", (uint32_t)((uint64_t)us * 1000 / ops));
+    else
+        rt_kprintf("%9s\n", "-");
+    rt_kprintf("@mem,%s,%s,%s,%s,%d,%d,%d\n", MEM_BENCH_CORE, r->name, cur_cache, test, bytes, us, ops);
+}
+
+/* Cache on/off --------------------------------------------------------------------------------*/
+static uint32_t dcache_saved;
+
+static void cache_set(const mem_region_t *r, int on)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    if (on && dcache_saved)
+        SCB_EnableDCache();
+    else if (!on)
+        SCB_DisableDCache();
+#endif
+#ifdef BSP_USING_SPI_FLASH
+    if (r->flags & MEM_F_NOR)
+        rt_flash_set_cache(r->addr, on ? MEM_BENCH_NOR_CACHE_ON : FLASH_CACHE_DISABLE);
+#endif
+    cur_cache = on ? "on" : "off";
+}
+
+/* CPU access ----------------------------------------------------------------------------------*/
+static void rand_init(uint32_t size)
+{
+    uint32_t i;
+
+    srand(1);
+    for (i = 0; i < MEM_BENCH_RAND_NUM; i++)
+        rand_ofs[i] = ((uint32_t)rand() % (size / 4)) * 4;
+}
+
+static void cpu_seq_read(const mem_region_t *r)
+{
+    const volatile uint32_t *p;
+    uint32_t i, j, sum = 0, start, words = r->size / 4;
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        p = (const volatile uint32_t *)r->addr;
+        for (i = 0; i < words; i += 4)
+            sum += p[i] + p[i + 1] + p[i + 2] + p[i + 3];
+    }
+    report(r, "cpu_seq_rd", r->size * MEM_BENCH_LOOP, elapsed_us(start), 0);
+    sink = sum;
+}
+
+static void cpu_seq_write(const mem_region_t *r)
+{
+    volatile uint32_t *p;
+    uint32_t i, j, start, words = r->size / 4;
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        p = (volatile uint32_t *)r->addr;
+        for (i = 0; i < words; i += 4)
+        {
+            p[i] = i;
+            p[i + 1] = i;
+            p[i + 2] = i;
+            p[i + 3] = i;
+        }
+    }
+    report(r, "cpu_seq_wr", r->size * MEM_BENCH_LOOP, elapsed_us(start), 0);
+}
+
+/* Word access at random offsets, offsets are in SRAM so cost is mostly access latency */
+static void cpu_rand(const mem_region_t *r, int write)
+{
+    uint32_t i, j, sum = 0, start;
+
+    rand_init(r->size);
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        if (write)
+        {
+            for (i = 0; i < MEM_BENCH_RAND_NUM; i++)
+                *(volatile uint32_t *)(r->addr + rand_ofs[i]) = i;
+        }
+        else
+        {
+            for (i = 0; i < MEM_BENCH_RAND_NUM; i++)
+                sum += *(const volatile uint32_t *)(r->addr + rand_ofs[i]);
+        }
+    }
+    report(r, write ? "cpu_rand_wr" : "cpu_rand_rd", MEM_BENCH_RAND_NUM * MEM_BENCH_LOOP * 4, elapsed_us(start),
+           MEM_BENCH_RAND_NUM * MEM_BENCH_LOOP);
+    sink = sum;
+}
+
+static void cpu_copy(const mem_region_t *r, int to_region)
+{
+    uint32_t j, start;
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        if (to_region)
+            memcpy((void *)r->addr, sram_buf, r->size);
+        else
+            memcpy(sram_buf, (const void *)r->addr, r->size);
+    }
+    report(r, to_region ? "cpu_cpy_sram2" : "cpu_cpy_2sram", r->size * MEM_BENCH_LOOP, elapsed_us(start), 0);
+}
+
+/* DMA copy ------------------------------------------------------------------------------------*/
+static DMA_HandleTypeDef bench_dma;
+
+static void dma_copy(const mem_region_t *r, int to_region)
+{
+    uint32_t src = to_region ? (uint32_t)sram_buf : r->addr;
+    uint32_t dst = to_region ? r->addr : (uint32_t)sram_buf;
+    uint32_t j, start;
+
+    bench_dma.Instance = MEM_BENCH_DMA;
+    bench_dma.Init.Request = 0;
+    bench_dma.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    bench_dma.Init.PeriphInc = DMA_PINC_ENABLE;
+    bench_dma.Init.MemInc = DMA_MINC_ENABLE;
+    bench_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    bench_dma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    bench_dma.Init.Mode = DMA_NORMAL;
+    bench_dma.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_OK != HAL_DMA_Init(&bench_dma))
+    {
+        LOG_E("dma init fail");
+        return;
+    }
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        HAL_DMA_Start(&bench_dma, src, dst, r->size / 4);
+        if (HAL_OK != HAL_DMA_PollForTransfer(&bench_dma, HAL_DMA_FULL_TRANSFER, 1000))
+            break;
+    }
+    report(r, to_region ? "dma_cpy_sram2" : "dma_cpy_2sram", r->size * j, elapsed_us(start), 0);
+    HAL_DMA_DeInit(&bench_dma);
+}
+
+#if defined(HAL_EXT_DMA_MODULE_ENABLED) && defined(SOC_BF0_HCPU)
+static EXT_DMA_HandleTypeDef bench_ext_dma;
+
+static void ext_dma_copy(const mem_region_t *r, int to_region)
+{
+    uint32_t src = to_region ? (uint32_t)sram_buf : r->addr;
+    uint32_t dst = to_region ? r->addr : (uint32_t)sram_buf;
+    uint32_t j, start;
+
+    memset(&bench_ext_dma, 0, sizeof(bench_ext_dma));
+    bench_ext_dma.Init.SrcInc = HAL_EXT_DMA_SRC_INC | HAL_EXT_DMA_SRC_BURST16;
+    bench_ext_dma.Init.DstInc = HAL_EXT_DMA_DST_INC | HAL_EXT_DMA_DST_BURST16;
+    bench_ext_dma.Init.cmpr_en = false;
+    if (HAL_OK != HAL_EXT_DMA_Init(&bench_ext_dma))
+    {
+        LOG_E("ext_dma init fail");
+        return;
+    }
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+    {
+        HAL_EXT_DMA_Start(&bench_ext_dma, src, dst, r->size / 4);
+        if (HAL_OK != HAL_EXT_DMA_PollForTransfer(&bench_ext_dma, HAL_EXT_DMA_FULL_TRANSFER, 1000))
+            break;
+    }
+    report(r, to_region ? "edma_cpy_sram2" : "edma_cpy_2sram", r->size * j, elapsed_us(start), 0);
+}
+#endif /* HAL_EXT_DMA_MODULE_ENABLED && SOC_BF0_HCPU */
+
+/* NAND has no XIP, only measure driver read */
+#ifdef BSP_USING_SPI_NAND
+#define NAND_PAGE_SIZE      (2048)
+
+static void nand_read(const mem_region_t *r)
+{
+    uint32_t i, j, start;
+
+    start = HAL_GTIMER_READ();
+    for (j = 0; j < MEM_BENCH_LOOP; j++)
+        rt_nand_read(r->addr, sram_buf, r->size);
+    report(r, "nand_seq_rd", r->size * MEM_BENCH_LOOP, elapsed_us(start), 0);
+
+    srand(1);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < MEM_BENCH_LOOP * 4; i++)
+    {
+        j = (uint32_t)rand() % (r->size / NAND_PAGE_SIZE);
+        rt_nand_read(r->addr + j * NAND_PAGE_SIZE, sram_buf, NAND_PAGE_SIZE);
+    }
+    report(r, "nand_rand_page", NAND_PAGE_SIZE * MEM_BENCH_LOOP * 4, elapsed_us(start), MEM_BENCH_LOOP * 4);
+}
+#endif /* BSP_USING_SPI_NAND */
+
+static void bench_region(const mem_region_t *r)
+{
+    int on;
+
+    if (r->flags & MEM_F_NAND)
+    {
+#ifdef BSP_USING_SPI_NAND
+        cur_cache = "-";
+        nand_read(r);
+#endif
+        return;
+    }
+
+    for (on = 1; on >= 0; on--)
+    {
+        rt_enter_critical();
+        cache_set(r, on);
+        cpu_seq_read(r);
+        cpu_rand(r, 0);
+        if (0 == (r->flags & MEM_F_RO))
+        {
+            cpu_seq_write(r);
+            cpu_rand(r, 1);
+        }
+        if (r->addr != (uint32_t)sram_buf)
+        {
+            cpu_copy(r, 0);
+            if (0 == (r->flags & MEM_F_RO))
+                cpu_copy(r, 1);
+        }
+        rt_exit_critical();
+
+        /* DMA is not affected by CPU cache, only by NOR cache */
+        if (on || (r->flags & MEM_F_NOR))
+        {
+            dma_copy(r, 0);
+            if (0 == (r->flags & MEM_F_RO))
+                dma_copy(r, 1);
+#if defined(HAL_EXT_DMA_MODULE_ENABLED) && defined(SOC_BF0_HCPU)
+            ext_dma_copy(r, 0);
+            if (0 == (r->flags & MEM_F_RO))
+                ext_dma_copy(r, 1);
+#endif
+        }
+    }
+    cache_set(r, 1);
+}
+
+/* XIP latency during erase --------------------------------------------------------------------*/
+#ifdef BSP_USING_SPI_FLASH
+static volatile int erase_busy;
+
+static void erase_thread(void *param)
+{
+    uint32_t *arg = (uint32_t *)param;
+
+    rt_flash_erase(arg[0], arg[1]);
+    erase_busy = 0;
+}
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t stall;
+    uint32_t max_us;
+    uint64_t sum_us;
+} xip_stat_t;
+
+/* Read 64 random words of XIP range then sleep 1 tick to let erase thread run */
+static void xip_sample(xip_stat_t *st)
+{
+    uint32_t i, start, us, sum = 0;
+
+    for (i = 0; i < 64; i++)
+    {
+        start = HAL_GTIMER_READ();
+        sum += *(const volatile uint32_t *)(FLASH_BASE_ADDR + rand_ofs[(st->count + i) % MEM_BENCH_RAND_NUM]);
+        us = elapsed_us(start);
+        st->sum_us += us;
+        if (us > st->max_us)
+            st->max_us = us;
+        if (us > MEM_BENCH_STALL_US)
+            st->stall++;
+    }
+    st->count += 64;
+    sink = sum;
+    rt_thread_mdelay(1);
+}
+
+static void xip_report(const char *name, xip_stat_t *st, uint32_t ms)
+{
+    uint32_t avg_ns = st->count ? (uint32_t)(st->sum_us * 1000 / st->count) : 0;
+
+    rt_kprintf("%-8s: %d reads in %d ms, avg %d ns, max %d us, %d stalls > %d us\n", name, st->count, ms,
+               avg_ns, st->max_us, st->stall, MEM_BENCH_STALL_US);
+    rt_kprintf("@xip,%s,%s,%d,%d,%d,%d\n", MEM_BENCH_CORE, name, st->count, avg_ns, st->max_us, st->stall);
+}
+
+static int bench_erase(uint32_t addr, uint32_t size)
+{
+    static uint32_t arg[2];
+    xip_stat_t st;
+    rt_thread_t tid;
+    rt_tick_t tick;
+
+    if (addr >= FLASH_BASE_ADDR && addr < FLASH_BASE_ADDR + MEM_BENCH_XIP_SPAN)
+    {
+        LOG_E("erase address is in XIP range being read");
+        return -1;
+    }
+
+    rand_init(MEM_BENCH_XIP_SPAN);
+    memset(&st, 0, sizeof(st));
+    tick = rt_tick_get();
+    while (rt_tick_get() - tick < rt_tick_from_millisecond(100))
+        xip_sample(&st);
+    xip_report("idle", &st, 100);
+
+    arg[0] = addr;
+    arg[1] = size;
+    erase_busy = 1;
+    tid = rt_thread_create("mb_erase", erase_thread, arg, 1024, rt_thread_self()->current_priority + 1, 10);
+    if (RT_NULL == tid)
+        return -1;
+    memset(&st, 0, sizeof(st));
+    tick = rt_tick_get();
+    rt_thread_startup(tid);
+    while (erase_busy)
+        xip_sample(&st);
+    xip_report("erase", &st, (rt_tick_get() - tick) * 1000 / RT_TICK_PER_SECOND);
+
+    return 0;
+}
+#endif /* BSP_USING_SPI_FLASH */
+
+static void bench_info(void)
+{
+    rt_kprintf("@mem_cfg,%s,hclk=%d", MEM_BENCH_CORE, HAL_RCC_GetHCLKFreq(CORE_ID_DEFAULT));
+#ifdef BSP_USING_PSRAM
+    rt_kprintf(",psram_clk=%d", rt_psram_get_clk(PSRAM_BASE));
+#endif
+    rt_kprintf(",size=%d\n", MEM_BENCH_SIZE);
+}
+
+static int mem_bench(int argc, char **argv)
+{
+    mem_region_t r;
+
+    if (NULL == sram_buf)
+        sram_buf = rt_malloc_align(MEM_BENCH_SIZE, 32);
+    if (NULL == sram_buf)
+    {
+        LOG_E("no buffer");
+        return -1;
+    }
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    dcache_saved = SCB->CCR & SCB_CCR_DC_Msk;
+#endif
+
+#ifdef BSP_USING_SPI_FLASH
+    if (argc >= 3 && 0 == strcmp(argv[1], "erase"))
+        return bench_erase(strtoul(argv[2], NULL, 0), argc > 3 ? atoi(argv[3]) * 1024 : 4096);
+#endif
+
+    bench_info();
+    report_header();
+    if (argc >= 3 && 0 == strcmp(argv[1], "addr"))
+    {
+        /* any other region, e.g. PSRAM2 or other NOR */
+        r.name = "user";
+        r.addr = strtoul(argv[2], NULL, 0);
+        r.size = MEM_BENCH_SIZE;
+        r.flags = (argc > 3 && 0 == strcmp(argv[3], "ro")) ? (MEM_F_RO | MEM_F_NOR) : 0;
+        bench_region(&r);
+        return 0;
+    }
+#ifdef BSP_USING_SPI_NAND
+    if (argc >= 3 && 0 == strcmp(argv[1], "nand"))
+    {
+        r.name = "nand";
+        r.addr = strtoul(argv[2], NULL, 0);
+        r.size = MEM_BENCH_SIZE;
+        r.flags = MEM_F_NAND;
+        bench_region(&r);
+        return 0;
+    }
+#endif
+
+    r.name = "sram";
+    r.addr = (uint32_t)sram_buf;
+    r.size = MEM_BENCH_SIZE;
+    r.flags = 0;
+    bench_region(&r);
+#ifdef BSP_USING_PSRAM
+    r.name = "psram";
+    r.addr = (uint32_t)psram_buf;
+    bench_region(&r);
+#endif
+#ifdef BSP_USING_SPI_FLASH
+    r.name = "nor";
+    r.addr = FLASH_BASE_ADDR;
+    r.flags = MEM_F_RO | MEM_F_NOR;
+    bench_region(&r);
+#endif
+    rt_kprintf("@mem_end\n");
+
+    rt_kprintf("mem_bench addr <addr> [ro]\n");
+#ifdef BSP_USING_SPI_NAND
+    rt_kprintf("mem_bench nand <addr>\n");
+#endif
+#ifdef BSP_USING_SPI_FLASH
+    rt_kprintf("mem_bench erase <addr> [size_kb]\n");
+#endif
+    return 0;
+}
+MSH_CMD_EXPORT(mem_bench, memory bandwidth and latency benchmark);
+
+int main(void)
+{
+    rt_kprintf("Use mem_bench to start\n");
+
+    while (1)
+    {
+        rt_thread_mdelay(10000);    // Let system breath.
+    }
+    return 0;
+}
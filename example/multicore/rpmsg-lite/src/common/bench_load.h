@@ -0,0 +1,65 @@
+#ifndef _BENCH_LOAD_H_
+#define _BENCH_LOAD_H_
+#include <rtthread.h>
+#include "bf0_hal.h"
+#include "ipc_config.h"
+
+/*
+    CPU load of one benchmark run on either core, time out of idle thread
+    is counted by scheduler hook with DWT cycle counter, so a run should be
+    shorter than 2^32 cycles (~17s at 240MHz).
+*/
+#ifdef RT_USING_HOOK
+static uint32_t bench_load_start_cycle;
+static uint32_t bench_load_idle_enter;
+static uint32_t bench_load_idle;
+
+static void bench_load_hook(rt_thread_t from, rt_thread_t to)
+{
+    rt_thread_t idle = rt_thread_idle_gethandler();
+    uint32_t now = HAL_DBG_DWT_GetCycles();
+
+    if (to == idle)
+    {
+        bench_load_idle_enter = now;
+    }
+    else if (from == idle)
+    {
+        bench_load_idle += now - bench_load_idle_enter;
+    }
+}
+#endif /* RT_USING_HOOK */
+
+static void bench_load_start(void)
+{
+#ifdef RT_USING_HOOK
+    if (!HAL_DBG_DWT_IsInit())
+    {
+        HAL_DBG_DWT_Init();
+    }
+    bench_load_idle = 0;
+    bench_load_start_cycle = HAL_DBG_DWT_GetCycles();
+    rt_scheduler_sethook(bench_load_hook);
+#endif /* RT_USING_HOOK */
+}
+
+/* return load in 0.1% since bench_load_start, BENCH_LOAD_NA if not supported */
+static uint32_t bench_load_stop(void)
+{
+#ifdef RT_USING_HOOK
+    uint32_t total;
+
+    rt_scheduler_sethook(RT_NULL);
+    total = HAL_DBG_DWT_GetCycles() - bench_load_start_cycle;
+    if ((0 == total) || (bench_load_idle > total))
+    {
+        return 0;
+    }
+
+    return 1000 - (uint32_t)((uint64_t)bench_load_idle * 1000 / total);
+#else
+    return BENCH_LOAD_NA;
+#endif /* RT_USING_HOOK */
+}
+
+#endif /* _BENCH_LOAD_H_ */
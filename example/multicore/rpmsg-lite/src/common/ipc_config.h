@@ -13,13 +13,50 @@
 
 #define RPMSG_LITE_LINK_ID  (0)
 
+/* throughput and latency benchmark, see rpmsg_bench, rpmsg_lat and rpmsg_sweep commands */
+#define BENCH_MASTER_EPT_ADDR         (31U)
+#define BENCH_REMOTE_EPT_ADDR         (41U)
+#define BENCH_MAGIC                   (0x48434E42)
+
+/* Compare with ipc_queue, HCPU tx buffer is placed below mailbox buffer as example/multicore/ipc_queue,
+ * so the region must be left free by linker script of HCPU project */
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    #define BENCH_IPC_QUEUE           (2)
+    #define BENCH_IPC_BUF_SIZE        (2048)
+    #define BENCH_IPC_TX_BUF_ADDR     (HPSYS_MBOX_BUF_ADDR - BENCH_IPC_BUF_SIZE)
+    #define BENCH_IPC_RX_BUF_ADDR     (HCPU_ADDR_2_LCPU_ADDR(BENCH_IPC_TX_BUF_ADDR))
+    /* LCPU -> HCPU ring for echo of latency test, right below ring of HCPU */
+    #define BENCH_IPC_ECHO_BUF_ADDR   (BENCH_IPC_TX_BUF_ADDR - BENCH_IPC_BUF_SIZE)
+    #define BENCH_IPC_ECHO_BUF_ALIAS  (HCPU_ADDR_2_LCPU_ADDR(BENCH_IPC_ECHO_BUF_ADDR))
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+enum
+{
+    BENCH_CMD_START,            /* remote counts received bytes */
+    BENCH_CMD_DONE,
+    BENCH_CMD_ECHO,             /* remote sends every received byte back by same transport */
+};
+
+/* busy of BENCH_CMD_DONE if RT_USING_HOOK is not enabled on remote */
+#define BENCH_LOAD_NA                 (0xFFFFFFFF)
+
+enum
+{
+    BENCH_MODE_RPMSG_COPY,      /* rpmsg_lite_send, rpmsg_queue_recv */
+    BENCH_MODE_RPMSG_NOCOPY,    /* rpmsg_lite_send_nocopy with batched kick, rpmsg_queue_recv_nocopy */
+    BENCH_MODE_IPC_QUEUE,       /* ipc_queue_write, ipc_queue_read_peek */
+    BENCH_MODE_NUM,
+};
+
+/* control message on benchmark endpoint */
 typedef struct
 {
-    uint32_t src;
-    void *data;
-    uint32_t len;
-    void *priv;
-} rpmsg_rx_cb_data_t;
+    uint32_t magic;
+    uint32_t cmd;
+    uint32_t mode;
+    uint32_t total;             /* bytes to send, or bytes received in BENCH_CMD_DONE */
+    uint32_t busy;              /* CPU load of remote in 0.1% from start to BENCH_CMD_DONE */
+} bench_ctrl_t;
 
 #endif /* _IPC_CONFIG_H_ */
 
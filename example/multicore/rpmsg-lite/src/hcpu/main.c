@@ -52,21 +52,47 @@
 #include "log.h"
 
 #include "rpmsg_lite.h"
+#include "rpmsg_queue.h"
 #include "ipc_config.h"
 #include "bf0_mbox_common.h"
 
 
-static rt_mq_t test_rpmsg_mq;
+static rpmsg_queue_handle my_queue;
 static struct rpmsg_lite_endpoint *my_ept;
 static struct rpmsg_lite_instance *my_rpmsg;
 
-static int32_t rpmsg_rx_cb(void *payload, uint32_t payload_len, uint32_t src, void *priv);
+extern void rpmsg_bench_init(struct rpmsg_lite_instance *rpmsg);
 
 
+static int32_t send_str(uint32_t dst, const char *str)
+{
+    uint32_t size;
+    uint32_t len;
+    char *buf;
+
+    /* fill tx buffer in shared memory directly instead of copying from caller */
+    buf = rpmsg_lite_alloc_tx_buffer(my_rpmsg, &size, 1000);
+    if (!buf)
+    {
+        return RL_ERR_NO_MEM;
+    }
+    /* including null terminator */
+    len = strlen(str) + 1;
+    if (len > size)
+    {
+        len = size;
+    }
+    memcpy(buf, str, len - 1);
+    buf[len - 1] = '\0';
+
+    return rpmsg_lite_send_nocopy(my_rpmsg, my_ept, dst, buf, len);
+}
+
 int main(void)
 {
-    rt_err_t result;
-    rpmsg_rx_cb_data_t rx_data;
+    uint32_t src;
+    char *data;
+    uint32_t len;
     int32_t r;
     int32_t timeout;
     rt_base_t tick;
@@ -75,31 +101,30 @@ int main(void)
 
     rt_pm_request(PM_SLEEP_MODE_IDLE);
 
-    test_rpmsg_mq = rt_mq_create("test_rpmsg_mq", sizeof(rpmsg_rx_cb_data_t), 30, RT_IPC_FLAG_FIFO);
-    RT_ASSERT(test_rpmsg_mq);
-
     my_rpmsg = rpmsg_lite_master_init((void *)RPMSG_BUF_ADDR_MASTER, RPMSG_BUF_SIZE, RPMSG_LITE_LINK_ID, RL_NO_FLAGS);
     RT_ASSERT(my_rpmsg);
 
-    my_ept = rpmsg_lite_create_ept(my_rpmsg, MASTER_EPT_ADDR, rpmsg_rx_cb, (void *)2);
+    /* received buffers are handed to consumer directly, no copy */
+    my_queue = rpmsg_queue_create(my_rpmsg);
+    RT_ASSERT(my_queue);
+
+    my_ept = rpmsg_lite_create_ept(my_rpmsg, MASTER_EPT_ADDR, rpmsg_queue_rx_cb, my_queue);
     RT_ASSERT(my_ept);
 
+    rpmsg_bench_init(my_rpmsg);
+
     timeout = 5000;
     while (1)
     {
         tick = rt_tick_get();
-        result = rt_mq_recv(test_rpmsg_mq, &rx_data, sizeof(rx_data), timeout);
-        if ((RT_EOK == result) && (rx_data.len > 0))
+        r = rpmsg_queue_recv_nocopy(my_rpmsg, my_queue, &src, &data, &len, timeout);
+        if ((RL_SUCCESS == r) && (len > 0))
         {
-            uint8_t *buf;
-            buf = rt_malloc(rx_data.len);
-            RT_ASSERT(buf);
-            memcpy((void *)buf, (void *)rx_data.data, rx_data.len);
-            r = rpmsg_lite_release_rx_buffer(my_rpmsg, rx_data.data);
+            /* use payload in shared memory in place, then give it back */
+            rt_kprintf("from: %d\n", src);
+            rt_kprintf("rx: %s\n", data);
+            r = rpmsg_queue_nocopy_free(my_rpmsg, data);
             RT_ASSERT(RL_SUCCESS == r);
-            rt_kprintf("from: %d\n", rx_data.src);
-            rt_kprintf("rx: %s\n", buf);
-            rt_free(buf);
         }
         tick = rt_tick_get() - tick;
         if (tick < timeout)
@@ -109,7 +134,7 @@ int main(void)
         else
         {
             timeout = 5000;
-            r = rpmsg_lite_send(my_rpmsg, my_ept, REMOTE_EPT_ADDR, "hello_from_hcpu", strlen("hello_from_hcpu") + 1, 1000);
+            r = send_str(REMOTE_EPT_ADDR, "hello_from_hcpu");
             RT_ASSERT(RL_SUCCESS == r);
         }
     }
@@ -117,41 +142,17 @@ int main(void)
     return RT_EOK;
 }
 
-static int32_t rpmsg_rx_cb(void *payload, uint32_t payload_len, uint32_t src, void *priv)
-{
-    rpmsg_rx_cb_data_t msg;
-
-    RL_ASSERT(priv != RL_NULL);
-
-    msg.data = payload;
-    msg.len  = payload_len;
-    msg.src  = src;
-    msg.priv = priv;
-
-    /* if message is successfully added into queue then hold rpmsg buffer */
-    if (RT_EOK == rt_mq_send(test_rpmsg_mq, &msg, sizeof(msg)))
-    {
-        /* hold the rx buffer */
-        return RL_HOLD;
-    }
-
-    return RL_RELEASE;
-}
-
 
 static int send(int argc, char *argv[])
 {
     int32_t r;
-    size_t msg_size;
 
     if (argc < 2)
     {
         rt_kprintf("wrong argument\n");
         return -1;
     }
-    /* including null terminator */
-    msg_size = strlen(argv[1]) + 1;
-    r = rpmsg_lite_send(my_rpmsg, my_ept, REMOTE_EPT_ADDR, argv[1], msg_size, 1000);
+    r = send_str(REMOTE_EPT_ADDR, argv[1]);
     RT_ASSERT(RL_SUCCESS == r);
 
     rt_pm_release(PM_SLEEP_MODE_IDLE);
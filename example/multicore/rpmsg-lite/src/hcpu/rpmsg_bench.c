@@ -0,0 +1,585 @@
+/**
+  ******************************************************************************
+  * @file   rpmsg_bench.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2021 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <board.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "rpmsg_lite.h"
+#include "rpmsg_queue.h"
+#include "rpmsg_platform.h"
+#include "ipc_config.h"
+#include "bench_load.h"
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    #include "ipc_queue.h"
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+/* kick peer once per batch of nocopy send */
+#define BENCH_KICK_BATCH      (8)
+/* most samples kept for latency percentiles */
+#define BENCH_LAT_MAX_COUNT   (2000)
+
+static struct rpmsg_lite_instance *bench_rpmsg;
+static struct rpmsg_lite_endpoint *bench_ept;
+static rpmsg_queue_handle bench_queue;
+static uint32_t bench_kick_batch = BENCH_KICK_BATCH;
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    static ipc_queue_handle_t bench_ipc;
+    static struct rt_semaphore bench_ipc_sem;
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+static const char *const bench_mode_name[BENCH_MODE_NUM] =
+{
+    "rpmsg copy",
+    "rpmsg nocopy",
+    "ipc_queue",
+};
+
+#ifdef RPMSG_BENCH_IPC_QUEUE
+static int32_t bench_ipc_rx_ind(ipc_queue_handle_t handle, size_t size)
+{
+    /* echo of latency test */
+    rt_sem_release(&bench_ipc_sem);
+    return 0;
+}
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+void rpmsg_bench_init(struct rpmsg_lite_instance *rpmsg)
+{
+    bench_rpmsg = rpmsg;
+    bench_queue = rpmsg_queue_create(rpmsg);
+    RT_ASSERT(bench_queue);
+    bench_ept = rpmsg_lite_create_ept(rpmsg, BENCH_MASTER_EPT_ADDR, rpmsg_queue_rx_cb, bench_queue);
+    RT_ASSERT(bench_ept);
+
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    {
+        ipc_queue_cfg_t q_cfg;
+        int32_t r;
+
+        rt_sem_init(&bench_ipc_sem, "rpbench", 0, RT_IPC_FLAG_FIFO);
+
+        q_cfg.qid = BENCH_IPC_QUEUE;
+        q_cfg.tx_buf_size = BENCH_IPC_BUF_SIZE;
+        q_cfg.tx_buf_addr = BENCH_IPC_TX_BUF_ADDR;
+        q_cfg.tx_buf_addr_alias = BENCH_IPC_RX_BUF_ADDR;
+        q_cfg.rx_buf_addr = BENCH_IPC_ECHO_BUF_ADDR;
+        q_cfg.rx_ind = bench_ipc_rx_ind;
+        q_cfg.user_data = 0;
+
+        bench_ipc = ipc_queue_init(&q_cfg);
+        RT_ASSERT(IPC_QUEUE_INVALID_HANDLE != bench_ipc);
+        r = ipc_queue_open(bench_ipc);
+        RT_ASSERT(0 == r);
+    }
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+}
+
+static int32_t bench_send_ctrl(uint32_t cmd, uint32_t mode, uint32_t total)
+{
+    bench_ctrl_t ctrl;
+
+    ctrl.magic = BENCH_MAGIC;
+    ctrl.cmd = cmd;
+    ctrl.mode = mode;
+    ctrl.total = total;
+    ctrl.busy = 0;
+
+    return rpmsg_lite_send(bench_rpmsg, bench_ept, BENCH_REMOTE_EPT_ADDR, (char *)&ctrl, sizeof(ctrl), 1000);
+}
+
+static int32_t bench_send_copy(uint8_t *buf, uint32_t size, uint32_t count)
+{
+    int32_t r;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        r = rpmsg_lite_send(bench_rpmsg, bench_ept, BENCH_REMOTE_EPT_ADDR, (char *)buf, size, RL_BLOCK);
+        if (RL_SUCCESS != r)
+        {
+            return r;
+        }
+    }
+
+    return RL_SUCCESS;
+}
+
+static int32_t bench_send_nocopy(uint32_t size, uint32_t count)
+{
+    uint32_t batch = 0;
+    uint32_t cap;
+    int32_t r = RL_SUCCESS;
+    void *p;
+
+    platform_notify_batch_begin();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p = rpmsg_lite_alloc_tx_buffer(bench_rpmsg, &cap, RL_DONT_BLOCK);
+        if (!p)
+        {
+            /* peer frees buffers only after it is kicked */
+            platform_notify_batch_end();
+            p = rpmsg_lite_alloc_tx_buffer(bench_rpmsg, &cap, RL_BLOCK);
+            platform_notify_batch_begin();
+            batch = 0;
+        }
+        RT_ASSERT(p && (cap >= size));
+        /* producer writes into shared memory directly */
+        memset(p, 0x5A, size);
+        r = rpmsg_lite_send_nocopy(bench_rpmsg, bench_ept, BENCH_REMOTE_EPT_ADDR, p, size);
+        if (RL_SUCCESS != r)
+        {
+            break;
+        }
+        if (++batch == bench_kick_batch)
+        {
+            platform_notify_batch_end();
+            platform_notify_batch_begin();
+            batch = 0;
+        }
+    }
+    platform_notify_batch_end();
+
+    return r;
+}
+
+#ifdef RPMSG_BENCH_IPC_QUEUE
+static int32_t bench_send_ipc(uint8_t *buf, uint32_t size, uint32_t count)
+{
+    size_t len;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t sent = 0; sent < size; sent += len)
+        {
+            len = ipc_queue_write(bench_ipc, buf + sent, size - sent, 1000);
+            if (0 == len)
+            {
+                return RL_ERR_NO_BUFF;
+            }
+        }
+    }
+
+    return RL_SUCCESS;
+}
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+static int32_t bench_wait_done(uint32_t *received, uint32_t *busy)
+{
+    bench_ctrl_t *ctrl;
+    uint32_t len;
+    char *data;
+    int32_t r;
+
+    r = rpmsg_queue_recv_nocopy(bench_rpmsg, bench_queue, RL_NULL, &data, &len, 10000);
+    if (RL_SUCCESS != r)
+    {
+        return r;
+    }
+    ctrl = (bench_ctrl_t *)data;
+    if ((len == sizeof(*ctrl)) && (BENCH_MAGIC == ctrl->magic) && (BENCH_CMD_DONE == ctrl->cmd))
+    {
+        *received = ctrl->total;
+        *busy = ctrl->busy;
+    }
+    else
+    {
+        r = RL_ERR_PARAM;
+    }
+    rpmsg_queue_nocopy_free(bench_rpmsg, data);
+
+    return r;
+}
+
+static void bench_print_load(uint32_t busy)
+{
+    if (BENCH_LOAD_NA == busy)
+    {
+        rt_kprintf("   n/a");
+    }
+    else
+    {
+        rt_kprintf(" %3d.%d%%", busy / 10, busy % 10);
+    }
+}
+
+static const char *bench_name(uint32_t mode)
+{
+    static char name[20];
+
+    if ((BENCH_MODE_RPMSG_NOCOPY == mode) && (BENCH_KICK_BATCH != bench_kick_batch))
+    {
+        rt_snprintf(name, sizeof(name), "%s/%d", bench_mode_name[mode], bench_kick_batch);
+        return name;
+    }
+
+    return bench_mode_name[mode];
+}
+
+static uint8_t bench_mode_skip(uint32_t mode)
+{
+#ifndef RPMSG_BENCH_IPC_QUEUE
+    if (BENCH_MODE_IPC_QUEUE == mode)
+    {
+        rt_kprintf("%-16s skipped, RPMSG_BENCH_IPC_QUEUE not defined\n", bench_mode_name[mode]);
+        return 1;
+    }
+#endif /* !RPMSG_BENCH_IPC_QUEUE */
+
+    return 0;
+}
+
+static void bench_run(uint32_t mode, uint8_t *buf, uint32_t size, uint32_t count)
+{
+    uint32_t received = 0;
+    uint32_t remote_busy = BENCH_LOAD_NA;
+    uint32_t local_busy;
+    uint32_t start;
+    uint32_t us;
+    int32_t r;
+
+    if (bench_mode_skip(mode))
+    {
+        return;
+    }
+
+    bench_load_start();
+    start = HAL_GTIMER_READ();
+    r = bench_send_ctrl(BENCH_CMD_START, mode, size * count);
+    if (RL_SUCCESS == r)
+    {
+        switch (mode)
+        {
+        case BENCH_MODE_RPMSG_COPY:
+            r = bench_send_copy(buf, size, count);
+            break;
+        case BENCH_MODE_RPMSG_NOCOPY:
+            r = bench_send_nocopy(size, count);
+            break;
+#ifdef RPMSG_BENCH_IPC_QUEUE
+        case BENCH_MODE_IPC_QUEUE:
+            r = bench_send_ipc(buf, size, count);
+            break;
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+        default:
+            bench_load_stop();
+            return;
+        }
+    }
+    if (RL_SUCCESS == r)
+    {
+        r = bench_wait_done(&received, &remote_busy);
+    }
+    us = (uint32_t)((float)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+    local_busy = bench_load_stop();
+
+    if ((RL_SUCCESS != r) || (received != size * count))
+    {
+        rt_kprintf("%-16s failed %d, received %d\n", bench_name(mode), r, received);
+        return;
+    }
+    rt_kprintf("%-16s %7d bytes %7d us %6d KB/s %6d us/msg", bench_name(mode), received, us,
+               (uint32_t)((uint64_t)received * 1000000 / 1024 / (us ? us : 1)), us / count);
+    rt_kprintf(" cpu hcpu");
+    bench_print_load(local_busy);
+    rt_kprintf(" lcpu");
+    bench_print_load(remote_busy);
+    rt_kprintf("\n");
+}
+
+/* send one message and wait until all of it is echoed */
+static int32_t bench_ping(uint32_t mode, uint8_t *buf, uint32_t size)
+{
+    uint32_t len;
+    uint32_t cap;
+    char *data;
+    void *p;
+    int32_t r;
+
+    switch (mode)
+    {
+    case BENCH_MODE_RPMSG_COPY:
+        r = rpmsg_lite_send(bench_rpmsg, bench_ept, BENCH_REMOTE_EPT_ADDR, (char *)buf, size, RL_BLOCK);
+        if (RL_SUCCESS == r)
+        {
+            r = rpmsg_queue_recv(bench_rpmsg, bench_queue, RL_NULL, (char *)buf, size, &len, 1000);
+        }
+        break;
+    case BENCH_MODE_RPMSG_NOCOPY:
+        p = rpmsg_lite_alloc_tx_buffer(bench_rpmsg, &cap, RL_BLOCK);
+        RT_ASSERT(p && (cap >= size));
+        memset(p, 0x5A, size);
+        r = rpmsg_lite_send_nocopy(bench_rpmsg, bench_ept, BENCH_REMOTE_EPT_ADDR, p, size);
+        if (RL_SUCCESS == r)
+        {
+            r = rpmsg_queue_recv_nocopy(bench_rpmsg, bench_queue, RL_NULL, &data, &len, 1000);
+            if (RL_SUCCESS == r)
+            {
+                rpmsg_queue_nocopy_free(bench_rpmsg, data);
+            }
+        }
+        break;
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    case BENCH_MODE_IPC_QUEUE:
+        r = bench_send_ipc(buf, size, 1);
+        /* stream, echo may come back in pieces */
+        for (len = 0; (RL_SUCCESS == r) && (len < size);)
+        {
+            size_t rd = ipc_queue_read(bench_ipc, buf + len, size - len);
+
+            if (rd > 0)
+            {
+                len += rd;
+            }
+            else if (RT_EOK != rt_sem_take(&bench_ipc_sem, rt_tick_from_millisecond(1000)))
+            {
+                r = RL_ERR_NO_BUFF;
+            }
+        }
+        break;
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+    default:
+        return RL_ERR_PARAM;
+    }
+
+    if ((RL_SUCCESS == r) && (len != size))
+    {
+        r = RL_ERR_BUFF_SIZE;
+    }
+
+    return r;
+}
+
+static int bench_u32_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_lat(uint32_t mode, uint8_t *buf, uint32_t size, uint32_t count)
+{
+    uint32_t remote_busy = BENCH_LOAD_NA;
+    uint32_t local_busy;
+    uint32_t received = 0;
+    uint32_t *rtt;
+    uint32_t cycles;
+    uint32_t mhz;
+    uint32_t i;
+    int32_t r;
+
+    if (bench_mode_skip(mode))
+    {
+        return;
+    }
+    rtt = rt_malloc(count * sizeof(uint32_t));
+    RT_ASSERT(rtt);
+    if (!HAL_DBG_DWT_IsInit())
+    {
+        HAL_DBG_DWT_Init();
+    }
+    mhz = HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000;
+
+    bench_load_start();
+    r = bench_send_ctrl(BENCH_CMD_ECHO, mode, size * count);
+    for (i = 0; (RL_SUCCESS == r) && (i < count); i++)
+    {
+        memset(buf, 0x5A, size);
+        cycles = HAL_DBG_DWT_GetCycles();
+        r = bench_ping(mode, buf, size);
+        rtt[i] = HAL_DBG_DWT_GetCycles() - cycles;
+    }
+    if (RL_SUCCESS == r)
+    {
+        r = bench_wait_done(&received, &remote_busy);
+    }
+    local_busy = bench_load_stop();
+
+    if ((RL_SUCCESS != r) || (received != size * count))
+    {
+        rt_kprintf("%-16s failed %d at %d, received %d\n", bench_name(mode), r, i, received);
+        rt_free(rtt);
+        return;
+    }
+
+    qsort(rtt, count, sizeof(uint32_t), bench_u32_cmp);
+    rt_kprintf("%-16s rtt us min %5d p50 %5d p90 %5d p99 %5d max %5d, one-way ~%d", bench_name(mode),
+               rtt[0] / mhz, rtt[count / 2] / mhz, rtt[count * 9 / 10] / mhz, rtt[count * 99 / 100] / mhz,
+               rtt[count - 1] / mhz, rtt[count / 2] / mhz / 2);
+    rt_kprintf(" cpu hcpu");
+    bench_print_load(local_busy);
+    rt_kprintf(" lcpu");
+    bench_print_load(remote_busy);
+    rt_kprintf("\n");
+    rt_free(rtt);
+}
+
+static uint8_t *bench_args(int argc, char *argv[], uint32_t *size, uint32_t *count, uint32_t max_count)
+{
+    uint8_t *buf;
+
+    if (argc > 1)
+    {
+        *size = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        *count = strtoul(argv[2], NULL, 0);
+    }
+    if ((*size < sizeof(bench_ctrl_t)) || (*size > RL_BUFFER_PAYLOAD_SIZE) || (0 == *count) || (*count > max_count))
+    {
+        rt_kprintf("size should be in [%d, %d], count in [1, %d]\n", sizeof(bench_ctrl_t), RL_BUFFER_PAYLOAD_SIZE,
+                   max_count);
+        return NULL;
+    }
+
+    buf = rt_malloc(RL_BUFFER_PAYLOAD_SIZE);
+    RT_ASSERT(buf);
+    /* never looks like control message */
+    memset(buf, 0x5A, RL_BUFFER_PAYLOAD_SIZE);
+
+    return buf;
+}
+
+static int rpmsg_bench(int argc, char *argv[])
+{
+    uint32_t size = 256;
+    uint32_t count = 1000;
+    uint8_t *buf;
+
+    buf = bench_args(argc, argv, &size, &count, UINT32_MAX / RL_BUFFER_PAYLOAD_SIZE);
+    if (!buf)
+    {
+        return -1;
+    }
+
+    rt_kprintf("%d x %d bytes HCPU -> LCPU\n", count, size);
+    for (uint32_t mode = 0; mode < BENCH_MODE_NUM; mode++)
+    {
+        bench_run(mode, buf, size, count);
+    }
+    rt_free(buf);
+
+    return 0;
+}
+MSH_CMD_EXPORT(rpmsg_bench, rpmsg_bench [size] [count]: compare rpmsg-lite and ipc_queue throughput)
+
+static int rpmsg_lat(int argc, char *argv[])
+{
+    uint32_t size = 64;
+    uint32_t count = 500;
+    uint8_t *buf;
+
+    buf = bench_args(argc, argv, &size, &count, BENCH_LAT_MAX_COUNT);
+    if (!buf)
+    {
+        return -1;
+    }
+
+    rt_kprintf("%d x %d bytes HCPU -> LCPU -> HCPU\n", count, size);
+    for (uint32_t mode = 0; mode < BENCH_MODE_NUM; mode++)
+    {
+        bench_lat(mode, buf, size, count);
+    }
+    rt_free(buf);
+
+    return 0;
+}
+MSH_CMD_EXPORT(rpmsg_lat, rpmsg_lat [size] [count]: round trip latency percentiles of rpmsg-lite and ipc_queue)
+
+/* all transports over message sizes, nocopy also over kick batch */
+static int rpmsg_sweep(int argc, char *argv[])
+{
+    static const uint32_t kick_batch[] = {1, 4, BENCH_KICK_BATCH, 16};
+    uint32_t sizes[] = {16, 64, 256, RL_BUFFER_PAYLOAD_SIZE};
+    uint32_t count = 500;
+    uint8_t *buf;
+
+    if (argc > 1)
+    {
+        count = strtoul(argv[1], NULL, 0);
+    }
+    if ((0 == count) || (count > BENCH_LAT_MAX_COUNT))
+    {
+        rt_kprintf("count should be in [1, %d]\n", BENCH_LAT_MAX_COUNT);
+        return -1;
+    }
+    buf = rt_malloc(RL_BUFFER_PAYLOAD_SIZE);
+    RT_ASSERT(buf);
+    memset(buf, 0x5A, RL_BUFFER_PAYLOAD_SIZE);
+
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        rt_kprintf("--- %d x %d bytes\n", count, sizes[i]);
+        for (uint32_t mode = 0; mode < BENCH_MODE_NUM; mode++)
+        {
+            if (BENCH_MODE_RPMSG_NOCOPY == mode)
+            {
+                for (uint32_t k = 0; k < sizeof(kick_batch) / sizeof(kick_batch[0]); k++)
+                {
+                    bench_kick_batch = kick_batch[k];
+                    bench_run(mode, buf, sizes[i], count);
+                }
+                bench_kick_batch = BENCH_KICK_BATCH;
+            }
+            else
+            {
+                bench_run(mode, buf, sizes[i], count);
+            }
+        }
+        for (uint32_t mode = 0; mode < BENCH_MODE_NUM; mode++)
+        {
+            bench_lat(mode, buf, sizes[i], count);
+        }
+    }
+    rt_free(buf);
+
+    return 0;
+}
+MSH_CMD_EXPORT(rpmsg_sweep, rpmsg_sweep [count]: throughput and latency of all transports over message sizes)
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,238 @@
+/**
+  ******************************************************************************
+  * @file   rpmsg_bench.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2021 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <board.h>
+#include <string.h>
+
+#include "rpmsg_lite.h"
+#include "rpmsg_queue.h"
+#include "ipc_config.h"
+#include "bench_load.h"
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    #include "ipc_queue.h"
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+#define BENCH_THREAD_STACK_SIZE   (1024)
+#define BENCH_THREAD_PRIORITY     (RT_THREAD_PRIORITY_MIDDLE)
+
+static struct rpmsg_lite_instance *bench_rpmsg;
+static struct rpmsg_lite_endpoint *bench_ept;
+static rpmsg_queue_handle bench_queue;
+/* copy mode receives into local buffer as an usual consumer does */
+static char bench_buf[RL_BUFFER_PAYLOAD_SIZE];
+static uint32_t bench_mode;
+static uint32_t bench_expect;
+static uint32_t bench_received;
+static uint8_t bench_running;
+static uint8_t bench_echo;
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    static ipc_queue_handle_t bench_ipc;
+    static struct rt_semaphore bench_ipc_sem;
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+#ifdef RPMSG_BENCH_IPC_QUEUE
+static int32_t bench_ipc_rx_ind(ipc_queue_handle_t handle, size_t size)
+{
+    rt_sem_release(&bench_ipc_sem);
+    return 0;
+}
+
+static void bench_ipc_drain(void)
+{
+    const void *data;
+    size_t len;
+
+    /* consume in place from ring buffer of HCPU */
+    while ((len = ipc_queue_read_peek(bench_ipc, &data)) > 0)
+    {
+        if (bench_echo)
+        {
+            size_t sent, wr;
+
+            for (sent = 0; sent < len; sent += wr)
+            {
+                wr = ipc_queue_write(bench_ipc, (const uint8_t *)data + sent, len - sent, 1000);
+                if (0 == wr)
+                {
+                    break;
+                }
+            }
+        }
+        bench_received += len;
+        ipc_queue_read_release(bench_ipc, len);
+    }
+}
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+static void bench_echo_rpmsg(char *data, uint32_t len)
+{
+    uint32_t cap;
+    void *p;
+
+    if (BENCH_MODE_RPMSG_COPY == bench_mode)
+    {
+        rpmsg_lite_send(bench_rpmsg, bench_ept, BENCH_MASTER_EPT_ADDR, data, len, RL_BLOCK);
+        return;
+    }
+
+    /* rx buffer can't be sent back, copy once into tx buffer in shared memory */
+    p = rpmsg_lite_alloc_tx_buffer(bench_rpmsg, &cap, RL_BLOCK);
+    RT_ASSERT(p && (cap >= len));
+    memcpy(p, data, len);
+    rpmsg_lite_send_nocopy(bench_rpmsg, bench_ept, BENCH_MASTER_EPT_ADDR, p, len);
+}
+
+static void bench_rx(char *data, uint32_t len)
+{
+    bench_ctrl_t *ctrl = (bench_ctrl_t *)data;
+
+    if ((len == sizeof(*ctrl)) && (BENCH_MAGIC == ctrl->magic) &&
+            ((BENCH_CMD_START == ctrl->cmd) || (BENCH_CMD_ECHO == ctrl->cmd)))
+    {
+        bench_mode = ctrl->mode;
+        bench_expect = ctrl->total;
+        bench_received = 0;
+        bench_echo = (BENCH_CMD_ECHO == ctrl->cmd);
+        bench_running = 1;
+        bench_load_start();
+    }
+    else
+    {
+        if (bench_running && bench_echo)
+        {
+            bench_echo_rpmsg(data, len);
+        }
+        bench_received += len;
+    }
+}
+
+static void bench_entry(void *param)
+{
+    bench_ctrl_t ctrl;
+    uint32_t len;
+    char *data;
+    int32_t r;
+
+    while (1)
+    {
+#ifdef RPMSG_BENCH_IPC_QUEUE
+        if (bench_running && (BENCH_MODE_IPC_QUEUE == bench_mode))
+        {
+            rt_sem_take(&bench_ipc_sem, rt_tick_from_millisecond(10));
+            bench_ipc_drain();
+        }
+        else
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+            if (bench_running && (BENCH_MODE_RPMSG_COPY == bench_mode))
+            {
+                r = rpmsg_queue_recv(bench_rpmsg, bench_queue, RL_NULL, bench_buf, sizeof(bench_buf), &len, RL_BLOCK);
+                if (RL_SUCCESS == r)
+                {
+                    bench_rx(bench_buf, len);
+                }
+            }
+            else
+            {
+                r = rpmsg_queue_recv_nocopy(bench_rpmsg, bench_queue, RL_NULL, &data, &len, RL_BLOCK);
+                if (RL_SUCCESS == r)
+                {
+                    bench_rx(data, len);
+                    rpmsg_queue_nocopy_free(bench_rpmsg, data);
+                }
+            }
+
+        if (bench_running && (bench_received >= bench_expect))
+        {
+            bench_running = 0;
+            ctrl.magic = BENCH_MAGIC;
+            ctrl.cmd = BENCH_CMD_DONE;
+            ctrl.mode = bench_mode;
+            ctrl.total = bench_received;
+            ctrl.busy = bench_load_stop();
+            rpmsg_lite_send(bench_rpmsg, bench_ept, BENCH_MASTER_EPT_ADDR, (char *)&ctrl, sizeof(ctrl), 1000);
+        }
+    }
+}
+
+void rpmsg_bench_init(struct rpmsg_lite_instance *rpmsg)
+{
+    rt_thread_t tid;
+
+    bench_rpmsg = rpmsg;
+    bench_queue = rpmsg_queue_create(rpmsg);
+    RT_ASSERT(bench_queue);
+    bench_ept = rpmsg_lite_create_ept(rpmsg, BENCH_REMOTE_EPT_ADDR, rpmsg_queue_rx_cb, bench_queue);
+    RT_ASSERT(bench_ept);
+
+#ifdef RPMSG_BENCH_IPC_QUEUE
+    {
+        ipc_queue_cfg_t q_cfg;
+        int32_t r;
+
+        rt_sem_init(&bench_ipc_sem, "rpbench", 0, RT_IPC_FLAG_FIFO);
+
+        /* echo ring is in HCPU RAM too */
+        q_cfg.qid = BENCH_IPC_QUEUE;
+        q_cfg.tx_buf_size = BENCH_IPC_BUF_SIZE;
+        q_cfg.tx_buf_addr = BENCH_IPC_ECHO_BUF_ALIAS;
+        q_cfg.tx_buf_addr_alias = BENCH_IPC_ECHO_BUF_ADDR;
+        q_cfg.rx_buf_addr = BENCH_IPC_RX_BUF_ADDR;
+        q_cfg.rx_ind = bench_ipc_rx_ind;
+        q_cfg.user_data = 0;
+
+        bench_ipc = ipc_queue_init(&q_cfg);
+        RT_ASSERT(IPC_QUEUE_INVALID_HANDLE != bench_ipc);
+        r = ipc_queue_open(bench_ipc);
+        RT_ASSERT(0 == r);
+    }
+#endif /* RPMSG_BENCH_IPC_QUEUE */
+
+    tid = rt_thread_create("rpbench", bench_entry, NULL, BENCH_THREAD_STACK_SIZE, BENCH_THREAD_PRIORITY, 10);
+    RT_ASSERT(tid);
+    rt_thread_startup(tid);
+}
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
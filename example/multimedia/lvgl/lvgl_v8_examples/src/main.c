@@ -31,7 +31,7 @@ int main(void)
     while (1)
     {
         ms = lv_task_handler();
-        rt_thread_mdelay(ms);
+        littlevgl2rtt_sleep(ms);
     }
     return RT_EOK;
 
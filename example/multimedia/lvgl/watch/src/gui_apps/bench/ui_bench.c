@@ -0,0 +1,555 @@
+/**
+ * @file ui_bench.c
+ *
+ * Scripted UI benchmark. Touch gestures are replayed by a virtual pointer device,
+ * frame time, dropped frames, CPU load and PSRAM usage are collected per scenario
+ * and printed as JSON, so builds can be compared by a host script on UART.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include "littlevgl2rtt.h"
+#include "lvgl.h"
+#include "gui_app_fwk.h"
+#include "app_mem.h"
+#include "cpu_usage_profiler.h"
+#include "ui_bench.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define UI_BENCH_TIMER_PERIOD   (5)
+#define UI_BENCH_REC_STEP_MAX   (32)
+/*Frame interval over it is idle, not dropped frames*/
+#define UI_BENCH_IDLE_GAP_MS    (250)
+#define UI_BENCH_HIST_NUM       (64)
+#define UI_BENCH_EVAL_MAX       (8)
+
+/*Coordinates are in permille of screen size*/
+#define PX(v)   ((lv_coord_t)((int32_t)(v) * LV_HOR_RES / 1000))
+#define PY(v)   ((lv_coord_t)((int32_t)(v) * LV_VER_RES / 1000))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+{
+    UI_BENCH_STEP_WAIT,
+    UI_BENCH_STEP_SWIPE,        /**< Press at (x0,y0), move to (x1,y1) in ms and release, tap if same point */
+    UI_BENCH_STEP_APP,          /**< Run app by id */
+    UI_BENCH_STEP_END,
+} ui_bench_step_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint16_t ms;
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+    const char *app;
+} ui_bench_step_t;
+
+typedef struct
+{
+    const char *name;
+    const ui_bench_step_t *steps;
+} ui_bench_scenario_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t dropped;
+    uint32_t sum_ms;
+    uint32_t max_ms;
+    uint16_t hist[UI_BENCH_HIST_NUM];
+    uint32_t last_frame_tick;
+    uint32_t start_tick;
+    uint32_t busy_us;
+    uint32_t lvgl_load_sum;
+    uint32_t samples;
+    uint32_t psram_peak;
+} ui_bench_result_t;
+
+typedef enum
+{
+    UI_BENCH_IDLE,
+    UI_BENCH_RUN,
+    UI_BENCH_REC,
+} ui_bench_state_t;
+
+typedef struct
+{
+    lv_timer_t *timer;
+    lv_indev_drv_t indev_drv;
+    lv_indev_t *indev;
+    lv_disp_drv_t *disp_drv;
+    void (*orig_monitor_cb)(struct _lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
+
+    volatile uint8_t req;               /**< State requested by shell */
+    uint8_t state;
+    uint8_t pressed;
+    uint8_t released;                   /**< Release has been read by LVGL */
+    lv_point_t point;
+
+    /*Scenario list to run*/
+    const ui_bench_scenario_t *eval[UI_BENCH_EVAL_MAX];
+    uint8_t eval_num;
+    uint8_t eval_idx;
+    uint16_t loops;
+    uint16_t loop;
+    const ui_bench_step_t *step;
+    uint32_t step_tick;
+    ui_bench_result_t result;
+
+    /*Recorder*/
+    ui_bench_step_t rec[UI_BENCH_REC_STEP_MAX + 1];
+    uint8_t rec_num;
+    uint8_t rec_pressed;
+    uint32_t rec_tick;
+} ui_bench_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const ui_bench_step_t launch_steps[] =
+{
+    {UI_BENCH_STEP_APP,   0,    0,   0,   0,   0, "Main"},
+    {UI_BENCH_STEP_WAIT,  800,  0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 80,   500, 500, 500, 500, NULL},
+    {UI_BENCH_STEP_WAIT,  1500, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_APP,   0,    0,   0,   0,   0, "Main"},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_END},
+};
+
+static const ui_bench_step_t list_steps[] =
+{
+    {UI_BENCH_STEP_APP,   0,    0,   0,   0,   0, "Main"},
+    {UI_BENCH_STEP_WAIT,  800,  0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 300,  500, 800, 500, 200, NULL},
+    {UI_BENCH_STEP_WAIT,  800,  0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 150,  500, 800, 500, 300, NULL},
+    {UI_BENCH_STEP_WAIT,  1200, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 300,  500, 200, 500, 800, NULL},
+    {UI_BENCH_STEP_WAIT,  800,  0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 150,  500, 300, 500, 800, NULL},
+    {UI_BENCH_STEP_WAIT,  1200, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_END},
+};
+
+static const ui_bench_step_t watchface_steps[] =
+{
+    {UI_BENCH_STEP_APP,   0,    0,   0,   0,   0, "clock"},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 250,  850, 500, 150, 500, NULL},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 250,  850, 500, 150, 500, NULL},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 250,  150, 500, 850, 500, NULL},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_SWIPE, 250,  150, 500, 850, 500, NULL},
+    {UI_BENCH_STEP_WAIT,  1000, 0,   0,   0,   0, NULL},
+    {UI_BENCH_STEP_APP,   0,    0,   0,   0,   0, "Main"},
+    {UI_BENCH_STEP_END},
+};
+
+static ui_bench_t bench;
+
+static const ui_bench_scenario_t scenarios[] =
+{
+    {"launch",    launch_steps},
+    {"list",      list_steps},
+    {"watchface", watchface_steps},
+    {"rec",       bench.rec},
+};
+
+#define SCENARIO_NUM    (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+static void ui_bench_input_read(struct _lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
+{
+    const ui_bench_step_t *step = bench.step;
+
+    if (bench.pressed && step && (UI_BENCH_STEP_SWIPE == step->type))
+    {
+        uint32_t t = LV_MIN(lv_tick_elaps(bench.step_tick), step->ms);
+        int32_t x0 = PX(step->x0), y0 = PY(step->y0);
+
+        bench.point.x = (lv_coord_t)(x0 + (PX(step->x1) - x0) * (int32_t)t / LV_MAX(step->ms, 1));
+        bench.point.y = (lv_coord_t)(y0 + (PY(step->y1) - y0) * (int32_t)t / LV_MAX(step->ms, 1));
+    }
+    data->point = bench.point;
+    data->state = bench.pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    if (!bench.pressed)
+        bench.released = 1;
+}
+
+static void ui_bench_monitor(struct _lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+    ui_bench_result_t *r = &bench.result;
+    uint32_t period, gap;
+
+    if (bench.orig_monitor_cb)
+        bench.orig_monitor_cb(disp_drv, time, px);
+
+    if ((UI_BENCH_RUN != bench.state) || (0 == px))
+        return;
+
+    r->frames++;
+    r->sum_ms += time;
+    r->max_ms = LV_MAX(r->max_ms, time);
+    r->hist[LV_MIN(time, UI_BENCH_HIST_NUM - 1)]++;
+
+    /*Interval over 1.5 period counts the periods missed*/
+    period = LV_MAX(lv_disp_get_default()->refr_timer->period, 1);
+    if (r->last_frame_tick)
+    {
+        gap = lv_tick_elaps(r->last_frame_tick);
+        if ((gap < UI_BENCH_IDLE_GAP_MS) && (gap * 2 > period * 3))
+            r->dropped += (gap + period / 2) / period - 1;
+    }
+    r->last_frame_tick = lv_tick_get();
+}
+
+static uint32_t ui_bench_percentile(const ui_bench_result_t *r, uint32_t pct)
+{
+    uint32_t target = (r->frames * pct + 99) / 100;
+    uint32_t cnt = 0;
+
+    for (uint32_t i = 0; i < UI_BENCH_HIST_NUM; i++)
+    {
+        cnt += r->hist[i];
+        if (cnt >= target)
+            return i;
+    }
+    return UI_BENCH_HIST_NUM - 1;
+}
+
+static void ui_bench_sample(void)
+{
+    uint32_t pool, used, max_used;
+
+    app_mem_get_psram_info(&pool, &used, &max_used);
+    bench.result.psram_peak = LV_MAX(bench.result.psram_peak, used);
+    bench.result.lvgl_load_sum += 100 - lv_timer_get_idle();
+    bench.result.samples++;
+}
+
+static void ui_bench_scenario_begin(void)
+{
+    memset(&bench.result, 0, sizeof(bench.result));
+    bench.result.start_tick = lv_tick_get();
+#ifdef USING_CPU_USAGE_PROFILER
+    bench.result.busy_us = cpu_get_busy_us();
+#endif
+    bench.step = bench.eval[bench.eval_idx]->steps;
+    bench.step_tick = lv_tick_get();
+    bench.pressed = 0;
+}
+
+static void ui_bench_scenario_end(void)
+{
+    const ui_bench_result_t *r = &bench.result;
+    uint32_t ms = LV_MAX(lv_tick_elaps(r->start_tick), 1);
+    uint32_t cpu = 0;
+    uint32_t pool, used, max_used;
+
+#ifdef USING_CPU_USAGE_PROFILER
+    cpu = (cpu_get_busy_us() - r->busy_us) / (ms * 10);
+#endif
+    app_mem_get_psram_info(&pool, &used, &max_used);
+
+    /*Console buffer is small, print in pieces*/
+    rt_kprintf("%s{\"name\":\"%s\",\"loop\":%d,\"ms\":%d,\"frames\":%d,", (0 == bench.eval_idx) ? "" : ",",
+               bench.eval[bench.eval_idx]->name, bench.loop, ms, r->frames);
+    rt_kprintf("\"avg_ms\":%d,\"p90_ms\":%d,\"p99_ms\":%d,\"max_ms\":%d,\"dropped\":%d,",
+               r->frames ? r->sum_ms / r->frames : 0, ui_bench_percentile(r, 90), ui_bench_percentile(r, 99),
+               r->max_ms, r->dropped);
+    rt_kprintf("\"cpu\":%d,\"lvgl\":%d,\"psram_peak\":%d,\"psram_end\":%d,\"psram_pool\":%d}",
+               cpu, r->samples ? r->lvgl_load_sum / r->samples : 0, r->psram_peak, used, pool);
+}
+
+/* Return true if the step is done */
+static bool ui_bench_step_run(const ui_bench_step_t *step)
+{
+    uint32_t elaps = lv_tick_elaps(bench.step_tick);
+
+    switch (step->type)
+    {
+    case UI_BENCH_STEP_WAIT:
+        return elaps >= step->ms;
+
+    case UI_BENCH_STEP_SWIPE:
+        if (!bench.pressed)
+        {
+            /*Press after release of last step is read by LVGL*/
+            if (bench.released)
+            {
+                bench.point.x = PX(step->x0);
+                bench.point.y = PY(step->y0);
+                bench.pressed = 1;
+                bench.released = 0;
+                bench.step_tick = lv_tick_get();
+            }
+            return false;
+        }
+        if (elaps < step->ms)
+            return false;
+        bench.point.x = PX(step->x1);
+        bench.point.y = PY(step->y1);
+        bench.pressed = 0;
+        bench.released = 0;
+        return true;
+
+    case UI_BENCH_STEP_APP:
+        gui_app_run(step->app);
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+static void ui_bench_rec_poll(void)
+{
+    lv_indev_t *indev;
+    lv_point_t p;
+    ui_bench_step_t *step;
+    bool pressed = false;
+
+    for (indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev))
+    {
+        if ((indev != bench.indev) && (LV_INDEV_TYPE_POINTER == indev->driver->type))
+        {
+            pressed = (LV_INDEV_STATE_PR == indev->proc.state);
+            lv_indev_get_point(indev, &p);
+            break;
+        }
+    }
+    if (!indev || (pressed == bench.rec_pressed) || (bench.rec_num + 2 > UI_BENCH_REC_STEP_MAX))
+        return;
+
+    if (pressed)
+    {
+        step = &bench.rec[bench.rec_num++];
+        step->type = UI_BENCH_STEP_WAIT;
+        step->ms = (uint16_t)LV_MIN(lv_tick_elaps(bench.rec_tick), UINT16_MAX);
+
+        step = &bench.rec[bench.rec_num];
+        step->type = UI_BENCH_STEP_SWIPE;
+        step->x0 = (int16_t)(p.x * 1000 / LV_HOR_RES);
+        step->y0 = (int16_t)(p.y * 1000 / LV_VER_RES);
+    }
+    else
+    {
+        step = &bench.rec[bench.rec_num++];
+        step->ms = (uint16_t)LV_MIN(lv_tick_elaps(bench.rec_tick), UINT16_MAX);
+        step->x1 = (int16_t)(p.x * 1000 / LV_HOR_RES);
+        step->y1 = (int16_t)(p.y * 1000 / LV_VER_RES);
+    }
+    bench.rec[bench.rec_num].type = UI_BENCH_STEP_END;
+    bench.rec_pressed = pressed;
+    bench.rec_tick = lv_tick_get();
+}
+
+static void ui_bench_timer_cb(lv_timer_t *timer)
+{
+    if (bench.req != bench.state)
+    {
+        /*Stop anything first*/
+        if (UI_BENCH_RUN == bench.state)
+        {
+            bench.pressed = 0;
+            rt_kprintf("]}\nUI_BENCH aborted\n");
+        }
+        bench.state = bench.req;
+        if (UI_BENCH_RUN == bench.state)
+        {
+            bench.eval_idx = 0;
+            bench.loop = 0;
+            bench.released = 1;
+            rt_kprintf("UI_BENCH {\"build\":\"%s %s\",\"hor_res\":%d,\"ver_res\":%d,\"results\":[",
+                       __DATE__, __TIME__, LV_HOR_RES, LV_VER_RES);
+            ui_bench_scenario_begin();
+        }
+        else if (UI_BENCH_REC == bench.state)
+        {
+            bench.rec_num = 0;
+            bench.rec_pressed = 0;
+            bench.rec[0].type = UI_BENCH_STEP_END;
+            bench.rec_tick = lv_tick_get();
+        }
+    }
+
+    if (UI_BENCH_REC == bench.state)
+    {
+        ui_bench_rec_poll();
+        return;
+    }
+    if (UI_BENCH_RUN != bench.state)
+    {
+        lv_timer_pause(timer);
+        return;
+    }
+
+    ui_bench_sample();
+    /*Keep display awake*/
+    lv_disp_trig_activity(NULL);
+
+    while (UI_BENCH_STEP_END != bench.step->type)
+    {
+        if (!ui_bench_step_run(bench.step))
+            return;
+        bench.step++;
+        bench.step_tick = lv_tick_get();
+    }
+
+    ui_bench_scenario_end();
+    if (++bench.eval_idx >= bench.eval_num)
+    {
+        bench.eval_idx = 0;
+        if (++bench.loop >= bench.loops)
+        {
+            rt_kprintf("]}\n");
+            bench.req = UI_BENCH_IDLE;
+            bench.state = UI_BENCH_IDLE;
+            return;
+        }
+        rt_kprintf(",");
+    }
+    ui_bench_scenario_begin();
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+void ui_bench_init(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+
+    if (bench.timer || !disp)
+        return;
+
+    bench.disp_drv = disp->driver;
+    bench.orig_monitor_cb = disp->driver->monitor_cb;
+    disp->driver->monitor_cb = ui_bench_monitor;
+
+    lv_indev_drv_init(&bench.indev_drv);
+    bench.indev_drv.type = LV_INDEV_TYPE_POINTER;
+    bench.indev_drv.read_cb = ui_bench_input_read;
+    bench.indev = lv_indev_drv_register(&bench.indev_drv);
+
+    bench.rec[0].type = UI_BENCH_STEP_END;
+    bench.timer = lv_timer_create(ui_bench_timer_cb, UI_BENCH_TIMER_PERIOD, NULL);
+    lv_timer_pause(bench.timer);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static const ui_bench_scenario_t *ui_bench_find(const char *name)
+{
+    for (uint32_t i = 0; i < SCENARIO_NUM; i++)
+    {
+        if (0 == strcmp(scenarios[i].name, name))
+            return &scenarios[i];
+    }
+    return NULL;
+}
+
+static void ui_bench_start(uint8_t state)
+{
+    bench.req = state;
+    lv_timer_resume(bench.timer);
+    lv_timer_ready(bench.timer);
+    littlevgl2rtt_wakeup();
+}
+
+static rt_err_t ui_bench(int argc, char **argv)
+{
+    if (!bench.timer)
+    {
+        rt_kprintf("ui_bench not initialized\n");
+        return -RT_ERROR;
+    }
+
+    if ((argc >= 2) && (0 == strcmp(argv[1], "run")))
+    {
+        const char *name = (argc > 2) ? argv[2] : "all";
+
+        if (UI_BENCH_IDLE != bench.state)
+        {
+            rt_kprintf("busy\n");
+            return -RT_EBUSY;
+        }
+
+        bench.eval_num = 0;
+        if (0 == strcmp(name, "all"))
+        {
+            /*Recorded one is not in all*/
+            for (uint32_t i = 0; i < SCENARIO_NUM - 1; i++)
+                bench.eval[bench.eval_num++] = &scenarios[i];
+        }
+        else
+        {
+            const char *next;
+
+            /*Comma separated list*/
+            do
+            {
+                next = strchr(name, ',');
+                for (uint32_t i = 0; i < SCENARIO_NUM; i++)
+                {
+                    size_t len = next ? (size_t)(next - name) : strlen(name);
+                    if ((strlen(scenarios[i].name) == len) && (0 == strncmp(scenarios[i].name, name, len))
+                            && (bench.eval_num < UI_BENCH_EVAL_MAX))
+                        bench.eval[bench.eval_num++] = &scenarios[i];
+                }
+                name = next ? next + 1 : NULL;
+            }
+            while (name);
+        }
+        if (0 == bench.eval_num)
+        {
+            rt_kprintf("Unknown scenario\n");
+            return -RT_EINVAL;
+        }
+        bench.loops = (argc > 3) ? (uint16_t)LV_MAX(atoi(argv[3]), 1) : 1;
+        ui_bench_start(UI_BENCH_RUN);
+    }
+    else if ((argc >= 2) && (0 == strcmp(argv[1], "rec")))
+    {
+        if ((argc > 2) && (0 == strcmp(argv[2], "stop")))
+        {
+            bench.req = UI_BENCH_IDLE;
+            rt_kprintf("%d steps recorded\n", bench.rec_num);
+        }
+        else
+        {
+            rt_kprintf("Recording touch, \"ui_bench rec stop\" to finish, \"ui_bench run rec\" to replay\n");
+            ui_bench_start(UI_BENCH_REC);
+        }
+    }
+    else if ((argc >= 2) && (0 == strcmp(argv[1], "stop")))
+    {
+        bench.req = UI_BENCH_IDLE;
+    }
+    else
+    {
+        rt_kprintf("ui_bench run [all|<name>[,<name>...]] [loops] | rec [stop] | stop\n");
+        for (uint32_t i = 0; i < SCENARIO_NUM; i++)
+            rt_kprintf("  %s\n", scenarios[i].name);
+    }
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(ui_bench, UI frame time benchmark);
+#endif /* RT_USING_FINSH */
@@ -0,0 +1,24 @@
+/**
+ * @file ui_bench.h
+ *
+ */
+
+#ifndef UI_BENCH_H
+#define UI_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+@brief Install UI benchmark, must be called in GUI thread after LVGL is initialized.
+       Scenarios are started by "ui_bench run", result is printed as one JSON line
+       starting with "UI_BENCH ".
+*/
+void ui_bench_init(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*UI_BENCH_H*/
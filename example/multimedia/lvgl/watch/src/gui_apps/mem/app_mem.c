@@ -148,8 +148,29 @@ MSH_CMD_EXPORT_ALIAS(app_mem_log, app_mem, app_mem: open or close app_mem log);
 
 
 
+/**
+    Image PSRAM pool is shared by LVGL, media and audio with mixed size long living
+    blocks. Define APP_MEM_PSRAM_USING_TLSF to manage it with TLSF heap, which has
+    constant alloc/free time and fragments less than first fit memheap.
+    "list_tlsfheap" dumps its free block histogram.
+*/
+//#define APP_MEM_PSRAM_USING_TLSF
+#if defined(APP_MEM_PSRAM_USING_TLSF) && !defined(RT_USING_TLSFHEAP)
+    #undef APP_MEM_PSRAM_USING_TLSF
+#endif
+
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
+#ifdef APP_MEM_PSRAM_USING_TLSF
+    struct rt_tlsfheap app_image_psram_memheap;
+    #define psram_heap_init(name, addr, size)   rt_tlsfheap_init(&app_image_psram_memheap, name, addr, size)
+    #define psram_heap_alloc(size)              rt_tlsfheap_alloc(&app_image_psram_memheap, size)
+    #define psram_heap_realloc(p, size)         rt_tlsfheap_realloc(&app_image_psram_memheap, p, size)
+#else
     struct rt_memheap app_image_psram_memheap;
+    #define psram_heap_init(name, addr, size)   rt_memheap_init(&app_image_psram_memheap, name, addr, size)
+    #define psram_heap_alloc(size)              rt_memheap_alloc(&app_image_psram_memheap, size)
+    #define psram_heap_realloc(p, size)         rt_memheap_realloc(&app_image_psram_memheap, p, size)
+#endif
 #endif
 
 #if IMAGE_CACHE_IN_SRAM_SIZE > 0
@@ -172,12 +193,24 @@ MSH_CMD_EXPORT_ALIAS(app_mem_log, app_mem, app_mem: open or close app_mem log);
  *   GLOBAL FUNCTIONS
  **********************/
 
+static void app_heap_free(uint8_t *p)
+{
+#if IMAGE_CACHE_IN_PSRAM_SIZE > 0 && defined(APP_MEM_PSRAM_USING_TLSF)
+    if (p >= app_image_psram_cache && p < app_image_psram_cache + IMAGE_CACHE_IN_PSRAM_SIZE)
+    {
+        rt_tlsfheap_free(p);
+        return;
+    }
+#endif
+    rt_memheap_free(p);
+}
+
 
 static int app_cahe_memheap_init(void)
 {
 
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
-    rt_memheap_init(&app_image_psram_memheap, "app_image_psram_memheap", (void *)app_image_psram_cache, IMAGE_CACHE_IN_PSRAM_SIZE);
+    psram_heap_init("app_image_psram_memheap", (void *)app_image_psram_cache, IMAGE_CACHE_IN_PSRAM_SIZE);
 #endif
 
 #if IMAGE_CACHE_IN_SRAM_SIZE > 0
@@ -238,7 +271,7 @@ void *app_cache_alloc(size_t size, image_cache_t cache_type)
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
     if (!p)
     {
-        p = (uint8_t *)rt_memheap_alloc(&app_image_psram_memheap, size);
+        p = (uint8_t *)psram_heap_alloc(size);
         if (p)((uint32_t *) p)[0] = PSRAM_HEAP;
     }
 #endif
@@ -270,7 +303,7 @@ void app_cache_free(void *p)
     temp_p -= 4;
     if (PSRAM_HEAP == ((uint32_t *) temp_p)[0] || SRAM_HEAP == ((uint32_t *) temp_p)[0])
     {
-        rt_memheap_free(temp_p);
+        app_heap_free(temp_p);
     }
     else
     {
@@ -322,7 +355,7 @@ void app_message_free(void *p)
     temp_p -= 4;
     if (PSRAM_HEAP == ((uint32_t *) temp_p)[0] || SRAM_HEAP == ((uint32_t *) temp_p)[0])
     {
-        rt_memheap_free(temp_p);
+        app_heap_free(temp_p);
     }
     else
     {
@@ -482,7 +515,7 @@ void *app_anim_mem_alloc(rt_size_t size, bool anim_data)
         if (!p)
         {
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
-            p  = (uint8_t *)rt_memheap_alloc(&app_image_psram_memheap, size);
+            p  = (uint8_t *)psram_heap_alloc(size);
             if (p)((uint32_t *) p)[0] = PSRAM_HEAP;
 #endif
         }
@@ -504,7 +537,7 @@ void *app_anim_mem_alloc(rt_size_t size, bool anim_data)
         if (!p)
         {
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
-            p  = (uint8_t *)rt_memheap_alloc(&app_image_psram_memheap, size);
+            p  = (uint8_t *)psram_heap_alloc(size);
             if (p)((uint32_t *) p)[0] = PSRAM_HEAP;
 #endif
         }
@@ -540,7 +573,7 @@ void *app_anim_mem_realloc(void *p, size_t new_size)
         else
         {
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
-            ret = (uint8_t *)rt_memheap_alloc(&app_image_psram_memheap, new_size);
+            ret = (uint8_t *)psram_heap_alloc(new_size);
             if (ret)
             {
                 ((uint32_t *)ret)[0] = PSRAM_HEAP;
@@ -559,7 +592,7 @@ void *app_anim_mem_realloc(void *p, size_t new_size)
 #if IMAGE_CACHE_IN_PSRAM_SIZE > 0
         if (PSRAM_HEAP == ((uint32_t *) temp_p)[0])
         {
-            ret  = rt_memheap_realloc(&app_image_psram_memheap, temp_p, new_size);
+            ret  = psram_heap_realloc(temp_p, new_size);
             if (ret)((uint32_t *) ret)[0] = PSRAM_HEAP;
         }
         else
@@ -593,7 +626,7 @@ void app_anim_mem_free(void *p)
     if (mem_log) rt_kprintf("app_anim_mem_free: %p. \n", temp_p);
     if (PSRAM_HEAP == ((uint32_t *) temp_p)[0] || SRAM_HEAP == ((uint32_t *) temp_p)[0])
     {
-        rt_memheap_free(temp_p);
+        app_heap_free(temp_p);
     }
     else
     {
@@ -696,6 +729,19 @@ uint32_t app_mem_get_ft_cache_size(void)
     return FREETYPE_ACT_CACHE_SIZE;
 }
 
+void app_mem_get_psram_info(uint32_t *pool_size, uint32_t *used_size, uint32_t *max_used_size)
+{
+#if IMAGE_CACHE_IN_PSRAM_SIZE > 0
+    *pool_size = app_image_psram_memheap.pool_size;
+    *used_size = app_image_psram_memheap.pool_size - app_image_psram_memheap.available_size;
+    *max_used_size = app_image_psram_memheap.max_used_size;
+#else
+    *pool_size = 0;
+    *used_size = 0;
+    *max_used_size = 0;
+#endif
+}
+
 
 #if PKG_USING_FFMPEG
 typedef struct _ffmpeg_mem_header
@@ -137,6 +137,14 @@ void app_mem_flush_cache(void *data, uint32_t size);
 */
 uint8_t app_get_mem_type(void *data);
 
+/**
+@brief get usage of image cache pool in PSRAM, all are 0 if the pool doesn't exist
+@param[out] pool_size Size of the pool
+@param[out] used_size Size in use now, include block header
+@param[out] max_used_size Peak of used size since boot
+*/
+void app_mem_get_psram_info(uint32_t *pool_size, uint32_t *used_size, uint32_t *max_used_size);
+
 
 /**********************
  *      MACROS
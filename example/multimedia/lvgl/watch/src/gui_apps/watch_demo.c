@@ -12,6 +12,7 @@
 #include "app_mem.h"
 #include "log.h"
 #include "lv_freetype.h"
+#include "ui_bench.h"
 
 #ifdef BSP_USING_PM
     #include "bf0_pm.h"
@@ -475,6 +476,7 @@ void app_watch_entry(void *parameter)
 
     gui_app_run("Main");
     lv_disp_trig_activity(NULL);
+    ui_bench_init();
 #if defined(GUI_APP_FRAMEWORK)&&(!defined (APP_TRANS_ANIMATION_NONE))
     lvsf_gesture_init(lv_layer_top());
 #endif /* defined(GUI_APP_FRAMEWORK)&&(!defined (APP_TRANS_ANIMATION_NONE)) */
@@ -504,7 +506,7 @@ void app_watch_entry(void *parameter)
             }
             else if (ms > 0)
             {
-                rt_thread_mdelay(ms);       /* Just to let the system breathe */
+                littlevgl2rtt_sleep(ms);    /* Just to let the system breathe */
             }
         }
         else
@@ -512,7 +514,7 @@ void app_watch_entry(void *parameter)
         {
             //EventStartB(0);
             if (ms > 0)
-                rt_thread_mdelay(ms);       /* Just to let the system breathe */
+                littlevgl2rtt_sleep(ms);    /* Just to let the system breathe */
             //EventStopB(0);
         }
 
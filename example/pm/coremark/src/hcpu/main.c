@@ -134,44 +134,25 @@ static void enable_module2(void)
 #endif /* SF32LB58X */
 }
 
-int run_coremark(int argc, char *argv[])
+/* Set HCPU clock in MHz, dvfs_mode is only used by SF32LB52X, -1 to select by frequency */
+static HAL_StatusTypeDef hcpu_set_freq(uint32_t freq, int dvfs_mode)
 {
     HAL_StatusTypeDef ret;
     rt_base_t level;
-#ifdef SF32LB52X
-    HPSYS_DvfsModeTypeDef dvfs_mode;
-#endif /* SF32LB52X */
-
-    if (argc < 2)
-    {
-        rt_kprintf("Wrong argument\n");
-        return -1;
-    }
-    uint32_t freq = atoi(argv[1]);
-
-    disable_module1();
-
-
-    rt_kprintf("Current HCPU freq: %d\n", HAL_RCC_GetHCLKFreq(CORE_ID_HCPU));
 
 #ifdef SF32lB55X
     HAL_RCC_LCPU_ClockSelect(RCC_CLK_MOD_SYS, RCC_SYSCLK_CLK_LP);
 #endif /* SF32LB55X */
 
 #ifdef SF32LB52X
-    if (argc > 2)
+    if (dvfs_mode >= 0)
     {
-        dvfs_mode = atoi(argv[2]);
-        ret = HAL_RCC_HCPU_ConfigHCLKByMode(freq, dvfs_mode);
+        ret = HAL_RCC_HCPU_ConfigHCLKByMode(freq, (HPSYS_DvfsModeTypeDef)dvfs_mode);
     }
     else
     {
         ret = HAL_RCC_HCPU_ConfigHCLK(freq);
     }
-    if (HAL_OK != ret)
-    {
-        RT_ASSERT(0);
-    }
 #else
     HAL_RCC_HCPU_ClockSelect(RCC_CLK_MOD_SYS, RCC_SYSCLK_HXT48);
     ret = HAL_RCC_HCPU_EnableDLL1(freq * 1000000);
@@ -181,6 +162,28 @@ int run_coremark(int argc, char *argv[])
     level = rt_hw_interrupt_disable();
     rt_hw_systick_init();
     rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+int run_coremark(int argc, char *argv[])
+{
+    HAL_StatusTypeDef ret;
+    rt_base_t level;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Wrong argument\n");
+        return -1;
+    }
+    uint32_t freq = atoi(argv[1]);
+
+    disable_module1();
+
+
+    rt_kprintf("Current HCPU freq: %d\n", HAL_RCC_GetHCLKFreq(CORE_ID_HCPU));
+
+    ret = hcpu_set_freq(freq, (argc > 2) ? atoi(argv[2]) : -1);
     RT_ASSERT(HAL_OK == ret);
 
     rt_kprintf("New HCPU freq: %d\n", HAL_RCC_GetHCLKFreq(CORE_ID_HCPU));
@@ -202,9 +205,6 @@ int run_while_loop(int argc, char *argv[])
     HAL_StatusTypeDef ret;
     uint32_t cnt;
     rt_base_t level;
-#ifdef SF32LB52X
-    HPSYS_DvfsModeTypeDef dvfs_mode;
-#endif /* SF32LB52X */
 
     if (argc < 2)
     {
@@ -218,32 +218,7 @@ int run_while_loop(int argc, char *argv[])
 
     rt_kprintf("Current HCPU freq: %d\n", HAL_RCC_GetHCLKFreq(CORE_ID_HCPU));
 
-#ifdef SF32lB55X
-    HAL_RCC_LCPU_ClockSelect(RCC_CLK_MOD_SYS, RCC_SYSCLK_CLK_LP);
-#endif /* SF32LB55X */
-
-#ifdef SF32LB52X
-    if (argc > 2)
-    {
-        dvfs_mode = atoi(argv[2]);
-        ret = HAL_RCC_HCPU_ConfigHCLKByMode(freq, dvfs_mode);
-    }
-    else
-    {
-        ret = HAL_RCC_HCPU_ConfigHCLK(freq);
-    }
-    if (HAL_OK != ret)
-    {
-        RT_ASSERT(0);
-    }
-#else
-    HAL_RCC_HCPU_ClockSelect(RCC_CLK_MOD_SYS, RCC_SYSCLK_HXT48);
-    ret = HAL_RCC_HCPU_EnableDLL1(freq * 1000000);
-    HAL_RCC_HCPU_ClockSelect(RCC_CLK_MOD_SYS, RCC_SYSCLK_DLL1);
-#endif
-    level = rt_hw_interrupt_disable();
-    rt_hw_systick_init();
-    rt_hw_interrupt_enable(level);
+    ret = hcpu_set_freq(freq, (argc > 2) ? atoi(argv[2]) : -1);
     RT_ASSERT(HAL_OK == ret);
 
     freq = HAL_RCC_GetHCLKFreq(CORE_ID_HCPU);
@@ -556,6 +531,28 @@ static char *cmd_line(int argc, char **argv)
     return r;
 }
 
+/* Send command line to LCPU, fail if response of previous one is not received */
+static int lcpu_send_cmd(const char *s)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    if (!ipc_request)
+    {
+        ipc_request = true;
+        rt_hw_interrupt_enable(level);
+        ipc_queue_write(ipc_handle, (uint8_t *)s, strlen(s), 10);
+        rt_pm_release(PM_SLEEP_MODE_IDLE);
+
+        //rt_err_t err = rt_timer_start(&rsp_timeout_timer);
+        //RT_ASSERT(RT_EOK == err);
+        return 0;
+    }
+    rt_hw_interrupt_enable(level);
+    rt_kprintf("Previous command not completed\n");
+
+    return -1;
+}
+
 int tolcpu(int argc, char **argv)
 {
     char *s;
@@ -566,22 +563,7 @@ int tolcpu(int argc, char **argv)
             /* resconstruct command line, replace null-terminator with space character */
             s = cmd_line(argc, argv);
             rt_kprintf("s:%s\n", s);
-            rt_base_t level = rt_hw_interrupt_disable();
-            if (!ipc_request)
-            {
-                ipc_request = true;
-                rt_hw_interrupt_enable(level);
-                ipc_queue_write(ipc_handle, (uint8_t *)s, strlen(s), 10);
-                rt_pm_release(PM_SLEEP_MODE_IDLE);
-
-                //rt_err_t err = rt_timer_start(&rsp_timeout_timer);
-                //RT_ASSERT(RT_EOK == err);
-            }
-            else
-            {
-                rt_hw_interrupt_enable(level);
-                rt_kprintf("Previous command not completed\n");
-            }
+            lcpu_send_cmd(s);
         }
     }
     else
@@ -602,6 +584,102 @@ static void rsp_timeout(void *parameter)
 
 #endif /* SF32LB52X */
 
+/* Sweep HCPU operating points, iterations are scaled by clock so each point runs about 11s */
+#ifndef COREMARK_SWEEP_IT_PER_MHZ
+    #define COREMARK_SWEEP_IT_PER_MHZ   (40)
+#endif
+
+#ifdef SF32LB52X
+    static const uint32_t sweep_freq[] = {240, 144, 48, 24};
+#else
+    static const uint32_t sweep_freq[] = {240, 192, 144, 96, 48};
+#endif /* SF32LB52X */
+
+/* Board with current sense (PMU/ADC or external meter) overrides these two,
+   end returns average HCPU supply current in uA since begin, 0 if not available */
+RT_WEAK void coremark_current_begin(void)
+{
+}
+
+RT_WEAK uint32_t coremark_current_end(void)
+{
+    return 0;
+}
+
+static const char *coremark_code_placement(void)
+{
+    uint32_t addr = (uint32_t)coremark;
+
+    /* flash is mapped at 0x10000000~0x1FFFFFFF or above 0x60000000 */
+    return ((addr >= 0x10000000 && addr < 0x20000000) || addr >= 0x60000000) ? "xip" : "ram";
+}
+
+static int coremark_sweep(int argc, char *argv[])
+{
+    const coremark_result_t *res;
+    uint32_t orig_freq = HAL_RCC_GetHCLKFreq(CORE_ID_HCPU) / 1000000;
+    uint32_t i, freq, ua, score, cm_mhz, cm_ma;
+    rt_base_t level;
+#ifdef SF32LB52X
+    uint32_t lcpu_freq = (argc > 1) ? atoi(argv[1]) : 0;
+    char cmd[32];
+    int wait;
+#endif /* SF32LB52X */
+
+    rt_kprintf("%5s %6s %7s %10s %8s %8s %9s %s\n", "MHz", "iter", "ms", "CoreMark", "CM/MHz", "uA", "CM/mA", "code");
+    for (i = 0; i < sizeof(sweep_freq) / sizeof(sweep_freq[0]); i++)
+    {
+        disable_module1();
+        if (HAL_OK != hcpu_set_freq(sweep_freq[i], -1))
+        {
+            enable_module1();
+            rt_kprintf("%5d not supported\n", sweep_freq[i]);
+            continue;
+        }
+        freq = HAL_RCC_GetHCLKFreq(CORE_ID_HCPU);
+
+#ifdef SF32LB52X
+        /* LCPU runs at the same time, its result is printed with 'L' prefix when done */
+        if (lcpu_freq)
+        {
+            for (wait = 0; ipc_request && wait < 600; wait++)
+                rt_thread_mdelay(100);
+            rt_snprintf(cmd, sizeof(cmd), "run_coremark %d", lcpu_freq);
+            lcpu_send_cmd(cmd);
+            rt_thread_mdelay(10);
+        }
+#endif /* SF32LB52X */
+
+        coremark_set_iterations(freq / 1000000 * COREMARK_SWEEP_IT_PER_MHZ);
+        coremark_current_begin();
+        level = rt_hw_interrupt_disable();
+        disable_module2();
+        coremark(0, 0);
+        enable_module2();
+        rt_hw_interrupt_enable(level);
+        ua = coremark_current_end();
+        enable_module1();
+
+        res = coremark_get_result();
+        if (0 == res->ticks)
+            continue;
+        /* score in 0.01, CoreMark/MHz in 0.001, CoreMark/mA in 0.01 */
+        score = (uint32_t)((uint64_t)res->iterations * 100000 / res->ticks);
+        cm_mhz = (uint32_t)((uint64_t)res->iterations * 1000000000000ULL / ((uint64_t)res->ticks * freq));
+        cm_ma = ua ? (uint32_t)((uint64_t)res->iterations * 100000000 / ((uint64_t)res->ticks * ua)) : 0;
+        rt_kprintf("%5d %6d %7d %7d.%02d %4d.%03d %8d %6d.%02d %s%s\n", freq / 1000000, res->iterations, res->ticks,
+                   score / 100, score % 100, cm_mhz / 1000, cm_mhz % 1000, ua, cm_ma / 100, cm_ma % 100,
+                   coremark_code_placement(), res->err ? " ERR" : "");
+        rt_kprintf("@cm,hcpu,%d,%d,%d,%d,%d,%s,%d\n", freq / 1000000, res->iterations, res->ticks, score, ua,
+                   coremark_code_placement(), res->err);
+    }
+    coremark_set_iterations(0);
+    hcpu_set_freq(orig_freq, -1);
+
+    return 0;
+}
+MSH_CMD_EXPORT(coremark_sweep, "Coremark on each HCPU clock: coremark_sweep [lcpu_freq]")
+
 
 #ifdef DVFS_TEST
 
@@ -0,0 +1,242 @@
+#include "rtthread.h"
+#include "bf0_hal.h"
+#include "drv_io.h"
+#include "stdio.h"
+#include "string.h"
+#include "stdlib.h"
+#include "board.h"
+#include "dfs_posix.h"
+
+#define DBG_TAG "sd_bench"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
+
+/* SD/eMMC throughput benchmark, sequential and random access through file system and
+   pipelined scatter-gather read through drv_sdhci (needs BSP_SDHCI_ADMA_SG) ---------------*/
+#include "drv_sdhci.h"
+
+#define SD_DEV_NAME         "sd0"
+#define BENCH_FILE          "/sd_bench.bin"
+#define BENCH_BUF_SIZE      (256 * 1024)
+#define RAND_IO_SIZE        (4 * 1024)
+
+static uint8_t *bench_buf;
+
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void report(const char *name, uint32_t bytes, uint32_t us)
+{
+    if (us == 0)
+        us = 1;
+    rt_kprintf("%-10s: %d KB in %d ms, %d KB/s\n", name, bytes / 1024, us / 1000,
+               (uint32_t)((uint64_t)bytes * 1000000 / 1024 / us));
+}
+
+/* Sequential write then read of total_kb, chunk_kb per call */
+static int bench_seq(uint32_t total_kb, uint32_t chunk_kb)
+{
+    uint32_t chunk = chunk_kb * 1024;
+    uint32_t total = total_kb * 1024;
+    uint32_t done, start;
+    int fd;
+
+    if (chunk == 0 || chunk > BENCH_BUF_SIZE)
+        chunk = BENCH_BUF_SIZE;
+    for (done = 0; done < chunk; done++)
+        bench_buf[done] = (uint8_t)done;
+
+    fd = open(BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0)
+    {
+        LOG_E("open %s fail", BENCH_FILE);
+        return -1;
+    }
+    start = HAL_GTIMER_READ();
+    for (done = 0; done < total; done += chunk)
+    {
+        if (write(fd, bench_buf, chunk) != chunk)
+            break;
+    }
+    fsync(fd);
+    report("seq write", done, elapsed_us(start));
+    close(fd);
+
+    fd = open(BENCH_FILE, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+    start = HAL_GTIMER_READ();
+    for (done = 0; done < total; done += chunk)
+    {
+        if (read(fd, bench_buf, chunk) != chunk)
+            break;
+    }
+    report("seq read", done, elapsed_us(start));
+    close(fd);
+
+    return 0;
+}
+
+/* Random 4KB read and write inside file made by seq test */
+static int bench_rand(uint32_t count)
+{
+    struct stat st;
+    uint32_t i, blocks, start;
+    int fd;
+
+    if (stat(BENCH_FILE, &st) != 0 || st.st_size < RAND_IO_SIZE)
+    {
+        LOG_E("run seq test first");
+        return -1;
+    }
+    blocks = st.st_size / RAND_IO_SIZE;
+
+    fd = open(BENCH_FILE, O_RDWR, 0);
+    if (fd < 0)
+        return -1;
+
+    srand(rt_tick_get());
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < count; i++)
+    {
+        lseek(fd, (rand() % blocks) * RAND_IO_SIZE, SEEK_SET);
+        if (read(fd, bench_buf, RAND_IO_SIZE) != RAND_IO_SIZE)
+            break;
+    }
+    report("rand read", i * RAND_IO_SIZE, elapsed_us(start));
+    rt_kprintf("%-10s: %d IOPS\n", "", (uint32_t)((uint64_t)i * 1000000 / (elapsed_us(start) + 1)));
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < count; i++)
+    {
+        lseek(fd, (rand() % blocks) * RAND_IO_SIZE, SEEK_SET);
+        if (write(fd, bench_buf, RAND_IO_SIZE) != RAND_IO_SIZE)
+            break;
+    }
+    fsync(fd);
+    report("rand write", i * RAND_IO_SIZE, elapsed_us(start));
+    close(fd);
+
+    return 0;
+}
+
+#ifdef BSP_SDHCI_ADMA_SG
+#define SG_REQ_NUM          (2)
+#define SG_SEG_NUM          (4)
+
+static struct rt_sdhci_req sg_req[SG_REQ_NUM];
+static SDHCI_SgTypeDef sg_seg[SG_REQ_NUM][SG_SEG_NUM];
+static struct rt_semaphore sg_done;
+static volatile rt_err_t sg_err;
+
+static void sg_cb(struct rt_sdhci_req *req, rt_err_t result)
+{
+    if (result != RT_EOK)
+        sg_err = result;
+    rt_sem_release(&sg_done);
+}
+
+/* Read only, from sector, keeps two requests in flight, each over SG_SEG_NUM segments */
+static int bench_sg(uint32_t sector, uint32_t total_kb)
+{
+    uint32_t req_blks = BENCH_BUF_SIZE / SG_REQ_NUM / SECTOR_SIZE;
+    uint32_t seg_len = BENCH_BUF_SIZE / SG_REQ_NUM / SG_SEG_NUM;
+    uint32_t total_blks = total_kb * 2;
+    uint32_t queued, done, start;
+    int i, j;
+
+    rt_sem_init(&sg_done, "sg_done", 0, RT_IPC_FLAG_FIFO);
+    sg_err = RT_EOK;
+    for (i = 0; i < SG_REQ_NUM; i++)
+    {
+        for (j = 0; j < SG_SEG_NUM; j++)
+        {
+            sg_seg[i][j].addr = (uint32_t)bench_buf + BENCH_BUF_SIZE / SG_REQ_NUM * i + seg_len * j;
+            sg_seg[i][j].len = seg_len;
+        }
+        sg_req[i].blks = req_blks;
+        sg_req[i].sg = sg_seg[i];
+        sg_req[i].sg_num = SG_SEG_NUM;
+        sg_req[i].write = 0;
+        sg_req[i].cb = sg_cb;
+    }
+
+    start = HAL_GTIMER_READ();
+    queued = 0;
+    done = 0;
+    for (i = 0; i < SG_REQ_NUM && queued < total_blks; i++)
+    {
+        sg_req[i].sector = sector + queued;
+        rt_sdhci_submit(0, &sg_req[i]);
+        queued += req_blks;
+    }
+    i = 0;
+    while (done < queued)
+    {
+        rt_sem_take(&sg_done, RT_WAITING_FOREVER);
+        done += req_blks;
+        /* request i is done first since queue is FIFO, reuse it for next blocks */
+        if (queued < total_blks && sg_err == RT_EOK)
+        {
+            sg_req[i].sector = sector + queued;
+            rt_sdhci_submit(0, &sg_req[i]);
+            queued += req_blks;
+        }
+        i = (i + 1) % SG_REQ_NUM;
+    }
+    report("sg read", done * SECTOR_SIZE, elapsed_us(start));
+    rt_sem_detach(&sg_done);
+
+    return sg_err == RT_EOK ? 0 : -1;
+}
+#endif /* BSP_SDHCI_ADMA_SG */
+
+static int sd_bench(int argc, char **argv)
+{
+    if (bench_buf == NULL)
+        bench_buf = rt_malloc_align(BENCH_BUF_SIZE, 32);
+    if (bench_buf == NULL)
+    {
+        LOG_E("no buffer");
+        return -1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "seq") == 0)
+        return bench_seq(argc > 2 ? atoi(argv[2]) : 4096, argc > 3 ? atoi(argv[3]) : 64);
+    if (argc >= 2 && strcmp(argv[1], "rand") == 0)
+        return bench_rand(argc > 2 ? atoi(argv[2]) : 256);
+#ifdef BSP_SDHCI_ADMA_SG
+    if (argc >= 3 && strcmp(argv[1], "sg") == 0)
+        return bench_sg(atoi(argv[2]), argc > 3 ? atoi(argv[3]) : 4096);
+#endif
+
+    rt_kprintf("sd_bench seq [total_kb] [chunk_kb]\n");
+    rt_kprintf("sd_bench rand [count]\n");
+#ifdef BSP_SDHCI_ADMA_SG
+    rt_kprintf("sd_bench sg <sector> [total_kb]\n");
+#endif
+    return 0;
+}
+MSH_CMD_EXPORT(sd_bench, SD throughput benchmark);
+
+int main(void)
+{
+    int i;
+
+    /* card is probed in mmcsd thread, wait block device */
+    for (i = 0; i < 50 && rt_device_find(SD_DEV_NAME) == RT_NULL; i++)
+        rt_thread_mdelay(100);
+
+    if (dfs_mount(SD_DEV_NAME, "/", "elm", 0, 0) == 0)
+        rt_kprintf("mount %s success, use sd_bench to start\n", SD_DEV_NAME);
+    else
+        rt_kprintf("mount %s fail\n", SD_DEV_NAME);
+
+    while (1)
+    {
+        rt_thread_mdelay(10000);    // Let system breath.
+    }
+    return 0;
+}
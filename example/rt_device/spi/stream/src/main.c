@@ -0,0 +1,169 @@
+#include "rtthread.h"
+#include "bf0_hal.h"
+#include "drv_io.h"
+#include "stdio.h"
+#include "string.h"
+#include "board.h"
+
+#define DBG_TAG "spi_stream"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
+
+/* spi streaming and queued transfer example, measures gap between back-to-back transfers.
+   Needs BSP_SPI_STREAM, and SPI1 rx/tx dma enabled in menuconfig ---------------------------*/
+#include "drv_spi.h"
+
+#ifndef BSP_SPI_STREAM
+    #error "Enable BSP_SPI_STREAM to run this example"
+#endif
+
+#define SPI_BUS_NAME        "spi1"
+#define SPI_DEVICE_NAME     "spi_strm"
+#define SPI_CLOCK_HZ        (20 * 1000 * 1000)
+
+#define MSG_NUM             (16)
+#define MSG_LEN             (64)
+#define RING_SIZE           (1024)
+
+static struct rt_spi_device *spi_dev;
+static struct rt_spi_message msgs[MSG_NUM];
+static uint8_t msg_buf[MSG_NUM][MSG_LEN];
+ALIGN(4) static uint8_t ring[RING_SIZE];
+static volatile uint32_t ring_halves;
+
+static rt_err_t spi_dev_init(void)
+{
+    struct rt_spi_configuration cfg = {0};
+    rt_device_t spi_bus;
+
+#ifdef  SF32LB52X
+    HAL_PIN_Set(PAD_PA24, SPI1_DIO, PIN_PULLDOWN, 1);
+    HAL_PIN_Set(PAD_PA25, SPI1_DI,  PIN_PULLUP, 1);
+    HAL_PIN_Set(PAD_PA28, SPI1_CLK, PIN_NOPULL, 1);
+    HAL_PIN_Set(PAD_PA29, SPI1_CS,  PIN_NOPULL, 1);
+#elif defined(SF32LB58X)
+    HAL_PIN_Set(PAD_PA21, SPI1_DO, PIN_PULLDOWN, 1);
+    HAL_PIN_Set(PAD_PA20, SPI1_DI,  PIN_PULLUP, 1);
+    HAL_PIN_Set(PAD_PA28, SPI1_CLK, PIN_NOPULL, 1);
+    HAL_PIN_Set(PAD_PA29, SPI1_CS,  PIN_NOPULL, 1);
+#endif
+
+    spi_bus = rt_device_find(SPI_BUS_NAME);
+    if (!spi_bus)
+        return -RT_ERROR;
+    rt_device_open(spi_bus, RT_DEVICE_FLAG_RDWR);
+
+    rt_hw_spi_device_attach(SPI_BUS_NAME, SPI_DEVICE_NAME);
+    spi_dev = (struct rt_spi_device *)rt_device_find(SPI_DEVICE_NAME);
+    if (!spi_dev)
+        return -RT_ERROR;
+    rt_device_open((rt_device_t)spi_dev, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_DMA_TX | RT_DEVICE_FLAG_DMA_RX);
+
+    cfg.data_width = 8;
+    cfg.max_hz = SPI_CLOCK_HZ;
+    cfg.mode = RT_SPI_MODE_0 | RT_SPI_MSB | RT_SPI_MASTER;
+    cfg.frameMode = RT_SPI_MOTO;
+    return rt_spi_configure(spi_dev, &cfg);
+}
+
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+/* Average idle time per message: whole time minus time of clocking data out */
+static void report(const char *name, uint32_t total_us)
+{
+    uint32_t wire_us = (uint32_t)((uint64_t)MSG_NUM * MSG_LEN * 8 * 1000000 / SPI_CLOCK_HZ);
+
+    rt_kprintf("%-9s: %d msgs x %d bytes, total %dus, wire %dus, gap %dus/msg\n", name, MSG_NUM, MSG_LEN,
+               total_us, wire_us, (total_us > wire_us) ? (total_us - wire_us) / MSG_NUM : 0);
+}
+
+static void measure_gap(void)
+{
+    rt_spi_queue_stat_t stat;
+    uint32_t start;
+
+    for (int i = 0; i < MSG_NUM; i++)
+    {
+        memset(msg_buf[i], i, MSG_LEN);
+        msgs[i].send_buf = msg_buf[i];
+        msgs[i].recv_buf = RT_NULL;
+        msgs[i].length = MSG_LEN;
+        /* every message is a CS framed command */
+        msgs[i].cs_take = 1;
+        msgs[i].cs_release = 1;
+        msgs[i].next = (i + 1 < MSG_NUM) ? &msgs[i + 1] : RT_NULL;
+    }
+
+    start = HAL_GTIMER_READ();
+    rt_spi_transfer_message(spi_dev, &msgs[0]);
+    report("blocking", elapsed_us(start));
+
+    rt_spi_queue_get_stat(spi_dev, &stat, RT_TRUE);
+    start = HAL_GTIMER_READ();
+    if (rt_spi_queue_transfer(spi_dev, &msgs[0]))
+        LOG_E("queue transfer failed");
+    report("queued", elapsed_us(start));
+
+    rt_spi_queue_get_stat(spi_dev, &stat, RT_FALSE);
+    rt_kprintf("queued   : isr gap avg %dus, max %dus\n",
+               stat.gap_num ? (uint32_t)(stat.gap_sum_us / stat.gap_num) : 0, stat.gap_max_us);
+}
+
+static void ring_cb(struct rt_spi_device *device, rt_uint8_t *buf, rt_uint32_t size, void *arg)
+{
+    /* refill half just sent */
+    memset(buf, (uint8_t)ring_halves, size);
+    ring_halves++;
+}
+
+static void measure_stream(void)
+{
+    uint32_t start, us;
+
+    memset(ring, 0x5a, sizeof(ring));
+    ring_halves = 0;
+    start = HAL_GTIMER_READ();
+    if (RT_EOK != rt_spi_stream_start(spi_dev, RT_SPI_STREAM_TX, ring, sizeof(ring), ring_cb, RT_NULL))
+    {
+        LOG_E("stream start failed");
+        return;
+    }
+    rt_thread_mdelay(100);
+    rt_spi_stream_stop(spi_dev);
+    us = elapsed_us(start);
+
+    /* without gap, throughput is same as clock rate */
+    rt_kprintf("stream   : %d bytes in %dus, %d kbps of %d kbps clock\n", ring_halves * RING_SIZE / 2, us,
+               (uint32_t)((uint64_t)ring_halves * RING_SIZE / 2 * 8 * 1000 / us), SPI_CLOCK_HZ / 1000);
+}
+
+/**
+  * @brief  Main program
+  * @param  None
+  * @retval 0 if success, otherwise failure number
+  */
+int main(void)
+{
+    rt_kprintf("Start spi stream demo!\n");
+    rt_thread_mdelay(100);
+    if (RT_EOK != spi_dev_init())
+    {
+        LOG_E("spi init failed");
+        return -RT_ERROR;
+    }
+
+    measure_gap();
+    measure_stream();
+    rt_kprintf("spi stream demo end!\n");
+
+    while (1)
+    {
+        rt_thread_mdelay(5000);
+    }
+    return RT_EOK;
+}
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
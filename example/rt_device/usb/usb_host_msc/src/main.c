@@ -0,0 +1,126 @@
+#include "rtthread.h"
+#include "bf0_hal.h"
+#include "drv_io.h"
+#include "stdio.h"
+#include "string.h"
+#include "stdlib.h"
+#include "board.h"
+#include "dfs_posix.h"
+
+#define DBG_TAG "udisk_bench"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
+
+/* USB host mass storage throughput, sequential file write then read with several chunk
+   sizes. Build with RT_USBH_MSTORAGE_CACHE to compare, udisk_cache shows how requests
+   were merged --------------------------------------------------------------------------*/
+#ifndef UDISK_MOUNTPOINT
+    #define UDISK_MOUNTPOINT    "/"
+#endif
+
+#define BENCH_FILE          UDISK_MOUNTPOINT "/udisk_bench.bin"
+#define BENCH_BUF_SIZE      (64 * 1024)
+
+static uint8_t *bench_buf;
+
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void report(const char *name, uint32_t chunk, uint32_t bytes, uint32_t us)
+{
+    uint32_t kbps;
+
+    if (us == 0)
+        us = 1;
+    kbps = (uint32_t)((uint64_t)bytes * 1000000 / 1024 / us);
+    rt_kprintf("%-6s %6d B chunk: %d KB in %d ms, %d.%02d MB/s\n", name, chunk, bytes / 1024,
+               us / 1000, kbps / 1024, (kbps % 1024) * 100 / 1024);
+}
+
+static int bench_seq(uint32_t total_kb, uint32_t chunk)
+{
+    uint32_t total = total_kb * 1024;
+    uint32_t done, start;
+    int fd;
+
+    for (done = 0; done < chunk; done++)
+        bench_buf[done] = (uint8_t)done;
+
+    fd = open(BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0)
+    {
+        LOG_E("open %s fail", BENCH_FILE);
+        return -1;
+    }
+    start = HAL_GTIMER_READ();
+    for (done = 0; done < total; done += chunk)
+    {
+        if (write(fd, bench_buf, chunk) != chunk)
+            break;
+    }
+    fsync(fd);
+    report("write", chunk, done, elapsed_us(start));
+    close(fd);
+
+    fd = open(BENCH_FILE, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+    start = HAL_GTIMER_READ();
+    for (done = 0; done < total; done += chunk)
+    {
+        if (read(fd, bench_buf, chunk) != chunk)
+            break;
+    }
+    report("read", chunk, done, elapsed_us(start));
+    close(fd);
+
+    return 0;
+}
+
+static int udisk_bench(int argc, char **argv)
+{
+    static const uint32_t chunks[] = {512, 4 * 1024, 32 * 1024};
+    uint32_t total_kb = argc > 1 ? atoi(argv[1]) : 1024;
+    uint32_t i;
+
+    if (bench_buf == NULL)
+        bench_buf = rt_malloc_align(BENCH_BUF_SIZE, 32);
+    if (bench_buf == NULL)
+    {
+        LOG_E("no buffer");
+        return -1;
+    }
+
+    if (argc > 2)
+    {
+        uint32_t chunk = atoi(argv[2]) * 1024;
+
+        if (chunk == 0 || chunk > BENCH_BUF_SIZE)
+            chunk = BENCH_BUF_SIZE;
+        return bench_seq(total_kb, chunk);
+    }
+
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+    {
+        if (bench_seq(total_kb, chunks[i]) != 0)
+            return -1;
+    }
+    unlink(BENCH_FILE);
+
+    return 0;
+}
+MSH_CMD_EXPORT(udisk_bench, udisk_bench [total_kb] [chunk_kb]: USB disk throughput);
+
+int main(void)
+{
+    /* disk is probed and mounted to UDISK_MOUNTPOINT by usb host class driver */
+    rt_kprintf("plug in USB disk, then run udisk_bench\n");
+
+    while (1)
+    {
+        rt_thread_mdelay(10000);    // Let system breath.
+    }
+    return 0;
+}
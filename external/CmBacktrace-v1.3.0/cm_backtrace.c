@@ -27,6 +27,7 @@
  */
 
 #include <cm_backtrace.h>
+#include <cmb_retm.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
@@ -795,3 +796,79 @@ void cm_backtrace_fault(uint32_t fault_handler_lr, uint32_t fault_handler_sp)
 
     print_call_stack(stack_pointer);
 }
+
+#ifdef CMB_USING_RETM
+/**
+ * save fault record to retention RAM, nothing is printed
+ * @note cm_backtrace_fault() could still be called afterwards
+ *
+ * @param fault_handler_lr the LR register value on fault handler
+ * @param fault_handler_sp the stack pointer on fault handler
+ */
+void cm_backtrace_fault_save(uint32_t fault_handler_lr, uint32_t fault_handler_sp)
+{
+    cmb_retm_record_t *record;
+    uint32_t stack_pointer = fault_handler_sp, saved_regs_addr = stack_pointer;
+    uint32_t stack_start_addr = main_stack_start_addr, n;
+    size_t stack_size = main_stack_size;
+
+    if (!init_ok || on_fault)
+    {
+        return;
+    }
+    record = cmb_retm_begin();
+
+#ifdef CMB_USING_OS_PLATFORM
+    on_thread_before_fault = fault_handler_lr & (1UL << 2);
+    if (on_thread_before_fault)
+    {
+        saved_regs_addr = stack_pointer = cmb_get_psp();
+        get_cur_thread_stack_info(stack_pointer, &stack_start_addr, &stack_size);
+        if (get_cur_thread_name() != NULL)
+        {
+            strncpy(record->thread, get_cur_thread_name(), CMB_RETM_NAME_LEN);
+        }
+    }
+#endif /* CMB_USING_OS_PLATFORM */
+    record->on_thread = on_thread_before_fault;
+    record->exc_return = fault_handler_lr;
+
+    stack_pointer += sizeof(size_t) * 8;
+#if (CMB_CPU_PLATFORM_TYPE == CMB_CPU_ARM_CORTEX_M4) || (CMB_CPU_PLATFORM_TYPE == CMB_CPU_ARM_CORTEX_M7)
+    stack_pointer = statck_del_fpu_regs(fault_handler_lr, stack_pointer);
+#endif
+    record->sp = stack_pointer;
+
+    stack_is_overflow = stack_pointer < stack_start_addr || stack_pointer > stack_start_addr + stack_size;
+    record->stack_overflow = stack_is_overflow;
+    if (!stack_is_overflow)
+    {
+        memcpy(record->regs, (uint32_t *)saved_regs_addr, sizeof(record->regs));
+        regs.saved.lr = record->regs[5];
+        regs.saved.pc = record->regs[6];
+
+        n = (stack_start_addr + stack_size - stack_pointer) / sizeof(uint32_t);
+        if (n > CMB_RETM_STACK_WORDS)
+        {
+            n = CMB_RETM_STACK_WORDS;
+        }
+        memcpy(record->stack, (uint32_t *)stack_pointer, n * sizeof(uint32_t));
+        record->stack_words = n;
+    }
+
+#if (CMB_CPU_PLATFORM_TYPE != CMB_CPU_ARM_CORTEX_M0)
+    record->cfsr = *(volatile uint32_t *)&CMB_NVIC_MFSR;
+    record->hfsr = CMB_NVIC_HFSR;
+    record->mmar = CMB_NVIC_MMAR;
+    record->bfar = CMB_NVIC_BFAR;
+#endif
+
+    /* call stack scan uses state of fault */
+    on_fault = true;
+    record->depth = cm_backtrace_call_stack(record->call_stack, CMB_CALL_STACK_MAX_DEPTH, stack_pointer);
+    on_fault = false;
+    stack_is_overflow = false;
+
+    cmb_retm_end(record);
+}
+#endif /* CMB_USING_RETM */
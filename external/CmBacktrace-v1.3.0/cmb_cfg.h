@@ -55,6 +55,21 @@
 #if defined(PKG_CMBACKTRACE_DUMP_STACK)
     #define CMB_USING_DUMP_STACK_INFO
 #endif
+/* save fault record to retention RAM, decoded and uploaded on next boot */
+#if defined(PKG_CMBACKTRACE_RETM)
+    #define CMB_USING_RETM
+    #if defined(PKG_CMBACKTRACE_RETM_REBOOT)
+        #define CMB_RETM_REBOOT
+    #endif
+    #define CMB_RETM_STACK_WORDS       PKG_CMBACKTRACE_RETM_STACK_WORDS
+    #define CMB_RETM_THREAD_NUM        PKG_CMBACKTRACE_RETM_THREAD_NUM
+    #if defined(PKG_CMBACKTRACE_RETM_LOG_SIZE)
+        #define CMB_RETM_LOG_SIZE      PKG_CMBACKTRACE_RETM_LOG_SIZE
+    #endif
+    #if defined(PKG_CMBACKTRACE_RETM_FILE)
+        #define CMB_RETM_FILE          PKG_CMBACKTRACE_RETM_FILE
+    #endif
+#endif
 /* language of print information */
 #if defined(PKG_CMBACKTRACE_PRINT_ENGLISH)
     #define CMB_PRINT_LANGUAGE         CMB_PRINT_LANGUAGE_ENGLISH
@@ -28,6 +28,7 @@
 #include <rtthread.h>
 #include <rthw.h>
 #include <cm_backtrace.h>
+#include <cmb_retm.h>
 #include <string.h>
 
 #ifndef CMB_LR_WORD_OFFSET
@@ -74,7 +75,7 @@ RT_WEAK rt_err_t exception_hook(void *context)
 
     rt_enter_critical();
 
-#ifdef RT_USING_FINSH
+#if defined(RT_USING_FINSH) && !defined(CMB_RETM_REBOOT)
     list_thread();
 #endif
 
@@ -85,6 +86,17 @@ RT_WEAK rt_err_t exception_hook(void *context)
     cmb_set_psp(cmb_get_psp() + 4 * 9);
 #endif
 
+#ifdef CMB_USING_RETM
+    /* record is printed and uploaded on next boot, no local variable to keep CMB_LR_WORD_OFFSET */
+    cm_backtrace_fault_save(*((uint32_t *)(cmb_get_sp() + sizeof(uint32_t) * CMB_LR_WORD_OFFSET)), cmb_get_sp() + sizeof(uint32_t) * CMB_SP_WORD_OFFSET);
+#ifdef CMB_RETM_REBOOT
+    {
+        extern void drv_reboot(void);
+        drv_reboot();
+    }
+#endif /* CMB_RETM_REBOOT */
+#endif /* CMB_USING_RETM */
+
     cm_backtrace_fault(*((uint32_t *)(cmb_get_sp() + sizeof(uint32_t) * CMB_LR_WORD_OFFSET)), cmb_get_sp() + sizeof(uint32_t) * CMB_SP_WORD_OFFSET);
 
     while (_continue == 1);
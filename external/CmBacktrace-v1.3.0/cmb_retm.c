@@ -0,0 +1,411 @@
+/*
+ * This file is part of the CmBacktrace Library.
+ *
+ * Function: Port of fault record in retention RAM, recent log ring, decode and upload on next boot.
+ */
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <cm_backtrace.h>
+#include <cmb_retm.h>
+#include "mem_section.h"
+
+#ifdef CMB_USING_RETM
+
+#ifdef RT_USING_ULOG
+    #include <ulog.h>
+#endif
+#ifdef USING_METRICS_COLLECTOR
+    #include "metrics_collector.h"
+    #include "metrics_id_middleware.h"
+#endif
+#ifdef USING_FILE_LOGGER
+    #include "file_logger.h"
+    #ifndef CMB_RETM_FILE
+        #define CMB_RETM_FILE              "/crash.bin"
+    #endif
+    #ifndef CMB_RETM_FILE_MAX
+        #define CMB_RETM_FILE_MAX          (16 * 1024)
+    #endif
+#endif
+
+#define CMB_RETM_HDR_SIZE      offsetof(cmb_retm_record_t, tick)
+
+typedef struct
+{
+    uint32_t wr;
+    char buf[CMB_RETM_LOG_SIZE];
+} cmb_retm_log_t;
+
+/* not cleared by reboot, validated by magic and checksum */
+RETM_BSS_SECT_BEGIN(cmb_retm)
+static cmb_retm_record_t cmb_retm_record RETM_BSS_SECT(cmb_retm);
+#ifdef RT_USING_ULOG
+    static cmb_retm_log_t cmb_retm_log RETM_BSS_SECT(cmb_retm);
+#endif
+RETM_BSS_SECT_END
+
+/* record is pending upload, log ring is not written to keep log before fault */
+static bool cmb_retm_pending;
+
+static uint32_t record_checksum(const cmb_retm_record_t *record)
+{
+    const uint32_t *p = (const uint32_t *)&record->tick;
+    uint32_t n = (record->size - CMB_RETM_HDR_SIZE) / sizeof(uint32_t);
+    uint32_t sum = 0;
+
+    while (n--)
+    {
+        sum += *p++;
+    }
+    return sum;
+}
+
+cmb_retm_record_t *cmb_retm_begin(void)
+{
+    cmb_retm_record_t *record = &cmb_retm_record;
+    struct rt_object_information *info;
+    struct rt_list_node *node;
+    struct rt_thread *thread;
+    uint32_t n = 0;
+
+    memset(record, 0, offsetof(cmb_retm_record_t, stack));
+    record->version = CMB_RETM_VERSION;
+    record->tick = rt_tick_get();
+#ifdef RT_USING_ULOG
+    record->log_wr = cmb_retm_pending ? 0 : cmb_retm_log.wr;
+#endif
+
+    /* scheduler is stopped in fault, walk thread list without lock */
+    info = rt_object_get_information(RT_Object_Class_Thread);
+    for (node = info->object_list.next; node != &info->object_list && n < CMB_RETM_THREAD_NUM; node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+        strncpy(record->threads[n].name, thread->name, CMB_RETM_NAME_LEN);
+        record->threads[n].sp = (uint32_t)thread->sp;
+        record->threads[n].stack_addr = (uint32_t)thread->stack_addr;
+        record->threads[n].stack_size = thread->stack_size;
+        record->threads[n].stat = thread->stat;
+        record->threads[n].priority = thread->current_priority;
+        n++;
+    }
+    record->thread_num = n;
+
+    return record;
+}
+
+void cmb_retm_end(cmb_retm_record_t *record)
+{
+    record->size = offsetof(cmb_retm_record_t, stack) + record->stack_words * sizeof(uint32_t);
+    record->checksum = record_checksum(record);
+    record->magic = CMB_RETM_MAGIC;
+}
+
+static bool record_is_valid(const cmb_retm_record_t *record)
+{
+    return (CMB_RETM_MAGIC == record->magic) && (CMB_RETM_VERSION == record->version)
+           && (record->size >= offsetof(cmb_retm_record_t, stack)) && (record->size <= sizeof(*record))
+           && (record->checksum == record_checksum(record));
+}
+
+const cmb_retm_record_t *cmb_retm_get(const char **log, size_t *log_size)
+{
+    if (!cmb_retm_pending)
+    {
+        return NULL;
+    }
+#ifdef RT_USING_ULOG
+    if (log)
+    {
+        *log = cmb_retm_log.buf;
+    }
+    if (log_size)
+    {
+        *log_size = sizeof(cmb_retm_log.buf);
+    }
+#else
+    if (log_size)
+    {
+        *log_size = 0;
+    }
+#endif
+    return &cmb_retm_record;
+}
+
+void cmb_retm_clear(void)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    cmb_retm_record.magic = 0;
+    cmb_retm_pending = false;
+#ifdef RT_USING_ULOG
+    cmb_retm_log.wr = 0;
+    memset(cmb_retm_log.buf, 0, sizeof(cmb_retm_log.buf));
+#endif
+    rt_hw_interrupt_enable(level);
+}
+
+static void print_log(const cmb_retm_record_t *record)
+{
+#ifdef RT_USING_ULOG
+    uint32_t i, pos;
+    char c;
+
+    rt_kprintf("recent log:\n");
+    /* oldest first, zero bytes are never written */
+    for (i = 0; i < CMB_RETM_LOG_SIZE; i++)
+    {
+        pos = (record->log_wr + i) % CMB_RETM_LOG_SIZE;
+        c = cmb_retm_log.buf[pos];
+        if (('\n' == c) || ((c >= ' ') && (c <= '~')))
+        {
+            rt_kprintf("%c", c);
+        }
+    }
+    rt_kprintf("\n");
+#endif /* RT_USING_ULOG */
+}
+
+void cmb_retm_print(const cmb_retm_record_t *record)
+{
+    uint32_t i;
+
+    if (!record)
+    {
+        return;
+    }
+
+    rt_kprintf("==== fault before reboot, tick %d ====\n", record->tick);
+    rt_kprintf("on %s %.*s%s\n", record->on_thread ? "thread" : "handler", CMB_RETM_NAME_LEN,
+               record->on_thread ? record->thread : "", record->stack_overflow ? ", stack overflow" : "");
+    rt_kprintf("  R0 : %08x  R1 : %08x  R2 : %08x  R3 : %08x\n",
+               record->regs[0], record->regs[1], record->regs[2], record->regs[3]);
+    rt_kprintf("  R12: %08x  LR : %08x  PC : %08x  PSR: %08x\n",
+               record->regs[4], record->regs[5], record->regs[6], record->regs[7]);
+    rt_kprintf("  EXC_RETURN: %08x  SP: %08x\n", record->exc_return, record->sp);
+    rt_kprintf("  CFSR: %08x  HFSR: %08x  MMAR: %08x  BFAR: %08x\n",
+               record->cfsr, record->hfsr, record->mmar, record->bfar);
+
+    rt_kprintf("call stack, use addr2line -e xxx.axf -a -f");
+    for (i = 0; i < record->depth && i < CMB_CALL_STACK_MAX_DEPTH; i++)
+    {
+        rt_kprintf(" %08x", record->call_stack[i]);
+    }
+    rt_kprintf("\n");
+
+    rt_kprintf("thread   pri  stat sp       stack    size\n");
+    for (i = 0; i < record->thread_num && i < CMB_RETM_THREAD_NUM; i++)
+    {
+        rt_kprintf("%-*.*s %3d  %02x   %08x %08x %d\n", CMB_RETM_NAME_LEN, CMB_RETM_NAME_LEN,
+                   record->threads[i].name, record->threads[i].priority, record->threads[i].stat,
+                   record->threads[i].sp, record->threads[i].stack_addr, record->threads[i].stack_size);
+    }
+
+    rt_kprintf("stack:");
+    for (i = 0; i < record->stack_words && i < CMB_RETM_STACK_WORDS; i++)
+    {
+        if (0 == (i & 3))
+        {
+            rt_kprintf("\n  %08x:", record->sp + i * sizeof(uint32_t));
+        }
+        rt_kprintf(" %08x", record->stack[i]);
+    }
+    rt_kprintf("\n");
+
+    print_log(record);
+    rt_kprintf("====================================\n");
+}
+
+#ifdef USING_METRICS_COLLECTOR
+typedef struct
+{
+    uint32_t tick;
+    uint32_t pc;
+    uint32_t lr;
+    uint32_t psr;
+    uint32_t exc_return;
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t fault_addr;
+    char thread[CMB_RETM_NAME_LEN];
+    uint8_t on_thread;
+    uint8_t stack_overflow;
+    uint8_t depth;
+    uint8_t reserved;
+    uint32_t call_stack[CMB_CALL_STACK_MAX_DEPTH];
+} cmb_retm_metrics_t;
+
+static mc_collector_t cmb_retm_collector;
+
+static void cmb_retm_collect(void *user_data)
+{
+    if (cmb_retm_pending)
+    {
+        cmb_retm_upload();
+    }
+}
+#endif /* USING_METRICS_COLLECTOR */
+
+int cmb_retm_upload(void)
+{
+    const cmb_retm_record_t *record = &cmb_retm_record;
+#ifdef USING_METRICS_COLLECTOR
+    cmb_retm_metrics_t *m;
+#endif
+#ifdef USING_FILE_LOGGER
+    void *logger;
+#endif
+
+    if (!cmb_retm_pending)
+    {
+        return -1;
+    }
+
+#ifdef USING_METRICS_COLLECTOR
+    m = mc_alloc_metrics(METRICS_MW_CRASH_RECORD, sizeof(*m));
+    if (!m)
+    {
+        return -1;
+    }
+    m->tick = record->tick;
+    m->pc = record->regs[6];
+    m->lr = record->regs[5];
+    m->psr = record->regs[7];
+    m->exc_return = record->exc_return;
+    m->cfsr = record->cfsr;
+    m->hfsr = record->hfsr;
+    /* BFARVALID or MMARVALID */
+    m->fault_addr = (record->cfsr & (1UL << 15)) ? record->bfar : record->mmar;
+    memcpy(m->thread, record->thread, CMB_RETM_NAME_LEN);
+    m->on_thread = record->on_thread;
+    m->stack_overflow = record->stack_overflow;
+    m->depth = record->depth;
+    m->reserved = 0;
+    memcpy(m->call_stack, record->call_stack, sizeof(m->call_stack));
+    mc_save_metrics(m, true);
+#endif /* USING_METRICS_COLLECTOR */
+
+#ifdef USING_FILE_LOGGER
+    /* full record, then log ring in write order */
+    logger = file_logger_init(CMB_RETM_FILE, CMB_RETM_FILE_MAX);
+    if (logger)
+    {
+        file_logger_write(logger, (void *)record, record->size);
+#ifdef RT_USING_ULOG
+        file_logger_write(logger, &cmb_retm_log.buf[record->log_wr], CMB_RETM_LOG_SIZE - record->log_wr);
+        if (record->log_wr)
+        {
+            file_logger_write_noheader(logger, cmb_retm_log.buf, record->log_wr);
+        }
+#endif
+        file_logger_close(logger);
+    }
+#endif /* USING_FILE_LOGGER */
+
+    cmb_retm_clear();
+
+    return 0;
+}
+
+#ifdef RT_USING_ULOG
+static struct ulog_backend cmb_retm_backend;
+
+static void cmb_retm_log_output(struct ulog_backend *backend, rt_uint32_t level, const char *tag, rt_bool_t is_raw,
+                                const char *log, size_t len)
+{
+    uint32_t wr, n;
+
+    if (cmb_retm_pending)
+    {
+        return;
+    }
+    /* only the tail is kept */
+    if (len > CMB_RETM_LOG_SIZE)
+    {
+        log += len - CMB_RETM_LOG_SIZE;
+        len = CMB_RETM_LOG_SIZE;
+    }
+    wr = cmb_retm_log.wr;
+    n = CMB_RETM_LOG_SIZE - wr;
+    if (n > len)
+    {
+        n = len;
+    }
+    memcpy(&cmb_retm_log.buf[wr], log, n);
+    memcpy(cmb_retm_log.buf, log + n, len - n);
+    wr += len;
+    if (wr >= CMB_RETM_LOG_SIZE)
+    {
+        wr -= CMB_RETM_LOG_SIZE;
+    }
+    cmb_retm_log.wr = wr;
+}
+#endif /* RT_USING_ULOG */
+
+static int cmb_retm_init(void)
+{
+    if (record_is_valid(&cmb_retm_record))
+    {
+        cmb_retm_pending = true;
+        cmb_retm_print(&cmb_retm_record);
+    }
+    else
+    {
+        cmb_retm_clear();
+    }
+
+#ifdef RT_USING_ULOG
+    if (cmb_retm_log.wr >= CMB_RETM_LOG_SIZE)
+    {
+        cmb_retm_log.wr = 0;
+    }
+    cmb_retm_backend.output = cmb_retm_log_output;
+    ulog_backend_register(&cmb_retm_backend, "cmb_retm", RT_FALSE);
+#endif
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(cmb_retm_init);
+
+#ifdef USING_METRICS_COLLECTOR
+/* record is uploaded in collector thread, file system is ready then */
+static int cmb_retm_collector_init(void)
+{
+    cmb_retm_collector.callback = cmb_retm_collect;
+    cmb_retm_collector.period = MC_PERIOD_EVERY_MINUTE;
+    cmb_retm_collector.user_data = 0;
+    RT_ASSERT(MC_OK == mc_register_collector(&cmb_retm_collector));
+
+    return 0;
+}
+INIT_APP_EXPORT(cmb_retm_collector_init);
+#endif /* USING_METRICS_COLLECTOR */
+
+#ifdef RT_USING_FINSH
+long cmb_retm(int argc, char **argv)
+{
+    if ((argc > 1) && !strcmp(argv[1], "upload"))
+    {
+        rt_kprintf("upload %s\n", cmb_retm_upload() ? "fail" : "done");
+    }
+    else if ((argc > 1) && !strcmp(argv[1], "clear"))
+    {
+        cmb_retm_clear();
+    }
+    else if (cmb_retm_pending)
+    {
+        cmb_retm_print(&cmb_retm_record);
+    }
+    else
+    {
+        rt_kprintf("no fault record, usage: cmb_retm [upload|clear]\n");
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(cmb_retm, show or upload fault record saved before reboot);
+#endif /* RT_USING_FINSH */
+
+#endif /* CMB_USING_RETM */
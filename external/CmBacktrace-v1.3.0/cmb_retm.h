@@ -0,0 +1,94 @@
+/*
+ * This file is part of the CmBacktrace Library.
+ *
+ * Function: Fault record kept in retention RAM. It's saved in fault handler without any print,
+ *           then decoded and uploaded on next boot.
+ */
+
+#ifndef _CMB_RETM_H_
+#define _CMB_RETM_H_
+
+#include "cmb_def.h"
+
+#ifdef CMB_USING_RETM
+
+#define CMB_RETM_MAGIC                 0x434D4252   /* "CMBR" */
+#define CMB_RETM_VERSION               1
+#define CMB_RETM_NAME_LEN              8
+
+#ifndef CMB_RETM_STACK_WORDS
+    #define CMB_RETM_STACK_WORDS       64
+#endif
+#ifndef CMB_RETM_THREAD_NUM
+    #define CMB_RETM_THREAD_NUM        16
+#endif
+#ifndef CMB_RETM_LOG_SIZE
+    #define CMB_RETM_LOG_SIZE          512
+#endif
+
+typedef struct
+{
+    char name[CMB_RETM_NAME_LEN];
+    uint32_t sp;
+    uint32_t stack_addr;
+    uint16_t stack_size;
+    uint8_t stat;
+    uint8_t priority;
+} cmb_retm_thread_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t size;                                  /* bytes from magic to end of stack words in use */
+    uint16_t version;
+    uint32_t checksum;                              /* word sum from tick to end of record */
+    uint32_t tick;
+    uint32_t regs[8];                               /* R0~R3, R12, LR, PC, PSR saved by exception */
+    uint32_t exc_return;
+    uint32_t sp;                                    /* stack pointer before exception */
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmar;
+    uint32_t bfar;
+    uint8_t on_thread;
+    uint8_t stack_overflow;
+    uint8_t depth;
+    uint8_t thread_num;
+    char thread[CMB_RETM_NAME_LEN];                 /* thread running at fault */
+    uint32_t call_stack[CMB_CALL_STACK_MAX_DEPTH];
+    cmb_retm_thread_t threads[CMB_RETM_THREAD_NUM];
+    uint16_t log_wr;                                /* write offset of log ring at fault */
+    uint16_t stack_words;
+    uint32_t stack[CMB_RETM_STACK_WORDS];           /* words from sp */
+} cmb_retm_record_t;
+
+/* save fault record, time consumed is mostly in call stack scan */
+void cm_backtrace_fault_save(uint32_t fault_handler_lr, uint32_t fault_handler_sp);
+
+/* port: get record to be filled with tick, thread list and log offset, called in fault handler */
+cmb_retm_record_t *cmb_retm_begin(void);
+
+/* port: seal record with checksum and magic */
+void cmb_retm_end(cmb_retm_record_t *record);
+
+/**
+ * get fault record saved before reboot
+ *
+ * @param log ring of recent log, could be NULL
+ * @param log_size size of log ring, 0 if log is not kept
+ *
+ * @return record, NULL if no valid record
+ */
+const cmb_retm_record_t *cmb_retm_get(const char **log, size_t *log_size);
+
+/* decode record to console */
+void cmb_retm_print(const cmb_retm_record_t *record);
+
+/* upload record by metrics collector and file logger, then clear it, return 0 if uploaded */
+int cmb_retm_upload(void);
+
+void cmb_retm_clear(void);
+
+#endif /* CMB_USING_RETM */
+
+#endif /* _CMB_RETM_H_ */
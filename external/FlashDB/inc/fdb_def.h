@@ -47,6 +47,27 @@ extern "C" {
 #define FDB_KV_USING_CACHE
 #endif
 
+/* the max entry number of KV hash index, each entry costs 8 bytes of heap.
+ * Index starts at FDB_KV_INDEX_INIT_SIZE entries and doubles as KV number grows.
+ * All KV in index make lookup O(1), otherwise it falls back to scan the sectors. 0: disable index */
+#ifndef FDB_KV_INDEX_MAX_SIZE
+#define FDB_KV_INDEX_MAX_SIZE          512
+#endif
+
+#ifndef FDB_KV_INDEX_INIT_SIZE
+#define FDB_KV_INDEX_INIT_SIZE         32
+#endif
+
+#if (FDB_KV_INDEX_MAX_SIZE > 0)
+#define FDB_KV_USING_INDEX
+#endif
+
+/* cache the start and end timestamp of each TSDB sector in RAM, fdb_tsl_iter_by_time
+ * binary searches the first sector instead of reading all sector headers */
+#ifndef FDB_TSDB_SEC_INDEX_DISABLE
+#define FDB_TSDB_USING_SEC_INDEX
+#endif
+
 #if defined(FDB_USING_FILE_LIBC_MODE) || defined(FDB_USING_FILE_POSIX_MODE)
 #define FDB_USING_FILE_MODE
 #endif
@@ -88,6 +109,7 @@ if (!(EXPR))                                                                  \
 #define FDB_KVDB_CTRL_SET_FILE_MODE    0x09             /**< set file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_MAX_SIZE     0x0A             /**< set database max size in file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_NOT_FORMAT   0x0B             /**< set database NOT format mode control command, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_INDEX_MAX    0x0C             /**< set max entry number of KV hash index, 0: disable index, this change MUST before database initialization */
 
 #define FDB_TSDB_CTRL_SET_SEC_SIZE     0x00             /**< set sector size control command, this change MUST before database initialization */
 #define FDB_TSDB_CTRL_GET_SEC_SIZE     0x01             /**< get sector size control command */
@@ -253,6 +275,13 @@ struct tsdb_sec_info {
 };
 typedef struct tsdb_sec_info *tsdb_sec_info_t;
 
+struct tsdb_sec_time {
+    fdb_time_t start_time;                       /**< the first node's timestamp */
+    fdb_time_t end_time;                         /**< the last node's timestamp */
+    uint8_t status;                              /**< sector store status @see fdb_sector_store_status_t */
+};
+typedef struct tsdb_sec_time *tsdb_sec_time_t;
+
 struct kv_cache_node {
     uint16_t name_crc;                           /**< KV name's CRC32 low 16bit value */
     uint16_t active;                             /**< KV node access active degree */
@@ -260,6 +289,12 @@ struct kv_cache_node {
 };
 typedef struct kv_cache_node *kv_cache_node_t;
 
+struct kv_index_node {
+    uint32_t name_hash;                          /**< KV name's CRC32 value */
+    uint32_t addr;                               /**< KV node address */
+};
+typedef struct kv_index_node *kv_index_node_t;
+
 struct sector_cache_node {
     uint32_t addr;                               /**< sector start address */
     uint32_t empty_addr;                         /**< sector empty address */
@@ -340,6 +375,17 @@ struct fdb_kvdb {
     
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+    /* KV hash index table, open addressing with linear probing */
+    struct kv_index_node *kv_index;
+    uint32_t kv_index_size;                      /**< entry number of table, power of 2 */
+    uint32_t kv_index_max;                       /**< max entry number, 0: FDB_KV_INDEX_MAX_SIZE */
+    uint32_t kv_index_live;                      /**< valid entry number */
+    uint32_t kv_index_used;                      /**< valid and deleted entry number */
+    bool kv_index_full;                          /**< some KV not in index */
+    bool kv_index_disable;
+#endif /* FDB_KV_USING_INDEX */
+
 #ifdef FDB_KV_AUTO_UPDATE
     uint32_t ver_num;                            /**< setting version number for update */
 #endif
@@ -356,6 +402,9 @@ struct fdb_tsdb {
     fdb_get_time get_time;                       /**< the current timestamp get function */
     size_t max_len;                              /**< the maximum length of each log */
     bool rollover;                               /**< the oldest data will rollover by newest data, default is true */
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    struct tsdb_sec_time *sec_time;              /**< timestamp of each sector, indexed by sector number */
+#endif
 
     void *user_data;
 };
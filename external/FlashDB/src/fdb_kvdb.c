@@ -333,6 +333,199 @@ static bool get_kv_from_cache(fdb_kvdb_t db, const char *name, size_t name_len,
 }
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+#ifndef FDB_KV_INDEX_MALLOC
+#define FDB_KV_INDEX_MALLOC(size)                rt_malloc(size)
+#define FDB_KV_INDEX_FREE(ptr)                   rt_free(ptr)
+#endif
+
+/* the index entry address value of unused and deleted entry, never a valid KV address */
+#define KV_INDEX_EMPTY                           0xFFFFFFFF
+#define KV_INDEX_DELETED                         0xFFFFFFFE
+
+typedef enum {
+    KV_INDEX_HIT,
+    KV_INDEX_MISS,                               /* the KV is surely not exist */
+    KV_INDEX_UNKNOWN,                            /* index is incomplete, need scan the sectors */
+} kv_index_result_t;
+
+/*
+ * Check the KV at addr has the name. The value CRC isn't checked here.
+ */
+static bool kv_index_name_match(fdb_kvdb_t db, uint32_t addr, const char *name, size_t name_len)
+{
+    struct kv_hdr_data kv_hdr;
+    uint32_t saved_name[(FDB_WG_ALIGN(FDB_KV_NAME_MAX) + 3) / 4];
+
+    _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+    if (kv_hdr.name_len != name_len || name_len > FDB_KV_NAME_MAX) {
+        return false;
+    }
+    _fdb_flash_read((fdb_db_t)db, addr + KV_HDR_DATA_SIZE, saved_name, FDB_WG_ALIGN(name_len));
+
+    return !memcmp(saved_name, name, name_len);
+}
+
+/*
+ * Rehash all valid entries to a new table, deleted entries are dropped.
+ */
+static bool kv_index_resize(fdb_kvdb_t db, uint32_t size)
+{
+    struct kv_index_node *table;
+    uint32_t i, j;
+
+    table = FDB_KV_INDEX_MALLOC(size * sizeof(struct kv_index_node));
+    if (!table) {
+        FDB_INFO("Warning: alloc KV index (%" PRIu32 ") failed.\n", size);
+        return false;
+    }
+    memset(table, 0xFF, size * sizeof(struct kv_index_node));
+
+    for (i = 0; i < db->kv_index_size; i++) {
+        if (db->kv_index[i].addr == KV_INDEX_EMPTY || db->kv_index[i].addr == KV_INDEX_DELETED) {
+            continue;
+        }
+        for (j = db->kv_index[i].name_hash & (size - 1); table[j].addr != KV_INDEX_EMPTY; j = (j + 1) & (size - 1));
+        table[j] = db->kv_index[i];
+    }
+
+    if (db->kv_index) {
+        FDB_KV_INDEX_FREE(db->kv_index);
+    }
+    db->kv_index = table;
+    db->kv_index_size = size;
+    db->kv_index_used = db->kv_index_live;
+
+    return true;
+}
+
+static void kv_index_reset(fdb_kvdb_t db)
+{
+    if (db->kv_index) {
+        memset(db->kv_index, 0xFF, db->kv_index_size * sizeof(struct kv_index_node));
+    }
+    db->kv_index_live = 0;
+    db->kv_index_used = 0;
+    db->kv_index_full = false;
+}
+
+/*
+ * Find the entry of KV name, return the entry position or -1.
+ */
+static int32_t kv_index_lookup(fdb_kvdb_t db, uint32_t name_hash, const char *name, size_t name_len)
+{
+    uint32_t i, n, mask = db->kv_index_size - 1;
+    kv_index_node_t node;
+
+    for (n = 0, i = name_hash & mask; n < db->kv_index_size; n++, i = (i + 1) & mask) {
+        node = &db->kv_index[i];
+        if (node->addr == KV_INDEX_EMPTY) {
+            break;
+        }
+        if (node->addr != KV_INDEX_DELETED && node->name_hash == name_hash
+                && kv_index_name_match(db, node->addr, name, name_len)) {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+static kv_index_result_t kv_index_find(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t *addr)
+{
+    int32_t pos;
+
+    if (!db->kv_index) {
+        return KV_INDEX_UNKNOWN;
+    }
+
+    pos = kv_index_lookup(db, fdb_calc_crc32(0, name, name_len), name, name_len);
+    if (pos >= 0) {
+        *addr = db->kv_index[pos].addr;
+        return KV_INDEX_HIT;
+    }
+
+    /* the index is being built when loading */
+    return (db->kv_index_full || db->in_recovery_check) ? KV_INDEX_UNKNOWN : KV_INDEX_MISS;
+}
+
+static void kv_index_update(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
+{
+    uint32_t i, size, mask, name_hash;
+    int32_t pos;
+
+    if (!db->kv_index) {
+        return;
+    }
+
+    name_hash = fdb_calc_crc32(0, name, name_len);
+    pos = kv_index_lookup(db, name_hash, name, name_len);
+    if (pos >= 0) {
+        db->kv_index[pos].addr = addr;
+        return;
+    }
+
+    /* keep the load factor under 3/4, grow when half of table is valid, otherwise just drop deleted entries */
+    if ((db->kv_index_used + 1) * 4 > db->kv_index_size * 3) {
+        size = db->kv_index_size;
+        if ((db->kv_index_live + 1) * 2 > size && size * 2 <= db->kv_index_max) {
+            size *= 2;
+        }
+        if ((db->kv_index_live + 1) * 4 > size * 3 || !kv_index_resize(db, size)) {
+            FDB_DEBUG("KV index is full, %" PRIu32 " entries.\n", db->kv_index_live);
+            db->kv_index_full = true;
+            return;
+        }
+    }
+
+    mask = db->kv_index_size - 1;
+    for (i = name_hash & mask; db->kv_index[i].addr != KV_INDEX_EMPTY && db->kv_index[i].addr != KV_INDEX_DELETED;
+            i = (i + 1) & mask);
+    if (db->kv_index[i].addr == KV_INDEX_EMPTY) {
+        db->kv_index_used++;
+    }
+    db->kv_index[i].name_hash = name_hash;
+    db->kv_index[i].addr = addr;
+    db->kv_index_live++;
+}
+
+static void kv_index_remove(fdb_kvdb_t db, const char *name, size_t name_len)
+{
+    int32_t pos;
+
+    if (!db->kv_index) {
+        return;
+    }
+
+    pos = kv_index_lookup(db, fdb_calc_crc32(0, name, name_len), name, name_len);
+    if (pos >= 0) {
+        db->kv_index[pos].addr = KV_INDEX_DELETED;
+        db->kv_index_live--;
+    }
+}
+
+static void kv_index_init(fdb_kvdb_t db)
+{
+    uint32_t size = FDB_KV_INDEX_INIT_SIZE;
+
+    db->kv_index = NULL;
+    db->kv_index_size = 0;
+    kv_index_reset(db);
+    if (db->kv_index_disable) {
+        return;
+    }
+    if (db->kv_index_max == 0) {
+        db->kv_index_max = FDB_KV_INDEX_MAX_SIZE;
+    }
+    while (size > db->kv_index_max) {
+        size >>= 1;
+    }
+    if (size >= 2) {
+        kv_index_resize(db, size);
+    }
+}
+#endif /* FDB_KV_USING_INDEX */
+
 /*
  * find the next KV address by magic word on the flash
  */
@@ -673,6 +866,21 @@ static bool find_kv(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
     bool find_ok = false;
     kv->crc_is_ok = true;
 
+#ifdef FDB_KV_USING_INDEX
+    switch (kv_index_find(db, key, strlen(key), &kv->addr.start)) {
+    case KV_INDEX_HIT:
+        if (read_kv(db, kv) == FDB_NO_ERR && kv->status == FDB_KV_WRITE) {
+            return true;
+        }
+        /* the entry is out of date, scan the sectors */
+        break;
+    case KV_INDEX_MISS:
+        return false;
+    default:
+        break;
+    }
+#endif /* FDB_KV_USING_INDEX */
+
 #ifdef FDB_KV_USING_CACHE
     size_t key_len = strlen(key);
 
@@ -690,6 +898,11 @@ static bool find_kv(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
             update_kv_cache(db, key, key_len, kv->addr.start);
         }
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+        if (find_ok) {
+            kv_index_update(db, key, strlen(key), kv->addr.start);
+        }
+#endif /* FDB_KV_USING_INDEX */
         //FDB_INFO("find_kv_no_cache: find_ok %d %d %s\n", find_ok, kv->name_len, kv->name);
     }
     if (!find_ok || !kv->crc_is_ok)
@@ -1105,6 +1318,13 @@ static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool co
                 update_kv_cache(db, old_kv->name, old_kv->name_len, FDB_DATA_UNUSED);
             }
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+            if (key != NULL) {
+                kv_index_remove(db, key, strlen(key));
+            } else {
+                kv_index_remove(db, old_kv->name, old_kv->name_len);
+            }
+#endif /* FDB_KV_USING_INDEX */
         }
 
         db->last_is_complete_del = false;
@@ -1184,6 +1404,9 @@ static fdb_err_t move_kv(fdb_kvdb_t db, fdb_kv_t kv)
                 kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv->name_len) + FDB_WG_ALIGN(kv->value_len));
         update_kv_cache(db, kv->name, kv->name_len, kv_addr);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+        kv_index_update(db, kv->name, kv->name_len, kv_addr);
+#endif /* FDB_KV_USING_INDEX */
     }
 
     FDB_DEBUG("Moved the KV (%.*s) from 0x%08" PRIX32 " to 0x%08" PRIX32 ".\n", kv->name_len, kv->name, kv->addr.start, kv_addr);
@@ -1407,6 +1630,9 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
             }
             update_kv_cache(db, key, kv_hdr.name_len, kv_addr);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+            kv_index_update(db, key, kv_hdr.name_len, kv_addr);
+#endif /* FDB_KV_USING_INDEX */
         }
         /* write value */
         if (result == FDB_NO_ERR) {
@@ -1569,6 +1795,9 @@ static fdb_err_t fdb_kv_set_default_notlock(fdb_kvdb_t db)
             goto __exit;
         }
     }
+#ifdef FDB_KV_USING_INDEX
+    kv_index_reset(db);
+#endif
     /* create default KV */
     for (i = 0; i < db->default_kvs.num; i++)
     {
@@ -1660,6 +1889,9 @@ fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
             goto __exit;
         }
     }
+#ifdef FDB_KV_USING_INDEX
+    kv_index_reset(db);
+#endif
     /* create default KV */
     for (i = 0; i < db->default_kvs.num; i++) {
         /* It seems to be a string when value length is 0.
@@ -1757,6 +1989,10 @@ void fdb_kv_print(fdb_kvdb_t db)
     FDB_PRINT("\nmode: next generation\n");
     FDB_PRINT("size: %" PRIu32 "/%" PRIu32 " bytes.\n", (uint32_t)using_size + ((SECTOR_NUM - FDB_GC_EMPTY_SEC_THRESHOLD) * SECTOR_HDR_DATA_SIZE),
             db_max_size(db) - db_sec_size(db) * FDB_GC_EMPTY_SEC_THRESHOLD);
+#ifdef FDB_KV_USING_INDEX
+    FDB_PRINT("index: %" PRIu32 "/%" PRIu32 " entries%s.\n", db->kv_index_live, db->kv_index_size,
+            db->kv_index_full ? ", full" : "");
+#endif
 
     /* unlock the KV cache */
     db_unlock(db);
@@ -1872,6 +2108,10 @@ static bool check_and_recovery_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
 #ifdef FDB_KV_USING_CACHE
         /* update the cache when first load. If caching is disabled, this step is not performed */
         update_kv_cache(db, kv->name, kv->name_len, kv->addr.start);
+#endif
+#ifdef FDB_KV_USING_INDEX
+        /* build the index when first load */
+        kv_index_update(db, kv->name, kv->name_len, kv->addr.start);
 #endif
     }
 
@@ -1909,6 +2149,10 @@ fdb_err_t _fdb_kv_load(fdb_kvdb_t db)
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, check_and_recovery_gc_cb, false);
 
 __retry:
+#ifdef FDB_KV_USING_INDEX
+    /* rebuild the index on every pass, entries of collected sectors are dropped */
+    kv_index_reset(db);
+#endif
     /* check all KV for recovery */
     kv_iterator(db, &kv, db, NULL, check_and_recovery_kv_cb);
     if (db->gc_request) {
@@ -1986,6 +2230,14 @@ void fdb_kvdb_control(fdb_kvdb_t db, int cmd, void *arg)
         FDB_ASSERT(db->parent.init_ok == false);
         db->parent.not_formatable = *(bool *)arg;
         break;
+    case FDB_KVDB_CTRL_SET_INDEX_MAX:
+#ifdef FDB_KV_USING_INDEX
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->kv_index_max = *(uint32_t *)arg;
+        db->kv_index_disable = (db->kv_index_max == 0);
+#endif
+        break;
     }
 }
 
@@ -2079,6 +2331,10 @@ fdb_err_t fdb_kvdb_init(fdb_kvdb_t db, const char *name, const char *path, struc
 
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+    kv_index_init(db);
+#endif
+
     FDB_DEBUG("KVDB size is %" PRIu32 " bytes.\n", db_max_size(db));
 
     result = _fdb_kv_load(db);
@@ -2107,6 +2363,14 @@ fdb_err_t fdb_kvdb_deinit(fdb_kvdb_t db)
 {
     _fdb_deinit((fdb_db_t) db);
 
+#ifdef FDB_KV_USING_INDEX
+    if (db->kv_index) {
+        FDB_KV_INDEX_FREE(db->kv_index);
+        db->kv_index = NULL;
+        db->kv_index_size = 0;
+    }
+#endif
+
     return FDB_NO_ERR;
 }
 
@@ -130,6 +130,104 @@ static fdb_err_t read_tsl(fdb_tsdb_t db, fdb_tsl_t tsl)
     return FDB_NO_ERR;
 }
 
+#ifdef FDB_TSDB_USING_SEC_INDEX
+#ifndef FDB_TSDB_SEC_INDEX_MALLOC
+#define FDB_TSDB_SEC_INDEX_MALLOC(size)          rt_malloc(size)
+#define FDB_TSDB_SEC_INDEX_FREE(ptr)             rt_free(ptr)
+#endif
+
+#define SECTOR_NUM                               (db_max_size(db) / db_sec_size(db))
+
+static void sec_index_update(fdb_tsdb_t db, tsdb_sec_info_t sector)
+{
+    tsdb_sec_time_t node;
+
+    if (!db->sec_time) {
+        return;
+    }
+
+    node = &db->sec_time[sector->addr / db_sec_size(db)];
+    node->status = sector->check_ok ? sector->status : FDB_SECTOR_STORE_UNUSED;
+    node->start_time = sector->start_time;
+    node->end_time = sector->end_time;
+}
+
+static void sec_index_reset(fdb_tsdb_t db)
+{
+    uint32_t i;
+
+    if (!db->sec_time) {
+        return;
+    }
+
+    for (i = 0; i < SECTOR_NUM; i++) {
+        db->sec_time[i].status = FDB_SECTOR_STORE_EMPTY;
+    }
+}
+
+/*
+ * Find the first sector to iterate from the oldest (from <= to) or the newest (from > to) sector.
+ * All sectors between the oldest and the current using sector hold TSL in time order.
+ *
+ * @return false if no TSL in range, sec_addr and traversed_len are unchanged if index is unavailable
+ */
+static bool sec_index_seek(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, uint32_t *sec_addr, uint32_t *traversed_len)
+{
+    uint32_t oldest, num, lo, hi, mid, i, pos;
+    tsdb_sec_time_t node;
+
+    if (!db->sec_time) {
+        return true;
+    }
+
+    oldest = db_oldest_addr(db) / db_sec_size(db);
+    num = (db->cur_sec.addr / db_sec_size(db) + SECTOR_NUM - oldest) % SECTOR_NUM + 1;
+    if (db->cur_sec.status == FDB_SECTOR_STORE_EMPTY) {
+        num--;
+    }
+
+    lo = 0;
+    hi = num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        node = &db->sec_time[(oldest + mid) % SECTOR_NUM];
+        if (node->status != FDB_SECTOR_STORE_USING && node->status != FDB_SECTOR_STORE_FULL) {
+            /* broken sector, let the iterator skip it */
+            return true;
+        }
+        if ((from <= to) ? (node->end_time < from) : (node->start_time <= from)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (from <= to) {
+        /* lo is the first sector which end time >= from */
+        if (lo == num) {
+            return false;
+        }
+        i = lo;
+        pos = lo;
+    } else {
+        /* lo - 1 is the last sector which start time <= from */
+        if (lo == 0) {
+            return false;
+        }
+        i = lo - 1;
+        pos = num - lo;
+        if (db->cur_sec.status == FDB_SECTOR_STORE_EMPTY) {
+            pos++;
+        }
+    }
+
+    *sec_addr = ((oldest + i) % SECTOR_NUM) * db_sec_size(db);
+    *traversed_len = pos * db_sec_size(db);
+
+    return true;
+}
+#endif /* FDB_TSDB_USING_SEC_INDEX */
+
 static uint32_t get_next_sector_addr(fdb_tsdb_t db, tsdb_sec_info_t pre_sec, uint32_t traversed_len)
 {
     if (traversed_len + db_sec_size(db) <= db_max_size(db)) {
@@ -343,6 +441,10 @@ static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_bl
         /* change current sector to full */
         _FDB_WRITE_STATUS(db, cur_sec_addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_FULL, true);
         sector->status = FDB_SECTOR_STORE_FULL;
+#ifdef FDB_TSDB_USING_SEC_INDEX
+        sector->end_time = db->last_time;
+        sec_index_update(db, sector);
+#endif
         /* calculate next sector address */
         if (sector->addr + db_sec_size(db) < db_max_size(db)) {
             new_sec_addr = sector->addr + db_sec_size(db);
@@ -363,6 +465,9 @@ static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_bl
             }
             format_sector(db, new_sec_addr);
             read_sector_info(db, new_sec_addr, &db->cur_sec, false);
+#ifdef FDB_TSDB_USING_SEC_INDEX
+            sec_index_update(db, &db->cur_sec);
+#endif
         }
     } else if (sector->status == FDB_SECTOR_STORE_FULL) {
         /* database full */
@@ -376,6 +481,10 @@ static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_bl
         _FDB_WRITE_STATUS(db, sector->addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_USING, true);
         /* save the start timestamp */
         FLASH_WRITE(db, sector->addr + SECTOR_START_TIME_OFFSET, (uint32_t *)&cur_time, sizeof(fdb_time_t), true);
+#ifdef FDB_TSDB_USING_SEC_INDEX
+        sector->end_time = cur_time;
+        sec_index_update(db, sector);
+#endif
     }
 
     return result;
@@ -413,6 +522,11 @@ static fdb_err_t tsl_append(fdb_tsdb_t db, fdb_blob_t blob)
     db->cur_sec.empty_data -= FDB_WG_ALIGN(blob->size);
     db->cur_sec.remain -= LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(blob->size);
     db->last_time = cur_time;
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    if (db->sec_time) {
+        db->sec_time[db->cur_sec.addr / db_sec_size(db)].end_time = cur_time;
+    }
+#endif
 
     return result;
 }
@@ -616,6 +730,13 @@ void fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl
 
     sec_addr = start_addr;
     db_lock(db);
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    /* skip the sectors out of range */
+    if (!sec_index_seek(db, from, to, &sec_addr, &traversed_len)) {
+        goto __exit;
+    }
+    start_addr = sec_addr;
+#endif
     /* search all sectors */
     do {
         traversed_len += db_sec_size(db);
@@ -745,7 +866,11 @@ static bool check_sec_hdr_cb(tsdb_sec_info_t sector, void *arg1, void *arg2)
         FDB_INFO("Sector (0x%08" PRIX32 ") header info is incorrect.\n", sector->addr);
         (arg->check_failed) = true;
         return true;
-    } else if (sector->status == FDB_SECTOR_STORE_USING) {
+    }
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    sec_index_update(db, sector);
+#endif
+    if (sector->status == FDB_SECTOR_STORE_USING) {
         if (db->cur_sec.addr == FDB_DATA_UNUSED) {
             memcpy(&db->cur_sec, sector, sizeof(struct tsdb_sec_info));
         } else {
@@ -778,6 +903,9 @@ static void tsl_format_all(fdb_tsdb_t db)
 
     sector.addr = 0;
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, format_all_cb, false);
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    sec_index_reset(db);
+#endif
     db_oldest_addr(db) = 0;
     db->cur_sec.addr = 0;
     db->last_time = 0;
@@ -910,6 +1038,15 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
     /* must less than sector size */
     FDB_ASSERT(max_len < db_sec_size(db));
 
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    /* filled by sector header check, a failed allocation only slows down iteration by time */
+    db->sec_time = FDB_TSDB_SEC_INDEX_MALLOC(SECTOR_NUM * sizeof(struct tsdb_sec_time));
+    if (!db->sec_time) {
+        FDB_INFO("Warning: alloc sector time index failed.\n");
+    }
+    sec_index_reset(db);
+#endif
+
     /* check all sector header */
     sector.addr = 0;
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &check_sec_arg, NULL, check_sec_hdr_cb, true);
@@ -960,6 +1097,9 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
         read_sector_info(db, addr, &sec, false);
         db->last_time = sec.end_time;
     }
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    sec_index_update(db, &db->cur_sec);
+#endif
 
 __exit:
 
@@ -979,6 +1119,13 @@ fdb_err_t fdb_tsdb_deinit(fdb_tsdb_t db)
 {
     _fdb_deinit((fdb_db_t) db);
 
+#ifdef FDB_TSDB_USING_SEC_INDEX
+    if (db->sec_time) {
+        FDB_TSDB_SEC_INDEX_FREE(db->sec_time);
+        db->sec_time = NULL;
+    }
+#endif
+
     return FDB_NO_ERR;
 }
 
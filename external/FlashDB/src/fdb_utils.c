@@ -15,6 +15,9 @@
 #include <string.h>
 #include <flashdb.h>
 #include <fdb_low_lvl.h>
+#ifdef BSP_USING_HW_CRC
+#include "drv_crc.h"
+#endif
 
 #define FDB_LOG_TAG "[utils]"
 
@@ -76,6 +79,9 @@ static const uint32_t crc32_table[] =
  */
 uint32_t fdb_calc_crc32(uint32_t crc, const void *buf, size_t size)
 {
+#ifdef BSP_USING_HW_CRC
+    return drv_crc_accumulate(CRC_32, crc ^ ~0U, buf, size) ^ ~0U;
+#else
     const uint8_t *p;
 
     p = (const uint8_t *)buf;
@@ -86,6 +92,7 @@ uint32_t fdb_calc_crc32(uint32_t crc, const void *buf, size_t size)
     }
 
     return crc ^ ~0U;
+#endif
 }
 
 size_t _fdb_set_status(uint8_t status_table[], size_t status_num, size_t status_index)
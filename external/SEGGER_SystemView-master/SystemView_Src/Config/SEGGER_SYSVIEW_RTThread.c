@@ -51,6 +51,8 @@ Revision: $Rev: 3745 $
 #include "rtthread.h"
 #include "SEGGER_SYSVIEW.h"
 #include "SEGGER_RTT.h"
+#include "SEGGER_SYSVIEW_RTThread.h"
+#include "sysview_trace.h"
 
 #if !((RTT_VERSION * 100 + RTT_SUBVERSION * 10 + RTT_REVISION) > 310L)
     #error "This version SystemView only supports above 3.1.0 of RT-Thread, please select a lower version SystemView!"
@@ -399,6 +401,9 @@ static int rt_trace_init(void)
     tidle = rt_thread_idle_gethandler();
 
     SEGGER_SYSVIEW_Conf();
+#if SYSVIEW_TRACE_MASK
+    sysview_trace_register();
+#endif
 
     // register hooks
     //rt_object_attach_sethook(_cb_object_attach);
@@ -72,6 +72,8 @@ Revision: $Rev: 3735 $
 #else
 	#define SYSVIEW_EVENTID_OFFSET     (32u)
 #endif
+
+void sysview_trace_register(void);
 #endif
 
 /*************************** End of file ****************************/
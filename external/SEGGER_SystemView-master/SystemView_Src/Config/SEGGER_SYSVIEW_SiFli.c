@@ -0,0 +1,253 @@
+/**
+  ******************************************************************************
+  * @file   SEGGER_SYSVIEW_SiFli.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <string.h>
+#include "SEGGER_SYSVIEW.h"
+#include "SEGGER_RTT.h"
+#include "sysview_trace.h"
+
+/* Trace points ------------------------------------------------------------------------------*/
+static SEGGER_SYSVIEW_MODULE sifli_module =
+{
+    "M=SiFli, 0 DMA ch=%u, 1 LCDC, 2 EPIC, 3 EZIP, 4 AUDPRC dma=%u, 5 Mailbox mb=%x,"
+    " 6 ipc_queue_write q=%u len=%u, 7 ipc_queue_read q=%u len=%u, 8 DataService svc=%u msg=%u,"
+    " 9 AudioServer evt=%x",
+    SYSVIEW_TRACE_NUM,
+    0,
+    NULL,
+    NULL
+};
+
+#if SYSVIEW_TRACE_MASK
+void sysview_trace_enter(uint32_t id, uint32_t p0, uint32_t p1)
+{
+    SEGGER_SYSVIEW_RecordU32x2(sifli_module.EventOffset + id, p0, p1);
+}
+
+void sysview_trace_exit(uint32_t id)
+{
+    SEGGER_SYSVIEW_RecordEndCall(sifli_module.EventOffset + id);
+}
+#endif /* SYSVIEW_TRACE_MASK */
+
+/* Called after SEGGER_SYSVIEW_Conf() */
+void sysview_trace_register(void)
+{
+    SEGGER_SYSVIEW_RegisterModule(&sifli_module);
+}
+
+/* UART streaming ----------------------------------------------------------------------------*/
+#ifdef PKG_SYSVIEW_USING_UART
+/*
+    SystemView UART recording for devices without J-Link.
+    RTT up buffer of SystemView is drained to UART by DMA, bytes from host are put into
+    RTT down buffer, so SystemView core works as with J-Link.
+*/
+#ifndef PKG_SYSVIEW_UART_NAME
+    #define PKG_SYSVIEW_UART_NAME       "uart2"
+#endif
+#ifndef PKG_SYSVIEW_UART_BAUD
+    #define PKG_SYSVIEW_UART_BAUD       (1000000)
+#endif
+#ifndef PKG_SYSVIEW_UART_CHUNK
+    #define PKG_SYSVIEW_UART_CHUNK      (512)
+#endif
+#ifndef PKG_SYSVIEW_UART_POLL_MS
+    #define PKG_SYSVIEW_UART_POLL_MS    (5)
+#endif
+
+#define SV_HELLO_SIZE   (4)
+
+static const U8 sv_hello[SV_HELLO_SIZE] = {'S', 'V', (SEGGER_SYSVIEW_VERSION / 10000), (SEGGER_SYSVIEW_VERSION / 1000) % 10};
+static rt_device_t sv_uart;
+static struct rt_semaphore sv_rx_sem;
+static struct rt_semaphore sv_tx_sem;
+static int sv_channel = -1;
+static uint8_t sv_hello_rcvd;
+ALIGN(4) static U8 sv_tx_buf[PKG_SYSVIEW_UART_CHUNK];
+
+/* Only reader of up buffer, SystemView core only moves WrOff */
+static unsigned sv_read_up(U8 *buf, unsigned size)
+{
+    SEGGER_RTT_BUFFER_UP *ring = &_SEGGER_RTT.aUp[sv_channel];
+    unsigned rd = ring->RdOff;
+    unsigned wr = ring->WrOff;
+    unsigned n = 0, len;
+
+    if (wr < rd)
+    {
+        len = ring->SizeOfBuffer - rd;
+        if (len > size)
+            len = size;
+        memcpy(buf, ring->pBuffer + rd, len);
+        n = len;
+        rd += len;
+        if (rd == ring->SizeOfBuffer)
+            rd = 0;
+    }
+    if (n < size && wr > rd)
+    {
+        len = wr - rd;
+        if (len > size - n)
+            len = size - n;
+        memcpy(buf + n, ring->pBuffer + rd, len);
+        n += len;
+        rd += len;
+    }
+    ring->RdOff = rd;
+
+    return n;
+}
+
+/* Only writer of down buffer, bytes are dropped if it's full */
+static void sv_write_down(const U8 *buf, unsigned size)
+{
+    SEGGER_RTT_BUFFER_DOWN *ring = &_SEGGER_RTT.aDown[sv_channel];
+    unsigned wr = ring->WrOff;
+    unsigned next;
+
+    while (size--)
+    {
+        next = wr + 1 == ring->SizeOfBuffer ? 0 : wr + 1;
+        if (next == ring->RdOff)
+            break;
+        ring->pBuffer[wr] = *buf++;
+        wr = next;
+    }
+    ring->WrOff = wr;
+}
+
+static rt_err_t sv_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    rt_sem_release(&sv_rx_sem);
+    return RT_EOK;
+}
+
+static rt_err_t sv_tx_done(rt_device_t dev, void *buffer)
+{
+    rt_sem_release(&sv_tx_sem);
+    return RT_EOK;
+}
+
+static void sv_send(const U8 *buf, rt_size_t len)
+{
+    rt_device_write(sv_uart, 0, buf, len);
+    /* DMA reads buffer until done */
+    if (sv_uart->open_flag & RT_DEVICE_FLAG_DMA_TX)
+        rt_sem_take(&sv_tx_sem, RT_WAITING_FOREVER);
+}
+
+static void sv_uart_entry(void *param)
+{
+    U8 rx[16];
+    rt_size_t n, k;
+
+    while (1)
+    {
+        while ((n = rt_device_read(sv_uart, 0, rx, sizeof(rx))) > 0)
+        {
+            /* hello from host again, it's reconnected */
+            if (n >= 2 && 'S' == rx[0] && 'V' == rx[1])
+            {
+                sv_hello_rcvd = 0;
+                sv_send(sv_hello, SV_HELLO_SIZE);
+            }
+            k = SV_HELLO_SIZE - sv_hello_rcvd;
+            if (k > n)
+                k = n;
+            sv_hello_rcvd += k;
+            sv_write_down(rx + k, n - k);
+        }
+
+        n = sv_read_up(sv_tx_buf, sizeof(sv_tx_buf));
+        if (n)
+            sv_send(sv_tx_buf, n);
+        else
+            rt_sem_take(&sv_rx_sem, rt_tick_from_millisecond(PKG_SYSVIEW_UART_POLL_MS));
+    }
+}
+
+static int sysview_uart_init(void)
+{
+    struct serial_configure cfg = RT_SERIAL_CONFIG_DEFAULT;
+    rt_uint16_t flag = RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX;
+    rt_thread_t tid;
+    int i;
+
+    for (i = 0; i < SEGGER_RTT_MAX_NUM_UP_BUFFERS; i++)
+        if (_SEGGER_RTT.aUp[i].sName && 0 == strcmp(_SEGGER_RTT.aUp[i].sName, "SysView"))
+            sv_channel = i;
+    sv_uart = rt_device_find(PKG_SYSVIEW_UART_NAME);
+    if (sv_channel < 0 || RT_NULL == sv_uart)
+    {
+        rt_kprintf("SystemView UART %s not available\n", PKG_SYSVIEW_UART_NAME);
+        return -RT_ERROR;
+    }
+
+    rt_sem_init(&sv_rx_sem, "sv_rx", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&sv_tx_sem, "sv_tx", 0, RT_IPC_FLAG_FIFO);
+    if (sv_uart->flag & RT_DEVICE_FLAG_DMA_TX)
+        flag |= RT_DEVICE_FLAG_DMA_TX;
+    if (RT_EOK != rt_device_open(sv_uart, flag))
+        return -RT_ERROR;
+    cfg.baud_rate = PKG_SYSVIEW_UART_BAUD;
+    rt_device_control(sv_uart, RT_DEVICE_CTRL_CONFIG, &cfg);
+    rt_device_set_rx_indicate(sv_uart, sv_rx_ind);
+    rt_device_set_tx_complete(sv_uart, sv_tx_done);
+
+    tid = rt_thread_create("sysview", sv_uart_entry, RT_NULL, 1024, RT_THREAD_PRIORITY_LOW, 10);
+    RT_ASSERT(tid);
+    rt_thread_startup(tid);
+    sv_send(sv_hello, SV_HELLO_SIZE);
+
+    return 0;
+}
+INIT_APP_EXPORT(sysview_uart_init);
+#endif /* PKG_SYSVIEW_USING_UART */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -34,6 +34,29 @@ typedef struct
 }fft_env_t;
 #endif
 
+// Backend doing the transforms of one RealFFT instance. Sharing the CCS
+// layout and inverse scale convention documented below, a backend may run
+// in software, CMSIS-DSP or the FFT accelerator.
+typedef struct
+{
+    const char* name;
+    int (*forward)(struct RealFFT* self,
+                   const int16_t* real_data_in,
+                   int16_t* complex_data_out);
+    int (*inverse)(struct RealFFT* self,
+                   const int16_t* complex_data_in,
+                   int16_t* real_data_out);
+} WebRtcSpl_FFTProvider;
+
+// Returns the backend used by WebRtcSpl_CreateRealFFT() for |order|: the one
+// set by WebRtcSpl_SetFFTProvider(), else the FFT_USING_xxx build choice,
+// else software when the order is out of the accelerator range.
+const WebRtcSpl_FFTProvider* WebRtcSpl_DefaultFFTProvider(int order);
+
+// Overrides the backend for RealFFT instances created afterwards,
+// NULL restores the build default. Existing instances are unaffected.
+void WebRtcSpl_SetFFTProvider(const WebRtcSpl_FFTProvider* provider);
+
 struct RealFFT* WebRtcSpl_CreateRealFFT(int order);
 void WebRtcSpl_FreeRealFFT(struct RealFFT* self);
 
@@ -29,6 +29,8 @@
 struct RealFFT
 {
     int order;
+    // Chosen at creation, so the scaling stays the same for its lifetime.
+    const WebRtcSpl_FFTProvider *provider;
 #ifdef AUDIO_MEM_ALLOC
     int16_t *complex_buf;
     uint8_t fft_busy;
@@ -51,6 +53,7 @@ struct RealFFT *WebRtcSpl_CreateRealFFT(int order)
         return NULL;
     }
     self->order = order;
+    self->provider = WebRtcSpl_DefaultFFTProvider(order);
 #ifdef AUDIO_MEM_ALLOC
     self->fft_busy = 0;
     self->complex_buf = (int16_t *)malloc((2 << kMaxFFTOrder) * sizeof(int16_t));
@@ -73,22 +76,9 @@ void WebRtcSpl_FreeRealFFT(struct RealFFT *self)
 // The C version FFT functions (i.e. WebRtcSpl_RealForwardFFT and
 // WebRtcSpl_RealInverseFFT) are real-valued FFT wrappers for complex-valued
 // FFT implementation in SPL.
-#ifdef FFT_USING_CMSIS_DSP
-const arm_cfft_instance_q15 *const cmsis_cfft_instance_table_q15[7] =
-{
-    &arm_cfft_sR_q15_len16,
-    &arm_cfft_sR_q15_len32,
-    &arm_cfft_sR_q15_len64,
-    &arm_cfft_sR_q15_len128,
-    &arm_cfft_sR_q15_len256,
-    &arm_cfft_sR_q15_len512,
-    &arm_cfft_sR_q15_len1024,
-    //&arm_cfft_sR_q15_len2048,
-    //&arm_cfft_sR_q15_len4096,
-};
-int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
-                             const int16_t *real_data_in,
-                             int16_t *complex_data_out)
+static int SoftRealForwardFFT(struct RealFFT *self,
+                              const int16_t *real_data_in,
+                              int16_t *complex_data_out)
 {
     int i = 0;
     int j = 0;
@@ -96,9 +86,6 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
     int n = 1 << self->order;
     // The complex-value FFT implementation needs a buffer to hold 2^order
     // 16-bit COMPLEX numbers, for both time and frequency data.
-
-    rt_uint32_t evt;
-
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         int16_t *complex_buffer = malloc((2 << kMaxFFTOrder) * 2);
@@ -111,8 +98,6 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
 #else
     int16_t complex_buffer[2 << kMaxFFTOrder];
 #endif
-
-
     // Insert zeros to the imaginary parts for complex forward FFT input.
     for (i = 0, j = 0; i < n; i += 1, j += 2)
     {
@@ -120,15 +105,12 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
         complex_buffer[j + 1] = 0;
     };
 
-    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    //result = WebRtcSpl_ComplexFFT(complex_buffer, self->order, 1);
-
-    arm_cfft_q15(cmsis_cfft_instance_table_q15[self->order - 4], (q15_t *)complex_buffer, 0, 1);
+    WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
+    result = WebRtcSpl_ComplexFFT(complex_buffer, self->order, 1);
 
-    // For real FFT output, use only the first N + 2 elements;
+    // For real FFT output, use only the first N + 2 elements from
     // complex forward FFT.
     memcpy(complex_data_out, complex_buffer, sizeof(int16_t) * (n + 2));
-
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         free(complex_buffer);
@@ -136,52 +118,18 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
         self->fft_busy = 0;
     #endif
 #endif
-
-
     return result;
 }
-int scale_calculate(const int16_t *complex_data_in, int n)
-{
-    int scale;
-    int tmp16;
-
-    tmp16 = WebRtcSpl_MaxAbsValueW16(complex_data_in, 2 * n);
 
-    if (tmp16 > 16383)      //2^14 - 1
-        scale = 0;
-    else if (tmp16 > 8191)      //2^13 - 1
-        scale = 1;
-    else if (tmp16 > 4095)      //2^12 - 1
-        scale = 2;
-    else if (tmp16 > 2047)      //2^11 - 1
-        scale = 3;
-    else if (tmp16 > 1023)      //2^10 - 1
-        scale = 4;
-    else if (tmp16 > 511)   //2^9 - 1
-        scale = 5;
-    else if (tmp16 > 255)   //2^8 - 1
-        scale = 6;
-    else if (tmp16 > 127)   //2^7 - 1
-        scale = 7;
-    else
-        scale = 8;
-
-    return scale;
-}
-int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
-                             const int16_t *complex_data_in,
-                             int16_t *real_data_out)
+static int SoftRealInverseFFT(struct RealFFT *self,
+                              const int16_t *complex_data_in,
+                              int16_t *real_data_out)
 {
     int i = 0;
     int j = 0;
     int result = 0;
     int n = 1 << self->order;
     // Create the buffer specific to complex-valued FFT implementation.
-
-    rt_uint32_t evt;
-    int scale = 0;
-
-    scale = scale_calculate(complex_data_in, n);
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         int16_t *complex_buffer = malloc((2 << kMaxFFTOrder) * 2);
@@ -194,33 +142,24 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
 #else
     int16_t complex_buffer[2 << kMaxFFTOrder];
 #endif
-
     // For n-point FFT, first copy the first n + 2 elements into complex
     // FFT, then construct the remaining n - 2 elements by real FFT's
     // conjugate-symmetric properties.
     memcpy(complex_buffer, complex_data_in, sizeof(int16_t) * (n + 2));
-
-    for (i = 0; i < n + 2; i++)
-    {
-        complex_buffer[i] <<= scale;
-    }
     for (i = n + 2; i < 2 * n; i += 2)
     {
-        complex_buffer[i] = complex_data_in[2 * n - i] << scale;
-        complex_buffer[i + 1] = -complex_data_in[2 * n - i + 1] << scale;
+        complex_buffer[i] = complex_data_in[2 * n - i];
+        complex_buffer[i + 1] = -complex_data_in[2 * n - i + 1];
     }
 
-    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    //result = WebRtcSpl_ComplexIFFT(complex_buffer, self->order, 1);
-    arm_cfft_q15(cmsis_cfft_instance_table_q15[self->order - 4], (q15_t *)complex_buffer, 1, 1);
-    result = self->order - scale;
+    WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
+    result = WebRtcSpl_ComplexIFFT(complex_buffer, self->order, 1);
 
     // Strip out the imaginary parts of the complex inverse FFT output.
     for (i = 0, j = 0; i < n; i += 1, j += 2)
     {
         real_data_out[i] = complex_buffer[j];
     }
-
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         free(complex_buffer);
@@ -228,14 +167,56 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
         self->fft_busy = 0;
     #endif
 #endif
-
     return result;
 }
-#else
-#ifndef FFT_USING_ONCHIP
-int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
-                             const int16_t *real_data_in,
-                             int16_t *complex_data_out)
+
+#if defined(FFT_USING_CMSIS_DSP) || defined(FFT_USING_ONCHIP)
+static int scale_calculate(const int16_t *complex_data_in, int n)
+{
+    int scale;
+    int tmp16;
+
+    tmp16 = WebRtcSpl_MaxAbsValueW16(complex_data_in, 2 * n);
+
+    if (tmp16 > 16383)      //2^14 - 1
+        scale = 0;
+    else if (tmp16 > 8191)      //2^13 - 1
+        scale = 1;
+    else if (tmp16 > 4095)      //2^12 - 1
+        scale = 2;
+    else if (tmp16 > 2047)      //2^11 - 1
+        scale = 3;
+    else if (tmp16 > 1023)      //2^10 - 1
+        scale = 4;
+    else if (tmp16 > 511)   //2^9 - 1
+        scale = 5;
+    else if (tmp16 > 255)   //2^8 - 1
+        scale = 6;
+    else if (tmp16 > 127)   //2^7 - 1
+        scale = 7;
+    else
+        scale = 8;
+
+    return scale;
+}
+#endif
+
+#ifdef FFT_USING_CMSIS_DSP
+const arm_cfft_instance_q15 *const cmsis_cfft_instance_table_q15[7] =
+{
+    &arm_cfft_sR_q15_len16,
+    &arm_cfft_sR_q15_len32,
+    &arm_cfft_sR_q15_len64,
+    &arm_cfft_sR_q15_len128,
+    &arm_cfft_sR_q15_len256,
+    &arm_cfft_sR_q15_len512,
+    &arm_cfft_sR_q15_len1024,
+    //&arm_cfft_sR_q15_len2048,
+    //&arm_cfft_sR_q15_len4096,
+};
+static int CmsisRealForwardFFT(struct RealFFT *self,
+                               const int16_t *real_data_in,
+                               int16_t *complex_data_out)
 {
     int i = 0;
     int j = 0;
@@ -243,6 +224,9 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
     int n = 1 << self->order;
     // The complex-value FFT implementation needs a buffer to hold 2^order
     // 16-bit COMPLEX numbers, for both time and frequency data.
+
+    rt_uint32_t evt;
+
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         int16_t *complex_buffer = malloc((2 << kMaxFFTOrder) * 2);
@@ -255,6 +239,8 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
 #else
     int16_t complex_buffer[2 << kMaxFFTOrder];
 #endif
+
+
     // Insert zeros to the imaginary parts for complex forward FFT input.
     for (i = 0, j = 0; i < n; i += 1, j += 2)
     {
@@ -262,12 +248,15 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
         complex_buffer[j + 1] = 0;
     };
 
-    WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    result = WebRtcSpl_ComplexFFT(complex_buffer, self->order, 1);
+    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
+    //result = WebRtcSpl_ComplexFFT(complex_buffer, self->order, 1);
 
-    // For real FFT output, use only the first N + 2 elements from
+    arm_cfft_q15(cmsis_cfft_instance_table_q15[self->order - 4], (q15_t *)complex_buffer, 0, 1);
+
+    // For real FFT output, use only the first N + 2 elements;
     // complex forward FFT.
     memcpy(complex_data_out, complex_buffer, sizeof(int16_t) * (n + 2));
+
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         free(complex_buffer);
@@ -275,18 +264,24 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
         self->fft_busy = 0;
     #endif
 #endif
+
+
     return result;
 }
-
-int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
-                             const int16_t *complex_data_in,
-                             int16_t *real_data_out)
+static int CmsisRealInverseFFT(struct RealFFT *self,
+                               const int16_t *complex_data_in,
+                               int16_t *real_data_out)
 {
     int i = 0;
     int j = 0;
     int result = 0;
     int n = 1 << self->order;
     // Create the buffer specific to complex-valued FFT implementation.
+
+    rt_uint32_t evt;
+    int scale = 0;
+
+    scale = scale_calculate(complex_data_in, n);
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         int16_t *complex_buffer = malloc((2 << kMaxFFTOrder) * 2);
@@ -299,24 +294,33 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
 #else
     int16_t complex_buffer[2 << kMaxFFTOrder];
 #endif
+
     // For n-point FFT, first copy the first n + 2 elements into complex
     // FFT, then construct the remaining n - 2 elements by real FFT's
     // conjugate-symmetric properties.
     memcpy(complex_buffer, complex_data_in, sizeof(int16_t) * (n + 2));
+
+    for (i = 0; i < n + 2; i++)
+    {
+        complex_buffer[i] <<= scale;
+    }
     for (i = n + 2; i < 2 * n; i += 2)
     {
-        complex_buffer[i] = complex_data_in[2 * n - i];
-        complex_buffer[i + 1] = -complex_data_in[2 * n - i + 1];
+        complex_buffer[i] = complex_data_in[2 * n - i] << scale;
+        complex_buffer[i + 1] = -complex_data_in[2 * n - i + 1] << scale;
     }
 
-    WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    result = WebRtcSpl_ComplexIFFT(complex_buffer, self->order, 1);
+    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
+    //result = WebRtcSpl_ComplexIFFT(complex_buffer, self->order, 1);
+    arm_cfft_q15(cmsis_cfft_instance_table_q15[self->order - 4], (q15_t *)complex_buffer, 1, 1);
+    result = self->order - scale;
 
     // Strip out the imaginary parts of the complex inverse FFT output.
     for (i = 0, j = 0; i < n; i += 1, j += 2)
     {
         real_data_out[i] = complex_buffer[j];
     }
+
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         free(complex_buffer);
@@ -324,15 +328,53 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
         self->fft_busy = 0;
     #endif
 #endif
+
     return result;
 }
+#endif
 
-#else
+#ifdef FFT_USING_ONCHIP
 #include "bf0_hal_fft.h"
 extern fft_env_t g_fft_env;
-int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
-                             const int16_t *real_data_in,
-                             int16_t *complex_data_out)
+
+// Orders below this finish faster than an interrupt round trip, poll them.
+#define ONCHIP_FFT_IT_MIN_ORDER     7
+
+static void onchip_fft_run(int order, int16_t *complex_buffer, uint8_t ifft)
+{
+    FFT_ConfigTypeDef config;
+    HAL_StatusTypeDef status;
+    rt_uint32_t evt;
+
+    RT_ASSERT(((uint32_t)complex_buffer & 3) == 0);
+    memset(&config, 0, sizeof(config));
+
+    config.bitwidth = 1;//0:8bit 1:16bit 2:32bit
+    config.fft_length = (order - 4);
+    config.ifft_flag = ifft;//0:fft  1:ifft
+    config.rfft_flag = 0;
+    config.input_data = complex_buffer;
+    config.output_data = complex_buffer;
+
+    // Let the 3A thread sleep while hardware runs the transform, so the CPU
+    // can drop to WFI or serve the codec threads instead of spinning.
+    if (order >= ONCHIP_FFT_IT_MIN_ORDER && g_fft_env.int_ev && !rt_interrupt_get_nest())
+    {
+        rt_event_control(g_fft_env.int_ev, RT_IPC_CMD_RESET, NULL);
+        status = HAL_FFT_StartFFT_IT(&(g_fft_env.fft_handle), &config);
+        RT_ASSERT(HAL_OK == status);
+        rt_event_recv(g_fft_env.int_ev, 1, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &evt);
+    }
+    else
+    {
+        status = HAL_FFT_StartFFT(&(g_fft_env.fft_handle), &config);
+        RT_ASSERT(HAL_OK == status);
+    }
+}
+
+static int OnchipRealForwardFFT(struct RealFFT *self,
+                                const int16_t *real_data_in,
+                                int16_t *complex_data_out)
 {
     int i = 0;
     int j = 0;
@@ -341,8 +383,6 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
     // The complex-value FFT implementation needs a buffer to hold 2^order
     // 16-bit COMPLEX numbers, for both time and frequency data.
 
-    rt_uint32_t evt;
-
 #ifdef AUDIO_MEM_ALLOC
     #if MALLOC_EVERYTIME
         int16_t *complex_buffer = malloc((2 << kMaxFFTOrder) * 2);
@@ -362,29 +402,9 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
         complex_buffer[j + 1] = 0;
     };
 
-    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    //result = WebRtcSpl_ComplexFFT(complex_buffer, self->order, 1);
-    FFT_ConfigTypeDef config;
-    HAL_StatusTypeDef status;
-
-    memset(&config, 0, sizeof(config));
-
-    config.bitwidth = 1;//0:8bit 1:16bit 2:32bit
-    config.fft_length = (self->order - 4);
-    config.ifft_flag = 0;//0:fft  1:ifft
-    config.rfft_flag = 0;
-    config.input_data = complex_buffer;
-    config.output_data = complex_buffer;
-#if 0
-    status = HAL_FFT_StartFFT_IT(&(g_fft_env.fft_handle), &config);
-    //rt_kprintf("fft status:%d, config:0x%x\n", status, &config);
-    RT_ASSERT(HAL_OK == status);
+    onchip_fft_run(self->order, complex_buffer, 0);
 
-    rt_event_recv(g_fft_env.int_ev, 1, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &evt);
-#else
-    status = HAL_FFT_StartFFT(&(g_fft_env.fft_handle), &config);
-#endif
-    // For real FFT output, use only the first N + 2 elements fromrt_free(out_buffer);
+    // For real FFT output, use only the first N + 2 elements from
     // complex forward FFT.
     memcpy(complex_data_out, complex_buffer, sizeof(int16_t) * (n + 2));
 
@@ -399,45 +419,15 @@ int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
 
     return result;
 }
-int scale_calculate(const int16_t *complex_data_in, int n)
-{
-    int scale;
-    int tmp16;
-
-    tmp16 = WebRtcSpl_MaxAbsValueW16(complex_data_in, 2 * n);
-
-    if (tmp16 > 16383)      //2^14 - 1
-        scale = 0;
-    else if (tmp16 > 8191)      //2^13 - 1
-        scale = 1;
-    else if (tmp16 > 4095)      //2^12 - 1
-        scale = 2;
-    else if (tmp16 > 2047)      //2^11 - 1
-        scale = 3;
-    else if (tmp16 > 1023)      //2^10 - 1
-        scale = 4;
-    else if (tmp16 > 511)   //2^9 - 1
-        scale = 5;
-    else if (tmp16 > 255)   //2^8 - 1
-        scale = 6;
-    else if (tmp16 > 127)   //2^7 - 1
-        scale = 7;
-    else
-        scale = 8;
-
-    return scale;
-}
-int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
-                             const int16_t *complex_data_in,
-                             int16_t *real_data_out)
+static int OnchipRealInverseFFT(struct RealFFT *self,
+                                const int16_t *complex_data_in,
+                                int16_t *real_data_out)
 {
     int i = 0;
     int j = 0;
     int result = 0;
     int n = 1 << self->order;
     // Create the buffer specific to complex-valued FFT implementation.
-    //int16_t *out_buffer;
-    rt_uint32_t evt;
     int scale = 0;
 
     scale = scale_calculate(complex_data_in, n);
@@ -470,29 +460,9 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
         complex_buffer[i + 1] = -complex_data_in[2 * n - i + 1] << scale;
     }
 
-    //WebRtcSpl_ComplexBitReverse(complex_buffer, self->order);
-    //result = WebRtcSpl_ComplexIFFT(complex_buffer, self->order, 1);
-    FFT_ConfigTypeDef config;
-    HAL_StatusTypeDef status;
-
-    memset(&config, 0, sizeof(config));
-
-    config.bitwidth = 1;//0:8bit 1:16bit 2:32bit
-    config.fft_length = (self->order - 4);
-    config.ifft_flag = 1;//0:fft  1:ifft
-    config.rfft_flag = 0;
-    config.input_data = complex_buffer;
-    config.output_data = complex_buffer;
-
-#if 0
-    status = HAL_FFT_StartFFT_IT(&(g_fft_env.fft_handle), &config);
-    RT_ASSERT(HAL_OK == status);
-    result = self->order - scale;
-    rt_event_recv(g_fft_env.int_ev, 1, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &evt);
-#else
-    status = HAL_FFT_StartFFT(&(g_fft_env.fft_handle), &config);
+    onchip_fft_run(self->order, complex_buffer, 1);
     result = self->order - scale;
-#endif
+
     // Strip out the imaginary parts of the complex inverse FFT output.
     for (i = 0, j = 0; i < n; i += 1, j += 2)
     {
@@ -510,5 +480,69 @@ int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
     return result;
 }
 #endif
+
+static const WebRtcSpl_FFTProvider soft_fft_provider =
+{
+    "soft",
+    SoftRealForwardFFT,
+    SoftRealInverseFFT,
+};
+
+#ifdef FFT_USING_CMSIS_DSP
+static const WebRtcSpl_FFTProvider cmsis_fft_provider =
+{
+    "cmsis",
+    CmsisRealForwardFFT,
+    CmsisRealInverseFFT,
+};
+#endif
+
+#ifdef FFT_USING_ONCHIP
+static const WebRtcSpl_FFTProvider onchip_fft_provider =
+{
+    "onchip",
+    OnchipRealForwardFFT,
+    OnchipRealInverseFFT,
+};
+#endif
+
+static const WebRtcSpl_FFTProvider *custom_fft_provider;
+
+const WebRtcSpl_FFTProvider *WebRtcSpl_DefaultFFTProvider(int order)
+{
+    if (custom_fft_provider)
+        return custom_fft_provider;
+#ifdef FFT_USING_ONCHIP
+    // Hardware supports 16..1024 points.
+    if (order >= 4 && order <= 10)
+        return &onchip_fft_provider;
+#elif defined(FFT_USING_CMSIS_DSP)
+    if (order >= 4 && order <= 10)
+        return &cmsis_fft_provider;
 #endif
+    return &soft_fft_provider;
+}
+
+void WebRtcSpl_SetFFTProvider(const WebRtcSpl_FFTProvider *provider)
+{
+    custom_fft_provider = provider;
+}
+
+int WebRtcSpl_RealForwardFFT(struct RealFFT *self,
+                             const int16_t *real_data_in,
+                             int16_t *complex_data_out)
+{
+    if (self == NULL || real_data_in == NULL || complex_data_out == NULL)
+        return -1;
+    return self->provider->forward(self, real_data_in, complex_data_out);
+}
+
+int WebRtcSpl_RealInverseFFT(struct RealFFT *self,
+                             const int16_t *complex_data_in,
+                             int16_t *real_data_out)
+{
+    if (self == NULL || complex_data_in == NULL || real_data_out == NULL)
+        return -1;
+    return self->provider->inverse(self, complex_data_in, real_data_out);
+}
 #undef AUDIO_MEM_ALLOC
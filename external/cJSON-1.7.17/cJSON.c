@@ -296,8 +296,79 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_Arena *arena; /* nodes and strings are allocated from arena if not NULL */
+    cJSON_bool in_situ; /* strings are decoded in place of input, arena is required */
 } parse_buffer;
 
+#ifndef CJSON_ARENA_CHUNK_SIZE
+#define CJSON_ARENA_CHUNK_SIZE 1024
+#endif
+
+struct cJSON_ArenaChunk
+{
+    struct cJSON_ArenaChunk *next;
+    size_t size;
+    size_t used;
+};
+
+#define ARENA_ALIGN(size) (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    struct cJSON_ArenaChunk *chunk = arena->chunk;
+    size_t chunk_size;
+
+    size = ARENA_ALIGN(size);
+    if ((chunk == NULL) || (chunk->used + size > chunk->size))
+    {
+        chunk_size = (size > arena->chunk_size) ? size : arena->chunk_size;
+        chunk = (struct cJSON_ArenaChunk*)global_hooks.allocate(ARENA_ALIGN(sizeof(*chunk)) + chunk_size);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = arena->chunk;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        arena->chunk = chunk;
+        arena->allocated += ARENA_ALIGN(sizeof(*chunk)) + chunk_size;
+        arena->chunks++;
+    }
+
+    chunk->used += size;
+    arena->used += size;
+    return (unsigned char*)chunk + ARENA_ALIGN(sizeof(*chunk)) + chunk->used - size;
+}
+
+static void *parse_allocate(parse_buffer * const input_buffer, size_t size)
+{
+    if (input_buffer->arena != NULL)
+    {
+        return arena_allocate(input_buffer->arena, size);
+    }
+    return input_buffer->hooks.allocate(size);
+}
+
+static cJSON *parse_new_item(parse_buffer * const input_buffer)
+{
+    cJSON* node = (cJSON*)parse_allocate(input_buffer, sizeof(cJSON));
+    if (node)
+    {
+        rt_memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+/* Items in arena are released with the arena */
+static void parse_delete(parse_buffer * const input_buffer, cJSON *item)
+{
+    if (input_buffer->arena == NULL)
+    {
+        cJSON_Delete(item);
+    }
+}
+
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
 #define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
 /* check if the buffer can be accessed at the given index (starting with 0) */
@@ -819,7 +890,15 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        if (input_buffer->in_situ)
+        {
+            /* decoded string is never longer than the literal, the closing quote takes the terminator */
+            output = (unsigned char*)input_pointer;
+        }
+        else
+        {
+            output = (unsigned char*)parse_allocate(input_buffer, allocation_length + sizeof(""));
+        }
         if (output == NULL)
         {
             goto fail; /* allocation failure */
@@ -895,7 +974,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && (input_buffer->arena == NULL))
     {
         input_buffer->hooks.deallocate(output);
     }
@@ -1102,9 +1181,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
 }
 
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse_root(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Arena *arena, cJSON_bool in_situ)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, NULL, false };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1120,8 +1199,10 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.length = buffer_length;
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.arena = arena;
+    buffer.in_situ = in_situ;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = parse_new_item(&buffer);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1152,7 +1233,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
 fail:
     if (item != NULL)
     {
-        cJSON_Delete(item);
+        parse_delete(&buffer, item);
     }
 
     if (value != NULL)
@@ -1181,6 +1262,54 @@ fail:
     return NULL;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, return_parse_end, require_null_terminated, NULL, false);
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, size_t chunk_size)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+    rt_memset(arena, 0, sizeof(*arena));
+    arena->chunk_size = chunk_size ? chunk_size : CJSON_ARENA_CHUNK_SIZE;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseArena(cJSON_Arena *arena, char *value, size_t buffer_length, cJSON_bool in_situ)
+{
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+    if (0 == buffer_length && value != NULL)
+    {
+        buffer_length = strlen(value) + sizeof("");
+    }
+
+    return parse_root(value, buffer_length, NULL, false, arena, in_situ);
+}
+
+CJSON_PUBLIC(void) cJSON_FreeArena(cJSON_Arena *arena)
+{
+    struct cJSON_ArenaChunk *chunk;
+
+    if (arena == NULL)
+    {
+        return;
+    }
+    while (arena->chunk != NULL)
+    {
+        chunk = arena->chunk;
+        arena->chunk = chunk->next;
+        global_hooks.deallocate(chunk);
+    }
+    arena->used = 0;
+    arena->allocated = 0;
+    arena->chunks = 0;
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
@@ -1486,7 +1615,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1539,7 +1668,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
@@ -1644,7 +1773,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1714,7 +1843,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
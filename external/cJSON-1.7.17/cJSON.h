@@ -152,6 +152,25 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
 
+/* Arena parse: all items and strings are allocated from arena in big chunks and freed at once by cJSON_FreeArena.
+ * With in_situ, strings are decoded in place and point into value, which must be writable and kept until the arena is freed.
+ * Items of arena must not be deleted or modified by cJSON_Delete/cJSON_Add... APIs.
+ * used/allocated give the bytes used by items and strings / taken from heap, accumulated until cJSON_FreeArena. */
+typedef struct cJSON_Arena
+{
+    struct cJSON_ArenaChunk *chunk;
+    size_t chunk_size;
+    size_t used;
+    size_t allocated;
+    size_t chunks;
+} cJSON_Arena;
+
+/* chunk_size 0 uses CJSON_ARENA_CHUNK_SIZE */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, size_t chunk_size);
+/* buffer_length 0 uses strlen of value */
+CJSON_PUBLIC(cJSON *) cJSON_ParseArena(cJSON_Arena *arena, char *value, size_t buffer_length, cJSON_bool in_situ);
+CJSON_PUBLIC(void) cJSON_FreeArena(cJSON_Arena *arena);
+
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
@@ -0,0 +1,442 @@
+/*
+  Streaming SAX style parser for cJSON, see cJSON_Sax.h
+*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "cJSON_Sax.h"
+
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+enum
+{
+    SAX_VALUE,
+    SAX_KEY,
+    SAX_COLON,
+    SAX_AFTER,
+    SAX_STRING,
+    SAX_ESCAPE,
+    SAX_UNICODE,
+    SAX_NUMBER,
+    SAX_LITERAL,
+    SAX_DONE,
+    SAX_ERROR
+};
+
+static const char * const literals[] = { "true", "false", "null" };
+static const cJSON_SaxEvent literal_events[] = { cJSON_SaxTrue, cJSON_SaxFalse, cJSON_SaxNull };
+
+static cJSON_bool is_space(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+static cJSON_bool in_object(const cJSON_Sax * const sax)
+{
+    return (sax->depth > 0) && (sax->object_bits & (1u << (sax->depth - 1)));
+}
+
+static void token_append(cJSON_Sax * const sax, unsigned char c)
+{
+    if (sax->token_len < CJSON_SAX_TOKEN_SIZE - 1)
+    {
+        sax->token[sax->token_len++] = (char)c;
+    }
+    else
+    {
+        sax->truncated = true;
+    }
+}
+
+static void token_append_utf8(cJSON_Sax * const sax, unsigned long code_point)
+{
+    if (code_point < 0x80)
+    {
+        token_append(sax, (unsigned char)code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        token_append(sax, (unsigned char)(0xC0 | (code_point >> 6)));
+        token_append(sax, (unsigned char)(0x80 | (code_point & 0x3F)));
+    }
+    else if (code_point < 0x10000)
+    {
+        token_append(sax, (unsigned char)(0xE0 | (code_point >> 12)));
+        token_append(sax, (unsigned char)(0x80 | ((code_point >> 6) & 0x3F)));
+        token_append(sax, (unsigned char)(0x80 | (code_point & 0x3F)));
+    }
+    else
+    {
+        token_append(sax, (unsigned char)(0xF0 | (code_point >> 18)));
+        token_append(sax, (unsigned char)(0x80 | ((code_point >> 12) & 0x3F)));
+        token_append(sax, (unsigned char)(0x80 | ((code_point >> 6) & 0x3F)));
+        token_append(sax, (unsigned char)(0x80 | (code_point & 0x3F)));
+    }
+}
+
+static cJSON_bool emit(cJSON_Sax * const sax, cJSON_SaxEvent event, const char *str, size_t len, double number)
+{
+    return sax->callback(sax, event, str, len, number) == 0;
+}
+
+static void value_done(cJSON_Sax * const sax)
+{
+    sax->state = (sax->depth == 0) ? SAX_DONE : SAX_AFTER;
+}
+
+/* Return false if stopped by callback */
+static cJSON_bool number_done(cJSON_Sax * const sax)
+{
+    char *end = NULL;
+    double number;
+
+    sax->token[sax->token_len] = '\0';
+    number = strtod(sax->token, &end);
+    if ((sax->token_len == 0) || (end != sax->token + sax->token_len) || sax->truncated)
+    {
+        sax->state = SAX_ERROR;
+        return true;
+    }
+    value_done(sax);
+    return emit(sax, cJSON_SaxNumber, NULL, 0, number);
+}
+
+static cJSON_bool open_container(cJSON_Sax * const sax, cJSON_bool object)
+{
+    if (sax->depth >= CJSON_SAX_MAX_DEPTH)
+    {
+        sax->state = SAX_ERROR;
+        return true;
+    }
+    if (object)
+    {
+        sax->object_bits |= 1u << sax->depth;
+    }
+    else
+    {
+        sax->object_bits &= ~(1u << sax->depth);
+    }
+    sax->depth++;
+    sax->first = true;
+    sax->state = object ? SAX_KEY : SAX_VALUE;
+    return emit(sax, object ? cJSON_SaxObjectStart : cJSON_SaxArrayStart, NULL, 0, 0);
+}
+
+static cJSON_bool close_container(cJSON_Sax * const sax, cJSON_bool object)
+{
+    cJSON_bool go_on;
+
+    if ((sax->depth == 0) || (in_object(sax) != object))
+    {
+        sax->state = SAX_ERROR;
+        return true;
+    }
+    go_on = emit(sax, object ? cJSON_SaxObjectEnd : cJSON_SaxArrayEnd, NULL, 0, 0);
+    sax->depth--;
+    value_done(sax);
+    return go_on;
+}
+
+static void start_token(cJSON_Sax * const sax, unsigned char state)
+{
+    sax->token_len = 0;
+    sax->truncated = false;
+    sax->high_surrogate = 0;
+    sax->state = state;
+}
+
+CJSON_PUBLIC(void) cJSON_SaxInit(cJSON_Sax *sax, cJSON_SaxCallback callback, void *user_data)
+{
+    memset(sax, 0, sizeof(*sax));
+    sax->callback = callback;
+    sax->user_data = user_data;
+    sax->state = SAX_VALUE;
+}
+
+CJSON_PUBLIC(cJSON_SaxResult) cJSON_SaxFeed(cJSON_Sax *sax, const char *data, size_t length)
+{
+    cJSON_bool go_on = true;
+    size_t i = 0;
+    unsigned char c;
+
+    if ((sax == NULL) || (sax->callback == NULL) || ((data == NULL) && (length > 0)))
+    {
+        return cJSON_SaxError;
+    }
+
+    while (go_on && (i < length) && (sax->state != SAX_ERROR))
+    {
+        c = (unsigned char)data[i];
+
+        switch (sax->state)
+        {
+        case SAX_VALUE:
+            if (is_space((char)c))
+            {
+                break;
+            }
+            if (c == '{')
+            {
+                go_on = open_container(sax, true);
+            }
+            else if (c == '[')
+            {
+                go_on = open_container(sax, false);
+            }
+            else if ((c == ']') && sax->first && (sax->depth > 0) && !in_object(sax))
+            {
+                go_on = close_container(sax, false);
+            }
+            else if (c == '\"')
+            {
+                sax->is_key = false;
+                start_token(sax, SAX_STRING);
+            }
+            else if ((c == '-') || ((c >= '0') && (c <= '9')))
+            {
+                start_token(sax, SAX_NUMBER);
+                token_append(sax, c);
+            }
+            else if ((c == 't') || (c == 'f') || (c == 'n'))
+            {
+                sax->literal = (c == 't') ? 0 : ((c == 'f') ? 1 : 2);
+                start_token(sax, SAX_LITERAL);
+                sax->token_len = 1;
+            }
+            else
+            {
+                sax->state = SAX_ERROR;
+            }
+            break;
+
+        case SAX_KEY:
+            if (is_space((char)c))
+            {
+                break;
+            }
+            if (c == '\"')
+            {
+                sax->is_key = true;
+                start_token(sax, SAX_STRING);
+            }
+            else if ((c == '}') && sax->first)
+            {
+                go_on = close_container(sax, true);
+            }
+            else
+            {
+                sax->state = SAX_ERROR;
+            }
+            break;
+
+        case SAX_COLON:
+            if (c == ':')
+            {
+                sax->first = false;
+                sax->state = SAX_VALUE;
+            }
+            else if (!is_space((char)c))
+            {
+                sax->state = SAX_ERROR;
+            }
+            break;
+
+        case SAX_AFTER:
+            if (is_space((char)c))
+            {
+                break;
+            }
+            if (c == ',')
+            {
+                sax->first = false;
+                sax->state = in_object(sax) ? SAX_KEY : SAX_VALUE;
+            }
+            else if ((c == '}') || (c == ']'))
+            {
+                go_on = close_container(sax, c == '}');
+            }
+            else
+            {
+                sax->state = SAX_ERROR;
+            }
+            break;
+
+        case SAX_STRING:
+            if (c == '\"')
+            {
+                sax->token[sax->token_len] = '\0';
+                if (sax->is_key)
+                {
+                    sax->state = SAX_COLON;
+                    go_on = emit(sax, cJSON_SaxKey, sax->token, sax->token_len, 0);
+                }
+                else
+                {
+                    value_done(sax);
+                    go_on = emit(sax, cJSON_SaxString, sax->token, sax->token_len, 0);
+                }
+            }
+            else if (c == '\\')
+            {
+                sax->state = SAX_ESCAPE;
+            }
+            else if (c < 0x20)
+            {
+                sax->state = SAX_ERROR;
+            }
+            else
+            {
+                token_append(sax, c);
+            }
+            break;
+
+        case SAX_ESCAPE:
+            sax->state = SAX_STRING;
+            switch (c)
+            {
+            case 'b':
+                token_append(sax, '\b');
+                break;
+            case 'f':
+                token_append(sax, '\f');
+                break;
+            case 'n':
+                token_append(sax, '\n');
+                break;
+            case 'r':
+                token_append(sax, '\r');
+                break;
+            case 't':
+                token_append(sax, '\t');
+                break;
+            case '\"':
+            case '\\':
+            case '/':
+                token_append(sax, c);
+                break;
+            case 'u':
+                sax->code_point = 0;
+                sax->hex_count = 0;
+                sax->state = SAX_UNICODE;
+                break;
+            default:
+                sax->state = SAX_ERROR;
+                break;
+            }
+            break;
+
+        case SAX_UNICODE:
+            if ((c >= '0') && (c <= '9'))
+            {
+                sax->code_point = (sax->code_point << 4) | (c - '0');
+            }
+            else if (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+            {
+                sax->code_point = (sax->code_point << 4) | ((c | 0x20) - 'a' + 10);
+            }
+            else
+            {
+                sax->state = SAX_ERROR;
+                break;
+            }
+            if (++sax->hex_count < 4)
+            {
+                break;
+            }
+            sax->state = SAX_STRING;
+            if ((sax->code_point >= 0xD800) && (sax->code_point <= 0xDBFF))
+            {
+                /* first half of surrogate pair, wait for second one */
+                sax->high_surrogate = sax->code_point;
+            }
+            else if ((sax->code_point >= 0xDC00) && (sax->code_point <= 0xDFFF))
+            {
+                if (sax->high_surrogate == 0)
+                {
+                    sax->state = SAX_ERROR;
+                    break;
+                }
+                token_append_utf8(sax, 0x10000 + (((sax->high_surrogate & 0x3FF) << 10) | (sax->code_point & 0x3FF)));
+                sax->high_surrogate = 0;
+            }
+            else
+            {
+                token_append_utf8(sax, sax->code_point);
+            }
+            break;
+
+        case SAX_NUMBER:
+            if (((c >= '0') && (c <= '9')) || (c == '.') || (c == 'e') || (c == 'E') || (c == '+') || (c == '-'))
+            {
+                token_append(sax, c);
+                break;
+            }
+            /* number ends at this character, which is handled again in next state */
+            go_on = number_done(sax);
+            continue;
+
+        case SAX_LITERAL:
+            if (c != (unsigned char)literals[sax->literal][sax->token_len])
+            {
+                sax->state = SAX_ERROR;
+                break;
+            }
+            if (literals[sax->literal][++sax->token_len] == '\0')
+            {
+                value_done(sax);
+                go_on = emit(sax, literal_events[sax->literal], NULL, 0, 0);
+            }
+            break;
+
+        case SAX_DONE:
+            if (!is_space((char)c))
+            {
+                sax->state = SAX_ERROR;
+            }
+            break;
+
+        default:
+            sax->state = SAX_ERROR;
+            break;
+        }
+
+        if (sax->state != SAX_ERROR)
+        {
+            i++;
+        }
+    }
+
+    sax->offset += i;
+    if (sax->state == SAX_ERROR)
+    {
+        return cJSON_SaxError;
+    }
+
+    return go_on ? cJSON_SaxOk : cJSON_SaxStopped;
+}
+
+CJSON_PUBLIC(cJSON_SaxResult) cJSON_SaxFinish(cJSON_Sax *sax)
+{
+    if (sax == NULL)
+    {
+        return cJSON_SaxError;
+    }
+    if ((sax->state == SAX_NUMBER) && (sax->depth == 0))
+    {
+        if (!number_done(sax))
+        {
+            return cJSON_SaxStopped;
+        }
+    }
+
+    return (sax->state == SAX_DONE) ? cJSON_SaxOk : cJSON_SaxError;
+}
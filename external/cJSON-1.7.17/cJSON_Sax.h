@@ -0,0 +1,81 @@
+#ifndef cJSON_Sax__h
+#define cJSON_Sax__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* Streaming parser: input is fed in pieces of any size and events are reported as soon as a
+ * token is complete, so documents larger than RAM can be walked without building a tree.
+ * Strings longer than CJSON_SAX_TOKEN_SIZE - 1 are reported truncated with truncated set. */
+
+#ifndef CJSON_SAX_TOKEN_SIZE
+#define CJSON_SAX_TOKEN_SIZE 128
+#endif
+
+/* max nesting of objects and arrays */
+#define CJSON_SAX_MAX_DEPTH 32
+
+typedef enum
+{
+    cJSON_SaxObjectStart,
+    cJSON_SaxObjectEnd,
+    cJSON_SaxArrayStart,
+    cJSON_SaxArrayEnd,
+    cJSON_SaxKey,
+    cJSON_SaxString,
+    cJSON_SaxNumber,
+    cJSON_SaxTrue,
+    cJSON_SaxFalse,
+    cJSON_SaxNull
+} cJSON_SaxEvent;
+
+typedef struct cJSON_Sax cJSON_Sax;
+
+/* str/len is valid for key and string only, number for number only.
+ * depth counts enclosing objects and arrays, start and end events have the depth of their content.
+ * Return non 0 to stop parsing. */
+typedef int (*cJSON_SaxCallback)(cJSON_Sax *sax, cJSON_SaxEvent event, const char *str, size_t len, double number);
+
+struct cJSON_Sax
+{
+    cJSON_SaxCallback callback;
+    void *user_data;
+    int depth;
+    cJSON_bool truncated;
+    size_t offset;              /* bytes consumed, position of error */
+
+    /* private */
+    unsigned char state;
+    unsigned char first;
+    unsigned char is_key;
+    unsigned char literal;
+    unsigned char hex_count;
+    unsigned int object_bits;   /* bit n set if level n is an object */
+    unsigned long code_point;
+    unsigned long high_surrogate;
+    size_t token_len;
+    char token[CJSON_SAX_TOKEN_SIZE];
+};
+
+typedef enum
+{
+    cJSON_SaxOk = 0,
+    cJSON_SaxStopped = 1,       /* stopped by callback */
+    cJSON_SaxError = -1
+} cJSON_SaxResult;
+
+CJSON_PUBLIC(void) cJSON_SaxInit(cJSON_Sax *sax, cJSON_SaxCallback callback, void *user_data);
+/* Feed next piece of input, return cJSON_SaxOk if more input is expected or document is complete */
+CJSON_PUBLIC(cJSON_SaxResult) cJSON_SaxFeed(cJSON_Sax *sax, const char *data, size_t length);
+/* End of input, flushes a number at top level. Return cJSON_SaxError if document is incomplete */
+CJSON_PUBLIC(cJSON_SaxResult) cJSON_SaxFinish(cJSON_Sax *sax);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
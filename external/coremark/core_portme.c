@@ -18,6 +18,7 @@ Original Author: Shay Gal-on
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <rtthread.h>
 #include "coremark.h"
 #include "board.h"
@@ -104,6 +105,7 @@ secs_ret time_in_secs(CORE_TICKS ticks) {
 }
 
 ee_u32 default_num_contexts=1;
+static coremark_result_t last_result;
 
 /* Function : portable_init
 	Target specific initialization code 
@@ -125,9 +127,25 @@ void portable_init(core_portable *p, int *argc, char *argv[])
 */
 void portable_fini(core_portable *p)
 {
+	core_results *res=(core_results *)((ee_u8 *)p - offsetof(core_results, port));
+
+	last_result.iterations=default_num_contexts*res->iterations;
+	last_result.ticks=get_time();
+	last_result.crc=res->crc;
+	last_result.err=res->err;
 	p->portable_id=0;
 }
 
+void coremark_set_iterations(ee_u32 iterations)
+{
+	seed4_volatile=iterations ? iterations : ITERATIONS;
+}
+
+const coremark_result_t *coremark_get_result(void)
+{
+	return &last_result;
+}
+
 
 #ifdef FINSH_USING_MSH
 extern int coremark(int argc, char *argv[]) ;
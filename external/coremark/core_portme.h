@@ -188,6 +188,27 @@ typedef struct CORE_PORTABLE_S {
 void portable_init(core_portable *p, int *argc, char *argv[]);
 void portable_fini(core_portable *p);
 
+/* Result of last run, saved by portable_fini for harness sweeping clock or code placement */
+typedef struct CORE_RESULT_S {
+	ee_u32	iterations;
+	CORE_TICKS	ticks;		/* in ms, port uses HAL_GetTick */
+	ee_u16	crc;
+	ee_s16	err;
+} coremark_result_t;
+
+/* Iterations of next run, 0 to restore ITERATIONS */
+void coremark_set_iterations(ee_u32 iterations);
+const coremark_result_t *coremark_get_result(void);
+
+/* Configuration : COREMARK_CODE_IN_RAM
+	Place benchmark code in L1 RAM instead of flash XIP, to compare with XIP result.
+	COREMARK_SRC is only defined for coremark sources, so code including this header is not moved.
+	Only armclang is handled here, for GCC add coremark objects to RAM code section of link script.
+*/
+#if defined(COREMARK_CODE_IN_RAM) && defined(COREMARK_SRC) && defined(__CLANG_ARM)
+#pragma clang section text=".l1_ret_text_coremark" rodata=".l1_ret_rodata_coremark"
+#endif
+
 #if !defined(PROFILE_RUN) && !defined(PERFORMANCE_RUN) && !defined(VALIDATION_RUN)
 #if (TOTAL_DATA_SIZE==1200)
 #define PROFILE_RUN 1
@@ -576,6 +576,12 @@
 
   }
 
+/* Current weight of all cached nodes, it grows whenever a node or a glyph of node is loaded */
+FT_Offset FTC_Manager_Get_Weight( FTC_Manager  manager )
+{
+  return manager ? manager->cur_weight : 0;
+}
+
 void FTC_Manager_Cache_Free( FTC_Manager  manager, unsigned int max_weight)
 	{
 	  FTC_Node	 node, first;
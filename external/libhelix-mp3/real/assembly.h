@@ -48,6 +48,8 @@
  * MULSHIFT32(x, y)    signed multiply of two 32-bit integers (x and y), returns top 32 bits of 64-bit result
  * FASTABS(x)          branchless absolute value of signed integer x
  * CLZ(x)              count leading zeros in x
+ * MLASHIFT32(s, x, y) s + MULSHIFT32(x, y), single SMMLA with DSP extension
+ * SAT16(x)            saturate signed integer x to [-32768, 32767]
  * MADD64(sum, x, y)   (Windows only) sum [64-bit] += x [32-bit] * y [32-bit]
  * SHL64(sum, x, y)    (Windows only) 64-bit left shift using __int64
  * SAR64(sum, x, y)    (Windows only) 64-bit right shift using __int64
@@ -80,6 +82,12 @@ __STATIC_FORCEINLINE int CLZ(int x)
 
 #define CLZ __CLZ
 
+/* Cortex-M33/M4 with DSP extension use SMMUL/SMMLA/SSAT kernels, all bit exact
+ * with C reference. Define HELIX_MP3_NO_DSP to build C reference, e.g. to check
+ * conformance of both. */
+#if !defined(HELIX_MP3_NO_DSP) && defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define HELIX_MP3_DSP
+#endif
 
 #endif
 
@@ -95,9 +103,38 @@ __STATIC_FORCEINLINE int FASTABS(int x)
 	return x;
 }
 
+#if defined(HELIX_MP3_DSP) && defined(__GNUC__)
+/* SMMUL needs no register for low word of product, unlike SMULL */
+__STATIC_FORCEINLINE int MULSHIFT32(int x, int y) {
+	int z;
+
+	__ASM ("smmul %0, %1, %2" : "=r" (z) : "r" (x), "r" (y));
+	return z;
+}
+#else
 __STATIC_FORCEINLINE int MULSHIFT32(int x, int y) {
 	return (((Word64)x * y)) >> 32;
 }
+#endif
+
+#ifdef HELIX_MP3_DSP
+#define MLASHIFT32(s, x, y)	__SMMLA((x), (y), (s))
+#define SAT16(x)			__SSAT((x), 16)
+#else
+__STATIC_FORCEINLINE int MLASHIFT32(int s, int x, int y) {
+	return s + MULSHIFT32(x, y);
+}
+
+/* Ken's trick: clips to [-32768, 32767] */
+__STATIC_FORCEINLINE int SAT16(int x) {
+	int sign = x >> 31;
+
+	if (sign != (x >> 15))
+		x = sign ^ ((1 << 15) - 1);
+
+	return x;
+}
+#endif
 
 __STATIC_FORCEINLINE Word64 SAR64(Word64 x, int n) {
 	return x >>= n;
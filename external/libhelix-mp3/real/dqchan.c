@@ -177,6 +177,11 @@ static int DequantBlock(int *inbuf, int *outbuf, int num, int scale)
 
 				/* normalize to [0x40000000, 0x7fffffff] */
 				x <<= 17;
+#ifdef HELIX_MP3_DSP
+				/* 64 <= x < 2^14, so shift is 0..7 as below */
+				shift = CLZ(x) - 1;
+				x <<= shift;
+#else
 				shift = 0;
 				if (x < 0x08000000)
 					x <<= 4, shift += 4;
@@ -184,15 +189,16 @@ static int DequantBlock(int *inbuf, int *outbuf, int num, int scale)
 					x <<= 2, shift += 2;
 				if (x < 0x40000000)
 					x <<= 1, shift += 1;
+#endif
 
 				coef = (x < SQRTHALF) ? poly43lo : poly43hi;
 
 				/* polynomial */
 				y = coef[0];
-				y = MULSHIFT32(y, x) + coef[1];
-				y = MULSHIFT32(y, x) + coef[2];
-				y = MULSHIFT32(y, x) + coef[3];
-				y = MULSHIFT32(y, x) + coef[4];
+				y = MLASHIFT32(coef[1], y, x);
+				y = MLASHIFT32(coef[2], y, x);
+				y = MLASHIFT32(coef[3], y, x);
+				y = MLASHIFT32(coef[4], y, x);
 				y = MULSHIFT32(y, pow2frac[shift]) << 3;
 
 				/* fractional scale */
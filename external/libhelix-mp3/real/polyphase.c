@@ -58,17 +58,10 @@
 
 static __inline short ClipToShort(int x, int fracBits)
 {
-	int sign;
-	
 	/* assumes you've already rounded (x += (1 << (fracBits-1))) */
 	x >>= fracBits;
-	
-	/* Ken's trick: clips to [-32768, 32767] */
-	sign = x >> 31;
-	if (sign != (x >> 15))
-		x = sign ^ ((1 << 15) - 1);
 
-	return (short)x;
+	return (short)SAT16(x);
 }
 
 #define MC0M(x)	{ \
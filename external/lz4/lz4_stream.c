@@ -0,0 +1,703 @@
+/*
+ * Streaming LZ4 frame decoder
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <rtthread.h>
+#include "lz4_stream.h"
+
+#if defined(SOC_BF0_HCPU) && defined(BSP_USING_EXT_DMA) && !defined(LZ4S_DISABLE_DMA)
+#define LZ4S_USING_DMA
+#include "bf0_hal.h"
+#include "drv_ext_dma.h"
+#endif
+
+#ifndef LZ4S_DMA_THRESHOLD
+#define LZ4S_DMA_THRESHOLD      (512)   /* copies shorter than it are done by CPU */
+#endif
+
+#define LZ4S_MAGIC              0x184D2204
+#define LZ4S_MAGIC_SKIP         0x184D2A50  /* low 4 bits are any */
+#define LZ4S_MAGIC_LEGACY       0x184C2102
+
+#define LZ4S_FLG_VERSION_MSK    0xC0
+#define LZ4S_FLG_VERSION        0x40
+#define LZ4S_FLG_BLK_CHECKSUM   0x10
+#define LZ4S_FLG_SIZE           0x08
+#define LZ4S_FLG_CHECKSUM       0x04
+#define LZ4S_FLG_RESERVED       0x02
+#define LZ4S_FLG_DICT_ID        0x01
+
+#define LZ4S_BLK_RAW            0x80000000
+
+#define XXH_P1                  2654435761U
+#define XXH_P2                  2246822519U
+#define XXH_P3                  3266489917U
+#define XXH_P4                  668265263U
+#define XXH_P5                  374761393U
+
+enum
+{
+    S_MAGIC,
+    S_HEADER,
+    S_SKIP_SIZE,
+    S_SKIP,
+    S_BLK_SIZE,
+    S_BLK_RAW,
+    S_TOKEN,
+    S_LIT_LEN,
+    S_LIT,
+    S_OFFSET,
+    S_MATCH_LEN,
+    S_MATCH,
+    S_BLK_SUM,
+    S_END_SUM,
+    S_DONE,
+};
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t xxh_rotl(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+static uint32_t xxh_round(uint32_t acc, uint32_t input)
+{
+    acc += input * XXH_P2;
+
+    return xxh_rotl(acc, 13) * XXH_P1;
+}
+
+static void xxh32_init(lz4s_xxh32_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->v[0] = XXH_P1 + XXH_P2;
+    h->v[1] = XXH_P2;
+    h->v[3] = 0 - XXH_P1;
+}
+
+static void xxh32_stripe(lz4s_xxh32_t *h, const uint8_t *p)
+{
+    h->v[0] = xxh_round(h->v[0], rd32(p));
+    h->v[1] = xxh_round(h->v[1], rd32(p + 4));
+    h->v[2] = xxh_round(h->v[2], rd32(p + 8));
+    h->v[3] = xxh_round(h->v[3], rd32(p + 12));
+}
+
+static void xxh32_update(lz4s_xxh32_t *h, const uint8_t *p, uint32_t len)
+{
+    uint8_t *mem = (uint8_t *)h->mem;
+    uint32_t n;
+
+    h->total += len;
+    if (h->mem_size)
+    {
+        n = 16 - h->mem_size;
+        if (n > len)
+            n = len;
+        memcpy(mem + h->mem_size, p, n);
+        h->mem_size += n;
+        p += n;
+        len -= n;
+        if (h->mem_size < 16)
+            return;
+        xxh32_stripe(h, mem);
+        h->mem_size = 0;
+    }
+    for (; len >= 16; p += 16, len -= 16)
+        xxh32_stripe(h, p);
+    memcpy(mem, p, len);
+    h->mem_size = len;
+}
+
+static uint32_t xxh32_digest(const lz4s_xxh32_t *h)
+{
+    const uint8_t *p = (const uint8_t *)h->mem;
+    uint32_t len = h->mem_size;
+    uint32_t r;
+
+    if (h->total >= 16)
+        r = xxh_rotl(h->v[0], 1) + xxh_rotl(h->v[1], 7) + xxh_rotl(h->v[2], 12) + xxh_rotl(h->v[3], 18);
+    else
+        r = h->v[2] + XXH_P5;
+    r += h->total;
+    for (; len >= 4; p += 4, len -= 4)
+        r = xxh_rotl(r + rd32(p) * XXH_P3, 17) * XXH_P4;
+    for (; len; p++, len--)
+        r = xxh_rotl(r + (*p) * XXH_P5, 11) * XXH_P1;
+    r ^= r >> 15;
+    r *= XXH_P2;
+    r ^= r >> 13;
+    r *= XXH_P3;
+    r ^= r >> 16;
+
+    return r;
+}
+
+#ifdef LZ4S_USING_DMA
+static volatile uint8_t lz4s_dma_err;
+
+static void lz4s_dma_err_cb(void)
+{
+    lz4s_dma_err = 1;
+}
+
+static void lz4s_dma_wait(lz4s_t *s)
+{
+    if (!s->dma_len)
+        return;
+
+    EXT_DMA_Wait_ASYNC_Done();
+    mpu_dcache_invalidate(s->dma_dst, s->dma_len);
+    if (lz4s_dma_err)
+        memcpy(s->dma_dst, s->dma_src, s->dma_len);
+    s->dma_len = 0;
+}
+
+/* Start copy by DMA, return 0 if copy is left to CPU */
+static int lz4s_dma_start(lz4s_t *s, uint8_t *dst, const uint8_t *src, uint32_t n)
+{
+    if (n < LZ4S_DMA_THRESHOLD || (((uint32_t)dst | (uint32_t)src | n) & 3) || rt_interrupt_get_nest())
+        return 0;
+    if (EXT_DMA_Config(1, 1) != RT_EOK)
+        return 0;
+
+    EXT_DMA_Register_Callback(EXT_DMA_XFER_CPLT_CB_ID, NULL);
+    EXT_DMA_Register_Callback(EXT_DMA_XFER_ERROR_CB_ID, lz4s_dma_err_cb);
+    lz4s_dma_err = 0;
+    /* literals or earlier output may be still in cache */
+    mpu_dcache_clean((void *)src, n);
+    mpu_dcache_clean(dst, n);
+    s->dma_src = (uint8_t *)src;
+    s->dma_dst = dst;
+    s->dma_len = n;
+    if (EXT_DMA_START_ASYNC((uint32_t)src, (uint32_t)dst, n >> 2) != RT_EOK)
+        lz4s_dma_err = 1;
+
+    return 1;
+}
+#else
+#define lz4s_dma_wait(s)
+#define lz4s_dma_start(s, dst, src, n)  0
+#endif /* LZ4S_USING_DMA */
+
+static void lz4s_copy(lz4s_t *s, uint8_t *dst, const uint8_t *src, uint32_t n)
+{
+    if (!lz4s_dma_start(s, dst, src, n))
+        memcpy(dst, src, n);
+}
+
+/* Hash and write output not flushed yet */
+static int lz4s_flush(lz4s_t *s)
+{
+    uint32_t mask = s->write ? s->win_size - 1 : 0xFFFFFFFF;
+    uint32_t pos, n;
+
+    lz4s_dma_wait(s);
+    while (s->flushed != s->out)
+    {
+        pos = s->flushed & mask;
+        n = s->out - s->flushed;
+        if (s->write && n > s->win_size - pos)
+            n = s->win_size - pos;
+        if (s->flg & LZ4S_FLG_CHECKSUM)
+            xxh32_update(&s->content_hash, s->win + pos, n);
+        if (s->write && s->write(s->user, s->win + pos, n) < 0)
+            return LZ4S_ERR_WRITE;
+        s->flushed += n;
+    }
+
+    return LZ4S_OK;
+}
+
+/* Bytes could be written to window without flush, contiguous from return pointer */
+static uint8_t *lz4s_room(lz4s_t *s, uint32_t *room)
+{
+    uint32_t pos;
+
+    if (!s->write)
+    {
+        *room = s->win_size - s->out;
+        return s->win + s->out;
+    }
+
+    pos = s->out & (s->win_size - 1);
+    *room = s->win_size - (s->out - s->flushed);
+    if (*room > s->win_size - pos)
+        *room = s->win_size - pos;
+
+    return s->win + pos;
+}
+
+static int lz4s_put(lz4s_t *s, const uint8_t *src, uint32_t n)
+{
+    uint32_t room;
+    uint8_t *dst;
+    int r;
+
+    while (n)
+    {
+        lz4s_dma_wait(s);
+        dst = lz4s_room(s, &room);
+        if (!room)
+        {
+            if (!s->write)
+                return LZ4S_ERR_DST_FULL;
+            if ((r = lz4s_flush(s)) < 0)
+                return r;
+            continue;
+        }
+        if (room > n)
+            room = n;
+        lz4s_copy(s, dst, src, room);
+        s->out += room;
+        src += room;
+        n -= room;
+    }
+
+    return LZ4S_OK;
+}
+
+static int lz4s_match(lz4s_t *s, uint32_t n)
+{
+    uint32_t room, pos, i;
+    uint8_t *dst;
+    const uint8_t *src;
+    int r;
+
+    while (n)
+    {
+        lz4s_dma_wait(s);
+        dst = lz4s_room(s, &room);
+        if (!room)
+        {
+            if (!s->write)
+                return LZ4S_ERR_DST_FULL;
+            if ((r = lz4s_flush(s)) < 0)
+                return r;
+            continue;
+        }
+        if (room > n)
+            room = n;
+        if (s->write)
+        {
+            pos = (s->out - s->offset) & (s->win_size - 1);
+            if (room > s->win_size - pos)
+                room = s->win_size - pos;
+            src = s->win + pos;
+        }
+        else
+        {
+            src = dst - s->offset;
+        }
+
+        if (room <= s->offset && (!s->write || room <= s->win_size - s->offset))
+        {
+            lz4s_copy(s, dst, src, room);
+        }
+        else
+        {
+            /* overlapped, forward byte copy repeats the pattern */
+            for (i = 0; i < room; i++)
+                dst[i] = src[i];
+        }
+        s->out += room;
+        n -= room;
+    }
+
+    return LZ4S_OK;
+}
+
+static int lz4s_header(lz4s_t *s)
+{
+    const uint8_t *p = s->field;
+    lz4s_xxh32_t h;
+    uint32_t n = 2;
+    uint8_t bd = p[1];
+
+    if (s->flg & LZ4S_FLG_SIZE)
+    {
+        s->content_size = rd32(p + 2);
+        if (rd32(p + 6))
+            return LZ4S_ERR_UNSUPPORTED;
+        n += 8;
+    }
+    xxh32_init(&h);
+    xxh32_update(&h, p, n);
+    if (((xxh32_digest(&h) >> 8) & 0xFF) != p[n])
+        return LZ4S_ERR_CHECKSUM;
+    if ((bd & 0x8F) || ((bd >> 4) & 7) < 4)
+        return LZ4S_ERR_FORMAT;
+    s->blk_max = 1UL << (8 + 2 * ((bd >> 4) & 7));
+    xxh32_init(&s->content_hash);
+
+    return LZ4S_OK;
+}
+
+/* Field is collected, move to next state */
+static int lz4s_field(lz4s_t *s)
+{
+    uint32_t v = rd32(s->field);
+
+    switch (s->state)
+    {
+    case S_MAGIC:
+        if (v == LZ4S_MAGIC)
+        {
+            s->state = S_HEADER;
+            s->field_need = 2;
+        }
+        else if ((v & 0xFFFFFFF0) == LZ4S_MAGIC_SKIP)
+        {
+            s->state = S_SKIP_SIZE;
+            s->field_need = 4;
+        }
+        else
+        {
+            return v == LZ4S_MAGIC_LEGACY ? LZ4S_ERR_UNSUPPORTED : LZ4S_ERR_FORMAT;
+        }
+        break;
+    case S_HEADER:
+        if (s->field_need == 2)
+        {
+            /* FLG and BD got, collect rest of descriptor */
+            s->flg = s->field[0];
+            if ((s->flg & LZ4S_FLG_VERSION_MSK) != LZ4S_FLG_VERSION || (s->flg & LZ4S_FLG_RESERVED))
+                return LZ4S_ERR_FORMAT;
+            if (s->flg & LZ4S_FLG_DICT_ID)
+                return LZ4S_ERR_UNSUPPORTED;
+            s->field_need = 3 + ((s->flg & LZ4S_FLG_SIZE) ? 8 : 0);
+            return LZ4S_OK;
+        }
+        else
+        {
+            int r = lz4s_header(s);
+
+            if (r < 0)
+                return r;
+            s->state = S_BLK_SIZE;
+            s->field_need = 4;
+        }
+        break;
+    case S_SKIP_SIZE:
+        s->blk_left = v;
+        s->state = S_SKIP;
+        return LZ4S_OK;
+    case S_BLK_SIZE:
+        if (v == 0)
+        {
+            if (s->flg & LZ4S_FLG_CHECKSUM)
+            {
+                s->state = S_END_SUM;
+                s->field_need = 4;
+                break;
+            }
+            s->state = S_DONE;
+            return LZ4S_OK;
+        }
+        s->blk_left = v & ~LZ4S_BLK_RAW;
+        if (s->blk_left > s->blk_max)
+            return LZ4S_ERR_FORMAT;
+        if (s->flg & LZ4S_FLG_BLK_CHECKSUM)
+            xxh32_init(&s->blk_hash);
+        s->state = (v & LZ4S_BLK_RAW) ? S_BLK_RAW : S_TOKEN;
+        return LZ4S_OK;
+    case S_OFFSET:
+        s->offset = s->field[0] | (s->field[1] << 8);
+        if (s->offset == 0 || s->offset > s->out || (s->write && s->offset > s->win_size))
+            return s->offset > s->out ? LZ4S_ERR_FORMAT : LZ4S_ERR_DISTANCE;
+        s->len = (s->token & 15) + 4;
+        s->state = ((s->token & 15) == 15) ? S_MATCH_LEN : S_MATCH;
+        return LZ4S_OK;
+    case S_BLK_SUM:
+        if (v != xxh32_digest(&s->blk_hash))
+            return LZ4S_ERR_CHECKSUM;
+        s->state = S_BLK_SIZE;
+        s->field_need = 4;
+        break;
+    case S_END_SUM:
+    {
+        int r = lz4s_flush(s);
+
+        if (r < 0)
+            return r;
+        if (v != xxh32_digest(&s->content_hash))
+            return LZ4S_ERR_CHECKSUM;
+        s->state = S_DONE;
+        return LZ4S_OK;
+    }
+    default:
+        return LZ4S_ERR_PARAM;
+    }
+    s->field_len = 0;
+
+    return LZ4S_OK;
+}
+
+static void lz4s_block_end(lz4s_t *s, const uint8_t **blk, const uint8_t *p)
+{
+    if (s->flg & LZ4S_FLG_BLK_CHECKSUM)
+        xxh32_update(&s->blk_hash, *blk, p - *blk);
+    *blk = p;
+    if (s->flg & LZ4S_FLG_BLK_CHECKSUM)
+        s->state = S_BLK_SUM;
+    else
+        s->state = S_BLK_SIZE;
+    s->field_len = 0;
+    s->field_need = 4;
+}
+
+int lz4s_init(lz4s_t *s, uint8_t *window, uint32_t size, lz4s_write_t write, void *user)
+{
+    if (!s || !window || !size || (write && (size & (size - 1))))
+        return LZ4S_ERR_PARAM;
+
+    memset(s, 0, sizeof(*s));
+    s->win = window;
+    s->win_size = size;
+    s->write = write;
+    s->user = user;
+    s->state = S_MAGIC;
+    s->field_need = 4;
+
+    return LZ4S_OK;
+}
+
+int lz4s_feed(lz4s_t *s, const void *src, uint32_t size)
+{
+    const uint8_t *p = (const uint8_t *)src;
+    const uint8_t *end = p + size;
+    const uint8_t *blk = p;     /* block data not hashed yet */
+    uint32_t n;
+    int r = LZ4S_OK;
+
+    while (p < end && s->state != S_DONE && r >= 0)
+    {
+        switch (s->state)
+        {
+        case S_MAGIC:
+        case S_HEADER:
+        case S_SKIP_SIZE:
+        case S_BLK_SIZE:
+        case S_BLK_SUM:
+        case S_END_SUM:
+            n = s->field_need - s->field_len;
+            if (n > (uint32_t)(end - p))
+                n = end - p;
+            memcpy(s->field + s->field_len, p, n);
+            p += n;
+            s->field_len += n;
+            if (s->field_len == s->field_need)
+                r = lz4s_field(s);
+            blk = p;
+            continue;
+        case S_SKIP:
+            n = end - p;
+            if (n > s->blk_left)
+                n = s->blk_left;
+            p += n;
+            s->blk_left -= n;
+            if (!s->blk_left)
+            {
+                /* next frame */
+                s->state = S_MAGIC;
+                s->field_len = 0;
+                s->field_need = 4;
+            }
+            blk = p;
+            continue;
+        default:
+            break;
+        }
+
+        /* inside block */
+        if (!s->blk_left)
+        {
+            /* a token without literals may end block */
+            if (s->state != S_TOKEN && !(s->state == S_LIT && !s->len))
+            {
+                r = LZ4S_ERR_FORMAT;
+                break;
+            }
+            lz4s_block_end(s, &blk, p);
+            continue;
+        }
+        n = end - p;
+        if (n > s->blk_left)
+            n = s->blk_left;
+
+        switch (s->state)
+        {
+        case S_BLK_RAW:
+            r = lz4s_put(s, p, n);
+            p += n;
+            s->blk_left -= n;
+            break;
+        case S_TOKEN:
+            s->token = *p++;
+            s->blk_left--;
+            s->len = s->token >> 4;
+            s->state = (s->len == 15) ? S_LIT_LEN : S_LIT;
+            break;
+        case S_LIT_LEN:
+        case S_MATCH_LEN:
+            s->len += *p;
+            s->blk_left--;
+            if (*p++ != 255)
+                s->state = (s->state == S_LIT_LEN) ? S_LIT : S_MATCH;
+            break;
+        case S_LIT:
+            if (n > s->len)
+                n = s->len;
+            r = lz4s_put(s, p, n);
+            p += n;
+            s->blk_left -= n;
+            s->len -= n;
+            if (!s->len)
+            {
+                s->state = S_OFFSET;
+                s->field_len = 0;
+                s->field_need = 2;
+                /* last sequence of block has no match */
+                if (!s->blk_left)
+                    s->state = S_TOKEN;
+            }
+            break;
+        case S_OFFSET:
+            s->field[s->field_len++] = *p++;
+            s->blk_left--;
+            if (s->field_len == s->field_need)
+                r = lz4s_field(s);
+            break;
+        case S_MATCH:
+            r = lz4s_match(s, s->len);
+            s->state = S_TOKEN;
+            break;
+        }
+
+        if ((s->state == S_TOKEN || s->state == S_BLK_RAW) && !s->blk_left && r >= 0)
+            lz4s_block_end(s, &blk, p);
+    }
+
+    if (r >= 0 && s->state >= S_BLK_RAW && s->state <= S_MATCH)
+    {
+        if ((s->flg & LZ4S_FLG_BLK_CHECKSUM) && p > blk)
+            xxh32_update(&s->blk_hash, blk, p - blk);
+        /* match needs no input, finish it if it's the last thing in chunk */
+        if (s->state == S_MATCH)
+        {
+            r = lz4s_match(s, s->len);
+            s->state = S_TOKEN;
+        }
+    }
+    if (r >= 0)
+        r = lz4s_flush(s);
+    else
+        lz4s_dma_wait(s);
+
+    return r < 0 ? r : (int)(p - (const uint8_t *)src);
+}
+
+int lz4s_done(const lz4s_t *s)
+{
+    return s->state == S_DONE;
+}
+
+uint32_t lz4s_output_size(const lz4s_t *s)
+{
+    return s->out;
+}
+
+int lz4s_decompress(const void *src, uint32_t src_size, void *dst, uint32_t dst_size)
+{
+    lz4s_t s;
+    int r;
+
+    r = lz4s_init(&s, (uint8_t *)dst, dst_size, NULL, NULL);
+    if (r == LZ4S_OK)
+        r = lz4s_feed(&s, src, src_size);
+    if (r < 0)
+        return r;
+    if (!lz4s_done(&s))
+        return LZ4S_ERR_TRUNCATED;
+    if ((s.flg & LZ4S_FLG_SIZE) && s.content_size != s.out)
+        return LZ4S_ERR_FORMAT;
+
+    return s.out;
+}
+
+int lz4s_decompress_read(lz4s_read_t read, void *read_user, uint8_t *buf, uint32_t buf_size,
+                         uint8_t *window, uint32_t win_size, lz4s_write_t write, void *user)
+{
+    lz4s_t s;
+    int r, n;
+
+    r = lz4s_init(&s, window, win_size, write, user);
+    while (r >= 0 && !lz4s_done(&s))
+    {
+        n = read(read_user, buf, buf_size);
+        if (n <= 0)
+            return n < 0 ? LZ4S_ERR_READ : LZ4S_ERR_TRUNCATED;
+        r = lz4s_feed(&s, buf, n);
+    }
+    if (r < 0)
+        return r;
+    if ((s.flg & LZ4S_FLG_SIZE) && s.content_size != s.out)
+        return LZ4S_ERR_FORMAT;
+
+    return s.out;
+}
+
+#if defined(RT_USING_FINSH) && defined(RT_USING_DFS)
+#include <dfs_posix.h>
+
+static int lz4s_file_read(void *user, uint8_t *buf, uint32_t size)
+{
+    return read((int)(uint32_t)user, buf, size);
+}
+
+static int lz4s_file_write(void *user, const uint8_t *data, uint32_t size)
+{
+    return write((int)(uint32_t)user, data, size) == (int)size ? 0 : -1;
+}
+
+/* Decompress a frame file with 64KB window and 512 bytes input buffer */
+static int lz4_unpack(int argc, char **argv)
+{
+    uint8_t *win, *buf;
+    int in, out, r;
+    uint32_t t;
+
+    if (argc < 3)
+    {
+        rt_kprintf("usage: lz4_unpack <in.lz4> <out>\n");
+        return -1;
+    }
+    in = open(argv[1], O_RDONLY);
+    out = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC);
+    win = rt_malloc(0x10000 + 512);
+    r = LZ4S_ERR_PARAM;
+    if (in >= 0 && out >= 0 && win)
+    {
+        buf = win + 0x10000;
+        t = rt_tick_get();
+        r = lz4s_decompress_read(lz4s_file_read, (void *)(uint32_t)in, buf, 512, win, 0x10000,
+                                 lz4s_file_write, (void *)(uint32_t)out);
+        rt_kprintf("lz4_unpack %d bytes in %dms\n", r, rt_tick_get() - t);
+    }
+    if (in >= 0)
+        close(in);
+    if (out >= 0)
+        close(out);
+    rt_free(win);
+
+    return r < 0 ? r : 0;
+}
+MSH_CMD_EXPORT(lz4_unpack, decompress LZ4 frame file: lz4_unpack in.lz4 out);
+#endif /* RT_USING_FINSH && RT_USING_DFS */
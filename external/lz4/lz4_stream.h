@@ -0,0 +1,147 @@
+/*
+ * Streaming LZ4 frame decoder
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Decode LZ4 frame (as made by lz4 command line tool) fed in chunks of any size, so that
+ * compressed data could be read from XIP flash in place, from a file or from DFU packets
+ * without loading the whole frame to RAM.
+ *
+ * Output is either
+ *   - a linear buffer which holds whole content, matches are copied inside it, or
+ *   - a ring window with write callback, window size (power of 2, up to 64KB) bounds RAM and
+ *     must be larger than match distance used by encoder, 64KB works for any frame.
+ *
+ * Long copies are done by EXT_DMA if available.
+ */
+
+#ifndef __LZ4_STREAM_H
+#define __LZ4_STREAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LZ4S_OK                 (0)
+#define LZ4S_ERR_FORMAT         (-1)    /* not a LZ4 frame or corrupted data */
+#define LZ4S_ERR_UNSUPPORTED    (-2)    /* dictionary or legacy frame */
+#define LZ4S_ERR_CHECKSUM       (-3)    /* header, block or content checksum mismatch */
+#define LZ4S_ERR_DISTANCE       (-4)    /* match is farther than window */
+#define LZ4S_ERR_DST_FULL       (-5)    /* linear output buffer is too small */
+#define LZ4S_ERR_WRITE          (-6)    /* write callback failed */
+#define LZ4S_ERR_TRUNCATED      (-7)    /* input ended before frame end */
+#define LZ4S_ERR_PARAM          (-8)
+#define LZ4S_ERR_READ           (-9)    /* read callback failed */
+
+/**
+ * @brief Output callback of ring window mode.
+ * @param user - user data given to lz4s_init()
+ * @param data - decoded data
+ * @param size - size of data
+ * @return 0 if successful, negative to abort decoding
+ */
+typedef int (*lz4s_write_t)(void *user, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Input callback of lz4s_decompress_read().
+ * @return bytes read, 0 at end of input, negative for error
+ */
+typedef int (*lz4s_read_t)(void *user, uint8_t *buf, uint32_t size);
+
+typedef struct
+{
+    uint32_t v[4];
+    uint32_t total;
+    uint32_t mem[4];
+    uint32_t mem_size;
+} lz4s_xxh32_t;
+
+/** Decoder state, all fields are private */
+typedef struct
+{
+    uint8_t *win;
+    uint32_t win_size;
+    lz4s_write_t write;
+    void *user;
+    uint32_t out;           /* bytes decoded */
+    uint32_t flushed;       /* bytes given to write callback or hashed */
+
+    uint8_t state;
+    uint8_t flg;
+    uint8_t token;
+    uint8_t field_len;      /* bytes collected in field */
+    uint8_t field_need;
+    uint8_t field[15];
+    uint32_t blk_max;
+    uint32_t blk_left;      /* bytes of current block or skippable frame left */
+    uint32_t len;           /* literal or match length left */
+    uint32_t offset;
+    uint32_t content_size;
+    lz4s_xxh32_t blk_hash;
+    lz4s_xxh32_t content_hash;
+
+    /* pending EXT_DMA copy */
+    uint8_t *dma_src;
+    uint8_t *dma_dst;
+    uint32_t dma_len;
+} lz4s_t;
+
+/**
+ * @brief Initialize decoder for a frame.
+ * @param s - decoder
+ * @param window - linear output buffer if write is NULL, otherwise ring window
+ * @param size - size of output buffer, or window size which must be power of 2
+ * @param write - output callback, NULL for linear output
+ * @param user - user data of write
+ * @return LZ4S_OK or LZ4S_ERR_PARAM
+ */
+int lz4s_init(lz4s_t *s, uint8_t *window, uint32_t size, lz4s_write_t write, void *user);
+
+/**
+ * @brief Feed next chunk of frame, data is decoded and written before return.
+ * @param s - decoder
+ * @param src - chunk, could be in XIP flash
+ * @param size - chunk size
+ * @return bytes consumed, less than size only if frame ends in chunk, negative for error
+ */
+int lz4s_feed(lz4s_t *s, const void *src, uint32_t size);
+
+/**
+ * @brief Check whether whole frame is decoded and verified.
+ * @return 1 if done
+ */
+int lz4s_done(const lz4s_t *s);
+
+/**
+ * @brief Get bytes decoded so far.
+ */
+uint32_t lz4s_output_size(const lz4s_t *s);
+
+/**
+ * @brief Decode a frame in memory (e.g. XIP flash) to linear buffer.
+ * @return decoded size, negative for error
+ */
+int lz4s_decompress(const void *src, uint32_t src_size, void *dst, uint32_t dst_size);
+
+/**
+ * @brief Decode a frame read by callback, e.g. from file.
+ * @param read - input callback
+ * @param read_user - user data of read
+ * @param buf - input buffer, a few hundred bytes are enough
+ * @param buf_size - size of input buffer
+ * @param window - see lz4s_init()
+ * @param win_size - see lz4s_init()
+ * @param write - see lz4s_init()
+ * @param user - see lz4s_init()
+ * @return decoded size, negative for error
+ */
+int lz4s_decompress_read(lz4s_read_t read, void *read_user, uint8_t *buf, uint32_t buf_size,
+                         uint8_t *window, uint32_t win_size, lz4s_write_t write, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LZ4_STREAM_H */
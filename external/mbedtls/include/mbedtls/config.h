@@ -2765,6 +2765,15 @@
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_OID_C
 
+/* SHA-256/AES on AES accelerator and TRNG as entropy source, see library/sifli_alt.c */
+//#define MBEDTLS_SIFLI_HW_ALT
+#ifdef MBEDTLS_SIFLI_HW_ALT
+#define MBEDTLS_SHA256_ALT
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_ENTROPY_HARDWARE_ALT
+#endif
+
 #include "check_config.h"
 
 #endif /* MBEDTLS_CONFIG_H */
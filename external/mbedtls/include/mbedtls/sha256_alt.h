@@ -0,0 +1,51 @@
+/**
+ * \file sha256_alt.h
+ *
+ * \brief SHA-224 and SHA-256 by HASH engine of SiFli AES accelerator
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef MBEDTLS_SHA256_ALT_H
+#define MBEDTLS_SHA256_ALT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          SHA-256 context structure
+ *
+ * \note           Engine is only held during update/finish, intermediate digest is kept in
+ *                 context and loaded back as engine IV, so any number of contexts could be
+ *                 interleaved and a context could be saved by copying it.
+ */
+typedef struct
+{
+    uint32_t total;             /*!< bytes hashed by engine, multiple of 64 */
+    uint32_t state[8];          /*!< intermediate digest state  */
+    uint32_t buffer[16];        /*!< data block being processed, word aligned for DMA */
+    uint32_t len;               /*!< bytes in buffer */
+    int is224;                  /*!< 0 => SHA-256, else SHA-224 */
+}
+mbedtls_sha256_context;
+
+void mbedtls_sha256_init( mbedtls_sha256_context *ctx );
+void mbedtls_sha256_free( mbedtls_sha256_context *ctx );
+void mbedtls_sha256_clone( mbedtls_sha256_context *dst,
+                           const mbedtls_sha256_context *src );
+void mbedtls_sha256_starts( mbedtls_sha256_context *ctx, int is224 );
+void mbedtls_sha256_update( mbedtls_sha256_context *ctx, const unsigned char *input,
+                    size_t ilen );
+void mbedtls_sha256_finish( mbedtls_sha256_context *ctx, unsigned char output[32] );
+
+/* Internal use */
+void mbedtls_sha256_process( mbedtls_sha256_context *ctx, const unsigned char data[64] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* sha256_alt.h */
@@ -0,0 +1,594 @@
+/*
+ *  SHA-256 and AES on SiFli AES accelerator, entropy source on TRNG
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Enabled by MBEDTLS_SIFLI_HW_ALT in config.h. Engine is shared with drv_aes and is only
+ *  held inside a call, contexts keep all state so streams could be interleaved.
+ *  mbedtls_bench is built with or without the option to compare against software path.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <rtthread.h>
+#include "bf0_hal.h"
+
+#include "mbedtls/sha256.h"
+#include "mbedtls/aes.h"
+
+#ifdef MBEDTLS_SIFLI_HW_ALT
+#include "drv_aes.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/entropy_poll.h"
+
+#ifndef SIFLI_ALT_BOUNCE_SIZE
+#define SIFLI_ALT_BOUNCE_SIZE   (512)       /* bytes for unaligned or ITCM data and CTR counter blocks */
+#endif
+#ifndef SIFLI_ALT_DMA_MAX
+#define SIFLI_ALT_DMA_MAX       (0x8000)    /* max bytes of one engine run */
+#endif
+
+/* Engine DMA can't access ITCM, unaligned buffer is copied as well */
+#define SIFLI_ALT_DMA_OK(p)     (((((uint32_t)(p)) & 3) == 0) && !HPSYS_RAM_IN_ITCM((uint32_t)(p)))
+
+/* Only used while engine is locked */
+static uint32_t sifli_alt_bounce[SIFLI_ALT_BOUNCE_SIZE / 4];
+
+static void sifli_alt_zeroize(void *v, size_t n)
+{
+    volatile unsigned char *p = v;
+
+    while (n--)
+        *p++ = 0;
+}
+
+#if defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)
+
+static const uint8_t sha256_empty[2][32] =
+{
+    {
+        0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+        0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55,
+    },
+    {
+        0xd1, 0x4a, 0x02, 0x8c, 0x2a, 0x3a, 0x2b, 0xc9, 0x47, 0x61, 0x02, 0xbb, 0x28, 0x82, 0x34, 0xc4,
+        0x15, 0xa2, 0xb0, 0x1f, 0x82, 0x8e, 0xa6, 0x2a, 0xc5, 0xb3, 0xe4, 0x2f,
+    },
+};
+
+/* Resume from digest in context, size is multiple of 64 unless final. Engine is locked. */
+static void sha256_hw_run(mbedtls_sha256_context *ctx, const unsigned char *data, uint32_t size, int final)
+{
+    uint8_t algo = ctx->is224 ? HASH_ALGO_SHA224 : HASH_ALGO_SHA256;
+    HAL_StatusTypeDef r;
+
+    HAL_HASH_reset();
+    /* length only matters for padding of last block */
+    HAL_HASH_init(ctx->total ? ctx->state : NULL, algo, final ? ctx->total : 0);
+    r = HAL_HASH_run((uint8_t *)data, size, final);
+    RT_ASSERT(HAL_OK == r);
+    HAL_HASH_result((uint8_t *)ctx->state);
+    ctx->total += size;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    sifli_alt_zeroize(ctx, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst,
+                          const mbedtls_sha256_context *src)
+{
+    *dst = *src;
+}
+
+void mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    memset(ctx, 0, sizeof(mbedtls_sha256_context));
+    ctx->is224 = is224;
+}
+
+void mbedtls_sha256_process(mbedtls_sha256_context *ctx, const unsigned char data[64])
+{
+    drv_aes_lock();
+    if (SIFLI_ALT_DMA_OK(data))
+    {
+        sha256_hw_run(ctx, data, 64, 0);
+    }
+    else
+    {
+        memcpy(sifli_alt_bounce, data, 64);
+        sha256_hw_run(ctx, (unsigned char *)sifli_alt_bounce, 64, 0);
+    }
+    drv_aes_unlock();
+}
+
+void mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input,
+                           size_t ilen)
+{
+    size_t n;
+    int locked = 0;
+
+    /* a full block is hashed only when more data follows, so that finish always has data to pad */
+    while (ilen)
+    {
+        if (ctx->len == 64 || (ctx->len == 0 && ilen > 64))
+        {
+            if (!locked)
+            {
+                drv_aes_lock();
+                locked = 1;
+            }
+        }
+        if (ctx->len == 64)
+        {
+            sha256_hw_run(ctx, (unsigned char *)ctx->buffer, 64, 0);
+            ctx->len = 0;
+        }
+        if (ctx->len == 0 && ilen > 64)
+        {
+            n = (ilen - 1) & ~63;
+            if (SIFLI_ALT_DMA_OK(input))
+            {
+                if (n > SIFLI_ALT_DMA_MAX)
+                    n = SIFLI_ALT_DMA_MAX;
+                sha256_hw_run(ctx, input, n, 0);
+            }
+            else
+            {
+                if (n > sizeof(sifli_alt_bounce))
+                    n = sizeof(sifli_alt_bounce);
+                memcpy(sifli_alt_bounce, input, n);
+                sha256_hw_run(ctx, (unsigned char *)sifli_alt_bounce, n, 0);
+            }
+            input += n;
+            ilen -= n;
+            continue;
+        }
+
+        n = 64 - ctx->len;
+        if (n > ilen)
+            n = ilen;
+        memcpy((unsigned char *)ctx->buffer + ctx->len, input, n);
+        ctx->len += n;
+        input += n;
+        ilen -= n;
+    }
+
+    if (locked)
+        drv_aes_unlock();
+}
+
+void mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+    if (ctx->total == 0 && ctx->len == 0)
+    {
+        /* engine can't pad empty message */
+        memcpy(ctx->state, sha256_empty[ctx->is224 ? 1 : 0], 32);
+    }
+    else
+    {
+        drv_aes_lock();
+        sha256_hw_run(ctx, (unsigned char *)ctx->buffer, ctx->len, 1);
+        drv_aes_unlock();
+    }
+    memcpy(output, ctx->state, ctx->is224 ? 28 : 32);
+}
+
+#endif /* MBEDTLS_SHA256_C && MBEDTLS_SHA256_ALT */
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+
+/* Engine is locked, CBC iv is updated for next call */
+static int aes_hw_run(mbedtls_aes_context *ctx, uint32_t hw_mode, int enc, unsigned char iv[16],
+                      const unsigned char *input, unsigned char *output, size_t length)
+{
+    uint32_t iv32[4];
+    unsigned char next_iv[16];
+    unsigned char *in, *out;
+    size_t n;
+
+    while (length)
+    {
+        n = length;
+        if (SIFLI_ALT_DMA_OK(input) && SIFLI_ALT_DMA_OK(output))
+        {
+            if (n > SIFLI_ALT_DMA_MAX)
+                n = SIFLI_ALT_DMA_MAX;
+            in = (unsigned char *)input;
+            out = output;
+        }
+        else
+        {
+            if (n > sizeof(sifli_alt_bounce))
+                n = sizeof(sifli_alt_bounce);
+            memcpy(sifli_alt_bounce, input, n);
+            in = out = (unsigned char *)sifli_alt_bounce;
+        }
+
+        if (iv)
+        {
+            memcpy(iv32, iv, 16);
+            if (!enc)
+                memcpy(next_iv, input + n - 16, 16);
+        }
+        HAL_AES_init(ctx->key, ctx->key_size, iv ? iv32 : NULL, hw_mode);
+        if (HAL_AES_run(enc ? AES_ENC : AES_DEC, in, out, n) != HAL_OK)
+            return MBEDTLS_ERR_AES_HW_ACCEL_FAILED;
+        mpu_dcache_invalidate(out, n);
+        if (out != output)
+            memcpy(output, out, n);
+        if (iv)
+            memcpy(iv, enc ? output + n - 16 : next_iv, 16);
+
+        input += n;
+        output += n;
+        length -= n;
+    }
+
+    return 0;
+}
+
+void mbedtls_aes_lib_init(void)
+{
+}
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_aes_context));
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    sifli_alt_zeroize(ctx, sizeof(mbedtls_aes_context));
+}
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    if (keybits != 128 && keybits != 192 && keybits != 256)
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+
+    ctx->key_size = keybits >> 3;
+    memcpy(ctx->key, key, ctx->key_size);
+
+    return 0;
+}
+
+int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    /* engine derives decryption key schedule itself */
+    return mbedtls_aes_setkey_enc(ctx, key, keybits);
+}
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx,
+                          int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16])
+{
+    int ret;
+
+    drv_aes_lock();
+    ret = aes_hw_run(ctx, AES_MODE_ECB, mode == MBEDTLS_AES_ENCRYPT, NULL, input, output, 16);
+    drv_aes_unlock();
+
+    return ret;
+}
+
+int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    return mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, input, output);
+}
+
+int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    return mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_DECRYPT, input, output);
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_aes_encrypt(mbedtls_aes_context *ctx,
+                         const unsigned char input[16],
+                         unsigned char output[16])
+{
+    mbedtls_internal_aes_encrypt(ctx, input, output);
+}
+
+void mbedtls_aes_decrypt(mbedtls_aes_context *ctx,
+                         const unsigned char input[16],
+                         unsigned char output[16])
+{
+    mbedtls_internal_aes_decrypt(ctx, input, output);
+}
+#endif /* !MBEDTLS_DEPRECATED_REMOVED */
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
+                          int mode,
+                          size_t length,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    int ret;
+
+    if (length % 16)
+        return (MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH);
+
+    drv_aes_lock();
+    ret = aes_hw_run(ctx, AES_MODE_CBC, mode == MBEDTLS_AES_ENCRYPT, iv, input, output, length);
+    drv_aes_unlock();
+
+    return ret;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+int mbedtls_aes_crypt_cfb128(mbedtls_aes_context *ctx,
+                             int mode,
+                             size_t length,
+                             size_t *iv_off,
+                             unsigned char iv[16],
+                             const unsigned char *input,
+                             unsigned char *output)
+{
+    int c;
+    size_t n = *iv_off;
+
+    if (mode == MBEDTLS_AES_DECRYPT)
+    {
+        while (length--)
+        {
+            if (n == 0)
+                mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, iv, iv);
+
+            c = *input++;
+            *output++ = (unsigned char)(c ^ iv[n]);
+            iv[n] = (unsigned char) c;
+
+            n = (n + 1) & 0x0F;
+        }
+    }
+    else
+    {
+        while (length--)
+        {
+            if (n == 0)
+                mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, iv, iv);
+
+            iv[n] = *output++ = (unsigned char)(iv[n] ^ *input++);
+
+            n = (n + 1) & 0x0F;
+        }
+    }
+
+    *iv_off = n;
+
+    return (0);
+}
+
+int mbedtls_aes_crypt_cfb8(mbedtls_aes_context *ctx,
+                           int mode,
+                           size_t length,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output)
+{
+    unsigned char c;
+    unsigned char ov[17];
+
+    while (length--)
+    {
+        memcpy(ov, iv, 16);
+        mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, iv, iv);
+
+        if (mode == MBEDTLS_AES_DECRYPT)
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)(iv[0] ^ *input++);
+
+        if (mode == MBEDTLS_AES_ENCRYPT)
+            ov[16] = c;
+
+        memcpy(iv, ov + 1, 16);
+    }
+
+    return (0);
+}
+#endif /*MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/*
+ * Counter blocks are made in bounce buffer and encrypted by one ECB run, counter is
+ * 128 bit big endian as software path, which engine CTR mode doesn't guarantee.
+ */
+int mbedtls_aes_crypt_ctr(mbedtls_aes_context *ctx,
+                          size_t length,
+                          size_t *nc_off,
+                          unsigned char nonce_counter[16],
+                          unsigned char stream_block[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    unsigned char *ks = (unsigned char *)sifli_alt_bounce;
+    size_t n = *nc_off;
+    size_t blocks, size, i;
+    int ret = 0;
+
+    while (n && length)
+    {
+        *output++ = (unsigned char)(*input++ ^ stream_block[n]);
+        n = (n + 1) & 0x0F;
+        length--;
+    }
+    if (!length)
+    {
+        *nc_off = n;
+        return 0;
+    }
+
+    drv_aes_lock();
+    while (length && !ret)
+    {
+        blocks = (length + 15) >> 4;
+        if (blocks > sizeof(sifli_alt_bounce) / 16)
+            blocks = sizeof(sifli_alt_bounce) / 16;
+        for (i = 0; i < blocks; i++)
+        {
+            memcpy(ks + i * 16, nonce_counter, 16);
+            for (n = 16; n > 0; n--)
+                if (++nonce_counter[n - 1] != 0)
+                    break;
+        }
+        ret = aes_hw_run(ctx, AES_MODE_ECB, 1, NULL, ks, ks, blocks * 16);
+
+        size = blocks * 16;
+        if (size > length)
+            size = length;
+        for (i = 0; i < size; i++)
+            output[i] = (unsigned char)(input[i] ^ ks[i]);
+        memcpy(stream_block, ks + (blocks - 1) * 16, 16);
+        input += size;
+        output += size;
+        length -= size;
+        n = size & 0x0F;
+    }
+    drv_aes_unlock();
+
+    *nc_off = n;
+
+    return ret;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT */
+
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static RNG_HandleTypeDef rng;
+    uint32_t value;
+    size_t n;
+
+    (void)data;
+    *olen = 0;
+    if (rng.Instance == NULL)
+    {
+        rng.Instance = hwp_trng;
+        if (HAL_RNG_Init(&rng) != HAL_OK || HAL_RNG_Generate(&rng, &value, 1) != HAL_OK)
+        {
+            rng.Instance = NULL;
+            return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+        }
+    }
+
+    while (*olen < len)
+    {
+        if (HAL_RNG_Generate(&rng, &value, 0) != HAL_OK)
+            return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+        n = len - *olen;
+        if (n > sizeof(value))
+            n = sizeof(value);
+        memcpy(output + *olen, &value, n);
+        *olen += n;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_ENTROPY_HARDWARE_ALT */
+
+#endif /* MBEDTLS_SIFLI_HW_ALT */
+
+#if defined(RT_USING_FINSH) && defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_AES_C)
+#include <finsh.h>
+
+#ifdef MBEDTLS_SIFLI_HW_ALT
+#define MBEDTLS_BENCH_PATH  "hw"
+#else
+#define MBEDTLS_BENCH_PATH  "sw"
+#endif
+
+#define MBEDTLS_BENCH_TOTAL (256 * 1024)
+
+static uint32_t mbedtls_bench_kbps(uint32_t start)
+{
+    uint32_t us = (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+
+    return us ? (uint32_t)((uint64_t)MBEDTLS_BENCH_TOTAL * 1000000 / 1024 / us) : 0;
+}
+
+static void mbedtls_bench(int argc, char **argv)
+{
+    mbedtls_sha256_context sha;
+    mbedtls_aes_context aes;
+    unsigned char key[32] = {0}, iv[16] = {0}, stream[16], hash[32];
+    unsigned char *buf;
+    uint32_t size = 4096, start, i, j;
+    size_t off;
+
+    if (argc > 1)
+        size = (atoi(argv[1]) + 15) & ~15;
+    if (size < 16 || size > MBEDTLS_BENCH_TOTAL)
+        size = 4096;
+    buf = malloc(size);
+    if (!buf)
+        return;
+    memset(buf, 0x5a, size);
+
+    mbedtls_sha256_init(&sha);
+    start = HAL_GTIMER_READ();
+    mbedtls_sha256_starts(&sha, 0);
+    for (i = 0; i < MBEDTLS_BENCH_TOTAL; i += size)
+        mbedtls_sha256_update(&sha, buf, size);
+    mbedtls_sha256_finish(&sha, hash);
+    rt_kprintf("%s sha256 %dKB/s\n", MBEDTLS_BENCH_PATH, mbedtls_bench_kbps(start));
+    mbedtls_sha256_free(&sha);
+
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < MBEDTLS_BENCH_TOTAL; i += size)
+        for (j = 0; j < size; j += 16)
+            mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, buf + j, buf + j);
+    rt_kprintf("%s aes128 ecb block %dKB/s\n", MBEDTLS_BENCH_PATH, mbedtls_bench_kbps(start));
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < MBEDTLS_BENCH_TOTAL; i += size)
+        mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, size, iv, buf, buf);
+    rt_kprintf("%s aes128 cbc %dKB/s\n", MBEDTLS_BENCH_PATH, mbedtls_bench_kbps(start));
+#endif
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    off = 0;
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < MBEDTLS_BENCH_TOTAL; i += size)
+        mbedtls_aes_crypt_ctr(&aes, size, &off, iv, stream, buf, buf);
+    rt_kprintf("%s aes128 ctr %dKB/s\n", MBEDTLS_BENCH_PATH, mbedtls_bench_kbps(start));
+#endif
+    (void)off;
+    (void)stream;
+    mbedtls_aes_free(&aes);
+    free(buf);
+}
+MSH_CMD_EXPORT(mbedtls_bench, mbedtls SHA-256 / AES throughput: mbedtls_bench [buffer_size]);
+#endif /* RT_USING_FINSH && MBEDTLS_SHA256_C && MBEDTLS_AES_C */
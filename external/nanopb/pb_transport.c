@@ -0,0 +1,294 @@
+/**
+  ******************************************************************************
+  * @file   pb_transport.c
+  * @author Sifli software development team
+  * @brief  nanopb streams over ipc_queue, BLE serial transmission and data service
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <string.h>
+#include "pb_transport.h"
+#ifdef BSP_BLE_SERIAL_TRANSMISSION
+    #include "bf0_sibles_serial_trans_service.h"
+#endif
+
+#ifndef BSP_USING_PC_SIMULATOR
+
+static void ipc_commit(pb_ipc_stream_t *ctx)
+{
+    if (ctx->size > 0)
+    {
+        ipc_queue_write_commit(ctx->handle, ctx->used);
+        ctx->buf = NULL;
+        ctx->size = 0;
+        ctx->used = 0;
+    }
+}
+
+static bool ipc_write_callback(pb_ostream_t *stream, const pb_byte_t *buf, size_t count)
+{
+    pb_ipc_stream_t *ctx = (pb_ipc_stream_t *)stream->state;
+    uint32_t waited = 0;
+    size_t n;
+
+    while (count > 0)
+    {
+        if (ctx->used == ctx->size)
+        {
+            ipc_commit(ctx);
+            ctx->size = ipc_queue_write_reserve(ctx->handle, (void **)&ctx->buf, PB_IPC_CHUNK_SIZE);
+            if (ctx->size == 0)
+            {
+                /* wait receiver to drain tx buffer */
+                if (waited++ >= ctx->timeout)
+                    return false;
+                rt_thread_mdelay(1);
+                continue;
+            }
+        }
+        n = ctx->size - ctx->used;
+        if (n > count)
+            n = count;
+        memcpy(ctx->buf + ctx->used, buf, n);
+        ctx->used += n;
+        buf += n;
+        count -= n;
+    }
+
+    return true;
+}
+
+pb_ostream_t pb_ostream_from_ipc_queue(pb_ipc_stream_t *ctx, ipc_queue_handle_t handle, uint32_t timeout)
+{
+    pb_ostream_t stream = PB_OSTREAM_SIZING;
+
+    memset(ctx, 0, sizeof(pb_ipc_stream_t));
+    ctx->handle = handle;
+    ctx->timeout = timeout;
+    stream.callback = ipc_write_callback;
+    stream.state = ctx;
+    stream.max_size = SIZE_MAX;
+
+    return stream;
+}
+
+bool pb_ipc_ostream_flush(pb_ostream_t *stream)
+{
+    pb_ipc_stream_t *ctx = (pb_ipc_stream_t *)stream->state;
+
+    if (stream->callback != ipc_write_callback)
+        return false;
+    ipc_commit(ctx);
+
+    return true;
+}
+
+static bool ipc_read_callback(pb_istream_t *stream, pb_byte_t *buf, size_t count)
+{
+    pb_ipc_stream_t *ctx = (pb_ipc_stream_t *)stream->state;
+    const void *data;
+    uint32_t waited = 0;
+    size_t n;
+
+    while (count > 0)
+    {
+        n = ipc_queue_read_peek(ctx->handle, &data);
+        if (n == 0)
+        {
+            /* rest of message not arrived yet */
+            if (waited++ >= ctx->timeout)
+                return false;
+            rt_thread_mdelay(1);
+            continue;
+        }
+        if (n > count)
+            n = count;
+        /* buf is NULL if field is skipped */
+        if (buf)
+        {
+            memcpy(buf, data, n);
+            buf += n;
+        }
+        ipc_queue_read_release(ctx->handle, n);
+        count -= n;
+    }
+
+    return true;
+}
+
+pb_istream_t pb_istream_from_ipc_queue(pb_ipc_stream_t *ctx, ipc_queue_handle_t handle, uint32_t timeout)
+{
+    pb_istream_t stream;
+
+    memset(ctx, 0, sizeof(pb_ipc_stream_t));
+    ctx->handle = handle;
+    ctx->timeout = timeout;
+    stream.callback = ipc_read_callback;
+    stream.state = ctx;
+    stream.bytes_left = SIZE_MAX;
+#ifndef PB_NO_ERRMSG
+    stream.errmsg = NULL;
+#endif
+
+    return stream;
+}
+
+bool pb_ipc_encode(ipc_queue_handle_t handle, const pb_msgdesc_t *fields, const void *src, uint32_t timeout)
+{
+    pb_ipc_stream_t ctx;
+    pb_ostream_t stream = pb_ostream_from_ipc_queue(&ctx, handle, timeout);
+    bool ret;
+
+    ret = pb_encode_ex(&stream, fields, src, PB_ENCODE_DELIMITED);
+    /* publish partial message too, receiver fails on it instead of waiting forever */
+    pb_ipc_ostream_flush(&stream);
+
+    return ret;
+}
+
+bool pb_ipc_decode(ipc_queue_handle_t handle, const pb_msgdesc_t *fields, void *dst, uint32_t timeout)
+{
+    pb_ipc_stream_t ctx;
+    pb_istream_t stream = pb_istream_from_ipc_queue(&ctx, handle, timeout);
+
+    return pb_decode_ex(&stream, fields, dst, PB_DECODE_DELIMITED);
+}
+#endif /* !BSP_USING_PC_SIMULATOR */
+
+#ifdef BSP_BLE_SERIAL_TRANSMISSION
+static bool ble_serial_write_callback(pb_ostream_t *stream, const pb_byte_t *buf, size_t count)
+{
+    return ble_serial_tran_stream_write((ble_serial_tran_stream_t *)stream->state, buf, (uint16_t)count) == 0;
+}
+
+int pb_ble_serial_encode(uint8_t handle, uint8_t cate_id, const pb_msgdesc_t *fields, const void *src)
+{
+    ble_serial_tran_stream_t ctx;
+    pb_ostream_t stream = PB_OSTREAM_SIZING;
+    size_t size;
+    int ret;
+
+    /* length is sent in first packet */
+    if (!pb_get_encoded_size(&size, fields, src) || size > UINT16_MAX)
+        return -1;
+
+    ret = ble_serial_tran_stream_begin(&ctx, handle, cate_id, (uint16_t)size);
+    if (ret != 0)
+        return ret;
+
+    stream.callback = ble_serial_write_callback;
+    stream.state = &ctx;
+    stream.max_size = size;
+    pb_encode(&stream, fields, src);
+
+    return ble_serial_tran_stream_end(&ctx);
+}
+#endif /* BSP_BLE_SERIAL_TRANSMISSION */
+
+#ifdef BSP_USING_DATA_SVC
+rt_err_t pb_datac_send(datac_handle_t handle, uint16_t msg_id, const pb_msgdesc_t *fields, const void *src)
+{
+    data_msg_t msg;
+    pb_ostream_t stream;
+    uint8_t *body;
+    size_t size;
+
+    if (!pb_get_encoded_size(&size, fields, src) || size > UINT16_MAX)
+        return -RT_EINVAL;
+
+    body = data_service_init_msg(&msg, msg_id, (uint16_t)size);
+    if (!body)
+        return -RT_ENOMEM;
+    stream = pb_ostream_from_buffer(body, size);
+    if (!pb_encode(&stream, fields, src))
+    {
+        data_service_deinit_msg(&msg);
+        return -RT_ERROR;
+    }
+
+    return datac_send_msg(handle, &msg);
+}
+
+int32_t pb_datas_push(datas_handle_t service, uint16_t msg_id, const pb_msgdesc_t *fields, const void *src)
+{
+    pb_ostream_t stream;
+    uint8_t *buf;
+    size_t size;
+    bool shm = true;
+    int32_t ret;
+
+    if (!pb_get_encoded_size(&size, fields, src))
+        return -RT_EINVAL;
+
+    /* shared memory buffer is handed to other core without copy */
+    buf = data_service_shm_alloc(size);
+    if (!buf)
+    {
+        shm = false;
+        buf = rt_malloc(size);
+        if (!buf)
+            return -RT_ENOMEM;
+    }
+
+    stream = pb_ostream_from_buffer(buf, size);
+    if (!pb_encode(&stream, fields, src))
+        ret = -RT_ERROR;
+    else if (shm)
+        ret = datas_push_msg_to_client_no_copy(service, msg_id, size, buf);
+    else
+        ret = datas_push_msg_to_client(service, msg_id, size, buf);
+
+    if (shm)
+        data_service_shm_free(buf);
+    else
+        rt_free(buf);
+
+    return ret;
+}
+
+bool pb_data_arg_decode(data_callback_arg_t *arg, const pb_msgdesc_t *fields, void *dst)
+{
+    pb_istream_t stream = pb_istream_from_buffer(arg->data, arg->data_len);
+
+    return pb_decode(&stream, fields, dst);
+}
+#endif /* BSP_USING_DATA_SVC */
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * @file   pb_transport.h
+  * @author Sifli software development team
+  * @brief  nanopb streams over ipc_queue, BLE serial transmission and data service
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PB_TRANSPORT_H
+#define PB_TRANSPORT_H
+
+#include <rtthread.h>
+#include "pb_encode.h"
+#include "pb_decode.h"
+
+/*
+ * Messages are encoded directly into the transport and decoded directly from it,
+ * so no buffer of the whole encoded message is needed on either side. Together with
+ * pb_callback_t fields, repeated fields such as sensor batches are produced and
+ * consumed item by item with only a small fixed buffer.
+ *
+ * Transports which need the message length in advance get it by a sizing pass.
+ */
+
+#ifndef BSP_USING_PC_SIMULATOR
+#include "ipc_queue.h"
+
+/** Size of tx buffer reserved at a time, it's published to receiver once full */
+#ifndef PB_IPC_CHUNK_SIZE
+    #define PB_IPC_CHUNK_SIZE   (128)
+#endif
+
+typedef struct
+{
+    ipc_queue_handle_t handle;
+    uint32_t timeout;       /**< ms to wait for tx space or rx data */
+    uint8_t *buf;           /**< reserved tx space */
+    size_t size;            /**< size of reserved tx space */
+    size_t used;            /**< bytes filled in reserved tx space */
+} pb_ipc_stream_t;
+
+/**
+ * @brief Create output stream writing to ipc queue, call pb_ipc_ostream_flush() after encoding
+ * @param[out] ctx stream state, must be kept until stream is flushed
+ * @param[in] handle ipc queue
+ * @param[in] timeout ms to wait if tx buffer is full
+ * @return output stream
+ */
+pb_ostream_t pb_ostream_from_ipc_queue(pb_ipc_stream_t *ctx, ipc_queue_handle_t handle, uint32_t timeout);
+
+/**
+ * @brief Publish data still held in reserved tx space
+ * @param[in] stream stream created by pb_ostream_from_ipc_queue()
+ * @return true if successful
+ */
+bool pb_ipc_ostream_flush(pb_ostream_t *stream);
+
+/**
+ * @brief Create input stream consuming data of ipc queue in place
+ * @param[out] ctx stream state
+ * @param[in] handle ipc queue
+ * @param[in] timeout ms to wait for data not arrived yet
+ * @return input stream
+ */
+pb_istream_t pb_istream_from_ipc_queue(pb_ipc_stream_t *ctx, ipc_queue_handle_t handle, uint32_t timeout);
+
+/**
+ * @brief Encode message with length prefix to ipc queue
+ * @param[in] handle ipc queue
+ * @param[in] fields message descriptor
+ * @param[in] src message
+ * @param[in] timeout ms to wait if tx buffer is full
+ * @return true if successful
+ */
+bool pb_ipc_encode(ipc_queue_handle_t handle, const pb_msgdesc_t *fields, const void *src, uint32_t timeout);
+
+/**
+ * @brief Decode message encoded by pb_ipc_encode(), usually called after rx_ind
+ * @param[in] handle ipc queue
+ * @param[in] fields message descriptor
+ * @param[out] dst message
+ * @param[in] timeout ms to wait for rest of message
+ * @return true if successful
+ */
+bool pb_ipc_decode(ipc_queue_handle_t handle, const pb_msgdesc_t *fields, void *dst, uint32_t timeout);
+#endif /* !BSP_USING_PC_SIMULATOR */
+
+#ifdef BSP_BLE_SERIAL_TRANSMISSION
+/**
+ * @brief Encode message to BLE serial transmission, only one MTU sized packet is buffered
+ *
+ * Received message is assembled by serial transmission service,
+ * decode it by pb_istream_from_buffer(data->data, data->len) in BLE_SERIAL_TRAN_DATA.
+ * @param[in] handle handle for the transmission channel
+ * @param[in] cate_id categoryID
+ * @param[in] fields message descriptor
+ * @param[in] src message
+ * @return encoded length if successful, negative if failed
+ */
+int pb_ble_serial_encode(uint8_t handle, uint8_t cate_id, const pb_msgdesc_t *fields, const void *src);
+#endif /* BSP_BLE_SERIAL_TRANSMISSION */
+
+#ifdef BSP_USING_DATA_SVC
+#include "data_service.h"
+
+/**
+ * @brief Send message to service, encoded once into the message body of exact size
+ * @param[in] handle data service client
+ * @param[in] msg_id message id
+ * @param[in] fields message descriptor
+ * @param[in] src message
+ * @return RT_EOK if successful
+ */
+rt_err_t pb_datac_send(datac_handle_t handle, uint16_t msg_id, const pb_msgdesc_t *fields, const void *src);
+
+/**
+ * @brief Push message to subscribers, encoded once into shared memory pool if available
+ * @param[in] service data service
+ * @param[in] msg_id message id
+ * @param[in] fields message descriptor
+ * @param[in] src message
+ * @return RT_EOK if successful
+ */
+int32_t pb_datas_push(datas_handle_t service, uint16_t msg_id, const pb_msgdesc_t *fields, const void *src);
+
+/**
+ * @brief Decode message received in data service callback
+ * @param[in] arg callback argument
+ * @param[in] fields message descriptor
+ * @param[out] dst message
+ * @return true if successful
+ */
+bool pb_data_arg_decode(data_callback_arg_t *arg, const pb_msgdesc_t *fields, void *dst);
+#endif /* BSP_USING_DATA_SVC */
+
+#endif /* PB_TRANSPORT_H */
@@ -0,0 +1,462 @@
+/**
+  ******************************************************************************
+  * @file   opus_port.c
+  * @author Sifli software development team
+  * @brief Opus decoder in preallocated arena and Ogg Opus stream reader.
+ *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2022 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "bf0_hal.h"
+#include "opus_port.h"
+
+#define DBG_TAG           "opus"
+#define DBG_LVL           DBG_INFO
+#include "rtdbg.h"
+
+/* Oggs page header before lacing values */
+#define OGG_PAGE_HDR      27
+#define OGG_FLAG_CONT     0x01
+#define OGG_FLAG_BOS      0x02
+
+static uint32_t g_dec_arena[(OPUS_PORT_DEC_ARENA_SIZE + 3) / 4];
+static uint8_t g_dec_arena_used;
+
+OpusDecoder *opus_port_decoder_open(opus_int32 fs, int channels, int *error)
+{
+    OpusDecoder *dec = (OpusDecoder *)g_dec_arena;
+    rt_base_t level;
+    int size = opus_decoder_get_size(channels);
+    int err;
+
+    if (!size)
+    {
+        err = OPUS_BAD_ARG;
+        goto Error;
+    }
+    if (size > sizeof(g_dec_arena))
+    {
+        LOG_E("decoder needs %d bytes, OPUS_PORT_DEC_ARENA_SIZE=%d", size, OPUS_PORT_DEC_ARENA_SIZE);
+        err = OPUS_ALLOC_FAIL;
+        goto Error;
+    }
+    level = rt_hw_interrupt_disable();
+    if (g_dec_arena_used)
+    {
+        rt_hw_interrupt_enable(level);
+        LOG_E("decoder arena in use");
+        err = OPUS_ALLOC_FAIL;
+        goto Error;
+    }
+    g_dec_arena_used = 1;
+    rt_hw_interrupt_enable(level);
+
+    err = opus_decoder_init(dec, fs, channels);
+    if (err == OPUS_OK)
+    {
+        if (error)
+            *error = OPUS_OK;
+        return dec;
+    }
+    g_dec_arena_used = 0;
+Error:
+    if (error)
+        *error = err;
+    return NULL;
+}
+
+void opus_port_decoder_close(OpusDecoder *dec)
+{
+    if (dec)
+    {
+        RT_ASSERT(dec == (OpusDecoder *)g_dec_arena);
+        g_dec_arena_used = 0;
+    }
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t get_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t opus_cycles(void)
+{
+#ifdef DWT
+    return HAL_DBG_DWT_GetCycles();
+#else
+    return 0;
+#endif
+}
+
+/* copy to dst or drop if dst is NULL, return bytes got */
+static int in_read(opus_ogg_t *o, uint8_t *dst, int len)
+{
+    int got = 0;
+
+    while (got < len)
+    {
+        if (o->in_pos == o->in_len)
+        {
+            int n = o->read(o->user, o->in, OPUS_OGG_IN_SIZE);
+            if (n <= 0)
+                break;
+            o->in_pos = 0;
+            o->in_len = n;
+        }
+        int n = o->in_len - o->in_pos;
+        if (n > len - got)
+            n = len - got;
+        if (dst)
+            memcpy(dst + got, o->in + o->in_pos, n);
+        o->in_pos += n;
+        got += n;
+    }
+    o->pos += got;
+    return got;
+}
+
+/* return -1 at end of source */
+static int next_page(opus_ogg_t *o)
+{
+    uint8_t hdr[OGG_PAGE_HDR];
+
+    while (1)
+    {
+        if (in_read(o, hdr, 4) != 4)
+            return -1;
+        //resync after seek or corrupted data
+        while (memcmp(hdr, "OggS", 4))
+        {
+            memmove(hdr, hdr + 1, 3);
+            if (in_read(o, hdr + 3, 1) != 1)
+                return -1;
+        }
+        if (in_read(o, hdr + 4, OGG_PAGE_HDR - 4) != OGG_PAGE_HDR - 4
+                || in_read(o, o->lacing, hdr[26]) != hdr[26])
+            return -1;
+        if (hdr[4] != 0)
+            continue;
+        if (o->serial && get_le32(hdr + 14) != o->serial)
+        {
+            //other logical stream
+            uint32_t body = 0;
+            for (int i = 0; i < hdr[26]; i++)
+                body += o->lacing[i];
+            in_read(o, NULL, body);
+            continue;
+        }
+        if (!o->serial)
+            o->serial = get_le32(hdr + 14);
+        o->page_segs = hdr[26];
+        o->seg_idx = 0;
+        if (!(hdr[5] & OGG_FLAG_CONT) && o->pkt_len)
+        {
+            //page with rest of packet is lost
+            o->pkt_len = 0;
+            o->oversize = 0;
+            o->errors++;
+        }
+        else if ((hdr[5] & OGG_FLAG_CONT) && !o->pkt_len)
+        {
+            //rest of packet we have not seen, drop it
+            o->oversize = 1;
+        }
+        return 0;
+    }
+}
+
+/* return packet length, 0 for dropped packet, -1 at end of source */
+static int next_packet(opus_ogg_t *o)
+{
+    while (1)
+    {
+        while (o->seg_idx < o->page_segs)
+        {
+            uint32_t seg = o->lacing[o->seg_idx++];
+            uint8_t *dst = NULL;
+            if (!o->oversize && o->pkt_len + seg <= OPUS_OGG_MAX_PACKET)
+                dst = o->pkt + o->pkt_len;
+            else
+                o->oversize = 1;
+            if (in_read(o, dst, seg) != seg)
+                return -1;
+            o->pkt_len += seg;
+            if (seg < 255)
+            {
+                int len = o->oversize ? 0 : o->pkt_len;
+                o->pkt_len = 0;
+                o->oversize = 0;
+                return len;
+            }
+        }
+        if (next_page(o) < 0)
+            return -1;
+    }
+}
+
+int opus_ogg_open(opus_ogg_t *o, opus_ogg_read_t read, void *user)
+{
+    int len;
+    int err;
+
+    memset(o, 0, offsetof(opus_ogg_t, lacing));
+    o->read = read;
+    o->user = user;
+
+    len = next_packet(o);
+    if (len < 19 || memcmp(o->pkt, "OpusHead", 8) || (o->pkt[8] & 0xF0))
+    {
+        LOG_I("not opus");
+        return OPUS_INVALID_PACKET;
+    }
+    o->channels = o->pkt[9];
+    o->pre_skip = get_le16(o->pkt + 10);
+    o->rate = get_le32(o->pkt + 12);
+    if (o->pkt[18] != 0 || o->channels < 1 || o->channels > 2)
+    {
+        LOG_I("opus mapping %d channels %d not supported", o->pkt[18], o->channels);
+        return OPUS_UNIMPLEMENTED;
+    }
+    //decode at original rate if opus supports it, saves cpu and resampling
+    if (o->rate != 8000 && o->rate != 12000 && o->rate != 16000 && o->rate != 24000)
+        o->rate = 48000;
+
+    o->dec = opus_port_decoder_open(o->rate, o->channels, &err);
+    if (!o->dec)
+        return err;
+    if (get_le16(o->pkt + 16))
+        opus_decoder_ctl(o->dec, OPUS_SET_GAIN((opus_int16)get_le16(o->pkt + 16)));
+
+    //OpusTags, may be large with cover art, dropped
+    if (next_packet(o) < 0)
+    {
+        opus_ogg_close(o);
+        return OPUS_INVALID_PACKET;
+    }
+    o->data_pos = o->pos;
+    opus_ogg_reset(o, o->data_pos);
+    LOG_I("opus rate=%d ch=%d pre_skip=%d data=%d arena=%d/%d", o->rate, o->channels, o->pre_skip,
+          o->data_pos, opus_decoder_get_size(o->channels), OPUS_PORT_DEC_ARENA_SIZE);
+    return OPUS_OK;
+}
+
+void opus_ogg_reset(opus_ogg_t *o, uint32_t pos)
+{
+    o->pos = pos;
+    o->in_pos = 0;
+    o->in_len = 0;
+    o->page_segs = 0;
+    o->seg_idx = 0;
+    o->pkt_len = 0;
+    o->oversize = 0;
+    o->pcm_pos = 0;
+    o->pcm_len = 0;
+    o->skip = (pos == o->data_pos) ? (uint64_t)o->pre_skip * o->rate / 48000 : 0;
+    if (o->dec)
+        opus_decoder_ctl(o->dec, OPUS_RESET_STATE);
+}
+
+int opus_ogg_read_pcm(opus_ogg_t *o, void *buf, int len)
+{
+    uint8_t *out = (uint8_t *)buf;
+    int frame_bytes = o->channels * sizeof(opus_int16);
+    int got = 0;
+
+    while (got + frame_bytes <= len)
+    {
+        if (o->pcm_pos == o->pcm_len)
+        {
+            int pkt_len = next_packet(o);
+            int samples;
+            if (pkt_len < 0)
+                break;
+            uint32_t start = opus_cycles();
+            if (pkt_len)
+                samples = opus_decode(o->dec, o->pkt, pkt_len, o->pcm, OPUS_OGG_PCM_SAMPLES / o->channels, 0);
+            else //dropped packet is concealed with length of last one
+                samples = opus_decode(o->dec, NULL, 0, o->pcm, o->pcm_len ? o->pcm_len : o->rate / 50, 0);
+            o->cycles += opus_cycles() - start;
+            o->packets++;
+            if (samples <= 0 || !pkt_len)
+                o->errors++;
+            if (samples <= 0)
+                continue;
+            o->samples += samples;
+            o->pcm_pos = 0;
+            o->pcm_len = samples;
+            if (o->skip)
+            {
+                uint32_t n = (o->skip < samples) ? o->skip : samples;
+                o->pcm_pos = n;
+                o->skip -= n;
+            }
+            continue;
+        }
+        int n = (o->pcm_len - o->pcm_pos) * frame_bytes;
+        if (n > ((len - got) / frame_bytes) * frame_bytes)
+            n = ((len - got) / frame_bytes) * frame_bytes;
+        memcpy(out + got, o->pcm + o->pcm_pos * o->channels, n);
+        o->pcm_pos += n / frame_bytes;
+        got += n;
+    }
+    return got;
+}
+
+void opus_ogg_close(opus_ogg_t *o)
+{
+    opus_port_decoder_close(o->dec);
+    o->dec = NULL;
+}
+
+int64_t opus_ogg_last_granule(const uint8_t *buf, int len)
+{
+    for (int i = len - OGG_PAGE_HDR; i >= 0; i--)
+    {
+        if (buf[i] == 'O' && !memcmp(buf + i, "OggS", 4) && buf[i + 4] == 0)
+        {
+            int64_t granule = (int64_t)(((uint64_t)get_le32(buf + i + 10) << 32) | get_le32(buf + i + 6));
+            //-1 means no packet ends on this page
+            if (granule != -1)
+                return granule;
+        }
+    }
+    return -1;
+}
+
+#if defined(RT_USING_FINSH) && defined(DWT)
+/* Decode cost of the build, signal is encoded first and not counted */
+static int opus_bench(int argc, char **argv)
+{
+    int channels = (argc > 1) ? atoi(argv[1]) : 1;
+    int seconds = (argc > 2) ? atoi(argv[2]) : 5;
+    int rate = (argc > 3) ? atoi(argv[3]) : 48000;
+    int frame = rate / 50;
+    uint32_t seed = 1;
+    uint64_t cycles = 0;
+    OpusEncoder *enc;
+    OpusDecoder *dec;
+    opus_int16 *pcm;
+    uint8_t *pkt;
+    int err;
+
+    if (channels < 1 || channels > 2 || seconds <= 0)
+    {
+        rt_kprintf("usage: opus_bench [channels] [seconds] [samplerate]\n");
+        return -1;
+    }
+    if (0 == HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    enc = opus_encoder_create(rate, channels, OPUS_APPLICATION_AUDIO, &err);
+    dec = opus_port_decoder_open(rate, channels, &err);
+    pcm = rt_malloc(frame * channels * sizeof(opus_int16));
+    pkt = rt_malloc(OPUS_OGG_MAX_PACKET);
+    if (!enc || !dec || !pcm || !pkt)
+    {
+        rt_kprintf("opus bench init err=%d\n", err);
+        goto Exit;
+    }
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(rate >= 48000 ? 64000 * channels : 32000 * channels));
+
+    for (int i = 0; i < seconds * 50; i++)
+    {
+        //two square tones plus noise, enough to keep all bands busy
+        for (int j = 0; j < frame; j++)
+        {
+            int n = i * frame + j;
+            seed = seed * 1664525 + 1013904223;
+            int s = (((n / 55) & 1) ? 6000 : -6000) + (((n / 7) & 1) ? 3000 : -3000) + ((int32_t)seed >> 20);
+            for (int c = 0; c < channels; c++)
+                pcm[j * channels + c] = (opus_int16)(c ? -s : s);
+        }
+        int len = opus_encode(enc, pcm, frame, pkt, OPUS_OGG_MAX_PACKET);
+        if (len <= 0)
+        {
+            rt_kprintf("opus encode err=%d\n", len);
+            goto Exit;
+        }
+        uint32_t start = opus_cycles();
+        opus_decode(dec, pkt, len, pcm, frame, 0);
+        cycles += opus_cycles() - start;
+    }
+    //cycles per second of audio in millions
+    uint32_t mcps = (uint32_t)(cycles * 100 / seconds / 1000000);
+    rt_kprintf("opus dec %dHz %dch: %d cycles/frame, %d.%02d MCPS, %d.%02d MCPS per channel\n",
+               rate, channels, (uint32_t)(cycles / (seconds * 50)), mcps / 100, mcps % 100,
+               mcps / channels / 100, mcps / channels % 100);
+    rt_kprintf("build: %s%s%s\n",
+#ifdef FIXED_POINT
+               "FIXED_POINT",
+#else
+               "FLOAT",
+#endif
+#ifdef OPUS_ARM_INLINE_EDSP
+               " EDSP",
+#else
+               "",
+#endif
+#ifdef OPUS_ARM_INLINE_ASM
+               " ASM"
+#else
+               ""
+#endif
+              );
+Exit:
+    if (enc)
+        opus_encoder_destroy(enc);
+    opus_port_decoder_close(dec);
+    if (pcm)
+        rt_free(pcm);
+    if (pkt)
+        rt_free(pkt);
+    return 0;
+}
+MSH_CMD_EXPORT(opus_bench, opus_bench [channels] [seconds] [samplerate]: measure decoder MCPS);
+#endif
@@ -0,0 +1,165 @@
+/**
+  ******************************************************************************
+  * @file   opus_port.h
+  * @author Sifli software development team
+  * @brief Opus decoder in preallocated arena and Ogg Opus stream reader.
+ *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2022 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef OPUS_PORT_H
+#define OPUS_PORT_H
+
+#include <stdint.h>
+#include "opus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoder state is placed in a static arena instead of heap, fixed point decoder needs
+   about 14KB for mono and 26KB for stereo. Open fails and logs needed size if too small. */
+#ifndef OPUS_PORT_DEC_ARENA_SIZE
+    #define OPUS_PORT_DEC_ARENA_SIZE    (28 * 1024)
+#endif
+
+/* Longer packets are dropped and concealed */
+#ifndef OPUS_OGG_MAX_PACKET
+    #define OPUS_OGG_MAX_PACKET         1500
+#endif
+
+/* Input is read from source in blocks of this size */
+#ifndef OPUS_OGG_IN_SIZE
+    #define OPUS_OGG_IN_SIZE            512
+#endif
+
+/* Longest frame decoded, 60ms of 48kHz stereo. 120ms frames are dropped. */
+#ifndef OPUS_OGG_PCM_SAMPLES
+    #define OPUS_OGG_PCM_SAMPLES        (2880 * 2)
+#endif
+
+/**
+ * @brief Create decoder in the static arena, only one decoder can use it at a time
+ * @param fs       output samplerate, 8000, 12000, 16000, 24000 or 48000
+ * @param channels 1 or 2
+ * @param error    OPUS_OK or error code if NULL is returned, could be NULL
+ * @return decoder or NULL if arena is in use or too small
+ */
+OpusDecoder *opus_port_decoder_open(opus_int32 fs, int channels, int *error);
+
+/**
+ * @brief Release the arena, decoder needs no other cleanup
+ */
+void opus_port_decoder_close(OpusDecoder *dec);
+
+/**
+ * @brief Read up to len bytes from source
+ * @return bytes read, 0 or negative at end of source
+ */
+typedef int (*opus_ogg_read_t)(void *user, void *buf, int len);
+
+/** Ogg Opus stream (RFC 7845), channel mapping family 0 only */
+typedef struct
+{
+    opus_ogg_read_t read;
+    void        *user;
+    OpusDecoder *dec;
+    opus_int32  rate;           /* output samplerate */
+    uint8_t     channels;
+    uint8_t     page_segs;
+    uint8_t     seg_idx;
+    uint8_t     oversize;       /* packet being collected is longer than pkt */
+    uint32_t    serial;
+    uint32_t    pos;            /* source offset of next byte to parse */
+    uint32_t    data_pos;       /* source offset of first audio page */
+    uint32_t    pre_skip;       /* samples at 48kHz */
+    uint32_t    skip;           /* samples per channel still to drop */
+    uint32_t    pkt_len;
+    uint16_t    in_pos;
+    uint16_t    in_len;
+    uint16_t    pcm_pos;        /* in samples per channel */
+    uint16_t    pcm_len;
+    /* statistics */
+    uint32_t    packets;
+    uint32_t    errors;         /* dropped or corrupted packets */
+    uint32_t    samples;        /* decoded samples per channel */
+    uint64_t    cycles;         /* cpu cycles spent in opus_decode */
+    uint8_t     lacing[255];
+    uint8_t     in[OPUS_OGG_IN_SIZE];
+    uint8_t     pkt[OPUS_OGG_MAX_PACKET];
+    opus_int16  pcm[OPUS_OGG_PCM_SAMPLES];
+} opus_ogg_t;
+
+/**
+ * @brief Parse OpusHead and OpusTags, create decoder by opus_port_decoder_open()
+ * @param o    stream, source must be at start of the Ogg stream
+ * @param read source read function
+ * @param user parameter of read
+ * @return OPUS_OK, o->data_pos is offset of audio data, source must be moved there
+ *         before opus_ogg_read_pcm()
+ */
+int opus_ogg_open(opus_ogg_t *o, opus_ogg_read_t read, void *user);
+
+/**
+ * @brief Decode interleaved 16bit pcm
+ * @return bytes of pcm, less than len only at end of stream
+ */
+int opus_ogg_read_pcm(opus_ogg_t *o, void *buf, int len);
+
+/**
+ * @brief Drop buffered data after source is moved to pos, stream resyncs at next page.
+ *        Pre-skip is applied again if pos is o->data_pos.
+ */
+void opus_ogg_reset(opus_ogg_t *o, uint32_t pos);
+
+void opus_ogg_close(opus_ogg_t *o);
+
+/**
+ * @brief Find granule position of last page in the tail of stream
+ * @return samples at 48kHz including pre-skip, -1 if no complete page header found
+ */
+int64_t opus_ogg_last_granule(const uint8_t *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPUS_PORT_H */
@@ -6,6 +6,11 @@
 #include "quickjs.h"
 #include "cutils.h"
 #include "lvgl_qjs.h"
+#include "qjs_bytecode.h"
+#ifdef QUICKJS_USING_ARENA
+    #include "quickjs-libc.h"
+    #include "qjs_arena.h"
+#endif
 
 #define DBG_TAG           "QJS"
 #define DBG_LVL           DBG_LOG
@@ -18,6 +23,55 @@ static JSRuntime *qjs_rt;
 static  JSContext *qjs_ctx;
 static JSContext * qjs_lv_init(JSRuntime *rt);
 
+#ifdef QUICKJS_USING_ARENA
+/* runtime lives in an arena while any JS app or watch face runs */
+static qjs_arena_t *qjs_arena;
+static int qjs_app_running;
+
+static JSRuntime *qjs_arena_rt(void)
+{
+    JSRuntime *rt;
+
+    qjs_arena = qjs_arena_create("js_app");
+    if (!qjs_arena)
+        return NULL;
+
+    rt = qjs_arena_new_runtime(qjs_arena);
+    if (!rt)
+    {
+        qjs_arena_destroy(qjs_arena);
+        qjs_arena = NULL;
+        return NULL;
+    }
+    js_std_init_handlers(rt);
+
+    return rt;
+}
+
+static void qjs_app_exit(const char *name)
+{
+    qjs_arena_stats_t stats;
+
+    if (!qjs_arena)
+        return;
+
+    qjs_arena_get_stats(qjs_arena, &stats);
+    rt_kprintf("QJS %s: used %d, peak %d, reserved %d\n", name, stats.used, stats.peak, stats.reserved);
+
+    if (--qjs_app_running > 0)
+        return;
+
+    /* last app exits, free runtime and give whole arena back */
+    JS_FreeContext(qjs_ctx);
+    js_std_free_handlers(qjs_rt);
+    JS_FreeRuntime(qjs_rt);
+    qjs_arena_destroy(qjs_arena);
+    qjs_ctx = NULL;
+    qjs_rt = NULL;
+    qjs_arena = NULL;
+}
+#endif
+
 
 /************************* QuickJS application support *******************************************/
 
@@ -29,9 +83,21 @@ static void qjs_app_init(void *param)
 	char* name = (char*)param;
     if (qjs_ctx==NULL) {
 		if (qjs_rt==NULL)
+#ifdef QUICKJS_USING_ARENA
+			qjs_rt = qjs_arena_rt();
+#else
 			qjs_rt = quickjs_rt();
+#endif
         qjs_ctx=qjs_lv_init(qjs_rt);
    	}
+#ifdef QUICKJS_USING_ARENA
+    if (qjs_arena)
+    {
+        qjs_app_running++;
+        /* peak is reported per app when it stops */
+        qjs_arena_reset_peak(qjs_arena);
+    }
+#endif
 	rt_sprintf(cbk_func, "globalThis.%s;", name + sizeof(qjs_app_prefix) - 1);
 	JSValue loaded= JS_Eval(qjs_ctx, cbk_func, strlen(cbk_func),"<input>",0);
     if (JS_VALUE_GET_PTR(loaded)) {
@@ -42,7 +108,7 @@ static void qjs_app_init(void *param)
 		strcat(cbk_func, (const char*)param);
         strcat(cbk_func, "/main.js");
         rt_kprintf("Quick js run %s\n", cbk_func);
-        eval_file(qjs_ctx,(const char *)cbk_func, -1);
+        qjs_bc_eval_file(qjs_ctx, (const char *)cbk_func, -1);
     }
     JS_FreeValue(qjs_ctx, loaded);
 }
@@ -78,6 +144,9 @@ void qjs_msg_handler(gui_app_msg_type_t msg, void *param)
 		rt_kprintf(cbk_func);
 		eval_buf(qjs_ctx, cbk_func, strlen(cbk_func), "<input>", 0);    
 		JS_RunGC(qjs_rt);
+#ifdef QUICKJS_USING_ARENA
+        qjs_app_exit((const char *)param);
+#endif
 #if 1
 		{
 			extern void list_memheap(void);
@@ -0,0 +1,355 @@
+/*
+ * QuickJS arena allocator
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include "quickjs.h"
+#include "cutils.h"
+#include "qjs_arena.h"
+#ifdef QUICKJS_ARENA_POOL
+    #include "mem_pool_mng.h"
+#endif
+
+#define QJS_ARENA_MAGIC     (0x51A40000)
+#define QJS_ARENA_LARGE     (0xFFFF)
+#define QJS_ARENA_ALIGN(x)  (((x) + 7) & ~7)
+
+/* block sizes of classes, multiple of 8 */
+static const uint16_t qjs_arena_class_size[QJS_ARENA_CLASS_NUM] = {16, 24, 32, 48, 64, 96, 128, 192, 256};
+
+/* size and tag are always the two words before user data */
+typedef struct
+{
+    uint32_t size;
+    uint32_t tag;           /* QJS_ARENA_MAGIC | class index or QJS_ARENA_LARGE */
+} qjs_small_hdr_t;
+
+typedef struct qjs_large_hdr
+{
+    struct qjs_large_hdr *prev;
+    struct qjs_large_hdr *next;
+    uint32_t size;
+    uint32_t tag;
+} qjs_large_hdr_t;
+
+typedef struct qjs_chunk
+{
+    struct qjs_chunk *next;
+    uint32_t size;
+    uint64_t data[];
+} qjs_chunk_t;
+
+struct qjs_arena
+{
+    const char *name;
+    struct qjs_arena *next;
+    void *free_list[QJS_ARENA_CLASS_NUM];
+    uint8_t *cur;           /* unused part of latest chunk */
+    uint8_t *end;
+    qjs_chunk_t *chunks;
+    qjs_large_hdr_t *large;
+    qjs_arena_stats_t stats;
+};
+
+static qjs_arena_t *qjs_arena_list;
+
+static void *qjs_arena_sys_alloc(size_t size)
+{
+#ifdef QUICKJS_ARENA_POOL
+    return mem_pool_alloc(QUICKJS_ARENA_POOL, size);
+#else
+    return malloc(size);
+#endif
+}
+
+static void qjs_arena_sys_free(void *p)
+{
+#ifdef QUICKJS_ARENA_POOL
+    mem_pool_free(p);
+#else
+    free(p);
+#endif
+}
+
+static int qjs_arena_class(size_t size)
+{
+    int i;
+
+    for (i = 0; i < QJS_ARENA_CLASS_NUM; i++)
+        if (size <= qjs_arena_class_size[i])
+            return i;
+
+    return -1;
+}
+
+static void qjs_arena_account(qjs_arena_t *arena, int32_t delta)
+{
+    arena->stats.used += delta;
+    if (arena->stats.used > arena->stats.peak)
+        arena->stats.peak = arena->stats.used;
+}
+
+static void *qjs_arena_small_alloc(qjs_arena_t *arena, int cls)
+{
+    uint32_t blk_size = sizeof(qjs_small_hdr_t) + qjs_arena_class_size[cls];
+    qjs_small_hdr_t *hdr;
+    void *p = arena->free_list[cls];
+
+    if (p)
+    {
+        arena->free_list[cls] = *(void **)p;
+        return p;
+    }
+
+    if (arena->cur + blk_size > arena->end)
+    {
+        qjs_chunk_t *chunk = qjs_arena_sys_alloc(sizeof(qjs_chunk_t) + QUICKJS_ARENA_CHUNK_SIZE);
+
+        if (!chunk)
+            return NULL;
+        /* tail of previous chunk is left unused, it's less than one block */
+        chunk->next = arena->chunks;
+        chunk->size = QUICKJS_ARENA_CHUNK_SIZE;
+        arena->chunks = chunk;
+        arena->cur = (uint8_t *)chunk->data;
+        arena->end = arena->cur + QUICKJS_ARENA_CHUNK_SIZE;
+        arena->stats.chunks++;
+        arena->stats.reserved += sizeof(qjs_chunk_t) + QUICKJS_ARENA_CHUNK_SIZE;
+    }
+
+    hdr = (qjs_small_hdr_t *)arena->cur;
+    arena->cur += blk_size;
+    hdr->size = qjs_arena_class_size[cls];
+    hdr->tag = QJS_ARENA_MAGIC | cls;
+
+    return hdr + 1;
+}
+
+static void *qjs_arena_large_alloc(qjs_arena_t *arena, size_t size)
+{
+    qjs_large_hdr_t *hdr;
+
+    size = QJS_ARENA_ALIGN(size);
+    hdr = qjs_arena_sys_alloc(sizeof(qjs_large_hdr_t) + size);
+    if (!hdr)
+        return NULL;
+
+    hdr->size = size;
+    hdr->tag = QJS_ARENA_MAGIC | QJS_ARENA_LARGE;
+    hdr->prev = NULL;
+    hdr->next = arena->large;
+    if (arena->large)
+        arena->large->prev = hdr;
+    arena->large = hdr;
+    arena->stats.large++;
+    arena->stats.reserved += sizeof(qjs_large_hdr_t) + size;
+
+    return hdr + 1;
+}
+
+static size_t qjs_arena_usable_size(const void *ptr)
+{
+    if (!ptr)
+        return 0;
+
+    RT_ASSERT((((const uint32_t *)ptr)[-1] & 0xFFFF0000) == QJS_ARENA_MAGIC);
+
+    return ((const uint32_t *)ptr)[-2];
+}
+
+static void *qjs_arena_malloc(JSMallocState *s, size_t size)
+{
+    qjs_arena_t *arena = s->opaque;
+    int cls = qjs_arena_class(size);
+    void *ptr;
+
+    if (unlikely(s->malloc_size + size > s->malloc_limit))
+        return NULL;
+
+    if (cls >= 0)
+    {
+        ptr = qjs_arena_small_alloc(arena, cls);
+        if (ptr)
+            arena->stats.class_count[cls]++;
+    }
+    else
+    {
+        ptr = qjs_arena_large_alloc(arena, size);
+    }
+
+    if (!ptr)
+        return NULL;
+
+    size = qjs_arena_usable_size(ptr);
+    s->malloc_count++;
+    s->malloc_size += size;
+    qjs_arena_account(arena, size);
+
+    return ptr;
+}
+
+static void qjs_arena_free(JSMallocState *s, void *ptr)
+{
+    qjs_arena_t *arena = s->opaque;
+    uint32_t tag, size;
+
+    if (!ptr)
+        return;
+
+    size = qjs_arena_usable_size(ptr);
+    tag = ((uint32_t *)ptr)[-1] & 0xFFFF;
+    s->malloc_count--;
+    s->malloc_size -= size;
+    qjs_arena_account(arena, -(int32_t)size);
+
+    if (tag == QJS_ARENA_LARGE)
+    {
+        qjs_large_hdr_t *hdr = (qjs_large_hdr_t *)ptr - 1;
+
+        if (hdr->prev)
+            hdr->prev->next = hdr->next;
+        else
+            arena->large = hdr->next;
+        if (hdr->next)
+            hdr->next->prev = hdr->prev;
+        arena->stats.large--;
+        arena->stats.reserved -= sizeof(qjs_large_hdr_t) + size;
+        qjs_arena_sys_free(hdr);
+    }
+    else
+    {
+        *(void **)ptr = arena->free_list[tag];
+        arena->free_list[tag] = ptr;
+        arena->stats.class_count[tag]--;
+    }
+}
+
+static void *qjs_arena_realloc(JSMallocState *s, void *ptr, size_t size)
+{
+    size_t old_size;
+    void *new_ptr;
+
+    if (!ptr)
+        return size ? qjs_arena_malloc(s, size) : NULL;
+
+    if (size == 0)
+    {
+        qjs_arena_free(s, ptr);
+        return NULL;
+    }
+
+    old_size = qjs_arena_usable_size(ptr);
+    /* keep block if it fits and isn't much larger than needed */
+    if (size <= old_size && (old_size <= QJS_ARENA_SMALL_MAX || size > old_size / 2))
+        return ptr;
+
+    new_ptr = qjs_arena_malloc(s, size);
+    if (!new_ptr)
+        return NULL;
+    memcpy(new_ptr, ptr, size < old_size ? size : old_size);
+    qjs_arena_free(s, ptr);
+
+    return new_ptr;
+}
+
+static const JSMallocFunctions qjs_arena_mf =
+{
+    qjs_arena_malloc,
+    qjs_arena_free,
+    qjs_arena_realloc,
+    qjs_arena_usable_size,
+};
+
+qjs_arena_t *qjs_arena_create(const char *name)
+{
+    qjs_arena_t *arena = rt_calloc(1, sizeof(qjs_arena_t));
+
+    if (!arena)
+        return NULL;
+
+    arena->name = name ? name : "qjs";
+    rt_enter_critical();
+    arena->next = qjs_arena_list;
+    qjs_arena_list = arena;
+    rt_exit_critical();
+
+    return arena;
+}
+
+void qjs_arena_destroy(qjs_arena_t *arena)
+{
+    qjs_arena_t **pp;
+
+    if (!arena)
+        return;
+
+    rt_enter_critical();
+    for (pp = &qjs_arena_list; *pp; pp = &(*pp)->next)
+    {
+        if (*pp == arena)
+        {
+            *pp = arena->next;
+            break;
+        }
+    }
+    rt_exit_critical();
+
+    if (arena->stats.used)
+        rt_kprintf("qjs arena %s: %d bytes left by runtime\n", arena->name, arena->stats.used);
+
+    while (arena->large)
+    {
+        qjs_large_hdr_t *next = arena->large->next;
+
+        qjs_arena_sys_free(arena->large);
+        arena->large = next;
+    }
+    while (arena->chunks)
+    {
+        qjs_chunk_t *next = arena->chunks->next;
+
+        qjs_arena_sys_free(arena->chunks);
+        arena->chunks = next;
+    }
+    rt_free(arena);
+}
+
+JSRuntime *qjs_arena_new_runtime(qjs_arena_t *arena)
+{
+    return JS_NewRuntime2(&qjs_arena_mf, arena);
+}
+
+void qjs_arena_get_stats(qjs_arena_t *arena, qjs_arena_stats_t *stats)
+{
+    *stats = arena->stats;
+}
+
+void qjs_arena_reset_peak(qjs_arena_t *arena)
+{
+    arena->stats.peak = arena->stats.used;
+}
+
+#ifdef RT_USING_FINSH
+static int qjs_arena(int argc, char **argv)
+{
+    qjs_arena_t *arena;
+    int i;
+
+    rt_enter_critical();
+    for (arena = qjs_arena_list; arena; arena = arena->next)
+    {
+        rt_kprintf("%s: used %d, peak %d, reserved %d, chunks %d, large %d\n", arena->name,
+                   arena->stats.used, arena->stats.peak, arena->stats.reserved,
+                   arena->stats.chunks, arena->stats.large);
+        for (i = 0; i < QJS_ARENA_CLASS_NUM; i++)
+            rt_kprintf("  %3d: %d\n", qjs_arena_class_size[i], arena->stats.class_count[i]);
+    }
+    rt_exit_critical();
+
+    return 0;
+}
+MSH_CMD_EXPORT(qjs_arena, show QuickJS arena usage);
+#endif
@@ -0,0 +1,70 @@
+/*
+ * QuickJS arena allocator
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * JSMallocFunctions of a runtime which allocate from its own arena: small blocks come from
+ * size class free lists carved from large chunks, bigger ones are allocated separately but
+ * tracked by arena. Destroying arena after JS_FreeRuntime() gives back everything in a few
+ * frees, whatever is left behind by runtime, so shared heap isn't fragmented by an app.
+ *
+ * Chunks come from mem_pool_mng if QUICKJS_ARENA_POOL is defined (a mem_pool_id_t), otherwise
+ * from QuickJS heap.
+ */
+
+#ifndef __QJS_ARENA_H
+#define __QJS_ARENA_H
+
+#include <stdint.h>
+#include "quickjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef QUICKJS_ARENA_CHUNK_SIZE
+    #define QUICKJS_ARENA_CHUNK_SIZE    (16 * 1024)
+#endif
+
+/** Largest block served by size classes, bigger ones are allocated separately */
+#define QJS_ARENA_SMALL_MAX             (256)
+#define QJS_ARENA_CLASS_NUM             (9)
+
+typedef struct qjs_arena qjs_arena_t;
+
+typedef struct
+{
+    uint32_t used;              /* bytes allocated by runtime */
+    uint32_t peak;              /* max used since creation or qjs_arena_reset_peak() */
+    uint32_t reserved;          /* bytes taken from system, chunks and large blocks */
+    uint32_t chunks;
+    uint32_t large;             /* number of large blocks */
+    uint32_t class_count[QJS_ARENA_CLASS_NUM];  /* allocated blocks of each size class */
+} qjs_arena_stats_t;
+
+/**
+ * @brief Create arena.
+ * @param name - name shown in statistics, not copied
+ * @return arena, NULL if no memory
+ */
+qjs_arena_t *qjs_arena_create(const char *name);
+
+/**
+ * @brief Release all memory of arena, runtime created on it must be freed first.
+ */
+void qjs_arena_destroy(qjs_arena_t *arena);
+
+/**
+ * @brief Create runtime allocating from arena.
+ */
+JSRuntime *qjs_arena_new_runtime(qjs_arena_t *arena);
+
+void qjs_arena_get_stats(qjs_arena_t *arena, qjs_arena_stats_t *stats);
+
+void qjs_arena_reset_peak(qjs_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __QJS_ARENA_H */
@@ -0,0 +1,261 @@
+/*
+ * QuickJS bytecode cache
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include "dfs_posix.h"
+#include "quickjs.h"
+#include "quickjs-libc.h"
+#include "cutils.h"
+#include "qjs_bytecode.h"
+
+#define DBG_TAG           "QJS.BC"
+#define DBG_LVL           DBG_INFO
+#include "rtdbg.h"
+
+static uint32_t qjs_bc_version(void)
+{
+    const char *p = JS_GetBytecodeVersion();
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a */
+    while (*p)
+    {
+        hash ^= (uint8_t)*p++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+int qjs_bc_path(const char *js_path, char *bc_path, size_t size)
+{
+    const char *dot = strrchr(js_path, '.');
+    const char *slash = strrchr(js_path, '/');
+    size_t len = strlen(js_path);
+
+    if (dot && (!slash || dot > slash))
+        len = dot - js_path;
+
+    if (len + sizeof(QJS_BC_SUFFIX) > size)
+        return -1;
+
+    memcpy(bc_path, js_path, len);
+    strcpy(bc_path + len, QJS_BC_SUFFIX);
+
+    return 0;
+}
+
+/* bytecode is valid if it's written by this build from current source, source could be
+ * removed after compiling */
+static int qjs_bc_header_valid(const qjs_bc_header_t *hdr, const char *js_path)
+{
+    struct stat st;
+
+    if (hdr->magic != QJS_BC_MAGIC || hdr->version != qjs_bc_version())
+        return 0;
+
+    if (stat(js_path, &st) == 0 &&
+            (hdr->src_size != (uint32_t)st.st_size || hdr->src_mtime != (uint32_t)st.st_mtime))
+        return 0;
+
+    return 1;
+}
+
+/* compile source to function or module, returns exception if it fails */
+static JSValue qjs_bc_compile_source(JSContext *ctx, const char *js_path, int *module)
+{
+    uint8_t *buf;
+    size_t buf_len;
+    JSValue val;
+
+    buf = js_load_file(ctx, &buf_len, js_path);
+    if (!buf)
+        return JS_ThrowReferenceError(ctx, "could not load '%s'", js_path);
+
+    if (*module < 0)
+        *module = has_suffix(js_path, ".mjs") || JS_DetectModule((const char *)buf, buf_len);
+
+    val = JS_Eval(ctx, (const char *)buf, buf_len, js_path,
+                  (*module ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL) | JS_EVAL_FLAG_COMPILE_ONLY);
+    js_free(ctx, buf);
+
+    return val;
+}
+
+static int qjs_bc_write(JSContext *ctx, const char *js_path, JSValueConst val, int module)
+{
+    char bc_path[QJS_BC_PATH_MAX];
+    qjs_bc_header_t hdr;
+    struct stat st;
+    uint8_t *bc;
+    size_t bc_len;
+    int fd, ret = -1;
+
+    if (qjs_bc_path(js_path, bc_path, sizeof(bc_path)) != 0 || stat(js_path, &st) != 0)
+        return -1;
+
+    bc = JS_WriteObject(ctx, &bc_len, val, JS_WRITE_OBJ_BYTECODE);
+    if (!bc)
+        return -1;
+
+    hdr.magic = QJS_BC_MAGIC;
+    hdr.version = qjs_bc_version();
+    hdr.flags = module ? QJS_BC_FLAG_MODULE : 0;
+    hdr.size = bc_len;
+    hdr.src_size = st.st_size;
+    hdr.src_mtime = st.st_mtime;
+
+    fd = open(bc_path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd >= 0)
+    {
+        if (write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) && write(fd, bc, bc_len) == (int)bc_len)
+            ret = 0;
+        close(fd);
+        if (ret != 0)
+            unlink(bc_path);
+    }
+    js_free(ctx, bc);
+
+    if (ret == 0)
+        LOG_I("compiled %s, %d bytes", bc_path, (int)bc_len);
+    else
+        LOG_W("fail to write %s", bc_path);
+
+    return ret;
+}
+
+/* evaluate compiled function or module, val is freed */
+static int qjs_bc_run(JSContext *ctx, JSValue val, int module, int from_bytecode)
+{
+    if (module)
+    {
+        /* dependencies of module read from bytecode are not loaded yet */
+        if (from_bytecode && JS_ResolveModule(ctx, val) < 0)
+        {
+            JS_FreeValue(ctx, val);
+            js_std_dump_error(ctx);
+            return -1;
+        }
+        js_module_set_import_meta(ctx, val, !from_bytecode, TRUE);
+    }
+
+    val = JS_EvalFunction(ctx, val);
+    if (JS_IsException(val))
+    {
+        js_std_dump_error(ctx);
+        return -1;
+    }
+    JS_FreeValue(ctx, val);
+
+    return 0;
+}
+
+int qjs_bc_compile(const char *js_path)
+{
+    JSRuntime *rt;
+    JSContext *ctx;
+    JSValue val;
+    int module = -1;
+    int ret = -1;
+
+    rt = JS_NewRuntime();
+    if (!rt)
+        return -1;
+
+    ctx = JS_NewContext(rt);
+    if (ctx)
+    {
+        val = qjs_bc_compile_source(ctx, js_path, &module);
+        if (JS_IsException(val))
+            js_std_dump_error(ctx);
+        else
+            ret = qjs_bc_write(ctx, js_path, val, module);
+        JS_FreeValue(ctx, val);
+        JS_FreeContext(ctx);
+    }
+    JS_FreeRuntime(rt);
+
+    return ret;
+}
+
+int qjs_bc_eval_file(JSContext *ctx, const char *js_path, int module)
+{
+    char bc_path[QJS_BC_PATH_MAX];
+    qjs_bc_header_t hdr;
+    const uint8_t *bc = NULL;
+    uint8_t *bc_ram = NULL;
+    int flags = JS_READ_OBJ_BYTECODE;
+    JSValue val;
+    int fd = -1;
+
+    if (qjs_bc_path(js_path, bc_path, sizeof(bc_path)) == 0)
+        fd = open(bc_path, O_RDONLY);
+
+    if (fd >= 0)
+    {
+        if (read(fd, &hdr, sizeof(hdr)) == sizeof(hdr) && qjs_bc_header_valid(&hdr, js_path))
+        {
+            uint8_t *addr = NULL;
+
+            if (ioctl(fd, F_GET_PHY_ADDR, &addr) == 0 && addr)
+            {
+                /* XIP, read in place and keep function bytecode there if possible */
+                bc = addr + sizeof(hdr);
+                flags |= JS_READ_OBJ_ROM_DATA;
+            }
+            else
+            {
+                bc_ram = js_malloc(ctx, hdr.size);
+                if (bc_ram && read(fd, bc_ram, hdr.size) == (int)hdr.size)
+                    bc = bc_ram;
+            }
+        }
+        close(fd);
+    }
+
+    if (bc)
+    {
+        val = JS_ReadObject(ctx, bc, hdr.size, flags);
+        if (bc_ram)
+            js_free(ctx, bc_ram);
+
+        if (!JS_IsException(val))
+            return qjs_bc_run(ctx, val, hdr.flags & QJS_BC_FLAG_MODULE, 1);
+
+        js_std_dump_error(ctx);
+        LOG_W("bad bytecode %s, recompile", bc_path);
+    }
+    else if (bc_ram)
+    {
+        js_free(ctx, bc_ram);
+    }
+
+    val = qjs_bc_compile_source(ctx, js_path, &module);
+    if (JS_IsException(val))
+    {
+        js_std_dump_error(ctx);
+        return -1;
+    }
+
+    qjs_bc_write(ctx, js_path, val, module);
+
+    return qjs_bc_run(ctx, val, module, 0);
+}
+
+#ifdef RT_USING_FINSH
+static int qjs_compile(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        rt_kprintf("usage: qjs_compile <script.js>\n");
+        return -1;
+    }
+
+    return qjs_bc_compile(argv[1]);
+}
+MSH_CMD_EXPORT(qjs_compile, compile JS script to bytecode file);
+#endif
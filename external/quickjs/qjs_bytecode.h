@@ -0,0 +1,74 @@
+/*
+ * QuickJS bytecode cache
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * A script is compiled to bytecode once, normally by app installer, and saved next to it,
+ * e.g. "/JA_app/main.js" -> "/JA_app/main.qbc". Launch reads bytecode instead of parsing
+ * source. Bytecode is recompiled if it's written by another QuickJS build (firmware update)
+ * or source is changed after compiling.
+ *
+ * If file system gives physical address of file (contiguous file on XIP flash), bytecode is
+ * read in place, and function bytecode is even kept in flash if QuickJS could use it without
+ * atom relocation. A script mustn't be reinstalled while its functions are alive then.
+ */
+
+#ifndef __QJS_BYTECODE_H
+#define __QJS_BYTECODE_H
+
+#include <stdint.h>
+#include "quickjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QJS_BC_MAGIC            (0x43424A51)    /* "QJBC" */
+#define QJS_BC_SUFFIX           ".qbc"
+#define QJS_BC_FLAG_MODULE      (1 << 0)
+
+#ifndef QJS_BC_PATH_MAX
+    #define QJS_BC_PATH_MAX     (128)
+#endif
+
+/** Header of bytecode file, followed by output of JS_WriteObject() */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;           /* hash of JS_GetBytecodeVersion() */
+    uint32_t flags;             /* QJS_BC_FLAG_xxx */
+    uint32_t size;              /* bytecode size */
+    uint32_t src_size;          /* size and modified time of compiled source */
+    uint32_t src_mtime;
+} qjs_bc_header_t;
+
+/**
+ * @brief Get bytecode file path of a script.
+ * @param js_path - script path
+ * @param bc_path - output path
+ * @param size - size of bc_path
+ * @return 0 if successful
+ */
+int qjs_bc_path(const char *js_path, char *bc_path, size_t size);
+
+/**
+ * @brief Compile script to bytecode file in a temporary runtime, e.g. at install time.
+ * @param js_path - script path
+ * @return 0 if successful
+ */
+int qjs_bc_compile(const char *js_path);
+
+/**
+ * @brief Run script from its bytecode, bytecode is (re)compiled first if missing or stale.
+ * @param ctx - context
+ * @param js_path - script path
+ * @param module - 1 for module, 0 for global script, -1 to detect
+ * @return 0 if successful, -1 if script throws or can't be loaded
+ */
+int qjs_bc_eval_file(JSContext *ctx, const char *js_path, int module);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __QJS_BYTECODE_H */
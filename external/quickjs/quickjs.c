@@ -34874,6 +34874,16 @@ uint8_t *JS_WriteObject(JSContext *ctx, size_t *psize, JSValueConst obj,
     return JS_WriteObject2(ctx, psize, obj, flags, NULL, NULL);
 }
 
+#define BC_STR_(x) #x
+#define BC_STR(x) BC_STR_(x)
+
+/* bytecode format is tied to opcode and atom tables of this build, so the
+   build time of this file identifies it for cached bytecode */
+const char *JS_GetBytecodeVersion(void)
+{
+    return "bc" BC_STR(BC_VERSION) " " __DATE__ " " __TIME__;
+}
+
 typedef struct BCReaderState {
     JSContext *ctx;
     const uint8_t *buf_start, *ptr, *buf_end;
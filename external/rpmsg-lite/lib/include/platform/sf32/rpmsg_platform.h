@@ -51,6 +51,15 @@ int32_t platform_interrupt_disable(uint32_t vector_id);
 int32_t platform_in_isr(void);
 void platform_notify(uint32_t vector_id);
 
+/*
+ * Defer mailbox notification of virtqueues until platform_notify_batch_end(),
+ * so that a burst of rpmsg_lite_send_nocopy() raises one interrupt at the peer.
+ * Could be nested. Allocation of tx buffer may wait for peer to free buffers,
+ * so batch must not hold more than RL_BUFFER_COUNT buffers.
+ */
+void platform_notify_batch_begin(void);
+void platform_notify_batch_end(void);
+
 /* platform low-level time-delay (busy loop) */
 void platform_time_delay(uint32_t num_msec);
 
@@ -19,6 +19,7 @@
 
 #include "ipc_queue.h"
 #include "rtthread.h"
+#include "rthw.h"
 
 
 #ifdef SOC_BF0_HCPU
@@ -37,6 +38,9 @@ static int32_t isr_counter     = 0;
 static int32_t disable_counter = 0;
 static void *platform_lock;
 static ipc_queue_handle_t rpmsg_ipc_queue[RPMSG_IPC_QUEUE_NUM];
+/* nesting of notification batch and virtqueues notified in batch, bit n for queue n */
+static uint32_t notify_batch;
+static uint32_t notify_pending;
 
 #if defined(RL_USE_STATIC_API) && (RL_USE_STATIC_API == 1)
 static LOCK_STATIC_CONTEXT platform_lock_static_ctxt;
@@ -143,21 +147,38 @@ int32_t platform_deinit_interrupt(uint32_t vector_id)
     }
 }
 
+static void platform_kick(uint32_t idx)
+{
+    env_lock_mutex(platform_lock);
+/* Write directly into the Mailbox register, no need to wait until the content is cleared
+   (consumed by the receiver side) because the same value of the virtqueue ID is written
+   into this register when triggering the ISR for the receiver side. The whole queue of
+   received buffers for associated virtqueue is handled in the ISR then. */
+    ipc_queue_write(rpmsg_ipc_queue[idx], NULL, 0, 0);
+
+    env_unlock_mutex(platform_lock);
+}
+
 void platform_notify(uint32_t vector_id)
 {
+    rt_base_t level;
+
     /* Only single RPMsg-Lite instance (LINK_ID) is defined for this dual core device. Extend
        this statement in case multiple instances of RPMsg-Lite are needed. */
     switch (RL_GET_LINK_ID(vector_id))
     {
         case RL_PLATFORM_SF32_M33_M33_LINK_ID:
-            env_lock_mutex(platform_lock);
-/* Write directly into the Mailbox register, no need to wait until the content is cleared
-   (consumed by the receiver side) because the same value of the virtqueue ID is written
-   into this register when triggering the ISR for the receiver side. The whole queue of
-   received buffers for associated virtqueue is handled in the ISR then. */
-            ipc_queue_write(rpmsg_ipc_queue[vector_id & 1], NULL, 0, 0);
-
-            env_unlock_mutex(platform_lock);
+            level = rt_hw_interrupt_disable();
+            if (notify_batch > 0U)
+            {
+                /* receiver handles whole virtqueue in one ISR, one kick at batch end is enough */
+                notify_pending |= 1UL << (vector_id & 1);
+                rt_hw_interrupt_enable(level);
+                return;
+            }
+            rt_hw_interrupt_enable(level);
+
+            platform_kick(vector_id & 1);
             return;
 
         default:
@@ -165,6 +186,38 @@ void platform_notify(uint32_t vector_id)
     }
 }
 
+void platform_notify_batch_begin(void)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    notify_batch++;
+    rt_hw_interrupt_enable(level);
+}
+
+void platform_notify_batch_end(void)
+{
+    rt_base_t level;
+    uint32_t pending = 0;
+
+    level = rt_hw_interrupt_disable();
+    RL_ASSERT(notify_batch > 0U);
+    if (--notify_batch == 0U)
+    {
+        pending = notify_pending;
+        notify_pending = 0;
+    }
+    rt_hw_interrupt_enable(level);
+
+    for (uint32_t i = 0; i < RPMSG_IPC_QUEUE_NUM; i++)
+    {
+        if (pending & (1UL << i))
+        {
+            platform_kick(i);
+        }
+    }
+}
+
 /**
  * platform_time_delay
  *
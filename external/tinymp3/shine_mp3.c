@@ -4,6 +4,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stddef.h>
 #define GRANULE_SIZE  576
 /* Include arch-specific instructions,
  * when defined. */
@@ -170,6 +171,64 @@ static inline uint32_t SWAB32(uint32_t x)
 }
 #define SWAB32 SWAB32
 #endif
+
+#elif defined(__GNUC__) && defined(__thumb2__) && defined(__ARM_FEATURE_DSP)
+/* Cortex-M with DSP extension, e.g. SF32LB52x. Filter and MDCT sums are
+ * accumulated in 64-bit by SMLAL instead of one SMULL + ADD per product. */
+#include <stdint.h>
+
+/* Fractional multiply */
+#define mul(x,y) \
+({ \
+    register int32_t result; \
+    asm ("smmul %0, %2, %1" : "=r" (result) : "r" (x), "r" (y)); \
+    result ;\
+})
+
+#define mulr(x,y) \
+({ \
+    register int32_t result; \
+    asm ("smmulr %0, %2, %1" : "=r" (result) : "r" (x), "r" (y)); \
+    result; \
+})
+
+#define mul0(hi,lo,a,b) \
+    asm ("smull %0, %1, %2, %3" : "=r" (lo), "=r" (hi) : "r" (a), "r" (b))
+
+#define muladd(hi,lo,a,b) \
+    asm ("smlal %0, %1, %2, %3" : "+r" (lo), "+r" (hi) : "r" (a), "r" (b))
+
+#define mulsub(hi,lo,a,b) \
+    asm ("smlal %0, %1, %2, %3" : "+r" (lo), "+r" (hi) : "r" (a), "r" (-(b)))
+
+#define mulz(hi,lo)
+
+#define cmuls(dre, dim, are, aim, bre, bim) \
+do { \
+    register int32_t tre, tim; \
+    asm ( \
+        "smull r3, %0, %2, %4\n\t" \
+        "smlal r3, %0, %3, %5\n\t" \
+        "lsls r3, r3, #1\n\t" \
+        "adc %0, %0, %0\n\t" \
+        "smull r3, %1, %2, %6\n\t" \
+        "smlal r3, %1, %4, %3\n\t" \
+        "lsls r3, r3, #1\n\t" \
+        "adc %1, %1, %1\n\t" \
+        : "=&r" (tre), "=&r" (tim) \
+        : "r" (are), "r" (aim), "r" (bre), "r" (-(bim)), "r" (bim) \
+        : "r3", "cc" \
+    ); \
+    dre = tre; \
+    dim = tim; \
+} while (0)
+
+static inline uint32_t SWAB32(uint32_t x)
+{
+    asm ("rev %0, %1" : "=r" (x) : "r" (x));
+    return x;
+}
+#define SWAB32 SWAB32
 #endif
 
 /* Include and define generic instructions,
@@ -289,7 +348,8 @@ typedef struct {
 
 typedef struct {
     int off[MAX_CHANNELS];
-    int32_t fl[SBLIMIT][64];
+    int sb_limit;                   /* subbands from sb_limit up are not computed */
+    int32_t fl[SBLIMIT][SBLIMIT];   /* symmetric halves of matrix folded, see shine_subband_initialise */
     int32_t x[MAX_CHANNELS][HAN_SIZE];
 } subband_t;
 
@@ -385,8 +445,17 @@ typedef struct shine_global_flags {
     l3loop_t l3loop;
     mdct_t mdct;
     subband_t subband;
+    int tables_ready;
 } shine_global_config;
 
+#ifdef SHINE_STATIC_STATE
+/* One encoder at a time, nothing allocated from heap while recording
+ * and filter tables are built only by the first shine_initialise. */
+static shine_global_config shine_state;
+static unsigned char shine_bs_data[BUFFER_SIZE];
+static uint8_t shine_state_busy;
+#endif
+
 
 void shine_format_bitstream(shine_global_config *config);
 
@@ -837,6 +906,7 @@ void shine_set_config_mpeg_defaults(shine_mpeg_t *mpeg) {
     mpeg->emph = NONE;
     mpeg->copyright = 0;
     mpeg->original = 1;
+    mpeg->bandwidth = 0;
 }
 
 int shine_mpeg_version(int samplerate_index) {
@@ -896,14 +966,38 @@ shine_global_config *shine_initialise(shine_config_t *pub_config) {
     if (shine_check_config(pub_config->wave.samplerate, pub_config->mpeg.bitr) < 0)
         return NULL;
 
+#ifdef SHINE_STATIC_STATE
+    if (shine_state_busy)
+        return NULL;
+    config = &shine_state;
+    shine_state_busy = 1;
+    /* filter tables at the end of config are kept from previous encoder */
+    memset(config, 0, offsetof(shine_global_config, mdct));
+#else
     config = rt_calloc(1, sizeof(shine_global_config));
     if (config == NULL)
         return config;
+#endif
 
-    shine_subband_initialise(config);
-    shine_mdct_initialise(config);
+    if (!config->tables_ready) {
+        shine_subband_initialise(config);
+        shine_mdct_initialise(config);
+        config->tables_ready = 1;
+    } else {
+        memset(config->subband.off, 0, sizeof(config->subband.off));
+        memset(config->subband.x, 0, sizeof(config->subband.x));
+    }
     shine_loop_initialise(config);
 
+    /* Subbands are samplerate / 64 wide, the ones above bandwidth are left 0. */
+    config->subband.sb_limit = SBLIMIT;
+    if (pub_config->mpeg.bandwidth > 0) {
+        int sb_limit = (pub_config->mpeg.bandwidth * 64 + pub_config->wave.samplerate - 1) / pub_config->wave.samplerate;
+
+        if (sb_limit < SBLIMIT)
+            config->subband.sb_limit = (sb_limit > 0) ? sb_limit : 1;
+    }
+
     /* Copy public config. */
     config->wave.channels = pub_config->wave.channels;
     config->wave.samplerate = pub_config->wave.samplerate;
@@ -1005,7 +1099,12 @@ unsigned char *shine_flush(shine_global_config *config, int *written) {
 
 void shine_close(shine_global_config *config) {
     shine_close_bit_stream(&config->bs);
-    free(config);
+#ifdef SHINE_STATIC_STATE
+    RT_ASSERT(config == &shine_state);
+    shine_state_busy = 0;
+#else
+    rt_free(config);
+#endif
 }
 /*
  *  bit_stream.c package
@@ -1026,7 +1125,12 @@ void shine_close(shine_global_config *config) {
 
 /* open the device to write the bit stream into it */
 void shine_open_bit_stream(bitstream_t *bs, int size) {
+#ifdef SHINE_STATIC_STATE
+    RT_ASSERT(size <= BUFFER_SIZE);
+    bs->data = shine_bs_data;
+#else
     bs->data = (unsigned char *) rt_malloc(size * sizeof(unsigned char));
+#endif
     bs->data_size = size;
     bs->data_position = 0;
     bs->cache = 0;
@@ -1035,8 +1139,11 @@ void shine_open_bit_stream(bitstream_t *bs, int size) {
 
 /*close the device containing the bit stream */
 void shine_close_bit_stream(bitstream_t *bs) {
+#ifndef SHINE_STATIC_STATE
     if (bs->data)
         rt_free(bs->data);
+#endif
+    bs->data = NULL;
 }
 
 /*
@@ -2237,32 +2344,37 @@ void shine_mdct_sub(shine_global_config *config, int stride) {
 
             /* Perform imdct of 18 previous subband samples + 18 current subband samples */
             for (band = 0; band < 32; band++) {
-                for (k = 18; k--;) {
-                    mdct_in[k] = config->l3_sb_sample[ch][gr][k][band];
-                    mdct_in[k + 18] = config->l3_sb_sample[ch][gr + 1][k][band];
-                }
+                if (band >= config->subband.sb_limit) {
+                    /* above bandwidth, butterfly below still reduces alias of band - 1 */
+                    memset(mdct_enc[band], 0, sizeof(mdct_enc[band]));
+                } else {
+                    for (k = 18; k--;) {
+                        mdct_in[k] = config->l3_sb_sample[ch][gr][k][band];
+                        mdct_in[k + 18] = config->l3_sb_sample[ch][gr + 1][k][band];
+                    }
 
-                /* Calculation of the MDCT
-                 * In the case of long blocks ( block_type 0,1,3 ) there are
-                 * 36 coefficients in the time domain and 18 in the frequency
-                 * domain.
-                 */
-                for (k = 18; k--;) {
-                    int32_t vm;
-                    uint32_t vm_lo __attribute__((unused));
-
-                    mul0(vm, vm_lo, mdct_in[35], config->mdct.cos_l[k][35]);
-                    for (j = 35; j; j -= 7) {
-                        muladd(vm, vm_lo, mdct_in[j - 1], config->mdct.cos_l[k][j - 1]);
-                        muladd(vm, vm_lo, mdct_in[j - 2], config->mdct.cos_l[k][j - 2]);
-                        muladd(vm, vm_lo, mdct_in[j - 3], config->mdct.cos_l[k][j - 3]);
-                        muladd(vm, vm_lo, mdct_in[j - 4], config->mdct.cos_l[k][j - 4]);
-                        muladd(vm, vm_lo, mdct_in[j - 5], config->mdct.cos_l[k][j - 5]);
-                        muladd(vm, vm_lo, mdct_in[j - 6], config->mdct.cos_l[k][j - 6]);
-                        muladd(vm, vm_lo, mdct_in[j - 7], config->mdct.cos_l[k][j - 7]);
+                    /* Calculation of the MDCT
+                     * In the case of long blocks ( block_type 0,1,3 ) there are
+                     * 36 coefficients in the time domain and 18 in the frequency
+                     * domain.
+                     */
+                    for (k = 18; k--;) {
+                        int32_t vm;
+                        uint32_t vm_lo __attribute__((unused));
+
+                        mul0(vm, vm_lo, mdct_in[35], config->mdct.cos_l[k][35]);
+                        for (j = 35; j; j -= 7) {
+                            muladd(vm, vm_lo, mdct_in[j - 1], config->mdct.cos_l[k][j - 1]);
+                            muladd(vm, vm_lo, mdct_in[j - 2], config->mdct.cos_l[k][j - 2]);
+                            muladd(vm, vm_lo, mdct_in[j - 3], config->mdct.cos_l[k][j - 3]);
+                            muladd(vm, vm_lo, mdct_in[j - 4], config->mdct.cos_l[k][j - 4]);
+                            muladd(vm, vm_lo, mdct_in[j - 5], config->mdct.cos_l[k][j - 5]);
+                            muladd(vm, vm_lo, mdct_in[j - 6], config->mdct.cos_l[k][j - 6]);
+                            muladd(vm, vm_lo, mdct_in[j - 7], config->mdct.cos_l[k][j - 7]);
+                        }
+                        mulz(vm, vm_lo);
+                        mdct_enc[band][k] = vm;
                     }
-                    mulz(vm, vm_lo);
-                    mdct_enc[band][k] = vm;
                 }
 
                 /* Perform aliasing reduction butterfly */
@@ -2309,9 +2421,15 @@ void shine_subband_initialise(shine_global_config *config) {
         memset(config->subband.x[i], 0, sizeof(config->subband.x[i]));
     }
 
+    /* Row i of the 32x64 matrix is cos((2i+1)(16-j)pi/64), so column j equals
+     * column 32-j for j in 0..16, column 96-j is negated column j for j in 33..47
+     * and column 48 is 0. Only columns 0..16 and 33..47 are stored, the windowed
+     * samples are folded the same way in shine_window_filter_subband. */
     for (i = SBLIMIT; i--;)
-        for (j = 64; j--;) {
-            if ((filter = 1e9 * cos((double) ((2 * i + 1) * (16 - j) * PI64))) >= 0)
+        for (j = SBLIMIT; j--;) {
+            int col = (j <= 16) ? j : j + 16;
+
+            if ((filter = 1e9 * cos((double) ((2 * i + 1) * (16 - col) * PI64))) >= 0)
                 modf(filter + 0.5, &filter);
             else
                 modf(filter - 0.5, &filter);
@@ -2337,6 +2455,7 @@ void shine_subband_initialise(shine_global_config *config) {
 void
 shine_window_filter_subband(int16_t **buffer, int32_t s[SBLIMIT], int ch, shine_global_config *config, int stride) {
     int32_t y[64];
+    int32_t yf[SBLIMIT];
     int i, j;
     int16_t *ptr = *buffer;
 
@@ -2373,22 +2492,36 @@ shine_window_filter_subband(int16_t **buffer, int32_t s[SBLIMIT], int ch, shine_
 
     config->subband.off[ch] = (config->subband.off[ch] + 480) & (HAN_SIZE - 1); /* offset is modulo (HAN_SIZE)*/
 
-    for (i = SBLIMIT; i--;) {
+    /* Fold symmetric columns of the matrix, halved so the sums can't overflow,
+     * and the result is doubled back. 32 products per subband instead of 64. */
+    yf[16] = y[16] >> 1;
+    for (i = 16; i--;)
+        yf[i] = (y[i] >> 1) + (y[32 - i] >> 1);
+    for (i = 15; i--;)
+        yf[i + 17] = (y[i + 33] >> 1) - (y[63 - i] >> 1);
+
+    for (i = SBLIMIT; i-- > config->subband.sb_limit;)
+        s[i] = 0;
+
+    for (i = config->subband.sb_limit; i--;) {
         int32_t s_value;
         uint32_t s_value_lo __attribute__((unused));
 
-        mul0(s_value, s_value_lo, config->subband.fl[i][63], y[63]);
-        for (j = 63; j; j -= 7) {
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 1], y[j - 1]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 2], y[j - 2]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 3], y[j - 3]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 4], y[j - 4]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 5], y[j - 5]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 6], y[j - 6]);
-            muladd(s_value, s_value_lo, config->subband.fl[i][j - 7], y[j - 7]);
+        mul0(s_value, s_value_lo, config->subband.fl[i][31], yf[31]);
+        muladd(s_value, s_value_lo, config->subband.fl[i][30], yf[30]);
+        muladd(s_value, s_value_lo, config->subband.fl[i][29], yf[29]);
+        muladd(s_value, s_value_lo, config->subband.fl[i][28], yf[28]);
+        for (j = 28; j; j -= 7) {
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 1], yf[j - 1]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 2], yf[j - 2]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 3], yf[j - 3]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 4], yf[j - 4]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 5], yf[j - 5]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 6], yf[j - 6]);
+            muladd(s_value, s_value_lo, config->subband.fl[i][j - 7], yf[j - 7]);
         }
         mulz(s_value, s_value_lo);
-        s[i] = s_value;
+        s[i] = s_value * 2;
     }
 }
 
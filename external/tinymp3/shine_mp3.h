@@ -48,6 +48,7 @@ typedef struct {
     enum emph emph;      /* De-emphasis */
     int copyright;
     int original;
+    int bandwidth; /* Hz, 0 - full band. Subbands above are not computed, e.g. 7000 for 16k voice */
 } shine_mpeg_t;
 
 typedef struct {
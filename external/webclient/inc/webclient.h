@@ -12,6 +12,7 @@
  * 2018-01-04     aozima       add ipv6 address support.
  * 2018-07-26     chenyong     modify log information
  * 2018-08-07     chenyong     modify header processing
+ * 2026-10-14     SiFli        add keep-alive pool, TLS session cache, body stream and statistics
  */
 
 #ifndef __WEBCLIENT_H__
@@ -79,6 +80,27 @@ extern "C" {
 #define WEBCLIENT_HEADER_BUFSZ         4096
 #define WEBCLIENT_RESPONSE_BUFSZ       4096
 
+/**
+ * Keep-alive connection pool. A connection whose response is read to the end and is not
+ * closed by server ("Connection: close" or HTTP/1.0) is kept by webclient_close() and reused
+ * by next request to same scheme://host:port. With WEBCLIENT_USING_MBED_TLS, TLS sessions
+ * are also cached per host so that a new connection does abbreviated handshake by session
+ * ticket or session ID.
+ */
+//#define WEBCLIENT_USING_KEEPALIVE
+
+#ifndef WEBCLIENT_POOL_SIZE
+#define WEBCLIENT_POOL_SIZE            2        /* idle connections kept */
+#endif
+
+#ifndef WEBCLIENT_POOL_IDLE_MS
+#define WEBCLIENT_POOL_IDLE_MS         30000    /* idle connection is closed after it */
+#endif
+
+#ifndef WEBCLIENT_TLS_CACHE_SIZE
+#define WEBCLIENT_TLS_CACHE_SIZE       2        /* hosts whose TLS session is cached */
+#endif
+
 enum WEBCLIENT_STATUS
 {
     WEBCLIENT_OK,
@@ -128,8 +150,33 @@ struct webclient_session
 #ifdef WEBCLIENT_USING_MBED_TLS
     MbedTLSSession *tls_session;        /* mbedtls connect session */
 #endif
+
+    rt_bool_t keepalive;                /* server keeps connection after response */
+    rt_tick_t start_tick;               /* request start, for time to first byte */
+    int ttfb_ms;                        /* time to first byte of last response */
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    char *pool_key;                     /* scheme://host:port of connection */
+#endif
 };
 
+struct webclient_stats
+{
+    rt_uint32_t connects;               /* new TCP connections */
+    rt_uint32_t reused;                 /* requests sent on pooled connections */
+    rt_uint32_t tls_handshakes;         /* full TLS handshakes */
+    rt_uint32_t tls_resumed;            /* abbreviated TLS handshakes */
+    rt_uint32_t connect_ms;             /* connect and handshake time of last new connection */
+    rt_uint32_t responses;
+    rt_uint32_t ttfb_ms;                /* time to first byte of last response */
+    rt_uint32_t ttfb_total_ms;          /* sum of time to first byte of all responses */
+};
+
+/**
+ * Body data callback of webclient_response_stream().
+ * @return 0 to continue, others to stop reading
+ */
+typedef int (*webclient_body_cb_t)(void *user, const void *data, size_t len);
+
 /* create webclient session and set header response size */
 struct webclient_session *webclient_session_create(size_t header_sz);
 
@@ -166,6 +213,18 @@ int webclient_request_header_add(char **request_header, const char *fmt, ...);
 int webclient_resp_status_get(struct webclient_session *session);
 int webclient_content_length_get(struct webclient_session *session);
 int webclient_send_usermethod(struct webclient_session *session, const char *uri, const void *body, size_t body_len);
+
+/* read response body piece by piece to callback, chunked body is not buffered */
+int webclient_response_stream(struct webclient_session *session, webclient_body_cb_t cb, void *user, void *buffer, size_t size);
+
+/* connection and latency statistics */
+void webclient_stats_get(struct webclient_stats *stats);
+void webclient_stats_reset(void);
+
+#ifdef WEBCLIENT_USING_KEEPALIVE
+/* close all idle connections and drop cached TLS sessions */
+void webclient_pool_flush(void);
+#endif
 #ifdef RT_USING_DFS
 /* file related operations */
 int webclient_get_file(const char *URI, const char *filename);
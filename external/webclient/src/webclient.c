@@ -13,6 +13,7 @@
  * 2018-07-26     chenyong     modify log information
  * 2018-08-07     chenyong     modify header processing
  * 2021-06-09     xiangxistu   add shard download function
+ * 2026-10-14     SiFli        add keep-alive pool, TLS session cache, body stream and statistics
  */
 
 #include <stdio.h>
@@ -47,6 +48,10 @@
 /* default receive or send timeout */
 #define WEBCLIENT_DEFAULT_TIMEO        6
 
+#define WEBCLIENT_TICK_TO_MS(tick)     ((rt_uint32_t)((rt_uint64_t)(tick) * 1000 / RT_TICK_PER_SECOND))
+
+static struct webclient_stats webclient_stats;
+
 extern long int strtol(const char *nptr, char **endptr, int base);
 
 static int webclient_strncasecmp(const char *a, const char *b, size_t n)
@@ -368,6 +373,410 @@ static int webclient_open_tls(struct webclient_session *session, const char *URI
 }
 #endif
 
+#ifdef WEBCLIENT_USING_KEEPALIVE
+struct webclient_pool_entry
+{
+    char *key;                          /* scheme://host:port, NULL for free entry */
+    char *host;
+    int socket;
+#ifdef WEBCLIENT_USING_MBED_TLS
+    MbedTLSSession *tls_session;
+#endif
+    rt_tick_t idle_tick;                /* when connection is put to pool */
+};
+
+static struct webclient_pool_entry webclient_pool[WEBCLIENT_POOL_SIZE];
+
+#ifdef WEBCLIENT_USING_MBED_TLS
+struct webclient_tls_cache_entry
+{
+    char *key;
+    mbedtls_ssl_session session;        /* session ID or ticket of last handshake */
+    rt_tick_t tick;                     /* last use, the oldest one is replaced */
+};
+
+static struct webclient_tls_cache_entry webclient_tls_cache[WEBCLIENT_TLS_CACHE_SIZE];
+#endif
+
+static struct rt_mutex webclient_pool_mutex;
+static rt_bool_t webclient_pool_inited;
+
+static void webclient_pool_lock(void)
+{
+    if (!webclient_pool_inited)
+    {
+        rt_enter_critical();
+        if (!webclient_pool_inited)
+        {
+            rt_mutex_init(&webclient_pool_mutex, "webpool", RT_IPC_FLAG_PRIO);
+            webclient_pool_inited = RT_TRUE;
+        }
+        rt_exit_critical();
+    }
+
+    rt_mutex_take(&webclient_pool_mutex, RT_WAITING_FOREVER);
+}
+
+static void webclient_pool_unlock(void)
+{
+    rt_mutex_release(&webclient_pool_mutex);
+}
+
+/* get "scheme://host:port" part of URI as pool key and the request path */
+static char *webclient_pool_key(const char *URI, const char **request)
+{
+    const char *host_addr = strstr(URI, "://");
+    const char *path_ptr;
+    char *key;
+
+    if (host_addr == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    path_ptr = strstr(host_addr + 3, "/");
+    if (path_ptr == RT_NULL)
+    {
+        path_ptr = URI + strlen(URI);
+    }
+
+    key = web_malloc(path_ptr - URI + 1);
+    if (key)
+    {
+        web_memcpy(key, URI, path_ptr - URI);
+        key[path_ptr - URI] = '\0';
+    }
+    *request = *path_ptr ? path_ptr : "/";
+
+    return key;
+}
+
+/* idle connection must have nothing to read, data or EOF means server closed or broke it */
+static rt_bool_t webclient_socket_idle(int socket)
+{
+    char ch;
+
+    if (recv(socket, &ch, 1, MSG_PEEK | MSG_DONTWAIT) < 0)
+    {
+        return (errno == EWOULDBLOCK || errno == EAGAIN);
+    }
+
+    return RT_FALSE;
+}
+
+static void webclient_pool_entry_close(struct webclient_pool_entry *entry)
+{
+    LOG_D("close idle connection %s.", entry->key);
+
+#ifdef WEBCLIENT_USING_MBED_TLS
+    if (entry->tls_session)
+    {
+        mbedtls_client_close(entry->tls_session);
+    }
+    else
+#endif
+    {
+        closesocket(entry->socket);
+    }
+
+    web_free(entry->key);
+    web_free(entry->host);
+    web_memset(entry, 0x00, sizeof(struct webclient_pool_entry));
+}
+
+/**
+ * get an idle connection to the server of URI from pool.
+ *
+ * @param session webclient session
+ * @param URI the input server URI address
+ *
+ * @return =0: connection is reused
+ *         <0: no idle connection, session pool key is set for a new one
+ */
+static int webclient_pool_take(struct webclient_session *session, const char *URI)
+{
+    rt_tick_t now = rt_tick_get();
+    const char *req_url;
+    char *req_url_new;
+    int rc = -WEBCLIENT_ERROR;
+    int i;
+
+    session->pool_key = webclient_pool_key(URI, &req_url);
+    if (session->pool_key == RT_NULL)
+    {
+        return -WEBCLIENT_ERROR;
+    }
+
+    req_url_new = web_strdup(req_url);
+    if (req_url_new == RT_NULL)
+    {
+        return -WEBCLIENT_NOMEM;
+    }
+
+    webclient_pool_lock();
+    for (i = 0; i < WEBCLIENT_POOL_SIZE; i++)
+    {
+        struct webclient_pool_entry *entry = &webclient_pool[i];
+
+        if (entry->key == RT_NULL)
+        {
+            continue;
+        }
+
+        if (now - entry->idle_tick >= rt_tick_from_millisecond(WEBCLIENT_POOL_IDLE_MS) ||
+            !webclient_socket_idle(entry->socket))
+        {
+            webclient_pool_entry_close(entry);
+            continue;
+        }
+
+        if (rc != WEBCLIENT_OK && strcmp(entry->key, session->pool_key) == 0)
+        {
+            session->socket = entry->socket;
+            session->host = entry->host;
+#ifdef WEBCLIENT_USING_MBED_TLS
+            session->tls_session = entry->tls_session;
+#endif
+            web_free(entry->key);
+            web_memset(entry, 0x00, sizeof(struct webclient_pool_entry));
+            rc = WEBCLIENT_OK;
+        }
+    }
+    webclient_pool_unlock();
+
+    if (rc != WEBCLIENT_OK)
+    {
+        web_free(req_url_new);
+        return rc;
+    }
+
+    session->req_url = req_url_new;
+    session->is_tls = (strncmp(URI, "https://", 8) == 0);
+    webclient_stats.reused++;
+    LOG_D("reuse connection %s.", session->pool_key);
+
+    return WEBCLIENT_OK;
+}
+
+/* check whether response body is read to the end */
+static rt_bool_t webclient_body_done(struct webclient_session *session)
+{
+    if (session->chunk_sz)
+    {
+        /* last chunk is read */
+        return session->chunk_sz < 0;
+    }
+
+    if (session->content_length == 0)
+    {
+        return RT_TRUE;
+    }
+
+    return session->content_length > 0 && session->content_remainder == 0;
+}
+
+/**
+ * put connection of session to pool if it could be reused, the oldest idle one is closed
+ * if pool is full.
+ *
+ * @param session webclient session
+ *
+ * @return RT_TRUE: connection is moved to pool
+ */
+static rt_bool_t webclient_pool_put(struct webclient_session *session)
+{
+    struct webclient_pool_entry *entry = RT_NULL;
+    int i;
+
+    if (!session->keepalive || session->socket < 0 || session->pool_key == RT_NULL ||
+        !webclient_body_done(session))
+    {
+        return RT_FALSE;
+    }
+
+#ifdef WEBCLIENT_USING_MBED_TLS
+    if (session->tls_session && mbedtls_ssl_get_bytes_avail(&session->tls_session->ssl))
+    {
+        return RT_FALSE;
+    }
+#endif
+
+    webclient_pool_lock();
+    for (i = 0; i < WEBCLIENT_POOL_SIZE; i++)
+    {
+        if (webclient_pool[i].key == RT_NULL)
+        {
+            entry = &webclient_pool[i];
+            break;
+        }
+
+        if (entry == RT_NULL || (rt_int32_t)(webclient_pool[i].idle_tick - entry->idle_tick) < 0)
+        {
+            entry = &webclient_pool[i];
+        }
+    }
+
+    if (entry->key)
+    {
+        webclient_pool_entry_close(entry);
+    }
+
+    entry->key = session->pool_key;
+    entry->host = session->host;
+    entry->socket = session->socket;
+#ifdef WEBCLIENT_USING_MBED_TLS
+    entry->tls_session = session->tls_session;
+    session->tls_session = RT_NULL;
+#endif
+    entry->idle_tick = rt_tick_get();
+    webclient_pool_unlock();
+
+    LOG_D("keep connection %s.", session->pool_key);
+
+    session->pool_key = RT_NULL;
+    session->host = RT_NULL;
+    session->socket = -1;
+
+    return RT_TRUE;
+}
+
+#ifdef WEBCLIENT_USING_MBED_TLS
+static struct webclient_tls_cache_entry *webclient_tls_cache_find(const char *key)
+{
+    int i;
+
+    for (i = 0; i < WEBCLIENT_TLS_CACHE_SIZE; i++)
+    {
+        if (webclient_tls_cache[i].key && strcmp(webclient_tls_cache[i].key, key) == 0)
+        {
+            return &webclient_tls_cache[i];
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* offer cached session of the host in client hello, server falls back to full handshake if
+ * it doesn't know the session */
+static void webclient_tls_cache_load(struct webclient_session *session)
+{
+    struct webclient_tls_cache_entry *entry;
+
+    if (session->pool_key == RT_NULL)
+    {
+        return;
+    }
+
+    webclient_pool_lock();
+    entry = webclient_tls_cache_find(session->pool_key);
+    if (entry && mbedtls_ssl_set_session(&session->tls_session->ssl, &entry->session) != 0)
+    {
+        LOG_D("set cached TLS session failed.");
+    }
+    webclient_pool_unlock();
+}
+
+/**
+ * save session of finished handshake to cache.
+ *
+ * @param session webclient session
+ *
+ * @return RT_TRUE: handshake resumed cached session
+ */
+static rt_bool_t webclient_tls_cache_save(struct webclient_session *session)
+{
+    mbedtls_ssl_context *ssl = &session->tls_session->ssl;
+    struct webclient_tls_cache_entry *entry;
+    rt_bool_t resumed = RT_FALSE;
+    int i;
+
+    if (session->pool_key == RT_NULL || ssl->session == RT_NULL)
+    {
+        return RT_FALSE;
+    }
+
+    webclient_pool_lock();
+    entry = webclient_tls_cache_find(session->pool_key);
+    if (entry)
+    {
+        /* server echoes session ID (also the one sent with ticket) in abbreviated handshake */
+        resumed = entry->session.id_len && entry->session.id_len == ssl->session->id_len &&
+                  web_memcmp(entry->session.id, ssl->session->id, ssl->session->id_len) == 0;
+    }
+    else
+    {
+        for (i = 0; i < WEBCLIENT_TLS_CACHE_SIZE; i++)
+        {
+            if (webclient_tls_cache[i].key == RT_NULL)
+            {
+                entry = &webclient_tls_cache[i];
+                break;
+            }
+
+            if (entry == RT_NULL || (rt_int32_t)(webclient_tls_cache[i].tick - entry->tick) < 0)
+            {
+                entry = &webclient_tls_cache[i];
+            }
+        }
+
+        if (entry->key)
+        {
+            web_free(entry->key);
+        }
+        entry->key = web_strdup(session->pool_key);
+    }
+
+    /* server may issue a new ticket in each handshake */
+    mbedtls_ssl_session_free(&entry->session);
+    if (entry->key == RT_NULL || mbedtls_ssl_get_session(ssl, &entry->session) != 0)
+    {
+        mbedtls_ssl_session_free(&entry->session);
+        if (entry->key)
+        {
+            web_free(entry->key);
+            entry->key = RT_NULL;
+        }
+    }
+    entry->tick = rt_tick_get();
+    webclient_pool_unlock();
+
+    LOG_D("TLS handshake %s %s.", session->pool_key, resumed ? "resumed" : "full");
+
+    return resumed;
+}
+#endif /* WEBCLIENT_USING_MBED_TLS */
+
+/**
+ * close all idle connections and drop cached TLS sessions, e.g. when network is changed.
+ */
+void webclient_pool_flush(void)
+{
+    int i;
+
+    webclient_pool_lock();
+    for (i = 0; i < WEBCLIENT_POOL_SIZE; i++)
+    {
+        if (webclient_pool[i].key)
+        {
+            webclient_pool_entry_close(&webclient_pool[i]);
+        }
+    }
+
+#ifdef WEBCLIENT_USING_MBED_TLS
+    for (i = 0; i < WEBCLIENT_TLS_CACHE_SIZE; i++)
+    {
+        if (webclient_tls_cache[i].key)
+        {
+            web_free(webclient_tls_cache[i].key);
+            webclient_tls_cache[i].key = RT_NULL;
+        }
+        mbedtls_ssl_session_free(&webclient_tls_cache[i].session);
+    }
+#endif
+    webclient_pool_unlock();
+}
+#endif /* WEBCLIENT_USING_KEEPALIVE */
+
 /**
  * connect to http server.
  *
@@ -388,6 +797,15 @@ static int webclient_connect(struct webclient_session *session, const char *URI)
     RT_ASSERT(session);
     RT_ASSERT(URI);
 
+    session->start_tick = rt_tick_get();
+
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    if (webclient_pool_take(session, URI) == WEBCLIENT_OK)
+    {
+        return WEBCLIENT_OK;
+    }
+#endif
+
     timeout.tv_sec = WEBCLIENT_DEFAULT_TIMEO;
     timeout.tv_usec = 0;
 
@@ -447,12 +865,27 @@ static int webclient_connect(struct webclient_session *session, const char *URI)
             return -WEBCLIENT_ERROR;
         }
 
+#ifdef WEBCLIENT_USING_KEEPALIVE
+        webclient_tls_cache_load(session);
+#endif
+
         if ((tls_ret = mbedtls_client_connect(session->tls_session)) < 0)
         {
             LOG_E("connect failed, https client connect return: -0x%x", -tls_ret);
             return -WEBCLIENT_CONNECT_FAILED;
         }
 
+#ifdef WEBCLIENT_USING_KEEPALIVE
+        if (webclient_tls_cache_save(session))
+        {
+            webclient_stats.tls_resumed++;
+        }
+        else
+#endif
+        {
+            webclient_stats.tls_handshakes++;
+        }
+
         socket_handle = session->tls_session->server_fd.fd;
 
         /* set recv timeout option */
@@ -463,6 +896,9 @@ static int webclient_connect(struct webclient_session *session, const char *URI)
 
         session->socket = socket_handle;
 
+        webclient_stats.connects++;
+        webclient_stats.connect_ms = WEBCLIENT_TICK_TO_MS(rt_tick_get() - session->start_tick);
+
         return WEBCLIENT_OK;
     }
 #endif
@@ -504,6 +940,9 @@ static int webclient_connect(struct webclient_session *session, const char *URI)
         }
 
         session->socket = socket_handle;
+
+        webclient_stats.connects++;
+        webclient_stats.connect_ms = WEBCLIENT_TICK_TO_MS(rt_tick_get() - session->start_tick);
     }
 
 __exit:
@@ -638,6 +1077,12 @@ static int webclient_send_header(struct webclient_session *session, int method)
 
     header = session->header->buffer;
 
+    /* request on an already connected session, e.g. shard download */
+    if (session->start_tick == 0)
+    {
+        session->start_tick = rt_tick_get();
+    }
+
     if (session->header->length == 0 && method <= WEBCLIENT_GET)
     {
         /* use default header data */
@@ -746,6 +1191,35 @@ __exit:
     return rc;
 }
 
+/* last chunk is read, skip trailer and keep connection if server allows */
+static void webclient_chunk_end(struct webclient_session *session)
+{
+    session->chunk_sz = -1;
+
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    if (session->keepalive)
+    {
+        char line[64];
+        int length;
+
+        /* trailer fields end with an empty line */
+        do
+        {
+            length = webclient_read_line(session, line, sizeof(line));
+        }
+        while (length > 1);
+
+        if (length == 1)
+        {
+            return;
+        }
+    }
+#endif
+
+    closesocket(session->socket);
+    session->socket = -1;
+}
+
 /**
  * resolve server response data.
  *
@@ -779,6 +1253,16 @@ int webclient_handle_response(struct webclient_session *session)
         if (rc < 0)
             break;
 
+        if (session->header->length == 0 && session->start_tick)
+        {
+            session->ttfb_ms = WEBCLIENT_TICK_TO_MS(rt_tick_get() - session->start_tick);
+            session->start_tick = 0;
+
+            webclient_stats.responses++;
+            webclient_stats.ttfb_ms = session->ttfb_ms;
+            webclient_stats.ttfb_total_ms += session->ttfb_ms;
+        }
+
         /* End of headers is a blank line.  exit. */
         if (rc == 0)
             break;
@@ -834,6 +1318,14 @@ int webclient_handle_response(struct webclient_session *session)
     }
     session->content_remainder = session->content_length ? (size_t) session->content_length : 0xFFFFFFFF;
 
+    /* HTTP/1.1 connection is persistent unless server closes it */
+    {
+        const char *connection = webclient_header_fields_get(session, "Connection");
+
+        session->keepalive = (web_memcmp(session->header->buffer, "HTTP/1.1", strlen("HTTP/1.1")) == 0) &&
+                             !(connection && webclient_strncasecmp(connection, "close", strlen("close")) == 0);
+    }
+
     transfer_encoding = webclient_header_fields_get(session, "Transfer-Encoding");
     if (transfer_encoding && strcmp(transfer_encoding, "chunked") == 0)
     {
@@ -844,6 +1336,12 @@ int webclient_handle_response(struct webclient_session *session)
         session->chunk_sz = strtol(line, RT_NULL, 16);
         session->chunk_offset = 0;
         rt_free(line);
+
+        if (session->chunk_sz == 0)
+        {
+            /* empty body */
+            webclient_chunk_end(session);
+        }
     }
 
     if (mime_ptr)
@@ -1298,9 +1796,7 @@ static int webclient_next_chunk(struct webclient_session *session)
     if (session->chunk_sz == 0)
     {
         /* end of chunks */
-        closesocket(session->socket);
-        session->socket = -1;
-        session->chunk_sz = -1;
+        webclient_chunk_end(session);
     }
 
     return session->chunk_sz;
@@ -1518,10 +2014,17 @@ int webclient_write(struct webclient_session *session, const void *buffer, size_
 /* close session socket, free host and request url */
 static int webclient_clean(struct webclient_session *session)
 {
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    /* keep connection for next request if response is complete */
+    webclient_pool_put(session);
+#endif
+
 #ifdef WEBCLIENT_USING_MBED_TLS
     if (session->tls_session)
     {
         mbedtls_client_close(session->tls_session);
+        session->tls_session = RT_NULL;
+        session->socket = -1;
     }
     else
     {
@@ -1551,7 +2054,19 @@ static int webclient_clean(struct webclient_session *session)
         session->req_url = RT_NULL;
     }
 
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    if (session->pool_key)
+    {
+        web_free(session->pool_key);
+        session->pool_key = RT_NULL;
+    }
+#endif
+
     session->content_length = -1;
+    session->chunk_sz = 0;
+    session->chunk_offset = 0;
+    session->keepalive = RT_FALSE;
+    session->start_tick = 0;
 
     return 0;
 }
@@ -1900,3 +2415,114 @@ int webclient_send_usermethod(struct webclient_session *session, const char *uri
     return resp_status;
 }
 
+
+/**
+ * read response body and give it to callback piece by piece, so that a large or chunked
+ * body is handled without buffering it all, chunk framing is removed.
+ *
+ * @param session webclient session
+ * @param cb body data callback, returns non-zero to stop reading
+ * @param user user data of callback
+ * @param buffer read buffer, = NULL: allocate WEBCLIENT_RESPONSE_BUFSZ bytes
+ * @param size read buffer size
+ *
+ * @return <0: read data error
+ *        >=0: body size given to callback
+ */
+int webclient_response_stream(struct webclient_session *session, webclient_body_cb_t cb, void *user, void *buffer, size_t size)
+{
+    unsigned char *buf_ptr = (unsigned char *) buffer;
+    int length, total_read = 0;
+    int rc = WEBCLIENT_OK;
+
+    RT_ASSERT(session);
+    RT_ASSERT(cb);
+
+    if (buf_ptr == RT_NULL)
+    {
+        size = WEBCLIENT_RESPONSE_BUFSZ;
+        buf_ptr = (unsigned char *) web_malloc(size);
+        if (buf_ptr == RT_NULL)
+        {
+            LOG_E("no memory for response stream buffer!");
+            return -WEBCLIENT_NOMEM;
+        }
+    }
+
+    while (1)
+    {
+        length = webclient_read(session, buf_ptr, size);
+        if (length < 0)
+        {
+            rc = length;
+            break;
+        }
+
+        if (length == 0)
+            break;
+
+        total_read += length;
+        if (cb(user, buf_ptr, length) != 0)
+            break;
+    }
+
+    if (buf_ptr != buffer)
+    {
+        web_free(buf_ptr);
+    }
+
+    if (rc < 0)
+    {
+        return rc;
+    }
+
+    return total_read;
+}
+
+/**
+ * get connection and latency statistics of all sessions.
+ *
+ * @param stats statistics output
+ */
+void webclient_stats_get(struct webclient_stats *stats)
+{
+    RT_ASSERT(stats);
+
+    web_memcpy(stats, &webclient_stats, sizeof(struct webclient_stats));
+}
+
+void webclient_stats_reset(void)
+{
+    web_memset(&webclient_stats, 0x00, sizeof(struct webclient_stats));
+}
+
+#ifdef RT_USING_FINSH
+static int web_stats(int argc, char **argv)
+{
+    struct webclient_stats stats;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        webclient_stats_reset();
+        return 0;
+    }
+
+#ifdef WEBCLIENT_USING_KEEPALIVE
+    if (argc > 1 && strcmp(argv[1], "flush") == 0)
+    {
+        webclient_pool_flush();
+        return 0;
+    }
+#endif
+
+    webclient_stats_get(&stats);
+    rt_kprintf("connects       : %d (last %d ms)\n", stats.connects, stats.connect_ms);
+    rt_kprintf("reused         : %d\n", stats.reused);
+    rt_kprintf("tls handshakes : %d full, %d resumed\n", stats.tls_handshakes, stats.tls_resumed);
+    rt_kprintf("responses      : %d, ttfb last %d ms, avg %d ms\n", stats.responses, stats.ttfb_ms,
+               stats.responses ? stats.ttfb_total_ms / stats.responses : 0);
+
+    return 0;
+}
+MSH_CMD_EXPORT(web_stats, webclient statistics: web_stats [reset|flush]);
+#endif
@@ -41,8 +41,30 @@ typedef enum
 {
     /*Play go-back animation*/
     APP_FLAG_GOBACK_ANIM   = 0x01,
+    /*Exited app kept with paused subpages, see warm_app_list*/
+    APP_FLAG_WARM          = 0x02,
+    /*Launched in background by app_schedule_preload*/
+    APP_FLAG_PRELOAD       = 0x04,
 } APP_FLAG_ENUM;
 
+/*Max apps kept in warm_app_list, 0 - disable warm cache*/
+#ifndef GUI_APP_WARM_CACHE_NUM
+    #define GUI_APP_WARM_CACHE_NUM      0
+#endif
+/*Evict warm apps while free heap is lower than it*/
+#ifndef GUI_APP_WARM_CACHE_MIN_FREE
+    #define GUI_APP_WARM_CACHE_MIN_FREE (64 * 1024)
+#endif
+
+/*LVGL allocations in app's handlers go to app's arena, see gui_app_arena.c*/
+#ifdef GUI_APP_SCREEN_ARENA
+    #define APP_ARENA_ENTER(p_app)  void *prev_arena = gui_app_arena_switch((p_app)->arena)
+    #define APP_ARENA_LEAVE()       gui_app_arena_switch(prev_arena)
+#else
+    #define APP_ARENA_ENTER(p_app)
+    #define APP_ARENA_LEAVE()
+#endif
+
 static uint32_t max_running_apps = 2; //!< mainmenu & avtive app
 static uint8_t en_suspend_app = 0; //Save the history of apps stopped by app scheduler when > max_running_apps
 static uint8_t en_check_duplicated_subpage = 1;
@@ -73,6 +95,18 @@ static rt_list_t running_app_list;
 */
 static rt_list_t suspend_app_list;
 
+/*
+    Apps exited by user or preloaded in idle, all subpages are kept paused(or started)
+    with their screens, so they are resumed without calling entry function again.
+
+    sorted by exited time descend, the oldest one is evicted first
+*/
+static rt_list_t warm_app_list;
+static uint32_t warm_cache_num = GUI_APP_WARM_CACHE_NUM;
+static char warm_preload_id[GUI_APP_ID_MAX_LEN];
+static volatile bool warm_flush_req = false;
+static gui_app_warm_cache_stat_t warm_stat;
+
 /**
  * focoused app, visible
  */
@@ -156,6 +190,7 @@ static uint8_t app_subgpage_perf_tick = 0;
 static uint32_t app_scheduler_new(void);
 static void app_destory(rt_list_t *app_node);
 static void app_destory_list(rt_list_t *list);
+static void app_warm_flush_all(void);
 static uint32_t app_run(rt_mailbox_t msg_mbx, const _intent *i, uint32_t tick);
 static uint32_t app_run_by_id(rt_mailbox_t msg_mbx, const char *id);
 
@@ -417,6 +452,35 @@ static bool is_suspend_or_destoryed_app_handler(gui_runing_app_t *handler)
 
 }
 
+static gui_runing_app_t *get_warm_app_handler(const char *id)
+{
+    rt_list_t *ptr;
+
+    rt_list_for_each(ptr, &warm_app_list)
+    {
+        gui_runing_app_t *run_app = rt_list_entry(ptr, gui_runing_app_t, node);
+        if (0 == strcmp(run_app->id, id))
+        {
+            return run_app;
+        }
+    }
+
+    return NULL;
+}
+
+static bool is_warm_app_handler(gui_runing_app_t *handler)
+{
+    rt_list_t *ptr;
+
+    rt_list_for_each(ptr, &warm_app_list)
+    {
+        if (rt_list_entry(ptr, gui_runing_app_t, node) == handler)
+            return true;
+    }
+
+    return false;
+}
+
 static bool is_last_page_present(void)
 {
     if (1 == rt_list_len(&running_app_list))
@@ -668,6 +732,7 @@ static void app_stop_all(void)
         port_app_sche_reset_indev(port_app_sche_get_act_scr());
         port_app_sche_load_scr(dummy_scr);
         actived_app = NULL;
+        app_warm_flush_all();
 
         rt_list_t *pn_app;
 
@@ -699,6 +764,7 @@ static void app_stop_all_backgrounds(void)
     rt_list_t *prev_node;
 
     app_sche_d("app_stop_all_backgrounds");
+    app_warm_flush_all();
 
     //Remove active app from running list.
     if (tmp_actived)
@@ -740,6 +806,8 @@ static void app_resume(rt_list_t *app_node)
     gui_runing_app_t *run_app = rt_list_entry(app_node, gui_runing_app_t, node);
     rt_list_t *prev_node = app_node->prev;
 
+    run_app->flag &= ~(APP_FLAG_WARM | APP_FLAG_PRELOAD);
+
     /*1. Remove app from running_app_list*/
     rt_list_remove(app_node);
 
@@ -855,6 +923,134 @@ static void app_destory_list(rt_list_t *list)
 }
 
 
+/*
+    Move warm app to the tail of running_app_list and destory it there,
+    APP_FLAG_WARM is kept to stop preloaded pages without resuming them.
+*/
+static void app_warm_evict(gui_runing_app_t *p_app)
+{
+    app_sche_i("Evict warm app[%s]", p_app->id);
+
+    rt_list_remove(&p_app->node);
+    rt_list_insert_before(&running_app_list, &p_app->node);
+    p_app->flag |= APP_FLAG_WARM;
+    warm_stat.evict++;
+
+    app_destory(&p_app->node);
+}
+
+static void app_warm_flush_all(void)
+{
+    while (!rt_list_isempty(&warm_app_list))
+    {
+        app_warm_evict(rt_list_first_entry(&warm_app_list, gui_runing_app_t, node));
+    }
+}
+
+static uint32_t app_warm_free_mem(void)
+{
+    rt_uint32_t total, used, max_used;
+
+    rt_memory_info(&total, &used, &max_used);
+
+    return total - used;
+}
+
+/**
+ * @brief Evict the oldest warm apps over cache size, or one of them
+ *        if free heap is below GUI_APP_WARM_CACHE_MIN_FREE
+ * @return Number of evicted apps
+ */
+static uint32_t app_warm_trim(void)
+{
+    uint32_t cnt = 0;
+
+    while (!rt_list_isempty(&warm_app_list))
+    {
+        if (!warm_flush_req && (rt_list_len(&warm_app_list) <= warm_cache_num))
+        {
+            //Memory is freed after evicted app destoryed, check it again next idle
+            if ((cnt > 0) || (app_warm_free_mem() >= GUI_APP_WARM_CACHE_MIN_FREE))
+                break;
+        }
+
+        app_warm_evict(rt_list_tail_entry(&warm_app_list, gui_runing_app_t, node));
+        cnt++;
+    }
+    warm_flush_req = false;
+
+    return cnt;
+}
+
+/*
+    Move warm/preloaded apps whose subpages all reached paused(or started) state
+    from running_app_list to warm_app_list.
+*/
+static void app_warm_settle(void)
+{
+    rt_list_t *pn_app, *temp;
+
+    rt_list_for_each_safe(pn_app, temp, &running_app_list)
+    {
+        gui_runing_app_t *p_app = rt_list_entry(pn_app, gui_runing_app_t, node);
+        rt_list_t *pn_page;
+        bool settled = true;
+
+        if ((0 == (p_app->flag & (APP_FLAG_WARM | APP_FLAG_PRELOAD))) || (pn_app == actived_app))
+            continue;
+        if ((app_st_running != p_app->state) || (app_st_running != p_app->target_state))
+            continue;
+        if (rt_list_isempty(&p_app->page_list))
+            continue;
+
+        rt_list_for_each(pn_page, &p_app->page_list)
+        {
+            subpage_node_t *p_page = rt_list_entry(pn_page, subpage_node_t, node);
+
+            if ((p_page->state != p_page->target_state)
+                    || ((page_st_paused != p_page->state) && (page_st_started != p_page->state)))
+            {
+                settled = false;
+                break;
+            }
+        }
+
+        if (settled)
+        {
+            app_sche_d("app[%s] keep in warm list", p_app->id);
+            rt_list_remove(pn_app);
+            rt_list_insert_after(&warm_app_list, pn_app);
+            p_app->flag &= ~APP_FLAG_PRELOAD;
+            p_app->flag |= APP_FLAG_WARM;
+        }
+    }
+}
+
+/*
+    Exited app could be kept in warm list if its pages are all shown(resumed or paused)
+*/
+static bool app_warm_cacheable(gui_runing_app_t *p_app)
+{
+    rt_list_t *ptr;
+
+    if ((0 == warm_cache_num) || (p_app->flag & APP_FLAG_WARM))
+        return false;
+    if ((0 == strcmp(p_main_app_id, p_app->id)) || (rt_list_len(&running_app_list) <= 1))
+        return false;
+    if (rt_list_isempty(&p_app->page_list) || (app_st_running != p_app->target_state))
+        return false;
+
+    rt_list_for_each(ptr, &p_app->page_list)
+    {
+        subpage_node_t *p_page = rt_list_entry(ptr, subpage_node_t, node);
+
+        if ((p_page->state < page_st_resumed) || (page_st_stoped == p_page->target_state))
+            return false;
+    }
+
+    return true;
+}
+
 /*
     Restart last suspended app, restart main app if no app was suspended
 */
@@ -921,12 +1117,15 @@ static void app_subpage_do(gui_runing_app_t *p_app, subpage_node_t *subpage, gui
         schedule_app  = &p_app->node;
         schedule_page = &subpage->node;
         uint32_t tick_cnt, tick_start = rt_tick_get();
+        APP_ARENA_ENTER(p_app);
 
         if (sche_subpage_func)
             sche_subpage_func(subpage->msg_handler, msg_id, p_app->id, subpage->name);
         else
             subpage->msg_handler(msg_id, p_app->id);
 
+        APP_ARENA_LEAVE();
+
         tick_cnt = tick_elaps(tick_start);
         subpage->tick_cnt += tick_cnt;
         p_app->tick_cnt += tick_cnt;
@@ -983,6 +1182,9 @@ static int app_do(gui_runing_app_t *p_app, app_exe_enum op)
             p_app->app_data = (void *)app_info.user_data;
             p_app->entry_f = (gui_app_entry_func_ptr_t) app_info.entry_func;
             p_app->state = app_st_launched;
+#ifdef GUI_APP_SCREEN_ARENA
+            p_app->arena = gui_app_arena_create(p_app->id);
+#endif
 
             rt_list_insert_after(&running_app_list, &p_app->node);
         }
@@ -997,8 +1199,10 @@ static int app_do(gui_runing_app_t *p_app, app_exe_enum op)
     case APP_EXEC_START:
     case APP_EXEC_RESTART:
     {
+        APP_ARENA_ENTER(p_app);
         printf_intent(&p_app->param);
         ret_v = p_app->entry_f(&p_app->param);
+        APP_ARENA_LEAVE();
         p_app->state = app_st_running;
     }
     break;
@@ -1026,6 +1230,10 @@ static int app_do(gui_runing_app_t *p_app, app_exe_enum op)
         app_info.entry_func = (uint32_t) p_app->entry_f;
         app_info.user_data    = (uint32_t) p_app->app_data;
         sche_app_dstry_func((const char *)p_app->id, (const app_entity_info *)&app_info);
+#ifdef GUI_APP_SCREEN_ARENA
+        gui_app_arena_destory(p_app->arena);
+        p_app->arena = NULL;
+#endif
     }
     break;
     default:
@@ -1091,10 +1299,11 @@ static int app_launch_new(const char *id, intent_t intent)
  * \n
  *
  * @param app_node
+ * @param keep_warm - Pause all pages and keep app in warm list instead if warm cache is enabled
  * \n
  * @see
  */
-static void app_exit(rt_list_t *app_node)
+static void app_exit(rt_list_t *app_node, bool keep_warm)
 {
     gui_runing_app_t *p_app;
     if (NULL == app_node) return;
@@ -1103,7 +1312,16 @@ static void app_exit(rt_list_t *app_node)
     p_app = rt_list_entry(app_node, gui_runing_app_t, node);
     app_sche_d("app_exit [%s]", p_app->id);
 
-    app_destory(app_node);
+    if (keep_warm && app_warm_cacheable(p_app))
+    {
+        app_sche_d("app[%s] pause for warm cache", p_app->id);
+        app_set_all_page_state(p_app, page_st_paused);
+        p_app->flag |= APP_FLAG_WARM;
+    }
+    else
+    {
+        app_destory(app_node);
+    }
 
     if (app_node == actived_app)
     {
@@ -1154,7 +1372,7 @@ static rt_err_t app_goback(rt_list_t *app_node)
 
     if (1 == rt_list_len(&run_app->page_list)) //go back last page, close app
     {
-        app_exit(app_node);
+        app_exit(app_node, true);
         return RT_EEMPTY;
     }
     else //goback to previous page
@@ -1208,6 +1426,14 @@ static rt_err_t app_create_page(rt_list_t *app_node, const char *page_id, gui_pa
     p_new_page->a_group.prio_down = 0;
 #endif /* TRANS_ANIMATION */
 
+    if (run_app->flag & APP_FLAG_PRELOAD)
+    {
+        /*Build page in background, it will be resumed when app is launched from warm list*/
+        page_set_target_state(p_new_page, page_st_started);
+        rt_list_insert_before(&run_app->page_list, &p_new_page->node);
+        return RT_EOK;
+    }
+
     /*Pause all other pages of this app*/
     app_set_all_page_state(run_app, page_st_paused);
 
@@ -1554,7 +1780,11 @@ static uint32_t schedule_apps(void)
             if ((cur_app->state < app_st_suspended) && (cur_app->target_state < app_st_suspended))
             {
                 //app_sche_d("running apps idx[%d]:[%s].",runing_app_cnt, cur_app->id);
-                if (++runing_app_cnt > max_running_apps)
+                if (cur_app->flag & (APP_FLAG_WARM | APP_FLAG_PRELOAD))
+                {
+                    ;//Going to warm list, not counted
+                }
+                else if (++runing_app_cnt > max_running_apps)
                 {
                     app_sche_d("running apps > MAX_RUNNING_APPS.");
                     if (en_suspend_app)
@@ -1634,6 +1864,12 @@ static uint32_t schedule_subpage(void)
 
                 gui_app_msg_type_t msg = page_state_machine(cur_page->state, cur_page->target_state);
 
+                if ((GUI_APP_MSG_ONRESUME == msg) && (page_st_stoped == cur_page->target_state)
+                        && (cur_app->flag & (APP_FLAG_WARM | APP_FLAG_PRELOAD)))
+                {
+                    msg = GUI_APP_MSG_ONSTOP; //Preloaded page has never been shown, stop it directly
+                }
+
                 switch (msg)
                 {
                 case GUI_APP_MSG_ONSTART:
@@ -1681,7 +1917,8 @@ static uint32_t schedule_subpage(void)
 #ifdef TRANS_ANIMATION
                     if (port_app_sche_get_act_scr() == cur_page->scr)
                     {
-                        pg_exit_being_stop = (page_st_stoped == cur_page->target_state);
+                        pg_exit_being_stop = (page_st_stoped == cur_page->target_state)
+                                             || (cur_app->flag & APP_FLAG_WARM);
                         //record exit anim and play with enter anim
                         trans_anim_pg_exit = cur_page;
                     }
@@ -1959,6 +2196,72 @@ static void check_duplicated_apps(void)
 
 }
 
+static void app_warm_preload(const char *id)
+{
+    intent_t i;
+
+    if ((0 == warm_cache_num) || get_runing_app_handler(id) || get_warm_app_handler(id)
+            || get_suspend_or_destoryed_app_handler(id))
+        return;
+
+    if (app_warm_free_mem() < GUI_APP_WARM_CACHE_MIN_FREE)
+    {
+        app_sche_i("Skip preload app[%s], low memory", id);
+        return;
+    }
+
+    i = intent_init(id);
+    if (NULL == i) return;
+
+    app_sche_i("Preload app[%s]", id);
+    if (0 == app_launch_new(id, i))
+    {
+        //Launched app is at head of running list, move it to tail as a background one
+        gui_runing_app_t *p_app = rt_list_first_entry(&running_app_list, gui_runing_app_t, node);
+
+        p_app->flag |= APP_FLAG_PRELOAD;
+        rt_list_remove(&p_app->node);
+        rt_list_insert_before(&running_app_list, &p_app->node);
+        warm_stat.preload++;
+    }
+    intent_deinit(i);
+}
+
+/*
+    Called while no msg pending and no animation:
+    settle warm apps, evict them over budget, then preload requested app.
+    Preloaded app's pages are created by following GUI_APP_MSG_OPEN_PAGE msgs.
+*/
+static void app_warm_idle(void)
+{
+    bool changed = false;
+
+    app_warm_settle();
+
+    if (app_warm_trim() > 0)
+    {
+        changed = true;
+    }
+
+    if (warm_preload_id[0] != '\0')
+    {
+        app_warm_preload(warm_preload_id);
+        warm_preload_id[0] = '\0';
+        changed = true;
+    }
+
+    if (changed)
+    {
+        while (app_scheduler_new())
+        {
+#ifdef TRANS_ANIMATION
+            if (trans_anim_playing) return;
+#endif /* TRANS_ANIMATION */
+        }
+        do_destory_apps();
+    }
+}
+
 static uint32_t app_scheduler_new(void)
 {
     uint32_t ret_v;
@@ -2032,6 +2335,14 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
             {
                 gui_runing_app_t *run_app = get_runing_app_handler(id);
 
+                if (!run_app && (NULL != (run_app = get_warm_app_handler(id))))
+                {
+                    //Bring warm app back to running list, and resume or exit it as running app
+                    app_sche_d("Found app[%s] in warm list.", id);
+                    rt_list_remove(&run_app->node);
+                    rt_list_insert_after(&running_app_list, &run_app->node);
+                }
+
                 if (run_app)
                 {
                     app_sche_d("Found app[%s] in running list. Args are -", id);
@@ -2039,6 +2350,7 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
                     {
                         app_sche_d("- same. Resume it");
 
+                        if (run_app->flag & APP_FLAG_WARM) warm_stat.hit++;
                         app_resume(&run_app->node);
                     }
                     else
@@ -2056,7 +2368,7 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
                         if (1 == rt_list_len(&running_app_list))
                             app_stop_running();//Make sure current subpage stopped, 'app_destory' can't do it.
                         else
-                            app_exit(&run_app->node);
+                            app_exit(&run_app->node, false);
 
 
                         /*retry when app is exit, and reuse current message's tick*/
@@ -2085,6 +2397,7 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
                     else
                     {
                         /* no running entity*/
+                        if (warm_cache_num) warm_stat.miss++;
                         app_launch_new(id, &(p_msg->content.intnt));
                     }
                 }
@@ -2105,7 +2418,12 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
             if (p_app)
             {
                 app_sche_i("Exit specified app[%s]", id);
-                app_exit(&(p_app->node));
+                app_exit(&(p_app->node), true);
+            }
+            else if (NULL != (p_app = get_warm_app_handler(id)))
+            {
+                app_sche_i("Exit warm app[%s]", id);
+                app_warm_evict(p_app);
             }
             else
             {
@@ -2178,6 +2496,14 @@ void app_schedule_task(rt_mailbox_t msg_mbx)
         {
             if (is_running_app_handler(p_msg->handler))
                 app_create_page(&(p_msg->handler->node), p_msg->content.page.name, p_msg->content.page.msg_handler, p_msg->content.page.user_data);
+            else if (is_warm_app_handler(p_msg->handler))
+            {
+                app_sche_i("Create page on warm app");
+
+                rt_list_remove(&(p_msg->handler->node));
+                rt_list_insert_after(&running_app_list, &(p_msg->handler->node));
+                app_create_page(&(p_msg->handler->node), p_msg->content.page.name, p_msg->content.page.msg_handler, p_msg->content.page.user_data);
+            }
             else if (is_suspend_or_destoryed_app_handler(p_msg->handler))
             {
                 app_sche_i("Create page on suspend app");
@@ -2318,6 +2644,15 @@ END_LOOP:
     if (0 == msg_mbx->entry)
     {
         do_destory_apps();
+
+        if ((scheduler_suspended != suspend_task)
+#ifdef TRANS_ANIMATION
+                && !trans_anim_playing
+#endif /* TRANS_ANIMATION */
+           )
+        {
+            app_warm_idle();
+        }
     }
 
 
@@ -2363,6 +2698,7 @@ uint32_t app_schedule_init(
 {
     rt_list_init(&running_app_list);
     rt_list_init(&suspend_app_list);
+    rt_list_init(&warm_app_list);
 
 
     dummy_scr = port_app_sche_create_scr();
@@ -2434,6 +2770,29 @@ void app_scheduler_print_perf_tick(uint8_t en)
     app_subgpage_perf_tick = en;
 }
 
+void app_schedule_warm_cache_size(uint32_t v)
+{
+    warm_cache_num = v;
+    if (0 == v) warm_flush_req = true;
+}
+
+void app_schedule_preload(const char *id)
+{
+    if (id && (strlen(id) < sizeof(warm_preload_id)))
+        strcpy(warm_preload_id, id);
+}
+
+void app_schedule_warm_cache_flush(void)
+{
+    warm_flush_req = true;
+}
+
+void app_schedule_get_warm_cache_stat(gui_app_warm_cache_stat_t *stat)
+{
+    memcpy(stat, &warm_stat, sizeof(warm_stat));
+    stat->cached = rt_list_len(&warm_app_list);
+}
+
 void display_app_list(rt_list_t *app_list)
 {
     rt_list_t *pn_app;
@@ -2464,6 +2823,8 @@ rt_err_t list_schedule_app(void)
     display_app_list(&running_app_list);
     app_sche_i("-------Suspend app list-------");
     display_app_list(&suspend_app_list);
+    app_sche_i("-------Warm app list-------");
+    display_app_list(&warm_app_list);
 
     return 0;
 }
@@ -3,6 +3,9 @@
  *********************/
 #include "gui_app_int.h"
 #include "bf0_lib.h"
+#ifdef PKG_USING_LITTLEVGL2RTT
+    #include "lvsf_img_cache.h"
+#endif
 
 #ifdef PKG_USING_LITTLEVGL2RTT
 screen_t port_app_sche_create_scr(void)
@@ -25,6 +28,7 @@ void port_app_sche_del_scr(screen_t scr)
 void port_app_sche_load_scr(screen_t scr)
 {
     lv_scr_load((lv_obj_t *)scr);
+    lvsf_img_cache_screen_changed();
 
 #if defined(DISABLE_LVGL_V8)&&defined(DISABLE_LVGL_V9)
     lv_obj_set_scrollbar_mode((lv_obj_t *)scr, LV_SCROLLBAR_MODE_OFF);
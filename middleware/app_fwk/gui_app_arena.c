@@ -0,0 +1,303 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include "gui_app_int.h"
+
+#ifdef GUI_APP_SCREEN_ARENA
+
+#ifndef RT_USING_MEMHEAP
+    #error "GUI_APP_SCREEN_ARENA requires RT_USING_MEMHEAP"
+#endif
+
+#define DBG_TAG           "APP.ARENA"
+#define DBG_LVL           DBG_INFO
+#include "rtdbg.h"
+
+/*
+    Every app owns a memheap carved from system heap at load, LVGL allocations made
+    in app's handlers are served from it and whole arena is returned at destory,
+    so pages of short-lived apps don't leave holes between long-lived blocks.
+
+    Block still allocated at destory (e.g. object moved to layer_top) keeps its arena
+    retired in arena_list, released once the last block is freed.
+*/
+typedef struct
+{
+    struct rt_memheap heap;
+    rt_list_t node;
+    char id[GUI_APP_ID_MAX_LEN];
+    uint8_t retired;
+    uint32_t blocks;          //!< Blocks allocated from arena now
+    uint32_t fallback;        //!< Allocations served by system heap as arena is full
+    uint32_t sys_free;        //!< Free system heap before arena is created
+    uint8_t *pool_end;
+} gui_app_arena_t;
+
+static rt_list_t arena_list = RT_LIST_OBJECT_INIT(arena_list);
+static gui_app_arena_t *cur_arena = NULL;
+static rt_thread_t cur_arena_thread = NULL;
+static uint32_t global_nest = 0;
+static gui_app_arena_stat_t arena_stat;
+
+static uint32_t arena_sys_free(void)
+{
+    rt_uint32_t total, used, max_used;
+
+    rt_memory_info(&total, &used, &max_used);
+
+    return total - used;
+}
+
+static uint32_t arena_max_free_block(gui_app_arena_t *arena)
+{
+    struct rt_memheap_item *item;
+    uint32_t max_free = 0;
+
+    rt_sem_take(&arena->heap.lock, RT_WAITING_FOREVER);
+    for (item = arena->heap.free_list->next_free; item != arena->heap.free_list; item = item->next_free)
+    {
+        uint32_t size = (uint32_t)item->next - (uint32_t)item - RT_ALIGN(sizeof(struct rt_memheap_item), RT_ALIGN_SIZE);
+        if (size > max_free) max_free = size;
+    }
+    rt_sem_release(&arena->heap.lock);
+
+    return max_free;
+}
+
+/*Fragmentation in percent, 0 - all free memory is in one block*/
+static uint32_t arena_frag(gui_app_arena_t *arena)
+{
+    uint32_t avail = arena->heap.available_size;
+
+    if (0 == avail) return 0;
+
+    return 100 - (uint64_t)arena_max_free_block(arena) * 100 / avail;
+}
+
+static gui_app_arena_t *arena_lookup(void *ptr)
+{
+    rt_list_t *pos;
+    gui_app_arena_t *found = NULL;
+
+    rt_enter_critical();
+    rt_list_for_each(pos, &arena_list)
+    {
+        gui_app_arena_t *arena = rt_list_entry(pos, gui_app_arena_t, node);
+
+        if ((uint8_t *)ptr >= (uint8_t *)arena->heap.start_addr && (uint8_t *)ptr < arena->pool_end)
+        {
+            found = arena;
+            break;
+        }
+    }
+    rt_exit_critical();
+
+    return found;
+}
+
+static void arena_release(gui_app_arena_t *arena)
+{
+    rt_enter_critical();
+    rt_list_remove(&arena->node);
+    rt_exit_critical();
+
+    rt_memheap_detach(&arena->heap);
+    rt_free(arena);
+}
+
+static gui_app_arena_t *arena_active(void)
+{
+    if ((NULL == cur_arena) || (global_nest > 0) || (rt_thread_self() != cur_arena_thread))
+        return NULL;
+
+    return cur_arena;
+}
+
+void *gui_app_arena_create(const char *id)
+{
+    gui_app_arena_t *arena;
+    uint32_t sys_free = arena_sys_free();
+
+    arena = (gui_app_arena_t *) rt_malloc(sizeof(gui_app_arena_t) + GUI_APP_ARENA_SIZE);
+    if (NULL == arena)
+    {
+        LOG_W("app[%s] no arena, use system heap", id);
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(gui_app_arena_t));
+    rt_strncpy(arena->id, id, GUI_APP_ID_MAX_LEN - 1);
+    rt_memheap_init(&arena->heap, "app_ar", (void *)(arena + 1), GUI_APP_ARENA_SIZE);
+    arena->pool_end = (uint8_t *)arena->heap.start_addr + arena->heap.pool_size;
+    arena->sys_free = sys_free;
+
+    rt_enter_critical();
+    rt_list_insert_before(&arena_list, &arena->node);
+    rt_exit_critical();
+
+    arena_stat.created++;
+    LOG_I("app[%s] arena %p, sys heap free %d", id, arena, sys_free);
+
+    return arena;
+}
+
+void gui_app_arena_destory(void *handle)
+{
+    gui_app_arena_t *arena = (gui_app_arena_t *) handle;
+    uint32_t frag, sys_free;
+
+    if (NULL == arena) return;
+
+    if (cur_arena == arena) cur_arena = NULL;
+
+    frag = arena_frag(arena);
+    sys_free = arena->sys_free;
+    if (arena->blocks > 0)
+    {
+        LOG_W("app[%s] %d blocks(%d bytes) outlive app, arena retired", arena->id,
+              arena->blocks, arena->heap.actual_used_size);
+        arena->retired = 1;
+        arena_stat.retired++;
+    }
+
+    LOG_I("app[%s] arena exit: peak %d/%d, frag %d%%, fallback %d",
+          arena->id, arena->heap.max_used_size, arena->heap.pool_size, frag, arena->fallback);
+
+    if (!arena->retired)
+    {
+        arena_release(arena);
+    }
+
+    LOG_I("sys heap free %d->%d", sys_free, arena_sys_free());
+}
+
+void *gui_app_arena_switch(void *handle)
+{
+    void *prev = cur_arena;
+
+    cur_arena = (gui_app_arena_t *) handle;
+    cur_arena_thread = rt_thread_self();
+
+    return prev;
+}
+
+void gui_app_arena_global_begin(void)
+{
+    global_nest++;
+}
+
+void gui_app_arena_global_end(void)
+{
+    RT_ASSERT(global_nest > 0);
+    global_nest--;
+}
+
+void *gui_app_arena_malloc(rt_size_t size)
+{
+    gui_app_arena_t *arena = arena_active();
+    void *ptr;
+
+    if (arena && size > 0)
+    {
+        ptr = rt_memheap_alloc(&arena->heap, size);
+        if (ptr)
+        {
+            arena->blocks++;
+            return ptr;
+        }
+        arena->fallback++;
+        arena_stat.fallback++;
+    }
+
+    return rt_malloc(size);
+}
+
+void gui_app_arena_free(void *ptr)
+{
+    gui_app_arena_t *arena;
+
+    if (NULL == ptr) return;
+
+    arena = arena_lookup(ptr);
+    if (NULL == arena)
+    {
+        rt_free(ptr);
+        return;
+    }
+
+    rt_memheap_free(ptr);
+    RT_ASSERT(arena->blocks > 0);
+    arena->blocks--;
+
+    if (arena->retired && 0 == arena->blocks)
+    {
+        LOG_I("app[%s] retired arena released", arena->id);
+        arena->retired = 0;
+        arena_stat.retired--;
+        arena_release(arena);
+    }
+}
+
+void *gui_app_arena_realloc(void *ptr, rt_size_t size)
+{
+    gui_app_arena_t *arena;
+    void *new_ptr;
+    rt_size_t old_size;
+
+    if (NULL == ptr) return gui_app_arena_malloc(size);
+    if (0 == size)
+    {
+        gui_app_arena_free(ptr);
+        return NULL;
+    }
+
+    arena = arena_lookup(ptr);
+    if (NULL == arena) return rt_realloc(ptr, size);
+
+    /*Grow or shrink in place if possible, otherwise move out of arena*/
+    new_ptr = rt_memheap_realloc(&arena->heap, ptr, size);
+    if (new_ptr) return new_ptr;
+
+    new_ptr = rt_malloc(size);
+    if (NULL == new_ptr) return NULL;
+
+    old_size = ((struct rt_memheap_item *)((uint8_t *)ptr - RT_ALIGN(sizeof(struct rt_memheap_item), RT_ALIGN_SIZE)))->size;
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    arena->fallback++;
+    arena_stat.fallback++;
+    gui_app_arena_free(ptr);
+
+    return new_ptr;
+}
+
+void gui_app_arena_get_stat(gui_app_arena_stat_t *stat)
+{
+    *stat = arena_stat;
+}
+
+#ifdef RT_USING_FINSH
+static int app_arena(int argc, char **argv)
+{
+    rt_list_t *pos;
+
+    rt_kprintf("arena size %d, created %d, retired %d, fallback %d, sys heap free %d\n",
+               GUI_APP_ARENA_SIZE, arena_stat.created, arena_stat.retired, arena_stat.fallback,
+               arena_sys_free());
+    rt_kprintf("%-16s %8s %8s %8s %6s %5s %s\n", "app", "used", "peak", "max_blk", "blocks", "frag", "state");
+
+    rt_list_for_each(pos, &arena_list)
+    {
+        gui_app_arena_t *arena = rt_list_entry(pos, gui_app_arena_t, node);
+
+        rt_kprintf("%-16s %8d %8d %8d %6d %4d%% %s\n", arena->id,
+                   arena->heap.pool_size - arena->heap.available_size, arena->heap.max_used_size,
+                   arena_max_free_block(arena), arena->blocks, arena_frag(arena),
+                   arena->retired ? "retired" : (arena == cur_arena ? "current" : "live"));
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(app_arena, show per app LVGL memory arenas);
+#endif /* RT_USING_FINSH */
+
+#endif /* GUI_APP_SCREEN_ARENA */
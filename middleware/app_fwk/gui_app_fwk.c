@@ -394,6 +394,33 @@ void gui_app_cleanup_bg_apps(void)
     send_msg_to_gui_app_task(&msg);
 }
 
+void gui_app_set_warm_cache(uint32_t num)
+{
+    CHECK_CUR_RTOS_TASK();
+    app_schedule_warm_cache_size(num);
+}
+
+int gui_app_preload(const char *id)
+{
+    CHECK_CUR_RTOS_TASK();
+
+    if ((NULL == id) || (strlen(id) >= GUI_APP_ID_MAX_LEN))
+        return RT_EINVAL;
+
+    app_schedule_preload(id);
+    return RT_EOK;
+}
+
+void gui_app_warm_cache_flush(void)
+{
+    app_schedule_warm_cache_flush();
+}
+
+void gui_app_get_warm_cache_stat(gui_app_warm_cache_stat_t *stat)
+{
+    app_schedule_get_warm_cache_stat(stat);
+}
+
 void gui_app_cleanup_now(void)
 {
     gui_app_msg_t msg;
@@ -1297,6 +1324,31 @@ rt_err_t app_sche_print_perf_tick(int argc, char **argv)
 
 MSH_CMD_EXPORT(app_sche_print_perf_tick, Print app &subpage costed ticks);
 
+rt_err_t app_warm(int argc, char **argv)
+{
+    gui_app_warm_cache_stat_t stat;
+
+    if (argc > 2 && 0 == strcmp(argv[1], "preload"))
+    {
+        gui_app_preload(argv[2]);
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "flush"))
+    {
+        gui_app_warm_cache_flush();
+    }
+    else if (argc > 1)
+    {
+        gui_app_set_warm_cache((uint32_t)strtol(argv[1], 0, 10));
+    }
+
+    gui_app_get_warm_cache_stat(&stat);
+    LOG_I("warm cache: cached %d, hit %d, miss %d, preload %d, evict %d",
+          stat.cached, stat.hit, stat.miss, stat.preload, stat.evict);
+
+    return 0;
+}
+MSH_CMD_EXPORT(app_warm, app_warm [num|flush|preload id]: warm app cache);
+
 #endif
 
 
@@ -84,6 +84,9 @@ typedef struct
     uint8_t target_state;
     uint8_t flag;
     uint32_t tick_cnt; //!< app running ticks(including subpage's ticks)
+#ifdef GUI_APP_SCREEN_ARENA
+    void *arena;       //!< LVGL memory arena, NULL to use system heap
+#endif
 } gui_runing_app_t;
 
 typedef struct _subpage_node
@@ -261,6 +264,31 @@ char *fwk_msg_to_name(gui_app_frmmsg_type_t msg);
 app_sche_state app_schedule_state_get(void);
 void app_schedule_destory_suspend_apps(uint32_t v);
 void app_scheduler_print_perf_tick(uint8_t en);
+/*
+ Warm cache: exited apps are kept paused, and launched again without rebuilding pages.
+ Set max apps kept, 0 to disable and flush.
+*/
+void app_schedule_warm_cache_size(uint32_t v);
+/*
+ Launch app in background at next idle, its pages are started but not resumed.
+*/
+void app_schedule_preload(const char *id);
+void app_schedule_warm_cache_flush(void);
+void app_schedule_get_warm_cache_stat(gui_app_warm_cache_stat_t *stat);
+
+#ifdef GUI_APP_SCREEN_ARENA
+/*Size of LVGL memory arena of each app*/
+#ifndef GUI_APP_ARENA_SIZE
+    #define GUI_APP_ARENA_SIZE      (96 * 1024)
+#endif
+/*
+ Arena is created at app loading and destoryed with app, LVGL allocations are
+ served from arena set by gui_app_arena_switch, which returns previous one.
+*/
+void *gui_app_arena_create(const char *id);
+void gui_app_arena_destory(void *arena);
+void *gui_app_arena_switch(void *arena);
+#endif /* GUI_APP_SCREEN_ARENA */
 
 /*---------------------------------app_schedule.h-------------------------------------------------------------------------*/
 
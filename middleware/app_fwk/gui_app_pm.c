@@ -5,6 +5,9 @@
 #include "bf0_pm.h"
 #include "gui_app_pm.h"
 #include "drv_io.h"
+#ifdef BSP_USING_PSRAM_PASR_HEAP
+    #include "drv_psram.h"
+#endif
 #ifdef GUI_PM_METRICS_ENABLED
     #include "metrics_collector.h"
     #include "metrics_id_middleware.h"
@@ -325,6 +328,10 @@ void gui_suspend(void)
         LOG_I("gui_suspend");
 
         close_display();
+#ifdef BSP_USING_PSRAM_PASR_HEAP
+        /* release frame caches and decode buffers so PSRAM top can skip refresh in standby */
+        rt_psram_pasr_flush();
+#endif
         pm_scenario_stop(PM_SCENARIO_UI);
         gui_sleep();
         LOG_I("gui_suspend_resume");
@@ -462,6 +469,12 @@ void sys_power_on(sys_power_on_reason_t reason)
 
 __WEAK void pm_shutdown(void)
 {
+#ifdef PKG_USING_DFS_YAFFS
+    extern int dfs_yaffs_checkpoint_all(void);
+
+    /* Clean shutdown, let next boot mount from checkpoint without scanning */
+    dfs_yaffs_checkpoint_all();
+#endif /* PKG_USING_DFS_YAFFS */
 #ifdef BSP_PM_STANDBY_SHUTDOWN
     rt_err_t err;
     s_sys_poweron_mng.is_poweron = false;
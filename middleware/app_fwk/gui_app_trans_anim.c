@@ -51,6 +51,10 @@ static manual_anim_state_t manual_anim_s = ma_state_stopped;
 static app_trans_ex_cb_t app_trans_ex_cb = NULL;
 static uint32_t manual_animation_start_process;
 static void print_trans_anim_info(const char *prefix, const gui_app_trans_anim_t *cfg);
+static gui_app_trans_anim_perf_t trans_anim_perf;
+static uint32_t trans_anim_last_frame_ms;
+static uint32_t trans_anim_total_frame_ms;
+static uint32_t manual_animation_last_process;
 
 
 static char *ma_state_name(manual_anim_state_t s)
@@ -116,6 +120,30 @@ static gui_anim_value_t app_trans_anim_process_2_value(gui_anim_value_t start, g
 }
 
 
+static void trans_anim_perf_frame(void)
+{
+    uint32_t now = rt_tick_get_millisecond();
+    uint32_t dt;
+
+    if (trans_anim_perf.frame_cnt > 0)
+    {
+        dt = now - trans_anim_last_frame_ms;
+        trans_anim_total_frame_ms += dt;
+        if (dt > trans_anim_perf.max_frame_ms) trans_anim_perf.max_frame_ms = dt;
+        trans_anim_perf.avg_frame_ms = trans_anim_total_frame_ms / trans_anim_perf.frame_cnt;
+    }
+    trans_anim_perf.frame_cnt++;
+    trans_anim_last_frame_ms = now;
+}
+
+#ifndef _MSC_VER
+    #define TRANS_ANIM_TIMER_READ()         HAL_GTIMER_READ()
+    #define TRANS_ANIM_TIMER_TO_US(t)       ((uint32_t)((uint64_t)(t) * 1000000 / HAL_LPTIM_GetFreq()))
+#else
+    #define TRANS_ANIM_TIMER_READ()         rt_tick_get_millisecond()
+    #define TRANS_ANIM_TIMER_TO_US(t)       ((t) * 1000)
+#endif
+
 static void app_trans_anim_clean(void)
 {
     bool is_manual_anim = false;
@@ -135,6 +163,16 @@ static void app_trans_anim_clean(void)
     }
 
 
+    if (app_trans_scr)
+    {
+        trans_anim_log_i("trans anim perf: snapshot %d bytes, setup %dms, %d frames, avg %dms, max %dms",
+                         trans_anim_perf.snapshot_bytes, trans_anim_perf.setup_ms, trans_anim_perf.frame_cnt,
+                         trans_anim_perf.avg_frame_ms, trans_anim_perf.max_frame_ms);
+        if (trans_anim_perf.update_cnt)
+            trans_anim_log_i("trans anim perf: %d manual updates, max %dus",
+                             trans_anim_perf.update_cnt, trans_anim_perf.max_update_us);
+    }
+
     if (app_trans_old_scr)
     {
         port_app_sche_reset_indev(port_app_sche_get_act_scr());
@@ -238,6 +276,8 @@ static rt_err_t app_trans_anim_process(gui_anim_obj_t img, const gui_app_trans_a
 */
 static void anim_manual_control(gui_anim_value_t process)
 {
+    trans_anim_perf_frame();
+
     if (app_trans_anim_back)
     {
         app_trans_anim_process(exit_anim_obj,  &exit_anim_cfg, FLAG_TRANS_ANIM_REVERSE | FLAG_TRANS_ANIM_FG, process);
@@ -517,9 +557,15 @@ rt_err_t app_trans_animation_setup(const gui_app_trans_anim_group_t *g_enter,
     enter_buf_index = 1;
 #endif
 
+    memset(&trans_anim_perf, 0, sizeof(trans_anim_perf));
+    trans_anim_total_frame_ms = 0;
+    trans_anim_perf.snapshot_bytes = ((b_exit_scale ? 1 : 0) + (b_enter_scale ? 1 : 0)) * APP_TRANS_ANIM_SNAPSHOT_SIZE;
+
     exit_anim_obj  = app_trans_animation_obj_create(exit_scr, true, b_exit_scale, exit_buf_index);
     enter_anim_obj = app_trans_animation_obj_create(enter_scr, false, b_enter_scale, enter_buf_index);
 
+    trans_anim_perf.setup_ms = (rt_tick_get() - s_tick) * 1000 / RT_TICK_PER_SECOND;
+
     if (is_back)
     {
         app_trans_animation_obj_move_foreground(exit_anim_obj);
@@ -533,6 +579,7 @@ rt_err_t app_trans_animation_setup(const gui_app_trans_anim_group_t *g_enter,
             {
                 trans_anim_log_i("Start manual animation");
                 anim_manual_control(manual_animation_start_process);
+                manual_animation_last_process = manual_animation_start_process;
                 ma_state_change(ma_state_active);
             }
             else
@@ -599,9 +646,20 @@ rt_err_t gui_app_manual_animation_update(uint32_t process)
     //if ((app_trans_scr != NULL) && is_manual_anim_flag)
     if (ma_state_active == manual_anim_s)
     {
+        uint32_t start, cost;
+
         manual_animation_start_process = process;
+        /* Touch may report several times per frame, only apply when progress changed */
+        if (process == manual_animation_last_process)
+            return RT_EOK;
+
         trans_anim_log_d("gui_app_manual_animation_update process=%d",  process);
+        start = TRANS_ANIM_TIMER_READ();
         anim_manual_control(process);
+        cost = TRANS_ANIM_TIMER_TO_US(TRANS_ANIM_TIMER_READ() - start);
+        manual_animation_last_process = process;
+        trans_anim_perf.update_cnt++;
+        if (cost > trans_anim_perf.max_update_us) trans_anim_perf.max_update_us = cost;
     }
     else
     {
@@ -736,6 +794,12 @@ void gui_app_set_trans_anim_prio(int8_t up, int8_t down)
     }
 }
 
+void gui_app_get_trans_anim_perf(gui_app_trans_anim_perf_t *perf)
+{
+    RT_ASSERT(perf);
+    memcpy(perf, &trans_anim_perf, sizeof(*perf));
+}
+
 void app_trans_end_cb_register(app_trans_ex_cb_t callback)
 {
     app_trans_ex_cb = callback;
@@ -794,6 +858,11 @@ void gui_app_set_trans_anim_prio(int8_t up, int8_t down)
     return;
 }
 
+void gui_app_get_trans_anim_perf(gui_app_trans_anim_perf_t *perf)
+{
+    memset(perf, 0, sizeof(*perf));
+}
+
 
 rt_err_t app_trans_animation_setup(const gui_app_trans_anim_group_t *g_enter,
                                    const gui_app_trans_anim_group_t *g_exit,
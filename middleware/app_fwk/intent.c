@@ -150,28 +150,21 @@ static int app_cmd_split(char *cmd, rt_size_t length, char *argv[], int max_argc
 
 intent_t intent_init(const char *action)
 {
-    char *action_copy;
+    char action_copy[INTENT_MAX_LEN];
     rt_size_t len;
     p_intent i;
 
     if (!action) return NULL;
 
-    //Init new intent data
+    //Init new intent data, the only allocation of intent
     i = (intent_t) rt_malloc(sizeof(_intent));
     if (!i) return NULL;
-    memset(i->content, INTENT_SEPARATER, sizeof(i->content));
-    i->content_len = 0;
+    memset(i, 0, sizeof(_intent));
 
 
     //Copy 'action' to 'action_copy'
     len = strlen(action);
     len = (len >= (INTENT_MAX_LEN - 1)) ? (INTENT_MAX_LEN - 1) : len;
-    action_copy = (char *) rt_malloc(len + 1);
-    if (NULL == action_copy)
-    {
-        rt_free(i);
-        return NULL;
-    }
     memcpy(action_copy, action, len);
     action_copy[len] = '\0';
 
@@ -182,11 +175,9 @@ intent_t intent_init(const char *action)
         char *argv[8];
         memset(argv, 0x00, sizeof(argv));
         argc = app_cmd_split(action_copy, len, argv, 8);
-        p_intent tmp = i;
 
         for (c = 0; c < argc; c++) add_to_intent(i, argv[c]);
     }
-    rt_free(action_copy);
 
 
     return i;
@@ -199,87 +190,122 @@ void intent_deinit(intent_t i)
 }
 
 
-int intent_set_string(intent_t i, const char *name, const char *value)
+/*16 bits FNV-1a of name, 0 is reserved for unused slot*/
+static uint16_t intent_hash(const char *name, uint32_t *name_len)
 {
-    uint32_t ret_v;
-    uint32_t name_len = strlen(name);
-    uint32_t value_len = strlen(value);
-    uint32_t buffer_len = name_len + 1 /* '=' */ + value_len + 1;
+    uint32_t h = 2166136261u;
+    const char *p = name;
 
-    char *buffer = (char *) rt_malloc(buffer_len);
-    if (!buffer) return RT_ENOMEM;
+    while (*p)
+    {
+        h ^= (uint8_t)*p++;
+        h *= 16777619u;
+    }
+    *name_len = p - name;
+    h = (h >> 16) ^ (h & 0xFFFF);
 
-    memset(buffer, 0, buffer_len);
+    return h ? (uint16_t)h : 1;
+}
 
-    rt_snprintf(buffer, buffer_len, "%s=%s", name, value);
-    ret_v = add_to_intent(i, buffer);
-    rt_free(buffer);
+static _intent_kv *intent_find_kv(p_intent i, const char *name, uint16_t hash, uint32_t name_len)
+{
+    uint32_t idx, n;
+    _intent_kv *kv;
 
-    if (ret_v > 0)
-        return RT_EOK;
-    else
-        return RT_ERROR;
+    for (n = 0, idx = hash & (INTENT_KV_NUM - 1); n < INTENT_KV_NUM; n++, idx = (idx + 1) & (INTENT_KV_NUM - 1))
+    {
+        kv = &i->kv[idx];
+        if (0 == kv->hash)
+        {
+            return kv;      //Not found, the free slot is returned
+        }
+        if ((kv->hash == hash) && (kv->value_off - kv->name_off == name_len + 1)
+                && (0 == memcmp(&i->content[kv->name_off], name, name_len)))
+        {
+            return kv;
+        }
+    }
+
+    return NULL;
 }
 
-const char *intent_get_string(intent_t i, const char *name)
+/*Write "name=value" to content, value is a string or formatted u32. Param set again is overwritten*/
+static int intent_set_param(p_intent i, const char *name, const char *str, uint32_t value)
 {
-    uint32_t idx = 0;
-    uint32_t name_len;
+    uint32_t name_len, value_len;
+    char num[12];
+    uint16_t hash;
+    _intent_kv *kv;
+    char *p;
 
     RT_ASSERT(NULL != i);
     RT_ASSERT(NULL != name);
 
-    name_len = strlen(name);
-    while (idx < i->content_len)
+    hash = intent_hash(name, &name_len);
+    kv = intent_find_kv(i, name, hash, name_len);
+    if (!kv)
     {
-        if (i->content[idx] != INTENT_SEPARATER)
-        {
-            if (0 == strncmp(&(i->content[idx]), name, name_len))
-            {
-                if ('=' == i->content[idx + name_len])
-                    return &(i->content[idx + name_len + 1]);
-            }
+        return RT_EFULL;
+    }
 
-            //goto next token
-            while (i->content[idx] != INTENT_SEPARATER) idx++;
-        }
-        else
-        {
-            //goto next token
-            while (INTENT_SEPARATER == i->content[idx]) idx++;
-        }
+    if (!str)
+    {
+        rt_snprintf(num, sizeof(num), "%x", value);
+        str = num;
+    }
+    value_len = strlen(str);
+    if (i->content_len + name_len + value_len + 2 >= INTENT_MAX_LEN)
+    {
+        return RT_ERROR;
     }
 
-    return NULL;
+    p = &i->content[i->content_len];
+    memcpy(p, name, name_len);
+    p[name_len] = '=';
+    memcpy(p + name_len + 1, str, value_len + 1);
+
+    if (0 == kv->hash)
+    {
+        i->kv_num++;
+    }
+    kv->hash = hash;
+    kv->name_off = i->content_len;
+    kv->value_off = i->content_len + name_len + 1;
+    i->content_len += name_len + value_len + 2;
+
+    return RT_EOK;
 }
 
+int intent_set_string(intent_t i, const char *name, const char *value)
+{
+    RT_ASSERT(NULL != value);
+
+    return intent_set_param(i, name, value, 0);
+}
 
-int intent_set_uint32(intent_t i, const char *name, uint32_t value)
+const char *intent_get_string(intent_t i, const char *name)
 {
-    uint32_t ret_v;
     uint32_t name_len;
-    uint32_t buffer_len;
-    char *buffer;
+    uint16_t hash;
+    _intent_kv *kv;
 
     RT_ASSERT(NULL != i);
     RT_ASSERT(NULL != name);
 
-    name_len = strlen(name);
-    buffer_len = name_len + 1 /* '=' */ + 8 + 1;
-
-    buffer = (char *) rt_malloc(buffer_len);
-    if (!buffer) return RT_ENOMEM;
+    hash = intent_hash(name, &name_len);
+    kv = intent_find_kv(i, name, hash, name_len);
+    if (!kv || (0 == kv->hash))
+    {
+        return NULL;
+    }
 
-    memset(buffer, 0, buffer_len);
+    return &(i->content[kv->value_off]);
+}
 
-    rt_snprintf(buffer, buffer_len, "%s=%x", name, value);
-    ret_v = add_to_intent(i, buffer);
-    rt_free(buffer);
 
-    if (ret_v > 0)
-        return RT_EOK;
-    else
-        return RT_ERROR;
+int intent_set_uint32(intent_t i, const char *name, uint32_t value)
+{
+    return intent_set_param(i, name, NULL, value);
 }
 
 
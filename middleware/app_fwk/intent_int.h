@@ -16,10 +16,26 @@
 #define INTENT_MAX_LEN 128
 #define INTENT_SEPARATER '\0'
 
+/* Max number of params, power of 2 */
+#ifndef INTENT_KV_NUM
+    #define INTENT_KV_NUM 8
+#endif
+
+/* Param slot in hash table, indexed by hash of name */
+typedef struct
+{
+    uint16_t hash;          /* 0: slot unused */
+    uint8_t  name_off;      /* "name=value" in content */
+    uint8_t  value_off;
+} _intent_kv;
+
+/* Intent is copied and compared by value, it must not contain pointers */
 typedef struct
 {
-    char content[INTENT_MAX_LEN];
+    char content[INTENT_MAX_LEN];   /* Action and its arguments, then "name=value" of params */
     uint32_t content_len;
+    uint32_t kv_num;
+    _intent_kv kv[INTENT_KV_NUM];
 } _intent, *p_intent;
 
 #endif  /* __INTENT_INT_H__ */
@@ -322,6 +322,8 @@ void app_trans_animation_obj_move_foreground(gui_anim_obj_t obj)
 void app_trans_anim_set_opa_scale(gui_anim_obj_t var, gui_anim_value_t opa_scale)
 {
     trans_anim_log_d("app_trans_anim_set_opa_scale %x, %d\n", var, opa_scale);
+    if (lv_obj_get_style_img_opa((lv_obj_t *)var, LV_PART_MAIN) == (lv_opa_t)opa_scale)
+        return;
     //lv_obj_set_style_local_image_opa((lv_obj_t *)var, LV_OBJ_PART_MAIN, opa_scale);
     //lv_obj_set_style_local_image_opa((lv_obj_t *)var, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, opa_scale);
     lv_obj_set_style_img_opa((lv_obj_t *)var, opa_scale, LV_PART_MAIN);
@@ -336,8 +338,29 @@ void app_trans_anim_set_zoom(gui_anim_obj_t var, gui_anim_value_t zoom)
 
 void app_trans_anim_set_x(gui_anim_obj_t var, gui_anim_value_t x)
 {
+    lv_obj_t *obj = (lv_obj_t *)var;
+    lv_obj_t *parent = lv_obj_get_parent(obj);
+
     trans_anim_log_d("app_trans_anim_set_x %x, %d\n", var, x);
-    lv_obj_set_x((lv_obj_t *)var, x);
+
+    /* Snapshot is a centered image without children, shift its coordinates directly, so that
+       each gesture step only invalidates old and new area, no style refresh and layout pass. */
+    if (parent && lv_obj_check_type(obj, &lv_img_class)
+            && LV_ALIGN_CENTER == lv_obj_get_style_align(obj, LV_PART_MAIN))
+    {
+        lv_coord_t dx = parent->coords.x1 + ((lv_obj_get_width(parent) - lv_obj_get_width(obj)) >> 1)
+                        + x - obj->coords.x1;
+        if (0 == dx)
+            return;
+
+        lv_obj_invalidate(obj);
+        obj->coords.x1 += dx;
+        obj->coords.x2 += dx;
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    lv_obj_set_x(obj, x);
 }
 
 void app_trans_anim_set_pivot(gui_anim_obj_t var, const gui_point_t *p)
@@ -58,8 +58,9 @@ short cvsdInit(cvsd_t *cvsd)
     return 0;
 }
 
-void encode_bit(const int16_t **in, int32_t *accum,
-                int32_t *step_size, uint32_t *output_byte)
+/* inlined so that the state of a whole SCO frame stays in registers */
+static inline void encode_bit(const int16_t **in, int32_t *accum,
+                              int32_t *step_size, uint32_t *output_byte)
 {
     if ((*(*in)++ << PRECISION) >= *accum)
     {
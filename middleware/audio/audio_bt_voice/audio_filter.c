@@ -14,6 +14,10 @@
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    #include "board.h"
+    #define FILTER_USING_DSP    1
+#endif
 
 #define FRACT_BITS 16
 #define GAIN_FRACT_BITS 3 // With that gain, we have an amplitude of a signal almost the same like on input
@@ -186,7 +190,7 @@ const int16_t polyphase_FIR_8kHz_on_64kHz_Fx[FIR_FILTER_LENGTH] =
     FLDBL2FXDBL(-0.0049790273433333969), FLDBL2FXDBL(0.0053714276716090659)
 };
 
-int interpolation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf,  int out_len)
+int interpolation_x8_c(int16_t *inp_buf, int inp_len, int16_t *out_buf,  int out_len)
 {
     static const int L_factor = 8;
 
@@ -208,7 +212,7 @@ int interpolation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf,  int out_l
     return 0;
 }
 
-int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len)
+int decimation_x8_c(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len)
 {
     static const int M_factor = 8;
 
@@ -226,4 +230,77 @@ int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len)
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+#ifdef FILTER_USING_DSP
+/* two samples, input and taps are not word aligned in general */
+static inline uint32_t filter_read_q15x2(const int16_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ * Same sums as the C version, each SMLALD does two exact MACs into the 64 bit
+ * accumulator, so the output is bit exact. Input pairs are loaded once per
+ * input sample and shared by the 8 phases.
+ */
+int interpolation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf,  int out_len)
+{
+    uint32_t c[FIR_FILTER_LENGTH / 2];
+
+    for (int k = 0; k < FIR_FILTER_LENGTH / 2; k++)
+        c[k] = filter_read_q15x2(&polyphase_FIR_8kHz_on_64kHz_Fx[k * 2]);
+
+    for (int i = FIR_FILTER_LENGTH; i < inp_len; i++)
+    {
+        const int16_t *x = inp_buf - 7 + i;
+        uint32_t x01 = filter_read_q15x2(x);
+        uint32_t x23 = filter_read_q15x2(x + 2);
+        uint32_t x45 = filter_read_q15x2(x + 4);
+        uint32_t x67 = filter_read_q15x2(x + 6);
+        const uint32_t *p = c;
+
+        for (int k = 0; k < 8; k++)
+        {
+            uint64_t accum = __SMLALD(x01, p[0], 0);
+            accum = __SMLALD(x23, p[1], accum);
+            accum = __SMLALD(x45, p[2], accum);
+            accum = __SMLALD(x67, p[3], accum);
+            p += 4;
+            *out_buf++ = (int64_t)accum >> (FRACT_BITS - GAIN_FRACT_BITS);
+        }
+    }
+    return 0;
+}
+
+int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len)
+{
+    for (int i = FIR_FILTER_LENGTH; i < inp_len; i += 8)
+    {
+        const int16_t *x = inp_buf - FIR_FILTER_LENGTH + i;
+        const int16_t *p = direct_FIR_8kHz_on_64kHz_Fx;
+        uint64_t accum = 0;
+
+        for (int j = 0; j < FIR_FILTER_LENGTH; j += 4)
+        {
+            accum = __SMLALD(filter_read_q15x2(x + j), filter_read_q15x2(p + j), accum);
+            accum = __SMLALD(filter_read_q15x2(x + j + 2), filter_read_q15x2(p + j + 2), accum);
+        }
+        *out_buf++ = (int64_t)accum >> FRACT_BITS;
+    }
+
+    return 0;
+}
+#else
+int interpolation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf,  int out_len)
+{
+    return interpolation_x8_c(inp_buf, inp_len, out_buf, out_len);
+}
+
+int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len)
+{
+    return decimation_x8_c(inp_buf, inp_len, out_buf, out_len);
+}
+#endif
@@ -16,4 +16,8 @@
 #define FIR_FILTER_LENGTH 64
 
 int interpolation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len);
-int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len);
\ No newline at end of file
+int decimation_x8(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len);
+
+/* scalar reference of the above, output is bit exact */
+int interpolation_x8_c(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len);
+int decimation_x8_c(int16_t *inp_buf, int inp_len, int16_t *out_buf, int out_len);
@@ -7,11 +7,17 @@ File: sbcplc.c
 #include "audio_msbc_plc.h"
 #include "assert.h"
 #include "stdlib.h"
+#include "string.h"
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    #include "board.h"
+    #define PLC_USING_DSP   1
+#endif
 
 static void g711plc_scalespeech(LowcFE_c *, short *out);
 static void g711plc_getfespeech(LowcFE_c *, short *out, int sz);
 static void g711plc_savespeech(LowcFE_c *, short *s);
 static int g711plc_findpitch(LowcFE_c *);
+static int g711plc_findpitch_q(LowcFE_c *);
 static void g711plc_overlapadd(Float *l, Float *r, Float *o, int cnt);
 static void g711plc_overlapadds(short *l, short *r, short *o, int cnt);
 static void g711plc_overlapaddatend(LowcFE_c *, short *s, short *f, int cnt);
@@ -46,6 +52,7 @@ void msbc_g711plc_construct(LowcFE_c *lc)
     assert(lc->historylen <= HISTORYLEN_MAX);
     assert(lc->poverlapmax <= POVERLAPMAX_);
     assert(lc->framesz <= FRAMESZ_MAX);
+    assert((lc->corrbuflen + lc->corrlen) / 2 <= CORRDEC_MAX);
 
     lc->sbcrt = 36;     /* SBC reconvergence time*/
 
@@ -80,6 +87,7 @@ void cvsd_g711plc_construct(LowcFE_c *lc)
     assert(lc->historylen <= HISTORYLEN_MAX);
     assert(lc->poverlapmax <= POVERLAPMAX_);
     assert(lc->framesz <= FRAMESZ_MAX);
+    assert((lc->corrbuflen + lc->corrlen) / 2 <= CORRDEC_MAX);
 
     lc->sbcrt = 0;      /* SBC reconvergence time*/
 
@@ -133,9 +141,9 @@ void g711plc_dofe(LowcFE_c *lc, short *out)
 {
     if (lc->erasecnt == 0)
     {
+        lc->pitch = g711plc_findpitch_q(lc); /* find pitch */
         /* get history */
         g711plc_convertsf(lc->history, lc->pitchbuf, lc->historylen);
-        lc->pitch = g711plc_findpitch(lc); /* find pitch */
         lc->poverlap = lc->pitch >> 2;      /* OLA 1/4 wavelength */
         /* save original last poverlap samples */
         g711plc_copyf(lc->pitchbufend - lc->poverlap, lc->lastq, lc->poverlap);
@@ -400,6 +408,109 @@ static int g711plc_findpitch(LowcFE_c *lc)
     return lc->pitch_max - bestmatch;
 }
 
+/*
+ * Same search as g711plc_findpitch() on the 16 bit history: correlation and energy
+ * are exact 64 bit sums (two MACs per SMLALD), only the normalized score is float.
+ * Coarse search runs on a 2:1 decimated copy so that samples are contiguous.
+ */
+static int64_t g711plc_dot(const short *a, const short *b, int cnt)
+{
+    int64_t acc = 0;
+    int i = 0;
+#ifdef PLC_USING_DSP
+    uint32_t x, y;
+    for (; i + 1 < cnt; i += 2)
+    {
+        memcpy(&x, &a[i], sizeof(x));
+        memcpy(&y, &b[i], sizeof(y));
+        acc = (int64_t)__SMLALD(x, y, (uint64_t)acc);
+    }
+#endif
+    for (; i < cnt; i++)
+        acc += (int32_t)a[i] * b[i];
+    return acc;
+}
+
+static Float g711plc_score(LowcFE_c *lc, int64_t corr, int64_t energy)
+{
+    Float scale = (Float)energy;
+    if (scale < lc->corrminpower)
+        scale = lc->corrminpower;
+    return (Float)corr / (Float)sqrt(scale);
+}
+
+static int g711plc_findpitch_q(LowcFE_c *lc)
+{
+    int i, j, k;
+    int bestmatch;
+    Float bestcorr, corr;
+    int64_t energy;
+    int declen = lc->corrlen / lc->ndec;
+    int decbuflen = lc->corrbuflen / lc->ndec;
+    short *l = &lc->history[lc->historylen - lc->corrlen];
+    short *r = &lc->history[lc->historylen - lc->corrbuflen];
+    short *dl = lc->corrdec;
+    short *dr = lc->corrdec + declen;
+    short *rp;
+
+    /* l and r are pitch_max (even) apart, so both decimate on same phase */
+    for (i = 0; i < declen; i++)
+        dl[i] = l[i * lc->ndec];
+    for (i = 0; i < decbuflen; i++)
+        dr[i] = r[i * lc->ndec];
+
+    /* coarse search */
+    rp = dr;
+    energy = g711plc_dot(rp, rp, declen);
+    bestcorr = g711plc_score(lc, g711plc_dot(rp, dl, declen), energy);
+    bestmatch = 0;
+    for (j = lc->ndec; j <= lc->pitchdiff; j += lc->ndec)
+    {
+        energy -= (int32_t)rp[0] * rp[0];
+        energy += (int32_t)rp[declen] * rp[declen];
+        rp++;
+        corr = g711plc_score(lc, g711plc_dot(rp, dl, declen), energy);
+        if (corr >= bestcorr)
+        {
+            bestcorr = corr;
+            bestmatch = j;
+        }
+    }
+    /* fine search */
+    j = bestmatch - (lc->ndec - 1);
+    if (j < 0)
+        j = 0;
+    k = bestmatch + (lc->ndec - 1);
+    if (k > lc->pitchdiff)
+        k = lc->pitchdiff;
+    rp = &r[j];
+    energy = g711plc_dot(rp, rp, lc->corrlen);
+    bestcorr = g711plc_score(lc, g711plc_dot(rp, l, lc->corrlen), energy);
+    bestmatch = j;
+    for (j++; j <= k; j++)
+    {
+        energy -= (int32_t)rp[0] * rp[0];
+        energy += (int32_t)rp[lc->corrlen] * rp[lc->corrlen];
+        rp++;
+        corr = g711plc_score(lc, g711plc_dot(rp, l, lc->corrlen), energy);
+        if (corr > bestcorr)
+        {
+            bestcorr = corr;
+            bestmatch = j;
+        }
+    }
+    return lc->pitch_max - bestmatch;
+}
+
+int g711plc_pitch_estimate(LowcFE_c *lc, int reference)
+{
+    if (!reference)
+        return g711plc_findpitch_q(lc);
+
+    g711plc_convertsf(lc->history, lc->pitchbuf, lc->historylen);
+    return g711plc_findpitch(lc);
+}
+
 static void g711plc_convertsf(short *f, Float *t, int cnt)
 {
     int i;
@@ -423,14 +534,11 @@ static void g711plc_copyf(Float *f, Float *t, int cnt)
 
 static void g711plc_copys(short *f, short *t, int cnt)
 {
-    int i;
-    for (i = 0; i < cnt; i++)
-        t[i] = f[i];
+    /* history shift overlaps, memmove copies it wordwise */
+    memmove(t, f, cnt * sizeof(short));
 }
 
 static void g711plc_zeros(short *s, int cnt)
 {
-    int i;
-    for (i = 0; i < cnt; i++)
-        s[i] = 0;
+    memset(s, 0, cnt * sizeof(short));
 }
@@ -25,6 +25,7 @@ typedef float Float;
 #define HISTORYLEN_MAX  780
 #define POVERLAPMAX_    60
 #define FRAMESZ_MAX     120
+#define CORRDEC_MAX     440     /* decimated correlation buffers, (corrbuflen + corrlen) / 2 */
 typedef struct _LowcFE_c
 {
     int pitch_min;
@@ -51,6 +52,7 @@ typedef struct _LowcFE_c
     Float pitchbuf[HISTORYLEN_MAX]; /* buffer for cycles of speech */
     Float lastq[POVERLAPMAX_];   /* saved last quarter wavelengh */
     short history[HISTORYLEN_MAX];  /* history buffer */
+    short corrdec[CORRDEC_MAX];     /* 2:1 decimated history for coarse pitch search */
 } LowcFE_c;
 
 /* public functions */
@@ -60,6 +62,9 @@ void g711plc_dofe(LowcFE_c *, short *s);     /* synthesize speech for erasure */
 void g711plc_addtohistory(LowcFE_c *, short *s);
 /* add a good frame to history buffer */
 
+/* pitch estimate of current history, reference != 0 uses the original float search, for test */
+int g711plc_pitch_estimate(LowcFE_c *, int reference);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,6 +55,8 @@
 #endif
 #include "audio_mp3ctrl.h"
 #include "sifli_resample.h"
+#include "mp3_seek_index.h"
+#include "bf0_hal.h"
 #ifdef SOLUTION_WATCH
     #include "app_mem.h"
 #endif
@@ -63,6 +65,9 @@
 
 
 #include "mp3dec.h"
+#ifdef PKG_LIB_OPUS
+    #include "opus_port.h"
+#endif
 
 #define DBG_TAG           "audio"
 #define DBG_LVL           LOG_LVL_INFO
@@ -74,8 +79,23 @@
 
 #define FADE_OUT_TIME_MS      1000
 
+#define WAVE_THREAD_STACK_SIZE  2048
+/* opus decoder keeps scratch in VLAs on stack */
+#ifndef OPUS_THREAD_STACK_SIZE
+    #define OPUS_THREAD_STACK_SIZE  (8 * 1024)
+#endif
+/* tail of ogg file searched for last granule position to get duration */
+#define OPUS_TAIL_SIZE          4096
+
 #define MP3_ONE_STEREO_FRAME_SIZE (MAX_NCHAN * MAX_NGRAN * MAX_NSAMP * 2)
-#define MP3_FRAME_CACHE_COUNT (4) // if not a2dp source, 2 is enough
+/*
+    Decoded PCM kept ahead of playback in audio server cache, decoder thread is
+    woken when half of it is empty and decodes until it's full again.
+    Cache must be less than 32KB.
+*/
+#ifndef MP3_FRAME_CACHE_COUNT
+    #define MP3_FRAME_CACHE_COUNT (6) // if not a2dp source, 2 is enough
+#endif
 #define MP3_FRAME_CACHE_SIZE  (MP3_ONE_STEREO_FRAME_SIZE * MP3_FRAME_CACHE_COUNT + 10)
 
 //event flag
@@ -160,11 +180,36 @@ struct mp3ctrl_t
     uint32_t        wave_samplerate;
     uint8_t         wave_channels;
     uint8_t         is_record;
+#ifdef PKG_LIB_OPUS
+    uint8_t         is_opus;    //ogg opus played by wave thread, decoded to pcm
+    opus_ogg_t      *opus;
+#endif
 #if defined(SYS_HEAP_IN_PSRAM)
     uint8_t        *stack_addr;
 #endif
+    //statistics of mp3 decoder thread
+    uint32_t        stat_start_ms;
+    uint32_t        stat_wakeups;
+    uint32_t        stat_frames;
+    uint32_t        stat_direct;    //frames put in audio cache without copy
+    uint32_t        out_need;       //cache bytes needed by last frame
+    uint64_t        stat_busy_us;
+    mp3_seek_index_t *seek_index;
+    uint8_t         index_valid;    //frame_index is exact, index could be built
 };
 
+typedef struct
+{
+    uint32_t play_ms;
+    uint32_t wakeups;
+    uint32_t frames;
+    uint32_t direct;
+    uint32_t busy_us;
+} mp3_stat_t;
+
+static mp3_stat_t g_mp3_last_stat;
+static mp3ctrl_handle g_mp3_running;
+
 typedef struct  ID3v1
 {
     char header[3];     // TAG
@@ -262,6 +307,133 @@ static void wave_read(mp3ctrl_handle ctrl, void *buffer, uint32_t size)
         buf_read(ctrl, buffer, size);
 }
 
+#ifdef PKG_LIB_OPUS
+static int opus_source_read(void *user, void *buf, int len)
+{
+    mp3ctrl_handle ctrl = (mp3ctrl_handle)user;
+#if RT_USING_DFS
+    if (ctrl->is_file)
+        return read(ctrl->fd, buf, len);
+#endif
+    return buf_read(ctrl, buf, len);
+}
+
+static void opus_release(mp3ctrl_handle ctrl)
+{
+    if (ctrl->opus)
+    {
+        opus_ogg_close(ctrl->opus);
+        audio_mem_free(ctrl->opus);
+        ctrl->opus = NULL;
+    }
+    ctrl->is_opus = 0;
+}
+
+/* return offset of first audio page, wave_bytes_per_second is average of whole file */
+static uint32_t opus_read_header(mp3ctrl_handle ctrl)
+{
+    uint32_t size;
+    uint32_t tail;
+    uint8_t *buf;
+    int64_t granule = -1;
+    uint32_t ms = 0;
+    opus_ogg_t *o = ctrl->opus;
+
+    if (!o)
+    {
+        o = audio_mem_malloc(sizeof(opus_ogg_t));
+        RT_ASSERT(o);
+        ctrl->opus = o;
+    }
+    else
+    {
+        opus_ogg_close(o);
+    }
+    ctrl->is_opus = 1;
+    wave_seek(ctrl, 0);
+    if (opus_ogg_open(o, opus_source_read, ctrl) != OPUS_OK)
+    {
+        LOG_I("opus header error");
+        return -1;
+    }
+    ctrl->wave_samplerate = o->rate;
+    ctrl->wave_channels = o->channels;
+    ctrl->wave_bytes_per_second = 0;
+#if RT_USING_DFS
+    if (ctrl->is_file)
+        size = lseek(ctrl->fd, 0, SEEK_END);
+    else
+#endif
+        size = ctrl->mp3_data_len;
+    tail = size - o->data_pos;
+    if (tail > OPUS_TAIL_SIZE)
+        tail = OPUS_TAIL_SIZE;
+    buf = audio_mem_malloc(tail);
+    if (buf)
+    {
+        wave_seek(ctrl, size - tail);
+        wave_read(ctrl, buf, tail);
+        granule = opus_ogg_last_granule(buf, tail);
+        audio_mem_free(buf);
+    }
+    if (granule > (int64_t)o->pre_skip)
+    {
+        ms = (uint32_t)((granule - o->pre_skip) / 48);
+        if (ms)
+            ctrl->wave_bytes_per_second = (uint64_t)(size - o->data_pos) * 1000 / ms;
+    }
+    LOG_I("opus len=%d ms=%d", size, ms);
+    return o->data_pos;
+}
+#endif
+
+/* 0 for mp3, 1 for wave, 2 for ogg opus. Next could not switch format, opus needs larger stack */
+static int wave_format(const char *header)
+{
+    if (!memcmp(header, "RIFF", 4))
+        return 1;
+#ifdef PKG_LIB_OPUS
+    if (!memcmp(header, "OggS", 4))
+        return 2;
+#endif
+    return 0;
+}
+
+static int wave_format_of(mp3ctrl_handle handle)
+{
+    if (!handle->is_wave)
+        return 0;
+#ifdef PKG_LIB_OPUS
+    if (handle->is_opus)
+        return 2;
+#endif
+    return 1;
+}
+
+/* pcm of wave thread, read from source or decoded */
+static int wave_read_frame(mp3ctrl_handle ctrl, void *buffer, int size)
+{
+#ifdef PKG_LIB_OPUS
+    if (ctrl->is_opus)
+        return ctrl->opus->dec ? opus_ogg_read_pcm(ctrl->opus, buffer, size) : 0;
+#endif
+#if RT_USING_DFS
+    if (ctrl->is_file)
+        return read(ctrl->fd, buffer, size);
+#endif
+    return buf_read(ctrl, buffer, size);
+}
+
+/* source of wave thread is moved to offset */
+static void wave_restart(mp3ctrl_handle ctrl, uint32_t offset)
+{
+    wave_seek(ctrl, offset);
+#ifdef PKG_LIB_OPUS
+    if (ctrl->is_opus)
+        opus_ogg_reset(ctrl->opus, offset);
+#endif
+}
+
 static uint32_t audio_parse_mp3_id3v2(mp3ctrl_handle handle)
 {
     uint32_t    tag_len;
@@ -279,10 +451,20 @@ static uint32_t audio_parse_mp3_id3v2(mp3ctrl_handle handle)
         if (!memcmp((const char *)&id3.header, "RIFF", 4))
         {
             handle->is_wave = 1;
+#ifdef PKG_LIB_OPUS
+            opus_release(handle);
+#endif
             wave_seek(handle, 0);
             tag_len = wav_read_header(handle);
             LOG_I("wav len=%d", tag_len);
         }
+#ifdef PKG_LIB_OPUS
+        else if (!memcmp((const char *)&id3.header, "OggS", 4))
+        {
+            handle->is_wave = 1;
+            tag_len = opus_read_header(handle);
+        }
+#endif
     }
     else
     {
@@ -369,6 +551,63 @@ static int find_sync_in_cache(mp3ctrl_handle ctrl)
     return 0;
 }
 
+/* offset of data at cache_read_ptr, counted from end of ID3v2 tag */
+static uint32_t mp3_stream_pos(mp3ctrl_handle ctrl)
+{
+    off_t pos;
+#if RT_USING_DFS
+    if (ctrl->is_file)
+        pos = lseek(ctrl->fd, 0, SEEK_CUR);
+    else
+#endif
+        pos = ctrl->fd;
+    return (uint32_t)pos - ctrl->cache_bytesLeft - ctrl->tag_len;
+}
+
+/*
+    called after get_frame_info(), cache_read_ptr is at first frame.
+    set exact duration and average bitrate if Xing/VBRI or saved index has frame count,
+    otherwise estimate them by first frame as CBR.
+*/
+static void mp3_index_open(mp3ctrl_handle ctrl, const char *filename, uint32_t file_size, MP3FrameInfo *frameinfo)
+{
+    uint32_t seconds;
+
+    ctrl->seek_index = mp3_seek_index_create(filename, file_size);
+    mp3_seek_index_parse(ctrl->seek_index, ctrl->cache_read_ptr, ctrl->cache_bytesLeft, mp3_stream_pos(ctrl));
+    ctrl->index_valid = 1;
+    seconds = mp3_seek_index_duration(ctrl->seek_index);
+    if (seconds)
+    {
+        ctrl->total_time_in_seconds = seconds;
+        ctrl->bitrate = (uint64_t)(ctrl->mp3_data_len - ctrl->tag_len) * 8 / seconds;
+    }
+    else
+    {
+        ctrl->total_time_in_seconds = (ctrl->mp3_data_len - ctrl->tag_len) * 8 / frameinfo->bitrate;
+        ctrl->bitrate = frameinfo->bitrate;
+    }
+}
+
+/* offset from end of ID3v2 tag to play from seconds, frame_index is updated for progress */
+static uint32_t mp3_seek_offset(mp3ctrl_handle ctrl, uint32_t seconds)
+{
+    uint32_t offset, frame;
+    mp3_seek_index_t *idx = ctrl->seek_index;
+
+    if (mp3_seek_index_lookup(idx, seconds, &offset, &frame) == 0)
+    {
+        ctrl->frame_index = frame;
+        ctrl->index_valid = 1;
+        return offset;
+    }
+    //not indexed yet, not exact
+    if (idx && idx->samplerate)
+        ctrl->frame_index = (uint64_t)seconds * idx->samplerate / idx->frame_samples;
+    ctrl->index_valid = 0;
+    return seconds * (uint64_t)ctrl->bitrate / 8;
+}
+
 static mp3ctrl_handle g_handle1 = NULL;
 static mp3ctrl_handle g_handle2 = NULL;
 
@@ -479,10 +718,12 @@ static void replace(mp3ctrl_handle ctrl)
     {
         ctrl->mp3_data_len = file_size;
     }
+    mp3_seek_index_destroy(ctrl->seek_index);
+    ctrl->seek_index = NULL;
+    ctrl->index_valid = 0;
     if (ctrl->is_wave == 0 && get_frame_info(ctrl, &frameinfo) == 0)
     {
-        ctrl->total_time_in_seconds = (ctrl->mp3_data_len - ctrl->tag_len) * 8 / frameinfo.bitrate;
-        ctrl->bitrate = frameinfo.bitrate;
+        mp3_index_open(ctrl, ctrl->is_file ? (const char *)p_cmd->next_buffer : NULL, file_size, &frameinfo);
         LOG_I("repalce time=%d channel=%d samprate=%d samps=%d",
               ctrl->total_time_in_seconds, frameinfo.nChans, frameinfo.samprate, frameinfo.outputSamps);
     }
@@ -540,6 +781,130 @@ static void callback_playing_progress(mp3ctrl_handle ctrl)
         }
     }
 }
+static uint32_t mp3_busy_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void mp3_stat_get(mp3ctrl_handle ctrl, mp3_stat_t *stat)
+{
+    stat->play_ms = rt_tick_get_millisecond() - ctrl->stat_start_ms;
+    stat->wakeups = ctrl->stat_wakeups;
+    stat->frames = ctrl->stat_frames;
+    stat->direct = ctrl->stat_direct;
+    stat->busy_us = (uint32_t)ctrl->stat_busy_us;
+}
+
+static void mp3_stat_print(const mp3_stat_t *stat)
+{
+    uint32_t ms = stat->play_ms ? stat->play_ms : 1;
+    uint32_t cpu = (uint32_t)((uint64_t)stat->busy_us * 10 / ms); //0.01%
+
+    rt_kprintf("mp3: %d ms %d frames (%d in place), %d wakeups/s, cpu %d.%02d%%\n",
+               stat->play_ms, stat->frames, stat->direct, (uint32_t)((uint64_t)stat->wakeups * 1000 / ms),
+               cpu / 100, cpu % 100);
+}
+
+/*no sample rate or channel conversion for current sink, so decoder could output in place in audio cache*/
+static inline uint8_t mp3_output_is_native(uint32_t samplerate, uint8_t channels)
+{
+    return !audio_device_is_a2dp_sink() || (samplerate == 44100 && channels == 2);
+}
+
+/*
+    Write decoded frame to audio cache, mono to stereo and resample to 44.1k of
+    a2dp sink are done into cache in the same loop if it has contiguous space.
+    Nothing is consumed if cache is full, return value is same as audio_write().
+*/
+static int mp3_output_frame(mp3ctrl_handle ctrl, int16_t *pcm, MP3FrameInfo *info)
+{
+    uint8_t to_stereo = 0;
+    uint32_t pcm_bytes = info->outputSamps * 2;
+    uint32_t need, bytes, space;
+    uint8_t *buf;
+    int len;
+
+    if (audio_device_is_a2dp_sink())
+    {
+        to_stereo = (info->nChans == 1);
+        if (info->samprate != 44100 && !ctrl->resample)
+        {
+            LOG_I("resample open %d", info->samprate);
+            ctrl->resample = sifli_resample_open_ex(info->nChans, info->samprate, 44100, MP3_ONE_STEREO_FRAME_SIZE);
+            RT_ASSERT(ctrl->resample);
+        }
+    }
+    else if (ctrl->resample)
+    {
+        //sink changed from a2dp
+        sifli_resample_close(ctrl->resample);
+        ctrl->resample = NULL;
+    }
+
+    if (ctrl->resample && ctrl->resample->channels != info->nChans)
+    {
+        sifli_resample_close(ctrl->resample);
+        ctrl->resample = sifli_resample_open_ex(info->nChans, info->samprate, 44100, MP3_ONE_STEREO_FRAME_SIZE);
+        RT_ASSERT(ctrl->resample);
+    }
+
+    if (ctrl->resample)
+        need = sifli_resample_max_output(ctrl->resample, pcm_bytes, to_stereo);
+    else
+        need = to_stereo ? pcm_bytes * 2 : pcm_bytes;
+    ctrl->out_need = need;
+
+    len = audio_write_get_buf(ctrl->client, &buf, &space);
+    if (len < 0)
+        return len;
+    if (space < need)
+        return 0;
+
+    if (len >= need)
+    {
+        if (ctrl->resample)
+            bytes = sifli_resample_process_to(ctrl->resample, pcm, pcm_bytes, 0, (int16_t *)buf, len, to_stereo);
+        else if (to_stereo)
+        {
+            mono2stereo(pcm, info->outputSamps, (int16_t *)buf);
+            bytes = pcm_bytes * 2;
+        }
+        else
+        {
+            if ((uint8_t *)pcm != buf)
+                memcpy(buf, pcm, pcm_bytes);
+            else
+                ctrl->stat_direct++;
+            bytes = pcm_bytes;
+        }
+        return audio_write_commit(ctrl->client, bytes);
+    }
+
+    //cache wraps around, convert in resample buffer then copy
+    if (ctrl->resample)
+    {
+        bytes = sifli_resample_process_to(ctrl->resample, pcm, pcm_bytes, 0,
+                                          sifli_resample_get_output(ctrl->resample), ctrl->resample->dst_size, to_stereo);
+        return audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), bytes);
+    }
+    else if (to_stereo)
+    {
+        int16_t stereo[64];
+        uint32_t done, n;
+
+        for (done = 0; done < info->outputSamps; done += n)
+        {
+            n = info->outputSamps - done;
+            if (n > sizeof(stereo) / 4)
+                n = sizeof(stereo) / 4;
+            mono2stereo(pcm + done, n, stereo);
+            audio_write(ctrl->client, (uint8_t *)stereo, n * 4);
+        }
+        return pcm_bytes * 2;
+    }
+    return audio_write(ctrl->client, (uint8_t *)pcm, pcm_bytes);
+}
+
 static void mp3ctrl_thread_entry_file(void *parameter)
 {
 #if PKG_USING_LIBHELIX
@@ -561,6 +926,8 @@ static void mp3ctrl_thread_entry_file(void *parameter)
     int nFrames = 0;
     rt_uint32_t evt;
     LOG_I("mp3 run...ctrl=0x%x", ctrl);
+    ctrl->stat_start_ms = rt_tick_get_millisecond();
+    g_mp3_running = ctrl;
     while (1)
     {
         if (is_closing)
@@ -576,6 +943,7 @@ static void mp3ctrl_thread_entry_file(void *parameter)
         {
             rt_event_recv(ctrl->event, MP3_EVENT_ALL, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &evt);
         }
+        ctrl->stat_wakeups++;
 
         if (evt & MP3_EVENT_FLAG_CLOSE)
         {
@@ -660,7 +1028,7 @@ static void mp3ctrl_thread_entry_file(void *parameter)
             p_cmd = rt_slist_entry(first, mp3_cmt_t, snode);
             rt_slist_remove(&ctrl->cmd_slist, first);
             mp3_slist_unlock(ctrl);
-            offset = (uint32_t)p_cmd->cmd_paramter1 * (uint64_t)ctrl->bitrate / 8;
+            offset = mp3_seek_offset(ctrl, (uint32_t)p_cmd->cmd_paramter1);
 #if RT_USING_DFS
             if (ctrl->is_file)
                 lseek(ctrl->fd, ctrl->tag_len + offset, SEEK_SET);
@@ -705,49 +1073,7 @@ static void mp3ctrl_thread_entry_file(void *parameter)
             {
                 LOG_D("mp3 try write again");
                 MP3GetLastFrameInfo(hMP3Decoder, &mp3FrameInfo);
-                if (audio_device_is_a2dp_sink())
-                {
-                    uint32_t bytes;
-                    if (mp3FrameInfo.samprate != 44100)
-                    {
-                        if (ctrl->resample)
-                        {
-                            ret = audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), ctrl->resample->dst_bytes);
-                            goto look_write_result;
-                        }
-                        else
-                        {
-                            ctrl->resample = sifli_resample_open(2, mp3FrameInfo.samprate, 44100);
-                            RT_ASSERT(ctrl->resample);
-                        }
-                        if (mp3FrameInfo.nChans == 2)
-                        {
-                            bytes = sifli_resample_process(ctrl->resample, (int16_t *)outBuf, mp3FrameInfo.outputSamps * 2, 0);
-                            ret = audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), bytes);
-                        }
-                        else
-                        {
-                            mono2stereo((int16_t *)outBuf, mp3FrameInfo.outputSamps, (int16_t *)outBuf2);
-                            bytes = sifli_resample_process(ctrl->resample, (int16_t *)outBuf2, mp3FrameInfo.outputSamps * 4, 0);
-                            ret = audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), bytes);
-                        }
-                    }
-                    else if (mp3FrameInfo.nChans == 1)
-                    {
-                        mono2stereo((int16_t *)outBuf, mp3FrameInfo.outputSamps, (int16_t *)outBuf2);
-                        ret = audio_write(ctrl->client, (uint8_t *)outBuf2, mp3FrameInfo.outputSamps * 4);
-                    }
-                    else
-                    {
-                        ret = audio_write(ctrl->client, (uint8_t *)outBuf, mp3FrameInfo.outputSamps * 2);
-                    }
-                }
-                else
-                {
-                    ret = audio_write(ctrl->client, (uint8_t *)outBuf, mp3FrameInfo.outputSamps * 2);
-                }
-
-look_write_result:
+                ret = mp3_output_frame(ctrl, (int16_t *)outBuf, &mp3FrameInfo);
                 if (ret == 0)
                 {
                     LOG_D("mp3 cache full");
@@ -762,15 +1088,30 @@ look_write_result:
             }
         }
 
+        if (ctrl->client && ctrl->out_need)
+        {
+            uint8_t *buf;
+            uint32_t space = 0;
+
+            //no room for a frame, wait until half of cache is played
+            if (audio_write_get_buf(ctrl->client, &buf, &space) >= 0 && space < ctrl->out_need)
+                continue;
+        }
+
+        uint32_t busy_start = HAL_GTIMER_READ();
         if (find_sync_in_cache(ctrl) < 0)
         {
             uint32_t cache_time_ms = 150;
             audio_ioctl(ctrl->client, 1, &cache_time_ms);
             rt_thread_mdelay(cache_time_ms + 20);
 
+            if (ctrl->index_valid)
+                mp3_seek_index_finish(ctrl->seek_index, ctrl->frame_index);
             if (ctrl->loop_times > 0)
             {
                 ctrl->is_file_end = 0;
+                ctrl->frame_index = 0;
+                ctrl->index_valid = 1;
 
                 ctrl->loop_times--;
 #if RT_USING_DFS
@@ -802,7 +1143,20 @@ look_write_result:
             continue;
         }
 
-        int err = MP3Decode(hMP3Decoder, &ctrl->cache_read_ptr, &ctrl->cache_bytesLeft, outBuf, 0);
+        if (ctrl->index_valid && ctrl->frame_index == mp3_seek_index_next(ctrl->seek_index))
+            mp3_seek_index_add(ctrl->seek_index, mp3_stream_pos(ctrl));
+
+        short *pcm = outBuf;
+        uint8_t *span;
+
+        //same format as last frame and no conversion, decode in place in audio cache
+        if (ctrl->client && mp3_output_is_native(old_samplerate, old_channels)
+                && audio_write_get_buf(ctrl->client, &span, NULL) >= MP3_ONE_STEREO_FRAME_SIZE
+                && ((uint32_t)span & 1) == 0)
+        {
+            pcm = (short *)span;
+        }
+        int err = MP3Decode(hMP3Decoder, &ctrl->cache_read_ptr, &ctrl->cache_bytesLeft, pcm, 0);
 
         nFrames++;
         ctrl->frame_index++;
@@ -818,6 +1172,7 @@ look_write_result:
                 rt_thread_mdelay(100);
                 ctrl->is_file_end = 1;
                 ctrl->cache_bytesLeft = 0;
+                ctrl->index_valid = 0;
                 LOG_I("too many errors, seek to file end");
             }
             rt_event_send(ctrl->event, MP3_EVENT_FLAG_DECODE);
@@ -831,6 +1186,12 @@ look_write_result:
             MP3GetLastFrameInfo(hMP3Decoder, &mp3FrameInfo);
             if (mp3FrameInfo.nChans != old_channels || mp3FrameInfo.samprate != old_samplerate)
             {
+                if (pcm != outBuf)
+                {
+                    //cache is closed for new format
+                    memcpy(outBuf, pcm, mp3FrameInfo.outputSamps * 2);
+                    pcm = outBuf;
+                }
                 if (ctrl->client)
                 {
                     audio_close(ctrl->client);
@@ -861,43 +1222,14 @@ look_write_result:
                       ctrl, ctrl->client, mp3FrameInfo.nChans, mp3FrameInfo.samprate, mp3FrameInfo.outputSamps);
             }
             LOG_D("nFrames=%d", nFrames);
-            if (audio_device_is_a2dp_sink())
+            ret = mp3_output_frame(ctrl, (int16_t *)pcm, &mp3FrameInfo);
+            if (ret <= 0 && pcm != outBuf)
             {
-                uint32_t bytes;
-                if (mp3FrameInfo.samprate != 44100)
-                {
-                    if (!ctrl->resample)
-                    {
-                        LOG_I("resample open %d", mp3FrameInfo.samprate);
-                        ctrl->resample = sifli_resample_open(2, mp3FrameInfo.samprate, 44100);
-                        RT_ASSERT(ctrl->resample);
-                    }
-                    if (mp3FrameInfo.nChans == 2)
-                    {
-                        bytes = sifli_resample_process(ctrl->resample, (int16_t *)outBuf, mp3FrameInfo.outputSamps * 2, 0);
-                        ret = audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), bytes);
-                    }
-                    else
-                    {
-                        mono2stereo((int16_t *)outBuf, mp3FrameInfo.outputSamps, (int16_t *)outBuf2);
-                        bytes = sifli_resample_process(ctrl->resample, (int16_t *)outBuf2, mp3FrameInfo.outputSamps * 4, 0);
-                        ret = audio_write(ctrl->client, (uint8_t *)sifli_resample_get_output(ctrl->resample), bytes);
-                    }
-                }
-                else if (mp3FrameInfo.nChans == 1)
-                {
-                    mono2stereo((int16_t *)outBuf, mp3FrameInfo.outputSamps, (int16_t *)outBuf2);
-                    ret = audio_write(ctrl->client, (uint8_t *)outBuf2, mp3FrameInfo.outputSamps * 4);
-                }
-                else
-                {
-                    ret = audio_write(ctrl->client, (uint8_t *)outBuf, mp3FrameInfo.outputSamps * 2);
-                }
-            }
-            else
-            {
-                ret = audio_write(ctrl->client, (uint8_t *)outBuf, mp3FrameInfo.outputSamps * 2);
+                //keep frame for retry, it's not committed to cache
+                memcpy(outBuf, pcm, mp3FrameInfo.outputSamps * 2);
             }
+            ctrl->stat_frames++;
+            ctrl->stat_busy_us += mp3_busy_us(busy_start);
 
             if (ret == -1)
             {
@@ -922,7 +1254,12 @@ look_write_result:
         audio_close(ctrl->client);
     ctrl->client = NULL;
     LOG_I("mp3 exit..nFrames=%d", nFrames);
+    mp3_stat_get(ctrl, &g_mp3_last_stat);
+    g_mp3_running = NULL;
+    mp3_stat_print(&g_mp3_last_stat);
     MP3FreeDecoder(hMP3Decoder);
+    mp3_seek_index_destroy(ctrl->seek_index);
+    ctrl->seek_index = NULL;
 #if RT_USING_DFS
     if (ctrl->is_file)
         close(ctrl->fd);
@@ -1070,12 +1407,8 @@ static void wave_thread_entry_file(void *parameter)
             offset = (uint32_t)p_cmd->cmd_paramter1 * (uint64_t)ctrl->wave_bytes_per_second;
             if (offset != -1)
             {
-#if RT_USING_DFS
-                if (ctrl->is_file)
-                    lseek(ctrl->fd, ctrl->tag_len + offset, SEEK_SET);
-                else
-#endif
-                    buf_seek(ctrl, ctrl->tag_len + offset);
+                //opus is located by average bitrate, decoder resyncs at next page
+                wave_restart(ctrl, ctrl->tag_len + offset);
                 ctrl->cache_bytesLeft = 0;
                 ctrl->is_file_end = 0;
             }
@@ -1164,13 +1497,7 @@ check_write_result:
                 callback_playing_progress(ctrl);
             }
         }
-        int len;
-#if RT_USING_DFS
-        if (ctrl->is_file)
-            len = read(ctrl->fd, outBuf, WAV_FRAME_SIZE);
-        else
-#endif
-            len = buf_read(ctrl, outBuf, WAV_FRAME_SIZE);
+        int len = wave_read_frame(ctrl, outBuf, WAV_FRAME_SIZE);
         if (len <= 0)
         {
             //wait cache out to speaker
@@ -1182,12 +1509,7 @@ check_write_result:
             {
                 ctrl->loop_times--;
                 ctrl->is_file_end = 0;
-#if RT_USING_DFS
-                if (ctrl->is_file)
-                    lseek(ctrl->fd, ctrl->tag_len + 0, SEEK_SET);
-                else
-#endif
-                    buf_seek(ctrl, ctrl->tag_len + 0);
+                wave_restart(ctrl, ctrl->tag_len);
                 LOG_I("wav--loop");
                 last_frame_len = WAV_FRAME_SIZE;
                 continue;
@@ -1312,6 +1634,9 @@ check_write_result:
     }
     audio_mem_free(outBuf);
     audio_mem_free(outBuf2);
+#ifdef PKG_LIB_OPUS
+    opus_release(ctrl);
+#endif
 
     mp3_slist_lock(ctrl);
     while (1)
@@ -1455,8 +1780,7 @@ static mp3ctrl_handle mp3ctrl_open_real(audio_type_t type,
     handle->cache_bytesLeft = 0;
     if (handle->is_wave == 0 && get_frame_info(handle, &frameinfo) == 0)
     {
-        handle->total_time_in_seconds = (handle->mp3_data_len - handle->tag_len) * 8 / frameinfo.bitrate;
-        handle->bitrate = frameinfo.bitrate;
+        mp3_index_open(handle, handle->is_file ? filename : NULL, file_size, &frameinfo);
         LOG_I("f=%d d=%d time=%d channel=%d samprate=%d samps=%d", file_size, handle->mp3_data_len,
               handle->total_time_in_seconds, frameinfo.nChans, frameinfo.samprate, frameinfo.outputSamps);
     }
@@ -1486,21 +1810,26 @@ static mp3ctrl_handle mp3ctrl_open_real(audio_type_t type,
     rt_slist_init(&handle->cmd_slist);
     handle->cmd_slist_mutex = rt_mutex_create("mp3", RT_IPC_FLAG_FIFO);
     handle->event = rt_event_create("mp3", RT_IPC_FLAG_FIFO);
+    uint32_t stack_size = WAVE_THREAD_STACK_SIZE;
+#ifdef PKG_LIB_OPUS
+    if (handle->is_opus)
+        stack_size = OPUS_THREAD_STACK_SIZE;
+#endif
 #if !defined(SYS_HEAP_IN_PSRAM)
     if (handle->is_wave)
-        handle->thread = rt_thread_create("wave", wave_thread_entry_file, handle, 2048, RT_THREAD_PRIORITY_HIGH + 1, 10);
+        handle->thread = rt_thread_create("wave", wave_thread_entry_file, handle, stack_size, RT_THREAD_PRIORITY_HIGH + 1, 10);
     else
         handle->thread = rt_thread_create("mp3", mp3ctrl_thread_entry_file, handle, 2048, RT_THREAD_PRIORITY_HIGH + 1, 10);
     RT_ASSERT(handle->thread);
 #else
     rt_err_t err;
-    handle->stack_addr = (uint8_t *)app_sram_alloc(2048);
+    handle->stack_addr = (uint8_t *)app_sram_alloc(stack_size);
     RT_ASSERT(handle->stack_addr);
     handle->thread = audio_mem_malloc(sizeof(struct rt_thread));
     RT_ASSERT(handle->thread);
     rt_memset(handle->thread, 0, sizeof(struct rt_thread));
     if (handle->is_wave)
-        err = rt_thread_init(handle->thread, "wave", wave_thread_entry_file, handle, handle->stack_addr, 2048, RT_THREAD_PRIORITY_HIGH + 1, 10);
+        err = rt_thread_init(handle->thread, "wave", wave_thread_entry_file, handle, handle->stack_addr, stack_size, RT_THREAD_PRIORITY_HIGH + 1, 10);
     else
         err = rt_thread_init(handle->thread, "mp3", mp3ctrl_thread_entry_file, handle, handle->stack_addr, 2048, RT_THREAD_PRIORITY_HIGH + 1, 10);
     RT_ASSERT(RT_EOK == err);
@@ -1638,6 +1967,7 @@ PUBLIC_API int mp3ctrl_ioctl(mp3ctrl_handle handle, int cmd, uint32_t param)
         if (p->len == -1)
         {
             cmd_msg->next_is_file = 1;
+            cmd_msg->next_buffer = (uint8_t *)p->filename; //for seek index, used before ioctl returns
             LOG_I("mp3 next %s", p->filename);
             struct stat stat_buf;
             stat(p->filename, &stat_buf);
@@ -1652,8 +1982,7 @@ PUBLIC_API int mp3ctrl_ioctl(mp3ctrl_handle handle, int cmd, uint32_t param)
             char riff[4] = {0};
             read(cmd_msg->next_fd, riff, 4);
             lseek(cmd_msg->next_fd, 0, SEEK_SET);
-            if ((!memcmp((const char *)riff, "RIFF", 4) && !handle->is_wave)
-                    || (memcmp((const char *)riff, "RIFF", 4) && handle->is_wave))
+            if (wave_format(riff) != wave_format_of(handle))
             {
                 close(cmd_msg->next_fd);
 Error:
@@ -1667,8 +1996,7 @@ Error:
 #endif
         {
             LOG_I("mp3 next buffer");
-            if ((!memcmp((const char *)p->filename, "RIFF", 4) && !handle->is_wave)
-                    || (memcmp((const char *)p->filename, "RIFF", 4) && handle->is_wave))
+            if (wave_format(p->filename) != wave_format_of(handle))
             {
 #if RT_USING_DFS
                 goto Error;
@@ -1745,7 +2073,9 @@ int mp3ctrl_getinfo(const char *filename, mp3_info_t *info)
     }
     if (handle->is_wave == 0 && get_frame_info(handle, &frameinfo) == 0)
     {
-        info->total_time_in_seconds = (handle->mp3_data_len - handle->tag_len) * 8 / frameinfo.bitrate;
+        mp3_index_open(handle, filename, file_size, &frameinfo);
+        mp3_seek_index_destroy(handle->seek_index);
+        info->total_time_in_seconds = handle->total_time_in_seconds;
         info->samplerate = frameinfo.samprate;
         info->channels = frameinfo.nChans;
         info->one_channel_sampels = frameinfo.outputSamps / frameinfo.nChans;
@@ -1769,6 +2099,9 @@ Exit:
     {
         audio_mem_free(handle->cache_ptr);
     }
+#ifdef PKG_LIB_OPUS
+    opus_release(handle);
+#endif
     audio_mem_free(handle);
     return 0;
 #else
@@ -1893,6 +2226,198 @@ static uint32_t wav_read_header(mp3ctrl_handle ctrl)
 
 #ifdef RT_USING_FINSH
 
+static void mp3_stat(uint8_t argc, char **argv)
+{
+    mp3_stat_t stat;
+    mp3ctrl_handle ctrl = g_mp3_running;
+
+    if (ctrl)
+    {
+        mp3_stat_get(ctrl, &stat);
+        mp3_stat_print(&stat);
+    }
+    else
+    {
+        rt_kprintf("last playback:\n");
+        mp3_stat_print(&g_mp3_last_stat);
+    }
+}
+MSH_CMD_EXPORT(mp3_stat, mp3 decoder wakeups and cpu load);
+
+#if RT_USING_DFS
+/*
+    Decode file as fast as possible without audio server.
+    bench: MIPS per stream = decoder cycles / audio seconds
+    conform: compare with 16 bit pcm of reference decoder, ISO/IEC 11172-4 limits in LSB are
+        full accuracy rms < 1/sqrt(12) and max <= 2, limited accuracy rms < 16/sqrt(12)
+    Build libhelix with HELIX_MP3_NO_DSP to get same numbers of C reference kernels.
+*/
+static void mp3_dectest(int argc, char **argv)
+{
+    HMP3Decoder dec;
+    MP3FrameInfo info = {0};
+    uint8_t *inbuf, *read_ptr;
+    int16_t *pcm, *ref = NULL;
+    int fd, ref_fd = -1, bytes_left = 0, eof = 0, err;
+    uint32_t frames = 0, samples = 0, cycles, frame_max = 0, hz;
+    uint64_t total = 0, sq = 0, n = 0;
+    uint32_t diff_max = 0, ref_short = 0;
+    uint8_t conform;
+
+    if (argc < 3 || (strcmp(argv[1], "bench") && strcmp(argv[1], "conform")) ||
+            (!strcmp(argv[1], "conform") && argc < 4))
+    {
+        rt_kprintf("usage: mp3_dectest bench <file.mp3>\n");
+        rt_kprintf("       mp3_dectest conform <file.mp3> <reference.pcm>\n");
+        return;
+    }
+    conform = !strcmp(argv[1], "conform");
+
+    fd = open(argv[2], O_RDONLY | O_BINARY);
+    if (fd < 0)
+    {
+        rt_kprintf("open %s failed\n", argv[2]);
+        return;
+    }
+    if (conform)
+    {
+        ref_fd = open(argv[3], O_RDONLY | O_BINARY);
+        if (ref_fd < 0)
+        {
+            rt_kprintf("open %s failed\n", argv[3]);
+            close(fd);
+            return;
+        }
+    }
+
+    dec = MP3InitDecoder();
+    inbuf = rt_malloc(MAINBUF_SIZE * 2);
+    pcm = rt_malloc(MAX_NCHAN * MAX_NGRAN * MAX_NSAMP * sizeof(int16_t));
+    if (conform)
+        ref = rt_malloc(MAX_NCHAN * MAX_NGRAN * MAX_NSAMP * sizeof(int16_t));
+    if (!dec || !inbuf || !pcm || (conform && !ref))
+    {
+        rt_kprintf("no memory\n");
+        goto exit;
+    }
+
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+    hz = HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT);
+    read_ptr = inbuf;
+
+    while (1)
+    {
+        int offset;
+
+        if (!eof && bytes_left < MAINBUF_SIZE)
+        {
+            int len;
+
+            memmove(inbuf, read_ptr, bytes_left);
+            read_ptr = inbuf;
+            len = read(fd, inbuf + bytes_left, MAINBUF_SIZE * 2 - bytes_left);
+            if (len <= 0)
+                eof = 1;
+            else
+                bytes_left += len;
+        }
+
+        offset = MP3FindSyncWord(read_ptr, bytes_left);
+        if (offset < 0)
+            break;
+        read_ptr += offset;
+        bytes_left -= offset;
+
+        cycles = HAL_DBG_DWT_GetCycles();
+        err = MP3Decode(dec, &read_ptr, &bytes_left, pcm, 0);
+        cycles = HAL_DBG_DWT_GetCycles() - cycles;
+        if (err == ERR_MP3_INDATA_UNDERFLOW)
+        {
+            if (eof)
+                break;
+            continue;
+        }
+        if (err)
+        {
+            /*skip bad frame, main data of next frame may be missing too*/
+            if (err != ERR_MP3_MAINDATA_UNDERFLOW && bytes_left > 0)
+            {
+                read_ptr++;
+                bytes_left--;
+            }
+            continue;
+        }
+
+        MP3GetLastFrameInfo(dec, &info);
+        total += cycles;
+        if (cycles > frame_max)
+            frame_max = cycles;
+        frames++;
+        samples += info.outputSamps / info.nChans;
+
+        if (conform)
+        {
+            int len = read(ref_fd, ref, info.outputSamps * sizeof(int16_t)) / sizeof(int16_t);
+
+            if (len < info.outputSamps)
+                ref_short = 1;
+            for (int i = 0; i < len; i++)
+            {
+                int32_t d = (int32_t)pcm[i] - ref[i];
+                uint32_t ad = d < 0 ? -d : d;
+
+                sq += (uint64_t)((int64_t)d * d);
+                if (ad > diff_max)
+                    diff_max = ad;
+            }
+            n += len;
+        }
+    }
+
+    if (frames && info.samprate)
+    {
+        uint32_t audio_ms = (uint32_t)((uint64_t)samples * 1000 / info.samprate);
+        uint32_t mips = audio_ms ? (uint32_t)(total / audio_ms / 1000) : 0;
+        uint32_t peak = (uint32_t)((uint64_t)frame_max * info.samprate / (info.outputSamps / info.nChans) / 1000000);
+
+        rt_kprintf("%d frames, %d Hz %d ch %d kbps, %d ms audio, decode %d ms at %d MHz\n",
+                   frames, info.samprate, info.nChans, info.bitrate / 1000, audio_ms,
+                   (uint32_t)(total * 1000 / hz), hz / 1000000);
+        rt_kprintf("avg %d cycles/frame, %d MIPS per stream, peak frame %d MIPS\n",
+                   (uint32_t)(total / frames), mips, peak);
+    }
+    if (conform && n)
+    {
+        /* rms^2 in 1/1000 LSB^2, full accuracy limit is 1000/12 */
+        uint32_t ms = (uint32_t)(sq * 1000 / n);
+
+        rt_kprintf("%d samples, max diff %d LSB, mean square %d.%03d LSB^2%s\n",
+                   (uint32_t)n, diff_max, ms / 1000, ms % 1000, ref_short ? ", reference is shorter" : "");
+        if (sq * 12 < n && diff_max <= 2)
+            rt_kprintf("conform: full accuracy\n");
+        else if (sq * 12 < n * 256)
+            rt_kprintf("conform: limited accuracy\n");
+        else
+            rt_kprintf("conform: FAIL\n");
+    }
+
+exit:
+    if (dec)
+        MP3FreeDecoder(dec);
+    if (inbuf)
+        rt_free(inbuf);
+    if (pcm)
+        rt_free(pcm);
+    if (ref)
+        rt_free(ref);
+    if (ref_fd >= 0)
+        close(ref_fd);
+    close(fd);
+}
+MSH_CMD_EXPORT(mp3_dectest, mp3 decoder MIPS benchmark and conformance check);
+#endif
+
 #if MP3_TEST_CMD
 
 /*
@@ -52,9 +52,13 @@
 #include "dfs_file.h"
 #include "dfs_posix.h"
 #include "audio_server.h"
+#include "bf0_hal.h"
 #ifdef PKG_USING_TINYMP3
     #include "shine_mp3.h"
 #endif
+#ifdef PKG_LIB_OPUS
+    #include "opus.h"
+#endif
 
 #define DBG_TAG           "recorder"
 #define DBG_LVL           LOG_LVL_INFO
@@ -66,6 +70,7 @@ typedef enum file_format
     FILE_FMT_PCM    = 0,
     FILE_FMT_MP3    = 1,
     FILE_FMT_WAV    = 2,
+    FILE_FMT_OPUS   = 3,
 } E_FILE_FMT;
 
 typedef enum
@@ -74,6 +79,76 @@ typedef enum
     REC_STATE_RUNNING   = 1,
 } E_REC_STATE;
 
+/*
+    Encoded data is copied to blocks of a pool and written to file by sink thread,
+    so flash write doesn't stall record thread. Data is dropped if pool is full.
+*/
+#ifndef AUDIO_REC_SINK_BLOCK_SIZE
+    #define AUDIO_REC_SINK_BLOCK_SIZE   (2048)
+#endif
+#ifndef AUDIO_REC_SINK_BLOCK_NUM
+    #define AUDIO_REC_SINK_BLOCK_NUM    (4)
+#endif
+
+#ifdef PKG_USING_TINYMP3
+/* 16k mono is taken as voice, subbands above this are not encoded, 0 - full band */
+#ifndef AUDIO_REC_MP3_VOICE_BW
+    #define AUDIO_REC_MP3_VOICE_BW      (7000)
+#endif
+#endif
+
+#ifdef PKG_LIB_OPUS
+/* voice memo, 20ms per frame, packets of 1s in one ogg page */
+#ifndef AUDIO_REC_OPUS_BITRATE
+    #define AUDIO_REC_OPUS_BITRATE      (16000)
+#endif
+#ifndef AUDIO_REC_OPUS_COMPLEXITY
+    #define AUDIO_REC_OPUS_COMPLEXITY   (2)
+#endif
+#ifndef AUDIO_REC_OPUS_STACK_SIZE
+    #define AUDIO_REC_OPUS_STACK_SIZE   (8 * 1024)
+#endif
+#define AUDIO_REC_OPUS_FRAME_MS     (20)
+#define AUDIO_REC_OPUS_MAX_PACKET   (400)
+#define AUDIO_REC_OGG_PAGE_PACKETS  (1000 / AUDIO_REC_OPUS_FRAME_MS)
+#define AUDIO_REC_OGG_BODY_SIZE     (4 * 1024)
+#endif
+
+typedef struct rec_block
+{
+    rt_uint32_t len;
+    rt_uint8_t  data[AUDIO_REC_SINK_BLOCK_SIZE];
+} rec_block_t;
+
+typedef struct
+{
+    rt_uint32_t time_ms;
+    rt_uint32_t frames;         //frames encoded
+    rt_uint32_t pcm_drop;       //frames lost when pcm ringbuf is full
+    rt_uint32_t sink_drop;      //writes lost when sink pool is full
+    rt_uint32_t write_max_ms;   //longest file write of sink thread
+    rt_uint32_t bytes;          //written to file
+    rt_uint64_t busy_us;        //encode time
+} rec_stat_t;
+
+#ifdef PKG_LIB_OPUS
+typedef struct
+{
+    OpusEncoder *enc;
+    rt_uint32_t frame_size;     //pcm bytes of one frame
+    rt_uint32_t pre_skip;
+    rt_uint64_t granule;        //48k samples of packets already in pages
+    rt_uint32_t serial;
+    rt_uint32_t seq;
+    rt_uint32_t body_len;
+    rt_uint32_t segs;
+    rt_uint32_t packets;
+    rt_uint8_t  lacing[255];
+    rt_uint8_t  *body;
+    rt_uint8_t  *packet;
+} rec_opus_t;
+#endif
+
 typedef struct aud_recorder
 {
     E_FILE_FMT fmt;
@@ -89,6 +164,18 @@ typedef struct aud_recorder
     shine_t shine;
     rt_uint32_t per_pass_size;
 #endif
+#ifdef PKG_LIB_OPUS
+    rec_opus_t opus;
+#endif
+    /*async file sink*/
+    rec_block_t *sink_pool;
+    rec_block_t *sink_cur;
+    rt_mailbox_t sink_free;
+    rt_mailbox_t sink_full;
+    rt_thread_t sink_thread;
+    struct rt_semaphore sink_exit;
+    rec_stat_t stat;
+    rt_uint32_t start_ms;
     rt_uint8_t state;
 } RECORDER;
 
@@ -99,19 +186,147 @@ typedef struct aud_recorder
 #define AUDIO_REC_PCM_EVENT         (1 << 2)
 #define AUDIO_REC_MP3_EVENT         (1 << 3)
 #define AUDIO_REC_WAV_EVENT         (1 << 4)
+#define AUDIO_REC_OPUS_EVENT        (1 << 5)
 
 #define AUDIO_REC_ALL_EVENT ( \
                             AUDIO_REC_OPEN_EVENT | \
                             AUDIO_REC_CLOSE_EVENT | \
                             AUDIO_REC_PCM_EVENT | \
                             AUDIO_REC_MP3_EVENT | \
-                            AUDIO_REC_WAV_EVENT \
+                            AUDIO_REC_WAV_EVENT | \
+                            AUDIO_REC_OPUS_EVENT \
                             )
 
 typedef struct aud_recorder *RECORDER_T;
 static struct aud_recorder recorder;
 static rt_event_t rec_event;
 static audio_client_t g_client;
+static rec_stat_t g_rec_last_stat;
+
+static rt_uint32_t rec_busy_us(rt_uint32_t start)
+{
+    return (rt_uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void rec_sink_entry(void *parameter)
+{
+    RECORDER_T rec = (RECORDER_T)parameter;
+    rec_block_t *blk;
+    rt_uint32_t start;
+
+    while (1)
+    {
+        rt_mb_recv(rec->sink_full, (rt_uint32_t *)&blk, RT_WAITING_FOREVER);
+        if (!blk)
+            break;
+        start = rt_tick_get_millisecond();
+        if (write(rec->fd, blk->data, blk->len) != blk->len)
+            LOG_E("rec sink write err\n");
+        else
+            rec->stat.bytes += blk->len;
+        start = rt_tick_get_millisecond() - start;
+        if (start > rec->stat.write_max_ms)
+            rec->stat.write_max_ms = start;
+        blk->len = 0;
+        rt_mb_send(rec->sink_free, (rt_uint32_t)blk);
+    }
+    rt_sem_release(&rec->sink_exit);
+}
+
+static int rec_sink_open(RECORDER_T rec, rt_uint8_t priority)
+{
+    rec->sink_pool = rt_malloc(sizeof(rec_block_t) * AUDIO_REC_SINK_BLOCK_NUM);
+    rec->sink_free = rt_mb_create("rec_free", AUDIO_REC_SINK_BLOCK_NUM, RT_IPC_FLAG_FIFO);
+    //one more for exit message
+    rec->sink_full = rt_mb_create("rec_full", AUDIO_REC_SINK_BLOCK_NUM + 1, RT_IPC_FLAG_FIFO);
+    if (!rec->sink_pool || !rec->sink_free || !rec->sink_full)
+        return -1;
+    for (int i = 0; i < AUDIO_REC_SINK_BLOCK_NUM; i++)
+    {
+        rec->sink_pool[i].len = 0;
+        rt_mb_send(rec->sink_free, (rt_uint32_t)&rec->sink_pool[i]);
+    }
+    rt_sem_init(&rec->sink_exit, "rec_sink", 0, RT_IPC_FLAG_FIFO);
+    /*lower priority than encoder, file write is done when encoder is idle*/
+    rec->sink_thread = rt_thread_create("rec_sink", rec_sink_entry, rec, 1024, priority + 1, 10);
+    if (!rec->sink_thread)
+        return -1;
+    rt_thread_startup(rec->sink_thread);
+    return 0;
+}
+
+static rt_uint32_t rec_sink_room(RECORDER_T rec)
+{
+    rt_uint32_t room = rec->sink_free->entry * AUDIO_REC_SINK_BLOCK_SIZE;
+
+    if (rec->sink_cur)
+        room += AUDIO_REC_SINK_BLOCK_SIZE - rec->sink_cur->len;
+    return room;
+}
+
+/*copy to blocks of pool, whole write is dropped if no enough room*/
+static int rec_sink_write(RECORDER_T rec, const void *data, rt_uint32_t len)
+{
+    const rt_uint8_t *p = (const rt_uint8_t *)data;
+
+    if (len > rec_sink_room(rec))
+    {
+        rec->stat.sink_drop++;
+        return -1;
+    }
+    while (len)
+    {
+        rt_uint32_t n;
+        if (!rec->sink_cur)
+            rt_mb_recv(rec->sink_free, (rt_uint32_t *)&rec->sink_cur, RT_WAITING_FOREVER);
+        n = AUDIO_REC_SINK_BLOCK_SIZE - rec->sink_cur->len;
+        if (n > len)
+            n = len;
+        memcpy(rec->sink_cur->data + rec->sink_cur->len, p, n);
+        rec->sink_cur->len += n;
+        p += n;
+        len -= n;
+        if (rec->sink_cur->len == AUDIO_REC_SINK_BLOCK_SIZE)
+        {
+            rt_mb_send(rec->sink_full, (rt_uint32_t)rec->sink_cur);
+            rec->sink_cur = NULL;
+        }
+    }
+    return 0;
+}
+
+/*write remaining data and wait sink thread exit*/
+static void rec_sink_close(RECORDER_T rec)
+{
+    if (rec->sink_thread)
+    {
+        if (rec->sink_cur && rec->sink_cur->len)
+            rt_mb_send(rec->sink_full, (rt_uint32_t)rec->sink_cur);
+        rec->sink_cur = NULL;
+        rt_mb_send(rec->sink_full, 0);
+        rt_sem_take(&rec->sink_exit, RT_WAITING_FOREVER);
+        rt_sem_detach(&rec->sink_exit);
+        rec->sink_thread = NULL;
+    }
+    if (rec->sink_free)
+        rt_mb_delete(rec->sink_free);
+    if (rec->sink_full)
+        rt_mb_delete(rec->sink_full);
+    if (rec->sink_pool)
+        rt_free(rec->sink_pool);
+    rec->sink_free = NULL;
+    rec->sink_full = NULL;
+    rec->sink_pool = NULL;
+}
+
+static void rec_stat_print(const rec_stat_t *stat)
+{
+    rt_uint32_t cpu = stat->time_ms ? (rt_uint32_t)(stat->busy_us * 10 / stat->time_ms) : 0;
+
+    rt_kprintf("rec: %d ms, %d frames, encode cpu %d.%02d%%\n", stat->time_ms, stat->frames, cpu / 100, cpu % 100);
+    rt_kprintf("rec: pcm drop %d, sink drop %d, write max %d ms, %d bytes\n",
+               stat->pcm_drop, stat->sink_drop, stat->write_max_ms, stat->bytes);
+}
 
 
 static int audio_record_pcm(RECORDER_T rec)
@@ -125,8 +340,7 @@ static int audio_record_pcm(RECORDER_T rec)
     {
         wrt_len = data_len > AUDIO_REC_TEMP_SIZE ? AUDIO_REC_TEMP_SIZE : data_len;
         rt_ringbuffer_get(rec->pcm_rbf, rec->temp_buf, wrt_len);
-        if (write(rec->fd, rec->temp_buf, wrt_len) != wrt_len)
-            LOG_E("audio_record_pcm write err\n");
+        rec_sink_write(rec, rec->temp_buf, wrt_len);
         data_len -= wrt_len;
         //rt_kprintf("audio_record_pcm %d.\n", wrt_len);
     }
@@ -167,6 +381,8 @@ static int audio_tinymp3_init(RECORDER_T rec)
     config.wave.samplerate = rec->rate;
     config.mpeg.mode = (rec->chs == 1) ? MONO : STEREO;
     config.mpeg.bitr = 64;
+    if ((rec->chs == 1) && (rec->rate == 16000))
+        config.mpeg.bandwidth = AUDIO_REC_MP3_VOICE_BW;
     /*2.check config samplerate bitrate*/
     if (shine_check_config(config.wave.samplerate, config.mpeg.bitr) < 0)
     {
@@ -176,6 +392,11 @@ static int audio_tinymp3_init(RECORDER_T rec)
     check_config(&config);
     /*3.shine init*/
     rec->shine = shine_initialise(&config);
+    if (!rec->shine)
+    {
+        LOG_E("shine init failed\n");
+        return -1;
+    }
     /*4.get sample point num in every frame which shine process one time*/
     samples_per_pass = shine_samples_per_pass(rec->shine) * rec->chs;
     rec->per_pass_size = samples_per_pass * sizeof(rt_uint16_t);
@@ -197,9 +418,11 @@ int audio_record_mp3(RECORDER_T rec, rt_uint8_t last)
     while (rt_ringbuffer_data_len(rec->pcm_rbf) >= rec->per_pass_size)
     {
         rt_ringbuffer_get(rec->pcm_rbf, rec->temp_buf, rec->per_pass_size);
+        rt_uint32_t start = HAL_GTIMER_READ();
         out_data = shine_encode_buffer_interleaved(rec->shine, (int16_t *)rec->temp_buf, &written);
-        if (write(rec->fd, out_data, written) != written)
-            LOG_E("audio_record_mp3 write err1\n");
+        rec->stat.busy_us += rec_busy_us(start);
+        rec->stat.frames++;
+        rec_sink_write(rec, out_data, written);
     }
 
     if (last)
@@ -209,19 +432,206 @@ int audio_record_mp3(RECORDER_T rec, rt_uint8_t last)
             rt_memset(rec->temp_buf, 0, rec->per_pass_size);
             rt_ringbuffer_get(rec->pcm_rbf, rec->temp_buf, rt_ringbuffer_data_len(rec->pcm_rbf));
             out_data = shine_encode_buffer_interleaved(rec->shine, (int16_t *)rec->temp_buf, &written);
-            if (write(rec->fd, out_data, written) != written)
-                LOG_E("audio_record_mp3 write err2\n");
+            rec_sink_write(rec, out_data, written);
         }
 
         out_data = shine_flush(rec->shine, &written);
-        if (write(rec->fd, out_data, written) != written)
-            LOG_E("audio_record_mp3 write err3\n");
+        rec_sink_write(rec, out_data, written);
     }
 
     return 0;
 }
 #endif
 
+#ifdef PKG_LIB_OPUS
+/* Ogg Opus file, RFC 7845 */
+static rt_uint32_t ogg_crc_tab[256];
+
+static rt_uint32_t ogg_crc(rt_uint32_t crc, const rt_uint8_t *p, rt_uint32_t len)
+{
+    if (!ogg_crc_tab[1])
+    {
+        for (rt_uint32_t i = 0; i < 256; i++)
+        {
+            rt_uint32_t r = i << 24;
+            for (int j = 0; j < 8; j++)
+                r = (r & 0x80000000) ? (r << 1) ^ 0x04C11DB7 : (r << 1);
+            ogg_crc_tab[i] = r;
+        }
+    }
+    while (len--)
+        crc = (crc << 8) ^ ogg_crc_tab[((crc >> 24) ^ *p++) & 0xFF];
+    return crc;
+}
+
+static inline void put_le16(rt_uint8_t *p, rt_uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void put_le32(rt_uint8_t *p, rt_uint32_t v)
+{
+    put_le16(p, v);
+    put_le16(p + 2, v >> 16);
+}
+
+/*write packets in body as one page*/
+static void ogg_page_flush(RECORDER_T rec, rt_uint8_t type)
+{
+    rec_opus_t *o = &rec->opus;
+    rt_uint8_t hdr[27 + 255];
+    rt_uint32_t crc;
+
+    memcpy(hdr, "OggS", 4);
+    hdr[4] = 0;
+    hdr[5] = type;
+    put_le32(hdr + 6, (rt_uint32_t)o->granule);
+    put_le32(hdr + 10, (rt_uint32_t)(o->granule >> 32));
+    put_le32(hdr + 14, o->serial);
+    put_le32(hdr + 18, o->seq++);
+    put_le32(hdr + 22, 0);
+    hdr[26] = o->segs;
+    memcpy(hdr + 27, o->lacing, o->segs);
+    crc = ogg_crc(0, hdr, 27 + o->segs);
+    crc = ogg_crc(crc, o->body, o->body_len);
+    put_le32(hdr + 22, crc);
+
+    //page is dropped as a whole if sink is full, player resyncs at next page
+    if (rec_sink_room(rec) >= 27 + o->segs + o->body_len)
+    {
+        rec_sink_write(rec, hdr, 27 + o->segs);
+        rec_sink_write(rec, o->body, o->body_len);
+    }
+    else
+    {
+        rec->stat.sink_drop++;
+    }
+    o->body_len = 0;
+    o->segs = 0;
+    o->packets = 0;
+}
+
+static void ogg_add_packet(RECORDER_T rec, const rt_uint8_t *data, rt_uint32_t len, rt_uint32_t samples_48k)
+{
+    rec_opus_t *o = &rec->opus;
+    rt_uint32_t segs = len / 255 + 1;
+
+    if (o->segs + segs > 255 || o->body_len + len > AUDIO_REC_OGG_BODY_SIZE)
+        ogg_page_flush(rec, 0);
+    memcpy(o->body + o->body_len, data, len);
+    o->body_len += len;
+    while (segs-- > 1)
+        o->lacing[o->segs++] = 255;
+    o->lacing[o->segs++] = len % 255;
+    o->granule += samples_48k;
+    if (++o->packets >= AUDIO_REC_OGG_PAGE_PACKETS)
+        ogg_page_flush(rec, 0);
+}
+
+static int audio_opus_init(RECORDER_T rec)
+{
+    rec_opus_t *o = &rec->opus;
+    static const char vendor[] = "sifli";
+    rt_uint8_t head[19];
+    rt_uint8_t tags[8 + 4 + sizeof(vendor) - 1 + 4];
+    opus_int32 lookahead = 0;
+    int err;
+
+    RT_ASSERT(rec);
+    o->enc = opus_encoder_create(rec->rate, rec->chs, OPUS_APPLICATION_VOIP, &err);
+    if (!o->enc)
+    {
+        LOG_E("opus encoder create err=%d\n", err);
+        return -1;
+    }
+    opus_encoder_ctl(o->enc, OPUS_SET_BITRATE(AUDIO_REC_OPUS_BITRATE));
+    opus_encoder_ctl(o->enc, OPUS_SET_COMPLEXITY(AUDIO_REC_OPUS_COMPLEXITY));
+    opus_encoder_ctl(o->enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_encoder_ctl(o->enc, OPUS_SET_VBR(1));
+    opus_encoder_ctl(o->enc, OPUS_GET_LOOKAHEAD(&lookahead));
+
+    o->frame_size = rec->rate * AUDIO_REC_OPUS_FRAME_MS / 1000 * rec->chs * sizeof(rt_int16_t);
+    o->pre_skip = lookahead * (48000 / rec->rate);
+    o->serial = rt_tick_get();
+    o->body = rt_malloc(AUDIO_REC_OGG_BODY_SIZE);
+    o->packet = rt_malloc(AUDIO_REC_OPUS_MAX_PACKET);
+    rec->temp_buf = rt_calloc(1, o->frame_size);
+    if (!o->body || !o->packet || !rec->temp_buf)
+        return -1;
+
+    /*identification and comment header, each in own page*/
+    memcpy(head, "OpusHead", 8);
+    head[8] = 1;
+    head[9] = rec->chs;
+    put_le16(head + 10, o->pre_skip);
+    put_le32(head + 12, rec->rate);
+    put_le16(head + 16, 0);
+    head[18] = 0;
+    memcpy(o->body, head, sizeof(head));
+    o->body_len = sizeof(head);
+    o->lacing[0] = sizeof(head);
+    o->segs = 1;
+    ogg_page_flush(rec, 0x02);
+
+    memcpy(tags, "OpusTags", 8);
+    put_le32(tags + 8, sizeof(vendor) - 1);
+    memcpy(tags + 12, vendor, sizeof(vendor) - 1);
+    put_le32(tags + 12 + sizeof(vendor) - 1, 0);
+    memcpy(o->body, tags, sizeof(tags));
+    o->body_len = sizeof(tags);
+    o->lacing[0] = sizeof(tags);
+    o->segs = 1;
+    ogg_page_flush(rec, 0);
+    LOG_I("opus rate=%d bitrate=%d frame=%d pre_skip=%d\n", rec->rate, AUDIO_REC_OPUS_BITRATE, o->frame_size, o->pre_skip);
+
+    return 0;
+}
+
+static int audio_record_opus(RECORDER_T rec, rt_uint8_t last)
+{
+    rec_opus_t *o = &rec->opus;
+    rt_uint32_t samples = o->frame_size / sizeof(rt_int16_t) / rec->chs;
+
+    RT_ASSERT(rec);
+    while (rt_ringbuffer_data_len(rec->pcm_rbf) >= o->frame_size
+            || (last && rt_ringbuffer_data_len(rec->pcm_rbf)))
+    {
+        rt_uint32_t len = rt_ringbuffer_get(rec->pcm_rbf, rec->temp_buf, o->frame_size);
+        if (len < o->frame_size)
+            rt_memset(rec->temp_buf + len, 0, o->frame_size - len);
+
+        rt_uint32_t start = HAL_GTIMER_READ();
+        opus_int32 n = opus_encode(o->enc, (const opus_int16 *)rec->temp_buf, samples, o->packet, AUDIO_REC_OPUS_MAX_PACKET);
+        rec->stat.busy_us += rec_busy_us(start);
+        if (n < 0)
+        {
+            LOG_E("opus encode err=%d\n", n);
+            continue;
+        }
+        rec->stat.frames++;
+        ogg_add_packet(rec, o->packet, n, samples * (48000 / rec->rate));
+    }
+    if (last)
+        ogg_page_flush(rec, 0x04);
+
+    return 0;
+}
+
+static void audio_opus_deinit(RECORDER_T rec)
+{
+    rec_opus_t *o = &rec->opus;
+
+    if (o->enc)
+        opus_encoder_destroy(o->enc);
+    if (o->body)
+        rt_free(o->body);
+    if (o->packet)
+        rt_free(o->packet);
+    rt_memset(o, 0, sizeof(rec_opus_t));
+}
+#endif
+
 static int audio_record_wav(RECORDER_T rec)
 {
     return 0;
@@ -247,6 +657,7 @@ static int audio_record_callback(audio_server_callback_cmt_t cmd, void *callback
         }
         else
         {
+            rec->stat.pcm_drop++;
             LOG_E("pcm rbf full, lost data!\n");
         }
         /*send record event by fmt*/
@@ -254,6 +665,10 @@ static int audio_record_callback(audio_server_callback_cmt_t cmd, void *callback
         {
             rt_event_send(rec_event, AUDIO_REC_MP3_EVENT);
         }
+        else if (rec->fmt == FILE_FMT_OPUS)
+        {
+            rt_event_send(rec_event, AUDIO_REC_OPUS_EVENT);
+        }
         else if (rec->fmt == FILE_FMT_WAV)
         {
             rt_event_send(rec_event, AUDIO_REC_WAV_EVENT);
@@ -284,6 +699,9 @@ static int audio_record_open(RECORDER_T rec)
     }
     rec->fd = open(rec->file_name, O_RDWR | O_CREAT | O_TRUNC | O_BINARY);
     RT_ASSERT(rec->fd >= 0);
+    rt_memset(&rec->stat, 0, sizeof(rec->stat));
+    if (rec_sink_open(rec, rt_thread_self()->current_priority))
+        goto ERR;
 
     /*init mp3 or wav encoder*/
     if (rec->fmt == FILE_FMT_MP3)
@@ -291,6 +709,13 @@ static int audio_record_open(RECORDER_T rec)
 #ifdef PKG_USING_TINYMP3
         if (audio_tinymp3_init(rec))
             goto ERR;
+#endif
+    }
+    else if (rec->fmt == FILE_FMT_OPUS)
+    {
+#ifdef PKG_LIB_OPUS
+        if (audio_opus_init(rec))
+            goto ERR;
 #endif
     }
     else if (rec->fmt == FILE_FMT_WAV)
@@ -318,6 +743,7 @@ static int audio_record_open(RECORDER_T rec)
 
     rec->client = audio_open(AUDIO_TYPE_LOCAL_MUSIC, AUDIO_RX, &pa, audio_record_callback, (void *)rec);
     RT_ASSERT(rec->client);
+    rec->start_ms = rt_tick_get_millisecond();
     rec->state = REC_STATE_RUNNING;
     /*start a timer*/
 
@@ -325,6 +751,12 @@ static int audio_record_open(RECORDER_T rec)
 
     return 0;
 ERR:
+#ifdef PKG_LIB_OPUS
+    audio_opus_deinit(rec);
+#endif
+    rec_sink_close(rec);
+    if (rec->temp_buf)
+        rt_free(rec->temp_buf);
     close(rec->fd);
     unlink(rec->file_name);
     rt_ringbuffer_destroy(rec->pcm_rbf);
@@ -347,6 +779,13 @@ static int audio_record_close(RECORDER_T rec)
         audio_record_mp3(rec, 1);
         /*close shine*/
         shine_close(rec->shine);
+#endif
+    }
+    else if (rec->fmt == FILE_FMT_OPUS)
+    {
+#ifdef PKG_LIB_OPUS
+        audio_record_opus(rec, 1);
+        audio_opus_deinit(rec);
 #endif
     }
     else if (rec->fmt == FILE_FMT_WAV)
@@ -357,8 +796,12 @@ static int audio_record_close(RECORDER_T rec)
     {
         audio_record_pcm(rec);
     }
-    /*close file*/
+    /*wait sink done, close file*/
+    rec_sink_close(rec);
     close(rec->fd);
+    rec->stat.time_ms = rt_tick_get_millisecond() - rec->start_ms;
+    g_rec_last_stat = rec->stat;
+    rec_stat_print(&g_rec_last_stat);
     /*free temp buf, distroy ringbuf*/
     rt_free(rec->temp_buf);
     rt_ringbuffer_destroy(rec->pcm_rbf);
@@ -405,6 +848,13 @@ static void audio_record_entry(void *parameter)
             {
                 audio_record_wav(&recorder);
             }
+
+            if (evt & AUDIO_REC_OPUS_EVENT)
+            {
+#ifdef PKG_LIB_OPUS
+                audio_record_opus(&recorder, 0);
+#endif
+            }
         }
     }
 }
@@ -416,12 +866,14 @@ static void record(uint8_t argc, char **argv)
     rt_thread_t tid;
     char *fmt = NULL;
     rt_uint8_t record_seconds = 0;
+    rt_uint32_t stack_size = 1536;
 
     if (argc < 5)
     {
         LOG_E("[Error]: Invalid argument input!\n \
             [Format]: {cmd} {fmt} {rate} {time} {name}.\n \
-            [Example]: record mp3 16000 10s mp3_1.\n");
+            [Example]: record mp3 16000 10s mp3_1.\n \
+            [Example]: record opus 16000 10s memo_1.\n");
         return;
     }
 
@@ -441,6 +893,18 @@ static void record(uint8_t argc, char **argv)
         LOG_W("mp3 encoder not open, save as pcm data!\n");
         rec->fmt = FILE_FMT_PCM;
         fmt = ".pcm";
+#endif
+    }
+    else if (!strncmp(argv[1], "opus", 4))
+    {
+#ifdef PKG_LIB_OPUS
+        rec->fmt = FILE_FMT_OPUS;
+        fmt = ".opus";
+        stack_size = AUDIO_REC_OPUS_STACK_SIZE;
+#else
+        LOG_W("opus encoder not open, save as pcm data!\n");
+        rec->fmt = FILE_FMT_PCM;
+        fmt = ".pcm";
 #endif
     }
     else if (!strncmp(argv[1], "wav", 3))
@@ -462,6 +926,11 @@ static void record(uint8_t argc, char **argv)
         LOG_E("record err sample rate, should be 16000/44100/48000!\n");
         return;
     }
+    if (rec->fmt == FILE_FMT_OPUS && rec->rate == 44100)
+    {
+        LOG_E("opus record err sample rate, should be 16000/48000!\n");
+        return;
+    }
 
     sscanf(argv[3], "%lds", &rec->time);
     if (!rec->time)
@@ -480,12 +949,12 @@ static void record(uint8_t argc, char **argv)
     strcat(rec->file_name, fmt);
 
     LOG_I("name:%s, fmt:%s, rate:%d, time:%ds.\n", rec->file_name,
-          !rec->fmt ? "pcm" : rec->fmt == 1 ? "mp3" : "wav", rec->rate, rec->time);
+          !rec->fmt ? "pcm" : rec->fmt == 1 ? "mp3" : rec->fmt == 2 ? "wav" : "opus", rec->rate, rec->time);
 
     rec_event = rt_event_create("recorder", RT_IPC_FLAG_FIFO);
     RT_ASSERT(rec_event);
     /*create rec process thread*/
-    tid = rt_thread_create("recorder", audio_record_entry, NULL, 1536, 16, 10);
+    tid = rt_thread_create("recorder", audio_record_entry, NULL, stack_size, 16, 10);
     rt_thread_startup(tid);
     /*open audio record*/
     rt_event_send(rec_event, AUDIO_REC_OPEN_EVENT);
@@ -509,6 +978,96 @@ static void record(uint8_t argc, char **argv)
 }
 
 MSH_CMD_EXPORT(record, audio recorder);
+
+static void record_stat(uint8_t argc, char **argv)
+{
+    RECORDER_T rec = &recorder;
+
+    if (rec->state == REC_STATE_RUNNING)
+    {
+        rec_stat_t stat = rec->stat;
+        stat.time_ms = rt_tick_get_millisecond() - rec->start_ms;
+        rec_stat_print(&stat);
+    }
+    else
+    {
+        rec_stat_print(&g_rec_last_stat);
+    }
+}
+MSH_CMD_EXPORT(record_stat, recorder encode cpu and dropped frames);
+
+#ifdef PKG_USING_TINYMP3
+/*
+    Encode generated tone + noise without mic and file, real time factor is
+    encode time / audio duration, e.g. mp3_bench 16000 1 7000
+*/
+static int mp3_bench(int argc, char **argv)
+{
+    shine_config_t config = {0};
+    shine_t shine;
+    int16_t *pcm;
+    rt_uint32_t i, frame, samples, start, us, max_us = 0, rtf;
+    rt_uint32_t seed = 1, frames = 50;
+    rt_uint64_t busy_us = 0, audio_us;
+    int written;
+
+    set_defaults(&config);
+    config.wave.samplerate = (argc > 1) ? strtoul(argv[1], NULL, 10) : 16000;
+    config.wave.channels = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+    config.mpeg.mode = (config.wave.channels == 1) ? MONO : STEREO;
+    config.mpeg.bitr = 64;
+    if (argc > 3)
+        config.mpeg.bandwidth = strtoul(argv[3], NULL, 10);
+    else if ((config.wave.channels == 1) && (config.wave.samplerate == 16000))
+        config.mpeg.bandwidth = AUDIO_REC_MP3_VOICE_BW;
+
+    if (shine_check_config(config.wave.samplerate, config.mpeg.bitr) < 0)
+    {
+        rt_kprintf("unsupported samplerate %d\n", config.wave.samplerate);
+        return -1;
+    }
+    shine = shine_initialise(&config);
+    if (!shine)
+    {
+        rt_kprintf("shine init failed\n");
+        return -1;
+    }
+    samples = shine_samples_per_pass(shine) * config.wave.channels;
+    pcm = rt_malloc(samples * sizeof(int16_t));
+    RT_ASSERT(pcm);
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        /*triangle at ~500Hz plus white noise, so quantization loop works as on speech*/
+        for (i = 0; i < samples; i++)
+        {
+            rt_uint32_t t = (frame * samples + i) / config.wave.channels;
+            int32_t tri = (int32_t)(((rt_uint64_t)t * 500 * 1024 / config.wave.samplerate) & 0x3FF) - 512;
+
+            seed = seed * 1103515245 + 12345;
+            pcm[i] = (int16_t)((tri < 0 ? -tri : tri) * 32 - 8192 + (int32_t)((seed >> 16) & 0xFFF) - 2048);
+        }
+        start = HAL_GTIMER_READ();
+        shine_encode_buffer_interleaved(shine, pcm, &written);
+        us = rec_busy_us(start);
+        busy_us += us;
+        if (us > max_us)
+            max_us = us;
+    }
+    shine_flush(shine, &written);
+    shine_close(shine);
+    rt_free(pcm);
+
+    audio_us = (rt_uint64_t)frames * samples / config.wave.channels * 1000000 / config.wave.samplerate;
+    rtf = (rt_uint32_t)(busy_us * 1000 / audio_us);
+    rt_kprintf("mp3 %dHz %dch bw %d: %d frames, avg %d us, max %d us, rtf %d.%03d\n",
+               config.wave.samplerate, config.wave.channels, config.mpeg.bandwidth, frames,
+               (rt_uint32_t)(busy_us / frames), max_us, rtf / 1000, rtf % 1000);
+
+    return 0;
+}
+MSH_CMD_EXPORT(mp3_bench, mp3 encoder real time factor);
+#endif
 #endif
 
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,375 @@
+/**
+  ******************************************************************************
+  * @file   mp3_seek_index.c
+  * @author Sifli software development team
+  * @brief Seek index of mp3 file, from Xing/VBRI TOC or built while playing.
+ *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2022 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include "os_adaptor.h"
+#if RT_USING_DFS
+    #include "dfs_file.h"
+    #include "dfs_posix.h"
+#endif
+#include "mp3_seek_index.h"
+
+#undef audio_mem_malloc
+#undef audio_mem_free
+#undef audio_mem_calloc
+#define audio_mem_malloc    rt_malloc
+#define audio_mem_free      rt_free
+#define audio_mem_calloc    rt_calloc
+
+#define DBG_TAG           "audio"
+#define DBG_LVL           LOG_LVL_INFO
+#include "log.h"
+
+#define MP3_SEEK_INDEX_MAGIC    0x5844494D  //"MIDX"
+#define MP3_SEEK_INDEX_VERSION  1
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t file_size;
+    uint32_t frames;
+    uint32_t samplerate;
+    uint32_t frame_samples;
+    uint32_t step;
+    uint32_t num;
+} mp3_seek_index_file_t;
+
+static inline uint32_t rb32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint32_t rb16(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static int index_alloc(mp3_seek_index_t *idx)
+{
+    if (!idx->entry)
+        idx->entry = audio_mem_malloc(MP3_SEEK_INDEX_MAX * sizeof(uint32_t));
+    return idx->entry ? 0 : -1;
+}
+
+#if RT_USING_DFS
+static void index_load(mp3_seek_index_t *idx)
+{
+    mp3_seek_index_file_t hdr;
+    int fd = open(idx->path, O_RDONLY | O_BINARY);
+    if (fd < 0)
+        return;
+
+    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)
+            || hdr.magic != MP3_SEEK_INDEX_MAGIC
+            || hdr.version != MP3_SEEK_INDEX_VERSION
+            || hdr.file_size != idx->file_size
+            || hdr.num == 0 || hdr.num > MP3_SEEK_INDEX_MAX
+            || hdr.step == 0 || hdr.samplerate == 0 || hdr.frame_samples == 0)
+    {
+        LOG_I("mp3 index %s mismatch", idx->path);
+        goto Exit;
+    }
+    if (index_alloc(idx) < 0)
+        goto Exit;
+    if (read(fd, idx->entry, hdr.num * sizeof(uint32_t)) != (int)(hdr.num * sizeof(uint32_t)))
+        goto Exit;
+
+    idx->num = hdr.num;
+    idx->step = hdr.step;
+    idx->frames = hdr.frames;
+    idx->samplerate = hdr.samplerate;
+    idx->frame_samples = hdr.frame_samples;
+    idx->complete = (hdr.frames != 0);
+    LOG_I("mp3 index load n=%d step=%d frames=%d", idx->num, idx->step, idx->frames);
+Exit:
+    close(fd);
+}
+
+static void index_save(mp3_seek_index_t *idx)
+{
+    mp3_seek_index_file_t hdr;
+    int fd;
+
+    if (!idx->path || !idx->dirty || idx->num == 0)
+        return;
+    idx->dirty = 0;
+
+    fd = open(idx->path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0);
+    if (fd < 0)
+    {
+        LOG_I("mp3 index %s not saved", idx->path);
+        return;
+    }
+    hdr.magic = MP3_SEEK_INDEX_MAGIC;
+    hdr.version = MP3_SEEK_INDEX_VERSION;
+    hdr.file_size = idx->file_size;
+    hdr.frames = idx->complete ? idx->frames : 0;
+    hdr.samplerate = idx->samplerate;
+    hdr.frame_samples = idx->frame_samples;
+    hdr.step = idx->step;
+    hdr.num = idx->num;
+    if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)
+            || write(fd, idx->entry, idx->num * sizeof(uint32_t)) != (int)(idx->num * sizeof(uint32_t)))
+    {
+        LOG_I("mp3 index write error");
+        close(fd);
+        unlink(idx->path);
+        return;
+    }
+    close(fd);
+    LOG_I("mp3 index save n=%d step=%d frames=%d", idx->num, idx->step, hdr.frames);
+}
+#else
+#define index_load(idx)
+#define index_save(idx)
+#endif
+
+mp3_seek_index_t *mp3_seek_index_create(const char *filename, uint32_t file_size)
+{
+    mp3_seek_index_t *idx = audio_mem_calloc(1, sizeof(mp3_seek_index_t));
+    if (!idx)
+        return NULL;
+
+    idx->file_size = file_size;
+    idx->step = MP3_SEEK_INDEX_STEP;
+#if RT_USING_DFS
+    if (filename)
+    {
+        idx->path = audio_mem_malloc(strlen(filename) + 5);
+        if (idx->path)
+        {
+            strcpy(idx->path, filename);
+            strcat(idx->path, ".idx");
+            index_load(idx);
+        }
+    }
+#endif
+    return idx;
+}
+
+void mp3_seek_index_destroy(mp3_seek_index_t *idx)
+{
+    if (!idx)
+        return;
+    index_save(idx);
+    if (idx->entry)
+        audio_mem_free(idx->entry);
+    if (idx->path)
+        audio_mem_free(idx->path);
+    audio_mem_free(idx);
+}
+
+int mp3_seek_index_parse(mp3_seek_index_t *idx, const uint8_t *frame, uint32_t len, uint32_t base)
+{
+    static const uint16_t samplerate_tab[3] = {44100, 48000, 32000};
+    const uint8_t *p;
+    uint32_t ver, layer, sr, mono, side;
+
+    if (!idx || len < 4 || frame[0] != 0xFF || (frame[1] & 0xE0) != 0xE0)
+        return -1;
+    ver = (frame[1] >> 3) & 3;      //3: MPEG1, 2: MPEG2, 0: MPEG2.5
+    layer = (frame[1] >> 1) & 3;    //1: layer III
+    sr = (frame[2] >> 2) & 3;
+    if (ver == 1 || layer == 0 || sr == 3)
+        return -1;
+
+    mono = ((frame[3] >> 6) & 3) == 3;
+    idx->base = base;
+    idx->samplerate = samplerate_tab[sr] >> (ver == 3 ? 0 : (ver == 2 ? 1 : 2));
+    if (layer == 3)
+        idx->frame_samples = 384;
+    else if (layer == 2 || ver == 3)
+        idx->frame_samples = 1152;
+    else
+        idx->frame_samples = 576;
+
+    //Xing/Info is after side info
+    side = (ver == 3) ? (mono ? 17 : 32) : (mono ? 9 : 17);
+    p = frame + 4 + side;
+    if (len >= 4 + side + 120 && (!memcmp(p, "Xing", 4) || !memcmp(p, "Info", 4)))
+    {
+        uint32_t flags = rb32(p + 4);
+        p += 8;
+        if (flags & 1)
+        {
+            idx->frames = rb32(p);
+            p += 4;
+        }
+        if (flags & 2)
+        {
+            idx->bytes = rb32(p);
+            p += 4;
+        }
+        if ((flags & 4) && idx->bytes)
+        {
+            memcpy(idx->toc, p, sizeof(idx->toc));
+            idx->has_toc = 1;
+        }
+        LOG_I("mp3 xing frames=%d bytes=%d toc=%d", idx->frames, idx->bytes, idx->has_toc);
+        return 0;
+    }
+
+    //VBRI is always 32 bytes after header
+    p = frame + 4 + 32;
+    if (len >= 4 + 32 + 26 && !memcmp(p, "VBRI", 4))
+    {
+        uint32_t n = rb16(p + 18);
+        uint32_t scale = rb16(p + 20);
+        uint32_t size = rb16(p + 22);
+        uint32_t per = rb16(p + 24);
+        uint32_t acc = base;
+
+        idx->frames = rb32(p + 14);
+        LOG_I("mp3 vbri frames=%d toc=%d", idx->frames, n);
+        /* entries of VBRI TOC are size of every per frames, same as our index */
+        if (idx->num || n == 0 || n >= MP3_SEEK_INDEX_MAX || per == 0
+                || size == 0 || size > 4 || len < 4 + 32 + 26 + n * size
+                || index_alloc(idx) < 0)
+            return 0;
+        p += 26;
+        idx->step = per;
+        idx->entry[0] = acc;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t v = 0;
+            for (uint32_t j = 0; j < size; j++)
+                v = (v << 8) | *p++;
+            acc += v * scale;
+            idx->entry[i + 1] = acc;
+        }
+        idx->num = n + 1;
+        idx->complete = 1;
+    }
+    return 0;
+}
+
+uint32_t mp3_seek_index_next(mp3_seek_index_t *idx)
+{
+    if (!idx || idx->complete || idx->has_toc || !idx->frame_samples)
+        return MP3_SEEK_INDEX_NONE;
+    return idx->num * idx->step;
+}
+
+void mp3_seek_index_add(mp3_seek_index_t *idx, uint32_t offset)
+{
+    if (mp3_seek_index_next(idx) == MP3_SEEK_INDEX_NONE || index_alloc(idx) < 0)
+        return;
+
+    if (idx->num == MP3_SEEK_INDEX_MAX)
+    {
+        /* keep even entries, this frame is also next one of doubled step */
+        for (uint32_t i = 0; i < MP3_SEEK_INDEX_MAX / 2; i++)
+            idx->entry[i] = idx->entry[i * 2];
+        idx->num = MP3_SEEK_INDEX_MAX / 2;
+        idx->step *= 2;
+    }
+    idx->entry[idx->num++] = offset;
+    idx->dirty = 1;
+}
+
+void mp3_seek_index_finish(mp3_seek_index_t *idx, uint32_t frames)
+{
+    if (mp3_seek_index_next(idx) == MP3_SEEK_INDEX_NONE || idx->num == 0)
+        return;
+    idx->frames = frames;
+    idx->complete = 1;
+    idx->dirty = 1;
+    index_save(idx);
+}
+
+uint32_t mp3_seek_index_duration(mp3_seek_index_t *idx)
+{
+    if (!idx || !idx->frames || !idx->samplerate)
+        return 0;
+    return (uint64_t)idx->frames * idx->frame_samples / idx->samplerate;
+}
+
+int mp3_seek_index_lookup(mp3_seek_index_t *idx, uint32_t seconds, uint32_t *offset, uint32_t *frame_index)
+{
+    uint32_t frame, i;
+
+    if (!idx || !idx->samplerate || !idx->frame_samples)
+        return -1;
+
+    frame = (uint64_t)seconds * idx->samplerate / idx->frame_samples;
+    if (idx->has_toc && idx->frames)
+    {
+        /* position in 1/256 percent, linear between TOC points */
+        uint32_t pos, a, b;
+        if (frame > idx->frames)
+            frame = idx->frames;
+        pos = (uint64_t)frame * 100 * 256 / idx->frames;
+        i = pos >> 8;
+        if (i >= 99)
+        {
+            i = 99;
+            b = 256;
+        }
+        else
+        {
+            b = idx->toc[i + 1];
+        }
+        a = idx->toc[i];
+        if (b < a)
+            b = a;
+        *offset = idx->base + (uint32_t)((uint64_t)(a * 256 + (b - a) * (pos & 0xFF)) * idx->bytes / 65536);
+        *frame_index = frame;
+        return 0;
+    }
+
+    i = frame / idx->step;
+    if (idx->num == 0 || (i >= idx->num && !idx->complete))
+        return -1;
+    if (i >= idx->num)
+        i = idx->num - 1;
+    *offset = idx->entry[i];
+    *frame_index = i * idx->step;
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file   mp3_seek_index.h
+  * @author Sifli software development team
+  * @brief Seek index of mp3 file, from Xing/VBRI TOC or built while playing.
+ *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2022 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MP3_SEEK_INDEX_H
+#define MP3_SEEK_INDEX_H
+
+#include <stdint.h>
+
+/*
+    Byte offset of frames, all offsets are counted from end of ID3v2 tag.
+    Taken from Xing/Info or VBRI header of first frame if present, otherwise
+    one entry every step frames is recorded while playing from start and saved
+    to "<file>.idx", so later seek and duration are exact.
+*/
+#ifndef MP3_SEEK_INDEX_STEP
+    #define MP3_SEEK_INDEX_STEP     (32)    //initial frames per entry, about 0.8s for 44.1k
+#endif
+#ifndef MP3_SEEK_INDEX_MAX
+    #define MP3_SEEK_INDEX_MAX      (1024)  //entries, step is doubled when full
+#endif
+
+#define MP3_SEEK_INDEX_NONE         (0xFFFFFFFF)
+
+typedef struct
+{
+    uint32_t    file_size;
+    uint32_t    frames;         //total frames, 0 if unknown
+    uint32_t    bytes;          //bytes of Xing TOC range
+    uint32_t    base;           //offset of first frame
+    uint32_t    samplerate;
+    uint16_t    frame_samples;  //samples of one channel in one frame
+    uint8_t     has_toc;        //toc[] is valid
+    uint8_t     complete;       //entry[] covers whole file
+    uint8_t     dirty;          //entry[] changed after loaded
+    uint8_t     toc[100];       //Xing TOC, toc[i] * bytes / 256 is offset of i%
+    uint32_t    step;           //frames per entry
+    uint32_t    num;
+    uint32_t   *entry;          //entry[i] is offset of frame i * step
+    char       *path;           //index file, NULL if not saved
+} mp3_seek_index_t;
+
+/**
+ * @brief Create index, load "<filename>.idx" if it's made for same file size.
+ * @param filename - mp3 file, NULL for mp3 in buffer, index is kept in memory only
+ * @param file_size - size of mp3 file or buffer
+ */
+mp3_seek_index_t *mp3_seek_index_create(const char *filename, uint32_t file_size);
+
+/** @brief Save index if changed and free it. */
+void mp3_seek_index_destroy(mp3_seek_index_t *idx);
+
+/**
+ * @brief Parse Xing/Info or VBRI header in first frame.
+ * @param frame - first frame, start with sync word
+ * @param len - valid bytes from frame
+ * @param base - offset of first frame
+ * @return 0 if frame header is valid
+ */
+int mp3_seek_index_parse(mp3_seek_index_t *idx, const uint8_t *frame, uint32_t len, uint32_t base);
+
+/** @brief Frame index whose offset should be added next, MP3_SEEK_INDEX_NONE if not needed. */
+uint32_t mp3_seek_index_next(mp3_seek_index_t *idx);
+
+/** @brief Add offset of frame mp3_seek_index_next(). */
+void mp3_seek_index_add(mp3_seek_index_t *idx, uint32_t offset);
+
+/** @brief Played from start to end, frames is total frames, index is saved. */
+void mp3_seek_index_finish(mp3_seek_index_t *idx, uint32_t frames);
+
+/** @brief Exact duration in seconds, 0 if unknown. */
+uint32_t mp3_seek_index_duration(mp3_seek_index_t *idx);
+
+/**
+ * @brief Find offset to play from seconds.
+ * @param offset - offset of frame
+ * @param frame_index - index of that frame
+ * @return 0 if found, -1 if not indexed
+ */
+int mp3_seek_index_lookup(mp3_seek_index_t *idx, uint32_t seconds, uint32_t *offset, uint32_t *frame_index);
+
+#endif
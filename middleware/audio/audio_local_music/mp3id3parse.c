@@ -118,14 +118,101 @@ static int ff_id3v2_tag_len(const uint8_t *buf)
         len += ID3v2_HEADER_SIZE;
     return len;
 }
-static uint8_t file_read_r8(int fd)
+/*
+    Tag is read through a block buffer, most tags have text frames in first block,
+    large frames like APIC are skipped by moving position only.
+*/
+#ifndef ID3_READ_BUF_SIZE
+    #define ID3_READ_BUF_SIZE       (2048)
+#endif
+
+#ifndef MP3_ID3_SCAN_SLICE_MS
+    #define MP3_ID3_SCAN_SLICE_MS   (20)    //scan time before yield to other threads
+#endif
+#ifndef MP3_ID3_SCAN_SLEEP_MS
+    #define MP3_ID3_SCAN_SLEEP_MS   (5)
+#endif
+
+typedef struct
+{
+    int         fd;
+    int         fd_pos;     //position of fd
+    int         start;      //file offset of buf[0]
+    int         len;        //valid bytes in buf
+    int         pos;        //file offset of next read
+    uint8_t     *buf;
+    uint32_t    reads;      //read() called
+} id3_file_t;
+
+static int id3_file_fill(id3_file_t *f)
+{
+    if (f->fd_pos != f->pos)
+        f->fd_pos = lseek(f->fd, f->pos, SEEK_SET);
+    f->start = f->pos;
+    f->len = read(f->fd, f->buf, ID3_READ_BUF_SIZE);
+    f->reads++;
+    if (f->len < 0)
+        f->len = 0;
+    f->fd_pos += f->len;
+    return f->len;
+}
+
+static int id3_file_read(id3_file_t *f, void *dst, int n)
+{
+    int done = 0;
+    while (done < n)
+    {
+        int off = f->pos - f->start;
+        int size;
+        if (off < 0 || off >= f->len)
+        {
+            if (n - done >= ID3_READ_BUF_SIZE)
+            {
+                //big frame, read to dst directly
+                if (f->fd_pos != f->pos)
+                    f->fd_pos = lseek(f->fd, f->pos, SEEK_SET);
+                size = read(f->fd, (uint8_t *)dst + done, n - done);
+                f->reads++;
+                if (size > 0)
+                {
+                    done += size;
+                    f->pos += size;
+                    f->fd_pos += size;
+                }
+                break;
+            }
+            if (id3_file_fill(f) <= 0)
+                break;
+            off = 0;
+        }
+        size = f->len - off;
+        if (size > n - done)
+            size = n - done;
+        memcpy((uint8_t *)dst + done, f->buf + off, size);
+        done += size;
+        f->pos += size;
+    }
+    return done;
+}
+
+static inline int id3_file_seek(id3_file_t *f, int offset, int whence)
+{
+    if (whence == SEEK_CUR)
+        offset += f->pos;
+    if (offset < 0)
+        return -1;
+    f->pos = offset;
+    return offset;
+}
+
+static uint8_t file_read_r8(id3_file_t *fd)
 {
     uint8_t data = 0;
-    read(fd, &data, 1);
+    id3_file_read(fd, &data, 1);
     return data;
 }
 
-static inline unsigned int file_read_rb16(int fd)
+static inline unsigned int file_read_rb16(id3_file_t *fd)
 {
     unsigned int val;
     val = file_read_r8(fd) << 8;
@@ -133,21 +220,21 @@ static inline unsigned int file_read_rb16(int fd)
     return val;
 }
 
-static inline unsigned int file_read_rb24(int fd)
+static inline unsigned int file_read_rb24(id3_file_t *fd)
 {
     unsigned int val;
     val = file_read_rb16(fd) << 8;
     val |= file_read_r8(fd);
     return val;
 }
-static inline unsigned int file_read_rb32(int fd)
+static inline unsigned int file_read_rb32(id3_file_t *fd)
 {
     unsigned int val;
     val = file_read_rb16(fd) << 16;
     val |= file_read_rb16(fd);
     return val;
 }
-static unsigned int get_size(int fd, int len)
+static unsigned int get_size(id3_file_t *fd, int len)
 {
     int v = 0;
     while (len--)
@@ -180,29 +267,21 @@ static int is_tag(const char *buf, unsigned int len)
     return 1;
 }
 
-static inline int f_tell(int fd)
+static inline int f_tell(id3_file_t *fd)
 {
-#if 0
-    int offset = 0;
-    struct dfs_fd *d = fd_get(fd);
-    if (d)
-        offset = d->size
-                 return offset;
-#else
-    return lseek(fd, 0, SEEK_CUR);
-#endif
+    return fd->pos;
 }
 
 /**
 * Return 1 if the tag of length len at the given offset is valid, 0 if not, -1 on error
 */
-static int check_tag(int fd, int offset, unsigned int len)
+static int check_tag(id3_file_t *fd, int offset, unsigned int len)
 {
     char tag[4];
 
     if (len > 4 ||
-            lseek(fd, offset, SEEK_SET) < 0 ||
-            read(fd, tag, len) < (int)len)
+            id3_file_seek(fd, offset, SEEK_SET) < 0 ||
+            id3_file_read(fd, tag, len) < (int)len)
         return -1;
     else if (/*!avio_rb32(tag) || */is_tag(tag, len))
         return 1;
@@ -373,12 +452,12 @@ static void read_ttag(id3_io_t *fd, uint8_t *dst, int taglen, const char *key)
 
 
 
-static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3_info_t *info)
+static void id3v2_parse(id3_file_t *fd, int len, uint8_t version, uint8_t flags, mp3_id3_info_t *info)
 {
     int isv34, unsync;
     uint32_t tlen;
     char tag[5];
-    int64_t next, end = lseek(fd, 0, SEEK_CUR) + len;
+    int64_t next, end = id3_file_seek(fd, 0, SEEK_CUR) + len;
     int taghdrlen;
     const char *reason = NULL;
     uint8_t *decode_buf = NULL;
@@ -427,7 +506,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
             reason = "invalid extended header length";
             goto error;
         }
-        lseek(fd, extlen, SEEK_CUR);
+        id3_file_seek(fd, extlen, SEEK_CUR);
         len -= extlen + 4;
         if (len < 0)
         {
@@ -449,7 +528,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
         }
         if (isv34)
         {
-            if (read(fd, tag, 4) < 4)
+            if (id3_file_read(fd, tag, 4) < 4)
                 break;
             tag[4] = 0;
             if (version == 3)
@@ -477,7 +556,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
                             tlen = size_to_syncsafe(tlen);
                         else if (check_tag(fd, cur + 2 + tlen, 4) != 1)
                             break;
-                        lseek(fd, cur, SEEK_SET);
+                        id3_file_seek(fd, cur, SEEK_SET);
                     }
                     else
                         tlen = size_to_syncsafe(tlen);
@@ -489,7 +568,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
         }
         else
         {
-            if (read(fd, tag, 3) < 3)
+            if (id3_file_read(fd, tag, 3) < 3)
                 break;
             tag[3] = 0;
             tlen = file_read_rb24(fd);
@@ -534,7 +613,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
                 type = "encrypted and compressed";
 
             LOG_I("Skipping %s ID3v2 frame %s", type, tag);
-            lseek(fd, tlen, SEEK_CUR);
+            id3_file_seek(fd, tlen, SEEK_CUR);
             /* check for text tag or supported special meta tag */
         }
         else if (!memcmp("TIT2", tag, 4) || !memcmp("TPE1", tag, 4) || !memcmp("TALB", tag, 4) || !memcmp("TYER", tag, 4))
@@ -598,11 +677,11 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
             }
             if (unsync || tunsync)
             {
-                int64_t end = lseek(fd, 0, SEEK_CUR) + tlen;
+                int64_t end = id3_file_seek(fd, 0, SEEK_CUR) + tlen;
                 uint8_t *b;
 
                 b = buffer;
-                while (lseek(fd, 0, SEEK_CUR) < end && b - buffer < tlen)
+                while (id3_file_seek(fd, 0, SEEK_CUR) < end && b - buffer < tlen)
                 {
                     *b++ = file_read_r8(fd);
                     if (*(b - 1) == 0xff && f_tell(fd) < end - 1 && b - buffer < tlen)
@@ -615,7 +694,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
             }
             else if (!tcomp)
             {
-                if (read(fd, buffer, tlen) < 0)
+                if (id3_file_read(fd, buffer, tlen) < 0)
                 {
                     goto seek;
                 }
@@ -639,7 +718,7 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
 
                 if (!(unsync || tunsync))
                 {
-                    err = read(fd, buffer, tlen);
+                    err = id3_file_read(fd, buffer, tlen);
                     if (err < 0)
                     {
                         LOG_I("Failed to read compressed tag");
@@ -688,12 +767,12 @@ static void id3v2_parse(int fd, int len, uint8_t version, uint8_t flags, mp3_id3
         {
             if (tag[1])
                 LOG_I("invalid frame id, assuming padding\n");
-            lseek(fd, tlen, SEEK_CUR);
+            id3_file_seek(fd, tlen, SEEK_CUR);
             break;
         }
         /* Skip to end of tag */
 seek:
-        lseek(fd, next, SEEK_SET);
+        id3_file_seek(fd, next, SEEK_SET);
     }
 
     /* Footer preset, always 10 bytes, skip over it */
@@ -703,7 +782,7 @@ seek:
 error:
     if (reason)
         LOG_I("ID3v2.%d tag skipped, cannot handle %s\n", version, reason);
-    lseek(fd, end, SEEK_SET);
+    id3_file_seek(fd, end, SEEK_SET);
     if (buffer)
         audio_mem_free(buffer);
     if (uncompressed_buffer)
@@ -738,40 +817,30 @@ void mp3_get_id3_end(mp3_id3_info_t *info)
             audio_mem_free(info->album);
     }
 }
-/*only support id3V2.3*/
-int mp3_get_id3_start(const char *filename, mp3_id3_info_t *info)
+static int id3_get(id3_file_t *f, const char *filename, mp3_id3_info_t *info)
 {
-    int fd;
     int ret = 0;
 
     uint32_t     file_size;
     uint32_t     tag_len;
     head_tag     id3;
-    RT_ASSERT(info);
-    memset(info, 0, sizeof(mp3_id3_info_t));
 
-    if (!filename || !info)
+    memset(info, 0, sizeof(mp3_id3_info_t));
+    LOG_D("mp3 open %s", filename);
+    f->fd = open(filename, O_RDONLY | O_BINARY);
+    if (f->fd < 0)
     {
-        LOG_E("mp3 parameter error");
+        LOG_E("mp3 open %s error", filename);
         return -1;
     }
-
-    LOG_I("mp3_getinfo %s", filename);
-    {
-        LOG_I("mp3 open %s", filename);
-        struct stat stat_buf;
-        stat(filename, &stat_buf);
-        file_size = stat_buf.st_size;
-        fd = open(filename, O_RDONLY | O_BINARY);
-        if (fd < 0)
-        {
-            LOG_E("mp3 open %s error", filename);
-            return -1;
-        }
-    }
-
-    read(fd, (char *)&id3, sizeof(id3));
-    if (!is_id3v2_match((const uint8_t *)&id3, "ID3"))
+    file_size = lseek(f->fd, 0, SEEK_END);
+    f->fd_pos = file_size;
+    f->start = 0;
+    f->len = 0;
+    f->pos = 0;
+
+    if (id3_file_read(f, (char *)&id3, sizeof(id3)) != sizeof(id3)
+            || !is_id3v2_match((const uint8_t *)&id3, "ID3"))
     {
         LOG_I("no ID3");
         ret = -1;
@@ -789,10 +858,128 @@ int mp3_get_id3_start(const char *filename, mp3_id3_info_t *info)
         goto Exit;
     }
 
-    id3v2_parse(fd, tag_len, id3.ver, id3.flag, info);
+    id3v2_parse(f, tag_len, id3.ver, id3.flag, info);
 
 Exit:
-    close(fd);
+    close(f->fd);
     return ret;
 }
-#endif
\ No newline at end of file
+
+/*only support id3V2.3*/
+int mp3_get_id3_start(const char *filename, mp3_id3_info_t *info)
+{
+    id3_file_t f = {0};
+    int ret;
+
+    RT_ASSERT(info);
+    memset(info, 0, sizeof(mp3_id3_info_t));
+
+    if (!filename || !info)
+    {
+        LOG_E("mp3 parameter error");
+        return -1;
+    }
+
+    LOG_I("mp3_getinfo %s", filename);
+    f.buf = audio_mem_malloc(ID3_READ_BUF_SIZE);
+    if (!f.buf)
+        return -1;
+    ret = id3_get(&f, filename, info);
+    audio_mem_free(f.buf);
+    return ret;
+}
+
+static int is_mp3_name(const char *name)
+{
+    int len = strlen(name);
+    if (len < 4 || name[len - 4] != '.')
+        return 0;
+    return (name[len - 3] | 0x20) == 'm' && (name[len - 2] | 0x20) == 'p' && name[len - 1] == '3';
+}
+
+int mp3_id3_scan_dir(const char *dir, mp3_id3_scan_cb_t cb, void *user_data)
+{
+    DIR *d;
+    struct dirent *ent;
+    mp3_id3_info_t info;
+    id3_file_t f = {0};
+    char *path;
+    int dir_len, count = 0;
+    uint32_t start, slice;
+
+    if (!dir || !cb)
+        return -1;
+    d = opendir(dir);
+    if (!d)
+    {
+        LOG_E("id3 scan %s error", dir);
+        return -1;
+    }
+    dir_len = strlen(dir);
+    path = audio_mem_malloc(dir_len + 2 + DFS_PATH_MAX);
+    f.buf = audio_mem_malloc(ID3_READ_BUF_SIZE);
+    if (!path || !f.buf)
+    {
+        count = -1;
+        goto Exit;
+    }
+    strcpy(path, dir);
+    if (dir_len == 0 || path[dir_len - 1] != '/')
+        path[dir_len++] = '/';
+
+    start = rt_tick_get_millisecond();
+    slice = start;
+    while ((ent = readdir(d)) != NULL)
+    {
+        if (ent->d_type == DT_DIR || !is_mp3_name(ent->d_name))
+            continue;
+
+        strncpy(path + dir_len, ent->d_name, DFS_PATH_MAX);
+        path[dir_len + DFS_PATH_MAX] = 0;
+        id3_get(&f, path, &info);
+        count++;
+        int stop = cb(path, &info, user_data);
+        mp3_get_id3_end(&info);
+        if (stop)
+            break;
+
+        //give UI a chance to run
+        if (rt_tick_get_millisecond() - slice >= MP3_ID3_SCAN_SLICE_MS)
+        {
+            rt_thread_mdelay(MP3_ID3_SCAN_SLEEP_MS);
+            slice = rt_tick_get_millisecond();
+        }
+    }
+    start = rt_tick_get_millisecond() - start;
+    LOG_I("id3 scan %s: %d files in %d ms, %d.%02d files/s, %d reads", dir, count, start,
+          count * 1000 / (start + 1), count * 100000 / (start + 1) % 100, f.reads);
+
+Exit:
+    closedir(d);
+    if (path)
+        audio_mem_free(path);
+    if (f.buf)
+        audio_mem_free(f.buf);
+    return count;
+}
+
+#if defined(RT_USING_FINSH)
+static int id3_scan_print(const char *filename, mp3_id3_info_t *info, void *user_data)
+{
+    rt_kprintf("%s: %s / %s / %s\n", filename, info->title ? info->title : "", info->artist ? info->artist : "",
+               info->album ? info->album : "");
+    return 0;
+}
+
+static void id3_scan(uint8_t argc, char **argv)
+{
+    if (argc < 2)
+    {
+        rt_kprintf("id3_scan <dir>\n");
+        return;
+    }
+    mp3_id3_scan_dir(argv[1], id3_scan_print, NULL);
+}
+MSH_CMD_EXPORT(id3_scan, scan id3 of mp3 files in dir);
+#endif
+#endif
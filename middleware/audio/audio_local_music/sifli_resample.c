@@ -1,11 +1,167 @@
 #include <rtthread.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <audio_mem.h>
 #include "sifli_resample.h"
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    #include "board.h"
+    #define RESAMPLE_USING_DSP  1
+#endif
 
-sifli_resample_t *sifli_resample_open(uint8_t channels, uint32_t src_samplerate, uint32_t dst_samplerate)
+#define TAPS            SIFLI_RESAMPLE_TAPS
+#define PHASES          SIFLI_RESAMPLE_PHASES
+#define HIST_FRAMES     (TAPS - 1)
+#define DEFAULT_SRC_BYTES(channels)   (576 * 2 * sizeof(int16_t) * (channels))
+
+#define PI_F            3.14159265f
+
+/*
+    windowed sinc low pass, cutoff is below the lower nyquist of src and dst.
+    each phase is normalized to unity DC gain, so the table is Q15 and sum of a phase is 32768.
+*/
+static void resample_make_coef(int16_t *coef, uint32_t src_samplerate, uint32_t dst_samplerate)
+{
+    float fc = 0.90f;
+    float h[TAPS];
+    float sum, d, w;
+    int32_t acc, v;
+
+    if (dst_samplerate < src_samplerate)
+    {
+        fc = fc * (float)dst_samplerate / (float)src_samplerate;
+    }
+
+    for (int phase = 0; phase < PHASES; phase++)
+    {
+        float frac = (float)phase / PHASES;
+        sum = 0.0f;
+        for (int k = 0; k < TAPS; k++)
+        {
+            /*distance from output position, window is centered between tap TAPS/2-1 and TAPS/2*/
+            d = (float)(k - TAPS / 2 + 1) - frac;
+            h[k] = (d == 0.0f) ? fc : sinf(PI_F * fc * d) / (PI_F * d);
+            /*blackman window over [-TAPS/2, TAPS/2]*/
+            w = (d + TAPS / 2) / TAPS;
+            h[k] *= 0.42f - 0.5f * cosf(2.0f * PI_F * w) + 0.08f * cosf(4.0f * PI_F * w);
+            sum += h[k];
+        }
+        acc = 0;
+        for (int k = 0; k < TAPS; k++)
+        {
+            v = (int32_t)(h[k] / sum * 32768.0f + (h[k] >= 0 ? 0.5f : -0.5f));
+            if (v > 32767)
+                v = 32767;
+            else if (v < -32768)
+                v = -32768;
+            coef[phase * TAPS + k] = (int16_t)v;
+            acc += v;
+        }
+        /*put rounding error on the biggest tap to keep DC gain exact*/
+        coef[phase * TAPS + TAPS / 2 - 1 + (phase * 2 >= PHASES)] += (int16_t)(32768 - acc);
+    }
+}
+
+static inline int16_t resample_sat16(int32_t acc)
+{
+#ifdef RESAMPLE_USING_DSP
+    return (int16_t)__SSAT(acc >> 15, 16);
+#else
+    acc >>= 15;
+    if (acc > 32767)
+        return 32767;
+    if (acc < -32768)
+        return -32768;
+    return (int16_t)acc;
+#endif
+}
+
+/*
+    run filter on x[0, n) while the whole window is inside, return output frames.
+    offset is the index in x of frame 0 of current packet.
+    dup: mono output is written to both channels of stereo dst.
+*/
+static uint32_t resample_run(sifli_resample_t *p, const int16_t *x, int32_t n, int32_t offset, int16_t *dst, uint32_t dst_frames, uint8_t dup)
+{
+    uint32_t out = 0;
+    int32_t start;
+    const int16_t *c;
+    const int16_t *s;
+    int32_t acc_l, acc_r;
+
+    while (out < dst_frames)
+    {
+        start = p->pos_int - TAPS / 2 + 1 + offset;
+        if (start + TAPS > n)
+        {
+            break;
+        }
+        RT_ASSERT(start >= 0);
+        c = &p->coef[(p->pos_num * PHASES / p->dst_samplerate) * TAPS];
+        acc_l = 0;
+        acc_r = 0;
+        if (p->channels == 1)
+        {
+            s = &x[start];
+#ifdef RESAMPLE_USING_DSP
+            for (int k = 0; k < TAPS; k += 2)
+            {
+                uint32_t xs, cs;
+                memcpy(&xs, &s[k], sizeof(xs));
+                memcpy(&cs, &c[k], sizeof(cs));
+                acc_l = __SMLAD(xs, cs, acc_l);
+            }
+#else
+            for (int k = 0; k < TAPS; k++)
+            {
+                acc_l += (int32_t)s[k] * c[k];
+            }
+#endif
+            *dst = resample_sat16(acc_l);
+            if (dup)
+            {
+                dst[1] = dst[0];
+                dst++;
+            }
+            dst++;
+        }
+        else
+        {
+            s = &x[start * 2];
+#ifdef RESAMPLE_USING_DSP
+            for (int k = 0; k < TAPS; k += 2)
+            {
+                uint32_t w0, w1, cs;
+                memcpy(&w0, &s[k * 2], sizeof(w0));
+                memcpy(&w1, &s[k * 2 + 2], sizeof(w1));
+                memcpy(&cs, &c[k], sizeof(cs));
+                acc_l = __SMLAD(__PKHBT(w0, w1, 16), cs, acc_l);
+                acc_r = __SMLAD(__PKHTB(w1, w0, 16), cs, acc_r);
+            }
+#else
+            for (int k = 0; k < TAPS; k++)
+            {
+                acc_l += (int32_t)s[k * 2] * c[k];
+                acc_r += (int32_t)s[k * 2 + 1] * c[k];
+            }
+#endif
+            *dst++ = resample_sat16(acc_l);
+            *dst++ = resample_sat16(acc_r);
+        }
+        out++;
+        p->pos_num += p->src_samplerate;
+        while (p->pos_num >= p->dst_samplerate)
+        {
+            p->pos_num -= p->dst_samplerate;
+            p->pos_int++;
+        }
+    }
+    return out;
+}
+
+sifli_resample_t *sifli_resample_open_ex(uint8_t channels, uint32_t src_samplerate, uint32_t dst_samplerate, uint32_t max_src_bytes)
 {
+    RT_ASSERT(channels >= 1 && channels <= SIFLI_RESAMPLE_MAX_CHANNELS);
     sifli_resample_t *p = (sifli_resample_t *)audio_mem_malloc(sizeof(sifli_resample_t));
     if (p)
     {
@@ -14,17 +170,34 @@ sifli_resample_t *sifli_resample_open(uint8_t channels, uint32_t src_samplerate,
         p->channels = channels;
         p->dst_samplerate = dst_samplerate;
         p->ratio = (float)dst_samplerate / (float)src_samplerate;
-        p->dst_size = p->ratio * 576 * 2 * sizeof(int16_t) * channels + 100;
+        /*with tail flushed by last packet*/
+        p->dst_size = (uint32_t)(p->ratio * (max_src_bytes + TAPS * sizeof(int16_t) * channels)) + 100;
         p->dst = (int16_t *)audio_mem_malloc(p->dst_size);
         if (!p->dst)
         {
             audio_mem_free(p);
             return NULL;
         }
+        p->coef = (int16_t *)audio_mem_malloc(PHASES * TAPS * sizeof(int16_t));
+        if (!p->coef)
+        {
+            audio_mem_free(p->dst);
+            audio_mem_free(p);
+            return NULL;
+        }
+        resample_make_coef(p->coef, src_samplerate, dst_samplerate);
+        /*first output is aligned to first input*/
+        p->pos_int = 0;
+        p->pos_num = 0;
     }
     return p;
 }
 
+sifli_resample_t *sifli_resample_open(uint8_t channels, uint32_t src_samplerate, uint32_t dst_samplerate)
+{
+    return sifli_resample_open_ex(channels, src_samplerate, dst_samplerate, DEFAULT_SRC_BYTES(channels));
+}
+
 int16_t *sifli_resample_get_output(sifli_resample_t *p)
 {
     if (p)
@@ -39,122 +212,123 @@ void sifli_resample_close(sifli_resample_t *p)
         {
             audio_mem_free(p->dst);
         }
+        if (p->coef)
+        {
+            audio_mem_free(p->coef);
+        }
         audio_mem_free(p);
     }
 }
-uint32_t sifli_resample_process(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet)
+
+/*output frames of whole packet, written at dst with och channels per frame*/
+static uint32_t resample_process_frames(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet,
+                                        int16_t *dst, uint32_t dst_frames, uint8_t dup)
 {
-    uint32_t new_size =  src_bytes * p->ratio + 100;
-    if (new_size > p->dst_size)
+    uint8_t ch = p->channels;
+    uint8_t och = dup ? 2 : ch;
+    int32_t samples = src_bytes / sizeof(int16_t) / ch;
+    uint32_t current = 0;
+    int32_t m;
+
+    /*windows covering history, run on history + head of packet*/
+    m = samples < HIST_FRAMES ? samples : HIST_FRAMES;
+    memcpy(p->edge, p->hist, HIST_FRAMES * ch * sizeof(int16_t));
+    memcpy(&p->edge[HIST_FRAMES * ch], src, m * ch * sizeof(int16_t));
+    current += resample_run(p, p->edge, HIST_FRAMES + m, HIST_FRAMES, dst, dst_frames, dup);
+
+    /*windows inside packet, no copy*/
+    current += resample_run(p, src, samples, 0, &dst[current * och], dst_frames - current, dup);
+
+    /*keep last frames for next packet*/
+    if (samples >= HIST_FRAMES)
     {
-        p->dst_size = new_size;
-        audio_mem_free(p->dst);
-        p->dst = (int16_t *)audio_mem_malloc(new_size);
-        RT_ASSERT(p->dst);
+        memcpy(p->hist, &src[(samples - HIST_FRAMES) * ch], HIST_FRAMES * ch * sizeof(int16_t));
     }
-
-    if (p->src_samplerate == p->dst_samplerate)
+    else
     {
-        memcpy(p->dst, src, src_bytes);
-        p->dst_bytes = src_bytes;
-        return src_bytes;
+        memcpy(p->hist, &p->edge[samples * ch], HIST_FRAMES * ch * sizeof(int16_t));
     }
-    int16_t *dst = p->dst;
-    uint32_t samples = src_bytes / sizeof(int16_t) / p->channels;
-    uint32_t totla_dst_index = p->total_dst_index;
-    int16_t data_left1, data_right1, data_left2, data_right2;
-    uint32_t current = 0;
-    int32_t  src_index;
-    float src_index_float;
-    float coef;
-    float d1_ratio = 1.0f / p->ratio;
-    while (1)
+    p->pos_int -= samples;
+
+    if (is_last_packet)
     {
-        src_index_float = totla_dst_index * d1_ratio;
-        src_index = (int32_t)src_index_float;
-        coef = src_index_float - src_index;
-        src_index = src_index - p->total_src_index;
-        if (src_index + 1 >= samples)
+        /*flush the tail by repeating last frame*/
+        memcpy(p->edge, p->hist, HIST_FRAMES * ch * sizeof(int16_t));
+        for (int i = 0; i < TAPS / 2; i++)
         {
-            if (p->channels == 1)
-            {
-                p->last_left = src[samples - 1];
-                p->last_right = p->last_right;
-            }
-            else
-            {
-                p->last_left = src[2 * samples - 2];
-                p->last_right = src[2 * samples - 1];
-            }
-            p-> total_src_index += samples;
-            p->total_dst_index = totla_dst_index;
-            break;
+            memcpy(&p->edge[(HIST_FRAMES + i) * ch], &p->hist[(HIST_FRAMES - 1) * ch], ch * sizeof(int16_t));
         }
-        if (src_index < 0)
-        {
-            data_left1 = p->last_left;
-            data_right1 = p->last_right;
-            src_index = 0;
-            if (p->channels == 1)
-            {
-                data_left2 = src[0];
-                *dst++ = (1.0f - coef) * data_left1 + coef * data_left2;
-            }
-            else
-            {
-                data_left2 = src[0];
-                data_right2 = src[1];
-                *dst++ = (1.0f - coef) * data_left1 + coef * data_left2;
-                *dst++ = (1.0f - coef) * data_right1 + coef * data_right2;
-            }
+        current += resample_run(p, p->edge, HIST_FRAMES + TAPS / 2, HIST_FRAMES, &dst[current * och], dst_frames - current, dup);
+        p->pos_int = 0;
+        p->pos_num = 0;
+        memset(p->hist, 0, sizeof(p->hist));
+    }
 
-            if (current * 2 >= p->dst_size)
-            {
-                RT_ASSERT(0);
-            }
-            current++;
-            totla_dst_index++;
+    RT_ASSERT(current <= dst_frames);
+    return current;
+}
 
-        }
-        else
-        {
-            if (p->channels == 1)
-            {
-                data_left1 = src[src_index];
-                data_left2 = src[src_index + 1];
-                *dst++ = (1.0f - coef) * data_left1 + coef * data_left2;
-            }
-            else
-            {
-                data_left1 = src[src_index * 2];
-                data_right1 = src[src_index * 2 + 1];
-                data_left2 = src[src_index * 2 + 2];
-                data_right2 = src[src_index * 2 + 3];
-                *dst++ = (1.0f - coef) * data_left1 + coef * data_left2;
-                *dst++ = (1.0f - coef) * data_right1 + coef * data_right2;
-            }
+uint32_t sifli_resample_process(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet)
+{
+    uint8_t ch = p->channels;
+    uint32_t frames;
 
-            if (current * 2 >= p->dst_size)
-            {
-                RT_ASSERT(0);
-            }
-            current++;
-            totla_dst_index++;
+    if (p->src_samplerate == p->dst_samplerate)
+    {
+        if (src_bytes > p->dst_size)
+        {
+            rt_kprintf("resample: input %d bigger than expected\n", src_bytes);
+            src_bytes = p->dst_size;
         }
+        memcpy(p->dst, src, src_bytes);
+        p->dst_bytes = src_bytes;
+        return src_bytes;
     }
-    if (is_last_packet)
+
+    frames = resample_process_frames(p, src, src_bytes, is_last_packet, p->dst, p->dst_size / sizeof(int16_t) / ch, 0);
+    p->dst_bytes = frames * sizeof(int16_t) * ch;
+    return p->dst_bytes;
+}
+
+uint32_t sifli_resample_max_output(sifli_resample_t *p, uint32_t src_bytes, uint8_t dup_mono)
+{
+    uint32_t frames = src_bytes / sizeof(int16_t) / p->channels;
+    uint8_t och = (dup_mono && p->channels == 1) ? 2 : p->channels;
+
+    frames = (uint32_t)((uint64_t)frames * p->dst_samplerate / p->src_samplerate) + TAPS + 1;
+    return frames * sizeof(int16_t) * och;
+}
+
+uint32_t sifli_resample_process_to(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet,
+                                   int16_t *dst, uint32_t dst_size, uint8_t dup_mono)
+{
+    uint8_t dup = (dup_mono && p->channels == 1);
+    uint8_t och = dup ? 2 : p->channels;
+    uint32_t frames;
+
+    if (dst_size < sifli_resample_max_output(p, src_bytes, dup))
+        return 0;
+
+    if (p->src_samplerate == p->dst_samplerate)
     {
-        if (p->channels == 1)
+        frames = src_bytes / sizeof(int16_t) / p->channels;
+        if (!dup)
         {
-            *dst++ = src[samples - 1];
+            if (dst != src)
+                memcpy(dst, src, src_bytes);
         }
         else
         {
-            *dst++ = src[2 * samples - 2];
-            *dst++ = src[2 * samples - 1];
+            /*from the end, dst could be same as src*/
+            for (int32_t i = frames - 1; i >= 0; i--)
+            {
+                dst[i * 2 + 1] = src[i];
+                dst[i * 2] = src[i];
+            }
         }
-        current++;
+        return frames * sizeof(int16_t) * och;
     }
-    p->dst_bytes = current * sizeof(int16_t) * p->channels;
-    return p->dst_bytes;
+
+    frames = resample_process_frames(p, src, src_bytes, is_last_packet, dst, dst_size / sizeof(int16_t) / och, dup);
+    return frames * sizeof(int16_t) * och;
 }
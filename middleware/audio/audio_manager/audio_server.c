@@ -63,6 +63,7 @@
 #include <audio_server.h>
 #include <gui_app_pm.h>
 #include "bf0_pm.h"
+#include "sysview_trace.h"
 #if RT_USING_DFS
     #include "dfs_file.h"
     #include "dfs_posix.h"
@@ -92,7 +93,37 @@
 /* ---------------------audio server config start-------------------------- */
 
 #define START_RX_IN_TX_INTERUPT     1
-#define SOFTWARE_TX_MIX_ENABLE      0
+
+/*
+  AUDIO_TX_SOFTWARE_MIX: mix several tx clients on speaker in software,
+  clients must have same samplerate and channels as the first one, no SRC in mixer
+*/
+#ifdef AUDIO_TX_SOFTWARE_MIX
+    #define SOFTWARE_TX_MIX_ENABLE      1
+    #undef  MULTI_CLIENTS_AT_WORKING
+    #define MULTI_CLIENTS_AT_WORKING    1
+    #ifndef AUDIO_TX_MIX_CLIENTS_MAX
+        #define AUDIO_TX_MIX_CLIENTS_MAX    4
+    #endif
+#else
+    #define SOFTWARE_TX_MIX_ENABLE      0
+#endif
+
+#define AUDIO_MIX_GAIN_UNITY        0x7FFF  //Q15
+
+/*
+  AUDIO_UI_SOUND: ui sounds are mixed into every speaker DMA buffer in tx done interrupt,
+  speaker opened by ui sound client runs with short DMA period, see audio_ui_sound.c
+*/
+#ifdef AUDIO_UI_SOUND
+    #ifndef AUDIO_UI_SOUND_DMA_SIZE
+        #define AUDIO_UI_SOUND_DMA_SIZE     CODEC_DATA_UNIT_LEN
+    #endif
+    #define speaker_mix_ui_sound(my)    (void)audio_ui_sound_mix((int16_t *)(my)->tx_data_tmp, (my)->tx_dma_size / 2, \
+                                                                 (my)->tx_samplerate, (my)->tx_channels)
+#else
+    #define speaker_mix_ui_sound(my)    ((void)0)
+#endif
 
 #undef audio_mem_malloc
 #undef audio_mem_free
@@ -249,6 +280,7 @@ struct audio_client_base_t
     uint8_t                     is_suspended;
     uint8_t                     is_factory_loopback;
     uint8_t                     debug_full;
+    uint16_t                    mix_gain; //Q15, used by software tx mix
 };
 
 #define OPEN_MAP_TX             (1 << 0)
@@ -268,6 +300,9 @@ typedef struct
     rt_device_t                 pdm;
     rt_device_t                 i2s;
     uint8_t                     *tx_data_tmp;
+#if SOFTWARE_TX_MIX_ENABLE
+    uint8_t                     *tx_mix_tmp;
+#endif
     uint8_t                     *rx_data_tmp;
     uint32_t                    tx_samplerate;
     uint32_t                    rx_samplerate;
@@ -423,6 +458,10 @@ static rt_err_t speaker_tx_done(rt_device_t dev, void *buffer);
 static rt_err_t mic_rx_ind(rt_device_t dev, rt_size_t size);
 static void start_rx(audio_device_speaker_t *my);
 static audio_client_t device_get_tx_in_running(audio_device_ctrl_t *device, int index);
+#if SOFTWARE_TX_MIX_ENABLE
+static audio_client_t device_get_tx_master(audio_device_ctrl_t *device);
+static int device_get_tx_num_in_running(audio_device_ctrl_t *device);
+#endif
 static audio_client_t device_get_rx_in_running(audio_device_ctrl_t *device);
 static void audio_device_change(audio_server_t *server);
 
@@ -462,6 +501,19 @@ static uint8_t is_can_mix(audio_client_t client_old, audio_client_t client_new,
     }
 
 #if SOFTWARE_TX_MIX_ENABLE
+    if (device->device_type != AUDIO_DEVICE_SPEAKER)
+    {
+        LOG_I("dennied, device %d not support tx mix", device->device_type);
+        return 0;
+    }
+    if (client_new->parameter.write_samplerate != device->tx_mix_dst_samplerate
+            || client_new->parameter.write_channnel_num != device->tx_mix_dst_channel)
+    {
+        LOG_I("dennied, tx mix need (%d,%d) but (%d,%d)",
+              device->tx_mix_dst_samplerate, device->tx_mix_dst_channel,
+              client_new->parameter.write_samplerate, client_new->parameter.write_channnel_num);
+        return 0;
+    }
     LOG_D("t1=%d mw=0x%x b2=0x%x t2=%d mw=0x%x b1=0x%x", client_old->audio_type,
           mix_policy[client_old->audio_type].can_mix_with,
           TYPE_TO_MIX_BIT(client_old->audio_type),
@@ -509,18 +561,17 @@ static void inline speaker_update_volume(audio_device_speaker_t *my, int16_t spf
     uint8_t vol = g_server.volume;
     audio_client_t first;
 #if SOFTWARE_TX_MIX_ENABLE
-    RT_ASSERT(0); //todo
-    first = NULL;
-    audio_type = AUDIO_TYPE_LOCAL_MUSIC;
+    //volume and fade follow the highest priority stream, others use mix gain
+    first = device_get_tx_master(my->parent);
 #else
     first = device_get_tx_in_running(my->parent, 0);
-    audio_type = first->audio_type;
 #endif
 
     if (!my->parent->is_busy || !my->tx_ref || !first)
     {
         return;
     }
+    audio_type = first->audio_type;
     if (g_server.private_volume[audio_type] != 0xFF)
     {
         vol = g_server.private_volume[audio_type];
@@ -565,10 +616,6 @@ static void inline speaker_update_volume(audio_device_speaker_t *my, int16_t spf
         }
         else if (my->audcodec_dev)
         {
-#if SOFTWARE_TX_MIX_ENABLE
-            RT_ASSERT(0);
-            //todo: multi stream fade out
-#else
             if (first->is_fade_vol && !first->is_fade_end)
             {
                 rt_tick_t tick = rt_tick_get_millisecond();
@@ -622,7 +669,6 @@ static void inline speaker_update_volume(audio_device_speaker_t *my, int16_t spf
             {
                 vol = 0;
             }
-#endif
             if (audio_type == AUDIO_TYPE_BT_VOICE)
                 volx2 = eq_get_tel_volumex2(vol);
             else
@@ -705,6 +751,208 @@ static void inline speaker_update_volume(audio_device_speaker_t *my, int16_t spf
 }
 
 
+#if SOFTWARE_TX_MIX_ENABLE
+/* dst += src * gain, gain is Q15, saturated to int16 */
+static void audio_mix_q15(int16_t *dst, const int16_t *src, uint32_t samples, uint16_t gain)
+{
+    uint32_t i = 0;
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    uint32_t *d2 = (uint32_t *)dst;
+    const uint32_t *s2 = (const uint32_t *)src;
+    if (gain >= AUDIO_MIX_GAIN_UNITY)
+    {
+        for (; i + 1 < samples; i += 2)
+        {
+            *d2 = __QADD16(*d2, *s2++);
+            d2++;
+        }
+    }
+    else
+    {
+        for (; i + 1 < samples; i += 2)
+        {
+            uint32_t in = *s2++;
+            int32_t lo = __SMULBB(in, gain) >> 15;
+            int32_t hi = __SMULTB(in, gain) >> 15;
+            *d2 = __QADD16(*d2, __PKHBT(lo, hi, 16));
+            d2++;
+        }
+    }
+#endif
+    for (; i < samples; i++)
+    {
+        int32_t v = dst[i] + (((int32_t)src[i] * gain) >> 15);
+        if (v > 32767)
+            v = 32767;
+        else if (v < -32768)
+            v = -32768;
+        dst[i] = (int16_t)v;
+    }
+}
+
+static uint16_t speaker_tx_mix_gain(audio_client_t c, audio_client_t master)
+{
+    uint32_t gain = c->mix_gain;
+    //master fade by codec volume, others fade by gain, 16 dma frames
+    if (c != master && c->is_fade_vol == 1)
+    {
+        if (!c->is_fade_end)
+        {
+            c->fade_vol_steps++;
+            if (c->fade_vol_steps >= 16)
+            {
+                c->is_fade_end = 1;
+            }
+        }
+        gain = c->is_fade_end ? 0 : gain * (16 - c->fade_vol_steps) / 16;
+    }
+    return (uint16_t)gain;
+}
+
+static void process_speaker_tx_mix(audio_server_t *server, audio_device_speaker_t *my)
+{
+    rt_list_t *pos;
+    audio_client_t c;
+    audio_client_t master = device_get_tx_master(my->parent);
+    rt_uint32_t getnum, evt = 0;
+    uint16_t gain;
+    int mixed = 0;
+    rt_uint8_t *span[2];
+    rt_size_t span_len[2];
+
+    memset(my->tx_data_tmp, 0, my->tx_dma_size);
+    rt_list_for_each(pos, &my->parent->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if (!(c->rw_flag & AUDIO_TX) || c->is_suspended)
+        {
+            continue;
+        }
+        //one client underflow should not stop others
+        if (!my->tx_enable || rt_ringbuffer_data_len(&c->ring_buf) < my->tx_dma_size)
+        {
+            continue;
+        }
+        gain = speaker_tx_mix_gain(c, master);
+        rt_ringbuffer_get_read_spans(&c->ring_buf, span, span_len);
+        if (span_len[0] >= my->tx_dma_size)
+        {
+            /* mix in place, no copy out of ring */
+            if (gain)
+            {
+                audio_mix_q15((int16_t *)my->tx_data_tmp, (const int16_t *)span[0], my->tx_dma_size / 2, gain);
+            }
+            getnum = rt_ringbuffer_read_commit(&c->ring_buf, my->tx_dma_size);
+        }
+        else if (!(span_len[0] & 1))
+        {
+            if (gain)
+            {
+                audio_mix_q15((int16_t *)my->tx_data_tmp, (const int16_t *)span[0], span_len[0] / 2, gain);
+                audio_mix_q15((int16_t *)(my->tx_data_tmp + span_len[0]), (const int16_t *)span[1],
+                              (my->tx_dma_size - span_len[0]) / 2, gain);
+            }
+            getnum = rt_ringbuffer_read_commit(&c->ring_buf, my->tx_dma_size);
+        }
+        else
+        {
+            /* sample split by end of ring */
+            getnum = rt_ringbuffer_get(&c->ring_buf, my->tx_mix_tmp, my->tx_dma_size);
+            if (gain)
+            {
+                audio_mix_q15((int16_t *)my->tx_data_tmp, (const int16_t *)my->tx_mix_tmp, getnum / 2, gain);
+            }
+        }
+        RT_ASSERT(getnum == my->tx_dma_size);
+        mixed++;
+    }
+
+    if (mixed)
+    {
+        my->tx_empty_cnt = 0;
+        speaker_update_volume(my, (int16_t *)my->tx_data_tmp, my->tx_dma_size / 2);
+        speaker_mix_ui_sound(my);
+        if (server->is_need_3a)
+        {
+            audio_3a_far_put(my->tx_data_tmp, my->tx_dma_size);
+            my->rx_uplink_send_start = 1;
+        }
+        bf0_audprc_set_tx_channel(0);
+    }
+    else
+    {
+        if (my->tx_enable)
+        {
+            speaker_mix_ui_sound(my);
+        }
+        if (server->is_need_3a)
+        {
+            audio_3a_far_put(my->tx_data_tmp, CODEC_DATA_UNIT_LEN);
+        }
+        if (my->tx_enable)
+        {
+            my->tx_empty_cnt++;
+            if (g_ae_log)
+            {
+                rt_kprintf("AE times %d\r\n", my->tx_empty_cnt);
+            }
+        }
+    }
+    bf0_audprc_device_write(my->audprc_dev, 0, my->tx_data_tmp, my->tx_dma_size);
+
+    if (!my->tx_enable)
+    {
+        return;
+    }
+    rt_list_for_each(pos, &my->parent->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if (!(c->rw_flag & AUDIO_TX) || c->is_suspended || !c->callback)
+        {
+            continue;
+        }
+        if (rt_ringbuffer_data_len(&c->ring_buf) < my->tx_dma_size)
+        {
+            evt |= AUDIO_SERVER_EVENT_TX_FULL_EMPTY;
+        }
+        else if (rt_ringbuffer_space_len(&c->ring_buf) >= rt_ringbuffer_get_size(&c->ring_buf) / 2)
+        {
+            evt |= AUDIO_SERVER_EVENT_TX_HALF_EMPTY;
+        }
+    }
+    if (evt)
+    {
+        rt_event_send(&server->event, evt);
+    }
+}
+
+/* called in audio server thread, notify every tx client need data */
+static void speaker_notify_tx_clients(audio_device_ctrl_t *speaker, audio_server_callback_cmt_t cmd)
+{
+    rt_list_t *pos, *n;
+    audio_client_t c;
+    uint32_t dma_size = g_server.device_speaker_private.tx_dma_size;
+
+    rt_list_for_each_safe(pos, n, &speaker->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if (!(c->rw_flag & AUDIO_TX) || c->is_suspended || !c->callback)
+        {
+            continue;
+        }
+        if (cmd == as_callback_cmd_cache_empty && rt_ringbuffer_data_len(&c->ring_buf) < dma_size)
+        {
+            c->callback(cmd, c->user_data, 0);
+        }
+        else if (cmd == as_callback_cmd_cache_half_empty
+                 && rt_ringbuffer_space_len(&c->ring_buf) >= rt_ringbuffer_get_size(&c->ring_buf) / 2)
+        {
+            c->callback(cmd, c->user_data, 0);
+        }
+    }
+}
+#endif
+
 static inline void process_speaker_tx(audio_server_t *server, audio_device_speaker_t *my)
 {
     rt_uint32_t  datanum, getnum;
@@ -716,9 +964,6 @@ static inline void process_speaker_tx(audio_server_t *server, audio_device_speak
     }
 
 
-#if SOFTWARE_TX_MIX_ENABLE
-    RT_ASSERT(0); //todo
-#endif
 #if START_RX_IN_TX_INTERUPT
     if (my->tx_ready == 1)
     {
@@ -727,6 +972,13 @@ static inline void process_speaker_tx(audio_server_t *server, audio_device_speak
         rt_event_send(my->event, 1);
     }
 #endif
+#if SOFTWARE_TX_MIX_ENABLE
+    if (device_get_tx_num_in_running(my->parent) > 1)
+    {
+        process_speaker_tx_mix(server, my);
+        return;
+    }
+#endif
 
     datanum = rt_ringbuffer_data_len(&first->ring_buf);
     getnum = 0;
@@ -745,6 +997,7 @@ static inline void process_speaker_tx(audio_server_t *server, audio_device_speak
         if (rt_ringbuffer_data_len(&first->ring_buf) < my->tx_dma_size)
         {
             memset(my->tx_data_tmp, 0, my->tx_dma_size);
+            speaker_mix_ui_sound(my);
             if (server->is_need_3a)
             {
                 audio_3a_far_put(my->tx_data_tmp, CODEC_DATA_UNIT_LEN);
@@ -763,6 +1016,7 @@ static inline void process_speaker_tx(audio_server_t *server, audio_device_speak
             getnum = rt_ringbuffer_get(&first->ring_buf, my->tx_data_tmp, my->tx_dma_size);
             RT_ASSERT(getnum == my->tx_dma_size);
             speaker_update_volume(my, (int16_t *)my->tx_data_tmp, my->tx_dma_size / 2);
+            speaker_mix_ui_sound(my);
             if (server->is_need_3a)
             {
 #if DEBUG_FRAME_SYNC
@@ -1273,8 +1527,6 @@ static int audio_device_speaker_open(void *user_data, audio_device_input_callbac
 
     client->is_suspended = 0;
 
-    my->tx_dma_size = TX_DMA_SIZE;
-
     if (client->audio_type == AUDIO_TYPE_BT_MUSIC)
     {
         server->is_bt_music_working = 1;
@@ -1283,6 +1535,14 @@ static int audio_device_speaker_open(void *user_data, audio_device_input_callbac
     // 2. prepare hardware memory
     if (need_tx_init)
     {
+        /* only set by first tx client, tx_data_tmp is allocated with it */
+        my->tx_dma_size = TX_DMA_SIZE;
+#ifdef AUDIO_UI_SOUND
+        if (audio_ui_sound_is_client(client->callback))
+        {
+            my->tx_dma_size = AUDIO_UI_SOUND_DMA_SIZE;
+        }
+#endif
         my->tx_channels    = client->parameter.write_channnel_num;
         my->tx_samplerate  = client->parameter.write_samplerate;
         my->tx_empty_occur = 1;
@@ -1305,6 +1565,10 @@ static int audio_device_speaker_open(void *user_data, audio_device_input_callbac
 
         my->tx_data_tmp = audio_mem_malloc(my->tx_dma_size);
         RT_ASSERT(my->tx_data_tmp);
+#if SOFTWARE_TX_MIX_ENABLE
+        my->tx_mix_tmp = audio_mem_malloc(my->tx_dma_size);
+        RT_ASSERT(my->tx_mix_tmp);
+#endif
     }
     if (need_rx_init)
     {
@@ -1552,6 +1816,10 @@ static int audio_device_speaker_close(void *user_data)
         RT_ASSERT((my->opened_map_flag  & OPEN_MAP_TX) == 0);
         audio_mem_free(my->tx_data_tmp);
         my->tx_data_tmp = NULL;
+#if SOFTWARE_TX_MIX_ENABLE
+        audio_mem_free(my->tx_mix_tmp);
+        my->tx_mix_tmp = NULL;
+#endif
     }
 Exit:
     LOG_I("%s out", __FUNCTION__);
@@ -1655,15 +1923,6 @@ static int hardware_device_open(audio_device_ctrl_t *device, audio_client_t clie
 
     client->device_using = device->device_type;
     device->opening_client = client;
-#if SOFTWARE_TX_MIX_ENABLE
-    if (client->rw_flag & AUDIO_TX)
-    {
-        if (!device->tx_mixed_rb)
-        {
-            device->tx_mixed_rb = rt_ringbuffer_create(16 * 1024);
-        }
-    }
-#endif
     switch (device->device_type)
     {
     case AUDIO_DEVICE_SPEAKER:
@@ -1754,13 +2013,6 @@ static void hardware_device_close(audio_client_t client)
             device->device.close(device->device.user_data);
         }
     }
-#if SOFTWARE_TX_MIX_ENABLE
-    if (device->tx_mixed_rb)
-    {
-        rt_ringbuffer_destroy(device->tx_mixed_rb);
-        device->tx_mixed_rb = NULL;
-    }
-#endif
     client->device_using = AUDIO_DEVICE_NONE;
 
     if (device->device_type == AUDIO_DEVICE_HFP && hfp_dev_input_buf)
@@ -1905,6 +2157,81 @@ static inline int client_compare_priority(audio_client_t c1, audio_client_t c2,
     return -1;
 }
 
+#if SOFTWARE_TX_MIX_ENABLE
+static audio_client_t device_get_tx_master(audio_device_ctrl_t *device)
+{
+    rt_list_t *pos = NULL;
+    audio_client_t c, master = NULL;
+
+    rt_list_for_each(pos, &device->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if ((c->rw_flag & AUDIO_TX) && (!master || client_compare_priority(c, master, device->device_type) > 0))
+        {
+            master = c;
+        }
+    }
+    return master;
+}
+
+static audio_client_t device_get_tx_lowest(audio_device_ctrl_t *device)
+{
+    rt_list_t *pos = NULL;
+    audio_client_t c, low = NULL;
+
+    rt_list_for_each(pos, &device->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if ((c->rw_flag & AUDIO_TX) && (!low || client_compare_priority(c, low, device->device_type) <= 0))
+        {
+            low = c;
+        }
+    }
+    return low;
+}
+
+/*
+ new tx client can mix with all running tx, lower priority one which can't mix will be suspended,
+ return -1 if new client should be suspended
+*/
+static int device_tx_mix_check(audio_device_ctrl_t *device, audio_client_t client)
+{
+    rt_list_t *pos, *n;
+    audio_client_t c;
+
+    rt_list_for_each(pos, &device->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if ((c->rw_flag & AUDIO_TX) && !is_can_mix(c, client, device)
+                && client_compare_priority(client, c, device->device_type) < 0)
+        {
+            return -1;
+        }
+    }
+
+    rt_list_for_each_safe(pos, n, &device->running_client_list)
+    {
+        c = rt_list_entry(pos, struct audio_client_base_t, node);
+        if ((c->rw_flag & AUDIO_TX) && !is_can_mix(c, client, device))
+        {
+            device_suspend_one_running_client(device, c);
+        }
+    }
+
+    while (device_get_tx_num_in_running(device) >= AUDIO_TX_MIX_CLIENTS_MAX)
+    {
+        c = device_get_tx_lowest(device);
+        RT_ASSERT(c);
+        if (client_compare_priority(client, c, device->device_type) < 0)
+        {
+            return -1;
+        }
+        device_suspend_one_running_client(device, c);
+    }
+    return 0;
+}
+#endif
+
 static void audio_device_open(audio_server_t *server, audio_client_t client)
 {
     uint8_t need_start = 0;
@@ -1915,6 +2242,8 @@ static void audio_device_open(audio_server_t *server, audio_client_t client)
     audio_client_t hight = NULL;
 
     audio_device_e want_device = server->private_device[client->audio_type];
+
+    audio_mem_set_type(client->audio_type);
     if (want_device == AUDIO_DEVICE_NO_INIT)
     {
         want_device = server->public_device;
@@ -1926,10 +2255,10 @@ static void audio_device_open(audio_server_t *server, audio_client_t client)
     device = &server->devices_ctrl[want_device];
 
 #if SOFTWARE_TX_MIX_ENABLE
-    if (device == AUDIO_DEVICE_A2DP_SINK && client->audio_type != AUDIO_TYPE_LOCAL_MUSIC)
+    if (device->device_type == AUDIO_DEVICE_A2DP_SINK && client->audio_type != AUDIO_TYPE_LOCAL_MUSIC)
     {
         LOG_I("only local music can use tws, using speaker");
-        device = AUDIO_DEVICE_SPEAKER;
+        device = &server->devices_ctrl[AUDIO_DEVICE_SPEAKER];
     }
 #endif
 
@@ -2011,6 +2340,12 @@ static void audio_device_open(audio_server_t *server, audio_client_t client)
     }
 
     //step 2: check tx client to mix, only support two tx mix
+#if SOFTWARE_TX_MIX_ENABLE
+    if ((client->rw_flag & AUDIO_TX) && device_tx_mix_check(device, client) != 0)
+    {
+        goto suspend_new_exit;
+    }
+#else
     if (client->rw_flag & AUDIO_TX)
     {
         int tx_num = device_get_tx_num_in_running(device);
@@ -2059,6 +2394,7 @@ tx_mix_check:
             }
         }
     }
+#endif
 
     //step 3 start new client
     LOG_I("device count tx=%d rx=%d busy=%d", device->tx_count, device->rx_count, device->is_busy);
@@ -2240,6 +2576,26 @@ static inline bool change_device(audio_client_t running, audio_device_ctrl_t *de
     if (running->rw_flag & AUDIO_TX)
     {
         int tx_num = device_get_tx_num_in_running(dev_new);
+#if SOFTWARE_TX_MIX_ENABLE
+        rt_list_t *pos;
+        audio_client_t old;
+        if (tx_num >= AUDIO_TX_MIX_CLIENTS_MAX)
+        {
+            LOG_I("dennied: %d tx", tx_num);
+            device_suspend_one_client(dev_new, running);
+            return false;
+        }
+        rt_list_for_each(pos, &dev_new->running_client_list)
+        {
+            old = rt_list_entry(pos, struct audio_client_base_t, node);
+            if ((old->rw_flag & AUDIO_TX) && !is_can_mix(old, running, dev_new))
+            {
+                LOG_I("dennied: can't mix");
+                device_suspend_one_running_client(dev_new, running);
+                return false;
+            }
+        }
+#else
         RT_ASSERT(tx_num <= 2);
         if (tx_num == 2)
         {
@@ -2257,6 +2613,7 @@ static inline bool change_device(audio_client_t running, audio_device_ctrl_t *de
                 return false;
             }
         }
+#endif
     }
 
     LOG_I("change new dev count tx=%d rx=%d busy=%d", dev_new->tx_count, dev_new->rx_count, dev_new->is_busy);
@@ -2322,14 +2679,10 @@ static void audio_device_change(audio_server_t *server)
 
 bool audio_device_is_a2dp_sink()
 {
-#if SOFTWARE_TX_MIX_ENABLE
-
-#else
     if (g_server.devices_ctrl[AUDIO_DEVICE_A2DP_SINK].is_busy)
     {
         return true;
     }
-#endif
     return false;
 }
 
@@ -2669,7 +3022,7 @@ void audio_server_entry()
     audio_device_ctrl_t *speaker;
     audio_device_ctrl_t *a2dp_sink;
     audio_device_ctrl_t *hfp;
-    audio_client_t first, second;
+    audio_client_t first;
     audio_server_t *server = get_server();
     LOG_I("audio server run");
     speaker = &server->devices_ctrl[AUDIO_DEVICE_SPEAKER];
@@ -2696,15 +3049,14 @@ void audio_server_entry()
             {
                 continue;
             }
+            SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDIO, evt, 0);
 
             if ((evt & AUDIO_SERVER_EVENT_TX_HALF_EMPTY) && speaker->tx_count)
             {
-                first = device_get_tx_in_running(speaker, 0);
 #if SOFTWARE_TX_MIX_ENABLE
-                second = device_get_tx_in_running(speaker, 1);
-                //todo mix two client
-                RT_ASSERT(0);
+                speaker_notify_tx_clients(speaker, as_callback_cmd_cache_half_empty);
 #else
+                first = device_get_tx_in_running(speaker, 0);
                 if (first && first->callback)
                     first->callback(as_callback_cmd_cache_half_empty, first->user_data, 0);
 #endif
@@ -2712,10 +3064,7 @@ void audio_server_entry()
             if ((evt & AUDIO_SERVER_EVENT_TX_FULL_EMPTY) && speaker->tx_count)
             {
 #if SOFTWARE_TX_MIX_ENABLE
-                first = device_get_tx_in_running(speaker, 0);
-                second = device_get_tx_in_running(speaker, 1);
-                //todo mix two client
-                RT_ASSERT(0);
+                speaker_notify_tx_clients(speaker, as_callback_cmd_cache_empty);
 #else
                 first = device_get_tx_in_running(speaker, 0);
                 if (first && first->callback)
@@ -2768,6 +3117,7 @@ void audio_server_entry()
             {
                 bt_voice_downlink_process(1);
             }
+            SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDIO);
         }
     }
     rt_mutex_detach(&server->mutex);
@@ -2905,6 +3255,7 @@ static audio_client_t audio_client_init(audio_type_t audio_type, audio_rwflag_t
     handle->user_data   = callback_userdata;
     handle->audio_type  = audio_type;
     handle->rw_flag     = rwflag;
+    handle->mix_gain    = AUDIO_MIX_GAIN_UNITY;
     handle->ring_pool   = audio_mem_calloc(1, tx_ring_size + RT_ALIGN_SIZE);
     RT_ASSERT(handle->ring_pool);
     rt_ringbuffer_init(&handle->ring_buf, handle->ring_pool, tx_ring_size);
@@ -3037,6 +3388,35 @@ AUDIO_API int audio_write(audio_client_t handle, uint8_t *data, uint32_t data_le
     return data_len;
 }
 
+AUDIO_API int audio_write_get_buf(audio_client_t handle, uint8_t **buf, uint32_t *space)
+{
+    if (!handle || handle->magic != AUDIO_CLIENT_MAGIC || !buf)
+    {
+        LOG_I("audio_write_get_buf invalid parameter");
+        return -2;
+    }
+    if (handle->is_suspended)
+    {
+        return -1;
+    }
+    if (space)
+    {
+        *space = rt_ringbuffer_space_len(&handle->ring_buf);
+    }
+    return rt_ringbuffer_get_write_span(&handle->ring_buf, buf);
+}
+
+AUDIO_API int audio_write_commit(audio_client_t handle, uint32_t data_len)
+{
+    if (!handle || handle->magic != AUDIO_CLIENT_MAGIC)
+    {
+        LOG_I("audio_write_commit invalid parameter");
+        return -2;
+    }
+    handle->debug_full = 0;
+    return rt_ringbuffer_write_commit(&handle->ring_buf, data_len);
+}
+
 AUDIO_API int audio_read(audio_client_t handle, uint8_t *buf, uint32_t buf_size)
 {
     if (!handle || handle->magic != AUDIO_CLIENT_MAGIC || !buf || !buf_size)
@@ -3089,6 +3469,10 @@ AUDIO_API int audio_ioctl(audio_client_t handle, int cmd, void *parameter)
             ret = 0;
         }
     }
+    else if (cmd == 3)
+    {
+        handle->mix_gain = (gain > AUDIO_MIX_GAIN_UNITY) ? AUDIO_MIX_GAIN_UNITY : (uint16_t)gain;
+    }
     else if (cmd == -1)
     {
         lock();
@@ -86,6 +86,12 @@
 
 #include "bf0_hal_audprc.h"
 #include "drv_audprc.h"
+#ifdef BSP_PDM_FRAME_MODE
+    #include "drv_pdm_audio.h"
+#endif
+#ifdef AUDIO_BEAMFORM
+    #include "audio_beamform.h"
+#endif
 #ifdef SOLUTION_WATCH
     #include "app_comm.h"
 #endif /* SOLUTION_WATCH */
@@ -705,6 +711,53 @@ static inline void process_speaker_rx(audio_server_t *server, audio_device_speak
 }
 
 #if !PKG_USING_3MICS_WITHOUT_ADC
+#ifdef AUDIO_BEAMFORM
+#ifndef AUDIO_BF_GEOMETRY
+    /* mm, pdm left, pdm right, adc mic */
+    #define AUDIO_BF_GEOMETRY   {{0, 0}, {20, 0}, {10, 17}}
+#endif
+#ifndef AUDIO_BF_STEER_DEG
+    #define AUDIO_BF_STEER_DEG  (90)
+#endif
+static audio_bf_t *g_bf;
+static uint8_t g_bf_enable = 1;
+static uint8_t g_bf_steer_pending;
+static int16_t g_bf_steer = AUDIO_BF_STEER_DEG;
+
+/* beam of 3 mics replaces adc mic as main channel of 3a */
+static void process_3mics_beam(audio_device_speaker_t *my, const int16_t *pdm)
+{
+    static const audio_bf_mic_t mic[3] = AUDIO_BF_GEOMETRY;
+    static const uint8_t stride[3] = {2, 2, 1};
+
+    if (!g_bf_enable)
+        return;
+    if (!g_bf)
+    {
+        audio_bf_config_t cfg = {0};
+        cfg.samplerate = my->tx_samplerate;
+        cfg.mic_num = 3;
+        cfg.steer_deg = g_bf_steer;
+        memcpy(cfg.mic, mic, sizeof(mic));
+        g_bf = audio_bf_create(&cfg, CODEC_DATA_UNIT_LEN / 2);
+        if (!g_bf)
+        {
+            LOG_E("bf create fail");
+            g_bf_enable = 0;
+            return;
+        }
+    }
+    else if (g_bf_steer_pending)
+    {
+        audio_bf_steer(g_bf, g_bf_steer);
+    }
+    g_bf_steer_pending = 0;
+
+    const int16_t *in[3] = {pdm, pdm + 1, (const int16_t *)my->adc_data_tmp};
+    audio_bf_process(g_bf, in, stride, (int16_t *)my->adc_data_tmp);
+}
+#endif
+
 static inline void process_3mics_rx(audio_server_t *server, audio_device_speaker_t *my)
 {
     if ((my->opened_map_flag & OPEN_MAP_RX) == 0 || !server->p_ring_buf)
@@ -725,19 +778,36 @@ static inline void process_3mics_rx(audio_server_t *server, audio_device_speaker
     rt_size_t len;
 
     readlen = CODEC_DATA_UNIT_LEN << 1;
-    len = rt_device_read(my->pdm, 0, my->pdm_data_tmp, readlen);
+#ifdef BSP_PDM_FRAME_MODE
+    /* frame is saved by 3a from DMA ring directly */
+    uint8_t *frame = bf0_pdm_frame_get(my->pdm, &len);
+    RT_ASSERT(frame && len == readlen);
+    audio_3a_save_pdm(frame, len);
+#else
+    uint8_t *frame = my->pdm_data_tmp;
+    len = rt_device_read(my->pdm, 0, frame, readlen);
     RT_ASSERT(len == readlen);
-    audio_3a_save_pdm(my->pdm_data_tmp, len);
+    audio_3a_save_pdm(frame, len);
+#endif
 
     readlen = CODEC_DATA_UNIT_LEN;
     len = rt_device_read(my->audprc_dev, 0, my->adc_data_tmp, readlen);
     RT_ASSERT(len == readlen);
 
+#ifdef AUDIO_BEAMFORM
+    process_3mics_beam(my, (const int16_t *)frame);
+#endif
+#ifdef BSP_PDM_FRAME_MODE
+    bf0_pdm_frame_release(my->pdm);
+#endif
+
     audio_3a_uplink2(my->adc_data_tmp, server->public_is_rx_mute);
 
 }
 #endif
 
+static uint32_t g_pdm_uplink_cnt;
+
 static inline void process_pdm_rx(audio_server_t *server, audio_device_speaker_t *my)
 {
     if ((my->opened_map_flag & OPEN_MAP_RX) == 0 || !server->p_ring_buf || !my->pdm_data_tmp)
@@ -767,13 +837,21 @@ static inline void process_pdm_rx(audio_server_t *server, audio_device_speaker_t
         readlen <<= 1;
     }
     //rt_kprintf("---------pdmlen=%d\r\n", readlen);
-    len = rt_device_read(my->pdm, 0, my->pdm_data_tmp, readlen);
+#ifdef BSP_PDM_FRAME_MODE
+    /* 3a and client work on DMA frame in place, several frames could be ready */
+    uint8_t *pdm_data;
+    while ((pdm_data = bf0_pdm_frame_get(my->pdm, &len)) != NULL)
+    {
+#else
+    uint8_t *pdm_data = my->pdm_data_tmp;
+    len = rt_device_read(my->pdm, 0, pdm_data, readlen);
     RT_ASSERT(len == readlen);
+#endif
 
 #if PKG_USING_3MICS_WITHOUT_ADC
     if (server->is_need_3a)
     {
-        audio_3a_uplink(my->pdm_data_tmp, readlen, server->public_is_rx_mute, 1);
+        audio_3a_uplink(pdm_data, len, server->public_is_rx_mute, 1);
     }
 #endif
 
@@ -781,16 +859,27 @@ static inline void process_pdm_rx(audio_server_t *server, audio_device_speaker_t
     {
         //todo: put data to client receive cache buffe?
         audio_server_coming_data_t data;
-        data.data = my->pdm_data_tmp;
+        data.data = pdm_data;
         data.data_len = len;
         data.reserved = 1; //pdm
         if (server->public_is_rx_mute)
         {
-            memset(my->pdm_data_tmp, 0, len);
+            memset(pdm_data, 0, len);
         }
         if (server->client->rw_flag != AUDIO_TX)
             server->client->callback(as_callback_cmd_data_coming, server->client->user_data, (uint32_t)&data);
     }
+#ifdef BSP_PDM_FRAME_MODE
+        bf0_pdm_frame_release(my->pdm);
+    }
+#endif
+
+    /* tick in is taken in pdm_rx_ind, so this is time from DMA frame done to uplink processed */
+    audio_tick_out(AUDIO_UPLINK_TIME);
+    if ((++g_pdm_uplink_cnt % 100) == 0)
+    {
+        audio_uplink_time_print();
+    }
 }
 
 
@@ -1169,6 +1258,10 @@ static int audio_device_speaker_open(void *user_data, audio_device_input_callbac
                     }
                 }
                 rt_device_control(my->pdm, AUDIO_CTL_CONFIGURE, &caps);
+#ifdef BSP_PDM_FRAME_MODE
+                bf0_pdm_frame_config(my->pdm, (caps.udata.config.channels == 1) ? CODEC_DATA_UNIT_LEN : (CODEC_DATA_UNIT_LEN << 1),
+                                     BSP_PDM_FRAME_NUM);
+#endif
                 int val_db = get_pdm_volume();
                 LOG_I("pdm gain=%d * 0.5db", val_db);
                 rt_device_control(my->pdm, AUDIO_CTL_SETVOLUME, (void *)val_db);;
@@ -1633,6 +1726,10 @@ inline static void audio_client_stop(audio_client_t client)
 
         server->is_need_3a = 0;
         audio_3a_close();
+#if defined(AUDIO_BEAMFORM) && !PKG_USING_3MICS_WITHOUT_ADC
+        audio_bf_destroy(g_bf);
+        g_bf = NULL;
+#endif
     }
 
     if (is_in_list(&server->suspend_list, &client->node))
@@ -2006,6 +2103,7 @@ static rt_err_t pdm_rx_ind(rt_device_t dev, rt_size_t size)
     else
 #endif
     {
+        audio_tick_in(AUDIO_UPLINK_TIME);
         rt_event_send(&g_server.event, AUDIO_SERVER_EVENT_PDM_RX);
     }
     return RT_EOK;
@@ -2411,6 +2509,35 @@ AUDIO_API int audio_write(audio_client_t handle, uint8_t *data, uint32_t data_le
     return data_len;
 }
 
+AUDIO_API int audio_write_get_buf(audio_client_t handle, uint8_t **buf, uint32_t *space)
+{
+    if (!handle || handle->magic != AUDIO_CLIENT_MAGIC || !buf)
+    {
+        LOG_I("audio_write_get_buf invalid parameter");
+        return -2;
+    }
+    if (handle->is_suspended)
+    {
+        return -1;
+    }
+    if (space)
+    {
+        *space = rt_ringbuffer_space_len(&handle->ring_buf);
+    }
+    return rt_ringbuffer_get_write_span(&handle->ring_buf, buf);
+}
+
+AUDIO_API int audio_write_commit(audio_client_t handle, uint32_t data_len)
+{
+    if (!handle || handle->magic != AUDIO_CLIENT_MAGIC)
+    {
+        LOG_I("audio_write_commit invalid parameter");
+        return -2;
+    }
+    handle->debug_full = 0;
+    return rt_ringbuffer_write_commit(&handle->ring_buf, data_len);
+}
+
 AUDIO_API int audio_read(audio_client_t handle, uint8_t *buf, uint32_t buf_size)
 {
     if (!handle || handle->magic != AUDIO_CLIENT_MAGIC || !buf || !buf_size)
@@ -3093,6 +3220,51 @@ int audio_data_cmd(int argc, char **argv)
 MSH_CMD_EXPORT_ALIAS(audio_data_cmd, audio_data, audio_data);
 #endif
 
+#if defined(AUDIO_BEAMFORM) && !PKG_USING_3MICS_WITHOUT_ADC && defined(RT_USING_FINSH)
+static int audio_bf(int argc, char **argv)
+{
+    if (argc >= 2 && !strcmp(argv[1], "on"))
+    {
+        g_bf_enable = 1;
+    }
+    else if (argc >= 2 && !strcmp(argv[1], "off"))
+    {
+        g_bf_enable = 0;
+    }
+    else if (argc >= 3 && !strcmp(argv[1], "steer"))
+    {
+        g_bf_steer = atoi(argv[2]);
+        g_bf_steer_pending = 1;
+    }
+    else if (argc >= 2 && !strcmp(argv[1], "stat"))
+    {
+        audio_bf_stat_t stat = {0};
+        audio_bf_t *bf = g_bf;
+        uint32_t frames_per_s = 16000 / (CODEC_DATA_UNIT_LEN / 2);
+        uint32_t khz;
+
+        if (!bf)
+        {
+            rt_kprintf("bf not running\n");
+            return 0;
+        }
+        audio_bf_get_stat(bf, &stat, argc >= 3 && !strcmp(argv[2], "reset"));
+        khz = (uint64_t)stat.cycles_avg * frames_per_s / 1000;
+        rt_kprintf("bf: frames %d, cycles avg %d max %d, %d.%03d MHz at 16k\n",
+                   stat.frames, stat.cycles_avg, stat.cycles_max, khz / 1000, khz % 1000);
+        return 0;
+    }
+    else
+    {
+        rt_kprintf("audio_bf on|off|steer <deg>|stat [reset]\n");
+        return 0;
+    }
+    rt_kprintf("bf enable=%d steer=%d\n", g_bf_enable, g_bf_steer);
+    return 0;
+}
+MSH_CMD_EXPORT(audio_bf, 3 mics beamformer);
+#endif
+
 
 #endif // SOC_BF0_HCPU
 
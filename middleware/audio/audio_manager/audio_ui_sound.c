@@ -0,0 +1,496 @@
+/**
+  ******************************************************************************
+  * @file   audio_ui_sound.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include "board.h"
+#include "audio_server.h"
+#include "audio_mem.h"
+#if RT_USING_DFS
+    #include "dfs_posix.h"
+#endif
+
+#ifdef AUDIO_UI_SOUND
+
+#define DBG_TAG         "audio_ui"
+#define DBG_LVL          LOG_LVL_INFO
+#include "log.h"
+
+/*
+  UI sounds are kept as PCM in RAM and mixed by speaker tx done interrupt straight into the
+  next DMA buffer, so a trigger doesn't go through audio server command thread or client ring.
+  If speaker is idle, a notify client with short DMA period is opened by ui_snd thread to run it,
+  and kept for AUDIO_UI_SOUND_HOLD_MS after last sound to absorb key click bursts.
+*/
+#ifndef AUDIO_UI_SOUND_MAX
+    #define AUDIO_UI_SOUND_MAX          8
+#endif
+/* sounds played at the same time, oldest one is replaced if all are busy */
+#ifndef AUDIO_UI_SOUND_VOICES
+    #define AUDIO_UI_SOUND_VOICES       4
+#endif
+#ifndef AUDIO_UI_SOUND_HOLD_MS
+    #define AUDIO_UI_SOUND_HOLD_MS      2000
+#endif
+/* speaker is treated as idle if not mixed for it */
+#define AUDIO_UI_SOUND_IDLE_MS          30
+
+typedef struct
+{
+    const int16_t *pcm;
+    uint32_t samples;           /* samples per channel */
+    uint32_t samplerate;
+    uint8_t  channels;
+    uint8_t  allocated;         /* pcm is freed on unregister */
+} ui_sound_t;
+
+typedef struct
+{
+    const ui_sound_t *snd;      /* NULL if voice is free */
+    uint32_t idx;               /* position in samples per channel */
+    uint16_t frac;              /* Q16 fraction of position */
+    uint16_t gain;              /* Q15 */
+    uint32_t trigger;           /* DWT cycles at trigger, 0 after first mix */
+    uint8_t  cold;              /* triggered while speaker is idle */
+} ui_voice_t;
+
+typedef struct
+{
+    uint32_t cnt;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} ui_latency_t;
+
+static ui_sound_t ui_sounds[AUDIO_UI_SOUND_MAX];
+static ui_voice_t ui_voices[AUDIO_UI_SOUND_VOICES];
+static ui_latency_t ui_lat[2];  /* warm, cold */
+static uint32_t ui_period_us;
+static volatile rt_tick_t ui_last_mix;
+static audio_client_t ui_client;
+static struct rt_semaphore ui_sem;
+static struct rt_thread ui_thread;
+ALIGN(RT_ALIGN_SIZE)
+static uint8_t ui_thread_stack[1536];
+static uint8_t ui_inited;
+
+static inline uint32_t ui_cycles_to_us(uint32_t cycles)
+{
+    return cycles / (HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000);
+}
+
+static bool ui_speaker_active(void)
+{
+    return (rt_tick_get() - ui_last_mix) < rt_tick_from_millisecond(AUDIO_UI_SOUND_IDLE_MS);
+}
+
+static bool ui_voices_active(void)
+{
+    for (int i = 0; i < AUDIO_UI_SOUND_VOICES; i++)
+    {
+        if (ui_voices[i].snd)
+            return true;
+    }
+    return false;
+}
+
+static int ui_client_callback(audio_server_callback_cmt_t cmd, void *callback_userdata, uint32_t reserved)
+{
+    /* nothing is written to ring, output is silence plus mixed ui sounds */
+    return 0;
+}
+
+int audio_ui_sound_is_client(audio_server_callback_func callback)
+{
+    return callback == ui_client_callback;
+}
+
+static void ui_thread_entry(void *param)
+{
+    audio_parameter_t pa;
+
+    while (1)
+    {
+        const ui_sound_t *snd = NULL;
+
+        rt_sem_take(&ui_sem, RT_WAITING_FOREVER);
+
+        for (int i = 0; i < AUDIO_UI_SOUND_VOICES && !snd; i++)
+            snd = ui_voices[i].snd;
+        if (!snd || ui_speaker_active())
+            continue;
+
+        memset(&pa, 0, sizeof(pa));
+        pa.write_samplerate = snd->samplerate;
+        pa.write_channnel_num = snd->channels;
+        pa.write_bits_per_sample = 16;
+        pa.write_cache_size = 0;
+
+        ui_client = audio_open2(AUDIO_TYPE_NOTIFY, AUDIO_TX, &pa, ui_client_callback, NULL, AUDIO_DEVICE_SPEAKER);
+        if (!ui_client)
+        {
+            LOG_E("open ui sound client failed");
+            continue;
+        }
+
+        while (rt_sem_take(&ui_sem, rt_tick_from_millisecond(AUDIO_UI_SOUND_HOLD_MS)) == RT_EOK || ui_voices_active())
+            ;
+
+        audio_close(ui_client);
+        ui_client = NULL;
+    }
+}
+
+static int audio_ui_sound_init(void)
+{
+    rt_sem_init(&ui_sem, "ui_snd", 0, RT_IPC_FLAG_FIFO);
+    rt_thread_init(&ui_thread, "ui_snd", ui_thread_entry, NULL, ui_thread_stack, sizeof(ui_thread_stack),
+                   RT_THREAD_PRIORITY_HIGH + RT_THREAD_PRIORITY_HIGHER, RT_THREAD_TICK_DEFAULT);
+    rt_thread_startup(&ui_thread);
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+    ui_lat[0].min_us = ui_lat[1].min_us = UINT32_MAX;
+    ui_inited = 1;
+    return 0;
+}
+INIT_APP_EXPORT(audio_ui_sound_init);
+
+int audio_ui_sound_register(const int16_t *pcm, uint32_t samples, uint32_t samplerate, uint8_t channels)
+{
+    if (!pcm || !samples || !samplerate || channels < 1 || channels > 2)
+        return -2;
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (int i = 0; i < AUDIO_UI_SOUND_MAX; i++)
+    {
+        if (!ui_sounds[i].pcm)
+        {
+            ui_sounds[i].pcm = pcm;
+            ui_sounds[i].samples = samples;
+            ui_sounds[i].samplerate = samplerate;
+            ui_sounds[i].channels = channels;
+            ui_sounds[i].allocated = 0;
+            rt_hw_interrupt_enable(level);
+            return i + 1;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return -1;
+}
+
+#if RT_USING_DFS
+int audio_ui_sound_load(const char *path)
+{
+    struct
+    {
+        char id[4];
+        uint32_t size;
+    } chunk;
+    char wave[4];
+    uint16_t fmt[8];
+    uint32_t samplerate = 0;
+    uint8_t channels = 0;
+    int16_t *pcm = NULL;
+    int id = -1;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_BINARY);
+    if (fd < 0)
+        return -2;
+
+    if (read(fd, &chunk, sizeof(chunk)) != sizeof(chunk) || memcmp(chunk.id, "RIFF", 4)
+            || read(fd, wave, 4) != 4 || memcmp(wave, "WAVE", 4))
+        goto exit;
+
+    while (read(fd, &chunk, sizeof(chunk)) == sizeof(chunk))
+    {
+        if (!memcmp(chunk.id, "fmt ", 4) && chunk.size >= 16)
+        {
+            if (read(fd, fmt, sizeof(fmt)) != sizeof(fmt))
+                goto exit;
+            /* 16 bits PCM only */
+            if (fmt[0] != 1 || fmt[7] != 16)
+            {
+                LOG_E("%s: not 16 bits PCM", path);
+                goto exit;
+            }
+            channels = (uint8_t)fmt[1];
+            samplerate = fmt[2] | ((uint32_t)fmt[3] << 16);
+            lseek(fd, chunk.size - sizeof(fmt), SEEK_CUR);
+        }
+        else if (!memcmp(chunk.id, "data", 4) && channels)
+        {
+            pcm = audio_mem_malloc(chunk.size);
+            if (!pcm || read(fd, pcm, chunk.size) != (int)chunk.size)
+                goto exit;
+            id = audio_ui_sound_register(pcm, chunk.size / 2 / channels, samplerate, channels);
+            if (id > 0)
+            {
+                ui_sounds[id - 1].allocated = 1;
+                pcm = NULL;
+            }
+            break;
+        }
+        else
+        {
+            lseek(fd, (chunk.size + 1) & ~1, SEEK_CUR);
+        }
+    }
+
+exit:
+    if (pcm)
+        audio_mem_free(pcm);
+    close(fd);
+    if (id < 0)
+        LOG_E("load %s failed", path);
+    return id;
+}
+#endif
+
+void audio_ui_sound_unregister(int id)
+{
+    ui_sound_t *snd;
+    const int16_t *pcm;
+
+    if (id < 1 || id > AUDIO_UI_SOUND_MAX)
+        return;
+
+    snd = &ui_sounds[id - 1];
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (int i = 0; i < AUDIO_UI_SOUND_VOICES; i++)
+    {
+        if (ui_voices[i].snd == snd)
+            ui_voices[i].snd = NULL;
+    }
+    pcm = snd->allocated ? snd->pcm : NULL;
+    snd->pcm = NULL;
+    rt_hw_interrupt_enable(level);
+
+    if (pcm)
+        audio_mem_free((void *)pcm);
+}
+
+int audio_ui_sound_play(int id, uint16_t gain)
+{
+    ui_voice_t *v = NULL;
+    uint32_t oldest = 0;
+    bool active;
+
+    if (!ui_inited || id < 1 || id > AUDIO_UI_SOUND_MAX || !ui_sounds[id - 1].pcm)
+        return -2;
+
+    active = ui_speaker_active();
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (int i = 0; i < AUDIO_UI_SOUND_VOICES; i++)
+    {
+        if (!ui_voices[i].snd)
+        {
+            v = &ui_voices[i];
+            break;
+        }
+        if (!v || ui_voices[i].idx > oldest)
+        {
+            oldest = ui_voices[i].idx;
+            v = &ui_voices[i];
+        }
+    }
+    v->snd = &ui_sounds[id - 1];
+    v->idx = 0;
+    v->frac = 0;
+    v->gain = gain;
+    v->cold = !active;
+    v->trigger = HAL_DBG_DWT_GetCycles();
+    if (!v->trigger)
+        v->trigger = 1;
+    rt_hw_interrupt_enable(level);
+
+    /* open speaker, or keep ui client opened */
+    if (!active || ui_client)
+        rt_sem_release(&ui_sem);
+
+    return 0;
+}
+
+void audio_ui_sound_stop_all(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (int i = 0; i < AUDIO_UI_SOUND_VOICES; i++)
+        ui_voices[i].snd = NULL;
+    rt_hw_interrupt_enable(level);
+}
+
+/* first mixed buffer is played after the one in DMA now, so one period is added */
+static void ui_latency_add(ui_voice_t *v)
+{
+    ui_latency_t *lat = &ui_lat[v->cold];
+    uint32_t us = ui_cycles_to_us(HAL_DBG_DWT_GetCycles() - v->trigger) + ui_period_us;
+
+    lat->cnt++;
+    lat->sum_us += us;
+    if (us < lat->min_us)
+        lat->min_us = us;
+    if (us > lat->max_us)
+        lat->max_us = us;
+    v->trigger = 0;
+}
+
+/* buf += sound, nearest sample for rate conversion, mono and stereo in both directions */
+static void ui_voice_mix(ui_voice_t *v, int16_t *buf, uint32_t frames, uint32_t step, uint8_t out_ch)
+{
+    const ui_sound_t *s = v->snd;
+    uint32_t idx = v->idx;
+    uint32_t frac = v->frac;
+    int32_t gain = v->gain;
+
+    for (uint32_t i = 0; i < frames && idx < s->samples; i++)
+    {
+        const int16_t *p = s->pcm + idx * s->channels;
+        int32_t l = (p[0] * gain) >> 15;
+        int32_t r = s->channels > 1 ? ((p[1] * gain) >> 15) : l;
+
+        if (out_ch == 1)
+        {
+            buf[i] = (int16_t)__SSAT(buf[i] + ((l + r) >> 1), 16);
+        }
+        else
+        {
+            buf[2 * i] = (int16_t)__SSAT(buf[2 * i] + l, 16);
+            buf[2 * i + 1] = (int16_t)__SSAT(buf[2 * i + 1] + r, 16);
+        }
+        frac += step;
+        idx += frac >> 16;
+        frac &= 0xFFFF;
+    }
+
+    v->idx = idx;
+    v->frac = (uint16_t)frac;
+    if (idx >= s->samples)
+        v->snd = NULL;
+}
+
+/* called in speaker tx done interrupt before DMA buffer is written, return voices mixed */
+uint32_t audio_ui_sound_mix(int16_t *buf, uint32_t samples, uint32_t samplerate, uint8_t channels)
+{
+    uint32_t mixed = 0;
+
+    if (!samplerate || !channels)
+        return 0;
+
+    ui_last_mix = rt_tick_get();
+    ui_period_us = (uint32_t)((uint64_t)samples * 1000000 / channels / samplerate);
+
+    for (int i = 0; i < AUDIO_UI_SOUND_VOICES; i++)
+    {
+        ui_voice_t *v = &ui_voices[i];
+
+        if (!v->snd)
+            continue;
+        if (v->trigger)
+            ui_latency_add(v);
+        ui_voice_mix(v, buf, samples / channels, (v->snd->samplerate << 16) / samplerate, channels);
+        mixed++;
+    }
+
+    return mixed;
+}
+
+#ifdef RT_USING_FINSH
+static int ui_sound(int argc, char **argv)
+{
+    if (argc > 2 && strcmp(argv[1], "play") == 0)
+    {
+        int n = argc > 4 ? atoi(argv[4]) : 1;
+        int ms = argc > 5 ? atoi(argv[5]) : 100;
+
+        for (int i = 0; i < n; i++)
+        {
+            audio_ui_sound_play(atoi(argv[2]), argc > 3 ? (uint16_t)strtol(argv[3], NULL, 0) : 0x7FFF);
+            if (i + 1 < n)
+                rt_thread_mdelay(ms);
+        }
+        return 0;
+    }
+#if RT_USING_DFS
+    if (argc > 2 && strcmp(argv[1], "load") == 0)
+    {
+        rt_kprintf("id %d\n", audio_ui_sound_load(argv[2]));
+        return 0;
+    }
+#endif
+    if (argc > 2 && strcmp(argv[1], "unload") == 0)
+    {
+        audio_ui_sound_unregister(atoi(argv[2]));
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        memset(ui_lat, 0, sizeof(ui_lat));
+        ui_lat[0].min_us = ui_lat[1].min_us = UINT32_MAX;
+        return 0;
+    }
+
+    for (int i = 0; i < AUDIO_UI_SOUND_MAX; i++)
+    {
+        if (ui_sounds[i].pcm)
+            rt_kprintf("sound %d: %d samples, %dHz, %d ch\n", i + 1, ui_sounds[i].samples,
+                       ui_sounds[i].samplerate, ui_sounds[i].channels);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        ui_latency_t *lat = &ui_lat[i];
+        rt_kprintf("%s latency: %d plays, min %dus, avg %dus, max %dus\n", i ? "cold" : "warm", lat->cnt,
+                   lat->cnt ? lat->min_us : 0, lat->cnt ? (uint32_t)(lat->sum_us / lat->cnt) : 0, lat->max_us);
+    }
+    rt_kprintf("dma period %dus, speaker %s, ui client %p\n", ui_period_us, ui_speaker_active() ? "active" : "idle", ui_client);
+
+    return 0;
+}
+MSH_CMD_EXPORT(ui_sound, ui_sound [play id [gain] [n] [ms]|load file|unload id|reset]: low latency ui sound);
+#endif /* RT_USING_FINSH */
+
+#endif /* AUDIO_UI_SOUND */
@@ -50,6 +50,7 @@
 #include <rtdevice.h>
 #include "board.h"
 #include "audio_mem.h"
+#include "mem_profiler.h"
 
 #if AUDIO_MEMORY_LEAK_CHECK
 
@@ -202,25 +203,345 @@ MSH_CMD_EXPORT(audio_mem,     audio mem check);
     #define __WEAK
 #endif
 
+#ifdef AUDIO_MEM_ARENA
+/*
+ * Audio buffers are taken from fixed size classes carved out of one heap block at init, so that
+ * per frame allocations neither wait on heap lock nor fail under heap pressure. Alloc and free are
+ * lock free by LDREX/STREX. Blocks reserved in each class are only given to call audio. Requests
+ * not fitting any class fall back to heap. Usage is attributed to type of latest opened stream.
+ */
+#include "audio_server.h"
+
+#ifndef AUDIO_MEM_ARENA_CLASSES
+    /* block size, block number, blocks reserved for call audio */
+    #define AUDIO_MEM_ARENA_CLASSES \
+        {  256, 16, 4 }, \
+        { 1024, 12, 4 }, \
+        { 2048,  8, 2 }, \
+        { 4096,  4, 2 }
+#endif
+
+#define AUDIO_ARENA_MAX_BLOCKS      (64)
+/* last one for allocation before any stream is opened */
+#define AUDIO_ARENA_TYPE_NUM        (AUDIO_TYPE_NUMBER + 1)
+#define AUDIO_ARENA_IS_VOICE(type)  (((type) == AUDIO_TYPE_BT_VOICE) || ((type) == AUDIO_TYPE_MODEM_VOICE))
+
+typedef struct
+{
+    uint16_t size;
+    uint8_t  num;
+    uint8_t  reserved;
+} audio_arena_cfg_t;
+
+typedef struct
+{
+    uint8_t *base;
+    uint32_t size;
+    uint32_t num;
+    uint32_t reserved;
+    volatile uint32_t used;
+    volatile uint32_t peak;
+    /* bit set if block in use, bits beyond num are always set */
+    volatile uint32_t bitmap[AUDIO_ARENA_MAX_BLOCKS / 32];
+    uint8_t owner[AUDIO_ARENA_MAX_BLOCKS];
+} audio_arena_class_t;
+
+typedef struct
+{
+    volatile uint32_t cur;
+    volatile uint32_t peak;
+    volatile uint32_t fallback;
+} audio_arena_stat_t;
+
+static const audio_arena_cfg_t audio_arena_cfg[] = { AUDIO_MEM_ARENA_CLASSES };
+#define AUDIO_ARENA_CLASS_NUM       (sizeof(audio_arena_cfg) / sizeof(audio_arena_cfg[0]))
+
+static audio_arena_class_t audio_arena[AUDIO_ARENA_CLASS_NUM];
+static uint8_t *audio_arena_start;
+static uint8_t *audio_arena_end;
+static volatile uint8_t audio_arena_type = AUDIO_TYPE_NUMBER;
+static audio_arena_stat_t audio_arena_stat[AUDIO_ARENA_TYPE_NUM];
+
+static uint32_t audio_arena_add(volatile uint32_t *p, int32_t delta)
+{
+    uint32_t v;
+
+    do
+    {
+        v = __LDREXW(p) + delta;
+    }
+    while (__STREXW(v, p));
+
+    return v;
+}
+
+static void audio_arena_max(volatile uint32_t *p, uint32_t v)
+{
+    do
+    {
+        if (__LDREXW(p) >= v)
+        {
+            __CLREX();
+            return;
+        }
+    }
+    while (__STREXW(v, p));
+}
+
+/* count one more block in use unless limit is reached, a free bit is guaranteed afterwards */
+static bool audio_arena_take(audio_arena_class_t *c, uint32_t limit)
+{
+    uint32_t used;
+
+    do
+    {
+        used = __LDREXW(&c->used);
+        if (used >= limit)
+        {
+            __CLREX();
+            return false;
+        }
+    }
+    while (__STREXW(used + 1, &c->used));
+    audio_arena_max(&c->peak, used + 1);
+
+    return true;
+}
+
+static int audio_arena_claim(audio_arena_class_t *c)
+{
+    uint32_t w, v, bit;
+
+    for (w = 0; w < AUDIO_ARENA_MAX_BLOCKS / 32; w++)
+    {
+        do
+        {
+            v = __LDREXW(&c->bitmap[w]);
+            if (v == 0xFFFFFFFF)
+            {
+                __CLREX();
+                break;
+            }
+            bit = __CLZ(__RBIT(~v));
+            if (!__STREXW(v | (1UL << bit), &c->bitmap[w]))
+                return w * 32 + bit;
+        }
+        while (1);
+    }
+
+    return -1;
+}
+
+static void audio_arena_release(audio_arena_class_t *c, uint32_t idx)
+{
+    volatile uint32_t *word = &c->bitmap[idx / 32];
+    uint32_t v;
+
+    do
+    {
+        v = __LDREXW(word);
+        RT_ASSERT(v & (1UL << (idx % 32)));
+    }
+    while (__STREXW(v & ~(1UL << (idx % 32)), word));
+    /* clear bit before count so that a taker always finds a free bit */
+    audio_arena_add(&c->used, -1);
+}
+
+static void *audio_arena_alloc(uint32_t size)
+{
+    audio_arena_class_t *c;
+    uint8_t type = audio_arena_type;
+    uint32_t i, cur;
+    int idx;
+
+    for (i = 0, c = &audio_arena[0]; i < AUDIO_ARENA_CLASS_NUM; i++, c++)
+    {
+        if (c->base == NULL || c->size < size)
+            continue;
+        if (!audio_arena_take(c, AUDIO_ARENA_IS_VOICE(type) ? c->num : c->num - c->reserved))
+            continue;
+
+        idx = audio_arena_claim(c);
+        RT_ASSERT(idx >= 0);
+        c->owner[idx] = type;
+        cur = audio_arena_add(&audio_arena_stat[type].cur, c->size);
+        audio_arena_max(&audio_arena_stat[type].peak, cur);
+        return c->base + idx * c->size;
+    }
+    if (audio_arena_start)
+        audio_arena_add(&audio_arena_stat[type].fallback, 1);
+
+    return NULL;
+}
+
+static audio_arena_class_t *audio_arena_find(void *ptr, uint32_t *idx)
+{
+    audio_arena_class_t *c;
+    uint8_t *p = (uint8_t *)ptr;
+    uint32_t i;
+
+    if (p < audio_arena_start || p >= audio_arena_end)
+        return NULL;
+
+    for (i = 0, c = &audio_arena[0]; i < AUDIO_ARENA_CLASS_NUM; i++, c++)
+    {
+        if (p >= c->base && p < c->base + c->size * c->num)
+        {
+            *idx = (p - c->base) / c->size;
+            RT_ASSERT(p == c->base + *idx * c->size);
+            return c;
+        }
+    }
+    RT_ASSERT(0);
+
+    return NULL;
+}
+
+static bool audio_arena_free(void *ptr)
+{
+    audio_arena_class_t *c;
+    uint32_t idx;
+
+    c = audio_arena_find(ptr, &idx);
+    if (c == NULL)
+        return false;
+
+    audio_arena_add(&audio_arena_stat[c->owner[idx]].cur, -(int32_t)c->size);
+    audio_arena_release(c, idx);
+
+    return true;
+}
+
+void audio_mem_set_type(uint8_t audio_type)
+{
+    audio_arena_type = audio_type < AUDIO_TYPE_NUMBER ? audio_type : AUDIO_TYPE_NUMBER;
+}
+
+static int audio_arena_init(void)
+{
+    audio_arena_class_t *c;
+    uint32_t total = 0;
+    uint32_t i, j;
+    uint8_t *p;
+
+    for (i = 0; i < AUDIO_ARENA_CLASS_NUM; i++)
+    {
+        RT_ASSERT(audio_arena_cfg[i].num <= AUDIO_ARENA_MAX_BLOCKS);
+        RT_ASSERT(audio_arena_cfg[i].reserved <= audio_arena_cfg[i].num);
+        RT_ASSERT((audio_arena_cfg[i].size & 31) == 0);
+        total += audio_arena_cfg[i].size * audio_arena_cfg[i].num;
+    }
+
+    /* cache line aligned as blocks are used as DMA buffer */
+    p = (uint8_t *)rt_malloc_align(total, 32);
+    if (p == NULL)
+    {
+        rt_kprintf("audio arena %d bytes alloc fail\n", total);
+        return -RT_ENOMEM;
+    }
+
+    for (i = 0, c = &audio_arena[0]; i < AUDIO_ARENA_CLASS_NUM; i++, c++)
+    {
+        c->base = p;
+        c->size = audio_arena_cfg[i].size;
+        c->num = audio_arena_cfg[i].num;
+        c->reserved = audio_arena_cfg[i].reserved;
+        for (j = c->num; j < AUDIO_ARENA_MAX_BLOCKS; j++)
+            c->bitmap[j / 32] |= 1UL << (j % 32);
+        p += c->size * c->num;
+    }
+    audio_arena_end = p;
+    audio_arena_start = audio_arena[0].base;
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(audio_arena_init);
+
+#ifdef RT_USING_FINSH
+static int audio_arena_cmd(int argc, char **argv)
+{
+    audio_arena_class_t *c;
+    uint32_t i;
+
+    rt_kprintf("size  used/num  peak  reserved\n");
+    for (i = 0, c = &audio_arena[0]; i < AUDIO_ARENA_CLASS_NUM; i++, c++)
+        rt_kprintf("%-5d %4d/%-4d %-5d %d\n", c->size, c->used, c->num, c->peak, c->reserved);
+
+    rt_kprintf("type  cur     peak    fallback\n");
+    for (i = 0; i < AUDIO_ARENA_TYPE_NUM; i++)
+    {
+        if (audio_arena_stat[i].peak == 0 && audio_arena_stat[i].fallback == 0)
+            continue;
+        if (i < AUDIO_TYPE_NUMBER)
+            rt_kprintf("%-5d ", i);
+        else
+            rt_kprintf("none  ");
+        rt_kprintf("%-7d %-7d %d\n", audio_arena_stat[i].cur, audio_arena_stat[i].peak, audio_arena_stat[i].fallback);
+    }
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(audio_arena_cmd, audio_arena, show audio arena usage);
+#endif /* RT_USING_FINSH */
+
+#endif /* AUDIO_MEM_ARENA */
+
 __WEAK void *audio_mem_malloc(uint32_t size)
 {
-    void *ptr = rt_malloc(size);
+    void *ptr;
+#ifdef AUDIO_MEM_ARENA
+    ptr = audio_arena_alloc(size);
+    if (ptr)
+        return ptr;
+#endif
+    ptr = rt_malloc(size);
     RT_ASSERT(ptr);
+    mem_prof_retag(ptr, MEM_PROF_HEAP_AUDIO);
     return ptr;
 }
 __WEAK void audio_mem_free(void *ptr)
 {
+#ifdef AUDIO_MEM_ARENA
+    if (audio_arena_free(ptr))
+        return;
+#endif
     rt_free(ptr);
 }
 __WEAK void *audio_mem_calloc(uint32_t count, uint32_t size)
 {
-    return rt_calloc(count, size);
+    void *ptr;
+#ifdef AUDIO_MEM_ARENA
+    ptr = audio_arena_alloc(count * size);
+    if (ptr)
+    {
+        memset(ptr, 0, count * size);
+        return ptr;
+    }
+#endif
+    ptr = rt_calloc(count, size);
+    mem_prof_retag(ptr, MEM_PROF_HEAP_AUDIO);
+    return ptr;
 }
 __WEAK void *audio_mem_realloc_do(void *mem_address, unsigned int newsize)
 {
     void *ptr = NULL;
+#ifdef AUDIO_MEM_ARENA
+    audio_arena_class_t *c;
+    uint32_t idx;
+
+    c = mem_address ? audio_arena_find(mem_address, &idx) : NULL;
+    if (c)
+    {
+        if (newsize <= c->size)
+            return mem_address;
+        ptr = audio_mem_malloc(newsize);
+        memcpy(ptr, mem_address, c->size);
+        audio_mem_free(mem_address);
+        return ptr;
+    }
+#endif
 #if 1
     ptr = rt_realloc(mem_address, newsize);
+    mem_prof_retag(ptr, MEM_PROF_HEAP_AUDIO);
 #else
     if (!mem_address)
     {
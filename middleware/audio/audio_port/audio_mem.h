@@ -55,6 +55,16 @@
 
 #define     AUDIO_MEMORY_LEAK_CHECK         0
 
+/* take audio buffers from fixed size classes, see AUDIO_MEM_ARENA_CLASSES in audio_mem.c */
+//#define AUDIO_MEM_ARENA
+
+#if defined(AUDIO_MEM_ARENA) && !AUDIO_MEMORY_LEAK_CHECK
+    /* attribute following allocations to audio_type_t, call audio may use reserved blocks */
+    void audio_mem_set_type(uint8_t audio_type);
+#else
+    #define audio_mem_set_type(audio_type)
+#endif
+
 #if AUDIO_MEMORY_LEAK_CHECK
     void *audio_mem_malloc_do(uint32_t size, const char *file, int line);
     void  audio_mem_free_do(void *ptr);
@@ -0,0 +1,196 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <rtthread.h>
+#include "bf0_hal.h"
+#include "audio_beamform.h"
+
+#define DBG_TAG           "audio"
+#define DBG_LVL           LOG_LVL_INFO
+#include "log.h"
+
+#define SOUND_SPEED_MM_S    343000
+#define BF_HIST             (AUDIO_BF_MAX_DELAY + AUDIO_BF_TAPS - 1)
+
+struct audio_bf
+{
+    audio_bf_config_t cfg;
+    uint16_t    frame_samples;
+    uint8_t     delay[AUDIO_BF_MAX_MICS];       //integer part
+    /* taps in time order of input, pairs packed for SMLAD, weight included */
+    uint32_t    taps[AUDIO_BF_MAX_MICS][AUDIO_BF_TAPS / 2];
+    int16_t     *hist[AUDIO_BF_MAX_MICS];       //BF_HIST samples of last frame + frame
+    audio_bf_stat_t stat;
+    uint64_t    cycles_sum;
+};
+
+static void bf_make_taps(audio_bf_t *bf, int mic, float delay, float weight)
+{
+    float h[AUDIO_BF_TAPS], sum = 0;
+    int d = (int)delay;
+    float f = delay - d;
+    int i;
+
+    if (d > AUDIO_BF_MAX_DELAY)
+    {
+        d = AUDIO_BF_MAX_DELAY;
+        f = 0;
+    }
+    bf->delay[mic] = d;
+    /* h[k] delays by (TAPS/2 - 1 + f), same latency for all mics */
+    for (i = 0; i < AUDIO_BF_TAPS; i++)
+    {
+        float t = i - (AUDIO_BF_TAPS / 2 - 1) - f;
+        float w = 0.5f + 0.5f * cosf(3.14159265f * t / (AUDIO_BF_TAPS / 2));
+        h[i] = (fabsf(t) < 1e-6f) ? 1.0f : sinf(3.14159265f * t) / (3.14159265f * t);
+        h[i] *= w;
+        sum += h[i];
+    }
+    /* filter input window is x[n-d-TAPS+1] ... x[n-d], reversed order of h */
+    for (i = 0; i < AUDIO_BF_TAPS; i += 2)
+    {
+        int32_t lo = (int32_t)(h[AUDIO_BF_TAPS - 1 - i] / sum * weight * 32767.0f);
+        int32_t hi = (int32_t)(h[AUDIO_BF_TAPS - 2 - i] / sum * weight * 32767.0f);
+        bf->taps[mic][i / 2] = ((uint32_t)(uint16_t)lo) | ((uint32_t)hi << 16);
+    }
+}
+
+int audio_bf_steer(audio_bf_t *bf, int16_t steer_deg)
+{
+    float ux, uy, proj[AUDIO_BF_MAX_MICS], min;
+    int i;
+
+    if (!bf)
+        return -1;
+    bf->cfg.steer_deg = steer_deg;
+    ux = cosf(steer_deg * 3.14159265f / 180);
+    uy = sinf(steer_deg * 3.14159265f / 180);
+    /* mic nearer to source gets wavefront earlier and is delayed more */
+    for (i = 0; i < bf->cfg.mic_num; i++)
+    {
+        proj[i] = bf->cfg.mic[i].x_mm * ux + bf->cfg.mic[i].y_mm * uy;
+        if (i == 0 || proj[i] < min)
+            min = proj[i];
+    }
+    for (i = 0; i < bf->cfg.mic_num; i++)
+    {
+        float weight = bf->cfg.weight[i] ? bf->cfg.weight[i] / 32768.0f : 1.0f / bf->cfg.mic_num;
+        bf_make_taps(bf, i, (proj[i] - min) * bf->cfg.samplerate / SOUND_SPEED_MM_S, weight);
+    }
+    return 0;
+}
+
+audio_bf_t *audio_bf_create(const audio_bf_config_t *cfg, uint16_t frame_samples)
+{
+    audio_bf_t *bf;
+    int i;
+
+    if (!cfg || cfg->mic_num == 0 || cfg->mic_num > AUDIO_BF_MAX_MICS || !cfg->samplerate || !frame_samples)
+        return NULL;
+    bf = rt_calloc(1, sizeof(audio_bf_t));
+    if (!bf)
+        return NULL;
+    bf->cfg = *cfg;
+    bf->frame_samples = frame_samples;
+    for (i = 0; i < cfg->mic_num; i++)
+    {
+        bf->hist[i] = rt_calloc(BF_HIST + frame_samples, sizeof(int16_t));
+        if (!bf->hist[i])
+        {
+            audio_bf_destroy(bf);
+            return NULL;
+        }
+    }
+    audio_bf_steer(bf, cfg->steer_deg);
+    LOG_I("bf create mics=%d steer=%d delay=%d/%d/%d", cfg->mic_num, cfg->steer_deg,
+          bf->delay[0], bf->delay[1], bf->delay[2]);
+    return bf;
+}
+
+void audio_bf_destroy(audio_bf_t *bf)
+{
+    if (!bf)
+        return;
+    for (int i = 0; i < AUDIO_BF_MAX_MICS; i++)
+        if (bf->hist[i])
+            rt_free(bf->hist[i]);
+    rt_free(bf);
+}
+
+static inline int32_t bf_fir(const int16_t *x, const uint32_t *taps, int32_t acc)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    for (int k = 0; k < AUDIO_BF_TAPS / 2; k++)
+        acc = __SMLAD(__UNALIGNED_UINT32_READ(x + 2 * k), taps[k], acc);
+#else
+    for (int k = 0; k < AUDIO_BF_TAPS / 2; k++)
+    {
+        acc += (int32_t)x[2 * k] * (int16_t)(taps[k] & 0xFFFF);
+        acc += (int32_t)x[2 * k + 1] * (int16_t)(taps[k] >> 16);
+    }
+#endif
+    return acc;
+}
+
+void audio_bf_process(audio_bf_t *bf, const int16_t *const in[], const uint8_t stride[], int16_t *out)
+{
+    const int16_t *win[AUDIO_BF_MAX_MICS];
+    uint32_t start = HAL_DBG_DWT_GetCycles();
+    uint32_t n, cycles;
+    int m, mics = bf->cfg.mic_num;
+
+    /* append frame after history, deinterleave */
+    for (m = 0; m < mics; m++)
+    {
+        int16_t *h = bf->hist[m] + BF_HIST;
+        const int16_t *s = in[m];
+        uint8_t st = stride[m];
+        for (n = 0; n < bf->frame_samples; n++, s += st)
+            h[n] = *s;
+        win[m] = bf->hist[m] + BF_HIST - bf->delay[m] - (AUDIO_BF_TAPS - 1);
+    }
+
+    if (mics == 3)
+    {
+        for (n = 0; n < bf->frame_samples; n++)
+        {
+            int32_t acc = bf_fir(win[0] + n, bf->taps[0], 0);
+            acc = bf_fir(win[1] + n, bf->taps[1], acc);
+            acc = bf_fir(win[2] + n, bf->taps[2], acc);
+            out[n] = __SSAT(acc >> 15, 16);
+        }
+    }
+    else
+    {
+        for (n = 0; n < bf->frame_samples; n++)
+        {
+            int32_t acc = 0;
+            for (m = 0; m < mics; m++)
+                acc = bf_fir(win[m] + n, bf->taps[m], acc);
+            out[n] = __SSAT(acc >> 15, 16);
+        }
+    }
+
+    for (m = 0; m < mics; m++)
+        memmove(bf->hist[m], bf->hist[m] + bf->frame_samples, BF_HIST * sizeof(int16_t));
+
+    cycles = HAL_DBG_DWT_GetCycles() - start;
+    bf->cycles_sum += cycles;
+    bf->stat.frames++;
+    if (cycles > bf->stat.cycles_max)
+        bf->stat.cycles_max = cycles;
+}
+
+void audio_bf_get_stat(audio_bf_t *bf, audio_bf_stat_t *stat, uint8_t reset)
+{
+    if (!bf || !stat)
+        return;
+    *stat = bf->stat;
+    stat->cycles_avg = bf->stat.frames ? (uint32_t)(bf->cycles_sum / bf->stat.frames) : 0;
+    if (reset)
+    {
+        memset(&bf->stat, 0, sizeof(bf->stat));
+        bf->cycles_sum = 0;
+    }
+}
@@ -2,8 +2,14 @@
 //
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include "audio_freqshift.h"
+#ifdef SOC_BF0_HCPU
+    #include <rtthread.h>
+    #include "bf0_hal.h"
+#endif
 
 #define FREQ_SHIFT  10                      // Shifting 10Hz
 
@@ -385,6 +391,250 @@ float freq_shift(int16_t *data_in, int16_t *data_out, int len, float phase_acc,
     return phase_acc;
 }
 
+/*
+  Fixed point version, all state is static and any block length is accepted.
+  Hilbert FIR runs on Q15 samples with SMLAD on sample pairs, hb_coef is exact in Q15.
+  Mixer output r * cos - i * sin is one SMUSD on packed (r, i) and (cos, sin).
+  Phase is a 32 bit accumulator, 2^32 is 1024 table steps.
+*/
+#define FREQ_SHIFT_BLOCK    FRAME_LENGTH
+
+#if defined(SOC_BF0_HCPU)
+    #define FREQ_SHIFT_SAT16(v)     __SSAT((v), 16)
+#else
+    #define FREQ_SHIFT_SAT16(v)     ((v) > 32767 ? 32767 : ((v) < -32768 ? -32768 : (v)))
+#endif
+
+static const int16_t hb_coef_q15[HB_FO] =
+{
+    2, -8701, -2, -4220, -6, -6967, 9, -20868, 0, 20868, -9, 6967, 6, 4220, 2, 8701,
+};
+
+static const int16_t sin_table_q15[] =  // round(sin([0:256] * pi / 512) * 32767)
+{
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210,
+    2410, 2611, 2811, 3012, 3212, 3412, 3612, 3811, 4011, 4210, 4410, 4609,
+    4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195, 6393, 6590, 6786, 6983,
+    7179, 7375, 7571, 7767, 7962, 8157, 8351, 8545, 8739, 8933, 9126, 9319,
+    9512, 9704, 9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+    14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269, 15446, 15623, 15800, 15976,
+    16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+    18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000,
+    20159, 20317, 20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311, 23452, 23592,
+    23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+    25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674,
+    26790, 26905, 27019, 27133, 27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+    28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+    29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+    30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050,
+    31113, 31176, 31237, 31297, 31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+    31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250,
+    32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752,
+    32757, 32761, 32765, 32766, 32767,
+};
+
+typedef struct
+{
+    uint32_t    taps[HB_FO / 2];                        //pairs in input order for SMLAD
+    int16_t     hist[HB_FO - 1 + FREQ_SHIFT_BLOCK];     //HB_FO - 1 samples of last block + block
+    uint32_t    phase;
+    uint32_t    step;
+    uint8_t     skip;                                   //imaginary outputs to drop after reset
+} freq_shift_q_t;
+
+static freq_shift_q_t g_fs;
+
+static inline uint32_t freq_shift_lut_q15(uint32_t phase_index)
+{
+    int32_t c, s;
+
+    if (phase_index <= 256)
+    {
+        c = sin_table_q15[256 - phase_index];
+        s = sin_table_q15[phase_index];
+    }
+    else if (phase_index <= 512)
+    {
+        c = -sin_table_q15[phase_index - 256];
+        s = sin_table_q15[512 - phase_index];
+    }
+    else if (phase_index <= 768)
+    {
+        c = -sin_table_q15[768 - phase_index];
+        s = -sin_table_q15[phase_index - 512];
+    }
+    else
+    {
+        c = sin_table_q15[phase_index - 768];
+        s = -sin_table_q15[1024 - phase_index];
+    }
+    return (uint32_t)(uint16_t)c | ((uint32_t)s << 16);
+}
+
+void freq_shift_open(int shift_hz, int samplerate)
+{
+    freq_shift_q_t *p = &g_fs;
+
+    memset(p, 0, sizeof(*p));
+    /* window at hist + n is x[n - 15] ... x[n], tap k covers x[n - 15 + 2k] and x[n - 14 + 2k] */
+    for (int k = 0; k < HB_FO / 2; k++)
+    {
+        p->taps[k] = (uint32_t)(uint16_t)hb_coef_q15[HB_FO - 1 - 2 * k]
+                     | ((uint32_t)(uint16_t)hb_coef_q15[HB_FO - 2 - 2 * k] << 16);
+    }
+    p->step = (uint32_t)(((int64_t)shift_hz << 32) / samplerate);
+    p->skip = HB_GRD;
+}
+
+static void freq_shift_q_block(const int16_t *data_in, int16_t *data_out, int len)
+{
+    freq_shift_q_t *p = &g_fs;
+    int16_t *x = p->hist;
+    uint32_t phase = p->phase;
+
+    memcpy(&x[HB_FO - 1], data_in, len * sizeof(int16_t));
+    for (int n = 0; n < len; n++)
+    {
+        int32_t acc = 0, re, im, out;
+        uint32_t cs = freq_shift_lut_q15(((phase + (1 << 21)) >> 22) & 1023);
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+        for (int k = 0; k < HB_FO / 2; k++)
+            acc = __SMLAD(__UNALIGNED_UINT32_READ(x + n + 2 * k), p->taps[k], acc);
+#else
+        for (int k = 0; k < HB_FO / 2; k++)
+        {
+            acc += (int32_t)x[n + 2 * k] * (int16_t)(p->taps[k] & 0xFFFF);
+            acc += (int32_t)x[n + 2 * k + 1] * (int16_t)(p->taps[k] >> 16);
+        }
+#endif
+        im = FREQ_SHIFT_SAT16((acc + (1 << 14)) >> 15);
+        if (p->skip)
+        {
+            im = 0;
+            p->skip--;
+        }
+        // real part is input delayed by group delay of hilbert filter
+        re = x[n + HB_FO - 1 - HB_GRD];
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+        out = __SMUSD((uint32_t)(uint16_t)re | ((uint32_t)im << 16), cs);
+#else
+        out = re * (int16_t)(cs & 0xFFFF) - im * (int16_t)(cs >> 16);
+#endif
+        data_out[n] = (int16_t)FREQ_SHIFT_SAT16((out + (1 << 14)) >> 15);
+        phase += p->step;
+    }
+    memmove(x, &x[len], (HB_FO - 1) * sizeof(int16_t));
+    p->phase = phase;
+}
+
+void freq_shift_process(int16_t *data_in, int16_t *data_out, int len)
+{
+    while (len > 0)
+    {
+        int n = len > FREQ_SHIFT_BLOCK ? FREQ_SHIFT_BLOCK : len;
+
+        freq_shift_q_block(data_in, data_out, n);
+        data_in += n;
+        data_out += n;
+        len -= n;
+    }
+}
+
+#if defined(SOC_BF0_HCPU) && defined(RT_USING_FINSH)
+/*
+  Regression of fixed point shifter against float freq_shift(), SNR of fixed output
+  taking float output as reference, and cpu cycles per sample of both.
+  Float phase_acc drifts by float rounding and sometimes picks neighbour table entry,
+  that is where most of the difference comes from.
+*/
+#ifndef FREQ_SHIFT_TEST_LEN
+    #define FREQ_SHIFT_TEST_LEN     800     //samples of one speaker tx block, TX_DMA_SIZE / 2 of audio server
+#endif
+#define FREQ_SHIFT_TEST_SAMPLES     (SAMPLE_RATE * 2)
+
+/* sweep 100Hz - 7kHz plus white noise, about -6dBFS */
+static void freq_shift_test_signal(int16_t *buf, int len, uint32_t pos, uint32_t *seed)
+{
+    for (int i = 0; i < len; i++)
+    {
+        float t = (float)(pos + i) / SAMPLE_RATE;
+        float f = 100.0f + 3450.0f * t;
+        float v = 0.4f * sinf(2.0f * 3.14159265f * f * t);
+
+        *seed = *seed * 1664525 + 1013904223;
+        v += 0.05f * ((int32_t)*seed >> 16) / 32768.0f;
+        buf[i] = (int16_t)(v * 32767);
+    }
+}
+
+static int freqshift_test(int argc, char **argv)
+{
+    int len = argc > 1 ? atoi(argv[1]) : FREQ_SHIFT_TEST_LEN;
+    int16_t *in, *ref, *fix;
+    uint32_t seed = 1, pos, cycles_f = 0, cycles_q = 0, start;
+    float sig = 0, err = 0, max_err = 0, acc = 0;
+    int first = 1;
+
+    if (len <= 0)
+    {
+        rt_kprintf("freqshift_test [block samples]\n");
+        return -1;
+    }
+    in = rt_malloc(len * sizeof(int16_t) * 3);
+    if (!in)
+    {
+        rt_kprintf("freqshift_test: no memory\n");
+        return -1;
+    }
+    ref = in + len;
+    fix = ref + len;
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    memset(hb_reg, 0, sizeof(hb_reg));
+    memset(hb_buf, 0, sizeof(hb_buf));
+    freq_shift_open(FREQ_SHIFT, SAMPLE_RATE);
+    for (pos = 0; pos + len <= FREQ_SHIFT_TEST_SAMPLES; pos += len)
+    {
+        freq_shift_test_signal(in, len, pos, &seed);
+        start = HAL_DBG_DWT_GetCycles();
+        freq_shift_process(in, fix, len);
+        cycles_q += HAL_DBG_DWT_GetCycles() - start;
+        start = HAL_DBG_DWT_GetCycles();
+        for (int i = 0; i < len; i += FRAME_LENGTH)
+        {
+            int n = len - i > FRAME_LENGTH ? FRAME_LENGTH : len - i;
+            acc = freq_shift(&in[i], &ref[i], n, acc, first);
+            first = 0;
+        }
+        cycles_f += HAL_DBG_DWT_GetCycles() - start;
+        for (int i = 0; i < len; i++)
+        {
+            float d = (float)ref[i] - fix[i];
+            sig += (float)ref[i] * ref[i];
+            err += d * d;
+            if (fabsf(d) > max_err)
+                max_err = fabsf(d);
+        }
+    }
+    if (pos)
+    {
+        rt_kprintf("freqshift_test: block %d, %d samples\n", len, pos);
+        rt_kprintf("  SNR %d.%02d dB, max error %d LSB\n", (int)(10 * log10f(sig / (err + 1e-6f))),
+                   (int)(1000 * log10f(sig / (err + 1e-6f))) % 100, (int)max_err);
+        rt_kprintf("  cycles/sample: fixed %d.%02d, float %d.%02d\n",
+                   cycles_q / pos, cycles_q % pos * 100 / pos, cycles_f / pos, cycles_f % pos * 100 / pos);
+    }
+    rt_free(in);
+    return 0;
+}
+MSH_CMD_EXPORT(freqshift_test, compare fixed point frequency shifter with float);
+#endif
+
 // Test code in PC.
 #if 0
 int16_t input_data[FRAME_LENGTH];
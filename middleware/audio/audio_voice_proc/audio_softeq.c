@@ -5,6 +5,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include "audio_softeq.h"
+#ifdef SOC_BF0_HCPU
+    #include <rtthread.h>
+    #include "bf0_hal.h"
+    #if defined(hwp_facc1) && defined(HAL_FACC_MODULE_ENABLED)
+        #define SOFTEQ_USING_FACC   1
+    #endif
+#endif
 
 #define SAMPLE_RATE 16000                   // Sample rate
 #define FRAME_LENGTH ((16*15)>> 1)          // Frame length, 7.5ms data
@@ -66,6 +74,538 @@ void soft_eq_param(int32_t *param, float *param_f)
         }
 }
 
+/*
+  Fixed point cascade, same result as soft_eq() within rounding.
+  Real coefficient is raw Q23 value * 4 (see soft_eq()), i.e. raw value in Q21.
+  x and y state are kept in Q27 so low frequency high Q stages keep precision,
+  each tap is one 32x32+64 MAC (SMLAL). Output of each stage is saturated to 16 bits
+  like float version, so stages can run in place.
+*/
+#ifdef SOC_BF0_HCPU
+    #define SOFTEQ_SAT16(v)     __SSAT((v), 16)
+#else
+    #define SOFTEQ_SAT16(v)     ((v) > 32767 ? 32767 : ((v) < -32768 ? -32768 : (v)))
+#endif
+
+void soft_eq_q_param(int32_t *param, soft_eq_q_stage_t *st, int stage)
+{
+    // raw order is b0 b1 a1 b2 a2, fixed order is b0 b1 b2 a1 a2
+    static const uint8_t order[SOFTEQ_PARAM] = {0, 1, 3, 2, 4};
+
+    for (int i = 0; i < stage; i++)
+    {
+        for (int j = 0; j < SOFTEQ_PARAM; j++)
+        {
+            int32_t v = param[i * SOFTEQ_PARAM + order[j]];
+            if (v >= (1 << 23))
+                v -= (1 << 24);
+            st[i].c[j] = v;
+        }
+        st[i].x1 = st[i].x2 = st[i].y1 = st[i].y2 = 0;
+    }
+}
+
+static void soft_eq_q_stage(const int16_t *data_in, int16_t *data_out, int len, soft_eq_q_stage_t *st)
+{
+    const int32_t b0 = st->c[0], b1 = st->c[1], b2 = st->c[2], a1 = st->c[3], a2 = st->c[4];
+    int32_t x1 = st->x1, x2 = st->x2, y1 = st->y1, y2 = st->y2;
+
+    for (int j = 0; j < len; j++)
+    {
+        int32_t x0 = (int32_t)data_in[j] << 12;
+        int64_t acc = (int64_t)b0 * x0;
+        int32_t y0;
+
+        acc += (int64_t)b1 * x1;
+        acc += (int64_t)b2 * x2;
+        acc += (int64_t)a1 * y1;
+        acc += (int64_t)a2 * y2;
+        y0 = (int32_t)(acc >> 21);
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        data_out[j] = (int16_t)SOFTEQ_SAT16((y0 + (1 << 11)) >> 12);
+    }
+    st->x1 = x1;
+    st->x2 = x2;
+    st->y1 = y1;
+    st->y2 = y2;
+}
+
+void soft_eq_q(int16_t *data_in, int16_t *data_out, int len, soft_eq_q_stage_t *st, int stage)
+{
+    if (stage <= 0)
+    {
+        if (data_out != data_in)
+            memcpy(data_out, data_in, len * sizeof(int16_t));
+        return;
+    }
+    soft_eq_q_stage(data_in, data_out, len, &st[0]);
+    for (int i = 1; i < stage; i++)
+        soft_eq_q_stage(data_out, data_out, len, &st[i]);
+}
+
+#ifdef SOC_BF0_HCPU
+static soft_eq_q_stage_t g_eq_q[SOFTEQ_PARAM_STAGE];
+
+#if SOFTEQ_USING_FACC
+/*
+  FACC IIR: y = (sum(b * x) + sum(a * y)) >> (15 - gain), a0 is not in coefficients.
+  Each biquad runs as one FACC IIR job with its own state buffer (buffer mode),
+  stages are chained in complete interrupt, ping-pong between data_out and tmp.
+  Stages not suitable for FACC run on CPU first, biquad cascade order does not matter.
+*/
+#define SOFTEQ_FACC_STATE_SIZE      RT_ALIGN(FACC_IIR_STATE_SIZE, 4)
+#define SOFTEQ_FACC_MAX_NOISE_GAIN  8   //about 4 LSB error each stage
+
+typedef struct
+{
+    int16_t     b[4];   //b0 b1 b2, 8 bytes for fifo alignment, only 6 bytes used
+    int16_t     a[2];   //a1 a2
+    uint8_t     gain;
+    uint8_t     *state;
+} soft_eq_facc_stage_t;
+
+typedef struct
+{
+    FACC_HandleTypeDef      hfacc;
+    struct rt_semaphore     sem;
+    soft_eq_facc_stage_t    st[SOFTEQ_PARAM_STAGE];
+    soft_eq_q_stage_t       cpu_st[SOFTEQ_PARAM_STAGE];
+    int                     cpu_stage;
+    uint8_t                 *state_pool;
+    int16_t                 *tmp;
+    int16_t                 *in;
+    int16_t                 *out;
+    soft_eq_done_t          done;
+    void                    *user_data;
+    int                     len;
+    int                     stage;
+    int                     max_len;
+    volatile int            cur;
+    volatile uint8_t        busy;
+    uint8_t                 ready;
+} soft_eq_facc_t;
+
+static soft_eq_facc_t g_eq_facc;
+
+static int soft_eq_facc_coeff(int32_t *param, int stage)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+
+    p->stage = 0;
+    p->cpu_stage = 0;
+    for (int i = 0; i < stage; i++)
+    {
+        int32_t v[SOFTEQ_PARAM];
+        int32_t max = 0;
+        int gain;
+        for (int j = 0; j < SOFTEQ_PARAM; j++)
+        {
+            v[j] = param[i * SOFTEQ_PARAM + j];
+            if (v[j] >= (1 << 23))
+                v[j] -= (1 << 24);
+            if (abs(v[j]) > max)
+                max = abs(v[j]);
+        }
+        // real coefficient is v / 2^21(output * 4 in soft_eq), FACC coefficient is Q(15 - gain)
+        for (gain = 0; gain <= 15; gain++)
+        {
+            if ((max >> (6 + gain)) < 32767)
+                break;
+        }
+        soft_eq_facc_stage_t *s = &p->st[p->stage];
+        int32_t one, a1, a2, den_dc, den_ny;
+        if (gain > 15)
+        {
+            gain = 15;
+            max = -1;
+        }
+        one = 1 << (15 - gain);
+        // raw order is b0 b1 a1 b2 a2, see soft_eq_param()
+        s->b[0] = (int16_t)((v[0] + (1 << (5 + gain))) >> (6 + gain));
+        s->b[1] = (int16_t)((v[1] + (1 << (5 + gain))) >> (6 + gain));
+        s->b[2] = (int16_t)((v[3] + (1 << (5 + gain))) >> (6 + gain));
+        s->b[3] = 0;
+        s->a[0] = (int16_t)((v[2] + (1 << (5 + gain))) >> (6 + gain));
+        s->a[1] = (int16_t)((v[4] + (1 << (5 + gain))) >> (6 + gain));
+        s->gain = gain;
+        /*
+          FACC feeds back 16bit output, rounding noise is amplified by 1/A(z),
+          low frequency high Q stage would be far from CPU result, keep it on CPU.
+        */
+        a1 = s->a[0];
+        a2 = s->a[1];
+        den_dc = one - a1 - a2;
+        den_ny = one + a1 - a2;
+        if (max >= 0
+                && abs(a2) < one && abs(a1) < one - a2
+                && abs(den_dc) * SOFTEQ_FACC_MAX_NOISE_GAIN >= one
+                && abs(den_ny) * SOFTEQ_FACC_MAX_NOISE_GAIN >= one)
+        {
+            p->stage++;
+        }
+        else
+        {
+            p->cpu_st[p->cpu_stage] = g_eq_q[i];
+            p->cpu_stage++;
+        }
+    }
+    return p->stage ? 0 : -1;
+}
+
+static void soft_eq_facc_run_stage(int i, int blocking)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+    soft_eq_facc_stage_t *s = &p->st[i];
+    FACC_ConfigTypeDef cfg = {0};
+    uint32_t bytes = p->len * sizeof(int16_t);
+    int stage = p->stage;
+    int16_t *src, *dst;
+
+    // last stage always output to data_out
+    dst = ((stage - 1 - i) & 1) ? p->tmp : p->out;
+    if (i == 0)
+        src = p->in;
+    else
+        src = (dst == p->out) ? p->tmp : p->out;
+
+    cfg.mod_sel = 1;
+    cfg.gain = s->gain;
+    HAL_FACC_Config(&p->hfacc, &cfg);
+    HAL_FACC_SetCoeff(&p->hfacc, (uint8_t *)s->b, 3 * sizeof(int16_t), (uint8_t *)s->a, 2 * sizeof(int16_t), 0);
+    HAL_FACC_Buffer_Enable(&p->hfacc, s->state);
+    mpu_dcache_clean(src, bytes);
+    mpu_dcache_invalidate(dst, bytes);
+    if (blocking)
+        HAL_FACC_Start(&p->hfacc, (uint8_t *)src, (uint8_t *)dst, bytes);
+    else
+        HAL_FACC_Start_IT(&p->hfacc, (uint8_t *)src, (uint8_t *)dst, bytes);
+}
+
+static void soft_eq_facc_cplt(FACC_HandleTypeDef *facc)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+    UNUSED(facc);
+
+    p->cur++;
+    if (p->cur < p->stage)
+    {
+        soft_eq_facc_run_stage(p->cur, 0);
+        return;
+    }
+    mpu_dcache_invalidate(p->out, p->len * sizeof(int16_t));
+    p->busy = 0;
+    if (p->done)
+        p->done(p->user_data, p->out, p->len);
+    else
+        rt_sem_release(&p->sem);
+}
+
+void FACC1_IRQHandler(void)
+{
+    rt_interrupt_enter();
+    HAL_FACC_IRQHandler(&g_eq_facc.hfacc);
+    rt_interrupt_leave();
+}
+
+static int soft_eq_facc_open(int32_t *param, int stage, int max_len)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+    // FACC output length need 8 bytes aligned
+    uint32_t tmp_size = RT_ALIGN(max_len * sizeof(int16_t), 8);
+
+    if (soft_eq_facc_coeff(param, stage) != 0)
+    {
+        rt_kprintf("softeq: no stage fit FACC, using cpu\n");
+        return -1;
+    }
+    p->state_pool = rt_malloc(p->stage * SOFTEQ_FACC_STATE_SIZE);
+    p->tmp = rt_malloc(tmp_size + 8);
+    if (!p->state_pool || !p->tmp)
+        goto err;
+    memset(p->state_pool, 0, p->stage * SOFTEQ_FACC_STATE_SIZE);
+    for (int i = 0; i < p->stage; i++)
+    {
+        p->st[i].state = p->state_pool + i * SOFTEQ_FACC_STATE_SIZE;
+    }
+    mpu_dcache_clean(p->state_pool, p->stage * SOFTEQ_FACC_STATE_SIZE);
+    p->max_len = max_len;
+
+    p->hfacc.Instance = hwp_facc1;
+    p->hfacc.CpltCallback = soft_eq_facc_cplt;
+    p->hfacc.State = HAL_FACC_STATE_RESET;
+    HAL_RCC_EnableModule(RCC_MOD_FACC1);
+    if (HAL_FACC_Init(&p->hfacc) != HAL_OK)
+        goto err;
+    rt_sem_init(&p->sem, "softeq", 0, RT_IPC_FLAG_FIFO);
+    NVIC_EnableIRQ(FACC1_IRQn);
+    p->busy = 0;
+    p->ready = 1;
+    return 0;
+err:
+    if (p->state_pool)
+        rt_free(p->state_pool);
+    if (p->tmp)
+        rt_free(p->tmp);
+    p->state_pool = NULL;
+    p->tmp = NULL;
+    return -1;
+}
+
+static void soft_eq_facc_close(void)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+    if (!p->ready)
+        return;
+    while (p->busy)
+    {
+        rt_thread_mdelay(1);
+    }
+    NVIC_DisableIRQ(FACC1_IRQn);
+    HAL_FACC_DeInit(&p->hfacc);
+    rt_sem_detach(&p->sem);
+    rt_free(p->state_pool);
+    rt_free(p->tmp);
+    p->state_pool = NULL;
+    p->tmp = NULL;
+    p->ready = 0;
+}
+
+static int soft_eq_facc_start(int16_t *data_in, int16_t *data_out, int len, soft_eq_done_t done, void *user_data)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+    rt_base_t level;
+
+    // odd length would make FACC treat it as last block and drop state
+    RT_ASSERT(data_in != data_out && len <= p->max_len && (len & 1) == 0);
+    level = rt_hw_interrupt_disable();
+    if (!p->ready || p->busy)
+    {
+        rt_hw_interrupt_enable(level);
+        return -1;
+    }
+    p->busy = 1;
+    rt_hw_interrupt_enable(level);
+
+    if (p->cpu_stage)
+        soft_eq_q(data_in, data_out, len, p->cpu_st, p->cpu_stage);
+    p->in = data_in;
+    p->out = data_out;
+    p->len = len;
+    p->done = done;
+    p->user_data = user_data;
+    p->cur = 0;
+    soft_eq_facc_run_stage(0, 0);
+    return 0;
+}
+
+static int soft_eq_facc_process(int16_t *data_in, int16_t *data_out, int len)
+{
+    soft_eq_facc_t *p = &g_eq_facc;
+
+    if (rt_interrupt_get_nest())
+    {
+        // in interrupt, e.g. audio tx done, could not wait semaphore
+        rt_base_t level = rt_hw_interrupt_disable();
+        if (p->busy)
+        {
+            rt_hw_interrupt_enable(level);
+            return -1;
+        }
+        p->busy = 1;
+        rt_hw_interrupt_enable(level);
+        RT_ASSERT(data_in != data_out && len <= p->max_len && (len & 1) == 0);
+        if (p->cpu_stage)
+            soft_eq_q(data_in, data_out, len, p->cpu_st, p->cpu_stage);
+        p->in = data_in;
+        p->out = data_out;
+        p->len = len;
+        for (int i = 0; i < p->stage; i++)
+        {
+            soft_eq_facc_run_stage(i, 1);
+        }
+        mpu_dcache_invalidate(data_out, len * sizeof(int16_t));
+        p->busy = 0;
+        return 0;
+    }
+    if (soft_eq_facc_start(data_in, data_out, len, NULL, NULL) != 0)
+        return -1;
+    rt_sem_take(&p->sem, RT_WAITING_FOREVER);
+    return 0;
+}
+#endif /* SOFTEQ_USING_FACC */
+
+static int g_eq_stage;
+
+int soft_eq_open(int32_t *param, int stage, int max_len)
+{
+    soft_eq_close();
+    if (stage > SOFTEQ_PARAM_STAGE)
+        stage = SOFTEQ_PARAM_STAGE;
+    g_eq_stage = stage;
+    // all state is static, nothing allocated for cpu path
+    soft_eq_q_param(param, g_eq_q, stage);
+#if SOFTEQ_USING_FACC
+    if (stage > 0 && soft_eq_facc_open(param, stage, max_len) == 0)
+    {
+        rt_kprintf("softeq: stages FACC=%d cpu=%d\n", g_eq_facc.stage, g_eq_facc.cpu_stage);
+    }
+#endif
+    return 0;
+}
+
+void soft_eq_close(void)
+{
+#if SOFTEQ_USING_FACC
+    soft_eq_facc_close();
+#endif
+    g_eq_stage = 0;
+}
+
+int soft_eq_is_hw(void)
+{
+#if SOFTEQ_USING_FACC
+    return g_eq_facc.ready;
+#else
+    return 0;
+#endif
+}
+
+int soft_eq_process_async(int16_t *data_in, int16_t *data_out, int len, soft_eq_done_t done, void *user_data)
+{
+#if SOFTEQ_USING_FACC
+    if (g_eq_stage > 0)
+        return soft_eq_facc_start(data_in, data_out, len, done, user_data);
+#endif
+    return -1;
+}
+
+void soft_eq_process(int16_t *data_in, int16_t *data_out, int len)
+{
+    if (g_eq_stage <= 0)
+    {
+        memcpy(data_out, data_in, len * sizeof(int16_t));
+        return;
+    }
+#if SOFTEQ_USING_FACC
+    if (g_eq_facc.ready)
+    {
+        // cpu state only has cpu stages, skip this block if FACC is busy by async user
+        if (soft_eq_facc_process(data_in, data_out, len) != 0)
+            memcpy(data_out, data_in, len * sizeof(int16_t));
+        return;
+    }
+#endif
+    soft_eq_q(data_in, data_out, len, g_eq_q, g_eq_stage);
+}
+
+#ifdef RT_USING_FINSH
+/*
+  Regression of fixed point cascade against float soft_eq(), SNR of fixed output
+  taking float output as reference, and cpu cycles per sample of both.
+*/
+#ifndef SOFTEQ_TEST_LEN
+    #define SOFTEQ_TEST_LEN     800     //samples of one speaker tx block, TX_DMA_SIZE / 2 of audio server
+#endif
+#define SOFTEQ_TEST_SAMPLES     (SAMPLE_RATE * 2)
+
+static const int32_t softeq_test_param[SOFTEQ_PARAM_STAGE * SOFTEQ_PARAM] =
+{
+    2092371,   12612199,    4164961,    2072738,   14709203,
+    2097628,   12605565,    4171651,    2074165,   14702575,
+    2094955,   12629019,    4148197,    2053752,   14725661,
+    2080652,   12761629,    4015587,    1941629,   14852087,
+    2098833,   12897838,    3879378,    1805187,   14970349,
+    2169530,   12992160,    3785056,    1668271,   15036566,
+    2090754,   13443037,    3334179,    1402456,   15381158,
+    2296306,   14830802,    1946414,     628332,   15949730,
+    1948206,   15934672,     842544,     533697,   16392465,
+    1419993,   16460420,    1225627,     256146,   16289398,
+};
+
+/* sweep 100Hz - 7kHz plus white noise, about -6dBFS */
+static void softeq_test_signal(int16_t *buf, int len, uint32_t pos, uint32_t *seed)
+{
+    for (int i = 0; i < len; i++)
+    {
+        float t = (float)(pos + i) / SAMPLE_RATE;
+        float f = 100.0f + 3450.0f * t;
+        float v = 0.4f * sinf(2.0f * 3.14159265f * f * t);
+
+        *seed = *seed * 1664525 + 1013904223;
+        v += 0.05f * ((int32_t)*seed >> 16) / 32768.0f;
+        buf[i] = (int16_t)(v * 32767);
+    }
+}
+
+static int softeq_test(int argc, char **argv)
+{
+    int stage = argc > 1 ? atoi(argv[1]) : SOFTEQ_PARAM_STAGE;
+    int len = argc > 2 ? atoi(argv[2]) : SOFTEQ_TEST_LEN;
+    int16_t *in, *ref, *fix;
+    soft_eq_q_stage_t *st;
+    uint32_t seed = 1, pos, cycles_f = 0, cycles_q = 0, start;
+    float sig = 0, err = 0, max_err = 0;
+
+    if (stage <= 0 || stage > SOFTEQ_PARAM_STAGE || len <= 0)
+    {
+        rt_kprintf("softeq_test [stage(1-%d)] [block samples]\n", SOFTEQ_PARAM_STAGE);
+        return -1;
+    }
+    in = rt_malloc(len * sizeof(int16_t) * 3);
+    st = rt_malloc(sizeof(soft_eq_q_stage_t) * stage);
+    if (!in || !st)
+    {
+        rt_kprintf("softeq_test: no memory\n");
+        goto exit;
+    }
+    ref = in + len;
+    fix = ref + len;
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    soft_eq_param((int32_t *)softeq_test_param, g_eq_param_f);
+    memset(d0_array, 0, sizeof(d0_array));
+    memset(d1_array, 0, sizeof(d1_array));
+    soft_eq_q_param((int32_t *)softeq_test_param, st, stage);
+    for (pos = 0; pos + len <= SOFTEQ_TEST_SAMPLES; pos += len)
+    {
+        softeq_test_signal(in, len, pos, &seed);
+        start = HAL_DBG_DWT_GetCycles();
+        soft_eq_q(in, fix, len, st, stage);
+        cycles_q += HAL_DBG_DWT_GetCycles() - start;
+        start = HAL_DBG_DWT_GetCycles();
+        soft_eq(in, ref, len, g_eq_param_f, stage);
+        cycles_f += HAL_DBG_DWT_GetCycles() - start;
+        for (int i = 0; i < len; i++)
+        {
+            float d = (float)ref[i] - fix[i];
+            sig += (float)ref[i] * ref[i];
+            err += d * d;
+            if (fabsf(d) > max_err)
+                max_err = fabsf(d);
+        }
+    }
+    if (pos == 0)
+        goto exit;
+    rt_kprintf("softeq_test: stage %d, block %d, %d samples\n", stage, len, pos);
+    rt_kprintf("  SNR %d.%02d dB, max error %d LSB\n", (int)(10 * log10f(sig / (err + 1e-6f))),
+               (int)(1000 * log10f(sig / (err + 1e-6f))) % 100, (int)max_err);
+    rt_kprintf("  cycles/sample: fixed %d.%02d, float %d.%02d\n",
+               cycles_q / pos, cycles_q % pos * 100 / pos, cycles_f / pos, cycles_f % pos * 100 / pos);
+exit:
+    if (in)
+        rt_free(in);
+    if (st)
+        rt_free(st);
+    return 0;
+}
+MSH_CMD_EXPORT(softeq_test, compare fixed point soft EQ with float);
+#endif /* RT_USING_FINSH */
+#endif /* SOC_BF0_HCPU */
+
 // Test code in PC
 #if 0
 int16_t input_data[FRAME_LENGTH];
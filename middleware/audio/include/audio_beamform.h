@@ -0,0 +1,51 @@
+#ifndef AUDIO_BEAMFORM_H
+#define AUDIO_BEAMFORM_H
+
+#include <stdint.h>
+
+/*
+  Delay-and-sum beamformer for small mic arrays.
+  Each mic is delayed by integer samples plus a fractional part done by a short
+  windowed sinc FIR, then weighted and summed to one channel.
+*/
+#define AUDIO_BF_MAX_MICS           3
+#define AUDIO_BF_TAPS               8   //fractional delay filter length, must be even
+#define AUDIO_BF_MAX_DELAY          16  //samples, about 340mm aperture at 16k
+
+typedef struct
+{
+    int16_t x_mm;
+    int16_t y_mm;
+} audio_bf_mic_t;
+
+typedef struct
+{
+    uint32_t        samplerate;
+    uint8_t         mic_num;
+    int16_t         steer_deg;                  //azimuth of look direction, 0 along +x, 90 along +y
+    uint16_t        weight[AUDIO_BF_MAX_MICS];  //Q15, 0 for equal weight 1/mic_num
+    audio_bf_mic_t  mic[AUDIO_BF_MAX_MICS];
+} audio_bf_config_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t cycles_avg;    //cycles per frame
+    uint32_t cycles_max;
+} audio_bf_stat_t;
+
+typedef struct audio_bf audio_bf_t;
+
+/*frame_samples: samples of one channel in one audio_bf_process() call*/
+audio_bf_t *audio_bf_create(const audio_bf_config_t *cfg, uint16_t frame_samples);
+void audio_bf_destroy(audio_bf_t *bf);
+/*change look direction, delay filters are recalculated*/
+int audio_bf_steer(audio_bf_t *bf, int16_t steer_deg);
+/*
+  in[i]: frame of mic i, stride[i] samples between two samples of it, e.g. 2 for left of stereo.
+  out: beam output, frame_samples, could be same as one of in[] if its stride is 1.
+*/
+void audio_bf_process(audio_bf_t *bf, const int16_t *const in[], const uint8_t stride[], int16_t *out);
+void audio_bf_get_stat(audio_bf_t *bf, audio_bf_stat_t *stat, uint8_t reset);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef AUDIO_FREQSHIFT_H
+#define AUDIO_FREQSHIFT_H
+
+#include <stdint.h>
+
+/*
+  Frequency shifter for howling suppression, shifts whole spectrum by shift_hz
+  with hilbert transform and complex mixer.
+*/
+
+/*float reference, len up to 120 samples, first is 1 on first call of a stream, return next phase_acc*/
+float freq_shift(int16_t *data_in, int16_t *data_out, int len, float phase_acc, int first);
+
+/*fixed point version, reset state of stream*/
+void freq_shift_open(int shift_hz, int samplerate);
+/*any len, data_out could be data_in*/
+void freq_shift_process(int16_t *data_in, int16_t *data_out, int len);
+
+#endif
@@ -58,4 +58,15 @@ int mp3ctrl_seek(mp3ctrl_handle handle, off_t frame_offset);
 int mp3ctrl_getinfo(const char *filename, mp3_info_t *info);
 int mp3_get_id3_start(const char *filename, mp3_id3_info_t *info);
 void mp3_get_id3_end(mp3_id3_info_t *info);
+
+/*
+    callback of mp3_id3_scan_dir, info is freed after return, copy what is needed.
+    return non-zero to stop scan.
+*/
+typedef int (*mp3_id3_scan_cb_t)(const char *filename, mp3_id3_info_t *info, void *user_data);
+/*
+    get id3 of all mp3 files in dir, thread sleeps a while every MP3_ID3_SCAN_SLICE_MS.
+    return files scanned, -1 if dir error
+*/
+int mp3_id3_scan_dir(const char *dir, mp3_id3_scan_cb_t cb, void *user_data);
 #endif
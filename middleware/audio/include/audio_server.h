@@ -159,8 +159,39 @@ audio_client_t audio_open2(audio_type_t audio_type, audio_rwflag_t rwflag, audio
   */
 int audio_write(audio_client_t handle, uint8_t *data, uint32_t data_len);
 
+/**
+  * @brief  get cache space to put pcm data in place, e.g. decoder output, then publish it by audio_write_commit()
+  * @param  handle value return by audio_open
+  * @param  buf return write position in cache
+  * @param  space return free bytes of cache, could be NULL
+  * @retval int
+  *          -2: invalid parameter
+  *          -1: the output for this type of audio was suspended by highest priority audio
+  *          >=0: contiguous bytes at buf, less than free bytes if cache wraps around
+  */
+int audio_write_get_buf(audio_client_t handle, uint8_t **buf, uint32_t *space);
+
+/**
+  * @brief  publish data put at position got by audio_write_get_buf()
+  * @param  handle value return by audio_open
+  * @param  data_len bytes put, not more than contiguous bytes got
+  * @retval int bytes committed, or -2 on invalid parameter
+  */
+int audio_write_commit(audio_client_t handle, uint32_t data_len);
+
 int audio_read(audio_client_t handle, uint8_t *buf, uint32_t buf_size);
 
+/**
+  * @brief  audio client control
+  * @param  handle audio client handle
+  * @param  cmd
+  *          0: factory loopback, parameter is gain
+  *          1: get cached data time, parameter is uint32_t * in ms
+  *          2: check fade out end, return 0 if ended
+  *          3: set software mix gain, parameter is Q15 gain(0~0x7FFF), only used if AUDIO_TX_SOFTWARE_MIX
+  *         -1: start fade out
+  * @retval int 0 if ok, others if failed
+  */
 int audio_ioctl(audio_client_t handle, int cmd, void *parameter);
 
 int audio_close(audio_client_t handle);
@@ -275,5 +306,37 @@ uint8_t get_server_current_play_status(void);
 uint8_t get_eq_config(audio_type_t type);
 void audio_3a_set_bypass(uint8_t is_bypass, uint8_t mic, uint8_t down);
 
+#ifdef AUDIO_UI_SOUND
+/**
+  * @brief  register PCM of ui sound, e.g. key click, kept in RAM and mixed into speaker output directly
+  * @param  pcm interleaved 16 bits PCM, must be kept until unregistered
+  * @param  samples samples per channel
+  * @param  samplerate sample rate of pcm, converted to speaker sample rate in mixing
+  * @param  channels 1 or 2
+  * @retval int sound id > 0, or -1 if no free slot, -2 on invalid parameter
+  */
+int audio_ui_sound_register(const int16_t *pcm, uint32_t samples, uint32_t samplerate, uint8_t channels);
+/**
+  * @brief  load 16 bits PCM wav file into RAM and register it
+  * @retval int sound id > 0, or < 0 if failed
+  */
+int audio_ui_sound_load(const char *path);
+void audio_ui_sound_unregister(int id);
+/**
+  * @brief  play ui sound, could be called in any thread or interrupt.
+  *         It's mixed in next speaker DMA buffer if speaker is running,
+  *         otherwise speaker is opened with short DMA period and kept for a while.
+  * @param  id sound id
+  * @param  gain Q15 gain, 0x7FFF for unity
+  * @retval int 0 if ok, -2 on invalid parameter
+  */
+int audio_ui_sound_play(int id, uint16_t gain);
+void audio_ui_sound_stop_all(void);
+
+/* for audio server */
+uint32_t audio_ui_sound_mix(int16_t *buf, uint32_t samples, uint32_t samplerate, uint8_t channels);
+int audio_ui_sound_is_client(audio_server_callback_func callback);
+#endif /* AUDIO_UI_SOUND */
+
 #endif
 
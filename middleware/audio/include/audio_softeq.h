@@ -0,0 +1,43 @@
+#ifndef AUDIO_SOFTEQ_H
+#define AUDIO_SOFTEQ_H
+
+#include <stdint.h>
+
+/*
+  param: SOFTEQ_PARAM_STAGE x 5 Q23 biquad coefficients, same format as audprc EQ.
+  After soft_eq_open(), soft_eq_process() runs the cascade on FACC if the chip has it
+  and the coefficients fit, otherwise on CPU.
+*/
+typedef void (*soft_eq_done_t)(void *user_data, int16_t *data_out, int len);
+
+/*max_len: max samples of one soft_eq_process() call, should be tx dma size of audio server*/
+int soft_eq_open(int32_t *param, int stage, int max_len);
+void soft_eq_close(void);
+/*data_in may be changed, data_out must not be data_in*/
+void soft_eq_process(int16_t *data_in, int16_t *data_out, int len);
+/*1 if cascade running on FACC*/
+int soft_eq_is_hw(void);
+/*
+  async FACC process, done is called in interrupt.
+  caller double buffers: fill next block while this one is processing.
+  return -1 if FACC not used or busy, caller should use soft_eq_process()
+*/
+int soft_eq_process_async(int16_t *data_in, int16_t *data_out, int len, soft_eq_done_t done, void *user_data);
+
+/*float reference implementation*/
+void soft_eq(int16_t *data_in, int16_t *data_out, int len, float *param, int stage);
+void soft_eq_param(int32_t *param, float *param_f);
+
+/*fixed point cpu implementation used by soft_eq_process(), one biquad stage*/
+typedef struct
+{
+    int32_t c[5];                   //b0 b1 b2 a1 a2, Q21
+    int32_t x1, x2, y1, y2;         //Q27
+} soft_eq_q_stage_t;
+
+/*convert stage x 5 raw Q23 coefficients and clear state*/
+void soft_eq_q_param(int32_t *param, soft_eq_q_stage_t *st, int stage);
+/*data_out could be data_in*/
+void soft_eq_q(int16_t *data_in, int16_t *data_out, int len, soft_eq_q_stage_t *st, int stage);
+
+#endif
@@ -1,24 +1,41 @@
 #ifndef SIFLI_RESAMPLE
 #define SIFLI_RESAMPLE 1
 
+/*polyphase filter: taps per phase and number of phases*/
+#define SIFLI_RESAMPLE_TAPS         8
+#define SIFLI_RESAMPLE_PHASES       64
+#define SIFLI_RESAMPLE_MAX_CHANNELS 2
+
 typedef struct
 {
     float    ratio;
     int16_t *dst;
     uint32_t dst_size;
     uint32_t dst_bytes;
-    uint32_t total_src_index;
-    uint32_t total_dst_index;
     uint32_t src_samplerate;
     uint32_t dst_samplerate;
-    int16_t  last_left;
-    int16_t  last_right;
+    int32_t  pos_int;   //integer part of next output position, in input frames relative to current packet
+    uint32_t pos_num;   //fraction part of next output position, in 1/dst_samplerate
+    int16_t *coef;      //Q15, SIFLI_RESAMPLE_PHASES x SIFLI_RESAMPLE_TAPS
+    int16_t  hist[(SIFLI_RESAMPLE_TAPS - 1) * SIFLI_RESAMPLE_MAX_CHANNELS];
+    int16_t  edge[(SIFLI_RESAMPLE_TAPS * 2) * SIFLI_RESAMPLE_MAX_CHANNELS];
     uint8_t  channels;
 } sifli_resample_t;
 
 uint32_t sifli_resample_process(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet);
 sifli_resample_t *sifli_resample_open(uint8_t channels, uint32_t src_samplerate, uint32_t dst_samplerate);
+/*max_src_bytes: max src_bytes of sifli_resample_process(), output buffer is allocated once for it*/
+sifli_resample_t *sifli_resample_open_ex(uint8_t channels, uint32_t src_samplerate, uint32_t dst_samplerate, uint32_t max_src_bytes);
 int16_t *sifli_resample_get_output(sifli_resample_t *p);
+/*worst case output bytes of src_bytes input*/
+uint32_t sifli_resample_max_output(sifli_resample_t *p, uint32_t src_bytes, uint8_t dup_mono);
+/*
+    same as sifli_resample_process(), but output is put at dst, e.g. in place in audio cache, instead of internal buffer.
+    dup_mono: mono input is written as stereo in the filter loop.
+    return output bytes, 0 if dst_size is less than sifli_resample_max_output().
+*/
+uint32_t sifli_resample_process_to(sifli_resample_t *p, int16_t *src, uint32_t src_bytes, uint8_t is_last_packet,
+                                   int16_t *dst, uint32_t dst_size, uint8_t dup_mono);
 void sifli_resample_close(sifli_resample_t *p);
 
 #endif
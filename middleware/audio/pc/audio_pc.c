@@ -267,6 +267,22 @@ int audio_write(audio_client_t handle, uint8_t *data, uint32_t data_len)
 }
 #endif
 
+/*No cache on PC, data put in place is written by audio_write_commit()*/
+static uint8_t pc_write_buf[8192];
+
+int audio_write_get_buf(audio_client_t handle, uint8_t **buf, uint32_t *space)
+{
+    *buf = pc_write_buf;
+    if (space)
+        *space = sizeof(pc_write_buf);
+    return sizeof(pc_write_buf);
+}
+
+int audio_write_commit(audio_client_t handle, uint32_t data_len)
+{
+    return audio_write(handle, pc_write_buf, data_len);
+}
+
 int audio_read(audio_client_t handle, uint8_t *buf, uint32_t buf_size)
 {
     return 0;
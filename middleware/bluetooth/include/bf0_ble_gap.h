@@ -186,6 +186,8 @@ enum ble_gap_event_t
     BLE_GAP_PERIODIC_ADV_SYNC_CREATED_IND,   /**< This event indicates periodic advertising sync created. */
     BLE_GAP_PERIODIC_ADV_SYNC_STOPPED_IND,   /**< This event indicates periodic advertising sync stopped. */
     BLE_GAP_PERIODIC_ADV_SYNC_ESTABLISHED_IND, /**< This event indicates periodic advertising sync established. */
+    BLE_GAP_EXT_ADV_REPORT_BATCH_IND,        /**< This event indicates advertising reports passed scan filter, delivered
+                                                  in batch, see ble_gap_scan_set_filter(). */
 };
 
 /**
@@ -2026,6 +2028,58 @@ typedef struct
     uint8_t data[__ARRAY_EMPTY];
 } ble_gap_ext_adv_report_ind_t;
 
+/**
+ * @brief The structure of #BLE_GAP_EXT_ADV_REPORT_BATCH_IND.
+ */
+typedef struct
+{
+    /// Number of reports
+    uint16_t count;
+    /// Length of data
+    uint16_t length;
+    /// Reports in #ble_gap_ext_adv_report_ind_t, each one is 4 bytes aligned, see #BLE_GAP_ADV_REPORT_NEXT
+    uint8_t data[__ARRAY_EMPTY];
+} ble_gap_ext_adv_report_batch_ind_t;
+
+/// Report following report r in #ble_gap_ext_adv_report_batch_ind_t
+#define BLE_GAP_ADV_REPORT_NEXT(r) \
+    ((ble_gap_ext_adv_report_ind_t *)((uint8_t *)(r) + RT_ALIGN(sizeof(ble_gap_ext_adv_report_ind_t) + (r)->length, 4)))
+
+/**
+ * @brief Scan filter parameter of ble_gap_scan_set_filter().
+ */
+typedef struct
+{
+    /// UUID length, 2, 4 or 16. 0 means no UUID filter
+    uint8_t uuid_len;
+    /// UUID in little endian, matched with service UUID lists and service data
+    uint8_t uuid[ATT_UUID_128_LEN];
+    /// Whether to match company identifier of manufacturer specific data
+    uint8_t manu_id_en;
+    /// Company identifier
+    uint16_t manu_id;
+    /// Reports with lower RSSI are dropped, -127 to let all pass
+    int8_t rssi_min;
+    /// Report with same address and data is dropped within this time in ms, 0 means no duplicate suppression
+    uint16_t dup_timeout_ms;
+    /// Matching reports are delivered in #BLE_GAP_EXT_ADV_REPORT_BATCH_IND at most this time in ms after received,
+    /// 0 means delivered at once in #BLE_GAP_EXT_ADV_REPORT_IND
+    uint16_t batch_ms;
+} ble_gap_scan_filter_t;
+
+/**
+ * @brief Statistics of scan filter.
+ */
+typedef struct
+{
+    uint32_t received;       /**< Reports received from BLE subsystem. */
+    uint32_t rssi_dropped;   /**< Reports dropped by RSSI. */
+    uint32_t miss_dropped;   /**< Reports dropped by UUID or manufacturer ID. */
+    uint32_t dup_dropped;    /**< Reports dropped as duplicate. */
+    uint32_t delivered;      /**< Reports delivered to application. */
+    uint32_t batches;        /**< #BLE_GAP_EXT_ADV_REPORT_BATCH_IND delivered. */
+} ble_gap_scan_filter_stat_t;
+
 /**
  * @ Indicate rssi and channel assesement of connected link . The structure of #BT_DBG_RSSI_NOTIFY_IND
  */
@@ -2221,6 +2275,23 @@ uint8_t ble_gap_scan_start(ble_gap_scan_start_t *scan_param);
  */
 uint8_t ble_gap_scan_stop(void);
 
+/**
+ * @brief Set scan filter. Advertising reports are checked against it before published, so application
+   is not woken by reports it would drop. Periodic advertising reports are not filtered.
+   Reports matching all conditions are delivered as #BLE_GAP_EXT_ADV_REPORT_IND, or in
+   #BLE_GAP_EXT_ADV_REPORT_BATCH_IND if batch_ms is set.
+   @param[in] filter Filter parameters, NULL to remove filter.
+   @retval The status of setting filter.
+ */
+uint8_t ble_gap_scan_set_filter(const ble_gap_scan_filter_t *filter);
+
+/**
+ * @brief Get statistics of scan filter.
+   @param[out] stat Statistics.
+   @param[in] reset Clear statistics after read.
+ */
+void ble_gap_scan_get_filter_stat(ble_gap_scan_filter_stat_t *stat, uint8_t reset);
+
 
 /**
  * @brief Start connect peer device. The event #BLE_GAP_CREATE_CONNECTION_CNF will indicate connect operation result. #BLE_GAP_CONNECTED_IND will indicate
@@ -529,6 +529,16 @@ int sibles_set_value(uint8_t conn_idx, sibles_value_t *value);
   */
 int sibles_write_value(uint8_t conn_idx, sibles_value_t *value);
 
+/**
+  * @brief  Send several new service attributes to remote using gatt notify.
+  * TX packets for all values are reserved at once and messages are handed to BLE stack together.
+  * @param[in]  conn_idx Connection index for the service.
+  * @param[in]  values Attribute content buffers.
+  * @param[in]  num Number of values, at most SIBLES_MAX_BATCH_VALUES are sent.
+  * @retval Number of values sent from the beginning of values, the rest has no TX packet, -1 if conn_idx is invalid.
+  */
+int sibles_write_values(uint8_t conn_idx, sibles_value_t *values, uint8_t num);
+
 /**
   * @brief  Send new service attribute to remote using gatt indicate.
   * @param[in]  conn_idx Connection index for the service.
@@ -166,6 +166,20 @@ typedef struct
 } ble_serial_close_t;
 
 
+/**
+ * @brief Throughput counters of serial transmission.
+ */
+typedef struct
+{
+    uint32_t tx_bytes;      /**< Notification bytes sent, including packet header. */
+    uint32_t tx_packets;    /**< Notifications sent. */
+    uint32_t tx_ms;         /**< Time spent in ble_serial_tran_send_data(), tx_bytes / tx_ms is kB/s as example/ble/throughput. */
+    uint32_t credit_waits;  /**< Times sender waited for a TX credit. */
+    uint32_t tx_fails;      /**< Notifications given up. */
+    uint32_t rx_bytes;      /**< Bytes written by remote, including packet header. */
+    uint32_t rx_packets;    /**< Writes by remote. */
+} ble_serial_tran_stats_t;
+
 /**
  * @brief The structure of transmission export.
  */
@@ -175,6 +189,22 @@ typedef struct
     uint8_t cate_id;                                       /**< CategoryID. */
 } ble_serial_tran_export_t;
 
+/**
+ * @brief Context of data sent in pieces, see ble_serial_tran_stream_begin().
+ */
+typedef struct
+{
+    uint8_t handle;         /**< Handle for the transmission channel. */
+    uint8_t failed;         /**< Sending failed, following writes are rejected. */
+    uint16_t total;         /**< Data length announced in first packet. */
+    uint16_t offset;        /**< Data length sent. */
+    uint16_t fill;          /**< Data length in packet being filled. */
+    uint16_t cap;           /**< Data capacity of packet being filled. */
+    uint16_t frag_len;      /**< Data capacity of continue packet. */
+    uint8_t *packet;        /**< One packet of MTU size. */
+    uint32_t tick;          /**< Start tick. */
+} ble_serial_tran_stream_t;
+
 
 
 #if defined(_MSC_VER)
@@ -229,6 +259,57 @@ int rt_ble_serial_dev_register(const char *name);
 
 int ble_serial_tran_send_data_advance(uint8_t handle, uint8_t *data, uint16_t data_len);
 
+/**
+ * @brief Start to send data of known length in pieces.
+ *
+ * Data is packed in the same format as ble_serial_tran_send_data(), but only one packet
+ * of MTU size is buffered, so a large message can be produced in place, e.g. by an encoder,
+ * without holding all of it in RAM.
+ * @param[out] stream stream context.
+ * @param[in] handle handle for the transmission channel.
+ * @param[in] cate_id categoryID.
+ * @param[in] total total data length, must be exactly written by ble_serial_tran_stream_write().
+ * @retval result 0 is successful, others are failed.
+ */
+int ble_serial_tran_stream_begin(ble_serial_tran_stream_t *stream, uint8_t handle, uint8_t cate_id, uint16_t total);
+
+/**
+ * @brief Append data to stream, a packet is sent once it is full.
+ * @param[in] stream stream context.
+ * @param[in] data data.
+ * @param[in] len data length.
+ * @retval result 0 is successful, others are failed.
+ */
+int ble_serial_tran_stream_write(ble_serial_tran_stream_t *stream, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Finish stream and free packet buffer, must be called if ble_serial_tran_stream_begin() succeeded.
+ * @param[in] stream stream context.
+ * @retval result total length if all data is sent, others are failed.
+ */
+int ble_serial_tran_stream_end(ble_serial_tran_stream_t *stream);
+
+/**
+ * @brief Enable high throughput mode, default on if BLE_SERIAL_TRAN_HIGH_THROUGHPUT is defined.
+ *
+ * When a link connects, MTU, data length and 2M PHY are negotiated, and continue fragments
+ * are filled up to MTU. Sending always keeps all TX credits in flight and waits for credit
+ * returned by remote instead of a fixed delay.
+ * @param[in] enable 1 to enable.
+ */
+void ble_serial_tran_set_high_throughput(uint8_t enable);
+
+/**
+ * @brief Get throughput counters.
+ * @param[out] stats counters.
+ */
+void ble_serial_tran_get_stats(ble_serial_tran_stats_t *stats);
+
+/**
+ * @brief Reset throughput counters.
+ */
+void ble_serial_tran_reset_stats(void);
+
 /**
 * @}
 */
@@ -61,12 +61,25 @@
 #define MAX_IOS_DATA_LEN 10*1024
 
 #define WF_VERSION 3
+/* Version reported when sliding window is used, START_RSP carries window size */
+#define WF_WINDOW_VERSION 4
 #define MAX_UPDATE_REPEAT 3
 
 #define WATCHFACE_SYNC_TIMEOUT 12000
 #define MD5_LEN 32
 #define WF_SEM_WAIT_TIME 2000
 
+/*
+ * Max blocks in flight in sliding window mode, 0 to always use stop-and-wait.
+ * Used only if phone asks for it in START_REQ. Only out of order blocks are buffered,
+ * their RAM is allocated on arrival and freed once block is acked by app.
+ */
+#ifndef BLE_WATCHFACE_WINDOW
+    #define BLE_WATCHFACE_WINDOW 8
+#endif
+/* Limited by bitmap in SEND_DATA_RSP */
+#define BLE_WATCHFACE_WINDOW_MAX 32
+
 typedef enum
 {
     WATCHFACE_FILE_TYPE_WATCHFACE,
@@ -108,6 +121,20 @@ typedef struct
     uint32_t last_index;
 } watchface_sync_t;
 
+typedef struct
+{
+    uint8_t size;           /* negotiated window, 0 for stop-and-wait */
+    uint8_t busy;           /* block next is given to app and not acked yet */
+    uint8_t in_callback;
+    uint8_t ack;            /* SEND_DATA_RSP to be sent */
+    uint32_t next;          /* blocks before it are all acked by app */
+    uint32_t map;           /* bit n set: block next + n is received */
+    uint8_t *buf[BLE_WATCHFACE_WINDOW_MAX];
+    uint16_t len[BLE_WATCHFACE_WINDOW_MAX];
+    rt_tick_t start_tick;
+    rt_mutex_t lock;
+} watchface_window_t;
+
 typedef struct
 {
     uint8_t is_open;
@@ -132,6 +159,7 @@ typedef struct
     uint32_t total_size;
 
     watchface_sync_t sync;
+    watchface_window_t win;
     watchface_callback callback;
 
     rt_sem_t sem;
@@ -756,6 +756,75 @@ void connection_parameter_get_high_performance(uint16_t *interval_min, uint16_t
 void connection_parameter_get_balance(uint16_t *interval_min, uint16_t *interval_max, uint16_t *latency, uint16_t *timeout);
 void connection_parameter_get_low_power(uint16_t *interval_min, uint16_t *interval_max, uint16_t *latency, uint16_t *timeout);
 
+#ifdef BLE_CM_ADAPTIVE_PARAM
+/*
+ * Adaptive connection parameter policy. GATT traffic of each link is sampled every
+ * BLE_CM_POLICY_PERIOD_MS, link steps up to a faster level at once when traffic rises or
+ * TX credits run out, and steps down only after BLE_CM_POLICY_DOWN_PERIODS quiet periods.
+ * Level requested by connection_manager_update_parameter() is taken as current level.
+ */
+#ifndef BLE_CM_POLICY_PERIOD_MS
+    #define BLE_CM_POLICY_PERIOD_MS     1000
+#endif
+/* Bytes per second to enter high performance, leave it below half of it */
+#ifndef BLE_CM_POLICY_HIGH_BPS
+    #define BLE_CM_POLICY_HIGH_BPS      2000
+#endif
+/* Bytes per second to enter balanced, leave it below half of it */
+#ifndef BLE_CM_POLICY_LOW_BPS
+    #define BLE_CM_POLICY_LOW_BPS       100
+#endif
+#ifndef BLE_CM_POLICY_DOWN_PERIODS
+    #define BLE_CM_POLICY_DOWN_PERIODS  5
+#endif
+/* Radio time of one connection event without data, for duty cycle estimation */
+#ifndef BLE_CM_POLICY_EVENT_US
+    #define BLE_CM_POLICY_EVENT_US      500
+#endif
+
+typedef struct
+{
+    uint32_t time_ms[3];    /**< Time in high performance, balanced and low power level. */
+    uint32_t bytes[3];      /**< GATT bytes sent and received in each level. */
+    uint32_t switches;      /**< Level changes made by policy. */
+    uint8_t level;          /**< Current level, @see connection_manager_update_conneciton. */
+} connection_manager_policy_stats_t;
+
+/**
+ * @brief Report GATT traffic of a link to policy, called by sibles.
+ * @param[conn_idx] connection index.
+ * @param[tx_len] bytes sent.
+ * @param[rx_len] bytes received.
+ * @param[stall] 1 if send failed for no TX credit.
+ */
+void connection_manager_policy_report(uint8_t conn_idx, uint16_t tx_len, uint16_t rx_len, uint8_t stall);
+
+/**
+ * @brief Keep link at given level or faster until released, e.g. during a transfer.
+ * Holds are counted, each hold shall be released once.
+ * @param[conn_idx] connection index.
+ * @param[interval_level] CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE to _LOW_POWER.
+ * @return CM_STATUS_OK if set success, @see connection_manager_status
+ */
+uint8_t connection_manager_policy_hold(uint8_t conn_idx, uint8_t interval_level);
+
+/**
+ * @brief Release a hold made by connection_manager_policy_hold().
+ */
+uint8_t connection_manager_policy_release(uint8_t conn_idx, uint8_t interval_level);
+
+/**
+ * @brief Enable or disable automatic level change of all links, enabled by default.
+ */
+void connection_manager_policy_enable(uint8_t enable);
+
+/**
+ * @brief Get time, bytes and level of a link since connected.
+ * @return CM_STATUS_OK if get success, @see connection_manager_status
+ */
+uint8_t connection_manager_policy_get_stats(uint8_t conn_idx, connection_manager_policy_stats_t *stats);
+#endif // BLE_CM_ADAPTIVE_PARAM
+
 //extern uint8_t ble_gap_aes_h6(uint8_t *w, uint8_t *key_id, uint32_t cb_request);
 //extern uint8_t ble_gap_aes_h7(uint8_t *salt, uint8_t *w, uint32_t metainfo);
 #endif
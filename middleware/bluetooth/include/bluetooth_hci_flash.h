@@ -70,12 +70,46 @@
         #define BT_HCI_DEFAULT_FLUSH_SIZE (64 * 1024)
         #define BT_HCI_INVALID_FLUSH_SIZE (0xFFFFFFFF)
 
+        /* RAM ring in front of file, power of 2. 0 to write file in BT thread directly */
+        #ifndef BT_HCI_RING_SIZE
+            #define BT_HCI_RING_SIZE (16*1024)
+        #endif
+
+        /* Max captured bytes of one packet, longer packet is truncated */
+        #ifndef BT_HCI_SNAPLEN
+            #define BT_HCI_SNAPLEN (1024)
+        #endif
+
+        #ifndef BT_HCI_DRAIN_PRIORITY
+            #define BT_HCI_DRAIN_PRIORITY (RT_THREAD_PRIORITY_LOW)
+        #endif
+
+        #ifndef BT_HCI_DRAIN_STACK_SIZE
+            #define BT_HCI_DRAIN_STACK_SIZE (2048)
+        #endif
+
+        #ifndef BT_HCI_DRAIN_PERIOD_MS
+            #define BT_HCI_DRAIN_PERIOD_MS (1000)
+        #endif
+
+        /* Written by bt_hci_trace_snapshot() in BT_HCI_PATH */
+        #ifndef BT_HCI_SNAP_NAME
+            #define BT_HCI_SNAP_NAME "hci_snap.btsnoop"
+        #endif
+
 
         int bt_hci_log_path_get(char *path);
         int bt_hci_log_onoff(int flag);
         int bt_hci_log_type_get(void);
         int bt_hci_log_clear(void);
 
+        /**
+         * @brief Save captured HCI packets before an error to BT_HCI_SNAP_NAME in btsnoop format.
+         *        Capture is paused until snapshot is written. Safe to call from ISR.
+         *        On assert capture stops and ring is kept in RAM as g_bt_hci_ring.
+         */
+        void bt_hci_trace_snapshot(void);
+
 
 
         #if defined(RT_USING_DFS) || defined(USING_FILE_LOGGER)
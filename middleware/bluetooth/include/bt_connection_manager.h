@@ -150,6 +150,13 @@ typedef struct
     uint8_t sub_state;
     uint8_t sniff_changing;
     //uint8_t rmt_smc;//1:remote device indicate encryption change;
+#ifdef BT_CM_RECONN_CACHE
+    rt_tick_t start_tick;       // Reconnect requested or ACL opened
+    uint32_t fast_profiles;     // Profiles started together from reconnect cache
+    uint16_t av_conn_id;
+    uint8_t fast;               // Profiles are started by cache instead of one by one
+    uint8_t audio_ready;
+#endif
 } bt_cm_conned_dev_t;
 
 typedef struct
@@ -159,6 +166,26 @@ typedef struct
     uint8_t g_bt_cm_last_bond_idx;
 } bt_cm_bonded_dev_t;
 
+#ifdef BT_CM_RECONN_CACHE
+#ifndef BT_CM_RECONN_CACHE_NUM
+    #define BT_CM_RECONN_CACHE_NUM BT_CM_MAX_BOND
+#endif
+#define BT_CM_CODEC_INFO_LEN 6
+
+// What was learnt about a peer on last connection, so reconnect could skip probing profiles one by one
+typedef struct
+{
+    BTS2S_BD_ADDR bd_addr;
+    uint32_t profiles;          // Profiles accepted by peer
+    uint32_t failed;            // Profiles rejected by peer, not started on fast reconnect
+    uint16_t time_to_audio;     // ms from reconnect to first audio profile connected
+    uint8_t valid;
+    uint8_t codec;              // A2DP codec type of last stream configuration
+    uint8_t codec_len;
+    uint8_t codec_info[BT_CM_CODEC_INFO_LEN];
+} bt_cm_peer_cache_t;
+#endif
+
 // Added reconnect flag and addr
 typedef struct
 {
@@ -192,5 +219,9 @@ void bt_cm_change_inquiryscan_activity(uint8_t is_high);
 uint8_t bt_cm_find_conn_index_by_addr(uint8_t *addr);
 uint8_t bt_cm_find_addr_by_conn_index(uint8_t idx, BTS2S_BD_ADDR *addr);
 void bt_cm_add_bonded_dev(bt_cm_conn_info_t *dev, uint8_t force);
+#ifdef BT_CM_RECONN_CACHE
+bt_cm_peer_cache_t *bt_cm_get_peer_cache(BTS2S_BD_ADDR *bd_addr);
+void bt_cm_clear_peer_cache(BTS2S_BD_ADDR *bd_addr);
+#endif
 #endif // BSP_BT_CONNECTION_MANAGER
 #endif // _BT_CONNECTION_MANAGER_H_
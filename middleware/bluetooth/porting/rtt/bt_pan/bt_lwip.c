@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-08-14     tyx          the first version
+ * 2026-10-14     SiFli        reference received frames and gather sent chains without copy
  */
 
 #include <rthw.h>
@@ -20,6 +21,7 @@
 
 #include "rtdef.h"
 #include "bts2_bt.h"
+#include "bts2_mem.h"
 
 
 
@@ -27,6 +29,10 @@
 #ifdef RT_USING_LWIP
 #include <netif/ethernetif.h>
 #include <lwip/netifapi.h>
+#include <lwip/memp.h>
+#ifdef USING_CPU_USAGE_PROFILER
+    #include "cpu_usage_profiler.h"
+#endif
 #ifdef LWIP_USING_DHCPD
     #include <dhcp_server.h>
 #endif
@@ -48,6 +54,35 @@ struct bt_lwip_prot_des
     rt_int8_t connected_flag;
 };
 
+struct bt_lwip_stat
+{
+    rt_uint32_t rx_frames;
+    rt_uint32_t rx_bytes;
+    rt_uint32_t rx_ref;         /* frames given to lwIP in BT buffer */
+    rt_uint32_t rx_copy;        /* frames copied to pbuf */
+    rt_uint32_t rx_drop;
+    rt_uint32_t tx_frames;
+    rt_uint32_t tx_bytes;
+};
+
+static struct bt_lwip_stat bt_lwip_stat;
+
+#if LWIP_SUPPORT_CUSTOM_PBUF
+/* Frames referenced by lwIP at the same time, e.g. in TCP out of sequence queue,
+ * received frames are copied to pbuf if all are used. */
+#ifndef BT_LWIP_RX_REF_NUM
+    #define BT_LWIP_RX_REF_NUM    (8)
+#endif
+
+struct bt_lwip_rx_pbuf
+{
+    struct pbuf_custom p;
+    void *buff;                 /* frame allocated by BT stack */
+};
+
+LWIP_MEMPOOL_DECLARE(BT_LWIP_RX, BT_LWIP_RX_REF_NUM, sizeof(struct bt_lwip_rx_pbuf), "BT PAN RX");
+#endif
+
 extern BTS2S_ETHER_ADDR   bts2_local_ether_addr;
 
 
@@ -195,9 +230,13 @@ static rt_err_t rt_bt_lwip_protocol_recv(struct rt_bt_pan_instance *bt_instance,
 
     /*copy data dat -> pbuf*/
     pbuf_take(p, buff, len);
+    bt_lwip_stat.rx_frames++;
+    bt_lwip_stat.rx_bytes += len;
+    bt_lwip_stat.rx_copy++;
     if ((eth_dev->netif->input(p, eth_dev->netif)) != ERR_OK)
     {
         LOG_D("F:%s L:%d IP input error", __FUNCTION__, __LINE__);
+        bt_lwip_stat.rx_drop++;
         pbuf_free(p);
         p = RT_NULL;
     }
@@ -210,41 +249,68 @@ static rt_err_t rt_bt_lwip_protocol_recv(struct rt_bt_pan_instance *bt_instance,
 
 
 
-static rt_err_t rt_bt_lwip_protocol_send(rt_device_t device, struct pbuf *p)
+#if LWIP_SUPPORT_CUSTOM_PBUF
+static void rt_bt_lwip_rx_pbuf_free(struct pbuf *p)
 {
-    struct rt_bt_pan_instance *bt_instance = ((struct eth_device *)device)->parent.user_data;
+    struct bt_lwip_rx_pbuf *rx = (struct bt_lwip_rx_pbuf *)p;
 
-    //LOG_D("F:%s L:%d run", __FUNCTION__, __LINE__);
+    bfree(rx->buff);
+    LWIP_MEMPOOL_FREE(BT_LWIP_RX, rx);
+}
 
-    rt_uint8_t *frame;
+static rt_err_t rt_bt_lwip_protocol_recv_ref(struct rt_bt_pan_instance *bt_instance, void *buff, int len)
+{
+    struct eth_device *eth_dev = &((struct bt_lwip_prot_des *)bt_instance->prot)->eth;
+    struct bt_lwip_rx_pbuf *rx;
+    struct pbuf *p;
 
-    /* sending data directly */
-    if (p->len == p->tot_len)
+    if (eth_dev->netif == RT_NULL)
     {
-
-        // rt_kprintf("enter rt_bt_lwip_protocol_send total ,total len %d\n",p->tot_len);
-        frame = (rt_uint8_t *)p->payload;
-        rt_bt_prot_transfer_instance(bt_instance, frame, p->tot_len);
-        LOG_D("F:%s L:%d run len:%d", __FUNCTION__, __LINE__, p->tot_len);
-        return RT_EOK;
+        return -RT_ERROR;
     }
 
-    frame = rt_malloc(p->tot_len);
-    if (frame == RT_NULL)
+    rx = (struct bt_lwip_rx_pbuf *)LWIP_MEMPOOL_ALLOC(BT_LWIP_RX);
+    if (rx == RT_NULL)
     {
-        LOG_E("F:%s L:%d malloc out_buf fail\n", __FUNCTION__, __LINE__);
         return -RT_ENOMEM;
     }
-    /*copy pbuf -> data dat*/
-    pbuf_copy_partial(p, frame, p->tot_len, 0);
-    /* send data */
-    //rt_kprintf("enter rt_bt_lwip_protocol_send fragment ,total len %d\n",p->tot_len);
-    rt_bt_prot_transfer_instance(bt_instance, frame, p->tot_len);
-    LOG_D("F:%s L:%d run len:%d", __FUNCTION__, __LINE__, p->tot_len);
-    rt_free(frame);
+
+    rx->buff = buff;
+    rx->p.custom_free_function = rt_bt_lwip_rx_pbuf_free;
+    p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rx->p, buff, len);
+    if (p == RT_NULL)
+    {
+        LWIP_MEMPOOL_FREE(BT_LWIP_RX, rx);
+        return -RT_ERROR;
+    }
+
+    bt_lwip_stat.rx_frames++;
+    bt_lwip_stat.rx_bytes += len;
+    bt_lwip_stat.rx_ref++;
+
+    /* buffer is freed with pbuf from now on */
+    if ((eth_dev->netif->input(p, eth_dev->netif)) != ERR_OK)
+    {
+        LOG_D("F:%s L:%d IP input error", __FUNCTION__, __LINE__);
+        bt_lwip_stat.rx_drop++;
+        pbuf_free(p);
+    }
+
     return RT_EOK;
+}
+#endif
+
+static rt_err_t rt_bt_lwip_protocol_send(rt_device_t device, struct pbuf *p)
+{
+    struct rt_bt_pan_instance *bt_instance = ((struct eth_device *)device)->parent.user_data;
 
+    LOG_D("F:%s L:%d run len:%d", __FUNCTION__, __LINE__, p->tot_len);
 
+    bt_lwip_stat.tx_frames++;
+    bt_lwip_stat.tx_bytes += p->tot_len;
+
+    /* chain is gathered to BT buffer directly */
+    return rt_bt_prot_transfer_instance_pbuf(bt_instance, p);
 }
 
 #ifdef RT_USING_DEVICE_OPS
@@ -349,7 +415,12 @@ static struct rt_bt_prot_ops ops =
 {
     rt_bt_lwip_protocol_recv,
     rt_bt_lwip_protocol_register,
-    rt_bt_lwip_protocol_unregister
+    rt_bt_lwip_protocol_unregister,
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    rt_bt_lwip_protocol_recv_ref
+#else
+    RT_NULL
+#endif
 };
 
 
@@ -358,6 +429,10 @@ int rt_bt_lwip_init(void)
     static struct rt_bt_prot prot;
     rt_bt_prot_event_t event;
 
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    LWIP_MEMPOOL_INIT(BT_LWIP_RX);
+#endif
+
     rt_memset(&prot, 0, sizeof(prot));
     rt_strncpy(&prot.name[0], RT_BT_PROT_LWIP, RT_BT_PROT_NAME_LEN);
     prot.ops = &ops;
@@ -373,4 +448,30 @@ int rt_bt_lwip_init(void)
 
 INIT_PREV_EXPORT(rt_bt_lwip_init);
 
+/* show PAN traffic, throughput is averaged since last call, e.g. run it before and after iperf */
+void bt_lwip_pan_stat(void)
+{
+    static struct bt_lwip_stat last;
+    static rt_tick_t last_tick;
+    rt_tick_t now = rt_tick_get();
+    rt_uint32_t ms = (now - last_tick) * 1000 / RT_TICK_PER_SECOND;
+
+    rt_kprintf("rx %d frames %d bytes (ref %d copy %d drop %d), tx %d frames %d bytes\n",
+               bt_lwip_stat.rx_frames, bt_lwip_stat.rx_bytes, bt_lwip_stat.rx_ref, bt_lwip_stat.rx_copy,
+               bt_lwip_stat.rx_drop, bt_lwip_stat.tx_frames, bt_lwip_stat.tx_bytes);
+    if (last_tick && ms)
+    {
+        rt_kprintf("last %d ms: rx %d kbps, tx %d kbps\n", ms,
+                   (bt_lwip_stat.rx_bytes - last.rx_bytes) * 8 / ms,
+                   (bt_lwip_stat.tx_bytes - last.tx_bytes) * 8 / ms);
+    }
+#ifdef USING_CPU_USAGE_PROFILER
+    rt_kprintf("cpu usage %d%%\n", (int)cpu_get_usage());
+#endif
+
+    last = bt_lwip_stat;
+    last_tick = now;
+}
+MSH_CMD_EXPORT(bt_lwip_pan_stat, show BT PAN traffic and throughput);
+
 #endif
@@ -32,6 +32,13 @@ extern BTS2S_ETHER_ADDR bd2etheraddr (const BTS2S_BD_ADDR *bd);
 */
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* show PAN traffic and throughput since last call */
+void bt_lwip_pan_stat(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -132,6 +132,38 @@ rt_err_t rt_bt_prot_transfer_instance(struct rt_bt_pan_instance *bt_instance, vo
 
 
 
+/* send pbuf chain, fall back to flat buffer if instance can't take chain */
+rt_err_t rt_bt_prot_transfer_instance_pbuf(struct rt_bt_pan_instance *bt_instance, void *pbuf)
+{
+    struct pbuf *p = (struct pbuf *)pbuf;
+    rt_uint8_t *frame;
+
+    if (bt_instance->ops->bt_send_pbuf != RT_NULL)
+    {
+        bt_instance->ops->bt_send_pbuf(bt_instance, pbuf);
+        return RT_EOK;
+    }
+
+    if (p->len == p->tot_len)
+    {
+        return rt_bt_prot_transfer_instance(bt_instance, p->payload, p->tot_len);
+    }
+
+    frame = rt_malloc(p->tot_len);
+    if (frame == RT_NULL)
+    {
+        LOG_E("F:%s L:%d malloc out_buf fail\n", __FUNCTION__, __LINE__);
+        return -RT_ENOMEM;
+    }
+    pbuf_copy_partial(p, frame, p->tot_len, 0);
+    rt_bt_prot_transfer_instance(bt_instance, frame, p->tot_len);
+    rt_free(frame);
+
+    return RT_EOK;
+}
+
+
+
 rt_err_t rt_bt_instance_transfer_prot(struct rt_bt_pan_instance *bt_instance, void *buff, int len)
 {
     struct rt_bt_prot *prot = bt_instance->prot;
@@ -145,3 +177,14 @@ rt_err_t rt_bt_instance_transfer_prot(struct rt_bt_pan_instance *bt_instance, vo
 
 
 
+/* give frame buffer to protocol without copy, caller still owns buffer if it's not RT_EOK */
+rt_err_t rt_bt_instance_transfer_prot_ref(struct rt_bt_pan_instance *bt_instance, void *buff, int len)
+{
+    struct rt_bt_prot *prot = bt_instance->prot;
+
+    if ((prot != RT_NULL) && (prot->ops->prot_recv_ref != RT_NULL))
+    {
+        return prot->ops->prot_recv_ref(bt_instance, buff, len);
+    }
+    return -RT_ENOSYS;
+}
@@ -43,6 +43,9 @@ struct rt_bt_prot_ops
     rt_err_t (*prot_recv)(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
     struct rt_bt_prot *(*dev_reg_callback)(struct rt_bt_prot *prot, struct rt_bt_pan_instance *bt_instance);
     void (*dev_unreg_callback)(struct rt_bt_prot *prot, struct rt_bt_pan_instance *bt_instance);
+    /* optional, take heap buffer of frame without copy, it's freed by bfree when protocol is done
+     * with it, return RT_EOK if buffer is taken */
+    rt_err_t (*prot_recv_ref)(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
 };
 
 
@@ -64,6 +67,8 @@ rt_err_t rt_bt_prot_regisetr(struct rt_bt_prot *prot);
 rt_err_t rt_bt_prot_event_unregister(struct rt_bt_prot *prot, rt_bt_prot_event_t event);
 rt_err_t rt_bt_prot_transfer_instance(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
 rt_err_t rt_bt_instance_transfer_prot(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
+rt_err_t rt_bt_prot_transfer_instance_pbuf(struct rt_bt_pan_instance *bt_instance, void *pbuf);
+rt_err_t rt_bt_instance_transfer_prot_ref(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
 extern void rt_lwip_instance_register_event_handler(struct rt_bt_pan_instance *bt_instance, rt_bt_instance_event_t event, rt_bt_instance_event_handler handler);
 
 
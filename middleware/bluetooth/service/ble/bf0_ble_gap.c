@@ -675,6 +675,300 @@ uint8_t ble_gap_scan_stop(void)
     return ret;
 }
 
+#ifndef BLE_GAP_SCAN_DUP_NUM
+    #define BLE_GAP_SCAN_DUP_NUM        16
+#endif
+#ifndef BLE_GAP_SCAN_BATCH_SIZE
+    #define BLE_GAP_SCAN_BATCH_SIZE     1024
+#endif
+
+/*
+    Scan filter is checked where advertising reports enter service layer, before they are published,
+    so application handlers run only for matching ones. With batch_ms, matching reports are queued
+    and published together by a one-shot timer started by the first queued report, a batch is also
+    sent once full or scan stopped. Two batch buffers are switched under scheduler lock, flush_lock
+    keeps the one being published away from the reports coming meanwhile.
+*/
+typedef struct
+{
+    ble_gap_addr_t addr;
+    uint32_t hash;
+    rt_tick_t tick;
+} ble_gap_scan_dup_t;
+
+typedef struct
+{
+    uint8_t enabled;
+    uint8_t cur;
+    ble_gap_scan_filter_t cfg;
+    ble_gap_scan_dup_t dup[BLE_GAP_SCAN_DUP_NUM];
+    ble_gap_scan_filter_stat_t stat;
+    rt_timer_t timer;
+    struct rt_mutex flush_lock;
+    uint32_t batch[2][RT_ALIGN(sizeof(ble_gap_ext_adv_report_batch_ind_t) + BLE_GAP_SCAN_BATCH_SIZE, 4) / 4];
+} ble_gap_scan_filter_env_t;
+
+static ble_gap_scan_filter_env_t *g_ble_gap_scan_filter;
+
+static uint8_t ble_gap_scan_ad_match(const uint8_t *data, uint16_t len, uint8_t type, const uint8_t *val,
+                                     uint8_t val_len, uint8_t is_list)
+{
+    uint16_t pos = 0;
+
+    while (pos + 1 < len)
+    {
+        uint8_t ad_len = data[pos];
+
+        if (ad_len == 0 || pos + 1 + ad_len > len)
+            break;
+        if (data[pos + 1] == type)
+        {
+            const uint8_t *ad = &data[pos + 2];
+            uint8_t n = ad_len - 1;
+
+            /* UUID list has val_len items, service data and manufacturer data start with it */
+            for (uint8_t i = 0; i + val_len <= n; i += val_len)
+            {
+                if (memcmp(&ad[i], val, val_len) == 0)
+                    return 1;
+                if (!is_list)
+                    break;
+            }
+        }
+        pos += ad_len + 1;
+    }
+
+    return 0;
+}
+
+static uint8_t ble_gap_scan_uuid_match(ble_gap_scan_filter_t *cfg, ble_gap_ext_adv_report_ind_t *ind)
+{
+    uint8_t more, complete, svc_data;
+
+    switch (cfg->uuid_len)
+    {
+    case ATT_UUID_16_LEN:
+        more = BLE_GAP_AD_TYPE_MORE_16_BIT_UUID;
+        complete = BLE_GAP_AD_TYPE_COMPLETE_LIST_16_BIT_UUID;
+        svc_data = BLE_GAP_AD_TYPE_SERVICE_16_BIT_DATA;
+        break;
+    case ATT_UUID_32_LEN:
+        more = BLE_GAP_AD_TYPE_MORE_32_BIT_UUID;
+        complete = BLE_GAP_AD_TYPE_COMPLETE_LIST_32_BIT_UUID;
+        svc_data = BLE_GAP_AD_TYPE_SERVICE_32_BIT_DATA;
+        break;
+    default:
+        more = BLE_GAP_AD_TYPE_MORE_128_BIT_UUID;
+        complete = BLE_GAP_AD_TYPE_COMPLETE_LIST_128_BIT_UUID;
+        svc_data = BLE_GAP_AD_TYPE_SERVICE_128_BIT_DATA;
+        break;
+    }
+
+    return ble_gap_scan_ad_match(ind->data, ind->length, more, cfg->uuid, cfg->uuid_len, 1)
+           || ble_gap_scan_ad_match(ind->data, ind->length, complete, cfg->uuid, cfg->uuid_len, 1)
+           || ble_gap_scan_ad_match(ind->data, ind->length, svc_data, cfg->uuid, cfg->uuid_len, 0);
+}
+
+static uint8_t ble_gap_scan_is_dup(ble_gap_scan_filter_env_t *env, ble_gap_ext_adv_report_ind_t *ind)
+{
+    ble_gap_scan_dup_t *oldest = &env->dup[0];
+    rt_tick_t now = rt_tick_get();
+    rt_tick_t timeout = rt_tick_from_millisecond(env->cfg.dup_timeout_ms);
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a of report type and data, a changed payload from same device is not duplicate */
+    hash = (hash ^ ind->info) * 16777619u;
+    for (uint16_t i = 0; i < ind->length; i++)
+        hash = (hash ^ ind->data[i]) * 16777619u;
+
+    for (uint32_t i = 0; i < BLE_GAP_SCAN_DUP_NUM; i++)
+    {
+        ble_gap_scan_dup_t *dup = &env->dup[i];
+
+        if (dup->tick && dup->addr.addr_type == ind->addr.addr_type
+                && memcmp(dup->addr.addr.addr, ind->addr.addr.addr, BD_ADDR_LEN) == 0)
+        {
+            if (dup->hash == hash && (now - dup->tick) < timeout)
+                return 1;
+            dup->hash = hash;
+            dup->tick = now;
+            return 0;
+        }
+        if (dup->tick == 0 || (now - dup->tick) > (now - oldest->tick))
+            oldest = dup;
+        if (dup->tick == 0)
+            break;
+    }
+
+    memcpy(&oldest->addr, &ind->addr, sizeof(ble_gap_addr_t));
+    oldest->hash = hash;
+    oldest->tick = now ? now : 1;
+    return 0;
+}
+
+static void ble_gap_scan_batch_flush(void)
+{
+    ble_gap_scan_filter_env_t *env = g_ble_gap_scan_filter;
+    ble_gap_ext_adv_report_batch_ind_t *batch;
+
+    if (!env)
+        return;
+
+    rt_mutex_take(&env->flush_lock, RT_WAITING_FOREVER);
+    rt_enter_critical();
+    batch = (ble_gap_ext_adv_report_batch_ind_t *)env->batch[env->cur];
+    if (batch->count)
+    {
+        env->cur ^= 1;
+        ((ble_gap_ext_adv_report_batch_ind_t *)env->batch[env->cur])->count = 0;
+        ((ble_gap_ext_adv_report_batch_ind_t *)env->batch[env->cur])->length = 0;
+    }
+    rt_exit_critical();
+
+    if (batch->count)
+    {
+        env->stat.batches++;
+        ble_event_publish(BLE_GAP_EXT_ADV_REPORT_BATCH_IND, batch,
+                          sizeof(ble_gap_ext_adv_report_batch_ind_t) + batch->length);
+    }
+    rt_mutex_release(&env->flush_lock);
+}
+
+static void ble_gap_scan_batch_timeout(void *parameter)
+{
+    ble_gap_scan_batch_flush();
+}
+
+static void ble_gap_scan_batch_add(ble_gap_scan_filter_env_t *env, ble_gap_ext_adv_report_ind_t *ind)
+{
+    ble_gap_ext_adv_report_batch_ind_t *batch;
+    uint16_t len = RT_ALIGN(sizeof(ble_gap_ext_adv_report_ind_t) + ind->length, 4);
+    uint8_t first;
+
+    if (len > BLE_GAP_SCAN_BATCH_SIZE)
+    {
+        ble_event_publish(BLE_GAP_EXT_ADV_REPORT_IND, ind, sizeof(ble_gap_ext_adv_report_ind_t) + ind->length);
+        return;
+    }
+
+    rt_enter_critical();
+    batch = (ble_gap_ext_adv_report_batch_ind_t *)env->batch[env->cur];
+    if (batch->length + len > BLE_GAP_SCAN_BATCH_SIZE)
+    {
+        rt_exit_critical();
+        ble_gap_scan_batch_flush();
+        rt_enter_critical();
+        batch = (ble_gap_ext_adv_report_batch_ind_t *)env->batch[env->cur];
+    }
+    memcpy(batch->data + batch->length, ind, sizeof(ble_gap_ext_adv_report_ind_t) + ind->length);
+    batch->length += len;
+    first = (++batch->count == 1);
+    rt_exit_critical();
+
+    if (first)
+    {
+        rt_timer_stop(env->timer);
+        rt_timer_start(env->timer);
+    }
+}
+
+/* 1 - report is handled by scan filter */
+static uint8_t ble_gap_scan_filter_report(ble_gap_ext_adv_report_ind_t *ind)
+{
+    ble_gap_scan_filter_env_t *env = g_ble_gap_scan_filter;
+    ble_gap_scan_filter_t *cfg;
+
+    if (!env || !env->enabled
+            || (ind->info & GAPM_REPORT_INFO_REPORT_TYPE_MASK) == GAPM_REPORT_TYPE_PER_ADV)
+        return 0;
+
+    cfg = &env->cfg;
+    env->stat.received++;
+    if (ind->rssi < cfg->rssi_min)
+    {
+        env->stat.rssi_dropped++;
+        return 1;
+    }
+    if ((cfg->uuid_len && !ble_gap_scan_uuid_match(cfg, ind))
+            || (cfg->manu_id_en && !ble_gap_scan_ad_match(ind->data, ind->length, BLE_GAP_AD_TYPE_MANU_SPECIFIC_DATA,
+                    (const uint8_t *)&cfg->manu_id, sizeof(cfg->manu_id), 0)))
+    {
+        env->stat.miss_dropped++;
+        return 1;
+    }
+    if (cfg->dup_timeout_ms && ble_gap_scan_is_dup(env, ind))
+    {
+        env->stat.dup_dropped++;
+        return 1;
+    }
+
+    env->stat.delivered++;
+    if (cfg->batch_ms)
+        ble_gap_scan_batch_add(env, ind);
+    else
+        ble_event_publish(BLE_GAP_EXT_ADV_REPORT_IND, ind, sizeof(ble_gap_ext_adv_report_ind_t) + ind->length);
+
+    return 1;
+}
+
+uint8_t ble_gap_scan_set_filter(const ble_gap_scan_filter_t *filter)
+{
+    ble_gap_scan_filter_env_t *env = g_ble_gap_scan_filter;
+
+    if (filter && filter->uuid_len != 0 && filter->uuid_len != ATT_UUID_16_LEN
+            && filter->uuid_len != ATT_UUID_32_LEN && filter->uuid_len != ATT_UUID_128_LEN)
+        return GAP_ERR_INVALID_PARAM;
+
+    if (!env)
+    {
+        if (!filter)
+            return HL_ERR_NO_ERROR;
+        env = bt_mem_alloc(sizeof(ble_gap_scan_filter_env_t));
+        if (!env)
+            return GAP_ERR_INSUFF_RESOURCES;
+        memset(env, 0, sizeof(ble_gap_scan_filter_env_t));
+        rt_mutex_init(&env->flush_lock, "ble_scf", RT_IPC_FLAG_FIFO);
+        env->timer = rt_timer_create("ble_scf", ble_gap_scan_batch_timeout, NULL,
+                                     1, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+        RT_ASSERT(env->timer);
+        g_ble_gap_scan_filter = env;
+    }
+
+    /* reports queued under old filter are delivered first */
+    env->enabled = 0;
+    rt_timer_stop(env->timer);
+    ble_gap_scan_batch_flush();
+
+    if (filter)
+    {
+        rt_tick_t batch_tick = rt_tick_from_millisecond(filter->batch_ms);
+
+        memcpy(&env->cfg, filter, sizeof(ble_gap_scan_filter_t));
+        memset(env->dup, 0, sizeof(env->dup));
+        if (batch_tick)
+            rt_timer_control(env->timer, RT_TIMER_CTRL_SET_TIME, &batch_tick);
+        env->enabled = 1;
+    }
+
+    return HL_ERR_NO_ERROR;
+}
+
+void ble_gap_scan_get_filter_stat(ble_gap_scan_filter_stat_t *stat, uint8_t reset)
+{
+    ble_gap_scan_filter_env_t *env = g_ble_gap_scan_filter;
+
+    if (!env)
+    {
+        memset(stat, 0, sizeof(ble_gap_scan_filter_stat_t));
+        return;
+    }
+    rt_enter_critical();
+    memcpy(stat, &env->stat, sizeof(ble_gap_scan_filter_stat_t));
+    if (reset)
+        memset(&env->stat, 0, sizeof(ble_gap_scan_filter_stat_t));
+    rt_exit_critical();
+}
+
 
 // For ADV set is not enough and need act as central role.
 uint8_t ble_gap_delete_init(void)
@@ -1310,6 +1604,7 @@ void ble_gap_event_process(sibles_msg_para_t *header, uint8_t *data_ptr, uint16_
             if (act_info->scan_info.state != BLE_GAP_ACTV_STOPPING) // STOPPING will delete in STOP CNF
                 ble_gap_delete_scan(act_info);
             evt.reason = ind->reason;
+            ble_gap_scan_batch_flush();
             ble_event_publish(BLE_GAP_SCAN_STOPPED_IND, &evt, sizeof(ble_gap_scan_stopped_ind_t));
         }
         else if (ind->actv_type == GAPM_ACTV_TYPE_INIT)
@@ -1780,6 +2075,10 @@ void ble_gap_event_process(sibles_msg_para_t *header, uint8_t *data_ptr, uint16_
     case GAPM_EXT_ADV_REPORT_IND:
     {
         ble_gap_ext_adv_report_ind_t *ind = (ble_gap_ext_adv_report_ind_t *)data_ptr;
+#ifdef BLE_GAP_CENTRAL
+        if (ble_gap_scan_filter_report(ind))
+            break;
+#endif
         ble_event_publish(BLE_GAP_EXT_ADV_REPORT_IND, ind, sizeof(ble_gap_ext_adv_report_ind_t) + ind->length);
         break;
     }
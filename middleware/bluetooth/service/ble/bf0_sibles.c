@@ -79,6 +79,16 @@
     #define SIBLES_MAX_REMOTE_SVCS 5
 #endif
 
+/* Max number of 16 bits UUID attributes of local services indexed for lookup by UUID */
+#ifndef SIBLES_MAX_ATT_INDEX
+    #define SIBLES_MAX_ATT_INDEX 128
+#endif
+
+/* Max number of values sent by one sibles_write_values() call */
+#ifndef SIBLES_MAX_BATCH_VALUES
+    #define SIBLES_MAX_BATCH_VALUES 8
+#endif
+
 // for android, search svc will return end handle as 0xffff
 // this may alloc a big value
 #define LAST_SVC_LEN 40
@@ -148,6 +158,25 @@ struct sibles_remote_svc_env
     sibles_remote_svc_cbk callback;
 };
 
+struct sibles_att_index
+{
+    uint16_t uuid;
+    uint8_t hdl;
+    uint8_t svc;
+};
+
+#ifdef SIBLES_PERF_STAT
+struct sibles_perf_stat
+{
+    uint32_t single_cnt;
+    uint32_t single_cycles;
+    uint32_t batch_cnt;
+    uint32_t batch_values;
+    uint32_t batch_cycles;
+    uint32_t no_credit;
+};
+#endif /* SIBLES_PERF_STAT */
+
 struct sibles_rte_wr_info
 {
     rt_slist_t   next;
@@ -161,6 +190,12 @@ struct sibles_env
     uint8_t status;
     uint8_t num_of_tx_pkt;
     struct sibles_svc_env svcs[SIBLES_MAX_SVCS];
+    /* Local attribute handle to index of svcs + 1, 0 if not registered */
+    uint8_t hdl_svc[256];
+    /* 16 bits UUID of local attributes sorted by UUID, built when service is registered */
+    uint8_t att_index_num;
+    uint8_t att_index_full;
+    struct sibles_att_index att_index[SIBLES_MAX_ATT_INDEX];
 #ifdef BLE_GATT_CLIENT
     struct sibles_remote_info remote_info;
     struct sibles_remote_svc_env remote_svc[SIBLES_MAX_REMOTE_SVCS];
@@ -282,6 +317,98 @@ static struct sibles_svc_env *get_svc_handle(uint16_t msg_id)
     return r;
 }
 
+static bool sibles_get_att_uuid16(struct sibles_svc_env *svc, uint8_t idx, uint16_t *uuid)
+{
+    if (svc->att_db == NULL)
+        return false;
+
+    if (svc->svc_uuid_len == ATT_UUID_16_LEN)
+    {
+        *uuid = ((struct attm_desc *)svc->att_db)[idx].uuid;
+        return true;
+    }
+
+    struct attm_desc_128 *att = &((struct attm_desc_128 *)svc->att_db)[idx];
+    if (PERM_GET(att->perm, UUID_LEN) != PERM_UUID_16)
+        return false;
+    *uuid = att->uuid[0] | (att->uuid[1] << 8);
+    return true;
+}
+
+static int sibles_att_index_find(uint16_t uuid)
+{
+    int low = 0, high = g_sibles.att_index_num - 1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (g_sibles.att_index[mid].uuid == uuid)
+            return mid;
+        if (g_sibles.att_index[mid].uuid < uuid)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -(low + 1);
+}
+
+/* Index attributes of a newly registered service, called once its start handle is known */
+static void sibles_att_index_add(uint8_t svc_idx)
+{
+    struct sibles_svc_env *svc = &g_sibles.svcs[svc_idx];
+    uint16_t uuid;
+    int pos;
+
+    rt_enter_critical();
+    for (int j = 0; j < svc->hdl_num && svc->hdl_start + j < 256; j++)
+    {
+        g_sibles.hdl_svc[svc->hdl_start + j] = svc_idx + 1;
+
+        if (!sibles_get_att_uuid16(svc, j, &uuid))
+            continue;
+
+        pos = sibles_att_index_find(uuid);
+        if (pos >= 0)
+        {
+            /* Same as linear lookup: service with larger index wins, first attribute in service wins */
+            if (g_sibles.att_index[pos].svc < svc_idx)
+            {
+                g_sibles.att_index[pos].hdl = svc->hdl_start + j;
+                g_sibles.att_index[pos].svc = svc_idx;
+            }
+            continue;
+        }
+        if (g_sibles.att_index_num == SIBLES_MAX_ATT_INDEX)
+        {
+            g_sibles.att_index_full = 1;
+            continue;
+        }
+        pos = -pos - 1;
+        memmove(&g_sibles.att_index[pos + 1], &g_sibles.att_index[pos],
+                (g_sibles.att_index_num - pos) * sizeof(struct sibles_att_index));
+        g_sibles.att_index[pos].uuid = uuid;
+        g_sibles.att_index[pos].hdl = svc->hdl_start + j;
+        g_sibles.att_index[pos].svc = svc_idx;
+        g_sibles.att_index_num++;
+    }
+    rt_exit_critical();
+
+    if (g_sibles.att_index_full)
+        LOG_W("att index full, increase SIBLES_MAX_ATT_INDEX");
+}
+
+static struct sibles_svc_env *sibles_get_svc_by_hdl(uint16_t hdl)
+{
+    uint8_t svc_idx;
+
+    if (hdl > 255)
+        return NULL;
+    svc_idx = g_sibles.hdl_svc[hdl];
+    if (svc_idx == 0 || g_sibles.svcs[svc_idx - 1].svc_status <= SIBLES_IDLE)
+        return NULL;
+    return &g_sibles.svcs[svc_idx - 1];
+}
+
 static void sibles_send_value_writecfm(uint8_t conn_idx, uint8_t hdl, uint8_t status)
 {
     struct sibles_value_ack *cfm;
@@ -355,6 +482,32 @@ static uint8_t sibles_acquire_tx_pkts(void)
     return 1;
 }
 
+/* Reserve up to num tx packets at once, return number reserved */
+static uint8_t sibles_acquire_tx_pkts_n(uint8_t num)
+{
+    uint8_t got;
+#ifdef BLE_GATT_CLIENT
+    uint8_t buffer_num = sibles_get_slist_len(&g_sibles.wr_node);
+    sibles_acquire_tx_pkts_hook(buffer_num);
+#endif //BLE_GATT_CLIENT
+    rt_enter_critical();
+    got = g_sibles.num_of_tx_pkt < num ? g_sibles.num_of_tx_pkt : num;
+    g_sibles.num_of_tx_pkt -= got;
+    rt_exit_critical();
+    return got;
+}
+
+#ifdef SIBLES_PERF_STAT
+static struct sibles_perf_stat g_sibles_perf;
+
+static uint32_t sibles_perf_begin(void)
+{
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+    return HAL_DBG_DWT_GetCycles();
+}
+#endif /* SIBLES_PERF_STAT */
+
 #ifdef BLE_GATT_CLIENT
 void sibles_clear_wr_list(uint8_t conn_idx)
 {
@@ -653,6 +806,7 @@ void sifli_mbox_process(sibles_msg_para_t *header, uint8_t *data_ptr, uint16_t p
         {
             env->hdl_start = rsp->start_hdl;
             env->svc_status = SIBLES_READY;
+            sibles_att_index_add(env - g_sibles.svcs);
         }
         else
             env->svc_status = SIBLES_EMPTY;
@@ -703,27 +857,23 @@ void sifli_mbox_process(sibles_msg_para_t *header, uint8_t *data_ptr, uint16_t p
     case SIBLES_VALUE_REQ_IND:
     {
         struct sibles_value_req_ind *ind;
-        int i;
+        struct sibles_svc_env *svc;
 
         ind = (struct sibles_value_req_ind *)data_ptr;
-        for (i = 0; i < SIBLES_MAX_SVCS; i++)
-            if (g_sibles.svcs[i].svc_status > SIBLES_IDLE &&
-                    ind->hdl >= g_sibles.svcs[i].hdl_start &&
-                    ind->hdl < (g_sibles.svcs[i].hdl_start + g_sibles.svcs[i].hdl_num))
-                break;
-        if (i < SIBLES_MAX_SVCS)
+        svc = sibles_get_svc_by_hdl(ind->hdl);
+        if (svc)
         {
-            int idx = ind->hdl - g_sibles.svcs[i].hdl_start;
+            int idx = ind->hdl - svc->hdl_start;
             sibles_value_t value;
 
             value.idx = idx;
-            value.hdl = &(g_sibles.svcs[i]);
+            value.hdl = svc;
             value.value = NULL;
 
-            if (g_sibles.svcs[i].get_cbk)
+            if (svc->get_cbk)
             {
 
-                value.value = (*g_sibles.svcs[i].get_cbk)(conn_idx, idx, &value.len);
+                value.value = (*svc->get_cbk)(conn_idx, idx, &value.len);
                 value.len |= SIBLE_CFM_FLAG;
 
                 sibles_set_value(conn_idx, &value);
@@ -741,29 +891,28 @@ void sifli_mbox_process(sibles_msg_para_t *header, uint8_t *data_ptr, uint16_t p
     case SIBLES_VALUE_WRITE_IND:
     {
         struct sibles_value_write_ind *ind;
-        int i;
+        struct sibles_svc_env *svc;
         uint8_t status;
 
         ind = (struct sibles_value_write_ind *)data_ptr;
-        for (i = 0; i < SIBLES_MAX_SVCS; i++)
-            if (g_sibles.svcs[i].svc_status > SIBLES_IDLE &&
-                    ind->hdl >= g_sibles.svcs[i].hdl_start &&
-                    ind->hdl < (g_sibles.svcs[i].hdl_start + g_sibles.svcs[i].hdl_num))
-                break;
-        if (i < SIBLES_MAX_SVCS)
+        svc = sibles_get_svc_by_hdl(ind->hdl);
+        if (svc)
         {
-            int idx = ind->hdl - g_sibles.svcs[i].hdl_start;
-            if (g_sibles.svcs[i].set_cbk)
+            int idx = ind->hdl - svc->hdl_start;
+            if (svc->set_cbk)
             {
                 sibles_set_cbk_t para;
                 para.idx = idx;
                 para.len = ind->length;
                 para.offset = ind->offset;
                 para.value  = ind->data;
-                status = (*g_sibles.svcs[i].set_cbk)(conn_idx, &para);
+                status = (*svc->set_cbk)(conn_idx, &para);
             }
             else
                 status = 1;
+#ifdef BLE_CM_ADAPTIVE_PARAM
+            connection_manager_policy_report(conn_idx, 0, ind->length, 0);
+#endif
             if (!ind->is_cmd)
                 sibles_send_value_writecfm(conn_idx, ind->hdl, status);
         };
@@ -1206,6 +1355,15 @@ uint8_t sibles_get_gatt_handle_by_uuid(uint16_t attr_uuid)
     uint8_t index;
     uint8_t found_attr = 0;
     uint8_t svc_index;
+    int pos;
+
+    pos = sibles_att_index_find(attr_uuid);
+    if (pos >= 0)
+        return g_sibles.att_index[pos].hdl;
+    if (!g_sibles.att_index_full)
+        return 0;
+
+    /* Index overflowed, UUID may be one of attributes not indexed */
     for (int i = 0; i < SIBLES_MAX_SVCS; i++)
     {
         if (g_sibles.svcs[i].svc_status == SIBLES_EMPTY)
@@ -1213,15 +1371,11 @@ uint8_t sibles_get_gatt_handle_by_uuid(uint16_t attr_uuid)
             continue;
         }
 
-        struct attm_desc *att_db = (struct attm_desc *)g_sibles.svcs[i].att_db;
-        if (att_db == NULL)
-        {
-            continue;
-        }
-
         for (int j = 0; j < g_sibles.svcs[i].hdl_num; j++)
         {
-            if (att_db[j].uuid == attr_uuid)
+            uint16_t uuid;
+
+            if (sibles_get_att_uuid16(&g_sibles.svcs[i], j, &uuid) && uuid == attr_uuid)
             {
                 svc_index = i;
                 index = j;
@@ -1243,64 +1397,26 @@ uint8_t sibles_get_gatt_handle_by_uuid(uint16_t attr_uuid)
 uint16_t sibles_get_uuid_by_attr(uint8_t attr)
 {
     uint16_t current_uuid = 0;
-    struct sibles_svc_env *svc;
+    struct sibles_svc_env *svc = sibles_get_svc_by_hdl(attr);
 
-    for (int i = 0; i < SIBLES_MAX_SVCS; i++)
+    if (svc == NULL || !sibles_get_att_uuid16(svc, attr - svc->hdl_start, &current_uuid))
     {
-        if (g_sibles.svcs[i].svc_status == SIBLES_EMPTY)
-        {
-            continue;
-        }
-
-        struct attm_desc *att_db = (struct attm_desc *)g_sibles.svcs[i].att_db;
-        if (att_db == NULL)
-        {
-            continue;
-        }
-
-        svc = (struct sibles_svc_env *)((sibles_hdl) & (g_sibles.svcs[i]));
-        LOG_I("sss %d", svc->hdl_start);
-        for (uint8_t j = 0; j < g_sibles.svcs[i].hdl_num; j++)
-        {
-            if ((svc->hdl_start + j) == attr)
-            {
-                current_uuid = att_db[j].uuid;
-                break;
-            }
-        }
+        return 0;
     }
     return current_uuid;
 }
 
 sibles_hdl sibles_get_sible_handle_and_index_by_attr(uint8_t attr, uint8_t *write_index)
 {
-    struct sibles_svc_env *svc;
-    for (int i = 0; i < SIBLES_MAX_SVCS; i++)
-    {
-        if (g_sibles.svcs[i].svc_status == SIBLES_EMPTY)
-        {
-            continue;
-        }
-
-        struct attm_desc *att_db = (struct attm_desc *)g_sibles.svcs[i].att_db;
-        if (att_db == NULL)
-        {
-            continue;
-        }
+    struct sibles_svc_env *svc = sibles_get_svc_by_hdl(attr);
 
-        svc = (struct sibles_svc_env *)((sibles_hdl) & (g_sibles.svcs[i]));
-
-        for (uint8_t j = 0; j < g_sibles.svcs[i].hdl_num; j++)
-        {
-            if ((svc->hdl_start + j) == attr)
-            {
-                *write_index = j;
-                return (sibles_hdl) & (g_sibles.svcs[i]);
-            }
-        }
+    if (svc == NULL || svc->att_db == NULL)
+    {
+        return 0;
     }
 
-    return 0;
+    *write_index = attr - svc->hdl_start;
+    return (sibles_hdl)svc;
 }
 
 void sibles_get_all_gatt_handle(sibles_local_svc_t *svc)
@@ -1372,6 +1488,9 @@ int sibles_write_value(uint8_t conn_idx, sibles_value_t *value)
 
     struct sibles_svc_env *svc = (struct sibles_svc_env *) value->hdl;
     sibles_send_value_t send_val;
+#ifdef SIBLES_PERF_STAT
+    uint32_t start = sibles_perf_begin();
+#endif
 
     send_val.hdl = value->idx + svc->hdl_start;
     send_val.msg = SIBLES_VALUE_NTF_IND;
@@ -1379,13 +1498,104 @@ int sibles_write_value(uint8_t conn_idx, sibles_value_t *value)
     send_val.value = value->value;
 
     if (sibles_acquire_tx_pkts() == 0)
+    {
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        connection_manager_policy_report(conn_idx, 0, 0, 1);
+#endif
+#ifdef SIBLES_PERF_STAT
+        g_sibles_perf.no_credit++;
+#endif
         return 0;
+    }
     sibles_send_value(conn_idx, &send_val);
+#ifdef BLE_CM_ADAPTIVE_PARAM
+    connection_manager_policy_report(conn_idx, send_val.len, 0, 0);
+#endif
+#ifdef SIBLES_PERF_STAT
+    g_sibles_perf.single_cycles += HAL_DBG_DWT_GetCycles() - start;
+    g_sibles_perf.single_cnt++;
+#endif
     //svc->svc_status = SIBLES_BUSY;
     //sifli_sem_take();
     return send_val.len;
 }
 
+int sibles_write_values(uint8_t conn_idx, sibles_value_t *values, uint8_t num)
+{
+#ifdef BSP_BLE_CONNECTION_MANAGER
+    if (!connection_manager_check_normal_conn_idx(conn_idx))
+    {
+        LOG_I("unexpected conn idx %d", conn_idx);
+        return -1;
+    }
+#endif
+
+    void *msgs[SIBLES_MAX_BATCH_VALUES];
+    sifli_task_id_t task_id = g_sibles.app_task_id;
+    uint32_t total_len = 0;
+    uint8_t got;
+#ifdef SIBLES_PERF_STAT
+    uint32_t start = sibles_perf_begin();
+#endif
+
+    if (num > SIBLES_MAX_BATCH_VALUES)
+        num = SIBLES_MAX_BATCH_VALUES;
+
+    got = sibles_acquire_tx_pkts_n(num);
+    if (got < num)
+    {
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        connection_manager_policy_report(conn_idx, 0, 0, 1);
+#endif
+#ifdef SIBLES_PERF_STAT
+        g_sibles_perf.no_credit += num - got;
+#endif
+    }
+
+    for (uint8_t i = 0; i < got; i++)
+    {
+        struct sibles_svc_env *svc = (struct sibles_svc_env *) values[i].hdl;
+        struct sibles_value *val;
+
+        val = (struct sibles_value *)sifli_msg_alloc(SIBLES_VALUE_NTF_IND,
+                TASK_BUILD_ID(task_id, conn_idx), sifli_get_stack_id(), sizeof(struct sibles_value) + values[i].len);
+        val->hdl = values[i].idx + svc->hdl_start;
+        val->length = values[i].len;
+        if (values[i].value)
+            memcpy(val->data, values[i].value, values[i].len);
+        msgs[i] = val;
+        total_len += values[i].len;
+    }
+
+#if defined(SOC_SF32LB55X) && defined(SOC_BF0_HCPU)
+    /* Queue all to mailbox and wake up mailbox thread once */
+    for (uint8_t i = 0; i < got; i++)
+    {
+        rt_err_t ret = sifli_mbox_send((uint8_t *)msgs[i]);
+        RT_ASSERT(ret == RT_EOK);
+    }
+    if (got)
+        silfi_mbox_notify(SIFLI_TASK_TRAN_EVT);
+#else
+    for (uint8_t i = 0; i < got; i++)
+        sifli_msg_send((void const *)msgs[i]);
+#endif
+
+#ifdef BLE_CM_ADAPTIVE_PARAM
+    if (got)
+        connection_manager_policy_report(conn_idx, total_len, 0, 0);
+#endif
+#ifdef SIBLES_PERF_STAT
+    if (got)
+    {
+        g_sibles_perf.batch_cycles += HAL_DBG_DWT_GetCycles() - start;
+        g_sibles_perf.batch_values += got;
+        g_sibles_perf.batch_cnt++;
+    }
+#endif
+    return got;
+}
+
 int sibles_write_value_with_rsp(uint8_t conn_idx, sibles_value_t *value)
 {
 #ifdef BSP_BLE_CONNECTION_MANAGER
@@ -1405,8 +1615,16 @@ int sibles_write_value_with_rsp(uint8_t conn_idx, sibles_value_t *value)
     send_val.value = value->value;
 
     if (sibles_acquire_tx_pkts() == 0)
+    {
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        connection_manager_policy_report(conn_idx, 0, 0, 1);
+#endif
         return 0;
+    }
     sibles_send_value(conn_idx, &send_val);
+#ifdef BLE_CM_ADAPTIVE_PARAM
+    connection_manager_policy_report(conn_idx, send_val.len, 0, 0);
+#endif
     //svc->svc_status = SIBLES_BUSY;
     //sifli_sem_take();
     return send_val.len;
@@ -1753,6 +1971,40 @@ enum dbg_patch_type
     MAX_DBG_PATCH_TYPE,
 };
 
+#ifdef SIBLES_PERF_STAT
+int sibles_perf(int argc, char *argv[])
+{
+    uint32_t mhz = HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000;
+    uint32_t start, cycles;
+    uint16_t uuid = 0;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        memset(&g_sibles_perf, 0, sizeof(g_sibles_perf));
+        return 0;
+    }
+
+    rt_kprintf("ntf single: %d, %d cycles/ntf\n", g_sibles_perf.single_cnt,
+               g_sibles_perf.single_cnt ? g_sibles_perf.single_cycles / g_sibles_perf.single_cnt : 0);
+    rt_kprintf("ntf batch: %d calls, %d values, %d cycles/ntf\n", g_sibles_perf.batch_cnt, g_sibles_perf.batch_values,
+               g_sibles_perf.batch_values ? g_sibles_perf.batch_cycles / g_sibles_perf.batch_values : 0);
+    rt_kprintf("no credit: %d, HCLK %dMHz\n", g_sibles_perf.no_credit, mhz);
+
+    if (g_sibles.att_index_num)
+    {
+        uuid = g_sibles.att_index[g_sibles.att_index_num - 1].uuid;
+        start = sibles_perf_begin();
+        for (int i = 0; i < 100; i++)
+            sibles_get_gatt_handle_by_uuid(uuid);
+        cycles = HAL_DBG_DWT_GetCycles() - start;
+        rt_kprintf("uuid lookup: %d cycles, %d attributes indexed%s\n", cycles / 100, g_sibles.att_index_num,
+                   g_sibles.att_index_full ? " (full)" : "");
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(sibles_perf, show sibles notification cost);
+#endif /* SIBLES_PERF_STAT */
+
 int btdm_dbg(int argc, char *argv[])
 {
     uint8_t cmdpara[4] = {0, 0, 0, 0};
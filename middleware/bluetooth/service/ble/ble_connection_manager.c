@@ -118,6 +118,11 @@ static connection_manager_env_t *cm_get_env()
 
 int connection_manager_event_process(uint8_t command, uint16_t len, void *data);
 static uint8_t get_manager_index_by_connection_index(uint8_t conn_idx);
+#ifdef BLE_CM_ADAPTIVE_PARAM
+    static void cm_policy_link_init(uint8_t manager_index, uint16_t interval);
+    static void cm_policy_link_deinit(uint8_t manager_index);
+    static void cm_policy_set_level(uint8_t manager_index, uint8_t interval_level);
+#endif
 
 
 int cm_env_init(void)
@@ -1933,6 +1938,9 @@ int ble_connection_manager_handler(uint16_t event_id, uint8_t *data, uint16_t le
         g_conn_manager[manager_index].connection_latency = ind->con_latency;
         g_conn_manager[manager_index].supervision_timeout = ind->sup_to;
         g_conn_manager[manager_index].update_state = UPDATE_PARAMETER_NONE;
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        cm_policy_link_init(manager_index, ind->con_interval);
+#endif
 
         ind->config_info.auth = env->connected_auth;
         for (int i = 0; i < MAX_PAIR_DEV; i++)
@@ -2022,6 +2030,9 @@ int ble_connection_manager_handler(uint16_t event_id, uint8_t *data, uint16_t le
         {
             rt_timer_stop(env->update_timer);
         }
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        cm_policy_link_deinit(manager_index);
+#endif
         connection_manager_event_process(CM_DISCONNECTED_IND, sizeof(connection_manager_disconnected_ind_t), data);
         connection_manager_connection_state_change(manager_index, CONNECTION_STATE_DISCONNECTED, event_id);
 #ifdef BLE_SVC_CHG_ENABLE
@@ -2552,12 +2563,17 @@ static uint8_t cm_update_parameter(uint8_t conn_idx, uint8_t interval_level, uin
 // default use l2cap update
 uint8_t connection_manager_update_parameter(uint8_t conn_idx, uint8_t interval_level, uint8_t *data)
 {
-    return cm_update_parameter(conn_idx, interval_level, data, UPDATE_TYPE_L2CAP);
+    return connection_manager_update_parameter_with_type(conn_idx, interval_level, data, UPDATE_TYPE_L2CAP);
 }
 
 uint8_t connection_manager_update_parameter_with_type(uint8_t conn_idx, uint8_t interval_level, uint8_t *data, enum connection_manager_update_type type)
 {
-    return cm_update_parameter(conn_idx, interval_level, data, type);
+    uint8_t ret = cm_update_parameter(conn_idx, interval_level, data, type);
+#ifdef BLE_CM_ADAPTIVE_PARAM
+    if (ret == CM_STATUS_OK || ret == CM_PARAMETER_SAME)
+        cm_policy_set_level(get_manager_index_by_connection_index(conn_idx), interval_level);
+#endif
+    return ret;
 }
 
 uint8_t connection_manager_get_connetion_parameter(uint8_t conn_idx, uint8_t *data)
@@ -2579,6 +2595,273 @@ uint8_t connection_manager_get_connetion_parameter(uint8_t conn_idx, uint8_t *da
 }
 
 // slave ask to start bond
+#ifdef BLE_CM_ADAPTIVE_PARAM
+typedef struct
+{
+    uint32_t tx_bytes;      /* traffic of current period */
+    uint32_t rx_bytes;
+    uint16_t stalls;
+    uint8_t quiet;          /* periods in row wanting a slower level */
+    uint8_t phy_2m;
+    uint8_t hold[3];        /* holds of each level */
+    connection_manager_policy_stats_t stats;
+} cm_policy_link_t;
+
+static cm_policy_link_t g_cm_policy[MAX_CONNECTION_LINK_NUM];
+static rt_timer_t g_cm_policy_timer;
+static uint8_t g_cm_policy_disabled;
+
+void connection_manager_policy_report(uint8_t conn_idx, uint16_t tx_len, uint16_t rx_len, uint8_t stall)
+{
+    uint8_t manager_index = get_manager_index_by_connection_index(conn_idx);
+    if (manager_index == CM_CONN_INDEX_ERROR)
+    {
+        return;
+    }
+
+    g_cm_policy[manager_index].tx_bytes += tx_len;
+    g_cm_policy[manager_index].rx_bytes += rx_len;
+    g_cm_policy[manager_index].stalls += stall;
+}
+
+/* estimated radio on time per mille, from connection events and air time of data */
+static uint32_t cm_policy_duty(uint8_t manager_index, uint32_t bps)
+{
+    conn_manager_t *link = &g_conn_manager[manager_index];
+    uint32_t event_period = link->connection_interval ? link->connection_interval : 1;
+    uint32_t events_x100, air_us;
+
+    // latency is only used while idle
+    if (bps < BLE_CM_POLICY_LOW_BPS)
+        event_period *= link->connection_latency + 1;
+    events_x100 = 80000 / event_period;
+    air_us = bps * (g_cm_policy[manager_index].phy_2m ? 4 : 8);
+
+    return (events_x100 * BLE_CM_POLICY_EVENT_US / 100 + air_us) / 1000;
+}
+
+static uint8_t cm_policy_switch(uint8_t manager_index, uint8_t interval_level, uint32_t bps)
+{
+    cm_policy_link_t *policy = &g_cm_policy[manager_index];
+    uint8_t conn_idx = g_conn_manager[manager_index].conn_idx;
+    uint8_t ret;
+
+    ret = cm_update_parameter(conn_idx, interval_level, NULL, UPDATE_TYPE_L2CAP);
+    if (ret != CM_STATUS_OK && ret != CM_PARAMETER_SAME)
+    {
+        // e.g. updating, try again next period
+        return ret;
+    }
+
+    LOG_I("policy conn %d: level %d -> %d, %d B/s, duty %d permille", conn_idx, policy->stats.level,
+          interval_level, bps, cm_policy_duty(manager_index, bps));
+    policy->stats.level = interval_level;
+    policy->stats.switches++;
+    policy->quiet = 0;
+
+#ifndef BLE_CONNECTION_PRIORITY_SYNC
+    if (interval_level == CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE && !policy->phy_2m)
+    {
+        ble_gap_update_phy_t phy;
+        phy.conn_idx = conn_idx;
+        phy.rx_phy = GAP_PHY_LE_2MBPS;
+        phy.tx_phy = GAP_PHY_LE_2MBPS;
+        phy.phy_opt = 0;
+        ble_gap_update_phy(&phy);
+        policy->phy_2m = 1;
+    }
+#endif
+    return ret;
+}
+
+/* fastest level held by app, LOW_POWER if none */
+static uint8_t cm_policy_floor(cm_policy_link_t *policy)
+{
+    uint8_t level;
+
+    for (level = CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE; level < CONNECTION_MANAGER_INTERVAL_LOW_POWER; level++)
+    {
+        if (policy->hold[level - 1])
+            break;
+    }
+    return level;
+}
+
+static void cm_policy_link_run(uint8_t manager_index)
+{
+    cm_policy_link_t *policy = &g_cm_policy[manager_index];
+    uint8_t level = policy->stats.level;
+    uint8_t target, floor;
+    uint32_t bytes, bps;
+
+    bytes = policy->tx_bytes + policy->rx_bytes;
+    bps = bytes * 1000 / BLE_CM_POLICY_PERIOD_MS;
+    policy->tx_bytes = 0;
+    policy->rx_bytes = 0;
+
+    // customized parameter is left to its user
+    if (level < CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE || level > CONNECTION_MANAGER_INTERVAL_LOW_POWER)
+    {
+        policy->stalls = 0;
+        return;
+    }
+    policy->stats.time_ms[level - 1] += BLE_CM_POLICY_PERIOD_MS;
+    policy->stats.bytes[level - 1] += bytes;
+
+    // thresholds to leave a level are half of those to enter it
+    if (policy->stalls || bps >= BLE_CM_POLICY_HIGH_BPS
+            || (level == CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE && bps >= BLE_CM_POLICY_HIGH_BPS / 2))
+        target = CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE;
+    else if (bps >= BLE_CM_POLICY_LOW_BPS || (bps >= BLE_CM_POLICY_LOW_BPS / 2 && level != CONNECTION_MANAGER_INTERVAL_LOW_POWER))
+        target = CONNECTION_MANAGER_INTERVAL_BALANCED;
+    else
+        target = CONNECTION_MANAGER_INTERVAL_LOW_POWER;
+    policy->stalls = 0;
+
+    // only holds are applied when policy is disabled
+    floor = cm_policy_floor(policy);
+    if (g_cm_policy_disabled || target > floor)
+        target = floor;
+
+    if (target < level)
+    {
+        cm_policy_switch(manager_index, target, bps);
+    }
+    else if (target > level && !g_cm_policy_disabled)
+    {
+        if (++policy->quiet >= BLE_CM_POLICY_DOWN_PERIODS)
+            cm_policy_switch(manager_index, target, bps);
+    }
+    else
+    {
+        policy->quiet = 0;
+    }
+}
+
+static void cm_policy_timeout(void *parameter)
+{
+    uint8_t i, connected = 0;
+
+    for (i = 0; i < MAX_CONNECTION_LINK_NUM; i++)
+    {
+        if (g_conn_manager[i].connection_state == CONNECTION_STATE_CONNECTED)
+        {
+            cm_policy_link_run(i);
+            connected = 1;
+        }
+    }
+
+    if (!connected)
+        rt_timer_stop(g_cm_policy_timer);
+}
+
+static void cm_policy_link_init(uint8_t manager_index, uint16_t interval)
+{
+    cm_policy_link_t *policy = &g_cm_policy[manager_index];
+
+    rt_memset(policy, 0, sizeof(cm_policy_link_t));
+    if (interval <= HIGH_PERFORMANCE_INTERVAL_MAX)
+        policy->stats.level = CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE;
+    else if (interval <= BANLANCED_INTERVAL_MAX)
+        policy->stats.level = CONNECTION_MANAGER_INTERVAL_BALANCED;
+    else
+        policy->stats.level = CONNECTION_MANAGER_INTERVAL_LOW_POWER;
+
+    if (!g_cm_policy_timer)
+    {
+        g_cm_policy_timer = rt_timer_create("ble_cm_plc", cm_policy_timeout, NULL,
+                                            rt_tick_from_millisecond(BLE_CM_POLICY_PERIOD_MS),
+                                            RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_SOFT_TIMER);
+        RT_ASSERT(g_cm_policy_timer);
+    }
+    if (!(g_cm_policy_timer->parent.flag & RT_TIMER_FLAG_ACTIVATED))
+        rt_timer_start(g_cm_policy_timer);
+}
+
+static void cm_policy_link_deinit(uint8_t manager_index)
+{
+    connection_manager_policy_stats_t *stats = &g_cm_policy[manager_index].stats;
+    static const char *const level_name[3] = {"high", "balanced", "low power"};
+    uint8_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (stats->time_ms[i])
+            LOG_I("policy conn %d %s: %d ms, %d B/s", g_conn_manager[manager_index].conn_idx, level_name[i],
+                  stats->time_ms[i], (uint32_t)((uint64_t)stats->bytes[i] * 1000 / stats->time_ms[i]));
+    }
+    stats->level = 0;
+}
+
+static void cm_policy_set_level(uint8_t manager_index, uint8_t interval_level)
+{
+    if (manager_index == CM_CONN_INDEX_ERROR)
+    {
+        return;
+    }
+    g_cm_policy[manager_index].stats.level = interval_level;
+    g_cm_policy[manager_index].quiet = 0;
+}
+
+uint8_t connection_manager_policy_hold(uint8_t conn_idx, uint8_t interval_level)
+{
+    uint8_t manager_index = get_manager_index_by_connection_index(conn_idx);
+    cm_policy_link_t *policy;
+
+    if (manager_index == CM_CONN_INDEX_ERROR)
+    {
+        return CM_CONN_INDEX_ERROR;
+    }
+    if (interval_level < CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE || interval_level > CONNECTION_MANAGER_INTERVAL_LOW_POWER)
+    {
+        return CM_PARAMETER_ERROR;
+    }
+
+    policy = &g_cm_policy[manager_index];
+    policy->hold[interval_level - 1]++;
+    if (policy->stats.level > interval_level)
+        return cm_policy_switch(manager_index, interval_level, 0);
+
+    return CM_STATUS_OK;
+}
+
+uint8_t connection_manager_policy_release(uint8_t conn_idx, uint8_t interval_level)
+{
+    uint8_t manager_index = get_manager_index_by_connection_index(conn_idx);
+
+    if (manager_index == CM_CONN_INDEX_ERROR)
+    {
+        return CM_CONN_INDEX_ERROR;
+    }
+    if (interval_level < CONNECTION_MANAGER_INTERVAL_HIGH_PERFORMANCE || interval_level > CONNECTION_MANAGER_INTERVAL_LOW_POWER
+            || g_cm_policy[manager_index].hold[interval_level - 1] == 0)
+    {
+        return CM_PARAMETER_ERROR;
+    }
+
+    // link steps down after quiet periods as usual
+    g_cm_policy[manager_index].hold[interval_level - 1]--;
+    return CM_STATUS_OK;
+}
+
+void connection_manager_policy_enable(uint8_t enable)
+{
+    g_cm_policy_disabled = !enable;
+}
+
+uint8_t connection_manager_policy_get_stats(uint8_t conn_idx, connection_manager_policy_stats_t *stats)
+{
+    uint8_t manager_index = get_manager_index_by_connection_index(conn_idx);
+
+    if (manager_index == CM_CONN_INDEX_ERROR)
+    {
+        return CM_CONN_INDEX_ERROR;
+    }
+    rt_memcpy(stats, &g_cm_policy[manager_index].stats, sizeof(connection_manager_policy_stats_t));
+    return CM_STATUS_OK;
+}
+#endif // BLE_CM_ADAPTIVE_PARAM
+
 uint8_t connection_manager_set_link_security(uint8_t conn_index, uint8_t sec_level)
 {
     uint8_t manager_index = get_manager_index_by_connection_index(conn_index);
@@ -3012,6 +3295,21 @@ static void cm_cmd(uint8_t argc, char **argv)
         {
             drv_reboot();
         }
+#ifdef BLE_CM_ADAPTIVE_PARAM
+        else if (strcmp(argv[1], "policy") == 0)
+        {
+            connection_manager_policy_stats_t stats;
+            for (j = 0; j < MAX_CONNECTION_LINK_NUM; j++)
+            {
+                if (g_conn_manager[j].connection_state != CONNECTION_STATE_CONNECTED)
+                    continue;
+                stats = g_cm_policy[j].stats;
+                LOG_I("conn %d level %d switches %d, high %d ms %d B, balanced %d ms %d B, low power %d ms %d B",
+                      g_conn_manager[j].conn_idx, stats.level, stats.switches, stats.time_ms[0], stats.bytes[0],
+                      stats.time_ms[1], stats.bytes[1], stats.time_ms[2], stats.bytes[2]);
+            }
+        }
+#endif // BLE_CM_ADAPTIVE_PARAM
 #ifdef BLE_SVC_CHG_ENABLE
         else if (strcmp(argv[1], "svc_change") == 0)
         {
@@ -64,6 +64,16 @@
 
 #define BLE_UART_RETRY      3
 #define BLE_UART_TXTIMEOUT  500
+/* Times to wait for a TX credit before a notification is given up */
+#define BLE_SERIAL_TRAN_TX_RETRY   20
+
+/* Data length requested in high throughput mode */
+#ifndef BLE_SERIAL_TRAN_DLE_OCTETS
+    #define BLE_SERIAL_TRAN_DLE_OCTETS  251
+#endif
+#ifndef BLE_SERIAL_TRAN_DLE_TIME
+    #define BLE_SERIAL_TRAN_DLE_TIME    2120
+#endif
 
 #ifdef BSP_BLE_SERIAL_TRANSMISSION
 
@@ -100,8 +110,12 @@ typedef struct
     uint8_t cb_count;
     uint8_t is_assemable;
     uint16_t mtu;
+    uint8_t high_throughput;
     ble_serial_tran_export_t *cb_table;
     ble_serial_tran_assemable_t assemable;
+    /* released when a notification is acked and its TX credit returns */
+    struct rt_semaphore credit_sem;
+    ble_serial_tran_stats_t stats;
 } ble_serial_tran_env_t;
 
 
@@ -244,6 +258,8 @@ uint8_t ble_serial_tran_set_cbk(uint8_t conn_idx, sibles_set_cbk_t *para)
     {
         // should get the conn_idx from parameter
         // notify upper layer
+        env->stats.rx_packets++;
+        env->stats.rx_bytes += para->len;
         uint8_t frag_flag = *(para->value + 1);
         uint8_t cate_id = *(para->value);
         if (frag_flag != 0 && !env->is_assemable)
@@ -363,169 +379,107 @@ static uint32_t ble_serial_wait_time_get(uint8_t conn_idx)
     return wait_time;
 }
 
+/* Send one notification. If all TX credits are in flight, wait until one returns instead of
+ * sleeping a fixed time, so that controller TX buffers are refilled as soon as possible. */
+static int ble_serial_tran_write(uint8_t conn_idx, sibles_value_t *value)
+{
+    ble_serial_tran_env_t *env = ble_serial_tran_get_env();
+    int retry = BLE_SERIAL_TRAN_TX_RETRY;
+    int ret;
+
+    while (1)
+    {
+        ret = sibles_write_value(conn_idx, value);
+        if (ret != 0 || retry-- == 0)
+            break;
+
+        env->stats.credit_waits++;
+        rt_sem_take(&env->credit_sem, rt_tick_from_millisecond(ble_serial_wait_time_get(conn_idx)));
+    }
+
+    if (ret == value->len)
+    {
+        env->stats.tx_packets++;
+        env->stats.tx_bytes += ret;
+    }
+    else
+    {
+        LOG_E("send fail %d", ret);
+        env->stats.tx_fails++;
+    }
+
+    return ret;
+}
+
 int ble_serial_tran_send_data(ble_serial_tran_data_t *data)
 {
     sibles_value_t value;
     int ret;
-    uint32_t wait_time;
     ble_serial_tran_env_t *env = ble_serial_tran_get_env();
-    uint8_t *packet ;
+    uint8_t *packet;
+    uint16_t payload_len, frag_len, len, offset;
+    rt_tick_t tick;
 
     if (data == NULL || data->data == NULL)
         return -1;                                  // Parameter error;
     else if (!g_serial_tran_hdl)
         return -2;                                  // Not ready
 
-    if (data->len <= env->mtu - 3 - 4)
+    // 3 bytes ATT header
+    payload_len = env->mtu - 3;
+    if ((packet = bt_mem_alloc(payload_len)) == NULL)
+        return -3;                                  // No enough memory
+
+    tick = rt_tick_get();
+    value.hdl = g_serial_tran_hdl;
+    value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
+    value.value = packet;
+
+    *packet = data->cate_id;                        // Add cateID to packet
+    memcpy(packet + 2, &data->len, 2);
+    if (data->len <= payload_len - 4)
     {
-        if ((packet = bt_mem_alloc(data->len + 4)) == NULL)
-            return -3;                                  // No enough memory
-        *packet = data->cate_id;                        // Add cateID to packet
-        *(packet + 1) = 0;                              // first not consider fragment
-        memcpy(packet + 2, &data->len, 2);
+        *(packet + 1) = 0;                          // Completed packet
         memcpy(packet + 4, data->data, data->len);
-        value.hdl = g_serial_tran_hdl;
-        value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
         value.len = data->len + 4;
-        value.value = packet;
-
-        ret = sibles_write_value(data->handle, &value);
-        if (ret == value.len)
-        {
-            bt_mem_free(packet);
-            // write success
-            return ret;
-        }
-        else if (ret == 0)
-        {
-            // tx queue is full, wait and retry
-            int retry = 20;
-            while (retry > 0)
-            {
-                retry--;
-                wait_time = ble_serial_wait_time_get(data->handle);
-                rt_thread_mdelay(wait_time);
-                ret = sibles_write_value(data->handle, &value);
-                if (ret == value.len)
-                {
-                    LOG_I("send retry success");
-                    bt_mem_free(packet);
-                    return ret;
-                }
-            }
-            LOG_E("send fail");
-            bt_mem_free(packet);
-            return 0;
-        }
-        LOG_E("unexpect fail");
-        bt_mem_free(packet);
-        return ret;
+        ret = ble_serial_tran_write(data->handle, &value);
     }
     else
     {
-        // use fragment packet
-        uint16_t single_packet_len = env->mtu - 3 - 4;
-        uint16_t offset = 0;
-
-        while (offset < data->len)
+        // use fragment packet, only first one has length, high throughput mode fills the rest
+        frag_len = env->high_throughput ? payload_len - 2 : payload_len - 4;
+        *(packet + 1) = 1;
+        memcpy(packet + 4, data->data, payload_len - 4);
+        value.len = payload_len;
+        offset = payload_len - 4;
+        ret = ble_serial_tran_write(data->handle, &value);
+
+        while (ret == value.len && offset < data->len)
         {
-            do
+            len = data->len - offset;
+            if (len <= frag_len)
             {
-                // first packet
-                if (offset == 0)
-                {
-                    packet = bt_mem_alloc(single_packet_len);
-                    if (!packet)
-                    {
-                        return -3;
-                    }
-                    *packet = data->cate_id;                        // Add cateID to packet
-                    *(packet + 1) = 1;                              // first not consider fragment
-                    memcpy(packet + 2, &data->len, 2);
-                    memcpy(packet + 4, data->data, single_packet_len);
-                    value.hdl = g_serial_tran_hdl;
-                    value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
-                    value.len = single_packet_len + 4;
-                    value.value = packet;
-                    break;
-                }
-                else if (data->len - offset <= single_packet_len)
-                {
-                    // last packet
-                    single_packet_len = data->len - offset;
-
-                    packet = bt_mem_alloc(single_packet_len);
-                    if (!packet)
-                    {
-                        return -3;
-                    }
-
-                    *packet = data->cate_id;
-                    *(packet + 1) = 3;
-                    memcpy(packet + 2, data->data + offset, single_packet_len);
-                    value.hdl = g_serial_tran_hdl;
-                    value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
-                    value.len = single_packet_len + 2;
-                    value.value = packet;
-                    break;
-                }
-                else
-                {
-                    // continue packet
-                    packet = bt_mem_alloc(single_packet_len);
-                    if (!packet)
-                    {
-                        return -3;
-                    }
-
-                    *packet = data->cate_id;
-                    *(packet + 1) = 2;
-                    memcpy(packet + 2, data->data + offset, single_packet_len);
-                    value.hdl = g_serial_tran_hdl;
-                    value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
-                    value.len = single_packet_len + 2;
-                    value.value = packet;
-                    break;
-                }
+                *(packet + 1) = 3;                  // Last packet
             }
-            while (0);
-
-            ret = sibles_write_value(data->handle, &value);
-            if (ret == value.len)
+            else
             {
-                bt_mem_free(packet);
-                // write success
+                *(packet + 1) = 2;                  // Continue packet
+                len = frag_len;
             }
-            else if (ret == 0)
-            {
-                // tx queue is full, wait and retry
-                int retry = 20;
-                uint8_t send_success = 0;
-                while (retry > 0)
-                {
-                    retry--;
-                    wait_time = ble_serial_wait_time_get(data->handle);
-                    rt_thread_mdelay(wait_time);
-                    ret = sibles_write_value(data->handle, &value);
-                    if (ret == value.len)
-                    {
-                        bt_mem_free(packet);
-                        send_success = 1;
-                        break;
-                    }
-                }
-                if (send_success == 0)
-                {
-                    LOG_E("send fail");
-                    bt_mem_free(packet);
-                    return 0;
-                }
-            }
-
-            offset += single_packet_len;
+            memcpy(packet + 2, data->data + offset, len);
+            value.len = len + 2;
+            ret = ble_serial_tran_write(data->handle, &value);
+            offset += len;
         }
-        return data->len;
+
+        if (ret == value.len)
+            ret = data->len;
     }
+
+    bt_mem_free(packet);
+    env->stats.tx_ms += (rt_tick_get() - tick) * 1000 / RT_TICK_PER_SECOND;
+
+    return ret;
 }
 
 int ble_serial_tran_send_data_advance(uint8_t handle, uint8_t *data, uint16_t data_len)
@@ -537,34 +491,129 @@ int ble_serial_tran_send_data_advance(uint8_t handle, uint8_t *data, uint16_t da
     value.value = data;
 
     int ret;
-    ret = sibles_write_value(handle, &value);
+    ret = ble_serial_tran_write(handle, &value);
 
-    if (ret == data_len)
-    {
-        // write success
-        return data_len;
-    }
-    else if (ret == 0)
+    return ret;
+}
+
+int ble_serial_tran_stream_begin(ble_serial_tran_stream_t *stream, uint8_t handle, uint8_t cate_id, uint16_t total)
+{
+    ble_serial_tran_env_t *env = ble_serial_tran_get_env();
+    uint16_t payload_len;
+
+    if (stream == NULL)
+        return -1;                                  // Parameter error;
+    else if (!g_serial_tran_hdl)
+        return -2;                                  // Not ready
+
+    memset(stream, 0, sizeof(ble_serial_tran_stream_t));
+    // 3 bytes ATT header
+    payload_len = env->mtu - 3;
+    if ((stream->packet = bt_mem_alloc(payload_len)) == NULL)
+        return -3;                                  // No enough memory
+
+    stream->handle = handle;
+    stream->total = total;
+    stream->cap = payload_len - 4;
+    // only first packet has length, high throughput mode fills the rest
+    stream->frag_len = env->high_throughput ? payload_len - 2 : payload_len - 4;
+    stream->tick = rt_tick_get();
+    stream->packet[0] = cate_id;                    // Add cateID to packet
+    stream->packet[1] = total <= stream->cap ? 0 : 1;   // Completed or first packet
+    memcpy(stream->packet + 2, &total, 2);
+
+    return 0;
+}
+
+static int ble_serial_tran_stream_flush(ble_serial_tran_stream_t *stream)
+{
+    sibles_value_t value;
+    uint16_t head = stream->offset == 0 ? 4 : 2;
+
+    if (stream->offset != 0)
+        stream->packet[1] = stream->offset + stream->fill == stream->total ? 3 : 2;    // Last or continue packet
+
+    value.hdl = g_serial_tran_hdl;
+    value.idx = BLE_SERIAL_TRAN_DATA_VALUE;
+    value.value = stream->packet;
+    value.len = head + stream->fill;
+    if (ble_serial_tran_write(stream->handle, &value) != value.len)
+        return -4;                                  // Send fail
+
+    stream->offset += stream->fill;
+    stream->fill = 0;
+    stream->cap = stream->frag_len;
+
+    return 0;
+}
+
+int ble_serial_tran_stream_write(ble_serial_tran_stream_t *stream, const uint8_t *data, uint16_t len)
+{
+    uint16_t head, n;
+
+    if (stream == NULL || stream->packet == NULL || stream->failed)
+        return -4;
+    if (stream->offset + stream->fill + len > stream->total)
+        return -1;
+
+    while (len > 0)
     {
-        // tx queue is full, wait and retry
-        int retry = 20;
-        while (retry > 0)
+        head = stream->offset == 0 ? 4 : 2;
+        n = stream->cap - stream->fill;
+        if (n > len)
+            n = len;
+        memcpy(stream->packet + head + stream->fill, data, n);
+        stream->fill += n;
+        data += n;
+        len -= n;
+
+        if (stream->fill == stream->cap || stream->offset + stream->fill == stream->total)
         {
-            retry--;
-            uint32_t wait_time = ble_serial_wait_time_get(handle);
-            rt_thread_mdelay(wait_time);
-            ret = sibles_write_value(handle, &value);
-            if (ret == data_len)
+            if (ble_serial_tran_stream_flush(stream) != 0)
             {
-                LOG_I("send retry success");
-                return data_len;
+                stream->failed = 1;
+                return -4;
             }
         }
-        return 0;
     }
+
+    return 0;
+}
+
+int ble_serial_tran_stream_end(ble_serial_tran_stream_t *stream)
+{
+    int ret;
+
+    if (stream == NULL || stream->packet == NULL)
+        return -1;
+
+    // empty data is still sent as a completed packet
+    if (stream->total == 0 && !stream->failed && ble_serial_tran_stream_flush(stream) != 0)
+        stream->failed = 1;
+
+    ret = (!stream->failed && stream->offset == stream->total) ? stream->total : -4;
+    bt_mem_free(stream->packet);
+    stream->packet = NULL;
+    ble_serial_tran_get_env()->stats.tx_ms += (rt_tick_get() - stream->tick) * 1000 / RT_TICK_PER_SECOND;
+
     return ret;
 }
 
+void ble_serial_tran_set_high_throughput(uint8_t enable)
+{
+    ble_serial_tran_get_env()->high_throughput = enable;
+}
+
+void ble_serial_tran_get_stats(ble_serial_tran_stats_t *stats)
+{
+    *stats = ble_serial_tran_get_env()->stats;
+}
+
+void ble_serial_tran_reset_stats(void)
+{
+    memset(&ble_serial_tran_get_env()->stats, 0, sizeof(ble_serial_tran_stats_t));
+}
+
 int ble_serial_event_handler(uint16_t event_id, uint8_t *data, uint16_t len, uint32_t context)
 {
     ble_serial_tran_env_t *env = ble_serial_tran_get_env();
@@ -577,6 +626,9 @@ int ble_serial_event_handler(uint16_t event_id, uint8_t *data, uint16_t len, uin
         ble_serial_open_t chan;
         chan.handle = ind->conn_idx;
         env->mtu = 23;
+        // negotiate MTU, then data length, then PHY
+        if (env->high_throughput)
+            sibles_exchange_mtu(ind->conn_idx);
         ble_serial_callback_event_notify(BLE_SERIAL_TRAN_OPEN, (uint8_t *)&chan);
         break;
     }
@@ -584,6 +636,31 @@ int ble_serial_event_handler(uint16_t event_id, uint8_t *data, uint16_t len, uin
     {
         sibles_mtu_exchange_ind_t *ind = (sibles_mtu_exchange_ind_t *)data;
         env->mtu = ind->mtu;
+        if (env->high_throughput)
+        {
+            ble_gap_update_data_len_t dle;
+
+            dle.conn_idx = ind->conn_idx;
+            dle.tx_octets = BLE_SERIAL_TRAN_DLE_OCTETS;
+            dle.tx_time = BLE_SERIAL_TRAN_DLE_TIME;
+            ble_gap_update_data_len(&dle);
+        }
+        break;
+    }
+    case BLE_GAP_UPDATE_DATA_LENGTH_IND:
+    {
+        ble_gap_update_data_length_ind_t *ind = (ble_gap_update_data_length_ind_t *)data;
+        LOG_I("serial trans mtu %d, tx octets %d", env->mtu, ind->max_tx_octets);
+        if (env->high_throughput)
+        {
+            ble_gap_update_phy_t phy;
+
+            phy.conn_idx = ind->conn_idx;
+            phy.tx_phy = GAP_PHY_LE_2MBPS;
+            phy.rx_phy = GAP_PHY_LE_2MBPS;
+            phy.phy_opt = 0;
+            ble_gap_update_phy(&phy);
+        }
         break;
     }
     case BLE_GAP_DISCONNECTED_IND:
@@ -605,6 +682,9 @@ int ble_serial_event_handler(uint16_t event_id, uint8_t *data, uint16_t len, uin
     }
     case SIBLES_WRITE_VALUE_RSP:
     {
+        // a TX credit returns, wake up sender
+        if (env->credit_sem.value < MAX_NUM_OF_TX_PKT)
+            rt_sem_release(&env->credit_sem);
         ble_serial_callback_event_notify(BLE_SERIAL_TRAN_SEND_AVAILABLE, NULL);
         break;
     }
@@ -628,6 +708,10 @@ void ble_serial_tran_init(void)
     // Init callback table
     env->cb_table = (ble_serial_tran_export_t *)SECTION_START_ADDR(SerialTranExport);
     env->cb_count = (ble_serial_tran_export_t *)SECTION_END_ADDR(SerialTranExport) - env->cb_table;
+    rt_sem_init(&env->credit_sem, "ble_ser", 0, RT_IPC_FLAG_FIFO);
+#ifdef BLE_SERIAL_TRAN_HIGH_THROUGHPUT
+    env->high_throughput = 1;
+#endif
 
 
     svc.att_db = (struct attm_desc_128 *)&serial_trans_att_db;
@@ -639,6 +723,31 @@ void ble_serial_tran_init(void)
         sibles_register_cbk(g_serial_tran_hdl, ble_serial_tran_get_cbk, ble_serial_tran_set_cbk);
 }
 
+#ifdef RT_USING_FINSH
+static int ble_serial_stat(int argc, char **argv)
+{
+    ble_serial_tran_env_t *env = ble_serial_tran_get_env();
+    ble_serial_tran_stats_t *stats = &env->stats;
+    uint32_t speed;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        ble_serial_tran_reset_stats();
+        return 0;
+    }
+
+    /* kB/s * 100, same as example/ble/throughput */
+    speed = stats->tx_ms ? (uint32_t)((uint64_t)stats->tx_bytes * 100 / stats->tx_ms) : 0;
+    rt_kprintf("mtu %d, high throughput %d\n", env->mtu, env->high_throughput);
+    rt_kprintf("tx %d bytes, %d packets, %d ms, %d.%02d kB/s, credit waits %d, fails %d\n",
+               stats->tx_bytes, stats->tx_packets, stats->tx_ms, speed / 100, speed % 100,
+               stats->credit_waits, stats->tx_fails);
+    rt_kprintf("rx %d bytes, %d packets\n", stats->rx_bytes, stats->rx_packets);
+
+    return 0;
+}
+MSH_CMD_EXPORT(ble_serial_stat, show BLE serial transmission throughput);
+#endif
 
 #endif // BSP_BLE_SERIAL_TRANSMISSION
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
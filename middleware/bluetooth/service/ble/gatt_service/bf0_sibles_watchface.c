@@ -86,6 +86,8 @@ static void ble_watchface_error_handler(uint16_t error_type);
 static void watchface_sync_start(uint8_t type);
 static void watchface_sync_end();
 static void ble_watchface_lose_check(uint16_t result, uint32_t data_index);
+static void ble_watchface_window_ack(ble_watchface_env_t *env, uint16_t result);
+static void ble_watchface_reset_state();
 
 static ble_watchface_env_t *ble_watchface_get_env(void)
 {
@@ -112,7 +114,15 @@ static void watchface_sync_file_timer_handler(void *param)
     watchface_sync_end();
 
     // check download process
-    if (env->sync.last_index == env->current_index)
+    if (env->sync.last_index == env->current_index && env->win.size)
+    {
+        // tell remote which blocks are missing
+        rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+        ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_DOWNLOAD_NOT_ONGOING);
+        rt_mutex_release(env->win.lock);
+        watchface_sync_start(WATCHFACE_SYNC_TYPE_RSP);
+    }
+    else if (env->sync.last_index == env->current_index)
     {
         // download is not ongoing
         // ble_watchface_error_handler(BLE_WATCHFACE_STATUS_DOWNLOAD_NOT_ONGOING);
@@ -222,6 +232,213 @@ static void ble_watchface_lose_check_handle(ble_watchface_env_t *env, uint8_t *d
     watchface_sync_start(WATCHFACE_SYNC_TYPE_FILE);
 }
 
+/************************* Sliding window *******************************************/
+
+/*
+ * Remote sends up to win.size blocks without waiting for SEND_DATA_RSP. Blocks are given to
+ * app in order, one at a time, app acks each by ble_watchface_file_download_rsp() which could
+ * be called later from its own thread, e.g. after flash write is queued. Blocks received out
+ * of order are buffered. SEND_DATA_RSP carries index of first block not acked yet and bitmap
+ * of blocks received from it, remote resends blocks of window with bit cleared.
+ */
+static void ble_watchface_window_reset(ble_watchface_env_t *env)
+{
+    uint32_t i;
+
+    for (i = 0; i < BLE_WATCHFACE_WINDOW_MAX; i++)
+    {
+        if (env->win.buf[i])
+        {
+            rt_free(env->win.buf[i]);
+            env->win.buf[i] = NULL;
+        }
+    }
+    env->win.busy = 0;
+    env->win.ack = 0;
+    env->win.next = 0;
+    env->win.map = 0;
+}
+
+static void ble_watchface_window_ack(ble_watchface_env_t *env, uint16_t result)
+{
+    uint16_t data_len = 12;
+    uint8_t send_data[12];
+
+    uint16_t command = BLE_WATCHFACE_FILE_SEND_DATA_RSP;
+    rt_memcpy(send_data, &command, sizeof(uint16_t));
+    rt_memcpy(send_data + 2, &result, sizeof(uint16_t));
+    rt_memcpy(send_data + 4, &env->win.next, sizeof(uint32_t));
+    rt_memcpy(send_data + 8, &env->win.map, sizeof(uint32_t));
+
+    env->win.ack = 0;
+    ble_watchface_data_send(send_data, data_len);
+}
+
+static void ble_watchface_window_deliver(ble_watchface_env_t *env, uint8_t *data, uint16_t length)
+{
+    ble_watchface_file_download_ind_t ind;
+
+    env->win.busy = 1;
+    env->state = BLE_WATCHFACE_FILE_DOWNLOAD;
+    env->current_index = env->win.next;
+    env->receive_size += length;
+    env->win.len[env->win.next % env->win.size] = length;
+
+    ind.event = WATCHFACE_APP_FILE_DOWNLOAD;
+    ind.data_len = length;
+    ind.data = data;
+
+    env->win.in_callback = 1;
+    if (env->callback)
+    {
+        uint16_t callback_len = sizeof(ble_watchface_file_download_ind_t) + ind.data_len;
+        env->callback(WATCHFACE_APP_FILE_DOWNLOAD, callback_len, &ind);
+    }
+    else
+    {
+        ble_watchface_file_download_rsp(BLE_WATCHFACE_STATUS_OK);
+    }
+    env->win.in_callback = 0;
+}
+
+/* Give buffered blocks to app while it acks them in callback, then send one rsp for all. */
+static void ble_watchface_window_process(ble_watchface_env_t *env)
+{
+    uint32_t slot;
+
+    while (env->win.size && !env->win.busy && (env->win.map & 1))
+    {
+        slot = env->win.next % env->win.size;
+        ble_watchface_window_deliver(env, env->win.buf[slot], env->win.len[slot]);
+    }
+
+    if (env->win.ack)
+        ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_OK);
+}
+
+static void ble_watchface_window_rsp(ble_watchface_env_t *env, uint16_t result)
+{
+    uint32_t slot;
+
+    rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+    if (!env->win.busy)
+    {
+        rt_mutex_release(env->win.lock);
+        return;
+    }
+
+    slot = env->win.next % env->win.size;
+    if (env->win.buf[slot])
+    {
+        rt_free(env->win.buf[slot]);
+        env->win.buf[slot] = NULL;
+    }
+    env->win.busy = 0;
+    env->state = BLE_WATCHFACE_FILE_PROCESS;
+
+    if (result == BLE_WATCHFACE_STATUS_OK)
+    {
+        env->win.next++;
+        env->win.map >>= 1;
+        env->win.ack = 1;
+        watchface_sync_start(WATCHFACE_SYNC_TYPE_FILE);
+        if (!env->win.in_callback)
+            ble_watchface_window_process(env);
+    }
+    else if (result > BLE_WATCHFACE_STATUS_APP_ERROR)
+    {
+        watchface_sync_end();
+        ble_watchface_window_ack(env, result);
+        ble_watchface_window_reset(env);
+        ble_watchface_reset_state();
+    }
+    else
+    {
+        // block rejected by app, remote resends it
+        env->receive_size -= env->win.len[slot];
+        env->win.map &= ~1;
+        ble_watchface_window_ack(env, result);
+    }
+    rt_mutex_release(env->win.lock);
+}
+
+static void ble_watchface_window_download_handler(ble_watchface_env_t *env, uint8_t *data, uint16_t length, uint16_t all_length)
+{
+    uint32_t index, offset, slot;
+
+    if (env->state != BLE_WATCHFACE_FILE_START && env->state != BLE_WATCHFACE_FILE_PROCESS
+            && env->state != BLE_WATCHFACE_FILE_DOWNLOAD)
+    {
+        LOG_I("ble_watchface_window_download_handler unexpected state %d", env->state);
+        ble_watchface_error_handler(BLE_WATCHFACE_STATUS_STATE_ERROR);
+        return;
+    }
+
+    rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+    if (env->state == BLE_WATCHFACE_FILE_START)
+    {
+        env->state = BLE_WATCHFACE_FILE_PROCESS;
+        env->win.start_tick = rt_tick_get();
+    }
+
+    if (all_length == 0 || length < 4)
+    {
+        LOG_E("window download missing, next index: %d", env->win.next);
+        ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_INDEX_ERROR);
+        rt_mutex_release(env->win.lock);
+        return;
+    }
+
+    memcpy(&index, data, sizeof(uint32_t));
+    data += 4;
+    length -= 4;
+    LOG_D("receive data index %d, next %d, map %x", index, env->win.next, env->win.map);
+
+    watchface_sync_end();
+    offset = index - env->win.next;
+    if (index < env->win.next)
+    {
+        // resent while rsp was lost
+        ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_OK);
+    }
+    else if (offset >= env->win.size)
+    {
+        LOG_W("index %d out of window %d", index, env->win.next);
+        ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_INDEX_ERROR);
+    }
+    else if (env->win.map & (1 << offset))
+    {
+        LOG_D("duplicated index %d", index);
+    }
+    else if (offset == 0)
+    {
+        // in order, no copy
+        env->win.map |= 1;
+        ble_watchface_window_deliver(env, data, length);
+        ble_watchface_window_process(env);
+    }
+    else
+    {
+        slot = index % env->win.size;
+        env->win.buf[slot] = rt_malloc(length);
+        if (env->win.buf[slot])
+        {
+            rt_memcpy(env->win.buf[slot], data, length);
+            env->win.len[slot] = length;
+            env->win.map |= 1 << offset;
+            // report gap once, when window front moves
+            if ((~env->win.map & ((1 << offset) - 1)) && (env->win.map >> offset) == 1)
+                ble_watchface_window_ack(env, BLE_WATCHFACE_STATUS_INDEX_ERROR);
+        }
+        else
+        {
+            LOG_W("no memory for block %d", index);
+        }
+    }
+    watchface_sync_start(WATCHFACE_SYNC_TYPE_FILE);
+    rt_mutex_release(env->win.lock);
+}
+
 uint8_t ble_watchface_abort()
 {
     ble_watchface_env_t *env = ble_watchface_get_env();
@@ -232,6 +449,9 @@ uint8_t ble_watchface_abort()
     LOG_I("ble_watchface_abort");
     watchface_sync_end();
     env->state = BLE_WATCHFACE_IDLE;
+    rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+    ble_watchface_window_reset(env);
+    rt_mutex_release(env->win.lock);
 
 #ifdef BSP_BLE_CONNECTION_MANAGER
     connection_manager_update_parameter(env->conn_idx, CONNECTION_MANAGER_INTERVAL_LOW_POWER, NULL);
@@ -357,7 +577,7 @@ void ble_watchface_send_start_rsp_file_info(uint16_t result, uint16_t block_leng
         return;
     }
     uint16_t data_len = 14;
-    uint8_t send_data[14];
+    uint8_t send_data[16];
 
     uint16_t command = BLE_WATCHFACE_START_RSP;
     // TODO: set this value by app
@@ -372,10 +592,16 @@ void ble_watchface_send_start_rsp_file_info(uint16_t result, uint16_t block_leng
     rt_memcpy(send_data + 2, &result, sizeof(uint16_t));
     rt_memcpy(send_data + 4, &max_data_len, sizeof(uint16_t));
 
-    uint16_t version = WF_VERSION;
+    uint16_t version = env->win.size ? WF_WINDOW_VERSION : WF_VERSION;
     rt_memcpy(send_data + 6, &version, sizeof(uint16_t));
     rt_memcpy(send_data + 8, &block_length, sizeof(uint16_t));
     rt_memcpy(send_data + 10, &block_left, sizeof(uint32_t));
+    if (env->win.size)
+    {
+        uint16_t window = env->win.size;
+        rt_memcpy(send_data + 14, &window, sizeof(uint16_t));
+        data_len += 2;
+    }
 
     if (env->file_type == WATCHFACE_FILE_TYPE_PHOTO_PREVIEW)
     {
@@ -403,7 +629,7 @@ void ble_watchface_send_start_rsp(uint16_t result)
     ble_watchface_env_t *env = ble_watchface_get_env();
 
     uint16_t data_len = 6;
-    uint8_t send_data[6];
+    uint8_t send_data[10];
 
     uint16_t command = BLE_WATCHFACE_START_RSP;
     // TODO: set this value by app
@@ -429,6 +655,14 @@ void ble_watchface_send_start_rsp(uint16_t result)
     rt_memcpy(send_data, &command, sizeof(uint16_t));
     rt_memcpy(send_data + 2, &result, sizeof(uint16_t));
     rt_memcpy(send_data + 4, &max_data_len, sizeof(uint16_t));
+    if (env->win.size)
+    {
+        uint16_t version = WF_WINDOW_VERSION;
+        uint16_t window = env->win.size;
+        rt_memcpy(send_data + 6, &version, sizeof(uint16_t));
+        rt_memcpy(send_data + 8, &window, sizeof(uint16_t));
+        data_len += 4;
+    }
     ble_watchface_data_send(send_data, data_len);
 
     if (result != BLE_WATCHFACE_STATUS_OK)
@@ -479,6 +713,18 @@ static void ble_watchface_start_handler(ble_watchface_env_t *env, uint8_t *data,
         ind.all_files_len = 0;
     }
 
+    // window supported by remote
+    env->win.size = 0;
+    if (length > 7 && env->file_type != WATCHFACE_FILE_TYPE_PHOTO_PREVIEW)
+    {
+        env->win.size = *(data + 7);
+        if (env->win.size > BLE_WATCHFACE_WINDOW)
+            env->win.size = BLE_WATCHFACE_WINDOW;
+        if (env->win.size > BLE_WATCHFACE_WINDOW_MAX)
+            env->win.size = BLE_WATCHFACE_WINDOW_MAX;
+        LOG_I("window %d", env->win.size);
+    }
+
     if (env->callback)
     {
         uint16_t callback_len = sizeof(uint32_t) * 3;
@@ -635,6 +881,9 @@ static void ble_watchface_file_start_handler(ble_watchface_env_t *env, uint8_t *
     env->current_index = 0;
     env->receive_size = 0;
     env->total_size = ind.file_len;
+    rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+    ble_watchface_window_reset(env);
+    rt_mutex_release(env->win.lock);
 
     if (env->callback)
     {
@@ -655,6 +904,11 @@ void ble_watchface_file_download_rsp(uint16_t result)
     LOG_I("ble_watchface_file_download_rsp %d", result);
     ble_watchface_env_t *env = ble_watchface_get_env();
     uint32_t index = 0;
+    if (env->win.size)
+    {
+        ble_watchface_window_rsp(env, result);
+        return;
+    }
     if (env->state != BLE_WATCHFACE_FILE_DOWNLOAD)
     {
         return;
@@ -982,6 +1236,11 @@ static void ble_watchface_file_end_handler(ble_watchface_env_t *env, uint8_t *da
     watchface_sync_end();
     ble_watchface_file_end_ind_t ind;
     uint8_t end_status = 0;
+    if (env->win.size)
+    {
+        uint32_t ms = (rt_tick_get() - env->win.start_tick) * 1000 / RT_TICK_PER_SECOND;
+        LOG_I("window %d: %d bytes in %d ms", env->win.size, env->receive_size, ms);
+    }
     if (env->status == BLE_WATCHFACE_STATUS_OK)
     {
         if (env->receive_size != env->total_size)
@@ -1118,7 +1377,10 @@ static void ble_watchface_packet_handler(ble_watchface_protocol_t *msg, uint16_t
     case BLE_WATCHFACE_FILE_SEND_DATA:
     {
         //LOG_I("BLE_WATCHFACE_SEND_DATA %d", length);
-        ble_watchface_file_download_handler(env, msg->data, msg->length, length);
+        if (env->win.size)
+            ble_watchface_window_download_handler(env, msg->data, msg->length, length);
+        else
+            ble_watchface_file_download_handler(env, msg->data, msg->length, length);
 
         break;
     }
@@ -1211,6 +1473,8 @@ int ble_watchface_event_handler(uint16_t event_id, uint8_t *data, uint16_t len,
     {
         env->sem = rt_sem_create("wf_sem", 1, RT_IPC_FLAG_FIFO);
         OS_ASSERT(env->sem);
+        env->win.lock = rt_mutex_create("wf_win", RT_IPC_FLAG_FIFO);
+        OS_ASSERT(env->win.lock);
         break;
     }
     case BLE_GAP_CONNECTED_IND:
@@ -1251,6 +1515,9 @@ int ble_watchface_event_handler(uint16_t event_id, uint8_t *data, uint16_t len,
                 ble_watchface_error_handler(BLE_WATCHFACE_STATUS_DISCONNECT);
             }
             env->state = BLE_WATCHFACE_IDLE;
+            rt_mutex_take(env->win.lock, RT_WAITING_FOREVER);
+            ble_watchface_window_reset(env);
+            rt_mutex_release(env->win.lock);
         }
         break;
     }
@@ -70,6 +70,10 @@
     #include "bt_rt_device.h"
 #endif
 
+#if defined(BT_CM_RECONN_CACHE) && defined(BSP_SHARE_PREFS)
+    #include "share_prefs.h"
+#endif
+
 
 
 #define BT_CM_MAX_TIMEOUT (3000)
@@ -106,11 +110,18 @@ static uint32_t g_bt_cm_sp_tar = BT_CM_DEFAULT_SLAVE_BIT;
 static bt_cm_env_t g_bt_cm_env;
 static bt_cm_bonded_dev_t g_bt_bonded_dev;
 static bt_cm_gap_mode_t g_bt_gap_mode;
+#ifdef BT_CM_RECONN_CACHE
+static bt_cm_peer_cache_t g_bt_cm_cache[BT_CM_RECONN_CACHE_NUM];
+static uint8_t g_bt_cm_cache_next;
+static uint8_t g_bt_cm_cache_dirty;
+#endif
 
 static uint16_t bt_cm_get_profile_role(bt_cm_conn_role_t role, uint32_t profile_bit);
 static uint32_t bt_cm_conn_get_next_profile(bt_cm_conned_dev_t *conn);
 static uint32_t bt_cm_get_profile_target(bt_cm_conn_role_t role);
 static void bt_fsm_hook_fun(const uint8_t *string, uint8_t state, uint8_t evt);
+static uint8_t bt_cm_conn_check_profile_completed(uint32_t profile_bit, bt_cm_conn_role_t role);
+uint32_t bt_cm_filter_profile(uint32_t profile);
 
 
 bt_cm_env_t *bt_cm_get_env()
@@ -205,6 +216,9 @@ void bt_cm_delete_bonded_devs(void)
 {
     memset(&g_bt_bonded_dev, 0, sizeof(bt_cm_bonded_dev_t));
     sifli_nvds_write(SIFLI_NVDS_TYPE_BT_CM, sizeof(bt_cm_bonded_dev_t), (uint8_t *)&g_bt_bonded_dev);
+#ifdef BT_CM_RECONN_CACHE
+    bt_cm_clear_peer_cache(NULL);
+#endif
 }
 
 void bt_cm_delete_bonded_devs_and_linkkey(uint8_t *addr)
@@ -221,6 +235,9 @@ void bt_cm_delete_bonded_devs_and_linkkey(uint8_t *addr)
             sc_unpair_req(bts2_task_get_app_task_id(), &bd_addr);
         }
     }
+#ifdef BT_CM_RECONN_CACHE
+    bt_cm_clear_peer_cache(&bd_addr);
+#endif
 }
 
 bt_cm_conned_dev_t *bt_cm_get_free_conn(bt_cm_env_t *env)
@@ -461,6 +478,246 @@ static bt_cm_err_t bt_cm_profile_connect(uint32_t profile_bit, bt_cm_conned_dev_
     return err;
 }
 
+#ifdef BT_CM_RECONN_CACHE
+#define BT_CM_CACHE_PREFS "bt_cm"
+#define BT_CM_CACHE_KEY   "peer_cache"
+// AVDTP service category of media codec
+#define BT_CM_AVDTP_MEDIA_CODEC (0x07)
+
+static void bt_cm_cache_load(void)
+{
+#ifdef BSP_SHARE_PREFS
+    share_prefs_t *prefs = share_prefs_open(BT_CM_CACHE_PREFS, SHAREPREFS_MODE_PRIVATE);
+    if (prefs)
+    {
+        if (share_prefs_get_block(prefs, BT_CM_CACHE_KEY, g_bt_cm_cache, sizeof(g_bt_cm_cache)) != sizeof(g_bt_cm_cache))
+            memset(g_bt_cm_cache, 0, sizeof(g_bt_cm_cache));
+        share_prefs_close(prefs);
+    }
+#endif
+    g_bt_cm_cache_dirty = 0;
+}
+
+static void bt_cm_cache_save(void)
+{
+    if (!g_bt_cm_cache_dirty)
+        return;
+    g_bt_cm_cache_dirty = 0;
+#ifdef BSP_SHARE_PREFS
+    share_prefs_t *prefs = share_prefs_open(BT_CM_CACHE_PREFS, SHAREPREFS_MODE_PRIVATE);
+    if (prefs)
+    {
+        if (share_prefs_set_block(prefs, BT_CM_CACHE_KEY, g_bt_cm_cache, sizeof(g_bt_cm_cache)) != RT_EOK)
+            LOG_E("save reconnect cache failed");
+        share_prefs_close(prefs);
+    }
+#endif
+}
+
+static bt_cm_peer_cache_t *bt_cm_cache_find(BTS2S_BD_ADDR *bd_addr, uint8_t alloc)
+{
+    uint32_t i;
+    bt_cm_peer_cache_t *cache;
+
+    for (i = 0; i < BT_CM_RECONN_CACHE_NUM; i++)
+    {
+        if (g_bt_cm_cache[i].valid && bd_eq(&g_bt_cm_cache[i].bd_addr, bd_addr) == TRUE)
+            return &g_bt_cm_cache[i];
+    }
+
+    if (!alloc)
+        return NULL;
+
+    for (i = 0; i < BT_CM_RECONN_CACHE_NUM; i++)
+    {
+        if (!g_bt_cm_cache[i].valid)
+            break;
+    }
+    // Replace entries in turn if full
+    if (i == BT_CM_RECONN_CACHE_NUM)
+    {
+        i = g_bt_cm_cache_next;
+        g_bt_cm_cache_next = (g_bt_cm_cache_next + 1) % BT_CM_RECONN_CACHE_NUM;
+    }
+    cache = &g_bt_cm_cache[i];
+    memset(cache, 0, sizeof(bt_cm_peer_cache_t));
+    memcpy(&cache->bd_addr, bd_addr, sizeof(BTS2S_BD_ADDR));
+    cache->valid = 1;
+    g_bt_cm_cache_dirty = 1;
+
+    return cache;
+}
+
+bt_cm_peer_cache_t *bt_cm_get_peer_cache(BTS2S_BD_ADDR *bd_addr)
+{
+    return bt_cm_cache_find(bd_addr, 0);
+}
+
+void bt_cm_clear_peer_cache(BTS2S_BD_ADDR *bd_addr)
+{
+    bt_cm_peer_cache_t *cache;
+
+    if (bd_addr == NULL)
+        memset(g_bt_cm_cache, 0, sizeof(g_bt_cm_cache));
+    else if ((cache = bt_cm_cache_find(bd_addr, 0)) != NULL)
+        memset(cache, 0, sizeof(bt_cm_peer_cache_t));
+    else
+        return;
+
+    g_bt_cm_cache_dirty = 1;
+    bt_cm_cache_save();
+}
+
+// Profiles known to be rejected by peer, they are not probed on reconnect
+static uint32_t bt_cm_cache_skip_profiles(bt_cm_conned_dev_t *conn)
+{
+    bt_cm_peer_cache_t *cache = bt_cm_cache_find(&conn->info.bd_addr, 0);
+    return cache ? cache->failed : 0;
+}
+
+// Link is up: start all remaining cached profiles together instead of waiting for each confirm
+static void bt_cm_cache_fast_start(bt_cm_conned_dev_t *conn)
+{
+    bt_cm_peer_cache_t *cache = bt_cm_cache_find(&conn->info.bd_addr, 0);
+    uint32_t left;
+    uint32_t i;
+
+    if (cache == NULL || cache->profiles == 0 || conn->incoming)
+        return;
+
+    left = bt_cm_filter_profile(bt_cm_get_profile_target(conn->info.role)) & cache->profiles;
+    left &= ~(conn->conned_profiles | conn->fast_profiles);
+    conn->fast = 1;
+    for (i = 0; i < 32; i++)
+    {
+        if ((left & (1 << i)) && bt_cm_profile_connect(1 << i, conn) == BT_CM_ERR_NO_ERR)
+            conn->fast_profiles |= (1 << i);
+    }
+    LOG_I("fast reconnect, profiles %x", conn->fast_profiles);
+}
+
+/*
+ * Record result of a profile connection.
+ * Return 1 if profiles were started together, then caller should not connect next profile.
+ */
+static uint8_t bt_cm_cache_profile_result(bt_cm_conned_dev_t *conn, uint32_t profile_bit, uint8_t ok)
+{
+    bt_cm_peer_cache_t *cache = bt_cm_cache_find(&conn->info.bd_addr, 1);
+    uint32_t profiles = cache->profiles;
+    uint32_t failed = cache->failed;
+
+    if (ok)
+    {
+        cache->profiles |= profile_bit;
+        cache->failed &= ~profile_bit;
+        if (!conn->audio_ready && (profile_bit & (BT_CM_HFP | BT_CM_A2DP)))
+        {
+            uint32_t ms = (rt_tick_get() - conn->start_tick) * 1000 / RT_TICK_PER_SECOND;
+            conn->audio_ready = 1;
+            cache->time_to_audio = ms > 0xFFFF ? 0xFFFF : ms;
+            LOG_I("%s %s: time to audio %d ms, profile %x", conn->incoming ? "incoming" : "reconnect",
+                  conn->fast ? "from cache" : "one by one", ms, profile_bit);
+        }
+    }
+    else if (!conn->incoming)
+    {
+        cache->profiles &= ~profile_bit;
+        cache->failed |= profile_bit;
+    }
+
+    if (cache->profiles != profiles || cache->failed != failed)
+        g_bt_cm_cache_dirty = 1;
+
+    if (!conn->fast)
+    {
+        if (bt_cm_conn_check_profile_completed(conn->conned_profiles, conn->info.role) == 1)
+            bt_cm_cache_save();
+        return 0;
+    }
+
+    if ((conn->fast_profiles & ~conn->conned_profiles) == 0)
+    {
+        conn->sub_state = BT_CM_SUB_STATE_IDLE;
+        bt_cm_cache_save();
+    }
+    return 1;
+}
+
+#ifdef CFG_AV
+// Keep codec of stream configuration, passed as AVDTP service capabilities
+static void bt_cm_cache_codec(bt_cm_env_t *env, BTS2S_AV_SET_CFG_IND *ind)
+{
+    bt_cm_peer_cache_t *cache = NULL;
+    uint16_t pos = 0;
+    uint32_t i;
+
+    for (i = 0; i < BT_CM_MAX_CONN; i++)
+    {
+        if (env->conn_device[i].state >= BT_CM_STATE_CONNECTED
+                && (env->conn_device[i].conned_profiles & BT_CM_A2DP)
+                && env->conn_device[i].av_conn_id == ind->conn_id)
+        {
+            cache = bt_cm_cache_find(&env->conn_device[i].info.bd_addr, 1);
+            break;
+        }
+    }
+
+    if (cache == NULL || ind->serv_cap_data == NULL)
+        return;
+
+    while (pos + 2 <= ind->serv_cap_len)
+    {
+        uint8_t cat = ind->serv_cap_data[pos];
+        uint8_t len = ind->serv_cap_data[pos + 1];
+        uint8_t *cap = &ind->serv_cap_data[pos + 2];
+
+        if (pos + 2 + len > ind->serv_cap_len)
+            break;
+        // media type, codec type, codec specific information
+        if (cat == BT_CM_AVDTP_MEDIA_CODEC && len >= 2)
+        {
+            uint8_t info_len = len - 2;
+            if (info_len > BT_CM_CODEC_INFO_LEN)
+                info_len = BT_CM_CODEC_INFO_LEN;
+            if (cache->codec != cap[1] || cache->codec_len != info_len
+                    || memcmp(cache->codec_info, &cap[2], info_len) != 0)
+            {
+                cache->codec = cap[1];
+                cache->codec_len = info_len;
+                memcpy(cache->codec_info, &cap[2], info_len);
+                g_bt_cm_cache_dirty = 1;
+            }
+            break;
+        }
+        pos += 2 + len;
+    }
+}
+#endif
+
+static void bt_cm_cache_list(void)
+{
+    uint32_t i, j;
+    for (i = 0; i < BT_CM_RECONN_CACHE_NUM; i++)
+    {
+        bt_cm_peer_cache_t *cache = &g_bt_cm_cache[i];
+        if (!cache->valid)
+            continue;
+        rt_kprintf("%04X:%02X:%06lX profiles %x failed %x audio %dms codec %d:",
+                   cache->bd_addr.nap, cache->bd_addr.uap, cache->bd_addr.lap,
+                   cache->profiles, cache->failed, cache->time_to_audio, cache->codec);
+        for (j = 0; j < cache->codec_len; j++)
+            rt_kprintf(" %02x", cache->codec_info[j]);
+        rt_kprintf("\n");
+    }
+}
+#else
+#define bt_cm_cache_load()
+#define bt_cm_cache_save()
+#define bt_cm_cache_skip_profiles(conn) 0
+#define bt_cm_cache_fast_start(conn)
+#define bt_cm_cache_profile_result(conn, profile_bit, ok) 0
+#endif
+
 static void bt_cm_conn_timeout(void *parameter)
 {
     // 0 is delete, 1 is restart
@@ -541,6 +798,8 @@ static uint32_t bt_cm_conn_get_next_profile(bt_cm_conned_dev_t *conn)
         target = bt_cm_filter_profile(target);
         uint32_t left = target ^ (conn->conned_profiles & target);
         uint32_t i;
+
+        left &= ~bt_cm_cache_skip_profiles(conn);
         for (i = 0; i < 32; i++)
         {
             if (left & (1 << i))
@@ -645,6 +904,7 @@ void init_bt_cm()
 #endif
 
     read_bt_infor_from_flash();
+    bt_cm_cache_load();
 
 }
 
@@ -898,6 +1158,7 @@ int bt_cm_hf_event_handler(uint16_t event_id, uint8_t *msg)
         if (conn)
         {
             conn->conned_profiles |= BT_CM_HFP;
+            uint8_t fast = bt_cm_cache_profile_result(conn, BT_CM_HFP, ind->res == BTS2_SUCC);
             if (conn->incoming)
             {
                 if (bt_cm_conn_check_profile_completed(conn->conned_profiles, conn->info.role) == 1)
@@ -911,7 +1172,7 @@ int bt_cm_hf_event_handler(uint16_t event_id, uint8_t *msg)
                     conn->sub_state = BT_CM_SUB_STATE_IDLE;
                 }
             }
-            else
+            else if (!fast)
             {
                 uint32_t profile_bit = bt_cm_conn_get_next_profile(conn);
                 if (ind->res != 4 && profile_bit != 0)
@@ -958,6 +1219,10 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
         if (conn)
         {
             conn->conned_profiles |= BT_CM_A2DP;
+#ifdef BT_CM_RECONN_CACHE
+            conn->av_conn_id = ind->conn_id;
+#endif
+            uint8_t fast = bt_cm_cache_profile_result(conn, BT_CM_A2DP, 1);
             if (conn->incoming)
             {
                 if (bt_cm_conn_check_profile_completed(conn->conned_profiles, conn->info.role) == 1)
@@ -971,7 +1236,7 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
                     conn->sub_state = BT_CM_SUB_STATE_IDLE;
                 }
             }
-            else
+            else if (!fast)
             {
                 uint32_t profile_bit = bt_cm_conn_get_next_profile(conn);
                 if (profile_bit != 0)
@@ -997,6 +1262,10 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
         if (conn)
         {
             conn->conned_profiles |= BT_CM_A2DP;
+#ifdef BT_CM_RECONN_CACHE
+            conn->av_conn_id = ind->conn_id;
+#endif
+            uint8_t fast = bt_cm_cache_profile_result(conn, BT_CM_A2DP, ind->res == AV_ACPT);
             if (conn->incoming)
             {
                 if (bt_cm_conn_check_profile_completed(conn->conned_profiles, conn->info.role) == 1)
@@ -1010,7 +1279,7 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
                     conn->sub_state = BT_CM_SUB_STATE_IDLE;
                 }
             }
-            else
+            else if (!fast)
             {
                 uint32_t profile_bit = bt_cm_conn_get_next_profile(conn);
                 if (profile_bit != 0)
@@ -1026,6 +1295,13 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
         break;
 
     }
+#ifdef BT_CM_RECONN_CACHE
+    case BTS2MU_AV_SET_CFG_IND:
+    {
+        bt_cm_cache_codec(env, (BTS2S_AV_SET_CFG_IND *)msg);
+        break;
+    }
+#endif
     case BTS2MU_AV_DISC_IND:
     {
         BTS2S_AV_DISC_IND *ind = (BTS2S_AV_DISC_IND *)msg;
@@ -1042,6 +1318,34 @@ int bt_cm_a2dp_event_handler(uint16_t event_id, uint8_t *msg)
 #define bt_cm_a2dp_event_handler(event_id,msg) 0
 #endif
 
+#if defined(CFG_AVRCP) && defined(BT_CM_RECONN_CACHE)
+int bt_cm_avrcp_event_handler(uint16_t event_id, uint8_t *msg)
+{
+    bt_cm_env_t *env = bt_cm_get_env();
+    switch (event_id)
+    {
+    case BTS2MU_AVRCP_CONN_CFM:
+    {
+        BTS2S_AVRCP_CONN_CFM *ind = (BTS2S_AVRCP_CONN_CFM *)msg;
+        bt_cm_conned_dev_t *conn = bt_cm_find_conn_by_addr(env, &ind->bd);
+        LOG_I("avrcp conn cfm %d", ind->res);
+        // Only result is needed, AVRCP is the last one of profile chain
+        if (conn)
+        {
+            conn->conned_profiles |= BT_CM_AVRCP;
+            bt_cm_cache_profile_result(conn, BT_CM_AVRCP, ind->res == BTS2_SUCC);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return 0;
+}
+#else
+#define bt_cm_avrcp_event_handler(event_id,msg) 0
+#endif
+
 #ifdef CFG_HID
 int bt_cm_hid_event_handler(uint16_t event_id, uint8_t *msg)
 {
@@ -1413,6 +1717,9 @@ int bt_cm_hci_event_handler(uint16_t event_id, uint8_t *msg)
                 conn->incoming = ind->incoming;
                 conn->state = BT_CM_STATE_CONNECTED;
                 conn->sub_state = BT_CM_SUB_PROFILING_CONNECTING;
+#ifdef BT_CM_RECONN_CACHE
+                conn->start_tick = rt_tick_get();
+#endif
 
 #ifdef RT_USING_BT
                 bt_cm_conn_info_t *bonded_dev = bt_cm_find_bonded_dev_by_addr(acl_info.mac.addr);
@@ -1451,6 +1758,7 @@ int bt_cm_hci_event_handler(uint16_t event_id, uint8_t *msg)
                 hcia_wr_lp_settings_keep_sniff_interval(&ind->bd, HCI_LINK_POLICY_NO_CHANGE, BT_CM_SNIFF_ENTER_TIME, BT_CM_SNIFF_INV, BT_CM_SNIFF_INV, BT_CM_SNIFF_ATTEMPT, BT_CM_SNIFF_TIMEOUT, NULL);
                 bt_cm_add_bonded_dev(&conn->info, 1);
                 // Since profile cause link establishment, currently must a profile is connecting
+                bt_cm_cache_fast_start(conn);
             }
             else if (ind->st == HCI_ERR_PAGE_TIMEOUT)
             {
@@ -1520,6 +1828,8 @@ int bt_cm_hci_event_handler(uint16_t event_id, uint8_t *msg)
             bt_cm_conn_role_t role = conn->info.role;
             uint8_t is_reconn = conn->info.is_reconn;
 
+            bt_cm_cache_save();
+
             if (conn->tim_hdl)
             {
                 rt_timer_stop(conn->tim_hdl);
@@ -1585,6 +1895,10 @@ int bt_cm_event_hdl(U16 type, U16 event_id, uint8_t *msg, uint32_t context)
     {
         bt_cm_a2dp_event_handler(event_id, msg);
     }
+    else if (type == BTS2M_AVRCP)
+    {
+        bt_cm_avrcp_event_handler(event_id, msg);
+    }
     else if (type == BTS2M_HCI_CMD)
     {
         bt_cm_hci_event_handler(event_id, msg);
@@ -1656,11 +1970,18 @@ bt_cm_err_t bt_cm_connect_req(BTS2S_BD_ADDR *bd_addr, bt_cm_conn_role_t role)
         conn->info.role = role;
         conn->state = role == BT_CM_MASTER ? BT_CM_STATE_CONNECTING : BT_CM_STATE_RECONNECTING;
         conn->sub_state = BT_CM_SUB_STATE_IDLE;
+#ifdef BT_CM_RECONN_CACHE
+        conn->start_tick = rt_tick_get();
+#endif
 
         uint32_t profile_bit = bt_cm_conn_get_next_profile(conn);
         if (profile_bit)
         {
             bt_cm_err_t ret = bt_cm_profile_connect(profile_bit, conn);
+#ifdef BT_CM_RECONN_CACHE
+            // Others are started once link is up if peer is in cache
+            conn->fast_profiles = profile_bit;
+#endif
             LOG_I("Reconnect ret %d", ret);
             if (ret != BT_CM_ERR_NO_ERR)
             {
@@ -1850,6 +2171,15 @@ void bt_cm(uint8_t argc, char **argv)
                     hcia_exit_sniff_mode(&env->conn_device[i].info.bd_addr, NULL);
             }
         }
+#ifdef BT_CM_RECONN_CACHE
+        else if (strcmp(argv[1], "cache") == 0)
+        {
+            if (argc > 2 && strcmp(argv[2], "clr") == 0)
+                bt_cm_clear_peer_cache(NULL);
+            else
+                bt_cm_cache_list();
+        }
+#endif
         else if (strcmp(argv[1], "get_link_key") == 0)
         {
             uint32_t i;
@@ -199,6 +199,8 @@ typedef struct play_list
     list_hdr_t *last;
     uint32_t  cnt;
     uint32_t  cnt_th;
+    /// oldest packet is dropped above it
+    uint32_t  cnt_max;
     uint32_t  full_num;
     uint32_t  empty_num;
     uint32_t  total_num;
@@ -374,6 +376,25 @@ typedef struct
     void bt_av_snk_close(void);
     void bt_av_unregister_sdp(U16 local_role);
     void bt_av_register_sdp(U16 local_role);
+
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+/// metrics of A2DP sink adaptive jitter buffer
+typedef struct
+{
+    uint32_t jitter_us;     /* filtered packet arrival jitter */
+    uint32_t peak_us;       /* decaying peak of arrival jitter */
+    uint32_t pkt_us;        /* media duration of one packet */
+    uint16_t target;        /* target depth in packets */
+    uint16_t level;         /* current depth in packets */
+    int32_t  drift_ppm;     /* estimated clock drift, positive if source is faster */
+    int32_t  ppm;           /* current resampler step */
+    uint32_t latency_ms;    /* buffered media */
+    uint32_t underruns;
+    uint32_t overflows;
+} bt_avsnk_jb_stats_t;
+
+void bt_avsnk_get_jb_stats(bt_avsnk_jb_stats_t *stats);
+#endif
 #endif
 
 extern void bt_av_disconnect(uint8_t con_idx);
@@ -61,6 +61,10 @@
 #if defined(AUDIO_USING_MANAGER) && defined(AUDIO_BT_AUDIO)
     #include "audio_server.h"
 #endif
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+    #include <stdlib.h>
+    #include "board.h"
+#endif
 
 uint8_t   bts2s_avsnk_openFlag;//0x00:dont open a2dp profile; 0x01:open a2dp profile;
 uint8_t   frms_per_payload;
@@ -87,6 +91,32 @@ extern bts2_app_stru *bts2g_app_p;
 #define  SINK_DATA_LIST_START_THRESHOLD    (5)
 #define  SINK_DATA_LIST_MAX_THRESHOLD      (10)
 
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+/*
+ * Adaptive jitter buffer: start threshold and drop level of playlist follow measured arrival
+ * jitter instead of fixed 5/10 packets, and clock drift between source and local codec is
+ * absorbed by a fractional resampler driven by playlist level.
+ */
+#ifndef CFG_AV_SNK_JB_MIN
+    #define CFG_AV_SNK_JB_MIN               (3)     /* packets */
+#endif
+#ifndef CFG_AV_SNK_JB_MAX
+    #define CFG_AV_SNK_JB_MAX               (12)    /* packets, playlist holds at most twice */
+#endif
+#ifndef CFG_AV_SNK_JB_MARGIN_US
+    #define CFG_AV_SNK_JB_MARGIN_US         (10000)
+#endif
+#ifndef CFG_AV_SNK_JB_MAX_PPM
+    #define CFG_AV_SNK_JB_MAX_PPM           (500)
+#endif
+/* clean packets before one underrun boost packet is given back */
+#define  JB_BOOST_DECAY_PKTS               (2000)
+#define  JB_BOOST_MAX                      (4)
+/* resampler position, Q20 */
+#define  JB_FRAC_BITS                      (20)
+#define  JB_RESAMPLE_MAX_FRAMES            (4000)
+#endif
+
 
 
 
@@ -123,7 +153,7 @@ static uint8_t list_push_back(play_list_t *list, list_hdr_t *hdr)
     ret = (list->cnt >= list->cnt_th) ? 1 : 0;
 
     //RT_ASSERT(list->cnt <= 100);
-    if (list->cnt > SINK_DATA_LIST_MAX_THRESHOLD)
+    if (list->cnt > list->cnt_max)
     {
         //USER_TRACE("list->cnt= %d\n", list->cnt);
         list->full_num++;
@@ -180,6 +210,238 @@ static void list_all_free(play_list_t *list)
 }
 
 
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+typedef struct
+{
+    /* arrival, updated by BT thread */
+    uint8_t  ref_valid;
+    uint32_t ref_tick;          /* HAL_GTIMER of last packet */
+    uint32_t ref_ts;            /* RTP timestamp of last packet */
+    uint32_t jitter_us;
+    uint32_t peak_us;
+    uint32_t pkt_us;
+    uint16_t target;
+    uint16_t boost;
+    uint32_t clean_pkts;
+    uint32_t overflows;
+    /* drift, updated by playback thread */
+    int32_t  level_q8;
+    int32_t  integ_q8;          /* integral term, ppm in Q8 */
+    int32_t  ppm;
+    uint32_t underruns;
+    uint32_t pos;               /* resampler position from prev frame, Q20 */
+    int16_t  prev[2];
+    int16_t  *out;
+    uint16_t out_size;
+} bt_avsnk_jb_t;
+
+static bt_avsnk_jb_t g_jb;
+
+static void jb_free(void)
+{
+    if (g_jb.out)
+    {
+        bfree(g_jb.out);
+        g_jb.out = NULL;
+        g_jb.out_size = 0;
+    }
+}
+
+/* Stream is over, forget estimates of this source. */
+static void jb_reset(play_list_t *list)
+{
+    if (g_jb.pkt_us)
+        USER_TRACE("a2dp jb: jitter %dus, peak %dus, drift %dppm, underrun %d, overflow %d\n",
+                   g_jb.jitter_us, g_jb.peak_us, g_jb.integ_q8 >> 8, g_jb.underruns, g_jb.overflows);
+    jb_free();
+    memset(&g_jb, 0, sizeof(g_jb));
+    g_jb.target = SINK_DATA_LIST_START_THRESHOLD;
+    list->cnt_th = SINK_DATA_LIST_START_THRESHOLD;
+    list->cnt_max = SINK_DATA_LIST_MAX_THRESHOLD;
+}
+
+/* Playback (re)starts, jitter and drift estimates are kept. */
+static void jb_on_start(play_list_t *list)
+{
+    g_jb.level_q8 = (int32_t)(list->cnt << 8);
+    g_jb.ppm = g_jb.integ_q8 >> 8;
+    g_jb.pos = 0;
+    g_jb.prev[0] = 0;
+    g_jb.prev[1] = 0;
+}
+
+static void jb_update_target(play_list_t *list)
+{
+    uint32_t target;
+
+    if (g_jb.pkt_us == 0)
+        return;
+
+    target = (g_jb.peak_us + 2 * g_jb.jitter_us + CFG_AV_SNK_JB_MARGIN_US + g_jb.pkt_us - 1) / g_jb.pkt_us;
+    target += g_jb.boost;
+    if (target < CFG_AV_SNK_JB_MIN)
+        target = CFG_AV_SNK_JB_MIN;
+    else if (target > CFG_AV_SNK_JB_MAX)
+        target = CFG_AV_SNK_JB_MAX;
+
+    g_jb.target = target;
+    /* start threshold is used for next start only, running stream reaches target by resampler */
+    list->cnt_th = target;
+    list->cnt_max = target * 2;
+}
+
+/* Called with RTP header of a media packet before it is queued. */
+static void jb_on_arrival(bts2s_av_inst_data *inst, uint8_t con_idx, const U8 *rtp)
+{
+    uint32_t now = HAL_GTIMER_READ();
+    uint32_t ts = ((uint32_t)rtp[4] << 24) | ((uint32_t)rtp[5] << 16) | ((uint32_t)rtp[6] << 8) | rtp[7];
+    uint32_t freq = inst->con[con_idx].act_cfg.sample_freq;
+    uint32_t local_us, media_us, d;
+
+    if (!g_jb.ref_valid || freq == 0)
+    {
+        g_jb.ref_valid = 1;
+        g_jb.ref_tick = now;
+        g_jb.ref_ts = ts;
+        return;
+    }
+
+    local_us = (uint32_t)((uint64_t)(now - g_jb.ref_tick) * 1000000 / HAL_LPTIM_GetFreq());
+    media_us = (uint32_t)((uint64_t)(ts - g_jb.ref_ts) * 1000000 / freq);
+    g_jb.ref_tick = now;
+    g_jb.ref_ts = ts;
+
+    /* source restarted its timestamps or a very long gap, don't take it as jitter */
+    if (media_us == 0 || media_us > 1000000 || local_us > 2000000)
+        return;
+
+    g_jb.pkt_us = g_jb.pkt_us ? (g_jb.pkt_us * 7 + media_us) / 8 : media_us;
+
+    /* RFC 3550 interarrival jitter, plus a slowly decaying peak for bursty links */
+    d = (uint32_t)abs((int32_t)(local_us - media_us));
+    g_jb.jitter_us += ((int32_t)d - (int32_t)g_jb.jitter_us) / 16;
+    g_jb.peak_us -= g_jb.peak_us / 128;
+    if (d > g_jb.peak_us)
+        g_jb.peak_us = d;
+
+    if (g_jb.boost && ++g_jb.clean_pkts >= JB_BOOST_DECAY_PKTS)
+    {
+        g_jb.boost--;
+        g_jb.clean_pkts = 0;
+    }
+
+    jb_update_target(&inst->snk_data.playlist);
+}
+
+static void jb_on_underrun(play_list_t *list)
+{
+    g_jb.underruns++;
+    g_jb.clean_pkts = 0;
+    if (g_jb.boost < JB_BOOST_MAX)
+        g_jb.boost++;
+    jb_update_target(list);
+}
+
+/* Sampled once per audio cache refill, gives the resampler step in ppm. */
+static void jb_on_refill(play_list_t *list)
+{
+    int32_t err, ppm;
+
+    g_jb.level_q8 += ((int32_t)(list->cnt << 8) - g_jb.level_q8) / 32;
+    err = g_jb.level_q8 - (int32_t)(g_jb.target << 8);
+
+    /* PI loop: integral term converges to clock drift, proportional term moves level to target */
+    g_jb.integ_q8 += err / 64;
+    if (g_jb.integ_q8 > (CFG_AV_SNK_JB_MAX_PPM << 8))
+        g_jb.integ_q8 = CFG_AV_SNK_JB_MAX_PPM << 8;
+    else if (g_jb.integ_q8 < -(CFG_AV_SNK_JB_MAX_PPM << 8))
+        g_jb.integ_q8 = -(CFG_AV_SNK_JB_MAX_PPM << 8);
+
+    ppm = (err * 20 + g_jb.integ_q8) >> 8;
+    if (ppm > CFG_AV_SNK_JB_MAX_PPM)
+        ppm = CFG_AV_SNK_JB_MAX_PPM;
+    else if (ppm < -CFG_AV_SNK_JB_MAX_PPM)
+        ppm = -CFG_AV_SNK_JB_MAX_PPM;
+    g_jb.ppm = ppm;
+}
+
+/*
+ * Linear interpolation of 16 bit stereo by (1 + ppm / 1e6), positive ppm consumes input faster.
+ * Previous frame is kept so that interpolation is continuous across packets.
+ */
+static U8 *jb_resample(U8 *data, U16 *len)
+{
+    const int16_t *in = (const int16_t *)data;
+    uint32_t n = *len / 4;
+    uint32_t step, pos, i, f, o = 0;
+    int32_t a, b;
+
+    if (n == 0 || n > JB_RESAMPLE_MAX_FRAMES)
+        return data;
+
+    if (g_jb.out_size < (n + 4) * 4)
+    {
+        jb_free();
+        g_jb.out = bmalloc((n + 4) * 4);
+        if (g_jb.out == NULL)
+            return data;
+        g_jb.out_size = (n + 4) * 4;
+    }
+
+    step = (1 << JB_FRAC_BITS) + (int32_t)((int64_t)g_jb.ppm * (1 << JB_FRAC_BITS) / 1000000);
+    pos = g_jb.pos;
+    while ((i = pos >> JB_FRAC_BITS) < n && o < n + 4)
+    {
+        f = (pos & ((1 << JB_FRAC_BITS) - 1)) >> (JB_FRAC_BITS - 15);
+        a = i ? in[(i - 1) * 2] : g_jb.prev[0];
+        b = in[i * 2];
+        g_jb.out[o * 2] = (int16_t)(a + (((b - a) * (int32_t)f) >> 15));
+        a = i ? in[(i - 1) * 2 + 1] : g_jb.prev[1];
+        b = in[i * 2 + 1];
+        g_jb.out[o * 2 + 1] = (int16_t)(a + (((b - a) * (int32_t)f) >> 15));
+        o++;
+        pos += step;
+    }
+    g_jb.pos = pos - (n << JB_FRAC_BITS);
+    g_jb.prev[0] = in[(n - 1) * 2];
+    g_jb.prev[1] = in[(n - 1) * 2 + 1];
+
+    *len = o * 4;
+    return (U8 *)g_jb.out;
+}
+
+void bt_avsnk_get_jb_stats(bt_avsnk_jb_stats_t *stats)
+{
+    play_list_t *list = &bt_av_get_inst_data()->snk_data.playlist;
+
+    stats->jitter_us = g_jb.jitter_us;
+    stats->peak_us = g_jb.peak_us;
+    stats->pkt_us = g_jb.pkt_us;
+    stats->target = g_jb.target;
+    stats->level = list->cnt;
+    stats->drift_ppm = g_jb.integ_q8 >> 8;
+    stats->ppm = g_jb.ppm;
+    stats->latency_ms = list->cnt * g_jb.pkt_us / 1000;
+    stats->underruns = g_jb.underruns;
+    stats->overflows = g_jb.overflows;
+}
+
+static int a2dp_jb(int argc, char **argv)
+{
+    bt_avsnk_jb_stats_t st;
+
+    bt_avsnk_get_jb_stats(&st);
+    rt_kprintf("a2dp jb: level %d target %d (%dms) pkt %dus\n", st.level, st.target, st.latency_ms, st.pkt_us);
+    rt_kprintf("jitter %dus peak %dus, drift %dppm step %dppm\n", st.jitter_us, st.peak_us, st.drift_ppm, st.ppm);
+    rt_kprintf("underrun %d overflow %d\n", st.underruns, st.overflows);
+    return 0;
+}
+MSH_CMD_EXPORT(a2dp_jb, show A2DP sink jitter buffer state);
+
+#else
+#define JB_PLAY_DATA_DECODE(inst, len)  play_data_decode(inst, len)
+#endif
+
 static int audio_bt_music_client_cb(audio_server_callback_cmt_t cmd, void *userdata, uint32_t unused)
 {
     (void)userdata;
@@ -335,6 +597,19 @@ static U8 *play_data_decode(bts2s_av_inst_data *inst, U16 *out_len)
 }
 
 
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+static U8 *jb_play_data_decode(bts2s_av_inst_data *inst, U16 *out_len)
+{
+    U8 *data = play_data_decode(inst, out_len);
+
+    if (data && *out_len)
+        data = jb_resample(data, out_len);
+
+    return data;
+}
+#define JB_PLAY_DATA_DECODE(inst, len)  jb_play_data_decode(inst, len)
+#endif
+
 static void decode_playback_thread(void *args)
 {
     bts2s_av_inst_data *inst_data;
@@ -368,7 +643,10 @@ static void decode_playback_thread(void *args)
                 continue;
             }
 
-            decode_data = play_data_decode(inst_data, &decode_len);
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+            jb_on_start(&inst_data->snk_data.playlist);
+#endif
+            decode_data = JB_PLAY_DATA_DECODE(inst_data, &decode_len);
             //interval = decode_len * 1000 / BT_MUSIC_SAMPLERATE / 4; //use interval to rt_event_recv will crash rt_free
             USER_TRACE("bt_music: open len=%d\r\n", decode_len);
 
@@ -400,10 +678,17 @@ static void decode_playback_thread(void *args)
                 USER_TRACE("snk: stop %d %d %x\r\n", is_stopped, inst_data->snk_data.play_state, inst_data->snk_data.audio_client);
                 continue;
             }
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+            jb_on_refill(&inst_data->snk_data.playlist);
+#endif
         }
 
         if (decode_len == 0)
         {
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+            if (!is_stopped)
+                jb_on_underrun(&inst_data->snk_data.playlist);
+#endif
             //decode_data = play_data_decode(inst_data, &decode_len);
             decode_len = 2560;
             decode_data = inst_data->snk_data.decode_buf;
@@ -424,7 +709,7 @@ static void decode_playback_thread(void *args)
             }
             else
             {
-                decode_data = play_data_decode(inst_data, &decode_len);
+                decode_data = JB_PLAY_DATA_DECODE(inst_data, &decode_len);
             }
         }
 
@@ -484,6 +769,9 @@ static void stop_audio_playback(bts2s_av_inst_data *inst)
     }
 
     list_all_free(&(inst->snk_data.playlist));
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+    jb_reset(&(inst->snk_data.playlist));
+#endif
 
     if (inst->snk_data.decode_buf)
     {
@@ -727,6 +1015,7 @@ static void bt_avsnk_init_data(bts2s_avsnk_inst_data *inst, bts2_app_stru *bts2_
 {
     inst->playlist.cnt = 0;
     inst->playlist.cnt_th = SINK_DATA_LIST_START_THRESHOLD;
+    inst->playlist.cnt_max = SINK_DATA_LIST_MAX_THRESHOLD;
     inst->playlist.first = NULL;
     inst->playlist.last = NULL;
     inst->play_state = FALSE;
@@ -1132,6 +1421,10 @@ void bt_avsnk_hdl_streamdata_ind(bts2s_av_inst_data *inst, uint8_t con_idx, BTS2
         play_data_t *pt_data = (play_data_t *)msg->data;
         uint8_t ret;
 
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+        /* RTP header is overwritten by list header below */
+        jb_on_arrival(inst, con_idx, msg->data);
+#endif
         pt_data->len = msg->len;
         ret = list_push_back(&inst->snk_data.playlist, &(pt_data->hdr));
         if ((inst->snk_data.play_state == FALSE) && (ret == 1))
@@ -1145,6 +1438,9 @@ void bt_avsnk_hdl_streamdata_ind(bts2s_av_inst_data *inst, uint8_t con_idx, BTS2
             list_hdr_t *hdr;
             hdr = list_pop_front(&inst->snk_data.playlist);
             bfree(hdr);
+#ifdef CFG_AV_SNK_ADAPTIVE_JB
+            g_jb.overflows++;
+#endif
         }
 #else
         bfree(msg->data);
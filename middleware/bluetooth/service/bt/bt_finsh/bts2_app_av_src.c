@@ -66,6 +66,20 @@
     static FILE *stream;
 #endif // AUDIO_DATA_TEST
 
+#ifndef AUDIO_DATA_TEST
+    /* SBC encoding cost of A2DP source, see avsrc_sbc */
+    typedef struct
+    {
+        uint32_t cycles;        /* total cycles of encoding */
+        uint32_t max_cycles;    /* max cycles of one packet */
+        uint32_t frms;          /* encoded frames */
+        uint32_t pkts;          /* encoded packets */
+        uint32_t zero_copy;     /* packets encoded in place from ring buffer */
+    } bt_avsrc_sbc_perf_t;
+
+    static bt_avsrc_sbc_perf_t sbc_perf;
+#endif
+
 #ifdef AUDIO_USING_MANAGER
     #include "audio_server.h"
 #endif // AUDIO_USING_MANAGER
@@ -582,6 +596,11 @@ U8 bt_avsrc_prepare_sbc(bts2s_av_inst_data *inst, U8 con_idx)
 
     if (cfg->frmsize != 0)
     {
+#ifndef AUDIO_DATA_TEST
+        if (!HAL_DBG_DWT_IsInit())
+            HAL_DBG_DWT_Init();
+        memset(&sbc_perf, 0, sizeof(sbc_perf));
+#endif
         /* calculate how many sbc frms fit into maximum size payload pkt */
         cfg->frms_per_payload = (U16)((inst->max_frm_size - 14) / cfg->frmsize);
         //cfg->frms_per_payload = 7;
@@ -1029,6 +1048,46 @@ static void bt_avsrc_send_data(U16 m, void *data)
 }
 #else
 
+/*
+ * Encode PCM of one L2CAP packet. Whole packet is passed to encoder in one call,
+ * so it runs frames back to back instead of once per frame.
+ */
+static U8 bt_avsrc_encode_frms(bts2_sbc_cfg *cfg, U8 *pcm, U16 pcm_len, U8 *dst, U16 dst_len)
+{
+    U8 frms = 0;
+    uint32_t cycles = HAL_DBG_DWT_GetCycles();
+
+    while (pcm_len > 0)
+    {
+        BTS2S_SBC_STREAM bss;
+
+        bss.psrc = pcm;
+        bss.src_len = pcm_len;
+        bss.pdst = dst;
+        bss.dst_len = dst_len;
+
+        bts2_sbc_encode(&bss);
+
+        if (bss.src_len_used == 0)
+            break;
+
+        pcm += bss.src_len_used;
+        pcm_len -= bss.src_len_used;
+        dst += bss.dst_len_used;
+        dst_len -= bss.dst_len_used;
+        frms += bss.dst_len_used / cfg->frmsize;
+    }
+
+    cycles = HAL_DBG_DWT_GetCycles() - cycles;
+    sbc_perf.cycles += cycles;
+    if (cycles > sbc_perf.max_cycles)
+        sbc_perf.max_cycles = cycles;
+    sbc_perf.frms += frms;
+    sbc_perf.pkts++;
+
+    return frms;
+}
+
 static uint16_t bt_avsrc_send_data(struct rt_ringbuffer *rb)
 {
     bts2s_av_inst_data *inst = bt_av_get_inst_data();
@@ -1037,14 +1096,12 @@ static uint16_t bt_avsrc_send_data(struct rt_ringbuffer *rb)
     U8 *payload_ptr  = NULL;
     U8 *sbc_frm_ptr = NULL;
     U8 *samples_ptr = NULL;
-    U8 *tmp_ptr = NULL;
     U8 frms;
     U16 payload_size;
     size_t bytes_rd = 0;
     U32 actual_time_expired;
     U32 actual_timer_delay;
     int con_idx;
-    int numrd;
     bts2_sbc_cfg *act_cfg  = NULL;
     U16 i;
     U16 payload_len;
@@ -1062,10 +1119,6 @@ static uint16_t bt_avsrc_send_data(struct rt_ringbuffer *rb)
     {
         do
         {
-            U32 pcm_pkg_pos;
-            U32 sb_pos = 0;
-            U32 rd_len = 0;
-            U16 pl;
             U16 buffer_count = av_get_stream_buffize();
 
 
@@ -1123,23 +1176,51 @@ static uint16_t bt_avsrc_send_data(struct rt_ringbuffer *rb)
                 is_empty = 1;
             }
 
-            uint8_t *ptr = bcalloc(1, act_cfg->bytes_to_rd);
-            if (!ptr)
-                break;
+            uint8_t *ptr = NULL;
+
+            /* Encode in place if PCM of the packet doesn't wrap around ring buffer */
+            samples_ptr = NULL;
+            if (!is_empty && rt_ringbuffer_get_read_span((struct rt_ringbuffer *)rb, &samples_ptr) < act_cfg->bytes_to_rd)
+                samples_ptr = NULL;
+
+            if (!samples_ptr)
+            {
+                ptr = bcalloc(1, act_cfg->bytes_to_rd);
+                if (!ptr)
+                    break;
+                if (!is_empty)
+                    rt_ringbuffer_get((struct rt_ringbuffer *)rb, ptr, act_cfg->bytes_to_rd);
+                samples_ptr = ptr;
+            }
 
             payload_size = act_cfg->frms_per_payload * act_cfg->frmsize;
             pkt_ptr = bmalloc(payload_size + AV_FIXED_MEDIA_PKT_HDR_SIZE + 1);
 
             if (!pkt_ptr)
             {
-                bfree(ptr);
+                if (ptr)
+                    bfree(ptr);
                 break;
             }
 
-            if (!is_empty)
+            payload_ptr = sbc_frm_ptr = pkt_ptr + AV_FIXED_MEDIA_PKT_HDR_SIZE;
+            bytes_rd = act_cfg->bytes_to_rd;
+            *sbc_frm_ptr++ = 0; /*reserve space for payload header */
+
+            frms = bt_avsrc_encode_frms(act_cfg, samples_ptr, bytes_rd, sbc_frm_ptr, payload_size);
+
+            if (ptr)
+            {
+                bfree(ptr);
+            }
+            else
             {
-                rt_ringbuffer_get((struct rt_ringbuffer *)rb, ptr, act_cfg->bytes_to_rd);
+                rt_ringbuffer_read_commit((struct rt_ringbuffer *)rb, act_cfg->bytes_to_rd);
+                sbc_perf.zero_copy++;
+            }
 
+            if (!is_empty)
+            {
                 len = rt_ringbuffer_data_len((struct rt_ringbuffer *)rb);
 #ifdef AUDIO_USING_MANAGER
                 if ((len <= rt_ringbuffer_get_size((struct rt_ringbuffer *)rb) / 2)
@@ -1153,40 +1234,6 @@ static uint16_t bt_avsrc_send_data(struct rt_ringbuffer *rb)
 #endif
             }
 
-            payload_ptr = sbc_frm_ptr = pkt_ptr + AV_FIXED_MEDIA_PKT_HDR_SIZE;
-            frms = 0;
-            numrd = bytes_rd = act_cfg->bytes_to_rd;
-
-            samples_ptr = ptr;
-            *sbc_frm_ptr++ = 0; /*reserve space for payload header */
-
-            pcm_pkg_pos = AV_FIXED_MEDIA_PKT_HDR_SIZE + 1;
-            pl = payload_size;
-
-            while (numrd > 0)
-            {
-                BTS2S_SBC_STREAM bss;
-
-                bss.dst_len = pl;
-                bss.pdst = &pkt_ptr[pcm_pkg_pos];
-                bss.src_len = numrd;
-                bss.psrc = &samples_ptr[sb_pos];
-
-                bts2_sbc_encode(&bss);
-
-                sb_pos += bss.src_len_used;
-                rd_len -= bss.src_len_used;
-
-                samples_ptr += bss.src_len_used;
-                numrd -= bss.src_len_used;
-
-
-                pcm_pkg_pos += bss.dst_len_used;
-                pl -= bss.dst_len_used;
-                frms += bss.dst_len_used / act_cfg->frmsize;
-            }
-
-            bfree(ptr);
             payload_len = (U16)(frms * act_cfg->frmsize + 1 + AV_FIXED_MEDIA_PKT_HDR_SIZE);
             if (frms > 0)
             {
@@ -1254,6 +1301,153 @@ BOOL bt_avrc_check_stream_state(void)
     }
 }
 
+#ifdef RT_USING_FINSH
+#define AVSRC_SBC_BENCH_FRMS    10      /* frames per packet */
+#define AVSRC_SBC_BENCH_PKTS    35      /* about 1s at 44.1kHz */
+
+static uint32_t avsrc_sbc_crc32(uint32_t crc, const U8 *data, uint32_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void avsrc_sbc_perf_print(uint32_t sample_freq, uint32_t samples_per_frm)
+{
+    uint32_t mips_x100 = 0;
+
+    if (sbc_perf.frms)
+        mips_x100 = (uint32_t)((uint64_t)sbc_perf.cycles * sample_freq / samples_per_frm / sbc_perf.frms / 10000);
+
+    rt_kprintf("sbc: %d pkts(%d in place), %d frms, %d cycles/frm, max %d cycles/pkt, %d.%02d MIPS, HCLK %dMHz\n",
+               sbc_perf.pkts, sbc_perf.zero_copy, sbc_perf.frms,
+               sbc_perf.frms ? sbc_perf.cycles / sbc_perf.frms : 0, sbc_perf.max_cycles,
+               mips_x100 / 100, mips_x100 % 100, HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000);
+}
+
+/* Deterministic stereo PCM, same input on every run to compare output with reference encoder */
+static void avsrc_sbc_bench_pcm(int16_t *pcm, uint32_t samples, uint32_t seed)
+{
+    uint32_t x = 0x12345678 + seed * 0x9E3779B9;
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        x = x * 1103515245 + 12345;
+        /* ramp plus small noise, left and right differ for joint stereo */
+        pcm[2 * i] = (int16_t)(((seed * samples + i) * 181) & 0x3FFF) - 0x2000 + (int16_t)((x >> 20) & 0xFF);
+        pcm[2 * i + 1] = (int16_t)((x >> 16) & 0x7FFF) - 0x4000;
+    }
+}
+
+/*
+ * Encode AVSRC_SBC_BENCH_PKTS packets of 44.1kHz joint stereo, 16 blocks, 8 subbands, bitpool 53,
+ * once with whole packet per call and once frame by frame, outputs must be identical.
+ */
+static int avsrc_sbc_bench(void)
+{
+    bts2_sbc_cfg cfg;
+    uint32_t frm_pcm = 16 * 8 * 2 * 2;
+    uint32_t pcm_len = frm_pcm * AVSRC_SBC_BENCH_FRMS;
+    uint32_t crc[2] = {0, 0};
+    U8 *pcm, *out;
+
+    if (bt_avrc_check_stream_state())
+    {
+        rt_kprintf("a2dp is streaming, stop it first\n");
+        return -1;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.frmsize = bts2_sbc_encode_cfg(SBC_JOINT_STEREO, SBC_METHOD_LOUDNESS, 44100, 16, 8, 53);
+    if (cfg.frmsize == 0)
+        return -1;
+
+    pcm = bmalloc(pcm_len);
+    out = bmalloc(cfg.frmsize * AVSRC_SBC_BENCH_FRMS);
+    if (!pcm || !out)
+    {
+        rt_kprintf("no memory\n");
+        goto exit;
+    }
+
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        /* configure again to start from same filter state */
+        bts2_sbc_encode_cfg(SBC_JOINT_STEREO, SBC_METHOD_LOUDNESS, 44100, 16, 8, 53);
+        memset(&sbc_perf, 0, sizeof(sbc_perf));
+
+        for (uint32_t p = 0; p < AVSRC_SBC_BENCH_PKTS; p++)
+        {
+            U8 frms = 0;
+
+            avsrc_sbc_bench_pcm((int16_t *)pcm, pcm_len / 4, p);
+            if (pass == 0)
+            {
+                frms = bt_avsrc_encode_frms(&cfg, pcm, pcm_len, out, cfg.frmsize * AVSRC_SBC_BENCH_FRMS);
+            }
+            else
+            {
+                for (uint32_t f = 0; f < AVSRC_SBC_BENCH_FRMS; f++)
+                    frms += bt_avsrc_encode_frms(&cfg, pcm + f * frm_pcm, frm_pcm, out + frms * cfg.frmsize, cfg.frmsize);
+            }
+            crc[pass] = avsrc_sbc_crc32(crc[pass], out, frms * cfg.frmsize);
+        }
+
+        rt_kprintf("%s: ", pass == 0 ? "per packet" : "per frame");
+        avsrc_sbc_perf_print(44100, 16 * 8);
+    }
+
+    rt_kprintf("output crc32 %08x %08x, %s\n", crc[0], crc[1], crc[0] == crc[1] ? "bit exact" : "MISMATCH");
+
+exit:
+    bts2_sbc_encode_completed();
+    memset(&sbc_perf, 0, sizeof(sbc_perf));
+    if (pcm)
+        bfree(pcm);
+    if (out)
+        bfree(out);
+    return 0;
+}
+
+static int avsrc_sbc(int argc, char **argv)
+{
+    bts2s_av_inst_data *inst = bt_av_get_inst_data();
+    int con_idx;
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return avsrc_sbc_bench();
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        memset(&sbc_perf, 0, sizeof(sbc_perf));
+        return 0;
+    }
+
+    con_idx = bt_avsrc_get_plyback_conn(inst);
+    if (con_idx == -1)
+    {
+        rt_kprintf("no a2dp source connection\n");
+        return 0;
+    }
+
+    bts2_sbc_cfg *cfg = &inst->con[con_idx].act_cfg;
+    rt_kprintf("%dHz, mode %d, %d blocks, %d subbands, bitpool %d, %d frms per pkt\n", cfg->sample_freq,
+               cfg->chnl_mode, cfg->blocks, cfg->subbands, cfg->bit_pool, cfg->frms_per_payload);
+    avsrc_sbc_perf_print(cfg->sample_freq, cfg->blocks * cfg->subbands);
+
+    return 0;
+}
+MSH_CMD_EXPORT(avsrc_sbc, avsrc_sbc [bench|reset]: A2DP source SBC encoding cost);
+#endif /* RT_USING_FINSH */
+
 
 #endif
 
@@ -71,22 +71,25 @@ const char *CARD_ParserVersion()
 typedef enum {cp_PropName, cp_ParamBN, cp_ParamIN, cp_ValueBV, cp_ValueIV, cp_PropData} TCARDParserState;
 typedef enum {cp_EncodingNone, cp_EncodingQP, cp_EncodingBase64, cp_Encoding8Bit} TCARDParserEncoding;
 
+/* Terminators of propname, param names and values are kept even when line is full */
+#define CARD_LINE_BUF_SIZE  (CARD_MAX_LINE_LEN + CARD_MAX_PARAMS * 2 + 2)
+
 typedef struct
 {
     /* folding stuff */
     int startOfLine;
     int folding;
 
-    /* inital buffer */
-    char *lineBuf;
-    int lbSize;
+    /* line buffer, fixed size */
+    char lineBuf[CARD_LINE_BUF_SIZE];
     int lbLen;
 
     /* line parsing state */
     TCARDParserState state;
     int startOfData;
-    CARD_Char **params;
+    CARD_Char *params[(CARD_MAX_PARAMS + 1) * 2];
     int nParams;
+    int paramSkip;
     int valueEscape;
     TCARDParserEncoding encoding;
     int     decoding;
@@ -106,14 +109,9 @@ void vcard_clear_line(VP *vp)
 {
     vp->state = cp_PropName;
     vp->lbLen = 0;
-    if (vp->lbSize > 1024)
-    {
-        bfree(vp->lineBuf);
-        vp->lineBuf = NULL;
-        vp->lbSize = 0;
-    };
     vp->startOfData = TRUE;
     vp->nParams = 0;
+    vp->paramSkip = FALSE;
     vp->valueEscape = FALSE;
     vp->encoding = cp_EncodingNone;
     vp->decoding = FALSE;
@@ -154,27 +152,26 @@ CARD_Parser CARD_ParserCreate(CARD_Char *encoding)
 */
 void CARD_ParserFree(CARD_Parser p)
 {
-    VP *vp = (VP *) p;
-    bfree(vp->lineBuf);
-    bfree(vp->params);
     bfree(p);
 }
 
 int vcard_add_char_to_line(VP *vp, char c)
 {
-    /* expand buf if neccessary */
-    if (vp->lbLen >= vp->lbSize)
+    if (vp->state == cp_PropData)
     {
-        vp->lbSize = vp->lbLen + 128;
-        vp->lineBuf = (char *) realloc(vp->lineBuf, vp->lbSize);
-        if (vp->lineBuf == NULL)
+        /* report data in chunks instead of growing line buffer */
+        if (vp->lbLen >= CARD_MAX_LINE_LEN)
         {
-            /* memory failure, crash & burn */
-            vp->lbSize = 0;
+            if (vp->cardData)
+                vp->cardData(vp->userData, vp->lineBuf, vp->lbLen);
             vp->lbLen = 0;
-            return FALSE;
         }
     }
+    else if (vp->lbLen >= (c ? CARD_MAX_LINE_LEN : CARD_LINE_BUF_SIZE))
+    {
+        /* too long propname or params, drop rest of it */
+        return TRUE;
+    }
 
     /* place in linebuf */
     vp->lineBuf[vp->lbLen] = c;
@@ -185,10 +182,12 @@ int vcard_add_char_to_line(VP *vp, char c)
 
 int card_add_param(VP *vp, int paramOff)
 {
-    vp->params = (CARD_Char **) realloc(vp->params, sizeof(CARD_Char *) * (vp->nParams + 1) * 2);
-
-    if (! vp->params)
+    if (vp->nParams >= CARD_MAX_PARAMS)
+    {
+        /* ignore value of this param too */
+        vp->paramSkip = TRUE;
         return FALSE;
+    }
 
     vp->params[vp->nParams * 2] = (CARD_Char *) paramOff;
     vp->params[vp->nParams * 2 + 1] = NULL;
@@ -199,7 +198,7 @@ int card_add_param(VP *vp, int paramOff)
 
 int card_set_paramvalue(VP *vp, int valueOff)
 {
-    if (! vp->params)
+    if (vp->nParams == 0 || vp->paramSkip)
         return FALSE;
 
     vp->params[(vp->nParams - 1) * 2 + 1] = (CARD_Char *) valueOff;
@@ -217,8 +216,9 @@ int vcard_end_prop(VP *vp)
     if (vp->cardProp)
     {
         /* null terminate the line buf */
-        if (! vcard_add_char_to_line(vp, 0))
-            return FALSE;
+        if (vp->lbLen >= CARD_LINE_BUF_SIZE)
+            vp->lbLen = CARD_LINE_BUF_SIZE - 1;
+        vp->lineBuf[vp->lbLen++] = 0;
 
         /* propname */
         b = vp->lineBuf;
@@ -249,7 +249,8 @@ int vcard_end_prop(VP *vp)
         }
 
         /* null terminate */
-        card_add_param(vp, 0);
+        vp->params[vp->nParams * 2] = NULL;
+        vp->params[vp->nParams * 2 + 1] = NULL;
 
         /* do callback */
         vp->cardProp(vp->userData, propName, (const CARD_Char **) vp->params);
@@ -344,7 +345,7 @@ int vcard_process_char(VP *vp, char c)
             if (isspace(c))
                 return TRUE; /* ignore */
 
-            /* start name - store as offset into lineBuf, as lineBuf may move when reallocated */
+            /* start name - store as offset into lineBuf, fixed up in vcard_end_prop() */
             card_add_param(vp, vp->lbLen);
 
             /* now in name */
@@ -394,7 +395,7 @@ int vcard_process_char(VP *vp, char c)
             if (isspace(c))
                 return TRUE; /* ignore */
 
-            /* start value - store as offset into lineBuf, as lineBuf may move */
+            /* start value - store as offset into lineBuf */
             card_set_paramvalue(vp, vp->lbLen);
 
             /* now in Value */
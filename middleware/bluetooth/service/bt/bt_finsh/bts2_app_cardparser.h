@@ -55,6 +55,17 @@ extern "C"
 #define CARD_PARSER_VER_MINOR 0
 #define CARD_PARSER_VER "1.0"
 
+/* Bound of property name with params kept in line buffer, data longer than this is
+   reported to CARD_DataHandler in several chunks, so memory used by parser is fixed */
+#ifndef CARD_MAX_LINE_LEN
+    #define CARD_MAX_LINE_LEN   256
+#endif
+
+/* Max params of one property, further params are ignored */
+#ifndef CARD_MAX_PARAMS
+    #define CARD_MAX_PARAMS     8
+#endif
+
 typedef char CARD_Char;
 typedef void *CARD_Parser;
 
@@ -89,6 +100,8 @@ typedef void (*CARD_PropHandler)(void *userData, const CARD_Char *propname, cons
     \param len length of data (len = 0 indicates eod)
     \return nothing
     \brief Called when a data chunk for a property is decoded
+    Data of one property may be reported in several chunks of at most CARD_MAX_LINE_LEN bytes
+    before eod
 */
 typedef void (*CARD_DataHandler)(void *userData, const CARD_Char *data, int len);
 
@@ -31,6 +31,7 @@ struct rt_bt_pan_instance  bt_pan_instance[MAX_PAN_INSTANCE_NUM];
 
 
 #include "bt_prot.h"
+#include "lwip/pbuf.h"
 #ifdef CFG_GNU
 #define FIFO "/data/myfifo"
 static void bt_pan_wr_data(char *string)
@@ -423,52 +424,83 @@ void bt_pan_disc(BTS2S_BD_ADDR *bd)
     }
 }
 
-void bt_lwip_pan_send(struct rt_bt_pan_instance *bt_instance, void *buff, int len)
+/* allocate data request of an ethernet frame, payload (frame without 14 bytes header) is
+ * filled by caller, both are freed by BT stack after sending */
+static BTS2S_PAN_DATA_REQ *bt_lwip_pan_data_req_alloc(struct rt_bt_pan_instance *bt_instance, const U8 *eth_header, int len)
 {
     bts2_pan_inst_data *ptr = NULL;
-    void  *p;
-    U8   *eth_header;
+    BTS2S_PAN_DATA_REQ *msg;
+
     ptr = bt_instance->bts2_app_data->pan_inst_ptr;
 
-    if (ptr->pan_st == PAN_BUSY_ST)
+    if (ptr->pan_st != PAN_BUSY_ST)
     {
-        if (ptr->mode == SNIFF_MODE)
-            bt_exit_sniff_mode(bt_instance->bts2_app_data);
+        USER_TRACE(">> PAN data send fail\n");
+        return NULL;
+    }
 
-        BTS2S_PAN_DATA_REQ *msg;
-        msg = (BTS2S_PAN_DATA_REQ *)bmalloc(sizeof(BTS2S_PAN_DATA_REQ));
-        BT_OOM_ASSERT(msg);
-        if (msg)
-        {
-            msg->type = BTS2MD_PAN_DATA_REQ;
-            eth_header = buff;
-            msg->ether_type = (eth_header[12] << 8) + eth_header[13];
-            msg->len = len - 14;
-            buff = eth_header + 14;
-
-            //msg->dst_addr = bt_pan_get_remote_mac_address(bt_instance);
-            msg->dst_addr.w[0] = (((U16)eth_header[0]) << 8) | (U16)eth_header[1];
-            msg->dst_addr.w[1] = (((U16)eth_header[2]) << 8) | (U16)eth_header[3];
-            msg->dst_addr.w[2] = (((U16)eth_header[4]) << 8) | (U16)eth_header[5];
-            msg->src_addr = bt_pan_get_mac_address(bt_instance);
-            p = bmalloc(msg->len);
-            BT_OOM_ASSERT(p);
-            if (p == NULL)
-            {
-                bfree(msg);
-                return;
-            }
-            memcpy(p, buff, msg->len);
-            msg->payload = p;
-            bts2_msg_put(bts2_task_get_pan_task_id(), BTS2M_PAN, msg);
-            //USER_TRACE("bt_lwip_pan_send\n");
-        }
+    if (ptr->mode == SNIFF_MODE)
+        bt_exit_sniff_mode(bt_instance->bts2_app_data);
+
+    msg = (BTS2S_PAN_DATA_REQ *)bmalloc(sizeof(BTS2S_PAN_DATA_REQ));
+    BT_OOM_ASSERT(msg);
+    if (msg == NULL)
+        return NULL;
+
+    msg->type = BTS2MD_PAN_DATA_REQ;
+    msg->ether_type = (eth_header[12] << 8) + eth_header[13];
+    msg->len = len - 14;
+
+    //msg->dst_addr = bt_pan_get_remote_mac_address(bt_instance);
+    msg->dst_addr.w[0] = (((U16)eth_header[0]) << 8) | (U16)eth_header[1];
+    msg->dst_addr.w[1] = (((U16)eth_header[2]) << 8) | (U16)eth_header[3];
+    msg->dst_addr.w[2] = (((U16)eth_header[4]) << 8) | (U16)eth_header[5];
+    msg->src_addr = bt_pan_get_mac_address(bt_instance);
+    msg->payload = bmalloc(msg->len);
+    BT_OOM_ASSERT(msg->payload);
+    if (msg->payload == NULL)
+    {
+        bfree(msg);
+        return NULL;
     }
-    else
+
+    return msg;
+}
+
+void bt_lwip_pan_send(struct rt_bt_pan_instance *bt_instance, void *buff, int len)
+{
+    BTS2S_PAN_DATA_REQ *msg;
+
+    msg = bt_lwip_pan_data_req_alloc(bt_instance, (U8 *)buff, len);
+    if (msg)
     {
-        USER_TRACE(">> PAN data send fail\n");
+        memcpy(msg->payload, (U8 *)buff + 14, msg->len);
+        bts2_msg_put(bts2_task_get_pan_task_id(), BTS2M_PAN, msg);
+        //USER_TRACE("bt_lwip_pan_send\n");
+    }
+}
+
+/* send pbuf chain, which is gathered to data request payload without intermediate buffer */
+void bt_lwip_pan_send_pbuf(struct rt_bt_pan_instance *bt_instance, void *pbuf)
+{
+    struct pbuf *p = (struct pbuf *)pbuf;
+    BTS2S_PAN_DATA_REQ *msg;
+    U8 header[14];
+    U8 *eth_header = header;
+
+    if (p->len >= sizeof(header))
+        eth_header = (U8 *)p->payload;
+    else if (pbuf_copy_partial(p, header, sizeof(header), 0) != sizeof(header))
+        return;
+
+    msg = bt_lwip_pan_data_req_alloc(bt_instance, eth_header, p->tot_len);
+    if (msg)
+    {
+        pbuf_copy_partial(p, msg->payload, msg->len, sizeof(header));
+        bts2_msg_put(bts2_task_get_pan_task_id(), BTS2M_PAN, msg);
     }
 }
+
 void rt_lwip_instance_register_event_handler(struct rt_bt_pan_instance *bt_instance, rt_bt_instance_event_t event, rt_bt_instance_event_handler handler)
 {
     int i = 0;
@@ -481,7 +513,8 @@ struct rt_bt_instance_ops instance_ops =
 {
     RT_NULL,
     RT_NULL,
-    bt_lwip_pan_send
+    bt_lwip_pan_send,
+    bt_lwip_pan_send_pbuf
 };
 
 void bt_lwip_pan_control_tcpip(bts2_app_stru *bts2_app_data)
@@ -652,8 +685,12 @@ void bt_hdl_pan_msg(bts2_app_stru *bts2_app_data)
             bfree(msg->payload);
             break;
         }
-        rt_bt_instance_transfer_prot(&bt_pan_instance[0], (void *)msg->payload, msg->len);
-        bfree(msg->payload);
+        /* frame stays in payload until lwIP frees it, copy only if it can't be referenced */
+        if (rt_bt_instance_transfer_prot_ref(&bt_pan_instance[0], (void *)msg->payload, msg->len) != RT_EOK)
+        {
+            rt_bt_instance_transfer_prot(&bt_pan_instance[0], (void *)msg->payload, msg->len);
+            bfree(msg->payload);
+        }
         break;
     }
     case BTS2MU_PAN_DISC_IND:
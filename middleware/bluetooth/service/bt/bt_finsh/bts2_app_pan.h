@@ -46,6 +46,7 @@ struct rt_bt_instance_ops
     rt_err_t (*bt_init)(struct rt_bt_pan_instance *bt_instance);
     int (*bt_recv)(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
     void (*bt_send)(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
+    void (*bt_send_pbuf)(struct rt_bt_pan_instance *bt_instance, void *pbuf);    /* lwIP struct pbuf chain */
 };
 
 struct rt_bt_pan_instance
@@ -82,12 +83,14 @@ void bt_pan_set_dns2(char *string);
 
 
 void bt_lwip_pan_send(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
+void bt_lwip_pan_send_pbuf(struct rt_bt_pan_instance *bt_instance, void *pbuf);
 void rt_lwip_instance_register_event_handler(struct rt_bt_pan_instance *bt_instance, rt_bt_instance_event_t event, rt_bt_instance_event_handler handler);
 void bt_lwip_pan_control_tcpip(bts2_app_stru *bts2_app_data);
 void bt_lwip_pan_detach_tcpip(bts2_app_stru *bts2_app_data);
 
 extern rt_err_t rt_bt_prot_attach_pan_instance(struct rt_bt_pan_instance *panInstance);
 extern rt_err_t rt_bt_instance_transfer_prot(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
+extern rt_err_t rt_bt_instance_transfer_prot_ref(struct rt_bt_pan_instance *bt_instance, void *buff, int len);
 //extern BTS2S_ETHER_ADDR bt_pan_get_remote_mac_address(struct rt_bt_pan_instance *bt_instance);
 extern BTS2S_ETHER_ADDR bt_pan_get_mac_address(struct rt_bt_pan_instance *bt_instance);
 
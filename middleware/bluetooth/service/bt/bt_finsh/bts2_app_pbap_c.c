@@ -68,9 +68,12 @@ typedef enum
 typedef struct
 {
     BT_PBAPC_ST pbap_clt_st;
-    BT_PBAP_VCARD *pbab_vcard;
+    bt_pbap_contact_t contact;
     BOOL is_valid_vcard;
     U32 elem_index;
+    BOOL pull_range;
+    U16 pull_offset;
+    U16 pull_cards;
     U16 mfs;
     BTS2S_BD_ADDR rmt_bd;
     U8 rmt_supp_repos;
@@ -87,15 +90,17 @@ typedef struct
     U32 entry_handle;
 } bts2s_pbap_clt_inst_data;
 
+#define BT_PBAP_CARD_TYPE_LEN   (16)
+
 typedef struct TUserData
 {
     int indent;
     int inBegin, inEnd, startData;
-    char *cardType;
+    char cardType[BT_PBAP_CARD_TYPE_LEN];
 } TUserData;
 
 static bts2s_pbap_clt_inst_data *local_inst = NULL;
-TUserData userData = {0, 0, 0, 0, NULL};
+TUserData userData = {0};
 CARD_Parser vp = NULL;
 int count = 0;
 int pring_count = 1;
@@ -248,42 +253,23 @@ continue_parse_value:
 
 static void bt_pbap_clt_dump_vcard(void)
 {
-    LOG_D("*********************************************\n");
-    LOG_D("pbap_vcard[%d]:\n", pring_count++);
-    LOG_D("[name]  ");
-    char *name = bmalloc(local_inst->pbab_vcard->v_name.length + 1);
-    if (name)
-    {
-        memcpy(name, local_inst->pbab_vcard->v_name.name, local_inst->pbab_vcard->v_name.length);
-        name[local_inst->pbab_vcard->v_name.length] = 0;
-        LOG_D("%s", name);
-        LOG_D("\n");
-        bfree(name);
-    }
-    else
-        LOG_D("out of memory");
-
-    vcard_tel_list *tmp = local_inst->pbab_vcard->v_tel;
+    bt_pbap_contact_t *contact = &local_inst->contact;
+    U8 i;
 
-    while (tmp)
+    LOG_D("pbap_vcard[%d]: [name] %.*s", pring_count++, contact->name_len, contact->name);
+    for (i = 0; i < contact->tel_num; i++)
     {
-        LOG_D("[tel]  ");
-        char *name_tel = bmalloc(tmp->length + 1);
-        if (name_tel)
-        {
-            memcpy(name_tel, tmp->tel, tmp->length);
-            name_tel[tmp->length] = 0;
-            tmp = tmp->next_struct;
-            LOG_D("%s", name_tel);
-            LOG_D("\n");
-            bfree(name_tel);
-        }
-        else
-            LOG_D("out of memory");
+        LOG_D("[tel] %.*s", contact->tel_len[i], contact->tel[i]);
     }
-    LOG_D("*********************************************\n");
 }
 
+static void bt_pbap_card_type_set(TUserData *ud, const CARD_Char *data, int len)
+{
+    if (len >= BT_PBAP_CARD_TYPE_LEN)
+        len = BT_PBAP_CARD_TYPE_LEN - 1;
+    memcpy(ud->cardType, data, len);
+    ud->cardType[len] = 0;
+}
 
 static void bt_pbap_check_vcard_valid(U32 index)
 {
@@ -315,30 +301,14 @@ void PropHandler(void *userData, const CARD_Char *propName, const CARD_Char **pa
         ud->inBegin = TRUE;
         ud->indent++;
 
-        local_inst->pbab_vcard = (BT_PBAP_VCARD *)bmalloc(sizeof(BT_PBAP_VCARD));
-        if (!local_inst->pbab_vcard)
-        {
-            USER_TRACE(">> Can't create phone-book buffer!!!!!!!!!\n");
-            local_inst->is_valid_vcard = FALSE;
-        }
-        else
-        {
-            local_inst->pbab_vcard->v_tel = (vcard_tel_list *)bmalloc(sizeof(vcard_tel_list));
-            BT_OOM_ASSERT(local_inst->pbab_vcard->v_tel);
-            if (local_inst->pbab_vcard->v_tel)
-            {
-                local_inst->pbab_vcard->v_tel->next_struct = NULL;
-                local_inst->pbab_vcard->v_tel->tel = NULL;
-                local_inst->pbab_vcard->v_tel->num = 0;
-                local_inst->is_valid_vcard = TRUE;
-            }
-        }
+        /* contact is filled in place, nothing is allocated per vCard */
+        memset(&local_inst->contact, 0, sizeof(local_inst->contact));
+        local_inst->is_valid_vcard = TRUE;
     }
     else if (bstricmp((char *)propName, "END") == 0)
     {
         /* end: vcard/vcal/whatever */
-        bfree(ud->cardType);
-        ud->cardType = NULL;
+        ud->cardType[0] = 0;
         ud->inEnd = TRUE;
         ud->indent--;
     }
@@ -364,142 +334,95 @@ void PropHandler(void *userData, const CARD_Char *propName, const CARD_Char **pa
         {
             type = BT_PBAP_CLT_PHOTO;
         }
+        else
+        {
+            type = BT_PBAP_CLT_VCARD_IDLE;
+        }
     }
 }
 
 void DataHandler(void *userData, const CARD_Char *data, int len)
 {
     TUserData *ud = (TUserData *) userData;
+    bt_pbap_contact_t *contact = &local_inst->contact;
+    BOOL first;
+
     assert(ud != NULL);
 
     if (ud->inBegin)
     {
         /* accumulate begin data */
         if (len > 0)
-        {
-            ud->cardType = realloc(ud->cardType, len + 1);
-            memcpy(ud->cardType, data, len);
-            ud->cardType[len] = 0;
-        }
+            bt_pbap_card_type_set(ud, data, len);
     }
     else if (ud->inEnd)
     {
         if (len > 0)
         {
-            ud->cardType = realloc(ud->cardType, len + 1);
-            memcpy(ud->cardType, data, len);
-            ud->cardType[len] = 0;
+            bt_pbap_card_type_set(ud, data, len);
         }
-        else if (ud->cardType)
+        else if (ud->cardType[0])
         {
-            bfree(ud->cardType);
-            ud->cardType = NULL;
+            ud->cardType[0] = 0;
 
             bt_pbap_check_vcard_valid(BT_PBAP_ELEM_FN | BT_PBAP_ELEM_TEL);
 
             if (local_inst->is_valid_vcard)
             {
                 bt_pbap_clt_dump_vcard();
-                //todo 上报solution
+                bt_pbap_store_add(contact);
             }
             else
             {
                 LOG_E("error,no valid vcard!!!!!!\n");
             }
-
-            bfree(local_inst->pbab_vcard->v_name.name);
-            local_inst->pbab_vcard->v_name.name = NULL;
-
-            vcard_tel_list *ptr = local_inst->pbab_vcard->v_tel;
-            vcard_tel_list *last_ptr = NULL;
-            while (ptr != NULL)
-            {
-                /* kill it and move on */
-                last_ptr = ptr;
-                ptr = ptr->next_struct;
-                if (last_ptr->tel)
-                {
-                    bfree(last_ptr->tel);
-                    last_ptr->tel = NULL;
-                }
-                bfree(last_ptr);      /* kill the block */
-                last_ptr = NULL;
-            }
-            bfree(local_inst->pbab_vcard);
-            local_inst->pbab_vcard = NULL;
+            local_inst->pull_cards++;
             type = BT_PBAP_CLT_VCARD_IDLE;
             local_inst->elem_index = BT_PBAP_ELEM_VCARD_IDLE;
         }
     }
     else
     {
+        /* long data comes in several chunks, first one starts a new value */
+        first = ud->startData;
         if (ud->startData)
         {
             ud->startData = FALSE;
         }
 
-        if (len == 0)
-        {
-            // printf("}\n");
-        }
-        else
+        if (len > 0 && local_inst->is_valid_vcard)
         {
-            /* output printable data */
-
-            if (type  == BT_PBAP_CLT_TEL)
+            if (type == BT_PBAP_CLT_TEL)
             {
-                // printf("tel:");
-                if (local_inst->is_valid_vcard)
+                if (first)
                 {
-                    if (local_inst->pbab_vcard->v_tel->num == 0)
-                    {
-                        local_inst->pbab_vcard->v_tel->tel = bmalloc(len);
-                        BT_OOM_ASSERT(local_inst->pbab_vcard->v_tel->tel);
-                        if (local_inst->pbab_vcard->v_tel->tel)
-                        {
-                            local_inst->pbab_vcard->v_tel->length = len;
-                            memcpy(local_inst->pbab_vcard->v_tel->tel, data, len);
-                            local_inst->pbab_vcard->v_tel->num++;
-                            local_inst->pbab_vcard->v_tel->next_struct = NULL;
-                        }
-                    }
+                    if (contact->tel_num >= BT_PBAP_TEL_MAX_NUM)
+                        type = BT_PBAP_CLT_VCARD_IDLE;
                     else
-                    {
-                        vcard_tel_list *tel_tmp = (vcard_tel_list *)bmalloc(sizeof(vcard_tel_list));
-                        BT_OOM_ASSERT(tel_tmp);
-                        if (tel_tmp)
-                        {
-                            vcard_tel_list *tmp = local_inst->pbab_vcard->v_tel;
-                            tel_tmp->length = len;
-                            tel_tmp->tel = bmalloc(len);
-                            BT_OOM_ASSERT(tel_tmp->tel);
-                            if (tel_tmp->tel)
-                            {
-                                memcpy(tel_tmp->tel, data, len);
-                                tel_tmp->next_struct = NULL;
-                                while (tmp->next_struct)
-                                {
-                                    tmp = tmp->next_struct;
-                                }
-                                tmp->next_struct = tel_tmp;
-                                local_inst->pbab_vcard->v_tel->num++;
-                            }
-                            else
-                                bfree(tel_tmp);
-                        }
-                    }
+                        contact->tel_num++;
+                }
+                if (type == BT_PBAP_CLT_TEL)
+                {
+                    U8 idx = contact->tel_num - 1;
+                    int n = BT_PBAP_TEL_MAX_LEN - contact->tel_len[idx];
+
+                    if (len < n)
+                        n = len;
+                    memcpy(&contact->tel[idx][contact->tel_len[idx]], data, n);
+                    contact->tel_len[idx] += n;
                 }
             }
             else if (type == BT_PBAP_CLT_FN)
             {
-                if (local_inst->is_valid_vcard)
-                {
-                    local_inst->pbab_vcard->v_name.length = len;
-                    local_inst->pbab_vcard->v_name.name = bmalloc(len);
-                    BT_OOM_ASSERT(local_inst->pbab_vcard->v_name.name);
-                    if (local_inst->pbab_vcard->v_name.name)
-                        memcpy(local_inst->pbab_vcard->v_name.name, data, len);
-                }
+                int n;
+
+                if (first)
+                    contact->name_len = 0;
+                n = BT_PBAP_NAME_MAX_LEN - contact->name_len;
+                if (len < n)
+                    n = len;
+                memcpy(&contact->name[contact->name_len], data, n);
+                contact->name_len += n;
             }
         }
     }
@@ -508,7 +431,7 @@ void DataHandler(void *userData, const CARD_Char *data, int len)
 void bt_parser_vcard_property(U8 *buf, U32 len, void *param)
 {
     int parseErr = FALSE;
-    TUserData userData = {0, 0, 0, 0, NULL};
+    TUserData userData = {0};
     CARD_Parser vp = NULL;
     U32 rc = 0;
 
@@ -533,8 +456,6 @@ void bt_parser_vcard_property(U8 *buf, U32 len, void *param)
 
     /* free parser */
     CARD_ParserFree(vp);
-    /* free up any remaining user data buffers */
-    bfree(userData.cardType);
 }
 
 static int bt_pbapc_parse_vcard_list(const char *data, U16 dataLen)
@@ -689,7 +610,9 @@ void bt_pbap_clt_init(bts2_app_stru *bts2_app_data)
     local_inst->pbap_clt_st = BT_PBAPC_IDLE_ST;
     local_inst->is_valid_vcard = FALSE;
     local_inst->elem_index = BT_PBAP_ELEM_VCARD_IDLE;
-    local_inst->pbab_vcard = NULL;
+    local_inst->pull_range = FALSE;
+    local_inst->pull_offset = 0;
+    local_inst->pull_cards = 0;
     local_inst->mfs = pbap_clt_get_max_mtu();
     local_inst->rmt_supp_repos = 0;
     local_inst->curr_cmd = BT_PBAP_CLT_IDLE;
@@ -925,26 +848,55 @@ bt_err_t bt_pbap_client_disconnect(BTS2S_BD_ADDR *bd)
 
 // #define FILTER_TEST PBAP_FILTER_VERSION | PBAP_FILTER_FN | PBAP_FILTER_N | pbap_filter_tel
 
+static void bt_pbapc_parser_reset(void)
+{
+    if (vp)
+    {
+        CARD_ParserFree(vp);
+        vp = NULL;
+    }
+    memset(&userData, 0, sizeof(userData));
+    type = BT_PBAP_CLT_VCARD_IDLE;
+    local_inst->elem_index = BT_PBAP_ELEM_VCARD_IDLE;
+}
+
+static void bt_pbapc_pull_pb_range(U16 max_size)
+{
+    pbap_clt_pull_pb_req((U8)local_inst->curr_repos,
+                         (U8)local_inst->curr_phonebook,
+                         0,
+                         0x00,
+                         PBAP_FORMAT_21,
+                         max_size,
+                         local_inst->pull_offset);
+    local_inst->pull_cards = 0;
+}
+
+/* max_size 0 downloads whole phone book, in ranges of BT_PBAP_PULL_RANGE vCards if it is not 0 */
 bt_err_t bt_pbap_client_pull_pb(BTS2E_PBAP_PHONE_REPOSITORY repos, U8 phone_book, U8 max_size)
 {
     bt_err_t ret = BT_ERROR_STATE;
     if (local_inst->curr_cmd == BT_PBAP_CLT_IDLE)
     {
-        pbap_clt_pull_pb_req((U8)local_inst->curr_repos,
-                             (U8)local_inst->curr_phonebook,
-                             0,
-                             0x00,
-                             PBAP_FORMAT_21,
-                             max_size, //0x00
-                             0x00);
-        USER_TRACE(">> Download phone book\n");
-        /* allocate parser */
+        /* allocate parser, each vCard is parsed as its fragment arrives */
+        bt_pbapc_parser_reset();
         vp = CARD_ParserCreate(NULL);
+        if (!vp)
+        {
+            return BT_ERROR_OUT_OF_MEMORY;
+        }
 
         /* initialize */
         CARD_SetUserData(vp, &userData);
         CARD_SetPropHandler(vp, PropHandler);
         CARD_SetDataHandler(vp, DataHandler);
+
+        bt_pbap_store_begin();
+        local_inst->curr_cmd = BT_PBAP_CLT_PULLPHONEBOOK;
+        local_inst->pull_range = (max_size == 0 && BT_PBAP_PULL_RANGE != 0);
+        local_inst->pull_offset = 0;
+        bt_pbapc_pull_pb_range(local_inst->pull_range ? BT_PBAP_PULL_RANGE : max_size);
+        USER_TRACE(">> Download phone book\n");
         ret = BT_EOK;
     }
     else
@@ -1295,6 +1247,22 @@ void bt_pbap_clt_hdl_msg(bts2_app_stru *bts2_app_data)
         BTS2S_PBAP_CLT_PULL_CMPT_IND *msg;
 
         msg = (BTS2S_PBAP_CLT_PULL_CMPT_IND *)bts2_app_data->recv_msg;
+        if (vp)
+        {
+            /* last line of response is terminated here */
+            CARD_Parse(vp, NULL, 0, TRUE);
+        }
+        if (msg->res == PBAPC_SUCCESS && local_inst->pull_range &&
+                local_inst->pull_cards == BT_PBAP_PULL_RANGE)
+        {
+            /* Full range returned, more may follow. Phone ignoring offset returns
+               whole book at once, which ends download as well */
+            local_inst->pull_offset += BT_PBAP_PULL_RANGE;
+            USER_TRACE(">> Pbap get phonebook from %d\n", local_inst->pull_offset);
+            bt_pbapc_pull_pb_range(BT_PBAP_PULL_RANGE);
+            break;
+        }
+
         local_inst->curr_cmd = BT_PBAP_CLT_IDLE;
         if (msg->res == PBAPC_SUCCESS)
         {
@@ -1304,6 +1272,8 @@ void bt_pbap_clt_hdl_msg(bts2_app_stru *bts2_app_data)
         {
             USER_TRACE(">> Pbap get phonebook failed\n");
         }
+        bt_pbap_store_end(msg->res == PBAPC_SUCCESS);
+        bt_pbapc_parser_reset();
         count = 0;
         pring_count = 1;
         break;
@@ -99,27 +99,33 @@ typedef enum
 
 
 
-typedef struct
-{
-    char *name;
-    U8 length;
-} vcard_name;
+/* Bounds of contact record, longer name or number is truncated and extra numbers are dropped */
+#ifndef BT_PBAP_NAME_MAX_LEN
+    #define BT_PBAP_NAME_MAX_LEN    (PBAP_VCARD_NAME_LEN * 2)
+#endif
 
+#ifndef BT_PBAP_TEL_MAX_NUM
+    #define BT_PBAP_TEL_MAX_NUM     4
+#endif
 
-typedef struct
-{
-    void *next_struct;
-    char *tel;
-    U8 length;
-    U8 num;
-} vcard_tel_list;
+#ifndef BT_PBAP_TEL_MAX_LEN
+    #define BT_PBAP_TEL_MAX_LEN     24
+#endif
 
+/* vCards pulled in one request when whole phone book is downloaded, 0 to pull all at once */
+#ifndef BT_PBAP_PULL_RANGE
+    #define BT_PBAP_PULL_RANGE      100
+#endif
 
+/* Compact contact record built from one vCard of phone book */
 typedef struct
 {
-    vcard_name v_name;
-    vcard_tel_list *v_tel;
-} BT_PBAP_VCARD;
+    U8 name_len;
+    U8 tel_num;
+    U8 tel_len[BT_PBAP_TEL_MAX_NUM];
+    char name[BT_PBAP_NAME_MAX_LEN];
+    char tel[BT_PBAP_TEL_MAX_NUM][BT_PBAP_TEL_MAX_LEN];
+} bt_pbap_contact_t;
 
 struct pbap_key_value_t
 {
@@ -172,6 +178,22 @@ bt_err_t bt_pbap_client_pull_vcard(U8 *p, U8 len);
 bt_err_t bt_pbap_client_get_name_by_number(char *phone_number, U16 phone_len);
 bt_err_t bt_pbap_client_auth(U8 *password, U8 len);
 
+/*----------------------------------------------------------------------------*
+ *
+ * DESCRIPTION:
+ *      Contact store filled while phone book is downloaded, see bts2_app_pbap_store.c.
+ *      Records of previous download are dropped by bt_pbap_store_begin().
+ *
+ * NOTE:
+ *      bt_pbap_store_get() returns FALSE if index is out of range.
+ *
+ *----------------------------------------------------------------------------*/
+void bt_pbap_store_begin(void);
+void bt_pbap_store_add(const bt_pbap_contact_t *contact);
+void bt_pbap_store_end(BOOL complete);
+U32 bt_pbap_store_count(void);
+BOOL bt_pbap_store_get(U32 index, bt_pbap_contact_t *contact);
+
 #endif
 #ifdef __cplusplus
 }
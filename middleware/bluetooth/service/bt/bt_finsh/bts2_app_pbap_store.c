@@ -0,0 +1,465 @@
+/**
+  ******************************************************************************
+  * @file   bts2_app_pbap_store.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "rtthread.h"
+#include "bts2_app_inc.h"
+
+#ifdef CFG_PBAP_CLT
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG         "btapp_pbstore"
+#include "log.h"
+
+/*
+ * Contacts of downloaded phone book are written one by one as vCards are parsed, so RAM
+ * use does not depend on size of phone book. Record is packed as
+ *     name_len, tel_num, tel_len[tel_num], name, tel[0] .. tel[tel_num - 1]
+ * and kept in FlashDB KVDB as "pb<index>" with count in "pb_num" if available,
+ * otherwise in a data file with an index file of U32 record offsets.
+ */
+
+#if defined(PKG_USING_FLASHDB) && defined(FDB_USING_KVDB)
+    #define BT_PBAP_STORE_KVDB
+    #include "flashdb.h"
+    #include "fal.h"
+    #ifdef FDB_USING_FILE_MODE
+        #include "dfs_posix.h"
+    #endif
+    #ifndef BT_PBAP_DB_PART
+        /* fal partition, or directory of db in file mode */
+        #define BT_PBAP_DB_PART         "pbap"
+    #endif
+    #ifndef BT_PBAP_DB_MAX_SIZE
+        #define BT_PBAP_DB_MAX_SIZE     (256 * 1024)
+    #endif
+#elif defined(RT_USING_DFS)
+    #define BT_PBAP_STORE_FILE
+    #include "dfs_posix.h"
+    #ifndef BT_PBAP_STORE_DATA
+        #define BT_PBAP_STORE_DATA      "/pbap.dat"
+    #endif
+    #ifndef BT_PBAP_STORE_IDX
+        #define BT_PBAP_STORE_IDX       "/pbap.idx"
+    #endif
+#endif
+
+#define BT_PBAP_RECORD_MAX_LEN  (2 + BT_PBAP_TEL_MAX_NUM + BT_PBAP_NAME_MAX_LEN + BT_PBAP_TEL_MAX_NUM * BT_PBAP_TEL_MAX_LEN)
+
+typedef struct
+{
+    U8 inited;
+    U8 busy;
+    U32 num;
+    U32 prev_num;
+#ifdef BT_PBAP_STORE_KVDB
+    struct fdb_kvdb db;
+#elif defined(BT_PBAP_STORE_FILE)
+    int data_fd;
+    int idx_fd;
+    U32 data_len;
+#endif
+    U8 buf[BT_PBAP_RECORD_MAX_LEN];
+} bt_pbap_store_t;
+
+static bt_pbap_store_t g_pbap_store;
+
+static U32 bt_pbap_record_pack(U8 *buf, const bt_pbap_contact_t *contact)
+{
+    U32 len = 0;
+    U8 i;
+
+    buf[len++] = contact->name_len;
+    buf[len++] = contact->tel_num;
+    memcpy(&buf[len], contact->tel_len, contact->tel_num);
+    len += contact->tel_num;
+    memcpy(&buf[len], contact->name, contact->name_len);
+    len += contact->name_len;
+    for (i = 0; i < contact->tel_num; i++)
+    {
+        memcpy(&buf[len], contact->tel[i], contact->tel_len[i]);
+        len += contact->tel_len[i];
+    }
+    return len;
+}
+
+static BOOL bt_pbap_record_unpack(const U8 *buf, U32 len, bt_pbap_contact_t *contact)
+{
+    U32 off = 2;
+    U8 i;
+
+    if (len < 2 || buf[0] > BT_PBAP_NAME_MAX_LEN || buf[1] > BT_PBAP_TEL_MAX_NUM)
+        return FALSE;
+
+    memset(contact, 0, sizeof(*contact));
+    contact->name_len = buf[0];
+    contact->tel_num = buf[1];
+    if (off + contact->tel_num > len)
+        return FALSE;
+    memcpy(contact->tel_len, &buf[off], contact->tel_num);
+    off += contact->tel_num;
+
+    if (off + contact->name_len > len)
+        return FALSE;
+    memcpy(contact->name, &buf[off], contact->name_len);
+    off += contact->name_len;
+
+    for (i = 0; i < contact->tel_num; i++)
+    {
+        if (contact->tel_len[i] > BT_PBAP_TEL_MAX_LEN || off + contact->tel_len[i] > len)
+            return FALSE;
+        memcpy(contact->tel[i], &buf[off], contact->tel_len[i]);
+        off += contact->tel_len[i];
+    }
+    return TRUE;
+}
+
+#ifdef BT_PBAP_STORE_KVDB
+
+static void bt_pbap_store_key(char *key, U32 index)
+{
+    rt_snprintf(key, 12, "pb%d", index);
+}
+
+static BOOL bt_pbap_store_init(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    struct fdb_blob blob;
+    fdb_err_t err;
+
+    if (store->inited)
+        return TRUE;
+
+#ifdef FDB_USING_FILE_MODE
+    {
+        int sec_size = PKG_FLASHDB_ERASE_GRAN;
+        int max_size = BT_PBAP_DB_MAX_SIZE;
+        bool file_mode = true;
+
+        fdb_kvdb_control(&store->db, FDB_KVDB_CTRL_SET_SEC_SIZE, (void *)&sec_size);
+        fdb_kvdb_control(&store->db, FDB_KVDB_CTRL_SET_MAX_SIZE, (void *)&max_size);
+        fdb_kvdb_control(&store->db, FDB_KVDB_CTRL_SET_FILE_MODE, (void *)&file_mode);
+        if (0 != access(BT_PBAP_DB_PART, 0) && 0 != mkdir(BT_PBAP_DB_PART, 0))
+        {
+            LOG_E("create db %s fail", BT_PBAP_DB_PART);
+            return FALSE;
+        }
+    }
+#endif /* FDB_USING_FILE_MODE */
+
+    err = fdb_kvdb_init(&store->db, "pbap", BT_PBAP_DB_PART, NULL, NULL);
+    if (err != FDB_NO_ERR)
+    {
+        LOG_E("pbap db init failed %d", err);
+        return FALSE;
+    }
+
+    store->num = 0;
+    fdb_kv_get_blob(&store->db, "pb_num", fdb_blob_make(&blob, &store->num, sizeof(store->num)));
+    store->prev_num = store->num;
+    store->inited = 1;
+    return TRUE;
+}
+
+static void bt_pbap_store_set_num(U32 num)
+{
+    struct fdb_blob blob;
+
+    fdb_kv_set_blob(&g_pbap_store.db, "pb_num", fdb_blob_make(&blob, &num, sizeof(num)));
+}
+
+static BOOL bt_pbap_store_open(void)
+{
+    /* Interrupted download reads as empty after reboot */
+    bt_pbap_store_set_num(0);
+    return TRUE;
+}
+
+static BOOL bt_pbap_store_write(U32 index, const U8 *buf, U32 len)
+{
+    struct fdb_blob blob;
+    char key[12];
+
+    bt_pbap_store_key(key, index);
+    return fdb_kv_set_blob(&g_pbap_store.db, key, fdb_blob_make(&blob, buf, len)) == FDB_NO_ERR;
+}
+
+static void bt_pbap_store_close(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    char key[12];
+    U32 i;
+
+    /* Records left from a larger phone book */
+    for (i = store->num; i < store->prev_num; i++)
+    {
+        bt_pbap_store_key(key, i);
+        fdb_kv_del(&store->db, key);
+    }
+    bt_pbap_store_set_num(store->num);
+}
+
+static U32 bt_pbap_store_read(U32 index, U8 *buf, U32 len)
+{
+    struct fdb_blob blob;
+    char key[12];
+
+    bt_pbap_store_key(key, index);
+    return fdb_kv_get_blob(&g_pbap_store.db, key, fdb_blob_make(&blob, buf, len));
+}
+
+#elif defined(BT_PBAP_STORE_FILE)
+
+static BOOL bt_pbap_store_init(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    struct stat st;
+
+    if (store->inited)
+        return TRUE;
+
+    store->data_fd = -1;
+    store->idx_fd = -1;
+    store->num = 0;
+    if (stat(BT_PBAP_STORE_IDX, &st) == 0)
+        store->num = st.st_size / sizeof(U32);
+    store->inited = 1;
+    return TRUE;
+}
+
+static BOOL bt_pbap_store_open(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+
+    store->data_fd = open(BT_PBAP_STORE_DATA, O_RDWR | O_BINARY | O_CREAT | O_TRUNC, 0);
+    store->idx_fd = open(BT_PBAP_STORE_IDX, O_RDWR | O_BINARY | O_CREAT | O_TRUNC, 0);
+    store->data_len = 0;
+    if (store->data_fd < 0 || store->idx_fd < 0)
+    {
+        LOG_E("open pbap store fail %d %d", store->data_fd, store->idx_fd);
+        if (store->data_fd >= 0)
+            close(store->data_fd);
+        if (store->idx_fd >= 0)
+            close(store->idx_fd);
+        store->data_fd = -1;
+        store->idx_fd = -1;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL bt_pbap_store_write(U32 index, const U8 *buf, U32 len)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    U8 rec_len = (U8)len;
+
+    /* Data is length prefixed so that file alone can be walked */
+    if (write(store->data_fd, &rec_len, 1) != 1 || write(store->data_fd, buf, len) != len)
+        return FALSE;
+    if (write(store->idx_fd, &store->data_len, sizeof(U32)) != sizeof(U32))
+        return FALSE;
+    store->data_len += len + 1;
+    return TRUE;
+}
+
+static void bt_pbap_store_close(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+
+    close(store->data_fd);
+    close(store->idx_fd);
+    store->data_fd = -1;
+    store->idx_fd = -1;
+}
+
+static U32 bt_pbap_store_read(U32 index, U8 *buf, U32 len)
+{
+    U32 off;
+    U8 rec_len = 0;
+    int fd;
+
+    fd = open(BT_PBAP_STORE_IDX, O_RDONLY | O_BINARY, 0);
+    if (fd < 0)
+        return 0;
+    if (lseek(fd, index * sizeof(U32), SEEK_SET) < 0 || read(fd, &off, sizeof(U32)) != sizeof(U32))
+    {
+        close(fd);
+        return 0;
+    }
+    close(fd);
+
+    fd = open(BT_PBAP_STORE_DATA, O_RDONLY | O_BINARY, 0);
+    if (fd < 0)
+        return 0;
+    if (lseek(fd, off, SEEK_SET) < 0 || read(fd, &rec_len, 1) != 1 || rec_len > len ||
+            read(fd, buf, rec_len) != rec_len)
+        rec_len = 0;
+    close(fd);
+    return rec_len;
+}
+
+#else
+
+/* No storage, contacts are only logged */
+static BOOL bt_pbap_store_init(void)
+{
+    g_pbap_store.inited = 1;
+    return TRUE;
+}
+
+static BOOL bt_pbap_store_open(void)
+{
+    return TRUE;
+}
+
+static BOOL bt_pbap_store_write(U32 index, const U8 *buf, U32 len)
+{
+    return TRUE;
+}
+
+static void bt_pbap_store_close(void)
+{
+}
+
+static U32 bt_pbap_store_read(U32 index, U8 *buf, U32 len)
+{
+    return 0;
+}
+
+#endif
+
+void bt_pbap_store_begin(void)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+
+    if (store->busy)
+        bt_pbap_store_end(FALSE);
+
+    if (!bt_pbap_store_init() || !bt_pbap_store_open())
+        return;
+
+    store->prev_num = store->num;
+    store->num = 0;
+    store->busy = 1;
+}
+
+void bt_pbap_store_add(const bt_pbap_contact_t *contact)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    U32 len;
+
+    LOG_D("pbap contact[%d] %.*s tel %d", store->num, contact->name_len, contact->name, contact->tel_num);
+    if (!store->busy)
+        return;
+
+    len = bt_pbap_record_pack(store->buf, contact);
+    if (!bt_pbap_store_write(store->num, store->buf, len))
+    {
+        LOG_E("pbap store write fail at %d", store->num);
+        bt_pbap_store_close();
+        store->busy = 0;
+        return;
+    }
+    store->num++;
+}
+
+void bt_pbap_store_end(BOOL complete)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+
+    if (!store->busy)
+        return;
+
+    bt_pbap_store_close();
+    store->busy = 0;
+    store->prev_num = store->num;
+    LOG_I("pbap store %s, %d contacts", complete ? "done" : "aborted", store->num);
+}
+
+U32 bt_pbap_store_count(void)
+{
+    if (!bt_pbap_store_init() || g_pbap_store.busy)
+        return 0;
+    return g_pbap_store.num;
+}
+
+BOOL bt_pbap_store_get(U32 index, bt_pbap_contact_t *contact)
+{
+    bt_pbap_store_t *store = &g_pbap_store;
+    U32 len;
+
+    if (index >= bt_pbap_store_count())
+        return FALSE;
+
+    len = bt_pbap_store_read(index, store->buf, sizeof(store->buf));
+    return bt_pbap_record_unpack(store->buf, len, contact);
+}
+
+#ifdef RT_USING_FINSH
+static void bt_pbap_store(uint8_t argc, char **argv)
+{
+    bt_pbap_contact_t contact;
+    U32 start = 0, num = 10, i;
+    U8 j;
+
+    if (argc > 1)
+        start = atoi(argv[1]);
+    if (argc > 2)
+        num = atoi(argv[2]);
+
+    rt_kprintf("pbap store: %d contacts%s\n", bt_pbap_store_count(), g_pbap_store.busy ? ", downloading" : "");
+    for (i = start; i < start + num && bt_pbap_store_get(i, &contact); i++)
+    {
+        rt_kprintf("%d: %.*s", i, contact.name_len, contact.name);
+        for (j = 0; j < contact.tel_num; j++)
+            rt_kprintf(" %.*s", contact.tel_len[j], contact.tel[j]);
+        rt_kprintf("\n");
+    }
+}
+MSH_CMD_EXPORT(bt_pbap_store, show downloaded phone book: bt_pbap_store [start] [num]);
+#endif
+
+#endif /* CFG_PBAP_CLT */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
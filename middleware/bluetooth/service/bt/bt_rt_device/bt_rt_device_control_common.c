@@ -478,6 +478,12 @@ bt_err_t bt_sifli_control_common(struct rt_bt_device *bt_handle, int cmd, void *
     }
     break;
 
+    case BT_CONTROL_SET_URC_BATCH:
+    {
+        ret = urc_batch_config((bt_urc_batch_cfg_t *)args);
+    }
+    break;
+
     default:
         ret = BT_ERROR_UNSUPPORTED;
         break;
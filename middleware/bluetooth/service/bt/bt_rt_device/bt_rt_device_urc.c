@@ -133,6 +133,7 @@ void urc_func_profile_disc_sifli(uint8_t *addr, bt_profile_t profile, uint8_t re
     rt_memcpy(info.peer_addr.addr, addr, BT_MAX_MAC_LEN);
     info.conn_idx = bt_cm_find_conn_index_by_addr((uint8_t *)info.peer_addr.addr);
     args.args = &info;
+    urc_batch_flush();
     rt_bt_event_notify(&args);
 
 #ifdef BT_USING_AVRCP
@@ -579,10 +580,143 @@ static int bt_sifli_notify_pan_event_hdl(uint16_t event_id, uint8_t *data, uint1
     return 0;
 }
 
+#define URC_STAT_TYPE_NUM     (BT_NOTIFY_PBAP + 1)
+
+typedef struct
+{
+    uint32_t events;
+    uint32_t bytes;             /* data from stack */
+    uint32_t copied;            /* copied into batch */
+    uint32_t referenced;        /* passed by reference */
+} urc_stat_t;
+
+typedef struct
+{
+    rt_mutex_t lock;
+    struct rt_timer timer;
+    uint16_t flush_ms;
+    uint16_t ref_size;
+    uint16_t num;
+    uint16_t used;
+    uint32_t batches;
+    bt_notify_t items[BT_URC_BATCH_NUM];
+    uint32_t buf[BT_URC_BATCH_BUF_SIZE / sizeof(uint32_t)];
+} urc_batch_t;
+
+static urc_batch_t g_urc_batch;
+static urc_stat_t g_urc_stat[URC_STAT_TYPE_NUM];
+
+void urc_batch_flush(void)
+{
+    urc_batch_t *batch = &g_urc_batch;
+    bt_urc_batch_t ind;
+    bt_notify_t args;
+
+    if (batch->num == 0)
+    {
+        return;
+    }
+
+    rt_mutex_take(batch->lock, RT_WAITING_FOREVER);
+    if (batch->num)
+    {
+        rt_timer_stop(&batch->timer);
+        ind.num = batch->num;
+        ind.items = batch->items;
+        args.event = BT_EVENT_URC_BATCH;
+        args.args = &ind;
+        /* Keep locked so that next batch is not started before receivers are done */
+        rt_bt_event_notify(&args);
+        batch->num = 0;
+        batch->used = 0;
+        batch->batches++;
+    }
+    rt_mutex_release(batch->lock);
+}
+
+static void urc_batch_timeout(void *param)
+{
+    urc_batch_flush();
+}
+
+void *urc_batch_alloc(uint16_t type, uint16_t event, uint32_t size)
+{
+    urc_batch_t *batch = &g_urc_batch;
+    void *buf;
+
+    size = RT_ALIGN(size, sizeof(uint32_t));
+    if (batch->flush_ms == 0 || size > batch->ref_size || size > BT_URC_BATCH_BUF_SIZE)
+    {
+        urc_batch_flush();
+        if (type < URC_STAT_TYPE_NUM)
+        {
+            g_urc_stat[type].referenced += size;
+        }
+        return NULL;
+    }
+
+    rt_mutex_take(batch->lock, RT_WAITING_FOREVER);
+    if (batch->num == BT_URC_BATCH_NUM || batch->used + size > BT_URC_BATCH_BUF_SIZE)
+    {
+        urc_batch_flush();
+    }
+
+    buf = (uint8_t *)batch->buf + batch->used;
+    batch->items[batch->num].event = event;
+    batch->items[batch->num].args = buf;
+    batch->used += size;
+    if (batch->num++ == 0)
+    {
+        rt_timer_start(&batch->timer);
+    }
+    if (type < URC_STAT_TYPE_NUM)
+    {
+        g_urc_stat[type].copied += size;
+    }
+
+    return buf;
+}
+
+void urc_batch_commit(void)
+{
+    rt_mutex_release(g_urc_batch.lock);
+}
+
+bt_err_t urc_batch_config(bt_urc_batch_cfg_t *cfg)
+{
+    urc_batch_t *batch = &g_urc_batch;
+    rt_tick_t tick;
+
+    if (cfg == NULL || batch->lock == NULL)
+    {
+        return BT_ERROR_INPARAM;
+    }
+
+    urc_batch_flush();
+    rt_mutex_take(batch->lock, RT_WAITING_FOREVER);
+    batch->flush_ms = cfg->flush_ms;
+    batch->ref_size = cfg->ref_size ? cfg->ref_size : BT_URC_BATCH_REF_SIZE;
+    if (batch->flush_ms)
+    {
+        tick = rt_tick_from_millisecond(batch->flush_ms);
+        rt_timer_control(&batch->timer, RT_TIMER_CTRL_SET_TIME, &tick);
+    }
+    rt_mutex_release(batch->lock);
+    LOG_I("URC batch %dms, ref size %d", batch->flush_ms, batch->ref_size);
+
+    return BT_EOK;
+}
+
 static int bt_notify_handle(uint16_t type, uint16_t event_id, uint8_t *data, uint16_t data_len)
 {
     int ret = -1;
 
+    if (type < URC_STAT_TYPE_NUM)
+    {
+        g_urc_stat[type].events++;
+        g_urc_stat[type].bytes += data_len;
+    }
+
     switch (type)
     {
     case BT_NOTIFY_COMMON:
@@ -669,11 +803,56 @@ static int bt_notify_handle(uint16_t type, uint16_t event_id, uint8_t *data, uin
 
 int app_bt_notify_init(void)
 {
+    g_urc_batch.lock = rt_mutex_create("urc_batch", RT_IPC_FLAG_FIFO);
+    RT_ASSERT(g_urc_batch.lock);
+    g_urc_batch.ref_size = BT_URC_BATCH_REF_SIZE;
+    rt_timer_init(&g_urc_batch.timer, "urc_batch", urc_batch_timeout, NULL, 1,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
     bt_interface_register_bt_event_notify_callback(bt_notify_handle);
     return BT_EOK;
 }
 
 INIT_ENV_EXPORT(app_bt_notify_init);
+
+#ifdef RT_USING_FINSH
+static void bt_urc_stat(uint8_t argc, char **argv)
+{
+    static const char *const type_name[URC_STAT_TYPE_NUM] =
+    {
+        "common", "hf", "ag", "a2dp", "avrcp", "hid", "pan", "spp", "gatt", "pbap"
+    };
+    static rt_tick_t start;
+    rt_tick_t ms = rt_tick_get_millisecond() - start;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        rt_memset(g_urc_stat, 0, sizeof(g_urc_stat));
+        g_urc_batch.batches = 0;
+        start = rt_tick_get_millisecond();
+        return;
+    }
+
+    if (ms == 0)
+    {
+        ms = 1;
+    }
+    rt_kprintf("batch %dms, ref size %d, batches %d\n", g_urc_batch.flush_ms, g_urc_batch.ref_size,
+               g_urc_batch.batches);
+    rt_kprintf("%-8s %8s %6s %10s %10s %10s\n", "profile", "events", "ev/s", "bytes", "copied", "ref");
+    for (uint32_t i = 0; i < URC_STAT_TYPE_NUM; i++)
+    {
+        urc_stat_t *stat = &g_urc_stat[i];
+
+        if (stat->events == 0)
+        {
+            continue;
+        }
+        rt_kprintf("%-8s %8d %6d %10d %10d %10d\n", type_name[i], stat->events,
+                   (uint32_t)((uint64_t)stat->events * 1000 / ms), stat->bytes, stat->copied, stat->referenced);
+    }
+}
+MSH_CMD_EXPORT(bt_urc_stat, bt_urc_stat [reset]: show BT event rate and copied bytes per profile);
+#endif
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
 
 
@@ -51,6 +51,19 @@
 #include <board.h>
 #include "bts2_bt.h"
 
+/* Max events in one BT_EVENT_URC_BATCH */
+#ifndef BT_URC_BATCH_NUM
+    #define BT_URC_BATCH_NUM        (16)
+#endif
+
+/* Copied args of batched events */
+#ifndef BT_URC_BATCH_BUF_SIZE
+    #define BT_URC_BATCH_BUF_SIZE   (2048)
+#endif
+
+#ifndef BT_URC_BATCH_REF_SIZE
+    #define BT_URC_BATCH_REF_SIZE   (512)
+#endif
 
 extern    void urc_func_inq_sifli(uint8_t *adrr, uint32_t nameSize, char *name, uint32_t dev_cls);
 extern    void urc_func_inq_finished_sifli(void);
@@ -82,6 +95,15 @@ extern    void urc_func_bt_remote_name_sifli(uint8_t *addr, uint8_t res, BTS2S_D
 
 extern __ROM_USED void rt_bt_event_notify(bt_notify_t *param);
 
+/* Return buffer for args of event in current batch with batch locked, fill it and call
+ * urc_batch_commit(). Return NULL if event is to be notified directly, previous batched
+ * events are notified before. type is bt_notify_type_id_t of event for statistics. */
+void *urc_batch_alloc(uint16_t type, uint16_t event, uint32_t size);
+void urc_batch_commit(void);
+/* Notify batched events, called before other events of a batched profile to keep order */
+void urc_batch_flush(void);
+bt_err_t urc_batch_config(bt_urc_batch_cfg_t *cfg);
+
 
 #endif /* _BT_RT_DEVICE_URC_H */
 
@@ -63,10 +63,20 @@
 void urc_func_pbap_vcard_list_notify(pbap_vcard_listing_item_t *msg)
 {
     bt_notify_t args;
+    pbap_vcard_listing_item_t *batch_item;
+
+    batch_item = urc_batch_alloc(BT_NOTIFY_PBAP, BT_EVENT_VCARD_LIST_ITEM_NOTIFY, sizeof(pbap_vcard_listing_item_t));
+    if (batch_item)
+    {
+        rt_memcpy(batch_item, msg, sizeof(pbap_vcard_listing_item_t));
+        urc_batch_commit();
+        return;
+    }
+
     args.event = BT_EVENT_VCARD_LIST_ITEM_NOTIFY;
     args.args = msg;
     rt_bt_event_notify(&args);
-    LOG_I("URC bt vcard_list notify %s len:%d", msg->vcard_name, msg->name_len);
+    LOG_D("URC bt vcard_list notify %s len:%d", msg->vcard_name, msg->name_len);
 }
 
 void urc_func_pbap_vcard_list_cmp(U8 res)
@@ -74,6 +84,7 @@ void urc_func_pbap_vcard_list_cmp(U8 res)
     bt_notify_t args;
     args.event = BT_EVENT_VCARD_LIST_CMP;
     args.args = &res;
+    urc_batch_flush();
     rt_bt_event_notify(&args);
     LOG_I("URC bt vcard_list notify cmp %d", res);
 }
@@ -71,6 +71,7 @@ void urc_func_spp_conn_ind_sifli(uint8_t *addr, U8 srv_chl, U8 *uuid, U8 uuid_le
     spp_conn_ind.mtu_size = mfs;
     args.event = BT_EVENT_SPP_CONN_IND;
     args.args = &spp_conn_ind;
+    urc_batch_flush();
     rt_bt_event_notify(&args);
     LOG_I("URC BT spp conn ind");
 }
@@ -79,6 +80,24 @@ void urc_func_spp_data_ind_sifli(U8 *payload, U16 payload_len, uint8_t *addr, U8
 {
     bt_notify_t args;
     bt_spp_data_t data_ind = {0};
+    bt_spp_data_t *batch_ind;
+
+    /* Small payloads are copied into batch, large ones are passed by reference as before */
+    batch_ind = urc_batch_alloc(BT_NOTIFY_SPP, BT_EVENT_SPP_DATA_IND, sizeof(bt_spp_data_t) + payload_len + uuid_len);
+    if (batch_ind)
+    {
+        rt_memcpy(batch_ind->peer_addr.addr, addr, BT_MAX_MAC_LEN);
+        batch_ind->srv_chl = srv_chl;
+        batch_ind->payload = (uint8_t *)(batch_ind + 1);
+        batch_ind->payload_len = payload_len;
+        rt_memcpy(batch_ind->payload, payload, payload_len);
+        batch_ind->uuid = batch_ind->payload + payload_len;
+        batch_ind->uuid_len = uuid_len;
+        rt_memcpy(batch_ind->uuid, uuid, uuid_len);
+        urc_batch_commit();
+        return;
+    }
+
     data_ind.payload = payload;
     data_ind.payload_len = payload_len;
     rt_memcpy(data_ind.peer_addr.addr, addr, BT_MAX_MAC_LEN);
@@ -88,7 +107,7 @@ void urc_func_spp_data_ind_sifli(U8 *payload, U16 payload_len, uint8_t *addr, U8
     args.event = BT_EVENT_SPP_DATA_IND;
     args.args = &data_ind;
     rt_bt_event_notify(&args);
-    LOG_I("URC BT spp data ind");
+    LOG_D("URC BT spp data ind");
 }
 
 void urc_func_spp_data_cfm_sifli(uint8_t *addr, U8 srv_chl, U8 *uuid, U8 uuid_len)
@@ -102,6 +121,7 @@ void urc_func_spp_data_cfm_sifli(uint8_t *addr, U8 srv_chl, U8 *uuid, U8 uuid_le
 
     args.event = BT_EVENT_SPP_DATA_CFM;
     args.args = &data_cfm;
+    urc_batch_flush();
     rt_bt_event_notify(&args);
     LOG_I("URC BT spp data cfm");
     return;
@@ -117,6 +137,7 @@ void urc_func_spp_disconn_ind_sifli(uint8_t *addr, U8 srv_chl, U8 *uuid, U8 uuid
     spp_disconn_ind.srv_chl = srv_chl;
     args.event = BT_EVENT_SPP_DISCONN_IND;
     args.args = &spp_disconn_ind;
+    urc_batch_flush();
     rt_bt_event_notify(&args);
     LOG_I("URC BT spp disconn ind");
 }
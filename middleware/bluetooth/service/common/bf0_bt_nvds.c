@@ -111,6 +111,15 @@
 
 
 #define SIBLE_NVDS_POOL_NUM 2
+/* Tags of stack and app pool are all below this, directory keeps offset of each tag in its pool */
+#define SIFLI_NVDS_DIR_SIZE     (NVDS_STACK_TAG_APP_SPECIFIC_LAST + 1)
+#define SIFLI_NVDS_DIR_NONE     0xFFFF
+
+/* Flush requested by tag write is delayed, so writes during bring-up and pairing go to flash at once.
+   0 to flush immediately. */
+#ifndef SIFLI_NVDS_FLUSH_DELAY_MS
+    #define SIFLI_NVDS_FLUSH_DELAY_MS   500
+#endif
 #define SIB_NVDS_ERR_CHECK(ret) \
     if (!(ret)) \
         break;
@@ -136,14 +145,31 @@ typedef struct
 typedef struct
 {
     uint8_t is_init;
+    uint8_t is_lock_init;
 } bt_nvds_env_t;
 
+typedef struct
+{
+    uint32_t tag_read;
+    uint32_t tag_write;
+    uint32_t flash_read;
+    uint32_t flash_write;
+    uint32_t flash_ms;      /* time spent in flash read and write */
+    uint32_t init_ms;       /* time of sifli_nvds_init */
+} sifli_nvds_stat_t;
+
 
 /*
  * GLOBAL VARIABLES
  ****************************************************************************************
 */
 static sibles_nvds_temp_buffer_t g_sible_nvds_temp_buf[SIBLE_NVDS_POOL_NUM];
+static uint16_t g_sible_nvds_dir[SIFLI_NVDS_DIR_SIZE];
+static struct rt_mutex g_sible_nvds_lock;
+#if defined(RT_USING_TIMER_SOFT) && (SIFLI_NVDS_FLUSH_DELAY_MS > 0)
+    static rt_timer_t g_sible_nvds_flush_timer;
+#endif
+static sifli_nvds_stat_t g_sible_nvds_stat;
 static bt_nvds_env_t g_bt_nvds_env;
 
 
@@ -194,6 +220,7 @@ const static bd_addr_t g_default_bdaddr = BLE_DEFAULT_BDADDR;
 
 
 static uint8_t *sifli_nvds_read_int(sifli_nvds_type_t type, uint16_t *len);
+static uint8_t *sifli_nvds_read_flash(sifli_nvds_type_t type, uint16_t *len);
 static void sifli_nvds_init_db(void);
 static uint8_t sifli_nvds_construct_default_val(sifli_nvds_type_t type, uint8_t *ptr, uint16_t *len);
 
@@ -219,6 +246,19 @@ static uint8_t sifli_nvds_is_init(void)
     return g_bt_nvds_env.is_init;
 }
 
+/* Pools may be written by BT thread, app and delayed flush */
+static void sifli_nvds_lock(void)
+{
+    if (g_bt_nvds_env.is_lock_init)
+        rt_mutex_take(&g_sible_nvds_lock, RT_WAITING_FOREVER);
+}
+
+static void sifli_nvds_unlock(void)
+{
+    if (g_bt_nvds_env.is_lock_init)
+        rt_mutex_release(&g_sible_nvds_lock);
+}
+
 
 /*
  * Porting APIs
@@ -396,6 +436,67 @@ static sifli_nvds_tag_value_t *sifli_nvds_get_tag_value_via_buffer(uint8_t *buff
 
 
 
+/* Build directory of one pool, first tag found is used as linear search does */
+static void sifli_nvds_dir_build(uint8_t index)
+{
+    sibles_nvds_temp_buffer_t *pool = &g_sible_nvds_temp_buf[index];
+    uint16_t off = 0;
+
+    for (uint32_t i = 0; i < SIFLI_NVDS_DIR_SIZE; i++)
+    {
+        if (sifli_nvds_type_tag_check(i) == index + 1)
+            g_sible_nvds_dir[i] = SIFLI_NVDS_DIR_NONE;
+    }
+    while (off + sizeof(sifli_nvds_tag_value_t) <= pool->buffer_len)
+    {
+        sifli_nvds_tag_value_t *val = (sifli_nvds_tag_value_t *)(pool->buffer + off);
+        if (val->len == 0 || off + sizeof(sifli_nvds_tag_value_t) + val->len > pool->buffer_len)
+            break;
+        if (sifli_nvds_type_tag_check(val->tag) == index + 1
+                && g_sible_nvds_dir[val->tag] == SIFLI_NVDS_DIR_NONE)
+            g_sible_nvds_dir[val->tag] = off;
+        off += sizeof(sifli_nvds_tag_value_t) + val->len;
+    }
+}
+
+static sifli_nvds_tag_value_t *sifli_nvds_dir_get(uint8_t index, uint8_t tag)
+{
+    uint16_t off = g_sible_nvds_dir[tag];
+    if (off == SIFLI_NVDS_DIR_NONE)
+        return NULL;
+    return (sifli_nvds_tag_value_t *)(g_sible_nvds_temp_buf[index].buffer + off);
+}
+
+/* Pool is loaded from flash once and kept, called with lock */
+static sibles_nvds_temp_buffer_t *sifli_nvds_pool_get(sifli_nvds_type_t type)
+{
+    uint8_t index = type - 1;
+    sibles_nvds_temp_buffer_t *pool = &g_sible_nvds_temp_buf[index];
+
+    if (pool->buffer == NULL)
+    {
+        /* Not cache empty value before flash is ready */
+        if (!sifli_nvds_is_init())
+            return NULL;
+        pool->buffer = sifli_nvds_read_flash(type, &pool->buffer_len);
+        if (pool->buffer == NULL)
+            return NULL;
+        pool->is_dirty = 0;
+        sifli_nvds_dir_build(index);
+    }
+    return pool;
+}
+
+static void sifli_nvds_pool_drop(void)
+{
+    for (uint32_t i = 0; i < SIBLE_NVDS_POOL_NUM; i++)
+    {
+        if (g_sible_nvds_temp_buf[i].buffer)
+            bt_mem_free(g_sible_nvds_temp_buf[i].buffer);
+        memset(&g_sible_nvds_temp_buf[i], 0, sizeof(sibles_nvds_temp_buffer_t));
+    }
+}
+
 static uint8_t sifli_nvds_modify_tag(uint8_t *buffer_pool, uint16_t *buffer_pool_len, uint16_t max_len,
                                      sifli_nvds_tag_value_t *old_tag, sifli_nvds_tag_value_t *new_tag)
 {
@@ -408,11 +509,9 @@ static uint8_t sifli_nvds_modify_tag(uint8_t *buffer_pool, uint16_t *buffer_pool
             return is_modified;
         /* 2. Remove old_tag. */
         uint16_t old_tag_len = old_tag->len + sizeof(sifli_nvds_tag_value_t);
-        sifli_nvds_tag_value_t *next_tag = (sifli_nvds_tag_value_t *)((uint8_t *)old_tag + old_tag->len);
-        if (next_tag->len != 0)
-            memcpy((uint8_t *)old_tag, (uint8_t *)next_tag, *buffer_pool_len - old_tag_len);
-        else
-            memset((uint8_t *)old_tag, 0, old_tag_len);
+        uint8_t *next_tag = (uint8_t *)old_tag + old_tag_len;
+        memmove((uint8_t *)old_tag, next_tag, buffer_pool + *buffer_pool_len - next_tag);
+        memset(buffer_pool + *buffer_pool_len - old_tag_len, 0, old_tag_len);
         /* 3. Add new tag. */
         uint16_t new_tag_len = new_tag->len + sizeof(sifli_nvds_tag_value_t);
         memcpy((uint8_t *)buffer_pool + *buffer_pool_len - old_tag_len, new_tag, new_tag_len);
@@ -479,63 +578,88 @@ uint8_t sifli_nvds_write_tag_value_via_buffer(uint8_t *buffer, uint16_t *buffer_
 
 }
 
+#if defined(RT_USING_TIMER_SOFT) && (SIFLI_NVDS_FLUSH_DELAY_MS > 0)
+static void sifli_nvds_flush_timeout(void *parameter)
+{
+    sifli_nvds_flush();
+}
+#endif
+
+/* Each request restarts the delay, flush runs in timer thread */
+static void sifli_nvds_flush_later(void)
+{
+#if defined(RT_USING_TIMER_SOFT) && (SIFLI_NVDS_FLUSH_DELAY_MS > 0)
+    if (g_sible_nvds_flush_timer == NULL)
+        g_sible_nvds_flush_timer = rt_timer_create("nvds", sifli_nvds_flush_timeout, NULL,
+                                   rt_tick_from_millisecond(SIFLI_NVDS_FLUSH_DELAY_MS),
+                                   RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+    if (g_sible_nvds_flush_timer)
+    {
+        rt_timer_start(g_sible_nvds_flush_timer);
+        return;
+    }
+#endif
+    sifli_nvds_flush();
+}
+
 uint8_t sifli_nvds_write_tag_value(sifli_nvds_write_tag_t *tag)
 {
     uint8_t ret = NVDS_FAIL;
     uint8_t is_dirty = 0;
     uint16_t buffer_pool_max_len[] = {SIFLI_NVDS_KEY_LEN_STACK, SIFLI_NVDS_KEY_LEN_APP};
     uint8_t index;
+    sibles_nvds_temp_buffer_t *pool = NULL;
+
+    if (tag == NULL || tag->type == BLE_UPDATE_NO_UPDATE)
+        return ret;
+
+    sifli_nvds_lock();
+    g_sible_nvds_stat.tag_write++;
     do
     {
         sifli_nvds_type_t ble_type;
-        uint16_t read_len;
-        uint8_t *buffer;
-
-        if (tag->type == BLE_UPDATE_NO_UPDATE)
-            break;
-
-        SIB_NVDS_ERR_CHECK(tag);
 
         ble_type =  sifli_nvds_type_tag_check(tag->value.tag);
         SIB_NVDS_ERR_CHECK(ble_type);
 
         index = ble_type - 1;
-        if (g_sible_nvds_temp_buf[index].buffer == NULL)
-            g_sible_nvds_temp_buf[index].buffer = sifli_nvds_read_int(ble_type, &g_sible_nvds_temp_buf[index].buffer_len);
-        SIB_NVDS_ERR_CHECK(g_sible_nvds_temp_buf[index].buffer);
+        pool = sifli_nvds_pool_get(ble_type);
+        SIB_NVDS_ERR_CHECK(pool);
 
-        read_len = g_sible_nvds_temp_buf[index].buffer_len;
-        buffer =  g_sible_nvds_temp_buf[index].buffer;
-
-        if (read_len)
+        sifli_nvds_tag_value_t *search_tag = sifli_nvds_dir_get(index, tag->value.tag);
+        if (search_tag)
         {
-            sifli_nvds_tag_value_t *search_tag = sifli_nvds_get_tag_value_via_buffer(buffer, read_len, tag->value.tag);
-            if (search_tag)
+            /* Only update the tag for SIFLI_NVDS_UPDATE_ALWAYS. */
+            if (tag->type == BLE_UPDATE_ALWAYS)
             {
-                /* Only update the tag for SIFLI_NVDS_UPDATE_ALWAYS. */
-                if (tag->type == BLE_UPDATE_ALWAYS)
-                {
-                    is_dirty = sifli_nvds_modify_tag(buffer, &g_sible_nvds_temp_buf[index].buffer_len,
-                                                     buffer_pool_max_len[index], search_tag, &tag->value);
-                }
-                ret = NVDS_OK;
-                break;
+                uint8_t old_len = search_tag->len;
+                is_dirty = sifli_nvds_modify_tag(pool->buffer, &pool->buffer_len,
+                                                 buffer_pool_max_len[index], search_tag, &tag->value);
+                /* Same length is updated in place, otherwise tags behind are moved */
+                if (is_dirty && old_len != tag->value.len)
+                    sifli_nvds_dir_build(index);
             }
+            ret = NVDS_OK;
+            break;
         }
 
-        is_dirty = sifli_nvds_add_tag(buffer, &g_sible_nvds_temp_buf[index].buffer_len, buffer_pool_max_len[index],
+        uint16_t off = pool->buffer_len;
+        is_dirty = sifli_nvds_add_tag(pool->buffer, &pool->buffer_len, buffer_pool_max_len[index],
                                       &tag->value);
+        if (is_dirty)
+            g_sible_nvds_dir[tag->value.tag] = off;
         ret = NVDS_OK;
     }
     while (0);
 
     if (ret == NVDS_OK)
     {
-        g_sible_nvds_temp_buf[index].is_dirty |= is_dirty;
+        pool->is_dirty |= is_dirty;
     }
+    sifli_nvds_unlock();
 
     if (tag->is_flush)
-        sifli_nvds_flush();
+        sifli_nvds_flush_later();
 
     return ret;
 }
@@ -546,20 +670,20 @@ uint8_t sifli_nvds_read_tag_value(sifli_nvds_read_tag_t *tag, uint8_t *tag_buffe
 {
     int8_t ret = NVDS_FAIL;
     sifli_nvds_tag_value_t *tag_val = NULL;
-    uint8_t *buffer = NULL;
+
+    if (tag == NULL || tag_buffer == NULL)
+        return ret;
+
+    sifli_nvds_lock();
+    g_sible_nvds_stat.tag_read++;
     do
     {
-        SIB_NVDS_ERR_CHECK((tag != NULL) && (tag_buffer != NULL));
-
         uint8_t ble_type = sifli_nvds_type_tag_check(tag->tag);
         SIB_NVDS_ERR_CHECK(ble_type);
 
-        uint16_t read_len;
-        buffer = sifli_nvds_read_int(ble_type, &read_len);
-        SIB_NVDS_ERR_CHECK(buffer);
-
-        tag_val = sifli_nvds_get_tag_value_via_buffer(buffer, read_len, tag->tag);
+        SIB_NVDS_ERR_CHECK(sifli_nvds_pool_get(ble_type));
 
+        tag_val = sifli_nvds_dir_get(ble_type - 1, tag->tag);
     }
     while (0);
 
@@ -570,35 +694,61 @@ uint8_t sifli_nvds_read_tag_value(sifli_nvds_read_tag_t *tag, uint8_t *tag_buffe
         tag->length = len;
         ret = NVDS_OK;
     }
+    sifli_nvds_unlock();
 
-    if (buffer)
-        bt_mem_free(buffer);
     return ret;
 }
 
 
+/* Dirty pools are written, pools are kept as cache of flash */
 uint8_t sifli_nvds_flush(void)
 {
     uint8_t ret;
+    sifli_nvds_lock();
     for (uint32_t i = 0; i < SIBLE_NVDS_POOL_NUM; i++)
     {
-        if (g_sible_nvds_temp_buf[i].buffer)
+        if (g_sible_nvds_temp_buf[i].buffer && g_sible_nvds_temp_buf[i].is_dirty)
         {
-            if (g_sible_nvds_temp_buf[i].is_dirty)
-            {
-                ret = sifli_nvds_write(i + 1, g_sible_nvds_temp_buf[i].buffer_len, g_sible_nvds_temp_buf[i].buffer);
-                LOG_HEX("nvds_cache", 16, (uint8_t *)g_sible_nvds_temp_buf[i].buffer, g_sible_nvds_temp_buf[i].buffer_len);
-                if (ret != NVDS_OK)
-                    LOG_E("nvds(%d) flush failed", i);
-            }
-            bt_mem_free(g_sible_nvds_temp_buf[i].buffer);
-            memset(&g_sible_nvds_temp_buf[i], 0, sizeof(sibles_nvds_temp_buffer_t));
+            ret = sifli_nvds_write(i + 1, g_sible_nvds_temp_buf[i].buffer_len, g_sible_nvds_temp_buf[i].buffer);
+            LOG_HEX("nvds_cache", 16, (uint8_t *)g_sible_nvds_temp_buf[i].buffer, g_sible_nvds_temp_buf[i].buffer_len);
+            if (ret != NVDS_OK)
+                LOG_E("nvds(%d) flush failed", i);
+            else
+                g_sible_nvds_temp_buf[i].is_dirty = 0;
         }
     }
+    sifli_nvds_unlock();
     return NVDS_OK;
 }
 
+/* Return copy of the whole value in buffer of maximum length, stack and app are read from cache */
 static uint8_t *sifli_nvds_read_int(sifli_nvds_type_t type, uint16_t *len)
+{
+    uint8_t *ptr = NULL;
+    if (type == SIFLI_NVDS_TYPE_STACK || type == SIFLI_NVDS_TYPE_APP)
+    {
+        uint16_t max_len = (type == SIFLI_NVDS_TYPE_STACK) ? SIFLI_NVDS_KEY_LEN_STACK : SIFLI_NVDS_KEY_LEN_APP;
+        sibles_nvds_temp_buffer_t *pool;
+        sifli_nvds_lock();
+        pool = sifli_nvds_pool_get(type);
+        if (pool)
+        {
+            ptr = bt_mem_alloc(max_len);
+            if (ptr)
+            {
+                memset(ptr, 0, max_len);
+                memcpy(ptr, pool->buffer, pool->buffer_len);
+                *len = pool->buffer_len;
+            }
+        }
+        sifli_nvds_unlock();
+        if (ptr)
+            return ptr;
+    }
+    return sifli_nvds_read_flash(type, len);
+}
+
+static uint8_t *sifli_nvds_read_flash(sifli_nvds_type_t type, uint16_t *len)
 {
     uint8_t *ptr = NULL;
     size_t read_len = 0;
@@ -681,7 +831,12 @@ size_t sifli_nvds_flash_read(const char *key, void *value_buf, size_t buf_len)
 {
     size_t read_len = 0;
     if (sifli_nvds_is_init())
+    {
+        uint32_t start = rt_tick_get_millisecond();
         read_len = sifli_nvds_flash_adaptor_read(key, value_buf, buf_len);
+        g_sible_nvds_stat.flash_ms += rt_tick_get_millisecond() - start;
+        g_sible_nvds_stat.flash_read++;
+    }
     return read_len;
 }
 
@@ -691,7 +846,12 @@ uint8_t sifli_nvds_flash_write(const char *key, const void *value_buf, size_t bu
 {
     uint8_t ret = NVDS_FAIL;
     if (sifli_nvds_is_init())
+    {
+        uint32_t start = rt_tick_get_millisecond();
         ret = sifli_nvds_flash_adaptor_write(key, value_buf, buf_len);
+        g_sible_nvds_stat.flash_ms += rt_tick_get_millisecond() - start;
+        g_sible_nvds_stat.flash_write++;
+    }
 
     return ret;
 }
@@ -738,7 +898,12 @@ uint8_t sifli_nvds_read(sifli_nvds_type_t type, uint16_t *len, uint8_t *buffer)
 
 void sifli_nvds_flash_reset(const char *key)
 {
+    sifli_nvds_lock();
+    /* Pending writes of the other keys are kept */
+    sifli_nvds_flush();
+    sifli_nvds_pool_drop();
     sifli_nvds_flash_delete(key);
+    sifli_nvds_unlock();
     // Only init stack key
     sifli_nvds_init_db();
 }
@@ -748,6 +913,26 @@ uint8_t sifli_nvds_get_default_vaule(uint8_t *ptr, uint16_t *len)
     return sifli_nvds_construct_default_val(SIFLI_NVDS_TYPE_STACK, ptr, len);
 }
 
+/* Whole value written to flash by others replaces the cache */
+static void sifli_nvds_pool_update(sifli_nvds_type_t type, uint16_t len, uint8_t *ptr, uint8_t ret)
+{
+    uint8_t index = type - 1;
+    sibles_nvds_temp_buffer_t *pool = &g_sible_nvds_temp_buf[index];
+
+    if (ret != NVDS_OK)
+        return;
+    sifli_nvds_lock();
+    if (pool->buffer && pool->buffer != ptr)
+    {
+        memcpy(pool->buffer, ptr, len);
+        memset(pool->buffer + len, 0, pool->buffer_len > len ? pool->buffer_len - len : 0);
+        pool->buffer_len = len;
+        pool->is_dirty = 0;
+        sifli_nvds_dir_build(index);
+    }
+    sifli_nvds_unlock();
+}
+
 uint8_t sifli_nvds_write(sifli_nvds_type_t type, uint16_t len, uint8_t *ptr)
 {
     uint8_t ret = NVDS_OK;
@@ -761,6 +946,7 @@ uint8_t sifli_nvds_write(sifli_nvds_type_t type, uint16_t len, uint8_t *ptr)
             break;
         }
         ret = sifli_nvds_flash_write(SIFLI_NVDS_KEY_STACK, ptr, len);
+        sifli_nvds_pool_update(type, len, ptr, ret);
         break;
     }
     case SIFLI_NVDS_TYPE_APP:
@@ -771,6 +957,7 @@ uint8_t sifli_nvds_write(sifli_nvds_type_t type, uint16_t len, uint8_t *ptr)
             break;
         }
         ret = sifli_nvds_flash_write(SIFLI_NVDS_KEY_APP, ptr, len);
+        sifli_nvds_pool_update(type, len, ptr, ret);
         break;
     }
     case SIFLI_NVDS_TYPE_CM:
@@ -1258,6 +1445,10 @@ static void sifli_nvds_init_db(void)
         }
         bt_mem_free(ptr);
     }
+    /* Tag directory of both pools is ready before controller bring-up */
+    sifli_nvds_lock();
+    sifli_nvds_pool_get(SIFLI_NVDS_TYPE_APP);
+    sifli_nvds_unlock();
 }
 
 void ble_db_init(void)
@@ -1276,9 +1467,15 @@ void ble_db_init(void)
 
 void sifli_nvds_init(void)
 {
+    uint32_t start = rt_tick_get_millisecond();
 #ifdef FDB_USING_KVDB
     rt_mutex_init(&ble_flash_mutex, "ble_flash_mutex", RT_IPC_FLAG_FIFO);
 #endif
+    if (!g_bt_nvds_env.is_lock_init)
+    {
+        rt_mutex_init(&g_sible_nvds_lock, "nvds", RT_IPC_FLAG_FIFO);
+        g_bt_nvds_env.is_lock_init = 1;
+    }
     ble_db_init();
 #ifdef NVDS_AUTO_UPDATE_MAC_ADDRESS_ENABLE
     ble_nvds_auto_update_address();
@@ -1287,6 +1484,7 @@ void sifli_nvds_init(void)
 #if (defined(SOC_SF32LB56X) || defined(SOC_SF32LB58X))
     ble_nvds_update_xtal_time();
 #endif
+    g_sible_nvds_stat.init_ms = rt_tick_get_millisecond() - start;
 }
 
 
@@ -1367,6 +1565,7 @@ INIT_APP_EXPORT(ble_pm_init);
 /**
     nvds write <type> <total len> <offset> <data in hex string, such as 123ABC, data will be {0x12, 0x3A, 0xBC}>
     nvds read  <type> <total len>
+    nvds stat [reset]
 */
 static void nvds(uint8_t argc, char **argv)
 {
@@ -1440,6 +1639,14 @@ static void nvds(uint8_t argc, char **argv)
                 bt_mem_free(ptr);
             }
         }
+        else if (strcmp(argv[1], "stat") == 0)
+        {
+            sifli_nvds_stat_t *stat = &g_sible_nvds_stat;
+            LOG_I("init %dms, tag read %d write %d, flash read %d write %d %dms",
+                  stat->init_ms, stat->tag_read, stat->tag_write, stat->flash_read, stat->flash_write, stat->flash_ms);
+            if (argc > 2 && strcmp(argv[2], "reset") == 0)
+                memset(stat, 0, sizeof(sifli_nvds_stat_t));
+        }
         else if (strcmp(argv[1], "get_mac") == 0)
         {
             uint8_t addr[NVDS_STACK_LEN_BD_ADDRESS] = {0};
@@ -48,6 +48,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 #include "rtthread.h"
 #include "os_adaptor.h"
 #include "board.h"
@@ -78,7 +79,13 @@
 #define BT_HCI_TIME_LEN (20)
 #define BT_HCI_TIME_OFFSET (0)
 #define BT_HCI_WP_OFFSET (BT_HCI_TIME_LEN)
-#define BT_HCI_DATA_OFFSET (BT_HCI_TIME_OFFSET + BT_HCI_WP_OFFSET)
+#if BT_HCI_RING_SIZE
+    /* Records are btsnoop records after btsnoop file header */
+    #define BT_HCI_SNOOP_HDR_LEN (16)
+#else
+    #define BT_HCI_SNOOP_HDR_LEN (0)
+#endif
+#define BT_HCI_DATA_OFFSET (BT_HCI_WP_OFFSET + sizeof(uint32_t) + BT_HCI_SNOOP_HDR_LEN)
 
 static uint8_t g_file_ready = 1;
 static uint8_t g_filePath[50];
@@ -94,6 +101,32 @@ static uint8_t g_filePath[50];
     static uint8_t g_file_force_flush;
 #endif
 
+#if BT_HCI_RING_SIZE && (defined(USING_FILE_LOGGER)||defined(RT_USING_DFS))
+
+/* btsnoop time of 1970-01-01 00:00:00 in us */
+#define BT_HCI_SNOOP_EPOCH      (0x00DCDDB30F2F8000ULL)
+#define BT_HCI_SNOOP_VERSION    (1)
+/* HCI UART (H4), first byte of packet is packet indicator */
+#define BT_HCI_SNOOP_DATALINK   (1002)
+#define BT_HCI_SNOOP_REC_LEN    (24)
+
+static void bt_hci_put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void bt_hci_snoop_hdr(uint8_t *hdr)
+{
+    memcpy(hdr, "btsnoop", 8);
+    bt_hci_put_be32(hdr + 8, BT_HCI_SNOOP_VERSION);
+    bt_hci_put_be32(hdr + 12, BT_HCI_SNOOP_DATALINK);
+}
+
+#endif
+
 #if defined(USING_FILE_LOGGER)
 
 static uint32_t bt_hci_init_int(uint32_t flush_size)
@@ -109,11 +142,27 @@ static uint32_t bt_hci_init_int(uint32_t flush_size)
     else
         ret = 0;
 
+#if BT_HCI_RING_SIZE
+    if (g_fptr)
+    {
+        uint8_t hdr[BT_HCI_SNOOP_HDR_LEN];
+
+        bt_hci_snoop_hdr(hdr);
+        file_logger_write((void *)g_fptr, hdr, sizeof(hdr));
+    }
+#endif
+
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    /* Don't block BT thread by flash write */
+    if (g_fptr)
+        file_logger_enable_async((void *)g_fptr);
+#endif
+
     return ret;
 
 }
 
-uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
+static uint32_t bt_hci_store_init(uint32_t flush_size, uint32_t is_start)
 {
     uint32_t ret = 0xFF;
 
@@ -150,14 +199,19 @@ uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
 }
 
 
-uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
+static uint32_t bt_hci_store(uint8_t *buffer, uint32_t len)
 {
     uint32_t ret = 1;
 
     if (g_file_ready && g_fptr != 0 && buffer != NULL)
     {
         fl_err_t log_ret = file_logger_write((void *)g_fptr, buffer, len);
-        if (log_ret != FL_OK)
+        if (log_ret == FL_DROPPED)
+        {
+            /* Counted by file logger, avoid log in BT thread */
+            ret = 2;
+        }
+        else if (log_ret != FL_OK)
         {
             LOG_E("HCI write failed %d", log_ret);
             ret = 2;
@@ -169,7 +223,7 @@ uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
     return ret;
 }
 
-uint32_t bt_hci_flush(void)
+static uint32_t bt_hci_store_flush(void)
 {
     uint32_t ret = 1;
 
@@ -230,27 +284,6 @@ uint32_t bt_hci_open(void)
 }
 
 
-static void bt_hci(uint8_t argc, char **argv)
-{
-    if (argc > 1)
-    {
-        if (strcmp(argv[1], "flush") == 0)
-        {
-            bt_hci_flush();
-        }
-        else if (strcmp(argv[1], "open") == 0)
-        {
-            bt_hci_open();
-        }
-        else if (strcmp(argv[1], "close") == 0)
-        {
-            bt_hci_close();
-        }
-    }
-}
-
-MSH_CMD_EXPORT(bt_hci, BT HCI command);
-
 
 #elif defined(RT_USING_DFS)
 
@@ -291,7 +324,7 @@ static uint32_t bt_hci_flush_int(void)
 
 }
 
-uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
+static uint32_t bt_hci_store_init(uint32_t flush_size, uint32_t is_start)
 {
     uint32_t ret = 0xFF;
     g_fptr = -1;
@@ -384,10 +417,16 @@ uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
             ("res w %d", res);
             g_file_pos += sizeof(timeStr);
 
-            g_file_pos += sizeof(g_file_pos);
+            g_file_pos = BT_HCI_DATA_OFFSET;
             res = write(g_fptr, &g_file_pos, sizeof(g_file_pos));
             LOG_I
             ("res w2 %d", res);
+#if BT_HCI_RING_SIZE
+            uint8_t hdr[BT_HCI_SNOOP_HDR_LEN];
+
+            bt_hci_snoop_hdr(hdr);
+            write(g_fptr, hdr, sizeof(hdr));
+#endif
             close(g_fptr);
             g_fptr = open(logName, O_RDWR | O_BINARY, 0);
             fileLen = lseek(g_fptr, 0, SEEK_END);
@@ -411,15 +450,14 @@ uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
 }
 
 
-uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
+static uint32_t bt_hci_store(uint8_t *buffer, uint32_t len)
 {
     rt_base_t level;
     uint8_t is_flushed = 0;
     uint32_t ret = 1;
-    int res;
+
     if (g_file_ready && g_fptr >= 0 && buffer != NULL)
     {
-        LOG_I("write len %d", len);
         level = rt_hw_interrupt_disable();
         g_file_writing = 1;
         rt_hw_interrupt_enable(level);
@@ -432,18 +470,25 @@ uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
         }
         else if (g_file_pos + len > g_file_len)
         {
+#if BT_HCI_RING_SIZE
+            /* Buffer is one record, wrap before it and mark end of records */
+            uint32_t end = 0xFFFFFFFF;
+            if (g_file_len - g_file_pos >= sizeof(end))
+                write(g_fptr, &end, sizeof(end));
+            lseek(g_fptr, BT_HCI_DATA_OFFSET, SEEK_SET);
+            write(g_fptr, (const uint8_t *)buffer, len);
+            g_file_pos = BT_HCI_DATA_OFFSET + len;
+#else
             uint32_t len1 = g_file_len - g_file_pos;
             write(g_fptr, (const uint8_t *)buffer, len1);
             lseek(g_fptr, BT_HCI_DATA_OFFSET, SEEK_SET);
             write(g_fptr, (const uint8_t *)(buffer + len1), len - len1);
             g_file_pos = BT_HCI_DATA_OFFSET + len - len1;
+#endif
         }
         else
         {
-
-            res  = write(g_fptr, (const uint8_t *)buffer, len);
-            LOG_I
-            ("res w3 %d", res);
+            write(g_fptr, (const uint8_t *)buffer, len);
             g_file_pos += len;
         }
         g_file_wr_size += len;
@@ -474,9 +519,8 @@ uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
 
 
 
-uint32_t bt_hci_flush(void)
+static uint32_t bt_hci_store_flush(void)
 {
-    char logName[BT_HCI_MAX_PATH_LEN] = {0};
     rt_base_t level;
 
     uint32_t ret = 0;
@@ -521,7 +565,396 @@ uint32_t bt_hci_open(void)
     return ret;
 }
 
+#endif // USING_FILE_LOGGER || RT_USING_DFS
+
+#if defined(USING_FILE_LOGGER)||defined(RT_USING_DFS)
+
+#if BT_HCI_RING_SIZE
+
+/*
+ * Packets are captured into RAM ring by BT thread and drained to file by low priority
+ * thread, so that flash write doesn't change BT timing.
+ *
+ * Single producer (BT thread) and single consumer (drain thread), wr and rd are free running
+ * byte counters. A record never wraps, tail of ring shorter than record is skipped.
+ * Drained records stay in ring until overwritten, old is the oldest intact record and
+ * snapshot writes all records from it.
+ */
+
+#define BT_HCI_RING_MASK        (BT_HCI_RING_SIZE - 1)
+#define BT_HCI_RING_PAD         (0xFFFF)
+#define BT_HCI_RING_ALIGN(len)  (((len) + 3) & ~3)
+
+#define BT_HCI_H4_CMD           (0x01)
+#define BT_HCI_H4_EVT           (0x04)
+
+#if (BT_HCI_RING_SIZE & BT_HCI_RING_MASK)
+    #error "BT_HCI_RING_SIZE must be power of 2"
+#endif
+
+typedef struct
+{
+    uint16_t orig_len;
+    uint16_t incl_len;          /* BT_HCI_RING_PAD: skip to start of ring */
+    uint32_t ticks;             /* gtimer at capture */
+    uint32_t drops;             /* packets dropped before this one */
+} bt_hci_ring_rec_t;
+
+typedef struct
+{
+    volatile uint32_t wr;
+    volatile uint32_t rd;
+    uint32_t old;
+    uint32_t drops;
+    volatile uint8_t frozen;
+    volatile uint8_t kicked;
+    volatile uint8_t snap_req;
+    volatile uint8_t flush_req;
+    uint32_t captured;
+    uint32_t max_used;
+    uint32_t cycles_max;
+    uint32_t cycles_sum;
+    uint8_t buf[BT_HCI_RING_SIZE];
+} bt_hci_ring_t;
+
+/* Not static, ring and indexes are kept as is after assert to be extracted from RAM dump */
+bt_hci_ring_t g_bt_hci_ring;
+
+static struct rt_semaphore g_hci_sem;
+static rt_thread_t g_hci_tid;
+static uint8_t g_hci_stage[BT_HCI_SNOOP_REC_LEN + BT_HCI_SNAPLEN];
+static uint32_t g_hci_freq;
+static uint32_t g_hci_ref_ticks;
+static uint64_t g_hci_ref_us;
+#ifdef RT_DEBUG
+    static void (*g_hci_prev_assert_hook)(const char *ex, const char *func, rt_size_t line);
+#endif
+
+/* Return NULL if pos is skipped tail of ring, size is bytes to next record */
+static bt_hci_ring_rec_t *bt_hci_ring_rec(bt_hci_ring_t *ring, uint32_t pos, uint32_t *size)
+{
+    uint32_t off = pos & BT_HCI_RING_MASK;
+    bt_hci_ring_rec_t *rec = (bt_hci_ring_rec_t *)&ring->buf[off];
 
+    if (BT_HCI_RING_SIZE - off < sizeof(bt_hci_ring_rec_t) || rec->incl_len == BT_HCI_RING_PAD)
+    {
+        *size = BT_HCI_RING_SIZE - off;
+        return NULL;
+    }
+    *size = sizeof(bt_hci_ring_rec_t) + BT_HCI_RING_ALIGN(rec->incl_len);
+    return rec;
+}
+
+uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
+{
+    bt_hci_ring_t *ring = &g_bt_hci_ring;
+    bt_hci_ring_rec_t *rec;
+    uint32_t incl, need, skip, size, off, wr, used;
+#ifdef DWT
+    uint32_t cycles = HAL_DBG_DWT_GetCycles();
+#endif
+
+    if (!g_file_ready || !g_hci_tid || buffer == NULL || len == 0)
+        return 1;
+
+    if (ring->frozen)
+    {
+        ring->drops++;
+        return 2;
+    }
+
+    incl = (len > BT_HCI_SNAPLEN) ? BT_HCI_SNAPLEN : len;
+    need = sizeof(bt_hci_ring_rec_t) + BT_HCI_RING_ALIGN(incl);
+    wr = ring->wr;
+    off = wr & BT_HCI_RING_MASK;
+    skip = (BT_HCI_RING_SIZE - off < need) ? (BT_HCI_RING_SIZE - off) : 0;
+    if (wr + skip + need - ring->rd > BT_HCI_RING_SIZE)
+    {
+        /* Drain is behind, drop rather than block BT thread */
+        ring->drops++;
+        return 2;
+    }
+
+    /* Drained records to be overwritten are not available for snapshot any more */
+    while (wr + skip + need - ring->old > BT_HCI_RING_SIZE)
+    {
+        bt_hci_ring_rec(ring, ring->old, &size);
+        ring->old += size;
+    }
+
+    if (skip)
+    {
+        if (skip >= sizeof(bt_hci_ring_rec_t))
+            ((bt_hci_ring_rec_t *)&ring->buf[off])->incl_len = BT_HCI_RING_PAD;
+        wr += skip;
+        off = 0;
+    }
+
+    rec = (bt_hci_ring_rec_t *)&ring->buf[off];
+    rec->orig_len = (len > 0xFFFF) ? 0xFFFF : len;
+    rec->incl_len = incl;
+    rec->ticks = HAL_GTIMER_READ();
+    rec->drops = ring->drops;
+    memcpy(rec + 1, buffer, incl);
+    __DMB();
+    ring->wr = wr + need;
+
+    ring->captured++;
+    used = ring->wr - ring->rd;
+    if (used > ring->max_used)
+        ring->max_used = used;
+    /* Drain is woken up periodically, only kick it when ring is getting full */
+    if (used >= BT_HCI_RING_SIZE / 2 && !ring->kicked)
+    {
+        ring->kicked = 1;
+        rt_sem_release(&g_hci_sem);
+    }
+
+#ifdef DWT
+    cycles = HAL_DBG_DWT_GetCycles() - cycles;
+    ring->cycles_sum += cycles;
+    if (cycles > ring->cycles_max)
+        ring->cycles_max = cycles;
+#endif
+
+    return 0;
+}
+
+static uint64_t bt_hci_ts_us(uint32_t ticks)
+{
+    /* Records are converted in order, delta to reference is small even for snapshot */
+    int32_t delta = (int32_t)(ticks - g_hci_ref_ticks);
+    uint64_t us = g_hci_ref_us + (int64_t)delta * 1000000 / (int32_t)g_hci_freq;
+
+    if (delta > 0x40000000)
+    {
+        g_hci_ref_ticks = ticks;
+        g_hci_ref_us = us;
+    }
+
+    return us;
+}
+
+static uint32_t bt_hci_snoop_rec(bt_hci_ring_rec_t *rec, uint8_t *out)
+{
+    const uint8_t *data = (const uint8_t *)(rec + 1);
+    uint64_t ts = bt_hci_ts_us(rec->ticks);
+    uint32_t flags;
+
+    /* bit 0 received, bit 1 command/event. Direction of ACL/SCO is not known here */
+    if (data[0] == BT_HCI_H4_CMD)
+        flags = 2;
+    else if (data[0] == BT_HCI_H4_EVT)
+        flags = 3;
+    else
+        flags = 0;
+
+    bt_hci_put_be32(out, rec->orig_len);
+    bt_hci_put_be32(out + 4, rec->incl_len);
+    bt_hci_put_be32(out + 8, flags);
+    bt_hci_put_be32(out + 12, rec->drops);
+    bt_hci_put_be32(out + 16, (uint32_t)(ts >> 32));
+    bt_hci_put_be32(out + 20, (uint32_t)ts);
+    memcpy(out + BT_HCI_SNOOP_REC_LEN, data, rec->incl_len);
+
+    return BT_HCI_SNOOP_REC_LEN + rec->incl_len;
+}
+
+static void bt_hci_drain(bt_hci_ring_t *ring)
+{
+    bt_hci_ring_rec_t *rec;
+    uint32_t rd = ring->rd;
+    uint32_t wr = ring->wr;
+    uint32_t size;
+
+    __DMB();
+    while (rd != wr)
+    {
+        rec = bt_hci_ring_rec(ring, rd, &size);
+        if (rec)
+            bt_hci_store(g_hci_stage, bt_hci_snoop_rec(rec, g_hci_stage));
+        rd += size;
+        /* Release space record by record, BT thread may be waiting for it */
+        __DMB();
+        ring->rd = rd;
+    }
+}
+
+/* Write all intact records to separate btsnoop file, ring is frozen */
+static void bt_hci_snapshot_write(bt_hci_ring_t *ring)
+{
+#ifdef RT_USING_DFS
+    char logName[BT_HCI_MAX_PATH_LEN] = {0};
+    bt_hci_ring_rec_t *rec;
+    uint32_t pos, size;
+    int fd;
+
+    snprintf(logName, BT_HCI_MAX_PATH_LEN, "%s%s", g_filePath, BT_HCI_SNAP_NAME);
+    fd = open(logName, O_WRONLY | O_BINARY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0)
+    {
+        LOG_E("HCI snapshot open failed %d", fd);
+        return;
+    }
+
+    bt_hci_snoop_hdr(g_hci_stage);
+    write(fd, g_hci_stage, BT_HCI_SNOOP_HDR_LEN);
+    for (pos = ring->old; pos != ring->wr; pos += size)
+    {
+        rec = bt_hci_ring_rec(ring, pos, &size);
+        if (rec)
+            write(fd, g_hci_stage, bt_hci_snoop_rec(rec, g_hci_stage));
+    }
+    close(fd);
+    LOG_I("HCI snapshot %d bytes to %s", ring->wr - ring->old, logName);
+#endif
+}
+
+static void bt_hci_drain_entry(void *param)
+{
+    bt_hci_ring_t *ring = &g_bt_hci_ring;
+
+    while (1)
+    {
+        rt_sem_take(&g_hci_sem, rt_tick_from_millisecond(BT_HCI_DRAIN_PERIOD_MS));
+        ring->kicked = 0;
+
+        bt_hci_drain(ring);
+
+        if (ring->snap_req)
+        {
+            bt_hci_snapshot_write(ring);
+            bt_hci_store_flush();
+            ring->snap_req = 0;
+            ring->frozen = 0;
+        }
+
+        if (ring->flush_req)
+        {
+            ring->flush_req = 0;
+            bt_hci_store_flush();
+        }
+    }
+}
+
+#ifdef RT_DEBUG
+static void bt_hci_assert_hook(const char *ex, const char *func, rt_size_t line)
+{
+    /* No file access here, stop capture so that ring is kept for RAM dump */
+    g_bt_hci_ring.frozen = 1;
+    if (g_hci_prev_assert_hook)
+        g_hci_prev_assert_hook(ex, func, line);
+}
+#endif
+
+static uint32_t bt_hci_ring_init(void)
+{
+    time_t now;
+
+    if (g_hci_tid)
+        return 0;
+
+    g_hci_freq = (uint32_t)HAL_LPTIM_GetFreq();
+    g_hci_ref_ticks = HAL_GTIMER_READ();
+    now = time(RT_NULL);
+    g_hci_ref_us = (uint64_t)now * 1000000 + BT_HCI_SNOOP_EPOCH;
+
+#ifdef DWT
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+#endif
+
+    rt_sem_init(&g_hci_sem, "bt_hci", 0, RT_IPC_FLAG_FIFO);
+    g_hci_tid = rt_thread_create("bt_hci", bt_hci_drain_entry, NULL, BT_HCI_DRAIN_STACK_SIZE,
+                                 BT_HCI_DRAIN_PRIORITY, RT_THREAD_TICK_DEFAULT);
+    if (!g_hci_tid)
+    {
+        rt_sem_detach(&g_hci_sem);
+        return 1;
+    }
+
+#ifdef RT_DEBUG
+    g_hci_prev_assert_hook = rt_assert_hook;
+    rt_assert_set_hook(bt_hci_assert_hook);
+#endif
+    rt_thread_startup(g_hci_tid);
+
+    return 0;
+}
+
+void bt_hci_trace_snapshot(void)
+{
+    bt_hci_ring_t *ring = &g_bt_hci_ring;
+
+    if (g_hci_tid && !ring->snap_req)
+    {
+        /* Keep records before error, snapshot is written by drain thread */
+        ring->frozen = 1;
+        ring->snap_req = 1;
+        rt_sem_release(&g_hci_sem);
+    }
+}
+
+uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
+{
+    uint32_t ret = bt_hci_store_init(flush_size, is_start);
+
+    if (ret == 0 && bt_hci_ring_init() != 0)
+    {
+        LOG_E("HCI ring init failed");
+        ret = 4;
+    }
+
+    return ret;
+}
+
+uint32_t bt_hci_flush(void)
+{
+    if (!g_hci_tid)
+        return bt_hci_store_flush();
+
+    g_bt_hci_ring.flush_req = 1;
+    rt_sem_release(&g_hci_sem);
+    return 0;
+}
+
+static void bt_hci_stat(void)
+{
+    bt_hci_ring_t *ring = &g_bt_hci_ring;
+
+    rt_kprintf("ring %d bytes, used %d, max used %d, retained %d\n", BT_HCI_RING_SIZE,
+               ring->wr - ring->rd, ring->max_used, ring->wr - ring->old);
+    rt_kprintf("captured %d, dropped %d, frozen %d\n", ring->captured, ring->drops, ring->frozen);
+#ifdef DWT
+    uint32_t mhz = HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000;
+    rt_kprintf("capture cycles avg %d max %d (%d us)\n", ring->captured ? ring->cycles_sum / ring->captured : 0,
+               ring->cycles_max, ring->cycles_max / mhz);
+#endif
+}
+
+#else
+
+uint32_t bt_hci_init(uint32_t flush_size, uint32_t is_start)
+{
+    return bt_hci_store_init(flush_size, is_start);
+}
+
+uint32_t bt_hci_write(uint8_t *buffer, uint32_t len)
+{
+    return bt_hci_store(buffer, len);
+}
+
+uint32_t bt_hci_flush(void)
+{
+    return bt_hci_store_flush();
+}
+
+void bt_hci_trace_snapshot(void)
+{
+    bt_hci_flush();
+}
+
+#endif // BT_HCI_RING_SIZE
 
 static void bt_hci(uint8_t argc, char **argv)
 {
@@ -539,12 +972,20 @@ static void bt_hci(uint8_t argc, char **argv)
         {
             bt_hci_close();
         }
+        else if (strcmp(argv[1], "snap") == 0)
+        {
+            bt_hci_trace_snapshot();
+        }
+#if BT_HCI_RING_SIZE
+        else if (strcmp(argv[1], "stat") == 0)
+        {
+            bt_hci_stat();
+        }
+#endif
     }
 }
 
-
-
-MSH_CMD_EXPORT(bt_hci, BT HCI command);
+MSH_CMD_EXPORT(bt_hci, BT HCI command: flush | open | close | snap | stat);
 
 #else
 
@@ -563,6 +1004,10 @@ uint32_t bt_hci_flush(void)
     return 0xFF;
 }
 
+void bt_hci_trace_snapshot(void)
+{
+}
+
 #endif // RT_USING_DFS
 
 
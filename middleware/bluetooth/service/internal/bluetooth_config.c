@@ -1270,6 +1270,31 @@ uint16_t data_complete_check(uint8_t *cmd, uint16_t len)
     return (size + len);
 }
 
+static void hci_forward_write_mb(hci_forward_env_t *env, uint8_t *ptr, rt_uint32_t size)
+{
+    int written, offset = 0;
+
+    //rt_hexdump("hci_tob", 32, ptr, size);
+    // Write to mailbox
+    HAL_DBG_print_data((char *)ptr, 0, size);
+
+    if ((loc_cmd_hdl(ptr, size) == 1) || (loc_cmd2_hdl(ptr, size) == 1))
+        return;
+
+    if (IPC_QUEUE_INVALID_HANDLE != env->ipc_port)
+    {
+        LOG_D("Write to MB %d\n", size);
+        written = ipc_queue_write(env->ipc_port, ptr, size, 10);
+        while (written < size)
+        {
+            size -= written;
+            offset += written;
+            written = ipc_queue_write(env->ipc_port, ptr + offset, size, 10);
+        }
+        LOG_D("Written to MB %d\n", written);
+    }
+}
+
 void hci_forward_to_mb_entry(void *param)
 {
     hci_forward_env_t *env = hci_forward_get_env();
@@ -1277,7 +1302,6 @@ void hci_forward_to_mb_entry(void *param)
     env->evt = rt_event_create("cmd_evt", RT_IPC_FLAG_FIFO);
     rt_uint32_t size;
     uint8_t *ptr;
-    int written, offset = 0;
     rt_size_t read_len;
     while (1)
     {
@@ -1285,6 +1309,19 @@ void hci_forward_to_mb_entry(void *param)
         LOG_D("(TB)read size %d, mb ptr %x\r\n", size, env->ipc_port);
         if (!size)
             continue;
+#ifdef HCI_FORWARD_ZERO_COPY
+        if (env->uart_port && (env->uart_port->open_flag & RT_DEVICE_FLAG_DMA_RX))
+        {
+            /* Same wait as data_complete_check(), then forward from uart DMA ring in place */
+            HAL_Delay(20);
+            while ((read_len = rt_serial_rx_peek(env->uart_port, &ptr, RT_NULL)) > 0)
+            {
+                hci_forward_write_mb(env, ptr, read_len);
+                rt_serial_rx_consume(env->uart_port, read_len);
+            }
+            continue;
+        }
+#endif /* HCI_FORWARD_ZERO_COPY */
         ptr = bt_mem_alloc(size + UART_EXTRA_DATA_LEN);
         RT_ASSERT(ptr);
 
@@ -1310,30 +1347,7 @@ void hci_forward_to_mb_entry(void *param)
         {
             RT_ASSERT(0);
         }
-        //rt_hexdump("hci_tob", 32, ptr, size);
-        // Write to mailbox
-        HAL_DBG_print_data((char *)ptr, 0, size);
-
-        if ((loc_cmd_hdl(ptr, size) == 1) || (loc_cmd2_hdl(ptr, size) == 1))
-        {
-            bt_mem_free(ptr);
-            continue;
-        }
-
-        if (IPC_QUEUE_INVALID_HANDLE != env->ipc_port)
-        {
-            LOG_D("Write to MB %d\n", size);
-            written = ipc_queue_write(env->ipc_port, ptr, size, 10);
-            while (written < size)
-            {
-                size -= written;
-                offset += written;
-                written = ipc_queue_write(env->ipc_port, ptr + offset, size, 10);
-            }
-            LOG_D("Written to MB %d\n", written);
-        }
-
-        offset = 0;
+        hci_forward_write_mb(env, ptr, size);
         bt_mem_free(ptr);
     }
 
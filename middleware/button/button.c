@@ -60,8 +60,6 @@
     #include "data_service_provider.h"
 #endif /* BUTTON_SERVICE_ENABLED */
 
-/** default detection delay in millisecond */
-#define BUTTON_DETECTION_DELAY   (1)
 #define GROUP_PIN_NUM    (64)
 #define MAX_GROUP_NUM    (4)
 #define MAX_PIN          (MAX_GROUP_NUM * GROUP_PIN_NUM - 1)
@@ -72,14 +70,41 @@
     #define BUTTON_SERVICE_MAX_CLIENT_NUM (1)
 #endif /* BUTTON_SERVICE_MAX_CLIENT_NUM */
 
+/** max time between release and next press of a multi-click, in millisecond */
+#ifndef BUTTON_MULTI_CLICK_INTERVAL
+    #define BUTTON_MULTI_CLICK_INTERVAL (300)
+#endif
+
+#ifndef BUTTON_CHORD_MAX_NUM
+    #define BUTTON_CHORD_MAX_NUM (4)
+#endif
+
+/** enable AON wakeup of button pin if the pin supports it */
+#ifndef BUTTON_PM_PIN_WAKEUP
+    #define BUTTON_PM_PIN_WAKEUP (1)
+#endif
+
+#define BUTTON_TS_EXPIRED(ts, now)  ((rt_int32_t)((now) - (ts)) >= 0)
+
+/*
+ * All buttons share one state machine and one timer. Pin IRQ only records a debounce deadline,
+ * the timer is armed for the nearest pending deadline (debounce, long press, multi-click window)
+ * of all buttons and chords, and is stopped when nothing is pending, so idle buttons cause no wakeup.
+ */
 typedef struct
 {
     bool valid;           /**< if cfg is valid  */
     bool enabled;         /**< if button is enabled */
-    int last_state;
-    uint16_t debounce_cnt;  /**< >0: debouncing is ongoing, ==0: no debouncing is ongoing*/
-    struct rt_timer timer;  /**< debouncing timer */
-    struct rt_timer timer2; /**< timer for advanced action evaluation */
+    bool debouncing;      /**< pin changed, state is read at debounce_ts */
+    bool pressed;         /**< debounced state */
+    bool long_pending;    /**< long press is reported at long_ts */
+    bool chorded;         /**< in an active chord, click and long press are not reported */
+    uint8_t max_click;    /**< >1: report click after multi-click window, see button_set_multi_click() */
+    uint8_t click_cnt;    /**< clicks in current multi-click window */
+    uint8_t last_click_cnt;
+    rt_tick_t debounce_ts;
+    rt_tick_t long_ts;
+    rt_tick_t click_ts;
     button_action_t last_action;
     button_cfg_t cfg;     /**< button configuration  */
 #ifdef BUTTON_SERVICE_ENABLED
@@ -87,12 +112,23 @@ typedef struct
 #endif /* BUTTON_SERVICE_ENABLED */
 } button_item_t;
 
+typedef struct
+{
+    uint32_t mask;        /**< button ids, 0 means free */
+    bool active;          /**< all buttons in mask are pressed */
+    bool long_pending;
+    rt_tick_t long_ts;
+    button_chord_handler_t handler;
+} button_chord_t;
+
 
 typedef struct
 {
     bool init;              /**< if button library is initialized */
     struct rt_semaphore sema;
+    struct rt_timer timer;  /**< shared by all buttons, armed for nearest deadline */
     button_item_t   buttons[BUTTON_MAX_NUM];
+    button_chord_t  chords[BUTTON_CHORD_MAX_NUM];
 } button_ctx_t;
 
 
@@ -365,106 +401,250 @@ static void send_button_action(button_item_t *button, button_action_t action)
 }
 #endif /* BUTTON_SERVICE_ENABLED */
 
-static void detection_timeout_handler(void *parameter)
+static void button_report(button_item_t *button, button_action_t action)
+{
+    SF_ASSERT(button->cfg.button_handler);
+    button->cfg.button_handler(button->cfg.pin, action);
+#ifdef BUTTON_SERVICE_ENABLED
+    send_button_action(button, action);
+#endif /* BUTTON_SERVICE_ENABLED */
+}
+
+/* Arm shared timer for nearest pending deadline, stop it if nothing is pending */
+static void button_schedule(void)
 {
+    button_ctx_t *ctx = &s_button_ctx;
     button_item_t *button;
-    button_action_t action;
+    rt_tick_t now, next = 0;
+    rt_int32_t delta;
+    bool pending = false;
     rt_base_t mask;
-    uint32_t button_id;
-    int curr_state;
-    rt_err_t err;
+    uint32_t i;
 
-    button_id = (uint32_t)parameter;
-    RT_ASSERT(button_id < BUTTON_MAX_NUM);
-    button = &s_button_ctx.buttons[button_id];
-    if (!button->enabled || !button->valid)
+    mask = rt_hw_interrupt_disable();
+    now = rt_tick_get();
+    for (i = 0; i < BUTTON_MAX_NUM; i++)
     {
-        return;
+        button = &ctx->buttons[i];
+        if (!button->valid || !button->enabled)
+            continue;
+        if (button->debouncing && (!pending || (rt_int32_t)(button->debounce_ts - next) < 0))
+        {
+            next = button->debounce_ts;
+            pending = true;
+        }
+        if (button->long_pending && (!pending || (rt_int32_t)(button->long_ts - next) < 0))
+        {
+            next = button->long_ts;
+            pending = true;
+        }
+        if (button->click_cnt && !button->pressed && (!pending || (rt_int32_t)(button->click_ts - next) < 0))
+        {
+            next = button->click_ts;
+            pending = true;
+        }
     }
-
-    curr_state = rt_pin_read(button->cfg.pin);
-    mask = rt_hw_interrupt_disable();
-    if (button->last_state == curr_state)
+    for (i = 0; i < BUTTON_CHORD_MAX_NUM; i++)
     {
-        if (button->debounce_cnt > 0)
+        if (ctx->chords[i].long_pending && (!pending || (rt_int32_t)(ctx->chords[i].long_ts - next) < 0))
         {
-            button->debounce_cnt--;
+            next = ctx->chords[i].long_ts;
+            pending = true;
         }
     }
-    else
+
+    rt_timer_stop(&ctx->timer);
+    if (pending)
     {
-        button->debounce_cnt = button->cfg.debounce_time;
-        button->last_state = curr_state;
+        delta = (rt_int32_t)(next - now);
+        if (delta < 1)
+            delta = 1;
+        rt_timer_control(&ctx->timer, RT_TIMER_CTRL_SET_TIME, &delta);
+        rt_timer_start(&ctx->timer);
     }
     rt_hw_interrupt_enable(mask);
+}
 
-    if (button->debounce_cnt > 0)
+static void button_chord_update(rt_tick_t now)
+{
+    button_ctx_t *ctx = &s_button_ctx;
+    button_chord_t *chord;
+    uint32_t pressed_mask = 0;
+    uint32_t i, j;
+
+    for (i = 0; i < BUTTON_MAX_NUM; i++)
     {
-        err = rt_timer_start(&button->timer);
-        SF_ASSERT(RT_EOK == err);
+        if (ctx->buttons[i].enabled && ctx->buttons[i].pressed)
+            pressed_mask |= 1UL << i;
     }
-    else
+
+    for (i = 0; i < BUTTON_CHORD_MAX_NUM; i++)
     {
-        rt_timer_stop(&button->timer2);
-        if (is_pressed(curr_state, button->cfg.active_state))
+        chord = &ctx->chords[i];
+        if (0 == chord->mask)
+            continue;
+
+        if (!chord->active && ((pressed_mask & chord->mask) == chord->mask))
         {
-            action = BUTTON_PRESSED;
-            err = rt_timer_start(&button->timer2);
-            SF_ASSERT(RT_EOK == err);
+            chord->active = true;
+            chord->long_pending = true;
+            chord->long_ts = now + rt_tick_from_millisecond(BUTTON_ADV_ACTION_CHECK_DELAY);
+            for (j = 0; j < BUTTON_MAX_NUM; j++)
+            {
+                if (chord->mask & (1UL << j))
+                {
+                    ctx->buttons[j].chorded = true;
+                    ctx->buttons[j].long_pending = false;
+                    ctx->buttons[j].click_cnt = 0;
+                }
+            }
+            chord->handler(i, BUTTON_PRESSED);
         }
-        else
+        else if (chord->active && ((pressed_mask & chord->mask) != chord->mask))
         {
-            action = BUTTON_RELEASED;
+            chord->active = false;
+            chord->long_pending = false;
+            chord->handler(i, BUTTON_RELEASED);
         }
-        SF_ASSERT(button->cfg.button_handler);
-        if ((BUTTON_PRESSED == button->last_action) && (BUTTON_RELEASED == action))
-        {
-            button->cfg.button_handler(button->cfg.pin, BUTTON_CLICKED);
-#ifdef BUTTON_SERVICE_ENABLED
-            send_button_action(button, BUTTON_CLICKED);
-#endif /* BUTTON_SERVICE_ENABLED */
+    }
+}
 
-        }
-        button->last_action = action;
-        button->cfg.button_handler(button->cfg.pin, action);
-#ifdef BUTTON_SERVICE_ENABLED
-        send_button_action(button, action);
-#endif /* BUTTON_SERVICE_ENABLED */
+static void button_click(button_item_t *button, rt_tick_t now)
+{
+    if (button->chorded)
+    {
+        return;
+    }
+
+    if (button->max_click <= 1)
+    {
+        button_report(button, BUTTON_CLICKED);
+        return;
+    }
+
+    button->click_cnt++;
+    button->click_ts = now + rt_tick_from_millisecond(BUTTON_MULTI_CLICK_INTERVAL);
+    if (button->click_cnt >= button->max_click)
+    {
+        button->last_click_cnt = button->click_cnt;
+        button->click_cnt = 0;
+        button_report(button, BUTTON_MULTI_CLICKED);
     }
 }
 
+/* Debounce is done, take pin state and report */
+static void button_update_state(button_item_t *button, rt_tick_t now)
+{
+    button_action_t action;
+    bool pressed;
+
+    pressed = is_pressed(rt_pin_read(button->cfg.pin), button->cfg.active_state);
+    button->long_pending = pressed && !button->chorded;
+    if (pressed)
+    {
+        action = BUTTON_PRESSED;
+        button->long_ts = now + rt_tick_from_millisecond(BUTTON_ADV_ACTION_CHECK_DELAY);
+    }
+    else
+    {
+        action = BUTTON_RELEASED;
+    }
+    button->pressed = pressed;
 
+    if ((BUTTON_PRESSED == button->last_action) && (BUTTON_RELEASED == action))
+    {
+        button_click(button, now);
+    }
+    if (!pressed)
+    {
+        button->chorded = false;
+    }
+    button->last_action = action;
+    button_report(button, action);
+}
 
-static void timer2_timeout_handler(void *parameter)
+static void button_timeout_handler(void *parameter)
 {
-    uint32_t button_id;
+    button_ctx_t *ctx = &s_button_ctx;
     button_item_t *button;
+    rt_tick_t now;
+    rt_base_t mask;
+    bool changed = false;
+    bool debounced;
+    uint32_t i;
 
-    button_id = (uint32_t)parameter;
-    RT_ASSERT(button_id < BUTTON_MAX_NUM);
-    button = &s_button_ctx.buttons[button_id];
-    if (!button->enabled || !button->valid)
+    now = rt_tick_get();
+    for (i = 0; i < BUTTON_MAX_NUM; i++)
     {
-        return;
+        button = &ctx->buttons[i];
+        if (!button->enabled || !button->valid)
+        {
+            continue;
+        }
+
+        mask = rt_hw_interrupt_disable();
+        debounced = button->debouncing && BUTTON_TS_EXPIRED(button->debounce_ts, now);
+        if (debounced)
+        {
+            button->debouncing = false;
+        }
+        rt_hw_interrupt_enable(mask);
+
+        if (debounced)
+        {
+            button_update_state(button, now);
+            changed = true;
+        }
+
+        if (button->long_pending && BUTTON_TS_EXPIRED(button->long_ts, now))
+        {
+            button->long_pending = false;
+            if (BUTTON_PRESSED == button->last_action)
+            {
+                button->last_action = BUTTON_LONG_PRESSED;
+                button->click_cnt = 0;
+                button_report(button, BUTTON_LONG_PRESSED);
+            }
+        }
+
+        if (button->click_cnt && !button->pressed && BUTTON_TS_EXPIRED(button->click_ts, now))
+        {
+            button->last_click_cnt = button->click_cnt;
+            button->click_cnt = 0;
+            button_report(button, (button->last_click_cnt > 1) ? BUTTON_MULTI_CLICKED : BUTTON_CLICKED);
+        }
     }
 
-    if (BUTTON_PRESSED == button->last_action)
+    if (changed)
     {
-        button->last_action = BUTTON_LONG_PRESSED;
-        SF_ASSERT(button->cfg.button_handler);
-        button->cfg.button_handler(button->cfg.pin, button->last_action);
-#ifdef BUTTON_SERVICE_ENABLED
-        send_button_action(button, button->last_action);
-#endif /* BUTTON_SERVICE_ENABLED */
+        button_chord_update(now);
     }
+    for (i = 0; i < BUTTON_CHORD_MAX_NUM; i++)
+    {
+        if (ctx->chords[i].long_pending && BUTTON_TS_EXPIRED(ctx->chords[i].long_ts, now))
+        {
+            ctx->chords[i].long_pending = false;
+            ctx->chords[i].handler(i, BUTTON_LONG_PRESSED);
+        }
+    }
+
+    button_schedule();
+}
+
+/* (Re)start debounce of a button, state is read once when pin keeps stable for debounce time */
+static void button_start_debounce(button_item_t *button)
+{
+    rt_base_t mask;
+
+    mask = rt_hw_interrupt_disable();
+    button->debouncing = true;
+    button->debounce_ts = rt_tick_get() + rt_tick_from_millisecond(button->cfg.debounce_time);
+    rt_hw_interrupt_enable(mask);
 }
 
 static void pin_event_handler(void *args)
 {
     int32_t pin = (int32_t)args;
-    rt_err_t err;
-    rt_base_t mask;
-    button_item_t *button;
     uint32_t i;
 
     for (i = 0; i < BUTTON_MAX_NUM; i++)
@@ -480,19 +660,41 @@ static void pin_event_handler(void *args)
     }
     if (i < BUTTON_MAX_NUM)
     {
-        button = &s_button_ctx.buttons[i];
-        if (0 == button->debounce_cnt)
-        {
-            mask = rt_hw_interrupt_disable();
-            button->debounce_cnt = button->cfg.debounce_time;
-            rt_hw_interrupt_enable(mask);
+        button_start_debounce(&s_button_ctx.buttons[i]);
+        button_schedule();
+    }
+}
 
-            button->last_state = rt_pin_read(pin);
-            err = rt_timer_start(&button->timer);
-            SF_ASSERT(RT_EOK == err);
-        }
+#if defined(BSP_USING_PM) && BUTTON_PM_PIN_WAKEUP
+static void button_pin_wakeup(button_item_t *button, bool enable)
+{
+    GPIO_TypeDef *gpio = GET_GPIO_INSTANCE(button->cfg.pin);
+    uint16_t gpio_pin = GET_GPIOx_PIN(button->cfg.pin);
+    int8_t wakeup_pin;
+
+#ifdef SOC_BF0_HCPU
+    wakeup_pin = HAL_HPAON_QueryWakeupPin(gpio, gpio_pin);
+#else
+    wakeup_pin = HAL_LPAON_QueryWakeupPin(gpio, gpio_pin);
+#endif
+    if (wakeup_pin < 0)
+    {
+        /* not a wakeup pin, button only works when system is awake */
+        return;
+    }
+
+    if (enable)
+    {
+        pm_enable_pin_wakeup(wakeup_pin, AON_PIN_MODE_DOUBLE_EDGE);
+    }
+    else
+    {
+        pm_disable_pin_wakeup(wakeup_pin);
     }
 }
+#else
+#define button_pin_wakeup(button, enable)
+#endif /* BSP_USING_PM && BUTTON_PM_PIN_WAKEUP */
 
 
 #ifdef BSP_USING_PM
@@ -526,9 +728,12 @@ void button_pm_resume(const struct rt_device *device, uint8_t mode)
             if (ctx->buttons[i].enabled)
             {
                 button_enable(i);
+                /* edge which woke up system is lost in standby, check state once */
+                button_start_debounce(&ctx->buttons[i]);
             }
         }
     }
+    button_schedule();
 
     return ;
 }
@@ -621,6 +826,8 @@ int32_t button_init(button_cfg_t *cfg)
     {
         ctx->init = true;
         rt_sem_init(&ctx->sema, "btn", 1, RT_IPC_FLAG_FIFO);
+        rt_timer_init(&ctx->timer, "btn", button_timeout_handler, NULL,
+                      1, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
 #ifdef BSP_USING_PM
         rt_pm_device_register(NULL, &button_pm_op);
 #endif /* BSP_USING_PM */
@@ -676,14 +883,16 @@ int32_t button_init(button_cfg_t *cfg)
     button->valid = true;
     button->last_action = BUTTON_RELEASED;
     button->enabled = false;
-    button->debounce_cnt = 0;
+    button->debouncing = false;
+    button->pressed = false;
+    button->long_pending = false;
+    button->chorded = false;
+    button->max_click = 0;
+    button->click_cnt = 0;
+    button->last_click_cnt = 0;
     memcpy(&button->cfg, cfg, sizeof(button->cfg));
     /* TODO: use fixed value for now */
     button->cfg.debounce_time = 20;
-    rt_timer_init(&button->timer, "btn", detection_timeout_handler, (void *)button_id,
-                  rt_tick_from_millisecond(BUTTON_DETECTION_DELAY), RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
-    rt_timer_init(&button->timer2, "btn_tm2", timer2_timeout_handler, (void *)button_id,
-                  rt_tick_from_millisecond(BUTTON_ADV_ACTION_CHECK_DELAY), RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
 
 #ifdef BUTTON_SERVICE_ENABLED
     rt_snprintf(btn_service_name, sizeof(btn_service_name), "btn%d", button_id);
@@ -717,10 +926,11 @@ sf_err_t button_enable(int32_t id)
         return -SF_ERR;
     }
 
-    button->debounce_cnt = 0;
+    button->debouncing = false;
     if (RT_EOK == rt_pin_irq_enable(button->cfg.pin, true))
     {
         button->enabled = true;
+        button_pin_wakeup(button, true);
         err = SF_EOK;
     }
     else
@@ -751,6 +961,11 @@ sf_err_t button_disable(int32_t id)
     if (RT_EOK == rt_pin_irq_enable(button->cfg.pin, false))
     {
         button->enabled = false;
+        button->debouncing = false;
+        button->long_pending = false;
+        button->click_cnt = 0;
+        button_pin_wakeup(button, false);
+        button_schedule();
         err = SF_EOK;
     }
     else
@@ -803,6 +1018,84 @@ sf_err_t button_update_handler(int32_t id, button_handler_t new_handler)
     return SF_EOK;
 }
 
+sf_err_t button_set_multi_click(int32_t id, uint8_t max_click)
+{
+    button_item_t *button;
+
+    if ((id < 0) || (id >= BUTTON_MAX_NUM))
+    {
+        return -SF_ERR;
+    }
+
+    button = &s_button_ctx.buttons[id];
+    if (!button->valid)
+    {
+        return -SF_ERR;
+    }
+
+    button->max_click = max_click;
+    button->click_cnt = 0;
+
+    return SF_EOK;
+}
+
+uint8_t button_get_click_count(int32_t id)
+{
+    SF_ASSERT((id >= 0) && (id < BUTTON_MAX_NUM));
+
+    return s_button_ctx.buttons[id].last_click_cnt;
+}
+
+int32_t button_chord_init(uint32_t button_mask, button_chord_handler_t handler)
+{
+    button_ctx_t *ctx = &s_button_ctx;
+    int32_t chord_id = -SF_EFULL;
+    rt_err_t err;
+    uint32_t i;
+
+    RT_ASSERT(BUTTON_MAX_NUM <= 32);
+    if ((NULL == handler) || (0 == (button_mask & (button_mask - 1)))
+            || (button_mask >> BUTTON_MAX_NUM) || !ctx->init)
+    {
+        return -SF_EINVAL;
+    }
+
+    err = rt_sem_take(&ctx->sema, RT_WAITING_FOREVER);
+    SF_ASSERT(err == RT_EOK);
+    for (i = 0; i < BUTTON_CHORD_MAX_NUM; i++)
+    {
+        if (0 == ctx->chords[i].mask)
+        {
+            ctx->chords[i].active = false;
+            ctx->chords[i].long_pending = false;
+            ctx->chords[i].handler = handler;
+            ctx->chords[i].mask = button_mask;
+            chord_id = i;
+            break;
+        }
+    }
+    err = rt_sem_release(&ctx->sema);
+    SF_ASSERT(err == RT_EOK);
+
+    return chord_id;
+}
+
+sf_err_t button_chord_deinit(int32_t chord_id)
+{
+    button_ctx_t *ctx = &s_button_ctx;
+
+    if ((chord_id < 0) || (chord_id >= BUTTON_CHORD_MAX_NUM))
+    {
+        return -SF_ERR;
+    }
+
+    ctx->chords[chord_id].mask = 0;
+    ctx->chords[chord_id].long_pending = false;
+    button_schedule();
+
+    return SF_EOK;
+}
+
 #ifdef USING_ADC_BUTTON
 int32_t button_bind_adc_button(int32_t id, int8_t adc_button_group_id, uint8_t handler_num,
                                adc_button_handler_t *handler)
@@ -87,13 +87,13 @@ static void arm_conv_facc(
     {
         config.fp_sel = 1;
         max_size = FACC_MAX_FIFO_SIZE;
-        if (srcBLen > max_size && srcALen > max_size)
+        if ((srcBLen > max_size && srcALen > max_size) || srcALen * srcBLen < SIFLI_DSP_CONV_HW_MIN_MACS)
             return arm_conv_q7((const q7_t *)pSrcA, srcALen, (const q7_t *)pSrcB, srcBLen, (q7_t *)pDst);
     }
     else
     {
         max_size = (FACC_MAX_FIFO_SIZE >> 1);
-        if (srcBLen > max_size && srcALen > max_size)
+        if ((srcBLen > max_size && srcALen > max_size) || srcALen * srcBLen < SIFLI_DSP_CONV_HW_MIN_MACS)
             return arm_conv_q15((const q15_t *)pSrcA, srcALen, (const q15_t *)pSrcB, srcBLen, (q15_t *)pDst);
     }
 
@@ -227,13 +227,15 @@ static void arm_fir_facc(
     if (is_8bit)
     {
         config.fp_sel = 1;
-        if (S->numTaps > FACC_MAX_FIFO_SIZE)
+        if (S->numTaps > FACC_MAX_FIFO_SIZE || S->numTaps < SIFLI_DSP_FIR_HW_MIN_TAPS)
             return arm_fir_q7(S, (const q7_t *)pSrc, (q7_t *)pDst, blockSize);
+        HAL_FACC_SetCoeffFirReverse(&hfacc, (uint8_t *)S->pCoeffs, S->numTaps);
     }
     else
     {
-        if (S->numTaps > (FACC_MAX_FIFO_SIZE >> 1))
+        if (S->numTaps > (FACC_MAX_FIFO_SIZE >> 1) || S->numTaps < SIFLI_DSP_FIR_HW_MIN_TAPS)
             return arm_fir_q15((const arm_fir_instance_q15 *)S, (const q15_t *)pSrc, (q15_t *)pDst, blockSize);
+        HAL_FACC_SetCoeffFirReverse(&hfacc, (uint8_t *)S->pCoeffs, (S->numTaps << 1));
         blockSize <<= 1;
     }
     HAL_FACC_Config(&hfacc, &config);
@@ -247,7 +249,6 @@ void arm_fir_q7_facc(
     q7_t *pDst,
     uint32_t blockSize)
 {
-    HAL_FACC_SetCoeffFirReverse(&hfacc, (uint8_t *)S->pCoeffs, S->numTaps);
     return arm_fir_facc(S, (uint8_t *)pSrc, (uint8_t *)pDst, blockSize, 1);
 }
 
@@ -257,7 +258,6 @@ void arm_fir_q15_facc(
     q15_t *pDst,
     uint32_t blockSize)
 {
-    HAL_FACC_SetCoeffFirReverse(&hfacc, (uint8_t *)S->pCoeffs, (S->numTaps << 1));
     return arm_fir_facc((const arm_fir_instance_q7 *)S, (uint8_t *)pSrc, (uint8_t *)pDst, blockSize, 0);
 }
 
@@ -379,4 +379,360 @@ void arm_iir_init_q15_facc(
 }
 #endif
 
+#if defined(HAL_FFT_MODULE_ENABLED) && defined(BF0_LCPU) && defined(hwp_fft2)
+    #define DSP_FFT_USING_HW
+    #define DSP_FFT_INSTANCE        hwp_fft2
+    #define DSP_FFT_RCC_MOD         RCC_MOD_FFT2
+    #define DSP_FFT_LEN_MAX         FFT2_LEN_MAX
+#elif defined(HAL_FFT_MODULE_ENABLED) && !defined(BF0_LCPU)
+    #define DSP_FFT_USING_HW
+    #define DSP_FFT_INSTANCE        hwp_fft1
+    #define DSP_FFT_RCC_MOD         RCC_MOD_FFT1
+    #define DSP_FFT_LEN_MAX         FFT1_LEN_MAX
+#endif
+
+enum
+{
+    FFT_MODE_CFFT_Q15,
+    FFT_MODE_CFFT_Q31,
+    FFT_MODE_RFFT_Q15,
+    FFT_MODE_NUM
+};
+
+#ifdef DSP_FFT_USING_HW
+#define FFT_SHIFT_UNKNOWN           (127)
+#define FFT_SHIFT_NO_HW             (126)
+
+static FFT_HandleTypeDef hfft;
+static struct rt_mutex fft_lock;
+/* Right shift from hardware output to CMSIS-DSP output format, per mode, direction and length */
+static int8_t fft_shift[FFT_MODE_NUM][2][FFT_LEN_TYPE_NUM];
+/* Unaligned buffers and scale measurement, 2 * SIFLI_DSP_FFT_HW_MAX_LEN q31 */
+static uint8_t *fft_scratch;
+
+void arm_dsp_fft_init(void)
+{
+    if (HAL_FFT_STATE_RESET != hfft.State)
+        return;
+
+    fft_scratch = rt_malloc_align(SIFLI_DSP_FFT_HW_MAX_LEN * 2 * sizeof(q31_t), 4);
+    if (!fft_scratch)
+        return;
+    rt_mutex_init(&fft_lock, "dsp_fft", RT_IPC_FLAG_PRIO);
+    memset(fft_shift, FFT_SHIFT_UNKNOWN, sizeof(fft_shift));
+    hfft.Instance = DSP_FFT_INSTANCE;
+    HAL_RCC_EnableModule(DSP_FFT_RCC_MOD);
+    HAL_FFT_Init(&hfft);
+}
+
+static int fft_hw_len_type(uint32_t len)
+{
+    int t;
+
+    if (HAL_FFT_STATE_RESET == hfft.State || len < SIFLI_DSP_FFT_HW_MIN_LEN || len > SIFLI_DSP_FFT_HW_MAX_LEN)
+        return -1;
+
+    for (t = 0; t <= DSP_FFT_LEN_MAX; t++)
+    {
+        if ((16UL << t) == len)
+            return t;
+    }
+    return -1;
+}
+
+static HAL_StatusTypeDef fft_hw_start(void *in, void *out, uint8_t mode, int t, uint8_t ifft)
+{
+    FFT_ConfigTypeDef config;
+
+    memset(&config, 0, sizeof(FFT_ConfigTypeDef));
+    config.bitwidth = (FFT_MODE_CFFT_Q31 == mode) ? FFT_BW_32BIT : FFT_BW_16BIT;
+    config.fft_length = t;
+    config.rfft_flag = (FFT_MODE_RFFT_Q15 == mode);
+    config.ifft_flag = ifft;
+    config.input_data = in;
+    config.output_data = out;
+
+    return HAL_FFT_StartFFT(&hfft, &config);
+}
+
+/* Transform an impulse whose spectrum is flat, return magnitude of first output */
+static int32_t fft_impulse(const void *S, uint8_t mode, uint8_t ifft, int t, int hw)
+{
+    uint32_t n = 16UL << t;
+    q15_t *out15 = (q15_t *)fft_scratch;
+    int32_t v;
+
+    memset(fft_scratch, 0, n * 2 * sizeof(q31_t));
+    switch (mode)
+    {
+    case FFT_MODE_CFFT_Q15:
+        out15[0] = 0x4000;
+        if (hw && HAL_OK != fft_hw_start(fft_scratch, fft_scratch, mode, t, ifft))
+            return -1;
+        if (!hw)
+            arm_cfft_q15((const arm_cfft_instance_q15 *)S, out15, ifft, 1);
+        v = out15[0];
+        break;
+    case FFT_MODE_CFFT_Q31:
+        ((q31_t *)fft_scratch)[0] = 0x40000000;
+        if (hw && HAL_OK != fft_hw_start(fft_scratch, fft_scratch, mode, t, ifft))
+            return -1;
+        if (!hw)
+            arm_cfft_q31((const arm_cfft_instance_q31 *)S, (q31_t *)fft_scratch, ifft, 1);
+        v = ((q31_t *)fft_scratch)[0];
+        break;
+    default:
+        out15 = (q15_t *)fft_scratch + n;
+        ((q15_t *)fft_scratch)[0] = 0x4000;
+        if (hw && HAL_OK != fft_hw_start(fft_scratch, out15, mode, t, 0))
+            return -1;
+        if (!hw)
+            arm_rfft_q15((const arm_rfft_instance_q15 *)S, (q15_t *)fft_scratch, out15);
+        v = out15[0];
+        break;
+    }
+
+    return v < 0 ? -v : v;
+}
+
+/* Hardware scale differs from CMSIS-DSP which downscales by stages, measure it once against the
+   CMSIS-DSP instance and keep nearest power of two. Called with fft_lock taken. */
+static int8_t fft_get_shift(const void *S, uint8_t mode, uint8_t ifft, int t)
+{
+    int8_t *shift = &fft_shift[mode][ifft][t];
+    int32_t hw, ref;
+    int8_t sh = 0;
+
+    if (FFT_SHIFT_UNKNOWN != *shift)
+        return *shift;
+
+    hw = fft_impulse(S, mode, ifft, t, 1);
+    ref = fft_impulse(S, mode, ifft, t, 0);
+    if (hw <= 0 || ref <= 0)
+    {
+        rt_kprintf("dsp_fft: mode %d len %d not supported by hardware\n", mode, 16 << t);
+        *shift = FFT_SHIFT_NO_HW;
+        return *shift;
+    }
+    while (hw > ref + (ref >> 1))
+    {
+        hw >>= 1;
+        sh++;
+    }
+    while (ref > hw + (hw >> 1))
+    {
+        ref >>= 1;
+        sh--;
+    }
+    *shift = sh;
+    return sh;
+}
+
+static int fft_hw_run(const void *S, uint32_t len, uint8_t mode, uint8_t ifft, void *in, void *out)
+{
+    int t = fft_hw_len_type(len);
+    uint32_t unit = (FFT_MODE_CFFT_Q31 == mode) ? sizeof(q31_t) : sizeof(q15_t);
+    uint32_t out_size = len * 2 * unit;
+    uint32_t in_size = (FFT_MODE_RFFT_Q15 == mode) ? len * unit : out_size;
+    uint8_t *hw_in = in;
+    uint8_t *hw_out = out;
+    int8_t shift;
+    int r = -1;
+
+    if (t < 0)
+        return -1;
+
+    rt_mutex_take(&fft_lock, RT_WAITING_FOREVER);
+    shift = fft_get_shift(S, mode, ifft, t);
+    if (FFT_SHIFT_NO_HW == shift)
+        goto __EXIT;
+
+    if (((uint32_t)in & 3) || ((uint32_t)out & 3))
+    {
+        hw_in = fft_scratch;
+        hw_out = (in == out) ? hw_in : hw_in + in_size;
+        memcpy(hw_in, in, in_size);
+    }
+    if (HAL_OK != fft_hw_start(hw_in, hw_out, mode, t, ifft))
+        goto __EXIT;
+
+    if (shift && FFT_MODE_CFFT_Q31 == mode)
+        arm_shift_q31((const q31_t *)hw_out, -shift, (q31_t *)out, len * 2);
+    else if (shift)
+        arm_shift_q15((const q15_t *)hw_out, -shift, (q15_t *)out, len * 2);
+    else if (hw_out != out)
+        memcpy(out, hw_out, out_size);
+    r = 0;
+
+__EXIT:
+    rt_mutex_release(&fft_lock);
+    return r;
+}
+#else
+void arm_dsp_fft_init(void)
+{
+}
+
+#define fft_hw_run(S, len, mode, ifft, in, out)     (-1)
+#endif /* DSP_FFT_USING_HW */
+
+void arm_cfft_q15_facc(
+    const arm_cfft_instance_q15 *S,
+    q15_t *p1,
+    uint8_t ifftFlag,
+    uint8_t bitReverseFlag)
+{
+    if (!bitReverseFlag || fft_hw_run(S, S->fftLen, FFT_MODE_CFFT_Q15, ifftFlag ? 1 : 0, p1, p1) != 0)
+        arm_cfft_q15(S, p1, ifftFlag, bitReverseFlag);
+}
+
+void arm_cfft_q31_facc(
+    const arm_cfft_instance_q31 *S,
+    q31_t *p1,
+    uint8_t ifftFlag,
+    uint8_t bitReverseFlag)
+{
+    if (!bitReverseFlag || fft_hw_run(S, S->fftLen, FFT_MODE_CFFT_Q31, ifftFlag ? 1 : 0, p1, p1) != 0)
+        arm_cfft_q31(S, p1, ifftFlag, bitReverseFlag);
+}
+
+void arm_rfft_q15_facc(
+    const arm_rfft_instance_q15 *S,
+    q15_t *pSrc,
+    q15_t *pDst)
+{
+    if (S->ifftFlagR || !S->bitReverseFlagR || fft_hw_run(S, S->fftLenReal, FFT_MODE_RFFT_Q15, 0, pSrc, pDst) != 0)
+        arm_rfft_q15(S, pSrc, pDst);
+}
+
+/* Asynchronous job queue ---------------------------------------------------------------------*/
+#ifndef ARM_DSP_JOB_STACK_SIZE
+    #define ARM_DSP_JOB_STACK_SIZE  2048
+#endif
+#ifndef ARM_DSP_JOB_PRIORITY
+    #define ARM_DSP_JOB_PRIORITY    RT_THREAD_PRIORITY_HIGH
+#endif
+
+static rt_list_t job_list = RT_LIST_OBJECT_INIT(job_list);
+static struct rt_semaphore job_sem;
+static rt_thread_t job_thread;
+
+static void job_process(arm_dsp_job_t *job)
+{
+    switch (job->type)
+    {
+    case ARM_DSP_JOB_FIR_Q7:
+#ifdef HAL_FACC_MODULE_ENABLED
+        arm_fir_q7_facc((const arm_fir_instance_q7 *)job->inst, (const q7_t *)job->src, (q7_t *)job->dst, job->len);
+#else
+        arm_fir_q7((const arm_fir_instance_q7 *)job->inst, (const q7_t *)job->src, (q7_t *)job->dst, job->len);
+#endif
+        break;
+    case ARM_DSP_JOB_FIR_Q15:
+#ifdef HAL_FACC_MODULE_ENABLED
+        arm_fir_q15_facc((const arm_fir_instance_q15 *)job->inst, (const q15_t *)job->src, (q15_t *)job->dst, job->len);
+#else
+        arm_fir_q15((const arm_fir_instance_q15 *)job->inst, (const q15_t *)job->src, (q15_t *)job->dst, job->len);
+#endif
+        break;
+    case ARM_DSP_JOB_CFFT_Q15:
+        arm_cfft_q15_facc((const arm_cfft_instance_q15 *)job->inst, (q15_t *)job->src, job->ifft_flag, job->bit_reverse_flag);
+        break;
+    case ARM_DSP_JOB_CFFT_Q31:
+        arm_cfft_q31_facc((const arm_cfft_instance_q31 *)job->inst, (q31_t *)job->src, job->ifft_flag, job->bit_reverse_flag);
+        break;
+    case ARM_DSP_JOB_RFFT_Q15:
+        arm_rfft_q15_facc((const arm_rfft_instance_q15 *)job->inst, (q15_t *)job->src, (q15_t *)job->dst);
+        break;
+    default:
+        break;
+    }
+}
+
+static void job_entry(void *param)
+{
+    arm_dsp_job_t *job;
+
+    while (1)
+    {
+        rt_sem_take(&job_sem, RT_WAITING_FOREVER);
+        rt_enter_critical();
+        job = rt_list_first_entry(&job_list, arm_dsp_job_t, node);
+        rt_list_remove(&job->node);
+        rt_exit_critical();
+
+        job_process(job);
+        if (job->cb)
+            job->cb(job, job->user_data);
+
+        rt_enter_critical();
+        job->done = 1;
+        if (job->sem)
+            rt_sem_release(job->sem);
+        rt_exit_critical();
+    }
+}
+
+static rt_err_t job_queue(arm_dsp_job_t *job, uint32_t num, struct rt_semaphore *sem)
+{
+    uint32_t i;
+
+    if (!job || 0 == num || !job_thread)
+        return -RT_EINVAL;
+
+    for (i = 0; i < num; i++)
+    {
+        if (job[i].type >= ARM_DSP_JOB_TYPE_NUM)
+            return -RT_EINVAL;
+        job[i].done = 0;
+        job[i].sem = (i == num - 1) ? sem : RT_NULL;
+    }
+
+    rt_enter_critical();
+    for (i = 0; i < num; i++)
+        rt_list_insert_before(&job_list, &job[i].node);
+    rt_exit_critical();
+
+    for (i = 0; i < num; i++)
+        rt_sem_release(&job_sem);
+
+    return RT_EOK;
+}
+
+rt_err_t arm_dsp_job_submit(arm_dsp_job_t *job, uint32_t num)
+{
+    return job_queue(job, num, RT_NULL);
+}
+
+rt_err_t arm_dsp_job_run(arm_dsp_job_t *job, uint32_t num, rt_int32_t timeout)
+{
+    struct rt_semaphore sem;
+    rt_err_t r;
+
+    rt_sem_init(&sem, "dsp_run", 0, RT_IPC_FLAG_FIFO);
+    r = job_queue(job, num, &sem);
+    if (RT_EOK == r && RT_EOK != rt_sem_take(&sem, timeout))
+    {
+        /* semaphore is on stack, detach it from job before return */
+        rt_enter_critical();
+        job[num - 1].sem = RT_NULL;
+        r = job[num - 1].done ? RT_EOK : -RT_ETIMEOUT;
+        rt_exit_critical();
+    }
+    rt_sem_detach(&sem);
+
+    return r;
+}
+
+static int arm_dsp_job_init(void)
+{
+    rt_sem_init(&job_sem, "dsp_job", 0, RT_IPC_FLAG_FIFO);
+    job_thread = rt_thread_create("dsp_job", job_entry, RT_NULL, ARM_DSP_JOB_STACK_SIZE, ARM_DSP_JOB_PRIORITY, 10);
+    if (!job_thread)
+        return -RT_ENOMEM;
+    rt_thread_startup(job_thread);
+    return RT_EOK;
+}
+INIT_COMPONENT_EXPORT(arm_dsp_job_init);
+
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
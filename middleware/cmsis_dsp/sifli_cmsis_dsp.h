@@ -46,10 +46,25 @@
 #ifndef SIFLI_CMSIS_DSP_H
 #define SIFLI_CMSIS_DSP_H
 
+#include "rtthread.h"
 #include "arm_math.h"
 
 #define FACC_MAX_BLOCK_SIZE 256
 
+/* Size thresholds below which CPU is faster than accelerator setup and cache maintenance */
+#ifndef SIFLI_DSP_CONV_HW_MIN_MACS
+    #define SIFLI_DSP_CONV_HW_MIN_MACS  256     /**< srcALen * srcBLen of convolution */
+#endif
+#ifndef SIFLI_DSP_FIR_HW_MIN_TAPS
+    #define SIFLI_DSP_FIR_HW_MIN_TAPS   8       /**< decided by numTaps so that one instance always keeps same state format */
+#endif
+#ifndef SIFLI_DSP_FFT_HW_MIN_LEN
+    #define SIFLI_DSP_FFT_HW_MIN_LEN    64      /**< FFT points */
+#endif
+#ifndef SIFLI_DSP_FFT_HW_MAX_LEN
+    #define SIFLI_DSP_FFT_HW_MAX_LEN    1024    /**< size of scratch for unaligned buffers, also limited by FFT engine */
+#endif
+
 /**
  * @brief Convolution of Q7 sequences.
  * @param[in]  pSrcA    points to the first input sequence.
@@ -248,6 +263,103 @@ void arm_iir_q15_facc(
 */
 void arm_dsp_facc_init(void);
 
+/**
+* @brief  Initialization FFT acceleration, FFT1 on HCPU and FFT2 on LCPU.
+*         FFT engine must not be used by others(e.g. audio 3A with FFT_USING_ONCHIP) at same time.
+*         Before init, FFT functions below run CMSIS-DSP on CPU.
+*/
+void arm_dsp_fft_init(void);
+
+/**
+* @brief Processing function for Q15 complex FFT, same as arm_cfft_q15().
+*        Hardware is used if fftLen is in [SIFLI_DSP_FFT_HW_MIN_LEN, SIFLI_DSP_FFT_HW_MAX_LEN] and bitReverseFlag is set,
+*        output is shifted to CMSIS-DSP format by scale measured once per length and direction.
+* @param[in]     S              points to an instance of Q15 CFFT structure.
+* @param[in,out] p1             points to the complex data buffer of size 2*fftLen, processed in-place.
+* @param[in]     ifftFlag       0 forward, 1 inverse.
+* @param[in]     bitReverseFlag 1 output in normal order, 0 bit reversed order which is done by CPU only.
+*/
+void arm_cfft_q15_facc(
+    const arm_cfft_instance_q15 *S,
+    q15_t *p1,
+    uint8_t ifftFlag,
+    uint8_t bitReverseFlag);
+
+/**
+* @brief Processing function for Q31 complex FFT, same as arm_cfft_q31(), see arm_cfft_q15_facc().
+*/
+void arm_cfft_q31_facc(
+    const arm_cfft_instance_q31 *S,
+    q31_t *p1,
+    uint8_t ifftFlag,
+    uint8_t bitReverseFlag);
+
+/**
+* @brief Processing function for Q15 real FFT, same as arm_rfft_q15().
+*        Forward transform with bitReverseFlagR set uses hardware, full spectrum of 2*fftLenReal is written.
+*        Inverse transform runs on CPU.
+* @param[in]  S     points to an instance of Q15 RFFT structure.
+* @param[in]  pSrc  points to input buffer, it could be modified.
+* @param[out] pDst  points to output buffer.
+*/
+void arm_rfft_q15_facc(
+    const arm_rfft_instance_q15 *S,
+    q15_t *pSrc,
+    q15_t *pDst);
+
+/** Job types of asynchronous queue */
+typedef enum
+{
+    ARM_DSP_JOB_FIR_Q7,         /**< arm_fir_q7_facc(inst, src, dst, len) */
+    ARM_DSP_JOB_FIR_Q15,        /**< arm_fir_q15_facc(inst, src, dst, len) */
+    ARM_DSP_JOB_CFFT_Q15,       /**< arm_cfft_q15_facc(inst, src, ifft_flag, bit_reverse_flag) */
+    ARM_DSP_JOB_CFFT_Q31,       /**< arm_cfft_q31_facc(inst, src, ifft_flag, bit_reverse_flag) */
+    ARM_DSP_JOB_RFFT_Q15,       /**< arm_rfft_q15_facc(inst, src, dst) */
+    ARM_DSP_JOB_TYPE_NUM,
+} arm_dsp_job_type_t;
+
+struct arm_dsp_job;
+
+/**
+ * @brief Completion callback of job, called in DSP worker thread.
+ */
+typedef void (*arm_dsp_job_cb_t)(struct arm_dsp_job *job, void *user_data);
+
+/** Asynchronous DSP job, owned by caller and must be kept until done */
+typedef struct arm_dsp_job
+{
+    rt_list_t node;             /**< private */
+    uint8_t type;               /**< arm_dsp_job_type_t */
+    uint8_t ifft_flag;          /**< CFFT only */
+    uint8_t bit_reverse_flag;   /**< CFFT only */
+    uint8_t done;               /**< set by worker after processing */
+    const void *inst;           /**< FIR, CFFT or RFFT instance matching type */
+    void *src;                  /**< input, in-place buffer of CFFT */
+    void *dst;                  /**< output of FIR and RFFT */
+    uint32_t len;               /**< block size of FIR */
+    arm_dsp_job_cb_t cb;        /**< could be NULL */
+    void *user_data;
+    struct rt_semaphore *sem;   /**< private */
+} arm_dsp_job_t;
+
+/**
+* @brief  Queue jobs and return, jobs are processed in order by DSP worker thread.
+*         FIR instances used by jobs must not be processed by other threads meanwhile.
+* @param[in]  job  array of jobs
+* @param[in]  num  number of jobs
+* @return RT_EOK if queued
+*/
+rt_err_t arm_dsp_job_submit(arm_dsp_job_t *job, uint32_t num);
+
+/**
+* @brief  Queue jobs and wait all of them done.
+* @param[in]  job      array of jobs
+* @param[in]  num      number of jobs
+* @param[in]  timeout  wait time in ticks
+* @return RT_EOK if all done, -RT_ETIMEOUT if the last job is not done in time, it is still queued
+*/
+rt_err_t arm_dsp_job_run(arm_dsp_job_t *job, uint32_t num, rt_int32_t timeout);
+
 
 #endif
 
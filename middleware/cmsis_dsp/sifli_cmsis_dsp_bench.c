@@ -0,0 +1,361 @@
+/**
+  ******************************************************************************
+  * @file   sifli_cmsis_dsp_bench.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "rtthread.h"
+#include "string.h"
+#include "stdlib.h"
+#include "sifli_cmsis_dsp.h"
+#include "bf0_hal.h"
+
+#ifdef RT_USING_FINSH
+
+/* Accelerated functions against plain CMSIS-DSP, same input, time of loops and max output difference */
+
+#define BENCH_FIR_TAPS      32
+#define BENCH_CONV_LEN      32
+#define BENCH_JOB_NUM       4
+
+static uint8_t *bench_in;
+static uint8_t *bench_cpu;
+static uint8_t *bench_acc;
+
+static uint32_t bench_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void bench_report(const char *name, uint32_t len, uint32_t cpu_us, uint32_t acc_us, int32_t err)
+{
+    uint32_t ratio = cpu_us * 100 / (acc_us ? acc_us : 1);
+
+    rt_kprintf("%-10s %4d: cpu %7d us, acc %7d us, x%d.%02d, max err %d\n", name, len, cpu_us, acc_us,
+               ratio / 100, ratio % 100, err);
+}
+
+static int32_t bench_err_q15(const q15_t *a, const q15_t *b, uint32_t n)
+{
+    int32_t d, err = 0;
+
+    while (n--)
+    {
+        d = abs(*a++ - *b++);
+        if (d > err)
+            err = d;
+    }
+    return err;
+}
+
+static int32_t bench_err_q31(const q31_t *a, const q31_t *b, uint32_t n)
+{
+    int64_t d, err = 0;
+
+    while (n--)
+    {
+        d = (int64_t) * a++ - *b++;
+        if (d < 0)
+            d = -d;
+        if (d > err)
+            err = d;
+    }
+    /* in q15 unit to compare with q15 results */
+    return (int32_t)(err >> 16);
+}
+
+static void bench_fill(uint32_t size)
+{
+    q15_t *p = (q15_t *)bench_in;
+    uint32_t i;
+
+    srand(1);
+    for (i = 0; i < size / sizeof(q15_t); i++)
+        p[i] = (q15_t)((rand() & 0xFFFF) - 0x8000) >> 2;
+}
+
+#ifdef HAL_FACC_MODULE_ENABLED
+static void bench_conv(uint32_t len, uint32_t loops)
+{
+    uint32_t i, start, cpu_us, acc_us;
+    const q15_t *b = (const q15_t *)bench_in + len;
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_conv_q15((const q15_t *)bench_in, len, b, BENCH_CONV_LEN, (q15_t *)bench_cpu);
+    cpu_us = bench_us(start);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_conv_q15_facc((const q15_t *)bench_in, len, b, BENCH_CONV_LEN, (q15_t *)bench_acc);
+    acc_us = bench_us(start);
+    bench_report("conv_q15", len, cpu_us, acc_us,
+                 bench_err_q15((q15_t *)bench_cpu, (q15_t *)bench_acc, len + BENCH_CONV_LEN - 1));
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_conv_q7((const q7_t *)bench_in, len, (const q7_t *)b, BENCH_CONV_LEN, (q7_t *)bench_cpu);
+    cpu_us = bench_us(start);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_conv_q7_facc((const q7_t *)bench_in, len, (const q7_t *)b, BENCH_CONV_LEN, (q7_t *)bench_acc);
+    acc_us = bench_us(start);
+    /* q7 outputs, compare as bytes */
+    for (i = 0, start = 0; i < len + BENCH_CONV_LEN - 1; i++)
+    {
+        if ((uint32_t)abs((q7_t)bench_cpu[i] - (q7_t)bench_acc[i]) > start)
+            start = abs((q7_t)bench_cpu[i] - (q7_t)bench_acc[i]);
+    }
+    bench_report("conv_q7", len, cpu_us, acc_us, start);
+}
+
+static void bench_fir(uint32_t len, uint32_t loops)
+{
+    arm_fir_instance_q15 cpu15, acc15;
+    arm_fir_instance_q7 cpu7, acc7;
+    const q15_t *coeff = (const q15_t *)bench_in + len;
+    q15_t *state_cpu, *state_acc;
+    uint32_t i, start, cpu_us, acc_us;
+
+    state_cpu = rt_malloc((BENCH_FIR_TAPS + len) * sizeof(q15_t));
+    state_acc = rt_malloc_align(FACC_IIR_STATE_SIZE > (BENCH_FIR_TAPS + len) * sizeof(q15_t) ?
+                                FACC_IIR_STATE_SIZE : (BENCH_FIR_TAPS + len) * sizeof(q15_t), 4);
+    if (!state_cpu || !state_acc)
+        goto __EXIT;
+
+    arm_fir_init_q15(&cpu15, BENCH_FIR_TAPS, coeff, state_cpu, len);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_fir_q15(&cpu15, (const q15_t *)bench_in, (q15_t *)bench_cpu, len);
+    cpu_us = bench_us(start);
+    arm_fir_init_q15_facc(&acc15, BENCH_FIR_TAPS, coeff, state_acc, len);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_fir_q15_facc(&acc15, (const q15_t *)bench_in, (q15_t *)bench_acc, len);
+    acc_us = bench_us(start);
+    bench_report("fir_q15", len, cpu_us, acc_us, bench_err_q15((q15_t *)bench_cpu, (q15_t *)bench_acc, len));
+
+    arm_fir_init_q7(&cpu7, BENCH_FIR_TAPS, (const q7_t *)coeff, (q7_t *)state_cpu, len);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_fir_q7(&cpu7, (const q7_t *)bench_in, (q7_t *)bench_cpu, len);
+    cpu_us = bench_us(start);
+    arm_fir_init_q7_facc(&acc7, BENCH_FIR_TAPS, (const q7_t *)coeff, (q7_t *)state_acc, len);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+        arm_fir_q7_facc(&acc7, (const q7_t *)bench_in, (q7_t *)bench_acc, len);
+    acc_us = bench_us(start);
+    for (i = 0, start = 0; i < len; i++)
+    {
+        if ((uint32_t)abs((q7_t)bench_cpu[i] - (q7_t)bench_acc[i]) > start)
+            start = abs((q7_t)bench_cpu[i] - (q7_t)bench_acc[i]);
+    }
+    bench_report("fir_q7", len, cpu_us, acc_us, start);
+
+__EXIT:
+    if (state_cpu)
+        rt_free(state_cpu);
+    if (state_acc)
+        rt_free_align(state_acc);
+}
+#endif /* HAL_FACC_MODULE_ENABLED */
+
+/* In-place transforms, input is copied again in each loop for both */
+static void bench_fft(uint32_t len, uint32_t loops)
+{
+    arm_cfft_instance_q15 cfft15;
+    arm_cfft_instance_q31 cfft31;
+    arm_rfft_instance_q15 rfft15;
+    uint32_t size15 = len * 2 * sizeof(q15_t);
+    uint32_t size31 = len * 2 * sizeof(q31_t);
+    uint32_t i, start, cpu_us, acc_us;
+
+    if (ARM_MATH_SUCCESS != arm_cfft_init_q15(&cfft15, len) ||
+            ARM_MATH_SUCCESS != arm_cfft_init_q31(&cfft31, len) ||
+            ARM_MATH_SUCCESS != arm_rfft_init_q15(&rfft15, len, 0, 1))
+    {
+        rt_kprintf("fft length %d not supported\n", len);
+        return;
+    }
+
+    /* first call measures hardware scale, keep it out of timing */
+    memcpy(bench_acc, bench_in, size31);
+    arm_cfft_q15_facc(&cfft15, (q15_t *)bench_acc, 0, 1);
+    memcpy(bench_acc, bench_in, size31);
+    arm_cfft_q31_facc(&cfft31, (q31_t *)bench_acc, 0, 1);
+    memcpy(bench_acc, bench_in, size31);
+    arm_rfft_q15_facc(&rfft15, (q15_t *)bench_acc, (q15_t *)bench_acc + len * 2);
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_cpu, bench_in, size15);
+        arm_cfft_q15(&cfft15, (q15_t *)bench_cpu, 0, 1);
+    }
+    cpu_us = bench_us(start);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_acc, bench_in, size15);
+        arm_cfft_q15_facc(&cfft15, (q15_t *)bench_acc, 0, 1);
+    }
+    acc_us = bench_us(start);
+    bench_report("cfft_q15", len, cpu_us, acc_us, bench_err_q15((q15_t *)bench_cpu, (q15_t *)bench_acc, len * 2));
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_cpu, bench_in, size31);
+        arm_cfft_q31(&cfft31, (q31_t *)bench_cpu, 0, 1);
+    }
+    cpu_us = bench_us(start);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_acc, bench_in, size31);
+        arm_cfft_q31_facc(&cfft31, (q31_t *)bench_acc, 0, 1);
+    }
+    acc_us = bench_us(start);
+    bench_report("cfft_q31", len, cpu_us, acc_us, bench_err_q31((q31_t *)bench_cpu, (q31_t *)bench_acc, len * 2));
+
+    /* real input in first half of buffer, spectrum of 2*len after it */
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_cpu, bench_in, len * sizeof(q15_t));
+        arm_rfft_q15(&rfft15, (q15_t *)bench_cpu, (q15_t *)bench_cpu + len * 2);
+    }
+    cpu_us = bench_us(start);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        memcpy(bench_acc, bench_in, len * sizeof(q15_t));
+        arm_rfft_q15_facc(&rfft15, (q15_t *)bench_acc, (q15_t *)bench_acc + len * 2);
+    }
+    acc_us = bench_us(start);
+    bench_report("rfft_q15", len, cpu_us, acc_us,
+                 bench_err_q15((q15_t *)bench_cpu + len * 2, (q15_t *)bench_acc + len * 2, len * 2));
+}
+
+/* BENCH_JOB_NUM transforms by direct calls against one batch of queued jobs */
+static void bench_job(uint32_t len, uint32_t loops)
+{
+    arm_cfft_instance_q15 cfft15;
+    arm_dsp_job_t job[BENCH_JOB_NUM];
+    uint32_t size15 = len * 2 * sizeof(q15_t);
+    uint32_t i, j, start, cpu_us, acc_us;
+
+    if (ARM_MATH_SUCCESS != arm_cfft_init_q15(&cfft15, len) || size15 * BENCH_JOB_NUM > len * 2 * sizeof(q31_t) * 2)
+        return;
+
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        for (j = 0; j < BENCH_JOB_NUM; j++)
+            arm_cfft_q15_facc(&cfft15, (q15_t *)(bench_cpu + size15 * (j & 1)), 0, 1);
+    }
+    cpu_us = bench_us(start);
+
+    memset(job, 0, sizeof(job));
+    for (j = 0; j < BENCH_JOB_NUM; j++)
+    {
+        job[j].type = ARM_DSP_JOB_CFFT_Q15;
+        job[j].inst = &cfft15;
+        job[j].src = bench_acc + size15 * (j & 1);
+        job[j].bit_reverse_flag = 1;
+    }
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < loops; i++)
+    {
+        if (RT_EOK != arm_dsp_job_run(job, BENCH_JOB_NUM, RT_WAITING_FOREVER))
+            break;
+    }
+    acc_us = bench_us(start);
+    rt_kprintf("job x%d   %4d: direct %7d us, queued %7d us\n", BENCH_JOB_NUM, len, cpu_us, acc_us);
+}
+
+static int dsp_bench(int argc, char **argv)
+{
+    uint32_t len = argc > 1 ? atoi(argv[1]) : 256;
+    uint32_t loops = argc > 2 ? atoi(argv[2]) : 100;
+    uint32_t size = len * 2 * sizeof(q31_t);
+
+    if (len < 16 || len > 4096 || loops == 0)
+    {
+        rt_kprintf("dsp_bench [len 16~4096] [loops]\n");
+        return -1;
+    }
+
+    bench_in = rt_malloc_align(size, 4);
+    bench_cpu = rt_malloc_align(size * 2, 4);
+    bench_acc = rt_malloc_align(size * 2, 4);
+    if (!bench_in || !bench_cpu || !bench_acc)
+    {
+        rt_kprintf("no memory\n");
+        goto __EXIT;
+    }
+
+    bench_fill(size);
+    arm_dsp_fft_init();
+#ifdef HAL_FACC_MODULE_ENABLED
+    arm_dsp_facc_init();
+    bench_conv(len, loops);
+    bench_fir(len, loops);
+#endif
+    bench_fft(len, loops);
+    bench_job(len, loops);
+
+__EXIT:
+    if (bench_in)
+        rt_free_align(bench_in);
+    if (bench_cpu)
+        rt_free_align(bench_cpu);
+    if (bench_acc)
+        rt_free_align(bench_acc);
+    bench_in = bench_cpu = bench_acc = RT_NULL;
+    return 0;
+}
+MSH_CMD_EXPORT(dsp_bench, benchmark DSP acceleration against CMSIS-DSP);
+
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
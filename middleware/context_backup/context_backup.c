@@ -118,6 +118,14 @@ typedef struct
     uint8_t reserved;
     /** backup region list */
     cb_retained_region_t backup_region_list[CB_MAX_BACKUP_REGION_NUM];
+    /** length of incremental backup area before block list, 0 if not used */
+    uint32_t incr_len;
+    /** #CB_INCR_MAGIC if incremental backup area matches hash table
+     *
+     * it's kept across cb_deinit and cb_init if backup regions are not changed
+     */
+    uint32_t incr_magic;
+    /* cb_incr_region_t incr_list[], for each backup region: hash table and data */
     /* cb_block_t block_list[] */
 } cb_context_db_t;
 
@@ -128,6 +136,12 @@ typedef struct
 #define CB_BLOCK_SIZE(data_len)   (RT_ALIGN(((data_len) + CB_BLOCK_HDR_SIZE), 4))
 #define CB_AVAILABLE_SIZE(size)   (RT_ALIGN_DOWN((size), 4))
 #define CB_NEXT_BLOCK(hdr)        ((cb_block_hdr_t *)((uint32_t)(hdr) + CB_BLOCK_SIZE((hdr)->data_len)))
+#define CB_FIRST_BLOCK(db)        ((cb_block_hdr_t *)((uint32_t)((db) + 1) + (db)->incr_len))
+
+#define CB_INCR_MAGIC             (0x43424952)
+#define CB_INCR_BLOCK_NUM(len)    (((len) + CB_INCR_BLOCK_SIZE - 1) / CB_INCR_BLOCK_SIZE)
+/** hash table and data size of one region in incremental backup area */
+#define CB_INCR_REGION_SIZE(len)  (CB_INCR_BLOCK_NUM(len) * sizeof(uint32_t) + RT_ALIGN((len), 4))
 
 #define CB_IS_IN_SRAM_RANGE(addr)    ((((addr) >= HPSYS_RAM0_BASE) && ((addr) < HPSYS_RAM_END)) ? true : false)
 
@@ -147,6 +161,9 @@ typedef struct
 #endif /* SF32LB55X || SF32LB58X  */
 
 
+/* EXT_DMA has the same address limitation as EZIP */
+#define CB_IS_IN_EXT_DMA_ADDR_RANGE(addr)  CB_IS_IN_EZIP_ADDR_RANGE(addr)
+
 #define CB_MAX_BLOCK_HDR_LIST_LEN     (32)
 
 
@@ -157,6 +174,7 @@ RETM_BSS_SECT_END
 RETM_BSS_SECT_BEGIN(cb_context_db_stats)
 static uint32_t cb_max_used_size RETM_BSS_SECT(cb_context_db_stats);
 static uint32_t cb_total_size RETM_BSS_SECT(cb_context_db_stats);
+static cb_perf_stats_t cb_perf_stats RETM_BSS_SECT(cb_context_db_stats);
 RETM_BSS_SECT_END
 
 
@@ -181,8 +199,8 @@ static uint8_t *cb_get_block_data_buf(uint32_t *size)
     RT_ASSERT(cb_context_db);
     RT_ASSERT(size);
 
-    ptr = (uint8_t *)(cb_context_db + 1) + cb_context_db->total_block_len;
-    *size = cb_context_db->max_len - cb_context_db->total_block_len;
+    ptr = (uint8_t *)CB_FIRST_BLOCK(cb_context_db) + cb_context_db->total_block_len;
+    *size = cb_context_db->max_len - cb_context_db->incr_len - cb_context_db->total_block_len;
     /* truncate the size to multiple of 4 bytes */
     *size = CB_AVAILABLE_SIZE(*size);
     if (*size <= CB_BLOCK_HDR_SIZE)
@@ -215,7 +233,7 @@ static void cb_update_db(void *user_data, cb_restore_callback_t callback,
 
     cb_context_db->block_num++;
     cb_context_db->total_block_len += CB_BLOCK_SIZE(hdr->data_len);
-    RT_ASSERT(cb_context_db->total_block_len <= cb_context_db->max_len);
+    RT_ASSERT((cb_context_db->incr_len + cb_context_db->total_block_len) <= cb_context_db->max_len);
 
 }
 
@@ -493,6 +511,86 @@ __EXIT:
     return err;
 }
 
+#ifdef hwp_extdma
+typedef struct
+{
+    EXT_DMA_HandleTypeDef hdma;
+    uint32_t dst;
+    /** length of ongoing transfer, 0 if idle */
+    uint32_t len;
+} cb_dma_ctx_t;
+
+L1_NON_RET_BSS_SECT_BEGIN(cb_dma_ctx)
+L1_NON_RET_BSS_SECT(cb_dma_ctx, static cb_dma_ctx_t cb_dma_ctx);
+L1_NON_RET_BSS_SECT_END
+#endif /* hwp_extdma */
+
+static void cb_dma_wait(void)
+{
+#ifdef hwp_extdma
+    HAL_StatusTypeDef res;
+
+    if (0 == cb_dma_ctx.len)
+    {
+        return;
+    }
+
+    res = HAL_EXT_DMA_PollForTransfer(&cb_dma_ctx.hdma, HAL_EXT_DMA_FULL_TRANSFER, HAL_MAX_DELAY);
+    RT_ASSERT(HAL_OK == res);
+    SCB_InvalidateDCache_by_Addr((void *)cb_dma_ctx.dst, cb_dma_ctx.len);
+    cb_dma_ctx.len = 0;
+#endif /* hwp_extdma */
+}
+
+/* start copy by EXT_DMA and return without waiting, previous transfer is waited for first.
+ * Return false if EXT_DMA can't access the range, nothing is started then */
+static bool cb_dma_start(uint32_t dst, uint32_t src, uint32_t len)
+{
+#ifdef hwp_extdma
+    HAL_StatusTypeDef res;
+
+    if (!CB_IS_IN_EXT_DMA_ADDR_RANGE(dst) || !CB_IS_IN_EXT_DMA_ADDR_RANGE(src)
+            || (0 != ((dst | src | len) & 3)) || ((len >> 2) > HAL_EXT_DMA_SINGLE_MAX) || (0 == len))
+    {
+        return false;
+    }
+
+    cb_dma_wait();
+
+    memset(&cb_dma_ctx.hdma, 0, sizeof(cb_dma_ctx.hdma));
+    cb_dma_ctx.hdma.Init.SrcInc = HAL_EXT_DMA_SRC_INC | HAL_EXT_DMA_SRC_BURST16;
+    cb_dma_ctx.hdma.Init.DstInc = HAL_EXT_DMA_DST_INC | HAL_EXT_DMA_DST_BURST16;
+    cb_dma_ctx.hdma.Init.cmpr_en = false;
+    res = HAL_EXT_DMA_Init(&cb_dma_ctx.hdma);
+    RT_ASSERT(HAL_OK == res);
+
+    /* DMA reads memory, not cache, and no dirty line of dst may be evicted over new data */
+    SCB_CleanDCache_by_Addr((void *)src, len);
+    SCB_CleanInvalidateDCache_by_Addr((void *)dst, len);
+
+    res = HAL_EXT_DMA_Start(&cb_dma_ctx.hdma, src, dst, len >> 2);
+    RT_ASSERT(HAL_OK == res);
+    cb_dma_ctx.dst = dst;
+    cb_dma_ctx.len = len;
+    cb_perf_stats.dma_len += len;
+
+    return true;
+#else
+    return false;
+#endif /* hwp_extdma */
+}
+
+static void cb_copy_data(uint32_t dst, uint32_t src, uint32_t len)
+{
+    if (cb_dma_start(dst, src, len))
+    {
+        cb_dma_wait();
+        return;
+    }
+
+    memcpy((void *)dst, (void *)src, len);
+}
+
 static rt_err_t cb_restore_static_data(void *target, uint8_t *buf, rt_uint32_t size, rt_compressor_cb_t decompressor_cb)
 {
     cb_retained_region_t *backup_region;
@@ -509,7 +607,7 @@ static rt_err_t cb_restore_static_data(void *target, uint8_t *buf, rt_uint32_t s
     else
     {
         RT_ASSERT(size == backup_region->len);
-        memcpy((void *)backup_region->start_addr, buf, size);
+        cb_copy_data(backup_region->start_addr, (uint32_t)buf, size);
     }
 
     return RT_EOK;
@@ -517,6 +615,149 @@ static rt_err_t cb_restore_static_data(void *target, uint8_t *buf, rt_uint32_t s
 
 
 
+static uint32_t cb_gtime_to_us(uint32_t gtime)
+{
+    return (uint32_t)((uint64_t)gtime * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+/* multiplying odd number and xorshift are both invertible, so change of any single word always changes hash */
+static uint32_t cb_incr_hash(const uint8_t *data, uint32_t len)
+{
+    const uint32_t *word = (const uint32_t *)data;
+    uint32_t hash = 0x811C9DC5;
+    uint32_t tail;
+
+    for (; len >= 4; len -= 4)
+    {
+        hash = (hash ^ *word++) * 0x9E3779B1;
+        hash ^= hash >> 16;
+    }
+    if (len > 0)
+    {
+        tail = 0;
+        memcpy(&tail, word, len);
+        hash = (hash ^ tail) * 0x9E3779B1;
+        hash ^= hash >> 16;
+    }
+
+    return hash;
+}
+
+static uint32_t cb_incr_area_len(const cb_retained_region_t *backup_region, uint8_t region_num)
+{
+    uint32_t len;
+    uint32_t i;
+
+    len = 0;
+    for (i = 0; i < region_num; i++, backup_region++)
+    {
+        len += CB_INCR_REGION_SIZE(backup_region->len);
+    }
+
+    return len;
+}
+
+/* copy run of changed blocks, DMA copies it while CPU goes on hashing following blocks */
+static void cb_save_incr_run(uint8_t *mirror, uint8_t *src, uint32_t *run_offset, uint32_t *run_len)
+{
+    if (0 == *run_len)
+    {
+        return;
+    }
+    if (!cb_dma_start((uint32_t)(mirror + *run_offset), (uint32_t)(src + *run_offset), *run_len))
+    {
+        memcpy(mirror + *run_offset, src + *run_offset, *run_len);
+    }
+    *run_len = 0;
+}
+
+/* copy block whose hash differs from the one of last backup, return written size */
+static uint32_t cb_save_incr_static_data(uint32_t *skipped)
+{
+    cb_retained_region_t *backup_region;
+    uint32_t *hash_tbl;
+    uint8_t *mirror;
+    uint8_t *src;
+    uint32_t written;
+    uint32_t blk_len;
+    uint32_t offset;
+    uint32_t hash;
+    uint32_t run_offset = 0;
+    uint32_t run_len = 0;
+    uint32_t i;
+    uint32_t j;
+    bool valid;
+
+    valid = (CB_INCR_MAGIC == cb_context_db->incr_magic);
+    /* invalid until all blocks match hash table */
+    cb_context_db->incr_magic = 0;
+
+    written = 0;
+    *skipped = 0;
+    hash_tbl = (uint32_t *)(cb_context_db + 1);
+    backup_region = &cb_context_db->backup_region_list[0];
+    for (i = 0; i < cb_context_db->backup_region_num; i++, backup_region++)
+    {
+        mirror = (uint8_t *)(hash_tbl + CB_INCR_BLOCK_NUM(backup_region->len));
+        src = (uint8_t *)backup_region->start_addr;
+        for (j = 0, offset = 0; offset < backup_region->len; j++, offset += blk_len)
+        {
+            blk_len = backup_region->len - offset;
+            if (blk_len > CB_INCR_BLOCK_SIZE)
+            {
+                blk_len = CB_INCR_BLOCK_SIZE;
+            }
+            hash = cb_incr_hash(src + offset, blk_len);
+            if (valid && (hash == hash_tbl[j]))
+            {
+                *skipped += blk_len;
+                cb_save_incr_run(mirror, src, &run_offset, &run_len);
+                continue;
+            }
+            if (0 == run_len)
+            {
+                run_offset = offset;
+            }
+            run_len += blk_len;
+            hash_tbl[j] = hash;
+            written += blk_len;
+        }
+        cb_save_incr_run(mirror, src, &run_offset, &run_len);
+        hash_tbl = (uint32_t *)(mirror + RT_ALIGN(backup_region->len, 4));
+    }
+    cb_dma_wait();
+
+    cb_context_db->incr_magic = CB_INCR_MAGIC;
+
+    return written;
+}
+
+static void cb_restore_incr_static_data(void)
+{
+    cb_retained_region_t *backup_region;
+    uint8_t *mirror;
+    uint32_t *hash_tbl;
+    uint32_t i;
+
+    RT_ASSERT(CB_INCR_MAGIC == cb_context_db->incr_magic);
+
+    hash_tbl = (uint32_t *)(cb_context_db + 1);
+    backup_region = &cb_context_db->backup_region_list[0];
+    for (i = 0; i < cb_context_db->backup_region_num; i++, backup_region++)
+    {
+        mirror = (uint8_t *)(hash_tbl + CB_INCR_BLOCK_NUM(backup_region->len));
+        /* regions are disjoint, CPU copies the ones EXT_DMA can't reach while DMA works on another */
+        if ((backup_region->len > 0)
+                && !cb_dma_start(backup_region->start_addr, (uint32_t)mirror, backup_region->len))
+        {
+            memcpy((void *)backup_region->start_addr, mirror, backup_region->len);
+        }
+        hash_tbl = (uint32_t *)(mirror + RT_ALIGN(backup_region->len, 4));
+    }
+    /* heap and stack restore need static data */
+    cb_dma_wait();
+}
+
 rt_err_t cb_save_static_data(void)
 {
     uint32_t i;
@@ -548,7 +789,7 @@ rt_err_t cb_save_static_data(void)
 #else
             if (backup_region->len <= max_size)
             {
-                memcpy((void *)data_buf, (void *)backup_region->start_addr, backup_region->len);
+                cb_copy_data((uint32_t)data_buf, backup_region->start_addr, backup_region->len);
                 wr_size = backup_region->len;
             }
             else
@@ -584,6 +825,9 @@ rt_err_t cb_init(cb_backup_param_t *param)
     rt_err_t err;
     uint32_t max_size;
     uint8_t *data_buf;
+    cb_context_db_t *db;
+    uint32_t incr_len;
+    bool keep_incr;
 
     RT_ASSERT(NULL == cb_context_db);
 
@@ -597,12 +841,34 @@ rt_err_t cb_init(cb_backup_param_t *param)
         return RT_EFULL;
     }
 
-    cb_context_db = (cb_context_db_t *)param->ret_mem_start_addr;
+    db = (cb_context_db_t *)param->ret_mem_start_addr;
+    incr_len = 0;
+    keep_incr = false;
+    if (param->backup_mask & CB_BACKUP_INCREMENTAL_MASK)
+    {
+        incr_len = cb_incr_area_len(&param->backup_region_list[0], param->backup_region_num);
+        if ((incr_len + CB_CONTEXT_DB_HDR_SIZE) > param->ret_mem_size)
+        {
+            return RT_EFULL;
+        }
+        /* retention memory still holds data of last backup, backup regions must be same */
+        keep_incr = (CB_INCR_MAGIC == db->incr_magic) && (incr_len == db->incr_len)
+                    && (param->backup_region_num == db->backup_region_num)
+                    && (0 == memcmp(&db->backup_region_list[0], &param->backup_region_list[0],
+                                    param->backup_region_num * sizeof(cb_retained_region_t)));
+    }
+
+    cb_context_db = db;
     cb_context_db->max_len = param->ret_mem_size - CB_CONTEXT_DB_HDR_SIZE;
     cb_context_db->backup_mask = param->backup_mask;
 
     cb_context_db->block_num = 0;
     cb_context_db->total_block_len = 0;
+    cb_context_db->incr_len = incr_len;
+    if (!keep_incr)
+    {
+        cb_context_db->incr_magic = 0;
+    }
 
 
     memcpy(&cb_context_db->backup_region_list[0], &param->backup_region_list[0], sizeof(cb_context_db->backup_region_list));
@@ -626,14 +892,26 @@ rt_err_t cb_deinit(void)
 rt_err_t cb_save_context(void)
 {
     rt_err_t err;
+    uint32_t start_time;
+    uint32_t written;
+    uint32_t skipped;
 
     if (!cb_context_db)
     {
         return RT_ERROR;
     }
 
+    start_time = HAL_GTIMER_READ();
+    written = 0;
+    skipped = 0;
+    cb_perf_stats.dma_len = 0;
+
     /* static data is restored first as heap restore needs static variable */
-    if (cb_context_db->backup_mask & CB_BACKUP_STATIC_DATA_MASK)
+    if (cb_context_db->backup_mask & CB_BACKUP_INCREMENTAL_MASK)
+    {
+        written = cb_save_incr_static_data(&skipped);
+    }
+    else if (cb_context_db->backup_mask & CB_BACKUP_STATIC_DATA_MASK)
     {
         err = cb_save_static_data();
         if (RT_EOK != err)
@@ -661,12 +939,17 @@ rt_err_t cb_save_context(void)
         }
     }
 
-    if (cb_context_db->total_block_len > cb_max_used_size)
+    if ((cb_context_db->incr_len + cb_context_db->total_block_len) > cb_max_used_size)
     {
-        cb_max_used_size = cb_context_db->total_block_len;
+        cb_max_used_size = cb_context_db->incr_len + cb_context_db->total_block_len;
         cb_total_size = cb_context_db->max_len;
     }
 
+    cb_perf_stats.save_cnt++;
+    cb_perf_stats.written = written + cb_context_db->total_block_len;
+    cb_perf_stats.skipped = skipped;
+    cb_perf_stats.save_time = cb_gtime_to_us(HAL_GTIMER_READ() - start_time);
+
     return RT_EOK;
 
 __EXIT:
@@ -680,14 +963,21 @@ rt_err_t cb_restore_context(void)
     uint32_t i;
     cb_block_hdr_t *hdr;
     rt_err_t err;
+    uint32_t start_time;
 
     if (!cb_context_db)
     {
         return RT_ERROR;
     }
 
+    start_time = HAL_GTIMER_READ();
     memcpy(&last_context_db, cb_context_db, sizeof(last_context_db));
-    hdr = (cb_block_hdr_t *)(cb_context_db + 1);
+    if (cb_context_db->backup_mask & CB_BACKUP_INCREMENTAL_MASK)
+    {
+        cb_restore_incr_static_data();
+    }
+
+    hdr = CB_FIRST_BLOCK(cb_context_db);
     for (i = 0; i < cb_context_db->block_num; i++)
     {
         RT_ASSERT(hdr->restore_callback);
@@ -710,13 +1000,15 @@ rt_err_t cb_restore_context(void)
 
         hdr = CB_NEXT_BLOCK(hdr);
 
-        RT_ASSERT(((uint32_t)hdr - (uint32_t)(cb_context_db + 1)) <= cb_context_db->total_block_len);
+        RT_ASSERT(((uint32_t)hdr - (uint32_t)CB_FIRST_BLOCK(cb_context_db)) <= cb_context_db->total_block_len);
     }
 
-    /* deallocate blocks */
+    /* deallocate blocks, incremental backup area is kept for next backup */
     cb_context_db->block_num = 0;
     cb_context_db->total_block_len = 0;
 
+    cb_perf_stats.restore_time = cb_gtime_to_us(HAL_GTIMER_READ() - start_time);
+
     return RT_EOK;
 }
 
@@ -732,5 +1024,12 @@ void cb_get_stats(uint32_t *total, uint32_t *min_free)
         *min_free = cb_total_size - cb_max_used_size;
     }
 }
+
+void cb_get_perf_stats(cb_perf_stats_t *stats)
+{
+    RT_ASSERT(stats);
+
+    memcpy(stats, &cb_perf_stats, sizeof(*stats));
+}
 #endif // SOC_BF0_HCPU
 
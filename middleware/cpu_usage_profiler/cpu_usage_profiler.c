@@ -72,6 +72,34 @@
 #endif /* CPU_USAGE_METRICS_USE_COLLECTOR */
 
 
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+    #if defined(USING_IPC_QUEUE) && defined(SOC_BF0_HCPU)
+        #include "bf0_mbox_common.h"
+    #endif
+    #ifndef CPU_PROFILER_CYCLE_THREAD_NUM
+        #define CPU_PROFILER_CYCLE_THREAD_NUM  (32)
+    #endif
+    #ifndef CPU_PROFILER_CYCLE_IRQ_NUM
+        #define CPU_PROFILER_CYCLE_IRQ_NUM     (100)   /* Larger IRQ number is accounted to the last */
+    #endif
+    #ifndef CPU_PROFILER_CYCLE_WINDOW_MS
+        #define CPU_PROFILER_CYCLE_WINDOW_MS   (1000)
+    #endif
+    #define CPU_PROFILER_CYCLE_IRQ_NEST        (8)
+    #define CPU_PROFILER_CYCLE_EXC_NUM         (CPU_PROFILER_CYCLE_IRQ_NUM + 16)
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
+#ifdef CPU_PROFILER_PC_SAMPLE_ENABLED
+    #include "bf0_hal_cache.h"
+    #ifndef CPU_PROFILER_PC_SAMPLE_BINS
+        #define CPU_PROFILER_PC_SAMPLE_BINS    (1024)  /* Must be power of 2 */
+    #endif
+    #ifndef CPU_PROFILER_PC_SAMPLE_SHIFT
+        #define CPU_PROFILER_PC_SAMPLE_SHIFT   (3)     /* Bin granularity, log2 of bytes */
+    #endif
+    #define CPU_PROFILER_PC_SAMPLE_PROBE       (8)
+#endif /* CPU_PROFILER_PC_SAMPLE_ENABLED */
+
 #ifdef CPU_USAGE_METRICS_ENABLED
     #define CPU_THREAD_NAME_LEN  (8)
     #ifdef RT_USING_PTHREADS
@@ -138,6 +166,66 @@ static cpu_usage_metrics_t cpu_metrics;
     mc_collector_t cpu_usage_metrics_collector;
 #endif /* CPU_USAGE_METRICS_USE_COLLECTOR */
 
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+typedef struct
+{
+    uint64_t cycles;
+    uint64_t win_start;     /* cycles at start of current window */
+    uint16_t last;          /* load of last window, in 0.1% */
+    uint16_t avg;           /* sliding average of window loads, in 0.1% */
+} cpu_cycle_stat_t;
+
+typedef struct
+{
+    struct rt_thread *thread;   /* NULL for threads not fit in table */
+    char name[RT_NAME_MAX];
+    cpu_cycle_stat_t stat;
+} cpu_cycle_thread_t;
+
+/*
+    Cycles are charged to the innermost running ISR, or to the running thread.
+    DWT stops with CPU clock, loads are share of clocked cycles.
+*/
+typedef struct
+{
+    uint32_t seg_start;
+    uint8_t irq_depth;
+    uint8_t thread_num;
+    uint16_t irq_stack[CPU_PROFILER_CYCLE_IRQ_NEST];
+    cpu_cycle_thread_t *cur;
+    cpu_cycle_thread_t thread[CPU_PROFILER_CYCLE_THREAD_NUM + 1];
+    cpu_cycle_stat_t exc[CPU_PROFILER_CYCLE_EXC_NUM];  /* by exception number */
+    uint64_t total;
+    uint64_t win_start;
+    struct rt_timer timer;
+} cpu_cycle_ctx_t;
+
+static cpu_cycle_ctx_t cpu_cycle;
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
+#ifdef CPU_PROFILER_PC_SAMPLE_ENABLED
+typedef struct
+{
+    uint32_t key;       /* pc >> CPU_PROFILER_PC_SAMPLE_SHIFT, 0 if unused */
+    uint32_t count;
+} cpu_pc_bin_t;
+
+/*
+    PC of interrupted thread is sampled on each SysTick, samples are binned in
+    open addressing hash table and dumped for hot_func.py to rank functions.
+*/
+typedef struct
+{
+    bool running;
+    uint32_t samples;
+    uint32_t handler;   /* SysTick preempted other exception, not sampled */
+    uint32_t dropped;   /* no free bin */
+    cpu_pc_bin_t bin[CPU_PROFILER_PC_SAMPLE_BINS];
+} cpu_pc_sample_ctx_t;
+
+static cpu_pc_sample_ctx_t cpu_pc_ctx;
+#endif /* CPU_PROFILER_PC_SAMPLE_ENABLED */
+
 
 
 
@@ -157,6 +245,8 @@ static uint32_t switch_in_gtimer;
 static uint32_t other_run_time;
 /** idle thread run time in microsecond */
 static uint32_t idle_run_time;
+/** other threads run time in microsecond, not cleared by reset, wraps around */
+static uint32_t busy_run_time;
 /** cpu usage percentage */
 static float cpu_usage;
 static uint32_t cpu_lptim_freq;
@@ -166,9 +256,155 @@ static void cpu_prof_reset(void);
     static void print_timer_callback(void *parameter);
 #endif
 
-#ifdef CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+static void cpu_cycle_charge(void)
+{
+    uint32_t now = HAL_DBG_DWT_GetCycles();
+    uint32_t delta = now - cpu_cycle.seg_start;
+
+    cpu_cycle.seg_start = now;
+    cpu_cycle.total += delta;
+    if (cpu_cycle.irq_depth > 0)
+    {
+        cpu_cycle.exc[cpu_cycle.irq_stack[((cpu_cycle.irq_depth < CPU_PROFILER_CYCLE_IRQ_NEST) ? cpu_cycle.irq_depth : CPU_PROFILER_CYCLE_IRQ_NEST) - 1]].cycles += delta;
+    }
+    else if (cpu_cycle.cur)
+    {
+        cpu_cycle.cur->stat.cycles += delta;
+    }
+}
+
+static cpu_cycle_thread_t *cpu_cycle_get_thread(struct rt_thread *thread)
+{
+    cpu_cycle_thread_t *entry;
+    uint32_t i;
+
+    for (i = 0; i < cpu_cycle.thread_num; i++)
+    {
+        if (cpu_cycle.thread[i].thread == thread)
+            return &cpu_cycle.thread[i];
+    }
+
+    if (cpu_cycle.thread_num >= CPU_PROFILER_CYCLE_THREAD_NUM)
+        return &cpu_cycle.thread[CPU_PROFILER_CYCLE_THREAD_NUM];
+
+    entry = &cpu_cycle.thread[cpu_cycle.thread_num++];
+    entry->thread = thread;
+    memcpy(entry->name, thread->name, RT_NAME_MAX);
+    return entry;
+}
+
+static void cpu_cycle_irq_enter(void)
+{
+    uint32_t exc = __get_xPSR() & 0x1FF;
+
+    cpu_cycle_charge();
+    if (exc >= CPU_PROFILER_CYCLE_EXC_NUM)
+        exc = CPU_PROFILER_CYCLE_EXC_NUM - 1;
+    if (cpu_cycle.irq_depth < CPU_PROFILER_CYCLE_IRQ_NEST)
+        cpu_cycle.irq_stack[cpu_cycle.irq_depth] = (uint16_t)exc;
+    cpu_cycle.irq_depth++;
+}
+
+static void cpu_cycle_irq_leave(void)
+{
+    if (0 == cpu_cycle.irq_depth)
+        return;
+    cpu_cycle_charge();
+    cpu_cycle.irq_depth--;
+}
+
+static void cpu_cycle_update_stat(cpu_cycle_stat_t *stat, uint64_t win_total)
+{
+    uint64_t delta = stat->cycles - stat->win_start;
+
+    stat->win_start = stat->cycles;
+    stat->last = win_total ? (uint16_t)(delta * 1000 / win_total) : 0;
+    stat->avg = (stat->avg * 7 + stat->last) / 8;
+}
+
+static void cpu_cycle_window_timeout(void *parameter)
+{
+    rt_base_t level;
+    uint64_t win_total;
+    uint32_t i;
+
+    level = rt_hw_interrupt_disable();
+    cpu_cycle_charge();
+    win_total = cpu_cycle.total - cpu_cycle.win_start;
+    cpu_cycle.win_start = cpu_cycle.total;
+    for (i = 0; i <= CPU_PROFILER_CYCLE_THREAD_NUM; i++)
+        cpu_cycle_update_stat(&cpu_cycle.thread[i].stat, win_total);
+    for (i = 0; i < CPU_PROFILER_CYCLE_EXC_NUM; i++)
+        cpu_cycle_update_stat(&cpu_cycle.exc[i], win_total);
+    rt_hw_interrupt_enable(level);
+}
+
+static void cpu_cycle_init(void)
+{
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    memcpy(cpu_cycle.thread[CPU_PROFILER_CYCLE_THREAD_NUM].name, "other", sizeof("other"));
+    cpu_cycle.seg_start = HAL_DBG_DWT_GetCycles();
+    cpu_cycle.cur = cpu_cycle_get_thread(rt_thread_self());
+
+    rt_timer_init(&cpu_cycle.timer, "cpu_cyc", cpu_cycle_window_timeout, NULL,
+                  rt_tick_from_millisecond(CPU_PROFILER_CYCLE_WINDOW_MS), RT_TIMER_FLAG_PERIODIC);
+    rt_timer_start(&cpu_cycle.timer);
+}
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
+#ifdef CPU_PROFILER_PC_SAMPLE_ENABLED
+static void cpu_pc_sample(void)
+{
+    cpu_pc_bin_t *bin;
+    uint32_t key;
+    uint32_t idx;
+    uint32_t i;
+
+    if (!cpu_pc_ctx.running || (SysTick_IRQn != (IRQn_Type)((int32_t)(__get_xPSR() & 0x1FF) - 16)))
+        return;
+
+    cpu_pc_ctx.samples++;
+    /* Only thread mode on PSP has its exception frame at PSP, PendSV in progress is excluded too */
+    if (!(SCB->ICSR & SCB_ICSR_RETTOBASE_Msk) || (rt_interrupt_get_nest() > 1) || !rt_thread_self())
+    {
+        cpu_pc_ctx.handler++;
+        return;
+    }
+
+    key = ((uint32_t *)__get_PSP())[6] >> CPU_PROFILER_PC_SAMPLE_SHIFT;
+    idx = key * 2654435761UL;
+    for (i = 0; i < CPU_PROFILER_PC_SAMPLE_PROBE; i++)
+    {
+        bin = &cpu_pc_ctx.bin[(idx + i) & (CPU_PROFILER_PC_SAMPLE_BINS - 1)];
+        if (bin->key == key)
+        {
+            bin->count++;
+            return;
+        }
+        if (0 == bin->key)
+        {
+            bin->key = key;
+            bin->count = 1;
+            return;
+        }
+    }
+    cpu_pc_ctx.dropped++;
+}
+#endif /* CPU_PROFILER_PC_SAMPLE_ENABLED */
+
+#if defined(CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED) || defined(CPU_PROFILER_CYCLE_ENABLED) || defined(CPU_PROFILER_PC_SAMPLE_ENABLED)
 static void isr_enter_hook(void)
 {
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+    cpu_cycle_irq_enter();
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+#ifdef CPU_PROFILER_PC_SAMPLE_ENABLED
+    cpu_pc_sample();
+#endif /* CPU_PROFILER_PC_SAMPLE_ENABLED */
+#ifdef CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED
     uint32_t run_time;
     uint32_t curr_gtimer;
     rt_hwtimerval_t curr_time;
@@ -196,8 +432,9 @@ static void isr_enter_hook(void)
     isr_hist.hist[isr_hist.index].time.sec = curr_time.sec;
     isr_hist.hist[isr_hist.index].time.usec = curr_time.usec;
     isr_hist.hist[isr_hist.index].irq_no = irqn;
-}
 #endif /* CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED */
+}
+#endif /* CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED || CPU_PROFILER_CYCLE_ENABLED || CPU_PROFILER_PC_SAMPLE_ENABLED */
 
 #ifdef PM_USE_RC48
 extern uint8_t g_xt48_used;
@@ -229,6 +466,11 @@ static void thread_tick_count(struct rt_thread *from, struct rt_thread *to)
     struct rt_timer *next_timer;
 #endif /* RT_USING_TIMER_SOFT */
 
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+    cpu_cycle_charge();
+    cpu_cycle.cur = cpu_cycle_get_thread(to);
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
     curr_gtimer = CPU_READ_GTIMER();
     if (!first_switch)
     {
@@ -267,6 +509,7 @@ static void thread_tick_count(struct rt_thread *from, struct rt_thread *to)
         {
             /* other task */
             other_run_time += run_time;
+            busy_run_time += run_time;
 
 #ifdef CPU_USAGE_METRICS_ENABLED
             cpu_metrics.other_run_time += run_time_float;
@@ -341,9 +584,14 @@ static int cpu_prof_init(void)
     /* set scheduler hook */
     rt_scheduler_sethook(thread_tick_count);
 
-#ifdef CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+    cpu_cycle_init();
+    rt_interrupt_leave_sethook(cpu_cycle_irq_leave);
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
+#if defined(CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED) || defined(CPU_PROFILER_CYCLE_ENABLED) || defined(CPU_PROFILER_PC_SAMPLE_ENABLED)
     rt_interrupt_enter_sethook(isr_enter_hook);
-#endif /* CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED */
+#endif /* CPU_PROFILER_RECORD_ISR_HISTORY_ENABLED || CPU_PROFILER_CYCLE_ENABLED || CPU_PROFILER_PC_SAMPLE_ENABLED */
 
     return 0;
 }
@@ -393,11 +641,130 @@ static void cpu_prof_view()
 }
 MSH_CMD_EXPORT_ALIAS(cpu_prof_view, cpu, cpu: view CPU profiling result);
 
+#ifdef CPU_PROFILER_CYCLE_ENABLED
+static int cpu_load(int argc, char **argv)
+{
+    cpu_cycle_stat_t *stat;
+    uint32_t i;
+
+#ifdef SOC_BF0_HCPU
+    rt_kprintf("HCPU");
+#else
+    rt_kprintf("LCPU");
+#endif /* SOC_BF0_HCPU */
+    rt_kprintf(" %dms window, load(%%) last/avg\n", CPU_PROFILER_CYCLE_WINDOW_MS);
+    for (i = 0; i <= CPU_PROFILER_CYCLE_THREAD_NUM; i++)
+    {
+        stat = &cpu_cycle.thread[i].stat;
+        if ((i < cpu_cycle.thread_num) || (stat->cycles > 0))
+            rt_kprintf("  %-*.*s %3d.%d %3d.%d\n", RT_NAME_MAX, RT_NAME_MAX, cpu_cycle.thread[i].name,
+                       stat->last / 10, stat->last % 10, stat->avg / 10, stat->avg % 10);
+    }
+    for (i = 0; i < CPU_PROFILER_CYCLE_EXC_NUM; i++)
+    {
+        stat = &cpu_cycle.exc[i];
+        if (stat->cycles > 0)
+            rt_kprintf("  irq%-*d %3d.%d %3d.%d\n", RT_NAME_MAX - 3, (int)i - 16,
+                       stat->last / 10, stat->last % 10, stat->avg / 10, stat->avg % 10);
+    }
+
+#if defined(USING_IPC_QUEUE) && defined(SOC_BF0_HCPU)
+    /* LCPU prints its table on the shared console */
+    if ((argc > 1) && (0 == strcmp(argv[1], "all")) && (IPC_QUEUE_INVALID_HANDLE != sys_get_hl_ipc_queue()))
+    {
+        const char *cmd = "cpu_load\n";
+        ipc_queue_write(sys_get_hl_ipc_queue(), (uint8_t *)cmd, strlen(cmd), 10);
+    }
+#endif
+    return 0;
+}
+MSH_CMD_EXPORT(cpu_load, cpu_load [all]: per thread and IRQ load);
+#endif /* CPU_PROFILER_CYCLE_ENABLED */
+
+#ifdef CPU_PROFILER_PC_SAMPLE_ENABLED
+static void cpu_pc_print_miss_rate(void)
+{
+#ifdef SOC_BF0_HCPU
+    float irate, drate;
+
+    HAL_CACHE_GetMissRate(&irate, &drate, false);
+    rt_kprintf("cpu_pc: icache_miss %d.%02d dcache_miss %d.%02d\n",
+               (int)irate, (int)(irate * 100) % 100, (int)drate, (int)(drate * 100) % 100);
+#endif /* SOC_BF0_HCPU */
+}
+
+static int cpu_pc(int argc, char **argv)
+{
+    rt_base_t level;
+    uint32_t i;
+
+    if ((argc > 1) && (0 == strcmp(argv[1], "start")))
+    {
+        level = rt_hw_interrupt_disable();
+        memset(&cpu_pc_ctx, 0, sizeof(cpu_pc_ctx));
+        cpu_pc_ctx.running = true;
+        rt_hw_interrupt_enable(level);
+#ifdef SOC_BF0_HCPU
+        HAL_CACHE_Enable(HAL_CACHE_ICACHE_ALL, HAL_CACHE_DCACHE_ALL);
+#endif /* SOC_BF0_HCPU */
+    }
+    else if ((argc > 1) && (0 == strcmp(argv[1], "stop")))
+    {
+        cpu_pc_ctx.running = false;
+    }
+    else if ((argc > 1) && (0 == strcmp(argv[1], "dump")))
+    {
+        bool running = cpu_pc_ctx.running;
+
+        /* Output is parsed by hot_func.py */
+        cpu_pc_ctx.running = false;
+        rt_kprintf("cpu_pc: shift %d samples %d handler %d dropped %d\n", CPU_PROFILER_PC_SAMPLE_SHIFT,
+                   cpu_pc_ctx.samples, cpu_pc_ctx.handler, cpu_pc_ctx.dropped);
+        cpu_pc_print_miss_rate();
+        for (i = 0; i < CPU_PROFILER_PC_SAMPLE_BINS; i++)
+        {
+            if (cpu_pc_ctx.bin[i].key)
+                rt_kprintf("cpu_pc: 0x%08x %d\n", cpu_pc_ctx.bin[i].key << CPU_PROFILER_PC_SAMPLE_SHIFT, cpu_pc_ctx.bin[i].count);
+        }
+        rt_kprintf("cpu_pc: end\n");
+        cpu_pc_ctx.running = running;
+    }
+    else
+    {
+        rt_kprintf("cpu_pc: samples %d handler %d dropped %d %s\n", cpu_pc_ctx.samples, cpu_pc_ctx.handler,
+                   cpu_pc_ctx.dropped, cpu_pc_ctx.running ? "running" : "stopped");
+        cpu_pc_print_miss_rate();
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(cpu_pc, cpu_pc [start|stop|dump]: sample PC of XIP code on SysTick);
+#endif /* CPU_PROFILER_PC_SAMPLE_ENABLED */
+
 float cpu_get_usage(void)
 {
     return cpu_usage;
 }
 
+uint32_t cpu_get_busy_us(void)
+{
+    uint32_t busy;
+    uint32_t run_time;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    busy = busy_run_time;
+    /* add the slice of running thread which is not accounted until it's switched out */
+    if (!first_switch && cpu_lptim_freq && ((RT_THREAD_PRIORITY_MAX - 1) != rt_thread_self()->init_priority))
+    {
+        run_time = CPU_READ_GTIMER() - switch_in_gtimer;
+        busy += (uint32_t)(run_time * (uint64_t)CPU_USEC_PER_SECOND / CPU_GET_LPTIM_FREQ());
+    }
+    rt_hw_interrupt_enable(level);
+
+    return busy;
+}
+
 uint32_t cpu_get_hw_us(void)
 {
     uint32_t us;
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# Rank hot XIP functions from "cpu_pc dump" output and generate link placement for RAM
+#
+# usage: hot_func.py <app.elf> <cpu_pc.log> [--budget BYTES] [--ld OUT] [--sct OUT]
+#                    [--compare BEFORE.log] [--nm arm-none-eabi-nm] [--top N]
+#   app.elf   image the log was captured with, built with -ffunction-sections
+#   cpu_pc.log  console log containing "cpu_pc dump" output
+#   BYTES     RAM code budget, functions are taken by rank until it's used up
+#   --ld      write GCC linker fragment, INCLUDE it in RAM code output section
+#   --sct     write armlink scatter fragment, paste/include in RAM code execution region
+#   --compare log captured before relocation, XIP share and cache miss are compared
+#
+# Enable CPU_PROFILER_PC_SAMPLE_ENABLED, run "cpu_pc start", exercise the use case then "cpu_pc dump".
+#
+
+import argparse
+import bisect
+import re
+import subprocess
+
+# MPI (NOR/NAND/PSRAM) mapped address ranges
+XIP_RANGES = ((0x10000000, 0x20000000), (0x60000000, 0x70000000))
+
+RE_BIN = re.compile(r'cpu_pc: 0x([0-9a-fA-F]+) (\d+)')
+RE_HDR = re.compile(r'cpu_pc: shift (\d+) samples (\d+) handler (\d+) dropped (\d+)')
+RE_MISS = re.compile(r'cpu_pc: icache_miss ([\d.]+) dcache_miss ([\d.]+)')
+
+
+def parse_log(path):
+    log = {'bins': {}, 'samples': 0, 'handler': 0, 'dropped': 0, 'imiss': None, 'dmiss': None}
+    with open(path, 'r', errors='ignore') as f:
+        for line in f:
+            m = RE_HDR.search(line)
+            if m:
+                # keep last dump of the log only
+                log['bins'] = {}
+                log['samples'], log['handler'], log['dropped'] = (int(x) for x in m.groups()[1:])
+                continue
+            m = RE_MISS.search(line)
+            if m:
+                log['imiss'], log['dmiss'] = (float(x) for x in m.groups())
+                continue
+            m = RE_BIN.search(line)
+            if m:
+                pc = int(m.group(1), 16)
+                log['bins'][pc] = log['bins'].get(pc, 0) + int(m.group(2))
+    return log
+
+
+def load_symbols(elf, nm):
+    out = subprocess.check_output([nm, '-S', '--defined-only', elf], universal_newlines=True)
+    syms = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 4 or fields[2] not in 'tTwW':
+            continue
+        addr = int(fields[0], 16) & ~1
+        size = int(fields[1], 16)
+        if size:
+            syms.append((addr, size, fields[3]))
+    syms.sort()
+    return syms
+
+
+def in_xip(addr):
+    return any(lo <= addr < hi for lo, hi in XIP_RANGES)
+
+
+def rank(log, syms):
+    starts = [s[0] for s in syms]
+    funcs = {}
+    xip = 0
+    for pc, count in log['bins'].items():
+        i = bisect.bisect_right(starts, pc) - 1
+        if i < 0 or pc >= syms[i][0] + syms[i][1]:
+            name, size = '0x%08x' % pc, 0
+        else:
+            name, size = syms[i][2], syms[i][1]
+        if in_xip(pc):
+            xip += count
+            f = funcs.setdefault(name, [0, size])
+            f[0] += count
+    ranked = sorted(funcs.items(), key=lambda x: -x[1][0])
+    return ranked, xip
+
+
+def select(ranked, budget):
+    sel = []
+    used = 0
+    for name, (count, size) in ranked:
+        if not size:
+            continue
+        if budget is not None and used + size > budget:
+            continue
+        sel.append((name, count, size))
+        used += size
+    return sel, used
+
+
+def write_ld(path, sel):
+    with open(path, 'w') as f:
+        f.write('/* generated by hot_func.py, hot XIP functions placed in RAM */\n')
+        for name, count, size in sel:
+            f.write('*(.text.%s)\n' % name)
+
+
+def write_sct(path, sel):
+    with open(path, 'w') as f:
+        f.write('; generated by hot_func.py, hot XIP functions placed in RAM\n')
+        for name, count, size in sel:
+            f.write('*.o (.text.%s)\n' % name)
+
+
+def report(tag, log, xip):
+    total = log['samples'] - log['handler']
+    share = xip * 100.0 / total if total else 0
+    print('%s: samples %d, thread %d, XIP %d (%.1f%%), dropped %d' %
+          (tag, log['samples'], total, xip, share, log['dropped']))
+    if log['imiss'] is not None:
+        print('%s: icache miss %.2f%%, dcache miss %.2f%%' % (tag, log['imiss'], log['dmiss']))
+    return share
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Rank hot XIP functions from cpu_pc dump')
+    parser.add_argument('elf')
+    parser.add_argument('log')
+    parser.add_argument('--budget', type=lambda x: int(x, 0), default=None)
+    parser.add_argument('--ld')
+    parser.add_argument('--sct')
+    parser.add_argument('--compare')
+    parser.add_argument('--nm', default='arm-none-eabi-nm')
+    parser.add_argument('--top', type=int, default=30)
+    args = parser.parse_args()
+
+    syms = load_symbols(args.elf, args.nm)
+    log = parse_log(args.log)
+    ranked, xip = rank(log, syms)
+    share = report('current', log, xip)
+
+    print('%4s %8s %6s %6s %8s  %s' % ('rank', 'samples', '%', 'cum%', 'size', 'function'))
+    cum = 0
+    for i, (name, (count, size)) in enumerate(ranked[:args.top]):
+        cum += count
+        print('%4d %8d %6.1f %6.1f %8d  %s' % (i + 1, count, count * 100.0 / max(xip, 1),
+                                               cum * 100.0 / max(xip, 1), size, name))
+
+    sel, used = select(ranked, args.budget)
+    if args.ld:
+        write_ld(args.ld, sel)
+    if args.sct:
+        write_sct(args.sct, sel)
+    if args.ld or args.sct:
+        hit = sum(c for _, c, _ in sel)
+        print('selected %d functions, %d bytes, %.1f%% of XIP samples' %
+              (len(sel), used, hit * 100.0 / max(xip, 1)))
+
+    if args.compare:
+        before = parse_log(args.compare)
+        _, before_xip = rank(before, syms)
+        before_share = report('before', before, before_xip)
+        print('XIP sample share %.1f%% -> %.1f%%' % (before_share, share))
+        if before['imiss'] is not None and log['imiss'] is not None:
+            print('icache miss %.2f%% -> %.2f%%' % (before['imiss'], log['imiss']))
+
+
+if __name__ == '__main__':
+    main()
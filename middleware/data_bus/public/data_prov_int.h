@@ -59,6 +59,23 @@
 ****************************************************************************************
 */
 
+/** Subscriber filter state, allocated when subscriber sets filter */
+typedef struct data_client_filter_tag
+{
+    datac_filter_t cfg;
+    struct rt_timer timer;      /*!<Timer to deliver coalesced message */
+    rt_tick_t last_tick;        /*!<Tick of last delivery */
+    int32_t   last_value;       /*!<Value of last delivery */
+    uint8_t   has_value;        /*!<last_value is valid */
+    uint8_t   has_sent;         /*!<last_tick is valid */
+    uint16_t  pend_msg_id;      /*!<Coalesced message waiting for interval expiry */
+    uint16_t  pend_len;
+    uint8_t  *pend_data;
+    uint32_t  sent_num;
+    uint32_t  drop_num;
+    uint32_t  merge_num;
+} data_client_filter_t;
+
 /** Data service client */
 typedef struct data_service_client_tag
 {
@@ -68,11 +85,14 @@ typedef struct data_service_client_tag
     uint8_t     service_id;         /*!<Service ID*/
     uint8_t    *user_data;
     data_req_t *config;
+    data_client_filter_t *filter;   /*!<Subscriber filter, NULL if not set*/
 } data_service_client_t;
 
 
 /** Data service */
 #define MAX_SVC_NAME_LEN        9
+/** Number of buckets of service message latency histogram, bucket n is for latency < (64us << n) */
+#define DATA_SVC_LAT_HIST_NUM   8
 typedef struct data_service_tag
 {
     bool active;                /*!<Service is active*/
@@ -83,8 +103,13 @@ typedef struct data_service_tag
     void **client_list;
     const struct data_service_config_tag *config;  /*!< service config */
     rt_list_t node;             /*!<List node */
+    uint8_t hash_next;          /*!<Next service ID in same name hash bucket, plus 1 */
     /// data fifo
     void *user_data;            /*!< User data of service */
+#if defined(RT_USING_FINSH) && !defined(LCPU_MEM_OPTIMIZE)
+    uint16_t lat_hist[DATA_SVC_LAT_HIST_NUM];   /*!<Latency histogram from queued to handled */
+    uint32_t lat_max;           /*!<Max latency in us */
+#endif
 } data_service_t;
 
 
@@ -45,6 +45,7 @@
 
 #include "rtdef.h"
 #include "rtthread.h"
+#include "rthw.h"
 #include "string.h"
 #include "data_service.h"
 #include "../public/data_prov_int.h"
@@ -61,6 +62,7 @@
     #include "ipc_queue.h"
 #endif /* !DS_MBOX_DISABLED */
 #include "mem_section.h"
+#include "sysview_trace.h"
 
 #define DBG_TAG           "DS"
 #define DBG_LVL           DBG_LOG
@@ -168,6 +170,9 @@ static struct rt_mutex g_data_service_mutex;
 
 
 static void *data_service_list[DATA_SERVICE_MAX_NUM];
+/* name hash index, service ID plus 1 of bucket head, chained by hash_next */
+#define DS_NAME_HASH_SIZE     (16)
+static uint8_t ds_name_hash[DS_NAME_HASH_SIZE];
 
 static rt_list_t data_service_db;
 
@@ -238,6 +243,38 @@ static inline void ds_ipc_exit_critical(void)
 }
 #endif /* DS_MBOX_DISABLED */
 
+#if defined(RT_USING_FINSH) && !defined(LCPU_MEM_OPTIMIZE)
+#define DS_LAT_STAT
+#define DS_STAMP_MASK       (0x3FFFFFFF)
+/* set bit0 so that 0 means no stamp */
+#define DS_STAMP_NOW()      (((HAL_GTIMER_READ() << 1) | 1) & DS_STAMP_MASK)
+
+static inline void ds_stamp_msg(data_msg_t *msg)
+{
+    msg->stamp = DS_STAMP_NOW();
+}
+
+static void ds_lat_record(data_service_t *service, data_msg_t *msg)
+{
+    uint32_t ticks;
+    uint32_t us;
+    uint32_t i;
+
+    if (!msg->stamp)
+        return;
+
+    ticks = ((DS_STAMP_NOW() - msg->stamp) & DS_STAMP_MASK) >> 1;
+    us = (uint32_t)((float)ticks * 1000000 / HAL_LPTIM_GetFreq());
+    for (i = 0; (i < DATA_SVC_LAT_HIST_NUM - 1) && (us >= (64UL << i)); i++);
+    if (service->lat_hist[i] < UINT16_MAX)
+        service->lat_hist[i]++;
+    if (us > service->lat_max)
+        service->lat_max = us;
+}
+#else
+#define ds_stamp_msg(msg)
+#endif /* RT_USING_FINSH && !LCPU_MEM_OPTIMIZE */
+
 static uint8_t **data_service_msg_body_ext(data_msg_t *msg)
 {
     uint8_t **body_ext;
@@ -255,6 +292,180 @@ static uint8_t **data_service_msg_body_ext(data_msg_t *msg)
 
 }
 
+#if defined(DATA_SVC_SHM_POOL) && !defined(DS_MBOX_DISABLED) && (defined(SOC_BF0_HCPU) || defined(SOC_BF0_LCPU))
+#define DS_SHM_ENABLED
+
+#ifndef DATA_SVC_SHM_BLK_SIZE
+    #define DATA_SVC_SHM_BLK_SIZE   (512)
+#endif
+#ifndef DATA_SVC_SHM_BLK_NUM
+    #define DATA_SVC_SHM_BLK_NUM    (8)
+#endif
+/* smaller body is cheaper to copy through ipc queue */
+#ifndef DATA_SVC_SHM_MIN_SIZE
+    #define DATA_SVC_SHM_MIN_SIZE   (128)
+#endif
+
+#define DS_SHM_LINE             (32)
+#define DS_SHM_STRIDE           (DS_SHM_LINE + RT_ALIGN(DATA_SVC_SHM_BLK_SIZE, DS_SHM_LINE))
+#define DS_SHM_BLK(idx)         (&ds_shm_pool[(idx) * DS_SHM_STRIDE])
+#define DS_SHM_PAYLOAD(idx)     (DS_SHM_BLK(idx) + DS_SHM_LINE)
+
+#ifdef SOC_BF0_HCPU
+    #define DS_SHM_PEER_ADDR(addr)  HCPU_ADDR_2_LCPU_ADDR(addr)
+#else
+    #define DS_SHM_PEER_ADDR(addr)  LCPU_ADDR_2_HCPU_ADDR(addr)
+#endif /* SOC_BF0_HCPU */
+
+/* Blocks are in RAM of owner core and accessed by other core through its alias address.
+ * First cache line of block holds ack counter which is written by other core only,
+ * all other state is in ds_shm_desc and written by owner core only,
+ * so that no cross core atomic operation is needed.
+ * Block is free if refs == rels + (ack - ack_base).
+ */
+typedef struct
+{
+    uint32_t refs;      /* references taken */
+    uint32_t rels;      /* references released by owner core */
+    uint32_t ack_base;  /* ack counter when allocated */
+} ds_shm_desc_t;
+
+ALIGN(DS_SHM_LINE)
+static uint8_t ds_shm_pool[DS_SHM_STRIDE * DATA_SVC_SHM_BLK_NUM];
+static ds_shm_desc_t ds_shm_desc[DATA_SVC_SHM_BLK_NUM];
+static uint16_t ds_shm_used;
+static uint16_t ds_shm_peak;
+static uint32_t ds_shm_fallback;
+
+static inline void ds_shm_clean(void *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    SCB_CleanDCache_by_Addr((uint32_t *)RT_ALIGN_DOWN((uint32_t)addr, DS_SHM_LINE),
+                            RT_ALIGN(size + ((uint32_t)addr & (DS_SHM_LINE - 1)), DS_SHM_LINE));
+#endif
+}
+
+static inline void ds_shm_invalidate(void *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    SCB_InvalidateDCache_by_Addr((uint32_t *)RT_ALIGN_DOWN((uint32_t)addr, DS_SHM_LINE),
+                                 RT_ALIGN(size + ((uint32_t)addr & (DS_SHM_LINE - 1)), DS_SHM_LINE));
+#endif
+}
+
+static inline volatile uint32_t *ds_shm_ack_ptr(uint8_t *payload)
+{
+    return (volatile uint32_t *)(payload - DS_SHM_LINE);
+}
+
+/* index of local block, -1 if ptr is not in pool */
+static int32_t ds_shm_index(const void *ptr)
+{
+    uint32_t off = (uint32_t)ptr - (uint32_t)ds_shm_pool;
+
+    if (((uint32_t)ptr < (uint32_t)ds_shm_pool) || (off >= sizeof(ds_shm_pool))
+            || ((off % DS_SHM_STRIDE) != DS_SHM_LINE))
+        return -1;
+
+    return off / DS_SHM_STRIDE;
+}
+
+static bool ds_shm_is_free(uint32_t idx)
+{
+    volatile uint32_t *ack = ds_shm_ack_ptr(DS_SHM_PAYLOAD(idx));
+    ds_shm_desc_t *desc = &ds_shm_desc[idx];
+
+    ds_shm_invalidate((void *)ack, sizeof(*ack));
+    return desc->refs == (desc->rels + (*ack - desc->ack_base));
+}
+
+static int32_t ds_shm_alloc_blk(uint32_t size)
+{
+    rt_base_t level;
+    int32_t idx = -1;
+
+    if (size > DATA_SVC_SHM_BLK_SIZE)
+        return -1;
+
+    level = rt_hw_interrupt_disable();
+    ds_shm_used = 0;
+    for (uint32_t i = 0; i < DATA_SVC_SHM_BLK_NUM; i++)
+    {
+        if (!ds_shm_is_free(i))
+        {
+            ds_shm_used++;
+        }
+        else if (idx < 0)
+        {
+            idx = i;
+        }
+    }
+    if (idx >= 0)
+    {
+        ds_shm_desc[idx].refs = 1;
+        ds_shm_desc[idx].rels = 0;
+        ds_shm_desc[idx].ack_base = *ds_shm_ack_ptr(DS_SHM_PAYLOAD(idx));
+        if (++ds_shm_used > ds_shm_peak)
+            ds_shm_peak = ds_shm_used;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return idx;
+}
+
+static void ds_shm_ref(uint32_t idx)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    ds_shm_desc[idx].refs++;
+    rt_hw_interrupt_enable(level);
+}
+
+static void ds_shm_unref(uint32_t idx)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    ds_shm_desc[idx].rels++;
+    rt_hw_interrupt_enable(level);
+}
+
+/* release block of other core, ptr is alias address got from message */
+static void ds_shm_ack(uint8_t *ptr)
+{
+    volatile uint32_t *ack = ds_shm_ack_ptr(ptr);
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    ds_shm_invalidate((void *)ack, sizeof(*ack));
+    (*ack)++;
+    ds_shm_clean((void *)ack, sizeof(*ack));
+    rt_hw_interrupt_enable(level);
+}
+
+void *data_service_shm_alloc(uint32_t size)
+{
+    int32_t idx = ds_shm_alloc_blk(size);
+
+    return (idx < 0) ? NULL : DS_SHM_PAYLOAD(idx);
+}
+
+void data_service_shm_free(void *ptr)
+{
+    int32_t idx = ds_shm_index(ptr);
+
+    RT_ASSERT(idx >= 0);
+    ds_shm_unref(idx);
+}
+#else
+void *data_service_shm_alloc(uint32_t size)
+{
+    return NULL;
+}
+
+void data_service_shm_free(void *ptr)
+{
+    RT_ASSERT(0);
+}
+#endif /* DATA_SVC_SHM_POOL && !DS_MBOX_DISABLED */
+
 static uint8_t *init_msg(data_msg_t *msg, uint16_t msgid, uint16_t src_cid, uint16_t dst_cid, uint16_t body_len)
 {
     uint8_t *body;
@@ -266,6 +477,8 @@ static uint8_t *init_msg(data_msg_t *msg, uint16_t msgid, uint16_t src_cid, uint
     msg->dst_cid = dst_cid;
     msg->len = body_len;
     msg->no_free = 0;
+    msg->shm = 0;
+    msg->stamp = 0;
     if (body_len > SHORT_DATA_MSG_BODY_THRESHOLD) //Long message body, save in allocated new memory.
     {
         uint8_t **body_ext = (uint8_t **)&msg->body[0];
@@ -293,6 +506,8 @@ static uint8_t *init_msg_no_copy(data_msg_t *msg, uint16_t msgid, uint16_t src_c
     msg->dst_cid = dst_cid;
     msg->len = body_len;
     msg->no_free = 0;
+    msg->shm = 0;
+    msg->stamp = 0;
     if (body_len > SHORT_DATA_MSG_BODY_THRESHOLD)
     {
         uint8_t **body_ext = (uint8_t **)&msg->body[0];
@@ -300,6 +515,14 @@ static uint8_t *init_msg_no_copy(data_msg_t *msg, uint16_t msgid, uint16_t src_c
         *body_ext = data;
         body = data;
         msg->no_free = 1;
+#ifdef DS_SHM_ENABLED
+        if (ds_shm_index(data) >= 0)
+        {
+            /* buffer from pool, message holds a reference until freed */
+            ds_shm_ref(ds_shm_index(data));
+            msg->no_free = 0;
+        }
+#endif /* DS_SHM_ENABLED */
     }
     else
     {
@@ -316,6 +539,20 @@ static void free_msg(data_msg_t *msg)
     uint8_t **body_ext;
 
     body_ext = data_service_msg_body_ext((data_msg_t *)msg);
+#ifdef DS_SHM_ENABLED
+    if (body_ext && msg->shm)
+    {
+        ds_shm_ack(*body_ext);
+        *body_ext = 0;
+        msg->shm = 0;
+    }
+    else if (body_ext && !msg->no_free && (ds_shm_index(*body_ext) >= 0))
+    {
+        ds_shm_unref(ds_shm_index(*body_ext));
+        *body_ext = 0;
+    }
+    else
+#endif /* DS_SHM_ENABLED */
     if (body_ext && !msg->no_free)
     {
         rt_free(*body_ext);
@@ -339,80 +576,154 @@ static int32_t send_msg(data_msg_t *msg)
 #endif
 #endif /* !DATA_SVC_PROC_THREAD_DISABLED */
 
+#ifdef DS_SHM_ENABLED
+/* send long message body by handle, -RT_EFULL if pool is exhausted */
+static rt_err_t ds_shm_send_proxy(data_msg_t *msg)
+{
+    uint8_t *data = data_service_get_msg_body(msg);
+    uint8_t *payload;
+    data_msg_t hdr;
+    ipc_queue_iovec_t iov;
+    rt_size_t len;
+    int32_t idx;
+
+    idx = ds_shm_index(data);
+    if (idx >= 0)
+    {
+        /* already in pool, take a reference for other core */
+        ds_shm_ref(idx);
+    }
+    else
+    {
+        idx = ds_shm_alloc_blk(msg->len);
+        if (idx < 0)
+        {
+            ds_shm_fallback++;
+            return -RT_EFULL;
+        }
+        memcpy(DS_SHM_PAYLOAD(idx), data, msg->len);
+    }
+    payload = DS_SHM_PAYLOAD(idx);
+    ds_shm_clean(payload, msg->len);
+
+    hdr = *msg;
+    hdr.shm = 1;
+    hdr.no_free = 0;
+    *(uint8_t **)&hdr.body[0] = (uint8_t *)DS_SHM_PEER_ADDR((uint32_t)payload);
+    iov.base = &hdr;
+    iov.len = sizeof(hdr);
+
+    ds_ipc_enter_critical();
+    len = ipc_queue_writev(g_proxy, &iov, 1, 1000);
+    RT_ASSERT(len == sizeof(hdr));
+    ds_ipc_exit_critical();
+
+    /* drop reference or heap copy owned by message */
+    free_msg(msg);
+    if (len != sizeof(hdr))
+    {
+        ds_shm_unref(idx);
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+#endif /* DS_SHM_ENABLED */
+
 // cid: receive connection id
 static rt_err_t data_send_proxy(data_msg_t *msg)
 {
 #ifndef DS_MBOX_DISABLED
     rt_size_t len;
-    uint8_t *body;
+    rt_size_t total_len;
+    ipc_queue_iovec_t iov[2];
+    uint32_t iov_cnt;
 
     if (IPC_QUEUE_INVALID_HANDLE == g_proxy)
     {
         return -RT_ERROR;
     }
 
-    ds_ipc_enter_critical();
-
-    len = ipc_queue_write(g_proxy, msg, sizeof(*msg), 1000);
-    RT_ASSERT(len == sizeof(*msg));
-    if (len != sizeof(*msg))
+#ifdef DS_SHM_ENABLED
+    if (data_service_msg_body_ext(msg) && (msg->len >= DATA_SVC_SHM_MIN_SIZE))
     {
-        free_msg(msg);
-        goto __ERROR;
+        rt_err_t result = ds_shm_send_proxy(msg);
+
+        if (-RT_EFULL != result)
+            return result;
+        /* pool exhausted, copy through ipc queue */
     }
+#endif /* DS_SHM_ENABLED */
+    msg->shm = 0;
 
+    iov[0].base = msg;
+    iov[0].len = sizeof(*msg);
+    iov_cnt = 1;
     if (data_service_msg_body_ext((data_msg_t *)msg))
     {
-        body = data_service_get_msg_body((data_msg_t *)msg);
-        RT_ASSERT(RT_NULL != body);
-        /* workaround: as unknonwn reason, HCPU wakeup time is ~700ms */
-        len = ipc_queue_write(g_proxy, body, msg->len, 1000);
-        RT_ASSERT(len == msg->len);
-        free_msg(msg);
+        iov[1].base = data_service_get_msg_body((data_msg_t *)msg);
+        iov[1].len = msg->len;
+        RT_ASSERT(RT_NULL != iov[1].base);
+        iov_cnt++;
+    }
+    total_len = iov[0].len + ((iov_cnt > 1) ? iov[1].len : 0);
 
-        if (len != msg->len)
-        {
-            goto __ERROR;
-        }
+    ds_ipc_enter_critical();
+
+    /* header and body go out as one frame with one mailbox interrupt,
+     * workaround: as unknonwn reason, HCPU wakeup time is ~700ms */
+    len = ipc_queue_writev(g_proxy, iov, iov_cnt, 1000);
+    RT_ASSERT(len == total_len);
+    if ((iov_cnt > 1) || (len != total_len))
+    {
+        free_msg(msg);
     }
 
     ds_ipc_exit_critical();
 
-    return RT_EOK;
+    if (len != total_len)
+    {
+        return -RT_ERROR;
+    }
 
-__ERROR:
+    return RT_EOK;
 
-    ds_ipc_exit_critical();
+#else
 
+    return -RT_ERROR;
 #endif /* !DS_MBOX_DISABLED */
+}
 
-    return -RT_ERROR;
+static uint32_t ds_name_hash_idx(const char *name)
+{
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a over significant part of name */
+    for (uint32_t i = 0; (i < MAX_SVC_NAME_LEN - 1) && name[i]; i++)
+    {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+
+    return hash & (DS_NAME_HASH_SIZE - 1);
 }
 
 static data_service_t *find_service(char *name)
 {
     data_service_t *service;
-    bool found = false;
-
-    /* try to find device object */
+    uint8_t id;
 
-    rt_list_t *iter;
-    rt_list_for_each(iter, &data_service_db)
+    id = ds_name_hash[ds_name_hash_idx(name)];
+    while (id)
     {
-        service = rt_list_entry(iter, data_service_t, node);
+        service = data_service_list[id - 1];
         if (rt_strncmp(service->name, name, MAX_SVC_NAME_LEN - 1) == 0)
         {
-            found = true;
-            break;
+            return service;
         }
+        id = service->hash_next;
     }
 
-    if (!found)
-    {
-        service = NULL;
-    }
-
-    return service;
+    return NULL;
 }
 
 
@@ -451,6 +762,14 @@ static data_service_t *add_service(const char *name, data_service_config_t *conf
     service->id = serv_id;
     service->last_clnt = 0;
 
+    /* add to name hash index */
+    service->hash_next = ds_name_hash[ds_name_hash_idx(service->name)];
+    ds_name_hash[ds_name_hash_idx(service->name)] = serv_id + 1;
+#if defined(RT_USING_FINSH) && !defined(LCPU_MEM_OPTIMIZE)
+    memset(service->lat_hist, 0, sizeof(service->lat_hist));
+    service->lat_max = 0;
+#endif
+
     return service;
 }
 
@@ -491,11 +810,14 @@ static rt_err_t forward_msg(data_service_t *service, data_msg_t *msg)
 
     if (queue)
     {
+        ds_stamp_msg(msg);
         result = rt_mq_send(queue, msg, sizeof(*msg));
     }
     else
     {
+        SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DATASRV, service->id, msg->msg_id);
         service->config->msg_handler(service, (data_msg_t *)msg);
+        SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DATASRV);
         free_msg(msg);
         result = RT_EOK;
     }
@@ -504,6 +826,270 @@ static rt_err_t forward_msg(data_service_t *service, data_msg_t *msg)
 }
 
 
+/* internal message to ds_proc thread, deliver coalesced message of client */
+#define DS_FILTER_FLUSH_IND     (RSP_MSG_TYPE | MSG_SERVICE_FILTER_REQ)
+
+static rt_err_t dispatch_msg(data_msg_t *msg);
+
+static bool ds_filter_get_value(const datac_filter_t *cfg, uint32_t len, const uint8_t *data, int32_t *value)
+{
+    int16_t v16;
+
+    if (!cfg->threshold || ((uint32_t)cfg->value_offset + cfg->value_size > len))
+        return false;
+
+    data += cfg->value_offset;
+    switch (cfg->value_size)
+    {
+    case 1:
+        *value = (int8_t)data[0];
+        break;
+    case 2:
+        memcpy(&v16, data, sizeof(v16));
+        *value = v16;
+        break;
+    case 4:
+        memcpy(value, data, sizeof(*value));
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+/* check change threshold, update last delivery if message is to be sent */
+static bool ds_filter_send(data_client_filter_t *filter, uint32_t len, const uint8_t *data)
+{
+    int32_t value;
+    bool valid;
+
+    valid = ds_filter_get_value(&filter->cfg, len, data, &value);
+    if (valid && filter->has_value)
+    {
+        uint32_t diff;
+
+        diff = (value > filter->last_value) ? (uint32_t)value - (uint32_t)filter->last_value
+               : (uint32_t)filter->last_value - (uint32_t)value;
+        if (diff < filter->cfg.threshold)
+        {
+            filter->drop_num++;
+            return false;
+        }
+    }
+
+    if (valid)
+    {
+        filter->last_value = value;
+        filter->has_value = 1;
+    }
+    filter->last_tick = rt_tick_get();
+    filter->has_sent = 1;
+    filter->sent_num++;
+
+    return true;
+}
+
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+static void ds_filter_timeout(void *param)
+{
+    data_msg_t msg;
+
+    /* only post to ds_proc as provider may be on different thread and service lock is a mutex */
+    init_msg(&msg, DS_FILTER_FLUSH_IND, 0, (uint16_t)(rt_ubase_t)param, 0);
+    if (RT_EOK != rt_mq_send(g_ds_queue, &msg, sizeof(msg)))
+        LOG_D("filter flush %x lost", (rt_ubase_t)param);
+}
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+
+/* save message to be delivered when interval expires, latest one wins */
+static void ds_filter_pend(data_client_filter_t *filter, uint16_t msg_id, uint32_t len,
+                           const uint8_t *data, rt_tick_t wait)
+{
+    if (filter->pend_data && (filter->pend_len != len))
+    {
+        rt_free(filter->pend_data);
+        filter->pend_data = NULL;
+    }
+    else if (filter->pend_data)
+    {
+        filter->merge_num++;
+    }
+
+    if (!filter->pend_data)
+    {
+        filter->pend_data = rt_malloc(len ? len : 1);
+        if (!filter->pend_data)
+        {
+            filter->drop_num++;
+            return;
+        }
+    }
+    memcpy(filter->pend_data, data, len);
+    filter->pend_len = len;
+    filter->pend_msg_id = msg_id;
+
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+    if (!(filter->timer.parent.flag & RT_TIMER_FLAG_ACTIVATED))
+    {
+        if (wait == 0)
+            wait = 1;
+        rt_timer_control(&filter->timer, RT_TIMER_CTRL_SET_TIME, &wait);
+        rt_timer_start(&filter->timer);
+    }
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+}
+
+/* called with ds_enter_critical, return true if message is to be sent to client now */
+static bool ds_filter_check(data_service_client_t *client, uint16_t msg_id, uint32_t len, const uint8_t *data)
+{
+    data_client_filter_t *filter = client->filter;
+    uint16_t bit;
+
+    if (!filter)
+        return true;
+
+    bit = (uint16_t)(GET_MSG_ID(msg_id) - GET_MSG_ID(filter->cfg.msg_id_base));
+    if (filter->cfg.msg_mask
+            && ((bit >= DATA_FILTER_MSG_MASK_BITS) || !(filter->cfg.msg_mask & (1UL << bit))))
+    {
+        filter->drop_num++;
+        return false;
+    }
+
+    if (filter->cfg.min_interval_ms && filter->has_sent)
+    {
+        rt_tick_t interval = rt_tick_from_millisecond(filter->cfg.min_interval_ms);
+        rt_tick_t elapsed = rt_tick_get() - filter->last_tick;
+
+        if (elapsed < interval)
+        {
+            ds_filter_pend(filter, msg_id, len, data, interval - elapsed);
+            return false;
+        }
+    }
+
+    if (filter->pend_data)
+    {
+        /* newer message replaces coalesced one, timer would find nothing to send */
+        rt_free(filter->pend_data);
+        filter->pend_data = NULL;
+        filter->merge_num++;
+    }
+
+    return ds_filter_send(filter, len, data);
+}
+
+static void ds_filter_free(data_service_client_t *client)
+{
+    data_client_filter_t *filter = client->filter;
+
+    if (!filter)
+        return;
+
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+    rt_timer_detach(&filter->timer);
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+    if (filter->pend_data)
+        rt_free(filter->pend_data);
+    rt_free(filter);
+    client->filter = NULL;
+}
+
+/* handle MSG_SERVICE_FILTER_REQ at provider side */
+static void ds_set_filter_int(data_msg_t *msg)
+{
+    data_service_t *service;
+    data_service_client_t *client = NULL;
+    data_client_filter_t *filter;
+    uint8_t conn_id;
+
+    service = get_service(GET_ROUT_ID_SERV_ID(msg->dst_cid));
+    RT_ASSERT(service);
+    conn_id = GET_ROUT_ID_CONN_ID(msg->dst_cid);
+
+    ds_enter_critical();
+    if (conn_id < service->config->max_client_num)
+        client = service->client_list[conn_id];
+
+    if (!client || (msg->len < sizeof(datac_filter_t)))
+    {
+        /* client unsubscribed already or filter is removed */
+        if (client)
+            ds_filter_free(client);
+        ds_exit_critical();
+        return;
+    }
+
+    filter = client->filter;
+    if (!filter)
+    {
+        filter = rt_malloc(sizeof(*filter));
+        if (!filter)
+        {
+            ds_exit_critical();
+            LOG_D("filter of %s %d: no memory", service->name, conn_id);
+            return;
+        }
+        memset(filter, 0, sizeof(*filter));
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+        rt_timer_init(&filter->timer, "dsflt", ds_filter_timeout,
+                      (void *)(rt_ubase_t)MAKE_ROUT_ID(conn_id, service->id), 1,
+                      RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+        client->filter = filter;
+    }
+    memcpy(&filter->cfg, data_service_get_msg_body(msg), sizeof(filter->cfg));
+    filter->has_value = 0;
+    filter->has_sent = 0;
+    ds_exit_critical();
+}
+
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+/* deliver coalesced message in ds_proc thread */
+static void ds_filter_flush(data_service_t *service, uint8_t conn_id)
+{
+    data_service_client_t *client = NULL;
+    data_client_filter_t *filter;
+    data_msg_t msg;
+    uint8_t *data = NULL;
+    uint8_t *body;
+    uint16_t len = 0;
+    uint16_t msg_id = 0;
+    uint16_t src_cid = 0;
+
+    ds_enter_critical();
+    if (conn_id < service->config->max_client_num)
+        client = service->client_list[conn_id];
+    filter = client ? client->filter : NULL;
+    if (filter && filter->pend_data)
+    {
+        data = filter->pend_data;
+        len = filter->pend_len;
+        msg_id = filter->pend_msg_id;
+        filter->pend_data = NULL;
+        if (ds_filter_send(filter, len, data))
+        {
+            src_cid = client->src_cid;
+        }
+        else
+        {
+            rt_free(data);
+            data = NULL;
+        }
+    }
+    ds_exit_critical();
+
+    if (data)
+    {
+        body = init_msg(&msg, msg_id, MAKE_ROUT_ID(conn_id, service->id), src_cid, len);
+        memcpy(body, data, len);
+        rt_free(data);
+        dispatch_msg(&msg);
+    }
+}
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+
 static rt_err_t dispatch_msg(data_msg_t *msg)
 {
     rt_err_t result;
@@ -515,6 +1101,12 @@ static rt_err_t dispatch_msg(data_msg_t *msg)
         // service at other side
         result = data_send_proxy(msg);
     }
+    else if (MSG_SERVICE_FILTER_REQ == msg->msg_id)
+    {
+        ds_set_filter_int(msg);
+        free_msg(msg);
+        result = RT_EOK;
+    }
     else
     {
         service = get_service(GET_ROUT_ID_SERV_ID(msg->dst_cid));
@@ -559,6 +1151,7 @@ static uint8_t add_clnt(data_service_t *service, uint16_t src_cid)
     client->conn_id = conn_id;
     client->user_data = NULL;
     client->config = NULL;
+    client->filter = NULL;
 
     /* add client */
     rt_list_init(&client->node);
@@ -585,6 +1178,7 @@ static rt_err_t del_clnt(data_service_t *service, uint8_t conn_id)
 
     if (removed_client->config)
         rt_free(removed_client->config);
+    ds_filter_free(removed_client);
     rt_list_remove(&removed_client->node);
     rt_free(removed_client);
 
@@ -858,6 +1452,8 @@ static void handle_proxy_msg(data_msg_t *msg)
 
     /* pointer in long message from other core should always be freed */
     msg->no_free = 0;
+    /* time of other core is not comparable */
+    msg->stamp = 0;
 
     switch (msg->msg_id)
     {
@@ -871,6 +1467,12 @@ static void handle_proxy_msg(data_msg_t *msg)
         datac_unsubscribe_int(msg);
         break;
     }
+    case MSG_SERVICE_FILTER_REQ:
+    {
+        ds_set_filter_int(msg);
+        free_msg(msg);
+        break;
+    }
     default:
     {
         service = get_service(GET_ROUT_ID_SERV_ID(msg->dst_cid));
@@ -886,6 +1488,7 @@ static void handle_proxy_msg(data_msg_t *msg)
             queue = g_ds_queue;
         }
 
+        ds_stamp_msg(msg);
         result = rt_mq_send(queue, msg, sizeof(*msg));
         RT_ASSERT(RT_EOK == result);
     }
@@ -945,6 +1548,15 @@ static rt_uint32_t data_proxy_process(void)
         if (total_read_len == sizeof(msg))
         {
             body_ext = data_service_msg_body_ext((data_msg_t *)&msg);
+#ifdef DS_SHM_ENABLED
+            if (body_ext && msg.shm)
+            {
+                /* body is in pool of other core, released by free_msg */
+                ds_shm_invalidate(*body_ext, msg.len);
+                total_read_len = 0;
+            }
+            else
+#endif /* DS_SHM_ENABLED */
             if (body_ext)
             {
                 body = rt_malloc(msg.len);
@@ -1143,7 +1755,19 @@ void data_service_entry(void *param)
 
         service = get_service(GET_ROUT_ID_SERV_ID(msg.dst_cid));
         RT_ASSERT(service);
-        service->config->msg_handler(service, (data_msg_t *)&msg);
+#ifndef DATA_SVC_PROC_THREAD_DISABLED
+        if (DS_FILTER_FLUSH_IND == msg.msg_id)
+            ds_filter_flush(service, GET_ROUT_ID_CONN_ID(msg.dst_cid));
+        else
+#endif /* !DATA_SVC_PROC_THREAD_DISABLED */
+        {
+#ifdef DS_LAT_STAT
+            ds_lat_record(service, &msg);
+#endif /* DS_LAT_STAT */
+            SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DATASRV, service->id, msg.msg_id);
+            service->config->msg_handler(service, (data_msg_t *)&msg);
+            SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DATASRV);
+        }
 
         free_msg(&msg);
     }
@@ -1438,6 +2062,29 @@ __ERR:
     return -RT_ERROR;
 }
 
+rt_err_t datac_set_filter(datac_handle_t handle, const datac_filter_t *filter)
+{
+    data_msg_t msg;
+    data_connection_t *conn;
+    uint8_t *body;
+    uint8_t cid;
+
+    if (!is_valid_handle(handle))
+    {
+        return -RT_ERROR;
+    }
+
+    cid = DS_CLIENT_HANDLE_2_CID(handle);
+    conn = get_conn(cid);
+
+    body = init_msg(&msg, MSG_SERVICE_FILTER_REQ, MAKE_SYSTEM_SERV_ROUT_ID(cid), conn->dst_cid,
+                    filter ? sizeof(*filter) : 0);
+    if (filter)
+        memcpy(body, filter, sizeof(*filter));
+
+    return dispatch_msg(&msg);
+}
+
 rt_err_t datac_send_msg(datac_handle_t handle, data_msg_t *msg)
 {
     rt_err_t result = RT_EOK;
@@ -1760,6 +2407,8 @@ int32_t datas_push_msg_to_client(datas_handle_t svc, uint16_t msg_id, uint32_t l
             send = service->config->data_filter(client->config, msg_id, len, data);
         else
             send = true;
+        if (send)
+            send = ds_filter_check(client, msg_id, len, data);
 
         if (send)
         {
@@ -1824,6 +2473,8 @@ int32_t datas_push_msg_to_client_no_copy(datas_handle_t svc, uint16_t msg_id, ui
             send = service->config->data_filter(client->config, msg_id, len, data);
         else
             send = true;
+        if (send)
+            send = ds_filter_check(client, msg_id, len, data);
 
         if (send)
         {
@@ -2003,6 +2654,10 @@ void list_data_service_summary(void)
         LOG_D("[%02d]  %-10s %d ",
               service->id, serv_name, client_num);
     }
+#ifdef DS_SHM_ENABLED
+    LOG_D("shm pool: %d x %d, used %d, peak %d, fallback %d", DATA_SVC_SHM_BLK_NUM, DATA_SVC_SHM_BLK_SIZE,
+          ds_shm_used, ds_shm_peak, ds_shm_fallback);
+#endif /* DS_SHM_ENABLED */
 }
 
 void list_data_service_detail(char *serv_name)
@@ -2028,8 +2683,18 @@ void list_data_service_detail(char *serv_name)
     rt_list_for_each(iter, (&service->clients))
     {
         client = rt_list_entry(iter, data_service_client_t, node);
-        LOG_D("[%02d]   %04x ", client->conn_id, client->src_cid);
+        if (client->filter)
+            LOG_D("[%02d]   %04x    filter: sent %d, drop %d, merge %d", client->conn_id, client->src_cid,
+                  client->filter->sent_num, client->filter->drop_num, client->filter->merge_num);
+        else
+            LOG_D("[%02d]   %04x ", client->conn_id, client->src_cid);
     }
+
+    LOG_D("-------------- ");
+    LOG_D("latency(us) <64 <128 <256 <512 <1k <2k <4k >=4k, max %d", service->lat_max);
+    LOG_D("            %d %d %d %d %d %d %d %d",
+          service->lat_hist[0], service->lat_hist[1], service->lat_hist[2], service->lat_hist[3],
+          service->lat_hist[4], service->lat_hist[5], service->lat_hist[6], service->lat_hist[7]);
 }
 
 
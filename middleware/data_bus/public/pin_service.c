@@ -70,6 +70,46 @@
 #define GET_ID_FROM_ARG(arg)   ((uint16_t) (((rt_uint32_t)arg) & 0xFFFF ))
 #define GET_FLAG_FROM_ARG(arg) ((uint16_t) ((((rt_uint32_t)arg)>>16) & 0xFFFF ))
 
+#ifndef PIN_SERVICE_BATCH_SLOT_NUM
+    #define PIN_SERVICE_BATCH_SLOT_NUM  (4)
+#endif
+
+#ifndef PIN_SERVICE_BATCH_DEFAULT_MS
+    #define PIN_SERVICE_BATCH_DEFAULT_MS  (20)
+#endif
+
+#define PIN_SERVICE_BATCH_MASK  (PIN_SERVICE_FLAG_BATCH | PIN_SERVICE_FLAG_QUAD)
+
+/* Edges of batch pin are recorded here in ISR and pushed by timer, instead of one message per edge */
+typedef struct
+{
+    uint16_t pin;
+    uint16_t pin_b;
+    uint16_t flag;
+    uint16_t batch_ms;
+    uint8_t in_use;
+    uint8_t pending;            //Timer started or DATA_RDY_IND sent, cleared when pushed
+    uint8_t quad_state;         //Last (A << 1 | B)
+    uint16_t wr;
+    uint16_t rd;
+    uint32_t edges;
+    int32_t quad_steps;
+    uint32_t last_push;         //ms
+    struct rt_timer timer;
+    pin_edge_event_t fifo[PIN_SERVICE_BATCH_FIFO_LEN];
+} pin_batch_slot_t;
+
+static pin_batch_slot_t batch_slot[PIN_SERVICE_BATCH_SLOT_NUM];
+
+/* Indexed by (last state << 2 | new state), state is (A << 1 | B), +1 if A leads B */
+static const int8_t quad_table[16] =
+{
+    0, -1,  1,  0,
+    1,  0,  0, -1,
+    -1,  0,  0,  1,
+    0,  1, -1,  0,
+};
+
 static datas_handle_t this_service = NULL;
 static bool service_filter(data_req_t *config, uint16_t msg_id, uint32_t len, uint8_t *data)
 {
@@ -77,6 +117,7 @@ static bool service_filter(data_req_t *config, uint16_t msg_id, uint32_t len, ui
     switch (msg_id)
     {
     case MSG_SERVICE_DATA_NTF_IND:
+    case PIN_MSG_BATCH_IND:
     {
         pin_config_msg_t *p_config = (pin_config_msg_t *)&config->data[0];
         RT_ASSERT(p_config != NULL);
@@ -111,6 +152,161 @@ static void pin_irq_handler(void *arg)
     datas_data_ready(this_service, sizeof(uint8_t *), (uint8_t *)arg);
 }
 
+static pin_batch_slot_t *batch_slot_find(uint16_t pin)
+{
+    for (uint32_t i = 0; i < PIN_SERVICE_BATCH_SLOT_NUM; i++)
+    {
+        if (batch_slot[i].in_use && (batch_slot[i].pin == pin))
+            return &batch_slot[i];
+    }
+    return NULL;
+}
+
+static void batch_timeout(void *parameter)
+{
+    pin_batch_slot_t *slot = (pin_batch_slot_t *)parameter;
+    uint32_t arg = TO_ARGUMENT(slot->pin, PIN_SERVICE_FLAG_BATCH);
+
+    datas_data_ready(this_service, sizeof(uint8_t *), (uint8_t *)arg);
+}
+
+static void pin_batch_irq_handler(void *arg)
+{
+    pin_batch_slot_t *slot = (pin_batch_slot_t *)arg;
+    uint32_t now = rt_tick_get_millisecond();
+    uint8_t level = rt_pin_read(slot->pin);
+
+    if (slot->flag & PIN_SERVICE_FLAG_QUAD)
+    {
+        uint8_t state = (level << 1) | (rt_pin_read(slot->pin_b) & 1);
+
+        slot->quad_steps += quad_table[(slot->quad_state << 2) | state];
+        slot->quad_state = state;
+    }
+
+    slot->edges++;
+    if ((uint16_t)(slot->wr - slot->rd) < PIN_SERVICE_BATCH_FIFO_LEN)
+    {
+        pin_edge_event_t *ev = &slot->fifo[slot->wr % PIN_SERVICE_BATCH_FIFO_LEN];
+
+        ev->timestamp = now;
+        ev->level = level;
+        slot->wr++;
+    }
+
+    if (slot->pending)
+        return;
+    slot->pending = 1;
+
+    /* Wakeup fast path, first edge after idle is pushed without waiting batch_ms */
+    if ((slot->flag & PIN_SERVICE_FLAG_BATCH_LEAD) && ((now - slot->last_push) >= slot->batch_ms))
+        batch_timeout(slot);
+    else
+        rt_timer_start(&slot->timer);
+}
+
+static void batch_push(datas_handle_t service, pin_batch_slot_t *slot)
+{
+    /* Service thread is the only consumer, so static buffer is safe */
+    static uint8_t buf[sizeof(pin_batch_msg_t) + sizeof(pin_edge_event_t) * PIN_SERVICE_BATCH_FIFO_LEN];
+    pin_batch_msg_t *batch = (pin_batch_msg_t *)buf;
+    rt_base_t level;
+    uint16_t num;
+
+    level = rt_hw_interrupt_disable();
+    num = slot->wr - slot->rd;
+    for (uint16_t i = 0; i < num; i++)
+        batch->event[i] = slot->fifo[(slot->rd + i) % PIN_SERVICE_BATCH_FIFO_LEN];
+    slot->rd = slot->wr;
+    batch->edges = slot->edges;
+    batch->quad_steps = slot->quad_steps;
+    slot->edges = 0;
+    slot->quad_steps = 0;
+    slot->pending = 0;
+    slot->last_push = rt_tick_get_millisecond();
+    rt_hw_interrupt_enable(level);
+
+    batch->id = slot->pin;
+    batch->num = num;
+    LOG_D("batch pin=%d, edges=%d, num=%d, steps=%d\n", slot->pin, batch->edges, num, batch->quad_steps);
+    datas_push_msg_to_client(service, PIN_MSG_BATCH_IND,
+                             sizeof(pin_batch_msg_t) + sizeof(pin_edge_event_t) * num, buf);
+}
+
+static void batch_slot_free(pin_batch_slot_t *slot)
+{
+    rt_pin_detach_irq(slot->pin);
+    if (slot->flag & PIN_SERVICE_FLAG_QUAD)
+        rt_pin_detach_irq(slot->pin_b);
+    rt_timer_stop(&slot->timer);
+    rt_timer_detach(&slot->timer);
+    slot->in_use = 0;
+}
+
+static rt_err_t batch_config(pin_config_msg_t *p_config)
+{
+    pin_batch_slot_t *slot = batch_slot_find(p_config->id);
+    uint8_t irq_mode = p_config->irq_mode;
+    rt_err_t result;
+
+    if (slot)
+    {
+        batch_slot_free(slot);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < PIN_SERVICE_BATCH_SLOT_NUM; i++)
+        {
+            if (!batch_slot[i].in_use)
+            {
+                slot = &batch_slot[i];
+                break;
+            }
+        }
+        if (!slot)
+        {
+            LOG_E("no batch slot for pin %d\n", p_config->id);
+            return -RT_EFULL;
+        }
+    }
+
+    memset(slot, 0, sizeof(*slot));
+    slot->pin = p_config->id;
+    slot->flag = p_config->flag;
+    slot->batch_ms = p_config->batch_ms ? p_config->batch_ms : PIN_SERVICE_BATCH_DEFAULT_MS;
+    slot->last_push = rt_tick_get_millisecond() - slot->batch_ms;
+    rt_timer_init(&slot->timer, "pin_b", batch_timeout, slot, rt_tick_from_millisecond(slot->batch_ms),
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+
+    if (slot->flag & PIN_SERVICE_FLAG_QUAD)
+    {
+        RT_ASSERT(PIN_BELONG_THIS_CORE(p_config->pin_b));
+        slot->pin_b = p_config->pin_b;
+        rt_pin_mode(slot->pin_b, p_config->mode);
+        slot->quad_state = ((rt_pin_read(slot->pin) & 1) << 1) | (rt_pin_read(slot->pin_b) & 1);
+        /* Every transition of both phases is decoded */
+        irq_mode = PIN_IRQ_MODE_RISING_FALLING;
+        result = rt_pin_attach_irq(slot->pin_b, irq_mode, pin_batch_irq_handler, (void *)slot);
+        if (RT_EOK != result)
+        {
+            rt_timer_detach(&slot->timer);
+            return result;
+        }
+    }
+
+    result = rt_pin_attach_irq(slot->pin, irq_mode, pin_batch_irq_handler, (void *)slot);
+    if (RT_EOK == result)
+        slot->in_use = 1;
+    else
+    {
+        if (slot->flag & PIN_SERVICE_FLAG_QUAD)
+            rt_pin_detach_irq(slot->pin_b);
+        rt_timer_detach(&slot->timer);
+    }
+
+    return result;
+}
+
 
 
 
@@ -130,7 +326,7 @@ static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
 
     case MSG_SERVICE_CONFIG_REQ:
     {
-        rt_err_t result;
+        rt_err_t result = RT_EOK;
         data_req_t *req = (data_req_t *)data_service_get_msg_body(msg);
         pin_config_msg_t *p_config = (pin_config_msg_t *)&req->data[0];
         RT_ASSERT(p_config != NULL);
@@ -138,9 +334,17 @@ static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
 
         rt_pin_mode(p_config->id, p_config->mode);
 
-        if (p_config->flag & PIN_SERVICE_FLAG_SET_IRQ_MODE)
+        if ((p_config->flag & PIN_SERVICE_FLAG_SET_IRQ_MODE) && (p_config->flag & PIN_SERVICE_BATCH_MASK))
         {
+            result = batch_config(p_config);
+        }
+        else if (p_config->flag & PIN_SERVICE_FLAG_SET_IRQ_MODE)
+        {
+            pin_batch_slot_t *slot = batch_slot_find(p_config->id);
             uint32_t arg = TO_ARGUMENT(p_config->id, p_config->flag);
+
+            if (slot)
+                batch_slot_free(slot);
             result = rt_pin_attach_irq(p_config->id, p_config->irq_mode, pin_irq_handler, (void *)arg);
         }
 
@@ -157,6 +361,16 @@ static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
         pin  =  GET_ID_FROM_ARG(data_ind->data);
         RT_ASSERT(PIN_BELONG_THIS_CORE(pin));
 
+        if (GET_FLAG_FROM_ARG(data_ind->data) & PIN_SERVICE_FLAG_BATCH)
+        {
+            pin_batch_slot_t *slot = batch_slot_find(pin);
+
+            /* Slot may be detached after timer fired */
+            if (slot)
+                batch_push(service, slot);
+            break;
+        }
+
         pin_common_msg_t push_msg;
 
         push_msg.id = pin;
@@ -180,12 +394,15 @@ static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
         memcpy(&pin_msg, p_pin_msg, sizeof(pin_msg));
         RT_ASSERT(PIN_BELONG_THIS_CORE(pin_msg.id));
 
+        pin_batch_slot_t *slot = batch_slot_find(pin_msg.id);
 
         switch (msg->msg_id)
         {
         case PIN_MSG_ENABLE_IRQ_REQ:
         {
             result = rt_pin_irq_enable(pin_msg.id, 1);
+            if (slot && (slot->flag & PIN_SERVICE_FLAG_QUAD))
+                rt_pin_irq_enable(slot->pin_b, 1);
             datas_send_response(service, msg, result);
             break;
         }
@@ -193,13 +410,21 @@ static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
         case PIN_MSG_DISABLE_IRQ_REQ:
         {
             result = rt_pin_irq_enable(pin_msg.id, 0);
+            if (slot && (slot->flag & PIN_SERVICE_FLAG_QUAD))
+                rt_pin_irq_enable(slot->pin_b, 0);
             datas_send_response(service, msg, result);
             break;
         }
 
         case PIN_MSG_DETACH_IRQ_REQ:
         {
-            result = rt_pin_detach_irq(pin_msg.id);
+            if (slot)
+            {
+                batch_slot_free(slot);
+                result = RT_EOK;
+            }
+            else
+                result = rt_pin_detach_irq(pin_msg.id);
             datas_send_response(service, msg, result);
             break;
         }
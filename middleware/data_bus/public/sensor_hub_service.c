@@ -0,0 +1,587 @@
+/**
+  ******************************************************************************
+  * @file   sensor_hub_service.c
+  * @author Sifli software development team
+  * @brief  Sensor hub, preprocess sensor data and deliver batched results to subscribers.
+  *
+* *****************************************************************************
+**/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "data_service_provider.h"
+#ifdef RT_USING_SENSOR
+#include "sensor_hub_service.h"
+#include "sensor.h"
+#include "string.h"
+
+#define LOG_TAG  "svc.shub"
+#include "log.h"
+
+/*
+    Accelerometer is read in FIFO mode if driver supports it, so the hub core wakes once per watermark,
+    otherwise it's polled at ODR. Samples are low pass filtered, step and wrist raise are detected on
+    filtered data. Filtered samples and step count are held until the smallest latency tolerance of
+    subscribers expires or batch is full, wrist raise is pushed at once.
+    Compare SENSOR_HUB_MSG_STAT_GET_REQ pushes with pm metrics of subscriber core to see its wake rate.
+*/
+
+#ifndef SENSOR_HUB_ODR_HZ
+    #define SENSOR_HUB_ODR_HZ               25
+#endif
+
+#ifndef SENSOR_HUB_LATENCY_MS
+    #define SENSOR_HUB_LATENCY_MS           (60 * 1000)
+#endif
+
+/* Max filtered samples in one SENSOR_HUB_MSG_ACCE_IND */
+#ifndef SENSOR_HUB_BATCH_MAX
+    #define SENSOR_HUB_BATCH_MAX            128
+#endif
+
+/* Max samples of one sensor read, also FIFO watermark */
+#ifndef SENSOR_HUB_READ_MAX
+    #define SENSOR_HUB_READ_MAX             32
+#endif
+
+#ifndef SENSOR_HUB_THREAD_STACK_SIZE
+    #define SENSOR_HUB_THREAD_STACK_SIZE    2048
+#endif
+
+#ifndef SENSOR_HUB_THREAD_PRIORITY
+    #define SENSOR_HUB_THREAD_PRIORITY      (RT_THREAD_PRIORITY_LOW)
+#endif
+
+/* Low pass filter, y += (x - y) >> SHIFT */
+#define SENSOR_HUB_LPF_SHIFT                2
+
+/* Step: magnitude goes above HIGH then below LOW, steps at least MIN_MS apart */
+#define SENSOR_HUB_STEP_HIGH_MG             1150
+#define SENSOR_HUB_STEP_LOW_MG              1050
+#define SENSOR_HUB_STEP_MIN_MS              250
+
+/* Wrist raise: screen up (z > UP, x and y small) within WINDOW_MS after arm down (z < DOWN) */
+#define SENSOR_HUB_WRIST_UP_MG              800
+#define SENSOR_HUB_WRIST_FLAT_MG            500
+#define SENSOR_HUB_WRIST_DOWN_MG            300
+#define SENSOR_HUB_WRIST_WINDOW_MS          800
+
+#define SHUB_EVT_DATA       (1 << 0)
+#define SHUB_EVT_CONFIG     (1 << 1)
+#define SHUB_EVT_FLUSH      (1 << 2)
+
+#define SHUB_ABS(v)         ((v) < 0 ? -(v) : (v))
+
+typedef struct
+{
+    datas_handle_t service;
+    struct rt_event event;
+    struct rt_mutex lock;
+    rt_thread_t thread;
+
+    /* requested by subscribers, protected by lock */
+    uint8_t clients;
+    uint32_t req_features;
+    uint16_t req_latency_ms;
+    uint16_t req_odr_hz;
+
+    /* used by hub thread only */
+    rt_device_t dev;
+    uint8_t fifo;
+    uint32_t features;
+    uint16_t latency_ms;
+    uint16_t odr_hz;
+    uint32_t start_ms;
+
+    int32_t lpf[3];
+    uint8_t lpf_valid;
+    uint8_t step_high;
+    uint8_t wrist_up;
+    uint32_t step_ms;
+    uint32_t arm_down_ms;
+
+    uint32_t batch_ms;
+    uint32_t step_sent;
+    uint32_t step_sent_ms;
+    sensor_hub_acce_ind_t *batch;
+
+    sensor_hub_stat_t stat;
+    struct rt_sensor_data rbuf[SENSOR_HUB_READ_MAX];
+} sensor_hub_t;
+
+static sensor_hub_t g_shub;
+
+static bool service_filter(data_req_t *config, uint16_t msg_id, uint32_t len, uint8_t *data)
+{
+    sensor_hub_config_t *p_config = (sensor_hub_config_t *)&config->data[0];
+
+    switch (msg_id)
+    {
+    case SENSOR_HUB_MSG_ACCE_IND:
+        return (p_config->features & SENSOR_HUB_FEATURE_ACCE) != 0;
+    case SENSOR_HUB_MSG_STEP_IND:
+        return (p_config->features & SENSOR_HUB_FEATURE_STEP) != 0;
+    case SENSOR_HUB_MSG_WRIST_IND:
+        return (p_config->features & SENSOR_HUB_FEATURE_WRIST) != 0;
+    default:
+        return true;
+    }
+}
+
+static rt_err_t shub_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    rt_event_send(&g_shub.event, SHUB_EVT_DATA);
+    return RT_EOK;
+}
+
+static rt_device_t shub_find_acce(void)
+{
+#ifdef SENSOR_HUB_ACCE_DEV
+    return rt_device_find(SENSOR_HUB_ACCE_DEV);
+#else
+    struct rt_object_information *info = rt_object_get_information(RT_Object_Class_Device);
+    struct rt_list_node *node;
+    rt_device_t dev = RT_NULL;
+
+    /* first accelerometer registered to sensor framework */
+    rt_enter_critical();
+    for (node = info->object_list.next; node != &info->object_list; node = node->next)
+    {
+        rt_device_t d = (rt_device_t)rt_list_entry(node, struct rt_object, list);
+
+        if (d->type == RT_Device_Class_Sensor && ((rt_sensor_t)d)->info.type == RT_SENSOR_CLASS_ACCE)
+        {
+            dev = d;
+            break;
+        }
+    }
+    rt_exit_critical();
+    return dev;
+#endif /* SENSOR_HUB_ACCE_DEV */
+}
+
+static void shub_push(uint16_t msg_id, uint32_t len, uint8_t *data, uint32_t *counter)
+{
+    if (datas_push_msg_to_client(g_shub.service, msg_id, len, data) == RT_EOK)
+    {
+        g_shub.stat.pushes++;
+        (*counter)++;
+    }
+}
+
+static void shub_flush(sensor_hub_t *hub, uint32_t now)
+{
+    if (hub->batch && hub->batch->num)
+    {
+        shub_push(SENSOR_HUB_MSG_ACCE_IND, sizeof(sensor_hub_acce_ind_t) + hub->batch->num * sizeof(sensor_hub_acce_t),
+                  (uint8_t *)hub->batch, &hub->stat.acce_pushes);
+        hub->batch->num = 0;
+    }
+
+    if ((hub->features & SENSOR_HUB_FEATURE_STEP) && hub->stat.steps != hub->step_sent)
+    {
+        sensor_hub_step_ind_t ind;
+
+        ind.timestamp = hub->step_ms;
+        ind.steps = hub->stat.steps;
+        shub_push(SENSOR_HUB_MSG_STEP_IND, sizeof(ind), (uint8_t *)&ind, &hub->stat.step_pushes);
+        hub->step_sent = hub->stat.steps;
+    }
+    hub->step_sent_ms = now;
+}
+
+static void shub_process(sensor_hub_t *hub, struct rt_sensor_data *data)
+{
+    int32_t *f = hub->lpf;
+    int32_t mag2;
+    uint32_t ts = data->timestamp;
+
+    if (!hub->lpf_valid)
+    {
+        f[0] = data->data.acce.x;
+        f[1] = data->data.acce.y;
+        f[2] = data->data.acce.z;
+        hub->lpf_valid = 1;
+    }
+    else
+    {
+        f[0] += (data->data.acce.x - f[0]) >> SENSOR_HUB_LPF_SHIFT;
+        f[1] += (data->data.acce.y - f[1]) >> SENSOR_HUB_LPF_SHIFT;
+        f[2] += (data->data.acce.z - f[2]) >> SENSOR_HUB_LPF_SHIFT;
+    }
+    hub->stat.samples++;
+
+    if (hub->batch)
+    {
+        sensor_hub_acce_t *s = &hub->batch->sample[hub->batch->num];
+
+        if (hub->batch->num == 0)
+        {
+            hub->batch->timestamp = ts;
+            hub->batch->interval_ms = 1000 / hub->odr_hz;
+            hub->batch_ms = rt_tick_get_millisecond();
+        }
+        s->x = (int16_t)f[0];
+        s->y = (int16_t)f[1];
+        s->z = (int16_t)f[2];
+        hub->batch->num++;
+        if (hub->batch->num >= SENSOR_HUB_BATCH_MAX)
+            shub_flush(hub, rt_tick_get_millisecond());
+    }
+
+    if (hub->features & SENSOR_HUB_FEATURE_STEP)
+    {
+        /* compare squared magnitude to avoid sqrt */
+        mag2 = f[0] * f[0] + f[1] * f[1] + f[2] * f[2];
+        if (!hub->step_high && mag2 > SENSOR_HUB_STEP_HIGH_MG * SENSOR_HUB_STEP_HIGH_MG)
+        {
+            hub->step_high = 1;
+            if (ts - hub->step_ms >= SENSOR_HUB_STEP_MIN_MS)
+            {
+                hub->stat.steps++;
+                hub->step_ms = ts;
+            }
+        }
+        else if (hub->step_high && mag2 < SENSOR_HUB_STEP_LOW_MG * SENSOR_HUB_STEP_LOW_MG)
+        {
+            hub->step_high = 0;
+        }
+    }
+
+    if (hub->features & SENSOR_HUB_FEATURE_WRIST)
+    {
+        if (f[2] < SENSOR_HUB_WRIST_DOWN_MG)
+        {
+            hub->arm_down_ms = ts;
+            hub->wrist_up = 0;
+        }
+        else if (!hub->wrist_up && f[2] > SENSOR_HUB_WRIST_UP_MG &&
+                 SHUB_ABS(f[0]) < SENSOR_HUB_WRIST_FLAT_MG && SHUB_ABS(f[1]) < SENSOR_HUB_WRIST_FLAT_MG)
+        {
+            hub->wrist_up = 1;
+            if (hub->arm_down_ms && ts - hub->arm_down_ms <= SENSOR_HUB_WRIST_WINDOW_MS)
+            {
+                sensor_hub_wrist_ind_t ind;
+
+                ind.timestamp = ts;
+                shub_push(SENSOR_HUB_MSG_WRIST_IND, sizeof(ind), (uint8_t *)&ind, &hub->stat.wrist_pushes);
+            }
+        }
+    }
+}
+
+static void shub_stop(sensor_hub_t *hub)
+{
+    if (hub->dev)
+    {
+        shub_flush(hub, rt_tick_get_millisecond());
+        rt_device_set_rx_indicate(hub->dev, RT_NULL);
+        rt_device_close(hub->dev);
+        hub->dev = RT_NULL;
+        hub->stat.run_ms += rt_tick_get_millisecond() - hub->start_ms;
+        LOG_I("stop");
+    }
+    if (hub->batch)
+    {
+        rt_free(hub->batch);
+        hub->batch = RT_NULL;
+    }
+}
+
+static void shub_start(sensor_hub_t *hub)
+{
+    rt_device_t dev;
+    rt_err_t err;
+
+    if ((hub->features & SENSOR_HUB_FEATURE_ACCE) && !hub->batch)
+    {
+        hub->batch = rt_malloc(sizeof(sensor_hub_acce_ind_t) + SENSOR_HUB_BATCH_MAX * sizeof(sensor_hub_acce_t));
+        if (hub->batch)
+            hub->batch->num = 0;
+        else
+            LOG_E("no memory for batch");
+    }
+    else if (!(hub->features & SENSOR_HUB_FEATURE_ACCE) && hub->batch)
+    {
+        shub_flush(hub, rt_tick_get_millisecond());
+        rt_free(hub->batch);
+        hub->batch = RT_NULL;
+    }
+
+    if (hub->dev)
+    {
+        rt_device_control(hub->dev, RT_SENSOR_CTRL_SET_ODR, (void *)(rt_uint32_t)hub->odr_hz);
+        return;
+    }
+
+    dev = shub_find_acce();
+    if (!dev)
+    {
+        LOG_E("no accelerometer");
+        return;
+    }
+
+    hub->fifo = 0;
+    err = -RT_ERROR;
+    if (dev->flag & RT_DEVICE_FLAG_FIFO_RX)
+    {
+        err = rt_device_open(dev, RT_DEVICE_FLAG_FIFO_RX);
+        if (err == RT_EOK)
+        {
+            hub->fifo = 1;
+            rt_device_control(dev, RT_SENSOR_CTRL_SET_FIFO_WM, (void *)SENSOR_HUB_READ_MAX);
+            rt_device_set_rx_indicate(dev, shub_rx_ind);
+        }
+    }
+    if (err != RT_EOK)
+        err = rt_device_open(dev, RT_DEVICE_FLAG_RDONLY);
+    if (err != RT_EOK)
+    {
+        LOG_E("open %s fail %d", dev->parent.name, err);
+        return;
+    }
+    rt_device_control(dev, RT_SENSOR_CTRL_SET_ODR, (void *)(rt_uint32_t)hub->odr_hz);
+
+    hub->dev = dev;
+    hub->lpf_valid = 0;
+    hub->start_ms = rt_tick_get_millisecond();
+    hub->step_sent_ms = hub->start_ms;
+    LOG_I("start %s %s odr %d latency %d", dev->parent.name, hub->fifo ? "fifo" : "polling", hub->odr_hz, hub->latency_ms);
+}
+
+static void shub_apply_config(sensor_hub_t *hub)
+{
+    uint8_t clients;
+
+    rt_mutex_take(&hub->lock, RT_WAITING_FOREVER);
+    clients = hub->clients;
+    hub->features = hub->req_features;
+    hub->latency_ms = hub->req_latency_ms ? hub->req_latency_ms : SENSOR_HUB_LATENCY_MS;
+    hub->odr_hz = hub->req_odr_hz ? hub->req_odr_hz : SENSOR_HUB_ODR_HZ;
+    rt_mutex_release(&hub->lock);
+
+    if (clients && hub->features)
+        shub_start(hub);
+    else
+        shub_stop(hub);
+}
+
+static void shub_thread_entry(void *param)
+{
+    sensor_hub_t *hub = (sensor_hub_t *)param;
+    rt_uint32_t evt;
+    rt_int32_t timeout;
+    rt_size_t num, i;
+    uint32_t now, wait_ms;
+
+    while (1)
+    {
+        timeout = RT_WAITING_FOREVER;
+        if (hub->dev)
+        {
+            /* wake for polling, or latency deadline of pending data */
+            wait_ms = hub->fifo ? hub->latency_ms : 1000 / hub->odr_hz;
+            timeout = rt_tick_from_millisecond(wait_ms);
+        }
+
+        evt = 0;
+        rt_event_recv(&hub->event, SHUB_EVT_DATA | SHUB_EVT_CONFIG | SHUB_EVT_FLUSH,
+                      RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, timeout, &evt);
+
+        if (evt & SHUB_EVT_CONFIG)
+            shub_apply_config(hub);
+
+        if (!hub->dev)
+            continue;
+
+        if ((evt & SHUB_EVT_DATA) || !hub->fifo)
+        {
+            num = rt_device_read(hub->dev, 0, hub->rbuf, hub->fifo ? SENSOR_HUB_READ_MAX : 1);
+            hub->stat.reads++;
+            for (i = 0; i < num; i++)
+                shub_process(hub, &hub->rbuf[i]);
+        }
+
+        now = rt_tick_get_millisecond();
+        if ((evt & SHUB_EVT_FLUSH) ||
+                (hub->batch && hub->batch->num && now - hub->batch_ms >= hub->latency_ms) ||
+                (hub->stat.steps != hub->step_sent && now - hub->step_sent_ms >= hub->latency_ms))
+        {
+            shub_flush(hub, now);
+        }
+    }
+}
+
+static int32_t msg_handler(datas_handle_t service, data_msg_t *msg)
+{
+    sensor_hub_t *hub = &g_shub;
+
+    switch (msg->msg_id)
+    {
+    case MSG_SERVICE_SUBSCRIBE_REQ:
+    {
+        rt_mutex_take(&hub->lock, RT_WAITING_FOREVER);
+        hub->clients++;
+        rt_mutex_release(&hub->lock);
+        break;
+    }
+
+    case MSG_SERVICE_UNSUBSCRIBE_REQ:
+    {
+        rt_mutex_take(&hub->lock, RT_WAITING_FOREVER);
+        if (hub->clients)
+            hub->clients--;
+        if (hub->clients == 0)
+        {
+            /* configs of remaining subscribers are not known, so they're only reset with the last one */
+            hub->req_features = 0;
+            hub->req_latency_ms = 0;
+            hub->req_odr_hz = 0;
+        }
+        rt_mutex_release(&hub->lock);
+        rt_event_send(&hub->event, SHUB_EVT_CONFIG);
+        break;
+    }
+
+    case MSG_SERVICE_CONFIG_REQ:
+    {
+        data_req_t *req = (data_req_t *)data_service_get_msg_body(msg);
+        sensor_hub_config_t *p_config = (sensor_hub_config_t *)&req->data[0];
+
+        if (req->len < sizeof(sensor_hub_config_t))
+        {
+            datas_send_response(service, msg, -RT_EINVAL);
+            break;
+        }
+
+        rt_mutex_take(&hub->lock, RT_WAITING_FOREVER);
+        hub->req_features |= p_config->features;
+        if (p_config->max_latency_ms && (!hub->req_latency_ms || p_config->max_latency_ms < hub->req_latency_ms))
+            hub->req_latency_ms = p_config->max_latency_ms;
+        if (p_config->odr_hz > hub->req_odr_hz)
+            hub->req_odr_hz = p_config->odr_hz;
+        rt_mutex_release(&hub->lock);
+
+        rt_event_send(&hub->event, SHUB_EVT_CONFIG);
+        /* response saves config for service_filter */
+        datas_send_response(service, msg, RT_EOK);
+        break;
+    }
+
+    case SENSOR_HUB_MSG_STAT_GET_REQ:
+    {
+        sensor_hub_stat_t stat;
+
+        memcpy(&stat, &hub->stat, sizeof(stat));
+        if (hub->dev)
+            stat.run_ms += rt_tick_get_millisecond() - hub->start_ms;
+        datas_send_response_data(service, msg, sizeof(stat), (uint8_t *)&stat);
+        break;
+    }
+
+    case SENSOR_HUB_MSG_FLUSH_REQ:
+    {
+        rt_event_send(&hub->event, SHUB_EVT_FLUSH);
+        datas_send_response(service, msg, RT_EOK);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static data_service_config_t sensor_hub_service_cb =
+{
+    .max_client_num = 5,
+    .queue = RT_NULL,
+    .data_filter = service_filter,
+    .msg_handler = msg_handler,
+};
+
+int sensor_hub_service_register(void)
+{
+    sensor_hub_t *hub = &g_shub;
+
+    rt_event_init(&hub->event, "shub", RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&hub->lock, "shub", RT_IPC_FLAG_FIFO);
+    hub->thread = rt_thread_create("shub", shub_thread_entry, hub, SENSOR_HUB_THREAD_STACK_SIZE,
+                                   SENSOR_HUB_THREAD_PRIORITY, RT_THREAD_TICK_DEFAULT);
+    RT_ASSERT(hub->thread);
+    rt_thread_startup(hub->thread);
+
+    hub->service = datas_register(SENSOR_HUB_SERVICE_NAME, &sensor_hub_service_cb);
+    RT_ASSERT(hub->service);
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(sensor_hub_service_register);
+
+#ifdef RT_USING_FINSH
+static int sensor_hub(int argc, char **argv)
+{
+    sensor_hub_stat_t *st = &g_shub.stat;
+    uint32_t run_ms = st->run_ms;
+    uint32_t min;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        memset(st, 0, sizeof(*st));
+        g_shub.start_ms = rt_tick_get_millisecond();
+        return 0;
+    }
+
+    if (g_shub.dev)
+        run_ms += rt_tick_get_millisecond() - g_shub.start_ms;
+    min = run_ms / 60000 ? run_ms / 60000 : 1;
+
+    rt_kprintf("sensor hub: %s clients %d features 0x%x odr %d latency %dms\n",
+               g_shub.dev ? (g_shub.fifo ? "fifo" : "polling") : "stopped", g_shub.clients,
+               g_shub.features, g_shub.odr_hz, g_shub.latency_ms);
+    rt_kprintf("run %dms samples %d reads %d steps %d\n", run_ms, st->samples, st->reads, st->steps);
+    rt_kprintf("pushes %d (acce %d step %d wrist %d), %d per minute\n", st->pushes, st->acce_pushes,
+               st->step_pushes, st->wrist_pushes, st->pushes / min);
+    return 0;
+}
+MSH_CMD_EXPORT(sensor_hub, sensor_hub [reset]: show sensor hub statistics);
+#endif /* RT_USING_FINSH */
+
+#endif /* RT_USING_SENSOR */
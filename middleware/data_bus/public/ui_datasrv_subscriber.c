@@ -1,9 +1,204 @@
 #include "data_prov_int.h"
 #include "lvgl.h"
 #include "data_service_subscriber.h"
+#include "ui_datasrv_subscriber.h"
+#include <string.h>
+
+#ifndef UI_DATAC_LATEST_SLOT_NUM
+    #define UI_DATAC_LATEST_SLOT_NUM   (16)
+#endif
 
 static rt_mq_t g_ui_ds_queue;
 
+/*
+    Subscriptions made by ui_datac_subscribe_latest() use their own queue. Data messages from it
+    are not called back at once, only latest one of every (subscriber, msg_id) is kept in a slot.
+    Slots are applied once per GUI timer period, which is display refresh period, so a frame
+    sees at most one update per value. A value same as the one delivered last time is dropped.
+
+    LVGL inserts new timer at head of timer list and runs the list from head, timer created
+    after display runs before display refresh timer in the same lv_timer_handler() pass,
+    so values are applied right before rendering.
+*/
+typedef struct
+{
+    data_callback_t callback;
+    uint32_t user_data;
+    uint16_t msg_id;
+    uint16_t last_len;
+    uint8_t *last;                  /*!< Data delivered last time */
+    data_service_mq_t pending;      /*!< Latest data not delivered yet */
+    uint8_t has_pending;
+} ui_datac_slot_t;
+
+static rt_mq_t g_ui_ds_latest_queue;
+static ui_datac_slot_t g_ui_ds_slot[UI_DATAC_LATEST_SLOT_NUM];
+static ui_datac_stat_t g_ui_ds_stat;
+
+static bool ui_datac_is_data_msg(uint16_t msg_id)
+{
+    return (MSG_SERVICE_DATA_NTF_IND == msg_id) || (MSG_SERVICE_DATA_RDY_IND == msg_id)
+           || (GET_MSG_ID(msg_id) >= MSG_SERVICE_CUSTOM_ID_BEGIN);
+}
+
+static void ui_datac_slot_free(ui_datac_slot_t *slot)
+{
+    if (slot->has_pending && slot->pending.arg.data)
+    {
+        rt_free(slot->pending.arg.data);
+    }
+    if (slot->last)
+    {
+        rt_free(slot->last);
+    }
+    memset(slot, 0, sizeof(*slot));
+}
+
+static ui_datac_slot_t *ui_datac_slot_get(data_service_mq_t *msg)
+{
+    ui_datac_slot_t *slot;
+    ui_datac_slot_t *idle = NULL;
+    ui_datac_slot_t *unused = NULL;
+
+    for (uint32_t i = 0; i < UI_DATAC_LATEST_SLOT_NUM; i++)
+    {
+        slot = &g_ui_ds_slot[i];
+        if (!slot->callback)
+        {
+            if (!unused)
+            {
+                unused = slot;
+            }
+            continue;
+        }
+        if ((slot->callback == msg->callback) && (slot->user_data == msg->arg.user_data)
+                && (slot->msg_id == msg->arg.msg_id))
+        {
+            return slot;
+        }
+        if (!slot->has_pending && !idle)
+        {
+            idle = slot;
+        }
+    }
+
+    if (!unused && idle)
+    {
+        /* recycle slot having nothing pending, it only costs one unchanged value not detected */
+        ui_datac_slot_free(idle);
+        unused = idle;
+    }
+    if (unused)
+    {
+        unused->callback = msg->callback;
+        unused->user_data = msg->arg.user_data;
+        unused->msg_id = msg->arg.msg_id;
+    }
+
+    return unused;
+}
+
+static void ui_datac_slot_release(data_callback_t callback, uint32_t user_data)
+{
+    for (uint32_t i = 0; i < UI_DATAC_LATEST_SLOT_NUM; i++)
+    {
+        ui_datac_slot_t *slot = &g_ui_ds_slot[i];
+
+        if ((slot->callback == callback) && (slot->user_data == user_data))
+        {
+            ui_datac_slot_free(slot);
+        }
+    }
+}
+
+static void ui_datac_latest_put(data_service_mq_t *msg)
+{
+    ui_datac_slot_t *slot;
+
+    g_ui_ds_stat.received++;
+    if (!ui_datac_is_data_msg(msg->arg.msg_id))
+    {
+        if (MSG_SERVICE_UNSUBSCRIBE_RSP == msg->arg.msg_id)
+        {
+            /* subscriber is leaving, values held for it are dropped */
+            ui_datac_slot_release(msg->callback, msg->arg.user_data);
+        }
+        g_ui_ds_stat.delivered++;
+        datac_delayed_usr_cbk(msg);
+        return;
+    }
+
+    slot = ui_datac_slot_get(msg);
+    if (!slot)
+    {
+        /* no slot, deliver as normal subscription */
+        g_ui_ds_stat.no_slot++;
+        g_ui_ds_stat.delivered++;
+        datac_delayed_usr_cbk(msg);
+        return;
+    }
+
+    if (slot->has_pending)
+    {
+        g_ui_ds_stat.superseded++;
+        if (slot->pending.arg.data)
+        {
+            rt_free(slot->pending.arg.data);
+        }
+    }
+    slot->pending = *msg;
+    slot->has_pending = 1;
+}
+
+static void ui_datac_latest_apply(void)
+{
+    bool applied = false;
+
+    for (uint32_t i = 0; i < UI_DATAC_LATEST_SLOT_NUM; i++)
+    {
+        ui_datac_slot_t *slot = &g_ui_ds_slot[i];
+        data_callback_arg_t *arg = &slot->pending.arg;
+
+        if (!slot->has_pending)
+        {
+            continue;
+        }
+        slot->has_pending = 0;
+
+        if (slot->last && (slot->last_len == arg->data_len) && (0 == memcmp(slot->last, arg->data, arg->data_len)))
+        {
+            g_ui_ds_stat.unchanged++;
+            rt_free(arg->data);
+            continue;
+        }
+
+        g_ui_ds_stat.delivered++;
+        applied = true;
+        slot->pending.callback(arg);
+
+        /* callback may unsubscribe and release the slot */
+        if (slot->callback)
+        {
+            if (slot->last)
+            {
+                rt_free(slot->last);
+            }
+            slot->last = arg->data;
+            slot->last_len = arg->data_len;
+        }
+        else if (arg->data)
+        {
+            rt_free(arg->data);
+        }
+        arg->data = NULL;
+    }
+
+    if (applied)
+    {
+        g_ui_ds_stat.frames++;
+    }
+}
+
 #if defined(DISABLE_LVGL_V8)&&defined(DISABLE_LVGL_V9)
     static void ui_datac_task(lv_task_t *param)
 #else
@@ -16,16 +211,26 @@ static rt_mq_t g_ui_ds_queue;
     {
         datac_delayed_usr_cbk(&msg);
     }
+
+    while (rt_mq_recv(g_ui_ds_latest_queue, &msg, sizeof(msg), RT_WAITING_NO) == RT_EOK)
+    {
+        ui_datac_latest_put(&msg);
+    }
+    ui_datac_latest_apply();
 }
 
 void ui_datac_init(void)
 {
     g_ui_ds_queue = rt_mq_create("uisrv", sizeof(data_service_mq_t), 30, RT_IPC_FLAG_FIFO);
     RT_ASSERT(g_ui_ds_queue);
+    g_ui_ds_latest_queue = rt_mq_create("uisrvl", sizeof(data_service_mq_t), 30, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(g_ui_ds_latest_queue);
 #if defined(DISABLE_LVGL_V8)&&defined(DISABLE_LVGL_V9)
     lv_task_create(ui_datac_task, 15, LV_TASK_PRIO_MID, (void *)0);
+#elif defined(DISABLE_LVGL_V9)
+    lv_timer_create(ui_datac_task, LV_DISP_DEF_REFR_PERIOD, (void *)0);
 #else
-    lv_timer_create(ui_datac_task, 15, (void *)0);
+    lv_timer_create(ui_datac_task, LV_DEF_REFR_PERIOD, (void *)0);
 #endif /* DISABLE_LVGL_V8 */
 }
 
@@ -36,5 +241,42 @@ void ui_datac_subscribe(datac_handle_t handle, char *name, data_callback_t cbk,
     datac_subscribe_ex(handle, name, cbk, user_data, g_ui_ds_queue);
 }
 
+void ui_datac_subscribe_latest(datac_handle_t handle, char *name, data_callback_t cbk, uint32_t user_data)
+{
+    datac_subscribe_ex(handle, name, cbk, user_data, g_ui_ds_latest_queue);
+}
+
+void ui_datac_get_stat(ui_datac_stat_t *stat)
+{
+    *stat = g_ui_ds_stat;
+}
+
+#ifdef RT_USING_FINSH
+static int ui_datac_stat(int argc, char **argv)
+{
+    uint32_t used = 0;
+
+    if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+    {
+        memset(&g_ui_ds_stat, 0, sizeof(g_ui_ds_stat));
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < UI_DATAC_LATEST_SLOT_NUM; i++)
+    {
+        if (g_ui_ds_slot[i].callback)
+        {
+            used++;
+        }
+    }
+    rt_kprintf("callbacks received %d, delivered %d, superseded %d, unchanged %d, no slot %d\n",
+               g_ui_ds_stat.received, g_ui_ds_stat.delivered, g_ui_ds_stat.superseded,
+               g_ui_ds_stat.unchanged, g_ui_ds_stat.no_slot);
+    rt_kprintf("frames with update %d, slots %d/%d\n", g_ui_ds_stat.frames, used, UI_DATAC_LATEST_SLOT_NUM);
+
+    return 0;
+}
+MSH_CMD_EXPORT(ui_datac_stat, ui_datac_stat [reset]: show coalesced GUI data service callbacks);
+#endif /* RT_USING_FINSH */
 
 
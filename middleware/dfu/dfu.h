@@ -202,6 +202,7 @@ typedef struct
 #define DFU_FLAG_SINGLE             4
 #define DFU_IMGHDR_KEY_OFFSET       8
 #define DFU_FLAG_COMPRESS           16
+#define DFU_FLAG_DELTA              32          // Compressed content is a delta against installed image, see dfu_delta.py
 struct image_header_enc     // Total length 512, but only 296 bytes are useful in transfer
 {
     // In encrypted
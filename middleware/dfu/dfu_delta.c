@@ -0,0 +1,421 @@
+/**
+  ******************************************************************************
+  * @file   dfu_delta.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2021 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <rtthread.h>
+#include "board.h"
+#include "os_adaptor.h"
+
+#include "rtconfig.h"
+
+#ifdef OTA_55X
+
+#include "dfu.h"
+#include "dfu_internal.h"
+#define LOG_TAG "DFUDELTA"
+#include "log.h"
+
+#ifdef DFU_INSTALL_DELTA
+
+/*
+ * Delta stream is the decompressed content of a DFU_FLAG_DELTA image, it's produced by dfu_delta.py:
+ *   dfu_delta_header_t, op(1B) [src(4B)] [len(4B)] [data], ..., DFU_DELTA_OP_END
+ * Stream is applied while it's decompressed packet by packet, so only one output block is buffered.
+ * Ops may read any part of installed image, it's copied to scratch flash because target is erased
+ * and programmed with new image at the same time.
+ */
+
+#define DFU_DELTA_US(start)  ((uint32_t)((uint64_t)(HAL_GTIMER_READ() - (start)) * 1000000 / HAL_LPTIM_GetFreq()))
+#define DFU_DELTA_ALIGN(size) (((size) + DFU_DELTA_ERASE_SIZE - 1) & ~(DFU_DELTA_ERASE_SIZE - 1))
+
+enum
+{
+    DFU_DELTA_ST_HDR,
+    DFU_DELTA_ST_OP,
+    DFU_DELTA_ST_ARG,
+    DFU_DELTA_ST_DATA,
+    DFU_DELTA_ST_END,
+};
+
+typedef struct
+{
+    dfu_image_header_int_t *header;
+    dfu_delta_header_t hdr;
+    uint8_t state;
+    uint8_t op;
+    uint8_t got;                /* bytes collected of hdr or arg */
+    uint8_t arg[8];
+    uint32_t src;               /* offset in installed image */
+    uint32_t remain;            /* data bytes left of current op */
+    uint32_t scratch;
+    uint32_t out_off;           /* programmed length of new image */
+    uint32_t fill;
+    uint32_t crc;
+    int err;
+    uint8_t *out;
+} dfu_delta_t;
+
+static dfu_delta_t *g_dfu_delta;
+static dfu_delta_stat_t g_dfu_delta_stat;
+
+__WEAK uint32_t dfu_delta_scratch_addr_get(uint32_t size)
+{
+    return DFU_RES_FLASH_CODE_START_ADDR + DFU_RES_FLASH_CODE_SIZE - DFU_DELTA_ALIGN(size);
+}
+
+void dfu_delta_get_stat(dfu_delta_stat_t *stat)
+{
+    memcpy(stat, &g_dfu_delta_stat, sizeof(*stat));
+}
+
+static uint32_t dfu_delta_get_u32(uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/* Installed image is checked and saved to scratch, then target could be erased for new image */
+static int dfu_delta_backup(dfu_delta_t *d)
+{
+    uint32_t old_len = d->hdr.old_len;
+    uint32_t off, size, crc = 0xFFFFFFFF;
+    uint32_t start = HAL_GTIMER_READ();
+
+    if (d->hdr.magic != DFU_DELTA_MAGIC)
+    {
+        LOG_E("delta magic %x", d->hdr.magic);
+        return DFU_FAIL;
+    }
+
+    if (old_len)
+    {
+        d->scratch = dfu_delta_scratch_addr_get(old_len);
+        if (d->scratch == 0xFFFFFFFF)
+        {
+            LOG_E("delta no scratch for %d", old_len);
+            return DFU_FAIL;
+        }
+
+        /* install was interrupted after backup, target is partly new image but scratch is good */
+        for (off = 0; off < old_len; off += size)
+        {
+            size = old_len - off;
+            if (size > DFU_DELTA_BLK_SIZE)
+                size = DFU_DELTA_BLK_SIZE;
+            if (dfu_flash_read(d->scratch + off, d->out, size) != size)
+                break;
+            crc = dfu_crc32mpeg2_update(crc, d->out, size);
+        }
+        if (off >= old_len && crc == d->hdr.old_crc)
+        {
+            LOG_I("delta base %d found in %x", old_len, d->scratch);
+            goto ERASE;
+        }
+
+        crc = 0xFFFFFFFF;
+        if (dfu_flash_erase(d->scratch, DFU_DELTA_ALIGN(old_len)) != 0)
+            return DFU_FAIL;
+    }
+
+    for (off = 0; off < old_len; off += size)
+    {
+        size = old_len - off;
+        if (size > DFU_DELTA_BLK_SIZE)
+            size = DFU_DELTA_BLK_SIZE;
+        if (dfu_packet_read_flash(d->header, off, d->out, size) != 0)
+            return DFU_FAIL;
+        crc = dfu_crc32mpeg2_update(crc, d->out, size);
+        if (dfu_flash_write(d->scratch + off, d->out, size) != 0)
+            return DFU_FAIL;
+    }
+
+    if (crc != d->hdr.old_crc)
+    {
+        /* delta is made for another version, installed image is still intact */
+        LOG_E("delta base crc %x, expect %x", crc, d->hdr.old_crc);
+        return DFU_FAIL;
+    }
+    LOG_I("delta base %d saved to %x", old_len, d->scratch);
+
+ERASE:
+    g_dfu_delta_stat.backup_time = DFU_DELTA_US(start);
+    return dfu_packet_erase_flash(d->header, 0, d->hdr.new_len) == 0 ? DFU_SUCCESS : DFU_FAIL;
+}
+
+static int dfu_delta_flush(dfu_delta_t *d)
+{
+    if (!d->fill)
+        return DFU_SUCCESS;
+
+    d->crc = dfu_crc32mpeg2_update(d->crc, d->out, d->fill);
+    if (dfu_packet_write_flash(d->header, d->out_off, d->out, d->fill) != 0)
+        return DFU_FAIL;
+    d->out_off += d->fill;
+    d->fill = 0;
+
+    return DFU_SUCCESS;
+}
+
+/* Read installed image to output buffer, at most to the end of buffer */
+static uint32_t dfu_delta_read_old(dfu_delta_t *d, uint32_t len)
+{
+    if (len > DFU_DELTA_BLK_SIZE - d->fill)
+        len = DFU_DELTA_BLK_SIZE - d->fill;
+    if (dfu_flash_read(d->scratch + d->src, d->out + d->fill, len) != len)
+        d->err = DFU_FAIL;
+    d->src += len;
+
+    return len;
+}
+
+static void dfu_delta_put(dfu_delta_t *d, uint32_t len)
+{
+    d->fill += len;
+    if (d->fill == DFU_DELTA_BLK_SIZE && d->err == DFU_SUCCESS)
+        d->err = dfu_delta_flush(d);
+}
+
+static void dfu_delta_op(dfu_delta_t *d)
+{
+    uint32_t len, n;
+
+    if (d->op == DFU_DELTA_OP_INSERT)
+    {
+        len = dfu_delta_get_u32(d->arg);
+    }
+    else
+    {
+        d->src = dfu_delta_get_u32(d->arg);
+        len = dfu_delta_get_u32(d->arg + 4);
+        if (d->src > d->hdr.old_len || len > d->hdr.old_len - d->src)
+        {
+            LOG_E("delta op %d src %d len %d", d->op, d->src, len);
+            d->err = DFU_FAIL;
+            return;
+        }
+    }
+    if (len > d->hdr.new_len - d->out_off - d->fill)
+    {
+        LOG_E("delta op %d len %d over new image", d->op, len);
+        d->err = DFU_FAIL;
+        return;
+    }
+
+    switch (d->op)
+    {
+    case DFU_DELTA_OP_COPY:
+        g_dfu_delta_stat.copy_bytes += len;
+        while (len && d->err == DFU_SUCCESS)
+        {
+            n = dfu_delta_read_old(d, len);
+            dfu_delta_put(d, n);
+            len -= n;
+        }
+        d->state = DFU_DELTA_ST_OP;
+        break;
+    case DFU_DELTA_OP_DIFF:
+        g_dfu_delta_stat.diff_bytes += len;
+        break;
+    default:
+        g_dfu_delta_stat.insert_bytes += len;
+        break;
+    }
+    if (d->op != DFU_DELTA_OP_COPY)
+    {
+        d->remain = len;
+        d->state = len ? DFU_DELTA_ST_DATA : DFU_DELTA_ST_OP;
+    }
+}
+
+static uint32_t dfu_delta_data(dfu_delta_t *d, uint8_t *data, uint32_t size)
+{
+    uint8_t *out = d->out + d->fill;
+    uint32_t n, i;
+
+    n = d->remain < size ? d->remain : size;
+    if (d->op == DFU_DELTA_OP_DIFF)
+    {
+        n = dfu_delta_read_old(d, n);
+        for (i = 0; i < n; i++)
+            out[i] += data[i];
+    }
+    else
+    {
+        if (n > DFU_DELTA_BLK_SIZE - d->fill)
+            n = DFU_DELTA_BLK_SIZE - d->fill;
+        memcpy(out, data, n);
+    }
+    dfu_delta_put(d, n);
+    d->remain -= n;
+    if (!d->remain)
+        d->state = DFU_DELTA_ST_OP;
+
+    return n;
+}
+
+int dfu_delta_start(dfu_image_header_int_t *header)
+{
+    dfu_delta_t *d;
+
+    OS_ASSERT(!g_dfu_delta);
+    if (header->flag & DFU_FLAG_ENC)
+    {
+        /* installed image would have to be decrypted with its own key */
+        LOG_E("delta of encrypted image not supported");
+        return DFU_FAIL;
+    }
+
+    d = calloc(1, sizeof(dfu_delta_t));
+    OS_ASSERT(d);
+    d->out = malloc(DFU_DELTA_BLK_SIZE);
+    OS_ASSERT(d->out);
+    d->header = header;
+    d->crc = 0xFFFFFFFF;
+    d->scratch = 0xFFFFFFFF;
+    d->err = DFU_SUCCESS;
+    memset(&g_dfu_delta_stat, 0, sizeof(g_dfu_delta_stat));
+    g_dfu_delta = d;
+
+    return DFU_SUCCESS;
+}
+
+int dfu_delta_feed(uint8_t *data, uint32_t size)
+{
+    dfu_delta_t *d = g_dfu_delta;
+    uint32_t n, need;
+
+    OS_ASSERT(d);
+    while (size && d->err == DFU_SUCCESS)
+    {
+        switch (d->state)
+        {
+        case DFU_DELTA_ST_HDR:
+            n = sizeof(d->hdr) - d->got;
+            if (n > size)
+                n = size;
+            memcpy((uint8_t *)&d->hdr + d->got, data, n);
+            d->got += n;
+            if (d->got == sizeof(d->hdr))
+            {
+                d->got = 0;
+                d->err = dfu_delta_backup(d);
+                d->state = DFU_DELTA_ST_OP;
+            }
+            break;
+        case DFU_DELTA_ST_OP:
+            n = 1;
+            d->op = *data;
+            if (d->op == DFU_DELTA_OP_END)
+                d->state = DFU_DELTA_ST_END;
+            else if (d->op <= DFU_DELTA_OP_INSERT)
+                d->state = DFU_DELTA_ST_ARG;
+            else
+                d->err = DFU_FAIL;
+            break;
+        case DFU_DELTA_ST_ARG:
+            need = (d->op == DFU_DELTA_OP_INSERT) ? 4 : 8;
+            n = need - d->got;
+            if (n > size)
+                n = size;
+            memcpy(d->arg + d->got, data, n);
+            d->got += n;
+            if (d->got == need)
+            {
+                d->got = 0;
+                dfu_delta_op(d);
+            }
+            break;
+        case DFU_DELTA_ST_DATA:
+            n = dfu_delta_data(d, data, size);
+            break;
+        default:
+            LOG_E("delta data after end");
+            n = size;
+            d->err = DFU_FAIL;
+            break;
+        }
+        data += n;
+        size -= n;
+    }
+
+    return d->err;
+}
+
+int dfu_delta_finish(uint32_t *new_len)
+{
+    dfu_delta_t *d = g_dfu_delta;
+    int r;
+
+    if (!d)
+        return DFU_FAIL;
+
+    r = d->err;
+    if (r == DFU_SUCCESS)
+        r = dfu_delta_flush(d);
+    if (r == DFU_SUCCESS && (d->state != DFU_DELTA_ST_END || d->out_off != d->hdr.new_len || d->crc != d->hdr.new_crc))
+    {
+        LOG_E("delta result len %d/%d crc %x/%x", d->out_off, d->hdr.new_len, d->crc, d->hdr.new_crc);
+        r = DFU_FAIL;
+    }
+    LOG_I("delta copy %d, diff %d, insert %d, backup %dms", g_dfu_delta_stat.copy_bytes,
+          g_dfu_delta_stat.diff_bytes, g_dfu_delta_stat.insert_bytes, g_dfu_delta_stat.backup_time / 1000);
+
+    *new_len = d->hdr.new_len;
+    free(d->out);
+    free(d);
+    g_dfu_delta = NULL;
+
+    return r;
+}
+
+#endif /* DFU_INSTALL_DELTA */
+#endif /* OTA_55X */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+#
+# Make delta stream of a DFU image against the installed one, see DFU_INSTALL_DELTA in dfu_internal.h
+#
+# usage: dfu_delta.py <old.bin> <new.bin> <out.bin> [--min-match N] [--verify]
+#   old.bin   image installed on device, must be byte exact (its crc is checked before apply)
+#   new.bin   new image
+#   out.bin   delta stream, package it as compressed image with DFU_FLAG_DELTA (32) set,
+#             it's signed and downloaded as any compressed image
+#   --verify  apply delta again and compare with new.bin
+#
+# Matches are found by hash of short windows, then extended bsdiff style: a region is kept as DIFF
+# as long as most bytes are same, so that code moved by a relinking gives mostly zero diff bytes
+# which are compressed well.
+#
+
+import argparse
+import struct
+import sys
+import zlib
+
+DELTA_MAGIC = 0x54444653
+OP_COPY = 0
+OP_DIFF = 1
+OP_INSERT = 2
+OP_END = 0xFF
+
+WINDOW = 8
+MAX_CANDIDATES = 16
+
+
+def crc32mpeg2(data, crc=0xFFFFFFFF):
+    table = crc32mpeg2.table
+    for b in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ table[((crc >> 24) ^ b) & 0xFF]
+    return crc
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        c = i << 24
+        for _ in range(8):
+            c = ((c << 1) ^ 0x04C11DB7) if c & 0x80000000 else (c << 1)
+        table.append(c & 0xFFFFFFFF)
+    return table
+
+
+crc32mpeg2.table = _crc_table()
+
+
+def build_index(old):
+    index = {}
+    for i in range(len(old) - WINDOW + 1):
+        lst = index.setdefault(old[i:i + WINDOW], [])
+        if len(lst) < MAX_CANDIDATES:
+            lst.append(i)
+    return index
+
+
+def match_len(old, new, src, pos):
+    n = 0
+    limit = min(len(old) - src, len(new) - pos)
+    while n < limit and old[src + n] == new[pos + n]:
+        n += 1
+    return n
+
+
+def extend(old, new, src, pos, length, floor):
+    """Grow exact match [pos, pos + length) both sides while at least half of bytes are same."""
+    # forward
+    best, score, n = length, 0, length
+    limit = min(len(old) - src, len(new) - pos)
+    while n < limit:
+        score += 1 if old[src + n] == new[pos + n] else -1
+        n += 1
+        if score > 0:
+            best, score = n, 0
+        elif score < -WINDOW * 2:
+            break
+    end = pos + best
+    # backward, not before end of previous op
+    back, score, n = 0, 0, 0
+    limit = min(src, pos - floor)
+    while n < limit:
+        n += 1
+        score += 1 if old[src - n] == new[pos - n] else -1
+        if score > 0:
+            back, score = n, 0
+        elif score < -WINDOW * 2:
+            break
+    return src - back, pos - back, end - (pos - back)
+
+
+def make_delta(old, new, min_match):
+    index = build_index(old)
+    ops = []
+    pos = 0
+    lit = 0         # start of pending literal
+    while pos < len(new):
+        best_src, best_len = 0, 0
+        for src in index.get(new[pos:pos + WINDOW], ()):
+            n = match_len(old, new, src, pos)
+            if n > best_len:
+                best_src, best_len = src, n
+        if best_len < min_match:
+            pos += 1
+            continue
+        src, start, length = extend(old, new, best_src, pos, best_len, lit)
+        if start > lit:
+            ops.append((OP_INSERT, 0, new[lit:start]))
+        diff = bytes((new[start + i] - old[src + i]) & 0xFF for i in range(length))
+        if diff.count(0) == length:
+            ops.append((OP_COPY, src, length))
+        else:
+            ops.append((OP_DIFF, src, diff))
+        pos = lit = start + length
+    if lit < len(new):
+        ops.append((OP_INSERT, 0, new[lit:]))
+    return ops
+
+
+def encode(old, new, ops):
+    out = bytearray(struct.pack('<5I', DELTA_MAGIC, len(old), crc32mpeg2(old), len(new), crc32mpeg2(new)))
+    for op, src, arg in ops:
+        if op == OP_COPY:
+            out += struct.pack('<BII', op, src, arg)
+        elif op == OP_DIFF:
+            out += struct.pack('<BII', op, src, len(arg)) + arg
+        else:
+            out += struct.pack('<BI', op, len(arg)) + arg
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply(old, delta):
+    magic, old_len, old_crc, new_len, new_crc = struct.unpack_from('<5I', delta)
+    if magic != DELTA_MAGIC or old_len != len(old) or old_crc != crc32mpeg2(old):
+        raise ValueError('delta is not made for this image')
+    pos = 20
+    out = bytearray()
+    while delta[pos] != OP_END:
+        op = delta[pos]
+        if op == OP_INSERT:
+            n, = struct.unpack_from('<I', delta, pos + 1)
+            out += delta[pos + 5:pos + 5 + n]
+            pos += 5 + n
+            continue
+        src, n = struct.unpack_from('<II', delta, pos + 1)
+        pos += 9
+        if op == OP_COPY:
+            out += old[src:src + n]
+        else:
+            out += bytes((old[src + i] + delta[pos + i]) & 0xFF for i in range(n))
+            pos += n
+    if len(out) != new_len or crc32mpeg2(out) != new_crc:
+        raise ValueError('rebuilt image mismatch')
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Make DFU delta image')
+    parser.add_argument('old')
+    parser.add_argument('new')
+    parser.add_argument('out')
+    parser.add_argument('--min-match', type=int, default=24)
+    parser.add_argument('--verify', action='store_true')
+    args = parser.parse_args()
+
+    with open(args.old, 'rb') as f:
+        old = f.read()
+    with open(args.new, 'rb') as f:
+        new = f.read()
+
+    ops = make_delta(old, new, max(args.min_match, WINDOW))
+    delta = encode(old, new, ops)
+    with open(args.out, 'wb') as f:
+        f.write(delta)
+
+    count = {OP_COPY: [0, 0], OP_DIFF: [0, 0], OP_INSERT: [0, 0]}
+    for op, src, arg in ops:
+        count[op][0] += 1
+        count[op][1] += arg if op == OP_COPY else len(arg)
+    print('old %d, new %d, delta %d' % (len(old), len(new), len(delta)))
+    print('copy %d ops %d bytes, diff %d ops %d bytes, insert %d ops %d bytes' %
+          tuple(x for op in (OP_COPY, OP_DIFF, OP_INSERT) for x in count[op]))
+    full = len(zlib.compress(new, 9))
+    part = len(zlib.compress(delta, 9))
+    print('compressed: full image %d, delta %d (%.1f%%)' % (full, part, part * 100.0 / max(full, 1)))
+
+    if args.verify:
+        if apply(old, delta) != new:
+            print('verify failed')
+            sys.exit(1)
+        print('verify ok')
+
+
+if __name__ == '__main__':
+    main()
@@ -86,10 +86,220 @@
 #endif
 uint32_t g_uncompress_len;
 
+#define DFU_PIPE_US(start)  ((uint32_t)((uint64_t)(HAL_GTIMER_READ() - (start)) * 1000000 / HAL_LPTIM_GetFreq()))
+
+static dfu_pipe_stat_t g_dfu_pipe_stat;
+#ifdef DFU_INSTALL_DELTA
+    static uint8_t g_dfu_delta;         /* decompressed data is applied as delta */
+#endif
+
+void dfu_install_get_pipe_stat(dfu_pipe_stat_t *stat)
+{
+    memcpy(stat, &g_dfu_pipe_stat, sizeof(*stat));
+}
+
+#ifdef DFU_INSTALL_PIPELINE
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t offset;
+    uint32_t size;
+} dfu_pipe_slot_t;
+
+typedef struct
+{
+    dfu_image_header_int_t *header;
+    uint8_t *dfu_key;
+    uint32_t total;
+    uint32_t erased;
+    int err;
+    dfu_pipe_slot_t slot[DFU_PIPE_DEPTH];
+    dfu_pipe_slot_t *cur;
+    rt_mailbox_t free_mb;
+    rt_mailbox_t full_mb;
+    struct rt_semaphore done;
+} dfu_pipe_t;
+
+static dfu_pipe_t *g_dfu_pipe;
+
+static void dfu_pipe_erase_to(dfu_pipe_t *pipe, uint32_t end)
+{
+    uint32_t size, start;
+
+    while (pipe->erased < end && pipe->erased < pipe->total)
+    {
+        size = DFU_PIPE_ERASE_AHEAD;
+        if (pipe->erased + size > pipe->total)
+            size = pipe->total - pipe->erased;
+        start = HAL_GTIMER_READ();
+        if (dfu_packet_erase_flash(pipe->header, pipe->erased, size) != 0)
+            pipe->err = DFU_FAIL;
+        g_dfu_pipe_stat.erase_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.erase_bytes += size;
+        pipe->erased += DFU_PIPE_ERASE_AHEAD;
+    }
+}
+
+static void dfu_pipe_writer(void *param)
+{
+    dfu_pipe_t *pipe = (dfu_pipe_t *)param;
+    dfu_pipe_slot_t *slot;
+    uint32_t start;
+
+    while (1)
+    {
+        if (rt_mb_recv(pipe->full_mb, (rt_uint32_t *)&slot, 0) != RT_EOK)
+        {
+            /* idle, erase next region while producer decompresses */
+            dfu_pipe_erase_to(pipe, pipe->erased + 1);
+            rt_mb_recv(pipe->full_mb, (rt_uint32_t *)&slot, RT_WAITING_FOREVER);
+        }
+        if (!slot)
+            break;
+
+        dfu_pipe_erase_to(pipe, slot->offset + slot->size);
+        start = HAL_GTIMER_READ();
+        if (pipe->header->flag & DFU_FLAG_ENC)
+            dfu_encrypt_packet(pipe->header, slot->offset, slot->buf, slot->size, pipe->dfu_key);
+        else if (dfu_packet_write_flash(pipe->header, slot->offset, slot->buf, slot->size) != 0)
+            pipe->err = DFU_FAIL;
+        g_dfu_pipe_stat.prog_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.prog_bytes += slot->size;
+        rt_mb_send(pipe->free_mb, (rt_uint32_t)slot);
+    }
+    rt_sem_release(&pipe->done);
+}
+
+static void dfu_pipe_start(dfu_image_header_int_t *header, uint8_t *dfu_key, uint32_t pksize, uint32_t total)
+{
+    dfu_pipe_t *pipe;
+    rt_thread_t tid;
+    int i;
+
+    pipe = calloc(1, sizeof(dfu_pipe_t));
+    OS_ASSERT(pipe);
+    pipe->header = header;
+    pipe->dfu_key = dfu_key;
+    pipe->total = total;
+    pipe->free_mb = rt_mb_create("dfu_free", DFU_PIPE_DEPTH, RT_IPC_FLAG_FIFO);
+    pipe->full_mb = rt_mb_create("dfu_full", DFU_PIPE_DEPTH + 1, RT_IPC_FLAG_FIFO);
+    OS_ASSERT(pipe->free_mb && pipe->full_mb);
+    rt_sem_init(&pipe->done, "dfu_pipe", 0, RT_IPC_FLAG_FIFO);
+    for (i = 0; i < DFU_PIPE_DEPTH; i++)
+    {
+        pipe->slot[i].buf = malloc(pksize);
+        OS_ASSERT(pipe->slot[i].buf);
+        rt_mb_send(pipe->free_mb, (rt_uint32_t)&pipe->slot[i]);
+    }
+    g_dfu_pipe = pipe;
+
+    tid = rt_thread_create("dfu_wr", dfu_pipe_writer, pipe, 2048, RT_THREAD_PRIORITY_MIDDLE - 1, RT_THREAD_TICK_DEFAULT);
+    OS_ASSERT(tid);
+    rt_thread_startup(tid);
+}
+
+static uint8_t *dfu_pipe_get_buf(void)
+{
+    dfu_pipe_t *pipe = g_dfu_pipe;
+    uint32_t start = HAL_GTIMER_READ();
+
+    OS_ASSERT(pipe);
+    if (!pipe->cur)
+        rt_mb_recv(pipe->free_mb, (rt_uint32_t *)&pipe->cur, RT_WAITING_FOREVER);
+    g_dfu_pipe_stat.stall_time += DFU_PIPE_US(start);
+
+    return pipe->cur->buf;
+}
+
+static void dfu_pipe_submit(uint32_t offset, uint32_t size)
+{
+    dfu_pipe_t *pipe = g_dfu_pipe;
+
+    pipe->cur->offset = offset;
+    pipe->cur->size = size;
+    rt_mb_send(pipe->full_mb, (rt_uint32_t)pipe->cur);
+    pipe->cur = NULL;
+}
+
+static int dfu_pipe_finish(void)
+{
+    dfu_pipe_t *pipe = g_dfu_pipe;
+    int err, i;
+
+    if (!pipe)
+        return DFU_SUCCESS;
+
+    rt_mb_send(pipe->full_mb, 0);
+    rt_sem_take(&pipe->done, RT_WAITING_FOREVER);
+    err = pipe->err;
+
+    for (i = 0; i < DFU_PIPE_DEPTH; i++)
+        free(pipe->slot[i].buf);
+    rt_mb_delete(pipe->free_mb);
+    rt_mb_delete(pipe->full_mb);
+    rt_sem_detach(&pipe->done);
+    free(pipe);
+    g_dfu_pipe = NULL;
+
+    return err;
+}
+#endif /* DFU_INSTALL_PIPELINE */
+
+static void dfu_pipe_report(uint32_t install_start)
+{
+    dfu_pipe_stat_t *st = &g_dfu_pipe_stat;
+
+    st->total_time = DFU_PIPE_US(install_start);
+#define DFU_PIPE_KBPS(bytes, us) ((us) ? (uint32_t)((uint64_t)(bytes) * 1000000 / 1024 / (us)) : 0)
+    LOG_I("install %dms: read %dKB/s, decomp %dKB/s, erase %dKB/s, prog %dKB/s, stall %dms",
+          st->total_time / 1000, DFU_PIPE_KBPS(st->read_bytes, st->read_time),
+          DFU_PIPE_KBPS(st->decomp_bytes, st->decomp_time), DFU_PIPE_KBPS(st->erase_bytes, st->erase_time),
+          DFU_PIPE_KBPS(st->prog_bytes, st->prog_time), st->stall_time / 1000);
+#undef DFU_PIPE_KBPS
+}
+
+/* Get target ready before the 1st packet is decompressed, uncompress_buf is allocated if pipeline isn't used */
+static int dfu_install_prepare(dfu_image_header_int_t *header, uint8_t *dfu_key, uint32_t pksize, uint32_t total,
+                               uint8_t **uncompress_buf)
+{
+#ifdef DFU_INSTALL_DELTA
+    if (header->flag & DFU_FLAG_DELTA)
+    {
+        /* target is erased after installed image is saved, new image length is known from delta */
+        if (dfu_delta_start(header) != DFU_SUCCESS)
+            return DFU_FAIL;
+        g_dfu_delta = 1;
+    }
+    else
+#endif
+    {
+#ifdef DFU_INSTALL_PIPELINE
+        /* writer thread erases ahead of programming instead of erasing whole image here */
+        dfu_pipe_start(header, dfu_key, pksize, total);
+        return DFU_SUCCESS;
+#else
+        uint32_t start = HAL_GTIMER_READ();
+        dfu_packet_erase_flash(header, 0, total);
+        g_dfu_pipe_stat.erase_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.erase_bytes += total;
+#endif
+    }
+
+    *uncompress_buf = malloc(pksize);
+    OS_ASSERT(*uncompress_buf);
+    return DFU_SUCCESS;
+}
+
 static int dfu_decompress(dfu_image_header_int_t *header, uint8_t *dfu_key, uint8_t *uncompress_buf, uint32_t *pksize, uint8_t *compress_buf, uint32_t *packet_len,
                           uint32_t *total_uncompress_len, uint32_t *uncompress_offset)
 {
     int r;
+    uint32_t start;
+#ifdef DFU_INSTALL_PIPELINE
+    if (g_dfu_pipe)
+        uncompress_buf = dfu_pipe_get_buf();
+#endif
+    start = HAL_GTIMER_READ();
 #ifdef DFU_DECOMPRESS_USING_SOFTWARE
     r = uncompress2(uncompress_buf, (uLong *)pksize, compress_buf, (uLong *)packet_len);
 #else
@@ -146,12 +356,38 @@ static int dfu_decompress(dfu_image_header_int_t *header, uint8_t *dfu_key, uint
 
     if (r != DFU_DECOM_OK)
         return r;
-    if (header->flag & DFU_FLAG_ENC)
-        dfu_encrypt_packet(header, *uncompress_offset, uncompress_buf, *pksize, dfu_key);
+    g_dfu_pipe_stat.decomp_time += DFU_PIPE_US(start);
+    g_dfu_pipe_stat.decomp_bytes += *pksize;
+#ifdef DFU_INSTALL_DELTA
+    if (g_dfu_delta)
+    {
+        start = HAL_GTIMER_READ();
+        r = dfu_delta_feed(uncompress_buf, *pksize);
+        g_dfu_pipe_stat.prog_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.prog_bytes += *pksize;
+        if (r != DFU_SUCCESS)
+            return r;
+    }
     else
+#endif
+#ifdef DFU_INSTALL_PIPELINE
     {
-        dfu_packet_write_flash(header, *uncompress_offset, uncompress_buf, *pksize);
+        /* encrypt and program in writer thread, next packet is decompressed meanwhile */
+        dfu_pipe_submit(*uncompress_offset, *pksize);
+    }
+#else
+    {
+        start = HAL_GTIMER_READ();
+        if (header->flag & DFU_FLAG_ENC)
+            dfu_encrypt_packet(header, *uncompress_offset, uncompress_buf, *pksize, dfu_key);
+        else
+        {
+            dfu_packet_write_flash(header, *uncompress_offset, uncompress_buf, *pksize);
+        }
+        g_dfu_pipe_stat.prog_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.prog_bytes += *pksize;
     }
+#endif
     //LOG_D("pk len %d", *packet_len);
     //dfu_ctrl_update_install_progress(header->img_id, *uncompress_offset, g_uncompress_len);
     RT_ASSERT(*total_uncompress_len >= *pksize);
@@ -213,7 +449,10 @@ static int dfu_img_install_flash(dfu_ctrl_env_t *env, uint8_t *dfu_key, dfu_imag
     int r = DFU_SUCCESS;
     uint32_t blksize, body_size = 0, comp_len, blk_offset = 0;
     uint8_t is_last_small_packet = 0;
+    uint32_t install_start = HAL_GTIMER_READ();
+    uint32_t start;
 
+    memset(&g_dfu_pipe_stat, 0, sizeof(g_dfu_pipe_stat));
     curr_info->img_id = header->img_id;
     curr_info->img_state = DFU_CTRL_IMG_STATE_DOWNLOADING;
     curr_info->header = header;
@@ -236,6 +475,7 @@ static int dfu_img_install_flash(dfu_ctrl_env_t *env, uint8_t *dfu_key, dfu_imag
         /* Should read from compress section. */
         header->flag |= DFU_FLAG_COMPRESS;
         //header->flag |= DFU_FLAG_ENC;
+        start = HAL_GTIMER_READ();
         if (dfu_key)
         {
             dfu_read_storage_data(header, offset, enc_data, blksize);
@@ -245,6 +485,8 @@ static int dfu_img_install_flash(dfu_ctrl_env_t *env, uint8_t *dfu_key, dfu_imag
         {
             dfu_read_storage_data(header, offset, dfu_temp + blk_offset, blksize);
         }
+        g_dfu_pipe_stat.read_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.read_bytes += blksize;
         header->flag &= ~DFU_FLAG_COMPRESS;
         //header->flag &= ~DFU_FLAG_ENC;
 
@@ -265,13 +507,12 @@ static int dfu_img_install_flash(dfu_ctrl_env_t *env, uint8_t *dfu_key, dfu_imag
             g_uncompress_len = total_uncompress_len;
             LOG_I("uncompre len %d \r\n", total_uncompress_len);
 
-            dfu_packet_erase_flash(header, 0, total_uncompress_len);
+            r = dfu_install_prepare(header, dfu_key, pksize, total_uncompress_len, &uncompress_buf);
+            if (r != DFU_SUCCESS)
+                break;
 
             packet_len = ((dfu_compress_packet_header_t *)(dfu_temp + sizeof(struct img_header_compress_info)))->packet_len;
 
-            uncompress_buf = malloc(pksize);
-            OS_ASSERT(uncompress_buf);
-
             temp_offset = sizeof(struct img_header_compress_info) + sizeof(dfu_compress_packet_header_t);
             temp_left = blksize - temp_offset;
             // Handle compress pksize smaller than bksize
@@ -490,9 +731,23 @@ END:
     //dfu_ctrl_update_install_progress(header->img_id, g_uncompress_len, g_uncompress_len);
     LOG_I("total len %d, uncom len %d, compress buf %x\r\n", total_len, total_uncompress_len, compress_buf);
     //RT_ASSERT(compress_buf == NULL);
+#ifdef DFU_INSTALL_PIPELINE
+    if (dfu_pipe_finish() != DFU_SUCCESS && r == DFU_SUCCESS)
+        r = DFU_FAIL;
+#endif
+#ifdef DFU_INSTALL_DELTA
+    if (g_dfu_delta)
+    {
+        /* image header length is the rebuilt image, not the delta */
+        if (dfu_delta_finish(&total_hdr_len) != DFU_SUCCESS && r == DFU_SUCCESS)
+            r = DFU_FAIL;
+        g_dfu_delta = 0;
+    }
+#endif
     free(uncompress_buf);
     free(enc_data);
     free(dfu_temp);
+    dfu_pipe_report(install_start);
 
     if (r == DFU_SUCCESS)
     {
@@ -644,7 +899,10 @@ int dfu_image_install_flash_offline(dfu_ctrl_env_t *env, uint8_t image_id, uint3
     int r = DFU_SUCCESS;
     uint32_t blksize, body_size = 0, comp_len, blk_offset = 0;
     uint8_t is_last_small_packet = 0;
+    uint32_t install_start = HAL_GTIMER_READ();
+    uint32_t start;
 
+    memset(&g_dfu_pipe_stat, 0, sizeof(g_dfu_pipe_stat));
     header->flag = 16;
     header->img_id = image_id;
     header->length = length;
@@ -669,7 +927,10 @@ int dfu_image_install_flash_offline(dfu_ctrl_env_t *env, uint8_t image_id, uint3
 
         //HAL_sw_breakpoint();
         //dfu_read_storage_data(header, offset, dfu_temp + blk_offset, blksize);
+        start = HAL_GTIMER_READ();
         dfu_flash_read(DFU_DOWNLOAD_REGION_START_ADDR + image_offset + offset, dfu_temp + blk_offset, blksize);
+        g_dfu_pipe_stat.read_time += DFU_PIPE_US(start);
+        g_dfu_pipe_stat.read_bytes += blksize;
 
         header->flag &= ~DFU_FLAG_COMPRESS;
         //header->flag &= ~DFU_FLAG_ENC;
@@ -691,13 +952,12 @@ int dfu_image_install_flash_offline(dfu_ctrl_env_t *env, uint8_t image_id, uint3
             g_uncompress_len = total_uncompress_len;
             LOG_I("uncompre len %d \r\n", total_uncompress_len);
 
-            dfu_packet_erase_flash(header, 0, total_uncompress_len);
+            r = dfu_install_prepare(header, dfu_key, pksize, total_uncompress_len, &uncompress_buf);
+            if (r != DFU_SUCCESS)
+                break;
 
             packet_len = ((dfu_compress_packet_header_t *)(dfu_temp + sizeof(struct img_header_compress_info)))->packet_len;
 
-            uncompress_buf = malloc(pksize);
-            OS_ASSERT(uncompress_buf);
-
             temp_offset = sizeof(struct img_header_compress_info) + sizeof(dfu_compress_packet_header_t);
             temp_left = blksize - temp_offset;
             // Handle compress pksize smaller than bksize
@@ -916,9 +1176,22 @@ END:
     // dfu_install_progress_ind(g_uncompress_len, g_uncompress_len);
     LOG_I("total len %d, uncom len %d, compress buf %x\r\n", total_len, total_uncompress_len, compress_buf);
     //RT_ASSERT(compress_buf == NULL);
+#ifdef DFU_INSTALL_PIPELINE
+    if (dfu_pipe_finish() != DFU_SUCCESS && r == DFU_SUCCESS)
+        r = DFU_FAIL;
+#endif
+#ifdef DFU_INSTALL_DELTA
+    if (g_dfu_delta)
+    {
+        if (dfu_delta_finish(&total_hdr_len) != DFU_SUCCESS && r == DFU_SUCCESS)
+            r = DFU_FAIL;
+        g_dfu_delta = 0;
+    }
+#endif
     free(uncompress_buf);
     //free(enc_data);
     free(dfu_temp);
+    dfu_pipe_report(install_start);
 
     //HAL_sw_breakpoint();
 
@@ -764,6 +764,74 @@ int8_t dfu_integrate_verify(uint8_t *in_data, int size, uint8_t *hash);
 
 int dfu_img_install(dfu_ctrl_env_t *env);
 
+/* Erase and program flash in a writer thread during install, overlapped with read, decrypt and decompress */
+//#define DFU_INSTALL_PIPELINE
+#ifndef DFU_PIPE_DEPTH
+    #define DFU_PIPE_DEPTH          (2)         /* decompressed packets buffered for writer thread */
+#endif
+#ifndef DFU_PIPE_ERASE_AHEAD
+    #define DFU_PIPE_ERASE_AHEAD    (0x10000)   /* erase granularity and distance ahead of programming */
+#endif
+
+/* Install statistics, time in us */
+typedef struct
+{
+    uint32_t read_bytes;
+    uint32_t read_time;         /* read compressed data and decrypt */
+    uint32_t decomp_bytes;
+    uint32_t decomp_time;
+    uint32_t stall_time;        /* decompress waited for free buffer, writer is the bottleneck */
+    uint32_t erase_bytes;
+    uint32_t erase_time;
+    uint32_t prog_bytes;
+    uint32_t prog_time;         /* encrypt and program */
+    uint32_t total_time;
+} dfu_pipe_stat_t;
+
+void dfu_install_get_pipe_stat(dfu_pipe_stat_t *stat);
+
+/* Install image of DFU_FLAG_DELTA, new image is rebuilt from installed one and delta ops.
+   Installed image is copied to scratch flash before target is erased. */
+//#define DFU_INSTALL_DELTA
+#ifndef DFU_DELTA_BLK_SIZE
+    #define DFU_DELTA_BLK_SIZE      (0x1000)    /* output buffer and old image read size */
+#endif
+#ifndef DFU_DELTA_ERASE_SIZE
+    #define DFU_DELTA_ERASE_SIZE    (0x2000)    /* scratch erase alignment */
+#endif
+
+#define DFU_DELTA_MAGIC             (0x54444653)    /* "SFDT" */
+#define DFU_DELTA_OP_COPY           (0)         /* src, len: copy from old image */
+#define DFU_DELTA_OP_DIFF           (1)         /* src, len, data[len]: old image byte + data byte */
+#define DFU_DELTA_OP_INSERT         (2)         /* len, data[len]: new data */
+#define DFU_DELTA_OP_END            (0xFF)
+
+/* Head of decompressed delta stream, ops follow it, all fields little endian */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t old_len;
+    uint32_t old_crc;           /* dfu_crc32mpeg2 of installed image */
+    uint32_t new_len;
+    uint32_t new_crc;
+} dfu_delta_header_t;
+
+typedef struct
+{
+    uint32_t copy_bytes;
+    uint32_t diff_bytes;
+    uint32_t insert_bytes;
+    uint32_t backup_time;       /* us, copy installed image to scratch */
+} dfu_delta_stat_t;
+
+int dfu_delta_start(dfu_image_header_int_t *header);
+int dfu_delta_feed(uint8_t *data, uint32_t size);
+/* Check new image and release, new_len is output, return DFU_SUCCESS if image is complete */
+int dfu_delta_finish(uint32_t *new_len);
+void dfu_delta_get_stat(dfu_delta_stat_t *stat);
+/* Flash address to keep installed image during apply, weak, default is tail of download region */
+uint32_t dfu_delta_scratch_addr_get(uint32_t size);
+
 int dfu_img_install_lcpu_rom_patch(dfu_ctrl_env_t *env);
 
 int8_t dfu_protocol_packet_send(uint8_t *data);
@@ -873,6 +941,9 @@ int dfu_image_install_flash_offline(dfu_ctrl_env_t *env, uint8_t image_id, uint3
 
 uint32_t dfu_crc32mpeg2(uint8_t *data, uint32_t len);
 
+/* Continue crc of dfu_crc32mpeg2, start with 0xFFFFFFFF */
+uint32_t dfu_crc32mpeg2_update(uint32_t crc, uint8_t *data, uint32_t len);
+
 
 #endif //__DFU_INTERNAL_H
 
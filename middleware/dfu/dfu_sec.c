@@ -725,10 +725,8 @@ static uint32_t CrcTable[256] =
     0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
-uint32_t dfu_crc32mpeg2(uint8_t *data, uint32_t len)
+uint32_t dfu_crc32mpeg2_update(uint32_t crc, uint8_t *data, uint32_t len)
 {
-    uint32_t crc = 0xFFFFFFFF;
-
     for (uint32_t i = 0; i < len; i++)
     {
         crc = (crc << 8) ^ CrcTable[((crc >> 24) ^ *data++) & 0xFF];
@@ -736,4 +734,9 @@ uint32_t dfu_crc32mpeg2(uint8_t *data, uint32_t len)
     return crc;
 }
 
+uint32_t dfu_crc32mpeg2(uint8_t *data, uint32_t len)
+{
+    return dfu_crc32mpeg2_update(0xFFFFFFFF, data, len);
+}
+
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
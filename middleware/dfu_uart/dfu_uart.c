@@ -59,12 +59,16 @@
 #include "bf0_mbox_common.h"
 
 #include "drv_flash.h"
+#ifdef BSP_USING_HW_CRC
+    #include "drv_crc.h"
+#endif
 #include "dfu_uart.h"
 
 #ifdef BSP_USING_DFU_UART
 #define LOG_TAG "dfu_uart"
 #include "log.h"
 
+#ifndef BSP_USING_HW_CRC
 static uint32_t crc32mpeg2_table[] = {
         0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
         0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61,
@@ -110,6 +114,7 @@ static uint32_t crc32mpeg2_table[] = {
         0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668,
         0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
+#endif /* !BSP_USING_HW_CRC */
 
 static dfu_uart_env_t g_dfu_uart_env;
 static void dfu_uart_send(uint8_t *data, uint16_t len);
@@ -432,12 +437,17 @@ static void dfu_uart_image_data_handler(dfu_uart_env_t *env, uint8_t *data, uint
 }
 
 static uint32_t crc32mpeg2_get_value(uint8_t *inData, uint16_t len, uint32_t lastCrc) {
+#ifdef BSP_USING_HW_CRC
+    /* CRC-32/MPEG-2 has no final xor, crc is the intermediate value */
+    return drv_crc_accumulate(CRC_32_MPEG_2, lastCrc, inData, len);
+#else
     uint16_t i;
     uint32_t crc = lastCrc;
 
     for (i = 0; i < len; i++)
         crc = (int) ((crc << 8) ^ crc32mpeg2_table[(int) (((crc >> 24) ^ inData[i]) & 0xFF)]);
     return crc;
+#endif
 }
 
 static uint8_t dfu_uart_crc_verification(dfu_uart_env_t *env)
@@ -698,6 +708,99 @@ static void dfu_uart_protocol_handler(dfu_uart_env_t *env, uint8_t *data, rt_uin
     }
 }
 
+static uint32_t dfu_uart_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static void dfu_uart_stat_add(dfu_uart_env_t *env, uint32_t bytes, uint32_t start)
+{
+    if (!env->stat_tick)
+        env->stat_tick = rt_tick_get();
+    env->stat_bytes += bytes;
+    env->stat_busy_us += dfu_uart_us(start);
+}
+
+#ifdef DFU_UART_ZERO_COPY
+/* Parse frames in uart receive fifo in place, copy only if frame wraps fifo end or is being assembled */
+static void dfu_uart_rx_process(dfu_uart_env_t *env)
+{
+    rt_size_t bufsz = ((struct rt_serial_device *)env->device)->config.bufsz;
+    rt_size_t len, total, frame_len;
+    uint32_t start = HAL_GTIMER_READ();
+    uint32_t bytes = 0;
+    uint16_t command, data_len;
+    uint8_t *ptr;
+
+    while ((len = rt_serial_rx_peek(env->device, &ptr, &total)) > 0)
+    {
+        if (env->is_assemable)
+        {
+            /* Only take bytes of current frame, next frame may follow in same chunk */
+            if (len > env->target_length - env->assemable_length)
+                len = env->target_length - env->assemable_length;
+            dfu_uart_protocol_handler(env, ptr, len);
+        }
+        else
+        {
+            if (total < DFU_UART_HEADER_EX_LEN)
+                break;
+
+            if (len < DFU_UART_HEADER_EX_LEN)
+            {
+                /* Header wraps fifo end, copy it out and assemble the frame */
+                uint8_t header[DFU_UART_HEADER_EX_LEN];
+
+                memcpy(header, ptr, len);
+                rt_serial_rx_consume(env->device, len);
+                rt_serial_rx_peek(env->device, &ptr, &total);
+                memcpy(header + len, ptr, DFU_UART_HEADER_EX_LEN - len);
+                rt_serial_rx_consume(env->device, DFU_UART_HEADER_EX_LEN - len);
+                bytes += DFU_UART_HEADER_EX_LEN;
+                dfu_uart_protocol_handler(env, header, DFU_UART_HEADER_EX_LEN);
+                continue;
+            }
+
+            memcpy(&data_len, ptr + 8, 2);
+            frame_len = data_len + DFU_UART_HEADER_EX_LEN;
+            if (len >= frame_len)
+            {
+                uint32_t header_front;
+                uint16_t header_rear;
+
+                memcpy(&header_front, ptr, SFUART_HEADER_FRONT_LEN);
+                memcpy(&header_rear, ptr + SFUART_HEADER_FRONT_LEN, SFUART_HEADER_REAR_LEN);
+                if ((header_front == SFUART_HEADER_FRONT) && (header_rear == SFUART_HEADER_REAR))
+                {
+                    memcpy(&command, ptr + 6, 2);
+                    dfu_uart_command_process(env, command, ptr + DFU_UART_HEADER_EX_LEN, data_len);
+                    len = frame_len;
+                }
+                else
+                {
+                    LOG_I("HEADER ERROR!");
+                }
+            }
+            else if ((total < frame_len) && (frame_len <= bufsz))
+            {
+                /* Wait rest of frame, it will be parsed in place */
+                break;
+            }
+            else
+            {
+                /* Frame wraps fifo end or is larger than fifo, assemble it */
+                dfu_uart_protocol_handler(env, ptr, len);
+            }
+        }
+        rt_serial_rx_consume(env->device, len);
+        bytes += len;
+    }
+
+    if (bytes)
+        dfu_uart_stat_add(env, bytes, start);
+}
+#endif /* DFU_UART_ZERO_COPY */
+
 void dfu_forward_to_mb_entry(void *param)
 {
     dfu_uart_env_t *env = dfu_uart_get_env();
@@ -717,9 +820,17 @@ void dfu_forward_to_mb_entry(void *param)
         {
             rt_mb_recv(env->to_mb, &size, RT_WAITING_FOREVER);
             //rt_kprintf("(TB)read size %d, mb ptr %x\r\n", size, env->ipc_port);
-            LOG_I("(TB)read size %d", size);
+            LOG_D("(TB)read size %d", size);
             if (!size)
                 continue;
+#ifdef DFU_UART_ZERO_COPY
+            if (env->device->open_flag & RT_DEVICE_FLAG_DMA_RX)
+            {
+                dfu_uart_rx_process(env);
+                continue;
+            }
+#endif /* DFU_UART_ZERO_COPY */
+            uint32_t start = HAL_GTIMER_READ();
             ptr = malloc(size);
             RT_ASSERT(ptr);
 
@@ -737,6 +848,7 @@ void dfu_forward_to_mb_entry(void *param)
             //LOG_HEX("DFU_UART", 16, ptr, size);
 
             free(ptr);
+            dfu_uart_stat_add(env, size, start);
         }
         rt_thread_mdelay(10);
     }
@@ -754,6 +866,36 @@ int dfu_uart_forward_init(void)
     return 0;
 }
 
+#ifdef RT_USING_FINSH
+/* Receive throughput and CPU time of receive thread, for comparing copy and zero copy path */
+static int dfu_uart_stat(int argc, char **argv)
+{
+    dfu_uart_env_t *env = dfu_uart_get_env();
+    uint32_t ms;
+
+    if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+    {
+        env->stat_bytes = 0;
+        env->stat_busy_us = 0;
+        env->stat_tick = 0;
+        return 0;
+    }
+
+    ms = env->stat_tick ? (rt_tick_get() - env->stat_tick) * 1000 / RT_TICK_PER_SECOND : 0;
+    rt_kprintf("dfu uart rx %d bytes in %dms, %d B/s, rx thread busy %dus (%d%%), %s\n",
+               env->stat_bytes, ms, ms ? (uint32_t)((uint64_t)env->stat_bytes * 1000 / ms) : 0,
+               env->stat_busy_us, ms ? env->stat_busy_us / 10 / ms : 0,
+#ifdef DFU_UART_ZERO_COPY
+               "zero copy"
+#else
+               "copy"
+#endif
+              );
+    return 0;
+}
+MSH_CMD_EXPORT(dfu_uart_stat, dfu uart receive statistics: dfu_uart_stat [reset]);
+#endif /* RT_USING_FINSH */
+
 void dfu_uart_send(uint8_t *data, uint16_t len)
 {
     //LOG_I("dfu_uart_send");
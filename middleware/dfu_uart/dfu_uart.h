@@ -79,6 +79,11 @@ typedef struct
     uint32_t single_packet_size;
 
     uint8_t mode;
+
+    // receive statistics, see dfu_uart_stat
+    uint32_t stat_bytes;
+    uint32_t stat_busy_us;
+    rt_tick_t stat_tick;
 } dfu_uart_env_t;
 
 typedef enum
@@ -5,11 +5,28 @@
 #include "bf0_hal.h"
 #include "drv_flash.h"
 #include <drv_log.h>
+#ifdef BSP_USING_HW_CRC
+    #include "drv_crc.h"
+#endif
 #include <dfs_fs.h>
 #include <dfs_file.h>
 #include <dfs_posix.h>
 
 #define MAX_BLOCK_LEN   (8*1024)
+
+/* Blocks outstanding in windowed transfer, each takes a MAX_BLOCK_LEN buffer */
+#ifndef ELM_TRANS_WINDOW
+    #define ELM_TRANS_WINDOW    (4)
+#endif
+
+/* Highest baud rate accepted by elm_trans_test 5 */
+#ifndef ELM_TRANS_MAX_BAUD
+    #define ELM_TRANS_MAX_BAUD  (3000000)
+#endif
+
+#define ELM_TRANS_MAGIC     (0x5745)    /* "EW" */
+#define ELM_TRANS_HDR_LEN   (10)
+#define ELM_TRANS_TIMEOUT   (2000)
 //uint8_t elm_data[MAX_BLOCK_LEN];
 static int elm_fptr = -1;
 static uint8_t *p_buf = RT_NULL;
@@ -32,6 +49,10 @@ unsigned int getCrc(unsigned char *pSrc, int len, unsigned int crc)
 {
     //unsigned int crc = 0xffffffff;
 
+#ifdef BSP_USING_HW_CRC
+    /* CRC-32/MPEG-2 has no final xor, crc is the intermediate value */
+    return drv_crc_accumulate(CRC_32_MPEG_2, crc, pSrc, len);
+#else
     for (int m = 0; m < len; m++)
     {
         crc ^= ((unsigned int)pSrc[m]) << 24;
@@ -50,6 +71,7 @@ unsigned int getCrc(unsigned char *pSrc, int len, unsigned int crc)
     }
 
     return crc;
+#endif
 }
 
 static int elm_trans_in(char *file_path, char *file_size, char *crc_str)
@@ -338,6 +360,339 @@ static int elm_trans_out(char *file_path, char *file_size)
     return 0;
 }
 
+/*
+    Windowed transfer in (elm_trans_test 4), host sends frames without waiting:
+        magic(2, "EW") seq(2) len(2) crc(4, CRC-32/MPEG-2 of payload) payload(len)
+    All little endian, len is MAX_BLOCK_LEN except the last block. Device answers with lines
+        "elm_ack <n>"  blocks 0..n-1 are written to file
+        "elm_nak <n>"  block n is lost or corrupted, host resends from block n
+    Host keeps at most ELM_TRANS_WINDOW blocks not acked. Blocks are written by a writer thread,
+    so UART reception goes on while file system is busy.
+*/
+typedef struct
+{
+    rt_device_t dev;
+    struct rt_semaphore rx_sem;
+    struct rt_semaphore free_sem;       /* free block buffers */
+    rt_mq_t write_mq;
+    rt_err_t (*rx_ind_bak)(rt_device_t dev, rt_size_t size);
+    uint8_t *buf[ELM_TRANS_WINDOW];
+    uint16_t len[ELM_TRANS_WINDOW];
+    volatile int write_err;
+} elm_trans_win_t;
+
+static elm_trans_win_t *elm_win;
+
+static rt_err_t elm_trans_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    rt_sem_release(&elm_win->rx_sem);
+    return RT_EOK;
+}
+
+/* Read exactly len bytes, wait for rx indication when fifo is empty */
+static int elm_trans_read(elm_trans_win_t *win, uint8_t *buf, uint32_t len)
+{
+    uint32_t off = 0;
+
+    while (off < len)
+    {
+        rt_size_t delta = rt_device_read(win->dev, 0, &buf[off], len - off);
+
+        off += delta;
+        if ((0 == delta) && (RT_EOK != rt_sem_take(&win->rx_sem, rt_tick_from_millisecond(ELM_TRANS_TIMEOUT))))
+        {
+            return RT_ETIMEOUT;
+        }
+    }
+
+    return RT_EOK;
+}
+
+/* Find next frame header, skipping garbage left by a corrupted frame */
+static int elm_trans_read_hdr(elm_trans_win_t *win, uint8_t *hdr)
+{
+    int res;
+
+    res = elm_trans_read(win, hdr, ELM_TRANS_HDR_LEN);
+    while ((RT_EOK == res) && ((hdr[0] | (hdr[1] << 8)) != ELM_TRANS_MAGIC))
+    {
+        memmove(hdr, hdr + 1, ELM_TRANS_HDR_LEN - 1);
+        res = elm_trans_read(win, &hdr[ELM_TRANS_HDR_LEN - 1], 1);
+    }
+
+    return res;
+}
+
+static void elm_trans_writer(void *param)
+{
+    elm_trans_win_t *win = (elm_trans_win_t *)param;
+    uint32_t seq;
+
+    while (RT_EOK == rt_mq_recv(win->write_mq, &seq, sizeof(seq), RT_WAITING_FOREVER))
+    {
+        uint32_t slot = seq % ELM_TRANS_WINDOW;
+
+        if (UINT32_MAX == seq)
+        {
+            break;
+        }
+        if ((0 == win->write_err) && (write(elm_fptr, win->buf[slot], win->len[slot]) != win->len[slot]))
+        {
+            win->write_err = 1;
+        }
+        if (0 == win->write_err)
+        {
+            rt_kprintf("elm_ack %d\n", seq + 1);
+        }
+        rt_sem_release(&win->free_sem);
+    }
+    /* tell receiver writer is gone */
+    rt_sem_release(&win->free_sem);
+}
+
+static void elm_trans_win_free(elm_trans_win_t *win)
+{
+    if (win->write_mq)
+    {
+        rt_mq_delete(win->write_mq);
+    }
+    for (int i = 0; i < ELM_TRANS_WINDOW; i++)
+    {
+        if (win->buf[i])
+        {
+            rt_free(win->buf[i]);
+        }
+    }
+    rt_sem_detach(&win->rx_sem);
+    rt_sem_detach(&win->free_sem);
+    rt_free(win);
+    elm_win = RT_NULL;
+}
+
+static int elm_trans_in_win(char *file_path, char *file_size, char *crc_str)
+{
+    uint32_t size, crc1, crc2, cnt, expect, nak, start, ms;
+    uint8_t hdr[ELM_TRANS_HDR_LEN];
+    elm_trans_win_t *win;
+    rt_thread_t writer;
+    int res = RT_EOK;
+    int retry = 0;
+
+    size = strtoul(file_size, 0, 16);
+    crc1 = strtoul(crc_str, 0, 16);
+    cnt = (size + MAX_BLOCK_LEN - 1) / MAX_BLOCK_LEN;
+    crc2 = 0xffffffff;
+
+    CLOSE_ELM_FILE
+    FREE_ELM_BUF
+
+    win = (elm_trans_win_t *)rt_malloc(sizeof(elm_trans_win_t));
+    if (win == RT_NULL)
+    {
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+    memset(win, 0, sizeof(elm_trans_win_t));
+    elm_win = win;
+    rt_sem_init(&win->rx_sem, "elm_rx", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&win->free_sem, "elm_buf", ELM_TRANS_WINDOW, RT_IPC_FLAG_FIFO);
+#if RT_USING_CONSOLE
+    win->dev = rt_device_find(RT_CONSOLE_DEVICE_NAME);
+#else
+    win->dev = rt_device_find("uart1");
+#endif
+    win->write_mq = rt_mq_create("elm_wr", sizeof(uint32_t), ELM_TRANS_WINDOW + 1, RT_IPC_FLAG_FIFO);
+    for (int i = 0; i < ELM_TRANS_WINDOW; i++)
+    {
+        win->buf[i] = (uint8_t *)rt_malloc(MAX_BLOCK_LEN);
+        if (win->buf[i] == RT_NULL)
+        {
+            break;
+        }
+    }
+    if ((win->dev == RT_NULL) || (win->write_mq == RT_NULL) || (win->buf[ELM_TRANS_WINDOW - 1] == RT_NULL))
+    {
+        elm_trans_win_free(win);
+        rt_kprintf("malloc err: %d\n", MAX_BLOCK_LEN * ELM_TRANS_WINDOW);
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+
+    elm_fptr =  open(file_path, O_RDWR | O_TRUNC | O_CREAT | O_BINARY, 0);
+    if (elm_fptr < 0)
+    {
+        elm_trans_win_free(win);
+        rt_kprintf("open file err: %s\n", file_path);
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+    if (0 != ioctl(elm_fptr, F_RESERVE_CONT_SPACE, size))
+    {
+        CLOSE_ELM_FILE
+        elm_trans_win_free(win);
+        rt_kprintf("set continue space error:%d\n", size);
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+
+    writer = rt_thread_create("elm_wr", elm_trans_writer, win, 2048, RT_THREAD_PRIORITY_MAX / 2, 10);
+    if (writer == RT_NULL)
+    {
+        CLOSE_ELM_FILE
+        elm_trans_win_free(win);
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+    rt_thread_startup(writer);
+
+    /* shell is blocked in this command, take over its rx indication */
+    win->rx_ind_bak = win->dev->rx_indicate;
+    rt_device_set_rx_indicate(win->dev, elm_trans_rx_ind);
+
+    rt_kprintf("elm_trans_win %d %d\n", ELM_TRANS_WINDOW, MAX_BLOCK_LEN);
+    rt_kprintf("elm_trans_in_waitrx\n");
+
+    start = rt_tick_get();
+    expect = 0;
+    nak = UINT32_MAX;
+    while ((expect < cnt) && (RT_EOK == res))
+    {
+        uint32_t seq, len, crc, want;
+        uint8_t *buf;
+
+        res = elm_trans_read_hdr(win, hdr);
+        if ((RT_EOK != res) && (retry++ < 3))
+        {
+            /* tail of window is lost, ask host to go back */
+            rt_kprintf("elm_nak %d\n", expect);
+            nak = expect;
+            res = RT_EOK;
+            continue;
+        }
+        if (RT_EOK != res)
+        {
+            rt_kprintf("rx data outof timer 2s\n");
+            break;
+        }
+        seq = hdr[2] | (hdr[3] << 8);
+        len = hdr[4] | (hdr[5] << 8);
+        crc = hdr[6] | (hdr[7] << 8) | (hdr[8] << 16) | ((uint32_t)hdr[9] << 24);
+        want = ((expect == cnt - 1) && (size % MAX_BLOCK_LEN)) ? (size % MAX_BLOCK_LEN) : MAX_BLOCK_LEN;
+
+        if ((seq != expect) || (len != want))
+        {
+            /* Lost block or garbage, rest of the window is dropped until host goes back */
+            if (nak != expect)
+            {
+                rt_kprintf("elm_nak %d\n", expect);
+                nak = expect;
+            }
+            continue;
+        }
+
+        rt_sem_take(&win->free_sem, RT_WAITING_FOREVER);
+        if (win->write_err)
+        {
+            res = RT_ERROR;
+            rt_kprintf("write file err\n");
+            break;
+        }
+        buf = win->buf[seq % ELM_TRANS_WINDOW];
+        res = elm_trans_read(win, buf, len);
+        if ((RT_EOK == res) && (getCrc(buf, len, 0xffffffff) != crc))
+        {
+            rt_sem_release(&win->free_sem);
+            rt_kprintf("elm_nak %d\n", expect);
+            nak = expect;
+            continue;
+        }
+        if (RT_EOK != res)
+        {
+            rt_sem_release(&win->free_sem);
+            rt_kprintf("rx data outof timer 2s\n");
+            break;
+        }
+
+        crc2 = getCrc(buf, len, crc2);
+        win->len[seq % ELM_TRANS_WINDOW] = len;
+        rt_mq_send(win->write_mq, &seq, sizeof(seq));
+        expect++;
+        retry = 0;
+    }
+    rt_device_set_rx_indicate(win->dev, win->rx_ind_bak);
+
+    /* wait for all blocks written, then stop writer */
+    for (int i = 0; i < ELM_TRANS_WINDOW; i++)
+    {
+        rt_sem_take(&win->free_sem, RT_WAITING_FOREVER);
+    }
+    expect = UINT32_MAX;
+    rt_mq_send(win->write_mq, &expect, sizeof(expect));
+    rt_sem_take(&win->free_sem, RT_WAITING_FOREVER);
+    ms = (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND;
+
+    if (win->write_err)
+    {
+        res = RT_ERROR;
+        rt_kprintf("write file err\n");
+    }
+    CLOSE_ELM_FILE
+    elm_trans_win_free(win);
+
+    if (RT_EOK != res)
+    {
+        rt_kprintf("elm_trans_in FAIL\n");
+        return RT_ERROR;
+    }
+
+    rt_kprintf("elm_trans_rate %d bytes %d ms %d KB/s\n", size, ms, ms ? size / ms * 1000 / 1024 : 0);
+    if (crc2 == crc1)
+    {
+        rt_kprintf("crc2(0x%08x) == crc1(0x%08x)\n", crc2, crc1);
+        rt_kprintf("elm_trans_in OK\n");
+    }
+    else
+    {
+        rt_kprintf("crc2(0x%08x) != crc1(0x%08x)\n", crc2, crc1);
+        rt_kprintf("elm_trans_in FAIL\n");
+    }
+
+    return RT_EOK;
+}
+
+static int elm_trans_baud(char *baud_str)
+{
+    uint32_t baud = strtoul(baud_str, 0, 10);
+    struct rt_serial_device *serial;
+#if RT_USING_CONSOLE
+    rt_device_t pDev = rt_device_find(RT_CONSOLE_DEVICE_NAME);
+#else
+    rt_device_t pDev = rt_device_find("uart1");
+#endif
+    struct serial_configure cfg;
+
+    if ((pDev == RT_NULL) || (pDev->type != RT_Device_Class_Char) || (baud < BAUD_RATE_9600))
+    {
+        rt_kprintf("elm_trans_baud FAIL\n");
+        return RT_ERROR;
+    }
+    if (baud > ELM_TRANS_MAX_BAUD)
+    {
+        baud = ELM_TRANS_MAX_BAUD;
+    }
+
+    /* answer at old baud rate, host switches after it gets the line */
+    rt_kprintf("elm_trans_baud %d OK\n", baud);
+    rt_thread_mdelay(50);
+
+    serial = (struct rt_serial_device *)pDev;
+    cfg = serial->config;
+    cfg.baud_rate = baud;
+    rt_device_control(pDev, RT_DEVICE_CTRL_CONFIG, &cfg);
+
+    return RT_EOK;
+}
+
 static int elm_trans_test(int argc, char **argv)
 {
     int res;
@@ -350,6 +705,8 @@ static int elm_trans_test(int argc, char **argv)
         rt_kprintf("eg1: elm_trans_test 1 /test.bin (get test.bin file size)\n");
         rt_kprintf("eg1: elm_trans_test 2 /test.bin 0x20000 (trans test.bin file out)\n");
         rt_kprintf("eg1: elm_trans_test 3 /test.bin 0x20000 0x12345678(trans test.bin file in)\n");
+        rt_kprintf("eg1: elm_trans_test 4 /test.bin 0x20000 0x12345678(trans test.bin file in, windowed)\n");
+        rt_kprintf("eg1: elm_trans_test 5 3000000 (change baud rate)\n");
         rt_kprintf("elm_trans_test FAIL\n");
         return RT_ERROR;
     }
@@ -388,6 +745,26 @@ static int elm_trans_test(int argc, char **argv)
         }
         return  elm_trans_in(argv[2], argv[3], argv[4]);
     }
+    else if (argv[1][0] == '4')
+    {
+        if (argc != 5)
+        {
+            rt_kprintf("para num %d != 5\n", argc);
+            rt_kprintf("elm_trans_in FAIL\n");
+            return RT_ERROR;
+        }
+        return  elm_trans_in_win(argv[2], argv[3], argv[4]);
+    }
+    else if (argv[1][0] == '5')
+    {
+        if (argc != 3)
+        {
+            rt_kprintf("para num %d != 3\n", argc);
+            rt_kprintf("elm_trans_baud FAIL\n");
+            return RT_ERROR;
+        }
+        return  elm_trans_baud(argv[2]);
+    }
 
     return 0;
 }
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+#
+# Host side of elm_trans_test, copy a file to device file system over the console UART
+#
+# usage: elm_trans.py <port> <local file> <device path> [--baud N] [--legacy] [--compare]
+#   --baud N    switch console to N before transfer (elm_trans_test 5), device may clamp it
+#               to ELM_TRANS_MAX_BAUD, console is left at the new baud rate
+#   --legacy    use stop-and-wait transfer (elm_trans_test 3)
+#   --compare   transfer with both protocols and print MB/s of each
+#
+# Windowed transfer (elm_trans_test 4) keeps up to ELM_TRANS_WINDOW blocks in flight, frames are
+#   magic(2, "EW") seq(2) len(2) crc(4) payload(len), little endian
+# device acks with "elm_ack <n>" once block n-1 is written, "elm_nak <n>" makes host go back to n.
+#
+# Requires pyserial.
+#
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+BLOCK = 8 * 1024
+MAGIC = 0x5745
+TIMEOUT = 5.0
+
+
+def crc32mpeg2(data, crc=0xFFFFFFFF):
+    table = crc32mpeg2.table
+    for b in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ table[((crc >> 24) ^ b) & 0xFF]
+    return crc
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        c = i << 24
+        for _ in range(8):
+            c = ((c << 1) ^ 0x04C11DB7) if (c & 0x80000000) else (c << 1)
+        table.append(c & 0xFFFFFFFF)
+    return table
+
+
+crc32mpeg2.table = _crc_table()
+
+
+class Console:
+    def __init__(self, port, baud):
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.pending = b''
+
+    def command(self, cmd):
+        self.ser.reset_input_buffer()
+        self.pending = b''
+        self.ser.write(cmd.encode() + b'\r\n')
+
+    def line(self, timeout=TIMEOUT):
+        """Next line from device, None on timeout"""
+        end = time.time() + timeout
+        while b'\n' not in self.pending:
+            if time.time() > end:
+                return None
+            self.pending += self.ser.read(self.ser.in_waiting or 1)
+        line, self.pending = self.pending.split(b'\n', 1)
+        return line.decode(errors='replace').strip()
+
+    def wait(self, *tokens, timeout=TIMEOUT):
+        """Wait for a line starting with one of tokens"""
+        end = time.time() + timeout
+        while time.time() < end:
+            line = self.line(end - time.time())
+            if line is None:
+                break
+            for t in tokens:
+                if line.startswith(t):
+                    return line
+        raise RuntimeError('timeout waiting for %s' % ' / '.join(tokens))
+
+
+def set_baud(con, baud):
+    con.command('elm_trans_test 5 %d' % baud)
+    line = con.wait('elm_trans_baud')
+    if not line.endswith('OK'):
+        raise RuntimeError(line)
+    baud = int(line.split()[1])
+    time.sleep(0.02)
+    con.ser.baudrate = baud
+    time.sleep(0.1)
+    con.command('elm_trans_test 0')
+    con.wait('elm_trans_test NEW')
+    return baud
+
+
+def push_legacy(con, data, path):
+    con.command('elm_trans_test 3 %s 0x%x 0x%08x' % (path, len(data), crc32mpeg2(data)))
+    for off in range(0, len(data), BLOCK):
+        con.wait('elm_trans_in_waitrx', 'elm_trans_in FAIL')
+        con.ser.write(data[off:off + BLOCK])
+    return con.wait('elm_trans_in OK', 'elm_trans_in FAIL', timeout=30)
+
+
+def push_window(con, data, path):
+    con.command('elm_trans_test 4 %s 0x%x 0x%08x' % (path, len(data), crc32mpeg2(data)))
+    line = con.wait('elm_trans_win', 'elm_trans_in FAIL')
+    if 'FAIL' in line:
+        return line
+    window, block = [int(x) for x in line.split()[1:3]]
+    con.wait('elm_trans_in_waitrx')
+
+    frames = []
+    for seq, off in enumerate(range(0, len(data), block)):
+        payload = data[off:off + block]
+        frames.append(struct.pack('<HHHI', MAGIC, seq & 0xFFFF, len(payload), crc32mpeg2(payload)) + payload)
+
+    base = nxt = 0
+    while base < len(frames):
+        while nxt < len(frames) and nxt < base + window:
+            con.ser.write(frames[nxt])
+            nxt += 1
+        line = con.line(1.0)
+        if line is None:
+            # nothing acked for a while, resend window
+            nxt = base
+        elif line.startswith('elm_ack'):
+            base = max(base, int(line.split()[1]))
+        elif line.startswith('elm_nak'):
+            base = int(line.split()[1])
+            nxt = base
+        elif line.startswith('elm_trans_in FAIL'):
+            return line
+    return con.wait('elm_trans_in OK', 'elm_trans_in FAIL', timeout=30)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Copy file to device over console UART')
+    parser.add_argument('port')
+    parser.add_argument('local')
+    parser.add_argument('path')
+    parser.add_argument('--init-baud', type=int, default=1000000, help='current console baud rate')
+    parser.add_argument('--baud', type=int, default=0)
+    parser.add_argument('--legacy', action='store_true')
+    parser.add_argument('--compare', action='store_true')
+    args = parser.parse_args()
+
+    with open(args.local, 'rb') as f:
+        data = f.read()
+
+    con = Console(args.port, args.init_baud)
+    if args.baud:
+        print('baud rate %d' % set_baud(con, args.baud))
+
+    if args.compare:
+        runs = [('stop-and-wait', push_legacy), ('windowed', push_window)]
+    elif args.legacy:
+        runs = [('stop-and-wait', push_legacy)]
+    else:
+        runs = [('windowed', push_window)]
+
+    ok = True
+    for name, push in runs:
+        start = time.time()
+        result = push(con, data, args.path)
+        used = time.time() - start
+        ok = ok and result.endswith('OK')
+        print('%-14s %s %d bytes in %.2f s, %.3f MB/s (%.0f%% of line rate)' %
+              (name, result, len(data), used, len(data) / used / 1e6,
+               len(data) * 10 / used * 100 / con.ser.baudrate))
+
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -61,6 +61,29 @@
 
 #define EPIC_TIMEOUT_MS  (100)
 
+#ifndef EZIPA_AHEAD_THREAD_PRIORITY
+    #define EZIPA_AHEAD_THREAD_PRIORITY   (15)
+#endif
+#ifndef EZIPA_AHEAD_THREAD_STACK_SIZE
+    #define EZIPA_AHEAD_THREAD_STACK_SIZE (1024)
+#endif
+#define EZIPA_AHEAD_TIMEOUT_MS  (1000)
+
+struct ezipa_ahead
+{
+    /* output buffers used in turn */
+    uint8_t *buf[2];
+    struct rt_work work;
+    struct rt_semaphore done;
+    /* next frame is being decoded */
+    bool pending;
+    /* next frame is decoded into output_buf */
+    bool ready;
+};
+
+/* shared by all objects, decoding is serialized by EPIC anyway */
+static struct rt_workqueue *ezipa_ahead_wq;
+
 #define EZ_IS_IN_SRAM_RANGE(addr)    ((((addr) >= HPSYS_RAM0_BASE) && ((addr) < HPSYS_RAM_END)) ? true : false)
 
 
@@ -536,6 +559,27 @@ static bool ezipa_is_file(const uint8_t *data)
 }
 
 
+/* Return XIP address of ezipa data if file is contiguous in mapped flash, e.g. romfs */
+static const uint8_t *ezipa_map_file(const char *filename)
+{
+    const uint8_t *data = NULL;
+    struct stat stat_buf;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if ((RT_EOK == fstat(fd, &stat_buf)) && (stat_buf.st_size > EZ_FILE_LEADING_HDR_SIZE))
+    {
+        data = dfs_mmap(fd, EZ_FILE_LEADING_HDR_SIZE, stat_buf.st_size - EZ_FILE_LEADING_HDR_SIZE);
+    }
+    close(fd);
+
+    return data;
+}
+
 static void ezipa_init_file_mode(ezipa_obj_t *obj, const char *filename)
 {
     ezipa_hdr_t hdr;
@@ -950,6 +994,150 @@ static int32_t ezipa_render_next_frame(ezipa_obj_t *obj, ezipa_canvas_t *canvas)
     return error;
 }
 
+static void ezipa_update_perf(ezipa_obj_t *obj, uint32_t start_ms)
+{
+    uint32_t ms = rt_tick_get_millisecond() - start_ms;
+
+    obj->perf.frame_cnt++;
+    obj->perf.last_decode_ms = ms;
+    obj->perf.total_decode_ms += ms;
+    if (ms > obj->perf.max_decode_ms)
+    {
+        obj->perf.max_decode_ms = ms;
+    }
+}
+
+static int32_t ezipa_decode_next_frame(ezipa_obj_t *obj, ezipa_canvas_t *canvas)
+{
+    int32_t error;
+    uint32_t start_ms = rt_tick_get_millisecond();
+
+    error = ezipa_render_next_frame(obj, canvas);
+    ezipa_update_perf(obj, start_ms);
+
+    return error;
+}
+
+static bool ezipa_has_next_frame(ezipa_obj_t *obj)
+{
+    return (0 == obj->header.play_num) || (obj->play_idx != obj->header.play_num);
+}
+
+static void ezipa_copy_output_buf(ezipa_obj_t *obj, uint8_t *src, uint8_t *dst)
+{
+    EPIC_HandleTypeDef *epic;
+    HAL_StatusTypeDef status;
+    rt_err_t err;
+
+    EPIC_BlendingDataType bg;
+    EPIC_BlendingDataType out;
+
+    HAL_EPIC_BlendDataInit(&bg);
+    HAL_EPIC_BlendDataInit(&out);
+
+    epic = drv_get_epic_handle();
+    RT_ASSERT(epic);
+
+    bg.data = src;
+    bg.color_mode = obj->epic_color_fmt;
+    bg.height = obj->header.height;
+    bg.x_offset = 0;
+    bg.y_offset = 0;
+    bg.total_width = obj->header.width;
+    bg.width = obj->header.width;
+    bg.color_en = false;
+
+    memcpy(&out, &bg, sizeof(out));
+    out.data = dst;
+
+    epic->XferCpltCallback = epic_cplt_callback;
+    epic->user_data = (void *)obj;
+
+    status = HAL_EPIC_Copy_IT(epic, &bg, &out);
+    RT_ASSERT(HAL_OK == status);
+
+    /* wait for complete */
+    err = rt_sem_take(&obj->sem, EPIC_TIMEOUT_MS);
+    RT_ASSERT(RT_EOK == err);
+}
+
+/* Decode next frame in background, composed on a copy of the displayed frame */
+static void ezipa_ahead_work(struct rt_work *work, void *work_data)
+{
+    ezipa_obj_t *obj = (ezipa_obj_t *)work_data;
+    EZIP_HandleTypeDef *old_ezip_handle;
+    EPIC_HandleTypeDef *epic_handle;
+    uint32_t start_ms;
+    rt_err_t err;
+
+    err = drv_epic_take(EPIC_TIMEOUT_MS);
+    RT_ASSERT(RT_EOK == err);
+
+    epic_handle = drv_get_epic_handle();
+    old_ezip_handle = epic_handle->hezip;
+    epic_handle->hezip = obj->ezip_handle;
+
+    start_ms = rt_tick_get_millisecond();
+    ezipa_copy_output_buf(obj, obj->disp_buf, obj->output_buf);
+    ezipa_render_next_frame(obj, NULL);
+    ezipa_update_perf(obj, start_ms);
+
+    if (IS_DCACHED_RAM((uint32_t)obj->output_buf))
+    {
+        mpu_dcache_invalidate(obj->output_buf, obj->header.width * obj->header.height * obj->pixel_size);
+    }
+
+    epic_handle->hezip = old_ezip_handle;
+
+    err = drv_epic_release();
+    RT_ASSERT(RT_EOK == err);
+
+    err = rt_sem_release(&obj->ahead->done);
+    RT_ASSERT(RT_EOK == err);
+}
+
+static void ezipa_ahead_wait(ezipa_obj_t *obj)
+{
+    struct ezipa_ahead *ahead = obj->ahead;
+    uint32_t start_ms;
+    uint32_t ms;
+    rt_err_t err;
+
+    if (!ahead->pending)
+    {
+        return;
+    }
+
+    start_ms = rt_tick_get_millisecond();
+    if (RT_EOK != rt_sem_trytake(&ahead->done))
+    {
+        err = rt_sem_take(&ahead->done, EZIPA_AHEAD_TIMEOUT_MS);
+        RT_ASSERT(RT_EOK == err);
+
+        ms = rt_tick_get_millisecond() - start_ms;
+        obj->perf.late_cnt++;
+        if (ms > obj->perf.max_wait_ms)
+        {
+            obj->perf.max_wait_ms = ms;
+        }
+    }
+    ahead->pending = false;
+    ahead->ready = true;
+}
+
+static void ezipa_ahead_start(ezipa_obj_t *obj)
+{
+    struct ezipa_ahead *ahead = obj->ahead;
+    rt_err_t err;
+
+    /* decode into the buffer not displayed */
+    obj->output_buf = (obj->disp_buf == ahead->buf[0]) ? ahead->buf[1] : ahead->buf[0];
+    ahead->pending = true;
+
+    err = rt_workqueue_dowork(ezipa_ahead_wq, &ahead->work);
+    RT_ASSERT(RT_EOK == err);
+}
+
 static int32_t ezipa_render_curr_frame(ezipa_obj_t *obj, ezipa_canvas_t *canvas)
 {
     EPIC_BlendingDataType fg;
@@ -968,7 +1156,7 @@ static int32_t ezipa_render_curr_frame(ezipa_obj_t *obj, ezipa_canvas_t *canvas)
     RT_ASSERT(epic);
 
     /* update canvas buf */
-    fg.data = (uint8_t *)obj->output_buf;
+    fg.data = (uint8_t *)obj->disp_buf;
     fg.color_mode = obj->epic_color_fmt;
     fg.height = obj->header.height;
     fg.x_offset = canvas->x_offset;
@@ -1017,6 +1205,9 @@ ezipa_obj_t *ezipa_open(const void *data, ezipa_color_fmt_t output_color_fmt)
     EPIC_HandleTypeDef *epic_handle;
     rt_err_t err;
     IRQn_Type ezip_irqn;
+#ifdef RT_USING_DFS
+    const uint8_t *xip_data;
+#endif /* RT_USING_DFS */
 
     obj = NULL;
     if (!data)
@@ -1077,7 +1268,13 @@ ezipa_obj_t *ezipa_open(const void *data, ezipa_color_fmt_t output_color_fmt)
     }
 
 #ifdef RT_USING_DFS
-    if (ezipa_is_file(data))
+    if (ezipa_is_file(data) && (NULL != (xip_data = ezipa_map_file(data))))
+    {
+        /* Decode from flash directly, no frame buffer in RAM needed */
+        obj->fd = -1;
+        obj->ezipa_data = (uint8_t *)xip_data;
+    }
+    else if (ezipa_is_file(data))
     {
         ezipa_init_file_mode(obj, data);
         if (obj->fd < 0)
@@ -1185,6 +1382,7 @@ ezipa_obj_t *ezipa_open(const void *data, ezipa_color_fmt_t output_color_fmt)
         LOG_D("Fail to allocate output buf:%dx%dx%d\n", obj->header.width, obj->header.height, obj->pixel_size);
         goto __EXIT;
     }
+    obj->disp_buf = obj->output_buf;
     obj->output_color_fmt = output_color_fmt;
     obj->play_idx = 0;
     obj->valid_curr_frame = false;
@@ -1216,6 +1414,11 @@ int32_t ezipa_close(ezipa_obj_t *obj)
         return -1;
     }
 
+    if (obj->ahead)
+    {
+        ezipa_set_decode_ahead(obj, false);
+    }
+
     err = rt_sem_detach(&obj->sem);
     RT_ASSERT(RT_EOK == err);
 
@@ -1255,6 +1458,7 @@ int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next)
     EZIP_HandleTypeDef *old_ezip_handle;
     EPIC_HandleTypeDef *epic_handle;
     uint32_t canvas_size = 0;
+    bool start_ahead = false;
 
     error = 0;
     if (!obj)
@@ -1277,6 +1481,11 @@ int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next)
 
     RT_ASSERT(obj->ezip_handle);
 
+    if (obj->ahead)
+    {
+        ezipa_ahead_wait(obj);
+    }
+
     err = drv_epic_take(EPIC_TIMEOUT_MS);
     RT_ASSERT(RT_EOK == err);
 
@@ -1290,9 +1499,24 @@ int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next)
         mpu_dcache_clean(canvas->buf, canvas_size);
     }
 
-    if (next)
+    if (next && obj->ahead)
+    {
+        if (!obj->ahead->ready)
+        {
+            /* first frame, nothing decoded ahead */
+            error = ezipa_decode_next_frame(obj, NULL);
+        }
+        obj->ahead->ready = false;
+        obj->disp_buf = obj->output_buf;
+        if (canvas)
+        {
+            error = ezipa_render_curr_frame(obj, canvas);
+        }
+        start_ahead = ezipa_has_next_frame(obj);
+    }
+    else if (next)
     {
-        error = ezipa_render_next_frame(obj, canvas);
+        error = ezipa_decode_next_frame(obj, canvas);
     }
     else if (canvas)
     {
@@ -1300,9 +1524,9 @@ int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next)
         error = ezipa_render_curr_frame(obj, canvas);
     }
 
-    if (IS_DCACHED_RAM((uint32_t)obj->output_buf))
+    if (IS_DCACHED_RAM((uint32_t)obj->disp_buf))
     {
-        mpu_dcache_invalidate(obj->output_buf, obj->header.width * obj->header.height * obj->pixel_size);
+        mpu_dcache_invalidate(obj->disp_buf, obj->header.width * obj->header.height * obj->pixel_size);
     }
 
     if (canvas_size > 0)
@@ -1315,10 +1539,112 @@ int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next)
     err = drv_epic_release();
     RT_ASSERT(RT_EOK == err);
 
+    if (start_ahead)
+    {
+        ezipa_ahead_start(obj);
+    }
+
 __EXIT:
 
     return error;
 }
 
+int32_t ezipa_set_decode_ahead(ezipa_obj_t *obj, bool enable)
+{
+    struct ezipa_ahead *ahead;
+    uint32_t buf_size;
+    rt_err_t err;
+
+    if (!obj)
+    {
+        return -1;
+    }
+
+    ahead = obj->ahead;
+    if (enable == (NULL != ahead))
+    {
+        return 0;
+    }
+
+    buf_size = obj->header.width * obj->header.height * obj->pixel_size;
+
+    if (enable)
+    {
+        if (!ezipa_ahead_wq)
+        {
+            ezipa_ahead_wq = rt_workqueue_create("ezipa", EZIPA_AHEAD_THREAD_STACK_SIZE, EZIPA_AHEAD_THREAD_PRIORITY);
+            if (!ezipa_ahead_wq)
+            {
+                return -2;
+            }
+        }
+
+        ahead = rt_malloc(sizeof(*ahead));
+        if (!ahead)
+        {
+            return -2;
+        }
+        memset(ahead, 0, sizeof(*ahead));
+
+        ahead->buf[0] = obj->output_buf;
+        ahead->buf[1] = EZIPA_LARGE_BUF_MALLOC(buf_size);
+        if (!ahead->buf[1])
+        {
+            LOG_D("Fail to allocate decode-ahead buf:%d\n", buf_size);
+            rt_free(ahead);
+            return -2;
+        }
+        if (IS_DCACHED_RAM((uint32_t)ahead->buf[1]))
+        {
+            mpu_dcache_clean(ahead->buf[1], buf_size);
+        }
+
+        err = rt_sem_init(&ahead->done, "ezipa_ahd", 0, RT_IPC_FLAG_FIFO);
+        RT_ASSERT(RT_EOK == err);
+        rt_work_init(&ahead->work, ezipa_ahead_work, obj);
+
+        obj->disp_buf = obj->output_buf;
+        obj->ahead = ahead;
+    }
+    else
+    {
+        ezipa_ahead_wait(obj);
+
+        /* keep latest decoded frame, the other one is freed */
+        obj->disp_buf = obj->output_buf;
+        if (obj->output_buf == ahead->buf[0])
+        {
+            EZIPA_LARGE_BUF_FREE(ahead->buf[1]);
+        }
+        else
+        {
+            EZIPA_LARGE_BUF_FREE(ahead->buf[0]);
+        }
+
+        err = rt_sem_detach(&ahead->done);
+        RT_ASSERT(RT_EOK == err);
+        rt_free(ahead);
+        obj->ahead = NULL;
+    }
+
+    return 0;
+}
+
+int32_t ezipa_get_perf(ezipa_obj_t *obj, ezipa_perf_t *perf, bool reset)
+{
+    if (!obj || !perf)
+    {
+        return -1;
+    }
+
+    memcpy(perf, &obj->perf, sizeof(*perf));
+    if (reset)
+    {
+        memset(&obj->perf, 0, sizeof(obj->perf));
+    }
+
+    return 0;
+}
+
 
 
@@ -64,6 +64,22 @@
 
 #define FL_PACKET_LEN(data_len)    ((data_len) + sizeof(fl_packet_hdr_t) + sizeof(fl_packet_tail_t))
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+#ifndef FILE_LOGGER_ASYNC_BUF_SIZE
+    #define FILE_LOGGER_ASYNC_BUF_SIZE   (4096)
+#endif
+#ifndef FILE_LOGGER_ASYNC_ALIGN
+    #define FILE_LOGGER_ASYNC_ALIGN      (4096)
+#endif
+#ifndef FILE_LOGGER_ASYNC_FLUSH_MS
+    #define FILE_LOGGER_ASYNC_FLUSH_MS   (1000)
+#endif
+#if FILE_LOGGER_ASYNC_BUF_SIZE < FILE_LOGGER_ASYNC_ALIGN
+    #error "FILE_LOGGER_ASYNC_BUF_SIZE cannot be less than FILE_LOGGER_ASYNC_ALIGN"
+#endif
+#define FL_ASYNC_THREAD_STACK_SIZE   (2048)
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
 typedef struct
 {
     int fd;
@@ -106,8 +122,37 @@ typedef struct
     /* true: reach the file end and go the beginning */
     bool turnaround;
     fl_file_hdr_t cursor;
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    struct fl_async_tag *async;
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
 } fl_handle_t;
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+/*
+    Written data is a byte stream, packets may span the two buffers.
+    Active buffer is swapped when fill reaches target, i.e. the file offset
+    of next sector boundary, so background write always ends at sector boundary
+    except for flush.
+*/
+typedef struct fl_async_tag
+{
+    rt_list_t node;
+    fl_handle_t *owner;
+    struct rt_mutex lock;   /* serialize file access of writer thread and API */
+    uint8_t *buf[2];
+    uint8_t act;            /* index of buffer being filled */
+    uint32_t fill;
+    uint32_t target;
+    uint32_t act_pos;       /* data position where active buffer starts */
+    uint32_t pend_len;      /* bytes in the other buffer to be written, 0 if it's free */
+    uint32_t drop_cnt;
+} fl_async_t;
+
+static rt_list_t fl_async_list = RT_LIST_OBJECT_INIT(fl_async_list);
+static struct rt_mutex fl_async_list_lock;
+static rt_mailbox_t fl_async_mb;
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
 
 static fl_err_t fl_write_file(fl_handle_t *handle, void *data, uint32_t data_len)
 {
@@ -326,6 +371,271 @@ __EXIT:
     return err;
 }
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+static uint32_t fl_async_get_target(fl_handle_t *handle, uint32_t pos)
+{
+    return FILE_LOGGER_ASYNC_BUF_SIZE - (FL_FILE_OFFSET(pos) % FILE_LOGGER_ASYNC_ALIGN);
+}
+
+/* Must be called with interrupt disabled and the other buffer free */
+static void fl_async_swap(fl_handle_t *handle)
+{
+    fl_async_t *async = handle->async;
+
+    async->pend_len = async->fill;
+    async->act ^= 1;
+    async->act_pos = (async->act_pos + async->fill) % handle->max_size;
+    async->fill = 0;
+    async->target = fl_async_get_target(handle, async->act_pos);
+}
+
+/* Must be called with interrupt disabled, return true if a buffer is ready to write */
+static bool fl_async_put(fl_handle_t *handle, const void *data, uint32_t data_len)
+{
+    fl_async_t *async = handle->async;
+    uint32_t len;
+    bool swapped = false;
+
+    while (data_len > 0)
+    {
+        len = async->target - async->fill;
+        if (len > data_len)
+        {
+            len = data_len;
+        }
+        memcpy(async->buf[async->act] + async->fill, data, len);
+        async->fill += len;
+        data = (const uint8_t *)data + len;
+        data_len -= len;
+        if ((async->fill == async->target) && (0 == async->pend_len))
+        {
+            fl_async_swap(handle);
+            swapped = true;
+        }
+    }
+
+    return swapped;
+}
+
+static fl_err_t fl_async_write(fl_handle_t *handle, bool has_header, void *data, uint32_t data_len)
+{
+    fl_async_t *async = handle->async;
+    fl_packet_hdr_t packet_hdr;
+    fl_packet_tail_t packet_tail;
+    uint32_t total_len = has_header ? FL_PACKET_LEN(data_len) : data_len;
+    uint32_t space;
+    rt_base_t level;
+    bool swapped;
+
+    level = rt_hw_interrupt_disable();
+    space = async->target - async->fill;
+    if ((total_len > space)
+            && (async->pend_len
+                || (total_len > space + fl_async_get_target(handle, (async->act_pos + async->target) % handle->max_size))))
+    {
+        async->drop_cnt++;
+        rt_hw_interrupt_enable(level);
+        return FL_DROPPED;
+    }
+
+    if (has_header)
+    {
+        packet_hdr.magic = FL_PACKET_HDR_MAGIC;
+        packet_hdr.len = data_len;
+        packet_tail.magic = FL_PACKET_TAIL_MAGIC;
+        swapped = fl_async_put(handle, &packet_hdr, sizeof(packet_hdr));
+        swapped |= fl_async_put(handle, data, data_len);
+        swapped |= fl_async_put(handle, &packet_tail, sizeof(packet_tail));
+    }
+    else
+    {
+        swapped = fl_async_put(handle, data, data_len);
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (swapped)
+    {
+        rt_mb_send(fl_async_mb, (rt_ubase_t)handle);
+    }
+
+    return FL_OK;
+}
+
+/* Write pending buffer, and partially filled active buffer if all is true */
+static fl_err_t fl_async_process(fl_handle_t *handle, bool all)
+{
+    fl_async_t *async = handle->async;
+    fl_err_t err = FL_OK;
+    rt_base_t level;
+    uint32_t len;
+    uint8_t *buf;
+
+    rt_mutex_take(&async->lock, RT_WAITING_FOREVER);
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        if ((0 == async->pend_len) && (async->fill > 0)
+                && (all || (async->fill == async->target)))
+        {
+            fl_async_swap(handle);
+        }
+        len = async->pend_len;
+        buf = async->buf[async->act ^ 1];
+        rt_hw_interrupt_enable(level);
+
+        if (0 == len)
+        {
+            break;
+        }
+
+        if (lseek(handle->fd, FL_FILE_OFFSET(handle->cursor.wr_pos), SEEK_SET) != FL_FILE_OFFSET(handle->cursor.wr_pos))
+        {
+            err = FL_WRITE_ERR;
+        }
+        else
+        {
+            err = fl_write_file(handle, buf, len);
+        }
+        if (FL_OK != err)
+        {
+            LOG_W("async write fail %d", err);
+        }
+
+        level = rt_hw_interrupt_disable();
+        async->pend_len = 0;
+        rt_hw_interrupt_enable(level);
+    }
+    rt_mutex_release(&async->lock);
+
+    return err;
+}
+
+static void fl_async_thread_entry(void *param)
+{
+    rt_ubase_t value;
+    rt_list_t *iter;
+    fl_async_t *async;
+    rt_err_t err;
+
+    while (1)
+    {
+        err = rt_mb_recv(fl_async_mb, &value, rt_tick_from_millisecond(FILE_LOGGER_ASYNC_FLUSH_MS));
+
+        rt_mutex_take(&fl_async_list_lock, RT_WAITING_FOREVER);
+        rt_list_for_each(iter, &fl_async_list)
+        {
+            async = rt_list_entry(iter, fl_async_t, node);
+            /* mailbox may have handle already closed, only process handle still in list */
+            if (RT_EOK != err)
+            {
+                /* write buffered data after idle */
+                fl_async_process(async->owner, true);
+            }
+            else if (async->owner == (fl_handle_t *)value)
+            {
+                fl_async_process((fl_handle_t *)value, false);
+                break;
+            }
+        }
+        rt_mutex_release(&fl_async_list_lock);
+    }
+}
+
+static void fl_async_lock(fl_handle_t *handle)
+{
+    if (handle->async)
+    {
+        rt_mutex_take(&handle->async->lock, RT_WAITING_FOREVER);
+        fl_async_process(handle, true);
+    }
+}
+
+static void fl_async_unlock(fl_handle_t *handle)
+{
+    if (handle->async)
+    {
+        rt_mutex_release(&handle->async->lock);
+    }
+}
+
+fl_err_t file_logger_enable_async(void *logger)
+{
+    fl_handle_t *handle = (fl_handle_t *)logger;
+    fl_async_t *async;
+    rt_thread_t tid;
+
+    RT_ASSERT(logger);
+
+    if (handle->async)
+    {
+        return FL_OK;
+    }
+
+    rt_enter_critical();
+    if (!fl_async_mb)
+    {
+        rt_mutex_init(&fl_async_list_lock, "fl_async", RT_IPC_FLAG_FIFO);
+        fl_async_mb = rt_mb_create("fl_async", 8, RT_IPC_FLAG_FIFO);
+        RT_ASSERT(fl_async_mb);
+        tid = rt_thread_create("fl_async", fl_async_thread_entry, NULL,
+                               FL_ASYNC_THREAD_STACK_SIZE, RT_THREAD_PRIORITY_IDLE - 2, 10);
+        RT_ASSERT(tid);
+        rt_thread_startup(tid);
+    }
+    rt_exit_critical();
+
+    async = rt_malloc(sizeof(*async) + 2 * FILE_LOGGER_ASYNC_BUF_SIZE);
+    if (!async)
+    {
+        return FL_ERROR;
+    }
+    memset(async, 0, sizeof(*async));
+    async->owner = handle;
+    async->buf[0] = (uint8_t *)(async + 1);
+    async->buf[1] = async->buf[0] + FILE_LOGGER_ASYNC_BUF_SIZE;
+    async->act_pos = handle->cursor.wr_pos;
+    rt_mutex_init(&async->lock, "fl_async", RT_IPC_FLAG_FIFO);
+
+    rt_mutex_take(&fl_async_list_lock, RT_WAITING_FOREVER);
+    handle->async = async;
+    async->target = fl_async_get_target(handle, async->act_pos);
+    rt_list_insert_before(&fl_async_list, &async->node);
+    rt_mutex_release(&fl_async_list_lock);
+
+    return FL_OK;
+}
+
+uint32_t file_logger_get_drop_cnt(void *logger)
+{
+    fl_handle_t *handle = (fl_handle_t *)logger;
+
+    RT_ASSERT(logger);
+
+    return handle->async ? handle->async->drop_cnt : 0;
+}
+
+static void fl_async_disable(fl_handle_t *handle)
+{
+    fl_async_t *async = handle->async;
+
+    if (!async)
+    {
+        return;
+    }
+
+    rt_mutex_take(&fl_async_list_lock, RT_WAITING_FOREVER);
+    fl_async_process(handle, true);
+    rt_list_remove(&async->node);
+    handle->async = NULL;
+    rt_mutex_release(&fl_async_list_lock);
+
+    rt_mutex_detach(&async->lock);
+    rt_free(async);
+}
+#else
+#define fl_async_lock(handle)
+#define fl_async_unlock(handle)
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
 
 void *file_logger_init(const char *name, uint32_t max_size)
 {
@@ -363,6 +673,9 @@ void *file_logger_init(const char *name, uint32_t max_size)
 
     handle->fd = fd;
     handle->name = name;
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    handle->async = NULL;
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
     handle->max_size = max_size - FL_FILE_HDR_SIZE;
     if (is_new)
     {
@@ -475,6 +788,14 @@ fl_err_t file_logger_write(void *logger, void *data, uint32_t data_len)
         goto __EXIT;
     }
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    if (handle->async)
+    {
+        err = fl_async_write(handle, true, data, data_len);
+        goto __EXIT;
+    }
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
     wr_size = lseek(handle->fd, FL_FILE_HDR_SIZE + handle->cursor.wr_pos, SEEK_SET);
     if (wr_size != (FL_FILE_HDR_SIZE + handle->cursor.wr_pos))
     {
@@ -530,6 +851,14 @@ fl_err_t file_logger_write_noheader(void *logger, void *data, uint32_t data_len)
         goto __EXIT;
     }
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    if (handle->async)
+    {
+        err = fl_async_write(handle, false, data, data_len);
+        goto __EXIT;
+    }
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
     wr_size = lseek(handle->fd, FL_FILE_HDR_SIZE + handle->cursor.wr_pos, SEEK_SET);
     if (wr_size != (FL_FILE_HDR_SIZE + handle->cursor.wr_pos))
     {
@@ -558,6 +887,8 @@ fl_err_t file_logger_iter(void *logger, fl_iter_cb_t cb, void *arg)
     uint8_t *data = NULL;
     uint32_t rd_pos;
 
+    fl_async_lock(handle);
+
     if (0 == handle->used_size)
     {
         goto __EXIT;
@@ -615,6 +946,7 @@ __EXIT:
     {
         rt_free(data);
     }
+    fl_async_unlock(handle);
 
     return err;
 }
@@ -625,9 +957,27 @@ fl_err_t file_logger_clear(void *logger)
     int ret;
     int wr_size;
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    if (handle->async)
+    {
+        /* drop buffered data */
+        rt_base_t level;
+        fl_async_t *async = handle->async;
+
+        rt_mutex_take(&async->lock, RT_WAITING_FOREVER);
+        level = rt_hw_interrupt_disable();
+        async->fill = 0;
+        async->pend_len = 0;
+        async->act_pos = 0;
+        async->target = fl_async_get_target(handle, 0);
+        rt_hw_interrupt_enable(level);
+    }
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
     ret = close(handle->fd);
     if (ret)
     {
+        fl_async_unlock(handle);
         return FL_ERROR;
     }
     handle->fd = -1;
@@ -636,6 +986,7 @@ fl_err_t file_logger_clear(void *logger)
     handle->cursor.wr_pos = 0;
     handle->cursor.magic = FL_FILE_HDR_MAGIC;
     wr_size = write(handle->fd, &handle->cursor, sizeof(handle->cursor));
+    fl_async_unlock(handle);
     if (wr_size != sizeof(handle->cursor))
     {
         return FL_WRITE_ERR;
@@ -650,6 +1001,8 @@ fl_err_t file_logger_flush(void *logger)
     int wr_size;
     fl_err_t err = FL_OK;
 
+    fl_async_lock(handle);
+
     /* write file header */
     wr_size = lseek(handle->fd, 0, SEEK_SET);
     if (wr_size != 0)
@@ -675,6 +1028,7 @@ fl_err_t file_logger_flush(void *logger)
     fsync(handle->fd);
 
 __EXIT:
+    fl_async_unlock(handle);
 
     return err;
 }
@@ -684,6 +1038,10 @@ fl_err_t file_logger_close(void *logger)
     fl_handle_t *handle = (fl_handle_t *)logger;
     fl_err_t err;
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+    fl_async_disable(handle);
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
     err = file_logger_flush(logger);
     if (FL_OK != err)
     {
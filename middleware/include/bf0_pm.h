@@ -336,6 +336,155 @@ void pm_pin_restore(void);
  */
 void pm_pin_backup(void);
 
+/* Predictive governor chooses sleep mode of lowest expected energy,
+   sleep time is predicted by timer and learnt wakeup source inter-arrival time */
+//#define PM_GOVERNOR_ENABLED
+
+#if (defined(PM_GOVERNOR_ENABLED) && defined(BSP_USING_PM)) || defined(_SIFLI_DOXYGEN_)
+/** Energy model of one sleep mode */
+typedef struct
+{
+    uint8_t  mode;          /**< sleep mode, e.g. PM_SLEEP_MODE_LIGHT */
+    uint32_t power;         /**< average power in the mode, in uW */
+    uint32_t energy;        /**< energy to enter and exit the mode, in uJ */
+    uint32_t latency;       /**< enter and exit time in ms, mode is not used if predicted sleep time is shorter */
+} pm_governor_mode_t;
+
+/** Residency and transition counters of one sleep mode */
+typedef struct
+{
+    uint32_t enter_cnt;     /**< times the mode is entered */
+    uint32_t early_cnt;     /**< times woken up by other source before timer timeout */
+    uint32_t residency;     /**< total time in the mode, in ms */
+} pm_governor_mode_stat_t;
+
+/** Governor statistics */
+typedef struct
+{
+    pm_governor_mode_stat_t mode[PM_SLEEP_MODE_MAX];
+    uint32_t demote_cnt;    /**< times shallower mode than static policy is chosen */
+} pm_governor_stat_t;
+
+/**
+ * @brief Configure energy model, default model is rough estimation and should be measured on board
+ *
+ *  @param[in] mode  mode table, must be valid after the call, IDLE mode should be included
+ *  @param[in] num   number of modes
+ *
+ * @return void
+ */
+void pm_governor_config(const pm_governor_mode_t *mode, uint8_t num);
+
+/**
+ * @brief Enable predictive governor, static policy is used if disabled
+ *
+ *  @param[in] enable true to enable
+ *
+ * @return void
+ */
+void pm_governor_enable(bool enable);
+
+/**
+ * @brief Get governor statistics
+ *
+ *  @param[out] stat statistics
+ *
+ * @return void
+ */
+void pm_governor_get_stat(pm_governor_stat_t *stat);
+
+/**
+ * @brief Clear governor statistics
+ *
+ * @return void
+ */
+void pm_governor_reset_stat(void);
+#endif /* PM_GOVERNOR_ENABLED */
+
+/* Load driven DVFS governor switches HCPU run mode by CPU utilization and client hints,
+   it depends on USING_CPU_USAGE_PROFILER and only SF32LB52X HCPU supports run mode switch */
+//#define PM_DVFS_GOVERNOR_ENABLED
+
+/** utilization sampling window in ms */
+#ifndef PM_DVFS_PERIOD_MS
+    #define PM_DVFS_PERIOD_MS       (50)
+#endif
+/** scale up if utilization of current frequency is above it, in percent */
+#ifndef PM_DVFS_UP_THRESHOLD
+    #define PM_DVFS_UP_THRESHOLD    (80)
+#endif
+/** lower frequency is chosen only if its utilization would be below it, in percent */
+#ifndef PM_DVFS_DOWN_THRESHOLD
+    #define PM_DVFS_DOWN_THRESHOLD  (60)
+#endif
+/** number of windows lower frequency must be sufficient before scaling down */
+#ifndef PM_DVFS_DOWN_DELAY
+    #define PM_DVFS_DOWN_DELAY      (3)
+#endif
+
+#if (defined(PM_DVFS_GOVERNOR_ENABLED) && defined(BSP_USING_PM) && defined(SF32LB52X) && defined(SOC_BF0_HCPU)) || defined(_SIFLI_DOXYGEN_)
+/** DVFS hint client */
+typedef enum
+{
+    PM_DVFS_CLIENT_GUI,
+    PM_DVFS_CLIENT_AUDIO,
+    PM_DVFS_CLIENT_MEDIA,
+    PM_DVFS_CLIENT_USER,
+    PM_DVFS_CLIENT_NUM
+} pm_dvfs_client_t;
+
+/** DVFS governor statistics */
+typedef struct
+{
+    uint32_t up_cnt;        /**< times run mode is switched to higher frequency */
+    uint32_t down_cnt;      /**< times run mode is switched to lower frequency */
+    uint32_t hint_cnt;      /**< times hint is given */
+    uint32_t park_cnt;      /**< times sampling is stopped in idle at lowest mode */
+    uint8_t  util;          /**< utilization of last window in percent */
+    uint16_t demand;        /**< required frequency of last decision in MHz */
+} pm_dvfs_stat_t;
+
+/**
+ * @brief Enable DVFS governor, run mode is restored to high speed if disabled
+ *
+ *  @param[in] enable true to enable
+ *
+ * @return void
+ */
+void pm_dvfs_enable(bool enable);
+
+/**
+ * @brief Give required processing capacity, higher frequency is applied immediately
+ *
+ *  @param[in] client  hint client
+ *  @param[in] mips    required MIPS, 1MIPS is regarded as 1MHz, 0 to clear hint
+ *  @param[in] hold_ms hint is valid for hold_ms, 0 means valid until cleared
+ *
+ * @return void
+ */
+void pm_dvfs_hint_mips(pm_dvfs_client_t client, uint32_t mips, uint32_t hold_ms);
+
+/**
+ * @brief Give work to be finished before deadline, e.g. GUI frame or audio decode block
+ *
+ *  @param[in] client      hint client
+ *  @param[in] work_us     execution time of the work measured in high speed mode, in us
+ *  @param[in] deadline_ms deadline from now in ms, hint expires after deadline
+ *
+ * @return void
+ */
+void pm_dvfs_hint_deadline(pm_dvfs_client_t client, uint32_t work_us, uint32_t deadline_ms);
+
+/**
+ * @brief Get DVFS governor statistics
+ *
+ *  @param[out] stat statistics
+ *
+ * @return void
+ */
+void pm_dvfs_get_stat(pm_dvfs_stat_t *stat);
+#endif /* PM_DVFS_GOVERNOR_ENABLED */
+
 ///@} pm
 #endif
 
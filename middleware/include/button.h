@@ -79,6 +79,7 @@ typedef enum
     BUTTON_RELEASED = 1,   /**< Indicates that a button is released */
     BUTTON_LONG_PRESSED = 2,/**< Indicates that a button is long released */
     BUTTON_CLICKED  = 3,    /**< Indicates that a button is clicked */
+    BUTTON_MULTI_CLICKED = 4, /**< Indicates that a button is clicked several times, see button_get_click_count() */
 } button_action_t;
 
 /** button active level */
@@ -92,6 +93,9 @@ typedef enum
 /** Button event handler type. */
 typedef void (*button_handler_t)(int32_t pin, button_action_t button_action);
 
+/** Chord event handler type, only BUTTON_PRESSED, BUTTON_LONG_PRESSED and BUTTON_RELEASED are reported. */
+typedef void (*button_chord_handler_t)(int32_t chord_id, button_action_t button_action);
+
 /** Button configuration structure. */
 typedef struct
 {
@@ -163,6 +167,46 @@ void button_irq_trigger(int32_t pin);
  */
 sf_err_t button_update_handler(int32_t id, button_handler_t new_handler);
 
+/** Enable multi-click detection
+ *
+ * Once enabled, BUTTON_CLICKED is delayed until no further press follows within
+ * BUTTON_MULTI_CLICK_INTERVAL, BUTTON_MULTI_CLICKED is reported instead if button is clicked
+ * more than once, immediately when max_click is reached.
+ *
+ * @param[in] id button id allocated by button_init
+ * @param[in] max_click max clicks counted, 0 or 1 to disable
+ *
+ * @return SF_EOK if successful
+ */
+sf_err_t button_set_multi_click(int32_t id, uint8_t max_click);
+
+/** Get clicks of last BUTTON_CLICKED or BUTTON_MULTI_CLICKED
+ *
+ * @param[in] id button id allocated by button_init
+ *
+ * @return number of clicks
+ */
+uint8_t button_get_click_count(int32_t id);
+
+/** Register a chord, i.e. several buttons pressed together
+ *
+ * Single button PRESSED and RELEASED are still reported, CLICKED and LONG_PRESSED of
+ * the buttons are suppressed once the chord is pressed.
+ *
+ * @param[in] button_mask bit mask of button ids, at least two buttons
+ * @param[in] handler chord handler, called in timer thread
+ *
+ * @return chord id, >=0 on success, otherwise an error code
+ */
+int32_t button_chord_init(uint32_t button_mask, button_chord_handler_t handler);
+
+/** Unregister a chord
+ *
+ * @param[in] chord_id chord id allocated by button_chord_init
+ *
+ * @return SF_EOK if successful
+ */
+sf_err_t button_chord_deinit(int32_t chord_id);
 
 #ifdef USING_ADC_BUTTON
 typedef void (*adc_button_handler_t)(uint8_t group_idx, int32_t pin, button_action_t button_action);
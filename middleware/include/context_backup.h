@@ -80,9 +80,19 @@ typedef struct
 #define CB_BACKUP_STATIC_DATA_MASK   ((uint8_t)1 << 2)
 /** backup all */
 #define CB_BACKUP_ALL_MASK    (CB_BACKUP_STACK_MASK | CB_BACKUP_HEAP_MASK | CB_BACKUP_STATIC_DATA_MASK)
+/** static data is kept uncompressed in retention memory, only blocks changed since last backup are written */
+#define CB_BACKUP_INCREMENTAL_MASK   ((uint8_t)1 << 3)
 
 #define CB_MAX_BACKUP_REGION_NUM  (4)
 
+/* use CB_BACKUP_INCREMENTAL_MASK for static data in PM */
+//#define CONTEXT_BACKUP_INCREMENTAL_ENABLED
+
+/** block size of incremental backup in byte, multiple of 4 */
+#ifndef CB_INCR_BLOCK_SIZE
+    #define CB_INCR_BLOCK_SIZE    (512)
+#endif
+
 
 
 typedef struct
@@ -102,6 +112,22 @@ typedef struct
     cb_retained_region_t backup_region_list[CB_MAX_BACKUP_REGION_NUM];
 } cb_backup_param_t;
 
+typedef struct
+{
+    /** number of backup */
+    uint32_t save_cnt;
+    /** time of last backup in us */
+    uint32_t save_time;
+    /** time of last restore in us */
+    uint32_t restore_time;
+    /** bytes written to retention memory in last backup */
+    uint32_t written;
+    /** bytes of static data not written in last backup as they're not changed */
+    uint32_t skipped;
+    /** bytes copied by EXT_DMA in last backup and the following restore */
+    uint32_t dma_len;
+} cb_perf_stats_t;
+
 
 
 rt_err_t cb_init(cb_backup_param_t *param);
@@ -109,6 +135,7 @@ rt_err_t cb_deinit(void);
 rt_err_t cb_save_context(void);
 rt_err_t cb_restore_context(void);
 void cb_get_stats(uint32_t *total, uint32_t *min_free);
+void cb_get_perf_stats(cb_perf_stats_t *stats);
 
 /// @}  context_backup
 
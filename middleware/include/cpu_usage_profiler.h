@@ -67,9 +67,12 @@ extern "C" {
 #ifdef USING_CPU_USAGE_PROFILER
 float cpu_get_usage(void);
 uint32_t cpu_get_hw_us(void);
+/** Get accumulated run time of non-idle threads in microsecond, it wraps around, use difference */
+uint32_t cpu_get_busy_us(void);
 #elif !defined(LCD_SDL2)
 #define cpu_get_usage()     0
 #define cpu_get_hw_us()     0
+#define cpu_get_busy_us()   0
 #endif
 
 /// @}  cpu_usage_profiler
@@ -108,6 +108,7 @@ enum
     MSG_SERVICE_PING_RSP      = RSP_MSG_TYPE | MSG_SERVICE_PING_REQ,
     MSG_SERVICE_SLEEP_REQ     = 0x0B,
     MSG_SERVICE_SLEEP_RSP     = RSP_MSG_TYPE | MSG_SERVICE_SLEEP_REQ,
+    MSG_SERVICE_FILTER_REQ    = 0x0C,   /*!< Set subscriber filter, handled by data service, no response */
 
     MSG_SERVICE_SYS_ID_END   =  0x2F,
     MSG_SERVICE_CUSTOM_ID_BEGIN   =  MSG_SERVICE_SYS_ID_END + 1,   //0x30
@@ -164,6 +165,26 @@ typedef struct
     uint8_t *data;
 } data_rdy_ind_t;
 
+/** Number of message ID covered by datac_filter_t.msg_mask */
+#define DATA_FILTER_MSG_MASK_BITS   (32)
+
+/**
+ * Parameter for MSG_SERVICE_FILTER_REQ, subscriber filter evaluated by data service
+ * on provider side before data pushed by datas_push_msg_to_client() is delivered.
+ * All zero means no filtering.
+ */
+typedef struct
+{
+    uint16_t msg_id_base;       /*!< Bit n of msg_mask is for message ID msg_id_base + n, RSP_MSG_TYPE bit ignored */
+    uint16_t min_interval_ms;   /*!< Minimum interval between delivery, 0: no rate limit.
+                                     Messages in interval are coalesced, only latest one is delivered when interval expires */
+    uint32_t msg_mask;          /*!< Accepted message ID, 0: accept all */
+    uint32_t threshold;         /*!< Deliver only if value changes by threshold at least since last delivery, 0: disabled */
+    uint16_t value_offset;      /*!< Offset of signed little endian value in message body for threshold check */
+    uint8_t  value_size;        /*!< Size of value, 1, 2 or 4 */
+    uint8_t  reserved;
+} datac_filter_t;
+
 #define DATA_SVC_THREAD_MB        1     /*!< Data service mailbox thread ID*/
 #define DATA_SVC_THREAD_PROC      2     /*!< Data service internal process thread ID*/
 
@@ -182,7 +203,8 @@ typedef struct
     uint16_t msg_id;        /*!< Message ID, see MSG_SERVICE_XXX */
     uint16_t len;            /*!< Parameter length */
     uint32_t no_free: 1;     /**< 1: no need to free memory of long msg, 0: need to free memory of long msg */
-    uint32_t reserved: 31;
+    uint32_t shm: 1;         /**< Internal use only, 1: long msg body is in shared memory pool of other core */
+    uint32_t stamp: 30;      /**< Internal use only, time when msg is put into service queue */
     uint8_t  body[SHORT_DATA_MSG_BODY_THRESHOLD]; /*!< Saving whole short msg body, which length <= SHORT_DATA_MSG_BODY_THRESHOLD.
                                                        For long msg body which length > SHORT_DATA_MSG_BODY_THRESHOLD,
                                                        we'll allocate a memroy from heap and save a pointer here.
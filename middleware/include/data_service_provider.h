@@ -121,6 +121,25 @@ typedef struct data_service_config_tag
     */
     int32_t datas_push_msg_to_client_no_copy(datas_handle_t svc, uint16_t msg_id, uint32_t len, uint8_t *data);
 
+    /**
+    @brief Allocate buffer from shared memory pool which is accessible by both cores.
+
+    Buffer pushed by datas_push_msg_to_client_no_copy() is never copied, the message
+    to other core carries a handle only and buffer is reference counted,
+    so service could call data_service_shm_free() just after push.
+    Only available if DATA_SVC_SHM_POOL is defined.
+    @param[in] size Size of buffer, at most DATA_SVC_SHM_BLK_SIZE
+    @retval Buffer pointer, NULL if pool is exhausted or not enabled.
+    */
+    void *data_service_shm_alloc(uint32_t size);
+
+    /**
+    @brief Release reference of buffer got by data_service_shm_alloc(),
+    buffer is returned to pool after all subscribers, on either core, have released it.
+    @param[in] ptr Buffer pointer
+    */
+    void data_service_shm_free(void *ptr);
+
 
     /**
     @brief  Inform service that data is available to
@@ -148,6 +148,16 @@ void datac_delayed_usr_cbk(data_service_mq_t *arg_msg);
  */
 rt_err_t datac_config(datac_handle_t handle, uint16_t len, uint8_t *config);
 
+/**
+ * @brief Set filter of subscription, data pushed by provider is filtered before sent to subscriber,
+ *        so that unwanted or too frequent update doesn't wake up subscriber thread or cross core.
+ * \note Rate limited messages are coalesced, latest one is delivered when interval expires.
+ * @param[in] handle Handle of data service
+ * @param[in] filter Filter, NULL to remove filter
+ * @retval RT_EOK if successful, otherwise return error number < 0.
+ */
+rt_err_t datac_set_filter(datac_handle_t handle, const datac_filter_t *filter);
+
 /**
  * @brief Send message to service provider
  * @param[in] handle Handle of data service
@@ -189,6 +199,7 @@ rt_err_t datac_ping(datac_handle_t handle, uint8_t mode);
 #define datac_unsubscribe(handle) -1
 #define datac_start(handle) -1
 #define datac_config(handle,len,config) -1
+#define datac_set_filter(handle,filter) -1
 #define datac_send_msg(handle,msg) -1
 #define datac_tx(handle,len,data) -1
 #define datac_rx(handle,len,data) -1
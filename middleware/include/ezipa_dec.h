@@ -91,6 +91,23 @@ typedef enum
     EZIPA_RGB888,
 } ezipa_color_fmt_t;
 
+/** Frame decoding statistics */
+typedef struct
+{
+    /** number of decoded frames */
+    uint32_t frame_cnt;
+    /** decoding time of last frame */
+    uint32_t last_decode_ms;
+    uint32_t max_decode_ms;
+    uint32_t total_decode_ms;
+    /** decode-ahead frames not ready when ezipa_draw() is called */
+    uint32_t late_cnt;
+    /** longest time ezipa_draw() waited for late frame */
+    uint32_t max_wait_ms;
+} ezipa_perf_t;
+
+struct ezipa_ahead;
+
 typedef struct
 {
     uint8_t *ezipa_data;
@@ -119,6 +136,10 @@ typedef struct
     uint32_t *org_frame_offset_tbl;
     uint32_t *fake_frame_offset_tbl;
     uint32_t frame_num;
+    /* buffer of the frame drawn on canvas, differs from output_buf if decode-ahead enabled */
+    uint8_t *disp_buf;
+    struct ezipa_ahead *ahead;
+    ezipa_perf_t perf;
 } ezipa_obj_t;
 
 
@@ -177,6 +198,32 @@ int32_t ezipa_close(ezipa_obj_t *obj);
  */
 int32_t ezipa_draw(ezipa_obj_t *obj, ezipa_canvas_t *canvas, bool next);
 
+/**
+ * @brief  Enable or disable decode-ahead
+ *
+ *  If enabled, after a frame is drawn the next frame is decoded into a second output buffer
+ *  in background, ezipa_draw() with next=true then only copies it to the canvas.
+ *  It costs one more output buffer allocated by EZIPA_LARGE_BUF_MALLOC.
+ *  One frame is skipped when disabled with a frame decoded ahead.
+ *
+ * @param[in]  obj ezipa object instance
+ * @param[in]  enable true: enable, false: disable
+ *
+ * @retval 0: no error, < 0: error code
+ */
+int32_t ezipa_set_decode_ahead(ezipa_obj_t *obj, bool enable);
+
+/**
+ * @brief  Get frame decoding statistics
+ *
+ * @param[in]  obj ezipa object instance
+ * @param[out] perf statistics
+ * @param[in]  reset true: clear statistics after read
+ *
+ * @retval 0: no error, < 0: error code
+ */
+int32_t ezipa_get_perf(ezipa_obj_t *obj, ezipa_perf_t *perf, bool reset);
+
 
 /// @}  ezipa_dec
 
@@ -76,6 +76,7 @@ typedef enum fl_err_tag
     FL_INVALID_DATA_LEN,
     FL_WRITE_ERR,
     FL_READ_ERR,
+    FL_DROPPED,     /**< data is dropped as async buffers are full */
 } fl_err_t;
 
 
@@ -96,6 +97,8 @@ void *file_logger_init(const char *name, uint32_t max_len);
 
 /** Write data in file logger
  *
+ * If asynchronous write is enabled by #file_logger_enable_async, data is copied to RAM buffer
+ * and written by background thread, FL_DROPPED is returned without blocking if buffer is full.
  *
  * @param[in] logger         file logger handle created by file_logger_init
  * @param[in] data           point to data to be written
@@ -117,6 +120,28 @@ fl_err_t file_logger_write(void *logger, void *data, uint32_t data_len);
  */
 fl_err_t file_logger_write_noheader(void *logger, void *data, uint32_t data_len);
 
+#ifdef FILE_LOGGER_ASYNC_ENABLED
+/** Enable asynchronous write of file logger
+ *
+ * Two RAM buffers of FILE_LOGGER_ASYNC_BUF_SIZE are allocated. Write APIs only copy data to buffer,
+ * a background thread writes full buffer to file at offset aligned to FILE_LOGGER_ASYNC_ALIGN.
+ * Buffered data is written before read, flush and close. It's disabled by #file_logger_close.
+ *
+ * @param[in] logger         file logger handle created by file_logger_init
+ *
+ * @return result
+ */
+fl_err_t file_logger_enable_async(void *logger);
+
+/** Get number of writes dropped as async buffers are full
+ *
+ * @param[in] logger         file logger handle created by file_logger_init
+ *
+ * @return drop count
+ */
+uint32_t file_logger_get_drop_cnt(void *logger);
+#endif /* FILE_LOGGER_ASYNC_ENABLED */
+
 /** Iterate all data in file logger in write sequence
  *
  *
@@ -272,6 +272,27 @@ void gui_app_set_exit_trans_anim(gui_app_trans_anim_t *cfg);
 
 void gui_app_set_trans_anim_prio(int8_t up, int8_t down);
 
+/**
+ * @brief Statistics of last transform animation
+ */
+typedef struct
+{
+    uint32_t snapshot_bytes;    //!< PSRAM used by screen snapshots
+    uint32_t setup_ms;          //!< Time to take snapshots and create animation objects
+    uint32_t frame_cnt;         //!< Animation frames played
+    uint32_t avg_frame_ms;      //!< Average interval between frames
+    uint32_t max_frame_ms;      //!< Longest interval between frames
+    uint32_t update_cnt;        //!< Manual (gesture) updates applied
+    uint32_t max_update_us;     //!< Longest time to apply one manual update
+} gui_app_trans_anim_perf_t;
+
+/**
+* @brief Get statistics of last transform animation
+*
+* @param perf
+*/
+void gui_app_get_trans_anim_perf(gui_app_trans_anim_perf_t *perf);
+
 
 rt_err_t gui_app_manual_animation_start(uint32_t process);
 rt_err_t gui_app_manual_animation_update(uint32_t process);
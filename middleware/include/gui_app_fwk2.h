@@ -230,6 +230,78 @@ int gui_app_fwk_suspend(void);
  */
 int gui_app_fwk_resume(void);
 
+/**
+ * @brief Statistics of warm app cache
+ */
+typedef struct
+{
+    uint32_t hit;        //!< Launches resumed from warm cache
+    uint32_t miss;       //!< Cold launches while warm cache is enabled
+    uint32_t preload;    //!< Apps launched in background by gui_app_preload
+    uint32_t evict;      //!< Apps destoryed from warm cache
+    uint32_t cached;     //!< Apps in warm cache now
+} gui_app_warm_cache_stat_t;
+
+/**
+ * @brief Set max number of exited apps kept in warm cache. Exited app keeps its pages
+ *        paused instead of being destoryed, and is resumed without calling entry function
+ *        when running it again with same parameters. Default is GUI_APP_WARM_CACHE_NUM.
+ * @param num - 0 to disable warm cache and destory all cached apps
+ */
+void gui_app_set_warm_cache(uint32_t num);
+
+/**
+ * @brief Launch app in background while app framework is idle, e.g. app under focus
+ *        in launcher. It's moved to warm cache after its pages are started.
+ * @param id - Identification of application
+ * @return RT_EOK if request accepted
+ */
+int gui_app_preload(const char *id);
+
+/**
+ * @brief Destory all apps in warm cache at next idle, could be called in low memory handler.
+ */
+void gui_app_warm_cache_flush(void);
+
+/**
+ * @brief Get statistics of warm cache
+ * @param stat
+ */
+void gui_app_get_warm_cache_stat(gui_app_warm_cache_stat_t *stat);
+
+/**
+ * @brief Statistics of per app LVGL memory arena, see GUI_APP_SCREEN_ARENA
+ */
+typedef struct
+{
+    uint32_t created;    //!< Arenas created at app loading
+    uint32_t retired;    //!< Arenas of destoryed apps still holding blocks
+    uint32_t fallback;   //!< Allocations served by system heap as arena is full
+} gui_app_arena_stat_t;
+
+#ifdef GUI_APP_SCREEN_ARENA
+/**
+ * @brief LVGL allocations between begin and end go to system heap instead of current app's
+ *        arena, for objects outliving the app, e.g. created on layer_top or cached globally.
+ *        Could be nested, and must be called in gui_app thread.
+ */
+void gui_app_arena_global_begin(void);
+
+/**
+ * @brief End of gui_app_arena_global_begin
+ */
+void gui_app_arena_global_end(void);
+
+/**
+ * @brief Get statistics of app memory arenas
+ * @param stat
+ */
+void gui_app_arena_get_stat(gui_app_arena_stat_t *stat);
+#else
+#define gui_app_arena_global_begin()
+#define gui_app_arena_global_end()
+#endif /* GUI_APP_SCREEN_ARENA */
+
 
 /**
   * @} gui_app_function_group_1
@@ -75,6 +75,40 @@ typedef int32_t ipc_queue_handle_t;
 /** IPC queue rx callback type */
 typedef int32_t (*ipc_queue_rx_ind_t)(ipc_queue_handle_t handle, size_t size);
 
+/** Doorbell coalescing configuration, see #ipc_queue_set_coalesce */
+typedef struct
+{
+    uint32_t threshold;        /**< ring doorbell once pending data reaches the threshold in byte, 0: coalescing disabled */
+    uint32_t max_latency;      /**< max time in millisecond that pending data can wait before doorbell is rung */
+} ipc_queue_coalesce_cfg_t;
+
+/** Doorbell coalescing statistics */
+typedef struct
+{
+    uint32_t write_cnt;        /**< number of writes */
+    uint32_t doorbell_cnt;     /**< number of interrupts triggered */
+    uint32_t threshold_cnt;    /**< number of interrupts triggered by byte threshold */
+    uint32_t timeout_cnt;      /**< number of interrupts triggered by max latency */
+    uint32_t flush_cnt;        /**< number of interrupts triggered by flush or full tx buffer */
+    uint32_t max_pending_len;  /**< max pending data size in byte when doorbell is rung */
+    uint32_t max_latency;      /**< max time in millisecond that pending data waited */
+} ipc_queue_coalesce_stat_t;
+
+/** Doorbell reason */
+enum
+{
+    IPC_QUEUE_DOORBELL_FLUSH,
+    IPC_QUEUE_DOORBELL_THRESHOLD,
+    IPC_QUEUE_DOORBELL_TIMEOUT,
+};
+
+/** IO vector used by #ipc_queue_writev */
+typedef struct
+{
+    const void *base;          /**< start address of the segment */
+    size_t len;                /**< length of the segment in byte */
+} ipc_queue_iovec_t;
+
 /** IPC queue configuration */
 typedef struct
 {
@@ -206,6 +240,99 @@ size_t ipc_queue_read(ipc_queue_handle_t handle, void *buffer, size_t size);
  */
 size_t ipc_queue_write(ipc_queue_handle_t handle, const void *buffer, size_t size, uint32_t timeout);
 
+/** Write several data segments to IPC queue and inform the receiver to read
+ *
+ * Segments are written back to back to tx buffer without being assembled in a temporary buffer,
+ * interrupt is triggered once after all segments are written.
+ * If tx buffer gets full, interrupt is triggered to let receiver drain the buffer before continuing.
+ * The API is not thread-safe. It should be avoided to write the same queue in different threads.
+ *
+ * @param[in]  handle  queue handle
+ * @param[in]  iov     segment array
+ * @param[in]  iov_cnt number of segments in iov
+ * @param[in]  timeout time to wait if tx buffer is full, the unit is #HAL_GetTick
+ *
+ * @return actual size of data that has been written
+ */
+size_t ipc_queue_writev(ipc_queue_handle_t handle, const ipc_queue_iovec_t *iov, uint32_t iov_cnt, uint32_t timeout);
+
+/** Reserve contiguous space in tx buffer to be filled in place
+ *
+ * The reserved space is not visible to receiver until #ipc_queue_write_commit is called.
+ * The size of the reserved space may be less than requested if the space wraps around the buffer end,
+ * call #ipc_queue_write_commit and reserve again for the rest.
+ * Only one reservation can be outstanding at a time.
+ *
+ * @param[in]  handle  queue handle
+ * @param[out] buffer  start address of the reserved space, NULL if no space
+ * @param[in]  size    expected size in byte
+ *
+ * @return size of the reserved space
+ */
+size_t ipc_queue_write_reserve(ipc_queue_handle_t handle, void **buffer, size_t size);
+
+/** Publish the data filled in the space got by #ipc_queue_write_reserve and inform the receiver to read
+ *
+ * @param[in]  handle  queue handle
+ * @param[in]  size    size of data to publish, must not be larger than the reserved size
+ *
+ * @return status, 0: success, otherwise: error
+ */
+int32_t ipc_queue_write_commit(ipc_queue_handle_t handle, size_t size);
+
+/** Get contiguous data in rx buffer to be consumed in place
+ *
+ * Data is kept in rx buffer until #ipc_queue_read_release is called.
+ * The returned size may be less than #ipc_queue_get_rx_size if data wraps around the buffer end.
+ *
+ * @param[in]  handle  queue handle
+ * @param[out] buffer  start address of the data, NULL if no data
+ *
+ * @return size of the contiguous data
+ */
+size_t ipc_queue_read_peek(ipc_queue_handle_t handle, const void **buffer);
+
+/** Release the data consumed in the region got by #ipc_queue_read_peek
+ *
+ * @param[in]  handle  queue handle
+ * @param[in]  size    size of consumed data
+ *
+ * @return actual size of data that has been released
+ */
+size_t ipc_queue_read_release(ipc_queue_handle_t handle, size_t size);
+
+/** Configure doorbell coalescing of the IPC queue
+ *
+ * If enabled, writes don't trigger interrupt one by one. Interrupt is triggered once the pending data
+ * reaches cfg->threshold or the first pending byte has waited for cfg->max_latency,
+ * whichever comes first. Interrupt is always triggered at once if tx buffer is full.
+ * Without OS timer, max latency is only checked on next write, use #ipc_queue_flush to signal pending data.
+ *
+ * @param[in]  handle  queue handle
+ * @param[in]  cfg     coalescing configuration, NULL or zero threshold to disable coalescing
+ *
+ * @return status, 0: success, otherwise: error
+ */
+int32_t ipc_queue_set_coalesce(ipc_queue_handle_t handle, const ipc_queue_coalesce_cfg_t *cfg);
+
+/** Trigger interrupt at once if there is pending data
+ *
+ * @param[in]  handle  queue handle
+ *
+ * @return status, 0: success, otherwise: error
+ */
+int32_t ipc_queue_flush(ipc_queue_handle_t handle);
+
+/** Get doorbell coalescing statistics
+ *
+ * @param[in]  handle  queue handle
+ * @param[out] stat    statistics
+ * @param[in]  reset   true: clear statistics after read
+ *
+ * @return status, 0: success, otherwise: error
+ */
+int32_t ipc_queue_get_coalesce_stat(ipc_queue_handle_t handle, ipc_queue_coalesce_stat_t *stat, bool reset);
+
 /** Check whether ipc queue is idle from sender perspective
  *
  * If all tx_buffer are empty, it's idle, even though rx_buffer is not empty
@@ -251,6 +378,16 @@ void ipc_queue_restore_all_rom(void);
  */
 size_t ipc_queue_get_rx_size(ipc_queue_handle_t handle);
 
+/** Get free space in tx buffer
+ *
+ * Data of this size can be written without waiting for the receiver.
+ *
+ * @param[in]  handle  queue handle
+ *
+ * @return free space in byte
+ */
+size_t ipc_queue_get_tx_space(ipc_queue_handle_t handle);
+
 
 /// @}  ipc_queue
 
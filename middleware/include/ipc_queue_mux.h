@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file   ipc_queue_mux.h
+  * @author Sifli software development team
+  * @brief Sifli logical channels multiplexed over one ipc_queue
+  * @{
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef IPC_QUEUE_MUX_H
+#define IPC_QUEUE_MUX_H
+#include "rtthread.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "ipc_queue.h"
+
+/**
+ ****************************************************************************************
+* @addtogroup ipc_queue_mux IPC Queue Channel Multiplexer
+* @ingroup middleware
+* @brief Many logical channels over one ipc_queue
+*
+* Each logical channel is an rt device used like the device of #ipc_queue_device_register,
+* but all channels share one ipc_queue, i.e. one mailbox channel and one pair of shared buffers.
+* Data is sent in frames of at most #IPC_MUX_FRAME_MAX bytes so that channel of higher priority
+* can interleave a long write, and part of tx buffer is kept for #IPC_MUX_PRIO_HIGH channels.
+* Each channel has its own rx buffer on receiver side and sender never sends more than the free space of it,
+* so one slow reader doesn't block the other channels.
+* Channel table must be the same on both cores.
+* @{
+****************************************************************************************
+*/
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Max payload of one frame */
+#ifndef IPC_MUX_FRAME_MAX
+    #define IPC_MUX_FRAME_MAX           (256)
+#endif
+
+/** Tx buffer space only usable by #IPC_MUX_PRIO_HIGH channels */
+#ifndef IPC_MUX_HIGH_RESERVE
+    #define IPC_MUX_HIGH_RESERVE        (128)
+#endif
+
+/** Channel priority */
+enum
+{
+    IPC_MUX_PRIO_HIGH,      /**< control, e.g. audio control, may use reserved tx space */
+    IPC_MUX_PRIO_NORMAL,
+    IPC_MUX_PRIO_BULK,      /**< bulk data, e.g. sensor data */
+};
+
+/** control command of channel device */
+#define IPC_MUX_CTRL_GET_STAT       (0x20 + 1)      /**< args: ipc_mux_stat_t *, statistics are reset after read */
+
+/** Logical channel configuration */
+typedef struct
+{
+    const char *name;          /**< device name */
+    uint8_t id;                /**< channel id, unique in one mux */
+    uint8_t prio;              /**< priority, IPC_MUX_PRIO_XXX */
+    uint16_t rx_buf_size;      /**< rx buffer size in byte, multiple of 4, it's also the tx window of the peer */
+} ipc_mux_chan_cfg_t;
+
+/** Statistics of logical channel */
+typedef struct
+{
+    uint32_t tx_bytes;
+    uint32_t tx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_frames;
+    uint32_t credit_waits;     /**< writes waited for peer rx buffer */
+    uint32_t space_waits;      /**< writes waited for tx buffer space */
+    uint32_t max_wait_ms;      /**< max time of a frame waited before written */
+    uint32_t rx_overflow;      /**< bytes dropped as rx buffer is full, nonzero if peer config differs */
+} ipc_mux_stat_t;
+
+/**
+ * @brief  Create logical channels over queue and register their devices
+ *
+ * ipc_queue_mux_rx_ind must be used as rx_ind of the queue.
+ *
+ * @param[in] queue ipc queue handle
+ * @param[in] cfg channel table, must be kept valid
+ * @param[in] chan_num number of channels
+ *
+ * @retval error code
+ */
+rt_err_t ipc_queue_mux_init(ipc_queue_handle_t queue, const ipc_mux_chan_cfg_t *cfg, uint8_t chan_num);
+
+/**
+ * @brief  rx notification callback for ipc queue which is bound with mux
+ *
+ * @param[in] queue ipc queue handle
+ * @param[in] size size in byte
+ *
+ * @retval status, 0: no error
+ */
+int32_t ipc_queue_mux_rx_ind(ipc_queue_handle_t queue, size_t size);
+
+/// @}  ipc_queue_mux
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @} file
+#endif
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
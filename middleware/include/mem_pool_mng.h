@@ -126,6 +126,15 @@ void *mem_pool_calloc(mem_pool_id_t pool_id, size_t count, size_t size);
 
 bool mem_pool_get_info(mem_pool_id_t pool_id, mem_pool_info_t *info);
 
+#if defined(MEM_PROF_TRACK_POOL) && defined(USING_MEM_PROFILER)
+#include "mem_profiler.h"
+/* Route calls through memory profiler to record call sites */
+#define mem_pool_alloc(pool_id, size)           mem_prof_pool_alloc(pool_id, size)
+#define mem_pool_calloc(pool_id, count, size)   mem_prof_pool_calloc(pool_id, count, size)
+#define mem_pool_realloc(p, new_size)           mem_prof_pool_realloc(p, new_size)
+#define mem_pool_free(p)                        mem_prof_pool_free(p)
+#endif /* MEM_PROF_TRACK_POOL && USING_MEM_PROFILER */
+
 
 /// @}  mem_pool_mng
 
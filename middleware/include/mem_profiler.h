@@ -0,0 +1,190 @@
+/**
+  ******************************************************************************
+  * @file   mem_profiler.h
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef MEM_PROFILER_H
+#define MEM_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rtthread.h"
+
+/**
+ ****************************************************************************************
+* @addtogroup mem_profiler Memory Profiler
+* @ingroup middleware
+* @brief Thread stack high-water sampling and heap allocation tracking by call site
+*
+* - Stack: a soft timer samples unused stack ('#' filled by kernel) of all threads every
+*   MEM_PROF_STACK_PERIOD_MS, and warns once when usage of a thread reaches MEM_PROF_STACK_WARN_PCT.
+* - Heap: rt_malloc is tracked through malloc/free hook (needs RT_USING_HOOK), mem_pool_alloc
+*   is tracked in files including mem_pool_mng.h with MEM_PROF_TRACK_POOL defined, audio_mem_malloc
+*   is tracked by tagging its rt_malloc record so it implies rt_malloc tracking. Each allocation is
+*   charged to a site, identified by hash of return addresses found on thread stack within
+*   MEM_PROF_CODE_START/MEM_PROF_CODE_SIZE, resolve them by addr2line.
+* @{
+****************************************************************************************
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MEM_PROF_BT_DEPTH
+    #define MEM_PROF_BT_DEPTH           (4)     /* Return addresses kept for each site */
+#endif
+
+typedef enum
+{
+    MEM_PROF_HEAP_SYS,                  /**< rt_malloc */
+    MEM_PROF_HEAP_POOL,                 /**< mem_pool_alloc */
+    MEM_PROF_HEAP_AUDIO,                /**< audio_mem_malloc */
+    MEM_PROF_HEAP_NUM
+} mem_prof_heap_t;
+
+#define MEM_PROF_HEAP_MASK_ALL          ((1 << MEM_PROF_HEAP_NUM) - 1)
+
+typedef enum
+{
+    MEM_PROF_SORT_LIVE,                 /**< by live bytes */
+    MEM_PROF_SORT_COUNT,                /**< by number of allocations */
+    MEM_PROF_SORT_GROWTH,               /**< by live bytes growth since previous history sample */
+} mem_prof_sort_t;
+
+typedef struct
+{
+    uint32_t hash;                      /**< hash of heap and backtrace */
+    uint32_t bt[MEM_PROF_BT_DEPTH];     /**< return addresses, innermost first, 0 if fewer */
+    uint32_t alloc_count;
+    uint32_t free_count;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    int32_t growth;                     /**< live bytes change since previous history sample */
+    uint8_t heap;                       /**< @ref mem_prof_heap_t */
+} mem_prof_site_t;
+
+typedef struct
+{
+    char name[RT_NAME_MAX];
+    uint32_t stack_size;
+    uint32_t max_used;                  /**< high-water mark in bytes */
+} mem_prof_stack_t;
+
+typedef struct
+{
+    uint32_t time;                      /**< second */
+    uint32_t live_bytes[MEM_PROF_HEAP_NUM];
+} mem_prof_hist_t;
+
+typedef struct
+{
+    uint32_t live_bytes[MEM_PROF_HEAP_NUM];
+    uint32_t peak_bytes[MEM_PROF_HEAP_NUM];
+    uint32_t untracked;                 /**< allocations dropped as site or record table is full */
+    uint16_t site_num;
+    uint16_t record_num;                /**< live allocations tracked */
+} mem_prof_summary_t;
+
+#ifdef USING_MEM_PROFILER
+/**
+ * @brief Start heap tracking, allocations done before are not seen and their free is ignored.
+ * @param heap_mask - bit mask of @ref mem_prof_heap_t
+ */
+void mem_prof_start(uint32_t heap_mask);
+
+/** @brief Stop heap tracking and clear all sites. Stack sampling is always on. */
+void mem_prof_stop(void);
+
+/**
+ * @brief Record allocation from an allocator without hook.
+ * @param heap - @ref mem_prof_heap_t
+ * @param ptr - allocated memory, NULL is ignored
+ * @param size - requested size
+ * @param skip - return addresses to skip on stack, i.e. wrapper levels between caller and this function
+ */
+void mem_prof_alloc(uint8_t heap, void *ptr, uint32_t size, uint32_t skip);
+
+/** @brief Record free of memory recorded by mem_prof_alloc() or rt_malloc hook. */
+void mem_prof_free(void *ptr);
+
+/** @brief Move memory already recorded by rt_malloc hook to another heap, e.g. allocator built on rt_malloc. */
+void mem_prof_retag(void *ptr, uint8_t heap);
+
+/**
+ * @brief Get sites sorted in descending order.
+ * @param sites - output array
+ * @param max - size of sites
+ * @return number of sites filled
+ */
+int mem_prof_get_sites(mem_prof_site_t *sites, int max, mem_prof_sort_t sort);
+
+/** @brief Get stack high-water of threads, sorted by usage percentage, return number filled. */
+int mem_prof_get_stacks(mem_prof_stack_t *stacks, int max);
+
+/** @brief Get history of live bytes, oldest first, return number filled. */
+int mem_prof_get_history(mem_prof_hist_t *hist, int max);
+
+void mem_prof_get_summary(mem_prof_summary_t *summary);
+
+/* Wrappers of memory pool, see MEM_PROF_TRACK_POOL in mem_pool_mng.h */
+void *mem_prof_pool_alloc(int pool_id, size_t size);
+void *mem_prof_pool_calloc(int pool_id, size_t count, size_t size);
+void *mem_prof_pool_realloc(void *p, size_t new_size);
+void mem_prof_pool_free(void *p);
+#else
+#define mem_prof_alloc(heap, ptr, size, skip)
+#define mem_prof_free(ptr)
+#define mem_prof_retag(ptr, heap)
+#endif /* USING_MEM_PROFILER */
+
+/// @}  mem_profiler
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @} file
+#endif /* MEM_PROFILER_H */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
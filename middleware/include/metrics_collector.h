@@ -76,6 +76,19 @@ extern "C" {
 #define MC_MAX_DATA_LEN (256)
 #endif /* MC_MAX_DATA_LEN */
 
+#ifdef MC_BATCH_ENABLED
+#ifndef MC_BATCH_BLOCK_SIZE
+#define MC_BATCH_BLOCK_SIZE (1024)
+#endif /* MC_BATCH_BLOCK_SIZE */
+#ifndef MC_BATCH_FLUSH_MS
+#define MC_BATCH_FLUSH_MS   (60000)
+#endif /* MC_BATCH_FLUSH_MS */
+/** Max length of one backend record, a block is stored uncompressed if LZ4 doesn't help */
+#define MC_BACKEND_MAX_DATA_LEN  (MC_BATCH_BLOCK_SIZE + 12)
+#else
+#define MC_BACKEND_MAX_DATA_LEN  (MC_MAX_DATA_LEN)
+#endif /* MC_BATCH_ENABLED */
+
 
 #if defined(MC_SERVICE_ENABLED) || defined(MC_CLIENT_ENABLED)
 enum
@@ -157,8 +170,23 @@ typedef struct
     void *db;
     uint32_t max_size;
     rt_list_t node;
+#ifdef MC_BATCH_ENABLED
+    void *batch;        /**< internal use, staging block */
+#endif /* MC_BATCH_ENABLED */
 } mc_db_t;
 
+#ifdef MC_BATCH_ENABLED
+typedef struct
+{
+    uint32_t blocks;        /**< blocks written to backend */
+    uint32_t records;       /**< metrics written in blocks */
+    uint32_t raw_bytes;     /**< bytes before compression */
+    uint32_t stored_bytes;  /**< bytes written to backend */
+    uint32_t last_flush_us; /**< time of last block compression and backend write */
+    uint32_t max_flush_us;
+} mc_batch_stat_t;
+#endif /* MC_BATCH_ENABLED */
+
 
 /** Register metrics collector
  *
@@ -310,6 +338,15 @@ const char *mc_get_path(void);
 
 void mc_backend_direct_write(mc_db_t *db, uint16_t id, void *data, uint16_t size);
 
+#ifdef MC_BATCH_ENABLED
+/** Get statistics of batched writes
+ *
+ * @param[out] stat      statistics
+ * @param[in] reset      clear statistics afterwards
+ */
+void mc_get_batch_stat(mc_batch_stat_t *stat, bool reset);
+#endif /* MC_BATCH_ENABLED */
+
 
 
 /*******************************************************************
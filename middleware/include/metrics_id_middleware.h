@@ -69,6 +69,10 @@ extern "C" {
 #define METRICS_MW_HR_STAT         (METRICS_MIDDLEWARE_ID_START + 11)
 #define METRICS_MW_POWER_ON_STAT         (METRICS_MIDDLEWARE_ID_START + 12)
 #define METRICS_MW_SHUTDOWN_STAT         (METRICS_MIDDLEWARE_ID_START + 13)
+#define METRICS_MW_GUI_FRAME_STAT        (METRICS_MIDDLEWARE_ID_START + 14)
+#define METRICS_MW_MEM_PROF_STACK        (METRICS_MIDDLEWARE_ID_START + 15)
+#define METRICS_MW_MEM_PROF_HEAP         (METRICS_MIDDLEWARE_ID_START + 16)
+#define METRICS_MW_CRASH_RECORD          (METRICS_MIDDLEWARE_ID_START + 17)
 
 
 
@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file   nn_runtime.h
+  * @author Sifli software development team
+  * @brief Layered int8 CNN inference runtime
+  * @{
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#ifndef __NN_RUNTIME_H__
+#define __NN_RUNTIME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <rtthread.h>
+
+/**
+****************************************************************************************
+* @addtogroup nn_runtime NN runtime
+* @ingroup middleware
+* @brief Run quantized int8 CNN models layer by layer
+*
+* Model is in a compact format: #nn_rt_model_hdr_t followed by #nn_rt_layer_t array,
+* weights and biases are referred by offset from start of model, so model could be executed in place from flash.
+* Tensors are in HWC order, quantization is q7 with power of 2 shifts, same as legacy CMSIS-NN q7 functions.
+*
+* Convolution layers run on NN_ACC, tiled by output rows to fit SRAM working buffer,
+* input rows of next tile are prefetched by EXT_DMA while NN_ACC computes current one.
+* Other layers, and convolution without NN_ACC, run by CMSIS-NN.
+* @{
+****************************************************************************************
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NN_RT_MODEL_MAGIC       (0x314E4E53)    /**< 'SNN1' */
+#define NN_RT_MODEL_VERSION     (1)
+
+/** Error code */
+#define NN_RT_ERR_OK            (0)
+#define NN_RT_ERR_PARAM         (-1)    /**< invalid parameter */
+#define NN_RT_ERR_MODEL         (-2)    /**< model is malformed or has unsupported layer */
+#define NN_RT_ERR_NO_MEM        (-3)    /**< no memory for activation or working buffer */
+#define NN_RT_ERR_HW            (-4)    /**< NN_ACC or DMA fails */
+
+/** Layer operation */
+#define NN_RT_OP_CONV2D         (0)     /**< convolution, NN_ACC */
+#define NN_RT_OP_DW_CONV2D      (1)     /**< depthwise convolution, NN_ACC */
+#define NN_RT_OP_FC             (2)     /**< fully connected, in_x*in_y*in_ch to out_ch */
+#define NN_RT_OP_MAXPOOL        (3)     /**< square max pooling */
+#define NN_RT_OP_AVGPOOL        (4)     /**< square average pooling */
+#define NN_RT_OP_RELU           (5)     /**< in place */
+#define NN_RT_OP_SOFTMAX        (6)
+
+/** Fused activation */
+#define NN_RT_ACT_NONE          (0)
+#define NN_RT_ACT_RELU          (1)
+
+/** Model header, little endian */
+typedef struct
+{
+    uint32_t magic;             /**< #NN_RT_MODEL_MAGIC */
+    uint16_t version;           /**< #NN_RT_MODEL_VERSION */
+    uint16_t layer_num;         /**< number of layers following header */
+    uint32_t max_act_size;      /**< size in bytes of largest tensor between layers */
+    uint32_t reserved;
+} nn_rt_model_hdr_t;
+
+/** Layer descriptor */
+typedef struct
+{
+    uint8_t op;                 /**< NN_RT_OP_XXX */
+    uint8_t act;                /**< NN_RT_ACT_XXX */
+    uint16_t reserved;
+    uint16_t in_x;
+    uint16_t in_y;
+    uint16_t in_ch;
+    uint16_t out_x;
+    uint16_t out_y;
+    uint16_t out_ch;
+    uint8_t ker_x;
+    uint8_t ker_y;
+    uint8_t pad_x;
+    uint8_t pad_y;
+    uint8_t stride_x;
+    uint8_t stride_y;
+    uint8_t bias_shift;
+    uint8_t out_shift;
+    uint32_t wt_offset;         /**< offset of weights from start of model */
+    uint32_t wt_size;           /**< size of weights in bytes */
+    uint32_t bias_offset;       /**< offset of out_ch biases from start of model */
+} nn_rt_layer_t;
+
+/** Per layer statistics of last run, time is in microsecond */
+typedef struct
+{
+    uint32_t time;              /**< execution time of layer */
+    uint32_t max_time;          /**< max execution time since load */
+    uint16_t tiles;             /**< NN_ACC tiles, 0 if layer is done by CPU */
+    uint8_t wt_in_sram;         /**< weights are copied to SRAM working buffer */
+    uint8_t reserved;
+} nn_rt_layer_stat_t;
+
+/** Runtime instance, fields are private */
+typedef struct
+{
+    const uint8_t *model;
+    const nn_rt_model_hdr_t *hdr;
+    const nn_rt_layer_t *layers;
+    int8_t *act[2];             /**< ping-pong tensors between layers */
+    int16_t *scratch;           /**< CMSIS-NN buffer */
+    uint8_t *sram;              /**< working buffer of NN_ACC */
+    uint32_t sram_size;
+    nn_rt_layer_stat_t *stat;
+    uint32_t run_time;          /**< total time of last run */
+} nn_rt_t;
+
+/** Load model
+ *
+ * @param[out] rt         runtime instance
+ * @param[in]  model      model data, kept by caller until #nn_rt_unload
+ * @param[in]  size       model size in bytes
+ * @param[in]  sram       working buffer of NN_ACC, should not cross 1MB boundary.
+ *                        Biases, weights if they fit, and two input tiles are placed here.
+ * @param[in]  sram_size  size of working buffer
+ *
+ * @return NN_RT_ERR_OK or error code
+ */
+int32_t nn_rt_load(nn_rt_t *rt, const void *model, uint32_t size, void *sram, uint32_t sram_size);
+
+/** Free buffers allocated by #nn_rt_load */
+void nn_rt_unload(nn_rt_t *rt);
+
+/** Run inference
+ *
+ * @param[in]  rt      runtime instance
+ * @param[in]  input   input tensor of first layer
+ * @param[out] output  output tensor of last layer, valid until next run
+ *
+ * @return NN_RT_ERR_OK or error code
+ */
+int32_t nn_rt_run(nn_rt_t *rt, const int8_t *input, int8_t **output);
+
+/** Get statistics of layer in last run
+ *
+ * @return NULL if idx is out of range
+ */
+const nn_rt_layer_stat_t *nn_rt_get_layer_stat(nn_rt_t *rt, uint16_t idx);
+
+/** Print per layer timing of last run */
+void nn_rt_dump_stat(nn_rt_t *rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @}  nn_runtime
+/// @}  file
+
+#endif /* __NN_RUNTIME_H__ */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
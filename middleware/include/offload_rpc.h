@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * @file   offload_rpc.h
+  * @author Sifli software development team
+  * @brief Offload RPC between HCPU and LCPU
+  * @{
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __OFFLOAD_RPC_H__
+#define __OFFLOAD_RPC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ipc_queue.h"
+
+/**
+****************************************************************************************
+* @addtogroup offload_rpc Offload RPC
+* @ingroup middleware
+* @brief Run compute kernels registered on the other core
+*
+* Kernels are registered by ID on the serving core. Caller passes a scalar parameter and buffer
+* descriptors, buffers are not copied, so they must be in memory accessible by both cores.
+* Result is returned asynchronously by callback, or synchronously by #offload_rpc_call.
+* Both cores could serve and call at the same time over the same queue.
+* @{
+****************************************************************************************
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OFFLOAD_RPC_MAX_KERNEL
+    #define OFFLOAD_RPC_MAX_KERNEL      (16)
+#endif
+
+#ifndef OFFLOAD_RPC_MAX_ARGS
+    #define OFFLOAD_RPC_MAX_ARGS        (4)
+#endif
+
+#ifndef OFFLOAD_RPC_MAX_PENDING
+    #define OFFLOAD_RPC_MAX_PENDING     (8)
+#endif
+
+#ifndef OFFLOAD_RPC_THREAD_STACK_SIZE
+    #define OFFLOAD_RPC_THREAD_STACK_SIZE   (2048)
+#endif
+
+#ifndef OFFLOAD_RPC_THREAD_PRIORITY
+    #define OFFLOAD_RPC_THREAD_PRIORITY     (RT_THREAD_PRIORITY_MIDDLE)
+#endif
+
+/** Error code */
+#define OFFLOAD_RPC_ERR_OK          (0)
+#define OFFLOAD_RPC_ERR_PARAM       (-1)    /**< invalid parameter */
+#define OFFLOAD_RPC_ERR_NO_KERNEL   (-2)    /**< kernel is not registered on remote core */
+#define OFFLOAD_RPC_ERR_BUSY        (-3)    /**< too many pending calls or queue is full */
+#define OFFLOAD_RPC_ERR_TIMEOUT     (-4)    /**< no response in time */
+#define OFFLOAD_RPC_ERR_NOT_INIT    (-5)    /**< offload RPC is not initialized */
+
+/** Buffer direction */
+#define OFFLOAD_RPC_ARG_IN          (1)     /**< buffer is read by kernel */
+#define OFFLOAD_RPC_ARG_OUT         (2)     /**< buffer is written by kernel */
+#define OFFLOAD_RPC_ARG_INOUT       (OFFLOAD_RPC_ARG_IN | OFFLOAD_RPC_ARG_OUT)
+
+/** Buffer descriptor given by caller, address is in caller's view */
+typedef struct
+{
+    void *ptr;                  /**< buffer address */
+    uint32_t len;               /**< buffer size in byte */
+    uint32_t dir;               /**< OFFLOAD_RPC_ARG_IN/OUT/INOUT */
+} offload_rpc_arg_t;
+
+/** Buffer descriptor received by kernel, address is translated to kernel's view */
+typedef struct
+{
+    void *ptr;                  /**< buffer address */
+    uint32_t len;               /**< buffer size in byte */
+} offload_rpc_buf_t;
+
+/** Kernel function
+ *
+ * @param[in] param  scalar parameter given by caller
+ * @param[in] buf    buffer descriptors
+ * @param[in] num    number of buffers
+ *
+ * @return result returned to caller, negative value is treated as failure in statistics
+ */
+typedef int32_t (*offload_rpc_kernel_t)(uint32_t param, offload_rpc_buf_t *buf, uint32_t num);
+
+/** Call completion callback, called in offload RPC thread
+ *
+ * @param[in] ret        result of kernel or negative error code
+ * @param[in] user_data  user data given in #offload_rpc_call_async
+ */
+typedef void (*offload_rpc_done_t)(int32_t ret, void *user_data);
+
+/** Per kernel statistics, time is in microsecond */
+typedef struct
+{
+    uint32_t call_cnt;          /**< calls made by this core */
+    uint32_t fail_cnt;          /**< calls returned negative value */
+    uint32_t rtt_max;           /**< max round trip time seen by caller */
+    uint32_t rtt_total;         /**< total round trip time seen by caller */
+    uint32_t exec_max;          /**< max execution time reported by remote core */
+    uint32_t exec_total;        /**< total execution time reported by remote core */
+    uint32_t serve_cnt;         /**< calls served by this core */
+    uint32_t serve_total;       /**< total execution time of calls served by this core */
+} offload_rpc_stat_t;
+
+/** Initialize offload RPC
+ *
+ * Queue is configured by application as shared buffer and queue id are assigned per project,
+ * same queue id should be used on both cores.
+ *
+ * @param[in] q_cfg  queue configuration, rx_ind is overridden
+ *
+ * @return 0: success, otherwise: fail
+ */
+int32_t offload_rpc_init(ipc_queue_cfg_t *q_cfg);
+
+/** Register kernel served by this core
+ *
+ * @param[in] id      kernel id, less than OFFLOAD_RPC_MAX_KERNEL
+ * @param[in] kernel  kernel function, NULL to unregister
+ * @param[in] name    kernel name for statistics
+ *
+ * @return 0: success, otherwise: fail
+ */
+int32_t offload_rpc_register(uint16_t id, offload_rpc_kernel_t kernel, const char *name);
+
+/** Call kernel on remote core asynchronously
+ *
+ * Buffers are cleaned from cache before request is sent, and output buffers are invalidated
+ * before done callback is called. They should be cache line aligned if they share line with other data.
+ *
+ * @param[in] id         kernel id
+ * @param[in] param      scalar parameter
+ * @param[in] arg        buffer descriptors
+ * @param[in] num        number of buffers, not more than OFFLOAD_RPC_MAX_ARGS
+ * @param[in] done       completion callback, could be NULL
+ * @param[in] user_data  parameter of callback
+ *
+ * @return 0: request is sent, otherwise: error code
+ */
+int32_t offload_rpc_call_async(uint16_t id, uint32_t param, const offload_rpc_arg_t *arg, uint32_t num,
+                               offload_rpc_done_t done, void *user_data);
+
+/** Call kernel on remote core and wait for result
+ *
+ * @param[in] id          kernel id
+ * @param[in] param       scalar parameter
+ * @param[in] arg         buffer descriptors
+ * @param[in] num         number of buffers
+ * @param[in] timeout_ms  timeout in millisecond, negative for wait forever
+ *
+ * @return result of kernel or negative error code
+ */
+int32_t offload_rpc_call(uint16_t id, uint32_t param, const offload_rpc_arg_t *arg, uint32_t num,
+                         int32_t timeout_ms);
+
+/** Get statistics of kernel
+ *
+ * @param[in]  id    kernel id
+ * @param[out] stat  statistics
+ * @param[in]  reset reset statistics after read
+ *
+ * @return 0: success, otherwise: fail
+ */
+int32_t offload_rpc_get_stat(uint16_t id, offload_rpc_stat_t *stat, bool reset);
+
+/** Translate local address to remote core's view, could be overridden for special memory
+ *
+ * @param[in] addr  local address
+ *
+ * @return address seen by remote core
+ */
+uint32_t offload_rpc_addr_to_remote(uint32_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @}  offload_rpc
+/// @}  file
+
+#endif /* __OFFLOAD_RPC_H__ */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
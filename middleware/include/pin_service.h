@@ -22,12 +22,20 @@ enum
     PIN_MSG_ENABLE_IRQ_RSP = RSP_MSG_TYPE | PIN_MSG_ENABLE_IRQ_REQ,
     PIN_MSG_DISABLE_IRQ_RSP = RSP_MSG_TYPE | PIN_MSG_DISABLE_IRQ_REQ,
     PIN_MSG_DETACH_IRQ_RSP = RSP_MSG_TYPE | PIN_MSG_DETACH_IRQ_REQ,
+
+    /*****Indication messages*****/
+    PIN_MSG_BATCH_IND = RSP_MSG_TYPE | (PIN_MSG_START + 0x10),  //pin_batch_msg_t, for PIN_SERVICE_FLAG_BATCH
 };
 
 typedef enum
 {
     PIN_SERVICE_FLAG_SET_IRQ_MODE       = (1 << 0), //Set pin irq mode
     PIN_SERVICE_FLAG_AUTO_DISABLE_IRQ   = (1 << 1), //Auto disable irq when it happened.
+    /* Without BATCH each irq is pushed as MSG_SERVICE_DATA_NTF_IND at once, use it for latency critical pin.
+       With BATCH edges are recorded in ISR and pushed together as PIN_MSG_BATCH_IND every batch_ms. */
+    PIN_SERVICE_FLAG_BATCH              = (1 << 2),
+    PIN_SERVICE_FLAG_QUAD               = (1 << 3), //Quadrature decode with phase B pin_b, both edges of both pins, implies BATCH
+    PIN_SERVICE_FLAG_BATCH_LEAD         = (1 << 4), //Push first edge after idle at once, e.g. for wakeup pin, then batch
 
 } pin_service_flag;
 
@@ -39,9 +47,30 @@ typedef struct
     uint16_t flag;             //See pin_service_flag
     uint8_t mode;              //See pin.h PIN_MODE_XXX definition
     uint8_t irq_mode;          //See pin.h PIN_IRQ_MODE_XXX definition
-
+    uint16_t batch_ms;         //Push interval of PIN_SERVICE_FLAG_BATCH, 0 for default
+    uint16_t pin_b;            //Phase B of PIN_SERVICE_FLAG_QUAD
 } pin_config_msg_t;
 
+#ifndef PIN_SERVICE_BATCH_FIFO_LEN
+    #define PIN_SERVICE_BATCH_FIFO_LEN  (32)
+#endif
+
+typedef struct
+{
+    uint32_t timestamp;        //ms
+    uint8_t level;             //Level of pin after the edge
+    uint8_t reserved[3];
+} pin_edge_event_t;
+
+typedef struct
+{
+    uint16_t id;               //Same position as pin_common_msg_t
+    uint16_t num;              //Number of event
+    uint32_t edges;            //Edges since last push, more than num if FIFO overflowed
+    int32_t quad_steps;        //Quadrature transitions since last push, 4 per cycle, positive if phase A leads
+    pin_edge_event_t event[0];
+} pin_batch_msg_t;
+
 
 typedef struct
 {
@@ -0,0 +1,86 @@
+#ifndef SENSOR_HUB_SERVICE_H
+#define SENSOR_HUB_SERVICE_H
+#include <rtthread.h>
+#include "data_service.h"
+
+/*
+    Sensor hub runs accelerometer driver and preprocessing on the core it is built for (normally LCPU),
+    results are batched and pushed to subscribers, which may be on the other core, no more often than
+    their latency tolerance allows. Subscriber configures it by datac_config() with sensor_hub_config_t.
+*/
+
+#define SENSOR_HUB_SERVICE_NAME     "sensor_hub"
+
+enum
+{
+    SENSOR_HUB_MSG_START = MSG_SERVICE_CUSTOM_ID_BEGIN, //0x30
+
+    /*****Request messages*****/
+    SENSOR_HUB_MSG_STAT_GET_REQ,
+    SENSOR_HUB_MSG_FLUSH_REQ,           //Push pending data now
+
+    /*****Response messages*****/
+    SENSOR_HUB_MSG_STAT_GET_RSP = RSP_MSG_TYPE | SENSOR_HUB_MSG_STAT_GET_REQ,
+    SENSOR_HUB_MSG_FLUSH_RSP = RSP_MSG_TYPE | SENSOR_HUB_MSG_FLUSH_REQ,
+
+    /*****Indication messages*****/
+    SENSOR_HUB_MSG_ACCE_IND = RSP_MSG_TYPE | (SENSOR_HUB_MSG_START + 0x10),   //sensor_hub_acce_ind_t
+    SENSOR_HUB_MSG_STEP_IND,                                                    //sensor_hub_step_ind_t
+    SENSOR_HUB_MSG_WRIST_IND,                                                   //sensor_hub_wrist_ind_t
+};
+
+typedef enum
+{
+    SENSOR_HUB_FEATURE_ACCE     = (1 << 0), //Filtered accelerometer samples
+    SENSOR_HUB_FEATURE_STEP     = (1 << 1), //Step count
+    SENSOR_HUB_FEATURE_WRIST    = (1 << 2), //Wrist raise, pushed without delay
+} sensor_hub_feature;
+
+/* Config of one subscriber, hub serves the union of features and the smallest latency */
+typedef struct
+{
+    uint32_t features;          //See sensor_hub_feature
+    uint16_t max_latency_ms;    //Tolerated delay of batched data and step count, 0 for default
+    uint16_t odr_hz;            //Wanted sample rate, 0 for default
+} sensor_hub_config_t;
+
+typedef struct
+{
+    int16_t x;                  //mG
+    int16_t y;
+    int16_t z;
+} sensor_hub_acce_t;
+
+typedef struct
+{
+    uint32_t timestamp;         //Time of sample[0] in ms
+    uint16_t interval_ms;       //Interval of samples
+    uint16_t num;
+    sensor_hub_acce_t sample[0];
+} sensor_hub_acce_ind_t;
+
+typedef struct
+{
+    uint32_t timestamp;         //Time of last step in ms
+    uint32_t steps;             //Total steps since hub started
+} sensor_hub_step_ind_t;
+
+typedef struct
+{
+    uint32_t timestamp;
+} sensor_hub_wrist_ind_t;
+
+/* Response of SENSOR_HUB_MSG_STAT_GET_REQ, pushes is the number of deliveries that may wake subscriber core */
+typedef struct
+{
+    uint32_t run_ms;            //Time sensor has been running
+    uint32_t samples;
+    uint32_t reads;             //Sensor reads, i.e. wakeups of hub core
+    uint32_t pushes;
+    uint32_t acce_pushes;
+    uint32_t step_pushes;
+    uint32_t wrist_pushes;
+    uint32_t steps;
+} sensor_hub_stat_t;
+
+#endif  /* SENSOR_HUB_SERVICE_H */
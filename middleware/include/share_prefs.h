@@ -50,6 +50,7 @@
 
 #include <rtthread.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 
 
@@ -177,6 +178,34 @@ int32_t share_prefs_get_block(share_prefs_t *prfs, const char *key, void *buf, i
 */
 rt_err_t share_prefs_set_block(share_prefs_t *prfs, const char *key, const void *buf, int32_t buf_len);
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+/// Write-back cache statistics
+typedef struct
+{
+    uint32_t set;           /*!< Set and remove requests*/
+    uint32_t flash_write;   /*!< Writes committed to flash*/
+    uint32_t saved_write;   /*!< Requests merged with pending change or unchanged value*/
+    uint32_t hit;           /*!< Reads served from cache*/
+    uint32_t miss;
+    uint32_t dirty;         /*!< Entries not committed yet*/
+} share_prefs_cache_stat_t;
+
+/**
+    @brief Write cached changes to flash.
+           Changes are also committed on close, SHARE_PREFS_CACHE_COMMIT_MS after first change and before deep sleep.
+    @param[in] prfs Handle of shared preference database, NULL for all opened handles
+    @retval RT_EOK if successful, otherwise return error number
+*/
+rt_err_t share_prefs_commit(share_prefs_t *prfs);
+
+/**
+    @brief Get write-back cache statistics of all handles
+    @param[out] stat Statistics
+    @param[in] reset Clear statistics afterwards
+*/
+void share_prefs_get_cache_stat(share_prefs_cache_stat_t *stat, bool reset);
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
 /// @} shard_pref
 /// @} file
 
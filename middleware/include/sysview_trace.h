@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file   sysview_trace.h
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef SYSVIEW_TRACE_H
+#define SYSVIEW_TRACE_H
+
+#include <stdint.h>
+#include "rtconfig.h"
+
+/**
+ ****************************************************************************************
+* @addtogroup sysview_trace SystemView Trace Points
+* @ingroup middleware
+* @brief Driver and middleware trace points recorded by SystemView
+*
+* Each trace point is shown as a call with duration in SystemView, module "SiFli".
+* Trace points are enabled by bit mask PKG_SYSVIEW_TRACE_MASK at compile time,
+* bit n enables trace point n, disabled trace points are compiled out.
+* @{
+****************************************************************************************
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Trace point id, also bit index in PKG_SYSVIEW_TRACE_MASK */
+#define SYSVIEW_TRACE_DMA           (0)     /**< DMA channel IRQ, param: (controller << 4) | channel */
+#define SYSVIEW_TRACE_LCDC          (1)     /**< LCDC IRQ */
+#define SYSVIEW_TRACE_EPIC          (2)     /**< EPIC IRQ */
+#define SYSVIEW_TRACE_EZIP          (3)     /**< EZIP IRQ */
+#define SYSVIEW_TRACE_AUDPRC        (4)     /**< AUDPRC DMA IRQ, param: DMA index */
+#define SYSVIEW_TRACE_MAILBOX       (5)     /**< Mailbox IRQ, param: mailbox */
+#define SYSVIEW_TRACE_IPC_SEND      (6)     /**< ipc_queue write, param: handle, size */
+#define SYSVIEW_TRACE_IPC_RECV      (7)     /**< ipc_queue read, param: handle, size */
+#define SYSVIEW_TRACE_DATASRV       (8)     /**< data_service message handler, param: service id, message id */
+#define SYSVIEW_TRACE_AUDIO         (9)     /**< audio server processing, param: events */
+#define SYSVIEW_TRACE_NUM           (10)
+
+#if defined(PKG_USING_SYSTEMVIEW) && defined(PKG_SYSVIEW_TRACE_MASK)
+    #define SYSVIEW_TRACE_MASK      (PKG_SYSVIEW_TRACE_MASK)
+#else
+    #define SYSVIEW_TRACE_MASK      (0)
+#endif
+
+#if SYSVIEW_TRACE_MASK
+void sysview_trace_enter(uint32_t id, uint32_t p0, uint32_t p1);
+void sysview_trace_exit(uint32_t id);
+
+/* Condition is constant, nothing left for disabled trace point */
+#define SYSVIEW_TRACE_ENTER(id, p0, p1)     do { if (SYSVIEW_TRACE_MASK & (1UL << (id))) sysview_trace_enter(id, (uint32_t)(p0), (uint32_t)(p1)); } while (0)
+#define SYSVIEW_TRACE_EXIT(id)              do { if (SYSVIEW_TRACE_MASK & (1UL << (id))) sysview_trace_exit(id); } while (0)
+#else
+#define SYSVIEW_TRACE_ENTER(id, p0, p1)
+#define SYSVIEW_TRACE_EXIT(id)
+#endif /* SYSVIEW_TRACE_MASK */
+
+/// @}  sysview_trace
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @} file
+#endif /* SYSVIEW_TRACE_H */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
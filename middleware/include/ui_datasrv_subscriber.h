@@ -75,6 +75,35 @@ void ui_datac_init(void);
     */
 datac_handle_t ui_datac_subscribe(datac_handle_t handle, char *name, data_callback_t cbk, uint32_t user_data);
 
+/**
+    @brief Subscribe data service in GUI thread context, data messages are coalesced per frame.
+    Only latest data of every message ID is called back, once per display refresh period and
+    right before rendering. Data same as last callback is not called back again.
+    Other messages (e.g. responses) are called back as ui_datac_subscribe().
+    @param[in] handle data client handle
+    @param[in] name Data service name
+    @param[in] cbk Callback functions for data service.
+    @param[in] user_data Callback function parameter. Service provide will call callback with it.
+    */
+void ui_datac_subscribe_latest(datac_handle_t handle, char *name, data_callback_t cbk, uint32_t user_data);
+
+/** Statistics of subscriptions made by ui_datac_subscribe_latest() */
+typedef struct
+{
+    uint32_t received;      /*!< Messages from data service */
+    uint32_t delivered;     /*!< Callbacks issued */
+    uint32_t superseded;    /*!< Data messages replaced by newer one in the same frame */
+    uint32_t unchanged;     /*!< Data messages same as last callback */
+    uint32_t no_slot;       /*!< Data messages called back at once as all slots are pending */
+    uint32_t frames;        /*!< Refresh periods with at least one data callback */
+} ui_datac_stat_t;
+
+/**
+    @brief Get statistics of coalesced subscriptions.
+    @param[out] stat statistics
+    */
+void ui_datac_get_stat(ui_datac_stat_t *stat);
+
 ///@} ui_datac
 #endif /*__UI_DATASRV_H__*/
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
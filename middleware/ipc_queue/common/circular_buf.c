@@ -491,6 +491,161 @@ __ROM_USED size_t circular_buf_getchar(struct circular_buf *cb, uint8_t *ch)
     return 1;
 }
 
+/**
+ * get the contiguous free space at the write position without copying
+ *
+ * At most length bytes are reserved, less is returned if the space wraps around
+ * the end of the pool. The data is not visible to the reader until
+ * circular_buf_write_commit is called.
+ */
+__ROM_USED size_t circular_buf_write_reserve(struct circular_buf *cb,
+        uint8_t           **ptr,
+        uint16_t            length)
+{
+    uint16_t size;
+    uint32_t wr_idx;
+
+    SF_ASSERT(cb != NULL);
+    SF_ASSERT(ptr != NULL);
+
+    *ptr = NULL;
+
+    size = circular_buf_space_len(cb);
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if (size < length)
+    {
+        length = size;
+    }
+
+    wr_idx = CB_GET_PTR_IDX(cb->write_idx_mirror);
+    if ((cb->buffer_size - wr_idx) < length)
+    {
+        length = cb->buffer_size - wr_idx;
+    }
+
+    *ptr = &cb->wr_buffer_ptr[wr_idx];
+
+    return length;
+}
+
+/**
+ * publish the data filled in the region got by circular_buf_write_reserve
+ */
+__ROM_USED size_t circular_buf_write_commit(struct circular_buf *cb, uint16_t length)
+{
+    uint32_t wr_mirror;
+    uint32_t wr_idx;
+
+    SF_ASSERT(cb != NULL);
+
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    SF_ASSERT(length <= circular_buf_space_len(cb));
+
+    wr_idx = CB_GET_PTR_IDX(cb->write_idx_mirror);
+    wr_mirror = CB_GET_PTR_MIRROR(cb->write_idx_mirror);
+    SF_ASSERT((cb->buffer_size - wr_idx) >= length);
+
+    wr_idx += length;
+    if (wr_idx == cb->buffer_size)
+    {
+        /* we are going into the other side of the mirror */
+        wr_mirror = ~wr_mirror;
+        wr_idx = 0;
+    }
+    cb->write_idx_mirror = CB_MAKE_PTR_IDX_MIRROR(wr_idx, wr_mirror);
+
+    return length;
+}
+
+/**
+ * get the contiguous data at the read position without copying
+ *
+ * Less than the total data length is returned if the data wraps around
+ * the end of the pool. The data is kept in cb until circular_buf_read_release is called.
+ */
+__ROM_USED size_t circular_buf_read_peek(struct circular_buf *cb, uint8_t **ptr)
+{
+    size_t size;
+    uint32_t rd_idx;
+
+    SF_ASSERT(cb != NULL);
+    SF_ASSERT(ptr != NULL);
+
+    *ptr = NULL;
+
+    size = circular_buf_data_len(cb);
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    rd_idx = CB_GET_PTR_IDX(cb->read_idx_mirror);
+    if ((cb->buffer_size - rd_idx) < size)
+    {
+        size = cb->buffer_size - rd_idx;
+    }
+
+    *ptr = &cb->rd_buffer_ptr[rd_idx];
+
+    return size;
+}
+
+/**
+ * drop the data consumed in the region got by circular_buf_read_peek and return remaining length
+ */
+__ROM_USED size_t circular_buf_read_release(struct circular_buf *cb,
+        uint16_t           length,
+        size_t            *remaining_len)
+{
+    size_t size;
+    uint32_t mask;
+    uint32_t rd_mirror;
+    uint32_t rd_idx;
+
+    SF_ASSERT(cb != NULL);
+
+    size = circular_buf_data_len(cb);
+    if (size < length)
+    {
+        length = size;
+    }
+
+    rd_idx = CB_GET_PTR_IDX(cb->read_idx_mirror);
+    rd_mirror = CB_GET_PTR_MIRROR(cb->read_idx_mirror);
+    if ((cb->buffer_size - rd_idx) < length)
+    {
+        length = cb->buffer_size - rd_idx;
+    }
+
+    mask = os_interrupt_disable();
+
+    if (remaining_len)
+    {
+        *remaining_len = circular_buf_data_len(cb) - length;
+    }
+
+    rd_idx += length;
+    if (rd_idx == cb->buffer_size)
+    {
+        /* we are going into the other side of the mirror */
+        rd_mirror = ~rd_mirror;
+        rd_idx = 0;
+    }
+    cb->read_idx_mirror = CB_MAKE_PTR_IDX_MIRROR(rd_idx, rd_mirror);
+
+    os_interrupt_enable(mask);
+
+    return length;
+}
+
 /**
  * get the size of data in cb
  */
@@ -130,6 +130,10 @@ size_t circular_buf_get_and_update_len(struct circular_buf *cb,
                                        size_t             *remaining_len);
 size_t circular_buf_getchar(struct circular_buf *cb, uint8_t *ch);
 size_t circular_buf_data_len(struct circular_buf *cb);
+size_t circular_buf_write_reserve(struct circular_buf *cb, uint8_t **ptr, uint16_t length);
+size_t circular_buf_write_commit(struct circular_buf *cb, uint16_t length);
+size_t circular_buf_read_peek(struct circular_buf *cb, uint8_t **ptr);
+size_t circular_buf_read_release(struct circular_buf *cb, uint16_t length, size_t *remaining_len);
 
 
 inline uint16_t circular_buf_get_size(struct circular_buf *cb)
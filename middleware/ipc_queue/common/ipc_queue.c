@@ -51,6 +51,7 @@
 #include "ipc_queue.h"
 #include "ipc_hw.h"
 #include "circular_buf.h"
+#include "sysview_trace.h"
 //#include "log.h"
 
 #ifndef __ROM_USED
@@ -81,6 +82,18 @@ typedef struct
 
 __ROM_USED ipc_ctx_t ipc_ctx;
 
+/** doorbell coalescing state, kept out of ipc_ctx to keep its layout unchanged */
+typedef struct
+{
+    ipc_queue_coalesce_cfg_t cfg;
+    uint32_t pending_len;                 /**< bytes written but not signalled to receiver */
+    uint32_t pending_tick;                /**< HAL_GetTick when first pending byte was written */
+    os_timer_handle_t timer;              /**< max latency timer */
+    ipc_queue_coalesce_stat_t stat;
+} ipc_queue_coalesce_t;
+
+static ipc_queue_coalesce_t ipc_coalesce[IPC_LOGICAL_QUEUE_NUM];
+
 
 static bool is_valid_handle(ipc_queue_handle_t handle)
 {
@@ -109,6 +122,99 @@ static bool is_valid_handle(ipc_queue_handle_t handle)
     return valid;
 }
 
+static void ipc_queue_ring(int32_t offset, uint32_t reason)
+{
+    ipc_queue_coalesce_t *co = &ipc_coalesce[offset];
+    uint32_t latency;
+
+    if (co->pending_len > 0)
+    {
+        latency = HAL_GetTick() - co->pending_tick;
+        if (latency > co->stat.max_latency)
+        {
+            co->stat.max_latency = latency;
+        }
+        if (co->pending_len > co->stat.max_pending_len)
+        {
+            co->stat.max_pending_len = co->pending_len;
+        }
+    }
+    co->pending_len = 0;
+    co->stat.doorbell_cnt++;
+    if (IPC_QUEUE_DOORBELL_THRESHOLD == reason)
+    {
+        co->stat.threshold_cnt++;
+    }
+    else if (IPC_QUEUE_DOORBELL_TIMEOUT == reason)
+    {
+        co->stat.timeout_cnt++;
+    }
+    else
+    {
+        co->stat.flush_cnt++;
+    }
+    if (co->timer)
+    {
+        os_timer_stop(co->timer);
+    }
+    ipc_hw_trigger_interrupt(&ipc_ctx.queues[offset].hw_q_handle);
+}
+
+/** Inform the receiver about len bytes of new data, doorbell may be deferred if coalescing is enabled */
+static void ipc_queue_doorbell(int32_t offset, size_t len, bool force)
+{
+    ipc_queue_coalesce_t *co = &ipc_coalesce[offset];
+    uint32_t mask;
+
+    if (0 == co->cfg.threshold)
+    {
+        ipc_hw_trigger_interrupt(&ipc_ctx.queues[offset].hw_q_handle);
+        return;
+    }
+
+    mask = os_interrupt_disable();
+
+    co->stat.write_cnt++;
+    if ((0 == co->pending_len) && (len > 0))
+    {
+        co->pending_tick = HAL_GetTick();
+    }
+    co->pending_len += len;
+
+    if (force)
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_FLUSH);
+    }
+    else if (co->pending_len >= co->cfg.threshold)
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_THRESHOLD);
+    }
+    else if ((HAL_GetTick() - co->pending_tick) >= co->cfg.max_latency)
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_TIMEOUT);
+    }
+    else if ((co->pending_len == len) && co->timer)
+    {
+        /* first pending data, arm the latency timer */
+        os_timer_start(co->timer);
+    }
+
+    os_interrupt_enable(mask);
+}
+
+static void ipc_queue_coalesce_timeout(void *param)
+{
+    int32_t offset = (int32_t)param;
+    uint32_t mask;
+
+    mask = os_interrupt_disable();
+    if (ipc_ctx.queues[offset].active && (ipc_coalesce[offset].pending_len > 0))
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_TIMEOUT);
+    }
+    os_interrupt_enable(mask);
+}
+
 __ROM_USED ipc_queue_handle_t ipc_queue_init(ipc_queue_cfg_t *q_cfg)
 {
     uint32_t i;
@@ -375,6 +481,11 @@ __ROM_USED int32_t ipc_queue_close(ipc_queue_handle_t handle)
     mask = os_interrupt_disable();
     result = ipc_hw_disable_interrupt(&queue->hw_q_handle);
     queue->active = false;
+    if (ipc_coalesce[offset].timer)
+    {
+        os_timer_stop(ipc_coalesce[offset].timer);
+    }
+    ipc_coalesce[offset].pending_len = 0;
     queue->rx_ring_buffer = NULL;
     queue->tx_ring_buffer = NULL;
 
@@ -405,6 +516,11 @@ __ROM_USED int32_t ipc_queue_close2(ipc_queue_handle_t handle)
     mask = os_interrupt_disable();
     result = ipc_hw_disable_interrupt2(&queue->hw_q_handle);
     queue->active = false;
+    if (ipc_coalesce[offset].timer)
+    {
+        os_timer_stop(ipc_coalesce[offset].timer);
+    }
+    ipc_coalesce[offset].pending_len = 0;
     queue->rx_ring_buffer = NULL;
     queue->tx_ring_buffer = NULL;
 
@@ -472,7 +588,9 @@ __ROM_USED size_t ipc_queue_read(ipc_queue_handle_t handle, void *buffer, size_t
         return 0;
     }
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_IPC_RECV, handle, size);
     data_len = circular_buf_get_and_update_len(queue->rx_ring_buffer, buffer, size, (size_t *)&queue->data_len);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_IPC_RECV);
 
     return data_len;
 }
@@ -500,8 +618,8 @@ __ROM_USED size_t ipc_queue_write(ipc_queue_handle_t handle, const void *buffer,
 
     if (NULL == buffer)
     {
-        /* just trigger interrupt */
-        ipc_hw_trigger_interrupt(&queue->hw_q_handle);
+        /* just trigger interrupt, pending data is also flushed */
+        ipc_queue_doorbell(offset, 0, true);
         return 0;
     }
 
@@ -510,6 +628,7 @@ __ROM_USED size_t ipc_queue_write(ipc_queue_handle_t handle, const void *buffer,
         return 0;
     }
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_IPC_SEND, handle, size);
     cnt = 0;
     start_time = HAL_GetTick();
     total_len = size;
@@ -522,8 +641,8 @@ __ROM_USED size_t ipc_queue_write(ipc_queue_handle_t handle, const void *buffer,
 
         if (data_len > 0)
         {
-            /* trigger mailbox if new data has been written */
-            ipc_hw_trigger_interrupt(&queue->hw_q_handle);
+            /* trigger mailbox if new data has been written, don't defer it if tx buffer is full */
+            ipc_queue_doorbell(offset, data_len, total_len > 0);
         }
         if (HAL_GetTick() != start_time)
         {
@@ -536,9 +655,343 @@ __ROM_USED size_t ipc_queue_write(ipc_queue_handle_t handle, const void *buffer,
         }
     }
 
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_IPC_SEND);
+
     return (size - total_len);
 }
 
+__ROM_USED size_t ipc_queue_writev(ipc_queue_handle_t handle, const ipc_queue_iovec_t *iov, uint32_t iov_cnt, uint32_t timeout)
+{
+    size_t data_len;
+    uint32_t start_time;
+    uint32_t cnt;
+    uint32_t i;
+    size_t total_len;
+    size_t written;
+    size_t unsignalled;
+    const uint8_t *buffer;
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (!is_valid_handle(handle))
+    {
+        return 0;
+    }
+
+    if ((NULL == iov) || (0 == iov_cnt))
+    {
+        return 0;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+    if (!queue->active)
+    {
+        return 0;
+    }
+
+    if (!queue->tx_ring_buffer)
+    {
+        return 0;
+    }
+
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_IPC_SEND, handle, 0);
+    cnt = 0;
+    written = 0;
+    unsignalled = 0;
+    start_time = HAL_GetTick();
+    for (i = 0; i < iov_cnt; i++)
+    {
+        buffer = (const uint8_t *)iov[i].base;
+        total_len = iov[i].len;
+        while (total_len > 0)
+        {
+            data_len = circular_buf_put(queue->tx_ring_buffer, buffer, total_len);
+            SF_ASSERT(data_len <= total_len);
+            total_len -= data_len;
+            buffer += data_len;
+            written += data_len;
+            unsignalled += data_len;
+
+            if (0 == total_len)
+            {
+                break;
+            }
+
+            /* tx buffer is full, let receiver drain what has been written so far */
+            if (unsignalled > 0)
+            {
+                ipc_queue_doorbell(offset, unsignalled, true);
+                unsignalled = 0;
+            }
+            if (HAL_GetTick() != start_time)
+            {
+                cnt++;
+                start_time = HAL_GetTick();
+            }
+            if (cnt >= timeout)
+            {
+                goto __END;
+            }
+        }
+    }
+
+__END:
+    if (unsignalled > 0)
+    {
+        /* only one interrupt for the whole frame if it fits in tx buffer */
+        ipc_queue_doorbell(offset, unsignalled, false);
+    }
+
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_IPC_SEND);
+
+    return written;
+}
+
+__ROM_USED size_t ipc_queue_write_reserve(ipc_queue_handle_t handle, void **buffer, size_t size)
+{
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (NULL == buffer)
+    {
+        return 0;
+    }
+    *buffer = NULL;
+
+    if (!is_valid_handle(handle))
+    {
+        return 0;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+    if (!queue->active)
+    {
+        return 0;
+    }
+
+    if (!queue->tx_ring_buffer)
+    {
+        return 0;
+    }
+
+    if (size > UINT16_MAX)
+    {
+        size = UINT16_MAX;
+    }
+
+    return circular_buf_write_reserve(queue->tx_ring_buffer, (uint8_t **)buffer, size);
+}
+
+__ROM_USED int32_t ipc_queue_write_commit(ipc_queue_handle_t handle, size_t size)
+{
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (!is_valid_handle(handle))
+    {
+        return -1;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+    if (!queue->active)
+    {
+        return -1;
+    }
+
+    if (!queue->tx_ring_buffer)
+    {
+        return -1;
+    }
+
+    if (0 == size)
+    {
+        return 0;
+    }
+
+    circular_buf_write_commit(queue->tx_ring_buffer, size);
+    ipc_queue_doorbell(offset, size, false);
+
+    return 0;
+}
+
+__ROM_USED size_t ipc_queue_read_peek(ipc_queue_handle_t handle, const void **buffer)
+{
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (NULL == buffer)
+    {
+        return 0;
+    }
+    *buffer = NULL;
+
+    if (!is_valid_handle(handle))
+    {
+        return 0;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+
+    if (!queue->active)
+    {
+        return 0;
+    }
+
+    if (!queue->rx_ring_buffer)
+    {
+        return 0;
+    }
+
+    if (0 == queue->data_len)
+    {
+        return 0;
+    }
+
+    return circular_buf_read_peek(queue->rx_ring_buffer, (uint8_t **)buffer);
+}
+
+__ROM_USED size_t ipc_queue_read_release(ipc_queue_handle_t handle, size_t size)
+{
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (!is_valid_handle(handle))
+    {
+        return 0;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+
+    if (!queue->active)
+    {
+        return 0;
+    }
+
+    if (!queue->rx_ring_buffer)
+    {
+        return 0;
+    }
+
+    if ((0 == queue->data_len) || (0 == size))
+    {
+        return 0;
+    }
+
+    if (size > UINT16_MAX)
+    {
+        size = UINT16_MAX;
+    }
+
+    return circular_buf_read_release(queue->rx_ring_buffer, size, (size_t *)&queue->data_len);
+}
+
+int32_t ipc_queue_set_coalesce(ipc_queue_handle_t handle, const ipc_queue_coalesce_cfg_t *cfg)
+{
+    ipc_queue_coalesce_t *co;
+    os_timer_handle_t timer;
+    os_timer_handle_t old_timer;
+    int32_t offset;
+    uint32_t mask;
+
+    if (!is_valid_handle(handle))
+    {
+        return -1;
+    }
+
+    if (cfg && (cfg->threshold > 0) && (0 == cfg->max_latency))
+    {
+        return -1;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    co = &ipc_coalesce[offset];
+
+    timer = NULL;
+    if (cfg && (cfg->threshold > 0))
+    {
+        timer = os_timer_create("ipcq_co", ipc_queue_coalesce_timeout, (void *)offset, cfg->max_latency);
+    }
+
+    mask = os_interrupt_disable();
+    if (co->pending_len > 0)
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_FLUSH);
+    }
+    old_timer = co->timer;
+    co->timer = timer;
+    if (cfg)
+    {
+        memcpy(&co->cfg, cfg, sizeof(co->cfg));
+    }
+    else
+    {
+        memset(&co->cfg, 0, sizeof(co->cfg));
+    }
+    os_interrupt_enable(mask);
+
+    if (old_timer)
+    {
+        os_timer_stop(old_timer);
+        os_timer_delete(old_timer);
+    }
+
+    return 0;
+}
+
+int32_t ipc_queue_flush(ipc_queue_handle_t handle)
+{
+    int32_t offset;
+    uint32_t mask;
+
+    if (!is_valid_handle(handle))
+    {
+        return -1;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    if (!ipc_ctx.queues[offset].active)
+    {
+        return -1;
+    }
+
+    mask = os_interrupt_disable();
+    if (ipc_coalesce[offset].pending_len > 0)
+    {
+        ipc_queue_ring(offset, IPC_QUEUE_DOORBELL_FLUSH);
+    }
+    os_interrupt_enable(mask);
+
+    return 0;
+}
+
+int32_t ipc_queue_get_coalesce_stat(ipc_queue_handle_t handle, ipc_queue_coalesce_stat_t *stat, bool reset)
+{
+    int32_t offset;
+    uint32_t mask;
+
+    if (!is_valid_handle(handle) || !stat)
+    {
+        return -1;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+
+    mask = os_interrupt_disable();
+    memcpy(stat, &ipc_coalesce[offset].stat, sizeof(*stat));
+    if (reset)
+    {
+        memset(&ipc_coalesce[offset].stat, 0, sizeof(ipc_coalesce[offset].stat));
+    }
+    os_interrupt_enable(mask);
+
+    return 0;
+}
+
 __ROM_USED bool ipc_queue_check_idle(void)
 {
     bool is_idle = true;
@@ -666,5 +1119,26 @@ __ROM_USED size_t ipc_queue_get_rx_size(ipc_queue_handle_t handle)
     return queue->data_len;
 }
 
+size_t ipc_queue_get_tx_space(ipc_queue_handle_t handle)
+{
+    ipc_queue_t *queue;
+    int32_t offset;
+
+    if (!is_valid_handle(handle))
+    {
+        return 0;
+    }
+
+    offset = IPC_QUEUE_HANDLE_2_OFFSET(handle);
+    queue = &ipc_ctx.queues[offset];
+
+    if (!queue->active || !queue->tx_ring_buffer)
+    {
+        return 0;
+    }
+
+    return circular_buf_space_len(queue->tx_ring_buffer);
+}
+
 
 
@@ -60,6 +60,14 @@ extern "C" {
 #define os_interrupt_enter()
 #define os_interrupt_exit()
 
+typedef void *os_timer_handle_t;
+
+/* no timer available, pending data is flushed by next write or ipc_queue_flush */
+#define os_timer_create(name, func, arg, ms)  (NULL)
+#define os_timer_start(timer)
+#define os_timer_stop(timer)
+#define os_timer_delete(timer)
+
 
 /// @}  file
 
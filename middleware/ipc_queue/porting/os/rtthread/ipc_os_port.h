@@ -62,6 +62,15 @@ extern "C" {
 #define os_interrupt_enter()        rt_interrupt_enter()
 #define os_interrupt_exit()         rt_interrupt_leave()
 
+typedef rt_timer_t os_timer_handle_t;
+
+/* one shot timer, callback is called in interrupt context */
+#define os_timer_create(name, func, arg, ms)  \
+    rt_timer_create(name, func, arg, rt_tick_from_millisecond(ms), RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER)
+#define os_timer_start(timer)       rt_timer_start(timer)
+#define os_timer_stop(timer)        rt_timer_stop(timer)
+#define os_timer_delete(timer)      rt_timer_delete(timer)
+
 
 /// @}  file
 
@@ -48,6 +48,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ipc_hw.h"
+#include "sysview_trace.h"
 
 static void bcpu2hcpu_notification_callback(MAILBOX_HandleTypeDef *hmailbox, uint8_t q_idx);
 
@@ -94,7 +95,9 @@ void LCPU2HCPU_IRQHandler(void)
 {
     /* enter interrupt */
     os_interrupt_enter();
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_MAILBOX, (&ipc_hw_obj.ch[0].cfg.rx.handle)->Instance, 0);
     HAL_MAILBOX_IRQHandler(&ipc_hw_obj.ch[0].cfg.rx.handle);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_MAILBOX);
     /* leave interrupt */
     os_interrupt_exit();
 }
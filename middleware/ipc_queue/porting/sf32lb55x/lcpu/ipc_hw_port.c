@@ -48,6 +48,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ipc_hw.h"
+#include "sysview_trace.h"
 
 __WEAK void ipc_queue_data_ind_rom(uint32_t user_data)
 {
@@ -130,7 +131,9 @@ void HCPU2LCPU_IRQHandler(void)
     /* enter interrupt */
     os_interrupt_enter();
     /* use replaced rx_handle to make RAM notification_callback version take effect*/
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_MAILBOX, (&h2l_rx_handle)->Instance, 0);
     HAL_MAILBOX_IRQHandler(&h2l_rx_handle);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_MAILBOX);
     /* leave interrupt */
     os_interrupt_exit();
 }
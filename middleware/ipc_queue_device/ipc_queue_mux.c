@@ -0,0 +1,512 @@
+/**
+  ******************************************************************************
+  * @file   ipc_queue_mux.c
+  * @author Sifli software development team
+  * @brief Logical channels multiplexed over one ipc queue
+ *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2026,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "rtthread.h"
+#include "rtdevice.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ipc_queue.h"
+#include "ipc_queue_mux.h"
+
+#define DBG_TAG           "ipc_mux"
+#define DBG_LVL           DBG_INFO
+#include "rtdbg.h"
+
+#ifndef IPC_MUX_WRITE_TIMEOUT
+    #define IPC_MUX_WRITE_TIMEOUT       (1000)
+#endif
+
+#ifndef IPC_MUX_THREAD_STACK_SIZE
+    #define IPC_MUX_THREAD_STACK_SIZE   (1024)
+#endif
+
+#define IPC_MUX_FRAME_DATA     (0)
+/** header only, len is number of bytes the receiver has consumed */
+#define IPC_MUX_FRAME_CREDIT   (1)
+
+typedef struct
+{
+    uint8_t ch;
+    uint8_t type;
+    uint16_t len;
+} ipc_mux_hdr_t;
+
+typedef struct ipc_mux ipc_mux_t;
+
+typedef struct
+{
+    struct rt_device dev;
+    const ipc_mux_chan_cfg_t *cfg;
+    ipc_mux_t *mux;
+    struct rt_ringbuffer rb;
+    /** bytes allowed to send before peer returns credit */
+    uint32_t tx_credit;
+    /** bytes read by user, not reported to peer yet */
+    uint32_t consumed;
+    struct rt_semaphore credit_sem;
+    ipc_mux_stat_t stat;
+} ipc_mux_chan_t;
+
+struct ipc_mux
+{
+    ipc_mux_t *next;
+    ipc_queue_handle_t queue;
+    ipc_mux_chan_t *chan;
+    uint8_t chan_num;
+    rt_mutex_t tx_lock;
+    struct rt_semaphore rx_sem;
+    rt_thread_t thread;
+    /* rx frame being parsed, header may be split at the end of rx buffer */
+    ipc_mux_hdr_t hdr;
+    uint8_t hdr_len;
+    uint16_t rx_remain;
+    ipc_mux_chan_t *rx_chan;
+    uint32_t unknown_drop;
+};
+
+static ipc_mux_t *ipc_mux_list;
+
+static ipc_mux_chan_t *ipc_mux_find_chan(ipc_mux_t *mux, uint8_t id)
+{
+    for (uint32_t i = 0; i < mux->chan_num; i++)
+    {
+        if (mux->chan[i].cfg->id == id)
+        {
+            return &mux->chan[i];
+        }
+    }
+    return NULL;
+}
+
+/* Must be called with tx_lock held */
+static bool ipc_mux_wait_space(ipc_mux_chan_t *chan, size_t size, rt_tick_t start, rt_tick_t timeout)
+{
+    ipc_mux_t *mux = chan->mux;
+    size_t reserve = (IPC_MUX_PRIO_HIGH == chan->cfg->prio) ? 0 : IPC_MUX_HIGH_RESERVE;
+    bool waited = false;
+
+    /* Lower priority channel leaves the reserved space for control message
+       instead of filling the whole buffer and making it wait behind bulk data */
+    while (ipc_queue_get_tx_space(mux->queue) < size + reserve)
+    {
+        if ((rt_tick_get() - start) >= timeout)
+        {
+            return false;
+        }
+        if (!waited)
+        {
+            chan->stat.space_waits++;
+            waited = true;
+        }
+        rt_mutex_release(mux->tx_lock);
+        rt_thread_mdelay(1);
+        rt_mutex_take(mux->tx_lock, RT_WAITING_FOREVER);
+    }
+
+    return true;
+}
+
+static void ipc_mux_send_credit(ipc_mux_chan_t *chan, uint32_t credit)
+{
+    ipc_mux_t *mux = chan->mux;
+    ipc_mux_hdr_t hdr;
+    ipc_queue_iovec_t iov;
+
+    hdr.ch = chan->cfg->id;
+    hdr.type = IPC_MUX_FRAME_CREDIT;
+    hdr.len = (uint16_t)credit;
+    iov.base = &hdr;
+    iov.len = sizeof(hdr);
+
+    rt_mutex_take(mux->tx_lock, RT_WAITING_FOREVER);
+    /* credit bypasses reserve, otherwise both sides could wait for each other */
+    if (sizeof(hdr) != ipc_queue_writev(mux->queue, &iov, 1, IPC_MUX_WRITE_TIMEOUT))
+    {
+        LOG_E("ch%d: credit lost", chan->cfg->id);
+    }
+    rt_mutex_release(mux->tx_lock);
+}
+
+static rt_err_t ipc_mux_chan_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    ipc_mux_chan_t *chan = (ipc_mux_chan_t *)dev->user_data;
+
+    if (!ipc_queue_is_open(chan->mux->queue))
+    {
+        return ipc_queue_open(chan->mux->queue);
+    }
+    return RT_EOK;
+}
+
+static rt_err_t ipc_mux_chan_close(rt_device_t dev)
+{
+    /* queue is shared by all channels, keep it open */
+    return RT_EOK;
+}
+
+static rt_size_t ipc_mux_chan_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    ipc_mux_chan_t *chan = (ipc_mux_chan_t *)dev->user_data;
+    rt_size_t len;
+    uint32_t credit = 0;
+
+    rt_enter_critical();
+    len = rt_ringbuffer_get(&chan->rb, buffer, size);
+    chan->consumed += len;
+    /* Return credit in batch to avoid one credit frame per read */
+    if (chan->consumed >= (chan->cfg->rx_buf_size >> 1))
+    {
+        credit = chan->consumed;
+        chan->consumed = 0;
+    }
+    rt_exit_critical();
+
+    if (credit)
+    {
+        ipc_mux_send_credit(chan, credit);
+    }
+
+    return len;
+}
+
+static rt_size_t ipc_mux_chan_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    ipc_mux_chan_t *chan = (ipc_mux_chan_t *)dev->user_data;
+    ipc_mux_t *mux = chan->mux;
+    const uint8_t *data = (const uint8_t *)buffer;
+    rt_tick_t timeout = rt_tick_from_millisecond(IPC_MUX_WRITE_TIMEOUT);
+    rt_size_t written = 0;
+    ipc_mux_hdr_t hdr;
+    ipc_queue_iovec_t iov[2];
+    rt_base_t level;
+    uint32_t len;
+    uint32_t wait_ms;
+    rt_tick_t start;
+
+    while (written < size)
+    {
+        start = rt_tick_get();
+        len = size - written;
+        if (len > IPC_MUX_FRAME_MAX)
+        {
+            len = IPC_MUX_FRAME_MAX;
+        }
+
+        /* Take credit, never send more than peer rx buffer could hold */
+        while (1)
+        {
+            level = rt_hw_interrupt_disable();
+            if (chan->tx_credit > 0)
+            {
+                if (len > chan->tx_credit)
+                {
+                    len = chan->tx_credit;
+                }
+                chan->tx_credit -= len;
+                rt_hw_interrupt_enable(level);
+                break;
+            }
+            rt_hw_interrupt_enable(level);
+            chan->stat.credit_waits++;
+            if (RT_EOK != rt_sem_take(&chan->credit_sem, timeout))
+            {
+                LOG_W("ch%d: no credit", chan->cfg->id);
+                return written;
+            }
+        }
+
+        hdr.ch = chan->cfg->id;
+        hdr.type = IPC_MUX_FRAME_DATA;
+        hdr.len = (uint16_t)len;
+        iov[0].base = &hdr;
+        iov[0].len = sizeof(hdr);
+        iov[1].base = data + written;
+        iov[1].len = len;
+
+        rt_mutex_take(mux->tx_lock, RT_WAITING_FOREVER);
+        if (!ipc_mux_wait_space(chan, sizeof(hdr) + len, start, timeout)
+                || ((sizeof(hdr) + len) != ipc_queue_writev(mux->queue, iov, 2, IPC_MUX_WRITE_TIMEOUT)))
+        {
+            rt_mutex_release(mux->tx_lock);
+            level = rt_hw_interrupt_disable();
+            chan->tx_credit += len;
+            rt_hw_interrupt_enable(level);
+            LOG_W("ch%d: tx timeout", chan->cfg->id);
+            break;
+        }
+        rt_mutex_release(mux->tx_lock);
+
+        written += len;
+        chan->stat.tx_bytes += len;
+        chan->stat.tx_frames++;
+        wait_ms = (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND;
+        if (wait_ms > chan->stat.max_wait_ms)
+        {
+            chan->stat.max_wait_ms = wait_ms;
+        }
+    }
+
+    return written;
+}
+
+static rt_err_t ipc_mux_chan_control(rt_device_t dev, int cmd, void *args)
+{
+    ipc_mux_chan_t *chan = (ipc_mux_chan_t *)dev->user_data;
+
+    if (IPC_MUX_CTRL_GET_STAT == cmd)
+    {
+        if (!args)
+        {
+            return -RT_EINVAL;
+        }
+        memcpy(args, &chan->stat, sizeof(chan->stat));
+        memset(&chan->stat, 0, sizeof(chan->stat));
+        return RT_EOK;
+    }
+
+    return -RT_ENOSYS;
+}
+
+static void ipc_mux_rx_frame_done(ipc_mux_t *mux)
+{
+    ipc_mux_chan_t *chan = mux->rx_chan;
+
+    if (chan)
+    {
+        chan->stat.rx_frames++;
+        if (chan->dev.rx_indicate)
+        {
+            chan->dev.rx_indicate(&chan->dev, rt_ringbuffer_data_len(&chan->rb));
+        }
+    }
+    mux->rx_chan = NULL;
+}
+
+static void ipc_mux_rx_header(ipc_mux_t *mux)
+{
+    ipc_mux_chan_t *chan = ipc_mux_find_chan(mux, mux->hdr.ch);
+    rt_base_t level;
+
+    mux->hdr_len = 0;
+    if (IPC_MUX_FRAME_CREDIT == mux->hdr.type)
+    {
+        if (chan)
+        {
+            level = rt_hw_interrupt_disable();
+            chan->tx_credit += mux->hdr.len;
+            rt_hw_interrupt_enable(level);
+            rt_sem_release(&chan->credit_sem);
+        }
+        return;
+    }
+
+    if (!chan)
+    {
+        mux->unknown_drop += mux->hdr.len;
+    }
+    mux->rx_chan = chan;
+    mux->rx_remain = mux->hdr.len;
+    if (0 == mux->rx_remain)
+    {
+        ipc_mux_rx_frame_done(mux);
+    }
+}
+
+static void ipc_mux_rx_entry(void *param)
+{
+    ipc_mux_t *mux = (ipc_mux_t *)param;
+    const uint8_t *p;
+    size_t avail;
+    size_t len;
+    size_t put;
+
+    while (1)
+    {
+        rt_sem_take(&mux->rx_sem, RT_WAITING_FOREVER);
+
+        /* Consume in place, payload is copied once from shared buffer to channel buffer */
+        while ((avail = ipc_queue_read_peek(mux->queue, (const void **)&p)) > 0)
+        {
+            if (0 == mux->rx_remain)
+            {
+                len = sizeof(mux->hdr) - mux->hdr_len;
+                if (len > avail)
+                {
+                    len = avail;
+                }
+                memcpy((uint8_t *)&mux->hdr + mux->hdr_len, p, len);
+                mux->hdr_len += len;
+                ipc_queue_read_release(mux->queue, len);
+                if (sizeof(mux->hdr) == mux->hdr_len)
+                {
+                    ipc_mux_rx_header(mux);
+                }
+                continue;
+            }
+
+            len = (avail > mux->rx_remain) ? mux->rx_remain : avail;
+            if (mux->rx_chan)
+            {
+                rt_enter_critical();
+                put = rt_ringbuffer_put(&mux->rx_chan->rb, p, len);
+                rt_exit_critical();
+                mux->rx_chan->stat.rx_bytes += put;
+                mux->rx_chan->stat.rx_overflow += len - put;
+            }
+            ipc_queue_read_release(mux->queue, len);
+            mux->rx_remain -= len;
+            if (0 == mux->rx_remain)
+            {
+                ipc_mux_rx_frame_done(mux);
+            }
+        }
+    }
+}
+
+int32_t ipc_queue_mux_rx_ind(ipc_queue_handle_t queue, size_t size)
+{
+    ipc_mux_t *mux;
+    int32_t ret;
+
+    ret = ipc_queue_get_user_data(queue, (uint32_t *)&mux);
+    RT_ASSERT(0 == ret);
+    if (mux)
+    {
+        rt_sem_release(&mux->rx_sem);
+    }
+
+    return 0;
+}
+
+rt_err_t ipc_queue_mux_init(ipc_queue_handle_t queue, const ipc_mux_chan_cfg_t *cfg, uint8_t chan_num)
+{
+    ipc_mux_t *mux;
+    ipc_mux_chan_t *chan;
+    uint8_t *pool;
+    rt_err_t err;
+
+    if ((IPC_QUEUE_INVALID_HANDLE == queue) || !cfg || (0 == chan_num))
+    {
+        return -RT_ERROR;
+    }
+
+    mux = rt_calloc(1, sizeof(ipc_mux_t) + chan_num * sizeof(ipc_mux_chan_t));
+    if (!mux)
+    {
+        return -RT_ENOMEM;
+    }
+    mux->queue = queue;
+    mux->chan = (ipc_mux_chan_t *)(mux + 1);
+    mux->chan_num = chan_num;
+    /* writer of higher priority thread gets the queue first */
+    mux->tx_lock = rt_mutex_create("ipcmux", RT_IPC_FLAG_PRIO);
+    RT_ASSERT(mux->tx_lock);
+    rt_sem_init(&mux->rx_sem, "ipcmux", 0, RT_IPC_FLAG_FIFO);
+
+    for (uint32_t i = 0; i < chan_num; i++)
+    {
+        chan = &mux->chan[i];
+        RT_ASSERT((cfg[i].rx_buf_size > 0) && (0 == (cfg[i].rx_buf_size & 3)));
+        RT_ASSERT(cfg[i].prio <= IPC_MUX_PRIO_BULK);
+        pool = rt_malloc(cfg[i].rx_buf_size);
+        RT_ASSERT(pool);
+        rt_ringbuffer_init(&chan->rb, pool, cfg[i].rx_buf_size);
+        rt_sem_init(&chan->credit_sem, cfg[i].name, 0, RT_IPC_FLAG_FIFO);
+        chan->cfg = &cfg[i];
+        chan->mux = mux;
+        /* channel table is the same on both sides, peer rx buffer has the same size */
+        chan->tx_credit = cfg[i].rx_buf_size;
+
+        chan->dev.type        = RT_Device_Class_Mailbox;
+        chan->dev.init        = RT_NULL;
+        chan->dev.open        = ipc_mux_chan_open;
+        chan->dev.close       = ipc_mux_chan_close;
+        chan->dev.read        = ipc_mux_chan_read;
+        chan->dev.write       = ipc_mux_chan_write;
+        chan->dev.control     = ipc_mux_chan_control;
+        chan->dev.user_data   = (void *)chan;
+        err = rt_device_register(&chan->dev, cfg[i].name, RT_DEVICE_FLAG_RDWR);
+        RT_ASSERT(RT_EOK == err);
+    }
+
+    ipc_queue_set_user_data(queue, (uint32_t)mux);
+
+    mux->thread = rt_thread_create("ipcmux", ipc_mux_rx_entry, mux, IPC_MUX_THREAD_STACK_SIZE,
+                                   RT_THREAD_PRIORITY_HIGH, RT_THREAD_TICK_DEFAULT);
+    RT_ASSERT(mux->thread);
+    rt_thread_startup(mux->thread);
+
+    mux->next = ipc_mux_list;
+    ipc_mux_list = mux;
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_FINSH
+static int ipc_mux(int argc, char **argv)
+{
+    ipc_mux_chan_t *chan;
+
+    for (ipc_mux_t *mux = ipc_mux_list; mux; mux = mux->next)
+    {
+        rt_kprintf("queue %d, tx space %d, unknown ch drop %d\n", mux->queue,
+                   ipc_queue_get_tx_space(mux->queue), mux->unknown_drop);
+        for (uint32_t i = 0; i < mux->chan_num; i++)
+        {
+            chan = &mux->chan[i];
+            rt_kprintf("  %-8s id %d prio %d credit %d rx %d/%d\n", chan->cfg->name, chan->cfg->id,
+                       chan->cfg->prio, chan->tx_credit, rt_ringbuffer_data_len(&chan->rb), chan->cfg->rx_buf_size);
+            rt_kprintf("    tx %d/%d rx %d/%d credit_wait %d space_wait %d max_wait %dms overflow %d\n",
+                       chan->stat.tx_bytes, chan->stat.tx_frames, chan->stat.rx_bytes, chan->stat.rx_frames,
+                       chan->stat.credit_waits, chan->stat.space_waits, chan->stat.max_wait_ms, chan->stat.rx_overflow);
+        }
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(ipc_mux, show ipc queue mux channels);
+#endif
@@ -1,4 +1,6 @@
 #include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
 #include "littlevgl2rtt.h"
 #ifdef LV_USE_LVSF
     #include "lv_ext_resource_manager.h"
@@ -328,9 +330,270 @@ static void enable_fps_label(int en)
 }
 #ifndef DISABLE_LVGL_V8
 
+/*
+    Frame pacing
+
+    LCDC transfer is gated by TE, so completion of the last flush of a frame
+    is phase locked to panel vsync. Refresh timer is re-phased after each frame
+    to start rendering 'predicted render time' before the vsync the next frame
+    should be shown at, instead of running at free period.
+*/
+#ifndef LV_FRAME_PACING_VSYNC_MS
+    #define LV_FRAME_PACING_VSYNC_MS    16      /*TE period of panel*/
+#endif
+#ifndef LV_FRAME_PACING_MARGIN_MS
+    #define LV_FRAME_PACING_MARGIN_MS   2
+#endif
+#ifndef LV_FRAME_PACING_IDLE_MS
+    #define LV_FRAME_PACING_IDLE_MS     3000    /*No input for this long is idle*/
+#endif
+#ifndef LV_FRAME_PACING_IDLE_DIV
+    #define LV_FRAME_PACING_IDLE_DIV    2       /*Frame rate divider if idle*/
+#endif
+#define FRAME_PACING_HIST_NUM   8
+
+typedef struct
+{
+    uint8_t on;
+    uint8_t vsync_ms;
+    uint8_t idle_div;
+    uint8_t div;                /*vsync periods per frame*/
+    volatile uint32_t flush_cnt;
+    volatile uint32_t last_vsync; /*Tick of last frame flushed*/
+    uint32_t render_cnt;
+    int32_t render_avg;         /*EMA of render time, in 1/16 ms*/
+    uint32_t missed;            /*Frames shown later than expected*/
+    uint32_t hist_interval[FRAME_PACING_HIST_NUM]; /*Frame interval in vsync periods, 1..8*/
+    uint32_t hist_render[FRAME_PACING_HIST_NUM];   /*Render time in 4ms steps, 28+ in the last*/
+} frame_pacing_t;
+
+static frame_pacing_t pacing =
+{
+    .on = 1,
+    .vsync_ms = LV_FRAME_PACING_VSYNC_MS,
+    .idle_div = LV_FRAME_PACING_IDLE_DIV,
+    .div = 1,
+};
+
+/*
+    Touch to photon latency test
+
+    lv_touch marks sample time of each new pressed point passed to LVGL, first frame
+    flushed after that is taken as the frame showing it.
+*/
+#define TOUCH_LATENCY_HIST_NUM  8
+
+typedef struct
+{
+    uint8_t on;
+    volatile uint8_t pending;
+    volatile uint32_t sample_ts;
+    uint32_t count;
+    uint32_t read_sum_us;       /*Sample to LVGL read*/
+    uint32_t read_max_us;
+    uint32_t photon_sum_us;     /*Sample to flush done*/
+    uint32_t photon_max_us;
+    uint32_t hist[TOUCH_LATENCY_HIST_NUM];  /*Photon latency in 8ms steps, 56+ in the last*/
+} touch_latency_t;
+
+static touch_latency_t touch_lat;
+
+#if !defined(_MSC_VER)
+static uint32_t touch_latency_us(uint32_t ts)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - ts) * 1000000 / HAL_LPTIM_GetFreq());
+}
+#endif
+
+void lv_touch_latency_mark(uint32_t sample_ts)
+{
+#if !defined(_MSC_VER)
+    uint32_t us;
+
+    if (!touch_lat.on || touch_lat.pending)
+        return;
+    us = touch_latency_us(sample_ts);
+    touch_lat.read_sum_us += us;
+    touch_lat.read_max_us = LV_MAX(touch_lat.read_max_us, us);
+    touch_lat.sample_ts = sample_ts;
+    touch_lat.pending = 1;
+#endif
+}
+
+static void touch_latency_flush_done(void)
+{
+#if !defined(_MSC_VER)
+    uint32_t us;
+
+    if (!touch_lat.pending)
+        return;
+    us = touch_latency_us(touch_lat.sample_ts);
+    touch_lat.photon_sum_us += us;
+    touch_lat.photon_max_us = LV_MAX(touch_lat.photon_max_us, us);
+    touch_lat.hist[LV_MIN(us / 8000, TOUCH_LATENCY_HIST_NUM - 1)]++;
+    touch_lat.count++;
+    touch_lat.pending = 0;
+#endif
+}
+
+/*Called by LCD driver if the last area of a frame is flushed, may be in ISR*/
+void lv_frame_pacing_flush_done(void)
+{
+    uint32_t now = lv_tick_get();
+    uint32_t interval = now - pacing.last_vsync;
+    uint32_t n;
+
+    if (pacing.flush_cnt > 0)
+    {
+        n = (interval + pacing.vsync_ms / 2) / pacing.vsync_ms;
+        /*Longer gaps are idle, not frame drops*/
+        if (n <= FRAME_PACING_HIST_NUM)
+        {
+            pacing.hist_interval[(n > 0) ? (n - 1) : 0]++;
+            if (n > pacing.div)
+                pacing.missed++;
+        }
+    }
+
+    pacing.last_vsync = now;
+    pacing.flush_cnt++;
+    touch_latency_flush_done();
+}
+
+static void frame_pacing_schedule(uint32_t render_ms)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    lv_timer_t *refr_timer;
+    uint32_t now, vsync, anchor, start, period, predict, flush_cnt;
+    uint32_t i;
+
+    if (!pacing.on || !disp || !disp->refr_timer)
+        return;
+
+    i = render_ms / 4;
+    pacing.hist_render[LV_MIN(i, FRAME_PACING_HIST_NUM - 1)]++;
+    pacing.render_avg += (((int32_t)render_ms << 4) - pacing.render_avg) / 4;
+    pacing.render_cnt++;
+
+    flush_cnt = pacing.flush_cnt;
+    if (0 == flush_cnt)
+        return; /*LCD driver doesn't report flush done*/
+
+    /*Resync if a frame was dropped without flushing*/
+    if ((pacing.render_cnt != flush_cnt) && (pacing.render_cnt != flush_cnt + 1))
+        pacing.render_cnt = flush_cnt;
+
+    vsync = pacing.vsync_ms;
+    /*Keep cadence of LV_DISP_DEF_REFR_PERIOD, lower if idle*/
+    pacing.div = LV_MAX(1, (LV_DISP_DEF_REFR_PERIOD + vsync / 2) / vsync);
+    if (lv_disp_get_inactive_time(disp) > LV_FRAME_PACING_IDLE_MS)
+        pacing.div *= pacing.idle_div;
+    period = pacing.div * vsync;
+
+    now = lv_tick_get();
+    anchor = pacing.last_vsync;
+    if (pacing.render_cnt != flush_cnt)
+    {
+        /*Frame just rendered is still flushing, it will be shown at next vsync*/
+        anchor += ((now - anchor) / vsync + 1) * vsync;
+    }
+
+    predict = ((pacing.render_avg + 15) >> 4) + LV_FRAME_PACING_MARGIN_MS;
+    start = anchor + period - predict;
+    if ((int32_t)(start - now) < 0)
+        start += ((now - start) / vsync + 1) * vsync;
+    if (start - now > period)
+        start = now + period;
+
+    refr_timer = disp->refr_timer;
+    refr_timer->period = period;
+    refr_timer->last_run = start - period;
+}
+
+void lv_frame_pacing_enable(bool en)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+
+    pacing.on = en ? 1 : 0;
+    if (!en && disp && disp->refr_timer)
+        lv_timer_set_period(disp->refr_timer, LV_DISP_DEF_REFR_PERIOD);
+}
+
+#ifdef RT_USING_FINSH
+static rt_err_t frame_pacing(int argc, char **argv)
+{
+    uint32_t i;
+
+    if (argc > 1 && 0 == strcmp(argv[1], "on"))
+    {
+        lv_frame_pacing_enable(true);
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "off"))
+    {
+        lv_frame_pacing_enable(false);
+    }
+    else if (argc > 2 && 0 == strcmp(argv[1], "vsync"))
+    {
+        pacing.vsync_ms = LV_MAX(1, atoi(argv[2]));
+    }
+    else if (argc > 2 && 0 == strcmp(argv[1], "idle"))
+    {
+        pacing.idle_div = LV_MAX(1, atoi(argv[2]));
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "reset"))
+    {
+        pacing.missed = 0;
+        memset(pacing.hist_interval, 0, sizeof(pacing.hist_interval));
+        memset(pacing.hist_render, 0, sizeof(pacing.hist_render));
+    }
+
+    rt_kprintf("on=%d vsync=%dms div=%d idle_div=%d render_avg=%dms missed=%d\n", pacing.on, pacing.vsync_ms,
+               pacing.div, pacing.idle_div, (pacing.render_avg + 15) >> 4, pacing.missed);
+    rt_kprintf("interval(vsync):");
+    for (i = 0; i < FRAME_PACING_HIST_NUM; i++)
+        rt_kprintf(" %d:%d", i + 1, pacing.hist_interval[i]);
+    rt_kprintf("\nrender(ms):");
+    for (i = 0; i < FRAME_PACING_HIST_NUM; i++)
+        rt_kprintf(" %d:%d", i * 4, pacing.hist_render[i]);
+    rt_kprintf("\n");
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(frame_pacing, frame_pacing [on|off|reset|vsync <ms>|idle <div>]);
+
+static rt_err_t touch_latency(int argc, char **argv)
+{
+    uint32_t i, n;
+
+    if (argc > 1 && 0 == strcmp(argv[1], "on"))
+    {
+        memset(&touch_lat, 0, sizeof(touch_lat));
+        touch_lat.on = 1;
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "off"))
+    {
+        touch_lat.on = 0;
+        touch_lat.pending = 0;
+    }
+
+    n = LV_MAX(1, touch_lat.count);
+    rt_kprintf("on=%d samples=%d read avg=%dus max=%dus photon avg=%dus max=%dus\n", touch_lat.on, touch_lat.count,
+               touch_lat.read_sum_us / n, touch_lat.read_max_us, touch_lat.photon_sum_us / n, touch_lat.photon_max_us);
+    rt_kprintf("photon(ms):");
+    for (i = 0; i < TOUCH_LATENCY_HIST_NUM; i++)
+        rt_kprintf(" %d:%d", i * 8, touch_lat.hist[i]);
+    rt_kprintf("\n");
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(touch_latency, touch_latency [on|off], drag on screen while on);
+#endif /* RT_USING_FINSH */
 
 void perf_monitor(struct _lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
 {
+    if (px > 0)
+        frame_pacing_schedule(time);
+
     if (fps_on)
     {
         frame_cnt++;
@@ -456,6 +719,26 @@ rt_thread_t lvgl_host_thread(void)
     return host_thread;
 }
 
+static struct rt_semaphore host_wake_sem;
+static uint8_t host_wake_inited;
+
+void littlevgl2rtt_sleep(uint32_t ms)
+{
+    if (!host_wake_inited)
+    {
+        rt_thread_mdelay(ms);
+        return;
+    }
+    rt_sem_take(&host_wake_sem, (ms == LV_NO_TIMER_READY) ? RT_WAITING_FOREVER : rt_tick_from_millisecond(ms));
+}
+
+void littlevgl2rtt_wakeup(void)
+{
+    /*Keep at most one pending wakeup*/
+    if (host_wake_inited && host_wake_sem.value == 0)
+        rt_sem_release(&host_wake_sem);
+}
+
 extern void lv_hal_init(const char *name);
 rt_err_t littlevgl2rtt_init(const char *name)
 {
@@ -484,6 +767,11 @@ rt_err_t littlevgl2rtt_init(const char *name)
 
 
     host_thread = rt_thread_self();
+    if (!host_wake_inited)
+    {
+        rt_sem_init(&host_wake_sem, "lv_wake", 0, RT_IPC_FLAG_FIFO);
+        host_wake_inited = 1;
+    }
     LOG_I("[littlevgl2rtt] Welcome to the littlevgl2rtt lib.");
 
     return RT_EOK;
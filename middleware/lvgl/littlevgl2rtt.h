@@ -18,5 +18,27 @@ float lv_get_fps(void);
 void set_display_fps_and_cpu_load(int en);
 int get_display_fps_and_cpu_load(void);
 
+/**
+ * @brief Align LVGL refresh to panel vsync, enabled by default
+ */
+void lv_frame_pacing_enable(bool en);
+/**
+ * @brief Report last area of a frame flushed to LCD, called by LCD driver
+ */
+void lv_frame_pacing_flush_done(void);
+/**
+ * @brief Sleep of LVGL host thread between lv_task_handler() calls, ends early by littlevgl2rtt_wakeup()
+ * @param ms - return value of lv_task_handler()
+ */
+void littlevgl2rtt_sleep(uint32_t ms);
+/**
+ * @brief Wake up LVGL host thread, e.g. input driver has new data
+ */
+void littlevgl2rtt_wakeup(void);
+/**
+ * @brief Report sample time(HAL_GTIMER_READ) of a new pressed point read by LVGL, for touch latency test
+ */
+void lv_touch_latency_mark(uint32_t sample_ts);
+
 
 #endif
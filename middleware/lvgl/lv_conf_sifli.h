@@ -76,9 +76,19 @@
     #ifdef RT_USING_HEAP
         #define LV_MEM_CUSTOM 1
         #define LV_MEM_CUSTOM_INCLUDE LV_RTTHREAD_INCLUDE
-        #define LV_MEM_CUSTOM_ALLOC   rt_malloc
-        #define LV_MEM_CUSTOM_FREE    rt_free
-        #define LV_MEM_CUSTOM_REALLOC rt_realloc
+        #if defined(GUI_APP_FRAMEWORK) && defined(GUI_APP_SCREEN_ARENA)
+            /*Per app arena, see gui_app_arena.c*/
+            void *gui_app_arena_malloc(rt_size_t size);
+            void gui_app_arena_free(void *ptr);
+            void *gui_app_arena_realloc(void *ptr, rt_size_t size);
+            #define LV_MEM_CUSTOM_ALLOC   gui_app_arena_malloc
+            #define LV_MEM_CUSTOM_FREE    gui_app_arena_free
+            #define LV_MEM_CUSTOM_REALLOC gui_app_arena_realloc
+        #else
+            #define LV_MEM_CUSTOM_ALLOC   rt_malloc
+            #define LV_MEM_CUSTOM_FREE    rt_free
+            #define LV_MEM_CUSTOM_REALLOC rt_realloc
+        #endif
     #endif
 
 
@@ -63,6 +63,10 @@
 #if LV_USE_GPU
 #include "drv_epic.h"
 
+#if !defined(LV_USE_L8_GPU) && defined(EPIC_SUPPORT_L8)
+    #define LV_USE_L8_GPU 1
+#endif
+
 
 #define GPU_BLEND_EXP_MS     500
 
@@ -108,9 +112,9 @@ bool EPIC_SUPPORTED_CF(lv_img_cf_t cf)
 #ifdef EPIC_SUPPORT_A8
     case LV_IMG_CF_ALPHA_8BIT:
 #endif /* EPIC_SUPPORT_A8 */
-#ifdef EPIC_SUPPORT_L8
+#if LV_USE_L8_GPU
     case LV_IMG_CF_INDEXED_8BIT:
-#endif /* EPIC_SUPPORT_L8 */
+#endif /* LV_USE_L8_GPU */
 #ifdef EPIC_SUPPORT_YUV
     case LV_IMG_CF_YUV422_PACKED_YUYV:
     case LV_IMG_CF_YUV422_PACKED_UYVY:
@@ -149,8 +153,9 @@ static uint32_t lv_img_2_epic_cf2(uint32_t cf)
         color_mode = EPIC_INPUT_EZIP;
     }
 #if LV_USE_L8_GPU
-    else if (LV_IMG_CF_INDEXED_8BIT == cf)
+    else if ((LV_IMG_CF_INDEXED_1BIT <= cf) && (LV_IMG_CF_INDEXED_8BIT >= cf))
     {
+        /*1/2/4bit are expanded to 8bit indices by idx cache*/
         color_mode = EPIC_INPUT_L8;
     }
 #endif /* LV_USE_L8_GPU==1 */
@@ -261,6 +266,27 @@ static uint32_t lv_img_2_epic_cf(const lv_img_dsc_t *src)
 
 
 
+#if LV_USE_L8_GPU
+#ifndef IS_SPI_FLASH_ADDR
+    #define IS_SPI_FLASH_ADDR(addr)  0
+#endif
+
+/*
+    Palette is followed by pixel indices. For 1/2/4bit images src must be an
+    idx cache entry, whose indices are one byte per pixel.
+*/
+static void lv_img_set_epic_lut(EPIC_LayerConfigTypeDef *layer, const lv_img_dsc_t *src)
+{
+    uint32_t lut_cnt = 1 << lv_img_cf_get_px_size(src->header.cf);
+
+    layer->lookup_table = (uint8_t *)src->data;
+    layer->lookup_table_size = lut_cnt;
+    /*Palettes in flash and in idx cache never change, skip reloading them to EPIC*/
+    layer->lookup_table_cached = (LV_IMG_CF_INDEXED_8BIT != src->header.cf) || IS_SPI_FLASH_ADDR(src->data);
+    layer->data = (uint8_t *)src->data + lut_cnt * sizeof(lv_color32_t);
+}
+#endif /* LV_USE_L8_GPU */
+
 static void lv_area_to_EPIC_area(const lv_area_t *lv_a, EPIC_AreaTypeDef *epic_a)
 {
     epic_a->x0 = (int16_t)lv_a->x1;
@@ -279,7 +305,12 @@ void check_gpu_done2(void)
 {
     rt_err_t err;
 
+    /*Close letter batch, it holds EPIC until stopped*/
+    drv_epic_cont_blend_reset();
+
+    LV_DEBUG_MARK_START(LV_DEBUG_MARK_GPU_WAIT, "gpu wait");
     err = drv_gpu_check_done(GPU_BLEND_EXP_MS);
+    LV_DEBUG_MARK_STOP(LV_DEBUG_MARK_GPU_WAIT);
     if (RT_EOK != err)
     {
         lv_async_call(invalidate_screen, NULL);
@@ -399,10 +430,9 @@ void img_rotate_opa_frac2(lv_img_dsc_t *dest, lv_img_dsc_t *src, int16_t angle,
 
     }
 #if LV_USE_L8_GPU
-    else if (LV_IMG_CF_INDEXED_8BIT == src->header.cf)
+    else if ((LV_IMG_CF_INDEXED_1BIT <= src->header.cf) && (LV_IMG_CF_INDEXED_8BIT >= src->header.cf))
     {
-        input_layers[1].lookup_table = (uint8_t *)src->data;
-        input_layers[1].data = (uint8_t *)src->data + (1 << lv_img_cf_get_px_size(LV_IMG_CF_INDEXED_8BIT)) * sizeof(lv_color32_t);
+        lv_img_set_epic_lut(&input_layers[1], src);
     }
 #endif /* LV_USE_L8_GPU==1 */
 #ifdef EPIC_SUPPORT_YUV
@@ -565,10 +595,9 @@ void img_transform(lv_img_dsc_t *dest, const lv_img_dsc_t *src,
 
     }
 #if LV_USE_L8_GPU
-    else if (LV_IMG_CF_INDEXED_8BIT == src->header.cf)
+    else if ((LV_IMG_CF_INDEXED_1BIT <= src->header.cf) && (LV_IMG_CF_INDEXED_8BIT >= src->header.cf))
     {
-        input_layers[1].lookup_table = (uint8_t *)src->data;
-        input_layers[1].data = (uint8_t *)src->data + (1 << lv_img_cf_get_px_size(LV_IMG_CF_INDEXED_8BIT)) * sizeof(lv_color32_t);
+        lv_img_set_epic_lut(&input_layers[1], src);
     }
 #endif /* LV_USE_L8_GPU==1 */
 #ifdef EPIC_SUPPORT_YUV
@@ -672,10 +701,8 @@ static void fill_color_opa(lv_img_cf_t cf, lv_color_t *dest_buf, lv_coord_t dest
     c.full = lv_color_to32(color);
     c.ch.alpha = opa;
 
-    lv_area_t mask_area_r = *mask_coords;
-
-    lv_area_move(&mask_area_r, - fill_area->x1, - fill_area->y1);
-    lv_area_to_EPIC_area(&mask_area_r, &epic_mask_area);
+    /*Mask coordinates are relative to dest_buf too*/
+    lv_area_to_EPIC_area(mask_coords, &epic_mask_area);
     lv_area_to_EPIC_area(fill_area, &epic_fill_area);
     epic_dst_area.x0 = 0;
     epic_dst_area.y0 = 0;
@@ -725,6 +752,443 @@ void lv_gpu_img_copy(lv_img_dsc_t *dst, lv_img_dsc_t *src,
 }
 
 
+#if defined(HAL_EZIP_MODULE_ENABLED) && (LV_GPU_EZIP_ROI_CACHE_SIZE > 0)
+/*
+    EZIP ROI cache: EPIC only decodes the EZIP rows intersecting the output
+    area, but the decoded rows are thrown away after each blend. For opaque
+    EZIP images drawn without transform, keep full width decoded rows in a
+    ring (row r at slot r % cap), so scrolling only decodes newly exposed rows
+    and blends the rest from the ring.
+*/
+#ifndef LV_GPU_EZIP_ROI_CACHE_SIZE
+    #ifdef BSP_USING_PSRAM
+        #define LV_GPU_EZIP_ROI_CACHE_SIZE  (128 * 1024)
+    #else
+        #define LV_GPU_EZIP_ROI_CACHE_SIZE  0   /*Disabled*/
+    #endif
+#endif
+#ifndef LV_GPU_EZIP_ROI_CACHE_NUM
+    #define LV_GPU_EZIP_ROI_CACHE_NUM   4
+#endif
+
+#if __has_include("app_mem.h")
+    #include "app_mem.h"
+    #define EZIP_ROI_CACHE_ALLOC(size)  app_cache_alloc(size, IMAGE_CACHE_PSRAM)
+    #define EZIP_ROI_CACHE_FREE(p)      app_cache_free(p)
+#else
+    #define EZIP_ROI_CACHE_ALLOC(size)  rt_malloc(size)
+    #define EZIP_ROI_CACHE_FREE(p)      rt_free(p)
+#endif
+
+typedef struct
+{
+    const uint8_t *data;   /*Image key*/
+    uint32_t data_size;
+    uint32_t sig;
+    lv_coord_t w;
+    lv_coord_t h;
+    uint8_t *buf;
+    lv_coord_t cap;        /*Rows of buf*/
+    lv_coord_t row0;       /*Cached rows are [row0, row0 + row_num)*/
+    lv_coord_t row_num;
+    uint32_t last_use;
+} ezip_roi_entry_t;
+
+static ezip_roi_entry_t ezip_roi_cache[LV_GPU_EZIP_ROI_CACHE_NUM];
+static uint32_t ezip_roi_tick;
+static uint32_t ezip_roi_decoded_rows;
+static uint32_t ezip_roi_reused_rows;
+
+static uint32_t ezip_roi_sig(const uint8_t *data, uint32_t data_size)
+{
+    const uint32_t *p = (const uint32_t *)RT_ALIGN_DOWN((uint32_t)data, 4);
+
+    return (data_size >= 32) ? (p[1] ^ p[3] ^ p[7]) : 0;
+}
+
+static void ezip_roi_entry_free(ezip_roi_entry_t *e)
+{
+    if (e->buf)
+    {
+        /*EPIC may still read the ring*/
+        check_gpu_done2();
+        EZIP_ROI_CACHE_FREE(e->buf);
+    }
+    memset(e, 0, sizeof(*e));
+}
+
+static ezip_roi_entry_t *ezip_roi_get(const lv_img_dsc_t *src)
+{
+    ezip_roi_entry_t *e, *lru = &ezip_roi_cache[0];
+    uint32_t sig = ezip_roi_sig(src->data, src->data_size);
+    uint32_t row_bytes = src->header.w * sizeof(lv_color_t);
+    lv_coord_t cap;
+
+    for (e = &ezip_roi_cache[0]; e < &ezip_roi_cache[LV_GPU_EZIP_ROI_CACHE_NUM]; e++)
+    {
+        if ((e->data == src->data) && (e->data_size == src->data_size) && (e->sig == sig)
+                && (e->w == src->header.w) && (e->h == src->header.h))
+        {
+            e->last_use = ++ezip_roi_tick;
+            return e;
+        }
+        if (e->last_use < lru->last_use)
+            lru = e;
+    }
+
+    cap = LV_GPU_EZIP_ROI_CACHE_SIZE / LV_GPU_EZIP_ROI_CACHE_NUM / row_bytes;
+    if (cap > src->header.h)
+        cap = src->header.h;
+    if (cap <= 0)
+        return NULL;
+
+    e = lru;
+    ezip_roi_entry_free(e);
+    e->buf = EZIP_ROI_CACHE_ALLOC(cap * row_bytes);
+    if (NULL == e->buf)
+        return NULL;
+
+    e->data = src->data;
+    e->data_size = src->data_size;
+    e->sig = sig;
+    e->w = src->header.w;
+    e->h = src->header.h;
+    e->cap = cap;
+    e->last_use = ++ezip_roi_tick;
+
+    return e;
+}
+
+/*Decode rows [r0, r1] to ring, they must not wrap*/
+static void ezip_roi_decode_seg(ezip_roi_entry_t *e, lv_img_dsc_t *src, lv_coord_t r0, lv_coord_t r1)
+{
+    lv_img_dsc_t ring;
+    lv_coord_t slot = r0 % e->cap;
+    lv_area_t ring_area = {0, 0, e->w - 1, e->cap - 1};
+    lv_area_t src_coords = {0, slot - r0, e->w - 1, slot - r0 + e->h - 1};
+    lv_area_t out_area = {0, slot, e->w - 1, slot + r1 - r0};
+    lv_point_t pivot = {0, 0};
+
+    ring.header.cf = LV_IMG_CF_TRUE_COLOR;
+    ring.header.always_zero = 0;
+    ring.header.w = e->w;
+    ring.header.h = e->cap;
+    ring.data = e->buf;
+    ring.data_size = e->w * e->cap * sizeof(lv_color_t);
+
+    img_rotate_opa_frac2(&ring, src, 0, EPIC_INPUT_SCALE_NONE, EPIC_INPUT_SCALE_NONE,
+                         &src_coords, &ring_area, &out_area, &pivot, LV_OPA_COVER, LV_COLOR_CHROMA_KEY,
+                         0, 0, 0, 0, NULL, NULL);
+
+    ezip_roi_decoded_rows += r1 - r0 + 1;
+}
+
+static void ezip_roi_decode(ezip_roi_entry_t *e, lv_img_dsc_t *src, lv_coord_t r0, lv_coord_t r1)
+{
+    lv_coord_t wrap = (r0 / e->cap + 1) * e->cap; /*First row after r0 mapped to slot 0*/
+
+    if (r1 >= wrap)
+    {
+        ezip_roi_decode_seg(e, src, r0, wrap - 1);
+        r0 = wrap;
+    }
+    ezip_roi_decode_seg(e, src, r0, r1);
+}
+
+/*Make rows [r0, r1] cached, return false if they don't fit*/
+static bool ezip_roi_fill(ezip_roi_entry_t *e, lv_img_dsc_t *src, lv_coord_t r0, lv_coord_t r1)
+{
+    lv_coord_t end = e->row0 + e->row_num; /*Exclusive*/
+
+    if (r1 - r0 + 1 > e->cap)
+        return false;
+
+    if ((0 == e->row_num) || (r1 < e->row0 - 1) || (r0 > end) || ((r0 < e->row0) && (r1 >= end)))
+    {
+        /*Not adjacent or superset, restart with requested rows*/
+        ezip_roi_decode(e, src, r0, r1);
+        e->row0 = r0;
+        e->row_num = r1 - r0 + 1;
+        return true;
+    }
+
+    if (r1 >= end)
+    {
+        /*Scrolled down, new rows overwrite the top ones*/
+        ezip_roi_reused_rows += end - r0;
+        ezip_roi_decode(e, src, end, r1);
+        e->row_num = r1 - e->row0 + 1;
+        if (e->row_num > e->cap)
+        {
+            e->row0 = r1 - e->cap + 1;
+            e->row_num = e->cap;
+        }
+    }
+    else if (r0 < e->row0)
+    {
+        /*Scrolled up, new rows overwrite the bottom ones*/
+        ezip_roi_reused_rows += r1 - e->row0 + 1;
+        ezip_roi_decode(e, src, r0, e->row0 - 1);
+        e->row_num = end - r0;
+        e->row0 = r0;
+        if (e->row_num > e->cap)
+            e->row_num = e->cap;
+    }
+    else
+    {
+        ezip_roi_reused_rows += r1 - r0 + 1;
+    }
+
+    return true;
+}
+
+/*Blend image rows [r0, r1] from ring, they must not wrap*/
+static void ezip_roi_draw_seg(ezip_roi_entry_t *e, lv_img_dsc_t *dest,
+                              const lv_area_t *src_area, const lv_area_t *buf_area, const lv_area_t *clip_area,
+                              lv_opa_t opa, lv_coord_t r0, lv_coord_t r1,
+                              lv_img_cf_t mask_cf, const lv_opa_t *mask_map, const lv_area_t *mask_coords)
+{
+    lv_img_dsc_t strip;
+    lv_area_t strip_area, strip_clip;
+    lv_point_t pivot = {0, 0};
+
+    strip_area.x1 = src_area->x1;
+    strip_area.x2 = src_area->x1 + e->w - 1;
+    strip_area.y1 = src_area->y1 + r0;
+    strip_area.y2 = src_area->y1 + r1;
+    if (!_lv_area_intersect(&strip_clip, &strip_area, clip_area))
+        return;
+
+    strip.header.cf = LV_IMG_CF_TRUE_COLOR;
+    strip.header.always_zero = 0;
+    strip.header.w = e->w;
+    strip.header.h = r1 - r0 + 1;
+    strip.data = e->buf + (r0 % e->cap) * e->w * sizeof(lv_color_t);
+    strip.data_size = strip.header.w * strip.header.h * sizeof(lv_color_t);
+
+    img_rotate_opa_frac(dest, &strip, 0, LV_IMG_ZOOM_NONE,
+                        &strip_area, buf_area, &strip_clip, &pivot, opa, LV_COLOR_CHROMA_KEY,
+                        0, 0, mask_cf, mask_map, mask_coords);
+}
+
+static bool ezip_roi_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_dsc_t *draw_dsc,
+                          lv_img_dsc_t *dest, lv_img_dsc_t *src, const lv_area_t *src_area,
+                          lv_img_cf_t mask_cf, const lv_opa_t *mask_map, const lv_area_t *mask_coords)
+{
+    ezip_roi_entry_t *e;
+    lv_area_t clip;
+    lv_coord_t r0, r1, wrap;
+
+    if ((LV_IMG_CF_RAW != src->header.cf) || (0 != draw_dsc->angle) || (LV_IMG_ZOOM_NONE != draw_dsc->zoom)
+            || draw_dsc->coord_x_frac || draw_dsc->coord_y_frac
+            || (lv_area_get_width(src_area) != src->header.w) || (lv_area_get_height(src_area) != src->header.h))
+        return false;
+
+    if (!_lv_area_intersect(&clip, src_area, draw_ctx->clip_area))
+        return true;
+
+    r0 = clip.y1 - src_area->y1;
+    r1 = clip.y2 - src_area->y1;
+
+    e = ezip_roi_get(src);
+    if ((NULL == e) || !ezip_roi_fill(e, src, r0, r1))
+        return false;
+
+    wrap = (r0 / e->cap + 1) * e->cap;
+    if (r1 >= wrap)
+    {
+        ezip_roi_draw_seg(e, dest, src_area, draw_ctx->buf_area, &clip, draw_dsc->opa, r0, wrap - 1,
+                          mask_cf, mask_map, mask_coords);
+        r0 = wrap;
+    }
+    ezip_roi_draw_seg(e, dest, src_area, draw_ctx->buf_area, &clip, draw_dsc->opa, r0, r1,
+                      mask_cf, mask_map, mask_coords);
+
+    return true;
+}
+
+#ifdef FINSH_USING_MSH
+static void ezip_roi_cache_flush(void)
+{
+    ezip_roi_entry_t *e;
+
+    for (e = &ezip_roi_cache[0]; e < &ezip_roi_cache[LV_GPU_EZIP_ROI_CACHE_NUM]; e++)
+        ezip_roi_entry_free(e);
+}
+#endif /* FINSH_USING_MSH */
+#endif /* HAL_EZIP_MODULE_ENABLED && LV_GPU_EZIP_ROI_CACHE_SIZE > 0 */
+
+#if LV_USE_L8_GPU
+/*
+    Indexed image cache: EPIC only reads 8bit indices, so 1/2/4bit indexed
+    images are expanded once to palette + one byte per pixel and kept here.
+    Icon sets stay compact in flash and are blended by EPIC through its lookup
+    table instead of being converted to true color line by line.
+*/
+#ifndef LV_GPU_IDX_CACHE_SIZE
+    #define LV_GPU_IDX_CACHE_SIZE   (32 * 1024)
+#endif
+#ifndef LV_GPU_IDX_CACHE_NUM
+    #define LV_GPU_IDX_CACHE_NUM    8
+#endif
+#endif /* LV_USE_L8_GPU */
+
+#if LV_USE_L8_GPU && (LV_GPU_IDX_CACHE_SIZE > 0)
+    #define IS_IDX_EXPANDED_CF(cf)  (((cf) >= LV_IMG_CF_INDEXED_1BIT) && ((cf) <= LV_IMG_CF_INDEXED_4BIT))
+#else
+    #define IS_IDX_EXPANDED_CF(cf)  0
+#endif
+
+#if LV_USE_L8_GPU && (LV_GPU_IDX_CACHE_SIZE > 0)
+typedef struct
+{
+    const uint8_t *data;   /*Image key*/
+    uint32_t sig;
+    lv_img_header_t header;
+    uint8_t *buf;          /*Palette + indices*/
+    uint32_t size;
+    uint32_t last_use;
+} idx_cache_entry_t;
+
+static idx_cache_entry_t idx_cache[LV_GPU_IDX_CACHE_NUM];
+static uint32_t idx_cache_used;
+static uint32_t idx_cache_tick;
+static uint32_t idx_expanded;
+static uint32_t idx_reused;
+
+static uint32_t idx_cache_sig(const lv_img_dsc_t *src, uint32_t lut_size)
+{
+    const uint8_t *p = src->data + lut_size;
+    uint32_t last = src->data_size - lut_size - 1;
+
+    /*Whole palette is compared, sample a few indices*/
+    return (src->data_size > lut_size) ? ((p[0] << 24) | (p[last / 2] << 16) | (p[last / 3] << 8) | p[last]) : 0;
+}
+
+static void idx_cache_entry_free(idx_cache_entry_t *e)
+{
+    if (e->buf)
+    {
+        /*EPIC may still read it, and the address may hold another palette later*/
+        check_gpu_done2();
+        HAL_EPIC_InvalidateL8Table(drv_get_epic_handle());
+        rt_free(e->buf);
+        idx_cache_used -= e->size;
+    }
+    memset(e, 0, sizeof(*e));
+}
+
+static void idx_expand(uint8_t *dst, const uint8_t *src, uint32_t w, uint32_t h, uint8_t bpp)
+{
+    uint32_t stride = (w * bpp + 7) >> 3;
+    uint8_t mask = (1 << bpp) - 1;
+    uint32_t x, y, bit;
+
+    /*Rows are byte aligned, first pixel in MSB*/
+    for (y = 0; y < h; y++, src += stride)
+    {
+        for (x = 0, bit = 0; x < w; x++, bit += bpp)
+            *dst++ = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+    }
+}
+
+static idx_cache_entry_t *idx_cache_get(const lv_img_dsc_t *src)
+{
+    idx_cache_entry_t *e, *lru;
+    uint8_t bpp = lv_img_cf_get_px_size(src->header.cf);
+    uint32_t lut_size = (1 << bpp) * sizeof(lv_color32_t);
+    uint32_t size = lut_size + src->header.w * src->header.h;
+    uint32_t sig;
+
+    if ((size > LV_GPU_IDX_CACHE_SIZE) || (src->data_size < lut_size + ((src->header.w * bpp + 7) >> 3) * src->header.h))
+        return NULL;
+
+    sig = idx_cache_sig(src, lut_size);
+    for (e = &idx_cache[0]; e < &idx_cache[LV_GPU_IDX_CACHE_NUM]; e++)
+    {
+        if ((e->data == src->data) && (e->sig == sig) && (e->header.cf == src->header.cf)
+                && (e->header.w == src->header.w) && (e->header.h == src->header.h)
+                && (0 == memcmp(e->buf, src->data, lut_size)))
+        {
+            e->last_use = ++idx_cache_tick;
+            idx_reused++;
+            return e;
+        }
+    }
+
+    /*Evict least recently used ones until there is a free entry and it fits*/
+    while (1)
+    {
+        idx_cache_entry_t *slot = NULL;
+
+        lru = NULL;
+        for (e = &idx_cache[0]; e < &idx_cache[LV_GPU_IDX_CACHE_NUM]; e++)
+        {
+            if (!e->buf)
+                slot = slot ? slot : e;
+            else if (!lru || (e->last_use < lru->last_use))
+                lru = e;
+        }
+        if (slot && (idx_cache_used + size <= LV_GPU_IDX_CACHE_SIZE))
+        {
+            e = slot;
+            break;
+        }
+        idx_cache_entry_free(lru);
+    }
+
+    e->buf = rt_malloc(size);
+    if (NULL == e->buf)
+        return NULL;
+
+    memcpy(e->buf, src->data, lut_size);
+    idx_expand(e->buf + lut_size, src->data + lut_size, src->header.w, src->header.h, bpp);
+    e->data = src->data;
+    e->sig = sig;
+    e->header = src->header;
+    e->size = size;
+    e->last_use = ++idx_cache_tick;
+    idx_cache_used += size;
+    idx_expanded++;
+
+    return e;
+}
+
+/*Open 1/2/4bit indexed variable image from idx cache, it's drawn as 8bit indices*/
+static bool idx_img_open(const lv_draw_img_dsc_t *draw_dsc, const void *src, lv_img_decoder_dsc_t *dec_dsc)
+{
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+    idx_cache_entry_t *e;
+
+    if ((LV_IMG_SRC_VARIABLE != lv_img_src_get_type(src)) || (LV_OPA_TRANSP != draw_dsc->recolor_opa)
+            || !IS_IDX_EXPANDED_CF(img->header.cf) || (NULL == img->data))
+        return false;
+
+    e = idx_cache_get(img);
+    if (NULL == e)
+        return false;
+
+    memset(dec_dsc, 0, sizeof(*dec_dsc));
+    dec_dsc->src = src;
+    dec_dsc->src_type = LV_IMG_SRC_VARIABLE;
+    dec_dsc->header = img->header;
+    dec_dsc->img_data = e->buf;
+    dec_dsc->img_data_size = e->size;
+
+    return true;
+}
+
+#ifdef FINSH_USING_MSH
+static void idx_cache_flush(void)
+{
+    idx_cache_entry_t *e;
+
+    for (e = &idx_cache[0]; e < &idx_cache[LV_GPU_IDX_CACHE_NUM]; e++)
+        idx_cache_entry_free(e);
+}
+#endif /* FINSH_USING_MSH */
+#endif /* LV_USE_L8_GPU && LV_GPU_IDX_CACHE_SIZE > 0 */
+
 static void draw_img(struct _lv_draw_ctx_t *draw_ctx,
                      const lv_draw_img_dsc_t *draw_dsc,
                      const lv_area_t *src_area, //Src buf coordinates
@@ -766,7 +1230,7 @@ static void draw_img(struct _lv_draw_ctx_t *draw_ctx,
             //&& (0 == other_mask_cnt)
             //&& disp->driver.gpu_rotate_cb
             //&& disp->driver.gpu_rotate_frac_cb
-            && EPIC_SUPPORTED_CF(cf)
+            && (EPIC_SUPPORTED_CF(cf) || IS_IDX_EXPANDED_CF(cf))
        )
     {
         lv_img_dsc_t src;
@@ -886,6 +1350,10 @@ static void draw_img(struct _lv_draw_ctx_t *draw_ctx,
         else
 #endif /* SOC_BF_A0 */
         {
+#if defined(HAL_EZIP_MODULE_ENABLED) && (LV_GPU_EZIP_ROI_CACHE_SIZE > 0)
+            if (ezip_roi_draw(draw_ctx, draw_dsc, &dest, &src, src_area, mask_cf, mask_map, &mask_coords))
+                return;
+#endif
             img_rotate_opa_frac(&dest, &src, draw_dsc->angle, (uint32_t)draw_dsc->zoom,
                                 src_area, draw_ctx->buf_area,
                                 draw_ctx->clip_area, (lv_point_t *) & (draw_dsc->pivot), draw_dsc->opa, LV_COLOR_CHROMA_KEY,
@@ -1080,6 +1548,147 @@ void print_letter_map(uint32_t letter, const uint8_t *map_p, uint16_t box_w, uin
 }
 
 #endif /* COMPATIBLE_WITH_SIFLI_EPIC_Ax */
+
+/*
+    Glyph atlas: glyph dsc and a copy of its bitmap in SRAM, so repeated letters
+    skip font lookup (freetype bitmap is only valid until next lookup) and EPIC
+    reads the bitmap from SRAM. Entries are direct mapped, the pool is a bump
+    allocator dropped as a whole when full.
+*/
+#ifndef LV_GPU_GLYPH_ATLAS_NUM
+    #define LV_GPU_GLYPH_ATLAS_NUM      64  /*Must be power of 2*/
+#endif
+#ifndef LV_GPU_GLYPH_ATLAS_SIZE
+    #define LV_GPU_GLYPH_ATLAS_SIZE     (8 * 1024)
+#endif
+
+typedef struct
+{
+    const lv_font_t *font;
+    uint32_t letter;
+    lv_coord_t line_height;
+    lv_font_glyph_dsc_t g;
+    const uint8_t *map_p;
+} glyph_atlas_entry_t;
+
+static glyph_atlas_entry_t glyph_atlas[LV_GPU_GLYPH_ATLAS_NUM];
+static uint32_t glyph_atlas_pool[LV_GPU_GLYPH_ATLAS_SIZE / 4];
+static uint32_t glyph_atlas_used;
+
+static void glyph_atlas_reset(void)
+{
+    /*EPIC may still read bitmaps in pool*/
+    drv_epic_cont_blend_reset();
+    check_gpu_done2();
+
+    memset(glyph_atlas, 0, sizeof(glyph_atlas));
+    glyph_atlas_used = 0;
+}
+
+static glyph_atlas_entry_t *glyph_atlas_slot(const lv_font_t *font, uint32_t letter)
+{
+    uint32_t h = ((uint32_t)font >> 2) ^ (letter * 2654435761u);
+
+    return &glyph_atlas[(h >> 16) & (LV_GPU_GLYPH_ATLAS_NUM - 1)];
+}
+
+static bool glyph_atlas_lookup(const lv_font_t *font, uint32_t letter,
+                               lv_font_glyph_dsc_t **g, const uint8_t **map_p)
+{
+    glyph_atlas_entry_t *e = glyph_atlas_slot(font, letter);
+
+    if ((e->font != font) || (e->letter != letter) || (e->line_height != font->line_height))
+        return false;
+
+    *g = &e->g;
+    *map_p = e->map_p;
+    return true;
+}
+
+static const uint8_t *glyph_atlas_insert(const lv_font_t *font, uint32_t letter,
+        const lv_font_glyph_dsc_t *g, const uint8_t *map_p, uint32_t size)
+{
+    glyph_atlas_entry_t *e;
+    uint32_t aligned_size = RT_ALIGN(size, 4);
+
+    if (aligned_size > LV_GPU_GLYPH_ATLAS_SIZE / 8)
+        return map_p;   /*Too big, not worth caching*/
+
+    if (glyph_atlas_used + aligned_size > LV_GPU_GLYPH_ATLAS_SIZE)
+        glyph_atlas_reset();
+
+    e = glyph_atlas_slot(font, letter);
+    e->font = font;
+    e->letter = letter;
+    e->line_height = font->line_height;
+    memcpy(&e->g, g, sizeof(e->g));
+    e->map_p = (const uint8_t *)glyph_atlas_pool + glyph_atlas_used;
+    memcpy((void *)e->map_p, map_p, size);
+    glyph_atlas_used += aligned_size;
+
+    return e->map_p;
+}
+
+/*
+    Letters of a label share color and clip area, blend them in one continuous
+    EPIC batch. The batch is closed by the next EPIC operation or my_gpu_wait.
+*/
+static void draw_letter_batched(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc,
+                                const lv_area_t *letter_area, const uint8_t *map_p,
+                                uint32_t epic_cf, uint32_t data_size, uint32_t dest_cf)
+{
+    EPIC_LayerConfigTypeDef input_layers[2];
+    EPIC_LayerConfigTypeDef output_canvas;
+    lv_area_t out_area;
+    lv_color32_t ax_color_u32;
+    uint32_t color_bpp;
+    uint8_t pixel_size;
+    lv_coord_t buf_w;
+
+    if (!_lv_area_intersect(&out_area, letter_area, draw_ctx->clip_area))
+        return;
+
+    /*Setup fg layer*/
+    HAL_EPIC_LayerConfigInit(&input_layers[1]);
+    ax_color_u32.full = lv_color_to32(dsc->color);
+    input_layers[1].alpha = dsc->opa;
+    input_layers[1].x_offset = letter_area->x1;
+    input_layers[1].y_offset = letter_area->y1;
+    input_layers[1].data = (uint8_t *)map_p;
+    input_layers[1].data_size = data_size;
+    input_layers[1].color_mode = epic_cf;
+    input_layers[1].color_en = true;
+    input_layers[1].color_r = ax_color_u32.ch.red;
+    input_layers[1].color_g = ax_color_u32.ch.green;
+    input_layers[1].color_b = ax_color_u32.ch.blue;
+    input_layers[1].ax_mode = ALPHA_BLEND_RGBCOLOR;
+    input_layers[1].width = lv_area_get_width(letter_area);
+    input_layers[1].height = lv_area_get_height(letter_area);
+    color_bpp = HAL_EPIC_GetColorDepth(epic_cf);
+    input_layers[1].total_width = RT_ALIGN(input_layers[1].width, 8 / color_bpp);
+
+    /*Output layer is also the bg layer*/
+    HAL_EPIC_LayerConfigInit(&input_layers[0]);
+    HAL_EPIC_LayerConfigInit(&output_canvas);
+    output_canvas.color_mode = lv_img_2_epic_cf2(dest_cf);
+    pixel_size = HAL_EPIC_GetColorDepth(output_canvas.color_mode) >> 3;
+    buf_w = lv_area_get_width(draw_ctx->buf_area);
+    output_canvas.data = (uint8_t *)draw_ctx->buf
+                         + pixel_size * (buf_w * (out_area.y1 - draw_ctx->buf_area->y1) + (out_area.x1 - draw_ctx->buf_area->x1));
+    output_canvas.width = lv_area_get_width(&out_area);
+    output_canvas.total_width = buf_w;
+    output_canvas.height = lv_area_get_height(&out_area);
+    output_canvas.x_offset = out_area.x1;
+    output_canvas.y_offset = out_area.y1;
+    output_canvas.data_size = pixel_size * output_canvas.total_width * output_canvas.height;
+
+    if (RT_EOK != drv_epic_cont_blend(input_layers, 2, &output_canvas))
+    {
+        drv_epic_cont_blend_reset();
+        lv_async_call(invalidate_screen, NULL);
+    }
+}
+
 /**
 * Draw a letter in the Virtual Display Buffer
 * @param pos_p left-top coordinate of the latter
@@ -1092,8 +1701,19 @@ void print_letter_map(uint32_t letter, const uint8_t *map_p, uint16_t box_w, uin
 static void draw_letter(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc,  const lv_point_t *pos_p,
                         uint32_t letter)
 {
-    lv_font_glyph_dsc_t g;
-    bool g_ret = lv_font_get_glyph_dsc(dsc->font, &g, letter, '\0');
+    lv_font_glyph_dsc_t g_buf;
+    lv_font_glyph_dsc_t *p_g;
+    const uint8_t *map_p;
+    bool cached = glyph_atlas_lookup(dsc->font, letter, &p_g, &map_p);
+
+    if (!cached)
+    {
+        p_g = &g_buf;
+        map_p = NULL;
+    }
+
+    bool g_ret = cached || lv_font_get_glyph_dsc(dsc->font, p_g, letter, '\0');
+    lv_font_glyph_dsc_t g = *p_g;
     if (g_ret == false)
     {
         /*Add warning if the dsc is not found
@@ -1140,20 +1760,23 @@ static void draw_letter(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc,
         return;
     }
 
-    const uint8_t *map_p = lv_font_get_glyph_bitmap(g.resolved_font, letter);
-    if (map_p == NULL)
-    {
-        LV_LOG_WARN("lv_draw_letter: character's bitmap not found");
-        return;
-    }
-
-
-
-
-
     uint32_t bpp = g.bpp;
     if (bpp == 3) bpp = 4;
 
+    uint32_t data_size = (RT_ALIGN(g.box_w * bpp, 8) >> 3)  * g.box_h;
+
+    if (!cached)
+    {
+        map_p = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+        if (map_p == NULL)
+        {
+            LV_LOG_WARN("lv_draw_letter: character's bitmap not found");
+            return;
+        }
+        if ((bpp == 2) || (bpp == 4) || (bpp == 8))
+            map_p = glyph_atlas_insert(dsc->font, letter, &g, map_p, data_size);
+    }
+
 
 
 #if defined(SOC_SF32LB56X)||defined(SOC_SF32LB58X)
@@ -1246,6 +1869,13 @@ static void draw_letter(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc,
         dest.header.cf = (set_px_true_color_alpha == disp->driver->set_px_cb) ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
         dest.header.always_zero = 0;
 
+        if (NULL == mask_map)
+        {
+            draw_letter_batched(draw_ctx, dsc, &letter_area, map_p,
+                                lv_img_2_epic_cf2(src.header.cf), src.data_size, dest.header.cf);
+            return;
+        }
+
         img_rotate_opa_frac(&dest, &src, 0, (uint32_t)LV_IMG_ZOOM_NONE,
                             &letter_area, draw_ctx->buf_area,
                             draw_ctx->clip_area, &pivot, dsc->opa, dsc->color, 0, 0,
@@ -1263,6 +1893,8 @@ static void draw_letter(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc,
 //Not support by EPIC, call sw rendering
     epic_draw_ctx_t *my_draw_ctx = (epic_draw_ctx_t *)draw_ctx;
 
+    drv_epic_cont_blend_reset();
+
 
     my_draw_ctx->sw_ctx_backup.base_draw.draw_letter(draw_ctx, dsc,  pos_p, letter);
 }
@@ -1286,9 +1918,21 @@ static lv_res_t my_decode_and_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_ds
 {
     if (draw_dsc->opa <= LV_OPA_MIN) return LV_RES_OK;
 
-    _lv_img_cache_entry_t *cdsc = _lv_img_cache_open(src, draw_dsc->recolor, draw_dsc->frame_id);
+    _lv_img_cache_entry_t *cdsc = NULL;
+    lv_img_decoder_dsc_t *dec_dsc;
+#if LV_USE_L8_GPU && (LV_GPU_IDX_CACHE_SIZE > 0)
+    lv_img_decoder_dsc_t idx_dsc;
+
+    if (idx_img_open(draw_dsc, src, &idx_dsc))
+        dec_dsc = &idx_dsc;
+    else
+#endif
+    {
+        cdsc = _lv_img_cache_open(src, draw_dsc->recolor, draw_dsc->frame_id);
 
-    if (cdsc == NULL || (!EPIC_SUPPORTED_CF(cdsc->dec_dsc.header.cf))) return LV_RES_INV;
+        if (cdsc == NULL || (!EPIC_SUPPORTED_CF(cdsc->dec_dsc.header.cf))) return LV_RES_INV;
+        dec_dsc = &cdsc->dec_dsc;
+    }
 
     /*
         lv_img_cf_t cf;
@@ -1296,7 +1940,7 @@ static lv_res_t my_decode_and_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_ds
         else if(lv_img_cf_has_alpha(cdsc->dec_dsc.header.cf)) cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
         else cf = LV_IMG_CF_TRUE_COLOR;
     */
-    if (cdsc->dec_dsc.error_msg != NULL)
+    if (dec_dsc->error_msg != NULL)
     {
         LV_LOG_WARN("Image draw error");
 
@@ -1304,7 +1948,7 @@ static lv_res_t my_decode_and_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_ds
     }
     /*The decoder could open the image and gave the entire uncompressed image.
      *Just draw it!*/
-    else if (cdsc->dec_dsc.img_data)
+    else if (dec_dsc->img_data)
     {
         lv_area_t map_area_rot;
         lv_area_copy(&map_area_rot, coords);
@@ -1327,19 +1971,74 @@ static lv_res_t my_decode_and_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_ds
         /*Out of mask. There is nothing to draw so the image is drawn successfully.*/
         if (union_ok == false)
         {
-            my_draw_cleanup(cdsc);
+            if (cdsc) my_draw_cleanup(cdsc);
             return LV_RES_OK;
         }
 
-        draw_img(draw_ctx, draw_dsc, coords, &cdsc->dec_dsc);
+        draw_img(draw_ctx, draw_dsc, coords, dec_dsc);
     }
 
 
-    my_draw_cleanup(cdsc);
+    if (cdsc) my_draw_cleanup(cdsc);
     return LV_RES_OK;
 }
 
 
+/*
+    SW masks (rounded corners, arcs, anti-aliased borders and lines) are
+    generated by the CPU into dsc->mask_buf, blend them by EPIC with the mask
+    as A8 layer if the area is large enough to beat the setup cost.
+    dsc->mask_buf is reused by the caller as soon as blend returns, so the
+    covered part of it is copied to one of two stage buffers. drv_epic_fill
+    waits the previous job before starting, so the stage buffer used two
+    jobs ago is always free and mask generation overlaps with EPIC.
+    Masks bigger than a stage buffer are blended in place and waited.
+*/
+#ifndef LV_GPU_MASK_BLEND_MIN_SIZE
+    #define LV_GPU_MASK_BLEND_MIN_SIZE  256
+#endif
+#ifndef LV_GPU_MASK_STAGE_SIZE
+    #define LV_GPU_MASK_STAGE_SIZE      2048
+#endif
+
+#if LV_GPU_MASK_STAGE_SIZE > 0
+static ALIGN(4) lv_opa_t g_mask_stage[2][LV_GPU_MASK_STAGE_SIZE];
+static uint8_t g_mask_stage_idx;
+#endif
+
+/*Return mask covering blend_area, set mask_coords and whether EPIC must be waited after blend*/
+static const lv_opa_t *get_blend_mask(const lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *blend_area,
+                                      lv_area_t *mask_coords, bool *wait)
+{
+#if LV_GPU_MASK_STAGE_SIZE > 0
+    uint32_t w = lv_area_get_width(blend_area);
+    uint32_t h = lv_area_get_height(blend_area);
+
+    if (w * h <= LV_GPU_MASK_STAGE_SIZE)
+    {
+        lv_coord_t mask_stride = lv_area_get_width(dsc->mask_area);
+        const lv_opa_t *src = dsc->mask_buf + (blend_area->y1 - dsc->mask_area->y1) * mask_stride
+                              + (blend_area->x1 - dsc->mask_area->x1);
+        lv_opa_t *stage = g_mask_stage[g_mask_stage_idx];
+
+        g_mask_stage_idx ^= 1;
+        for (uint32_t y = 0; y < h; y++)
+        {
+            lv_memcpy(stage + y * w, src, w);
+            src += mask_stride;
+        }
+
+        *mask_coords = *blend_area;
+        *wait = false;
+        return stage;
+    }
+#endif /* LV_GPU_MASK_STAGE_SIZE > 0 */
+
+    *mask_coords = *dsc->mask_area;
+    *wait = true;
+    return dsc->mask_buf;
+}
+
 static void draw_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
 {
     /*Let's get the blend area which is the intersection of the area to fill and the clip area.*/
@@ -1351,8 +2050,32 @@ static void draw_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *ds
     lv_img_cf_t mask_cf;
     const lv_opa_t *mask_map;
     lv_area_t *mask_coords;
+    lv_area_t sw_mask_coords;
     bool only_1map_mask;
-    if (lv_draw_mask_is_only_map_mask(&blend_area, &mask_param))
+    bool mask_wait = false;
+
+    if (dsc->mask_buf && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) return;
+
+    if (dsc->mask_buf && dsc->mask_res != LV_DRAW_MASK_RES_FULL_COVER &&
+            dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+            lv_area_get_size(&blend_area) >= LV_GPU_MASK_BLEND_MIN_SIZE &&
+            _lv_area_is_in(&blend_area, dsc->mask_area, 0))
+    {
+        /*Use the SW generated mask as EPIC mask layer*/
+        mask_map = get_blend_mask(dsc, &blend_area, &sw_mask_coords, &mask_wait);
+        mask_coords = &sw_mask_coords;
+        mask_cf  = LV_IMG_CF_ALPHA_8BIT;
+        only_1map_mask = true;
+    }
+    else if (dsc->mask_buf && dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER)
+    {
+        /*Mask hides nothing, blend as not masked*/
+        mask_map = NULL;
+        mask_coords = &mask_param.cfg.coords;
+        only_1map_mask = true;
+        mask_cf  = LV_IMG_CF_ALPHA_8BIT;
+    }
+    else if (lv_draw_mask_is_only_map_mask(&blend_area, &mask_param))
     {
         LV_ASSERT(LV_DRAW_MASK_TYPE_MAP == mask_param.dsc.type);
 
@@ -1417,19 +2140,24 @@ static void draw_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *ds
         /*Got the first pixel on the buffer*/
         lv_coord_t dest_stride = lv_area_get_width(draw_ctx->buf_area); /*Width of the destination buffer*/
 
-        /*Make the blend area relative to the buffer*/
+        /*Make the blend area and mask relative to the buffer*/
+        lv_area_t mask_area_r = *mask_coords;
         lv_area_move(&blend_area, -draw_ctx->buf_area->x1, -draw_ctx->buf_area->y1);
+        lv_area_move(&mask_area_r, -draw_ctx->buf_area->x1, -draw_ctx->buf_area->y1);
 
         /*Call your custom gou fill function to fill blend_area, on dest_buf with dsc->color*/
         fill_color_opa(LV_IMG_CF_TRUE_COLOR, draw_ctx->buf, dest_stride,
                        &blend_area, dsc->color, dsc->opa,
-                       mask_cf, mask_map, mask_coords);
+                       mask_cf, mask_map, &mask_area_r);
     }
     /*Fallback: the GPU doesn't support these settings. Call the SW renderer.*/
     else
     {
         lv_draw_sw_blend_basic(draw_ctx, dsc);
     }
+
+    /*Caller reuses mask_buf after return*/
+    if (mask_wait) check_gpu_done2();
 }
 
 void my_gpu_wait(lv_draw_ctx_t *draw_ctx)
@@ -1593,7 +2321,7 @@ static rt_err_t gpu_cfg(int argc, char **argv)
     if (argc < 2)
     {
         rt_kprintf("gpu_cfg [OPTION] [VALUE]\n");
-        rt_kprintf("    OPTION:enable\n");
+        rt_kprintf("    OPTION:enable|roi [flush]|idx [flush]\n");
         return RT_EOK;
     }
 
@@ -1610,6 +2338,24 @@ static rt_err_t gpu_cfg(int argc, char **argv)
         else
             rt_kprintf("gpu is disable.\n");
     }
+#if defined(HAL_EZIP_MODULE_ENABLED) && (LV_GPU_EZIP_ROI_CACHE_SIZE > 0)
+    else if (strcmp(argv[1], "roi") == 0)
+    {
+        if ((argc > 2) && (strcmp(argv[2], "flush") == 0))
+            ezip_roi_cache_flush();
+
+        rt_kprintf("ezip roi: decoded %d rows, reused %d rows\n", ezip_roi_decoded_rows, ezip_roi_reused_rows);
+    }
+#endif
+#if LV_USE_L8_GPU && (LV_GPU_IDX_CACHE_SIZE > 0)
+    else if (strcmp(argv[1], "idx") == 0)
+    {
+        if ((argc > 2) && (strcmp(argv[2], "flush") == 0))
+            idx_cache_flush();
+
+        rt_kprintf("idx image: expanded %d, reused %d, cache used %d bytes\n", idx_expanded, idx_reused, idx_cache_used);
+    }
+#endif
     return RT_EOK;
 }
 FINSH_FUNCTION_EXPORT(gpu_cfg, gpu configuration: gpu switch | compress rate etc.);
@@ -306,6 +306,9 @@ static void lcd_flush_done(lcd_fb_desc_t *fb_desc)
     lv_disp_drv_t *p_disp = lcd_flushing_disp_drv;
     lcd_flushing_disp_drv = NULL;
 
+    if (p_disp->draw_buf->flushing_last)
+        lv_frame_pacing_flush_done();
+
     rt_err_t err;
     err = rt_sem_release(&lcd_sema);
     RT_ASSERT(RT_EOK == err);
@@ -320,6 +323,9 @@ static rt_err_t lcd_flush_done(rt_device_t dev, void *buffer)
     lcd_flushing_disp_drv = NULL;
     debug_lcd_flush_end();
 
+    if (p_disp->draw_buf->flushing_last)
+        lv_frame_pacing_flush_done();
+
     rt_err_t err;
     err = rt_sem_release(&lcd_sema);
     RT_ASSERT(RT_EOK == err);
@@ -48,9 +48,15 @@
 #include "board.h"
 #include "drv_touch.h"
 
+/*Report pressed point this much ahead by velocity of touch driver, 0 to disable*/
+#ifndef LV_TOUCH_PREDICT_MS
+    #define LV_TOUCH_PREDICT_MS     0
+#endif
+
 static lv_indev_drv_t indev_drv;
 static rt_device_t touch_device = NULL;
 static rt_uint32_t touch_data_cnt = 0;
+static lv_point_t last_pressed;
 
 
 
@@ -58,6 +64,11 @@ static rt_err_t rx_indicate(rt_device_t dev, rt_size_t size)
 {
     ++touch_data_cnt;
 
+    /*Read at once instead of waiting indev read period*/
+    if (indev_drv.read_timer)
+        lv_timer_ready(indev_drv.read_timer);
+    littlevgl2rtt_wakeup();
+
     //rt_kprintf("lv touch device rx indicate!  %d\r\n", touch_data_cnt);
 
     return RT_EOK;
@@ -90,6 +101,31 @@ static void input_read(struct _lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
         data->point.y = touch_data.y;
 
         if (touch_data_cnt > 0) --touch_data_cnt;
+
+#ifdef BSP_USING_TOUCHD
+        if (LV_INDEV_STATE_PR == data->state
+                && (last_pressed.x != data->point.x || last_pressed.y != data->point.y))
+        {
+            struct touch_state st;
+
+            if (RT_EOK == rt_touch_get_state(&st))
+                lv_touch_latency_mark(st.read_ts);
+            last_pressed = data->point;
+        }
+#endif
+#if defined(BSP_USING_TOUCHD) && (LV_TOUCH_PREDICT_MS > 0)
+        /*Only the latest point is predicted, queued ones are history*/
+        if (LV_INDEV_STATE_PR == data->state && 0 == touch_data_cnt)
+        {
+            rt_uint16_t px, py;
+
+            if (RT_EOK == rt_touch_predict(LV_TOUCH_PREDICT_MS, &px, &py))
+            {
+                data->point.x = px;
+                data->point.y = py;
+            }
+        }
+#endif
     }
 
 #ifdef BSP_USING_LVGL_INPUT_AGENT
@@ -8,17 +8,12 @@
 #include "log.h"
 #include "bf0_pm.h"
 #include "section.h"
-#if __has_include("app_mem.h")
-    #include "app_mem.h"
-#else
-    #define app_cache_alloc(size,type) lv_mem_alloc(size)
-    #define app_cache_free(p) lv_mem_free(p)
-#endif
 #ifdef RT_USING_DFS
     #include <dfs_posix.h>
 #endif
 #include "lv_draw_sw.h"
 //#include "lv_draw.h"
+#include "lvsf_img_cache.h"
 
 
 #if LV_USE_GPU
@@ -229,22 +224,46 @@ static lv_res_t file_decoder_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_
         fd = open(dsc->src, O_RDONLY);
         if (fd >= 0)
         {
-#if defined(RT_USING_MTD_NAND)
-            dsc->img_data_size = file_stat.st_size - sizeof(lv_img_header_t);
-            dsc->img_data = app_cache_alloc(dsc->img_data_size, IMAGE_CACHE_PSRAM);
-            if (dsc->img_data)
+            const uint8_t *xip;
+
+            /* Contiguous in XIP flash, e.g. romfs, let EPIC/EZIP fetch data directly */
+            xip = dfs_mmap(fd, sizeof(lv_img_header_t), file_stat.st_size - sizeof(lv_img_header_t));
+            if (xip)
             {
+                dsc->img_data = xip;
+                dsc->img_data_size = file_stat.st_size - sizeof(lv_img_header_t);
+                dsc->user_data = (void *)(file_stat.st_size - sizeof(lv_img_header_t));
                 ret = LV_RES_OK;
-                lseek(fd, sizeof(lv_img_header_t), SEEK_SET);
-                read(fd, (void *)dsc->img_data, dsc->img_data_size);
             }
-#elif defined(RT_USING_MTD_NOR)
-            res = ioctl(fd, F_GET_PHY_ADDR, &addr);
-            if (0 == res)
+#if defined(RT_USING_MTD_NAND)
+            else
             {
-                dsc->img_data = (const uint8_t *)(addr + sizeof(lv_img_header_t));
-                dsc->user_data = (void *)(file_stat.st_size - sizeof(lv_img_header_t));
-                ret = LV_RES_OK;
+                uint8_t *data;
+
+                dsc->img_data_size = file_stat.st_size - sizeof(lv_img_header_t);
+                data = lvsf_img_cache_lookup(dsc->src, file_stat.st_mtime, dsc->img_data_size);
+                if (data)
+                {
+                    ret = LV_RES_OK;
+                }
+                else
+                {
+                    data = lvsf_img_cache_alloc(dsc->src, file_stat.st_mtime, dsc->img_data_size);
+                    if (data)
+                    {
+                        lseek(fd, sizeof(lv_img_header_t), SEEK_SET);
+                        if (read(fd, data, dsc->img_data_size) == dsc->img_data_size)
+                        {
+                            ret = LV_RES_OK;
+                        }
+                        else
+                        {
+                            lvsf_img_cache_discard(data);
+                            data = NULL;
+                        }
+                    }
+                }
+                dsc->img_data = data;
             }
 #endif
             close(fd);
@@ -287,9 +306,10 @@ static void file_decoder_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *
     (void)decoder; /*Unused*/
 
 #if defined(RT_USING_MTD_NAND)
-    if (dsc->img_data)
+    /* user_data is only set for XIP data, which is not from cache */
+    if (dsc->img_data && !dsc->user_data)
     {
-        app_cache_free((void *)dsc->img_data);
+        lvsf_img_cache_release(dsc->img_data);
         dsc->img_data = NULL;
     }
 #endif
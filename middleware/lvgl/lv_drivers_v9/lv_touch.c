@@ -52,6 +52,10 @@
 /*********************
  *      DEFINES
  *********************/
+/*Report pressed point this much ahead by velocity of touch driver, 0 to disable*/
+#ifndef LV_TOUCH_PREDICT_MS
+    #define LV_TOUCH_PREDICT_MS     0
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -78,6 +82,11 @@ static rt_err_t rx_indicate(rt_device_t dev, rt_size_t size)
         lv_touchscreen_t *p = (lv_touchscreen_t *)dev->user_data;
         p->data_cnt++;
         //LV_LOG_USER("lv touch device rx indicate!  %d\r\n", p->data_cnt);
+
+        /*Read at once instead of waiting indev read period*/
+        if (p->indev_drv && lv_indev_get_read_timer(p->indev_drv))
+            lv_timer_ready(lv_indev_get_read_timer(p->indev_drv));
+        littlevgl2rtt_wakeup();
     }
 
     return RT_EOK;
@@ -110,6 +119,19 @@ static void touchscreen_read(lv_indev_t *drv, lv_indev_data_t *data)
         data->point.y = touch_data.y;
 
         if (touchscreen->data_cnt > 0) --touchscreen->data_cnt;
+#if defined(BSP_USING_TOUCHD) && (LV_TOUCH_PREDICT_MS > 0)
+        /*Only the latest point is predicted, queued ones are history*/
+        if (LV_INDEV_STATE_PRESSED == data->state && 0 == touchscreen->data_cnt)
+        {
+            rt_uint16_t px, py;
+
+            if (RT_EOK == rt_touch_predict(LV_TOUCH_PREDICT_MS, &px, &py))
+            {
+                data->point.x = px;
+                data->point.y = py;
+            }
+        }
+#endif
     }
 
 #ifdef BSP_USING_LVGL_INPUT_AGENT
@@ -16,6 +16,7 @@
 #ifdef RT_USING_DFS
     #include <dfs_posix.h>
 #endif
+#include "lvsf_img_cache.h"
 
 /*********************
  *      DEFINES
@@ -172,25 +173,45 @@ static lv_result_t decoder_open(lv_image_decoder_t *decoder, lv_image_decoder_ds
 
                 if (dsc->src_type == LV_IMAGE_SRC_FILE)
                 {
-#if defined(RT_USING_MTD_NAND)
+                    /* Contiguous in XIP flash, e.g. romfs, let EPIC/EZIP fetch data directly */
                     p_decoded->data_size = file_size - sizeof(lv_image_header_t);
-                    p_decoded->data = lv_malloc(p_decoded->data_size);
+                    p_decoded->data = dfs_mmap((int)f->file_d, sizeof(lv_image_header_t), p_decoded->data_size);
                     if (p_decoded->data)
                     {
-                        uint32_t br;
-                        lv_fs_seek(f, sizeof(lv_image_header_t), LV_FS_SEEK_SET);
-                        res = lv_fs_read(f, (void *)p_decoded->data, p_decoded->data_size, &br);
-                        LV_ASSERT(LV_FS_RES_OK == res);
-                        LV_ASSERT(p_decoded->data_size == br);
-                        dsc->user_data = p_decoded->data;
                         ret = LV_RESULT_OK;
                     }
-#elif defined(RT_USING_MTD_NOR)
-                    rt_uint32_t addr;
-                    if (0 == ioctl((int)f->file_d, F_GET_PHY_ADDR, &addr))
+#if defined(RT_USING_MTD_NAND)
+                    else
                     {
-                        p_decoded->data = (uint8_t *)(addr + sizeof(lv_image_header_t));
-                        ret = LV_RESULT_OK;
+                        struct stat file_stat;
+                        uint32_t mtime = 0;
+
+                        if (0 == fstat((int)f->file_d, &file_stat))
+                            mtime = file_stat.st_mtime;
+
+                        p_decoded->data_size = file_size - sizeof(lv_image_header_t);
+                        p_decoded->data = lvsf_img_cache_lookup(fn, mtime, p_decoded->data_size);
+                        if (p_decoded->data)
+                        {
+                            dsc->user_data = p_decoded->data;
+                            ret = LV_RESULT_OK;
+                        }
+                        else if (NULL != (p_decoded->data = lvsf_img_cache_alloc(fn, mtime, p_decoded->data_size)))
+                        {
+                            uint32_t br;
+                            lv_fs_seek(f, sizeof(lv_image_header_t), LV_FS_SEEK_SET);
+                            res = lv_fs_read(f, (void *)p_decoded->data, p_decoded->data_size, &br);
+                            if ((LV_FS_RES_OK == res) && (p_decoded->data_size == br))
+                            {
+                                dsc->user_data = p_decoded->data;
+                                ret = LV_RESULT_OK;
+                            }
+                            else
+                            {
+                                lvsf_img_cache_discard(p_decoded->data);
+                                p_decoded->data = NULL;
+                            }
+                        }
                     }
 #endif
                 }
@@ -219,7 +240,7 @@ static void decoder_close(lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *d
 #if defined(RT_USING_MTD_NAND)
     if (dsc->user_data)
     {
-        lv_free(dsc->user_data);
+        lvsf_img_cache_release(dsc->user_data);
         dsc->user_data = NULL;
     }
 #endif
@@ -52,6 +52,7 @@
 
 #if LV_USE_DRAW_EPIC
 #include "lv_epic_utils.h"
+#include "lv_epic_mask_cache.h"
 
 #include "lv_display_private.h"
 
@@ -61,6 +62,17 @@
 
 #define DRAW_UNIT_ID_EPIC 5
 
+/*Tasks larger than this are split to an EPIC tile and a CPU tile drawn at the same time*/
+#ifndef LV_DRAW_EPIC_TILE_MIN_PIXELS
+    #define LV_DRAW_EPIC_TILE_MIN_PIXELS  (240 * 40)
+#endif
+
+/*CPU tile share of task height, in 1/16*/
+#define TILE_CPU_SHARE_INIT   3
+#define TILE_CPU_SHARE_MAX    8
+/*Cache line size, tiles boundary is aligned to it to avoid EPIC output invalidating CPU tile*/
+#define TILE_ALIGN_BYTES      32
+
 
 /**********************
  *      TYPEDEFS
@@ -77,6 +89,9 @@ typedef struct _lv_draw_epic_unit_t
 #endif
 
     lv_draw_unit_t *p_sw_unit;
+
+    uint8_t tile_cpu_share;
+    lv_draw_epic_stat_t stat;
 } lv_draw_epic_unit_t;
 
 /**********************
@@ -110,6 +125,7 @@ static void execute_drawing(lv_draw_epic_unit_t *u);
     volatile uint32_t g_enable_epic = 0xFFFFFFFF;
 #endif
 static uint8_t initialized = 0;
+static lv_draw_epic_unit_t *epic_unit = NULL;
 /**********************
  *      MACROS
  **********************/
@@ -125,6 +141,7 @@ void lv_draw_epic_init(void)
         draw_epic_unit->base_unit.dispatch_cb = dispatch;
         draw_epic_unit->base_unit.evaluate_cb = evaluate;
         drv_gpu_open();
+        lv_epic_mask_cache_init();
 
 #if LV_USE_OS
         draw_epic_unit->base_unit.wait_for_finish_cb = wait_for_finish;
@@ -132,6 +149,8 @@ void lv_draw_epic_init(void)
 #endif
 
         draw_epic_unit->p_sw_unit = draw_epic_unit->base_unit.next;
+        draw_epic_unit->tile_cpu_share = TILE_CPU_SHARE_INIT;
+        epic_unit = draw_epic_unit;
         initialized = 1;
     }
 }
@@ -140,15 +159,38 @@ void lv_draw_epic_deinit(void)
 {
     if (initialized)
     {
+        lv_epic_mask_cache_deinit();
         drv_gpu_close();
         initialized = 0;
     }
 }
 
+void lv_draw_epic_get_stat(lv_draw_epic_stat_t *stat, bool reset)
+{
+    if (!epic_unit)
+    {
+        lv_memzero(stat, sizeof(lv_draw_epic_stat_t));
+        return;
+    }
+
+    lv_memcpy(stat, &epic_unit->stat, sizeof(lv_draw_epic_stat_t));
+    lv_epic_mask_cache_get_stat(&stat->mask_hit, &stat->mask_miss, reset);
+    if (reset) lv_memzero(&epic_unit->stat, sizeof(lv_draw_epic_stat_t));
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+static uint32_t elapsed_us(uint32_t prev_cycles)
+{
+    static uint32_t hclk_mhz = 0;
+
+    if (0 == hclk_mhz) hclk_mhz = HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000;
+
+    return HAL_GetElapsedTick(prev_cycles, HAL_DBG_DWT_GetCycles()) / hclk_mhz;
+}
+
 static inline bool cf_supported(lv_color_format_t cf, uint32_t flags)
 {
     //Ezip images
@@ -168,6 +210,9 @@ static int32_t evaluate(lv_draw_unit_t *draw_unit, lv_draw_task_t *t)
 {
     lv_draw_epic_unit_t *draw_epic_unit = (lv_draw_epic_unit_t *) draw_unit;
 
+    /*Called once for each new task*/
+    draw_epic_unit->stat.all_tasks++;
+
 #ifdef DEBUG_LV_DRAW_EPIC_ENABLED_FUNCTION
     if (0 == (g_enable_epic & (1 << (t->type))))
     {
@@ -194,17 +239,21 @@ static int32_t evaluate(lv_draw_unit_t *draw_unit, lv_draw_task_t *t)
         }
         return 1;
     }
-#if 0
-    case LV_DRAW_TASK_TYPE_LINE:
+#if defined(EPIC_SUPPORT_MONOCHROME_LAYER)&&defined(EPIC_SUPPORT_MASK)
     case LV_DRAW_TASK_TYPE_ARC:
-        if (t->preference_score > 90)
+    {
+        const lv_draw_arc_dsc_t *draw_dsc = (const lv_draw_arc_dsc_t *) t->draw_dsc;
+
+        /*With cached mask only blending is left, otherwise CPU still generates the mask*/
+        int32_t score = lv_draw_epic_arc_is_cached(draw_dsc, &t->area) ? 60 : 85;
+        if (t->preference_score > score)
         {
-            t->preference_score = 90;
+            t->preference_score = score;
             t->preferred_draw_unit_id = DRAW_UNIT_ID_EPIC;
         }
         return 1;
-
-#endif
+    }
+#endif /* EPIC_SUPPORT_MONOCHROME_LAYER&&EPIC_SUPPORT_MASK */
 
     case LV_DRAW_TASK_TYPE_LABEL:
         if (t->preference_score > 95)
@@ -217,16 +266,20 @@ static int32_t evaluate(lv_draw_unit_t *draw_unit, lv_draw_task_t *t)
     case LV_DRAW_TASK_TYPE_BORDER:
     {
         const lv_draw_border_dsc_t *draw_dsc = (lv_draw_border_dsc_t *) t->draw_dsc;
-
-        if (draw_dsc->side != (lv_border_side_t)LV_BORDER_SIDE_FULL)
-            return 0;
+        int32_t score = 90;
 
         if (draw_dsc->radius != 0)
+        {
+#if defined(EPIC_SUPPORT_MONOCHROME_LAYER)&&defined(EPIC_SUPPORT_MASK)&&LV_DRAW_SW_COMPLEX
+            score = lv_draw_epic_border_is_cached(draw_dsc, &t->area) ? 70 : 88;
+#else
             return 0;
+#endif
+        }
 
-        if (t->preference_score > 90)
+        if (t->preference_score > score)
         {
-            t->preference_score = 90;
+            t->preference_score = score;
             t->preferred_draw_unit_id = DRAW_UNIT_ID_EPIC;
         }
         return 1;
@@ -367,10 +420,117 @@ static int32_t dispatch(lv_draw_unit_t *draw_unit, lv_layer_t *layer)
     return 1;
 }
 
+/*
+ * Return true if the task can be drawn by the SW renderer on part of its area
+ * with the same result, and is large enough to be worth it.
+ */
+static bool is_tile_splittable(lv_draw_epic_unit_t *u, lv_draw_task_t *t, lv_area_t *draw_area)
+{
+    lv_layer_t *layer = u->base_unit.target_layer;
+
+    if (!lv_area_intersect(draw_area, &t->area, u->base_unit.clip_area))
+        return false;
+    if (!lv_area_intersect(draw_area, draw_area, &layer->buf_area))
+        return false;
+    if ((NULL == layer->draw_buf) || (lv_area_get_size(draw_area) < LV_DRAW_EPIC_TILE_MIN_PIXELS))
+        return false;
+
+    switch (t->type)
+    {
+    case LV_DRAW_TASK_TYPE_FILL:
+        return true;
+
+    case LV_DRAW_TASK_TYPE_IMAGE:
+    {
+        const lv_draw_image_dsc_t *draw_dsc = (const lv_draw_image_dsc_t *) t->draw_dsc;
+        const lv_image_dsc_t *img_dsc = draw_dsc->src;
+
+        //Transformed pixels differ slightly between EPIC and SW, keep them in one unit to avoid seams.
+        if (draw_dsc->rotation != 0 || draw_dsc->scale_x != LV_SCALE_NONE || draw_dsc->scale_y != LV_SCALE_NONE)
+            return false;
+        if (lv_image_src_get_type(img_dsc) != LV_IMAGE_SRC_VARIABLE)
+            return false;
+        if (0 != (img_dsc->header.flags & LV_IMAGE_FLAGS_EZIP))
+            return false;
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/*
+ * Draw the top tile of 't' with CPU while EPIC draws the rest.
+ * CPU takes the top, as EPIC invalidates cache from the start of its output to the end.
+ * Return false if not split, and the task should be drawn by EPIC only.
+ */
+static bool execute_drawing_tiles(lv_draw_epic_unit_t *u, lv_draw_task_t *t)
+{
+    lv_draw_unit_t *draw_unit = (lv_draw_unit_t *) u;
+    lv_layer_t *layer = draw_unit->target_layer;
+    const lv_area_t *clip_area = draw_unit->clip_area;
+    lv_area_t draw_area, cpu_tile, epic_tile;
+    int32_t split_y;
+
+    if (!is_tile_splittable(u, t, &draw_area))
+        return false;
+
+    split_y = draw_area.y1 + lv_area_get_height(&draw_area) * u->tile_cpu_share / 16;
+    while ((split_y > draw_area.y1)
+            && (0 != ((uint32_t)lv_draw_layer_go_to_xy(layer, 0, split_y - layer->buf_area.y1) % TILE_ALIGN_BYTES)))
+        split_y--;
+    if (split_y <= draw_area.y1)
+        return false;
+
+    cpu_tile = draw_area;
+    cpu_tile.y2 = split_y - 1;
+    epic_tile = draw_area;
+    epic_tile.y1 = split_y;
+
+    uint32_t start = HAL_DBG_DWT_GetCycles();
+    uint32_t cpu_us, wait_start;
+
+    /*Start EPIC tile, it's asynchronous*/
+    draw_unit->clip_area = &epic_tile;
+    if (LV_DRAW_TASK_TYPE_FILL == t->type)
+        lv_draw_epic_fill(draw_unit, t->draw_dsc, &t->area);
+    else
+        lv_draw_epic_img(draw_unit, t->draw_dsc, &t->area);
+
+    /*CPU tile meanwhile*/
+    draw_unit->clip_area = &cpu_tile;
+    if (LV_DRAW_TASK_TYPE_FILL == t->type)
+        lv_draw_sw_fill(draw_unit, (lv_draw_fill_dsc_t *)t->draw_dsc, &t->area);
+    else
+        lv_draw_sw_image(draw_unit, t->draw_dsc, &t->area);
+    cpu_us = elapsed_us(start);
+
+    wait_start = HAL_DBG_DWT_GetCycles();
+    drv_epic_wait_done();
+    draw_unit->clip_area = clip_area;
+
+    uint32_t wait_us = elapsed_us(wait_start);
+
+    u->stat.split_tasks++;
+    u->stat.cpu_busy_us += cpu_us;
+    u->stat.epic_busy_us += cpu_us + wait_us; //EPIC busy until done
+    u->stat.overlap_us += cpu_us;
+
+    /*Balance tiles: EPIC still busy after CPU tile means CPU could take more.*/
+    if ((wait_us > cpu_us / 8) && (u->tile_cpu_share < TILE_CPU_SHARE_MAX))
+        u->tile_cpu_share++;
+    else if ((0 == wait_us) && (u->tile_cpu_share > 1))
+        u->tile_cpu_share--;
+
+    return true;
+}
+
 static void execute_drawing(lv_draw_epic_unit_t *u)
 {
     lv_draw_task_t *t = u->task_act;
     lv_draw_unit_t *draw_unit = (lv_draw_unit_t *) u;
+    uint32_t start;
 
     int ret = (int)drv_epic_wait_done();
     if (ret > 0)
@@ -379,6 +539,12 @@ static void execute_drawing(lv_draw_epic_unit_t *u)
         LV_ASSERT(0);
     }
 
+    u->stat.tasks++;
+    if (execute_drawing_tiles(u, t))
+        return;
+
+    start = HAL_DBG_DWT_GetCycles();
+
     LV_EPIC_LOG("_epic_execute_drawing %d ", t->type);
     lv_epic_print_area_info("src_area", &t->area);
     lv_epic_print_layer_info(draw_unit);
@@ -420,6 +586,7 @@ static void execute_drawing(lv_draw_epic_unit_t *u)
     }
 
     drv_epic_wait_done();
+    u->stat.epic_busy_us += elapsed_us(start);
 
 #if LV_USE_PARALLEL_DRAW_DEBUG
     /*Layers manage it for themselves*/
@@ -521,4 +688,24 @@ static void render_thread_cb(void *ptr)
 }
 #endif
 
+#ifdef RT_USING_FINSH
+#include <string.h>
+static int epic_stat(int argc, char **argv)
+{
+    lv_draw_epic_stat_t stat;
+    uint32_t mask_total;
+
+    lv_draw_epic_get_stat(&stat, (argc > 1) && (0 == strcmp(argv[1], "reset")));
+    mask_total = stat.mask_hit + stat.mask_miss;
+
+    rt_kprintf("tasks epic=%d all=%d (%d%%) split=%d\n", stat.tasks, stat.all_tasks,
+               stat.all_tasks ? stat.tasks * 100 / stat.all_tasks : 0, stat.split_tasks);
+    rt_kprintf("busy epic=%dus cpu=%dus overlap=%dus\n", stat.epic_busy_us, stat.cpu_busy_us, stat.overlap_us);
+    rt_kprintf("mask hit=%d miss=%d rate=%d%%\n", stat.mask_hit, stat.mask_miss,
+               mask_total ? stat.mask_hit * 100 / mask_total : 0);
+    return 0;
+}
+MSH_CMD_EXPORT(epic_stat, epic_stat [reset]: share of draw tasks drawn by EPIC and mask cache hit rate);
+#endif /* RT_USING_FINSH */
+
 #endif /*LV_USE_DRAW_EPIC*/
@@ -72,6 +72,18 @@ extern "C" {
 
 typedef lv_layer_t lv_epic_layer_t;
 
+typedef struct
+{
+    uint32_t all_tasks;    /*Tasks evaluated, i.e. drawn by any unit*/
+    uint32_t tasks;        /*Tasks drawn by EPIC unit*/
+    uint32_t split_tasks;  /*Tasks split to EPIC tile and CPU tile*/
+    uint32_t epic_busy_us; /*Time of EPIC drawing, include waiting for done*/
+    uint32_t cpu_busy_us;  /*Time of CPU drawing tiles in EPIC unit*/
+    uint32_t overlap_us;   /*Time of EPIC and CPU drawing at the same time*/
+    uint32_t mask_hit;     /*Arc and rounded border masks found in cache*/
+    uint32_t mask_miss;    /*Arc and rounded border masks generated*/
+} lv_draw_epic_stat_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -82,6 +94,13 @@ void lv_draw_epic_init(void);
 
 void lv_draw_epic_deinit(void);
 
+/**
+ * Get busy time counters of EPIC unit
+ * @param stat  output
+ * @param reset reset the counters after reading
+ */
+void lv_draw_epic_get_stat(lv_draw_epic_stat_t *stat, bool reset);
+
 void lv_draw_epic_fill(lv_draw_unit_t *draw_unit, const lv_draw_fill_dsc_t *dsc,
                        const lv_area_t *coords);
 
@@ -97,6 +116,10 @@ void lv_draw_epic_label(lv_draw_unit_t *draw_unit, const lv_draw_label_dsc_t *ds
 void lv_draw_epic_border(lv_draw_unit_t *draw_unit, const lv_draw_border_dsc_t *dsc,
                          const lv_area_t *coords);
 void lv_draw_epic_arc(lv_draw_unit_t *draw_unit, const lv_draw_arc_dsc_t *dsc, const lv_area_t *coords);
+
+/*Return true if the masks for drawing are cached, used to estimate cost*/
+bool lv_draw_epic_arc_is_cached(const lv_draw_arc_dsc_t *dsc, const lv_area_t *coords);
+bool lv_draw_epic_border_is_cached(const lv_draw_border_dsc_t *dsc, const lv_area_t *coords);
 /**********************
  *      MACROS
  **********************/
@@ -50,6 +50,7 @@
 
 #if LV_USE_DRAW_EPIC
 #include "lv_epic_utils.h"
+#include "lv_epic_mask_cache.h"
 
 #include "../../misc/lv_area_private.h"
 #include "lv_draw_sw_mask_private.h"
@@ -65,25 +66,45 @@
 #include "../../stdlib/lv_string.h"
 #include "../lv_draw_private.h"
 
-static void add_circle(const lv_opa_t *circle_mask, const lv_area_t *blend_area, const lv_area_t *circle_area,
-                       lv_opa_t *mask_buf,  int32_t width);
-static void get_rounded_area(int16_t angle, int32_t radius, uint8_t thickness, lv_area_t *res_area);
-
 /*********************
  *      DEFINES
  *********************/
-#define SPLIT_RADIUS_LIMIT 10  /*With radius greater than this the arc will drawn in quarters. A quarter is drawn only if there is arc in it*/
-#define SPLIT_ANGLE_GAP_LIMIT 60  /*With small gaps in the arc don't bother with splitting because there is nothing to skip.*/
-
 
-//#define MULTI_LINE_MASK_ENABLE
 /**********************
  *      TYPEDEFS
  **********************/
 
+/*Masks of an arc, initialized only when the mask is not cached*/
+typedef struct
+{
+    const lv_draw_arc_dsc_t *dsc;
+    lv_area_t area_out;
+    int32_t width;
+    int32_t start_angle;
+    int32_t end_angle;
+
+    bool inited;
+    void *mask_list[4];
+    lv_draw_sw_mask_angle_param_t mask_angle_param;
+    lv_draw_sw_mask_radius_param_t mask_out_param;
+    lv_draw_sw_mask_radius_param_t mask_in_param;
+    bool mask_in_param_valid;
+    lv_opa_t *circle_mask;
+    lv_area_t round_area_1;
+    lv_area_t round_area_2;
+} arc_mask_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static bool arc_mask_setup(arc_mask_t *arc, const lv_draw_arc_dsc_t *dsc, const lv_area_t *coords,
+                           lv_area_t *mask_area, lv_epic_mask_key_t *key);
+static lv_draw_sw_mask_res_t arc_mask_row(lv_opa_t *row, int32_t x, int32_t y, int32_t w, void *user_data);
+static void arc_mask_free(arc_mask_t *arc);
+static void ring_to_border_dsc(const lv_draw_arc_dsc_t *dsc, lv_draw_border_dsc_t *cir_dsc);
+static void add_circle(const lv_opa_t *circle_mask, const lv_area_t *blend_area, const lv_area_t *circle_area,
+                       lv_opa_t *mask_buf,  int32_t width);
+static void get_rounded_area(int16_t angle, int32_t radius, uint8_t thickness, lv_area_t *res_area);
 
 /**********************
  *  STATIC VARIABLES
@@ -103,130 +124,172 @@ void lv_draw_epic_arc(lv_draw_unit_t *draw_unit, const lv_draw_arc_dsc_t *dsc, c
     if (dsc->width == 0) return;
     if (dsc->start_angle == dsc->end_angle) return;
 
-    int32_t width = dsc->width;
-    if (width > dsc->radius) width = dsc->radius;
-
-    lv_area_t area_out = *coords;
     lv_area_t clipped_area;
-    if (!lv_area_intersect(&clipped_area, &area_out, draw_unit->clip_area)) return;
+    if (!lv_area_intersect(&clipped_area, coords, draw_unit->clip_area)) return;
 
     /*Draw a full ring*/
     if (dsc->img_src == NULL &&
             (dsc->start_angle + 360 == dsc->end_angle || dsc->start_angle == dsc->end_angle + 360))
     {
         lv_draw_border_dsc_t cir_dsc;
-        lv_draw_border_dsc_init(&cir_dsc);
-        cir_dsc.opa = dsc->opa;
-        cir_dsc.color = dsc->color;
-        cir_dsc.width = width;
-        cir_dsc.radius = LV_RADIUS_CIRCLE;
-        cir_dsc.side = LV_BORDER_SIDE_FULL;
-        lv_draw_sw_border(draw_unit, &cir_dsc, &area_out);
+        ring_to_border_dsc(dsc, &cir_dsc);
+        lv_draw_epic_border(draw_unit, &cir_dsc, coords);
         return;
     }
 
-    lv_area_t area_in;
-    lv_area_copy(&area_in, &area_out);
-    area_in.x1 += dsc->width;
-    area_in.y1 += dsc->width;
-    area_in.x2 -= dsc->width;
-    area_in.y2 -= dsc->width;
+    arc_mask_t arc;
+    lv_area_t mask_area;
+    lv_epic_mask_key_t key;
+    if (!arc_mask_setup(&arc, dsc, coords, &mask_area, &key)) return;
 
-    int32_t start_angle = (int32_t)dsc->start_angle;
-    int32_t end_angle = (int32_t)dsc->end_angle;
-    while (start_angle >= 360) start_angle -= 360;
-    while (end_angle >= 360) end_angle -= 360;
-
-    void *mask_list[4] = {0};
-    /*Create an angle mask*/
-    lv_draw_sw_mask_angle_param_t mask_angle_param;
-    lv_draw_sw_mask_angle_init(&mask_angle_param, dsc->center.x, dsc->center.y, start_angle, end_angle);
-    mask_list[0] = &mask_angle_param;
-
-    /*Create an outer mask*/
-    lv_draw_sw_mask_radius_param_t mask_out_param;
-    lv_draw_sw_mask_radius_init(&mask_out_param, &area_out, LV_RADIUS_CIRCLE, false);
-    mask_list[1] = &mask_out_param;
-
-    /*Create inner the mask*/
-    lv_draw_sw_mask_radius_param_t mask_in_param;
-    bool mask_in_param_valid = false;
-    if (lv_area_get_width(&area_in) > 0 && lv_area_get_height(&area_in) > 0)
-    {
-        lv_draw_sw_mask_radius_init(&mask_in_param, &area_in, LV_RADIUS_CIRCLE, true);
-        mask_list[2] = &mask_in_param;
-        mask_in_param_valid = true;
-    }
-
-    int32_t blend_h = lv_area_get_height(&clipped_area);
-    int32_t blend_w = lv_area_get_width(&clipped_area);
-    int32_t h;
-
-#ifdef MULTI_LINE_MASK_ENABLE
-    //Allocate maximum 4KB ping-pong buffer for CPU and GPU paralell
-    int32_t  mask_buf_h = LV_MIN(2048 / blend_w, blend_h);
-    lv_opa_t *mask_buf = lv_mem_alloc(blend_w * mask_buf_h * 2);
-    lv_opa_t *mask_buf_ping_pong = mask_buf;
-#else
-    lv_opa_t *mask_buf = lv_malloc(blend_w);
-#endif /* MULTI_LINE_MASK_ENABLE */
-
-    lv_area_t blend_area = clipped_area;
-    lv_area_t img_area;
     lv_draw_sw_blend_dsc_t blend_dsc = {0};
-    blend_dsc.mask_buf = mask_buf;
     blend_dsc.opa = dsc->opa;
-    blend_dsc.blend_area = &blend_area;
-    blend_dsc.mask_area = &blend_area;
+    blend_dsc.color = dsc->color;
 
-    const uint8_t *img_mask = NULL;
+    lv_area_t img_area;
     lv_image_decoder_dsc_t decoder_dsc;
-    if (dsc->img_src == NULL)
-    {
-        blend_dsc.color = dsc->color;
-    }
-    else
+    if (dsc->img_src)
     {
         lv_result_t res = lv_image_decoder_open(&decoder_dsc, dsc->img_src, NULL);
         if (res == LV_RESULT_INVALID || decoder_dsc.decoded == NULL)
         {
             LV_LOG_WARN("Can't decode the background image");
-            blend_dsc.color = dsc->color;
+            if (res != LV_RESULT_INVALID) lv_image_decoder_close(&decoder_dsc);
+            lv_draw_sw_arc(draw_unit, dsc, coords);
+            return;
         }
-        else
+
+        /*Its A8 part would have to be merged into the mask, which then can't be cached*/
+        if (decoder_dsc.decoded->header.cf == LV_COLOR_FORMAT_RGB565A8)
         {
-            img_area.x1 = 0;
-            img_area.y1 = 0;
-            img_area.x2 = decoder_dsc.decoded->header.w - 1;
-            img_area.y2 = decoder_dsc.decoded->header.h - 1;
-            int32_t ofs = decoder_dsc.decoded->header.w / 2;
-            lv_area_move(&img_area, dsc->center.x - ofs, dsc->center.y - ofs);
-            blend_dsc.src_area = &img_area;
-            blend_dsc.src_buf = decoder_dsc.decoded->data;
-            blend_dsc.src_stride = decoder_dsc.decoded->header.stride;
-            blend_dsc.src_color_format = decoder_dsc.decoded->header.cf;
-            if (blend_dsc.src_color_format == LV_COLOR_FORMAT_RGB565A8)
-            {
-                blend_dsc.src_color_format = LV_COLOR_FORMAT_RGB565;
-                img_mask = (uint8_t *)blend_dsc.src_buf + blend_dsc.src_stride * lv_area_get_height(blend_dsc.src_area);
-            }
+            lv_image_decoder_close(&decoder_dsc);
+            lv_draw_sw_arc(draw_unit, dsc, coords);
+            return;
         }
+
+        img_area.x1 = 0;
+        img_area.y1 = 0;
+        img_area.x2 = decoder_dsc.decoded->header.w - 1;
+        img_area.y2 = decoder_dsc.decoded->header.h - 1;
+        int32_t ofs = decoder_dsc.decoded->header.w / 2;
+        lv_area_move(&img_area, dsc->center.x - ofs, dsc->center.y - ofs);
+        blend_dsc.src_area = &img_area;
+        blend_dsc.src_buf = decoder_dsc.decoded->data;
+        blend_dsc.src_stride = decoder_dsc.decoded->header.stride;
+        blend_dsc.src_color_format = decoder_dsc.decoded->header.cf;
+    }
+
+    lv_epic_draw_blend_mask(draw_unit, &blend_dsc, &key, &mask_area, arc_mask_row, &arc);
+
+    arc_mask_free(&arc);
+    if (dsc->img_src) lv_image_decoder_close(&decoder_dsc);
+}
+
+bool lv_draw_epic_arc_is_cached(const lv_draw_arc_dsc_t *dsc, const lv_area_t *coords)
+{
+    if (dsc->img_src == NULL &&
+            (dsc->start_angle + 360 == dsc->end_angle || dsc->start_angle == dsc->end_angle + 360))
+    {
+        lv_draw_border_dsc_t cir_dsc;
+        ring_to_border_dsc(dsc, &cir_dsc);
+        return lv_draw_epic_border_is_cached(&cir_dsc, coords);
+    }
+
+    arc_mask_t arc;
+    lv_area_t mask_area;
+    lv_epic_mask_key_t key;
+    if (!arc_mask_setup(&arc, dsc, coords, &mask_area, &key)) return true;
+
+    return lv_epic_mask_cache_has(&key);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*
+ * Get the area and cache key of the arc mask, the mask is limited to the
+ * bounding box of the arc. Return false if nothing to draw.
+ */
+static bool arc_mask_setup(arc_mask_t *arc, const lv_draw_arc_dsc_t *dsc, const lv_area_t *coords,
+                           lv_area_t *mask_area, lv_epic_mask_key_t *key)
+{
+    lv_memzero(arc, sizeof(arc_mask_t));
+    arc->dsc = dsc;
+    arc->area_out = *coords;
+    arc->width = dsc->width;
+    if (arc->width > dsc->radius) arc->width = dsc->radius;
+
+    int32_t start_angle = (int32_t)dsc->start_angle;
+    int32_t end_angle = (int32_t)dsc->end_angle;
+    while (start_angle >= 360) start_angle -= 360;
+    while (end_angle >= 360) end_angle -= 360;
+    arc->start_angle = start_angle;
+    arc->end_angle = end_angle;
+
+    lv_area_t arc_area;
+    lv_draw_arc_get_area(dsc->center.x, dsc->center.y, dsc->radius, dsc->start_angle, dsc->end_angle,
+                         arc->width, dsc->rounded, &arc_area);
+    if (!lv_area_intersect(mask_area, &arc_area, coords)) return false;
+
+    /*Relative to the center, so that moved arcs share the mask*/
+    lv_memzero(key, sizeof(lv_epic_mask_key_t));
+    key->type = LV_EPIC_MASK_ARC;
+    key->p[0] = dsc->radius;
+    key->p[1] = arc->width;
+    key->p[2] = start_angle;
+    key->p[3] = end_angle;
+    key->p[4] = dsc->rounded;
+    key->p[5] = coords->x1 - dsc->center.x;
+    key->p[6] = coords->y1 - dsc->center.y;
+    key->p[7] = mask_area->x1 - dsc->center.x;
+    key->p[8] = mask_area->y1 - dsc->center.y;
+    key->p[9] = lv_area_get_width(mask_area);
+    key->p[10] = lv_area_get_height(mask_area);
+
+    return true;
+}
+
+static void arc_mask_init(arc_mask_t *arc)
+{
+    const lv_draw_arc_dsc_t *dsc = arc->dsc;
+    int32_t width = arc->width;
+
+    lv_area_t area_in;
+    lv_area_copy(&area_in, &arc->area_out);
+    area_in.x1 += dsc->width;
+    area_in.y1 += dsc->width;
+    area_in.x2 -= dsc->width;
+    area_in.y2 -= dsc->width;
+
+    /*Create an angle mask*/
+    lv_draw_sw_mask_angle_init(&arc->mask_angle_param, dsc->center.x, dsc->center.y, arc->start_angle, arc->end_angle);
+    arc->mask_list[0] = &arc->mask_angle_param;
+
+    /*Create an outer mask*/
+    lv_draw_sw_mask_radius_init(&arc->mask_out_param, &arc->area_out, LV_RADIUS_CIRCLE, false);
+    arc->mask_list[1] = &arc->mask_out_param;
+
+    /*Create inner the mask*/
+    if (lv_area_get_width(&area_in) > 0 && lv_area_get_height(&area_in) > 0)
+    {
+        lv_draw_sw_mask_radius_init(&arc->mask_in_param, &area_in, LV_RADIUS_CIRCLE, true);
+        arc->mask_list[2] = &arc->mask_in_param;
+        arc->mask_in_param_valid = true;
     }
 
-    lv_opa_t *circle_mask = NULL;
-    lv_area_t round_area_1;
-    lv_area_t round_area_2;
     if (dsc->rounded)
     {
-        circle_mask = lv_malloc(width * width);
-        lv_memset(circle_mask, 0xff, width * width);
+        arc->circle_mask = lv_malloc(width * width);
+        LV_ASSERT_MALLOC(arc->circle_mask);
+        lv_memset(arc->circle_mask, 0xff, width * width);
         lv_area_t circle_area = {0, 0, width - 1, width - 1};
         lv_draw_sw_mask_radius_param_t circle_mask_param;
         lv_draw_sw_mask_radius_init(&circle_mask_param, &circle_area, width / 2, false);
         void *circle_mask_list[2] = {&circle_mask_param, NULL};
 
-        lv_opa_t *circle_mask_tmp = circle_mask;
-        for (h = 0; h < width; h++)
+        lv_opa_t *circle_mask_tmp = arc->circle_mask;
+        for (int32_t h = 0; h < width; h++)
         {
             lv_draw_sw_mask_res_t res = lv_draw_sw_mask_apply(circle_mask_list, circle_mask_tmp, 0, h, width);
             if (res == LV_DRAW_SW_MASK_RES_TRANSP)
@@ -236,173 +299,74 @@ void lv_draw_epic_arc(lv_draw_unit_t *draw_unit, const lv_draw_arc_dsc_t *dsc, c
 
             circle_mask_tmp += width;
         }
-        get_rounded_area(start_angle, dsc->radius, width, &round_area_1);
-        lv_area_move(&round_area_1, dsc->center.x, dsc->center.y);
-        get_rounded_area(end_angle, dsc->radius, width, &round_area_2);
-        lv_area_move(&round_area_2, dsc->center.x, dsc->center.y);
+        lv_draw_sw_mask_free_param(&circle_mask_param);
 
+        get_rounded_area(arc->start_angle, dsc->radius, width, &arc->round_area_1);
+        lv_area_move(&arc->round_area_1, dsc->center.x, dsc->center.y);
+        get_rounded_area(arc->end_angle, dsc->radius, width, &arc->round_area_2);
+        lv_area_move(&arc->round_area_2, dsc->center.x, dsc->center.y);
     }
 
-#ifdef MULTI_LINE_MASK_ENABLE
-    lv_area_t mask_area = clipped_area;
-
-    for (int32_t f = 0; f < blend_h;)
-    {
-        int32_t blend_sub_h = LV_MIN(mask_buf_h, blend_h - f);
-        lv_opa_t *mask_buf_sub;
-        lv_draw_mask_res_t mask_res = LV_DRAW_MASK_RES_TRANSP;
-
-
-        mask_area.y1 = blend_area.y1;
-        mask_area.y2 = blend_area.y1;
-
-        mask_buf_sub = mask_buf_ping_pong;
-        for (h = 0; h < blend_sub_h; h++)
-        {
-            lv_memset(mask_buf_sub, 0xff, blend_w);
-            lv_draw_mask_res_t mask_res_sub = lv_draw_mask_apply(mask_buf_sub, mask_area.x1, mask_area.y1, blend_w);
-
-            if (dsc->rounded)
-            {
-                if (mask_area.y1 >= round_area_1.y1 && mask_area.y1 <= round_area_1.y2)
-                {
-                    if (mask_res_sub == LV_DRAW_MASK_RES_TRANSP)
-                    {
-                        lv_memzero(mask_buf_sub, blend_w);
-                        mask_res_sub = LV_DRAW_MASK_RES_CHANGED;
-                    }
-                    add_circle(circle_mask, &mask_area, &round_area_1, mask_buf_sub, width);
-                }
-                if (mask_area.y1 >= round_area_2.y1 && mask_area.y1 <= round_area_2.y2)
-                {
-                    if (mask_res_sub == LV_DRAW_MASK_RES_TRANSP)
-                    {
-                        lv_memzero(mask_buf_sub, blend_w);
-                        mask_res_sub = LV_DRAW_MASK_RES_CHANGED;
-                    }
-                    add_circle(circle_mask, &mask_area, &round_area_2, mask_buf_sub, width);
-                }
-            }
-
-
-            /*If it was an RGB565A8 image use consider its A8 part on the mask*/
-            if (img_mask && mask_res_sub != LV_DRAW_SW_MASK_RES_TRANSP)
-            {
-                const uint8_t *img_mask_tmp = img_mask;
-                img_mask_tmp += blend_dsc.src_stride / 2 * (blend_area.y1 - blend_dsc.src_area->y1);
-                img_mask_tmp += blend_area.x1 - blend_dsc.src_area->x1;
-
-                int32_t i;
-                for (i = 0; i < blend_w; i++)
-                {
-                    mask_buf[i] = LV_OPA_MIX2(mask_buf[i], img_mask_tmp[i]);
-                }
-                if (mask_res_sub == LV_DRAW_SW_MASK_RES_FULL_COVER)
-                {
-                    mask_res_sub = LV_DRAW_SW_MASK_RES_CHANGED;
-                }
-            }
-
-            if (mask_res_sub != LV_DRAW_MASK_RES_TRANSP)
-                mask_res = mask_res_sub;
-            else
-                lv_memzero(mask_buf_sub, blend_w);
-
-            mask_area.y1 ++;
-            mask_area.y2 ++;
-            mask_buf_sub += blend_w;
-        }
-
-
-
-        blend_area.y2 =  blend_area.y1 + blend_sub_h - 1;
-        if (mask_res != LV_DRAW_MASK_RES_TRANSP)
-        {
-            _lv_blend_cont_fill(clip_area, &blend_area,
-                                dsc->color, mask_buf_ping_pong, mask_res, dsc->opa, LV_BLEND_MODE_NORMAL);
+    arc->inited = true;
+}
 
-            if (mask_buf_ping_pong == mask_buf)
-                mask_buf_ping_pong = mask_buf + (blend_w * mask_buf_h);
-            else
-                mask_buf_ping_pong = mask_buf;
-        }
+static lv_draw_sw_mask_res_t arc_mask_row(lv_opa_t *row, int32_t x, int32_t y, int32_t w, void *user_data)
+{
+    arc_mask_t *arc = user_data;
 
-        blend_area.y1 += blend_sub_h;
-        blend_area.y2 += blend_sub_h;
-        f += blend_sub_h;
-    }
+    if (!arc->inited) arc_mask_init(arc);
 
-    _lv_blend_cont_fill_reset();
+    lv_draw_sw_mask_res_t res = lv_draw_sw_mask_apply(arc->mask_list, row, x, y, w);
 
-#else
-    blend_area.y2 = blend_area.y1;
-    for (h = 0; h < blend_h; h++)
+    if (arc->circle_mask)
     {
-        lv_memset(mask_buf, 0xff, blend_w);
-        blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, blend_area.y1, blend_w);
+        lv_area_t row_area = {x, y, x + w - 1, y};
 
-        if (dsc->rounded)
+        if (y >= arc->round_area_1.y1 && y <= arc->round_area_1.y2)
         {
-            if (blend_area.y1 >= round_area_1.y1 && blend_area.y1 <= round_area_1.y2)
-            {
-                if (blend_dsc.mask_res == LV_DRAW_SW_MASK_RES_TRANSP)
-                {
-                    lv_memzero(mask_buf, blend_w);
-                    blend_dsc.mask_res = LV_DRAW_SW_MASK_RES_CHANGED;
-                }
-                add_circle(circle_mask, &blend_area, &round_area_1, mask_buf, width);
-            }
-            if (blend_area.y1 >= round_area_2.y1 && blend_area.y1 <= round_area_2.y2)
+            if (res == LV_DRAW_SW_MASK_RES_TRANSP)
             {
-                if (blend_dsc.mask_res == LV_DRAW_SW_MASK_RES_TRANSP)
-                {
-                    lv_memzero(mask_buf, blend_w);
-                    blend_dsc.mask_res = LV_DRAW_SW_MASK_RES_CHANGED;
-                }
-                add_circle(circle_mask, &blend_area, &round_area_2, mask_buf, width);
+                lv_memzero(row, w);
+                res = LV_DRAW_SW_MASK_RES_CHANGED;
             }
+            add_circle(arc->circle_mask, &row_area, &arc->round_area_1, row, arc->width);
         }
-
-        /*If it was an RGB565A8 image use consider its A8 part on the mask*/
-        if (img_mask && blend_dsc.mask_res != LV_DRAW_SW_MASK_RES_TRANSP)
+        if (y >= arc->round_area_2.y1 && y <= arc->round_area_2.y2)
         {
-            const uint8_t *img_mask_tmp = img_mask;
-            img_mask_tmp += blend_dsc.src_stride / 2 * (blend_area.y1 - blend_dsc.src_area->y1);
-            img_mask_tmp += blend_area.x1 - blend_dsc.src_area->x1;
-
-            int32_t i;
-            for (i = 0; i < blend_w; i++)
-            {
-                mask_buf[i] = LV_OPA_MIX2(mask_buf[i], img_mask_tmp[i]);
-            }
-            if (blend_dsc.mask_res == LV_DRAW_SW_MASK_RES_FULL_COVER)
+            if (res == LV_DRAW_SW_MASK_RES_TRANSP)
             {
-                blend_dsc.mask_res = LV_DRAW_SW_MASK_RES_CHANGED;
+                lv_memzero(row, w);
+                res = LV_DRAW_SW_MASK_RES_CHANGED;
             }
+            add_circle(arc->circle_mask, &row_area, &arc->round_area_2, row, arc->width);
         }
+    }
 
-        lv_epic_draw_blend(draw_unit, &blend_dsc);
+    return res;
+}
 
-        blend_area.y1 ++;
-        blend_area.y2 ++;
-    }
-#endif /* MULTI_LINE_MASK_ENABLE */
+static void arc_mask_free(arc_mask_t *arc)
+{
+    if (!arc->inited) return;
 
-    lv_draw_sw_mask_free_param(&mask_angle_param);
-    lv_draw_sw_mask_free_param(&mask_out_param);
-    if (mask_in_param_valid)
+    lv_draw_sw_mask_free_param(&arc->mask_angle_param);
+    lv_draw_sw_mask_free_param(&arc->mask_out_param);
+    if (arc->mask_in_param_valid)
     {
-        lv_draw_sw_mask_free_param(&mask_in_param);
+        lv_draw_sw_mask_free_param(&arc->mask_in_param);
     }
-
-    lv_free(mask_buf);
-    if (dsc->img_src) lv_image_decoder_close(&decoder_dsc);
-    if (circle_mask) lv_free(circle_mask);
+    if (arc->circle_mask) lv_free(arc->circle_mask);
 }
 
-/**********************
- *   STATIC FUNCTIONS
- **********************/
+static void ring_to_border_dsc(const lv_draw_arc_dsc_t *dsc, lv_draw_border_dsc_t *cir_dsc)
+{
+    lv_draw_border_dsc_init(cir_dsc);
+    cir_dsc->opa = dsc->opa;
+    cir_dsc->color = dsc->color;
+    cir_dsc->width = LV_MIN(dsc->width, dsc->radius);
+    cir_dsc->radius = LV_RADIUS_CIRCLE;
+    cir_dsc->side = LV_BORDER_SIDE_FULL;
+}
 
 static void add_circle(const lv_opa_t *circle_mask, const lv_area_t *blend_area, const lv_area_t *circle_area,
                        lv_opa_t *mask_buf,  int32_t width)
@@ -52,6 +52,7 @@
 
 #if LV_USE_DRAW_EPIC
 #include "lv_epic_utils.h"
+#include "lv_epic_mask_cache.h"
 
 
 
@@ -83,6 +84,15 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static void get_border_areas(const lv_draw_border_dsc_t *dsc, const lv_area_t *coords, lv_area_t *area_inner,
+                             int32_t *rout, int32_t *rin);
+
+static uint32_t get_corner_areas(const lv_area_t *outer_area, const lv_area_t *inner_area, int32_t rout,
+                                 lv_area_t *core_area, bool *split_hor, lv_area_t *corners);
+
+static void border_mask_key(lv_epic_mask_key_t *key, const lv_area_t *outer_area, const lv_area_t *inner_area,
+                            int32_t rout, int32_t rin, const lv_area_t *corner);
+
 static void draw_border_complex(lv_draw_unit_t *draw_unit, const lv_area_t *outer_area, const lv_area_t *inner_area,
                                 lv_coord_t rout, lv_coord_t rin, lv_color_t color, lv_opa_t opa);
 
@@ -108,22 +118,10 @@ void lv_draw_epic_border(lv_draw_unit_t *draw_unit, const lv_draw_border_dsc_t *
     if (dsc->width == 0) return;
     if (dsc->side == LV_BORDER_SIDE_NONE) return;
 
-    int32_t coords_w = lv_area_get_width(coords);
-    int32_t coords_h = lv_area_get_height(coords);
-    int32_t rout = dsc->radius;
-    int32_t short_side = LV_MIN(coords_w, coords_h);
-    if (rout > short_side >> 1) rout = short_side >> 1;
-
     /*Get the inner area*/
     lv_area_t area_inner;
-    lv_area_copy(&area_inner, coords);
-    area_inner.x1 += ((dsc->side & LV_BORDER_SIDE_LEFT) ? dsc->width : - (dsc->width + rout));
-    area_inner.x2 -= ((dsc->side & LV_BORDER_SIDE_RIGHT) ? dsc->width : - (dsc->width + rout));
-    area_inner.y1 += ((dsc->side & LV_BORDER_SIDE_TOP) ? dsc->width : - (dsc->width + rout));
-    area_inner.y2 -= ((dsc->side & LV_BORDER_SIDE_BOTTOM) ? dsc->width : - (dsc->width + rout));
-
-    lv_coord_t rin = rout - dsc->width;
-    if (rin < 0) rin = 0;
+    int32_t rout, rin;
+    get_border_areas(dsc, coords, &area_inner, &rout, &rin);
 
     if (rout == 0 && rin == 0)
     {
@@ -136,25 +134,163 @@ void lv_draw_epic_border(lv_draw_unit_t *draw_unit, const lv_draw_border_dsc_t *
 
 }
 
+bool lv_draw_epic_border_is_cached(const lv_draw_border_dsc_t *dsc, const lv_area_t *coords)
+{
+    lv_area_t area_inner, core_area;
+    lv_area_t corners[4];
+    lv_epic_mask_key_t key;
+    int32_t rout, rin;
+    bool split_hor;
+
+    get_border_areas(dsc, coords, &area_inner, &rout, &rin);
+    if (rout == 0 && rin == 0)
+        return true;
+    if (0 == get_corner_areas(coords, &area_inner, rout, &core_area, &split_hor, corners))
+        return true;
+
+    /*All corners are drawn together, check the first one*/
+    border_mask_key(&key, coords, &area_inner, rout, rin, &corners[0]);
+    return lv_epic_mask_cache_has(&key);
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
-void draw_border_complex(lv_draw_unit_t *draw_unit, const lv_area_t *outer_area, const lv_area_t *inner_area,
-                         lv_coord_t rout, lv_coord_t rin, lv_color_t color, lv_opa_t opa)
+static void get_border_areas(const lv_draw_border_dsc_t *dsc, const lv_area_t *coords, lv_area_t *area_inner,
+                             int32_t *rout, int32_t *rin)
+{
+    int32_t coords_w = lv_area_get_width(coords);
+    int32_t coords_h = lv_area_get_height(coords);
+    int32_t short_side = LV_MIN(coords_w, coords_h);
+
+    *rout = dsc->radius;
+    if (*rout > short_side >> 1) *rout = short_side >> 1;
+
+    lv_area_copy(area_inner, coords);
+    area_inner->x1 += ((dsc->side & LV_BORDER_SIDE_LEFT) ? dsc->width : - (dsc->width + *rout));
+    area_inner->x2 -= ((dsc->side & LV_BORDER_SIDE_RIGHT) ? dsc->width : - (dsc->width + *rout));
+    area_inner->y1 += ((dsc->side & LV_BORDER_SIDE_TOP) ? dsc->width : - (dsc->width + *rout));
+    area_inner->y2 -= ((dsc->side & LV_BORDER_SIDE_BOTTOM) ? dsc->width : - (dsc->width + *rout));
+
+    *rin = *rout - dsc->width;
+    if (*rin < 0) *rin = 0;
+}
+
+/*
+ * Get the straight parts area and the rounded parts which need mask.
+ * Return the number of areas in 'corners', 4 at most.
+ */
+static uint32_t get_corner_areas(const lv_area_t *outer_area, const lv_area_t *inner_area, int32_t rout,
+                                 lv_area_t *core_area, bool *split_hor, lv_area_t *corners)
+{
+    uint32_t cnt = 0;
+    lv_area_t a;
+
+    /*Calculate the x and y coordinates where the straight parts area is*/
+    core_area->x1 = LV_MAX(outer_area->x1 + rout, inner_area->x1);
+    core_area->x2 = LV_MIN(outer_area->x2 - rout, inner_area->x2);
+    core_area->y1 = LV_MAX(outer_area->y1 + rout, inner_area->y1);
+    core_area->y2 = LV_MIN(outer_area->y2 - rout, inner_area->y2);
+    lv_coord_t core_w = lv_area_get_width(core_area);
+
+    bool top_side = outer_area->y1 <= inner_area->y1;
+    bool bottom_side = outer_area->y2 >= inner_area->y2;
+    bool left_side = outer_area->x1 <= inner_area->x1;
+    bool right_side = outer_area->x2 >= inner_area->x2;
+
+    *split_hor = true;
+    if (left_side && right_side && top_side && bottom_side &&
+            core_w < SPLIT_LIMIT)
+    {
+        *split_hor = false;
+    }
+
+    if (!*split_hor)
+    {
+        /*Left and right corner together if they are close to each other*/
+        lv_coord_t max_h = LV_MAX(rout, inner_area->y1 - outer_area->y1);
+
+        a = *outer_area;
+        a.y2 = outer_area->y1 + max_h - 1;
+        corners[cnt++] = a;
+
+        a.y1 = LV_MAX(outer_area->y2 - max_h + 1, a.y2 + 1);
+        a.y2 = outer_area->y2;
+        if (a.y1 <= a.y2) corners[cnt++] = a;
+
+        return cnt;
+    }
+
+    /*Left corners*/
+    a.x1 = outer_area->x1;
+    a.x2 = core_area->x1 - 1;
+    if (a.x1 <= a.x2)
+    {
+        a.y1 = outer_area->y1;
+        a.y2 = core_area->y1 - 1;
+        if ((left_side || top_side) && (a.y1 <= a.y2)) corners[cnt++] = a;
+
+        a.y1 = core_area->y2 + 1;
+        a.y2 = outer_area->y2;
+        if ((left_side || bottom_side) && (a.y1 <= a.y2)) corners[cnt++] = a;
+    }
+
+    /*Right corners, not overlapping with the left ones*/
+    a.x1 = LV_MAX(core_area->x2 + 1, core_area->x1);
+    a.x2 = outer_area->x2;
+    if (a.x1 <= a.x2)
+    {
+        a.y1 = outer_area->y1;
+        a.y2 = core_area->y1 - 1;
+        if ((right_side || top_side) && (a.y1 <= a.y2)) corners[cnt++] = a;
+
+        a.y1 = core_area->y2 + 1;
+        a.y2 = outer_area->y2;
+        if ((right_side || bottom_side) && (a.y1 <= a.y2)) corners[cnt++] = a;
+    }
+
+    return cnt;
+}
+
+/*Corner shape relative to the outer area, so that moved objects of the same size share the mask*/
+static void border_mask_key(lv_epic_mask_key_t *key, const lv_area_t *outer_area, const lv_area_t *inner_area,
+                            int32_t rout, int32_t rin, const lv_area_t *corner)
+{
+    lv_memzero(key, sizeof(lv_epic_mask_key_t));
+    key->type = LV_EPIC_MASK_BORDER;
+    key->p[0] = rout;
+    key->p[1] = rin;
+    key->p[2] = lv_area_get_width(outer_area);
+    key->p[3] = lv_area_get_height(outer_area);
+    key->p[4] = inner_area->x1 - outer_area->x1;
+    key->p[5] = inner_area->y1 - outer_area->y1;
+    key->p[6] = inner_area->x2 - outer_area->x1;
+    key->p[7] = inner_area->y2 - outer_area->y1;
+    key->p[8] = corner->x1 - outer_area->x1;
+    key->p[9] = corner->y1 - outer_area->y1;
+    key->p[10] = lv_area_get_width(corner);
+    key->p[11] = lv_area_get_height(corner);
+}
+
+static lv_draw_sw_mask_res_t border_mask_row(lv_opa_t *row, int32_t x, int32_t y, int32_t w, void *user_data)
+{
+    return lv_draw_sw_mask_apply((void **)user_data, row, x, y, w);
+}
+
+/*
+ * Straight parts are plain fills. Each rounded part is blended in one EPIC job
+ * with its whole A8 mask, which is cached for the next frames.
+ */
+static void draw_border_complex(lv_draw_unit_t *draw_unit, const lv_area_t *outer_area, const lv_area_t *inner_area,
+                                lv_coord_t rout, lv_coord_t rin, lv_color_t color, lv_opa_t opa)
 {
 #if LV_DRAW_SW_COMPLEX
-    /*Get clipped draw area which is the real draw area.
-     *It is always the same or inside `coords`*/
     lv_area_t draw_area;
     if (!lv_area_intersect(&draw_area, outer_area, draw_unit->clip_area)) return;
-    int32_t draw_area_w = lv_area_get_width(&draw_area);
 
     lv_draw_sw_blend_dsc_t blend_dsc;
     lv_memzero(&blend_dsc, sizeof(blend_dsc));
-    lv_opa_t *mask_buf = lv_malloc(draw_area_w);
-    blend_dsc.mask_buf = mask_buf;
-
 
     void *mask_list[3] = {0};
 
@@ -172,37 +308,21 @@ void draw_border_complex(lv_draw_unit_t *draw_unit, const lv_area_t *outer_area,
         mask_list[1] = &mask_rout_param;
     }
 
-    int32_t h;
     lv_area_t blend_area;
     blend_dsc.blend_area = &blend_area;
-    blend_dsc.mask_area = &blend_area;
     blend_dsc.color = color;
     blend_dsc.opa = opa;
 
-    /*Calculate the x and y coordinates where the straight parts area is*/
     lv_area_t core_area;
-    core_area.x1 = LV_MAX(outer_area->x1 + rout, inner_area->x1);
-    core_area.x2 = LV_MIN(outer_area->x2 - rout, inner_area->x2);
-    core_area.y1 = LV_MAX(outer_area->y1 + rout, inner_area->y1);
-    core_area.y2 = LV_MIN(outer_area->y2 - rout, inner_area->y2);
-    lv_coord_t core_w = lv_area_get_width(&core_area);
+    lv_area_t corners[4];
+    bool split_hor;
+    uint32_t corner_cnt = get_corner_areas(outer_area, inner_area, rout, &core_area, &split_hor, corners);
 
     bool top_side = outer_area->y1 <= inner_area->y1;
     bool bottom_side = outer_area->y2 >= inner_area->y2;
-
-    /*No masks*/
     bool left_side = outer_area->x1 <= inner_area->x1;
     bool right_side = outer_area->x2 >= inner_area->x2;
 
-    bool split_hor = true;
-    if (left_side && right_side && top_side && bottom_side &&
-            core_w < SPLIT_LIMIT)
-    {
-        split_hor = false;
-    }
-
-
-    blend_dsc.mask_res = LV_DRAW_SW_MASK_RES_FULL_COVER;
     /*Draw the straight lines first if they are long enough*/
     if (top_side && split_hor)
     {
@@ -253,114 +373,16 @@ void draw_border_complex(lv_draw_unit_t *draw_unit, const lv_area_t *outer_area,
     }
 
     /*Draw the corners*/
-    lv_coord_t blend_w;
-
-    /*Left and right corner together if they are close to each other*/
-    if (!split_hor)
-    {
-        /*Calculate the top corner and mirror it to the bottom*/
-        blend_area.x1 = draw_area.x1;
-        blend_area.x2 = draw_area.x2;
-        lv_coord_t max_h = LV_MAX(rout, inner_area->y1 - outer_area->y1);
-        for (h = 0; h < max_h; h++)
-        {
-            lv_coord_t top_y = outer_area->y1 + h;
-            lv_coord_t bottom_y = outer_area->y2 - h;
-            if (top_y < draw_area.y1 && bottom_y > draw_area.y2) continue;  /*This line is clipped now*/
-
-            lv_memset(mask_buf, 0xff, draw_area_w);
-            blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, top_y, draw_area_w);
-
-            if (top_y >= draw_area.y1)
-            {
-                blend_area.y1 = top_y;
-                blend_area.y2 = top_y;
-                lv_epic_draw_blend(draw_unit, &blend_dsc);
-            }
-
-            if (bottom_y <= draw_area.y2)
-            {
-                blend_area.y1 = bottom_y;
-                blend_area.y2 = bottom_y;
-                lv_epic_draw_blend(draw_unit, &blend_dsc);
-            }
-        }
-    }
-    else
+    for (uint32_t i = 0; i < corner_cnt; i++)
     {
-        /*Left corners*/
-        blend_area.x1 = draw_area.x1;
-        blend_area.x2 = LV_MIN(draw_area.x2, core_area.x1 - 1);
-        blend_w = lv_area_get_width(&blend_area);
-        if (blend_w > 0)
-        {
-            if (left_side || top_side)
-            {
-                for (h = draw_area.y1; h < core_area.y1; h++)
-                {
-                    blend_area.y1 = h;
-                    blend_area.y2 = h;
-
-                    lv_memset(mask_buf, 0xff, blend_w);
-                    blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, h, blend_w);
-                    lv_epic_draw_blend(draw_unit, &blend_dsc);
-                }
-            }
-
-            if (left_side || bottom_side)
-            {
-                for (h = core_area.y2 + 1; h <= draw_area.y2; h++)
-                {
-                    blend_area.y1 = h;
-                    blend_area.y2 = h;
-
-                    lv_memset(mask_buf, 0xff, blend_w);
-                    blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, h, blend_w);
-                    lv_epic_draw_blend(draw_unit, &blend_dsc);
-                }
-            }
-        }
-
-        /*Right corners*/
-        blend_area.x1 = LV_MAX(draw_area.x1, blend_area.x2 + 1);    /*To not overlap with the left side*/
-        blend_area.x1 = LV_MAX(draw_area.x1, core_area.x2 + 1);
-
-        blend_area.x2 = draw_area.x2;
-        blend_w = lv_area_get_width(&blend_area);
+        lv_epic_mask_key_t key;
 
-        if (blend_w > 0)
-        {
-            if (right_side || top_side)
-            {
-                for (h = draw_area.y1; h < core_area.y1; h++)
-                {
-                    blend_area.y1 = h;
-                    blend_area.y2 = h;
-
-                    lv_memset(mask_buf, 0xff, blend_w);
-                    blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, h, blend_w);
-                    lv_epic_draw_blend(draw_unit, &blend_dsc);
-                }
-            }
-
-            if (right_side || bottom_side)
-            {
-                for (h = core_area.y2 + 1; h <= draw_area.y2; h++)
-                {
-                    blend_area.y1 = h;
-                    blend_area.y2 = h;
-
-                    lv_memset(mask_buf, 0xff, blend_w);
-                    blend_dsc.mask_res = lv_draw_sw_mask_apply(mask_list, mask_buf, blend_area.x1, h, blend_w);
-                    lv_epic_draw_blend(draw_unit, &blend_dsc);
-                }
-            }
-        }
+        border_mask_key(&key, outer_area, inner_area, rout, rin, &corners[i]);
+        lv_epic_draw_blend_mask(draw_unit, &blend_dsc, &key, &corners[i], border_mask_row, mask_list);
     }
 
     lv_draw_sw_mask_free_param(&mask_rin_param);
     if (rout > 0) lv_draw_sw_mask_free_param(&mask_rout_param);
-    lv_free(mask_buf);
 
 #endif /*LV_DRAW_SW_COMPLEX*/
 }
@@ -326,6 +326,8 @@ static void _draw_epic_letter(lv_draw_unit_t *draw_unit, lv_draw_glyph_dsc_t *gl
                 blend_dsc.blend_area = glyph_draw_dsc->letter_coords;
                 blend_dsc.mask_res = LV_DRAW_SW_MASK_RES_CHANGED;
 
+                /*EPIC may still be blending previous letter to the same buffer*/
+                drv_epic_cont_blend_reset();
                 lv_draw_sw_blend(draw_unit, &blend_dsc);
             }
             else
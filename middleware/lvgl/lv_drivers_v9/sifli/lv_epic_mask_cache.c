@@ -0,0 +1,320 @@
+/**
+  ******************************************************************************
+  * @file   lv_epic_mask_cache.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lv_draw_epic.h"
+
+#if LV_USE_DRAW_EPIC
+#include "lv_epic_utils.h"
+#include "lv_epic_mask_cache.h"
+
+#include "../../misc/lv_area_private.h"
+#include "lv_draw_sw_mask_private.h"
+#include "blend/lv_draw_sw_blend_private.h"
+#include "../../osal/lv_os.h"
+#include "../../stdlib/lv_mem.h"
+#include "../../stdlib/lv_string.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_OS
+    #define CACHE_LOCK()      lv_mutex_lock(&cache_lock)
+    #define CACHE_UNLOCK()    lv_mutex_unlock(&cache_lock)
+#else
+    #define CACHE_LOCK()
+    #define CACHE_UNLOCK()
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct _lv_epic_mask_entry_t
+{
+    struct _lv_epic_mask_entry_t *next;
+    lv_epic_mask_key_t key;
+    int32_t w;
+    int32_t h;
+    uint32_t size;
+    lv_opa_t data[];
+} lv_epic_mask_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static lv_epic_mask_entry_t *find_entry(const lv_epic_mask_key_t *key, int32_t w, int32_t h, bool to_front);
+static void evict(uint32_t size);
+static bool fill_mask(lv_opa_t *buf, const lv_area_t *area, lv_epic_mask_row_cb_t row_cb, void *user_data);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/*Most recently used first. Only EPIC render thread adds and frees entries, evaluate_cb looks up*/
+static lv_epic_mask_entry_t *cache_head;
+static uint32_t cache_used;
+static uint32_t cache_hit;
+static uint32_t cache_miss;
+#if LV_USE_OS
+    static lv_mutex_t cache_lock;
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_epic_mask_cache_init(void)
+{
+#if LV_USE_OS
+    lv_mutex_init(&cache_lock);
+#endif
+}
+
+void lv_epic_mask_cache_deinit(void)
+{
+    evict(LV_DRAW_EPIC_MASK_CACHE_SIZE);
+#if LV_USE_OS
+    lv_mutex_delete(&cache_lock);
+#endif
+}
+
+bool lv_epic_mask_cache_has(const lv_epic_mask_key_t *key)
+{
+    bool found;
+
+    CACHE_LOCK();
+    found = (NULL != find_entry(key, 0, 0, false));
+    CACHE_UNLOCK();
+
+    return found;
+}
+
+void lv_epic_draw_blend_mask(lv_draw_unit_t *draw_unit, const lv_draw_sw_blend_dsc_t *blend_dsc,
+                             const lv_epic_mask_key_t *key, const lv_area_t *area,
+                             lv_epic_mask_row_cb_t row_cb, void *user_data)
+{
+    lv_area_t clipped;
+    if (!lv_area_intersect(&clipped, area, draw_unit->clip_area)) return;
+
+    lv_draw_sw_blend_dsc_t dsc = *blend_dsc;
+    lv_area_t mask_area;
+    lv_epic_mask_entry_t *entry = NULL;
+    lv_opa_t *tmp = NULL;
+    int32_t w = lv_area_get_width(area);
+    int32_t h = lv_area_get_height(area);
+    uint32_t size = (uint32_t)w * h;
+
+    if (key && size <= LV_DRAW_EPIC_MASK_CACHE_SIZE)
+    {
+        CACHE_LOCK();
+        entry = find_entry(key, w, h, true);
+        CACHE_UNLOCK();
+
+        if (entry)
+        {
+            cache_hit++;
+        }
+        else
+        {
+            cache_miss++;
+            entry = lv_malloc(sizeof(lv_epic_mask_entry_t) + size);
+            if (entry)
+            {
+                fill_mask(entry->data, area, row_cb, user_data);
+                entry->key = *key;
+                entry->w = w;
+                entry->h = h;
+                entry->size = size;
+
+                evict(size);
+                CACHE_LOCK();
+                entry->next = cache_head;
+                cache_head = entry;
+                cache_used += size;
+                CACHE_UNLOCK();
+            }
+        }
+    }
+
+    dsc.mask_res = LV_DRAW_SW_MASK_RES_CHANGED;
+    dsc.mask_area = &mask_area;
+    dsc.blend_area = &mask_area;
+
+    if (entry)
+    {
+        mask_area = *area;
+        dsc.mask_buf = entry->data;
+        lv_epic_draw_blend(draw_unit, &dsc);
+        return;
+    }
+
+    /*Not cached, only the visible part is needed*/
+    mask_area = clipped;
+    tmp = lv_malloc(lv_area_get_size(&clipped));
+    if (tmp)
+    {
+        if (fill_mask(tmp, &clipped, row_cb, user_data))
+        {
+            dsc.mask_buf = tmp;
+            lv_epic_draw_blend(draw_unit, &dsc);
+            drv_epic_wait_done();
+        }
+        lv_free(tmp);
+        return;
+    }
+
+    /*Out of memory, row by row and wait EPIC before reusing the row*/
+    int32_t clipped_w = lv_area_get_width(&clipped);
+    tmp = lv_malloc(clipped_w);
+    if (NULL == tmp)
+    {
+        LV_LOG_WARN("no memory for %d x %d mask", (int)w, (int)h);
+        return;
+    }
+
+    dsc.mask_buf = tmp;
+    for (int32_t y = clipped.y1; y <= clipped.y2; y++)
+    {
+        lv_memset(tmp, 0xff, clipped_w);
+        dsc.mask_res = row_cb(tmp, clipped.x1, y, clipped_w, user_data);
+        if (LV_DRAW_SW_MASK_RES_TRANSP == dsc.mask_res) continue;
+
+        mask_area.y1 = y;
+        mask_area.y2 = y;
+        lv_epic_draw_blend(draw_unit, &dsc);
+        drv_epic_wait_done();
+    }
+    lv_free(tmp);
+}
+
+void lv_epic_mask_cache_get_stat(uint32_t *hit, uint32_t *miss, bool reset)
+{
+    *hit = cache_hit;
+    *miss = cache_miss;
+    if (reset)
+    {
+        cache_hit = 0;
+        cache_miss = 0;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*w == 0 matches any size*/
+static lv_epic_mask_entry_t *find_entry(const lv_epic_mask_key_t *key, int32_t w, int32_t h, bool to_front)
+{
+    lv_epic_mask_entry_t *prev = NULL;
+    lv_epic_mask_entry_t *entry;
+
+    for (entry = cache_head; entry; prev = entry, entry = entry->next)
+    {
+        if ((0 != w) && ((entry->w != w) || (entry->h != h)))
+            continue;
+        if (0 != lv_memcmp(&entry->key, key, sizeof(lv_epic_mask_key_t)))
+            continue;
+
+        if (to_front && prev)
+        {
+            prev->next = entry->next;
+            entry->next = cache_head;
+            cache_head = entry;
+        }
+        return entry;
+    }
+
+    return NULL;
+}
+
+/*Free least recently used entries until 'size' fits*/
+static void evict(uint32_t size)
+{
+    if (cache_used + size <= LV_DRAW_EPIC_MASK_CACHE_SIZE)
+        return;
+
+    /*EPIC may still read the entries*/
+    drv_epic_wait_done();
+
+    CACHE_LOCK();
+    while (cache_head && (cache_used + size > LV_DRAW_EPIC_MASK_CACHE_SIZE))
+    {
+        lv_epic_mask_entry_t **p_last = &cache_head;
+        while ((*p_last)->next)
+            p_last = &(*p_last)->next;
+
+        cache_used -= (*p_last)->size;
+        lv_free(*p_last);
+        *p_last = NULL;
+    }
+    CACHE_UNLOCK();
+}
+
+/*Return false if all transparent*/
+static bool fill_mask(lv_opa_t *buf, const lv_area_t *area, lv_epic_mask_row_cb_t row_cb, void *user_data)
+{
+    int32_t w = lv_area_get_width(area);
+    bool visible = false;
+
+    for (int32_t y = area->y1; y <= area->y2; y++)
+    {
+        lv_memset(buf, 0xff, w);
+        if (LV_DRAW_SW_MASK_RES_TRANSP == row_cb(buf, area->x1, y, w, user_data))
+            lv_memzero(buf, w);
+        else
+            visible = true;
+        buf += w;
+    }
+
+    return visible;
+}
+
+#endif /*LV_USE_DRAW_EPIC*/
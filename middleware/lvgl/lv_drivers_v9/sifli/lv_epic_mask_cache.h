@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file   lv_epic_mask_cache.h
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef LV_EPIC_MASK_CACHE_H
+#define LV_EPIC_MASK_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "../../lv_conf_internal.h"
+
+#if LV_USE_DRAW_EPIC
+#include "lv_draw_sw.h"
+#include "lv_draw_sw_private.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*Total size of cached A8 masks, masks larger than it are generated for the clip area each time*/
+#ifndef LV_DRAW_EPIC_MASK_CACHE_SIZE
+    #define LV_DRAW_EPIC_MASK_CACHE_SIZE  (48 * 1024)
+#endif
+
+#define LV_EPIC_MASK_KEY_PARAMS  12
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+    LV_EPIC_MASK_ARC = 1,
+    LV_EPIC_MASK_BORDER,
+} lv_epic_mask_type_t;
+
+/*Shape of a mask, params must be relative to the mask area so that moved shapes hit the cache*/
+typedef struct
+{
+    int32_t type;
+    int32_t p[LV_EPIC_MASK_KEY_PARAMS];
+} lv_epic_mask_key_t;
+
+/*Apply masks to one row at absolute (x, y), w pixels set to 0xff, return the result like lv_draw_sw_mask_apply()*/
+typedef lv_draw_sw_mask_res_t (*lv_epic_mask_row_cb_t)(lv_opa_t *row, int32_t x, int32_t y, int32_t w,
+                                                       void *user_data);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void lv_epic_mask_cache_init(void);
+
+void lv_epic_mask_cache_deinit(void);
+
+/**
+ * Check if the mask is cached, cheap enough to be called from evaluate_cb
+ * @param key   shape of mask
+ * @return      true if cached
+ */
+bool lv_epic_mask_cache_has(const lv_epic_mask_key_t *key);
+
+/**
+ * Blend with A8 mask of 'area' by EPIC in one job. The mask is taken from the cache,
+ * or generated by 'row_cb' and cached. Masks larger than the cache are generated for
+ * the clipped area only, and row by row if out of memory.
+ * @param draw_unit draw unit
+ * @param blend_dsc color, opa and source image of blending, mask and areas are ignored
+ * @param key       shape of mask, NULL to not cache it
+ * @param area      mask area, absolute coordinates
+ * @param row_cb    mask generator
+ * @param user_data passed to row_cb
+ */
+void lv_epic_draw_blend_mask(lv_draw_unit_t *draw_unit, const lv_draw_sw_blend_dsc_t *blend_dsc,
+                             const lv_epic_mask_key_t *key, const lv_area_t *area,
+                             lv_epic_mask_row_cb_t row_cb, void *user_data);
+
+/**
+ * Get hit and miss counters of mask cache
+ * @param hit   output
+ * @param miss  output
+ * @param reset reset the counters after reading
+ */
+void lv_epic_mask_cache_get_stat(uint32_t *hit, uint32_t *miss, bool reset);
+
+/**********************
+ *      MACROS
+ **********************/
+#endif /*LV_USE_DRAW_EPIC*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_EPIC_MASK_CACHE_H*/
@@ -57,6 +57,7 @@
 #include "../indev/mouse.h"
 #include "../indev/keyboard.h"
 #include "../indev/mousewheel.h"
+#include "lvsf_perf_model.h"
 
 /*********************
  *      DEFINES
@@ -208,6 +209,12 @@ void monitor_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *c
         return;
     }
 
+#ifdef LVSF_PERF_MODEL
+    lvsf_perf_model_lcdc(lv_area_get_size(area));
+    if (lv_disp_flush_is_last(disp_drv))
+        lvsf_perf_model_frame_end(lv_scr_act());
+#endif
+
 #if MONITOR_DOUBLE_BUFFERED
     monitor.tft_fb_act = (uint32_t *)color_p;
 
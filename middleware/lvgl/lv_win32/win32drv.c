@@ -16,6 +16,7 @@
 
 #include "rtconfig.h"
 #include "lvgl.h"
+#include "lvsf_perf_model.h"
 //#include "lvsf.h"
 
 /*********************
@@ -645,8 +646,10 @@ static void lv_win32_display_driver_flush_callback(
     const lv_area_t *area,
     lv_color_t *color_p)
 {
+    LVSF_PERF_MODEL_LCDC(lv_area_get_size(area));
     if (lv_disp_flush_is_last(disp_drv))
     {
+        LVSF_PERF_MODEL_FRAME_END(lv_scr_act());
 #if (LV_COLOR_DEPTH == 32) || \
     (LV_COLOR_DEPTH == 24) || \
     (LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0) || \
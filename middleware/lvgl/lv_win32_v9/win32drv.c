@@ -19,6 +19,7 @@
 #include "lv_obj_private.h"
 #include "lv_textarea_private.h"
 #include "lv_keyboard.h"
+#include "lvsf_perf_model.h"
 
 #pragma comment(lib, "Imm32.lib")
 
@@ -898,8 +899,10 @@ static void lv_windows_display_driver_flush_callback(
         return;
     }
 
+    LVSF_PERF_MODEL_LCDC(lv_area_get_size(area));
     if (lv_display_flush_is_last(disp_drv))
     {
+        LVSF_PERF_MODEL_FRAME_END(lv_screen_active());
 #if (LV_COLOR_DEPTH == 32) || \
     (LV_COLOR_DEPTH == 24) || \
     (LV_COLOR_DEPTH == 16)
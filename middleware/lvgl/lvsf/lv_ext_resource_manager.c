@@ -151,6 +151,148 @@ extern const lv_i18n_lang_t *const lv_i18n_lang_pack[];
 
 static struct lv_ext_res_mng_tag kernel_res_mng;
 
+#ifndef LV_EXT_LOCALE_INDEX_NUM
+    #define LV_EXT_LOCALE_INDEX_NUM     64  /*Must be power of 2*/
+#endif
+
+/*
+    Locale index: open addressing hash table of all locales in enabled lang packs.
+    Adding or enabling a pack inserts its locales, deleting or disabling one marks
+    the index dirty so it's rebuilt on next lookup.
+*/
+typedef struct
+{
+    uint32_t hash;
+    const lv_i18n_lang_t *lang;
+    const lv_lang_pack_node_t *node;
+} lv_ext_locale_index_entry_t;
+
+struct lv_ext_locale_index
+{
+    bool dirty;
+    bool full;
+    uint16_t num;
+    lv_ext_locale_index_entry_t entry[LV_EXT_LOCALE_INDEX_NUM];
+};
+
+static uint32_t locale_hash(const char *locale)
+{
+    uint32_t h = 2166136261u;
+
+    while (*locale)
+    {
+        h ^= (uint8_t) * locale++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+static void locale_index_insert_pack(struct lv_ext_locale_index *index, const lv_lang_pack_node_t *node)
+{
+    const lv_i18n_lang_pack_t *lang;
+    uint32_t hash;
+    uint32_t i;
+
+    for (lang = node->lang_pack; (NULL != lang) && (NULL != *lang); lang++)
+    {
+        if (index->num >= LV_EXT_LOCALE_INDEX_NUM / 2)
+        {
+            /*Keep load factor low, lookup falls back to list walk*/
+            index->full = true;
+            return;
+        }
+
+        hash = locale_hash((*lang)->locale);
+        i = hash & (LV_EXT_LOCALE_INDEX_NUM - 1);
+        while (index->entry[i].lang)
+        {
+            i = (i + 1) & (LV_EXT_LOCALE_INDEX_NUM - 1);
+        }
+        index->entry[i].hash = hash;
+        index->entry[i].lang = *lang;
+        index->entry[i].node = node;
+        index->num++;
+    }
+}
+
+static void locale_index_rebuild(lv_ext_res_mng_t res_mng)
+{
+    struct lv_ext_locale_index *index = res_mng->locale_index;
+    lv_lang_pack_node_t *node;
+
+    memset(index, 0, sizeof(*index));
+    _LV_LL_READ(&(res_mng->lang_pack_list), node)
+    {
+        if (!node->disabled)
+        {
+            locale_index_insert_pack(index, node);
+        }
+    }
+}
+
+static bool locale_index_find(lv_ext_res_mng_t res_mng, const char *locale,
+                              const lv_i18n_lang_t **lang, const lv_lang_pack_node_t **node)
+{
+    struct lv_ext_locale_index *index = res_mng->locale_index;
+    uint32_t hash;
+    uint32_t i;
+
+    if (!index)
+    {
+        index = lv_mem_alloc(sizeof(*index));
+        if (!index)
+        {
+            return false;
+        }
+        res_mng->locale_index = index;
+        index->dirty = true;
+    }
+
+    if (index->dirty)
+    {
+        locale_index_rebuild(res_mng);
+    }
+
+    if (index->full)
+    {
+        return false;
+    }
+
+    hash = locale_hash(locale);
+    i = hash & (LV_EXT_LOCALE_INDEX_NUM - 1);
+    while (index->entry[i].lang)
+    {
+        if ((index->entry[i].hash == hash) && (0 == strcmp(index->entry[i].lang->locale, locale)))
+        {
+            *lang = index->entry[i].lang;
+            *node = index->entry[i].node;
+            return true;
+        }
+        i = (i + 1) & (LV_EXT_LOCALE_INDEX_NUM - 1);
+    }
+
+    return false;
+}
+
+static void locale_index_pack_added(lv_ext_res_mng_t res_mng, const lv_lang_pack_node_t *node)
+{
+    struct lv_ext_locale_index *index = res_mng->locale_index;
+
+    if (index && !index->dirty && !index->full)
+    {
+        locale_index_insert_pack(index, node);
+    }
+}
+
+static void locale_index_invalidate(lv_ext_res_mng_t res_mng)
+{
+    if (res_mng->locale_index)
+    {
+        res_mng->locale_index->dirty = true;
+    }
+}
+
 
 lv_res_t resource_init(void)
 {
@@ -287,6 +429,19 @@ lv_res_t lv_ext_set_locale(lv_ext_res_mng_t res_mng, const char *locale)
         }
     }
 #else
+    {
+        const lv_i18n_lang_t *lang;
+        const lv_lang_pack_node_t *lang_node;
+
+        if (locale_index_find(res_mng, locale, &lang, &lang_node))
+        {
+            res_mng->curr_lang = lang;
+            res_mng->curr_lang_node = lang_node;
+            return LV_RES_OK;
+        }
+    }
+
+    /* locale with suffix like "en_us.UTF-8" matches by prefix */
     _LV_LL_READ(&(res_mng->lang_pack_list), node)
     {
         if (!node->disabled)
@@ -398,6 +553,8 @@ const lv_lang_pack_node_t *lv_ext_add_lang_pack(lv_ext_res_mng_t res_mng,
     node->lang_pack = lang_pack;
     node->lang_pack_name = lang_pack_name;
 
+    locale_index_pack_added(res_mng, node);
+
     return node;
 }
 
@@ -440,6 +597,7 @@ lv_res_t lv_ext_del_lang_pack(lv_ext_res_mng_t res_mng, const char *lang_pack_na
     }
     _lv_ll_remove(&res_mng->lang_pack_list, iter);
     lv_mem_free(iter);
+    locale_index_invalidate(res_mng);
 
     return LV_RES_OK;
 }
@@ -458,6 +616,7 @@ lv_res_t lv_ext_disable_lang_pack(lv_ext_res_mng_t res_mng,
     }
 
     node->disabled = true;
+    locale_index_invalidate(res_mng);
 
     return LV_RES_OK;
 }
@@ -475,7 +634,11 @@ lv_res_t lv_ext_enable_lang_pack(lv_ext_res_mng_t res_mng,
         return LV_RES_INV;
     }
 
-    node->disabled = false;
+    if (node->disabled)
+    {
+        node->disabled = false;
+        locale_index_pack_added(res_mng, node);
+    }
 
     return LV_RES_OK;
 }
@@ -490,6 +653,12 @@ lv_res_t lv_ext_clear_lang_pack(lv_ext_res_mng_t res_mng)
 
     _lv_ll_clear(&res_mng->lang_pack_list);
 
+    if (res_mng->locale_index)
+    {
+        lv_mem_free(res_mng->locale_index);
+        res_mng->locale_index = NULL;
+    }
+
     return LV_RES_OK;
 }
 
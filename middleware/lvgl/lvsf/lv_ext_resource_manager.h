@@ -129,6 +129,8 @@ struct lv_ext_res_mng_tag
     const lv_i18n_lang_t *curr_lang;
     const lv_lang_pack_node_t *curr_lang_node;
     lv_ll_t lang_pack_list;
+    /** locale hash index of enabled lang packs, built on first lv_ext_set_locale */
+    struct lv_ext_locale_index *locale_index;
 
     lv_res_t (*load)(lv_ext_res_mng_t res_mng);
     lv_img_dsc_t *(*get_img)(lv_ext_res_mng_t res_mng, const char *key);
@@ -270,12 +272,19 @@ typedef const char *lv_ext_str_id_t;
 
 
 #include "sf_type.h"
+#ifdef LV_USING_RES_BUNDLE
+    #include "lv_res_bundle.h"
+#endif
 
 #ifndef SOLUTION_WATCH
     #define RES_PATH    "/ex/resource/"
     #define RES_SUFFIX  ".bin"
 
-    #ifdef LV_USING_FILE_RESOURCE
+    #if defined(LV_USING_RES_BUNDLE) && defined(LV_USING_FILE_RESOURCE)
+        #define LV_EXT_IMG_GET(key) lv_res_bundle_img_src(STRINGIFY(key), RES_PATH STRINGIFY(key) RES_SUFFIX)
+    #elif defined(LV_USING_RES_BUNDLE)
+        #define LV_EXT_IMG_GET(key) lv_res_bundle_img_src(STRINGIFY(key), (const void *)&key)
+    #elif defined(LV_USING_FILE_RESOURCE)
         #define LV_EXT_IMG_GET(key) (RES_PATH STRINGIFY(key) RES_SUFFIX)
     #else
         #define LV_EXT_IMG_GET(key) (const void *)&key
@@ -28,6 +28,17 @@
 #include "lv_freetype.h"
 #include "lvsf_ft_reg.h"
 #include "lvsf_font.h"
+#include "lvsf_perf.h"
+#include "lv_ext_resource_manager.h"
+#ifdef LV_USING_RES_BUNDLE
+    #include "lv_res_bundle.h"
+#endif
+#if !defined(_MSC_VER)
+    #include "bf0_hal.h"
+#endif
+#ifdef RT_USING_DFS
+    #include <dfs_posix.h>
+#endif /* RT_USING_DFS */
 
 FT_Library library;
 static uint16_t g_bpp = FT_BPP;
@@ -46,6 +57,16 @@ static FTC_SBit sbit;
 static uint32_t freetype_cache_size = 0;
 
 extern void FTC_Manager_Cache_Free(FTC_Manager  manager, unsigned int max_weight);
+extern FT_Offset FTC_Manager_Get_Weight(FTC_Manager  manager);
+
+/*
+    Sbit cache lookups which loaded a glyph, i.e. manager weight changed, are
+    misses. Their latency (outline load + hint + render) is accumulated in us,
+    shown by "ft_stat" and in perf_cfg cache.
+*/
+static lvsf_perf_cache_t ft_sbit_perf = {.name = "ft_sbit"};
+static uint32_t ft_miss_us;
+static uint32_t ft_miss_max_us;
 
 /**********************
  *      MACROS
@@ -345,6 +366,285 @@ static void sft_cache_dump_all()
 }
 #endif
 
+/*
+    Persistent glyph store, the second level below FreeType's own LRU
+    (FTC sbit cache). Rasterized small glyphs (size <= g_cache_max_font_size,
+    non latin) are appended to an arena in PSRAM, and the arena is written to
+    LV_FT_GLYPH_STORE_FILE, so warm boots find common glyphs without FreeType.
+    Arena stops growing when full, "ft_glyph drop" deletes the file so the
+    store restarts empty on next boot.
+*/
+#if defined(RT_USING_DFS) && defined(BSP_USING_PSRAM)
+    #ifndef LV_FT_GLYPH_STORE_SIZE
+        #define LV_FT_GLYPH_STORE_SIZE      (64 * 1024)
+    #endif
+#else
+    #undef LV_FT_GLYPH_STORE_SIZE
+    #define LV_FT_GLYPH_STORE_SIZE          0
+#endif
+
+#if LV_FT_GLYPH_STORE_SIZE > 0
+#include <dfs_posix.h>
+
+#ifndef LV_FT_GLYPH_STORE_FILE
+    #define LV_FT_GLYPH_STORE_FILE          "/ft_glyph.bin"
+#endif
+#ifndef LV_FT_GLYPH_STORE_INDEX_NUM
+    #define LV_FT_GLYPH_STORE_INDEX_NUM     2048    /*Must be power of 2*/
+#endif
+/*Save when so many glyphs were added since last save*/
+#ifndef LV_FT_GLYPH_STORE_SAVE_NUM
+    #define LV_FT_GLYPH_STORE_SAVE_NUM      64
+#endif
+
+#if __has_include("app_mem.h")
+    #include "app_mem.h"
+    #define FT_STORE_ALLOC(size)    app_cache_alloc(size, IMAGE_CACHE_PSRAM)
+    #define FT_STORE_FREE(p)        app_cache_free(p)
+#else
+    #define FT_STORE_ALLOC(size)    rt_malloc(size)
+    #define FT_STORE_FREE(p)        rt_free(p)
+#endif
+
+#define FT_STORE_MAGIC      0x43475446  /*"FTGC"*/
+#define FT_STORE_VERSION    1
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bpp;
+    uint32_t used;      /*Bytes of records following*/
+} ft_store_hdr_t;
+
+typedef struct
+{
+    uint32_t face_id;
+    uint32_t unicode;
+    uint16_t font_size;
+    uint16_t data_size;
+    uint16_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t  ofs_x;
+    int16_t  ofs_y;
+    uint16_t reserved;
+    /*data_size bytes of bitmap, record is 4 bytes aligned*/
+} ft_store_rec_t;
+
+typedef struct
+{
+    uint8_t *arena;
+    uint32_t used;
+    uint32_t saved;
+    uint16_t unsaved_num;
+    bool save_pending;
+    uint16_t index[LV_FT_GLYPH_STORE_INDEX_NUM];    /*Record offset / 4 + 1, 0: empty*/
+} ft_store_t;
+
+static ft_store_t *ft_store;
+static lvsf_perf_cache_t ft_store_perf = {.name = "ft_glyph"};
+
+static uint32_t ft_store_face_id(FT_Face face)
+{
+    uint32_t h = 5381 + (uint32_t)face->num_glyphs;
+    const char *s;
+
+    for (s = face->family_name; s && *s; s++)
+        h = (h << 5) + h + (uint8_t) * s;
+    for (s = face->style_name; s && *s; s++)
+        h = (h << 5) + h + (uint8_t) * s;
+
+    return h;
+}
+
+static inline uint32_t ft_store_slot(uint32_t face_id, uint16_t font_size, uint32_t unicode)
+{
+    uint32_t h = (face_id ^ (font_size << 21) ^ unicode) * 2654435761u;
+
+    return (h >> 16) & (LV_FT_GLYPH_STORE_INDEX_NUM - 1);
+}
+
+static bool ft_store_index_add(ft_store_t *store, uint32_t offset)
+{
+    ft_store_rec_t *rec = (ft_store_rec_t *)(store->arena + offset);
+    uint32_t i = ft_store_slot(rec->face_id, rec->font_size, rec->unicode);
+    uint32_t n;
+
+    for (n = 0; n < LV_FT_GLYPH_STORE_INDEX_NUM / 2; n++)
+    {
+        if (0 == store->index[i])
+        {
+            store->index[i] = (uint16_t)(offset / 4 + 1);
+            return true;
+        }
+        i = (i + 1) & (LV_FT_GLYPH_STORE_INDEX_NUM - 1);
+    }
+
+    return false;
+}
+
+static ft_store_rec_t *ft_store_find(uint32_t face_id, uint16_t font_size, uint32_t unicode)
+{
+    uint32_t i = ft_store_slot(face_id, font_size, unicode);
+    uint32_t n;
+    ft_store_rec_t *rec;
+
+    for (n = 0; (n < LV_FT_GLYPH_STORE_INDEX_NUM / 2) && ft_store->index[i]; n++)
+    {
+        rec = (ft_store_rec_t *)(ft_store->arena + (ft_store->index[i] - 1) * 4);
+        if ((rec->unicode == unicode) && (rec->face_id == face_id) && (rec->font_size == font_size))
+            return rec;
+        i = (i + 1) & (LV_FT_GLYPH_STORE_INDEX_NUM - 1);
+    }
+
+    return NULL;
+}
+
+static void ft_store_load(ft_store_t *store)
+{
+    ft_store_hdr_t hdr;
+    ft_store_rec_t *rec;
+    uint32_t offset;
+    int fd;
+
+    fd = open(LV_FT_GLYPH_STORE_FILE, O_RDONLY);
+    if (fd < 0)
+        return;
+
+    if ((sizeof(hdr) != read(fd, &hdr, sizeof(hdr)))
+            || (FT_STORE_MAGIC != hdr.magic) || (FT_STORE_VERSION != hdr.version)
+            || (g_bpp != hdr.bpp) || (hdr.used > LV_FT_GLYPH_STORE_SIZE)
+            || (hdr.used != read(fd, store->arena, hdr.used)))
+    {
+        close(fd);
+        rt_kprintf("ft_glyph: drop invalid %s\n", LV_FT_GLYPH_STORE_FILE);
+        unlink(LV_FT_GLYPH_STORE_FILE);
+        return;
+    }
+    close(fd);
+
+    for (offset = 0; offset + sizeof(ft_store_rec_t) <= hdr.used;)
+    {
+        rec = (ft_store_rec_t *)(store->arena + offset);
+        if (offset + sizeof(*rec) + rec->data_size > hdr.used)
+            break;
+        if (!ft_store_index_add(store, offset))
+            break;
+        offset += RT_ALIGN(sizeof(*rec) + rec->data_size, 4);
+    }
+
+    store->used = offset;
+    store->saved = offset;
+    rt_kprintf("ft_glyph: load %d bytes\n", offset);
+}
+
+static void ft_store_save(void)
+{
+    ft_store_hdr_t hdr;
+    int fd;
+
+    if (!ft_store || (ft_store->saved == ft_store->used))
+        return;
+
+    fd = open(LV_FT_GLYPH_STORE_FILE, O_WRONLY | O_CREAT);
+    if (fd < 0)
+        return;
+
+    hdr.magic = FT_STORE_MAGIC;
+    hdr.version = FT_STORE_VERSION;
+    hdr.bpp = g_bpp;
+    hdr.used = ft_store->used;
+
+    /*Append new records, then commit them by header*/
+    if ((sizeof(hdr) + ft_store->saved == lseek(fd, sizeof(hdr) + ft_store->saved, SEEK_SET))
+            && (ft_store->used - ft_store->saved == write(fd, ft_store->arena + ft_store->saved, ft_store->used - ft_store->saved))
+            && (0 == lseek(fd, 0, SEEK_SET))
+            && (sizeof(hdr) == write(fd, &hdr, sizeof(hdr))))
+    {
+        ft_store->saved = ft_store->used;
+        ft_store->unsaved_num = 0;
+    }
+    close(fd);
+}
+
+static void ft_store_save_async(void *param)
+{
+    ft_store_save();
+    if (ft_store)
+        ft_store->save_pending = false;
+}
+
+static void ft_store_add(uint32_t face_id, uint16_t font_size, uint32_t unicode,
+                         const lv_font_glyph_dsc_t *dsc_out, const uint8_t *data, uint32_t data_size)
+{
+    ft_store_rec_t *rec;
+    uint32_t size = RT_ALIGN(sizeof(*rec) + data_size, 4);
+
+    if ((ft_store->used + size > LV_FT_GLYPH_STORE_SIZE) || (data_size > UINT16_MAX))
+        return;
+
+    rec = (ft_store_rec_t *)(ft_store->arena + ft_store->used);
+    rec->face_id = face_id;
+    rec->unicode = unicode;
+    rec->font_size = font_size;
+    rec->data_size = (uint16_t)data_size;
+    rec->adv_w = dsc_out->adv_w;
+    rec->box_w = dsc_out->box_w;
+    rec->box_h = dsc_out->box_h;
+    rec->ofs_x = dsc_out->ofs_x;
+    rec->ofs_y = dsc_out->ofs_y;
+    rec->reserved = 0;
+    memcpy(&rec[1], data, data_size);
+
+    if (!ft_store_index_add(ft_store, ft_store->used))
+        return;
+    ft_store->used += size;
+
+    if ((++ft_store->unsaved_num >= LV_FT_GLYPH_STORE_SAVE_NUM) && !ft_store->save_pending)
+    {
+        /*Write file after current refresh*/
+        ft_store->save_pending = true;
+        lv_async_call(ft_store_save_async, NULL);
+    }
+}
+
+static void ft_store_open(void)
+{
+    if (ft_store)
+        return;
+
+    ft_store = rt_malloc(sizeof(ft_store_t));
+    if (!ft_store)
+        return;
+    memset(ft_store, 0, sizeof(ft_store_t));
+
+    ft_store->arena = FT_STORE_ALLOC(LV_FT_GLYPH_STORE_SIZE);
+    if (!ft_store->arena)
+    {
+        rt_free(ft_store);
+        ft_store = NULL;
+        return;
+    }
+
+    ft_store_load(ft_store);
+    lvsf_perf_cache_register(&ft_store_perf);
+}
+
+static void ft_store_close(void)
+{
+    ft_store_t *store = ft_store;
+
+    if (!store)
+        return;
+
+    ft_store_save();
+    ft_store = NULL;
+    FT_STORE_FREE(store->arena);
+    rt_free(store);
+}
+#endif /* LV_FT_GLYPH_STORE_SIZE > 0 */
+
 static FT_Error  font_Face_Requester(FTC_FaceID  face_id,
                                      FT_Library  library,
                                      FT_Pointer  req_data,
@@ -373,6 +673,31 @@ static bool get_glyph_dsc_cache_cb(const lv_font_t *font, lv_font_glyph_dsc_t *d
     lv_freetype_font_fmt_dsc_t *dsc = (lv_freetype_font_fmt_dsc_t *)(font->user_data);
     face = dsc->face;
 
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    bool store_miss = false;
+
+    dsc->buf = NULL;
+    if (ft_store && dsc->font_size <= g_cache_max_font_size && unicode_letter > 0xff)
+    {
+        ft_store_rec_t *rec = ft_store_find(dsc->face_id, dsc->font_size, unicode_letter);
+
+        if (rec)
+        {
+            dsc_out->adv_w = rec->adv_w;
+            dsc_out->box_h = rec->box_h;
+            dsc_out->box_w = rec->box_w;
+            dsc_out->ofs_x = rec->ofs_x;
+            dsc_out->ofs_y = rec->ofs_y;
+            dsc_out->bpp = FT_BPP;
+            dsc->buf = (uint8_t *)&rec[1];
+            LVSF_PERF_CACHE_HIT(&ft_store_perf);
+            return true;
+        }
+        LVSF_PERF_CACHE_MISS(&ft_store_perf);
+        store_miss = true;
+    }
+#endif
+
 #if 0//def FREETYPE_EXTERN_CACHE_AGAIN
     sft_hash_key_t key;
     if (g_extern_cache && dsc->font_size <= g_cache_max_font_size && unicode_letter > 0xff)
@@ -412,7 +737,25 @@ static bool get_glyph_dsc_cache_cb(const lv_font_t *font, lv_font_glyph_dsc_t *d
     charmap_index = FT_Get_Charmap_Index(face->charmap);
     glyph_index = FTC_CMapCache_Lookup(cmap_cache, face, charmap_index, unicode_letter);
     if (0 == glyph_index) return false;
+
+    FT_Offset weight = FTC_Manager_Get_Weight(cache_manager);
+#if !defined(_MSC_VER)
+    uint32_t start = HAL_GTIMER_READ();
+#endif
     FTC_SBitCache_Lookup(sbit_cache, &desc_sbit_type, glyph_index, &sbit, NULL);
+    if (weight == FTC_Manager_Get_Weight(cache_manager))
+    {
+        LVSF_PERF_CACHE_HIT(&ft_sbit_perf);
+    }
+    else
+    {
+        LVSF_PERF_CACHE_MISS(&ft_sbit_perf);
+#if !defined(_MSC_VER)
+        uint32_t us = (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+        ft_miss_us += us;
+        if (us > ft_miss_max_us) ft_miss_max_us = us;
+#endif
+    }
 
     dsc_out->adv_w = sbit->xadvance;
     dsc_out->box_h = sbit->height;          /*Height of the bitmap in [px]*/
@@ -427,6 +770,16 @@ static bool get_glyph_dsc_cache_cb(const lv_font_t *font, lv_font_glyph_dsc_t *d
 
     //if((dsc_out->box_h == 0) && (dsc_out->box_w == 0)) return false;
 
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    if (store_miss && sbit->buffer)
+    {
+        int pitch = (sbit->pitch < 0) ? -sbit->pitch : sbit->pitch;
+
+        ft_store_add(dsc->face_id, dsc->font_size, unicode_letter, dsc_out,
+                     sbit->buffer, pitch * sbit->height);
+    }
+#endif
+
 #if 0//def FREETYPE_EXTERN_CACHE_AGAIN
     if (g_extern_cache && dsc->font_size <= g_cache_max_font_size && unicode_letter > 0xff)
     {
@@ -462,6 +815,11 @@ static bool get_glyph_dsc_cache_cb(const lv_font_t *font, lv_font_glyph_dsc_t *d
     static const uint8_t *get_glyph_bitmap_cache_cb(const struct _lv_font_t *font, lv_font_glyph_dsc_t *desc, uint32_t unicode_letter, uint8_t *param)
 #endif
 {
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    lv_freetype_font_fmt_dsc_t *store_dsc = (lv_freetype_font_fmt_dsc_t *)(font->user_data);
+    if (store_dsc->buf) return (const uint8_t *)store_dsc->buf;
+#endif
+
 #if 0//def FREETYPE_EXTERN_CACHE_AGAIN
     if (g_extern_cache)
     {
@@ -532,6 +890,138 @@ static const uint8_t *get_glyph_bitmap_cb(const lv_font_t *font, uint32_t unicod
     return (const uint8_t *)(dsc->buf);
 #endif
 }
+
+/*
+    Preload worker, renders most frequent glyphs of current locale into FTC
+    sbit cache (and persistent glyph store) in GUI thread after fonts are opened,
+    LV_FT_PRELOAD_PER_TICK glyphs per timer period so that startup UI is not blocked.
+    Only font sizes <= g_cache_max_font_size are preloaded.
+*/
+#ifndef LV_FT_PRELOAD_NUM
+    #define LV_FT_PRELOAD_NUM           128     /*Max glyphs per font size, 0: disable*/
+#endif
+#ifndef LV_FT_PRELOAD_PER_TICK
+    #define LV_FT_PRELOAD_PER_TICK      8
+#endif
+#ifndef LV_FT_PRELOAD_PERIOD
+    #define LV_FT_PRELOAD_PERIOD        20      /*ms*/
+#endif
+
+#if LV_FT_PRELOAD_NUM > 0
+/*Most frequent characters of modern Chinese text, in order*/
+static const char ft_preload_zh[] =
+    "的一是不了在人有我他这个们中来上大为和国地到以说时要就出会可也你对生能而子那得于着下自之"
+    "年过发后作里用道行所然家种事成方多经么去法学如都同现当没动面起看定天分还进好小部其些主样"
+    "理心她本前开但因只从想实日军者意无力它与长把机十民第公此已工使情明性知全三又关点正业外将"
+    "两高间由问很最重并物手应战向头文体政美相见被利什二等产或新己制身果加西斯月话合回特代内信"
+    "表化老给世位次度门任常先海通教儿原东声提立及比员解水名真论处走义各入几口认条平系气题活尔";
+/*Latin glyphs, digits first as they are on most watch faces*/
+static const char ft_preload_latin[] =
+    "0123456789:.%-/ abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ,!?'()";
+
+static const uint16_t ft_preload_sizes[] = {FONT_SMALL, FONT_NORMAL, FONT_SUBTITLE, FONT_TITLE};
+
+static struct
+{
+    lv_timer_t *timer;
+    const char *text;
+    uint32_t pos;
+    uint16_t count;         /*Glyphs preloaded of current size*/
+    uint8_t size_idx;
+    uint32_t glyphs;
+    uint32_t start_tick;
+} ft_preload;
+
+static uint32_t ft_utf8_next(const char *txt, uint32_t *i)
+{
+    const uint8_t *p = (const uint8_t *)txt + *i;
+    uint32_t u;
+    uint32_t n;
+
+    if (p[0] < 0x80)
+    {
+        u = p[0];
+        n = 1;
+    }
+    else if ((p[0] & 0xE0) == 0xC0)
+    {
+        u = ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+        n = 2;
+    }
+    else if ((p[0] & 0xF0) == 0xE0)
+    {
+        u = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        n = 3;
+    }
+    else
+    {
+        u = ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        n = 4;
+    }
+    *i += n;
+
+    return u;
+}
+
+static void ft_preload_stop(void)
+{
+    if (ft_preload.timer)
+    {
+        lv_timer_del(ft_preload.timer);
+        ft_preload.timer = NULL;
+        rt_kprintf("ft_preload: %d glyphs in %dms, sbit hit %d miss %d\n", ft_preload.glyphs,
+                   lv_tick_elaps(ft_preload.start_tick), ft_sbit_perf.hit, ft_sbit_perf.miss);
+    }
+}
+
+static void ft_preload_cb(lv_timer_t *timer)
+{
+    lv_font_glyph_dsc_t glyph;
+    const lv_font_t *font;
+    uint32_t n;
+
+    for (n = 0; n < LV_FT_PRELOAD_PER_TICK; n++)
+    {
+        if (0 == ft_preload.text[ft_preload.pos] || ft_preload.count >= LV_FT_PRELOAD_NUM)
+        {
+            ft_preload.pos = 0;
+            ft_preload.count = 0;
+            ft_preload.size_idx++;
+        }
+        while (ft_preload.size_idx < sizeof(ft_preload_sizes) / sizeof(ft_preload_sizes[0])
+                && ft_preload_sizes[ft_preload.size_idx] > g_cache_max_font_size)
+        {
+            ft_preload.size_idx++;
+        }
+        if (ft_preload.size_idx >= sizeof(ft_preload_sizes) / sizeof(ft_preload_sizes[0]))
+        {
+            ft_preload_stop();
+            return;
+        }
+
+        font = lvsf_get_font_from_size(ft_preload_sizes[ft_preload.size_idx]);
+        if (font)
+            lv_font_get_glyph_dsc(font, &glyph, ft_utf8_next(ft_preload.text, &ft_preload.pos), 0);
+        else
+            ft_preload.pos += strlen(ft_preload.text + ft_preload.pos);
+        ft_preload.count++;
+        ft_preload.glyphs++;
+    }
+}
+
+static void ft_preload_start(void)
+{
+    const char *locale = lv_ext_get_locale();
+
+    if (ft_preload.timer)
+        return;
+
+    memset(&ft_preload, 0, sizeof(ft_preload));
+    ft_preload.text = (locale && 0 == strncmp(locale, "zh", 2)) ? ft_preload_zh : ft_preload_latin;
+    ft_preload.start_tick = lv_tick_get();
+    ft_preload.timer = lv_timer_create(ft_preload_cb, LV_FT_PRELOAD_PERIOD, NULL);
+}
+#endif /* LV_FT_PRELOAD_NUM > 0 */
 #endif //USE_CACHE_MANGER
 
 /**********************
@@ -623,6 +1113,7 @@ int lv_freetype_font_init(lv_font_t *font, const char *font_lib_addr, int font_l
     if (dsc == NULL) return FT_Err_Out_Of_Memory;
 
     dsc->font_size = font_size;
+    dsc->buf = NULL;
 
     //font_lib_size > 0, for font_lib data
     if (font_lib_size > 0)
@@ -631,7 +1122,27 @@ int lv_freetype_font_init(lv_font_t *font, const char *font_lib_addr, int font_l
     }
     else //font file of file-system
     {
-        error = FT_New_Face(library, (font_lib_addr), 0, &dsc->face);
+        const void *xip = NULL;
+#ifdef RT_USING_DFS
+        struct stat file_stat;
+        int fd;
+
+        /* Font contiguous in XIP flash, e.g. romfs, is used in place rather than read through file */
+        fd = open(font_lib_addr, O_RDONLY);
+        if (fd >= 0)
+        {
+            if (0 == fstat(fd, &file_stat))
+            {
+                font_lib_size = file_stat.st_size;
+                xip = dfs_mmap(fd, 0, font_lib_size);
+            }
+            close(fd);
+        }
+#endif /* RT_USING_DFS */
+        if (xip)
+            error = FT_New_Memory_Face(library, (const FT_Byte *)xip, font_lib_size, 0, &dsc->face);
+        else
+            error = FT_New_Face(library, (font_lib_addr), 0, &dsc->face);
     }
 
     if (error)
@@ -642,6 +1153,10 @@ int lv_freetype_font_init(lv_font_t *font, const char *font_lib_addr, int font_l
 
 
 
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    dsc->face_id = ft_store_face_id(dsc->face);
+#endif
+
     error = FT_Set_Pixel_Sizes(dsc->face, 0, font_size);
     if (error)
     {
@@ -683,13 +1198,33 @@ void lv_freetype_open_font(bool init)
         g_cache_p = sft_cache_init(MAX_UNICODE_CACHED_NUMBER);
         RT_ASSERT(g_cache_p);
     }
+#endif
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    //must called before lvsf_font_inital()-->lv_freetype_font_init()
+    ft_store_open();
+#endif
+#ifdef LV_USING_RES_BUNDLE
+    //must called before lvsf_font_inital() creates faces from font libs
+    lv_res_bundle_bind_fonts();
 #endif
     lvsf_font_inital(ft_get_cache_size(), init);
+#if USE_CACHE_MANGER
+    lvsf_perf_cache_register(&ft_sbit_perf);
+#if LV_FT_PRELOAD_NUM > 0
+    ft_preload_start();
+#endif
+#endif
 }
 
 void lv_freetype_close_font(void)
 {
     rt_kprintf("lv_freetype_close_font\n");
+#if LV_FT_GLYPH_STORE_SIZE > 0
+    ft_store_close();
+#endif
+#if USE_CACHE_MANGER && LV_FT_PRELOAD_NUM > 0
+    ft_preload_stop();
+#endif
     lvsf_font_deinit();
 
 #if USE_CACHE_MANGER
@@ -764,6 +1299,50 @@ int lv_freetype_test(void)
 }
 MSH_CMD_EXPORT_ALIAS(lv_freetype_test, reset_ft, reset_ft: close and re - open freetype test);
 
+#if USE_CACHE_MANGER
+static int ft_stat(int argc, char **argv)
+{
+    uint32_t total = ft_sbit_perf.hit + ft_sbit_perf.miss;
+
+    rt_kprintf("sbit hit=%d miss=%d rate=%d%% weight=%d/%d\n", ft_sbit_perf.hit, ft_sbit_perf.miss,
+               total ? ft_sbit_perf.hit * 100 / total : 0,
+               (uint32_t)FTC_Manager_Get_Weight(cache_manager), ft_get_cache_size());
+    rt_kprintf("miss latency avg=%dus max=%dus\n",
+               ft_sbit_perf.miss ? ft_miss_us / ft_sbit_perf.miss : 0, ft_miss_max_us);
+#if LV_FT_PRELOAD_NUM > 0
+    rt_kprintf("preload %s, %d glyphs\n", ft_preload.timer ? "running" : "done", ft_preload.glyphs);
+#endif
+
+    if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+    {
+        ft_sbit_perf.hit = 0;
+        ft_sbit_perf.miss = 0;
+        ft_miss_us = 0;
+        ft_miss_max_us = 0;
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(ft_stat, ft_stat [reset]: freetype sbit cache hit rate and miss latency);
+#endif
+
+#if LV_FT_GLYPH_STORE_SIZE > 0
+static int ft_glyph(int argc, char **argv)
+{
+    if ((argc > 1) && (0 == strcmp(argv[1], "drop")))
+    {
+        unlink(LV_FT_GLYPH_STORE_FILE);
+    }
+
+    if (ft_store)
+    {
+        rt_kprintf("used=%d/%d saved=%d hit=%d miss=%d\n", ft_store->used, LV_FT_GLYPH_STORE_SIZE,
+                   ft_store->saved, ft_store_perf.hit, ft_store_perf.miss);
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(ft_glyph, ft_glyph [drop]: persistent glyph store state);
+#endif
+
 #endif
 #endif
 
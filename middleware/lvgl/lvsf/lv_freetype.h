@@ -58,6 +58,7 @@ typedef struct
     FT_Face         face;      /* handle to face object */
     uint16_t        font_size;     /*font height size */
     void            *buf;
+    uint32_t        face_id;       /*face hash to key persistent glyph store*/
 } lv_freetype_font_fmt_dsc_t;
 
 /**********************
@@ -0,0 +1,418 @@
+/**
+ * @file lv_layout_bin.c
+ *
+ * Loader of precompiled layout, see lv_layout_bin.h
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <rtthread.h>
+#include <string.h>
+#include "rtconfig.h"
+#include "lvgl.h"
+#include "lvsf.h"
+#include "lv_layout_bin.h"
+#ifdef SOLUTION_WATCH
+    #include "lvsf_wf.h"
+    #include "lvsf_roundbar.h"
+    #include "lvsf_details.h"
+    #include "lvsf_weather.h"
+#endif
+
+#define DBG_TAG "layout_bin"
+#define DBG_LVL DBG_INFO
+#include "rtdbg.h"
+
+#ifdef LV_USING_LAYOUT_BIN
+
+/*********************
+ *      DEFINES
+ *********************/
+#define WF_DIG_IMG_NUM  (10)
+
+#define TYPE_BIT(t)     (1 << LV_LAYOUT_BIN_##t)
+#define TYPE_ALL        (0xFFFF)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef lv_obj_t *(*layout_bin_create_t)(lv_obj_t *parent);
+
+typedef struct
+{
+    uint32_t magic;                         /**< Same as file, tells handle from the one of text loader */
+    const lv_layout_bin_widget_t *widget;
+    const char *pool;
+    uint16_t widget_num;
+    lv_obj_t *obj[];
+} layout_bin_ui_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const layout_bin_create_t create_table[LV_LAYOUT_BIN_TYPE_NUM] =
+{
+    [LV_LAYOUT_BIN_OBJ]       = lv_obj_create,
+    [LV_LAYOUT_BIN_IMAGE]     = lv_img_create,
+    [LV_LAYOUT_BIN_LABEL]     = lv_label_create,
+    [LV_LAYOUT_BIN_ANACLOCK]  = lv_analogclk_create,
+    [LV_LAYOUT_BIN_IDXIMG]    = lv_idximg_create,
+#ifdef SOLUTION_WATCH
+    [LV_LAYOUT_BIN_WATCHFACE] = lv_wf_create,
+    [LV_LAYOUT_BIN_DETAILS]   = lv_details_create,
+    [LV_LAYOUT_BIN_ROUNDBAR]  = lv_roundbar_create,
+    [LV_LAYOUT_BIN_WEATHER]   = lv_weather_create,
+    [LV_LAYOUT_BIN_ICON]      = lv_icon_create,
+#endif /* SOLUTION_WATCH */
+};
+
+/* Widget types a prop can be applied to, setters of widgets don't check type */
+static const uint16_t prop_type_mask[LV_LAYOUT_BIN_PROP_NUM] =
+{
+    [LV_LAYOUT_BIN_PROP_ALIGN]        = TYPE_ALL,
+    [LV_LAYOUT_BIN_PROP_IMG_SRC]      = TYPE_BIT(IMAGE),
+    [LV_LAYOUT_BIN_PROP_TEXT]         = TYPE_BIT(LABEL),
+    [LV_LAYOUT_BIN_PROP_TEXT_COLOR]   = TYPE_BIT(LABEL),
+    [LV_LAYOUT_BIN_PROP_FONT_SIZE]    = TYPE_BIT(LABEL),
+    [LV_LAYOUT_BIN_PROP_HOFF]         = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_MOFF]         = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_SOFF]         = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_BG]           = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_HOUR]         = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_MIN]          = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_SECOND]       = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_INTERVAL]     = TYPE_BIT(ANACLOCK),
+    [LV_LAYOUT_BIN_PROP_DIG_HOUR_IMG] = TYPE_BIT(WATCHFACE),
+    [LV_LAYOUT_BIN_PROP_DIG_MIN_IMG]  = TYPE_BIT(WATCHFACE),
+    [LV_LAYOUT_BIN_PROP_DIG_SEC_IMG]  = TYPE_BIT(WATCHFACE),
+    [LV_LAYOUT_BIN_PROP_DIG_SEP_IMG]  = TYPE_BIT(WATCHFACE),
+    [LV_LAYOUT_BIN_PROP_WF_TYPE]      = TYPE_BIT(WATCHFACE),
+    [LV_LAYOUT_BIN_PROP_BG_COLOR]     = TYPE_BIT(ROUNDBAR),
+    [LV_LAYOUT_BIN_PROP_INDIC_COLOR]  = TYPE_BIT(ROUNDBAR),
+    [LV_LAYOUT_BIN_PROP_LINE_WIDTH]   = TYPE_BIT(ROUNDBAR),
+    [LV_LAYOUT_BIN_PROP_START_ANGLE]  = TYPE_BIT(ROUNDBAR),
+    [LV_LAYOUT_BIN_PROP_END_ANGLE]    = TYPE_BIT(ROUNDBAR),
+    [LV_LAYOUT_BIN_PROP_VALUE]        = TYPE_BIT(ROUNDBAR),
+};
+
+static const lv_align_t align_table[LV_LAYOUT_BIN_ALIGN_NUM] =
+{
+    LV_ALIGN_TOP_LEFT,
+    LV_ALIGN_TOP_MID,
+    LV_ALIGN_TOP_RIGHT,
+    LV_ALIGN_BOTTOM_LEFT,
+    LV_ALIGN_BOTTOM_MID,
+    LV_ALIGN_BOTTOM_RIGHT,
+    LV_ALIGN_LEFT_MID,
+    LV_ALIGN_RIGHT_MID,
+    LV_ALIGN_CENTER,
+    LV_ALIGN_OUT_TOP_LEFT,
+    LV_ALIGN_OUT_TOP_MID,
+    LV_ALIGN_OUT_TOP_RIGHT,
+    LV_ALIGN_OUT_BOTTOM_LEFT,
+    LV_ALIGN_OUT_BOTTOM_MID,
+    LV_ALIGN_OUT_BOTTOM_RIGHT,
+    LV_ALIGN_OUT_LEFT_TOP,
+    LV_ALIGN_OUT_LEFT_MID,
+    LV_ALIGN_OUT_LEFT_BOTTOM,
+    LV_ALIGN_OUT_RIGHT_TOP,
+    LV_ALIGN_OUT_RIGHT_MID,
+    LV_ALIGN_OUT_RIGHT_BOTTOM,
+};
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static inline const char *pool_str(const layout_bin_ui_t *ui, uint32_t offset)
+{
+    return ui->pool + offset;
+}
+
+/* Str list is checked by lv_layout_is_bin, strings are used in place */
+static uint32_t pool_str_list(const layout_bin_ui_t *ui, uint32_t offset, const char *list[], uint32_t max_num)
+{
+    const uint16_t *p = (const uint16_t *)(ui->pool + offset);
+    uint32_t num = p[0];
+    uint32_t i;
+
+    if (num > max_num)
+        num = max_num;
+    for (i = 0; i < num; i++)
+        list[i] = ui->pool + p[1 + i];
+
+    return num;
+}
+
+static bool check_prop(const char *pool, uint32_t size, const lv_layout_bin_prop_t *prop, uint32_t widget_idx)
+{
+    const uint16_t *list;
+    uint32_t i;
+
+    if (prop->id >= LV_LAYOUT_BIN_PROP_NUM)
+        return false;
+
+    switch (prop->id)
+    {
+    case LV_LAYOUT_BIN_PROP_ALIGN:
+        /*Target must be created before*/
+        return (prop->value < LV_LAYOUT_BIN_ALIGN_NUM) && (prop->aux <= widget_idx);
+    case LV_LAYOUT_BIN_PROP_IMG_SRC:
+    case LV_LAYOUT_BIN_PROP_TEXT:
+    case LV_LAYOUT_BIN_PROP_BG:
+    case LV_LAYOUT_BIN_PROP_HOUR:
+    case LV_LAYOUT_BIN_PROP_MIN:
+    case LV_LAYOUT_BIN_PROP_SECOND:
+        return prop->value < size;
+    case LV_LAYOUT_BIN_PROP_DIG_HOUR_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_MIN_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_SEC_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_SEP_IMG:
+        if ((prop->value & 1) || (prop->value + 2 > size))
+            return false;
+        list = (const uint16_t *)(pool + prop->value);
+        if (prop->value + 2 + list[0] * 2 > size)
+            return false;
+        for (i = 0; i < list[0]; i++)
+        {
+            if (list[1 + i] >= size)
+                return false;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+static void apply_prop(layout_bin_ui_t *ui, lv_obj_t *obj, const lv_layout_bin_prop_t *prop)
+{
+    switch (prop->id)
+    {
+    case LV_LAYOUT_BIN_PROP_ALIGN:
+        if (prop->aux && ui->obj[prop->aux - 1])
+            lv_obj_align_to(obj, ui->obj[prop->aux - 1], align_table[prop->value], lv_obj_get_x(obj), lv_obj_get_y(obj));
+        else
+            lv_obj_align(obj, align_table[prop->value], lv_obj_get_x(obj), lv_obj_get_y(obj));
+        break;
+    case LV_LAYOUT_BIN_PROP_IMG_SRC:
+        lv_img_set_src(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_TEXT:
+        /*Pool is kept until layout is freed*/
+        lv_label_set_text_static(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_TEXT_COLOR:
+        lv_obj_set_style_text_color(obj, lv_color_hex(prop->value), LV_PART_MAIN | LV_STATE_DEFAULT);
+        break;
+    case LV_LAYOUT_BIN_PROP_FONT_SIZE:
+        lv_obj_set_style_text_font(obj, LV_EXT_FONT_GET(prop->value), LV_PART_MAIN | LV_STATE_DEFAULT);
+        break;
+    case LV_LAYOUT_BIN_PROP_HOFF:
+        lv_analogclk_set_hoff(obj, prop->value);
+        break;
+    case LV_LAYOUT_BIN_PROP_MOFF:
+        lv_analogclk_set_moff(obj, prop->value);
+        break;
+    case LV_LAYOUT_BIN_PROP_SOFF:
+        lv_analogclk_set_soff(obj, prop->value);
+        break;
+    case LV_LAYOUT_BIN_PROP_BG:
+        lv_analogclk_set_bg(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_HOUR:
+        lv_analogclk_set_hour(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_MIN:
+        lv_analogclk_set_min(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_SECOND:
+        lv_analogclk_set_second(obj, pool_str(ui, prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_INTERVAL:
+        lv_analogclk_refr_inteval(obj, prop->value);
+        break;
+#ifdef SOLUTION_WATCH
+    case LV_LAYOUT_BIN_PROP_DIG_HOUR_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_MIN_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_SEC_IMG:
+    case LV_LAYOUT_BIN_PROP_DIG_SEP_IMG:
+    {
+        const char *img_list[WF_DIG_IMG_NUM];
+        uint32_t img_cnt = pool_str_list(ui, prop->value, img_list, WF_DIG_IMG_NUM);
+
+        if (LV_LAYOUT_BIN_PROP_DIG_HOUR_IMG == prop->id)
+            lv_wf_set_digital_hour_img(obj, (const lv_img_dsc_t **)img_list, img_cnt);
+        else if (LV_LAYOUT_BIN_PROP_DIG_MIN_IMG == prop->id)
+            lv_wf_set_digital_min_img(obj, (const lv_img_dsc_t **)img_list, img_cnt);
+        else if (LV_LAYOUT_BIN_PROP_DIG_SEC_IMG == prop->id)
+            lv_wf_set_digital_sec_img(obj, (const lv_img_dsc_t **)img_list, img_cnt);
+        else if (img_cnt >= 2)
+            lv_wf_set_digital_sep_img(obj, img_list[0], img_list[1]);
+        break;
+    }
+    case LV_LAYOUT_BIN_PROP_WF_TYPE:
+        lv_wf_set_type(obj, WF_TYPE_DIGITAL_IMG);
+        lv_wf_invalidate(obj);
+        lv_wf_refresh_open(obj);
+        break;
+    case LV_LAYOUT_BIN_PROP_BG_COLOR:
+        lv_roundbar_set_bg_color(obj, lv_color_hex(prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_INDIC_COLOR:
+        lv_roundbar_set_indic_color(obj, lv_color_hex(prop->value));
+        break;
+    case LV_LAYOUT_BIN_PROP_LINE_WIDTH:
+        lv_roundbar_set_line_width(obj, (int32_t)prop->value);
+        break;
+    case LV_LAYOUT_BIN_PROP_START_ANGLE:
+    case LV_LAYOUT_BIN_PROP_END_ANGLE:
+    {
+        lv_coord_t start;
+        lv_coord_t end;
+
+        lv_roundbar_get_angle(obj, &start, &end);
+        if (LV_LAYOUT_BIN_PROP_START_ANGLE == prop->id)
+            start = (int32_t)prop->value;
+        else
+            end = (int32_t)prop->value;
+        lv_roundbar_set_angle(obj, start, end);
+        break;
+    }
+    case LV_LAYOUT_BIN_PROP_VALUE:
+        lv_roundbar_set_value(obj, (int32_t)prop->value);
+        break;
+#endif /* SOLUTION_WATCH */
+    default:
+        break;
+    }
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+bool lv_layout_is_bin(const uint8_t *data, uint32_t size)
+{
+    const lv_layout_bin_header_t *hdr = (const lv_layout_bin_header_t *)data;
+    const lv_layout_bin_widget_t *widget;
+    const lv_layout_bin_prop_t *prop;
+    const char *pool;
+    uint32_t i, j;
+
+    if (!data || (size < sizeof(*hdr)) || ((rt_ubase_t)data & 3) || (LV_LAYOUT_BIN_MAGIC != hdr->magic))
+        return false;
+
+    if ((LV_LAYOUT_BIN_VERSION != hdr->version)
+            || (size < sizeof(*hdr) + hdr->widget_num * sizeof(*widget) + hdr->prop_num * sizeof(*prop) + hdr->pool_size))
+    {
+        LOG_W("invalid layout: ver %d, size %d", hdr->version, size);
+        return false;
+    }
+
+    widget = (const lv_layout_bin_widget_t *)(hdr + 1);
+    prop = (const lv_layout_bin_prop_t *)(widget + hdr->widget_num);
+    pool = (const char *)(prop + hdr->prop_num);
+    /*Every offset in pool is a valid string if pool is terminated*/
+    if (hdr->pool_size && pool[hdr->pool_size - 1])
+        return false;
+
+    for (i = 0; i < hdr->widget_num; i++, widget++)
+    {
+        if ((widget->type >= LV_LAYOUT_BIN_TYPE_NUM) || !create_table[widget->type]
+                || (widget->parent >= (int32_t)i) || (widget->parent < LV_LAYOUT_BIN_ROOT)
+                || ((LV_LAYOUT_BIN_NO_STR != widget->name) && (widget->name >= hdr->pool_size))
+                || (widget->prop_idx + widget->prop_num > hdr->prop_num))
+        {
+            LOG_W("invalid widget %d, type %d", i, widget->type);
+            return false;
+        }
+
+        for (j = 0; j < widget->prop_num; j++)
+        {
+            const lv_layout_bin_prop_t *p = &prop[widget->prop_idx + j];
+
+            if (!check_prop(pool, hdr->pool_size, p, i) || !(prop_type_mask[p->id] & (1 << widget->type)))
+            {
+                LOG_W("invalid prop %d of widget %d", p->id, i);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void *lv_load_layout_bin(lv_obj_t *parent, const uint8_t *data, uint32_t size)
+{
+    const lv_layout_bin_header_t *hdr = (const lv_layout_bin_header_t *)data;
+    const lv_layout_bin_widget_t *widget;
+    const lv_layout_bin_prop_t *prop;
+    layout_bin_ui_t *ui;
+    lv_obj_t *obj;
+    uint32_t i, j;
+
+    if (!lv_layout_is_bin(data, size))
+        return NULL;
+
+    ui = rt_malloc(sizeof(*ui) + hdr->widget_num * sizeof(ui->obj[0]));
+    RT_ASSERT(ui);
+
+    widget = (const lv_layout_bin_widget_t *)(hdr + 1);
+    prop = (const lv_layout_bin_prop_t *)(widget + hdr->widget_num);
+    ui->magic = LV_LAYOUT_BIN_MAGIC;
+    ui->widget = widget;
+    ui->pool = (const char *)(prop + hdr->prop_num);
+    ui->widget_num = hdr->widget_num;
+
+    for (i = 0; i < hdr->widget_num; i++, widget++)
+    {
+        obj = create_table[widget->type](widget->parent == LV_LAYOUT_BIN_ROOT ? parent : ui->obj[widget->parent]);
+        ui->obj[i] = obj;
+        if (!obj)
+            continue;
+
+        lv_obj_set_pos(obj, widget->x, widget->y);
+        if (widget->w && widget->h)
+            lv_obj_set_size(obj, widget->w, widget->h);
+        for (j = 0; j < widget->prop_num; j++)
+            apply_prop(ui, obj, &prop[widget->prop_idx + j]);
+    }
+
+    return ui;
+}
+
+void lv_free_layout_bin(void *ui)
+{
+    if (lv_layout_bin_is_ui(ui))
+    {
+        ((layout_bin_ui_t *)ui)->magic = 0;
+        rt_free(ui);
+    }
+}
+
+lv_obj_t *lv_find_obj_in_layout_bin(void *ui, const char *name)
+{
+    layout_bin_ui_t *bin_ui = (layout_bin_ui_t *)ui;
+    uint32_t i;
+
+    if (!lv_layout_bin_is_ui(ui) || !name)
+        return NULL;
+
+    for (i = 0; i < bin_ui->widget_num; i++)
+    {
+        if ((LV_LAYOUT_BIN_NO_STR != bin_ui->widget[i].name)
+                && (0 == strcmp(pool_str(bin_ui, bin_ui->widget[i].name), name)))
+            return bin_ui->obj[i];
+    }
+
+    return NULL;
+}
+
+bool lv_layout_bin_is_ui(void *ui)
+{
+    return ui && (LV_LAYOUT_BIN_MAGIC == ((layout_bin_ui_t *)ui)->magic);
+}
+
+#endif /* LV_USING_LAYOUT_BIN */
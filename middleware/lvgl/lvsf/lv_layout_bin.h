@@ -0,0 +1,190 @@
+#ifndef _LV_LAYOUT_BIN_H_
+#define _LV_LAYOUT_BIN_H_
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include "rtconfig.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+    Precompiled layout, generated by tools/scripts/layout2bin.py from the XML layout.
+    Enums, colors, font sizes and align targets are resolved on host, strings are kept
+    in a deduplicated pool and used in place, so loading needs no parsing or allocation
+    except the object table.
+
+    | header | widget[widget_num] | prop[prop_num] | string pool |
+*/
+#define LV_LAYOUT_BIN_MAGIC         (0x424C564C)    /* "LVLB" */
+#define LV_LAYOUT_BIN_VERSION       (1)
+#define LV_LAYOUT_BIN_NO_STR        (0xFFFF)
+#define LV_LAYOUT_BIN_ROOT          (-1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+    LV_LAYOUT_BIN_OBJ,
+    LV_LAYOUT_BIN_IMAGE,
+    LV_LAYOUT_BIN_LABEL,
+    LV_LAYOUT_BIN_ANACLOCK,
+    LV_LAYOUT_BIN_IDXIMG,
+    LV_LAYOUT_BIN_WATCHFACE,
+    LV_LAYOUT_BIN_DETAILS,
+    LV_LAYOUT_BIN_ROUNDBAR,
+    LV_LAYOUT_BIN_WEATHER,
+    LV_LAYOUT_BIN_ICON,
+    LV_LAYOUT_BIN_TYPE_NUM,
+} lv_layout_bin_type_t;
+
+/** Property id, value kind is given in comment */
+typedef enum
+{
+    LV_LAYOUT_BIN_PROP_ALIGN,           /**< int, index of lv_layout_bin_align_t, aux is target widget index + 1 */
+    LV_LAYOUT_BIN_PROP_IMG_SRC,         /**< str */
+    LV_LAYOUT_BIN_PROP_TEXT,            /**< str */
+    LV_LAYOUT_BIN_PROP_TEXT_COLOR,      /**< color 0xRRGGBB */
+    LV_LAYOUT_BIN_PROP_FONT_SIZE,       /**< int, LVSF_FONT_SIZES */
+    LV_LAYOUT_BIN_PROP_HOFF,            /**< int */
+    LV_LAYOUT_BIN_PROP_MOFF,            /**< int */
+    LV_LAYOUT_BIN_PROP_SOFF,            /**< int */
+    LV_LAYOUT_BIN_PROP_BG,              /**< str */
+    LV_LAYOUT_BIN_PROP_HOUR,            /**< str */
+    LV_LAYOUT_BIN_PROP_MIN,             /**< str */
+    LV_LAYOUT_BIN_PROP_SECOND,          /**< str */
+    LV_LAYOUT_BIN_PROP_INTERVAL,        /**< int, ms */
+    LV_LAYOUT_BIN_PROP_DIG_HOUR_IMG,    /**< str list */
+    LV_LAYOUT_BIN_PROP_DIG_MIN_IMG,     /**< str list */
+    LV_LAYOUT_BIN_PROP_DIG_SEC_IMG,     /**< str list */
+    LV_LAYOUT_BIN_PROP_DIG_SEP_IMG,     /**< str list */
+    LV_LAYOUT_BIN_PROP_WF_TYPE,         /**< int */
+    LV_LAYOUT_BIN_PROP_BG_COLOR,        /**< color 0xRRGGBB */
+    LV_LAYOUT_BIN_PROP_INDIC_COLOR,     /**< color 0xRRGGBB */
+    LV_LAYOUT_BIN_PROP_LINE_WIDTH,      /**< int */
+    LV_LAYOUT_BIN_PROP_START_ANGLE,     /**< int */
+    LV_LAYOUT_BIN_PROP_END_ANGLE,       /**< int */
+    LV_LAYOUT_BIN_PROP_VALUE,           /**< int */
+    LV_LAYOUT_BIN_PROP_NUM,
+} lv_layout_bin_prop_id_t;
+
+/** Align index in file, kept stable even if LVGL changes lv_align_t */
+typedef enum
+{
+    LV_LAYOUT_BIN_ALIGN_TOP_LEFT,
+    LV_LAYOUT_BIN_ALIGN_TOP_MID,
+    LV_LAYOUT_BIN_ALIGN_TOP_RIGHT,
+    LV_LAYOUT_BIN_ALIGN_BOTTOM_LEFT,
+    LV_LAYOUT_BIN_ALIGN_BOTTOM_MID,
+    LV_LAYOUT_BIN_ALIGN_BOTTOM_RIGHT,
+    LV_LAYOUT_BIN_ALIGN_LEFT_MID,
+    LV_LAYOUT_BIN_ALIGN_RIGHT_MID,
+    LV_LAYOUT_BIN_ALIGN_CENTER,
+    LV_LAYOUT_BIN_ALIGN_OUT_TOP_LEFT,
+    LV_LAYOUT_BIN_ALIGN_OUT_TOP_MID,
+    LV_LAYOUT_BIN_ALIGN_OUT_TOP_RIGHT,
+    LV_LAYOUT_BIN_ALIGN_OUT_BOTTOM_LEFT,
+    LV_LAYOUT_BIN_ALIGN_OUT_BOTTOM_MID,
+    LV_LAYOUT_BIN_ALIGN_OUT_BOTTOM_RIGHT,
+    LV_LAYOUT_BIN_ALIGN_OUT_LEFT_TOP,
+    LV_LAYOUT_BIN_ALIGN_OUT_LEFT_MID,
+    LV_LAYOUT_BIN_ALIGN_OUT_LEFT_BOTTOM,
+    LV_LAYOUT_BIN_ALIGN_OUT_RIGHT_TOP,
+    LV_LAYOUT_BIN_ALIGN_OUT_RIGHT_MID,
+    LV_LAYOUT_BIN_ALIGN_OUT_RIGHT_BOTTOM,
+    LV_LAYOUT_BIN_ALIGN_NUM,
+} lv_layout_bin_align_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t widget_num;
+    uint16_t prop_num;
+    uint16_t reserved;
+    uint32_t pool_size;
+} lv_layout_bin_header_t;
+
+typedef struct
+{
+    uint8_t  type;          /**< lv_layout_bin_type_t */
+    uint8_t  prop_num;
+    int16_t  parent;        /**< Index of parent widget, always smaller than own index, LV_LAYOUT_BIN_ROOT for root */
+    int16_t  x;
+    int16_t  y;
+    int16_t  w;             /**< 0: size not set */
+    int16_t  h;
+    uint16_t name;          /**< Offset in string pool, LV_LAYOUT_BIN_NO_STR if no name */
+    uint16_t prop_idx;      /**< First prop */
+} lv_layout_bin_widget_t;
+
+typedef struct
+{
+    uint8_t  id;            /**< lv_layout_bin_prop_id_t */
+    uint8_t  reserved;
+    uint16_t aux;
+    uint32_t value;         /**< int, color or offset in string pool. Str list is {u16 num; u16 offset[num]} in pool */
+} lv_layout_bin_prop_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * @brief Check if data is a precompiled layout
+ * @param data layout data
+ * @param size size of data in bytes
+ * @return true if header is valid
+ */
+bool lv_layout_is_bin(const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Create widgets of precompiled layout, data must be kept until layout is freed
+ * @param parent parent of root widgets
+ * @param data layout data
+ * @param size size of data in bytes
+ * @return layout handle, NULL if data is invalid
+ */
+void *lv_load_layout_bin(lv_obj_t *parent, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Free layout handle, widgets are deleted with their parent
+ * @param ui layout handle
+ */
+void lv_free_layout_bin(void *ui);
+
+/**
+ * @brief Find widget by name
+ * @param ui layout handle
+ * @param name widget name
+ * @return widget, NULL if not found
+ */
+lv_obj_t *lv_find_obj_in_layout_bin(void *ui, const char *name);
+
+/**
+ * @brief Check if handle is returned by lv_load_layout_bin
+ * @param ui layout handle
+ * @return true if it is
+ */
+bool lv_layout_bin_is_ui(void *ui);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*_LV_LAYOUT_BIN_H_*/
@@ -11,15 +11,28 @@
  *********************/
 #include "rtconfig.h"
 #include "lvgl.h"
-#include "widget_factory.h"
+#if defined(PKG_USING_UI_BINARY_LOADER) || defined(PKG_USING_UI_XML_LOADER)
+    #define LAYOUT_TEXT_LOADER
+#endif
+#ifdef LAYOUT_TEXT_LOADER
+    #include "widget_factory.h"
+#endif
 #include "lv_layout_loader.h"
 //#include "app_clock_main.h"
-#include "ui_loader_default.h"
-#include "ui_builder_default.h"
-#include "widget_factory.h"
-#include "widget_consts.h"
-#include "value.h"
-#ifdef SOLUTION_WATCH
+#ifdef LAYOUT_TEXT_LOADER
+    #include "ui_loader_default.h"
+    #include "ui_builder_default.h"
+    #include "widget_factory.h"
+    #include "widget_consts.h"
+    #include "value.h"
+#endif
+#ifdef LV_USING_LAYOUT_BIN
+    #include "lv_layout_bin.h"
+#endif
+#if LVGL_VERSION_MAJOR == 8
+    #include "src/misc/lv_gc.h"
+#endif
+#if defined(SOLUTION_WATCH) && defined(LAYOUT_TEXT_LOADER)
     #include "lvsf_wf.h"
     #include "lvsf_roundbar.h"
     #include "lvsf_details.h"
@@ -31,6 +44,23 @@
  *********************/
 SECTION_DEF(APP_WATCHFACE_LAYOUT_SECTION_NAME, ui_layout_desc_t);
 
+/* Timers and animations paused at the same time */
+#ifndef LV_LAYOUT_PAUSE_REC_NUM
+    #define LV_LAYOUT_PAUSE_REC_NUM     (32)
+#endif
+
+#ifndef LV_LAYOUT_CULL_NUM
+    #define LV_LAYOUT_CULL_NUM          (16)
+#endif
+
+#ifndef LV_LAYOUT_CULL_PERIOD
+    #define LV_LAYOUT_CULL_PERIOD       (100)
+#endif
+
+#ifndef LV_LAYOUT_CULL_MARGIN
+    #define LV_LAYOUT_CULL_MARGIN       (16)
+#endif
+
 
 /**********************
  *      TYPEDEFS
@@ -52,6 +82,7 @@ SECTION_DEF(APP_WATCHFACE_LAYOUT_SECTION_NAME, ui_layout_desc_t);
  *   GLOBAL FUNCTIONS
  **********************/
 
+#ifdef LAYOUT_TEXT_LOADER
 static lv_color_t color_str_2_lv_color(const char *color_val)
 {
     char color_str[3];
@@ -73,6 +104,7 @@ static lv_color_t color_str_2_lv_color(const char *color_val)
 
     return lv_color_make(r, g, b);
 }
+#endif /* LAYOUT_TEXT_LOADER */
 
 
 
@@ -112,6 +144,16 @@ static const ui_layout_desc_t *find_watchface_layout(const char *id)
 
 static lv_obj_t *load_layout(lv_obj_t *parent, const ui_layout_desc_t *layout)
 {
+#ifdef LV_USING_LAYOUT_BIN
+    if (lv_layout_is_bin(layout->data, layout->data_size))
+    {
+        /*Widgets are deleted with parent, only object table is freed*/
+        lv_free_layout_bin(lv_load_layout_bin(parent, layout->data, layout->data_size));
+        return parent;
+    }
+#endif /* LV_USING_LAYOUT_BIN */
+
+#ifdef LAYOUT_TEXT_LOADER
     ui_loader_t *loader = default_ui_loader();
     ui_builder_t *builder = ui_builder_default(layout->id_str);
 
@@ -120,6 +162,10 @@ static lv_obj_t *load_layout(lv_obj_t *parent, const ui_layout_desc_t *layout)
     ui_loader_load(loader, layout->data, layout->data_size, builder);
 
     return builder->root;
+#else
+    LOG_W("layout %s is not precompiled", layout->id_str);
+    return NULL;
+#endif /* LAYOUT_TEXT_LOADER */
 }
 
 
@@ -139,6 +185,9 @@ static rt_int32_t on_init(lv_obj_t *parent)
 
     load_layout(parent, layout);
     screen_obj = parent;
+#ifdef LV_LAYOUT_CULLING
+    lv_layout_cull_add(screen_obj);
+#endif
 
     return RT_EOK;
 }
@@ -159,6 +208,9 @@ static rt_int32_t on_resume(void)
 
 static rt_int32_t on_deinit(void)
 {
+#ifdef LV_LAYOUT_CULLING
+    lv_layout_cull_remove(screen_obj);
+#endif
     screen_obj = NULL;
     return RT_EOK;
 }
@@ -172,7 +224,7 @@ const app_clock_ops_t g_app_watchface_layout_ops =
 
 };
 
-
+#ifdef LAYOUT_TEXT_LOADER
 static lv_res_t lv_analogclk_set_prop(lv_obj_t *obj, widget_prop_t prop_name, const value_t *val, const void *ui)
 {
     lv_res_t res = LV_RES_OK;
@@ -598,37 +650,187 @@ static lv_res_t lv_roundbar_set_prop(lv_obj_t *obj, widget_prop_t prop_name, con
 
 
 #endif
+#endif /* LAYOUT_TEXT_LOADER */
+
+#if LVGL_VERSION_MAJOR == 8
+/*
+    Timers with user_data of widget and animations of widget are paused.
+    Animation is frozen by a long delay and its position is restored on resume.
+*/
+#define PAUSE_ANIM_DELAY   (-0x3FFFFFFF)
+
+typedef struct
+{
+    void *item;                 /**< lv_timer_t or lv_anim_t */
+    lv_obj_t *owner;            /**< Object passed to pause */
+    int32_t act_time;           /**< Animation time before pause */
+    uint32_t pause_tick;
+    uint8_t is_anim;
+    uint8_t by_cull;
+} obj_pause_rec_t;
+
+static obj_pause_rec_t pause_rec[LV_LAYOUT_PAUSE_REC_NUM];
+
+static struct
+{
+    uint32_t timer_skipped;     /**< Timer callbacks not run */
+    uint32_t anim_frozen_ms;
+    uint32_t rec_full;
+} pause_stat;
 
-static void obj_resume_core(lv_obj_t *obj)
+static obj_pause_rec_t *pause_rec_find(const void *item)
 {
-//TODO
-#if 0
-    /*Recursively resume the children*/
-    lv_obj_t *i;
-    lv_obj_t *i_next;
-    i = _lv_ll_get_head(&(obj->child_ll));
-    while (i != NULL)
+    uint32_t i;
+
+    for (i = 0; i < LV_LAYOUT_PAUSE_REC_NUM; i++)
+    {
+        if (pause_rec[i].item == item)
+        {
+            return &pause_rec[i];
+        }
+    }
+    return NULL;
+}
+
+static void pause_rec_add(void *item, lv_obj_t *owner, bool is_anim, bool by_cull)
+{
+    obj_pause_rec_t *rec = pause_rec_find(NULL);
+
+    if (!rec)
+    {
+        pause_stat.rec_full++;
+        return;
+    }
+    rec->item = item;
+    rec->owner = owner;
+    rec->is_anim = is_anim;
+    rec->by_cull = by_cull;
+    rec->pause_tick = lv_tick_get();
+    if (is_anim)
+    {
+        rec->act_time = ((lv_anim_t *)item)->act_time;
+        ((lv_anim_t *)item)->act_time = PAUSE_ANIM_DELAY;
+    }
+    else
     {
-        /*Get the next object before resume this*/
-        i_next = _lv_ll_get_next(&(obj->child_ll), i);
+        lv_timer_pause((lv_timer_t *)item);
+    }
+}
 
-        /*Call the recursive resume to the child too*/
-        obj_resume_core(i);
+static void obj_pause_core(lv_obj_t *owner, lv_obj_t *obj, bool by_cull)
+{
+    lv_timer_t *t;
+    lv_anim_t *a;
+    uint32_t i;
 
-        /*Set i to the next node*/
-        i = i_next;
+    /*Recursively pause the children*/
+    for (i = 0; i < lv_obj_get_child_cnt(obj); i++)
+    {
+        obj_pause_core(owner, lv_obj_get_child(obj, i), by_cull);
     }
 
-    /* All children paused.
-     * Now resume the object specific data*/
-    obj->signal_cb(obj, LV_SIGNAL_RESUME, NULL);
-#endif
+    for (t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t))
+    {
+        if ((t->user_data == obj) && !t->paused)
+        {
+            pause_rec_add(t, owner, false, by_cull);
+        }
+    }
+
+    a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+    while (a)
+    {
+        if ((a->var == obj) && !pause_rec_find(a))
+        {
+            pause_rec_add(a, owner, true, by_cull);
+        }
+        a = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
+    }
+}
+
+static bool timer_exist(const lv_timer_t *timer)
+{
+    lv_timer_t *t;
+
+    for (t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t))
+    {
+        if (t == timer)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool anim_exist(const lv_anim_t *anim)
+{
+    lv_anim_t *a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+
+    while (a)
+    {
+        if (a == anim)
+        {
+            return true;
+        }
+        a = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
+    }
+    return false;
 }
 
+static void obj_resume_core(lv_obj_t *owner, bool by_cull)
+{
+    obj_pause_rec_t *rec;
+    uint32_t elaps;
+    uint32_t i;
+
+    for (i = 0; i < LV_LAYOUT_PAUSE_REC_NUM; i++)
+    {
+        rec = &pause_rec[i];
+        if (!rec->item || (rec->owner != owner) || (rec->by_cull != by_cull))
+        {
+            continue;
+        }
+
+        /*Timer or animation may be deleted by widget meanwhile*/
+        elaps = lv_tick_elaps(rec->pause_tick);
+        if (rec->is_anim)
+        {
+            if (anim_exist(rec->item))
+            {
+                ((lv_anim_t *)rec->item)->act_time = rec->act_time;
+                pause_stat.anim_frozen_ms += elaps;
+            }
+        }
+        else if (timer_exist(rec->item))
+        {
+            lv_timer_t *t = (lv_timer_t *)rec->item;
+
+            lv_timer_resume(t);
+            if (t->period)
+            {
+                pause_stat.timer_skipped += elaps / t->period;
+            }
+        }
+        rec->item = NULL;
+    }
+}
+
+#else
+static void obj_pause_core(lv_obj_t *owner, lv_obj_t *obj, bool by_cull)
+{
+    //TODO
+}
+
+static void obj_resume_core(lv_obj_t *owner, bool by_cull)
+{
+    //TODO
+}
+#endif /* LVGL_VERSION_MAJOR == 8 */
+
 
 
 /**
- * Pause 'obj' and all of its children
+ * Resume 'obj' and all of its children paused by lv_obj_pause
  * @param obj pointer to an object to resume
  * @return LV_RES_OK
  */
@@ -636,55 +838,180 @@ lv_res_t lv_obj_resume(lv_obj_t *obj)
 {
 //    LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
 
-    obj_resume_core(obj);
+    obj_resume_core(obj, false);
 
     return LV_RES_OK;
 }
 
 
 
-static void obj_pause_core(lv_obj_t *obj)
+/**
+ * Pause 'obj' and all of its children, i.e. their timers and animations
+ * @param obj pointer to an object to pause
+ * @return LV_RES_OK
+ */
+lv_res_t lv_obj_pause(lv_obj_t *obj)
 {
-//TODO
-#if 0
-    /*Recursively pause the children*/
-    lv_obj_t *i;
-    lv_obj_t *i_next;
-    i = _lv_ll_get_head(&(obj->child_ll));
-    while (i != NULL)
+//    LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
+
+    obj_pause_core(obj, obj, false);
+
+    return LV_RES_OK;
+}
+
+
+#ifdef LV_LAYOUT_CULLING
+/*
+    Tracked objects are paused when they move out of display by more than 2 * margin,
+    and resumed when they are within margin, so that they are running before visible.
+    Invalidation of offscreen objects is dropped by LVGL, pausing removes its sources.
+*/
+typedef struct
+{
+    lv_obj_t *obj;
+    bool paused;
+    uint32_t pause_cnt;
+} layout_cull_t;
+
+static layout_cull_t cull_obj[LV_LAYOUT_CULL_NUM];
+static lv_timer_t *cull_timer;
+
+static bool obj_near_viewport(lv_obj_t *obj, lv_coord_t margin)
+{
+    lv_area_t area;
+    lv_obj_t *scr = lv_obj_get_screen(obj);
+
+    if ((scr != lv_scr_act()) && (scr != lv_layer_top()) && (scr != lv_layer_sys()))
+    {
+        return false;
+    }
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN))
     {
-        /*Get the next object before pause this*/
-        i_next = _lv_ll_get_next(&(obj->child_ll), i);
+        return false;
+    }
 
-        /*Call the recursive pause to the child too*/
-        obj_pause_core(i);
+    lv_obj_get_coords(obj, &area);
+    return (area.x1 < lv_disp_get_hor_res(NULL) + margin) && (area.x2 >= -margin)
+           && (area.y1 < lv_disp_get_ver_res(NULL) + margin) && (area.y2 >= -margin);
+}
 
-        /*Set i to the next node*/
-        i = i_next;
+static void cull_timer_cb(lv_timer_t *t)
+{
+    layout_cull_t *c;
+    uint32_t i;
+
+    for (i = 0; i < LV_LAYOUT_CULL_NUM; i++)
+    {
+        c = &cull_obj[i];
+        if (!c->obj)
+        {
+            continue;
+        }
+        if (!c->paused && !obj_near_viewport(c->obj, LV_LAYOUT_CULL_MARGIN * 2))
+        {
+            obj_pause_core(c->obj, c->obj, true);
+            c->paused = true;
+            c->pause_cnt++;
+        }
+        else if (c->paused && obj_near_viewport(c->obj, LV_LAYOUT_CULL_MARGIN))
+        {
+            obj_resume_core(c->obj, true);
+            c->paused = false;
+        }
     }
+}
 
-    /* All children paused.
-     * Now pause the object specific data*/
-    obj->signal_cb(obj, LV_SIGNAL_PAUSE, NULL);
-#endif
+static void cull_delete_cb(lv_event_t *e)
+{
+    lv_layout_cull_remove(lv_event_get_target(e));
 }
 
+void lv_layout_cull_add(lv_obj_t *obj)
+{
+    layout_cull_t *c = NULL;
+    uint32_t i;
 
+    for (i = 0; i < LV_LAYOUT_CULL_NUM; i++)
+    {
+        if (cull_obj[i].obj == obj)
+        {
+            return;
+        }
+        if (!c && !cull_obj[i].obj)
+        {
+            c = &cull_obj[i];
+        }
+    }
+    if (!c)
+    {
+        LOG_W("cull table full");
+        return;
+    }
 
-/**
- * Pause 'obj' and all of its children
- * @param obj pointer to an object to pause
- * @return LV_RES_OK
- */
-lv_res_t lv_obj_pause(lv_obj_t *obj)
+    c->obj = obj;
+    c->paused = false;
+    c->pause_cnt = 0;
+    lv_obj_add_event_cb(obj, cull_delete_cb, LV_EVENT_DELETE, NULL);
+    if (!cull_timer)
+    {
+        cull_timer = lv_timer_create(cull_timer_cb, LV_LAYOUT_CULL_PERIOD, NULL);
+    }
+}
+
+void lv_layout_cull_remove(lv_obj_t *obj)
 {
-//    LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
+    uint32_t i;
 
-    obj_pause_core(obj);
+    for (i = 0; i < LV_LAYOUT_CULL_NUM; i++)
+    {
+        if (cull_obj[i].obj == obj)
+        {
+            if (cull_obj[i].paused)
+            {
+                obj_resume_core(obj, true);
+            }
+            lv_obj_remove_event_cb(obj, cull_delete_cb);
+            cull_obj[i].obj = NULL;
+        }
+    }
+}
 
-    return LV_RES_OK;
+static void layout_cull(int argc, char **argv)
+{
+    uint32_t i, paused = 0, timers = 0, anims = 0;
+
+    for (i = 0; i < LV_LAYOUT_PAUSE_REC_NUM; i++)
+    {
+        if (pause_rec[i].item && pause_rec[i].by_cull)
+        {
+            if (pause_rec[i].is_anim)
+            {
+                anims++;
+            }
+            else
+            {
+                timers++;
+            }
+        }
+    }
+    for (i = 0; i < LV_LAYOUT_CULL_NUM; i++)
+    {
+        if (cull_obj[i].obj)
+        {
+            rt_kprintf("%p %-8s paused %d times\n", cull_obj[i].obj, cull_obj[i].paused ? "paused" : "running",
+                       cull_obj[i].pause_cnt);
+            paused += cull_obj[i].paused;
+        }
+    }
+    rt_kprintf("paused objects %d, timers %d, anims %d\n", paused, timers, anims);
+    rt_kprintf("saved: timer callbacks %d, anim frozen %d ms (%d frames), record full %d\n",
+               pause_stat.timer_skipped, pause_stat.anim_frozen_ms,
+               pause_stat.anim_frozen_ms / LV_DISP_DEF_REFR_PERIOD, pause_stat.rec_full);
 }
+MSH_CMD_EXPORT(layout_cull, show paused offscreen layout objects);
+#endif /* LV_LAYOUT_CULLING */
 
+#ifdef LAYOUT_TEXT_LOADER
 static lv_res_t lv_obj_set_prop(lv_obj_t *obj, widget_prop_t prop_name, const value_t *val, const void *ui)
 {
     lv_res_t res = LV_RES_OK;
@@ -867,8 +1194,23 @@ INIT_ENV_EXPORT(lv_widget_factory_init);
 
 
 
+#endif /* LAYOUT_TEXT_LOADER */
+
+
 void *lv_load_layout(lv_obj_t *parent, const ui_layout_desc_t *layout)
 {
+#ifdef LV_LAYOUT_CULLING
+    lv_layout_cull_add(parent);
+#endif
+
+#ifdef LV_USING_LAYOUT_BIN
+    if (lv_layout_is_bin(layout->data, layout->data_size))
+    {
+        return lv_load_layout_bin(parent, layout->data, layout->data_size);
+    }
+#endif /* LV_USING_LAYOUT_BIN */
+
+#ifdef LAYOUT_TEXT_LOADER
     ui_loader_t *loader = default_ui_loader();
     ui_builder_t *builder = ui_builder_default(layout->id_str);
     ret_t ret;
@@ -879,21 +1221,90 @@ void *lv_load_layout(lv_obj_t *parent, const ui_layout_desc_t *layout)
     RT_ASSERT(RET_OK == ret);
 
     return builder->ui;
+#else
+    LOG_W("layout %s is not precompiled", layout->id_str);
+    return NULL;
+#endif /* LAYOUT_TEXT_LOADER */
 }
 
 void lv_free_layout(void *ui)
 {
+#ifdef LV_USING_LAYOUT_BIN
+    if (lv_layout_bin_is_ui(ui))
+    {
+        lv_free_layout_bin(ui);
+        return;
+    }
+#endif /* LV_USING_LAYOUT_BIN */
+
+#ifdef LAYOUT_TEXT_LOADER
     ui_builder_t *builder = ui_builder_default("");
 
     ui_builder_on_destroy(builder, ui);
-
+#endif /* LAYOUT_TEXT_LOADER */
 }
 
 
 
 lv_obj_t *lv_find_obj_in_layout(void *ui, const char *name)
 {
+#ifdef LV_USING_LAYOUT_BIN
+    if (lv_layout_bin_is_ui(ui))
+    {
+        return lv_find_obj_in_layout_bin(ui, name);
+    }
+#endif /* LV_USING_LAYOUT_BIN */
+
+#ifdef LAYOUT_TEXT_LOADER
     return ui_builder_default_get_widget(ui, name);
+#else
+    return NULL;
+#endif /* LAYOUT_TEXT_LOADER */
+}
+
+
+/**
+ * Load and free layout repeatedly, print average time
+ * @param parent parent of temporary container
+ * @param id layout id registered by APP_WATCHFACE_LAYOUT_REGISTER
+ * @param loops number of loads
+ * @return average load time in us, 0 if layout not found
+ */
+uint32_t lv_layout_bench(lv_obj_t *parent, const char *id, uint32_t loops)
+{
+    const ui_layout_desc_t *layout = find_watchface_layout(id);
+    lv_obj_t *cont;
+    uint32_t start, load_ms = 0, del_ms = 0;
+    uint32_t i;
+    void *ui;
+
+    if (!layout || !loops)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < loops; i++)
+    {
+        cont = lv_obj_create(parent);
+        start = lv_tick_get();
+        ui = lv_load_layout(cont, layout);
+        load_ms += lv_tick_elaps(start);
+
+        start = lv_tick_get();
+        lv_free_layout(ui);
+        lv_obj_del(cont);
+        del_ms += lv_tick_elaps(start);
+    }
+
+    rt_kprintf("layout %s (%s, %d bytes): load %d us, delete %d us, %d loops\n", id,
+#ifdef LV_USING_LAYOUT_BIN
+               lv_layout_is_bin(layout->data, layout->data_size) ? "bin" : "text",
+#else
+               "text",
+#endif
+               layout->data_size, load_ms * 1000 / loops, del_ms * 1000 / loops, loops);
+
+    return load_ms * 1000 / loops;
 }
 
 
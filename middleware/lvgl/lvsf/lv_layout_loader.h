@@ -39,11 +39,18 @@ typedef struct
 lv_res_t lv_obj_resume(lv_obj_t *obj);
 lv_res_t lv_obj_pause(lv_obj_t *obj);
 
+/* Pause object when it is out of display and resume it when back, parent of layout is added by lv_load_layout */
+void lv_layout_cull_add(lv_obj_t *obj);
+void lv_layout_cull_remove(lv_obj_t *obj);
+
 
 void *lv_load_layout(lv_obj_t *parent, const ui_layout_desc_t *layout);
 void lv_free_layout(void *ui);
 lv_obj_t *lv_find_obj_in_layout(void *ui, const char *name);
 
+/* Average load time in us of registered layout, register both text and precompiled layout to compare */
+uint32_t lv_layout_bench(lv_obj_t *parent, const char *id, uint32_t loops);
+
 
 /**********************
  *      MACROS
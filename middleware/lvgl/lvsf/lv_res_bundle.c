@@ -0,0 +1,379 @@
+/**
+ * @file lv_res_bundle.c
+ *
+ * Resource bundle mapped in place, see lv_res_bundle.h
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <rtthread.h>
+#include <string.h>
+#include "rtconfig.h"
+#include "lvgl.h"
+#include "lvsf.h"
+#include "section.h"
+#include "lv_ext_resource_manager.h"
+#include "lv_res_bundle.h"
+#ifdef LV_USING_FREETYPE_ENGINE
+    #include "lvsf_ft_reg.h"
+#endif
+#ifdef RT_USING_DFS
+    #include <dfs_posix.h>
+#endif
+
+#define DBG_TAG "res_bundle"
+#define DBG_LVL DBG_INFO
+#include "rtdbg.h"
+
+#ifdef LV_USING_RES_BUNDLE
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FNV_OFFSET      (0x811C9DC5)
+#define FNV_PRIME       (0x01000193)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    const uint8_t *data;
+    const lv_res_bundle_entry_t *entry;
+    const char *pool;
+    uint16_t entry_num;
+    lv_img_dsc_t **img;         /**< Descriptor of image entry, created on first use */
+} res_bundle_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+#ifdef LV_USING_FREETYPE_ENGINE
+    SECTION_DEF(FONT_SECTION_NAME, font_desc_t);
+#endif
+
+static res_bundle_t bundle;
+static lv_res_bundle_stat_t bundle_stat;
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+static uint32_t res_hash(const char *s)
+{
+    uint32_t h = FNV_OFFSET;
+
+    while (*s)
+        h = (h ^ (uint8_t) * s++) * FNV_PRIME;
+
+    return h;
+}
+
+static bool entry_match(const lv_res_bundle_entry_t *e, lv_res_bundle_type_t type, const char *name)
+{
+    return (e->type == type) && (0 == strcmp(bundle.pool + e->name, name));
+}
+
+/* Index of entry, -1 if not found */
+static int32_t res_lookup(lv_res_bundle_type_t type, const char *name, const char *locale)
+{
+    uint32_t hash = res_hash(name);
+    int32_t lo = 0, hi = (int32_t)bundle.entry_num - 1, i;
+    int32_t any = -1, common = -1;
+
+    bundle_stat.lookup++;
+
+    while (lo <= hi)
+    {
+        i = (lo + hi) / 2;
+        if (bundle.entry[i].hash < hash)
+            lo = i + 1;
+        else
+            hi = i - 1;
+    }
+
+    /*lo is the first entry of hash, entries of same name are next to each other*/
+    for (i = lo; (i < bundle.entry_num) && (bundle.entry[i].hash == hash); i++)
+    {
+        const lv_res_bundle_entry_t *e = &bundle.entry[i];
+
+        if (!entry_match(e, type, name))
+            continue;
+        if (LV_RES_BUNDLE_NO_STR == e->locale)
+        {
+            common = i;
+            if (!locale || !locale[0])
+                return i;
+        }
+        else if (locale && (0 == strcmp(bundle.pool + e->locale, locale)))
+        {
+            return i;
+        }
+        else if (any < 0)
+        {
+            any = i;
+        }
+    }
+
+    if (common >= 0)
+        return common;
+    if (any < 0)
+        bundle_stat.miss++;
+
+    return any;
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+bool lv_res_bundle_is_valid(const uint8_t *data, uint32_t size)
+{
+    const lv_res_bundle_header_t *hdr = (const lv_res_bundle_header_t *)data;
+    const lv_res_bundle_entry_t *entry;
+    const char *pool;
+    uint32_t i;
+
+    if (!data || (size < sizeof(*hdr)) || ((rt_ubase_t)data & 3) || (LV_RES_BUNDLE_MAGIC != hdr->magic))
+        return false;
+
+    if ((LV_RES_BUNDLE_VERSION != hdr->version) || (hdr->total_size > size)
+            || (hdr->total_size < sizeof(*hdr) + hdr->entry_num * sizeof(*entry) + hdr->pool_size)
+            || (hdr->align < 4) || (hdr->align & (hdr->align - 1)) || ((rt_ubase_t)data & (hdr->align - 1)))
+    {
+        LOG_W("invalid bundle: ver %d, size %d/%d, align %d at %p", hdr->version, hdr->total_size, size,
+              hdr->align, data);
+        return false;
+    }
+
+    entry = (const lv_res_bundle_entry_t *)(hdr + 1);
+    pool = (const char *)(entry + hdr->entry_num);
+    /*Every offset in pool is a valid string if pool is terminated*/
+    if (hdr->pool_size && pool[hdr->pool_size - 1])
+        return false;
+
+    for (i = 0; i < hdr->entry_num; i++, entry++)
+    {
+        if ((entry->type >= LV_RES_BUNDLE_TYPE_NUM) || (entry->name >= hdr->pool_size)
+                || ((LV_RES_BUNDLE_NO_STR != entry->locale) && (entry->locale >= hdr->pool_size))
+                || (entry->offset & (hdr->align - 1)) || (entry->offset > hdr->total_size)
+                || (entry->size > hdr->total_size - entry->offset)
+                || ((i > 0) && (entry->hash < entry[-1].hash))
+                || ((LV_RES_BUNDLE_IMG == entry->type) && (entry->size < sizeof(lv_img_header_t))))
+        {
+            LOG_W("invalid entry %d, type %d", i, entry->type);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+rt_err_t lv_res_bundle_mount(const uint8_t *data, uint32_t size)
+{
+    const lv_res_bundle_header_t *hdr = (const lv_res_bundle_header_t *)data;
+    lv_img_dsc_t **img;
+
+    if (!lv_res_bundle_is_valid(data, size))
+        return -RT_EINVAL;
+
+    img = (lv_img_dsc_t **) rt_calloc(hdr->entry_num ? hdr->entry_num : 1, sizeof(lv_img_dsc_t *));
+    if (!img)
+        return -RT_ENOMEM;
+
+    lv_res_bundle_unmount();
+    bundle.data = data;
+    bundle.entry = (const lv_res_bundle_entry_t *)(hdr + 1);
+    bundle.pool = (const char *)(bundle.entry + hdr->entry_num);
+    bundle.entry_num = hdr->entry_num;
+    bundle.img = img;
+    LOG_I("bundle %p mounted, %d entries, %d bytes", data, hdr->entry_num, hdr->total_size);
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_DFS
+rt_err_t lv_res_bundle_mount_file(const char *path)
+{
+    struct stat st;
+    void *addr = NULL;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -RT_ERROR;
+
+    if (0 == fstat(fd, &st))
+        addr = dfs_mmap(fd, 0, st.st_size);
+    close(fd);
+
+    if (!addr)
+    {
+        LOG_W("%s is not mapped", path);
+        return -RT_ENOSYS;
+    }
+
+    return lv_res_bundle_mount((const uint8_t *)addr, st.st_size);
+}
+#endif /* RT_USING_DFS */
+
+void lv_res_bundle_unmount(void)
+{
+    uint32_t i;
+
+    if (!bundle.data)
+        return;
+
+    for (i = 0; i < bundle.entry_num; i++)
+    {
+        if (bundle.img[i])
+            rt_free(bundle.img[i]);
+    }
+    rt_free(bundle.img);
+    memset(&bundle, 0, sizeof(bundle));
+    bundle_stat.img_dsc = 0;
+    bundle_stat.font_bound = 0;
+}
+
+const uint8_t *lv_res_bundle_find(lv_res_bundle_type_t type, const char *name, const char *locale, uint32_t *size)
+{
+    int32_t i;
+
+    if (!bundle.data || !name)
+        return NULL;
+
+    i = res_lookup(type, name, locale);
+    if (i < 0)
+        return NULL;
+
+    if (size)
+        *size = bundle.entry[i].size;
+
+    return bundle.data + bundle.entry[i].offset;
+}
+
+const void *lv_res_bundle_img_src(const char *name, const void *fallback)
+{
+    const lv_res_bundle_entry_t *e;
+    lv_img_dsc_t *dsc;
+    int32_t i;
+
+    if (!bundle.data || !name)
+        return fallback;
+
+    i = res_lookup(LV_RES_BUNDLE_IMG, name, NULL);
+    if (i < 0)
+        return fallback;
+
+    if (bundle.img[i])
+        return bundle.img[i];
+
+    dsc = (lv_img_dsc_t *) rt_malloc(sizeof(lv_img_dsc_t));
+    if (!dsc)
+        return fallback;
+
+    /*Only header is copied, pixels are used in place*/
+    e = &bundle.entry[i];
+    memset(dsc, 0, sizeof(*dsc));
+    memcpy(&dsc->header, bundle.data + e->offset, sizeof(lv_img_header_t));
+    dsc->data = bundle.data + e->offset + sizeof(lv_img_header_t);
+    dsc->data_size = e->size - sizeof(lv_img_header_t);
+    bundle.img[i] = dsc;
+    bundle_stat.img_dsc++;
+
+    return dsc;
+}
+
+uint32_t lv_res_bundle_bind_fonts(void)
+{
+    uint32_t bound = 0;
+#ifdef LV_USING_FREETYPE_ENGINE
+    const font_desc_t *desc = (const font_desc_t *)SECTION_START_ADDR(FONT_SECTION_NAME);
+    const font_desc_t *end = (const font_desc_t *)SECTION_END_ADDR(FONT_SECTION_NAME);
+    const char *locale = lv_ext_get_locale();
+#endif
+
+#ifdef LV_RES_BUNDLE_PATH
+    if (!bundle.data && LV_RES_BUNDLE_PATH[0])
+        lv_res_bundle_mount_file(LV_RES_BUNDLE_PATH);
+#endif
+
+#ifdef LV_USING_FREETYPE_ENGINE
+    if (!bundle.data)
+        return 0;
+
+    /*Descriptors of all sizes share one library, rebinding it again is harmless*/
+    for (; desc < end; desc++)
+    {
+        const uint8_t *font;
+        uint32_t size;
+
+        if (!desc->font_name || !desc->font_lib)
+            continue;
+
+        font = lv_res_bundle_find(LV_RES_BUNDLE_FONT, desc->font_name, locale, &size);
+        if (!font)
+            continue;
+
+        if (desc->font_lib->font_lib_data != (const char *)font)
+        {
+            desc->font_lib->font_lib_data = (const char *)font;
+            desc->font_lib->font_lib_size = size;
+            bound++;
+            LOG_I("font %s: %d bytes subset of locale %s", desc->font_name, size, locale);
+        }
+    }
+    bundle_stat.font_bound = bound;
+#endif /* LV_USING_FREETYPE_ENGINE */
+
+    return bound;
+}
+
+void lv_res_bundle_get_stat(lv_res_bundle_stat_t *stat, bool reset)
+{
+    rt_enter_critical();
+    *stat = bundle_stat;
+    if (reset)
+    {
+        bundle_stat.lookup = 0;
+        bundle_stat.miss = 0;
+    }
+    rt_exit_critical();
+}
+
+#ifdef RT_USING_FINSH
+static int res_bundle(int argc, char **argv)
+{
+    const lv_res_bundle_header_t *hdr = (const lv_res_bundle_header_t *)bundle.data;
+    lv_res_bundle_stat_t stat;
+    uint32_t i;
+
+    if (!hdr)
+    {
+        rt_kprintf("no bundle\n");
+        return 0;
+    }
+
+    lv_res_bundle_get_stat(&stat, (argc > 1) && (0 == strcmp(argv[1], "reset")));
+    rt_kprintf("bundle %p, %d entries, %d bytes, align %d\n", hdr, hdr->entry_num, hdr->total_size, hdr->align);
+    rt_kprintf("lookup %d, miss %d, image descriptors %d (%d bytes), fonts bound %d\n", stat.lookup, stat.miss,
+               stat.img_dsc, stat.img_dsc * sizeof(lv_img_dsc_t), stat.font_bound);
+
+    if ((argc > 1) && (0 == strcmp(argv[1], "list")))
+    {
+        for (i = 0; i < bundle.entry_num; i++)
+        {
+            const lv_res_bundle_entry_t *e = &bundle.entry[i];
+
+            rt_kprintf("%3d %-4s %-24s %-8s %p %8d\n", i, (LV_RES_BUNDLE_FONT == e->type) ? "font" : "img",
+                       bundle.pool + e->name, (LV_RES_BUNDLE_NO_STR == e->locale) ? "*" : bundle.pool + e->locale,
+                       bundle.data + e->offset, e->size);
+        }
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(res_bundle, res_bundle [list|reset]: show mapped resource bundle);
+#endif /* RT_USING_FINSH */
+
+#endif /* LV_USING_RES_BUNDLE */
@@ -0,0 +1,149 @@
+#ifndef _LV_RES_BUNDLE_H_
+#define _LV_RES_BUNDLE_H_
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <rtthread.h>
+#include "rtconfig.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+    Resource bundle, generated by tools/scripts/respack.py. Fonts are subset to the glyphs
+    used by UI strings of every locale, images are LVGL binary images. Bundle is used in place
+    from XIP flash, payloads are aligned to header align and nothing is copied to RAM except
+    image descriptors.
+
+    | header | entry[entry_num] sorted by hash | string pool | payloads |
+*/
+#define LV_RES_BUNDLE_MAGIC         (0x4252564C)    /* "LVRB" */
+#define LV_RES_BUNDLE_VERSION       (1)
+#define LV_RES_BUNDLE_NO_STR        (0xFFFF)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+    LV_RES_BUNDLE_FONT,         /**< Subset TTF/OTF, one entry per locale */
+    LV_RES_BUNDLE_IMG,          /**< lv_img_header_t followed by pixel data */
+    LV_RES_BUNDLE_TYPE_NUM,
+} lv_res_bundle_type_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_num;
+    uint32_t align;
+    uint32_t pool_size;
+    uint32_t total_size;
+} lv_res_bundle_header_t;
+
+typedef struct
+{
+    uint32_t hash;          /**< FNV-1a of name */
+    uint32_t offset;        /**< Payload offset from bundle start, multiple of align */
+    uint32_t size;
+    uint16_t name;          /**< Offset in string pool */
+    uint16_t locale;        /**< Offset in string pool, LV_RES_BUNDLE_NO_STR if used by all locales */
+    uint8_t  type;          /**< lv_res_bundle_type_t */
+    uint8_t  reserved;
+    uint16_t reserved2;
+} lv_res_bundle_entry_t;
+
+typedef struct
+{
+    uint32_t lookup;
+    uint32_t miss;
+    uint32_t img_dsc;       /**< Image descriptors allocated */
+    uint32_t font_bound;    /**< Font libraries bound to bundle at last lv_res_bundle_bind_fonts */
+} lv_res_bundle_stat_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * @brief Check if data is a resource bundle
+ * @param data bundle data
+ * @param size size of data in bytes
+ * @return true if header and entry table are valid
+ */
+bool lv_res_bundle_is_valid(const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Use resource bundle, data must stay mapped until unmount. Previous bundle is unmounted.
+ * @param data bundle data, e.g. in XIP flash
+ * @param size size of data in bytes
+ * @return RT_EOK if mounted
+ */
+rt_err_t lv_res_bundle_mount(const uint8_t *data, uint32_t size);
+
+#ifdef RT_USING_DFS
+/**
+ * @brief Mount bundle file mapped by dfs_mmap, file must be contiguous in mapped flash
+ * @param path file path
+ * @return RT_EOK if mounted
+ */
+rt_err_t lv_res_bundle_mount_file(const char *path);
+#endif
+
+/**
+ * @brief Stop using bundle, called after lv_freetype_close_font and images in bundle are deleted
+ */
+void lv_res_bundle_unmount(void);
+
+/**
+ * @brief Find payload in mounted bundle
+ * @param type lv_res_bundle_type_t
+ * @param name resource name
+ * @param locale locale, NULL or "" for resource used by all locales.
+ *        Entry of locale is preferred, then the one for all locales, then any locale
+ * @param size size of payload in bytes, can be NULL
+ * @return payload, NULL if not found
+ */
+const uint8_t *lv_res_bundle_find(lv_res_bundle_type_t type, const char *name, const char *locale, uint32_t *size);
+
+/**
+ * @brief Get image in bundle as image source
+ * @param name image name, i.e. file name of image given to respack.py
+ * @param fallback returned if image is not in bundle, e.g. file path
+ * @return lv_img_dsc_t pointing to bundle, or fallback
+ */
+const void *lv_res_bundle_img_src(const char *name, const void *fallback);
+
+/**
+ * @brief Bind registered freetype fonts to their subset of current locale in bundle,
+ *        called by lv_freetype_open_font before faces are created
+ * @return number of font libraries bound
+ */
+uint32_t lv_res_bundle_bind_fonts(void);
+
+/**
+ * @brief Get statistics
+ * @param stat statistics
+ * @param reset clear lookup and miss counters after read
+ */
+void lv_res_bundle_get_stat(lv_res_bundle_stat_t *stat, bool reset);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*_LV_RES_BUNDLE_H_*/
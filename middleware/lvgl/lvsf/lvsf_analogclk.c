@@ -10,6 +10,7 @@
 
 #include "lvgl.h"
 #include "lvsf.h"
+#include "lvsf_perf.h"
 
 #if LVSF_USE_ANALOGCLK!=0
 
@@ -27,6 +28,16 @@
  *********************/
 #define MY_CLASS &lv_analogclk_class
 
+/*
+    A moving hand invalidates its old and new positions strip by strip instead
+    of the bounding box of the whole rotated image, which for a long thin hand at
+    45 degrees covers nearly a quarter of the face. Each strip is about as long as
+    the hand is wide, at most LV_ANALOGCLK_HAND_SEGS strips per hand.
+*/
+#ifndef LV_ANALOGCLK_HAND_SEGS
+    #define LV_ANALOGCLK_HAND_SEGS  4
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -42,6 +53,7 @@ typedef struct
     uint8_t moff;
     uint8_t soff;
     uint16_t refresh_interval;
+    uint32_t inv_pixels;    /*Invalidated by hands in this tick*/
 } lv_analogclk_ext_t;
 
 
@@ -65,6 +77,8 @@ const lv_obj_class_t lv_analogclk_class =
     .base_class = &lv_obj_class
 };
 
+static lvsf_perf_redraw_t analogclk_redraw = {.name = "analogclk"};
+
 /**********************
  *      MACROS
  **********************/
@@ -74,6 +88,96 @@ const lv_obj_class_t lv_analogclk_class =
  *   STATIC FUNCTIONS
  **********************/
 
+/*Angle in 0.1 degree, interpolated to keep long hands inside invalidated strips*/
+static int32_t hand_sin(int16_t angle)
+{
+    int32_t s0 = lv_trigo_sin(angle / 10);
+    int32_t s1 = lv_trigo_sin(angle / 10 + 1);
+
+    return s0 + (s1 - s0) * (angle % 10) / 10;
+}
+
+/*Bounding box of rectangle (x1,y1)-(x2,y2) in image, rotated around pivot, relative to image*/
+static void hand_strip_area(lv_area_t *res, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                            int32_t sinma, int32_t cosma, int32_t zoom, const lv_point_t *pivot)
+{
+    int32_t xs[4] = {x1, x2, x1, x2};
+    int32_t ys[4] = {y1, y1, y2, y2};
+    int32_t i, x, y;
+
+    res->x1 = LV_COORD_MAX;
+    res->y1 = LV_COORD_MAX;
+    res->x2 = LV_COORD_MIN;
+    res->y2 = LV_COORD_MIN;
+    for (i = 0; i < 4; i++)
+    {
+        int32_t dx = ((xs[i] - pivot->x) * zoom) >> 8;
+        int32_t dy = ((ys[i] - pivot->y) * zoom) >> 8;
+
+        x = ((cosma * dx - sinma * dy) >> LV_TRIGO_SHIFT) + pivot->x;
+        y = ((sinma * dx + cosma * dy) >> LV_TRIGO_SHIFT) + pivot->y;
+        res->x1 = LV_MIN(res->x1, x);
+        res->y1 = LV_MIN(res->y1, y);
+        res->x2 = LV_MAX(res->x2, x);
+        res->y2 = LV_MAX(res->y2, y);
+    }
+    /*Rounding and anti-aliasing*/
+    res->x1 -= 2;
+    res->y1 -= 2;
+    res->x2 += 2;
+    res->y2 += 2;
+}
+
+static void hand_invalidate(lv_analogclk_ext_t *ext, lv_obj_t *hand, int16_t old_angle, int16_t new_angle)
+{
+    lv_img_t *img = (lv_img_t *)hand;
+    lv_coord_t w = lv_obj_get_width(hand);
+    lv_coord_t h = lv_obj_get_height(hand);
+    int32_t old_sin = hand_sin(old_angle), old_cos = hand_sin(old_angle + 900);
+    int32_t new_sin = hand_sin(new_angle), new_cos = hand_sin(new_angle + 900);
+    int32_t segs, i, y1, y2;
+    lv_area_t a, b;
+
+    /*Hand images are vertical, split along their height*/
+    segs = (w > 0) ? (h / w) : 1;
+    segs = LV_CLAMP(1, segs, LV_ANALOGCLK_HAND_SEGS);
+
+    for (i = 0; i < segs; i++)
+    {
+        y1 = h * i / segs;
+        y2 = h * (i + 1) / segs - 1;
+        hand_strip_area(&a, 0, y1, w - 1, y2, old_sin, old_cos, img->zoom, &img->pivot);
+        hand_strip_area(&b, 0, y1, w - 1, y2, new_sin, new_cos, img->zoom, &img->pivot);
+        /*Old and new strips of small step mostly overlap, one area keeps invalid list short*/
+        _lv_area_join(&a, &a, &b);
+        lv_area_move(&a, hand->coords.x1, hand->coords.y1);
+        ext->inv_pixels += lv_area_get_size(&a);
+        lv_obj_invalidate_area(hand, &a);
+    }
+}
+
+static void hand_set_angle(lv_analogclk_ext_t *ext, lv_obj_t *hand, int16_t angle)
+{
+    lv_img_t *img = (lv_img_t *)hand;
+    lv_disp_t *disp = lv_obj_get_disp(hand);
+    int16_t old_angle;
+
+    angle = angle % 3600;
+    if (angle == img->angle)
+        return;
+
+    lv_obj_update_layout(hand);
+    old_angle = img->angle;
+    img->angle = angle;
+
+    /*Same as lv_img_set_angle(), but invalidate strips only*/
+    lv_disp_enable_invalidation(disp, false);
+    lv_obj_refresh_ext_draw_size(hand);
+    lv_disp_enable_invalidation(disp, true);
+
+    hand_invalidate(ext, hand, old_angle, angle);
+}
+
 static void lv_analogclk_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
 {
     LV_UNUSED(class_p);
@@ -114,6 +218,7 @@ static void refresh_task_cb(lv_timer_t *t)
 {
     lv_analogclk_ext_t *ext = (lv_analogclk_ext_t *)t->user_data;
 
+    ext->inv_pixels = 0;
 #ifdef WIN32
     time_t  cur = _time64(RT_NULL);
     struct tm *tmb = _localtime64(&cur);
@@ -135,18 +240,19 @@ static void refresh_task_cb(lv_timer_t *t)
 
         int32_t ms_now = rt_tick_get_millisecond();
         uint16_t second_angle = ((ms_now / 1000 + delta) * 60) + ((ms_now % 1000) * 360 * 10 / 60000) + 10;
-        lv_img_set_angle(ext->second_hand, second_angle);
+        hand_set_angle(ext, ext->second_hand, second_angle);
     }
     if (ext->minute_hand)
     {
         uint16_t minute_angle = (tmb->tm_min * 60) + (tmb->tm_sec) + 10;
-        lv_img_set_angle(ext->minute_hand, minute_angle);
+        hand_set_angle(ext, ext->minute_hand, minute_angle);
     }
     if (ext->hour_hand)
     {
         uint16_t hour_angle = (tmb->tm_hour * 300) + (tmb->tm_min * 5) + 10;
-        lv_img_set_angle(ext->hour_hand, hour_angle);
+        hand_set_angle(ext, ext->hour_hand, hour_angle);
     }
+    lvsf_perf_redraw_add(&analogclk_redraw, ext->inv_pixels);
 }
 
 /**********************
@@ -316,7 +422,10 @@ void lv_analogclk_refr_inteval(lv_obj_t *aclk, uint16_t ms)
             ext->clock_redraw_task = NULL;
         }
         if (ms)
+        {
             ext->clock_redraw_task = lv_timer_create(refresh_task_cb, ms, (void *)aclk);
+            lvsf_perf_redraw_register(&analogclk_redraw);
+        }
         ext->refresh_interval = ms;
     }
 }
@@ -49,8 +49,40 @@
     #include "app_mem.h"
 #endif
 
+#include "lvsf_perf.h"
+
 #define lvsf_get_font(size) LV_EXT_FONT_GET(size)
 
+#if defined SOLUTION_WATCH && (IMAGE_CACHE_IN_PSRAM_SIZE > 0 || IMAGE_CACHE_IN_SRAM_SIZE > 0)
+    #define CURVE_MEM_ALLOC(size)   app_canvas_mem_alloc(size)
+    #define CURVE_MEM_FREE(ptr)     app_canvas_mem_free(ptr)
+#else
+    #define CURVE_MEM_ALLOC(size)   lv_mem_alloc(size)
+    #define CURVE_MEM_FREE(ptr)     lv_mem_free(ptr)
+#endif
+
+/*
+    Rendered glyphs of curved text, keyed by font, color and character.
+    Redrawing a date ring then only rotates cached glyphs into the canvas
+    (by GPU if available) instead of rasterizing every character again.
+*/
+#ifndef LVSF_CURVE_GLYPH_CACHE_NUM
+    #define LVSF_CURVE_GLYPH_CACHE_NUM  32
+#endif
+
+typedef struct
+{
+    const lv_font_t *font;
+    lv_color_t color;
+    char ch;
+    uint32_t last_use;
+    lv_img_dsc_t img;
+} curve_glyph_t;
+
+static curve_glyph_t curve_glyphs[LVSF_CURVE_GLYPH_CACHE_NUM];
+static uint32_t curve_glyph_tick;
+static lvsf_perf_cache_t curve_glyph_perf = {.name = "curve_glyph"};
+
 int lvsf_font_height(int font_size)
 {
     return lvsf_get_font(font_size)->line_height;
@@ -199,6 +231,83 @@ char *next_char(char *text, char *ch, lv_color_t *color)
 }
 
 
+static void curve_glyph_free(curve_glyph_t *g)
+{
+    if (g->img.data)
+    {
+        /*Drop decoded data of old content kept by image cache*/
+        lv_img_cache_invalidate_src(&g->img);
+        CURVE_MEM_FREE((void *)g->img.data);
+    }
+    memset(g, 0, sizeof(*g));
+}
+
+void lvsf_curve_glyph_cache_flush(void)
+{
+    curve_glyph_t *g;
+
+    for (g = &curve_glyphs[0]; g < &curve_glyphs[LVSF_CURVE_GLYPH_CACHE_NUM]; g++)
+        curve_glyph_free(g);
+}
+
+/*Get rendered glyph, canvas is created in parent on first miss and deleted by caller*/
+static lv_img_dsc_t *curve_glyph_get(lv_obj_t *parent, lv_obj_t **canvas, lv_draw_label_dsc_t *dsc, char *mytext)
+{
+    curve_glyph_t *g, *lru = NULL;
+    lv_coord_t w, h;
+    uint32_t size;
+    void *buf;
+
+    for (g = &curve_glyphs[0]; g < &curve_glyphs[LVSF_CURVE_GLYPH_CACHE_NUM]; g++)
+    {
+        if (g->img.data && (g->font == dsc->font) && (g->ch == mytext[0]) && lv_color_eq(g->color, dsc->color))
+        {
+            g->last_use = ++curve_glyph_tick;
+            LVSF_PERF_CACHE_HIT(&curve_glyph_perf);
+            return &g->img;
+        }
+        if (!lru || (g->last_use < lru->last_use))
+            lru = g;
+    }
+    LVSF_PERF_CACHE_MISS(&curve_glyph_perf);
+    lvsf_perf_cache_register(&curve_glyph_perf);
+
+    w = lv_font_get_glyph_width(dsc->font, mytext[0], mytext[1]);
+    h = lv_font_get_line_height(dsc->font);
+    size = LV_CANVAS_BUF_SIZE_TRUE_COLOR(w, h);
+
+    curve_glyph_free(lru);
+    buf = CURVE_MEM_ALLOC(size);
+    if (!buf)
+    {
+        /*Give memory of whole cache back and try again*/
+        lvsf_curve_glyph_cache_flush();
+        buf = CURVE_MEM_ALLOC(size);
+    }
+    if (!buf)
+    {
+        rt_kprintf("lvsf_curve_text: glyph %c w %d h %d no mem\n", mytext[0], w, h);
+        return NULL;
+    }
+
+    if (!*canvas)
+        *canvas = lv_canvas_create(parent);
+    memset(buf, 0, size);
+    lv_canvas_set_buffer(*canvas, buf, w, h, LV_IMG_CF_TRUE_COLOR);
+#ifdef DISABLE_LVGL_V9
+    lv_canvas_draw_text(*canvas, 0, 0, w, dsc, mytext);
+#endif
+
+    lru->font = dsc->font;
+    lru->color = dsc->color;
+    lru->ch = mytext[0];
+    lru->last_use = ++curve_glyph_tick;
+    memcpy(&lru->img, lv_canvas_get_img(*canvas), sizeof(lv_img_dsc_t));
+    lru->img.data = buf;
+
+    return &lru->img;
+}
+
 void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int corner_starty, int angle, int r, lv_color_t color, int size)
 {
     int delta_angle = TEXT_ANGLE;       // Quad 3,4 , show text anti clock-wise
@@ -208,13 +317,11 @@ void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int c
     if (text)
     {
         int startx, starty;
-        uint8_t *cbuf;
         lv_img_dsc_t *img;
-        lv_obj_t *canvas;
-        int font_width, font_height;
+        lv_obj_t *canvas = NULL;
+        int font_height;
         lv_draw_label_dsc_t dsc;
 
-        canvas = lv_canvas_create(parent);
         lv_draw_label_dsc_init(&dsc);
         dsc.flag = LV_TEXT_FLAG_EXPAND;
 #ifdef DISABLE_LVGL_V9
@@ -223,21 +330,7 @@ void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int c
         dsc.font = LV_EXT_FONT_GET(size);
         dsc.color = color;
 
-
-        font_width = lv_font_get_glyph_width(dsc.font, '#', '#');
         font_height = lv_font_get_line_height(dsc.font);
-#if defined SOLUTION_WATCH && (IMAGE_CACHE_IN_PSRAM_SIZE > 0 || IMAGE_CACHE_IN_SRAM_SIZE > 0)
-        cbuf = (uint8_t *)app_canvas_mem_alloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR((font_width << 1), (font_height << 1))); //Enlarge mem, make sure lager than any character
-#else
-        cbuf = (uint8_t *)lv_mem_alloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR((font_width << 1), (font_height << 1))); //Enlarge mem, make sure lager than any character
-#endif
-        if (!cbuf)
-        {
-            rt_kprintf("lvsf_curve_text: size %d font_width %d font_height %d \n", size, font_width, font_height);
-            RT_ASSERT(cbuf);
-        }
-        lv_canvas_set_buffer(canvas, cbuf, font_width, font_height, LV_IMG_CF_TRUE_COLOR);
-        img = lv_canvas_get_img(canvas);
 
         while (*text)
         {
@@ -248,14 +341,12 @@ void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int c
             if ((mytext[0] != ' ') && (mytext[0] != '\0'))
             {
                 dsc.color = color;
-                font_width = lv_font_get_glyph_width(dsc.font, mytext[0], mytext[1]);
-                lv_canvas_set_buffer(canvas, cbuf, font_width, font_height, LV_IMG_CF_TRUE_COLOR);
-
-
-                memset(cbuf, 0, LV_CANVAS_BUF_SIZE_TRUE_COLOR(font_width, font_height));
-#ifdef DISABLE_LVGL_V9
-                lv_canvas_draw_text(canvas, 0, 0, font_width, &dsc, mytext);
-#endif
+                img = curve_glyph_get(parent, &canvas, &dsc, mytext);
+                if (!img)
+                {
+                    angle += delta_angle;
+                    continue;
+                }
                 if (angle < 180)
                 {
                     startx = r - corner_startx + ((lv_trigo_cos(angle) * (2 * r + font_height)) >> (LV_TRIGO_SHIFT + 1));
@@ -272,12 +363,8 @@ void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int c
             angle += delta_angle;
         }
 
-#if defined SOLUTION_WATCH && (IMAGE_CACHE_IN_PSRAM_SIZE > 0 || IMAGE_CACHE_IN_SRAM_SIZE > 0)
-        app_canvas_mem_free(cbuf);
-#else
-        lv_mem_free(cbuf);
-#endif
-        lv_obj_del(canvas);
+        if (canvas)
+            lv_obj_del(canvas);
     }
 
 }
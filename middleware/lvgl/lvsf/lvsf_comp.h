@@ -96,6 +96,11 @@ lv_obj_t *lvsf_curve_text(lv_obj_t *parent, char *text, int x, int y, int angle,
 */
 void lvsf_curve_draw_text(lv_obj_t *parent, char *text, int corner_startx, int corner_starty, int angle, int r, lv_color_t color, int size);
 
+/**
+ * Free glyphs cached by curved text, e.g. after font or language is changed
+*/
+void lvsf_curve_glyph_cache_flush(void);
+
 /**
  * Get font width
  * @param font_size the size of font
@@ -22,6 +22,14 @@ typedef struct
     lv_coord_t pivot_x;
     lv_coord_t pivot_y;
     void *buf;
+    /*Last drawn text, same text is not drawn into canvas again*/
+    char *text;
+    int angle;
+    int r;
+    lv_color_t color;
+    int size;
+    lv_coord_t text_pivot_x;
+    lv_coord_t text_pivot_y;
 } lv_lvsfcurve_t;
 
 /**********************
@@ -66,6 +74,8 @@ static void lv_lvsfcurve_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj
     LV_UNUSED(class_p);
     if (ext && ext->buf)
         app_canvas_mem_free(ext->buf);
+    if (ext && ext->text)
+        lv_mem_free(ext->text);
 }
 
 /**********************
@@ -89,6 +99,11 @@ void lv_lvsfcurve_set_buf(lv_obj_t *curve, uint16_t txt_width, uint16_t txt_heig
     RT_ASSERT(!ext->buf);
     lv_canvas_set_buffer(curve, buff, txt_width, txt_height, LV_IMG_CF_TRUE_COLOR);
     ext->buf = buff;
+    if (ext->text)
+    {
+        lv_mem_free(ext->text);
+        ext->text = NULL;
+    }
 }
 
 void lv_lvsfcurve_set_pivot(lv_obj_t *curve, lv_coord_t x, lv_coord_t y)
@@ -116,7 +131,24 @@ void lv_lvsfcurve_text(lv_obj_t *curve, char *text, int angle, int r, lv_color_t
 {
     lv_lvsfcurve_t *ext = (lv_lvsfcurve_t *)curve;
 
+    if (ext->text && (0 == strcmp(ext->text, text)) && (ext->angle == angle) && (ext->r == r)
+            && lv_color_eq(ext->color, color) && (ext->size == size)
+            && (ext->text_pivot_x == ext->pivot_x) && (ext->text_pivot_y == ext->pivot_y))
+        return;
+
     lvsf_curve_text(curve, text, ext->pivot_x, ext->pivot_y, angle, r, color, size);
+
+    if (ext->text)
+        lv_mem_free(ext->text);
+    ext->text = lv_mem_alloc(strlen(text) + 1);
+    if (ext->text)
+        strcpy(ext->text, text);
+    ext->angle = angle;
+    ext->r = r;
+    ext->color = color;
+    ext->size = size;
+    ext->text_pivot_x = ext->pivot_x;
+    ext->text_pivot_y = ext->pivot_y;
 }
 
 
@@ -44,7 +44,11 @@
  */
 
 #include "rtthread.h"
+#include <stdlib.h>
+#include <string.h>
+#include "lvgl.h"
 #include "lv_ext_resource_manager.h"
+#include "lvsf_emoji.h"
 #ifdef RT_USING_DFS
     #include <dfs.h>
     #include <dfs_file.h>
@@ -76,36 +80,303 @@ static inline void *lv_get_emoji_by_unicode(uint32_t u_letter)
     return NULL;
 }
 #else
-void *lv_get_emoji_by_unicode(uint32_t u_letter)
+
+typedef struct
 {
-#define GET_EMOJI_INFO(_id) \
-    case 0x##_id: \
-    { \
-    return (void *)&emoji_##_id;\
-    }
+    uint32_t unicode;
+    const void *img;
+} emoji_entry_t;
 
-    switch (u_letter)
-    {
+#define GET_EMOJI_INFO(_id)  {0x##_id, (const void *)&emoji_##_id},
+
+static const emoji_entry_t emoji_table[] =
+{
 #ifndef SOLUTION_WATCH
-        /*
-        GET_EMOJI_INFO(1f302)
-        GET_EMOJI_INFO(1f392)
-        GET_EMOJI_INFO(1f393)
-        GET_EMOJI_INFO(1f39a)
-        GET_EMOJI_INFO(2639)
-        GET_EMOJI_INFO(263a)
-        GET_EMOJI_INFO(26d1)
-        */
+    /*
+    GET_EMOJI_INFO(1f302)
+    GET_EMOJI_INFO(1f392)
+    GET_EMOJI_INFO(1f393)
+    GET_EMOJI_INFO(1f39a)
+    GET_EMOJI_INFO(2639)
+    GET_EMOJI_INFO(263a)
+    GET_EMOJI_INFO(26d1)
+    */
 #else /*for SOLUTION_WATCH*/
 #ifdef EMOJI_SUPPORT
 #include "emoji_info.h"
 #endif
 #endif
-    default:
-        return NULL;
+    {0, NULL},  /*End mark, keeps table not empty*/
+};
+
+#define EMOJI_NUM   (sizeof(emoji_table) / sizeof(emoji_table[0]) - 1)
+
+/*Table order is not guaranteed by emoji_info.h, sort an index once*/
+static uint16_t emoji_index[EMOJI_NUM + 1];
+static bool emoji_sorted;
+static uint32_t last_unicode;
+static const void *last_img;
+
+static int emoji_cmp(const void *a, const void *b)
+{
+    uint32_t ua = emoji_table[*(const uint16_t *)a].unicode;
+    uint32_t ub = emoji_table[*(const uint16_t *)b].unicode;
+
+    return (ua > ub) - (ua < ub);
+}
+
+static void emoji_sort(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < EMOJI_NUM; i++)
+        emoji_index[i] = i;
+    qsort(emoji_index, EMOJI_NUM, sizeof(emoji_index[0]), emoji_cmp);
+    emoji_sorted = true;
+}
+
+void *lv_get_emoji_by_unicode(uint32_t u_letter)
+{
+    int32_t lo = 0, hi = (int32_t)EMOJI_NUM - 1, mid;
+    const emoji_entry_t *e;
+
+    /*Same emoji is often repeated in one message*/
+    if (last_img && (last_unicode == u_letter))
+        return (void *)last_img;
+
+    if (!emoji_sorted)
+        emoji_sort();
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) >> 1;
+        e = &emoji_table[emoji_index[mid]];
+        if (e->unicode == u_letter)
+        {
+            last_unicode = u_letter;
+            last_img = e->img;
+            return (void *)e->img;
+        }
+        if (e->unicode < u_letter)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
     }
+
+    return NULL;
 }
 #endif
 
+#if LVGL_VERSION_MAJOR == 8
+/*
+    Atlas packs emoji into one ARGB image, cells in grid of LV_EMOJI_ATLAS_COLS columns.
+    All emoji of a line are drawn from the same source, so it's decoded and cached once
+    and the GPU reads one continuous buffer instead of many small images.
+*/
+#ifndef LV_EMOJI_ATLAS_COLS
+    #define LV_EMOJI_ATLAS_COLS     (8)
+#endif
+
+static struct
+{
+    lv_img_dsc_t img;
+    uint32_t *unicode;      /*Sorted, cell index is position in list*/
+    uint16_t num;
+    lv_coord_t cell_w;
+    lv_coord_t cell_h;
+} emoji_atlas;
+
+static int u32_cmp(const void *a, const void *b)
+{
+    uint32_t ua = *(const uint32_t *)a;
+    uint32_t ub = *(const uint32_t *)b;
+
+    return (ua > ub) - (ua < ub);
+}
+
+static void atlas_copy_px(uint8_t *dst, const uint8_t *src, lv_coord_t w, bool src_alpha)
+{
+    lv_coord_t x;
+
+    if (src_alpha)
+    {
+        memcpy(dst, src, w * LV_IMG_PX_SIZE_ALPHA_BYTE);
+        return;
+    }
+    for (x = 0; x < w; x++)
+    {
+        memcpy(dst, src, LV_COLOR_SIZE / 8);
+        dst[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = LV_OPA_COVER;
+        dst += LV_IMG_PX_SIZE_ALPHA_BYTE;
+        src += LV_COLOR_SIZE / 8;
+    }
+}
+
+static bool atlas_add(uint32_t cell, const void *src)
+{
+    lv_img_decoder_dsc_t dec;
+    uint32_t stride = emoji_atlas.cell_w * LV_EMOJI_ATLAS_COLS * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    uint8_t *dst;
+    uint8_t *line = NULL;
+    bool src_alpha;
+    lv_coord_t y, w, h;
+
+    if (LV_RES_OK != lv_img_decoder_open(&dec, src, lv_color_black(), 0))
+        return false;
+
+    w = dec.header.w;
+    h = dec.header.h;
+    src_alpha = (LV_IMG_CF_TRUE_COLOR != dec.header.cf) && (LV_IMG_CF_RAW != dec.header.cf)
+                && (LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED != dec.header.cf);
+    if ((w > emoji_atlas.cell_w) || (h > emoji_atlas.cell_h)
+            || (!dec.img_data && !(line = lv_mem_alloc(w * LV_IMG_PX_SIZE_ALPHA_BYTE))))
+    {
+        lv_img_decoder_close(&dec);
+        return false;
+    }
+
+    dst = (uint8_t *)emoji_atlas.img.data + (cell / LV_EMOJI_ATLAS_COLS) * emoji_atlas.cell_h * stride
+          + (cell % LV_EMOJI_ATLAS_COLS) * emoji_atlas.cell_w * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    for (y = 0; y < h; y++, dst += stride)
+    {
+        if (dec.img_data)
+        {
+            atlas_copy_px(dst, dec.img_data + y * w * (src_alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : LV_COLOR_SIZE / 8),
+                          w, src_alpha);
+        }
+        else
+        {
+            /*Line reader of built-in decoder outputs alpha for all formats except true color*/
+            lv_img_decoder_read_line(&dec, 0, y, w, line);
+            atlas_copy_px(dst, line, w, src_alpha);
+        }
+    }
+
+    if (line)
+        lv_mem_free(line);
+    lv_img_decoder_close(&dec);
+    return true;
+}
+
+int lv_emoji_atlas_build(const uint32_t *letters, uint32_t num, lv_coord_t cell_w, lv_coord_t cell_h)
+{
+    uint32_t rows, size, i, n;
+    const void *src;
+
+    lv_emoji_atlas_free();
+    if (!num || !letters)
+        return 0;
+
+    rows = (num + LV_EMOJI_ATLAS_COLS - 1) / LV_EMOJI_ATLAS_COLS;
+    size = (uint32_t)cell_w * LV_EMOJI_ATLAS_COLS * cell_h * rows * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    emoji_atlas.unicode = lv_mem_alloc(num * sizeof(uint32_t));
+    emoji_atlas.img.data = lv_mem_alloc(size);
+    if (!emoji_atlas.unicode || !emoji_atlas.img.data)
+    {
+        lv_emoji_atlas_free();
+        return -1;
+    }
+    /*Transparent for cells not filled*/
+    lv_memset_00((void *)emoji_atlas.img.data, size);
+
+    memcpy(emoji_atlas.unicode, letters, num * sizeof(uint32_t));
+    qsort(emoji_atlas.unicode, num, sizeof(uint32_t), u32_cmp);
+    emoji_atlas.cell_w = cell_w;
+    emoji_atlas.cell_h = cell_h;
+
+    emoji_atlas.img.header.always_zero = 0;
+    emoji_atlas.img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    emoji_atlas.img.header.w = cell_w * LV_EMOJI_ATLAS_COLS;
+    emoji_atlas.img.header.h = cell_h * rows;
+    emoji_atlas.img.data_size = size;
+
+    /*Unknown or unsupported emoji are dropped from list*/
+    for (i = 0, n = 0; i < num; i++)
+    {
+        if ((i > 0) && (emoji_atlas.unicode[i] == emoji_atlas.unicode[i - 1]))
+            continue;
+        src = lv_get_emoji_by_unicode(emoji_atlas.unicode[i]);
+        if (src && atlas_add(n, src))
+            emoji_atlas.unicode[n++] = emoji_atlas.unicode[i];
+    }
+    emoji_atlas.num = n;
+
+    return n;
+}
+
+void lv_emoji_atlas_free(void)
+{
+    if (emoji_atlas.img.data)
+    {
+        lv_img_cache_invalidate_src(&emoji_atlas.img);
+        lv_mem_free((void *)emoji_atlas.img.data);
+    }
+    if (emoji_atlas.unicode)
+        lv_mem_free(emoji_atlas.unicode);
+    memset(&emoji_atlas, 0, sizeof(emoji_atlas));
+}
+
+const lv_img_dsc_t *lv_emoji_atlas_get(uint32_t u_letter, lv_area_t *cell)
+{
+    int32_t lo = 0, hi = (int32_t)emoji_atlas.num - 1, mid;
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) >> 1;
+        if (emoji_atlas.unicode[mid] == u_letter)
+        {
+            if (cell)
+            {
+                cell->x1 = (mid % LV_EMOJI_ATLAS_COLS) * emoji_atlas.cell_w;
+                cell->y1 = (mid / LV_EMOJI_ATLAS_COLS) * emoji_atlas.cell_h;
+                cell->x2 = cell->x1 + emoji_atlas.cell_w - 1;
+                cell->y2 = cell->y1 + emoji_atlas.cell_h - 1;
+            }
+            return &emoji_atlas.img;
+        }
+        if (emoji_atlas.unicode[mid] < u_letter)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return NULL;
+}
+
+uint32_t lv_emoji_atlas_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_dsc_t *dsc, const lv_point_t *pos,
+                             const uint32_t *letters, uint32_t num)
+{
+    const lv_area_t *clip_ori = draw_ctx->clip_area;
+    lv_area_t cell, dest, clip, coords;
+    uint32_t i;
+
+    coords.y1 = pos->y;
+    dest.y1 = pos->y;
+    dest.y2 = pos->y + emoji_atlas.cell_h - 1;
+    dest.x1 = pos->x;
+    for (i = 0; i < num; i++)
+    {
+        if (!lv_emoji_atlas_get(letters[i], &cell))
+            break;
+
+        dest.x2 = dest.x1 + emoji_atlas.cell_w - 1;
+        if (_lv_area_intersect(&clip, clip_ori, &dest))
+        {
+            /*Whole atlas is placed so that the cell covers dest, clip selects the cell*/
+            coords.x1 = dest.x1 - cell.x1;
+            coords.y1 = dest.y1 - cell.y1;
+            coords.x2 = coords.x1 + emoji_atlas.img.header.w - 1;
+            coords.y2 = coords.y1 + emoji_atlas.img.header.h - 1;
+            draw_ctx->clip_area = &clip;
+            lv_draw_img(draw_ctx, dsc, &coords, &emoji_atlas.img);
+        }
+        dest.x1 = dest.x2 + 1;
+    }
+    draw_ctx->clip_area = clip_ori;
+
+    return i;
+}
+#endif /* LVGL_VERSION_MAJOR == 8 */
+
 
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -46,8 +46,44 @@
 #ifndef LVSF_EMOJI_H
 #define LVSF_EMOJI_H
 
+#include "lvgl.h"
+
 void *lv_get_emoji_by_unicode(uint32_t u_letter);
 
+#if LVGL_VERSION_MAJOR == 8
+/**
+ * @brief Pack emoji into one atlas image, previous atlas is freed
+ * @param letters unicode of emoji, e.g. most used ones
+ * @param num number of letters
+ * @param cell_w max width of emoji
+ * @param cell_h max height of emoji
+ * @return number of emoji in atlas, -1 if no memory
+ */
+int lv_emoji_atlas_build(const uint32_t *letters, uint32_t num, lv_coord_t cell_w, lv_coord_t cell_h);
+
+void lv_emoji_atlas_free(void);
+
+/**
+ * @brief Get atlas image and area of emoji in it
+ * @param u_letter unicode of emoji
+ * @param cell area of emoji in atlas, can be NULL
+ * @return atlas image, NULL if emoji is not in atlas
+ */
+const lv_img_dsc_t *lv_emoji_atlas_get(uint32_t u_letter, lv_area_t *cell);
+
+/**
+ * @brief Draw a run of emoji from atlas side by side
+ * @param draw_ctx draw context
+ * @param dsc image draw descriptor
+ * @param pos top left of first emoji
+ * @param letters unicode of emoji
+ * @param num number of letters
+ * @return number of emoji drawn, it stops at first one not in atlas
+ */
+uint32_t lv_emoji_atlas_draw(lv_draw_ctx_t *draw_ctx, const lv_draw_img_dsc_t *dsc, const lv_point_t *pos,
+                             const uint32_t *letters, uint32_t num);
+#endif /* LVGL_VERSION_MAJOR == 8 */
+
 
 #endif /* LVSF_EMOJI_H */
 
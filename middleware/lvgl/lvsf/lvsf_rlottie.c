@@ -35,6 +35,15 @@
  *********************/
 #define MY_CLASS &lv_rlottie_class
 
+/*Max PSRAM for rendered frames of one animation*/
+#ifndef LV_RLOTTIE_FRAME_CACHE_BUDGET
+    #define LV_RLOTTIE_FRAME_CACHE_BUDGET   (1024 * 1024)
+#endif
+/*Render size is divided by 2^SHIFT in downscale mode*/
+#ifndef LV_RLOTTIE_DOWNSCALE_SHIFT
+    #define LV_RLOTTIE_DOWNSCALE_SHIFT      1
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -51,6 +60,11 @@ typedef struct
     size_t allocated_buffer_size;
     size_t scanline_width;
     void *file_data;
+    lv_rlottie_policy_t policy;
+    uint8_t *frame_cache;       /*total_frames rendered frames in LVGL format*/
+    uint8_t *frame_done;        /*Bitmap of frames in frame_cache*/
+    size_t frame_size;
+    size_t frame_done_cnt;
 } lvsf_rlottie_t;
 
 /**********************
@@ -79,6 +93,41 @@ const lv_obj_class_t lv_rlottie_class =
  *   GLOBAL FUNCTIONS
  **********************/
 
+static void rlottie_release_buf(lvsf_rlottie_t *ext)
+{
+    lv_img_cache_invalidate_src(&ext->imgdsc);
+    if (ext->allocated_buf)
+        app_cache_free(ext->allocated_buf);
+    ext->allocated_buf = NULL;
+    ext->allocated_buffer_size = 0;
+    if (ext->frame_cache)
+        app_cache_free(ext->frame_cache);
+    ext->frame_cache = NULL;
+    if (ext->frame_done)
+        rt_free(ext->frame_done);
+    ext->frame_done = NULL;
+    ext->frame_done_cnt = 0;
+}
+
+static void rlottie_setup_frame_cache(lvsf_rlottie_t *ext, lv_coord_t w, lv_coord_t h)
+{
+    ext->frame_size = (size_t)w * h * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    if ((0 == ext->total_frames) || (ext->total_frames * ext->frame_size > LV_RLOTTIE_FRAME_CACHE_BUDGET))
+        return;
+
+    ext->frame_done = rt_malloc((ext->total_frames + 7) / 8);
+    if (!ext->frame_done)
+        return;
+    memset(ext->frame_done, 0, (ext->total_frames + 7) / 8);
+
+    ext->frame_cache = app_cache_alloc(ext->total_frames * ext->frame_size, IMAGE_CACHE_PSRAM);
+    if (!ext->frame_cache)
+    {
+        rt_free(ext->frame_done);
+        ext->frame_done = NULL;
+    }
+}
+
 static void common_rlottie_setup(lvsf_rlottie_t *ext, lv_obj_t *parent)
 {
     lv_obj_update_layout((const lv_obj_t *) ext);
@@ -88,6 +137,22 @@ static void common_rlottie_setup(lvsf_rlottie_t *ext, lv_obj_t *parent)
 
     lv_coord_t obj_width = lv_obj_get_width(parent);
     lv_coord_t obj_height = lv_obj_get_height(parent);
+    uint8_t shift = 0;
+
+    if ((LV_RLOTTIE_POLICY_CACHE == ext->policy) || (LV_RLOTTIE_POLICY_AUTO == ext->policy))
+        rlottie_setup_frame_cache(ext, obj_width, obj_height);
+
+    if ((LV_RLOTTIE_POLICY_DOWNSCALE == ext->policy)
+            || ((LV_RLOTTIE_POLICY_AUTO == ext->policy) && !ext->frame_cache))
+    {
+        shift = LV_RLOTTIE_DOWNSCALE_SHIFT;
+        obj_width  = (obj_width + (1 << shift) - 1) >> shift;
+        obj_height = (obj_height + (1 << shift) - 1) >> shift;
+        /*GPU scales it up from top left, object keeps its size*/
+        lv_obj_set_size((lv_obj_t *)ext, lv_obj_get_width(parent), lv_obj_get_height(parent));
+        lv_img_set_pivot((lv_obj_t *)ext, 0, 0);
+        lv_img_set_zoom((lv_obj_t *)ext, LV_IMG_ZOOM_NONE << shift);
+    }
 
     ext->scanline_width = obj_width * ARGB888_PIXEL_SIZE;
     size_t allocaled_buf_size = (obj_width * obj_height * ARGB888_PIXEL_SIZE);
@@ -106,8 +171,6 @@ static void common_rlottie_setup(lvsf_rlottie_t *ext, lv_obj_t *parent)
     ext->imgdsc.data_size = lv_img_buf_get_img_size(ext->imgdsc.header.w, ext->imgdsc.header.h, ext->imgdsc.header.cf);
 
     lv_img_set_src((lv_obj_t *)ext, &ext->imgdsc);
-
-    int period = (int)1000.0 / ext->framerate;
 }
 
 lv_obj_t *lv_rlottie_create(lv_obj_t *parent)
@@ -163,6 +226,7 @@ int lv_rlottie_raw(lv_obj_t *lottie, const char *rlottie_desc)
     ext->animation = lottie_animation_from_data(rlottie_desc, rlottie_desc, "");
 #endif
     if (ext->animation == NULL) return -RT_ERROR;
+    rlottie_release_buf(ext);
     common_rlottie_setup(ext,  lottie);
     return RT_EOK;
 }
@@ -186,6 +250,23 @@ int lv_rlottie_play(lv_obj_t *lottie, int enable)
     return RT_EOK;
 }
 
+int lv_rlottie_set_policy(lv_obj_t *lottie, lv_rlottie_policy_t policy)
+{
+    lvsf_rlottie_t *ext = (lvsf_rlottie_t *)lottie;
+
+    if (policy == ext->policy)
+        return RT_EOK;
+
+    ext->policy = policy;
+    if (ext->animation)
+    {
+        rlottie_release_buf(ext);
+        common_rlottie_setup(ext, lottie);
+    }
+
+    return RT_EOK;
+}
+
 
 /**********************
  *   STATIC FUNCTIONS
@@ -205,9 +286,7 @@ static void lv_rlottie_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
         lv_timer_del(ext->task);
     if (ext->animation)
         lottie_animation_destroy(ext->animation);
-    lv_img_cache_invalidate_src(&ext->imgdsc);
-    if (ext->allocated_buf)
-        app_cache_free(ext->allocated_buf);
+    rlottie_release_buf(ext);
     if (ext->file_data)
         app_cache_free(ext->file_data);
 }
@@ -267,10 +346,38 @@ static void next_frame_task_cb(lv_timer_t *t)
     }
 
     lvsf_rlottie_t *ext = (lvsf_rlottie_t *)t->user_data;
-    if (ext->current_frame == ext->total_frames)
+    if (++ext->current_frame >= ext->total_frames)
         ext->current_frame = 0;
-    else
-        ++ext->current_frame;
+
+    if (ext->frame_cache)
+    {
+        uint8_t *frame = ext->frame_cache + ext->current_frame * ext->frame_size;
+        uint8_t bit = 1 << (ext->current_frame & 7);
+
+        if (0 == (ext->frame_done[ext->current_frame >> 3] & bit))
+        {
+            lottie_animation_render(ext->animation, ext->current_frame, ext->allocated_buf,
+                                    ext->imgdsc.header.w, ext->imgdsc.header.h, ext->scanline_width);
+#if LV_COLOR_DEPTH == 16
+            convert_to_rgba5658(ext->allocated_buf, ext->imgdsc.header.w, ext->imgdsc.header.h);
+#endif
+            memcpy(frame, ext->allocated_buf, ext->frame_size);
+            ext->frame_done[ext->current_frame >> 3] |= bit;
+
+            if (++ext->frame_done_cnt == ext->total_frames)
+            {
+                /*All frames cached, render buffer is no longer needed*/
+                app_cache_free(ext->allocated_buf);
+                ext->allocated_buf = NULL;
+                ext->allocated_buffer_size = 0;
+            }
+        }
+
+        /*Image cache keeps data pointer of variable image*/
+        lv_img_cache_invalidate_src(&ext->imgdsc);
+        ext->imgdsc.data = frame;
+        goto refresh;
+    }
 
     lottie_animation_render(
         ext->animation,
@@ -285,6 +392,7 @@ static void next_frame_task_cb(lv_timer_t *t)
     convert_to_rgba5658(ext->allocated_buf, ext->imgdsc.header.w, ext->imgdsc.header.h);
 #endif
 
+refresh:
 #ifdef DISABLE_LVGL_V9
     lv_event_send((lv_obj_t *)ext, LV_EVENT_LEAVE, NULL);
 #else
@@ -313,5 +421,10 @@ int lv_rlottie_play(lv_obj_t *lottie, int enable)
 {
     return -RT_ERROR;
 }
+
+int lv_rlottie_set_policy(lv_obj_t *lottie, lv_rlottie_policy_t policy)
+{
+    return -RT_ERROR;
+}
 #endif
 
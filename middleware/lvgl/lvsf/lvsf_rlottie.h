@@ -19,6 +19,15 @@ extern "C" {
  *********************/
 extern const lv_obj_class_t lv_rlottie_class;
 
+/** Trade CPU time against memory per animation */
+typedef enum
+{
+    LV_RLOTTIE_POLICY_RENDER,       /**< Render every frame at full size (default) */
+    LV_RLOTTIE_POLICY_CACHE,        /**< Keep rendered frames if all fit LV_RLOTTIE_FRAME_CACHE_BUDGET, else render */
+    LV_RLOTTIE_POLICY_DOWNSCALE,    /**< Render at reduced size and let GPU scale it up */
+    LV_RLOTTIE_POLICY_AUTO,         /**< CACHE if frames fit the budget, else DOWNSCALE */
+} lv_rlottie_policy_t;
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -35,6 +44,11 @@ int lv_rlottie_raw(lv_obj_t *lottie, const char *rlottie_desc);
 
 int lv_rlottie_play(lv_obj_t *lottie, int enable);
 
+/**
+ * Set frame policy, animation already loaded is set up again
+ */
+int lv_rlottie_set_policy(lv_obj_t *lottie, lv_rlottie_policy_t policy);
+
 /**********************
  *      MACROS
  **********************/
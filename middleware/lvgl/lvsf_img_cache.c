@@ -0,0 +1,255 @@
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include "lvsf_img_cache.h"
+
+#if __has_include("app_mem.h")
+    #include "app_mem.h"
+    #define IMG_CACHE_DATA_ALLOC(size)  app_cache_alloc(size, IMAGE_CACHE_PSRAM)
+    #define IMG_CACHE_DATA_FREE(p)      app_cache_free(p)
+#else
+    #define IMG_CACHE_DATA_ALLOC(size)  rt_malloc(size)
+    #define IMG_CACHE_DATA_FREE(p)      rt_free(p)
+#endif
+
+#define DBG_TAG "img_cache"
+#define DBG_LVL DBG_INFO
+#include "rtdbg.h"
+
+typedef struct
+{
+    rt_list_t list;     /*Head is most recently used*/
+    uint32_t hash;
+    uint32_t mtime;
+    uint32_t size;
+    uint32_t epoch;     /*Screen epoch of last use*/
+    uint16_t ref;
+    void *data;
+    char path[0];
+} img_cache_entry_t;
+
+static rt_list_t cache_list = RT_LIST_OBJECT_INIT(cache_list);
+static uint32_t cache_budget = LVSF_IMG_CACHE_BUDGET;
+static uint32_t cache_epoch = 1;
+static lvsf_img_cache_stat_t cache_stat;
+
+static uint32_t path_hash(const char *path)
+{
+    uint32_t h = 5381;
+
+    while (*path)
+        h = (h << 5) + h + (uint8_t) * path++;
+
+    return h;
+}
+
+static inline bool is_pinned(img_cache_entry_t *e)
+{
+    return (e->ref > 0) || (e->epoch == cache_epoch);
+}
+
+static void entry_free(img_cache_entry_t *e)
+{
+    rt_list_remove(&e->list);
+    cache_stat.bytes -= e->size;
+    cache_stat.entries--;
+    IMG_CACHE_DATA_FREE(e->data);
+    rt_free(e);
+}
+
+static img_cache_entry_t *entry_find_data(const void *data)
+{
+    img_cache_entry_t *e;
+
+    rt_list_for_each_entry(e, &cache_list, list)
+    {
+        if (e->data == data)
+            return e;
+    }
+
+    return RT_NULL;
+}
+
+/*Evict LRU entries until need bytes fit in budget*/
+static void cache_trim(uint32_t need)
+{
+    img_cache_entry_t *e, *n;
+
+    for (e = rt_list_entry(cache_list.prev, img_cache_entry_t, list);
+            (&e->list != &cache_list) && (cache_stat.bytes + need > cache_budget);
+            e = n)
+    {
+        n = rt_list_entry(e->list.prev, img_cache_entry_t, list);
+
+        if (is_pinned(e))
+            continue;
+
+        LOG_D("evict %s %d", e->path, e->size);
+        entry_free(e);
+        cache_stat.evict++;
+    }
+}
+
+void *lvsf_img_cache_lookup(const char *path, uint32_t mtime, uint32_t size)
+{
+    img_cache_entry_t *e;
+    uint32_t hash = path_hash(path);
+
+    RT_ASSERT(path);
+
+    rt_list_for_each_entry(e, &cache_list, list)
+    {
+        if ((e->hash == hash) && (e->size == size) && (0 == strcmp(e->path, path)))
+        {
+            if (e->mtime != mtime)
+            {
+                /*File changed, drop stale data if nobody is using it*/
+                if (0 == e->ref) entry_free(e);
+                break;
+            }
+
+            e->ref++;
+            e->epoch = cache_epoch;
+            rt_list_remove(&e->list);
+            rt_list_insert_after(&cache_list, &e->list);
+            cache_stat.hit++;
+            return e->data;
+        }
+    }
+
+    cache_stat.miss++;
+    return RT_NULL;
+}
+
+void *lvsf_img_cache_alloc(const char *path, uint32_t mtime, uint32_t size)
+{
+    img_cache_entry_t *e;
+    uint32_t path_len;
+
+    RT_ASSERT(path);
+
+    cache_trim(size);
+
+    path_len = strlen(path);
+    e = rt_malloc(sizeof(img_cache_entry_t) + path_len + 1);
+    if (RT_NULL == e)
+        return RT_NULL;
+
+    e->data = IMG_CACHE_DATA_ALLOC(size);
+    if (RT_NULL == e->data)
+    {
+        /*Retry after dropping all entries not in use*/
+        lvsf_img_cache_flush();
+        e->data = IMG_CACHE_DATA_ALLOC(size);
+    }
+    if (RT_NULL == e->data)
+    {
+        rt_free(e);
+        return RT_NULL;
+    }
+
+    memcpy(e->path, path, path_len + 1);
+    e->hash = path_hash(path);
+    e->mtime = mtime;
+    e->size = size;
+    e->ref = 1;
+    e->epoch = cache_epoch;
+    rt_list_insert_after(&cache_list, &e->list);
+    cache_stat.bytes += size;
+    cache_stat.entries++;
+
+    return e->data;
+}
+
+void lvsf_img_cache_release(const void *data)
+{
+    img_cache_entry_t *e = entry_find_data(data);
+
+    RT_ASSERT(e && (e->ref > 0));
+    e->ref--;
+
+    /*Over budget by entries which were pinned at alloc*/
+    if (cache_stat.bytes > cache_budget)
+        cache_trim(0);
+}
+
+void lvsf_img_cache_discard(const void *data)
+{
+    img_cache_entry_t *e = entry_find_data(data);
+
+    RT_ASSERT(e && (1 == e->ref));
+    entry_free(e);
+}
+
+void lvsf_img_cache_screen_changed(void)
+{
+    cache_epoch++;
+    if (0 == cache_epoch) cache_epoch = 1;
+
+    if (cache_stat.bytes > cache_budget)
+        cache_trim(0);
+}
+
+void lvsf_img_cache_set_budget(uint32_t bytes)
+{
+    cache_budget = bytes;
+    cache_trim(0);
+}
+
+void lvsf_img_cache_flush(void)
+{
+    img_cache_entry_t *e, *n;
+
+    rt_list_for_each_entry_safe(e, n, &cache_list, list)
+    {
+        if (0 == e->ref)
+            entry_free(e);
+    }
+}
+
+void lvsf_img_cache_get_stat(lvsf_img_cache_stat_t *stat, bool reset)
+{
+    img_cache_entry_t *e;
+
+    RT_ASSERT(stat);
+
+    cache_stat.budget = cache_budget;
+    cache_stat.pinned = 0;
+    rt_list_for_each_entry(e, &cache_list, list)
+    {
+        if (is_pinned(e))
+            cache_stat.pinned++;
+    }
+
+    memcpy(stat, &cache_stat, sizeof(*stat));
+
+    if (reset)
+    {
+        cache_stat.hit = 0;
+        cache_stat.miss = 0;
+        cache_stat.evict = 0;
+    }
+}
+
+#ifdef RT_USING_FINSH
+static rt_err_t img_cache(int argc, char **argv)
+{
+    lvsf_img_cache_stat_t stat;
+
+    if (argc > 2 && 0 == strcmp(argv[1], "budget"))
+    {
+        lvsf_img_cache_set_budget(strtoul(argv[2], 0, 10));
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "flush"))
+    {
+        lvsf_img_cache_flush();
+    }
+
+    lvsf_img_cache_get_stat(&stat, argc > 1 && 0 == strcmp(argv[1], "reset"));
+    rt_kprintf("hit=%d miss=%d evict=%d\n", stat.hit, stat.miss, stat.evict);
+    rt_kprintf("entries=%d pinned=%d bytes=%d/%d\n", stat.entries, stat.pinned, stat.bytes, stat.budget);
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(img_cache, img_cache [budget <bytes>|flush|reset]);
+#endif /* RT_USING_FINSH */
@@ -0,0 +1,78 @@
+#ifndef LVSF_IMG_CACHE_H
+#define LVSF_IMG_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Image data cache shared by v8/v9 file image decoders.
+
+    Image data loaded from file system is kept in PSRAM after decoder closed,
+    entries are keyed by path, mtime and size and evicted in LRU order when
+    total size exceeds budget. Entries in use or used since last
+    lvsf_img_cache_screen_changed() (i.e. by the active screen) are never evicted.
+
+    Must be called from GUI thread.
+*/
+
+#ifndef LVSF_IMG_CACHE_BUDGET
+    #define LVSF_IMG_CACHE_BUDGET   (512 * 1024)
+#endif
+
+typedef struct
+{
+    uint32_t hit;
+    uint32_t miss;
+    uint32_t evict;
+    uint32_t bytes;     /**< Bytes of all entries */
+    uint32_t budget;
+    uint16_t entries;
+    uint16_t pinned;    /**< Entries in use or used by active screen */
+} lvsf_img_cache_stat_t;
+
+/**
+ * @brief Find cached image data and take a reference
+ * @return image data, NULL if not cached
+ */
+void *lvsf_img_cache_lookup(const char *path, uint32_t mtime, uint32_t size);
+
+/**
+ * @brief Allocate a referenced entry for image not cached, caller fills the data then.
+ *        LRU entries are evicted to make room.
+ * @return data buffer of size bytes, NULL if out of memory
+ */
+void *lvsf_img_cache_alloc(const char *path, uint32_t mtime, uint32_t size);
+
+/**
+ * @brief Drop reference returned by lookup or alloc, data stays cached.
+ */
+void lvsf_img_cache_release(const void *data);
+
+/**
+ * @brief Drop reference and free entry, e.g. if data failed to load
+ */
+void lvsf_img_cache_discard(const void *data);
+
+/**
+ * @brief Mark start of a new screen, entries used by previous screen become evictable
+ */
+void lvsf_img_cache_screen_changed(void);
+
+void lvsf_img_cache_set_budget(uint32_t bytes);
+
+/**
+ * @brief Free all entries not in use
+ */
+void lvsf_img_cache_flush(void);
+
+void lvsf_img_cache_get_stat(lvsf_img_cache_stat_t *stat, bool reset);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LVSF_IMG_CACHE_H*/
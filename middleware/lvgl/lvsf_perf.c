@@ -178,16 +178,21 @@ const static obj2nameTypedef obj2name_array[] =
 };
 
 
-const char *get_obj_name(const lv_obj_t *obj)
+static const char *get_class_name(const lv_obj_class_t *class_p)
 {
     for (uint32_t i = 0; i < (sizeof(obj2name_array) / sizeof(obj2name_array[0])); i++)
-        if (lv_obj_check_type(obj, obj2name_array[i].class_p))
+        if (class_p == obj2name_array[i].class_p)
             return obj2name_array[i].name;
 
 
     return "Unknow";
 }
 
+const char *get_obj_name(const lv_obj_t *obj)
+{
+    return get_class_name(obj->class_p);
+}
+
 #ifdef PKG_USING_SYSTEMVIEW
 #include "SEGGER_SYSVIEW.h"
 #include "lv_gc.h"
@@ -739,6 +744,336 @@ void lv_debug_init(void)
     _lv_debug_register_lcd_flush_evt();
 }
 
+#elif defined(LVSF_PERF_FRAME_STAT)
+#include "rthw.h"
+#if !defined(_MSC_VER)
+    #include "bf0_hal.h"
+#endif
+#ifdef USING_METRICS_COLLECTOR
+    #include "metrics_collector.h"
+    #include "metrics_id_middleware.h"
+#endif /* USING_METRICS_COLLECTOR */
+
+#ifdef DWT
+    #define FRAME_STAT_NOW()        HAL_DBG_DWT_GetCycles()
+    #define FRAME_STAT_US(cycles)   ((cycles) / (SystemCoreClock / 1000000))
+#else
+    #define FRAME_STAT_NOW()        lv_tick_get()
+    #define FRAME_STAT_US(ms)       ((ms) * 1000)
+#endif
+
+#define FRAME_STAT_CLASS_NUM    16
+#define FRAME_STAT_DEPTH_MAX    16
+
+typedef struct
+{
+    uint32_t hist[LVSF_PERF_FRAME_BUCKET_NUM];
+    uint32_t cnt;
+    uint32_t max_us;
+    uint64_t sum_us;
+} frame_stat_hist_t;
+
+typedef struct
+{
+    const lv_obj_class_t *class_p;
+    uint32_t cnt;
+    uint64_t us;    /*Exclusive of children*/
+} frame_stat_class_t;
+
+typedef struct
+{
+    bool en;
+    uint32_t frames;
+    frame_stat_hist_t item[LVSF_PERF_FRAME_NUM];
+    frame_stat_class_t cls[FRAME_STAT_CLASS_NUM];
+
+    /*Frame in progress*/
+    uint32_t cur_us[LVSF_PERF_FRAME_NUM];
+    uint32_t draw_cnt;
+    uint32_t timer_start;
+    uint32_t layout_start;
+    uint32_t gpu_start;
+    uint32_t flush_start;
+    uint32_t draw_start;
+    uint32_t seg_start;
+    uint8_t  depth;
+    int8_t   stack[FRAME_STAT_DEPTH_MAX];  /*Index of cls, -1 if table full*/
+} frame_stat_t;
+
+static frame_stat_t frame_stat = {.en = true};
+
+static void frame_stat_add(lvsf_perf_frame_item_t item, uint32_t us)
+{
+    frame_stat_hist_t *h = &frame_stat.item[item];
+    uint32_t i;
+
+    for (i = 0; i < LVSF_PERF_FRAME_BUCKET_NUM - 1; i++)
+    {
+        if (us < (500UL << i))
+            break;
+    }
+    h->hist[i]++;
+    h->cnt++;
+    h->sum_us += us;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+static int8_t frame_stat_class_idx(const lv_obj_class_t *class_p)
+{
+    int8_t i;
+
+    for (i = 0; i < FRAME_STAT_CLASS_NUM; i++)
+    {
+        if (frame_stat.cls[i].class_p == class_p)
+            return i;
+        if (NULL == frame_stat.cls[i].class_p)
+        {
+            frame_stat.cls[i].class_p = class_p;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void frame_stat_class_charge(uint32_t now)
+{
+    int8_t idx;
+
+    if (0 == frame_stat.depth)
+        return;
+
+    idx = frame_stat.stack[LV_MIN(frame_stat.depth, FRAME_STAT_DEPTH_MAX) - 1];
+    if (idx >= 0)
+        frame_stat.cls[idx].us += FRAME_STAT_US(now - frame_stat.seg_start);
+    frame_stat.seg_start = now;
+}
+
+void lv_debug_task_start_exec(const lv_timer_t *t)
+{
+    if (!frame_stat.en) return;
+
+    frame_stat.timer_start = FRAME_STAT_NOW();
+    if (_lv_disp_refr_timer == t->timer_cb)
+        frame_stat.draw_cnt = 0;
+}
+
+void lv_debug_task_stop_exec(const lv_timer_t *t)
+{
+    uint32_t us, i;
+
+    if (!frame_stat.en) return;
+
+    us = FRAME_STAT_US(FRAME_STAT_NOW() - frame_stat.timer_start);
+    if (_lv_disp_refr_timer != t->timer_cb)
+    {
+        frame_stat.cur_us[LVSF_PERF_FRAME_TIMER] += us;
+        return;
+    }
+
+    /*Nothing drawn, not a frame*/
+    if (0 == frame_stat.draw_cnt)
+        return;
+
+    frame_stat.cur_us[LVSF_PERF_FRAME_TOTAL] = us;
+    for (i = 0; i < LVSF_PERF_FRAME_NUM; i++)
+    {
+        if (LVSF_PERF_FRAME_FLUSH != i)
+            frame_stat_add((lvsf_perf_frame_item_t)i, frame_stat.cur_us[i]);
+        frame_stat.cur_us[i] = 0;
+    }
+    frame_stat.frames++;
+}
+
+void lv_debug_mark_start(uint32_t id, const char *desc)
+{
+    if (!frame_stat.en) return;
+
+    if (0xC1 == id)
+        frame_stat.layout_start = FRAME_STAT_NOW();
+    else if (LV_DEBUG_MARK_GPU_WAIT == id)
+        frame_stat.gpu_start = FRAME_STAT_NOW();
+}
+
+void lv_debug_mark_stop(uint32_t id)
+{
+    if (!frame_stat.en) return;
+
+    /*0xC1~0xC3 are layout of screen, top and system layer*/
+    if (0xC3 == id)
+        frame_stat.cur_us[LVSF_PERF_FRAME_LAYOUT] += FRAME_STAT_US(FRAME_STAT_NOW() - frame_stat.layout_start);
+    else if (LV_DEBUG_MARK_GPU_WAIT == id)
+        frame_stat.cur_us[LVSF_PERF_FRAME_GPU_WAIT] += FRAME_STAT_US(FRAME_STAT_NOW() - frame_stat.gpu_start);
+}
+
+void lv_debug_lcd_flush_start(int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+    if (!frame_stat.en) return;
+
+    frame_stat.flush_start = FRAME_STAT_NOW();
+}
+
+/*May be called in ISR*/
+void lv_debug_lcd_flush_stop(void)
+{
+    if (!frame_stat.en) return;
+
+    frame_stat_add(LVSF_PERF_FRAME_FLUSH, FRAME_STAT_US(FRAME_STAT_NOW() - frame_stat.flush_start));
+}
+
+void lv_debug_obj_start_draw(const lv_obj_t *obj, const lv_area_t *mask)
+{
+    uint32_t now;
+
+    if (!frame_stat.en) return;
+
+    now = FRAME_STAT_NOW();
+    if (0 == frame_stat.depth)
+    {
+        frame_stat.draw_start = now;
+        frame_stat.seg_start = now;
+        frame_stat.draw_cnt++;
+    }
+    else
+    {
+        frame_stat_class_charge(now);
+    }
+
+    if (frame_stat.depth < FRAME_STAT_DEPTH_MAX)
+    {
+        int8_t idx = frame_stat_class_idx(obj->class_p);
+        frame_stat.stack[frame_stat.depth] = idx;
+        if (idx >= 0)
+            frame_stat.cls[idx].cnt++;
+    }
+    frame_stat.depth++;
+}
+
+void lv_debug_obj_stop_draw(const lv_obj_t *obj, const lv_area_t *mask)
+{
+    uint32_t now;
+
+    if (!frame_stat.en || (0 == frame_stat.depth)) return;
+
+    now = FRAME_STAT_NOW();
+    frame_stat_class_charge(now);
+    frame_stat.depth--;
+    if (0 == frame_stat.depth)
+        frame_stat.cur_us[LVSF_PERF_FRAME_DRAW] += FRAME_STAT_US(now - frame_stat.draw_start);
+}
+
+uint32_t lvsf_perf_frame_percentile(lvsf_perf_frame_item_t item, uint32_t pct)
+{
+    frame_stat_hist_t *h = &frame_stat.item[item];
+    uint32_t i, sum = 0;
+
+    RT_ASSERT(item < LVSF_PERF_FRAME_NUM);
+
+    for (i = 0; i < LVSF_PERF_FRAME_BUCKET_NUM - 1; i++)
+    {
+        sum += h->hist[i];
+        if (sum * 100 >= h->cnt * pct)
+            break;
+    }
+
+    return (i < LVSF_PERF_FRAME_BUCKET_NUM - 1) ? (500UL << i) : h->max_us;
+}
+
+void lvsf_perf_frame_reset(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    frame_stat.frames = 0;
+    memset(frame_stat.item, 0, sizeof(frame_stat.item));
+    memset(frame_stat.cls, 0, sizeof(frame_stat.cls));
+    rt_hw_interrupt_enable(level);
+}
+
+#if defined(FINSH_USING_MSH)&&!defined(PY_GEN)
+static void frame_stat_dump(void)
+{
+    static const char *const item_name[LVSF_PERF_FRAME_NUM] = {"timer", "layout", "draw", "gpu_wait", "flush", "frame"};
+    frame_stat_hist_t *h;
+    uint32_t i, j;
+
+    rt_kprintf("frames=%d, buckets <0.5,1,2,4,8,16,32ms,more\n", frame_stat.frames);
+    for (i = 0; i < LVSF_PERF_FRAME_NUM; i++)
+    {
+        h = &frame_stat.item[i];
+        rt_kprintf("%-8s avg=%dus p50=%dus p90=%dus p99=%dus max=%dus |", item_name[i],
+                   h->cnt ? (uint32_t)(h->sum_us / h->cnt) : 0,
+                   lvsf_perf_frame_percentile((lvsf_perf_frame_item_t)i, 50),
+                   lvsf_perf_frame_percentile((lvsf_perf_frame_item_t)i, 90),
+                   lvsf_perf_frame_percentile((lvsf_perf_frame_item_t)i, 99),
+                   h->max_us);
+        for (j = 0; j < LVSF_PERF_FRAME_BUCKET_NUM; j++)
+            rt_kprintf(" %d", h->hist[j]);
+        rt_kprintf("\n");
+    }
+
+    for (i = 0; (i < FRAME_STAT_CLASS_NUM) && frame_stat.cls[i].class_p; i++)
+    {
+        rt_kprintf("%-16s draw=%d %dus\n", get_class_name(frame_stat.cls[i].class_p), frame_stat.cls[i].cnt,
+                   (uint32_t)frame_stat.cls[i].us);
+    }
+}
+#endif /* FINSH_USING_MSH && !PY_GEN */
+
+#ifdef USING_METRICS_COLLECTOR
+static mc_collector_t frame_stat_collector;
+
+static void frame_stat_metrics_collect(void *user_data)
+{
+    lvsf_perf_frame_metrics_t *metrics;
+    uint32_t i, j;
+
+    if (0 == frame_stat.frames)
+        return;
+
+    metrics = mc_alloc_metrics(METRICS_MW_GUI_FRAME_STAT, sizeof(lvsf_perf_frame_metrics_t));
+    RT_ASSERT(metrics);
+    metrics->frames = frame_stat.frames;
+    for (i = 0; i < LVSF_PERF_FRAME_NUM; i++)
+    {
+        for (j = 0; j < LVSF_PERF_FRAME_BUCKET_NUM; j++)
+            metrics->hist[i][j] = (uint16_t)LV_MIN(frame_stat.item[i].hist[j], UINT16_MAX);
+        metrics->max_ms[i] = (uint16_t)LV_MIN(frame_stat.item[i].max_us / 1000, UINT16_MAX);
+    }
+    lvsf_perf_frame_reset();
+    mc_save_metrics(metrics, true);
+}
+
+static int frame_stat_metrics_init(void)
+{
+    mc_err_t err;
+
+    frame_stat_collector.callback = frame_stat_metrics_collect;
+    frame_stat_collector.period = MC_PERIOD_EVERY_HOUR;
+    frame_stat_collector.user_data = 0;
+
+    err = mc_register_collector(&frame_stat_collector);
+    RT_ASSERT(MC_OK == err);
+    return 0;
+}
+INIT_APP_EXPORT(frame_stat_metrics_init);
+#endif /* USING_METRICS_COLLECTOR */
+
+void lv_debug_enable(bool enable)
+{
+    frame_stat.en = enable;
+    frame_stat.depth = 0;
+}
+
+void lv_debug_init(void)
+{
+#ifdef DWT
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+#endif
+}
+INIT_COMPONENT_EXPORT(lv_debug_init);
+
 #else
 
 void lv_debug_enable(bool enable)
@@ -752,11 +1087,58 @@ void lv_debug_init(void)
 #endif
 
 
+static lvsf_perf_cache_t *perf_cache_list;
+
+void lvsf_perf_cache_register(lvsf_perf_cache_t *cache)
+{
+    lvsf_perf_cache_t *iter;
+
+    for (iter = perf_cache_list; iter; iter = iter->next)
+    {
+        if (iter == cache)
+            return;
+    }
+
+    cache->next = perf_cache_list;
+    perf_cache_list = cache;
+}
+
+static lvsf_perf_redraw_t *perf_redraw_list;
+
+void lvsf_perf_redraw_register(lvsf_perf_redraw_t *redraw)
+{
+    lvsf_perf_redraw_t *iter;
+
+    for (iter = perf_redraw_list; iter; iter = iter->next)
+    {
+        if (iter == redraw)
+            return;
+    }
+
+    redraw->next = perf_redraw_list;
+    perf_redraw_list = redraw;
+}
+
+void lvsf_perf_redraw_add(lvsf_perf_redraw_t *redraw, uint32_t pixels)
+{
+    redraw->ticks++;
+    redraw->pixels += pixels;
+    if (pixels > redraw->max_pixels)
+        redraw->max_pixels = pixels;
+}
+
+
 #if defined(FINSH_USING_MSH)&&!defined(PY_GEN)
 #include <finsh.h>
 
 static rt_err_t perf_cfg(int argc, char **argv)
 {
+    if (argc < 2)
+    {
+        rt_kprintf("perf_cfg obj [0|1]|cache [reset]|redraw [reset]|frame [reset]|model [reset|chip <name>|budget <ms>]\n");
+        return 0;
+    }
+
     if (strcmp(argv[1], "obj") == 0)
     {
         if (argc > 2)
@@ -768,6 +1150,63 @@ static rt_err_t perf_cfg(int argc, char **argv)
         }
         rt_kprintf("obj_detail = %d\n", obj_detail);
     }
+    else if (strcmp(argv[1], "cache") == 0)
+    {
+        lvsf_perf_cache_t *iter;
+        uint32_t total;
+
+        for (iter = perf_cache_list; iter; iter = iter->next)
+        {
+            total = iter->hit + iter->miss;
+            rt_kprintf("%-12s hit=%d miss=%d rate=%d%%\n", iter->name, iter->hit, iter->miss,
+                       total ? (iter->hit * 100 / total) : 0);
+            if ((argc > 2) && (strcmp(argv[2], "reset") == 0))
+            {
+                iter->hit = 0;
+                iter->miss = 0;
+            }
+        }
+    }
+    else if (strcmp(argv[1], "redraw") == 0)
+    {
+        lvsf_perf_redraw_t *iter;
+
+        for (iter = perf_redraw_list; iter; iter = iter->next)
+        {
+            rt_kprintf("%-12s ticks=%d avg=%d max=%d pixels\n", iter->name, iter->ticks,
+                       iter->ticks ? (iter->pixels / iter->ticks) : 0, iter->max_pixels);
+            if ((argc > 2) && (strcmp(argv[2], "reset") == 0))
+            {
+                iter->ticks = 0;
+                iter->pixels = 0;
+                iter->max_pixels = 0;
+            }
+        }
+    }
+#ifdef LVSF_PERF_FRAME_STAT
+    else if (strcmp(argv[1], "frame") == 0)
+    {
+        frame_stat_dump();
+        if ((argc > 2) && (strcmp(argv[2], "reset") == 0))
+            lvsf_perf_frame_reset();
+    }
+#endif /* LVSF_PERF_FRAME_STAT */
+#ifdef LVSF_PERF_MODEL
+    else if (strcmp(argv[1], "model") == 0)
+    {
+        if ((argc > 3) && (strcmp(argv[2], "chip") == 0))
+        {
+            if (lvsf_perf_model_set_chip(argv[3]))
+                rt_kprintf("Unknown chip %s\n", argv[3]);
+        }
+        else if ((argc > 3) && (strcmp(argv[2], "budget") == 0))
+            lvsf_perf_model_set_budget(strtoul(argv[3], 0, 10) * 1000);
+        else if ((argc > 2) && (strcmp(argv[2], "reset") == 0))
+            lvsf_perf_model_reset();
+        else
+            lvsf_perf_model_dump();
+    }
+#endif /* LVSF_PERF_MODEL */
 
     return 0;
 }
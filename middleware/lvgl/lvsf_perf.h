@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "lvgl.h"
+#include "lvsf_perf_model.h"
 
 #ifdef PKG_USING_SYSTEMVIEW
 
@@ -87,6 +88,39 @@ extern void lv_debug_vdb_stop_flush(lv_color_t *color_p, const lv_area_t *area);
 #define LV_DEBUG_VDB_START_FLUSH(pixels,area)  lv_debug_vdb_start_flush(pixels,area)
 #define LV_DEBUG_VDB_STOP_FLUSH(pixels,area)   lv_debug_vdb_stop_flush(pixels,area)
 
+#elif defined(LVSF_PERF_FRAME_STAT)
+
+/*On device frame time breakdown, see "perf_cfg frame"*/
+void lv_debug_task_start_exec(const lv_timer_t *t);
+void lv_debug_task_stop_exec(const lv_timer_t *t);
+void lv_debug_mark_start(uint32_t id, const char *desc);
+void lv_debug_mark_stop(uint32_t id);
+void lv_debug_lcd_flush_start(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+void lv_debug_lcd_flush_stop(void);
+
+extern void lv_debug_obj_start_draw(const lv_obj_t *obj, const lv_area_t *mask);
+extern void lv_debug_obj_stop_draw(const lv_obj_t *obj, const lv_area_t *mask);
+
+#define LV_DEBUG_TASK_CREATE(task)
+#define LV_DEBUG_TASK_TERMINATE(task)
+#define LV_DEBUG_TASK_START_EXEC(task) lv_debug_task_start_exec(task)
+#define LV_DEBUG_TASK_STOP_EXEC(task)  lv_debug_task_stop_exec(task)
+
+#define LV_DEBUG_GPU_START(type, p1, p2, output_coords)
+#define LV_DEBUG_GPU_STOP()
+
+#define LV_DEBUG_MARK_START(id,desc)   lv_debug_mark_start(id,desc)
+#define LV_DEBUG_MARK_STOP(id)         lv_debug_mark_stop(id)
+
+#define LV_DEBUG_LCD_FLUSH_START(x1,y1,x2,y2) lv_debug_lcd_flush_start((x1),(y1),(x2),(y2))
+#define LV_DEBUG_LCD_FLUSH_STOP()  lv_debug_lcd_flush_stop()
+
+#define LV_DEBUG_OBJ_START_DRAW(obj,mask) lv_debug_obj_start_draw(obj,mask)
+#define LV_DEBUG_OBJ_STOP_DRAW(obj,mask)  lv_debug_obj_stop_draw(obj,mask)
+
+#define LV_DEBUG_VDB_START_FLUSH(pixels,area)
+#define LV_DEBUG_VDB_STOP_FLUSH(pixels,area)
+
 #else
 
 #define LV_DEBUG_TASK_CREATE(task)
@@ -114,6 +148,76 @@ extern void lv_debug_vdb_stop_flush(lv_color_t *color_p, const lv_area_t *area);
 
 
 
+/*
+    Hit/miss counters of GUI caches (glyph, image etc.), registered ones
+    are listed by "perf_cfg cache [reset]".
+*/
+typedef struct lvsf_perf_cache
+{
+    const char *name;
+    uint32_t hit;
+    uint32_t miss;
+    struct lvsf_perf_cache *next;
+} lvsf_perf_cache_t;
+
+void lvsf_perf_cache_register(lvsf_perf_cache_t *cache);
+
+#define LVSF_PERF_CACHE_HIT(cache)   ((cache)->hit++)
+#define LVSF_PERF_CACHE_MISS(cache)  ((cache)->miss++)
+
+/*
+    Pixels invalidated per update of a widget (e.g. analog clock hands),
+    registered ones are listed by "perf_cfg redraw [reset]".
+*/
+typedef struct lvsf_perf_redraw
+{
+    const char *name;
+    uint32_t ticks;
+    uint32_t pixels;        /**< Sum of all ticks */
+    uint32_t max_pixels;    /**< Max of one tick */
+    struct lvsf_perf_redraw *next;
+} lvsf_perf_redraw_t;
+
+void lvsf_perf_redraw_register(lvsf_perf_redraw_t *redraw);
+void lvsf_perf_redraw_add(lvsf_perf_redraw_t *redraw, uint32_t pixels);
+
+/*Mark id of waiting GPU done*/
+#define LV_DEBUG_MARK_GPU_WAIT  (0xAAAAAAAB)
+
+#ifdef LVSF_PERF_FRAME_STAT
+/*
+    Frame time histograms, bucket i counts durations below (500us << i),
+    the last one counts the rest.
+*/
+#define LVSF_PERF_FRAME_BUCKET_NUM  8
+
+typedef enum
+{
+    LVSF_PERF_FRAME_TIMER,      /**< Timer handlers other than refresh */
+    LVSF_PERF_FRAME_LAYOUT,
+    LVSF_PERF_FRAME_DRAW,       /**< Drawing objects, include GPU wait */
+    LVSF_PERF_FRAME_GPU_WAIT,
+    LVSF_PERF_FRAME_FLUSH,      /**< Per LCD flush, not per frame */
+    LVSF_PERF_FRAME_TOTAL,      /**< Whole refresh timer */
+    LVSF_PERF_FRAME_NUM
+} lvsf_perf_frame_item_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint16_t hist[LVSF_PERF_FRAME_NUM][LVSF_PERF_FRAME_BUCKET_NUM];
+    uint16_t max_ms[LVSF_PERF_FRAME_NUM];
+} lvsf_perf_frame_metrics_t;
+
+/**
+ * @brief Get percentile of an item
+ * @param pct  percentage, e.g. 90
+ * @return upper bound of the bucket the percentile falls in, in us
+ */
+uint32_t lvsf_perf_frame_percentile(lvsf_perf_frame_item_t item, uint32_t pct);
+void lvsf_perf_frame_reset(void);
+#endif /* LVSF_PERF_FRAME_STAT */
+
 #define PRINT_AREA(s,area) //rt_kprintf("%s \t x1y1=%d,%d  x2y2=%d,%d  \n",s,(area)->x1,(area)->y1,(area)->x2,(area)->y2)
 
 #ifdef __cplusplus
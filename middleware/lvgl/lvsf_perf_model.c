@@ -0,0 +1,251 @@
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "lvsf_perf_model.h"
+
+#ifdef LVSF_PERF_MODEL
+
+#ifndef LVSF_PERF_MODEL_BUDGET_MS
+    #define LVSF_PERF_MODEL_BUDGET_MS   (33)
+#endif
+
+#define PERF_MODEL_SCREEN_NUM   (16)
+
+/*Frame buffer is flushed while next frame is rendered*/
+#if defined(LCD_FB_USING_TWO_UNCOMPRESSED) || defined(LCD_FB_USING_TWO_COMPRESSED)
+    #define PERF_MODEL_FB_OVERLAP   1
+#else
+    #define PERF_MODEL_FB_OVERLAP   0
+#endif
+
+/*
+    Nominal values at default clocks, calibrate with "perf_cfg frame" on hardware.
+    px_cycles_x16: fill, copy, blend, transform, grad, mask
+*/
+static const lvsf_perf_model_chip_t chip_table[] =
+{
+    {"sf32lb55x", 240, 12, {16, 16, 32, 64, 32, 48}, 80,  400, 192, 30, 16, 2000},
+    {"sf32lb52x", 240, 12, {16, 16, 32, 64, 32, 48}, 120, 200, 240, 30, 16, 2000},
+    {"sf32lb56x", 240, 10, {16, 16, 24, 48, 24, 32}, 100, 400, 240, 25, 16, 1500},
+    {"sf32lb58x", 240, 10, {16, 16, 24, 48, 24, 32}, 250, 500, 480, 20, 16, 1200},
+};
+
+static const char *const op_name[LVSF_PERF_EPIC_OP_NUM] = {"fill", "copy", "blend", "trans", "grad", "mask"};
+
+typedef struct
+{
+    const void *screen;
+    const char *name;
+    uint32_t frames;
+    uint32_t over_budget;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint64_t epic_us;
+    uint64_t lcdc_us;
+    uint64_t mem_bound_us;      /*Part of epic_us limited by memory bandwidth*/
+    bool reported;
+} perf_model_screen_t;
+
+typedef struct
+{
+    const lvsf_perf_model_chip_t *chip;
+    uint32_t budget_us;
+    perf_model_screen_t screen[PERF_MODEL_SCREEN_NUM];
+    uint32_t op_cnt[LVSF_PERF_EPIC_OP_NUM];
+    uint64_t op_us[LVSF_PERF_EPIC_OP_NUM];
+
+    /*Frame in progress*/
+    uint32_t cur_epic_us;
+    uint32_t cur_lcdc_us;
+    uint32_t cur_mem_bound_us;
+    uint32_t cur_ops;
+} perf_model_t;
+
+static perf_model_t perf_model =
+{
+#if defined(SF32LB52X)
+    .chip = &chip_table[1],
+#elif defined(SF32LB56X)
+    .chip = &chip_table[2],
+#elif defined(SF32LB58X)
+    .chip = &chip_table[3],
+#else
+    .chip = &chip_table[0],
+#endif
+    .budget_us = LVSF_PERF_MODEL_BUDGET_MS * 1000,
+};
+
+void lvsf_perf_model_epic(lvsf_perf_epic_op_t op, uint32_t out_pixels, uint32_t src_bytes, uint32_t fb_bytes)
+{
+    const lvsf_perf_model_chip_t *chip = perf_model.chip;
+    uint32_t compute_us, mem_us, us;
+
+    if (op >= LVSF_PERF_EPIC_OP_NUM)
+        return;
+
+    /*EPIC pipeline and memory run in parallel, the slower one dominates*/
+    compute_us = (uint32_t)((uint64_t)out_pixels * chip->px_cycles_x16[op] / 16 / chip->epic_mhz);
+    mem_us = src_bytes / chip->src_mbps + fb_bytes / chip->fb_mbps;
+    if (mem_us > compute_us)
+    {
+        perf_model.cur_mem_bound_us += mem_us - compute_us;
+        compute_us = mem_us;
+    }
+    us = chip->epic_setup_us + compute_us;
+
+    perf_model.cur_epic_us += us;
+    perf_model.cur_ops++;
+    perf_model.op_cnt[op]++;
+    perf_model.op_us[op] += us;
+}
+
+void lvsf_perf_model_lcdc(uint32_t pixels)
+{
+    const lvsf_perf_model_chip_t *chip = perf_model.chip;
+    uint32_t if_us, mem_us;
+
+    if_us = (uint32_t)((uint64_t)pixels * chip->lcd_bpp / chip->lcdc_mbits);
+    mem_us = pixels * 2 / chip->fb_mbps;
+    perf_model.cur_lcdc_us += chip->lcdc_setup_us + (if_us > mem_us ? if_us : mem_us);
+}
+
+static perf_model_screen_t *find_screen(const void *screen)
+{
+    perf_model_screen_t *s;
+    uint32_t i;
+
+    for (i = 0; i < PERF_MODEL_SCREEN_NUM; i++)
+    {
+        s = &perf_model.screen[i];
+        if (s->screen == screen)
+            return s;
+        if (NULL == s->screen)
+        {
+            s->screen = screen;
+            return s;
+        }
+    }
+    /*Table is full, the last one takes the rest*/
+    return &perf_model.screen[PERF_MODEL_SCREEN_NUM - 1];
+}
+
+void lvsf_perf_model_frame_end(const void *screen)
+{
+    perf_model_screen_t *s;
+    uint32_t render_us, us;
+
+    if ((0 == perf_model.cur_ops) && (0 == perf_model.cur_lcdc_us))
+        return;
+
+    render_us = perf_model.chip->frame_cpu_us + perf_model.cur_epic_us;
+#if PERF_MODEL_FB_OVERLAP
+    us = render_us > perf_model.cur_lcdc_us ? render_us : perf_model.cur_lcdc_us;
+#else
+    us = render_us + perf_model.cur_lcdc_us;
+#endif
+
+    s = find_screen(screen);
+    s->frames++;
+    s->sum_us += us;
+    s->epic_us += perf_model.cur_epic_us;
+    s->lcdc_us += perf_model.cur_lcdc_us;
+    s->mem_bound_us += perf_model.cur_mem_bound_us;
+    if (us > s->max_us)
+        s->max_us = us;
+    if (us > perf_model.budget_us)
+    {
+        s->over_budget++;
+        if (!s->reported)
+        {
+            s->reported = true;
+            rt_kprintf("perf_model: screen %s%p frame %d us (epic %d, lcdc %d) over budget %d us on %s\n",
+                       s->name ? s->name : "", s->screen, us, perf_model.cur_epic_us, perf_model.cur_lcdc_us,
+                       perf_model.budget_us, perf_model.chip->name);
+        }
+    }
+
+    perf_model.cur_epic_us = 0;
+    perf_model.cur_lcdc_us = 0;
+    perf_model.cur_mem_bound_us = 0;
+    perf_model.cur_ops = 0;
+}
+
+void lvsf_perf_model_name_screen(const void *screen, const char *name)
+{
+    find_screen(screen)->name = name;
+}
+
+int lvsf_perf_model_set_chip(const char *name)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(chip_table) / sizeof(chip_table[0]); i++)
+    {
+        if (0 == strcmp(chip_table[i].name, name))
+        {
+            perf_model.chip = &chip_table[i];
+            lvsf_perf_model_reset();
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void lvsf_perf_model_set_budget(uint32_t us)
+{
+    uint32_t i;
+
+    perf_model.budget_us = us;
+    for (i = 0; i < PERF_MODEL_SCREEN_NUM; i++)
+        perf_model.screen[i].reported = false;
+}
+
+void lvsf_perf_model_reset(void)
+{
+    const char *name[PERF_MODEL_SCREEN_NUM];
+    uint32_t i;
+
+    /*Keep names, screens are still alive*/
+    for (i = 0; i < PERF_MODEL_SCREEN_NUM; i++)
+        name[i] = perf_model.screen[i].name;
+    memset(perf_model.screen, 0, sizeof(perf_model.screen));
+    memset(perf_model.op_cnt, 0, sizeof(perf_model.op_cnt));
+    memset(perf_model.op_us, 0, sizeof(perf_model.op_us));
+    for (i = 0; i < PERF_MODEL_SCREEN_NUM; i++)
+        perf_model.screen[i].name = name[i];
+}
+
+void lvsf_perf_model_dump(void)
+{
+    perf_model_screen_t *s;
+    uint32_t i;
+
+    rt_kprintf("chip %s, budget %d us, %s\n", perf_model.chip->name, perf_model.budget_us,
+               PERF_MODEL_FB_OVERLAP ? "flush overlapped" : "flush serialized");
+    rt_kprintf("%-18s %6s %8s %8s %8s %8s %8s %6s\n", "screen", "frames", "avg_us", "max_us",
+               "epic_us", "mem_us", "lcdc_us", "over");
+    for (i = 0; i < PERF_MODEL_SCREEN_NUM; i++)
+    {
+        s = &perf_model.screen[i];
+        if (0 == s->frames)
+            continue;
+        if (s->name)
+            rt_kprintf("%-18.18s", s->name);
+        else
+            rt_kprintf("%-18p", s->screen);
+        rt_kprintf(" %6d %8d %8d %8d %8d %8d %6d\n", s->frames, (uint32_t)(s->sum_us / s->frames), s->max_us,
+                   (uint32_t)(s->epic_us / s->frames), (uint32_t)(s->mem_bound_us / s->frames),
+                   (uint32_t)(s->lcdc_us / s->frames), s->over_budget);
+    }
+
+    rt_kprintf("op     count    avg_us\n");
+    for (i = 0; i < LVSF_PERF_EPIC_OP_NUM; i++)
+    {
+        if (perf_model.op_cnt[i])
+            rt_kprintf("%-6s %-8d %d\n", op_name[i], perf_model.op_cnt[i],
+                       (uint32_t)(perf_model.op_us[i] / perf_model.op_cnt[i]));
+    }
+}
+
+#endif /* LVSF_PERF_MODEL */
@@ -0,0 +1,82 @@
+#ifndef LVSF_PERF_MODEL_H
+#define LVSF_PERF_MODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "rtconfig.h"
+
+#ifdef LVSF_PERF_MODEL
+/*
+    Performance model of PC simulator. EPIC ops, LCDC transfer and memory bandwidth
+    are converted to hardware time by per-chip tables, frame time is predicted per screen
+    and listed by "perf_cfg model".
+*/
+typedef enum
+{
+    LVSF_PERF_EPIC_FILL,
+    LVSF_PERF_EPIC_COPY,
+    LVSF_PERF_EPIC_BLEND,
+    LVSF_PERF_EPIC_TRANSFORM,   /**< Blend with rotation or scaling */
+    LVSF_PERF_EPIC_GRAD,
+    LVSF_PERF_EPIC_MASK,        /**< Continuous blend with mask, e.g. text */
+    LVSF_PERF_EPIC_OP_NUM
+} lvsf_perf_epic_op_t;
+
+typedef struct
+{
+    const char *name;
+    uint16_t epic_mhz;
+    uint16_t epic_setup_us;                         /**< Driver and register setup of one op */
+    uint8_t  px_cycles_x16[LVSF_PERF_EPIC_OP_NUM];  /**< EPIC cycles per output pixel, in 1/16 */
+    uint16_t src_mbps;                              /**< Read bandwidth of image source (flash/PSRAM), MB/s */
+    uint16_t fb_mbps;                               /**< Bandwidth of frame buffer memory, MB/s */
+    uint16_t lcdc_mbits;                            /**< LCD interface rate, Mbit/s */
+    uint16_t lcdc_setup_us;                         /**< Per flush area */
+    uint8_t  lcd_bpp;                               /**< Bits per pixel on LCD interface */
+    uint16_t frame_cpu_us;                          /**< Refresh overhead of CPU not covered by ops */
+} lvsf_perf_model_chip_t;
+
+/**
+ * @brief Add one EPIC op to current frame
+ * @param op          op type
+ * @param out_pixels  output pixels
+ * @param src_bytes   bytes read from image source, include A8/A4 masks
+ * @param fb_bytes    bytes read and written in frame buffer, i.e. background read and output write
+ */
+void lvsf_perf_model_epic(lvsf_perf_epic_op_t op, uint32_t out_pixels, uint32_t src_bytes, uint32_t fb_bytes);
+
+/** @brief Add one LCDC flush area of pixels to current frame */
+void lvsf_perf_model_lcdc(uint32_t pixels);
+
+/** @brief Close current frame and charge it to screen, screen is the key of statistics */
+void lvsf_perf_model_frame_end(const void *screen);
+
+/** @brief Name a screen in report, name must be kept by caller */
+void lvsf_perf_model_name_screen(const void *screen, const char *name);
+
+/** @brief Select chip table by name, return 0 if found */
+int lvsf_perf_model_set_chip(const char *name);
+
+/** @brief Frame budget in us, frame over it is reported once per screen */
+void lvsf_perf_model_set_budget(uint32_t us);
+
+void lvsf_perf_model_dump(void);
+void lvsf_perf_model_reset(void);
+
+#define LVSF_PERF_MODEL_EPIC(op, out_pixels, src_bytes, fb_bytes)  lvsf_perf_model_epic(op, out_pixels, src_bytes, fb_bytes)
+#define LVSF_PERF_MODEL_LCDC(pixels)                               lvsf_perf_model_lcdc(pixels)
+#define LVSF_PERF_MODEL_FRAME_END(screen)                          lvsf_perf_model_frame_end(screen)
+#else
+#define LVSF_PERF_MODEL_EPIC(op, out_pixels, src_bytes, fb_bytes)
+#define LVSF_PERF_MODEL_LCDC(pixels)
+#define LVSF_PERF_MODEL_FRAME_END(screen)
+#endif /* LVSF_PERF_MODEL */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LVSF_PERF_MODEL_H*/
@@ -10,6 +10,32 @@
 #define _MODULE_NAME_ "h264"
 #include "log.h"
 
+#ifndef BSP_USING_PC_SIMULATOR
+    #include "bf0_hal.h"
+#endif
+#if defined(BSP_USING_EPIC) && !defined(BSP_USING_PC_SIMULATOR)
+    #include "drv_epic.h"
+    #if defined(EPIC_SUPPORT_YUV) && !defined(DRV_EPIC_NEW_API)
+        #define MEDIA_VIDEO_USING_EPIC  1
+    #endif
+#endif
+
+#ifdef MEDIA_EZIP_DIRECT_FB
+    #if !defined(BSP_USING_EPIC) || defined(BSP_USING_PC_SIMULATOR)
+        #error "MEDIA_EZIP_DIRECT_FB requires BSP_USING_EPIC"
+    #endif
+    #ifndef DRV_EPIC_NEW_API
+        #define MEDIA_EZIP_FB_USING_EPIC  1
+    #endif
+    #ifndef MEDIA_EZIP_FB_SLOTS
+        #define MEDIA_EZIP_FB_SLOTS     2
+    #endif
+    #define MEDIA_EZIP_FB_TIMEOUT_MS    500
+#endif /* MEDIA_EZIP_DIRECT_FB */
+
+/* conversion statistics, per path */
+static media_video_conv_stat_t video_conv_stat;
+
 bool media_video_need_decode(media_cache_t *cache)
 {
     bool ret = true;
@@ -25,6 +51,16 @@ bool media_video_need_decode(media_cache_t *cache)
     return ret;
 }
 
+uint32_t media_pts_to_ms(ffmpeg_handle thiz, int stream_idx, int64_t pts)
+{
+    AVRational ms = {1, 1000};
+
+    if (pts == AV_NOPTS_VALUE || !thiz->fmt_ctx || stream_idx < 0)
+        return 0;
+
+    return (uint32_t)av_rescale_q(pts, thiz->fmt_ctx->streams[stream_idx]->time_base, ms);
+}
+
 int media_decode_video(ffmpeg_handle thiz,
                        int *got_frame,
                        AVPacket *p_AVPacket)
@@ -58,6 +94,7 @@ int media_decode_video(ffmpeg_handle thiz,
 
     if (is_drop_occured)
     {
+        thiz->sync_stat.cache_dropped++;
         LOG_I("video drop");
     }
 
@@ -102,6 +139,14 @@ int media_decode_video(ffmpeg_handle thiz,
         }
         else
         {
+            int64_t pts = av_frame_get_best_effort_timestamp(frame);
+
+            if (pts != AV_NOPTS_VALUE)
+                one_cache->pts_ms = media_pts_to_ms(thiz, thiz->video_stream_idx, pts);
+            else
+                one_cache->pts_ms = (uint32_t)(thiz->sync_stat.decoded * thiz->period_float);
+            thiz->sync_stat.decoded++;
+
             rt_enter_critical();
             rt_slist_remove(&cache->empty_frame_slist, empty);
             rt_slist_append(&cache->decoded_frame_slist, empty);
@@ -327,6 +372,221 @@ void media_cache_deinit(media_cache_t *cache, int cache_num)
     }
 }
 
+static int media_video_pixel_size(int fmt)
+{
+    if (fmt == IMG_DESC_FMT_RGB565)
+        return 2;
+    if (fmt == IMG_DESC_FMT_RGB888)
+        return 3;
+    if (fmt == IMG_DESC_FMT_ARGB8888)
+        return 4;
+    return 0;
+}
+
+static uint32_t video_conv_time_us(void)
+{
+#ifdef BSP_USING_PC_SIMULATOR
+    return rt_tick_get() * (1000000 / RT_TICK_PER_SECOND);
+#else
+    return (uint32_t)((uint64_t)HAL_GTIMER_READ() * 1000000 / HAL_LPTIM_GetFreq());
+#endif
+}
+
+static void video_conv_stat_add(uint32_t start, uint8_t by_epic)
+{
+    uint32_t us = video_conv_time_us() - start;
+
+    if (by_epic)
+    {
+        video_conv_stat.epic_frames++;
+        video_conv_stat.epic_us += us;
+    }
+    else
+    {
+        video_conv_stat.sw_frames++;
+        video_conv_stat.sw_us += us;
+    }
+}
+
+#ifdef MEDIA_VIDEO_USING_EPIC
+/*
+    yuv420p to rgb in one EPIC pass, frame is scaled to fit out area and rotated around its center,
+    area not covered by frame is filled with black
+*/
+static int media_video_epic_convert(media_video_out_t *out, AVFrame *frame, int fmt)
+{
+    EPIC_LayerConfigTypeDef input_layer;
+    EPIC_LayerConfigTypeDef output_canvas;
+    uint32_t out_cf;
+    uint32_t src_w = frame->width;
+    uint32_t src_h = frame->height;
+    uint32_t scale;
+    rt_err_t err;
+
+    if (fmt == IMG_DESC_FMT_RGB565)
+        out_cf = EPIC_OUTPUT_RGB565;
+    else if (fmt == IMG_DESC_FMT_RGB888)
+        out_cf = EPIC_OUTPUT_RGB888;
+    else
+        out_cf = EPIC_OUTPUT_ARGB8888;
+
+    /* u/v lines are expected to be half of y line, same as software path */
+    if ((frame->linesize[1] != (frame->linesize[0] >> 1))
+            || (frame->linesize[2] != (frame->linesize[0] >> 1)))
+    {
+        return -RT_ENOSYS;
+    }
+
+    /* fit by rotated size, keep aspect ratio */
+    if (out->angle == 900 || out->angle == 2700)
+    {
+        uint32_t t = src_w;
+        src_w = src_h;
+        src_h = t;
+    }
+    scale = (src_w * EPIC_INPUT_SCALE_NONE + out->width - 1) / out->width;
+    if ((src_h * EPIC_INPUT_SCALE_NONE + out->height - 1) / out->height > scale)
+        scale = (src_h * EPIC_INPUT_SCALE_NONE + out->height - 1) / out->height;
+
+    HAL_EPIC_LayerConfigInit(&input_layer);
+    input_layer.color_mode = EPIC_INPUT_YUV420_PLANAR;
+    input_layer.data = frame->data[0];
+    input_layer.yuv.y_buf = frame->data[0];
+    input_layer.yuv.u_buf = frame->data[1];
+    input_layer.yuv.v_buf = frame->data[2];
+    input_layer.width = frame->width;
+    input_layer.height = frame->height;
+    input_layer.total_width = frame->linesize[0];
+    input_layer.x_offset = ((int16_t)out->width - (int16_t)frame->width) / 2;
+    input_layer.y_offset = ((int16_t)out->height - (int16_t)frame->height) / 2;
+    input_layer.transform_cfg.angle = out->angle;
+    input_layer.transform_cfg.pivot_x = frame->width / 2;
+    input_layer.transform_cfg.pivot_y = frame->height / 2;
+    input_layer.transform_cfg.scale_x = scale;
+    input_layer.transform_cfg.scale_y = scale;
+
+    HAL_EPIC_LayerConfigInit(&output_canvas);
+    output_canvas.color_mode = out_cf;
+    output_canvas.data = out->buf;
+    output_canvas.width = out->width;
+    output_canvas.height = out->height;
+    output_canvas.total_width = out->total_width;
+    output_canvas.x_offset = 0;
+    output_canvas.y_offset = 0;
+    output_canvas.color_en = true;
+    output_canvas.color_r = 0;
+    output_canvas.color_g = 0;
+    output_canvas.color_b = 0;
+
+    err = drv_epic_blend(&input_layer, 1, &output_canvas, NULL);
+    if (RT_EOK == err)
+        err = drv_gpu_check_done(DRV_EPIC_TIMEOUT_MS);
+
+    return (RT_EOK == err) ? RT_EOK : -RT_ERROR;
+}
+#endif /* MEDIA_VIDEO_USING_EPIC */
+
+static int media_video_sw_convert(media_video_out_t *out, AVFrame *frame, int fmt)
+{
+    int pitch = out->total_width * media_video_pixel_size(fmt);
+
+    /* per pixel conversion, no scaling or rotation */
+    if (out->angle != 0 || out->width != frame->width || out->height != frame->height)
+        return -RT_ENOSYS;
+
+    if (fmt == IMG_DESC_FMT_RGB565)
+    {
+        yuv420_2_rgb565(out->buf,
+                        (const uint8_t *)frame->data[0], //y
+                        (const uint8_t *)frame->data[1], //u
+                        (const uint8_t *)frame->data[2], //v
+                        frame->width,
+                        frame->height,
+                        frame->linesize[0],
+                        frame->linesize[0] >> 1,
+                        pitch,
+                        yuv2rgb565_table,
+                        0);
+
+    }
+    else if (fmt == IMG_DESC_FMT_RGB888) //rgb888
+    {
+        yuv420_2_rgb888(out->buf,
+                        (const uint8_t *)frame->data[0], //y
+                        (const uint8_t *)frame->data[1], //u
+                        (const uint8_t *)frame->data[2], //v
+                        frame->width,
+                        frame->height,
+                        frame->linesize[0],
+                        frame->linesize[0] >> 1,
+                        pitch,
+                        yuv2rgb565_table,       // TODO: Check this
+                        0);
+    }
+    else //argb8888
+    {
+        yuv420_2_rgb8888(out->buf,
+                         (const uint8_t *)frame->data[0], //y
+                         (const uint8_t *)frame->data[1], //u
+                         (const uint8_t *)frame->data[2], //v
+                         frame->width,
+                         frame->height,
+                         frame->linesize[0],
+                         frame->linesize[0] >> 1,
+                         pitch,
+                         yuv2rgb565_table,       // TODO: Check this
+                         0);
+    }
+    return RT_EOK;
+}
+
+int media_video_convert_to(media_video_out_t *out, AVFrame *frame, int fmt)
+{
+    uint32_t start;
+    int r;
+
+    if (out == NULL || out->buf == NULL || frame == NULL
+            || out->width == 0 || out->height == 0 || out->total_width < out->width)
+        return -RT_EINVAL;
+
+    if ((AV_PIX_FMT_YUV420P != frame->format) && (AV_PIX_FMT_YUVJ420P != frame->format))
+        return -RT_ENOSYS;
+
+    if (media_video_pixel_size(fmt) == 0)
+        return -RT_ENOSYS;
+
+    if (frame->data[0] == NULL || frame->data[1] == NULL || frame->data[2] == NULL)
+        return -RT_EEMPTY;
+
+    start = video_conv_time_us();
+#ifdef MEDIA_VIDEO_USING_EPIC
+    r = media_video_epic_convert(out, frame, fmt);
+    if (r == RT_EOK)
+    {
+        video_conv_stat_add(start, 1);
+        return r;
+    }
+    LOG_D("epic convert fail %d, use software", r);
+#endif
+    r = media_video_sw_convert(out, frame, fmt);
+    if (r == RT_EOK)
+        video_conv_stat_add(start, 0);
+    else
+        video_conv_stat.fail++;
+
+    return r;
+}
+
+void media_video_get_conv_stat(media_video_conv_stat_t *stat, uint8_t reset)
+{
+    rt_enter_critical();
+    if (stat)
+        memcpy(stat, &video_conv_stat, sizeof(video_conv_stat));
+    if (reset)
+        memset(&video_conv_stat, 0, sizeof(video_conv_stat));
+    rt_exit_critical();
+}
+
 int media_video_convert(uint8_t *buf, AVFrame *frame, int fmt)
 {
     int r = RT_EOK;
@@ -351,48 +611,16 @@ int media_video_convert(uint8_t *buf, AVFrame *frame, int fmt)
     {
         if (frame->data[0] == NULL || frame->data[1] == NULL || frame->data[2] == NULL)
             r = -RT_EEMPTY;
-        else if (fmt == IMG_DESC_FMT_RGB565)
+        else if (media_video_pixel_size(fmt) != 0)
         {
-            yuv420_2_rgb565(buf,
-                            (const uint8_t *)frame->data[0], //y
-                            (const uint8_t *)frame->data[1], //u
-                            (const uint8_t *)frame->data[2], //v
-                            frame->width,
-                            frame->height,
-                            frame->linesize[0],
-                            frame->linesize[0] >> 1,
-                            frame->width << 1,
-                            yuv2rgb565_table,
-                            0);
+            media_video_out_t out;
 
-        }
-        else if (fmt == IMG_DESC_FMT_RGB888) //rgb888
-        {
-            yuv420_2_rgb888(buf,
-                            (const uint8_t *)frame->data[0], //y
-                            (const uint8_t *)frame->data[1], //u
-                            (const uint8_t *)frame->data[2], //v
-                            frame->width,
-                            frame->height,
-                            frame->linesize[0],
-                            frame->linesize[0] >> 1,
-                            (frame->width << 1) + frame->width,
-                            yuv2rgb565_table,       // TODO: Check this
-                            0);
-        }
-        else if (fmt == IMG_DESC_FMT_ARGB8888) //argb8888
-        {
-            yuv420_2_rgb8888(buf,
-                             (const uint8_t *)frame->data[0], //y
-                             (const uint8_t *)frame->data[1], //u
-                             (const uint8_t *)frame->data[2], //v
-                             frame->width,
-                             frame->height,
-                             frame->linesize[0],
-                             frame->linesize[0] >> 1,
-                             frame->width << 2,
-                             yuv2rgb565_table,       // TODO: Check this
-                             0);
+            out.buf = buf;
+            out.total_width = frame->width;
+            out.width = frame->width;
+            out.height = frame->height;
+            out.angle = 0;
+            r = media_video_convert_to(&out, frame, fmt);
         }
         else    //fmt==IMG_DESC_FMT_YUV420P
         {
@@ -457,3 +685,389 @@ int media_video_get(media_cache_t *cache, int fmt, uint8_t *data, uint8_t is_ezi
     return 0;
 }
 
+
+#ifdef MEDIA_EZIP_DIRECT_FB
+/*
+    ezip video is decoded straight into a ring of LCD framebuffers, no copy between decoder and LCD.
+    Frame N+1 is decoded into next slot while LCDC is still reading frame N from its slot,
+    slot_free counts slots not owned by LCDC and is released by tx_complete of LCD device.
+    Video of panel size is decoded by EZIP to AHB directly, a wider one without EPIC is cropped,
+    otherwise EPIC decodes and scales it to fit the panel.
+*/
+typedef struct
+{
+    rt_device_t             lcd;
+    rt_err_t (*old_tx_complete)(rt_device_t dev, void *buffer);
+    struct rt_semaphore     ezip_done;
+    struct rt_semaphore     slot_free;
+    void (*mem_free)(void *rmem);
+    uint8_t                *slot[MEDIA_EZIP_FB_SLOTS];
+    uint32_t                slot_size;
+    uint32_t                last_frame_us;
+    uint16_t                width;
+    uint16_t                height;
+    uint16_t                buf_format;
+    uint8_t                 pixel_size;
+    uint8_t                 next;
+} media_ezip_fb_t;
+
+static media_ezip_fb_t *ezip_fb;
+static media_ezip_fb_stat_t ezip_fb_stat;
+
+static rt_err_t ezip_fb_lcd_done(rt_device_t dev, void *buffer)
+{
+    if (ezip_fb)
+        rt_sem_release(&ezip_fb->slot_free);
+    return RT_EOK;
+}
+
+static void ezip_fb_ezip_done(EZIP_HandleTypeDef *ezip)
+{
+    rt_sem_release(&ezip_fb->ezip_done);
+}
+
+static uint32_t ezip_fb_psram_bytes(const uint8_t *buf, uint32_t len)
+{
+    return IS_DCACHED_RAM((uint32_t)buf) ? len : 0;
+}
+
+static int ezip_fb_decode_ezip(media_ezip_fb_t *fb, uint8_t *input, uint32_t w, uint32_t h, uint8_t *slot)
+{
+    EZIP_HandleTypeDef *ezip = drv_get_ezip_handle();
+    EZIP_DecodeConfigTypeDef config;
+    void (*old_cplt)(EZIP_HandleTypeDef * ezip);
+    HAL_StatusTypeDef status;
+    rt_err_t err;
+
+    memset(&config, 0, sizeof(config));
+    config.input = input;
+    config.output = slot;
+    config.work_mode = HAL_EZIP_MODE_EZIP;
+    config.output_mode = HAL_EZIP_OUTPUT_AHB;
+    config.width = -1;
+    config.height = -1;
+    /* crop center of larger frame, center smaller one vertically, lines are always panel width */
+    if (w > fb->width)
+    {
+        config.start_x = (w - fb->width) / 2;
+        config.width = fb->width;
+    }
+    if (h > fb->height)
+    {
+        config.start_y = (h - fb->height) / 2;
+        config.height = fb->height;
+    }
+    else
+    {
+        config.output += (fb->height - h) / 2 * fb->width * fb->pixel_size;
+    }
+
+    err = drv_epic_take(MEDIA_EZIP_FB_TIMEOUT_MS);
+    if (RT_EOK != err)
+        return -RT_EBUSY;
+
+    if (HAL_EZIP_STATE_RESET == ezip->State)
+    {
+        HAL_EZIP_Init(ezip);
+        HAL_NVIC_SetPriority(EZIP_IRQn, 3, 0);
+        HAL_NVIC_EnableIRQ(EZIP_IRQn);
+    }
+    old_cplt = ezip->CpltCallback;
+    ezip->CpltCallback = ezip_fb_ezip_done;
+
+    status = HAL_EZIP_Decode_IT(ezip, &config);
+    if (HAL_OK == status)
+    {
+        err = rt_sem_take(&fb->ezip_done, rt_tick_from_millisecond(MEDIA_EZIP_FB_TIMEOUT_MS));
+        if (RT_EOK != err || HAL_EZIP_STATE_READY != ezip->State)
+        {
+            /* error state is sticky in HAL, only this frame is lost */
+            LOG_W("ezip fb decode err %d state %d code 0x%x", err, ezip->State, ezip->ErrorCode);
+            ezip->State = HAL_EZIP_STATE_READY;
+            status = HAL_ERROR;
+        }
+    }
+
+    ezip->CpltCallback = old_cplt;
+    drv_epic_release();
+
+    return (HAL_OK == status) ? RT_EOK : -RT_ERROR;
+}
+
+#ifdef MEDIA_EZIP_FB_USING_EPIC
+static int ezip_fb_decode_epic(media_ezip_fb_t *fb, uint8_t *input, uint32_t w, uint32_t h, uint8_t *slot)
+{
+    EPIC_LayerConfigTypeDef input_layer;
+    EPIC_LayerConfigTypeDef output_canvas;
+    uint32_t scale;
+    rt_err_t err;
+
+    /* fit in panel, keep aspect ratio */
+    scale = (w * EPIC_INPUT_SCALE_NONE + fb->width - 1) / fb->width;
+    if ((h * EPIC_INPUT_SCALE_NONE + fb->height - 1) / fb->height > scale)
+        scale = (h * EPIC_INPUT_SCALE_NONE + fb->height - 1) / fb->height;
+
+    HAL_EPIC_LayerConfigInit(&input_layer);
+    input_layer.color_mode = EPIC_INPUT_EZIP;
+    input_layer.data = input;
+    input_layer.width = w;
+    input_layer.height = h;
+    input_layer.total_width = w;
+    input_layer.x_offset = ((int16_t)fb->width - (int16_t)w) / 2;
+    input_layer.y_offset = ((int16_t)fb->height - (int16_t)h) / 2;
+    input_layer.transform_cfg.pivot_x = w / 2;
+    input_layer.transform_cfg.pivot_y = h / 2;
+    input_layer.transform_cfg.scale_x = scale;
+    input_layer.transform_cfg.scale_y = scale;
+
+    HAL_EPIC_LayerConfigInit(&output_canvas);
+    if (RTGRAPHIC_PIXEL_FORMAT_RGB565 == fb->buf_format)
+        output_canvas.color_mode = EPIC_OUTPUT_RGB565;
+    else if (RTGRAPHIC_PIXEL_FORMAT_RGB888 == fb->buf_format)
+        output_canvas.color_mode = EPIC_OUTPUT_RGB888;
+    else
+        output_canvas.color_mode = EPIC_OUTPUT_ARGB8888;
+    output_canvas.data = slot;
+    output_canvas.width = fb->width;
+    output_canvas.height = fb->height;
+    output_canvas.total_width = fb->width;
+    output_canvas.color_en = true;
+    output_canvas.color_r = 0;
+    output_canvas.color_g = 0;
+    output_canvas.color_b = 0;
+
+    err = drv_epic_blend(&input_layer, 1, &output_canvas, NULL);
+    if (RT_EOK == err)
+        err = drv_gpu_check_done(MEDIA_EZIP_FB_TIMEOUT_MS);
+
+    return (RT_EOK == err) ? RT_EOK : -RT_ERROR;
+}
+#endif /* MEDIA_EZIP_FB_USING_EPIC */
+
+int ffmpeg_ezip_fb_open(ffmpeg_handle thiz, const char *lcd_name)
+{
+    struct rt_device_graphic_info info;
+    media_ezip_fb_t *fb;
+    rt_device_t lcd;
+
+    if (!thiz || thiz->magic != FFMPEG_HANDLE_MAGIC || !thiz->is_sifli_ezip_memdia)
+        return -RT_EINVAL;
+    if (ezip_fb)
+        return -RT_EBUSY;
+
+    lcd = rt_device_find(lcd_name);
+    if (!lcd || RT_EOK != rt_device_open(lcd, RT_DEVICE_OFLAG_RDWR))
+        return -RT_ENOSYS;
+
+    if (RT_EOK != rt_device_control(lcd, RTGRAPHIC_CTRL_GET_INFO, &info)
+            || (RTGRAPHIC_PIXEL_FORMAT_RGB565 != info.pixel_format
+                && RTGRAPHIC_PIXEL_FORMAT_RGB888 != info.pixel_format
+                && RTGRAPHIC_PIXEL_FORMAT_ARGB888 != info.pixel_format))
+    {
+        rt_device_close(lcd);
+        return -RT_ENOSYS;
+    }
+
+    fb = rt_malloc(sizeof(*fb));
+    RT_ASSERT(fb);
+    memset(fb, 0, sizeof(*fb));
+    fb->lcd = lcd;
+    fb->width = info.width;
+    fb->height = info.height;
+    fb->buf_format = info.pixel_format;
+    fb->pixel_size = info.bits_per_pixel / 8;
+    fb->slot_size = fb->width * fb->height * fb->pixel_size;
+    fb->mem_free = thiz->cfg.mem_free;
+    for (int i = 0; i < MEDIA_EZIP_FB_SLOTS; i++)
+    {
+        fb->slot[i] = thiz->cfg.mem_malloc(fb->slot_size);
+        RT_ASSERT(fb->slot[i]);
+        /* black letterbox, written back before EZIP/EPIC write the slot */
+        memset(fb->slot[i], 0, fb->slot_size);
+        mpu_dcache_clean(fb->slot[i], fb->slot_size);
+    }
+    rt_sem_init(&fb->ezip_done, "ezfb_dec", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&fb->slot_free, "ezfb_slot", MEDIA_EZIP_FB_SLOTS, RT_IPC_FLAG_FIFO);
+
+    fb->old_tx_complete = lcd->tx_complete;
+    memset(&ezip_fb_stat, 0, sizeof(ezip_fb_stat));
+    ezip_fb = fb;
+    rt_device_set_tx_complete(lcd, ezip_fb_lcd_done);
+
+    LOG_I("ezip fb %dx%d fmt %d, %d slots, video %dx%d", fb->width, fb->height, fb->buf_format,
+          MEDIA_EZIP_FB_SLOTS, thiz->ezip_header.width, thiz->ezip_header.height);
+
+    return RT_EOK;
+}
+
+int ffmpeg_ezip_fb_show(ffmpeg_handle thiz)
+{
+    media_ezip_fb_t *fb = ezip_fb;
+    rt_slist_t *decoded_root;
+    rt_slist_t *empty_root;
+    rt_slist_t *decoded;
+    ezip_video_packet_t *packet;
+    uint32_t w, h, start, now;
+    uint8_t *slot;
+    uint8_t by_epic = 0;
+    int r;
+
+    if (!thiz || thiz->magic != FFMPEG_HANDLE_MAGIC || !fb)
+        return -RT_EINVAL;
+
+    decoded_root = &thiz->ezip_video_cache.decoded_video_slist;
+    empty_root = &thiz->ezip_video_cache.empty_video_slist;
+    rt_enter_critical();
+    decoded = rt_slist_first(decoded_root);
+    if (decoded)
+        rt_slist_remove(decoded_root, decoded);
+    rt_exit_critical();
+    if (!decoded)
+        return -RT_EEMPTY;
+
+    packet = rt_container_of(decoded, ezip_video_packet_t, snode);
+    w = thiz->ezip_header.width;
+    h = thiz->ezip_header.height;
+
+    /* next slot in ring is the oldest one sent to LCD */
+    if (RT_EOK != rt_sem_trytake(&fb->slot_free))
+    {
+        ezip_fb_stat.slot_wait++;
+        if (RT_EOK != rt_sem_take(&fb->slot_free, rt_tick_from_millisecond(MEDIA_EZIP_FB_TIMEOUT_MS)))
+        {
+            r = -RT_ETIMEOUT;
+            goto __EXIT;
+        }
+    }
+    slot = fb->slot[fb->next];
+
+    /* packet is written by cpu, EZIP reads it from memory */
+    mpu_dcache_clean(packet->buffer, packet->data_len);
+
+    start = video_conv_time_us();
+    r = -RT_ENOSYS;
+#ifdef MEDIA_EZIP_FB_USING_EPIC
+    if (w != fb->width || h != fb->height)
+    {
+        by_epic = 1;
+        r = ezip_fb_decode_epic(fb, packet->buffer, w, h, slot);
+    }
+#endif /* MEDIA_EZIP_FB_USING_EPIC */
+    if (!by_epic && w >= fb->width)
+        r = ezip_fb_decode_ezip(fb, packet->buffer, w, h, slot);
+    now = video_conv_time_us();
+
+    if (RT_EOK != r)
+    {
+        rt_sem_release(&fb->slot_free);
+        goto __EXIT;
+    }
+
+    rt_device_control(fb->lcd, RTGRAPHIC_CTRL_SET_BUF_FORMAT, &fb->buf_format);
+    rt_graphix_ops(fb->lcd)->set_window(0, 0, fb->width - 1, fb->height - 1);
+    rt_graphix_ops(fb->lcd)->draw_rect_async((const char *)slot, 0, 0, fb->width - 1, fb->height - 1);
+    fb->next = (fb->next + 1) % MEDIA_EZIP_FB_SLOTS;
+
+    rt_enter_critical();
+    if (ezip_fb_stat.frames)
+        ezip_fb_stat.frame_us += now - fb->last_frame_us;
+    fb->last_frame_us = now;
+    ezip_fb_stat.frames++;
+    ezip_fb_stat.epic_frames += by_epic;
+    ezip_fb_stat.last_us = now - start;
+    ezip_fb_stat.decode_us += now - start;
+    if (now - start > ezip_fb_stat.max_us)
+        ezip_fb_stat.max_us = now - start;
+    ezip_fb_stat.in_bytes += packet->data_len;
+    ezip_fb_stat.out_bytes += by_epic ? fb->slot_size : RT_MIN(h, fb->height) * fb->width * fb->pixel_size;
+    ezip_fb_stat.scan_bytes += fb->slot_size;
+    ezip_fb_stat.psram_bytes += ezip_fb_psram_bytes(packet->buffer, packet->data_len)
+                                + 2 * ezip_fb_psram_bytes(slot, fb->slot_size);
+    rt_exit_critical();
+
+__EXIT:
+    if (RT_EOK != r)
+    {
+        ezip_fb_stat.fail++;
+        LOG_D("ezip fb frame drop %d", r);
+    }
+    /* pixels are in slot, compressed packet can be reused at once */
+    rt_enter_critical();
+    rt_slist_append(empty_root, decoded);
+    rt_exit_critical();
+
+    return r;
+}
+
+void ffmpeg_ezip_fb_close(ffmpeg_handle thiz)
+{
+    media_ezip_fb_t *fb = ezip_fb;
+
+    if (!fb)
+        return;
+
+    /* wait for LCDC to release all slots */
+    for (int i = 0; i < MEDIA_EZIP_FB_SLOTS; i++)
+    {
+        if (RT_EOK != rt_sem_take(&fb->slot_free, rt_tick_from_millisecond(MEDIA_EZIP_FB_TIMEOUT_MS)))
+            LOG_W("ezip fb slot still in use");
+    }
+
+    rt_device_set_tx_complete(fb->lcd, fb->old_tx_complete);
+    ezip_fb = NULL;
+    rt_device_close(fb->lcd);
+
+    for (int i = 0; i < MEDIA_EZIP_FB_SLOTS; i++)
+        fb->mem_free(fb->slot[i]);
+    rt_sem_detach(&fb->ezip_done);
+    rt_sem_detach(&fb->slot_free);
+    rt_free(fb);
+}
+
+void ffmpeg_ezip_fb_get_stat(media_ezip_fb_stat_t *stat, uint8_t reset)
+{
+    rt_enter_critical();
+    if (stat)
+        memcpy(stat, &ezip_fb_stat, sizeof(ezip_fb_stat));
+    if (reset)
+        memset(&ezip_fb_stat, 0, sizeof(ezip_fb_stat));
+    rt_exit_critical();
+}
+#endif /* MEDIA_EZIP_DIRECT_FB */
+
+#ifdef RT_USING_FINSH
+static int media_conv_stat(int argc, char **argv)
+{
+    media_video_conv_stat_t stat;
+
+    media_video_get_conv_stat(&stat, argc > 1 && strcmp(argv[1], "reset") == 0);
+    rt_kprintf("epic: %d frames, avg %d us\n", stat.epic_frames,
+               stat.epic_frames ? (uint32_t)(stat.epic_us / stat.epic_frames) : 0);
+    rt_kprintf("sw  : %d frames, avg %d us\n", stat.sw_frames,
+               stat.sw_frames ? (uint32_t)(stat.sw_us / stat.sw_frames) : 0);
+    rt_kprintf("fail: %d\n", stat.fail);
+    return 0;
+}
+MSH_CMD_EXPORT(media_conv_stat, video yuv to rgb conversion statistics);
+
+#ifdef MEDIA_EZIP_DIRECT_FB
+static int ezip_fb_stat_cmd(int argc, char **argv)
+{
+    media_ezip_fb_stat_t stat;
+    uint32_t n;
+
+    ffmpeg_ezip_fb_get_stat(&stat, argc > 1 && strcmp(argv[1], "reset") == 0);
+    n = stat.frames ? stat.frames : 1;
+    rt_kprintf("frames %d (epic %d), fail %d, slot wait %d\n", stat.frames, stat.epic_frames,
+               stat.fail, stat.slot_wait);
+    rt_kprintf("decode avg %d us, max %d us, last %d us, frame avg %d us\n",
+               (uint32_t)(stat.decode_us / n), stat.max_us, stat.last_us,
+               stat.frames > 1 ? (uint32_t)(stat.frame_us / (stat.frames - 1)) : 0);
+    rt_kprintf("per frame: in %d, out %d, scan out %d, psram %d bytes\n",
+               (uint32_t)(stat.in_bytes / n), (uint32_t)(stat.out_bytes / n),
+               (uint32_t)(stat.scan_bytes / n), (uint32_t)(stat.psram_bytes / n));
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(ezip_fb_stat_cmd, ezip_fb_stat, direct ezip video to framebuffer statistics);
+#endif /* MEDIA_EZIP_DIRECT_FB */
+#endif
@@ -35,7 +35,9 @@
     #define FFMPEG_NAND_URL_FMT "nand://addr=0x%x&len=0x%x"
 #endif
 
-#define VIDEO_BUFFER_CAPACITY       3
+#ifndef VIDEO_BUFFER_CAPACITY
+    #define VIDEO_BUFFER_CAPACITY   3   //decoded frame lookahead, including the one on display
+#endif
 
 // Video
 
@@ -92,6 +94,7 @@ typedef struct ms_frame_data_t_tag
 {
     rt_slist_t      snode;
     AVFrame        *frame;
+    uint32_t        pts_ms;     //presentation time
 } ms_frame_data_t;
 
 typedef struct
@@ -138,8 +141,22 @@ typedef struct
     uint8_t        *avio_buffer;
     uint32_t       avio_buffer_size;
     media_free     pack_free; //media_packet_t free
+    uint16_t       pack_slots; //>0: lock free queue with pack_slots slots, ffmpeg_send_frame_to_decoder() must be called in one thread
+    uint8_t        pack_pool_class_num; //>0: packet pool with pack_pool_classes, packets should be got by ffmpeg_alloc_frame()
+    const media_pool_class_cfg_t *pack_pool_classes; //MEDIA_POOL_DEFAULT_CLASSES can be used
 } ffmpeg_config_t;
 
+typedef struct
+{
+    uint32_t        decoded;        //video frames decoded
+    uint32_t        presented;      //video frames got by ffmpeg_next_video_frame()
+    uint32_t        late_dropped;   //decoded but later than audio clock, dropped before display
+    uint32_t        cache_dropped;  //dropped since lookahead cache is full
+    uint32_t        nonref_skipped; //packets decoded with non-reference frames discarded
+    uint32_t        gop_skipped;    //packets skipped until next key frame
+    uint32_t        max_lag_ms;     //max video behind audio clock
+} ffmpeg_sync_stat_t;
+
 typedef struct ffmpeg_decoder_tag *ffmpeg_handle;
 typedef struct
 {
@@ -148,6 +165,42 @@ typedef struct
     sifli_gpu_fmt_t gpu_pic_fmt;
 } video_info_t;
 
+/* output of media_video_convert_to(), e.g. a LCD framebuffer */
+typedef struct
+{
+    uint8_t        *buf;          //top-left pixel of output area
+    uint16_t        total_width;  //line width of buf in pixels
+    uint16_t        width;        //output area, frame is scaled to fit and centered
+    uint16_t        height;
+    int16_t         angle;        //rotation in 0.1 degree
+} media_video_out_t;
+
+typedef struct
+{
+    uint32_t        epic_frames;  //converted by EPIC
+    uint64_t        epic_us;
+    uint32_t        sw_frames;    //converted by software
+    uint64_t        sw_us;
+    uint32_t        fail;         //not supported, e.g. scaling without EPIC
+} media_video_conv_stat_t;
+
+/* statistics of ffmpeg_ezip_fb_show() */
+typedef struct
+{
+    uint32_t        frames;       //frames sent to LCD
+    uint32_t        epic_frames;  //decoded and scaled by EPIC
+    uint32_t        fail;         //decode error or timeout, frame dropped
+    uint32_t        slot_wait;    //next slot was still read by LCDC
+    uint32_t        last_us;      //decode time of last frame
+    uint32_t        max_us;
+    uint64_t        decode_us;
+    uint64_t        frame_us;     //time between frames sent to LCD
+    uint64_t        in_bytes;     //compressed data read by EZIP
+    uint64_t        out_bytes;    //pixels written to framebuffer
+    uint64_t        scan_bytes;   //pixels read by LCDC
+    uint64_t        psram_bytes;  //part of above in PSRAM
+} media_ezip_fb_stat_t;
+
 /*------------API for special app -----------*/
 int media_audio_get(AVFrame *frame, uint16_t *audio_data);
 int media_decode_video(ffmpeg_handle thiz,
@@ -159,6 +212,14 @@ int media_cache_init(media_cache_t *cache,      int cache_num);
 void media_cache_deinit(media_cache_t *cache, int cache_num);
 int media_video_get(media_cache_t *cache,     int fmt, uint8_t *data, uint8_t is_ezip);
 int media_video_convert(uint8_t *buf, AVFrame *frame, int fmt);
+/*
+ convert yuv420p frame to fmt(IMG_DESC_FMT_RGB565/RGB888/ARGB8888) in out area,
+ done by EPIC in one pass with scaling/rotation if EPIC supports yuv input,
+ otherwise by software which supports no scaling or rotation
+ 0 - success
+*/
+int media_video_convert_to(media_video_out_t *out, AVFrame *frame, int fmt);
+void media_video_get_conv_stat(media_video_conv_stat_t *stat, uint8_t reset);
 bool media_video_need_decode(media_cache_t *cache);
 bool ezip_video_need_decode(ffmpeg_handle thiz);
 /*------------API for local file and network file stream -----------*/
@@ -194,11 +255,37 @@ data :  output result set to data or data[0], [1] , data[2]
 */
 int ffmpeg_next_video_frame(ffmpeg_handle hanlde, uint8_t *data);
 
+/*
+ get counters of audio/video sync, video is scheduled by audio clock if audio is playing
+ 0 - success
+*/
+int ffmpeg_get_sync_stat(ffmpeg_handle hanlde, ffmpeg_sync_stat_t *stat, uint8_t reset);
+
 
 bool ffmpeg_is_video_available(ffmpeg_handle hanlde);
 
+/*
+ sifli ezip media only, MEDIA_EZIP_DIRECT_FB
+ decode video into a ring of MEDIA_EZIP_FB_SLOTS framebuffers sent to LCD device lcd_name,
+ instead of getting frames by ffmpeg_next_video_frame(). Video of panel size should be ezip
+ encoded in LCD color format, other sizes are scaled by EPIC.
+ ffmpeg_ezip_fb_show() sends next frame to LCD and returns while LCD is still reading it,
+ call it when ffmpeg_is_video_available() is true
+ 0 - success, -RT_EEMPTY - no frame
+*/
+int ffmpeg_ezip_fb_open(ffmpeg_handle hanlde, const char *lcd_name);
+int ffmpeg_ezip_fb_show(ffmpeg_handle hanlde);
+void ffmpeg_ezip_fb_close(ffmpeg_handle hanlde);
+void ffmpeg_ezip_fb_get_stat(media_ezip_fb_stat_t *stat, uint8_t reset);
+
 //only use for e_network_packet_stream, p is malloced by user, and free by pack_free() in ffmpeg_config_t
 void ffmpeg_send_frame_to_decoder(ffmpeg_handle thiz, media_packet_t *p);
 
+//only use for e_network_packet_stream with packet pool, p->data_len is set to data_len, return NULL if no memory.
+//p is freed to pool after consumed, pack_free() is not called for it
+media_packet_t *ffmpeg_alloc_frame(ffmpeg_handle thiz, uint32_t data_len);
+//0 - success
+int ffmpeg_get_frame_pool_stat(ffmpeg_handle thiz, uint8_t class_idx, media_pool_stat_t *stat);
+
 #endif
 
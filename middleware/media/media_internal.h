@@ -56,6 +56,19 @@ enum
 
 #define FFMPEG_HANDLE_MAGIC     0x55555555
 
+/* video scheduling by audio clock, in ms */
+#ifndef MEDIA_SYNC_LATE_MS
+    #define MEDIA_SYNC_LATE_MS          60      //decoded frame later than this is dropped if next one is ready
+#endif
+#ifndef MEDIA_SYNC_SKIP_NONREF_MS
+    #define MEDIA_SYNC_SKIP_NONREF_MS   120     //decoder behind more than this discards non-reference frames
+#endif
+#ifndef MEDIA_SYNC_SKIP_GOP_MS
+    #define MEDIA_SYNC_SKIP_GOP_MS      500     //decoder behind more than this skips to next key frame
+#endif
+#define MEDIA_SYNC_RESYNC_MS            5000    //larger gap is taken as loop or seek, not lag
+#define MEDIA_SYNC_EXTRAPOLATE_MS       200     //audio clock runs on tick at most this long after last write
+
 typedef struct
 {
     uint32_t is_audio: 1;
@@ -191,10 +204,19 @@ typedef struct ffmpeg_decoder_tag
     uint8_t                 seeking_state; //1--start, 2--time ok, need I frame, 0--end
     uint8_t                 is_closing;   //aysnc closing
     sifli_gpu_fmt_t         gpu_pic_fmt;
+
+    // Audio master clock, updated by audio decoder after each write
+    __IO uint8_t            audio_clock_valid;
+    uint8_t                 skip_to_key;    //skipping packets until next key frame
+    uint32_t                audio_end_ms;   //pts of end of written pcm
+    __IO uint32_t           audio_clock_ms; //pts of pcm being played
+    __IO uint32_t           audio_clock_tick;
+    ffmpeg_sync_stat_t      sync_stat;
 } ffmpeg_decoder_t;
 
 extern void ffmeg_mem_init();
 extern void ffmpeg_memleak_check();
+uint32_t media_pts_to_ms(ffmpeg_handle thiz, int stream_idx, int64_t pts);
 int ezip_video_cache_init(ffmpeg_handle thiz);
 void ezip_video_cache_deinit(ffmpeg_handle thiz);
 int ezip_video_decode(ffmpeg_handle thiz, uint32_t size, uint32_t paddings);
@@ -135,6 +135,141 @@ static int open_codec_context(int *stream_idx,
     return 0;
 }
 
+/* audio clock is the master, video frames are presented and decoded against it */
+static void audio_clock_update(ffmpeg_handle thiz)
+{
+    uint32_t cached = 0;
+    uint32_t clock_ms;
+
+    audio_ioctl(thiz->audio_handle, 1, &cached);
+    clock_ms = (thiz->audio_end_ms > cached) ? thiz->audio_end_ms - cached : 0;
+
+    rt_enter_critical();
+    thiz->audio_clock_ms = clock_ms;
+    thiz->audio_clock_tick = rt_tick_get_millisecond();
+    thiz->audio_clock_valid = 1;
+    rt_exit_critical();
+}
+
+static int audio_clock_get(ffmpeg_handle thiz, uint32_t *clock_ms)
+{
+    uint32_t base, tick, delta;
+
+    if (!thiz->audio_clock_valid || !thiz->cfg.audio_enable || thiz->is_paused || thiz->is_suspended)
+        return -1;
+
+    rt_enter_critical();
+    base = thiz->audio_clock_ms;
+    tick = thiz->audio_clock_tick;
+    rt_exit_critical();
+
+    /* pcm keeps playing between writes, but not longer than what was cached */
+    delta = rt_tick_get_millisecond() - tick;
+    if (delta > MEDIA_SYNC_EXTRAPOLATE_MS)
+        delta = MEDIA_SYNC_EXTRAPOLATE_MS;
+    *clock_ms = base + delta;
+
+    return 0;
+}
+
+/*
+  return true if video packet should not be decoded.
+  decoder behind audio clock discards non-reference frames first, then skips to next key frame
+ */
+static bool video_packet_skip(ffmpeg_handle thiz, AVPacket *pkt)
+{
+    AVCodecContext *ctx = thiz->video_dec_ctx;
+    uint32_t clock_ms, pts_ms, lag = 0;
+
+    if (pkt->flags & AV_PKT_FLAG_KEY)
+    {
+        thiz->skip_to_key = 0;
+    }
+    else if (thiz->skip_to_key)
+    {
+        /* references are gone, nothing to decode until key frame */
+        thiz->sync_stat.gop_skipped++;
+        return true;
+    }
+
+    if (pkt->pts != AV_NOPTS_VALUE && !thiz->seeking_state && audio_clock_get(thiz, &clock_ms) == 0)
+    {
+        pts_ms = media_pts_to_ms(thiz, thiz->video_stream_idx, pkt->pts);
+        if (clock_ms > pts_ms && clock_ms - pts_ms < MEDIA_SYNC_RESYNC_MS)
+            lag = clock_ms - pts_ms;
+    }
+    if (lag > thiz->sync_stat.max_lag_ms)
+        thiz->sync_stat.max_lag_ms = lag;
+
+    if (lag > MEDIA_SYNC_SKIP_GOP_MS && !(pkt->flags & AV_PKT_FLAG_KEY))
+    {
+        LOG_I("video lag %d ms, skip to key frame", lag);
+        thiz->skip_to_key = 1;
+        thiz->sync_stat.gop_skipped++;
+        return true;
+    }
+
+    if (lag > MEDIA_SYNC_SKIP_NONREF_MS)
+    {
+        ctx->skip_frame = AVDISCARD_NONREF;
+        thiz->sync_stat.nonref_skipped++;
+    }
+    else
+    {
+        ctx->skip_frame = AVDISCARD_DEFAULT;
+    }
+
+    return false;
+}
+
+/*
+  return true if first decoded frame is due by audio clock.
+  late frames are dropped while a newer decoded frame is ready
+ */
+static bool video_frame_due(ffmpeg_handle thiz)
+{
+    media_cache_t *cache = &thiz->video_cache;
+    ms_frame_data_t *frame;
+    rt_slist_t *first;
+    uint32_t clock_ms;
+    bool due = true;
+
+    if (audio_clock_get(thiz, &clock_ms) != 0)
+        return true;
+
+    rt_enter_critical();
+    while (1)
+    {
+        first = rt_slist_first(&cache->decoded_frame_slist);
+        if (!first)
+        {
+            due = false;
+            break;
+        }
+        frame = rt_container_of(first, ms_frame_data_t, snode);
+        if (frame->pts_ms > clock_ms + MEDIA_SYNC_RESYNC_MS
+                || clock_ms > frame->pts_ms + MEDIA_SYNC_RESYNC_MS)
+        {
+            /* loop or seek, audio clock not updated yet */
+            break;
+        }
+        if (frame->pts_ms > clock_ms + thiz->period / 2)
+        {
+            due = false;
+            break;
+        }
+        if (!rt_slist_next(first) || frame->pts_ms + MEDIA_SYNC_LATE_MS >= clock_ms)
+            break;
+
+        rt_slist_remove(&cache->decoded_frame_slist, first);
+        rt_slist_append(&cache->empty_frame_slist, first);
+        thiz->sync_stat.late_dropped++;
+    }
+    rt_exit_critical();
+
+    return due;
+}
+
 /*
   1. for local file or network mp4 stream, decoding speed is same as
      video period if no audio stream  or audio stream is disabled by user.
@@ -169,6 +304,12 @@ static void video_decode_thread(void *p)
 
         os_message_get(thiz->av_pkt_queue, &pkt, sizeof(pkt), OS_WAIT_FORVER);
 
+        if (pkt.size > 0 && video_packet_skip(thiz, &pkt))
+        {
+            av_packet_unref(&pkt);
+            continue;
+        }
+
         AVPacket orig_pkt = pkt;
 
         do
@@ -249,6 +390,9 @@ static int audio_callback_func(audio_server_callback_cmt_t cmd, void *callback_u
 static void decode_audio_packet(ffmpeg_handle thiz, AVPacket *orig, AVPacket *cur_pkt)
 {
     int got_frame;
+
+    if (orig->pts != AV_NOPTS_VALUE)
+        thiz->audio_end_ms = media_pts_to_ms(thiz, thiz->audio_stream_idx, orig->pts);
     do
     {
         int ret;
@@ -284,6 +428,8 @@ static void decode_audio_packet(ffmpeg_handle thiz, AVPacket *orig, AVPacket *cu
                 RT_ASSERT(thiz->audio_handle);
             }
 
+            uint32_t frame_ms = thiz->audio_frame->nb_samples * 1000 / thiz->audio_samplerate;
+
             TRACE_MARK_START(TRACEID_AUDIO_CONVERT);
             media_audio_get(thiz->audio_frame,  thiz->audio_data);
             TRACE_MARK_STOP(TRACEID_AUDIO_CONVERT);
@@ -304,6 +450,8 @@ static void decode_audio_packet(ffmpeg_handle thiz, AVPacket *orig, AVPacket *cu
                 }
             }
             TRACE_MARK_STOP(TRACEID_AUDIO_WRITE);
+            thiz->audio_end_ms += frame_ms;
+            audio_clock_update(thiz);
 
         }
         TRACE_MARK_STOP(TRACEID_AUDIO_DECODE_TOTAL);
@@ -331,6 +479,7 @@ static void audio_decode_thread(void *p)
             {
                 audio_close(thiz->audio_handle);
                 thiz->audio_handle = NULL;
+                thiz->audio_clock_valid = 0;
             }
         }
         os_message_get(thiz->av_pkt_queue_audio, &pkt, sizeof(pkt), OS_WAIT_FORVER);
@@ -367,6 +516,7 @@ static void audio_decode_thread(void *p)
     {
         audio_close(thiz->audio_handle);
         thiz->audio_handle = NULL;
+        thiz->audio_clock_valid = 0;
     }
     rt_thread_mdelay(20);
     LOG_I("audio decode_thread exit");
@@ -390,6 +540,7 @@ static void video_audio_decode_thread(void *p)
             {
                 audio_close(thiz->audio_handle);
                 thiz->audio_handle = NULL;
+                thiz->audio_clock_valid = 0;
             }
         }
 
@@ -406,6 +557,11 @@ static void video_audio_decode_thread(void *p)
 
         if (pkt.stream_index == thiz->video_stream_idx)
         {
+            if (pkt.size > 0 && video_packet_skip(thiz, &pkt))
+            {
+                av_packet_unref(&orig_pkt);
+                continue;
+            }
             do
             {
                 int ret;
@@ -470,6 +626,7 @@ static void video_audio_decode_thread(void *p)
     {
         audio_close(thiz->audio_handle);
         thiz->audio_handle = NULL;
+        thiz->audio_clock_valid = 0;
     }
     rt_thread_mdelay(20);
     LOG_I("%s exit", __FUNCTION__);
@@ -583,6 +740,7 @@ static void media_read_thread(void *p)
                         av_seek_frame(thiz->fmt_ctx, 0, 0, AVSEEK_FLAG_BACKWARD);
                         thiz->frame_index = 0;
                         thiz->last_seconds = -1;
+                        thiz->audio_clock_valid = 0;
                         thiz->cfg.notify(thiz->user_data, e_ffmpeg_play_to_loop, 0);
                         continue;
                     }
@@ -818,9 +976,7 @@ static int read_packet(void *opaque, uint8_t *buf, int buf_size)
 
     while (thiz->is_ok)
     {
-        lock();
-        q = rt_list_first_entry(&thiz->network_queue->root, media_packet_t, node);
-        unlock();
+        q = media_queue_peek_head(thiz->network_queue);
         if (!q)
         {
             media_queue_wait(thiz->network_queue);
@@ -836,10 +992,8 @@ static int read_packet(void *opaque, uint8_t *buf, int buf_size)
         media_queue_add_readed(thiz->network_queue, len);
         if (q->data_len == 0)
         {
-            lock();
-            rt_list_remove(&q->node);
-            unlock();
-            thiz->cfg.pack_free(q);
+            media_queue_remove_head(thiz->network_queue, q);
+            media_queue_free_packet(thiz->network_queue, q);
         }
         return (int)len;
     }
@@ -873,7 +1027,20 @@ static int mediaplayer_start(ffmpeg_handle thiz, bool is_file)
     else
     {
         int ret;
-        thiz->network_queue = media_queue_open(thiz->cfg.pack_free);
+        if (thiz->cfg.pack_slots)
+            thiz->network_queue = media_queue_open_spsc(thiz->cfg.pack_free, thiz->cfg.pack_slots);
+        else
+            thiz->network_queue = media_queue_open(thiz->cfg.pack_free);
+        if (thiz->network_queue && thiz->cfg.pack_pool_class_num)
+        {
+            media_pool_t *pool = media_pool_create(thiz->cfg.pack_pool_classes, thiz->cfg.pack_pool_class_num);
+            if (!pool)
+            {
+                LOG_E("avio pool no mem");
+                goto Exit;
+            }
+            media_queue_attach_pool(thiz->network_queue, pool);
+        }
         if (!thiz->network_queue)
         {
             LOG_E("avio queue no mem");
@@ -1183,6 +1350,9 @@ static void ezip_clean_up(ffmpeg_handle thiz)
         thiz->audio_data = NULL;
     }
     ezip_audio_cache_deinit(thiz);
+#ifdef MEDIA_EZIP_DIRECT_FB
+    ffmpeg_ezip_fb_close(thiz);
+#endif
     ezip_video_cache_deinit(thiz);
 
     rt_free(thiz);
@@ -1699,6 +1869,10 @@ bool ffmpeg_is_video_available(ffmpeg_handle thiz)
     rt_exit_critical();
     if (decoded)
     {
+        if (has_audio && !thiz->is_sifli_ezip_memdia)
+        {
+            return video_frame_due(thiz);
+        }
         if (!has_audio)
         {
             rt_tick_t cur = rt_tick_get();
@@ -1762,7 +1936,25 @@ int ffmpeg_next_video_frame(ffmpeg_handle thiz, uint8_t *data)
         return 0;
     }
 
-    return media_video_get(&thiz->video_cache, thiz->cfg.fmt, data, e_sifli_fmt_ezip == thiz->gpu_pic_fmt);
+    int ret = media_video_get(&thiz->video_cache, thiz->cfg.fmt, data, e_sifli_fmt_ezip == thiz->gpu_pic_fmt);
+    if (ret == 0)
+        thiz->sync_stat.presented++;
+
+    return ret;
+}
+
+int ffmpeg_get_sync_stat(ffmpeg_handle thiz, ffmpeg_sync_stat_t *stat, uint8_t reset)
+{
+    if (!thiz || thiz->magic != FFMPEG_HANDLE_MAGIC || !stat)
+        return -RT_EINVAL;
+
+    rt_enter_critical();
+    memcpy(stat, &thiz->sync_stat, sizeof(*stat));
+    if (reset)
+        memset(&thiz->sync_stat, 0, sizeof(thiz->sync_stat));
+    rt_exit_critical();
+
+    return 0;
 }
 
 void ffmpeg_eizp_release(uint8_t *ezip)
@@ -1911,6 +2103,7 @@ void ffmpeg_seek(ffmpeg_handle thiz, uint32_t second)
     if (thiz && thiz->magic == FFMPEG_HANDLE_MAGIC)
     {
         thiz->seek_to_second = second;
+        thiz->audio_clock_valid = 0;
         thiz->seeking_state = 1;
         while (1)
         {
@@ -1943,6 +2136,24 @@ void ffmpeg_audio_mute(ffmpeg_handle thiz, bool is_mute)
         LOG_I("mute=%d", is_mute);
     }
 }
+media_packet_t *ffmpeg_alloc_frame(ffmpeg_handle thiz, uint32_t data_len)
+{
+    if (thiz && thiz->magic == FFMPEG_HANDLE_MAGIC && thiz->network_queue && thiz->network_queue->pool)
+    {
+        return media_pool_alloc(thiz->network_queue->pool, data_len);
+    }
+    return NULL;
+}
+
+int ffmpeg_get_frame_pool_stat(ffmpeg_handle thiz, uint8_t class_idx, media_pool_stat_t *stat)
+{
+    if (thiz && thiz->magic == FFMPEG_HANDLE_MAGIC && thiz->network_queue)
+    {
+        return media_pool_get_stat(thiz->network_queue->pool, class_idx, stat);
+    }
+    return -1;
+}
+
 void ffmpeg_send_frame_to_decoder(ffmpeg_handle thiz, media_packet_t *p)
 {
     if (thiz && thiz->magic == FFMPEG_HANDLE_MAGIC && thiz->network_queue && p)
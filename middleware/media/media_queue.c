@@ -1,4 +1,7 @@
 #include "media_queue.h"
+#include "board.h"
+#include <string.h>
+#include <rthw.h>
 
 static inline void lock(rt_mutex_t mutex)
 {
@@ -27,6 +30,243 @@ media_queue_t *media_queue_open(media_free func)
     return q;
 }
 
+#define MEDIA_POOL_ALIGN(size)  RT_ALIGN((size), 4)
+
+media_pool_t *media_pool_create(const media_pool_class_cfg_t *class_cfg, uint8_t class_num)
+{
+    media_pool_t *pool;
+    media_pool_class_t *cls;
+    uint8_t *block;
+
+    RT_ASSERT(class_cfg && class_num <= MEDIA_POOL_CLASS_MAX);
+    pool = (media_pool_t *)calloc(1, sizeof(media_pool_t));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < class_num; i++)
+    {
+        RT_ASSERT(i == 0 || class_cfg[i].data_size > class_cfg[i - 1].data_size);
+        cls = &pool->cls[i];
+        cls->block_size = MEDIA_POOL_ALIGN(sizeof(media_packet_t) + class_cfg[i].data_size);
+        cls->num = class_cfg[i].num;
+        cls->mem = (uint8_t *)malloc(cls->block_size * cls->num);
+        if (!cls->mem)
+        {
+            pool->class_num = i;
+            media_pool_destroy(pool);
+            return NULL;
+        }
+        cls->free_list = NULL;
+        block = cls->mem + cls->block_size * cls->num;
+        for (uint32_t n = 0; n < cls->num; n++)
+        {
+            block -= cls->block_size;
+            *(void **)block = cls->free_list;
+            cls->free_list = block;
+        }
+        cls->stat.data_size = class_cfg[i].data_size;
+        cls->stat.num = cls->num;
+    }
+    pool->class_num = class_num;
+
+    return pool;
+}
+
+void media_pool_destroy(media_pool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < pool->class_num; i++)
+    {
+        RT_ASSERT(pool->cls[i].stat.used == 0);
+        free(pool->cls[i].mem);
+    }
+    free(pool);
+}
+
+media_packet_t *media_pool_alloc(media_pool_t *pool, uint32_t data_len)
+{
+    media_pool_class_t *cls;
+    media_packet_t *p = NULL;
+    rt_base_t level;
+
+    RT_ASSERT(pool);
+
+    level = rt_hw_interrupt_disable();
+    for (uint8_t i = 0; i < pool->class_num; i++)
+    {
+        cls = &pool->cls[i];
+        if (cls->stat.data_size < data_len || !cls->free_list)
+        {
+            continue;
+        }
+        p = (media_packet_t *)cls->free_list;
+        cls->free_list = *(void **)cls->free_list;
+        cls->stat.used++;
+        cls->stat.alloc_cnt++;
+        if (cls->stat.used > cls->stat.high_water)
+        {
+            cls->stat.high_water = cls->stat.used;
+        }
+        break;
+    }
+    if (!p)
+    {
+        pool->overflow_cnt++;
+        pool->heap_used++;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (!p)
+    {
+        p = (media_packet_t *)malloc(sizeof(media_packet_t) + data_len);
+        if (!p)
+        {
+            level = rt_hw_interrupt_disable();
+            pool->heap_used--;
+            rt_hw_interrupt_enable(level);
+            return NULL;
+        }
+    }
+    memset(p, 0, sizeof(media_packet_t));
+    p->data_len = data_len;
+
+    return p;
+}
+
+void media_pool_free(media_pool_t *pool, media_packet_t *p)
+{
+    media_pool_class_t *cls;
+    rt_base_t level;
+
+    RT_ASSERT(pool && p);
+
+    level = rt_hw_interrupt_disable();
+    for (uint8_t i = 0; i < pool->class_num; i++)
+    {
+        cls = &pool->cls[i];
+        if ((uint8_t *)p >= cls->mem && (uint8_t *)p < cls->mem + cls->block_size * cls->num)
+        {
+            RT_ASSERT(((uint8_t *)p - cls->mem) % cls->block_size == 0);
+            *(void **)p = cls->free_list;
+            cls->free_list = p;
+            cls->stat.used--;
+            rt_hw_interrupt_enable(level);
+            return;
+        }
+    }
+    RT_ASSERT(pool->heap_used);
+    pool->heap_used--;
+    rt_hw_interrupt_enable(level);
+
+    free(p);
+}
+
+int media_pool_get_stat(media_pool_t *pool, uint8_t class_idx, media_pool_stat_t *stat)
+{
+    rt_base_t level;
+
+    if (!pool || !stat || class_idx >= pool->class_num)
+    {
+        return -1;
+    }
+    level = rt_hw_interrupt_disable();
+    memcpy(stat, &pool->cls[class_idx].stat, sizeof(media_pool_stat_t));
+    rt_hw_interrupt_enable(level);
+
+    return 0;
+}
+
+void media_queue_attach_pool(media_queue_t *q, media_pool_t *pool)
+{
+    RT_ASSERT(q && !q->pool);
+    q->pool = pool;
+}
+
+void media_queue_free_packet(media_queue_t *q, media_packet_t *p)
+{
+    RT_ASSERT(q && p);
+    if (q->pool)
+    {
+        media_pool_free(q->pool, p);
+    }
+    else
+    {
+        q->free(p);
+    }
+}
+
+media_queue_t *media_queue_open_spsc(media_free func, uint32_t slot_num)
+{
+    uint32_t num = 2;
+    media_queue_t *q = media_queue_open(func);
+
+    while (num < slot_num)
+    {
+        num <<= 1;
+    }
+    q->slots = (media_packet_t **)calloc(num, sizeof(media_packet_t *));
+    RT_ASSERT(q->slots);
+    q->slot_mask = num - 1;
+    q->head = 0;
+    q->tail = 0;
+
+    return q;
+}
+
+static void spsc_clean(media_queue_t *q)
+{
+    media_packet_t *p;
+
+    while (q->head != q->tail)
+    {
+        p = q->slots[q->head & q->slot_mask];
+        q->slots[q->head & q->slot_mask] = NULL;
+        q->head++;
+        media_queue_free_packet(q, p);
+    }
+}
+
+static void spsc_add_tail(media_queue_t *q, media_packet_t *p)
+{
+    uint32_t tail = q->tail;
+
+    while ((tail - q->head) > q->slot_mask)
+    {
+        //full, wait consumer
+        q->wr_waiting = 1;
+        __DMB();
+        if ((tail - q->head) > q->slot_mask)
+        {
+            rt_event_recv(q->event, MEDIA_QUEUE_EVT_SPACE, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, NULL);
+        }
+        q->wr_waiting = 0;
+    }
+
+    q->slots[tail & q->slot_mask] = p;
+    q->bytes_download += p->data_len;
+    if (p->data_type == 'v')
+    {
+        q->debug_v++;
+    }
+    else
+    {
+        q->debug_a++;
+    }
+    //publish slot before moving tail
+    __DMB();
+    q->tail = tail + 1;
+    __DMB();
+    if (q->rd_waiting)
+    {
+        media_queue_set(q);
+    }
+}
+
 void media_queue_close(media_queue_t *q)
 {
     media_packet_t *p;
@@ -41,7 +281,16 @@ void media_queue_close(media_queue_t *q)
     {
         p = rt_list_first_entry(&q->root, media_packet_t, node);
         rt_list_remove(&p->node);
-        q->free(p);
+        media_queue_free_packet(q, p);
+    }
+    if (q->slots)
+    {
+        spsc_clean(q);
+        free(q->slots);
+    }
+    if (q->pool)
+    {
+        media_pool_destroy(q->pool);
     }
     rt_event_delete(q->event);
     unlock(q->mutex);
@@ -59,6 +308,12 @@ void media_queue_add_tail(media_queue_t *q, media_packet_t *p)
 {
     RT_ASSERT(q && p);
 
+    if (q->slots)
+    {
+        spsc_add_tail(q, p);
+        return;
+    }
+
     lock(q->mutex);
 
     rt_list_insert_before(&q->root, &p->node);
@@ -87,7 +342,12 @@ void media_queue_clean(media_queue_t *q)
     {
         p = rt_list_first_entry(&q->root, media_packet_t, node);
         rt_list_remove(&p->node);
-        q->free(p);
+        media_queue_free_packet(q, p);
+    }
+    if (q->slots)
+    {
+        //only called by consumer
+        spsc_clean(q);
     }
 
     q->bytes_download = 0;
@@ -96,16 +356,75 @@ void media_queue_clean(media_queue_t *q)
     unlock(q->mutex);
 }
 
+media_packet_t *media_queue_peek_head(media_queue_t *q)
+{
+    media_packet_t *p = NULL;
+    RT_ASSERT(q);
+
+    if (q->slots)
+    {
+        if (q->head != q->tail)
+        {
+            __DMB();
+            p = q->slots[q->head & q->slot_mask];
+        }
+        return p;
+    }
+
+    lock(q->mutex);
+    if (!rt_list_isempty(&q->root))
+    {
+        p = rt_list_first_entry(&q->root, media_packet_t, node);
+    }
+    unlock(q->mutex);
+
+    return p;
+}
+
+void media_queue_remove_head(media_queue_t *q, media_packet_t *p)
+{
+    RT_ASSERT(q && p);
+
+    if (q->slots)
+    {
+        RT_ASSERT(q->head != q->tail && q->slots[q->head & q->slot_mask] == p);
+        q->slots[q->head & q->slot_mask] = NULL;
+        __DMB();
+        q->head++;
+        __DMB();
+        if (q->wr_waiting)
+        {
+            rt_event_send(q->event, MEDIA_QUEUE_EVT_SPACE);
+        }
+        return;
+    }
+
+    lock(q->mutex);
+    rt_list_remove(&p->node);
+    unlock(q->mutex);
+}
+
 void media_queue_set(media_queue_t *q)
 {
     RT_ASSERT(q);
-    rt_event_send(q->event, 1);
+    rt_event_send(q->event, MEDIA_QUEUE_EVT_DATA);
 }
 
 void media_queue_wait(media_queue_t *q)
 {
     RT_ASSERT(q);
-    rt_event_recv(q->event, 1, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, NULL);
+    if (q->slots)
+    {
+        q->rd_waiting = 1;
+        __DMB();
+        if (q->head == q->tail)
+        {
+            rt_event_recv(q->event, MEDIA_QUEUE_EVT_DATA, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, NULL);
+        }
+        q->rd_waiting = 0;
+        return;
+    }
+    rt_event_recv(q->event, MEDIA_QUEUE_EVT_DATA, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, NULL);
 }
 
 
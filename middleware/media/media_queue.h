@@ -16,27 +16,105 @@ typedef struct
 
 typedef void (*media_free)(void *p);
 
+#define MEDIA_POOL_CLASS_MAX    4
+
+/*size classes for network streaming, small for audio frames and big for video frames*/
+#define MEDIA_POOL_DEFAULT_CLASSES  \
+{                                   \
+    {1024,  32},                    \
+    {4096,  16},                    \
+    {16384, 6},                     \
+}
+
+typedef struct
+{
+    uint32_t data_size;     //max data_len of packet in this class
+    uint32_t num;           //number of preallocated packets
+} media_pool_class_cfg_t;
+
+typedef struct
+{
+    uint32_t data_size;
+    uint32_t num;
+    uint32_t used;
+    uint32_t high_water;    //max used num ever
+    uint32_t alloc_cnt;
+} media_pool_stat_t;
+
+typedef struct
+{
+    uint32_t  block_size;
+    uint32_t  num;
+    uint8_t  *mem;
+    void     *free_list;
+    media_pool_stat_t stat;
+} media_pool_class_t;
+
+typedef struct
+{
+    media_pool_class_t cls[MEDIA_POOL_CLASS_MAX];
+    uint8_t  class_num;
+    uint32_t overflow_cnt;  //allocated from heap as pool is exhausted or packet is too big
+    uint32_t heap_used;     //packets allocated from heap and not freed yet
+} media_pool_t;
+
+#define MEDIA_QUEUE_EVT_DATA    (1 << 0)
+#define MEDIA_QUEUE_EVT_SPACE   (1 << 1)
+
 typedef struct
 {
     rt_list_t root;
     rt_mutex_t mutex;
     rt_event_t event;
     media_free free;
+    media_pool_t *pool;
     uint32_t  debug_last_v;
     uint32_t  debug_last_a;
     uint32_t  debug_v;
     uint32_t  debug_a;
     uint64_t  bytes_download;
     uint64_t  bytes_used;
+    /*lock free single producer single consumer ring, only valid if opened by media_queue_open_spsc()*/
+    media_packet_t **slots;
+    uint32_t  slot_mask;
+    volatile uint32_t head;         //written by consumer only
+    volatile uint32_t tail;         //written by producer only
+    volatile uint8_t  rd_waiting;
+    volatile uint8_t  wr_waiting;
 } media_queue_t;
 
 media_queue_t *media_queue_open(media_free func);
+/*
+    slot_num: number of preallocated packet slots, rounded up to power of 2.
+    only one thread may add packets and only one thread may get packets,
+    no mutex is taken and event is only sent if the peer is waiting.
+*/
+media_queue_t *media_queue_open_spsc(media_free func, uint32_t slot_num);
 uint64_t media_bytes_in_queue(media_queue_t *q);
 void media_queue_close(media_queue_t *q);
 void media_queue_set(media_queue_t *q);
 void media_queue_wait(media_queue_t *q);
 void media_queue_add_tail(media_queue_t *q, media_packet_t *p);
 void media_queue_clean(media_queue_t *q);
+//return first packet or NULL if empty, packet is kept in queue
+media_packet_t *media_queue_peek_head(media_queue_t *q);
+//remove the packet got by media_queue_peek_head() from queue, not freed
+void media_queue_remove_head(media_queue_t *q, media_packet_t *p);
+
+/*
+    fixed size packet pool, class_cfg should be sorted by data_size ascending.
+    packet is allocated from the smallest class that fits, or from heap if all fitted classes are exhausted.
+*/
+media_pool_t *media_pool_create(const media_pool_class_cfg_t *class_cfg, uint8_t class_num);
+void media_pool_destroy(media_pool_t *pool);
+media_packet_t *media_pool_alloc(media_pool_t *pool, uint32_t data_len);
+void media_pool_free(media_pool_t *pool, media_packet_t *p);
+//class_idx: 0 ~ class_num - 1
+int media_pool_get_stat(media_pool_t *pool, uint8_t class_idx, media_pool_stat_t *stat);
+//packets in queue are freed to pool instead of by media_free, pool is destroyed by media_queue_close()
+void media_queue_attach_pool(media_queue_t *q, media_pool_t *pool);
+//free a packet got from the queue
+void media_queue_free_packet(media_queue_t *q, media_packet_t *p);
 
 static inline void _lock(media_queue_t *q)
 {
@@ -0,0 +1,857 @@
+/**
+  ******************************************************************************
+  * @file   mem_profiler.c
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+#include <stdlib.h>
+#include "board.h"
+#include "mem_profiler.h"
+#include "mem_pool_mng.h"
+
+#define DBG_TAG "mem_prof"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#ifdef MEM_PROF_USE_COLLECTOR
+    #include "metrics_collector.h"
+    #include "metrics_id_middleware.h"
+#endif /* MEM_PROF_USE_COLLECTOR */
+
+#ifndef MEM_PROF_SITE_NUM
+    #define MEM_PROF_SITE_NUM           (64)
+#endif
+#ifndef MEM_PROF_RECORD_NUM
+    #define MEM_PROF_RECORD_NUM         (512)   /* Live allocations tracked, must be power of 2 */
+#endif
+#ifndef MEM_PROF_THREAD_NUM
+    #define MEM_PROF_THREAD_NUM         (32)
+#endif
+#ifndef MEM_PROF_STACK_PERIOD_MS
+    #define MEM_PROF_STACK_PERIOD_MS    (1000)
+#endif
+#ifndef MEM_PROF_STACK_WARN_PCT
+    #define MEM_PROF_STACK_WARN_PCT     (90)
+#endif
+#ifndef MEM_PROF_HIST_NUM
+    #define MEM_PROF_HIST_NUM           (24)
+#endif
+#ifndef MEM_PROF_HIST_PERIOD_S
+    #define MEM_PROF_HIST_PERIOD_S      (60)
+#endif
+#ifndef MEM_PROF_BT_SCAN_WORDS
+    #define MEM_PROF_BT_SCAN_WORDS      (256)   /* Stack words scanned for return address */
+#endif
+#ifndef MEM_PROF_MC_SITE_NUM
+    #define MEM_PROF_MC_SITE_NUM        (4)
+#endif
+
+/* Return addresses are only taken from code in XIP flash */
+#ifndef MEM_PROF_CODE_START
+    #if defined(SOC_BF0_HCPU) && defined(HCPU_FLASH_CODE_START_ADDR)
+        #define MEM_PROF_CODE_START     (HCPU_FLASH_CODE_START_ADDR)
+        #define MEM_PROF_CODE_SIZE      (HCPU_FLASH_CODE_SIZE)
+    #else
+        #define MEM_PROF_CODE_START     (0)
+        #define MEM_PROF_CODE_SIZE      (0)
+    #endif
+#endif
+
+#if defined(__CC_ARM)
+    #define MEM_PROF_RET_ADDR()         ((uint32_t)__return_address())
+#else
+    #define MEM_PROF_RET_ADDR()         ((uint32_t)__builtin_return_address(0))
+#endif
+
+#define STACK_FILL_WORD                 (0x23232323)   /* '#' filled by rt_thread_init */
+#define RECORD_INDEX(ptr)               ((((uint32_t)(ptr)) >> 3) * 2654435761u >> 7 & (MEM_PROF_RECORD_NUM - 1))
+#define SITE_NONE                       (0xFFFF)
+
+typedef struct
+{
+    mem_prof_site_t pub;
+    uint32_t prev_live;                 /* live bytes at previous history sample */
+} site_t;
+
+typedef struct
+{
+    void *ptr;                          /* NULL if empty */
+    uint32_t size;
+    uint16_t site;
+} record_t;
+
+typedef struct
+{
+    rt_thread_t thread;
+    void *stack_addr;
+    char name[RT_NAME_MAX];
+    uint32_t stack_size;
+    uint32_t max_used;
+    uint8_t seen;
+    uint8_t dead;
+    uint8_t warned;
+} thread_stat_t;
+
+static uint8_t heap_mask;
+static site_t sites[MEM_PROF_SITE_NUM];
+static uint16_t site_num;
+static record_t records[MEM_PROF_RECORD_NUM];
+static uint16_t record_num;
+static uint32_t untracked;
+static uint32_t heap_live[MEM_PROF_HEAP_NUM];
+static uint32_t heap_peak[MEM_PROF_HEAP_NUM];
+
+static thread_stat_t threads[MEM_PROF_THREAD_NUM];
+static mem_prof_hist_t hist[MEM_PROF_HIST_NUM];
+static uint16_t hist_num, hist_idx;
+static uint32_t hist_elapsed_ms;
+static struct rt_timer sample_timer;
+
+/* Heap tracking --------------------------------------------------------------------------------*/
+static bool is_return_addr(uint32_t addr)
+{
+    uint16_t *ins;
+
+    /* return address of Thumb code has bit 0 set */
+    if (0 == (addr & 1) || addr < MEM_PROF_CODE_START + 4 || addr >= MEM_PROF_CODE_START + MEM_PROF_CODE_SIZE)
+        return false;
+
+    /* preceded by BL, or BLX Rm */
+    ins = (uint16_t *)(addr & ~1);
+    if ((ins[-2] & 0xF800) == 0xF000 && (ins[-1] & 0xD000) == 0xD000)
+        return true;
+    if ((ins[-1] & 0xFF87) == 0x4780)
+        return true;
+    return false;
+}
+
+/* Collect return addresses from ra on, ra is looked up on stack first, it's saved by the
+   function called from allocator if any. Only thread stack is scanned. */
+static uint32_t backtrace(uint32_t ra, uint32_t skip, uint32_t *bt)
+{
+    rt_thread_t thread = rt_thread_self();
+    uint32_t *sp = (uint32_t *)&thread;
+    uint32_t *top, *p;
+    uint32_t hash = 2166136261u;
+    uint32_t n = 0;
+
+    memset(bt, 0, sizeof(uint32_t) * MEM_PROF_BT_DEPTH);
+    if (RT_NULL == thread || rt_interrupt_get_nest())
+        return hash;
+    top = (uint32_t *)((uint32_t)thread->stack_addr + thread->stack_size);
+    if (sp < (uint32_t *)thread->stack_addr || sp >= top)
+        return hash;
+    if (top > sp + MEM_PROF_BT_SCAN_WORDS)
+        top = sp + MEM_PROF_BT_SCAN_WORDS;
+
+    for (p = sp; p < top && (*p | 1) != (ra | 1); p++)
+        ;
+    if (p == top)
+        p = sp;
+
+    for (; p < top && n < MEM_PROF_BT_DEPTH; p++)
+    {
+        if (!is_return_addr(*p))
+            continue;
+        if (skip)
+        {
+            skip--;
+            continue;
+        }
+        bt[n++] = *p;
+        hash = (hash ^ *p) * 16777619u;
+    }
+
+    return hash;
+}
+
+static uint16_t site_get(uint8_t heap, uint32_t hash, uint32_t *bt)
+{
+    uint16_t i;
+
+    hash ^= heap;
+    for (i = 0; i < site_num; i++)
+        if (sites[i].pub.hash == hash && sites[i].pub.heap == heap)
+            return i;
+    if (site_num >= MEM_PROF_SITE_NUM)
+        return SITE_NONE;
+
+    memset(&sites[i], 0, sizeof(sites[i]));
+    sites[i].pub.hash = hash;
+    sites[i].pub.heap = heap;
+    memcpy(sites[i].pub.bt, bt, sizeof(sites[i].pub.bt));
+    site_num++;
+    return i;
+}
+
+static record_t *record_find(void *ptr)
+{
+    uint32_t i, n;
+
+    for (i = RECORD_INDEX(ptr), n = 0; n < MEM_PROF_RECORD_NUM; i = (i + 1) & (MEM_PROF_RECORD_NUM - 1), n++)
+    {
+        if (records[i].ptr == ptr)
+            return &records[i];
+        if (RT_NULL == records[i].ptr)
+            break;
+    }
+    return RT_NULL;
+}
+
+/* Backward shift deletion of linear probing */
+static void record_remove(record_t *r)
+{
+    uint32_t i = r - records, j = i, k;
+
+    while (1)
+    {
+        j = (j + 1) & (MEM_PROF_RECORD_NUM - 1);
+        if (RT_NULL == records[j].ptr)
+            break;
+        k = RECORD_INDEX(records[j].ptr);
+        /* keep j if its home k is cyclically in (i, j] */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        records[i] = records[j];
+        i = j;
+    }
+    records[i].ptr = RT_NULL;
+    record_num--;
+}
+
+static void site_charge(uint16_t s, int32_t size)
+{
+    site_t *site = &sites[s];
+    uint8_t heap = site->pub.heap;
+
+    if (size > 0)
+    {
+        site->pub.alloc_count++;
+        site->pub.live_bytes += size;
+        if (site->pub.live_bytes > site->pub.peak_bytes)
+            site->pub.peak_bytes = site->pub.live_bytes;
+        heap_live[heap] += size;
+        if (heap_live[heap] > heap_peak[heap])
+            heap_peak[heap] = heap_live[heap];
+    }
+    else
+    {
+        site->pub.free_count++;
+        site->pub.live_bytes += size;
+        heap_live[heap] += size;
+    }
+}
+
+static void record_alloc(uint8_t heap, void *ptr, uint32_t size, uint32_t ra, uint32_t skip)
+{
+    uint32_t bt[MEM_PROF_BT_DEPTH];
+    uint32_t hash, i;
+    rt_base_t level;
+    uint16_t s;
+
+    if (RT_NULL == ptr || 0 == (heap_mask & (1 << heap)))
+        return;
+
+    hash = backtrace(ra, skip, bt);
+
+    level = rt_hw_interrupt_disable();
+    s = site_get(heap, hash, bt);
+    if (SITE_NONE == s || record_num >= MEM_PROF_RECORD_NUM - 1)
+    {
+        untracked++;
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+    for (i = RECORD_INDEX(ptr); records[i].ptr; i = (i + 1) & (MEM_PROF_RECORD_NUM - 1))
+        ;
+    records[i].ptr = ptr;
+    records[i].size = size;
+    records[i].site = s;
+    record_num++;
+    site_charge(s, size);
+    rt_hw_interrupt_enable(level);
+}
+
+static void record_free(void *ptr)
+{
+    rt_base_t level;
+    record_t *r;
+
+    if (RT_NULL == ptr || 0 == heap_mask)
+        return;
+
+    level = rt_hw_interrupt_disable();
+    r = record_find(ptr);
+    if (r)
+    {
+        site_charge(r->site, -(int32_t)r->size);
+        record_remove(r);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static void sys_malloc_hook(void *ptr, rt_size_t size)
+{
+    /* skip return address into rt_malloc */
+    record_alloc(MEM_PROF_HEAP_SYS, ptr, size, MEM_PROF_RET_ADDR(), 1);
+}
+
+static void sys_free_hook(void *ptr)
+{
+    record_free(ptr);
+}
+
+void mem_prof_alloc(uint8_t heap, void *ptr, uint32_t size, uint32_t skip)
+{
+    record_alloc(heap, ptr, size, MEM_PROF_RET_ADDR(), skip);
+}
+
+void mem_prof_free(void *ptr)
+{
+    record_free(ptr);
+}
+
+void mem_prof_retag(void *ptr, uint8_t heap)
+{
+    uint32_t bt[MEM_PROF_BT_DEPTH];
+    rt_base_t level;
+    record_t *r;
+    uint16_t s;
+
+    if (RT_NULL == ptr || 0 == (heap_mask & (1 << heap)))
+        return;
+
+    level = rt_hw_interrupt_disable();
+    r = record_find(ptr);
+    if (r)
+    {
+        memcpy(bt, sites[r->site].pub.bt, sizeof(bt));
+        s = site_get(heap, sites[r->site].pub.hash ^ sites[r->site].pub.heap, bt);
+        if (SITE_NONE != s)
+        {
+            /* not a free of old site */
+            sites[r->site].pub.alloc_count--;
+            sites[r->site].pub.live_bytes -= r->size;
+            heap_live[sites[r->site].pub.heap] -= r->size;
+            r->site = s;
+            site_charge(s, r->size);
+        }
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+void *mem_prof_pool_alloc(int pool_id, size_t size)
+{
+    void *p = (mem_pool_alloc)((mem_pool_id_t)pool_id, size);
+
+    record_alloc(MEM_PROF_HEAP_POOL, p, size, MEM_PROF_RET_ADDR(), 0);
+    return p;
+}
+
+void *mem_prof_pool_calloc(int pool_id, size_t count, size_t size)
+{
+    void *p = (mem_pool_calloc)((mem_pool_id_t)pool_id, count, size);
+
+    record_alloc(MEM_PROF_HEAP_POOL, p, count * size, MEM_PROF_RET_ADDR(), 0);
+    return p;
+}
+
+void *mem_prof_pool_realloc(void *p, size_t new_size)
+{
+    void *n = (mem_pool_realloc)(p, new_size);
+
+    if (n || 0 == new_size)
+        record_free(p);
+    record_alloc(MEM_PROF_HEAP_POOL, n, new_size, MEM_PROF_RET_ADDR(), 0);
+    return n;
+}
+
+void mem_prof_pool_free(void *p)
+{
+    record_free(p);
+    (mem_pool_free)(p);
+}
+
+void mem_prof_start(uint32_t mask)
+{
+    rt_base_t level;
+
+    /* audio memory is from rt_malloc, it's found by record of rt_malloc */
+    if (mask & (1 << MEM_PROF_HEAP_AUDIO))
+        mask |= 1 << MEM_PROF_HEAP_SYS;
+    mem_prof_stop();
+    level = rt_hw_interrupt_disable();
+    heap_mask = (uint8_t)(mask & MEM_PROF_HEAP_MASK_ALL);
+    rt_hw_interrupt_enable(level);
+#ifdef RT_USING_HOOK
+    if (mask & (1 << MEM_PROF_HEAP_SYS))
+    {
+        rt_malloc_sethook(sys_malloc_hook);
+        rt_free_sethook(sys_free_hook);
+    }
+#endif
+}
+
+void mem_prof_stop(void)
+{
+    rt_base_t level;
+
+#ifdef RT_USING_HOOK
+    rt_malloc_sethook(RT_NULL);
+    rt_free_sethook(RT_NULL);
+#endif
+    level = rt_hw_interrupt_disable();
+    heap_mask = 0;
+    memset(records, 0, sizeof(records));
+    record_num = 0;
+    site_num = 0;
+    untracked = 0;
+    memset(heap_live, 0, sizeof(heap_live));
+    memset(heap_peak, 0, sizeof(heap_peak));
+    hist_num = 0;
+    hist_idx = 0;
+    rt_hw_interrupt_enable(level);
+}
+
+static int32_t site_key(mem_prof_site_t *s, mem_prof_sort_t sort)
+{
+    if (MEM_PROF_SORT_COUNT == sort)
+        return (int32_t)s->alloc_count;
+    if (MEM_PROF_SORT_GROWTH == sort)
+        return s->growth;
+    return (int32_t)s->live_bytes;
+}
+
+int mem_prof_get_sites(mem_prof_site_t *out, int max, mem_prof_sort_t sort)
+{
+    mem_prof_site_t t;
+    rt_base_t level;
+    int i, j, n = 0;
+
+    for (i = 0; i < site_num; i++)
+    {
+        level = rt_hw_interrupt_disable();
+        t = sites[i].pub;
+        rt_hw_interrupt_enable(level);
+
+        /* insert into top list */
+        for (j = n; j > 0 && site_key(&out[j - 1], sort) < site_key(&t, sort); j--)
+            if (j < max)
+                out[j] = out[j - 1];
+        if (j < max)
+        {
+            out[j] = t;
+            if (n < max)
+                n++;
+        }
+    }
+    return n;
+}
+
+void mem_prof_get_summary(mem_prof_summary_t *summary)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    memcpy(summary->live_bytes, heap_live, sizeof(heap_live));
+    memcpy(summary->peak_bytes, heap_peak, sizeof(heap_peak));
+    summary->untracked = untracked;
+    summary->site_num = site_num;
+    summary->record_num = record_num;
+    rt_hw_interrupt_enable(level);
+}
+
+int mem_prof_get_history(mem_prof_hist_t *out, int max)
+{
+    rt_base_t level;
+    int i, n;
+
+    level = rt_hw_interrupt_disable();
+    n = hist_num < max ? hist_num : max;
+    for (i = 0; i < n; i++)
+        out[i] = hist[(hist_idx + MEM_PROF_HIST_NUM - n + i) % MEM_PROF_HIST_NUM];
+    rt_hw_interrupt_enable(level);
+    return n;
+}
+
+static void hist_sample(void)
+{
+    rt_base_t level;
+    uint16_t i;
+
+    level = rt_hw_interrupt_disable();
+    hist[hist_idx].time = rt_tick_get() / RT_TICK_PER_SECOND;
+    memcpy(hist[hist_idx].live_bytes, heap_live, sizeof(heap_live));
+    hist_idx = (hist_idx + 1) % MEM_PROF_HIST_NUM;
+    if (hist_num < MEM_PROF_HIST_NUM)
+        hist_num++;
+    for (i = 0; i < site_num; i++)
+    {
+        sites[i].pub.growth = (int32_t)(sites[i].pub.live_bytes - sites[i].prev_live);
+        sites[i].prev_live = sites[i].pub.live_bytes;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/* Stack sampling -------------------------------------------------------------------------------*/
+static uint32_t stack_used(rt_thread_t thread)
+{
+    uint32_t *p = (uint32_t *)RT_ALIGN((uint32_t)thread->stack_addr, 4);
+    uint32_t *top = (uint32_t *)((uint32_t)thread->stack_addr + thread->stack_size);
+
+    while (p < top && STACK_FILL_WORD == *p)
+        p++;
+    return (uint32_t)top - (uint32_t)p;
+}
+
+static thread_stat_t *thread_stat_get(rt_thread_t thread)
+{
+    thread_stat_t *free = RT_NULL;
+    uint32_t i;
+
+    for (i = 0; i < MEM_PROF_THREAD_NUM; i++)
+    {
+        if (threads[i].thread == thread && threads[i].stack_addr == thread->stack_addr)
+            return &threads[i];
+        if (RT_NULL == threads[i].thread)
+            free = &threads[i];
+    }
+    /* entry of deleted thread is kept until table is full */
+    for (i = 0; RT_NULL == free && i < MEM_PROF_THREAD_NUM; i++)
+        if (threads[i].dead)
+            free = &threads[i];
+    if (free)
+    {
+        memset(free, 0, sizeof(*free));
+        free->thread = thread;
+        free->stack_addr = thread->stack_addr;
+        free->stack_size = thread->stack_size;
+        rt_strncpy(free->name, thread->name, RT_NAME_MAX);
+    }
+    return free;
+}
+
+static void stack_sample(void)
+{
+    struct rt_object_information *info = rt_object_get_information(RT_Object_Class_Thread);
+    struct rt_list_node *node;
+    thread_stat_t *stat;
+    rt_thread_t thread;
+    uint32_t i, used;
+
+    for (i = 0; i < MEM_PROF_THREAD_NUM; i++)
+        threads[i].seen = 0;
+
+    rt_enter_critical();
+    for (node = info->object_list.next; node != &info->object_list; node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+        stat = thread_stat_get(thread);
+        if (RT_NULL == stat)
+            continue;
+        stat->seen = 1;
+        stat->dead = 0;
+        used = stack_used(thread);
+        if (used <= stat->max_used)
+            continue;
+        stat->max_used = used;
+        if (!stat->warned && used * 100 >= stat->stack_size * MEM_PROF_STACK_WARN_PCT)
+        {
+            stat->warned = 1;
+            LOG_W("%.*s stack used %d/%d", RT_NAME_MAX, stat->name, used, stat->stack_size);
+        }
+    }
+    rt_exit_critical();
+
+    for (i = 0; i < MEM_PROF_THREAD_NUM; i++)
+        if (threads[i].thread && !threads[i].seen)
+            threads[i].dead = 1;
+}
+
+int mem_prof_get_stacks(mem_prof_stack_t *out, int max)
+{
+    mem_prof_stack_t t;
+    uint32_t i;
+    int j, n = 0;
+
+    rt_enter_critical();
+    for (i = 0; i < MEM_PROF_THREAD_NUM; i++)
+    {
+        if (RT_NULL == threads[i].thread || 0 == threads[i].stack_size)
+            continue;
+        memcpy(t.name, threads[i].name, RT_NAME_MAX);
+        t.stack_size = threads[i].stack_size;
+        t.max_used = threads[i].max_used;
+        for (j = n; j > 0 && (uint64_t)out[j - 1].max_used * t.stack_size < (uint64_t)t.max_used * out[j - 1].stack_size; j--)
+            if (j < max)
+                out[j] = out[j - 1];
+        if (j < max)
+        {
+            out[j] = t;
+            if (n < max)
+                n++;
+        }
+    }
+    rt_exit_critical();
+    return n;
+}
+
+static void sample_timeout(void *param)
+{
+    stack_sample();
+    hist_elapsed_ms += MEM_PROF_STACK_PERIOD_MS;
+    if (heap_mask && hist_elapsed_ms >= MEM_PROF_HIST_PERIOD_S * 1000)
+    {
+        hist_elapsed_ms = 0;
+        hist_sample();
+    }
+}
+
+#ifdef MEM_PROF_USE_COLLECTOR
+typedef struct
+{
+    uint32_t hash;
+    uint32_t bt0;
+    uint32_t live_bytes;
+    uint32_t alloc_count;
+} mem_prof_mc_site_t;
+
+typedef struct
+{
+    uint32_t live_bytes[MEM_PROF_HEAP_NUM];
+    uint32_t peak_bytes[MEM_PROF_HEAP_NUM];
+    uint32_t untracked;
+    uint8_t site_num;
+    uint8_t reserved[3];
+    mem_prof_mc_site_t site[0];
+} mem_prof_heap_metrics_t;
+
+typedef struct
+{
+    char name[8];
+    uint32_t stack_size;
+    uint32_t max_used;
+} mem_prof_mc_stack_t;
+
+typedef struct
+{
+    uint8_t thread_num;
+    uint8_t reserved[3];
+    mem_prof_mc_stack_t thread[0];
+} mem_prof_stack_metrics_t;
+
+#define MEM_PROF_MC_THREAD_NUM  ((MC_MAX_DATA_LEN - sizeof(mem_prof_stack_metrics_t)) / sizeof(mem_prof_mc_stack_t))
+
+static mc_collector_t mem_prof_collector;
+
+static void mem_prof_metrics_collect(void *user_data)
+{
+    mem_prof_site_t top[MEM_PROF_MC_SITE_NUM];
+    mem_prof_stack_t stacks[MEM_PROF_MC_THREAD_NUM];
+    mem_prof_stack_metrics_t *sm;
+    mem_prof_heap_metrics_t *hm;
+    mem_prof_summary_t sum;
+    int i, n;
+
+    n = mem_prof_get_stacks(stacks, MEM_PROF_MC_THREAD_NUM);
+    sm = mc_alloc_metrics(METRICS_MW_MEM_PROF_STACK, sizeof(*sm) + n * sizeof(sm->thread[0]));
+    RT_ASSERT(sm);
+    sm->thread_num = n;
+    for (i = 0; i < n; i++)
+    {
+        rt_strncpy(sm->thread[i].name, stacks[i].name, sizeof(sm->thread[i].name));
+        sm->thread[i].stack_size = stacks[i].stack_size;
+        sm->thread[i].max_used = stacks[i].max_used;
+    }
+    mc_save_metrics(sm, true);
+
+    if (0 == heap_mask)
+        return;
+    mem_prof_get_summary(&sum);
+    n = mem_prof_get_sites(top, MEM_PROF_MC_SITE_NUM, MEM_PROF_SORT_LIVE);
+    hm = mc_alloc_metrics(METRICS_MW_MEM_PROF_HEAP, sizeof(*hm) + n * sizeof(hm->site[0]));
+    RT_ASSERT(hm);
+    memcpy(hm->live_bytes, sum.live_bytes, sizeof(hm->live_bytes));
+    memcpy(hm->peak_bytes, sum.peak_bytes, sizeof(hm->peak_bytes));
+    hm->untracked = sum.untracked;
+    hm->site_num = n;
+    for (i = 0; i < n; i++)
+    {
+        hm->site[i].hash = top[i].hash;
+        hm->site[i].bt0 = top[i].bt[0];
+        hm->site[i].live_bytes = top[i].live_bytes;
+        hm->site[i].alloc_count = top[i].alloc_count;
+    }
+    mc_save_metrics(hm, true);
+}
+#endif /* MEM_PROF_USE_COLLECTOR */
+
+static int mem_prof_init(void)
+{
+    rt_timer_init(&sample_timer, "mem_prof", sample_timeout, RT_NULL,
+                  rt_tick_from_millisecond(MEM_PROF_STACK_PERIOD_MS), RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_SOFT_TIMER);
+    rt_timer_start(&sample_timer);
+#ifdef MEM_PROF_HEAP_AUTO_START
+    mem_prof_start(MEM_PROF_HEAP_MASK_ALL);
+#endif
+#ifdef MEM_PROF_USE_COLLECTOR
+    mem_prof_collector.callback = mem_prof_metrics_collect;
+    mem_prof_collector.period = MC_PERIOD_EVERY_HOUR;
+    mem_prof_collector.user_data = 0;
+    RT_ASSERT(MC_OK == mc_register_collector(&mem_prof_collector));
+#endif
+    return 0;
+}
+INIT_APP_EXPORT(mem_prof_init);
+
+#ifdef RT_USING_FINSH
+static const char *const heap_name[MEM_PROF_HEAP_NUM] = {"sys", "pool", "audio"};
+
+static void print_top(mem_prof_sort_t sort, int max)
+{
+    mem_prof_site_t *top;
+    mem_prof_summary_t sum;
+    int i, j, n;
+
+    mem_prof_get_summary(&sum);
+    for (i = 0; i < MEM_PROF_HEAP_NUM; i++)
+        rt_kprintf("%-5s live %d peak %d\n", heap_name[i], sum.live_bytes[i], sum.peak_bytes[i]);
+    rt_kprintf("sites %d, records %d, untracked %d\n", sum.site_num, sum.record_num, sum.untracked);
+
+    if (max <= 0 || max > MEM_PROF_SITE_NUM)
+        max = MEM_PROF_SITE_NUM;
+    top = rt_malloc(max * sizeof(*top));
+    if (RT_NULL == top)
+        return;
+    n = mem_prof_get_sites(top, max, sort);
+    rt_kprintf("%-5s %8s %8s %8s %8s %8s | backtrace\n", "heap", "live", "peak", "growth", "alloc", "free");
+    for (i = 0; i < n; i++)
+    {
+        rt_kprintf("%-5s %8d %8d %8d %8d %8d |", heap_name[top[i].heap], top[i].live_bytes, top[i].peak_bytes,
+                   top[i].growth, top[i].alloc_count, top[i].free_count);
+        for (j = 0; j < MEM_PROF_BT_DEPTH && top[i].bt[j]; j++)
+            rt_kprintf(" 0x%08x", top[i].bt[j]);
+        rt_kprintf("\n");
+    }
+    rt_free(top);
+}
+
+static void print_stack(void)
+{
+    mem_prof_stack_t *s;
+    int i, n;
+
+    s = rt_malloc(MEM_PROF_THREAD_NUM * sizeof(*s));
+    if (RT_NULL == s)
+        return;
+    n = mem_prof_get_stacks(s, MEM_PROF_THREAD_NUM);
+    rt_kprintf("%-*.*s %6s %6s %4s\n", RT_NAME_MAX, RT_NAME_MAX, "thread", "size", "max", "pct");
+    for (i = 0; i < n; i++)
+        rt_kprintf("%-*.*s %6d %6d %3d%%\n", RT_NAME_MAX, RT_NAME_MAX, s[i].name, s[i].stack_size, s[i].max_used,
+                   s[i].max_used * 100 / s[i].stack_size);
+    rt_free(s);
+}
+
+static void print_hist(void)
+{
+    mem_prof_hist_t h[MEM_PROF_HIST_NUM];
+    int i, n;
+
+    n = mem_prof_get_history(h, MEM_PROF_HIST_NUM);
+    rt_kprintf("%8s %8s %8s %8s\n", "time", heap_name[0], heap_name[1], heap_name[2]);
+    for (i = 0; i < n; i++)
+        rt_kprintf("%8d %8d %8d %8d\n", h[i].time, h[i].live_bytes[0], h[i].live_bytes[1], h[i].live_bytes[2]);
+}
+
+static int mem_prof(int argc, char **argv)
+{
+    uint32_t mask, i;
+    mem_prof_sort_t sort;
+
+    if (argc >= 2 && 0 == strcmp(argv[1], "start"))
+    {
+        mask = argc > 2 ? 0 : MEM_PROF_HEAP_MASK_ALL;
+        for (i = 2; i < (uint32_t)argc; i++)
+        {
+            if (0 == strcmp(argv[i], "all"))
+                mask = MEM_PROF_HEAP_MASK_ALL;
+            else if (0 == strcmp(argv[i], heap_name[0]))
+                mask |= 1 << MEM_PROF_HEAP_SYS;
+            else if (0 == strcmp(argv[i], heap_name[1]))
+                mask |= 1 << MEM_PROF_HEAP_POOL;
+            else if (0 == strcmp(argv[i], heap_name[2]))
+                mask |= 1 << MEM_PROF_HEAP_AUDIO;
+        }
+        mem_prof_start(mask);
+    }
+    else if (argc >= 2 && 0 == strcmp(argv[1], "stop"))
+        mem_prof_stop();
+    else if (argc >= 2 && 0 == strcmp(argv[1], "top"))
+    {
+        sort = MEM_PROF_SORT_LIVE;
+        if (argc > 2 && 0 == strcmp(argv[2], "count"))
+            sort = MEM_PROF_SORT_COUNT;
+        else if (argc > 2 && 0 == strcmp(argv[2], "grow"))
+            sort = MEM_PROF_SORT_GROWTH;
+        print_top(sort, argc > 3 ? atoi(argv[3]) : 10);
+    }
+    else if (argc >= 2 && 0 == strcmp(argv[1], "stack"))
+        print_stack();
+    else if (argc >= 2 && 0 == strcmp(argv[1], "hist"))
+        print_hist();
+    else
+    {
+        rt_kprintf("mem_prof start [all|sys|pool|audio]...\n");
+        rt_kprintf("mem_prof stop\n");
+        rt_kprintf("mem_prof top [live|count|grow] [n]\n");
+        rt_kprintf("mem_prof stack\n");
+        rt_kprintf("mem_prof hist\n");
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(mem_prof, Stack and heap profiling);
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
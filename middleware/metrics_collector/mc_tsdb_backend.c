@@ -132,7 +132,7 @@ void *mc_backend_init(const char *name, uint32_t max_size)
 
 #endif /* FDB_USING_FILE_MODE */
 
-    result = fdb_tsdb_init(tsdb, name, name, get_time, MC_MAX_DATA_LEN, NULL);
+    result = fdb_tsdb_init(tsdb, name, name, get_time, MC_BACKEND_MAX_DATA_LEN, NULL);
     RT_ASSERT(FDB_NO_ERR == result);
 
     return tsdb;
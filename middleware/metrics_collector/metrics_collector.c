@@ -62,6 +62,10 @@
     #include "data_service.h"
 #endif /* MC_SERVICE_ENABLED */
 
+#ifdef MC_BATCH_ENABLED
+    #include "lz4.h"
+#endif /* MC_BATCH_ENABLED */
+
 #include "log.h"
 
 
@@ -118,6 +122,39 @@ typedef struct
     bool freed;
 } mc_mq_msg_t;
 
+#ifdef MC_BATCH_ENABLED
+/* Reserved metrics id of a block of batched metrics */
+#define MC_BATCH_BLOCK_ID   (0x1FFF)
+
+/* Backend record of batched metrics, hdr.len covers raw_len, rec_num and payload.
+   Payload is LZ4 compressed if shorter than raw_len, otherwise stored as is */
+typedef struct
+{
+    mc_metrics_hdr_t hdr;
+    uint16_t raw_len;
+    uint16_t rec_num;
+    uint8_t payload[0];
+} mc_batch_block_t;
+
+#define MC_BATCH_BLOCK_HDR_LEN   (sizeof(mc_batch_block_t) - sizeof(mc_metrics_hdr_t))
+
+typedef struct
+{
+    uint16_t len;
+    uint16_t rec_num;
+    uint32_t time;          /* time of first metrics */
+    uint8_t data[MC_BATCH_BLOCK_SIZE];
+} mc_batch_stage_t;
+
+#if MC_BATCH_BLOCK_SIZE < MC_MAX_DATA_LEN
+    #error "MC_BATCH_BLOCK_SIZE cannot be less than MC_MAX_DATA_LEN"
+#endif
+
+static LZ4_stream_t mc_lz4_state;
+static uint32_t mc_batch_out[(sizeof(mc_batch_block_t) + MC_BATCH_BLOCK_SIZE + 3) / 4];
+static mc_batch_stat_t mc_batch_stat;
+#endif /* MC_BATCH_ENABLED */
+
 
 static mc_ctx_t mc_ctx;
 static struct rt_thread g_metrics_thread;
@@ -151,6 +188,204 @@ static inline void mc_exit_critical(void)
 }
 
 
+#ifdef MC_BATCH_ENABLED
+static uint32_t mc_batch_get_us(uint32_t start)
+{
+    return (HAL_DBG_DWT_GetCycles() - start) / (HAL_RCC_GetHCLKFreq(CORE_ID_CURRENT) / 1000000);
+}
+
+/* Compress staged metrics and write them as one backend record, must be called in critical section */
+static mc_err_t mc_batch_flush(mc_db_t *db)
+{
+    mc_batch_stage_t *stage = (mc_batch_stage_t *)db->batch;
+    mc_batch_block_t *block = (mc_batch_block_t *)mc_batch_out;
+    uint32_t start;
+    int comp_len;
+    mc_err_t err = MC_OK;
+
+    if (!stage || (0 == stage->len))
+    {
+        return MC_OK;
+    }
+
+    start = HAL_DBG_DWT_GetCycles();
+    comp_len = LZ4_compress_fast_extState(&mc_lz4_state, (const char *)stage->data, (char *)block->payload,
+                                          stage->len, stage->len - 1, 1);
+    if (comp_len <= 0)
+    {
+        memcpy(block->payload, stage->data, stage->len);
+        comp_len = stage->len;
+    }
+    block->hdr.id = MC_BATCH_BLOCK_ID;
+    block->hdr.core = CORE_ID_CURRENT;
+    block->hdr.len = MC_BATCH_BLOCK_HDR_LEN + comp_len;
+    block->hdr.time = stage->time;
+    block->raw_len = stage->len;
+    block->rec_num = stage->rec_num;
+
+    if (db->db)
+    {
+        err = mc_backend_write(db->db, block, MC_METRICS_TOTAL_LEN(block->hdr.len));
+    }
+
+    mc_batch_stat.blocks++;
+    mc_batch_stat.records += stage->rec_num;
+    mc_batch_stat.raw_bytes += stage->len;
+    mc_batch_stat.stored_bytes += MC_METRICS_TOTAL_LEN(block->hdr.len);
+    mc_batch_stat.last_flush_us = mc_batch_get_us(start);
+    if (mc_batch_stat.last_flush_us > mc_batch_stat.max_flush_us)
+    {
+        mc_batch_stat.max_flush_us = mc_batch_stat.last_flush_us;
+    }
+
+    stage->len = 0;
+    stage->rec_num = 0;
+
+    return err;
+}
+
+static mc_err_t mc_batch_write(mc_db_t *db, mc_metrics_t *metrics)
+{
+    mc_batch_stage_t *stage = (mc_batch_stage_t *)db->batch;
+    uint32_t len = MC_METRICS_TOTAL_LEN(metrics->header.len);
+    mc_err_t err = MC_OK;
+
+    if (!stage)
+    {
+        stage = rt_malloc(sizeof(*stage));
+        if (!stage)
+        {
+            /* write directly if out of memory */
+            return mc_backend_write(db->db, metrics, len);
+        }
+        stage->len = 0;
+        stage->rec_num = 0;
+        db->batch = stage;
+    }
+
+    /* keep metrics header aligned in block */
+    len = RT_ALIGN(len, 4);
+    if (stage->len + len > MC_BATCH_BLOCK_SIZE)
+    {
+        err = mc_batch_flush(db);
+    }
+    if (0 == stage->len)
+    {
+        stage->time = metrics->header.time;
+    }
+    memcpy(&stage->data[stage->len], metrics, MC_METRICS_TOTAL_LEN(metrics->header.len));
+    stage->len += len;
+    stage->rec_num++;
+
+    return err;
+}
+
+static bool mc_batch_pending(void)
+{
+    rt_list_t *iter;
+    mc_db_t *db;
+
+    rt_list_for_each(iter, &mc_ctx.db_list)
+    {
+        db = rt_list_entry(iter, mc_db_t, node);
+        if (db->batch && ((mc_batch_stage_t *)db->batch)->len)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void mc_batch_flush_all(void)
+{
+    rt_list_t *iter;
+    mc_db_t *db;
+
+    mc_enter_critical();
+    rt_list_for_each(iter, &mc_ctx.db_list)
+    {
+        db = rt_list_entry(iter, mc_db_t, node);
+        mc_ctx.err_code = mc_batch_flush(db);
+    }
+    mc_exit_critical();
+}
+
+/* Walk metrics in a backend record, return true if cb interrupts reading */
+static bool mc_batch_iter(void *data, uint32_t data_len, mc_backend_iter_cb_t cb, void *arg)
+{
+    mc_batch_block_t *block = (mc_batch_block_t *)data;
+    mc_metrics_hdr_t *hdr;
+    uint8_t *raw;
+    uint32_t stored_len;
+    uint32_t pos;
+    bool res = false;
+
+    if (MC_BATCH_BLOCK_ID != block->hdr.id)
+    {
+        /* metrics saved without batching */
+        return cb(data, data_len, arg);
+    }
+
+    stored_len = block->hdr.len - MC_BATCH_BLOCK_HDR_LEN;
+    if (stored_len < block->raw_len)
+    {
+        raw = rt_malloc(block->raw_len);
+        RT_ASSERT(raw);
+        if (LZ4_decompress_safe((const char *)block->payload, (char *)raw, stored_len, block->raw_len) != block->raw_len)
+        {
+            LOG_W("corrupted metrics block");
+            rt_free(raw);
+            return false;
+        }
+    }
+    else
+    {
+        raw = block->payload;
+    }
+
+    for (pos = 0; !res && (pos + sizeof(mc_metrics_hdr_t) <= block->raw_len);)
+    {
+        hdr = (mc_metrics_hdr_t *)&raw[pos];
+        res = cb(hdr, MC_METRICS_TOTAL_LEN(hdr->len), arg);
+        pos += RT_ALIGN(MC_METRICS_TOTAL_LEN(hdr->len), 4);
+    }
+
+    if (raw != block->payload)
+    {
+        rt_free(raw);
+    }
+
+    return res;
+}
+
+void mc_get_batch_stat(mc_batch_stat_t *stat, bool reset)
+{
+    RT_ASSERT(stat);
+
+    mc_enter_critical();
+    memcpy(stat, &mc_batch_stat, sizeof(*stat));
+    if (reset)
+    {
+        memset(&mc_batch_stat, 0, sizeof(mc_batch_stat));
+    }
+    mc_exit_critical();
+}
+
+static int mc_batch(int argc, char **argv)
+{
+    mc_batch_stat_t stat;
+
+    mc_get_batch_stat(&stat, (argc > 1) && (0 == strcmp(argv[1], "reset")));
+    rt_kprintf("blocks:%d records:%d raw:%d stored:%d ratio:%d%%\n", stat.blocks, stat.records,
+               stat.raw_bytes, stat.stored_bytes, stat.raw_bytes ? (stat.stored_bytes * 100 / stat.raw_bytes) : 0);
+    rt_kprintf("flush time(us) last:%d max:%d\n", stat.last_flush_us, stat.max_flush_us);
+
+    return 0;
+}
+MSH_CMD_EXPORT(mc_batch, mc_batch [reset]: show batched write statistics);
+#endif /* MC_BATCH_ENABLED */
+
 static void mc_timer_timeout_handler(void *parameter)
 {
     mc_collector_mng_t *mng;
@@ -400,6 +635,9 @@ mc_err_t mc_flush(void)
     mc_err_t err = MC_OK;
 
     mc_enter_critical();
+#ifdef MC_BATCH_ENABLED
+    mc_batch_flush(&mc_ctx.default_db);
+#endif /* MC_BATCH_ENABLED */
     if (mc_ctx.default_db.db)
     {
         err = mc_backend_flush(mc_ctx.default_db.db);
@@ -416,6 +654,9 @@ mc_err_t mc_close(void)
     mc_err_t err = MC_OK;
 
     mc_enter_critical();
+#ifdef MC_BATCH_ENABLED
+    mc_batch_flush(&mc_ctx.default_db);
+#endif /* MC_BATCH_ENABLED */
     if (mc_ctx.default_db.db)
     {
         err = mc_backend_close(mc_ctx.default_db.db);
@@ -439,6 +680,9 @@ mc_err_t mc_flush_ex(mc_db_t *db)
     }
 
     mc_enter_critical();
+#ifdef MC_BATCH_ENABLED
+    mc_batch_flush(db);
+#endif /* MC_BATCH_ENABLED */
     err = mc_backend_flush(db->db);
     mc_ctx.err_code = err;
     mc_exit_critical();
@@ -458,6 +702,13 @@ static bool mc_raw_metrics_iter_cb(void *data, uint32_t data_len, void *arg)
     return user_cb(data, data_len, hdr->time);
 }
 
+#ifdef MC_BATCH_ENABLED
+static bool mc_raw_metrics_block_iter_cb(void *data, uint32_t data_len, void *arg)
+{
+    return mc_batch_iter(data, data_len, mc_raw_metrics_iter_cb, arg);
+}
+#endif /* MC_BATCH_ENABLED */
+
 static bool mc_parsed_metrics_iter_cb(void *data, uint32_t data_len, void *arg)
 {
     mc_metrics_hdr_t *hdr = (mc_metrics_hdr_t *)data;
@@ -468,6 +719,18 @@ static bool mc_parsed_metrics_iter_cb(void *data, uint32_t data_len, void *arg)
     return user_cb(hdr->id, hdr->core, hdr->len, hdr->time, (void *)(hdr + 1));
 }
 
+#ifdef MC_BATCH_ENABLED
+static bool mc_parsed_metrics_block_iter_cb(void *data, uint32_t data_len, void *arg)
+{
+    return mc_batch_iter(data, data_len, mc_parsed_metrics_iter_cb, arg);
+}
+    #define MC_RAW_METRICS_ITER_CB     mc_raw_metrics_block_iter_cb
+    #define MC_PARSED_METRICS_ITER_CB  mc_parsed_metrics_block_iter_cb
+#else
+    #define MC_RAW_METRICS_ITER_CB     mc_raw_metrics_iter_cb
+    #define MC_PARSED_METRICS_ITER_CB  mc_parsed_metrics_iter_cb
+#endif /* MC_BATCH_ENABLED */
+
 
 mc_err_t mc_read_raw_metrics(mc_raw_metrics_read_callback_t cb)
 {
@@ -481,7 +744,10 @@ mc_err_t mc_read_raw_metrics(mc_raw_metrics_read_callback_t cb)
     mc_enter_critical();
     if (mc_ctx.default_db.db)
     {
-        mc_backend_iter(mc_ctx.default_db.db, mc_raw_metrics_iter_cb, (void *)cb);
+#ifdef MC_BATCH_ENABLED
+        mc_batch_flush(&mc_ctx.default_db);
+#endif /* MC_BATCH_ENABLED */
+        mc_backend_iter(mc_ctx.default_db.db, MC_RAW_METRICS_ITER_CB, (void *)cb);
     }
     else
     {
@@ -505,7 +771,10 @@ mc_err_t mc_read_metrics(mc_metrics_read_callback_t cb)
     mc_enter_critical();
     if (mc_ctx.default_db.db)
     {
-        mc_backend_iter(mc_ctx.default_db.db, mc_parsed_metrics_iter_cb, (void *)cb);
+#ifdef MC_BATCH_ENABLED
+        mc_batch_flush(&mc_ctx.default_db);
+#endif /* MC_BATCH_ENABLED */
+        mc_backend_iter(mc_ctx.default_db.db, MC_PARSED_METRICS_ITER_CB, (void *)cb);
     }
     else
     {
@@ -523,6 +792,16 @@ mc_err_t mc_clear_metrics(void)
         return MC_ERROR;
     }
 
+#ifdef MC_BATCH_ENABLED
+    mc_enter_critical();
+    if (mc_ctx.default_db.batch)
+    {
+        ((mc_batch_stage_t *)mc_ctx.default_db.batch)->len = 0;
+        ((mc_batch_stage_t *)mc_ctx.default_db.batch)->rec_num = 0;
+    }
+    mc_exit_critical();
+#endif /* MC_BATCH_ENABLED */
+
     return mc_backend_clear(mc_ctx.default_db.db);
 }
 
@@ -693,8 +972,12 @@ static void mc_handle_msg(mc_mq_msg_t *msg)
     mc_enter_critical();
     if (msg->db->db) /* check whether db has been closed */
     {
+#ifdef MC_BATCH_ENABLED
+        err = mc_batch_write(msg->db, msg->data);
+#else
         err = mc_backend_write(msg->db->db, msg->data,
                                MC_METRICS_TOTAL_LEN(msg->data->header.len));
+#endif /* MC_BATCH_ENABLED */
         mc_ctx.err_code = err;
     }
     mc_exit_critical();
@@ -712,7 +995,18 @@ static void mc_thread_entry(void *param)
 
     while (1)
     {
+#ifdef MC_BATCH_ENABLED
+        /* write staged metrics if no more metrics come in a while */
+        err = rt_mq_recv(mc_ctx.queue, &msg, sizeof(msg),
+                         mc_batch_pending() ? rt_tick_from_millisecond(MC_BATCH_FLUSH_MS) : RT_WAITING_FOREVER);
+        if (-RT_ETIMEOUT == err)
+        {
+            mc_batch_flush_all();
+            continue;
+        }
+#else
         err = rt_mq_recv(mc_ctx.queue, &msg, sizeof(msg), RT_WAITING_FOREVER);
+#endif /* MC_BATCH_ENABLED */
         RT_ASSERT(RT_EOK == err);
 
         mc_handle_msg(&msg);
@@ -761,6 +1055,13 @@ mc_err_t mc_init(void)
     err = rt_mutex_init(&mc_ctx.lock, "mc", RT_IPC_FLAG_FIFO);
     RT_ASSERT(RT_EOK == err);
 
+#ifdef MC_BATCH_ENABLED
+    if (!HAL_DBG_DWT_IsInit())
+    {
+        HAL_DBG_DWT_Init();
+    }
+#endif /* MC_BATCH_ENABLED */
+
     mc_ctx.queue = rt_mq_create("metrics", sizeof(mc_mq_msg_t), 256, RT_IPC_FLAG_FIFO);
     RT_ASSERT(mc_ctx.queue);
     err = rt_thread_init(&g_metrics_thread, "metrics", mc_thread_entry, (void *)NULL,
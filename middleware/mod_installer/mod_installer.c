@@ -53,6 +53,9 @@
 #include "dlfcn.h"
 #include "dfs_posix.h"
 #include "board.h"
+#ifdef PKG_USING_QUICKJS
+    #include "qjs_bytecode.h"
+#endif
 
 #define SYS_INFO_FILE  "sys_info.cfg"
 /** file is saved in contiguous space  */
@@ -106,6 +109,17 @@ rt_err_t app_install(app_installer_info_t *info)
     const char *res_mod_name = NULL;
     rt_err_t res;
 
+#ifdef PKG_USING_QUICKJS
+    /* JS app is installed as script, precompile it so that launch needn't parse source */
+    if (info->pgm_package_path)
+    {
+        size_t len = strlen(info->pgm_package_path);
+
+        if (len > 3 && 0 == strcmp(info->pgm_package_path + len - 3, ".js"))
+            return (0 == qjs_bc_compile(info->pgm_package_path)) ? RT_EOK : -RT_ERROR;
+    }
+#endif
+
     if (info->res_package_path)
     {
         res_mod_name = make_app_res_mod_name(info->app_name);
@@ -198,6 +212,7 @@ rt_err_t mod_install(const char *mod_name, const char *package_path,
     off_t length;
     int res;
     uint8_t *module_ptr;
+    rt_tick_t tick = rt_tick_get();
 
     fid = -1;
     module_ptr = NULL;
@@ -261,6 +276,7 @@ rt_err_t mod_install(const char *mod_name, const char *package_path,
 #endif
 
     res = dlmodule_install(mod_name, module_ptr, install_path);
+    rt_kprintf("install %s: %d, %d ms\n", mod_name, res, (rt_tick_get() - tick) * 1000 / RT_TICK_PER_SECOND);
 
 __EXIT:
 #if !CONT_FILE_SPACE
@@ -0,0 +1,616 @@
+/**
+  ******************************************************************************
+  * @file   nn_runtime.c
+  * @author Sifli software development team
+  * @brief Layered int8 CNN inference runtime
+ * @{
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <board.h>
+#include <string.h>
+#include "nn_runtime.h"
+#include "arm_nnfunctions.h"
+#ifdef BSP_USING_NN_ACC
+    #include "drv_nnacc.h"
+#endif
+#ifdef BSP_EXT_DMA_QUEUE
+    #include "drv_ext_dma.h"
+#endif
+
+#define LOG_TAG      "mw.nnrt"
+#include "log.h"
+
+#ifdef SOC_BF0_HCPU
+    #define NN_RT_CACHE_CLEAN(ptr, len)         mpu_dcache_clean((void *)(ptr), (len))
+    #define NN_RT_CACHE_INVALIDATE(ptr, len)    mpu_dcache_invalidate((void *)(ptr), (len))
+#else
+    #define NN_RT_CACHE_CLEAN(ptr, len)
+    #define NN_RT_CACHE_INVALIDATE(ptr, len)
+#endif
+
+#define NN_RT_ALIGN(x)      RT_ALIGN((x), 4)
+/* NN_ACC rounds output size up to 4 bytes */
+#define NN_RT_ACT_SLACK     (4)
+
+/* one inference at a time as NN_ACC and its semaphores are shared */
+static struct rt_mutex nn_rt_lock;
+#ifdef BSP_USING_NN_ACC
+static struct rt_semaphore nn_rt_acc_sem;
+#endif
+#ifdef BSP_EXT_DMA_QUEUE
+static struct rt_semaphore nn_rt_dma_sem;
+static EXT_DMA_ReqTypeDef nn_rt_dma_req;
+static volatile rt_err_t nn_rt_dma_err;
+static uint8_t nn_rt_dma_pending;
+#endif
+
+static uint32_t nn_rt_time_us(void)
+{
+    return (uint32_t)((uint64_t)HAL_GTIMER_READ() * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static uint32_t layer_in_size(const nn_rt_layer_t *l)
+{
+    return (uint32_t)l->in_x * l->in_y * l->in_ch;
+}
+
+static uint32_t layer_out_size(const nn_rt_layer_t *l)
+{
+    return (uint32_t)l->out_x * l->out_y * l->out_ch;
+}
+
+/* bytes of CMSIS-NN buffer needed by layer done on CPU */
+static uint32_t layer_scratch_size(const nn_rt_layer_t *l)
+{
+    switch (l->op)
+    {
+#ifndef BSP_USING_NN_ACC
+    case NN_RT_OP_CONV2D:
+    case NN_RT_OP_DW_CONV2D:
+        return 4 * l->in_ch * l->ker_x * l->ker_y;
+#endif
+    case NN_RT_OP_FC:
+        return 2 * layer_in_size(l);
+    case NN_RT_OP_AVGPOOL:
+        return 4 * l->out_x * l->in_ch;
+    default:
+        return 0;
+    }
+}
+
+static int32_t layer_check(const nn_rt_layer_t *l, uint32_t model_size)
+{
+    uint32_t in_size = layer_in_size(l);
+    uint32_t out_size = layer_out_size(l);
+
+    if (in_size == 0 || out_size == 0)
+        return NN_RT_ERR_MODEL;
+
+    switch (l->op)
+    {
+    case NN_RT_OP_CONV2D:
+    case NN_RT_OP_DW_CONV2D:
+        if (l->stride_x == 0 || l->stride_y == 0 || l->ker_x == 0 || l->ker_y == 0)
+            return NN_RT_ERR_MODEL;
+        if (l->op == NN_RT_OP_CONV2D && l->wt_size != (uint32_t)l->out_ch * l->ker_x * l->ker_y * l->in_ch)
+            return NN_RT_ERR_MODEL;
+        if (l->op == NN_RT_OP_DW_CONV2D
+                && (l->out_ch != l->in_ch || l->wt_size != (uint32_t)l->ker_x * l->ker_y * l->in_ch))
+            return NN_RT_ERR_MODEL;
+        break;
+    case NN_RT_OP_FC:
+        if (l->out_x != 1 || l->out_y != 1 || l->wt_size != in_size * l->out_ch)
+            return NN_RT_ERR_MODEL;
+        break;
+    case NN_RT_OP_MAXPOOL:
+    case NN_RT_OP_AVGPOOL:
+        /* CMSIS-NN q7 pooling is square only */
+        if (l->in_x != l->in_y || l->out_x != l->out_y || l->ker_x != l->ker_y
+                || l->pad_x != l->pad_y || l->stride_x != l->stride_y || l->stride_x == 0
+                || l->out_ch != l->in_ch)
+            return NN_RT_ERR_MODEL;
+        return NN_RT_ERR_OK;
+    case NN_RT_OP_RELU:
+    case NN_RT_OP_SOFTMAX:
+        if (in_size != out_size || (l->op == NN_RT_OP_SOFTMAX && in_size > UINT16_MAX))
+            return NN_RT_ERR_MODEL;
+        return NN_RT_ERR_OK;
+    default:
+        return NN_RT_ERR_MODEL;
+    }
+
+    if ((uint64_t)l->wt_offset + l->wt_size > model_size
+            || (uint64_t)l->bias_offset + l->out_ch > model_size)
+        return NN_RT_ERR_MODEL;
+
+    return NN_RT_ERR_OK;
+}
+
+/*********************** Copy engine, EXT_DMA if queue is available ******************************/
+
+#ifdef BSP_EXT_DMA_QUEUE
+static void nn_rt_dma_done(EXT_DMA_ReqTypeDef *req, rt_err_t result)
+{
+    nn_rt_dma_err = result;
+    rt_sem_release(&nn_rt_dma_sem);
+}
+#endif
+
+static int32_t copy_start(void *dst, const void *src, uint32_t len)
+{
+    if (len == 0)
+        return NN_RT_ERR_OK;
+
+#ifdef BSP_EXT_DMA_QUEUE
+    RT_ASSERT(!nn_rt_dma_pending);
+    NN_RT_CACHE_CLEAN(src, len);
+    nn_rt_dma_req.dst = dst;
+    nn_rt_dma_req.src = src;
+    nn_rt_dma_req.len = len;
+    nn_rt_dma_req.op = EXT_DMA_OP_COPY;
+    nn_rt_dma_req.cb = nn_rt_dma_done;
+    nn_rt_dma_err = RT_EOK;
+    if (EXT_DMA_Submit(&nn_rt_dma_req) != RT_EOK)
+        return NN_RT_ERR_HW;
+    nn_rt_dma_pending = 1;
+#else
+    memcpy(dst, src, len);
+    NN_RT_CACHE_CLEAN(dst, len);
+#endif
+
+    return NN_RT_ERR_OK;
+}
+
+static int32_t copy_wait(void)
+{
+#ifdef BSP_EXT_DMA_QUEUE
+    if (nn_rt_dma_pending)
+    {
+        rt_sem_take(&nn_rt_dma_sem, RT_WAITING_FOREVER);
+        nn_rt_dma_pending = 0;
+        if (nn_rt_dma_err != RT_EOK)
+            return NN_RT_ERR_HW;
+    }
+#endif
+    return NN_RT_ERR_OK;
+}
+
+/*********************** Convolution ************************************************************/
+
+#ifdef BSP_USING_NN_ACC
+static void nn_rt_acc_done(void)
+{
+    rt_sem_release(&nn_rt_acc_sem);
+}
+
+/* rows of input needed by rows of output, padding rows included */
+#define TILE_IN_ROWS(l, out_rows)   (((out_rows) - 1) * (l)->stride_y + (l)->ker_y)
+
+/*
+  Fill tile with input rows from r0, rows out of input are zero as padding.
+  Copy is started and not waited.
+ */
+static int32_t tile_fetch(const nn_rt_layer_t *l, uint8_t *tile, const int8_t *in, int32_t r0, uint32_t rows)
+{
+    uint32_t row_bytes = (uint32_t)l->in_x * l->in_ch;
+    uint32_t top = (r0 < 0) ? -r0 : 0;
+    uint32_t bottom = (r0 + (int32_t)rows > l->in_y) ? r0 + rows - l->in_y : 0;
+
+    if (top + bottom > rows)
+        top = rows - bottom;
+    if (top)
+    {
+        memset(tile, 0, top * row_bytes);
+        NN_RT_CACHE_CLEAN(tile, top * row_bytes);
+    }
+    if (bottom)
+    {
+        memset(tile + (rows - bottom) * row_bytes, 0, bottom * row_bytes);
+        NN_RT_CACHE_CLEAN(tile + (rows - bottom) * row_bytes, bottom * row_bytes);
+    }
+
+    return copy_start(tile + top * row_bytes, in + (r0 + (int32_t)top) * row_bytes,
+                      (rows - top - bottom) * row_bytes);
+}
+
+/*
+  SRAM layout: bias | weights (if fit) | tile 0 | tile 1
+  NN_ACC computes tile n while input rows of tile n+1 are copied.
+ */
+static int32_t conv_acc(nn_rt_t *rt, const nn_rt_layer_t *l, const int8_t *in, int8_t *out,
+                        nn_rt_layer_stat_t *stat)
+{
+    uint32_t row_bytes = (uint32_t)l->in_x * l->in_ch;
+    uint32_t out_row_bytes = (uint32_t)l->out_x * l->out_ch;
+    uint32_t bias_size = NN_RT_ALIGN(l->out_ch);
+    uint32_t wt_size = NN_RT_ALIGN(l->wt_size);
+    uint32_t min_tile = NN_RT_ALIGN(TILE_IN_ROWS(l, 1) * row_bytes);
+    uint32_t avail, half, tile_rows, tile_num, oy, t;
+    uint8_t *tile[2];
+    const int8_t *wt;
+    NNACC_ConfigTypeDef cfg;
+    int32_t err;
+
+    if (rt->sram_size < bias_size + 2 * min_tile)
+        return NN_RT_ERR_NO_MEM;
+
+    /* bias must be in the same 1MB as input */
+    memcpy(rt->sram, rt->model + l->bias_offset, l->out_ch);
+    NN_RT_CACHE_CLEAN(rt->sram, l->out_ch);
+    avail = rt->sram_size - bias_size;
+
+    wt = (const int8_t *)(rt->model + l->wt_offset);
+    stat->wt_in_sram = (avail >= wt_size + 2 * min_tile);
+    if (stat->wt_in_sram)
+    {
+        err = copy_start(rt->sram + bias_size, wt, l->wt_size);
+        if (err == NN_RT_ERR_OK)
+            err = copy_wait();
+        if (err != NN_RT_ERR_OK)
+            return err;
+        wt = (const int8_t *)(rt->sram + bias_size);
+        avail -= wt_size;
+    }
+
+    half = (avail / 2) & ~3;
+    tile[0] = rt->sram + rt->sram_size - avail;
+    tile[1] = tile[0] + half;
+    tile_rows = ((half / row_bytes) - l->ker_y) / l->stride_y + 1;
+    if (tile_rows > l->out_y)
+        tile_rows = l->out_y;
+    tile_num = (l->out_y + tile_rows - 1) / tile_rows;
+    stat->tiles = tile_num;
+
+    /* NN_ACC writes output directly, drop dirty lines there first */
+    NN_RT_CACHE_CLEAN(out, layer_out_size(l));
+
+    cfg.wt = wt;
+    cfg.bias = (const int8_t *)rt->sram;
+    cfg.in_dim_x = l->in_x;
+    cfg.in_ch_num = l->in_ch;
+    cfg.kernel_dim_x = l->ker_x;
+    cfg.kernel_dim_y = l->ker_y;
+    cfg.padding_x = l->pad_x;
+    cfg.padding_y = 0;          /* padding rows are in tile */
+    cfg.stride_x = l->stride_x;
+    cfg.stride_y = l->stride_y;
+    cfg.out_dim_x = l->out_x;
+    cfg.out_ch_num = l->out_ch;
+    cfg.bias_shift = l->bias_shift;
+    cfg.out_shift = l->out_shift;
+    cfg.mode = (l->op == NN_RT_OP_DW_CONV2D) ? HAL_NNACC_MODE_DEPTHWISE_CONV2D : HAL_NNACC_MODE_CONV2D;
+
+    err = tile_fetch(l, tile[0], in, -(int32_t)l->pad_y, TILE_IN_ROWS(l, tile_rows));
+    if (err == NN_RT_ERR_OK)
+        err = copy_wait();
+
+    for (t = 0, oy = 0; t < tile_num && err == NN_RT_ERR_OK; t++, oy += tile_rows)
+    {
+        uint32_t rows = (l->out_y - oy < tile_rows) ? l->out_y - oy : tile_rows;
+
+        cfg.input = (const int8_t *)tile[t & 1];
+        cfg.in_dim_y = TILE_IN_ROWS(l, rows);
+        cfg.out_dim_y = rows;
+        cfg.output = out + oy * out_row_bytes;
+        if (nn_acc_start_IT(&cfg, nn_rt_acc_done) != RT_EOK)
+        {
+            err = NN_RT_ERR_HW;
+            break;
+        }
+
+        if (t + 1 < tile_num)
+        {
+            uint32_t next_oy = oy + tile_rows;
+            uint32_t next_rows = (l->out_y - next_oy < tile_rows) ? l->out_y - next_oy : tile_rows;
+
+            err = tile_fetch(l, tile[(t + 1) & 1], in, (int32_t)(next_oy * l->stride_y) - l->pad_y,
+                             TILE_IN_ROWS(l, next_rows));
+            if (err == NN_RT_ERR_OK)
+                err = copy_wait();
+        }
+
+        if (rt_sem_take(&nn_rt_acc_sem, rt_tick_from_millisecond(1000)) != RT_EOK)
+        {
+            LOG_E("NN_ACC timeout");
+            err = NN_RT_ERR_HW;
+        }
+    }
+
+    NN_RT_CACHE_INVALIDATE(out, layer_out_size(l));
+
+    return err;
+}
+#else
+
+static int32_t conv_cpu(nn_rt_t *rt, const nn_rt_layer_t *l, const int8_t *in, int8_t *out)
+{
+    const q7_t *wt = (const q7_t *)(rt->model + l->wt_offset);
+    const q7_t *bias = (const q7_t *)(rt->model + l->bias_offset);
+    arm_status ret;
+
+    if (l->op == NN_RT_OP_DW_CONV2D)
+        ret = arm_depthwise_separable_conv_HWC_q7_nonsquare(in, l->in_x, l->in_y, l->in_ch, wt, l->out_ch,
+                l->ker_x, l->ker_y, l->pad_x, l->pad_y, l->stride_x, l->stride_y,
+                bias, l->bias_shift, l->out_shift, out, l->out_x, l->out_y,
+                (q15_t *)rt->scratch, NULL);
+    else
+        ret = arm_convolve_HWC_q7_basic_nonsquare(in, l->in_x, l->in_y, l->in_ch, wt, l->out_ch,
+                l->ker_x, l->ker_y, l->pad_x, l->pad_y, l->stride_x, l->stride_y,
+                bias, l->bias_shift, l->out_shift, out, l->out_x, l->out_y,
+                (q15_t *)rt->scratch, NULL);
+
+    return (ret == ARM_MATH_SUCCESS) ? NN_RT_ERR_OK : NN_RT_ERR_MODEL;
+}
+#endif /* BSP_USING_NN_ACC */
+
+/*********************** Layer dispatch *********************************************************/
+
+static int32_t layer_run(nn_rt_t *rt, const nn_rt_layer_t *l, const int8_t *in, int8_t *out,
+                         nn_rt_layer_stat_t *stat)
+{
+    int32_t err = NN_RT_ERR_OK;
+
+    stat->tiles = 0;
+    stat->wt_in_sram = 0;
+
+    switch (l->op)
+    {
+    case NN_RT_OP_CONV2D:
+    case NN_RT_OP_DW_CONV2D:
+#ifdef BSP_USING_NN_ACC
+        err = conv_acc(rt, l, in, out, stat);
+#else
+        err = conv_cpu(rt, l, in, out);
+#endif
+        break;
+    case NN_RT_OP_FC:
+        arm_fully_connected_q7(in, (const q7_t *)(rt->model + l->wt_offset), layer_in_size(l), l->out_ch,
+                               l->bias_shift, l->out_shift, (const q7_t *)(rt->model + l->bias_offset),
+                               out, (q15_t *)rt->scratch);
+        break;
+    case NN_RT_OP_MAXPOOL:
+        arm_maxpool_q7_HWC((q7_t *)in, l->in_x, l->in_ch, l->ker_x, l->pad_x, l->stride_x, l->out_x,
+                           (q7_t *)rt->scratch, out);
+        break;
+    case NN_RT_OP_AVGPOOL:
+        arm_avepool_q7_HWC((q7_t *)in, l->in_x, l->in_ch, l->ker_x, l->pad_x, l->stride_x, l->out_x,
+                           (q7_t *)rt->scratch, out);
+        break;
+    case NN_RT_OP_RELU:
+        /* in place */
+        arm_relu_q7(out, layer_out_size(l));
+        break;
+    case NN_RT_OP_SOFTMAX:
+        arm_softmax_q7(in, layer_in_size(l), out);
+        break;
+    default:
+        err = NN_RT_ERR_MODEL;
+        break;
+    }
+
+    if (err == NN_RT_ERR_OK && l->act == NN_RT_ACT_RELU && l->op != NN_RT_OP_RELU)
+        arm_relu_q7(out, layer_out_size(l));
+
+    return err;
+}
+
+/*********************** API ********************************************************************/
+
+int32_t nn_rt_load(nn_rt_t *rt, const void *model, uint32_t size, void *sram, uint32_t sram_size)
+{
+    const nn_rt_model_hdr_t *hdr = (const nn_rt_model_hdr_t *)model;
+    const nn_rt_layer_t *layers;
+    uint32_t scratch_size = 0;
+    uint32_t prev_out = 0;
+    int32_t err;
+    uint16_t i;
+
+    if (!rt || !model || size < sizeof(*hdr))
+        return NN_RT_ERR_PARAM;
+
+    memset(rt, 0, sizeof(*rt));
+    if (hdr->magic != NN_RT_MODEL_MAGIC || hdr->version != NN_RT_MODEL_VERSION || hdr->layer_num == 0
+            || size < sizeof(*hdr) + hdr->layer_num * sizeof(nn_rt_layer_t))
+        return NN_RT_ERR_MODEL;
+
+    layers = (const nn_rt_layer_t *)(hdr + 1);
+    for (i = 0; i < hdr->layer_num; i++)
+    {
+        const nn_rt_layer_t *l = &layers[i];
+
+        err = layer_check(l, size);
+        if (err == NN_RT_ERR_OK && layer_out_size(l) > hdr->max_act_size)
+            err = NN_RT_ERR_MODEL;
+        if (err == NN_RT_ERR_OK && i > 0 && layer_in_size(l) != prev_out)
+            err = NN_RT_ERR_MODEL;
+        if (err != NN_RT_ERR_OK)
+        {
+            LOG_E("layer %d op %d invalid", i, l->op);
+            return err;
+        }
+#ifdef BSP_USING_NN_ACC
+        if ((l->op == NN_RT_OP_CONV2D || l->op == NN_RT_OP_DW_CONV2D)
+                && sram_size < NN_RT_ALIGN(l->out_ch)
+                + 2 * NN_RT_ALIGN(TILE_IN_ROWS(l, 1) * (uint32_t)l->in_x * l->in_ch))
+        {
+            LOG_E("layer %d needs bigger sram", i);
+            return NN_RT_ERR_NO_MEM;
+        }
+#endif
+        if (layer_scratch_size(l) > scratch_size)
+            scratch_size = layer_scratch_size(l);
+        prev_out = layer_out_size(l);
+    }
+    if (!sram && sram_size)
+        return NN_RT_ERR_PARAM;
+
+    rt->model = (const uint8_t *)model;
+    rt->hdr = hdr;
+    rt->layers = layers;
+    rt->sram = (uint8_t *)sram;
+    rt->sram_size = sram_size & ~3;
+    rt->act[0] = rt_malloc_align(NN_RT_ALIGN(hdr->max_act_size) + NN_RT_ACT_SLACK, 32);
+    rt->act[1] = rt_malloc_align(NN_RT_ALIGN(hdr->max_act_size) + NN_RT_ACT_SLACK, 32);
+    rt->stat = rt_calloc(hdr->layer_num, sizeof(nn_rt_layer_stat_t));
+    if (scratch_size)
+        rt->scratch = rt_malloc_align(scratch_size, 4);
+    if (!rt->act[0] || !rt->act[1] || !rt->stat || (scratch_size && !rt->scratch))
+    {
+        nn_rt_unload(rt);
+        return NN_RT_ERR_NO_MEM;
+    }
+
+    LOG_I("model loaded, %d layers, act %d, scratch %d", hdr->layer_num, hdr->max_act_size, scratch_size);
+
+    return NN_RT_ERR_OK;
+}
+
+void nn_rt_unload(nn_rt_t *rt)
+{
+    if (!rt)
+        return;
+
+    if (rt->act[0])
+        rt_free_align(rt->act[0]);
+    if (rt->act[1])
+        rt_free_align(rt->act[1]);
+    if (rt->scratch)
+        rt_free_align(rt->scratch);
+    if (rt->stat)
+        rt_free(rt->stat);
+    memset(rt, 0, sizeof(*rt));
+}
+
+int32_t nn_rt_run(nn_rt_t *rt, const int8_t *input, int8_t **output)
+{
+    const int8_t *in = input;
+    int8_t *out = NULL;
+    uint32_t run_start, start;
+    int32_t err = NN_RT_ERR_OK;
+    uint16_t i;
+
+    if (!rt || !rt->hdr || !input)
+        return NN_RT_ERR_PARAM;
+
+    rt_mutex_take(&nn_rt_lock, RT_WAITING_FOREVER);
+    run_start = nn_rt_time_us();
+    for (i = 0; i < rt->hdr->layer_num && err == NN_RT_ERR_OK; i++)
+    {
+        const nn_rt_layer_t *l = &rt->layers[i];
+        nn_rt_layer_stat_t *stat = &rt->stat[i];
+
+        if (l->op == NN_RT_OP_RELU && in != input)
+        {
+            out = (int8_t *)in;
+        }
+        else
+        {
+            out = (in == rt->act[0]) ? rt->act[1] : rt->act[0];
+            if (l->op == NN_RT_OP_RELU)
+                memcpy(out, in, layer_in_size(l));
+        }
+
+        start = nn_rt_time_us();
+        err = layer_run(rt, l, in, out, stat);
+        stat->time = nn_rt_time_us() - start;
+        if (stat->time > stat->max_time)
+            stat->max_time = stat->time;
+        if (err != NN_RT_ERR_OK)
+            LOG_E("layer %d op %d fail %d", i, l->op, err);
+
+        in = out;
+    }
+    rt->run_time = nn_rt_time_us() - run_start;
+    rt_mutex_release(&nn_rt_lock);
+
+    if (output)
+        *output = (err == NN_RT_ERR_OK) ? out : NULL;
+
+    return err;
+}
+
+const nn_rt_layer_stat_t *nn_rt_get_layer_stat(nn_rt_t *rt, uint16_t idx)
+{
+    if (!rt || !rt->hdr || idx >= rt->hdr->layer_num)
+        return NULL;
+
+    return &rt->stat[idx];
+}
+
+void nn_rt_dump_stat(nn_rt_t *rt)
+{
+    static const char *const op_name[] = {"conv", "dwconv", "fc", "maxpool", "avgpool", "relu", "softmax"};
+    uint16_t i;
+
+    if (!rt || !rt->hdr)
+        return;
+
+    rt_kprintf("layer op       out(x,y,ch)     time(us) max(us) tiles wt_sram\n");
+    for (i = 0; i < rt->hdr->layer_num; i++)
+    {
+        const nn_rt_layer_t *l = &rt->layers[i];
+        const nn_rt_layer_stat_t *stat = &rt->stat[i];
+
+        rt_kprintf("%5d %-8s %4d,%4d,%4d  %8d %7d %5d %7d\n", i,
+                   (l->op < sizeof(op_name) / sizeof(op_name[0])) ? op_name[l->op] : "?",
+                   l->out_x, l->out_y, l->out_ch, stat->time, stat->max_time, stat->tiles, stat->wt_in_sram);
+    }
+    rt_kprintf("total %d us\n", rt->run_time);
+}
+
+static int nn_rt_init(void)
+{
+    rt_mutex_init(&nn_rt_lock, "nn_rt", RT_IPC_FLAG_PRIO);
+#ifdef BSP_USING_NN_ACC
+    rt_sem_init(&nn_rt_acc_sem, "nn_acc", 0, RT_IPC_FLAG_FIFO);
+#endif
+#ifdef BSP_EXT_DMA_QUEUE
+    rt_sem_init(&nn_rt_dma_sem, "nn_dma", 0, RT_IPC_FLAG_FIFO);
+#endif
+    return 0;
+}
+INIT_COMPONENT_EXPORT(nn_rt_init);
+
+/// @} nn_runtime
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,492 @@
+/**
+  ******************************************************************************
+  * @file   offload_rpc.c
+  * @author Sifli software development team
+  * @brief Offload RPC between HCPU and LCPU
+ * @{
+  ******************************************************************************
+*/
+/*
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <board.h>
+#include <string.h>
+#include <stdlib.h>
+#include "offload_rpc.h"
+
+#define LOG_TAG      "mw.orpc"
+#include "log.h"
+
+#define ORPC_MSG_REQ        (1)
+#define ORPC_MSG_RSP        (2)
+
+#ifdef SOC_BF0_HCPU
+    #define ORPC_CACHE_CLEAN(ptr, len)          mpu_dcache_clean((ptr), (len))
+    #define ORPC_CACHE_INVALIDATE(ptr, len)     mpu_dcache_invalidate((ptr), (len))
+#else
+    #define ORPC_CACHE_CLEAN(ptr, len)
+    #define ORPC_CACHE_INVALIDATE(ptr, len)
+#endif
+
+/* message on queue, same layout for request and response */
+typedef struct
+{
+    uint8_t type;
+    uint8_t num;
+    uint16_t id;
+    uint16_t seq;
+    uint16_t reserved;
+    int32_t val;            /* param of request, result of response */
+    uint32_t exec_time;     /* execution time in us, response only */
+    struct
+    {
+        uint32_t addr;
+        uint32_t len;
+    } buf[OFFLOAD_RPC_MAX_ARGS];
+} orpc_msg_t;
+
+typedef struct
+{
+    uint16_t seq;
+    uint16_t id;
+    uint8_t used;
+    uint8_t num;
+    uint32_t start;
+    offload_rpc_done_t done;
+    void *user_data;
+    offload_rpc_arg_t arg[OFFLOAD_RPC_MAX_ARGS];
+} orpc_pending_t;
+
+typedef struct
+{
+    offload_rpc_kernel_t kernel;
+    const char *name;
+    offload_rpc_stat_t stat;
+} orpc_kernel_t;
+
+typedef struct
+{
+    struct rt_semaphore sema;
+    int32_t ret;
+} orpc_sync_t;
+
+static ipc_queue_handle_t orpc_queue = IPC_QUEUE_INVALID_HANDLE;
+static struct rt_semaphore orpc_rx_sema;
+static struct rt_mutex orpc_tx_mutex;
+static orpc_pending_t orpc_pending[OFFLOAD_RPC_MAX_PENDING];
+static orpc_kernel_t orpc_kernel[OFFLOAD_RPC_MAX_KERNEL];
+static uint16_t orpc_seq;
+
+static uint32_t orpc_elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+RT_WEAK uint32_t offload_rpc_addr_to_remote(uint32_t addr)
+{
+#ifdef SOC_BF0_HCPU
+    return HCPU_ADDR_2_LCPU_ADDR(addr);
+#else
+    return LCPU_ADDR_2_HCPU_ADDR(addr);
+#endif
+}
+
+static int32_t orpc_rx_ind(ipc_queue_handle_t handle, size_t size)
+{
+    rt_sem_release(&orpc_rx_sema);
+
+    return 0;
+}
+
+static int32_t orpc_send(orpc_msg_t *msg)
+{
+    size_t len;
+
+    rt_mutex_take(&orpc_tx_mutex, RT_WAITING_FOREVER);
+    len = ipc_queue_write(orpc_queue, msg, sizeof(*msg), 100);
+    rt_mutex_release(&orpc_tx_mutex);
+
+    return (len == sizeof(*msg)) ? OFFLOAD_RPC_ERR_OK : OFFLOAD_RPC_ERR_BUSY;
+}
+
+static void orpc_serve(orpc_msg_t *msg)
+{
+    offload_rpc_buf_t buf[OFFLOAD_RPC_MAX_ARGS];
+    orpc_kernel_t *k = RT_NULL;
+    uint32_t start;
+    uint32_t i;
+    uint32_t num = msg->num;
+
+    if (msg->id < OFFLOAD_RPC_MAX_KERNEL)
+        k = &orpc_kernel[msg->id];
+
+    msg->type = ORPC_MSG_RSP;
+    msg->exec_time = 0;
+    if (!k || !k->kernel || num > OFFLOAD_RPC_MAX_ARGS)
+    {
+        msg->val = OFFLOAD_RPC_ERR_NO_KERNEL;
+    }
+    else
+    {
+        for (i = 0; i < num; i++)
+        {
+            buf[i].ptr = (void *)msg->buf[i].addr;
+            buf[i].len = msg->buf[i].len;
+            ORPC_CACHE_INVALIDATE(buf[i].ptr, buf[i].len);
+        }
+        start = HAL_GTIMER_READ();
+        msg->val = k->kernel((uint32_t)msg->val, buf, num);
+        msg->exec_time = orpc_elapsed_us(start);
+        /* kernel might write any buffer, which is invalidated by caller if it's output */
+        for (i = 0; i < num; i++)
+        {
+            ORPC_CACHE_CLEAN(buf[i].ptr, buf[i].len);
+        }
+        k->stat.serve_cnt++;
+        k->stat.serve_total += msg->exec_time;
+    }
+
+    if (orpc_send(msg) != OFFLOAD_RPC_ERR_OK)
+    {
+        LOG_E("rsp %d lost", msg->id);
+    }
+}
+
+static void orpc_complete(orpc_msg_t *msg)
+{
+    orpc_pending_t *p = RT_NULL;
+    offload_rpc_done_t done;
+    void *user_data;
+    offload_rpc_stat_t *stat;
+    uint32_t rtt;
+    rt_base_t level;
+    uint32_t i;
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < OFFLOAD_RPC_MAX_PENDING; i++)
+    {
+        if (orpc_pending[i].used && orpc_pending[i].seq == msg->seq)
+        {
+            p = &orpc_pending[i];
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (!p)
+    {
+        LOG_W("unexpected rsp %d seq %d", msg->id, msg->seq);
+        return;
+    }
+
+    rtt = orpc_elapsed_us(p->start);
+    for (i = 0; i < p->num; i++)
+    {
+        if (p->arg[i].dir & OFFLOAD_RPC_ARG_OUT)
+            ORPC_CACHE_INVALIDATE(p->arg[i].ptr, p->arg[i].len);
+    }
+
+    if (p->id < OFFLOAD_RPC_MAX_KERNEL)
+    {
+        stat = &orpc_kernel[p->id].stat;
+        stat->call_cnt++;
+        if (msg->val < 0)
+            stat->fail_cnt++;
+        stat->rtt_total += rtt;
+        if (rtt > stat->rtt_max)
+            stat->rtt_max = rtt;
+        stat->exec_total += msg->exec_time;
+        if (msg->exec_time > stat->exec_max)
+            stat->exec_max = msg->exec_time;
+    }
+
+    level = rt_hw_interrupt_disable();
+    done = p->done;
+    user_data = p->user_data;
+    p->used = 0;
+    rt_hw_interrupt_enable(level);
+
+    if (done)
+        done(msg->val, user_data);
+}
+
+static void orpc_entry(void *param)
+{
+    orpc_msg_t msg;
+
+    while (1)
+    {
+        rt_sem_take(&orpc_rx_sema, RT_WAITING_FOREVER);
+        while (ipc_queue_get_rx_size(orpc_queue) >= sizeof(msg))
+        {
+            if (ipc_queue_read(orpc_queue, &msg, sizeof(msg)) != sizeof(msg))
+                break;
+            if (ORPC_MSG_REQ == msg.type)
+                orpc_serve(&msg);
+            else if (ORPC_MSG_RSP == msg.type)
+                orpc_complete(&msg);
+        }
+    }
+}
+
+int32_t offload_rpc_init(ipc_queue_cfg_t *q_cfg)
+{
+    rt_thread_t tid;
+
+    RT_ASSERT(q_cfg);
+    if (IPC_QUEUE_INVALID_HANDLE != orpc_queue)
+        return OFFLOAD_RPC_ERR_OK;
+
+    rt_sem_init(&orpc_rx_sema, "orpc_rx", 0, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&orpc_tx_mutex, "orpc_tx", RT_IPC_FLAG_PRIO);
+
+    q_cfg->rx_ind = orpc_rx_ind;
+    orpc_queue = ipc_queue_init(q_cfg);
+    if (IPC_QUEUE_INVALID_HANDLE == orpc_queue)
+        return OFFLOAD_RPC_ERR_PARAM;
+    if (ipc_queue_open(orpc_queue) != 0)
+    {
+        ipc_queue_deinit(orpc_queue);
+        orpc_queue = IPC_QUEUE_INVALID_HANDLE;
+        return OFFLOAD_RPC_ERR_PARAM;
+    }
+
+    tid = rt_thread_create("orpc", orpc_entry, RT_NULL, OFFLOAD_RPC_THREAD_STACK_SIZE,
+                           OFFLOAD_RPC_THREAD_PRIORITY, RT_THREAD_TICK_DEFAULT);
+    RT_ASSERT(tid);
+    rt_thread_startup(tid);
+
+    return OFFLOAD_RPC_ERR_OK;
+}
+
+int32_t offload_rpc_register(uint16_t id, offload_rpc_kernel_t kernel, const char *name)
+{
+    if (id >= OFFLOAD_RPC_MAX_KERNEL)
+        return OFFLOAD_RPC_ERR_PARAM;
+
+    orpc_kernel[id].name = name;
+    orpc_kernel[id].kernel = kernel;
+
+    return OFFLOAD_RPC_ERR_OK;
+}
+
+int32_t offload_rpc_call_async(uint16_t id, uint32_t param, const offload_rpc_arg_t *arg, uint32_t num,
+                               offload_rpc_done_t done, void *user_data)
+{
+    orpc_pending_t *p = RT_NULL;
+    orpc_msg_t msg;
+    rt_base_t level;
+    uint32_t i;
+    int32_t r;
+
+    if (IPC_QUEUE_INVALID_HANDLE == orpc_queue)
+        return OFFLOAD_RPC_ERR_NOT_INIT;
+    if (num > OFFLOAD_RPC_MAX_ARGS || (num && !arg))
+        return OFFLOAD_RPC_ERR_PARAM;
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < OFFLOAD_RPC_MAX_PENDING; i++)
+    {
+        if (!orpc_pending[i].used)
+        {
+            p = &orpc_pending[i];
+            p->used = 1;
+            p->seq = ++orpc_seq;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+    if (!p)
+        return OFFLOAD_RPC_ERR_BUSY;
+
+    p->id = id;
+    p->num = num;
+    p->done = done;
+    p->user_data = user_data;
+
+    msg.type = ORPC_MSG_REQ;
+    msg.num = num;
+    msg.id = id;
+    msg.seq = p->seq;
+    msg.reserved = 0;
+    msg.val = (int32_t)param;
+    msg.exec_time = 0;
+    for (i = 0; i < num; i++)
+    {
+        p->arg[i] = arg[i];
+        /* output buffer is cleaned too, dirty line must not be evicted over remote result */
+        ORPC_CACHE_CLEAN(arg[i].ptr, arg[i].len);
+        msg.buf[i].addr = offload_rpc_addr_to_remote((uint32_t)arg[i].ptr);
+        msg.buf[i].len = arg[i].len;
+    }
+    for (; i < OFFLOAD_RPC_MAX_ARGS; i++)
+    {
+        msg.buf[i].addr = 0;
+        msg.buf[i].len = 0;
+    }
+
+    p->start = HAL_GTIMER_READ();
+    r = orpc_send(&msg);
+    if (r != OFFLOAD_RPC_ERR_OK)
+        p->used = 0;
+
+    return r;
+}
+
+static void orpc_sync_done(int32_t ret, void *user_data)
+{
+    orpc_sync_t *sync = (orpc_sync_t *)user_data;
+
+    sync->ret = ret;
+    rt_sem_release(&sync->sema);
+}
+
+int32_t offload_rpc_call(uint16_t id, uint32_t param, const offload_rpc_arg_t *arg, uint32_t num,
+                         int32_t timeout_ms)
+{
+    orpc_sync_t sync;
+    rt_int32_t tick;
+    rt_base_t level;
+    uint32_t i;
+    int32_t r;
+
+    rt_sem_init(&sync.sema, "orpc_s", 0, RT_IPC_FLAG_FIFO);
+    r = offload_rpc_call_async(id, param, arg, num, orpc_sync_done, &sync);
+    if (r == OFFLOAD_RPC_ERR_OK)
+    {
+        tick = (timeout_ms < 0) ? RT_WAITING_FOREVER : rt_tick_from_millisecond(timeout_ms);
+        if (rt_sem_take(&sync.sema, tick) == RT_EOK)
+        {
+            r = sync.ret;
+        }
+        else
+        {
+            /* release pending call, late response is dropped as its seq doesn't match */
+            r = OFFLOAD_RPC_ERR_TIMEOUT;
+            level = rt_hw_interrupt_disable();
+            for (i = 0; i < OFFLOAD_RPC_MAX_PENDING; i++)
+            {
+                if (orpc_pending[i].used && orpc_pending[i].user_data == &sync)
+                {
+                    orpc_pending[i].done = RT_NULL;
+                    orpc_pending[i].used = 0;
+                }
+            }
+            rt_hw_interrupt_enable(level);
+            /* response might be completed just now */
+            if (rt_sem_trytake(&sync.sema) == RT_EOK)
+                r = sync.ret;
+        }
+    }
+    rt_sem_detach(&sync.sema);
+
+    return r;
+}
+
+int32_t offload_rpc_get_stat(uint16_t id, offload_rpc_stat_t *stat, bool reset)
+{
+    rt_base_t level;
+
+    if (id >= OFFLOAD_RPC_MAX_KERNEL || !stat)
+        return OFFLOAD_RPC_ERR_PARAM;
+
+    level = rt_hw_interrupt_disable();
+    *stat = orpc_kernel[id].stat;
+    if (reset)
+        memset(&orpc_kernel[id].stat, 0, sizeof(orpc_kernel[id].stat));
+    rt_hw_interrupt_enable(level);
+
+    return OFFLOAD_RPC_ERR_OK;
+}
+
+#ifdef RT_USING_FINSH
+static int32_t orpc_echo_kernel(uint32_t param, offload_rpc_buf_t *buf, uint32_t num)
+{
+    return (int32_t)param;
+}
+
+static void cmd_offload_rpc(int argc, char **argv)
+{
+    offload_rpc_stat_t stat;
+    uint32_t i;
+    int32_t r;
+
+    if (argc >= 2 && strcmp(argv[1], "echo") == 0)
+    {
+        /* register echo kernel on serving core, then ping it on the other core */
+        offload_rpc_register(OFFLOAD_RPC_MAX_KERNEL - 1, orpc_echo_kernel, "echo");
+        rt_kprintf("echo kernel %d registered\n", OFFLOAD_RPC_MAX_KERNEL - 1);
+        return;
+    }
+    if (argc >= 2 && strcmp(argv[1], "ping") == 0)
+    {
+        uint32_t cnt = (argc >= 3) ? atoi(argv[2]) : 10;
+
+        for (i = 0; i < cnt; i++)
+        {
+            r = offload_rpc_call(OFFLOAD_RPC_MAX_KERNEL - 1, i, RT_NULL, 0, 1000);
+            if (r != (int32_t)i)
+            {
+                rt_kprintf("ping %d fail %d\n", i, r);
+                break;
+            }
+        }
+    }
+
+    rt_kprintf("id name       calls  fail avg_rtt max_rtt avg_exe max_exe served avg_srv\n");
+    for (i = 0; i < OFFLOAD_RPC_MAX_KERNEL; i++)
+    {
+        offload_rpc_get_stat(i, &stat, argc >= 2 && strcmp(argv[1], "reset") == 0);
+        if (!stat.call_cnt && !stat.serve_cnt && !orpc_kernel[i].kernel)
+            continue;
+        rt_kprintf("%2d %-8s %7d %5d %7d %7d %7d %7d %6d %7d\n", i,
+                   orpc_kernel[i].name ? orpc_kernel[i].name : "-",
+                   stat.call_cnt, stat.fail_cnt,
+                   stat.call_cnt ? stat.rtt_total / stat.call_cnt : 0, stat.rtt_max,
+                   stat.call_cnt ? stat.exec_total / stat.call_cnt : 0, stat.exec_max,
+                   stat.serve_cnt, stat.serve_cnt ? stat.serve_total / stat.serve_cnt : 0);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(cmd_offload_rpc, offload_rpc, offload_rpc[echo | ping[cnt] | reset]: statistics in us);
+#endif /* RT_USING_FINSH */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
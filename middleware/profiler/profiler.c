@@ -75,8 +75,7 @@ enum profiler_command
     PROFILER_COMMAND_INFO   = 3
 };
 
-//TODO: use DWT cycle instead
-#define cycle_get_32()    (*(volatile uint32_t *)0xE0001004)
+#define cycle_get_32()    HAL_DBG_DWT_GetCycles()
 
 char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
 [CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS];
@@ -108,6 +107,104 @@ ALIGN(RT_ALIGN_SIZE)
 static uint8_t profiler_stack[CONFIG_PROFILER_STACK_SIZE];
 L1_NON_RET_BSS_SECT_END
 
+#ifdef CONFIG_PROFILER_USING_RING
+#if (CONFIG_PROFILER_RING_SIZE & (CONFIG_PROFILER_RING_SIZE - 1))
+    #error "CONFIG_PROFILER_RING_SIZE must be power of 2"
+#endif
+#if (CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN > 255)
+    #error "Event length is stored in 1 byte in event ring"
+#endif
+#define RING_MASK  (CONFIG_PROFILER_RING_SIZE - 1)
+
+/*
+    Records are [len][event]. Producers reserve space by LDREX/STREX on head,
+    len is written after event, so draining stops at a record still being written.
+    Consumer clears consumed bytes, free space is always zero.
+*/
+ALIGN(4)
+static uint8_t event_ring[CONFIG_PROFILER_RING_SIZE];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+static volatile uint32_t ring_dropped;
+static uint32_t ring_dropped_sent;
+static uint16_t dropped_event_id;
+
+static void ring_count_drop(void)
+{
+    uint32_t v;
+
+    do
+    {
+        v = HAL_LOCK_Read32(&ring_dropped);
+    }
+    while (!HAL_LOCK_Write32(&ring_dropped, v + 1));
+}
+
+static void ring_put(const uint8_t *data, uint32_t len)
+{
+    uint32_t head;
+    uint32_t i;
+
+    do
+    {
+        head = HAL_LOCK_Read32(&ring_head);
+        if (head + len + 1 - ring_tail > CONFIG_PROFILER_RING_SIZE)
+        {
+            __CLREX();
+            ring_count_drop();
+            return;
+        }
+    }
+    while (!HAL_LOCK_Write32(&ring_head, head + len + 1));
+
+    for (i = 0; i < len; i++)
+        event_ring[(head + 1 + i) & RING_MASK] = data[i];
+    __DMB();
+    event_ring[head & RING_MASK] = (uint8_t)len;
+}
+
+static void ring_drain(void)
+{
+    uint8_t rec[CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN];
+    uint32_t tail = ring_tail;
+    uint32_t len, i;
+
+    while (tail != ring_head)
+    {
+        len = event_ring[tail & RING_MASK];
+        if (0 == len)
+            break;
+        __DMB();
+
+        event_ring[tail & RING_MASK] = 0;
+        for (i = 0; i < len; i++)
+        {
+            rec[i] = event_ring[(tail + 1 + i) & RING_MASK];
+            event_ring[(tail + 1 + i) & RING_MASK] = 0;
+        }
+        __DMB();
+        tail += len + 1;
+        ring_tail = tail;
+
+        if (0 == SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_RTT_CHANNEL_DATA, rec, len))
+            ring_count_drop();
+    }
+
+    if (sending_events && (ring_dropped != ring_dropped_sent))
+    {
+        struct log_event_buf buf;
+        uint32_t dropped = ring_dropped;
+
+        profiler_log_start(&buf);
+        profiler_log_encode_u32(&buf, dropped - ring_dropped_sent);
+        buf.payload_start[0] = (uint8_t)dropped_event_id;
+        if (SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_RTT_CHANNEL_DATA,
+                                   buf.payload_start, buf.payload - buf.payload_start))
+            ring_dropped_sent = dropped;
+    }
+}
+#endif /* CONFIG_PROFILER_USING_RING */
+
 static void send_system_description(void)
 {
     size_t num_bytes_send;
@@ -181,7 +278,12 @@ static void profiler_thread_fn(void *parameter)
                 break;
             }
         }
+#ifdef CONFIG_PROFILER_USING_RING
+        ring_drain();
+        rt_thread_mdelay(CONFIG_PROFILER_DRAIN_PERIOD_MS);
+#else
         rt_thread_delay(500);
+#endif /* CONFIG_PROFILER_USING_RING */
     }
     //k_sem_give(&profiler_sem);
 }
@@ -200,6 +302,17 @@ static void register_execution_tracking_events(void)
     processing_end_event_id = profiler_register_event_type(
                                   "event_processing_end",
                                   labels, types, 1);
+
+#ifdef CONFIG_PROFILER_USING_RING
+    {
+        const char *drop_labels[] = {"count"};
+
+        /* Events lost since last report. */
+        dropped_event_id = profiler_register_event_type(
+                               "events_dropped",
+                               drop_labels, types, 1);
+    }
+#endif /* CONFIG_PROFILER_USING_RING */
 }
 
 int profiler_init(void)
@@ -212,6 +325,9 @@ int profiler_init(void)
     //sending_events = true;
     int ret;
 
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
     register_execution_tracking_events();
 
     SEGGER_RTT_Init();
@@ -362,6 +478,9 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
         uint8_t type_id = event_type_id & UINT8_MAX;
 
         buf->payload_start[0] = type_id;
+#ifdef CONFIG_PROFILER_USING_RING
+        ring_put(buf->payload_start, buf->payload - buf->payload_start);
+#else
         uint32_t mask = rt_hw_interrupt_disable();
 
         uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
@@ -371,6 +490,7 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
         //RT_UNUSED(num_bytes_send);
         rt_hw_interrupt_enable(mask);
         //RT_ASSERT(num_bytes_send > 0);
+#endif /* CONFIG_PROFILER_USING_RING */
     }
 }
 
@@ -395,3 +515,15 @@ void profiler_log_event_execution(uint16_t event_id, bool start)
     }
 }
 
+#ifdef RT_USING_FINSH
+static int profiler_stat(int argc, char **argv)
+{
+    rt_kprintf("sending=%d events=%d clock=%dHz\n", sending_events, profiler_num_events, SystemCoreClock);
+#ifdef CONFIG_PROFILER_USING_RING
+    rt_kprintf("ring used=%d/%d dropped=%d\n", ring_head - ring_tail,
+               CONFIG_PROFILER_RING_SIZE, ring_dropped);
+#endif /* CONFIG_PROFILER_USING_RING */
+    return 0;
+}
+MSH_CMD_EXPORT(profiler_stat, show profiler state);
+#endif /* RT_USING_FINSH */
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# Convert profiler RTT capture to Chrome trace format (chrome://tracing, Perfetto)
+#
+# usage: profiler2chrome.py <info.txt> <data.bin> <out.json> [--freq HZ]
+#   info.txt  text of "Profiler info" channel, i.e. event descriptions
+#   data.bin  raw bytes of "Profiler data" channel
+#   HZ        CPU clock of timestamps, printed by "profiler_stat"
+#
+
+import argparse
+import json
+import struct
+
+ARG_TYPES = ('u8', 's8', 'u16', 's16', 'u32', 's32', 's', 't')
+
+
+def load_desc(path):
+    desc = {}
+    with open(path, 'r', errors='ignore') as f:
+        for line in f:
+            fields = line.strip().split(',')
+            if len(fields) < 2:
+                continue
+            name, eid = fields[0], int(fields[1])
+            rest = fields[2:]
+            types = [t for t in rest if t in ARG_TYPES]
+            labels = rest[len(types):]
+            desc[eid] = (name, types, labels)
+    return desc
+
+
+def parse_events(data, desc):
+    pos = 0
+    while pos < len(data):
+        eid = data[pos]
+        if eid not in desc:
+            raise ValueError('unknown event id %d at offset %d' % (eid, pos))
+        name, types, labels = desc[eid]
+        ts, = struct.unpack_from('<I', data, pos + 1)
+        pos += 5
+        args = []
+        for t in types:
+            if t == 's':
+                n, = struct.unpack_from('<I', data, pos)
+                args.append(data[pos + 4:pos + 4 + n].decode(errors='ignore'))
+                pos += 4 + n
+            else:
+                v, = struct.unpack_from('<i' if t.startswith('s') else '<I', data, pos)
+                args.append(v)
+                pos += 4
+        yield name, ts, dict(zip(labels, args))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('info')
+    parser.add_argument('data')
+    parser.add_argument('out')
+    parser.add_argument('--freq', type=int, default=240000000)
+    opt = parser.parse_args()
+
+    desc = load_desc(opt.info)
+    with open(opt.data, 'rb') as f:
+        data = f.read()
+
+    trace = []
+    base = None
+    high = 0
+    last = 0
+    for name, ts, args in parse_events(data, desc):
+        # Extend 32bit cycle counter
+        if ts < last:
+            high += 1 << 32
+        last = ts
+        cycles = high + ts
+        if base is None:
+            base = cycles
+        us = (cycles - base) * 1000000.0 / opt.freq
+
+        if name in ('event_processing_start', 'event_processing_end'):
+            eid = args.get('mem_address', 0)
+            target = desc[eid][0] if eid in desc else str(eid)
+            ph = 'B' if name == 'event_processing_start' else 'E'
+            trace.append({'name': target, 'ph': ph, 'ts': us, 'pid': 0, 'tid': 0})
+        else:
+            trace.append({'name': name, 'ph': 'i', 's': 'g', 'ts': us, 'pid': 0, 'tid': 0, 'args': args})
+
+    with open(opt.out, 'w') as f:
+        json.dump({'traceEvents': trace, 'displayTimeUnit': 'ms'}, f)
+    print('%d events' % len(trace))
+
+
+if __name__ == '__main__':
+    main()
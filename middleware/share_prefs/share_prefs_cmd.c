@@ -23,6 +23,10 @@ static rt_err_t share_prefs(int argc, char **argv)
         rt_kprintf("\t-ri <key>\n");
         rt_kprintf("\t-ws <key> <string value>\n");
         rt_kprintf("\t-rs <key>\n");
+#ifdef SHARE_PREFS_CACHE_ENABLED
+        rt_kprintf("\t-f\n");
+        rt_kprintf("\t-st\n");
+#endif
         return -RT_ERROR;
     }
 
@@ -74,6 +78,20 @@ static rt_err_t share_prefs(int argc, char **argv)
         int32_t v = atoi(argv[3]);
         res = share_prefs_set_int(pref, argv[2], v);
     }
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    else if (strcmp(argv[1], "-f") == 0)
+    {
+        res = share_prefs_commit(pref);
+    }
+    else if (strcmp(argv[1], "-st") == 0)
+    {
+        share_prefs_cache_stat_t stat;
+
+        share_prefs_get_cache_stat(&stat, false);
+        rt_kprintf("set %d, flash write %d, saved %d, hit %d, miss %d, dirty %d\n",
+                   stat.set, stat.flash_write, stat.saved_write, stat.hit, stat.miss, stat.dirty);
+    }
+#endif
 
     if (res != RT_EOK)
         rt_kprintf("ERROR %d\n", res);
@@ -14,12 +14,342 @@
 #include "flashdb.h"
 
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+#ifdef BSP_USING_PM
+    #include <rtdevice.h>
+#endif
+
+#ifndef SHARE_PREFS_CACHE_MAX_BYTES
+    #define SHARE_PREFS_CACHE_MAX_BYTES  (2048)
+#endif
+#ifndef SHARE_PREFS_CACHE_COMMIT_MS
+    #define SHARE_PREFS_CACHE_COMMIT_MS  (3000)
+#endif
+/* Commit before entering this or deeper sleep mode */
+#ifndef SHARE_PREFS_CACHE_PM_MODE
+    #define SHARE_PREFS_CACHE_PM_MODE    (PM_SLEEP_MODE_DEEP)
+#endif
+
+typedef struct
+{
+    rt_list_t node;
+    uint16_t len;
+    uint8_t dirty;
+    uint8_t removed;    /* key is deleted from db at commit */
+    char *key;          /* stored after value */
+    uint8_t data[0];
+} prefs_cache_entry_t;
+
+#define CACHE_ENTRY_SIZE(e)  (sizeof(prefs_cache_entry_t) + (e)->len + strlen((e)->key) + 1)
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
 typedef struct
 {
     share_prefs_t prefs;
     struct fdb_kvdb db;
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    rt_list_t node;
+    rt_list_t cache;        /* most recently used first */
+    uint32_t cache_bytes;
+    uint32_t dirty_num;
+    struct rt_mutex lock;
+#endif /* SHARE_PREFS_CACHE_ENABLED */
 } flshdb_share_prefs_t;
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+static rt_list_t prefs_list = RT_LIST_OBJECT_INIT(prefs_list);
+static struct rt_mutex prefs_list_lock;
+static struct rt_timer prefs_commit_timer;
+static volatile uint32_t prefs_dirty_total;
+static share_prefs_cache_stat_t prefs_cache_stat;
+
+static char *_init_kvdb_key(const char *prfs_nm, const char *key);
+static void _deinit_kvdb_key(const char *kvdb_key);
+
+static prefs_cache_entry_t *cache_find(flshdb_share_prefs_t *p, const char *key)
+{
+    prefs_cache_entry_t *e;
+
+    rt_list_for_each_entry(e, &p->cache, node)
+    {
+        if (0 == strcmp(e->key, key))
+            return e;
+    }
+
+    return NULL;
+}
+
+static void cache_free_entry(flshdb_share_prefs_t *p, prefs_cache_entry_t *e)
+{
+    if (e->dirty)
+    {
+        p->dirty_num--;
+        prefs_dirty_total--;
+    }
+    p->cache_bytes -= CACHE_ENTRY_SIZE(e);
+    rt_list_remove(&e->node);
+    rt_free(e);
+}
+
+static prefs_cache_entry_t *cache_new_entry(flshdb_share_prefs_t *p, const char *key, const void *value, uint16_t len)
+{
+    prefs_cache_entry_t *e;
+    uint32_t key_len = strlen(key);
+
+    e = rt_malloc(sizeof(prefs_cache_entry_t) + len + key_len + 1);
+    if (NULL == e)
+        return NULL;
+
+    e->len = len;
+    e->dirty = 0;
+    e->removed = 0;
+    e->key = (char *)&e->data[len];
+    if (len)
+        memcpy(e->data, value, len);
+    memcpy(e->key, key, key_len + 1);
+    rt_list_insert_after(&p->cache, &e->node);
+    p->cache_bytes += CACHE_ENTRY_SIZE(e);
+
+    return e;
+}
+
+/* Write dirty entries to db, called with p->lock taken */
+static rt_err_t cache_commit(flshdb_share_prefs_t *p)
+{
+    prefs_cache_entry_t *e, *n;
+    struct fdb_blob blob;
+    char *kvdb_key;
+    fdb_err_t err;
+    rt_err_t ret = RT_EOK;
+
+    rt_list_for_each_entry_safe(e, n, &p->cache, node)
+    {
+        if (!e->dirty)
+            continue;
+
+        kvdb_key = _init_kvdb_key(p->prefs.prfs_name, e->key);
+        if (NULL == kvdb_key)
+            return RT_ENOMEM;
+
+        if (e->removed)
+            err = fdb_kv_del(&p->db, kvdb_key);
+        else
+            err = fdb_kv_set_blob(&p->db, kvdb_key, fdb_blob_make(&blob, e->data, e->len));
+        _deinit_kvdb_key(kvdb_key);
+        prefs_cache_stat.flash_write++;
+
+        if ((FDB_NO_ERR != err) && !(e->removed && (FDB_KV_NAME_ERR == err)))
+        {
+            ret = err;
+            continue;
+        }
+
+        e->dirty = 0;
+        p->dirty_num--;
+        prefs_dirty_total--;
+        if (e->removed)
+            cache_free_entry(p, e);
+    }
+
+    return ret;
+}
+
+/* Keep cache in budget, LRU clean entries are dropped first */
+static void cache_trim(flshdb_share_prefs_t *p)
+{
+    prefs_cache_entry_t *e, *n;
+
+    if (p->cache_bytes <= SHARE_PREFS_CACHE_MAX_BYTES)
+        return;
+
+    if (p->dirty_num)
+        cache_commit(p);
+
+    for (e = rt_list_entry(p->cache.prev, prefs_cache_entry_t, node);
+            (&e->node != &p->cache) && (p->cache_bytes > SHARE_PREFS_CACHE_MAX_BYTES);
+            e = n)
+    {
+        n = rt_list_entry(e->node.prev, prefs_cache_entry_t, node);
+        if (!e->dirty)
+            cache_free_entry(p, e);
+    }
+}
+
+static void cache_drop(flshdb_share_prefs_t *p, const char *key)
+{
+    prefs_cache_entry_t *e;
+
+    rt_mutex_take(&p->lock, RT_WAITING_FOREVER);
+    e = cache_find(p, key);
+    if (e)
+        cache_free_entry(p, e);
+    rt_mutex_release(&p->lock);
+}
+
+static void cache_mark_dirty(flshdb_share_prefs_t *p, prefs_cache_entry_t *e)
+{
+    if (e->dirty)
+    {
+        /* previous value is overwritten before it reaches flash */
+        prefs_cache_stat.saved_write++;
+        return;
+    }
+
+    e->dirty = 1;
+    p->dirty_num++;
+    prefs_dirty_total++;
+    /* commit in SHARE_PREFS_CACHE_COMMIT_MS after first change */
+    if (!(prefs_commit_timer.parent.flag & RT_TIMER_FLAG_ACTIVATED))
+        rt_timer_start(&prefs_commit_timer);
+}
+
+static rt_err_t cache_set(flshdb_share_prefs_t *p, const char *key, const void *value, int32_t len, bool remove)
+{
+    prefs_cache_entry_t *e;
+
+    rt_mutex_take(&p->lock, RT_WAITING_FOREVER);
+    prefs_cache_stat.set++;
+    e = cache_find(p, key);
+    if (e && !e->removed && !remove && (e->len == len) && (0 == memcmp(e->data, value, len)))
+    {
+        /* same value, nothing to write */
+        prefs_cache_stat.saved_write++;
+    }
+    else
+    {
+        if (e && (remove || (e->len != len)))
+        {
+            bool dirty = e->dirty;
+
+            /* keep dirty state for saved write counting */
+            cache_free_entry(p, e);
+            e = cache_new_entry(p, key, value, remove ? 0 : len);
+            if (e && dirty)
+            {
+                e->dirty = 1;
+                p->dirty_num++;
+                prefs_dirty_total++;
+            }
+        }
+        else if (e)
+        {
+            memcpy(e->data, value, len);
+            rt_list_remove(&e->node);
+            rt_list_insert_after(&p->cache, &e->node);
+        }
+        else
+        {
+            e = cache_new_entry(p, key, value, remove ? 0 : len);
+        }
+
+        if (NULL == e)
+        {
+            rt_mutex_release(&p->lock);
+            return RT_ENOMEM;
+        }
+        e->removed = remove;
+        cache_mark_dirty(p, e);
+        cache_trim(p);
+    }
+    rt_mutex_release(&p->lock);
+
+    return RT_EOK;
+}
+
+static rt_err_t share_prefs_commit_all(void)
+{
+    flshdb_share_prefs_t *p;
+    rt_err_t ret = RT_EOK;
+
+    rt_mutex_take(&prefs_list_lock, RT_WAITING_FOREVER);
+    rt_list_for_each_entry(p, &prefs_list, node)
+    {
+        rt_mutex_take(&p->lock, RT_WAITING_FOREVER);
+        if (p->dirty_num && (RT_EOK != cache_commit(p)))
+            ret = RT_ERROR;
+        rt_mutex_release(&p->lock);
+    }
+    rt_mutex_release(&prefs_list_lock);
+
+    return ret;
+}
+
+static void prefs_commit_timeout(void *param)
+{
+    share_prefs_commit_all();
+}
+
+#ifdef BSP_USING_PM
+static int prefs_pm_suspend(const struct rt_device *device, uint8_t mode)
+{
+    if ((mode >= SHARE_PREFS_CACHE_PM_MODE) && prefs_dirty_total)
+    {
+        /* flash can't be written here, commit in timer thread and retry sleep later */
+        rt_tick_t tick = 1;
+
+        rt_timer_stop(&prefs_commit_timer);
+        rt_timer_control(&prefs_commit_timer, RT_TIMER_CTRL_SET_TIME, &tick);
+        rt_timer_start(&prefs_commit_timer);
+        return -RT_EBUSY;
+    }
+
+    return RT_EOK;
+}
+
+static void prefs_pm_resume(const struct rt_device *device, uint8_t mode)
+{
+    rt_tick_t tick = rt_tick_from_millisecond(SHARE_PREFS_CACHE_COMMIT_MS);
+
+    rt_timer_control(&prefs_commit_timer, RT_TIMER_CTRL_SET_TIME, &tick);
+}
+
+static const struct rt_device_pm_ops prefs_pm_op =
+{
+    .suspend = prefs_pm_suspend,
+    .resume = prefs_pm_resume,
+};
+#endif /* BSP_USING_PM */
+
+static int share_prefs_cache_init(void)
+{
+    rt_mutex_init(&prefs_list_lock, "prefs", RT_IPC_FLAG_FIFO);
+    rt_timer_init(&prefs_commit_timer, "prefs", prefs_commit_timeout, NULL,
+                  rt_tick_from_millisecond(SHARE_PREFS_CACHE_COMMIT_MS),
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+#ifdef BSP_USING_PM
+    rt_pm_device_register(NULL, &prefs_pm_op);
+#endif /* BSP_USING_PM */
+
+    return 0;
+}
+INIT_PREV_EXPORT(share_prefs_cache_init);
+
+rt_err_t share_prefs_commit(share_prefs_t *prfs)
+{
+    flshdb_share_prefs_t *p = (flshdb_share_prefs_t *) prfs;
+    rt_err_t ret;
+
+    if (NULL == p)
+        return share_prefs_commit_all();
+
+    rt_mutex_take(&p->lock, RT_WAITING_FOREVER);
+    ret = cache_commit(p);
+    rt_mutex_release(&p->lock);
+
+    return ret;
+}
+
+void share_prefs_get_cache_stat(share_prefs_cache_stat_t *stat, bool reset)
+{
+    RT_ASSERT(stat);
+
+    memcpy(stat, &prefs_cache_stat, sizeof(*stat));
+    stat->dirty = prefs_dirty_total;
+    if (reset)
+        memset(&prefs_cache_stat, 0, sizeof(prefs_cache_stat));
+}
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
 share_prefs_t *share_prefs_open(const char *prefs_name, uint32_t mode)
 {
     uint32_t name_len;
@@ -67,6 +397,16 @@ share_prefs_t *share_prefs_open(const char *prefs_name, uint32_t mode)
         }
     }
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    rt_list_init(&p_flshdb_prefs->cache);
+    p_flshdb_prefs->cache_bytes = 0;
+    p_flshdb_prefs->dirty_num = 0;
+    rt_mutex_init(&p_flshdb_prefs->lock, "prefs", RT_IPC_FLAG_FIFO);
+    rt_mutex_take(&prefs_list_lock, RT_WAITING_FOREVER);
+    rt_list_insert_before(&prefs_list, &p_flshdb_prefs->node);
+    rt_mutex_release(&prefs_list_lock);
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
 
     return p_prefs;
 }
@@ -74,10 +414,30 @@ rt_err_t share_prefs_close(share_prefs_t *prfs)
 {
     flshdb_share_prefs_t *p_flshdb_prefs = (flshdb_share_prefs_t *) prfs;
 
+    rt_err_t ret = RT_EOK;
+
     if (p_flshdb_prefs != NULL)
+    {
+#ifdef SHARE_PREFS_CACHE_ENABLED
+        prefs_cache_entry_t *e, *n;
+
+        rt_mutex_take(&prefs_list_lock, RT_WAITING_FOREVER);
+        rt_list_remove(&p_flshdb_prefs->node);
+        rt_mutex_release(&prefs_list_lock);
+
+        rt_mutex_take(&p_flshdb_prefs->lock, RT_WAITING_FOREVER);
+        ret = cache_commit(p_flshdb_prefs);
+        rt_list_for_each_entry_safe(e, n, &p_flshdb_prefs->cache, node)
+        {
+            cache_free_entry(p_flshdb_prefs, e);
+        }
+        rt_mutex_release(&p_flshdb_prefs->lock);
+        rt_mutex_detach(&p_flshdb_prefs->lock);
+#endif /* SHARE_PREFS_CACHE_ENABLED */
         rt_free(p_flshdb_prefs);
+    }
 
-    return RT_EOK;
+    return ret;
 }
 
 rt_err_t share_prefs_clear(share_prefs_t *prfs)
@@ -101,7 +461,7 @@ static char *_init_kvdb_key(const char *prfs_nm, const char *key)
     return kvdb_key;
 }
 
-rt_inline void _deinit_kvdb_key(const char *kvdb_key)
+static void _deinit_kvdb_key(const char *kvdb_key)
 {
     rt_free((void *)kvdb_key);
 }
@@ -114,10 +474,35 @@ static size_t _get_block(share_prefs_t *prfs, const char *key, void *buf, size_t
     char *kvdb_key;
     size_t ret_v;
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    prefs_cache_entry_t *e;
+
+    rt_mutex_take(&p_flshdb_prefs->lock, RT_WAITING_FOREVER);
+    e = cache_find(p_flshdb_prefs, key);
+    if (e)
+    {
+        prefs_cache_stat.hit++;
+        if (e->removed)
+        {
+            ret_v = 0;
+            *saved_value_len = 0;
+        }
+        else
+        {
+            ret_v = MIN((size_t)buf_len, e->len);
+            memcpy(buf, e->data, ret_v);
+            *saved_value_len = e->len;
+        }
+        rt_mutex_release(&p_flshdb_prefs->lock);
+        return ret_v;
+    }
+    prefs_cache_stat.miss++;
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
     kvdb_key = _init_kvdb_key(prfs_nm, key);
     if (NULL == kvdb_key)
     {
-        return -1;
+        ret_v = -1;
     }
     else
     {
@@ -125,8 +510,20 @@ static size_t _get_block(share_prefs_t *prfs, const char *key, void *buf, size_t
         ret_v = fdb_kv_get_blob(&p_flshdb_prefs->db, kvdb_key, fdb_blob_make(&blob, buf, buf_len));
         *saved_value_len = blob.saved.len;
         _deinit_kvdb_key(kvdb_key);
-        return ret_v;
+#ifdef SHARE_PREFS_CACHE_ENABLED
+        /* cache complete value only */
+        if ((ret_v > 0) && (ret_v == blob.saved.len) && (ret_v <= SHARE_PREFS_CACHE_MAX_BYTES / 4))
+        {
+            cache_new_entry(p_flshdb_prefs, key, buf, ret_v);
+            cache_trim(p_flshdb_prefs);
+        }
+#endif /* SHARE_PREFS_CACHE_ENABLED */
     }
+
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    rt_mutex_release(&p_flshdb_prefs->lock);
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+    return ret_v;
 }
 
 static rt_err_t _set_block(share_prefs_t *prfs, const char *key, const void *value, int32_t value_len)
@@ -137,6 +534,15 @@ static rt_err_t _set_block(share_prefs_t *prfs, const char *key, const void *val
     char *kvdb_key;
     rt_err_t ret_v;
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    if (value_len <= SHARE_PREFS_CACHE_MAX_BYTES / 4)
+    {
+        return cache_set(p_flshdb_prefs, key, value, value_len, false);
+    }
+    /* large value is written through, drop stale cached value */
+    cache_drop(p_flshdb_prefs, key);
+#endif /* SHARE_PREFS_CACHE_ENABLED */
+
     kvdb_key = _init_kvdb_key(prfs_nm, key);
     if (NULL == kvdb_key)
     {
@@ -163,6 +569,11 @@ rt_err_t share_prefs_remove(share_prefs_t *prfs, const char *key)
     char *kvdb_key;
     rt_err_t ret_v;
 
+#ifdef SHARE_PREFS_CACHE_ENABLED
+    (void)kvdb_key;
+    (void)ret_v;
+    return cache_set(p_flshdb_prefs, key, NULL, 0, true);
+#else
     kvdb_key = _init_kvdb_key(prfs->prfs_name, key);
     if (NULL == kvdb_key)
     {
@@ -177,6 +588,7 @@ rt_err_t share_prefs_remove(share_prefs_t *prfs, const char *key)
         _deinit_kvdb_key(kvdb_key);
         return ret_v;
     }
+#endif /* SHARE_PREFS_CACHE_ENABLED */
 }
 
 
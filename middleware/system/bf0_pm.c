@@ -65,6 +65,9 @@
 #ifdef USING_CONTEXT_BACKUP
     #include "context_backup.h"
 #endif /* USING_CONTEXT_BACKUP */
+#ifdef PM_DVFS_GOVERNOR_ENABLED
+    #include "cpu_usage_profiler.h"
+#endif /* PM_DVFS_GOVERNOR_ENABLED */
 
 #ifdef PM_METRICS_USE_COLLECTOR
     #include "metrics_collector.h"
@@ -1166,7 +1169,13 @@ static void save_ram(void)
     rt_err_t err;
 
     pm_init_mem_map();
+#ifdef PM_PROFILING_ENABLED
+    test_pm_data.save_time.save_static_begin = HAL_GTIMER_READ();
+#endif /* PM_PROFILING_ENABLED */
     err = cb_save_context();
+#ifdef PM_PROFILING_ENABLED
+    test_pm_data.save_time.save_static_done = HAL_GTIMER_READ();
+#endif /* PM_PROFILING_ENABLED */
     if (RT_EOK != err)
     {
         /* wakeup LCPU so that SWD is connectable after assertion */
@@ -1218,8 +1227,14 @@ static void restore_ram(void)
 
     rt_err_t err;
 
+#ifdef PM_PROFILING_ENABLED
+    test_pm_data.restore_time.restore_static_data_begin = HAL_GTIMER_READ();
+#endif /* PM_PROFILING_ENABLED */
     err = cb_restore_context();
     RT_ASSERT(RT_EOK == err);
+#ifdef PM_PROFILING_ENABLED
+    test_pm_data.restore_time.restore_static_data_done = HAL_GTIMER_READ();
+#endif /* PM_PROFILING_ENABLED */
 
     cb_deinit();
 #endif
@@ -1761,6 +1776,776 @@ static void pm_update_wakeup_src_stat(void)
 
 #endif /* PM_METRICS_ENABLED */
 
+#ifdef PM_GOVERNOR_ENABLED
+
+#define PM_GOV_SRC_NUM          (8)
+/* number of inter-arrival samples before a wakeup source is used for prediction */
+#define PM_GOV_MIN_SAMPLES      (4)
+/* weight of new sample is 1/8 */
+#define PM_GOV_EWMA_SHIFT       (3)
+/* wakeup earlier than timer timeout by more than margin is regarded as woken up by other source, in ms */
+#define PM_GOV_EARLY_MARGIN     (2)
+/* cap of predicted sleep time, mode of lowest power wins beyond it, in ms */
+#define PM_GOV_MAX_PREDICT      (3600 * 1000)
+
+typedef struct
+{
+    /** wakeup source, bit position in WSR */
+    uint8_t  src;
+    uint8_t  samples;
+    /** GTime of last wakeup */
+    uint32_t last_time;
+    /** average inter-arrival time in ms */
+    int32_t  mean;
+    /** average deviation of inter-arrival time in ms */
+    int32_t  dev;
+} pm_gov_src_t;
+
+typedef struct
+{
+    bool enabled;
+    uint8_t mode_num;
+    uint8_t src_num;
+    const pm_governor_mode_t *mode_tbl;
+    /** sleep time allowed by timer in last decision, in ms */
+    uint32_t timer_ms;
+    pm_gov_src_t src[PM_GOV_SRC_NUM];
+    pm_governor_stat_t stat;
+} pm_gov_ctx_t;
+
+/* rough estimation, use pm_governor_config to set the model measured on board */
+static const pm_governor_mode_t pm_gov_default_mode[] =
+{
+    {PM_SLEEP_MODE_IDLE,    3000,   0,  0},
+    {PM_SLEEP_MODE_LIGHT,   500,    20, 1},
+#if defined(PM_DEEP_ENABLE) || defined(PM_STANDBY_ENABLE)
+    {PM_SLEEP_MODE_DEEP,    150,    100, 3},
+#endif /* PM_DEEP_ENABLE || PM_STANDBY_ENABLE */
+#ifdef PM_STANDBY_ENABLE
+    {PM_SLEEP_MODE_STANDBY, 30,     150, 10},
+#endif /* PM_STANDBY_ENABLE */
+};
+
+static pm_gov_ctx_t pm_gov_ctx =
+{
+    .enabled = true,
+    .mode_num = sizeof(pm_gov_default_mode) / sizeof(pm_gov_default_mode[0]),
+    .mode_tbl = pm_gov_default_mode,
+    .timer_ms = UINT32_MAX,
+};
+
+static uint32_t pm_gov_gtime_to_ms(uint32_t gtime)
+{
+    return (uint32_t)((float)gtime * 1000 / HAL_LPTIM_GetFreq());
+}
+
+/* same as builtin policy, used as reference and if governor is disabled */
+static uint8_t pm_gov_static_mode(rt_tick_t tick)
+{
+    uint8_t mode = PM_SLEEP_MODE_IDLE;
+    int32_t i;
+
+    for (i = sizeof(pm_policy) / sizeof(pm_policy[0]) - 1; i >= 0; i--)
+    {
+        if (tick >= rt_tick_from_millisecond(pm_policy[i].thresh))
+        {
+            mode = pm_policy[i].mode;
+            break;
+        }
+    }
+
+    return mode;
+}
+
+/* earliest wakeup time predicted by wakeup source statistics, in ms */
+static uint32_t pm_gov_predict(uint32_t predict_ms)
+{
+    pm_gov_ctx_t *ctx = &pm_gov_ctx;
+    pm_gov_src_t *src;
+    uint32_t curr_time;
+    int32_t elapsed;
+    int32_t remain;
+    uint32_t i;
+
+    curr_time = HAL_GTIMER_READ();
+    for (i = 0, src = &ctx->src[0]; i < ctx->src_num; i++, src++)
+    {
+        if (src->samples < PM_GOV_MIN_SAMPLES)
+        {
+            continue;
+        }
+        elapsed = (int32_t)pm_gov_gtime_to_ms(curr_time - src->last_time);
+        if (elapsed > (src->mean + 2 * src->dev))
+        {
+            /* source is quiet for longer than expected, don't trust it until it wakes up system again */
+            continue;
+        }
+        remain = src->mean - src->dev - elapsed;
+        if (remain < 0)
+        {
+            remain = 0;
+        }
+        if ((uint32_t)remain < predict_ms)
+        {
+            predict_ms = remain;
+        }
+    }
+
+    return predict_ms;
+}
+
+static uint8_t pm_governor_select(rt_tick_t tick)
+{
+    pm_gov_ctx_t *ctx = &pm_gov_ctx;
+    const pm_governor_mode_t *m;
+    uint8_t static_mode;
+    uint8_t max_mode;
+    uint8_t mode;
+    uint32_t timer_ms;
+    uint32_t predict_ms;
+    uint64_t energy;
+    uint64_t min_energy;
+    uint32_t i;
+
+    static_mode = pm_gov_static_mode(tick);
+    if (!ctx->enabled)
+    {
+        ctx->timer_ms = UINT32_MAX;
+        return static_mode;
+    }
+
+    if (RT_TICK_MAX == tick)
+    {
+        timer_ms = UINT32_MAX;
+    }
+    else
+    {
+        timer_ms = (uint32_t)((uint64_t)tick * 1000 / RT_TICK_PER_SECOND);
+    }
+    ctx->timer_ms = timer_ms;
+
+    predict_ms = pm_gov_predict(timer_ms);
+    if (predict_ms > PM_GOV_MAX_PREDICT)
+    {
+        predict_ms = PM_GOV_MAX_PREDICT;
+    }
+
+    /* requested sleep mode is the deepest mode allowed */
+    for (max_mode = PM_SLEEP_MODE_LIGHT; max_mode < PM_SLEEP_MODE_SHUTDOWN; max_mode++)
+    {
+        if (rt_pm_sleep_mode_state_get(max_mode))
+        {
+            break;
+        }
+    }
+
+    mode = PM_SLEEP_MODE_IDLE;
+    min_energy = UINT64_MAX;
+    for (i = 0, m = ctx->mode_tbl; i < ctx->mode_num; i++, m++)
+    {
+        if ((m->mode > max_mode) || (predict_ms < m->latency))
+        {
+            continue;
+        }
+        /* uW * ms = nJ */
+        energy = (uint64_t)m->energy * 1000 + (uint64_t)m->power * predict_ms;
+        if (energy < min_energy)
+        {
+            min_energy = energy;
+            mode = m->mode;
+        }
+    }
+
+    if (mode < static_mode)
+    {
+        ctx->stat.demote_cnt++;
+    }
+
+    return mode;
+}
+
+static pm_gov_src_t *pm_gov_find_src(uint8_t src_bit)
+{
+    pm_gov_ctx_t *ctx = &pm_gov_ctx;
+    pm_gov_src_t *src;
+    uint32_t i;
+
+    for (i = 0, src = &ctx->src[0]; i < ctx->src_num; i++, src++)
+    {
+        if (src->src == src_bit)
+        {
+            return src;
+        }
+    }
+
+    if (ctx->src_num >= PM_GOV_SRC_NUM)
+    {
+        return NULL;
+    }
+
+    src = &ctx->src[ctx->src_num++];
+    memset(src, 0, sizeof(*src));
+    src->src = src_bit;
+
+    return src;
+}
+
+/* called after wakeup, learn inter-arrival time of the source which wakes up system earlier than timer */
+static void pm_governor_update(uint8_t mode, uint32_t start_time, uint32_t end_time)
+{
+    pm_gov_ctx_t *ctx = &pm_gov_ctx;
+    pm_governor_mode_stat_t *stat;
+    pm_gov_src_t *src;
+    uint32_t wakeup_src;
+    uint32_t sleep_ms;
+    int32_t interval;
+    int32_t err;
+    uint32_t i;
+
+    if (mode >= PM_SLEEP_MODE_MAX)
+    {
+        return;
+    }
+
+    sleep_ms = pm_gov_gtime_to_ms(end_time - start_time);
+    stat = &ctx->stat.mode[mode];
+    stat->enter_cnt++;
+    stat->residency += sleep_ms;
+
+    if ((UINT32_MAX != ctx->timer_ms) && ((sleep_ms + PM_GOV_EARLY_MARGIN) >= ctx->timer_ms))
+    {
+        /* woken up by timer as expected */
+        return;
+    }
+    stat->early_cnt++;
+
+    wakeup_src = g_wakeup_src;
+    for (i = 0; wakeup_src && (i < 32); i++)
+    {
+        if (!((1UL << i) & wakeup_src))
+        {
+            continue;
+        }
+        wakeup_src &= ~(1UL << i);
+
+        src = pm_gov_find_src(i);
+        if (!src)
+        {
+            continue;
+        }
+        if (src->samples)
+        {
+            interval = (int32_t)pm_gov_gtime_to_ms(end_time - src->last_time);
+            if (1 == src->samples)
+            {
+                src->mean = interval;
+                src->dev = interval / 2;
+            }
+            else
+            {
+                err = interval - src->mean;
+                src->mean += err >> PM_GOV_EWMA_SHIFT;
+                if (err < 0)
+                {
+                    err = -err;
+                }
+                src->dev += (err - src->dev) >> PM_GOV_EWMA_SHIFT;
+            }
+        }
+        if (src->samples < UINT8_MAX)
+        {
+            src->samples++;
+        }
+        src->last_time = end_time;
+    }
+}
+
+void pm_governor_config(const pm_governor_mode_t *mode, uint8_t num)
+{
+    rt_base_t level;
+
+    RT_ASSERT(mode && num);
+
+    level = rt_hw_interrupt_disable();
+    pm_gov_ctx.mode_tbl = mode;
+    pm_gov_ctx.mode_num = num;
+    rt_hw_interrupt_enable(level);
+}
+
+void pm_governor_enable(bool enable)
+{
+    pm_gov_ctx.enabled = enable;
+}
+
+void pm_governor_get_stat(pm_governor_stat_t *stat)
+{
+    rt_base_t level;
+
+    RT_ASSERT(stat);
+
+    level = rt_hw_interrupt_disable();
+    memcpy(stat, &pm_gov_ctx.stat, sizeof(*stat));
+    rt_hw_interrupt_enable(level);
+}
+
+void pm_governor_reset_stat(void)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    memset(&pm_gov_ctx.stat, 0, sizeof(pm_gov_ctx.stat));
+    rt_hw_interrupt_enable(level);
+}
+
+static int pm_gov(int argc, char **argv)
+{
+    pm_gov_ctx_t *ctx = &pm_gov_ctx;
+    pm_governor_stat_t stat;
+    pm_gov_src_t *src;
+    uint32_t i;
+
+    if (argc > 1)
+    {
+        if (0 == strcmp(argv[1], "on"))
+        {
+            pm_governor_enable(true);
+        }
+        else if (0 == strcmp(argv[1], "off"))
+        {
+            pm_governor_enable(false);
+        }
+        else if (0 == strcmp(argv[1], "reset"))
+        {
+            pm_governor_reset_stat();
+        }
+        else
+        {
+            rt_kprintf("usage: pm_gov [on|off|reset]\n");
+        }
+        return 0;
+    }
+
+    pm_governor_get_stat(&stat);
+    rt_kprintf("governor: %s, demote: %d\n", ctx->enabled ? "on" : "off", stat.demote_cnt);
+    rt_kprintf("mode  enter      early      residency(ms)\n");
+    for (i = PM_SLEEP_MODE_IDLE; i < PM_SLEEP_MODE_MAX; i++)
+    {
+        rt_kprintf("%-4d  %-10d %-10d %d\n", i, stat.mode[i].enter_cnt,
+                   stat.mode[i].early_cnt, stat.mode[i].residency);
+    }
+    rt_kprintf("src   samples    mean(ms)   dev(ms)\n");
+    for (i = 0, src = &ctx->src[0]; i < ctx->src_num; i++, src++)
+    {
+        rt_kprintf("%-4d  %-10d %-10d %d\n", src->src, src->samples, src->mean, src->dev);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(pm_gov, pm_gov [on|off|reset]: predictive sleep governor);
+
+#endif /* PM_GOVERNOR_ENABLED */
+
+#if defined(PM_PROFILING_ENABLED) && defined(RT_USING_FINSH)
+static void pm_prof_print(const char *name, uint32_t begin, uint32_t t)
+{
+    if (t)
+    {
+        rt_kprintf("  %-20s %d us\n", name, (uint32_t)((uint64_t)(t - begin) * 1000000 / HAL_LPTIM_GetFreq()));
+    }
+}
+
+/* phases of last standby, relative to start of save and to wakeup */
+static int pm_prof(int argc, char **argv)
+{
+    test_pm_data_save_time_t *save = &test_pm_data.save_time;
+    test_pm_data_restore_time_t *restore = &test_pm_data.restore_time;
+#ifdef USING_CONTEXT_BACKUP
+    cb_perf_stats_t cb_stats;
+#endif /* USING_CONTEXT_BACKUP */
+
+    rt_kprintf("save:\n");
+    pm_prof_print("save_static_begin", save->save_start, save->save_static_begin);
+    pm_prof_print("save_static_done", save->save_start, save->save_static_done);
+    pm_prof_print("save_done", save->save_start, save->save_done);
+    rt_kprintf("wakeup:\n");
+    pm_prof_print("lcpu_wakeup", restore->init_enter, restore->lcpu_wakeup);
+    pm_prof_print("hal_init_done", restore->init_enter, restore->hal_init_done);
+    pm_prof_print("mpu_config_done", restore->init_enter, restore->mpu_config_done);
+    pm_prof_print("ram_code_load_done", restore->init_enter, restore->ram_code_load_done);
+    pm_prof_print("restore_static_begin", restore->init_enter, restore->restore_static_data_begin);
+    pm_prof_print("restore_static_done", restore->init_enter, restore->restore_static_data_done);
+    pm_prof_print("restore_ram_done", restore->init_enter, restore->restore_ram_done);
+    pm_prof_print("restore_done", restore->init_enter, restore->restore_done);
+    pm_prof_print("device_resume_begin", restore->init_enter, restore->device_resume_begin);
+    pm_prof_print("device_resume_done", restore->init_enter, restore->device_resume_done);
+#ifdef USING_CONTEXT_BACKUP
+    cb_get_perf_stats(&cb_stats);
+    rt_kprintf("context backup: save %d us, restore %d us, written %d, skipped %d, dma %d\n",
+               cb_stats.save_time, cb_stats.restore_time, cb_stats.written, cb_stats.skipped, cb_stats.dma_len);
+#endif /* USING_CONTEXT_BACKUP */
+
+    return 0;
+}
+MSH_CMD_EXPORT(pm_prof, show time of standby save and wakeup phases);
+#endif /* PM_PROFILING_ENABLED && RT_USING_FINSH */
+
+#if defined(PM_DVFS_GOVERNOR_ENABLED) && defined(SF32LB52X) && defined(SOC_BF0_HCPU)
+
+#ifndef USING_CPU_USAGE_PROFILER
+    #error "PM_DVFS_GOVERNOR_ENABLED depends on USING_CPU_USAGE_PROFILER"
+#endif /* USING_CPU_USAGE_PROFILER */
+
+#ifndef RT_USING_IDLE_HOOK
+    #error "PM_DVFS_GOVERNOR_ENABLED depends on RT_USING_IDLE_HOOK"
+#endif /* RT_USING_IDLE_HOOK */
+
+typedef struct
+{
+    /** required frequency in MHz, 0 if no hint */
+    uint32_t mhz;
+    /** tick that hint expires */
+    rt_tick_t expire;
+    /** hint never expires */
+    bool hold;
+} pm_dvfs_hint_t;
+
+typedef struct
+{
+    bool enabled;
+    /** sampling timer is stopped in idle */
+    bool parked;
+    /** run mode chosen by governor */
+    uint8_t mode;
+    /** number of windows lower mode is sufficient */
+    uint8_t down_cnt;
+    /** busy time and time in us at start of window */
+    uint32_t last_busy;
+    uint32_t last_time;
+    struct rt_timer timer;
+    pm_dvfs_hint_t hint[PM_DVFS_CLIENT_NUM];
+    pm_dvfs_stat_t stat;
+} pm_dvfs_ctx_t;
+
+/* HCLK of each run mode configured by sifli_pm_run, in MHz */
+static const uint16_t pm_dvfs_mode_mhz[PM_RUN_MODE_MAX] = {240, 144, 48, 24};
+
+static pm_dvfs_ctx_t pm_dvfs_ctx;
+
+static void pm_dvfs_restart_window(pm_dvfs_ctx_t *ctx)
+{
+    ctx->last_busy = cpu_get_busy_us();
+    ctx->last_time = cpu_get_hw_us();
+}
+
+/* lowest frequency mode whose utilization for demand is not above threshold */
+static uint8_t pm_dvfs_find_mode(uint32_t demand, uint32_t threshold)
+{
+    uint8_t mode;
+
+    for (mode = PM_RUN_MODE_MAX - 1; mode > PM_RUN_MODE_HIGH_SPEED; mode--)
+    {
+        if (demand * 100 <= pm_dvfs_mode_mhz[mode] * threshold)
+        {
+            break;
+        }
+    }
+
+    return mode;
+}
+
+static uint32_t pm_dvfs_hint_demand(pm_dvfs_ctx_t *ctx)
+{
+    pm_dvfs_hint_t *hint;
+    rt_tick_t curr_tick;
+    uint32_t demand;
+    uint32_t i;
+
+    curr_tick = rt_tick_get();
+    demand = 0;
+    for (i = 0, hint = &ctx->hint[0]; i < PM_DVFS_CLIENT_NUM; i++, hint++)
+    {
+        if (0 == hint->mhz)
+        {
+            continue;
+        }
+        if (!hint->hold && ((int32_t)(curr_tick - hint->expire) >= 0))
+        {
+            hint->mhz = 0;
+            continue;
+        }
+        if (hint->mhz > demand)
+        {
+            demand = hint->mhz;
+        }
+    }
+
+    return demand;
+}
+
+/* the switch waits for PSRAM and flash idle and reinitializes their timing in sifli_pm_run,
+   core voltage follows HCLK in HAL_RCC_HCPU_ConfigHCLK, lower frequency is applied in idle */
+static void pm_dvfs_set_mode(pm_dvfs_ctx_t *ctx, uint8_t mode)
+{
+    if (mode == ctx->mode)
+    {
+        return;
+    }
+    if (mode < ctx->mode)
+    {
+        ctx->stat.up_cnt++;
+    }
+    else
+    {
+        ctx->stat.down_cnt++;
+    }
+    ctx->mode = mode;
+    ctx->down_cnt = 0;
+    rt_pm_run_enter(mode);
+    /* utilization is meaningful only if the whole window runs at the same frequency */
+    pm_dvfs_restart_window(ctx);
+}
+
+static void pm_dvfs_evaluate(pm_dvfs_ctx_t *ctx)
+{
+    uint32_t busy;
+    uint32_t curr_time;
+    uint32_t window;
+    uint32_t util;
+    uint32_t load;
+    uint32_t hint;
+    uint8_t load_mode;
+    uint8_t target;
+
+    busy = cpu_get_busy_us();
+    curr_time = cpu_get_hw_us();
+    window = curr_time - ctx->last_time;
+    if (0 == window)
+    {
+        return;
+    }
+    util = (uint32_t)((uint64_t)(busy - ctx->last_busy) * 100 / window);
+    if (util > 100)
+    {
+        util = 100;
+    }
+    ctx->last_busy = busy;
+    ctx->last_time = curr_time;
+
+    /* required frequency running at current utilization */
+    load = util * pm_dvfs_mode_mhz[ctx->mode] / 100;
+    hint = pm_dvfs_hint_demand(ctx);
+
+    if (util > PM_DVFS_UP_THRESHOLD)
+    {
+        /* saturated load tells nothing about real demand, go to highest frequency at once */
+        load_mode = PM_RUN_MODE_HIGH_SPEED;
+    }
+    else
+    {
+        load_mode = pm_dvfs_find_mode(load, PM_DVFS_DOWN_THRESHOLD);
+    }
+    target = pm_dvfs_find_mode(hint, 100);
+    if (load_mode < target)
+    {
+        target = load_mode;
+    }
+
+    ctx->stat.util = util;
+    ctx->stat.demand = (load > hint) ? load : hint;
+
+    if (target < ctx->mode)
+    {
+        pm_dvfs_set_mode(ctx, target);
+    }
+    else if (target > ctx->mode)
+    {
+        ctx->down_cnt++;
+        if (ctx->down_cnt >= PM_DVFS_DOWN_DELAY)
+        {
+            pm_dvfs_set_mode(ctx, target);
+        }
+    }
+    else
+    {
+        ctx->down_cnt = 0;
+    }
+}
+
+static void pm_dvfs_timeout(void *parameter)
+{
+    pm_dvfs_ctx_t *ctx = (pm_dvfs_ctx_t *)parameter;
+
+    if (ctx->enabled)
+    {
+        pm_dvfs_evaluate(ctx);
+    }
+}
+
+/* periodic sampling is stopped at lowest mode so that it doesn't prevent sleep */
+static void pm_dvfs_idle_hook(void)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (ctx->enabled && !ctx->parked && ((PM_RUN_MODE_MAX - 1) == ctx->mode)
+            && (0 == pm_dvfs_hint_demand(ctx)))
+    {
+        rt_timer_stop(&ctx->timer);
+        ctx->parked = true;
+        ctx->stat.park_cnt++;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/* called in interrupt entry, any activity after idle resumes sampling */
+static void pm_dvfs_unpark(void)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+
+    if (ctx->parked)
+    {
+        ctx->parked = false;
+        pm_dvfs_restart_window(ctx);
+        rt_timer_start(&ctx->timer);
+    }
+}
+
+static void pm_dvfs_init(void)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+
+    ctx->mode = RT_PM_DEFAULT_RUN_MODE;
+    rt_timer_init(&ctx->timer, "dvfs", pm_dvfs_timeout, ctx,
+                  rt_tick_from_millisecond(PM_DVFS_PERIOD_MS), RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+    rt_thread_idle_sethook(pm_dvfs_idle_hook);
+    pm_dvfs_enable(true);
+}
+
+void pm_dvfs_enable(bool enable)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (enable && !ctx->enabled)
+    {
+        ctx->enabled = true;
+        ctx->parked = false;
+        ctx->down_cnt = 0;
+        pm_dvfs_restart_window(ctx);
+        rt_timer_start(&ctx->timer);
+    }
+    else if (!enable && ctx->enabled)
+    {
+        ctx->enabled = false;
+        ctx->parked = false;
+        rt_timer_stop(&ctx->timer);
+        pm_dvfs_set_mode(ctx, PM_RUN_MODE_HIGH_SPEED);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+void pm_dvfs_hint_mips(pm_dvfs_client_t client, uint32_t mips, uint32_t hold_ms)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+    pm_dvfs_hint_t *hint;
+    rt_base_t level;
+    uint8_t mode;
+
+    RT_ASSERT(client < PM_DVFS_CLIENT_NUM);
+
+    level = rt_hw_interrupt_disable();
+    hint = &ctx->hint[client];
+    hint->mhz = mips;
+    hint->hold = (0 == hold_ms);
+    hint->expire = rt_tick_get() + rt_tick_from_millisecond(hold_ms);
+    ctx->stat.hint_cnt++;
+    if (ctx->enabled && mips)
+    {
+        /* don't wait for the window, work is about to start */
+        mode = pm_dvfs_find_mode(mips, 100);
+        if (mode < ctx->mode)
+        {
+            pm_dvfs_set_mode(ctx, mode);
+        }
+        pm_dvfs_unpark();
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+void pm_dvfs_hint_deadline(pm_dvfs_client_t client, uint32_t work_us, uint32_t deadline_ms)
+{
+    uint32_t mhz;
+
+    if (0 == deadline_ms)
+    {
+        pm_dvfs_hint_mips(client, pm_dvfs_mode_mhz[PM_RUN_MODE_HIGH_SPEED], 1);
+        return;
+    }
+
+    /* round up, deadline must be met */
+    mhz = (uint32_t)(((uint64_t)work_us * pm_dvfs_mode_mhz[PM_RUN_MODE_HIGH_SPEED] + deadline_ms * 1000 - 1)
+                     / (deadline_ms * 1000));
+    pm_dvfs_hint_mips(client, mhz, deadline_ms);
+}
+
+void pm_dvfs_get_stat(pm_dvfs_stat_t *stat)
+{
+    rt_base_t level;
+
+    RT_ASSERT(stat);
+
+    level = rt_hw_interrupt_disable();
+    memcpy(stat, &pm_dvfs_ctx.stat, sizeof(*stat));
+    rt_hw_interrupt_enable(level);
+}
+
+static int pm_dvfs(int argc, char **argv)
+{
+    pm_dvfs_ctx_t *ctx = &pm_dvfs_ctx;
+    pm_dvfs_stat_t stat;
+    uint32_t i;
+
+    if (argc > 1)
+    {
+        if (0 == strcmp(argv[1], "on"))
+        {
+            pm_dvfs_enable(true);
+        }
+        else if (0 == strcmp(argv[1], "off"))
+        {
+            pm_dvfs_enable(false);
+        }
+        else if ((0 == strcmp(argv[1], "hint")) && (argc > 3))
+        {
+            pm_dvfs_hint_mips(PM_DVFS_CLIENT_USER, atoi(argv[2]), atoi(argv[3]));
+        }
+        else
+        {
+            rt_kprintf("usage: pm_dvfs [on|off|hint <mips> <hold_ms>]\n");
+        }
+        return 0;
+    }
+
+    pm_dvfs_get_stat(&stat);
+    rt_kprintf("dvfs: %s%s, mode: %d(%dMHz)\n", ctx->enabled ? "on" : "off", ctx->parked ? "(parked)" : "",
+               ctx->mode, pm_dvfs_mode_mhz[ctx->mode]);
+    rt_kprintf("util: %d%%, demand: %dMHz\n", stat.util, stat.demand);
+    rt_kprintf("up: %d, down: %d, hint: %d, park: %d\n", stat.up_cnt, stat.down_cnt, stat.hint_cnt, stat.park_cnt);
+    for (i = 0; i < PM_DVFS_CLIENT_NUM; i++)
+    {
+        if (ctx->hint[i].mhz)
+        {
+            rt_kprintf("client %d: %dMHz\n", i, ctx->hint[i].mhz);
+        }
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(pm_dvfs, pm_dvfs [on|off|hint <mips> <hold_ms>]: load driven DVFS governor);
+
+#endif /* PM_DVFS_GOVERNOR_ENABLED && SF32LB52X && SOC_BF0_HCPU */
 
 static void sifli_sleep(struct rt_pm *pm, uint8_t mode)
 {
@@ -1768,6 +2553,9 @@ static void sifli_sleep(struct rt_pm *pm, uint8_t mode)
     uint32_t start_time;
     uint32_t end_time;
 #endif /* PM_METRICS_ENABLED || BSP_PM_DEBUG */
+#ifdef PM_GOVERNOR_ENABLED
+    uint32_t gov_start_time = HAL_GTIMER_READ();
+#endif /* PM_GOVERNOR_ENABLED */
 
     g_power_mode = mode;
 
@@ -1910,6 +2698,10 @@ static void sifli_sleep(struct rt_pm *pm, uint8_t mode)
 
     pm_save_wakeup_src();
 
+#ifdef PM_GOVERNOR_ENABLED
+    pm_governor_update(mode, gov_start_time, HAL_GTIMER_READ());
+#endif /* PM_GOVERNOR_ENABLED */
+
 #if defined(PM_METRICS_ENABLED)
     pm_stat.sleep_time += (float)(end_time - start_time) / HAL_LPTIM_GetFreq();
     pm_stat.total_wakeup_times += 1;
@@ -2264,6 +3056,10 @@ MSH_CMD_EXPORT(freq_scale, freq scaling);
 
 static void sifli_exit_idle(struct rt_pm *pm)
 {
+#if defined(PM_DVFS_GOVERNOR_ENABLED) && defined(SF32LB52X) && defined(SOC_BF0_HCPU)
+    pm_dvfs_unpark();
+#endif /* PM_DVFS_GOVERNOR_ENABLED && SF32LB52X && SOC_BF0_HCPU */
+
 #if defined(BSP_PM_FREQ_SCALING) && !defined(PM_HW_DEEP_WFI_SUPPORT)
 #ifdef SOC_BF0_HCPU
     if (pm_freq_scaling_param.sys_clk_src > RCC_SYSCLK_HXT48)
@@ -2963,6 +3759,9 @@ int32_t pm_init_mem_map()
     param.ret_mem_start_addr = (uint32_t)PM_RETENTION_RAM_START_ADDR;
     param.ret_mem_size = PM_RETENTION_RAM_SIZE;
     param.backup_mask = CB_BACKUP_HEAP_MASK | CB_BACKUP_STATIC_DATA_MASK | CB_BACKUP_STACK_MASK;
+#ifdef CONTEXT_BACKUP_INCREMENTAL_ENABLED
+    param.backup_mask |= CB_BACKUP_INCREMENTAL_MASK;
+#endif /* CONTEXT_BACKUP_INCREMENTAL_ENABLED */
     param.backup_region_num = 1;
     backup_region = &param.backup_region_list[0];
     backup_region->start_addr = (uint32_t)PM_BACKUP_REGION_START_ADDR;
@@ -3003,8 +3802,15 @@ __ROM_USED int low_power_init(void)
 
     rt_system_pm_init(&sifli_pm, SIFLI_TIMER_MASK, NULL);
     rt_pm_policy_register(sizeof(pm_policy) / sizeof(pm_policy[0]), pm_policy);
+#ifdef PM_GOVERNOR_ENABLED
+    /* selector registered later, e.g. by bluetooth, replaces the governor */
+    rt_pm_override_mode_select(pm_governor_select);
+#endif /* PM_GOVERNOR_ENABLED */
     rt_pm_device_register(NULL, &sifli_pm_op);
     init_default_wakeup_src();
+#if defined(PM_DVFS_GOVERNOR_ENABLED) && defined(SF32LB52X) && defined(SOC_BF0_HCPU)
+    pm_dvfs_init();
+#endif /* PM_DVFS_GOVERNOR_ENABLED && SF32LB52X && SOC_BF0_HCPU */
 
 #if !defined(SF32LB55X) && defined(SOC_BF0_HCPU)
 
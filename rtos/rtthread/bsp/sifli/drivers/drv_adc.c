@@ -60,6 +60,7 @@
 
 #ifdef BSP_USING_ADC
 #include "drv_config.h"
+#include "drv_adc.h"
 
 //#define DRV_DEBUG
 #define LOG_TAG             "drv.adc"
@@ -138,6 +139,41 @@ static float adc_vbat_factor = 2.01;
 static uint32_t adc_thd_reg;
 
 static struct rt_semaphore         gpadc_lock;
+
+#ifdef BSP_GPADC_STREAM
+#ifndef BSP_GPADC_USING_DMA
+    #error "BSP_GPADC_STREAM needs BSP_GPADC_USING_DMA"
+#endif
+#ifdef BSP_GPADC_SUPPORT_MULTI_CH_SAMPLING
+    #error "BSP_GPADC_STREAM could not be used with BSP_GPADC_SUPPORT_MULTI_CH_SAMPLING"
+#endif
+
+typedef struct
+{
+    rt_uint32_t low;
+    rt_uint32_t high;
+    rt_uint8_t state;               /* 0 inside window, 1 above, 2 below */
+} adc_stream_thd_t;
+
+static struct
+{
+    ADC_HandleTypeDef *hadc;
+    rt_adc_stream_cfg_t cfg;
+    volatile rt_uint8_t running;
+    rt_uint8_t nch;
+    rt_uint8_t ch[RT_ADC_STREAM_CH_MAX];    /* channel of each word in DMA frame */
+    rt_uint32_t acc[RT_ADC_STREAM_CH_MAX];  /* decimation accumulator of each word */
+    rt_uint16_t acc_cnt;
+    rt_uint32_t last_isr;                   /* GTIMER of previous half done */
+    rt_uint32_t period;                     /* GTIMER ticks per DMA frame */
+    rt_uint32_t frames;
+    rt_uint32_t irqs;
+    rt_adc_stream_frame_t frame;            /* latest output, also used by rt_adc_read() */
+    adc_stream_thd_t thd[RT_ADC_STREAM_CH_MAX];
+    rt_adc_threshold_cb_t thd_cb;
+    void *thd_arg;
+} adc_stream;
+#endif /* BSP_GPADC_STREAM */
 #ifdef BSP_GPADC_SUPPORT_MULTI_CH_SAMPLING
 struct bf0_hwtimer
 {
@@ -527,6 +563,17 @@ static rt_err_t sifli_get_adc_value(struct rt_adc_device *device, rt_uint32_t ch
     RT_ASSERT(device != RT_NULL);
     RT_ASSERT(value != RT_NULL);
 
+#ifdef BSP_GPADC_STREAM
+    if (adc_stream.running)
+    {
+        /* no conversion while scanning, latest decimated value is returned */
+        if (channel >= RT_ADC_STREAM_CH_MAX || !(adc_stream.cfg.chn_mask & (1 << channel)))
+            return -RT_EBUSY;
+        *value = adc_stream.frame.value[channel];
+        return RT_EOK;
+    }
+#endif
+
     rt_err_t r = rt_sem_take(&gpadc_lock, rt_tick_from_millisecond(2000));
 #ifdef BSP_GPADC_SUPPORT_MULTI_CH_SAMPLING
     uint32_t adc_origin = HAL_ADC_GetValue(sifli_adc_handler, channel);
@@ -744,6 +791,11 @@ static rt_err_t sifli_adc_control(struct rt_adc_device *device, rt_uint32_t cmd,
     RT_ASSERT(RT_ADC_CMD_READ == cmd);
     RT_ASSERT(read_arg);
 
+#ifdef BSP_GPADC_STREAM
+    if (adc_stream.running)
+        return sifli_get_adc_value(device, read_arg->channel, &read_arg->value);
+#endif
+
     rt_err_t r = rt_sem_take(&gpadc_lock, rt_tick_from_millisecond(2000));
     RT_ASSERT(RT_EOK == r);
 
@@ -810,6 +862,273 @@ static rt_err_t sifli_adc_control(struct rt_adc_device *device, rt_uint32_t cmd,
     return RT_EOK;
 }
 
+#ifdef BSP_GPADC_STREAM
+static rt_uint32_t adc_stream_to_value(rt_uint32_t channel, float reg)
+{
+    float fval = sifli_adc_get_float_mv(reg) * 10; // mv to 0.1mv based
+
+#ifdef SF32LB52X
+    if (channel == 7)   // same vbat factor as sifli_get_adc_value()
+        fval *= adc_vbat_factor;
+#endif
+    return fval > 0 ? (rt_uint32_t)fval : 0;
+}
+
+static void adc_stream_check_threshold(rt_uint32_t channel, rt_uint32_t value)
+{
+    adc_stream_thd_t *thd = &adc_stream.thd[channel];
+    rt_uint8_t state;
+
+    if (thd->low >= thd->high)
+        return;
+
+    if (value > thd->high)
+        state = 1;
+    else if (value < thd->low)
+        state = 2;
+    else
+        state = 0;
+
+    if (state != thd->state)
+    {
+        thd->state = state;
+        if (state != 0 && adc_stream.thd_cb)
+            adc_stream.thd_cb(channel, value, state == 1, adc_stream.thd_arg);
+    }
+}
+
+/* Decimate one half of ring, timestamps are spread over time since previous half */
+static void adc_stream_process(rt_uint32_t *buf, rt_uint32_t frames)
+{
+    rt_uint32_t now = HAL_GTIMER_READ();
+    rt_uint32_t span = now - adc_stream.last_isr;
+    rt_uint32_t decim = adc_stream.cfg.decim ? adc_stream.cfg.decim : 1;
+    rt_uint32_t i, s;
+
+    mpu_dcache_invalidate(buf, frames * adc_stream.nch * sizeof(rt_uint32_t));
+    adc_stream.irqs++;
+
+    for (i = 0; i < frames; i++)
+    {
+        for (s = 0; s < adc_stream.nch; s++, buf++)
+            adc_stream.acc[s] += (*buf & GPADC_ADC_DMA_RDATA_DMA_RDATA_Msk) >> GPADC_ADC_DMA_RDATA_DMA_RDATA_Pos;
+        if (++adc_stream.acc_cnt < decim)
+            continue;
+
+        adc_stream.frame.ts = adc_stream.last_isr + (rt_uint32_t)((uint64_t)span * (i + 1) / frames);
+        for (s = 0; s < adc_stream.nch; s++)
+        {
+            rt_uint32_t ch = adc_stream.ch[s];
+
+            adc_stream.frame.value[ch] = adc_stream_to_value(ch, (float)adc_stream.acc[s] / decim);
+            adc_stream.acc[s] = 0;
+            adc_stream_check_threshold(ch, adc_stream.frame.value[ch]);
+        }
+        adc_stream.acc_cnt = 0;
+        adc_stream.frames++;
+        if (adc_stream.cfg.cb)
+            adc_stream.cfg.cb(&adc_stream.frame, adc_stream.cfg.arg);
+    }
+
+    adc_stream.period = span / frames;
+    adc_stream.last_isr = now;
+}
+
+static void adc_stream_half_cplt(DMA_HandleTypeDef *hdma)
+{
+    adc_stream_process(adc_stream.cfg.ring, adc_stream.cfg.frames / 2);
+}
+
+static void adc_stream_cplt(DMA_HandleTypeDef *hdma)
+{
+    rt_uint32_t half = adc_stream.cfg.frames / 2;
+
+    adc_stream_process(adc_stream.cfg.ring + half * adc_stream.nch, adc_stream.cfg.frames - half);
+}
+
+static void adc_stream_error(DMA_HandleTypeDef *hdma)
+{
+    LOG_E("GPADC stream DMA error 0x%x", hdma->ErrorCode);
+}
+
+void GPADC_IRQHandler(void)
+{
+    /* enter interrupt */
+    rt_interrupt_enter();
+
+    if (adc_stream.hadc)
+        HAL_DMA_IRQHandler(adc_stream.hadc->DMA_Handle);
+
+    /* leave interrupt */
+    rt_interrupt_leave();
+}
+
+rt_err_t rt_adc_stream_start(rt_adc_device_t device, const rt_adc_stream_cfg_t *cfg)
+{
+    ADC_HandleTypeDef *hadc;
+    ADC_ChannelConfTypeDef ADC_ChanConf;
+    rt_uint32_t ch, nch;
+    rt_err_t r;
+
+    RT_ASSERT(device != RT_NULL);
+    hadc = device->parent.user_data;
+
+    if (cfg == RT_NULL || cfg->ring == RT_NULL || cfg->frames < 2 || cfg->chn_mask == 0 || hadc->DMA_Handle == NULL)
+        return -RT_EINVAL;
+    if (adc_stream.running)
+        return -RT_EBUSY;
+
+    r = rt_sem_take(&gpadc_lock, rt_tick_from_millisecond(2000));
+    if (r != RT_EOK)
+        return r;
+
+    adc_stream.hadc = hadc;
+    adc_stream.cfg = *cfg;
+    adc_stream.acc_cnt = 0;
+    adc_stream.frames = 0;
+    adc_stream.irqs = 0;
+    adc_stream.period = 0;
+    rt_memset(adc_stream.acc, 0, sizeof(adc_stream.acc));
+    rt_memset(&adc_stream.frame, 0, sizeof(adc_stream.frame));
+    for (ch = 0; ch < RT_ADC_STREAM_CH_MAX; ch++)
+        adc_stream.thd[ch].state = 0;
+
+    /* one slot per channel, conversions of a scan come out in slot order */
+    HAL_ADC_Set_MultiMode(hadc, 1);
+    nch = 0;
+    rt_memset(&ADC_ChanConf, 0, sizeof(ADC_ChanConf));
+    for (ch = 0; ch < RT_ADC_STREAM_CH_MAX; ch++)
+    {
+        if (!(cfg->chn_mask & (1 << ch)))
+        {
+            HAL_ADC_EnableSlot(hadc, ch, 0);
+            continue;
+        }
+        ADC_ChanConf.Channel = sifli_adc_get_channel(ch);
+        ADC_ChanConf.pchnl_sel = ch;
+        ADC_ChanConf.slot_en = 1;
+        ADC_ChanConf.nchnl_sel = 0;
+        ADC_ChanConf.acc_num = cfg->hw_acc;
+        HAL_ADC_ConfigChannel(hadc, &ADC_ChanConf);
+        adc_stream.ch[nch++] = ch;
+    }
+    adc_stream.nch = nch;
+
+    hadc->DMA_Handle->Init.Mode = DMA_CIRCULAR;
+    if (HAL_DMA_Init(hadc->DMA_Handle) != HAL_OK)
+        goto __ERROR;
+    hadc->DMA_Handle->XferHalfCpltCallback = adc_stream_half_cplt;
+    hadc->DMA_Handle->XferCpltCallback = adc_stream_cplt;
+    hadc->DMA_Handle->XferErrorCallback = adc_stream_error;
+    HAL_NVIC_SetPriority(GPADC_DMA_IRQ, GPADC_DMA_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(GPADC_DMA_IRQ);
+
+#ifdef RT_USING_PM
+    /* DMA keeps running in idle sleep, deep sleep would stop GPADC */
+    rt_pm_request(PM_SLEEP_MODE_IDLE);
+#endif
+    HAL_ADC_Prepare(hadc);
+#ifndef SF32LB55X
+    ADC_SET_UNMUTE(hadc);
+#endif
+    ADC_DMA_COMB_DATA(hadc);
+    ADC_DMA_ENABLE(hadc);
+    hadc->Init.op_mode = 1;
+    hadc->Instance->ADC_CTRL_REG |= GPADC_ADC_CTRL_REG_ADC_OP_MODE;
+
+    adc_stream.last_isr = HAL_GTIMER_READ();
+    adc_stream.running = 1;
+    if (HAL_DMA_Start_IT(hadc->DMA_Handle, (uint32_t)&hadc->Instance->ADC_DMA_RDATA, (uint32_t)cfg->ring,
+                         cfg->frames * nch) != HAL_OK)
+    {
+        adc_stream.running = 0;
+#ifdef RT_USING_PM
+        rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif
+        goto __ERROR;
+    }
+    hadc->Instance->ADC_CTRL_REG |= GPADC_ADC_CTRL_REG_ADC_START;
+
+    /* lock is kept until stream stopped */
+    return RT_EOK;
+
+__ERROR:
+    hadc->Init.op_mode = 0;
+    hadc->Instance->ADC_CTRL_REG &= ~GPADC_ADC_CTRL_REG_ADC_OP_MODE;
+    HAL_ADC_Set_MultiMode(hadc, 0);
+    hadc->DMA_Handle->Init.Mode = DMA_NORMAL;
+    adc_stream.hadc = NULL;
+    rt_sem_release(&gpadc_lock);
+    return -RT_ERROR;
+}
+
+rt_err_t rt_adc_stream_stop(rt_adc_device_t device)
+{
+    ADC_HandleTypeDef *hadc;
+    rt_uint32_t ch;
+
+    RT_ASSERT(device != RT_NULL);
+    hadc = device->parent.user_data;
+
+    if (!adc_stream.running || adc_stream.hadc != hadc)
+        return -RT_ERROR;
+
+    HAL_ADC_Stop_DMA(hadc);
+    HAL_NVIC_DisableIRQ(GPADC_DMA_IRQ);
+    adc_stream.running = 0;
+#ifndef SF32LB55X
+    ADC_SET_MUTE(hadc);
+#endif
+    hadc->Init.op_mode = 0;
+    hadc->Instance->ADC_CTRL_REG &= ~GPADC_ADC_CTRL_REG_ADC_OP_MODE;
+
+    /* back to fixed slot 0 used by single conversion */
+    for (ch = 0; ch < RT_ADC_STREAM_CH_MAX; ch++)
+        HAL_ADC_EnableSlot(hadc, ch, 0);
+    HAL_ADC_Set_MultiMode(hadc, 0);
+    hadc->DMA_Handle->Init.Mode = DMA_NORMAL;
+    hadc->DMA_Handle->XferHalfCpltCallback = NULL;
+
+#ifdef RT_USING_PM
+    rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif
+    rt_sem_release(&gpadc_lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_adc_stream_set_threshold(rt_adc_device_t device, rt_uint32_t channel, rt_uint32_t low, rt_uint32_t high,
+                                     rt_adc_threshold_cb_t cb, void *arg)
+{
+    rt_base_t level;
+
+    if (channel >= RT_ADC_STREAM_CH_MAX)
+        return -RT_EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    adc_stream.thd[channel].low = low;
+    adc_stream.thd[channel].high = high;
+    adc_stream.thd[channel].state = 0;
+    adc_stream.thd_cb = cb;
+    adc_stream.thd_arg = arg;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_adc_stream_get_stat(rt_adc_device_t device, rt_adc_stream_stat_t *stat)
+{
+    if (stat == RT_NULL)
+        return -RT_EINVAL;
+
+    stat->frames = adc_stream.frames;
+    stat->irqs = adc_stream.irqs;
+    stat->period_us = (rt_uint32_t)((uint64_t)adc_stream.period * 1000000 / HAL_LPTIM_GetFreq());
+
+    return RT_EOK;
+}
+#endif /* BSP_GPADC_STREAM */
+
 static const struct rt_adc_ops sifli_adc_ops =
 {
     .enabled = sifli_adc_enabled,
@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file   drv_adc.h
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __DRV_ADC_H__
+#define __DRV_ADC_H__
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <drv_common.h>
+
+#ifdef BSP_GPADC_STREAM
+#define RT_ADC_STREAM_CH_MAX        (8)
+
+/** Decimated frame of continuous sampling */
+typedef struct
+{
+    rt_uint32_t ts;                             /**< GTIMER tick, interpolated between DMA interrupts */
+    rt_uint32_t value[RT_ADC_STREAM_CH_MAX];    /**< by channel, 0.1mv based like rt_adc_read(), valid for channels in mask */
+} rt_adc_stream_frame_t;
+
+/**
+ * @brief Frame callback, called in DMA interrupt for each decimated frame.
+ */
+typedef void (*rt_adc_stream_cb_t)(const rt_adc_stream_frame_t *frame, void *arg);
+
+/**
+ * @brief Threshold callback, called in DMA interrupt when channel value crosses its window.
+ * @param channel - ADC channel
+ * @param value - decimated value, 0.1mv based
+ * @param above - 1 if crossed above high threshold, 0 if crossed below low threshold
+ */
+typedef void (*rt_adc_threshold_cb_t)(rt_uint32_t channel, rt_uint32_t value, rt_uint8_t above, void *arg);
+
+typedef struct
+{
+    rt_uint8_t chn_mask;        /**< bit n for channel n, converted in channel order each frame */
+    rt_uint8_t hw_acc;          /**< ACC_NUM of each slot, hardware averaging before DMA, 0 to disable */
+    rt_uint16_t decim;          /**< frames averaged to one output frame, 0 or 1 for no decimation */
+    rt_uint32_t *ring;          /**< DMA ring, one word each conversion, cache line aligned */
+    rt_uint32_t frames;         /**< ring depth in frames, half of ring is processed in each interrupt */
+    rt_adc_stream_cb_t cb;      /**< could be NULL if only threshold or latest value is used */
+    void *arg;
+} rt_adc_stream_cfg_t;
+
+typedef struct
+{
+    rt_uint32_t frames;         /**< decimated frames */
+    rt_uint32_t irqs;           /**< DMA interrupts, CPU wakeups */
+    rt_uint32_t period_us;      /**< measured conversion frame period */
+} rt_adc_stream_stat_t;
+
+/**
+ * @brief Start continuous multi-channel scan, GPADC runs free in continuous mode and DMA fills the ring.
+ *        While running, rt_adc_read() returns latest decimated value of enabled channel without conversion.
+ * @param device - ADC device, e.g. "bat1"
+ * @param cfg - stream configure, copied
+ * @return RT_EOK if started
+ */
+rt_err_t rt_adc_stream_start(rt_adc_device_t device, const rt_adc_stream_cfg_t *cfg);
+
+/** @brief Stop continuous scan. */
+rt_err_t rt_adc_stream_stop(rt_adc_device_t device);
+
+/**
+ * @brief Set threshold window of a channel, low >= high to disable.
+ *        Callback is called once per crossing, so it is not repeated while value stays outside.
+ */
+rt_err_t rt_adc_stream_set_threshold(rt_adc_device_t device, rt_uint32_t channel, rt_uint32_t low, rt_uint32_t high,
+                                     rt_adc_threshold_cb_t cb, void *arg);
+
+/** @brief Get statistics of running stream. */
+rt_err_t rt_adc_stream_get_stat(rt_adc_device_t device, rt_adc_stream_stat_t *stat);
+#endif /* BSP_GPADC_STREAM */
+
+#endif /* __DRV_ADC_H__ */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
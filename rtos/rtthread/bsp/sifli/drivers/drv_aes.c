@@ -187,6 +187,15 @@ rt_err_t drv_aes_copy_async(AES_IOTypeDef *data, pAESCallback cb)
     return aes_start(IRQ_COPY_MODE, AES_ENC, &cfg, data, cb);
 }
 
+void drv_aes_lock(void)
+{
+    Lock();
+}
+
+void drv_aes_unlock(void)
+{
+    Unlock();
+}
 
 static int AES_Init(void)
 {
@@ -109,6 +109,13 @@ rt_err_t drv_aes_dec_sync(AES_KeyTypeDef *cfg, AES_IOTypeDef *data);
  */
 rt_err_t drv_aes_copy_async(AES_IOTypeDef *data, pAESCallback cb);
 
+/**
+ * @brief Get exclusive use of AES/HASH engine for calling HAL API directly, e.g. mbedtls ALT.
+ *        Only polling mode HAL API could be used between lock and unlock.
+ */
+void drv_aes_lock(void);
+void drv_aes_unlock(void);
+
 /// @} drv_aes
 /// @} bsp_driver
 
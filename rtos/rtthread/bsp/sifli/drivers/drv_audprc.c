@@ -52,6 +52,7 @@
 #include "board.h"
 #include "drv_config.h"
 #include "stdlib.h"
+#include "sysview_trace.h"
 #ifdef BSP_ENABLE_AUD_PRC
     #include "drv_audprc.h"
 #endif
@@ -528,7 +529,9 @@ void AUDPRC_TX0_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX0_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 0, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[0]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -541,7 +544,9 @@ void AUDPRC_TX1_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX1_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 1, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[1]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -554,7 +559,9 @@ void AUDPRC_TX2_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX2_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 2, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[2]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -567,7 +574,9 @@ void AUDPRC_TX3_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX3_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 3, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[3]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -580,7 +589,9 @@ void AUDPRC_RX0_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_RX0_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 4, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[4]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -593,7 +604,9 @@ void AUDPRC_RX1_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_RX1_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 5, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[5]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -606,7 +619,9 @@ void AUDPRC_TX_OUT0_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX_OUT0_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 6, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[6]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -619,7 +634,9 @@ void AUDPRC_TX_OUT1_DMA_IRQHandler(void)
 
     //LOG_I("AUDPRC_TX_OUT1_DMA_IRQHandler");
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_AUDPRC, 7, 0);
     HAL_DMA_IRQHandler(h_aud_prc.audprc.hdma[7]);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_AUDPRC);
 
     /* leave interrupt */
     rt_interrupt_leave();
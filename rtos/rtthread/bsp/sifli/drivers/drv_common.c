@@ -306,6 +306,44 @@ void SysTick_Handler(void)
     rt_interrupt_leave();
 }
 
+#ifdef RT_TIMER_EXEC_STAT
+/* GTIMER is used to measure execution time of timer timeout function */
+rt_uint32_t rt_timer_exec_clock(void)
+{
+    return HAL_GTIMER_READ();
+}
+
+rt_uint32_t rt_timer_exec_clock_freq(void)
+{
+    return HAL_LPTIM_GetFreq();
+}
+#endif /* RT_TIMER_EXEC_STAT */
+
+#ifdef RT_USING_INIT_PROFILE
+/* GTIMER runs before system tick starts, board initialization can be measured too */
+rt_uint32_t rt_init_profile_clock(void)
+{
+    return HAL_GTIMER_READ();
+}
+
+rt_uint32_t rt_init_profile_clock_freq(void)
+{
+    return HAL_LPTIM_GetFreq();
+}
+#endif /* RT_USING_INIT_PROFILE */
+
+#ifdef RT_USING_WORKPOOL
+rt_uint32_t rt_workpool_clock(void)
+{
+    return HAL_GTIMER_READ();
+}
+
+rt_uint32_t rt_workpool_clock_freq(void)
+{
+    return HAL_LPTIM_GetFreq();
+}
+#endif /* RT_USING_WORKPOOL */
+
 time_t drv_get_timestamp(void)
 {
 #ifdef HAL_RTC_MODULE_ENABLED
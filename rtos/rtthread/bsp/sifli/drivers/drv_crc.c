@@ -0,0 +1,322 @@
+/**
+  ******************************************************************************
+  * @file   drv_crc.c
+  * @author Sifli software development team
+  * @brief
+  *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <string.h>
+#include "drv_crc.h"
+
+typedef struct
+{
+    uint32_t poly;
+    uint32_t init;
+    uint32_t xorout;
+    uint8_t width;
+    uint8_t ref;        /* input and output are reflected */
+} crc_preset_t;
+
+/* Same as HAL g_crc_config, in order of HAL_CRC_Mode */
+static const crc_preset_t crc_preset[CRC_MODE_NUM] =
+{
+    {0x09,       0x00,       0x00,       7,  0},    /* CRC_7_MMC */
+    {0x07,       0x00,       0x00,       8,  0},    /* CRC_8 */
+    {0x07,       0x00,       0x55,       8,  0},    /* CRC_8_ITU */
+    {0x07,       0xFF,       0x00,       8,  1},    /* CRC_8_ROHC */
+    {0x31,       0x00,       0x00,       8,  1},    /* CRC_8_MAXIM */
+    {0x8005,     0x0000,     0x0000,     16, 1},    /* CRC_16_IBM */
+    {0x8005,     0x0000,     0xFFFF,     16, 1},    /* CRC_16_MAXIM */
+    {0x8005,     0xFFFF,     0xFFFF,     16, 1},    /* CRC_16_USB */
+    {0x8005,     0xFFFF,     0x0000,     16, 1},    /* CRC_16_MODBUS */
+    {0x1021,     0x0000,     0x0000,     16, 1},    /* CRC_16_CCITT */
+    {0x1021,     0xFFFF,     0x0000,     16, 0},    /* CRC_16_CCITT_FALSE */
+    {0x1021,     0xFFFF,     0xFFFF,     16, 1},    /* CRC_16_X25 */
+    {0x1021,     0x0000,     0x0000,     16, 0},    /* CRC_16_XMODEM */
+    {0x3D65,     0x0000,     0xFFFF,     16, 1},    /* CRC_16_DNP */
+    {0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, 32, 1},    /* CRC_32 */
+    {0x04C11DB7, 0xFFFFFFFF, 0x00000000, 32, 0},    /* CRC_32_MPEG_2 */
+};
+
+#define CRC_MASK(w)     ((w) == 32 ? 0xFFFFFFFF : ((1UL << (w)) - 1))
+
+static uint32_t crc_reflect(uint32_t v, uint32_t width)
+{
+    uint32_t r = 0;
+
+    for (uint32_t i = 0; i < width; i++, v >>= 1)
+        r = (r << 1) | (v & 1);
+
+    return r;
+}
+
+/* Reflected CRC-32, the most used one, by nibble table as lfs_crc() */
+static uint32_t crc32_sw(uint32_t crc, const uint8_t *p, uint32_t size)
+{
+    static const uint32_t rtable[16] =
+    {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+
+    while (size--)
+    {
+        crc = (crc >> 4) ^ rtable[(crc ^ *p) & 0xf];
+        crc = (crc >> 4) ^ rtable[(crc ^ (*p++ >> 4)) & 0xf];
+    }
+
+    return crc;
+}
+
+static uint32_t crc_sw(const crc_preset_t *p, uint32_t state, const uint8_t *buf, uint32_t size)
+{
+    uint32_t poly;
+
+    if (p->poly == 0x04C11DB7 && p->ref)
+        return crc32_sw(state, buf, size);
+
+    if (p->ref)
+    {
+        poly = crc_reflect(p->poly, p->width);
+        while (size--)
+        {
+            state ^= *buf++;
+            for (int i = 0; i < 8; i++)
+                state = (state >> 1) ^ ((state & 1) ? poly : 0);
+        }
+    }
+    else
+    {
+        /* work on MSB aligned register so that width less than 8 works as well */
+        poly = p->poly << (32 - p->width);
+        state <<= 32 - p->width;
+        while (size--)
+        {
+            state ^= (uint32_t) * buf++ << 24;
+            for (int i = 0; i < 8; i++)
+                state = (state << 1) ^ ((state & 0x80000000) ? poly : 0);
+        }
+        state >>= 32 - p->width;
+    }
+
+    return state;
+}
+
+#ifdef HAL_CRC_MODULE_ENABLED
+static CRC_HandleTypeDef crc_handle;
+static struct rt_mutex crc_lock;
+static uint8_t crc_ready;
+
+#ifdef DRV_CRC_DMA_INSTANCE
+static DMA_HandleTypeDef crc_dma;
+
+/* Return bytes fed, 0 if engine should be fed by CPU */
+static uint32_t crc_hw_dma(const uint8_t *buf, uint32_t size)
+{
+    size &= ~3;
+    if (((uint32_t)buf & 3) || size < DRV_CRC_DMA_THRESHOLD)
+        return 0;
+
+    crc_dma.Instance = DRV_CRC_DMA_INSTANCE;
+    crc_dma.Init.Request = 0;
+    crc_dma.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    crc_dma.Init.PeriphInc = DMA_PINC_ENABLE;     //src
+    crc_dma.Init.MemInc = DMA_MINC_DISABLE;       //dst, CRC data register
+    crc_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    crc_dma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    crc_dma.Init.Mode = DMA_NORMAL;
+    crc_dma.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&crc_dma) != HAL_OK)
+        return 0;
+
+    mpu_dcache_clean((void *)buf, size);
+    crc_handle.Instance->CR |= (HAL_CRC_DATASIZE_32 << CRC_CR_DATASIZE_Pos);
+    if (HAL_DMA_Start(&crc_dma, (uint32_t)buf, (uint32_t)&crc_handle.Instance->DR, size >> 2) != HAL_OK
+            || HAL_DMA_PollForTransfer(&crc_dma, HAL_DMA_FULL_TRANSFER, 1000) != HAL_OK)
+        size = 0;
+    HAL_DMA_DeInit(&crc_dma);
+    while (0 == (crc_handle.Instance->SR & CRC_SR_DONE));
+
+    /* engine can't keep up with DMA, data is lost */
+    if (crc_handle.Instance->SR & CRC_SR_OVERFLOW)
+        size = 0;
+
+    return size;
+}
+#endif /* DRV_CRC_DMA_INSTANCE */
+
+static uint32_t crc_hw(HAL_CRC_Mode mode, uint32_t state, const uint8_t *buf, uint32_t size)
+{
+    const crc_preset_t *p = &crc_preset[mode];
+    /* INIT is loaded to shift register, which isn't reflected */
+    uint32_t init = p->ref ? crc_reflect(state, p->width) : state;
+    uint32_t done = 0;
+
+    rt_mutex_take(&crc_lock, RT_WAITING_FOREVER);
+    HAL_CRC_Setmode_Customized(&crc_handle, init, p->poly, mode);
+#ifdef DRV_CRC_DMA_INSTANCE
+    done = crc_hw_dma(buf, size);
+    if (!done)
+        HAL_CRC_Setmode_Customized(&crc_handle, init, p->poly, mode);
+#endif
+    /* HAL_CRC_Accumulate needs at least one word */
+    if (size - done >= 4)
+    {
+        HAL_CRC_Accumulate(&crc_handle, (uint8_t *)buf + done, size - done);
+        done = size;
+    }
+    state = crc_handle.Instance->DR & CRC_MASK(p->width);
+    rt_mutex_release(&crc_lock);
+
+    if (done < size)
+        state = crc_sw(p, state, buf + done, size - done);
+
+    return state;
+}
+#endif /* HAL_CRC_MODULE_ENABLED */
+
+uint32_t drv_crc_accumulate(HAL_CRC_Mode mode, uint32_t state, const void *buf, uint32_t size)
+{
+    RT_ASSERT(mode < CRC_MODE_NUM);
+
+#ifdef HAL_CRC_MODULE_ENABLED
+    if (crc_ready && size >= DRV_CRC_HW_THRESHOLD && !rt_interrupt_get_nest())
+        return crc_hw(mode, state, buf, size);
+#endif
+
+    return crc_sw(&crc_preset[mode], state, buf, size);
+}
+
+void drv_crc_start(drv_crc_ctx_t *ctx, HAL_CRC_Mode mode)
+{
+    const crc_preset_t *p = &crc_preset[mode];
+
+    RT_ASSERT(mode < CRC_MODE_NUM);
+    ctx->mode = mode;
+    ctx->state = p->ref ? crc_reflect(p->init, p->width) : p->init;
+}
+
+void drv_crc_update(drv_crc_ctx_t *ctx, const void *buf, uint32_t size)
+{
+    ctx->state = drv_crc_accumulate(ctx->mode, ctx->state, buf, size);
+}
+
+uint32_t drv_crc_finish(drv_crc_ctx_t *ctx)
+{
+    return ctx->state ^ crc_preset[ctx->mode].xorout;
+}
+
+uint32_t drv_crc_calc(HAL_CRC_Mode mode, const void *buf, uint32_t size)
+{
+    drv_crc_ctx_t ctx;
+
+    drv_crc_start(&ctx, mode);
+    drv_crc_update(&ctx, buf, size);
+
+    return drv_crc_finish(&ctx);
+}
+
+uint32_t drv_crc_xorout(HAL_CRC_Mode mode)
+{
+    RT_ASSERT(mode < CRC_MODE_NUM);
+
+    return crc_preset[mode].xorout;
+}
+
+#ifdef HAL_CRC_MODULE_ENABLED
+static int CRC_Init(void)
+{
+    crc_handle.Instance = hwp_crc;
+    if (HAL_CRC_Init(&crc_handle) != HAL_OK)
+        return -RT_ERROR;
+    rt_mutex_init(&crc_lock, "crc_drv", RT_IPC_FLAG_FIFO);
+    crc_ready = 1;
+
+    return 0;
+}
+INIT_BOARD_EXPORT(CRC_Init);
+#endif /* HAL_CRC_MODULE_ENABLED */
+
+#if defined(RT_USING_FINSH) && defined(HAL_CRC_MODULE_ENABLED)
+#include <stdlib.h>
+
+/* Check engine against software implementation and compare speed */
+static void crc_test(int argc, char **argv)
+{
+    uint32_t size = argc > 1 ? atoi(argv[1]) : 4096;
+    uint8_t *buf;
+    uint32_t hw, sw, t0, t1, t2;
+
+    if (size < DRV_CRC_HW_THRESHOLD * 2)
+        size = DRV_CRC_HW_THRESHOLD * 2;
+    buf = rt_malloc(size + 1);
+
+    if (!buf)
+        return;
+    for (uint32_t i = 0; i <= size; i++)
+        buf[i] = (uint8_t)(i * 7 + 3);
+
+    for (int mode = 0; mode < CRC_MODE_NUM; mode++)
+    {
+        const crc_preset_t *p = &crc_preset[mode];
+        uint32_t init = p->ref ? crc_reflect(p->init, p->width) : p->init;
+
+        /* odd address and split to cover unaligned head and tail, and resume */
+        t0 = HAL_GTIMER_READ();
+        hw = crc_hw((HAL_CRC_Mode)mode, init, buf + 1, size / 2);
+        hw = crc_hw((HAL_CRC_Mode)mode, hw, buf + 1 + size / 2, size - size / 2);
+        t1 = HAL_GTIMER_READ();
+        sw = crc_sw(p, init, buf + 1, size);
+        t2 = HAL_GTIMER_READ();
+        rt_kprintf("mode %d: hw 0x%x %dus, sw 0x%x %dus %s\n", mode, hw ^ p->xorout,
+                   (uint32_t)((uint64_t)(t1 - t0) * 1000000 / HAL_LPTIM_GetFreq()), sw ^ p->xorout,
+                   (uint32_t)((uint64_t)(t2 - t1) * 1000000 / HAL_LPTIM_GetFreq()), hw == sw ? "OK" : "FAIL");
+    }
+    rt_free(buf);
+}
+MSH_CMD_EXPORT(crc_test, CRC engine test: crc_test [size]);
+#endif /* RT_USING_FINSH && HAL_CRC_MODULE_ENABLED */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,148 @@
+/**
+  ******************************************************************************
+  * @file   drv_crc.h
+  * @author Sifli software development team
+  * @brief CRC BSP driver
+  * @{
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __DRV_CRC_H_
+#define __DRV_CRC_H_
+
+#include <rtthread.h>
+#include <board.h>
+#include "bf0_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup bsp_driver Driver IO
+  * @{
+  */
+
+/** @defgroup drv_crc CRC
+  * @brief CRC service shared by file systems, KV database and transfer tools.
+  *
+  * Engine is shared by mutex, each context keeps its own intermediate value so that
+  * several streams could be accumulated at same time. Buffer shorter than DRV_CRC_HW_THRESHOLD,
+  * call from ISR or before board init is calculated by software with same result.
+  * @{
+  */
+
+#ifndef DRV_CRC_HW_THRESHOLD
+#define DRV_CRC_HW_THRESHOLD    (32)        /* Minimum size in bytes to use engine */
+#endif
+
+/* Define DRV_CRC_DMA_INSTANCE as a free DMA channel, e.g. DMA1_Channel7, to feed engine by DMA
+   for buffer longer than DRV_CRC_DMA_THRESHOLD, CPU feeds it again if engine reports overflow */
+//#define DRV_CRC_DMA_INSTANCE    DMA1_Channel7
+#ifndef DRV_CRC_DMA_THRESHOLD
+#define DRV_CRC_DMA_THRESHOLD   (1024)
+#endif
+
+typedef struct
+{
+    HAL_CRC_Mode mode;
+    uint32_t state;     /* Intermediate value, before final xor */
+} drv_crc_ctx_t;
+
+/**
+ * @brief Start a CRC calculation.
+ * @param ctx - context
+ * @param mode - CRC preset, see HAL_CRC_Mode
+ */
+void drv_crc_start(drv_crc_ctx_t *ctx, HAL_CRC_Mode mode);
+
+/**
+ * @brief Accumulate data to context.
+ * @param ctx - context
+ * @param buf - data, any alignment
+ * @param size - data size in bytes
+ */
+void drv_crc_update(drv_crc_ctx_t *ctx, const void *buf, uint32_t size);
+
+/**
+ * @brief Get CRC of data accumulated, context could be updated further.
+ * @param ctx - context
+ * @return CRC value
+ */
+uint32_t drv_crc_finish(drv_crc_ctx_t *ctx);
+
+/**
+ * @brief Continue calculation from an intermediate value, for existing API which carries
+ *        CRC between calls, e.g. fdb_calc_crc32(), lfs_crc().
+ * @param mode - CRC preset
+ * @param state - intermediate value, before final xor
+ * @param buf - data
+ * @param size - data size in bytes
+ * @return new intermediate value
+ */
+uint32_t drv_crc_accumulate(HAL_CRC_Mode mode, uint32_t state, const void *buf, uint32_t size);
+
+/**
+ * @brief Calculate CRC of a buffer.
+ * @param mode - CRC preset
+ * @param buf - data
+ * @param size - data size in bytes
+ * @return CRC value
+ */
+uint32_t drv_crc_calc(HAL_CRC_Mode mode, const void *buf, uint32_t size);
+
+/**
+ * @brief Get final xor of preset, intermediate value = CRC ^ xor.
+ * @param mode - CRC preset
+ * @return final xor value
+ */
+uint32_t drv_crc_xorout(HAL_CRC_Mode mode);
+
+/// @} drv_crc
+/// @} bsp_driver
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__DRV_CRC_H_ */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
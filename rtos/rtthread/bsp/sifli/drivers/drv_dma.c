@@ -53,6 +53,7 @@
 
 #include <drv_log.h>
 #include <drv_common.h>
+#include "sysview_trace.h"
 
 #ifdef DMA_SUPPORT_DYN_CHANNEL_ALLOC
 void DMAC1_CH1_IRQHandler(void)
@@ -60,7 +61,9 @@ void DMAC1_CH1_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 1, 0);
     HAL_DMAC1_CH1_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -71,7 +74,9 @@ void DMAC1_CH2_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 2, 0);
     HAL_DMAC1_CH2_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -82,7 +87,9 @@ void DMAC1_CH3_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 3, 0);
     HAL_DMAC1_CH3_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -93,7 +100,9 @@ void DMAC1_CH4_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 4, 0);
     HAL_DMAC1_CH4_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -104,7 +113,9 @@ void DMAC1_CH5_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 5, 0);
     HAL_DMAC1_CH5_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -115,7 +126,9 @@ void DMAC1_CH6_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 6, 0);
     HAL_DMAC1_CH6_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -126,7 +139,9 @@ void DMAC1_CH7_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 7, 0);
     HAL_DMAC1_CH7_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -137,7 +152,9 @@ void DMAC1_CH8_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (1 << 4) | 8, 0);
     HAL_DMAC1_CH8_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -148,7 +165,9 @@ void DMAC2_CH1_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 1, 0);
     HAL_DMAC2_CH1_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -159,7 +178,9 @@ void DMAC2_CH2_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 2, 0);
     HAL_DMAC2_CH2_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -170,7 +191,9 @@ void DMAC2_CH3_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 3, 0);
     HAL_DMAC2_CH3_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -181,7 +204,9 @@ void DMAC2_CH4_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 4, 0);
     HAL_DMAC2_CH4_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -192,7 +217,9 @@ void DMAC2_CH5_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 5, 0);
     HAL_DMAC2_CH5_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -203,7 +230,9 @@ void DMAC2_CH6_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 6, 0);
     HAL_DMAC2_CH6_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -214,7 +243,9 @@ void DMAC2_CH7_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 7, 0);
     HAL_DMAC2_CH7_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -225,7 +256,9 @@ void DMAC2_CH8_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (2 << 4) | 8, 0);
     HAL_DMAC2_CH8_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -238,7 +271,9 @@ void DMAC3_CH1_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 1, 0);
     HAL_DMAC3_CH1_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -249,7 +284,9 @@ void DMAC3_CH2_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 2, 0);
     HAL_DMAC3_CH2_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -260,7 +297,9 @@ void DMAC3_CH3_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 3, 0);
     HAL_DMAC3_CH3_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -271,7 +310,9 @@ void DMAC3_CH4_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 4, 0);
     HAL_DMAC3_CH4_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -282,7 +323,9 @@ void DMAC3_CH5_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 5, 0);
     HAL_DMAC3_CH5_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -293,7 +336,9 @@ void DMAC3_CH6_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 6, 0);
     HAL_DMAC3_CH6_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -304,7 +349,9 @@ void DMAC3_CH7_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 7, 0);
     HAL_DMAC3_CH7_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -315,7 +362,9 @@ void DMAC3_CH8_IRQHandler(void)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_DMA, (3 << 4) | 8, 0);
     HAL_DMAC3_CH8_IRQHandler();
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_DMA);
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -49,6 +49,10 @@
 #include <rthw.h>
 #include "string.h"
 #include "mem_section.h"
+#include "sysview_trace.h"
+#ifdef LVSF_PERF_MODEL
+    #include "lvsf_perf_model.h"
+#endif
 #ifdef HAL_EZIP_MODULE_ENABLED
     #include "drv_flash.h"
 #endif
@@ -74,6 +78,58 @@
     #define MAX(x,y) (((x)>(y))?(x):(y))
 #endif
 
+#ifdef LVSF_PERF_MODEL
+static uint32_t epic_perf_layer_bytes(const EPIC_BlendingDataType *layer)
+{
+    if (!layer || !layer->data)
+        return 0;
+    return (uint32_t)layer->width * layer->height * HAL_EPIC_GetColorDepth(layer->color_mode) / 8;
+}
+
+/*Charge one op to simulator performance model, output layer is read as background and written*/
+static void epic_perf_model(lvsf_perf_epic_op_t op, const EPIC_LayerConfigTypeDef *in, uint8_t in_num,
+                            const EPIC_LayerConfigTypeDef *out)
+{
+    uint32_t src_bytes = 0;
+    uint32_t fb_bytes;
+
+    for (uint8_t i = 0; i < in_num; i++)
+    {
+        /*Background in frame buffer is counted by fb_bytes*/
+        if (in[i].data == out->data)
+            continue;
+        if ((LVSF_PERF_EPIC_BLEND == op) && ((0 != in[i].transform_cfg.angle)
+                                             || (EPIC_INPUT_SCALE_NONE != in[i].transform_cfg.scale_x)
+                                             || (EPIC_INPUT_SCALE_NONE != in[i].transform_cfg.scale_y)))
+            op = LVSF_PERF_EPIC_TRANSFORM;
+        src_bytes += epic_perf_layer_bytes((const EPIC_BlendingDataType *)&in[i]);
+    }
+    fb_bytes = epic_perf_layer_bytes((const EPIC_BlendingDataType *)out) * 2;
+    LVSF_PERF_MODEL_EPIC(op, (uint32_t)out->width * out->height, src_bytes, fb_bytes);
+}
+
+static void epic_perf_model_copy(const EPIC_BlendingDataType *src, const EPIC_BlendingDataType *dst)
+{
+    LVSF_PERF_MODEL_EPIC(LVSF_PERF_EPIC_COPY, (uint32_t)dst->width * dst->height,
+                         epic_perf_layer_bytes(src), epic_perf_layer_bytes(dst));
+}
+
+static void epic_perf_model_grad(const EPIC_GradCfgTypeDef *param)
+{
+    uint32_t pixels = (uint32_t)param->width * param->height;
+
+    LVSF_PERF_MODEL_EPIC(LVSF_PERF_EPIC_GRAD, pixels, 0, pixels * HAL_EPIC_GetColorDepth(param->color_mode) / 8);
+}
+
+    #define EPIC_PERF_MODEL(op, in, in_num, out)    epic_perf_model(op, in, in_num, out)
+    #define EPIC_PERF_MODEL_COPY(src, dst)          epic_perf_model_copy(src, dst)
+    #define EPIC_PERF_MODEL_GRAD(param)             epic_perf_model_grad(param)
+#else
+    #define EPIC_PERF_MODEL(op, in, in_num, out)
+    #define EPIC_PERF_MODEL_COPY(src, dst)
+    #define EPIC_PERF_MODEL_GRAD(param)
+#endif /* LVSF_PERF_MODEL */
+
 #define TICK_TIME_START uint32_t __wait_time = rt_tick_get();
 #define TICK_TIME_PRINT  LOG_E("Line %d, cost %d ms\r\n",__LINE__,rt_tick_get() - __wait_time);
 
@@ -105,6 +161,13 @@
 
 #define debug_rl_hist_num  src_list_max //Set '0' to disable history
 
+/*Max input layers of one merged blending, include the dst layer if used as background*/
+#ifdef SF32LB52X
+    #define merge_layer_max    2
+#else
+    #define merge_layer_max    MAX_EPIC_LAYER
+#endif /* SF32LB52X */
+
 typedef struct
 {
     uint32_t  used;
@@ -193,6 +256,7 @@ typedef struct
 
     priv_render_list_t render_list_pool[render_list_pool_max];
     priv_render_list_t *using_rl; //Committing rl
+    drv_epic_cmd_buf_t *recording_cb;
 #if debug_rl_hist_num > 0
     uint32_t           hist_idx;
     priv_render_hist_t hist[debug_rl_hist_num];
@@ -311,7 +375,9 @@ __ROM_USED void EPIC_IRQHandler(void)
     epic = drv_get_epic_handle();
     RT_ASSERT(RT_NULL != epic);
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_EPIC, 0, 0);
     HAL_EPIC_IRQHandler(epic);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_EPIC);
 
     rt_interrupt_leave();
 }
@@ -326,7 +392,9 @@ __ROM_USED void EZIP_IRQHandler(void)
     ezip = drv_get_ezip_handle();
     RT_ASSERT(RT_NULL != ezip);
 
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_EZIP, 0, 0);
     HAL_EZIP_IRQHandler(ezip);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_EZIP);
 
     rt_interrupt_leave();
 }
@@ -1342,6 +1410,7 @@ static HAL_StatusTypeDef epic_split_render_next(uint8_t init)
         PRINT_LAYER_INFO(p_src_layer, "src");
         PRINT_LAYER_INFO(p_dst_layer, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL_COPY(p_src_layer, p_dst_layer);
         ret = HAL_EPIC_Copy_IT(h_epic, p_src_layer, p_dst_layer);
     }
     break;
@@ -1357,6 +1426,7 @@ static HAL_StatusTypeDef epic_split_render_next(uint8_t init)
         }
         PRINT_LAYER_INFO(&drv_epic.output_layer, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_FILL, drv_epic.input_layers, drv_epic.input_layer_cnt, &drv_epic.output_layer);
         ret = HAL_EPIC_BlendStartEx_IT(h_epic, drv_epic.input_layers,
                                        drv_epic.input_layer_cnt, &drv_epic.output_layer);
     }
@@ -1371,6 +1441,7 @@ static HAL_StatusTypeDef epic_split_render_next(uint8_t init)
         }
         PRINT_LAYER_INFO(&drv_epic.output_layer, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_BLEND, drv_epic.input_layers, drv_epic.input_layer_cnt, &drv_epic.output_layer);
         ret = HAL_EPIC_BlendStartEx_IT(h_epic, drv_epic.input_layers,
                                        drv_epic.input_layer_cnt, &drv_epic.output_layer);
     }
@@ -1385,6 +1456,7 @@ static HAL_StatusTypeDef epic_split_render_next(uint8_t init)
         }
         PRINT_LAYER_INFO(&drv_epic.output_layer, "dst");
 
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_TRANSFORM, drv_epic.input_layers, drv_epic.input_layer_cnt, &drv_epic.output_layer);
         ret = HAL_EPIC_TransStart(h_epic, drv_epic.input_layers,
                                   drv_epic.input_layer_cnt, &drv_epic.output_layer,
                                   drv_epic.split_rd.hor_path,
@@ -1409,6 +1481,7 @@ static HAL_StatusTypeDef epic_split_render_next(uint8_t init)
               param.width, param.height);
 
 
+        EPIC_PERF_MODEL_GRAD(&param);
         ret = HAL_EPIC_FillGrad_IT(h_epic, &param);
 
     }
@@ -1458,6 +1531,9 @@ rt_err_t drv_epic_copy(const uint8_t *src, uint8_t *dst,
     EPIC_BlendingDataType *p_src_layer = (EPIC_BlendingDataType *) &drv_epic.input_layers[0];
     EPIC_BlendingDataType *p_dst_layer = (EPIC_BlendingDataType *) &drv_epic.output_layer;
 
+    /*Close letter batch first, it holds EPIC until stopped*/
+    cont_blend_reset();
+
     err = wait_gpu_done(GPU_BLEND_EXP_MS);
     if (RT_EOK != err) return err;
 
@@ -1487,7 +1563,6 @@ rt_err_t drv_epic_copy(const uint8_t *src, uint8_t *dst,
     //Clip dst layer to copy area
     clip_layer_to_area(p_dst_layer, dst, dst_area->x0, dst_area->y0, copy_area);
 
-    cont_blend_reset();
     gpu_lock(DRV_EPIC_IMG_COPY, p_src_layer, NULL, p_dst_layer);
     drv_epic.cbk = cbk;
 
@@ -1509,6 +1584,7 @@ rt_err_t drv_epic_copy(const uint8_t *src, uint8_t *dst,
         PRINT_LAYER_INFO(p_src_layer, "src");
         PRINT_LAYER_INFO(p_dst_layer, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL_COPY(p_src_layer, p_dst_layer);
         ret = HAL_EPIC_Copy_IT(h_epic, p_src_layer, p_dst_layer);
     }
 
@@ -1529,10 +1605,12 @@ rt_err_t drv_epic_fill_ext(EPIC_LayerConfigTypeDef *input_layers,
     EPIC_HandleTypeDef *h_epic = &epic_handle;
     EPIC_AreaTypeDef *fill_area = &drv_epic.split_rd.dst_area;
 
+    /*Close letter batch first, it holds EPIC until stopped*/
+    cont_blend_reset();
+
     err = wait_gpu_done(GPU_BLEND_EXP_MS);
     if (RT_EOK != err) return err;
 
-    cont_blend_reset();
     gpu_lock(DRV_EPIC_COLOR_FILL,
              (3 == input_layer_cnt) ? input_layers + 2 : NULL,
              NULL, output_canvas);
@@ -1570,6 +1648,7 @@ rt_err_t drv_epic_fill_ext(EPIC_LayerConfigTypeDef *input_layers,
         }
         PRINT_LAYER_INFO(output_canvas, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_FILL, input_layers, input_layer_cnt, output_canvas);
         ret = HAL_EPIC_BlendStartEx_IT(h_epic, input_layers, input_layer_cnt, output_canvas);
     }
 
@@ -1681,10 +1760,12 @@ rt_err_t drv_epic_fill_grad(EPIC_GradCfgTypeDef *param,
     EPIC_HandleTypeDef *h_epic = &epic_handle;
     EPIC_AreaTypeDef *fill_area = &drv_epic.split_rd.dst_area;
 
+    /*Close letter batch first, it holds EPIC until stopped*/
+    cont_blend_reset();
+
     err = wait_gpu_done(GPU_BLEND_EXP_MS);
     if (RT_EOK != err) return err;
 
-    cont_blend_reset();
     gpu_lock(DRV_EPIC_FILL_GRAD, NULL, NULL, param);
     drv_epic.cbk = cbk;
 
@@ -1727,6 +1808,7 @@ rt_err_t drv_epic_fill_grad(EPIC_GradCfgTypeDef *param,
 
 
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL_GRAD(param);
         ret = HAL_EPIC_FillGrad_IT(h_epic, param);
     }
 
@@ -1748,10 +1830,12 @@ rt_err_t drv_epic_blend(EPIC_LayerConfigTypeDef *input_layers,
     EPIC_HandleTypeDef *h_epic = &epic_handle;
     EPIC_AreaTypeDef *p_blend_area = &drv_epic.split_rd.dst_area;
 
+    /*Close letter batch first, it holds EPIC until stopped*/
+    cont_blend_reset();
+
     err = wait_gpu_done(GPU_BLEND_EXP_MS);
     if (RT_EOK != err) return err;
 
-    cont_blend_reset();
     gpu_lock(DRV_EPIC_IMG_ROT, input_layers, &input_layer_cnt, output_canvas);
     drv_epic.cbk = cbk;
 
@@ -1788,6 +1872,7 @@ rt_err_t drv_epic_blend(EPIC_LayerConfigTypeDef *input_layers,
         }
         PRINT_LAYER_INFO(output_canvas, "dst");
         h_epic->XferCpltCallback = epic_cplt_callback;
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_BLEND, input_layers, input_layer_cnt, output_canvas);
         ret = HAL_EPIC_BlendStartEx_IT(h_epic, input_layers, input_layer_cnt, output_canvas);
     }
 
@@ -1813,10 +1898,12 @@ rt_err_t drv_epic_transform(EPIC_LayerConfigTypeDef *input_layers,
     EPIC_HandleTypeDef *h_epic = &epic_handle;
     EPIC_AreaTypeDef *p_blend_area = &drv_epic.split_rd.dst_area;
 
+    /*Close letter batch first, it holds EPIC until stopped*/
+    cont_blend_reset();
+
     err = wait_gpu_done(GPU_BLEND_EXP_MS);
     if (RT_EOK != err) return err;
 
-    cont_blend_reset();
     gpu_lock(DRV_EPIC_TRANSFORM, input_layers, &input_layer_cnt, output_canvas);
     drv_epic.cbk = cbk;
 
@@ -1869,6 +1956,7 @@ rt_err_t drv_epic_transform(EPIC_LayerConfigTypeDef *input_layers,
         }
         PRINT_LAYER_INFO(output_canvas, "dst");
 
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_TRANSFORM, input_layers, input_layer_cnt, output_canvas);
         ret = HAL_EPIC_TransStart(h_epic, input_layers, input_layer_cnt,
                                   output_canvas, hor_path, ver_path, user_data);
 
@@ -1914,6 +2002,7 @@ rt_err_t drv_epic_cont_blend(EPIC_LayerConfigTypeDef *input_layers,
 
         gpu_lock(DRV_EPIC_LETTER_BLEND, fg_layer, mask_layer, output_canvas);
 
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_MASK, fg_layer, 1, output_canvas);
         ret = HAL_EPIC_ContBlendStart(h_epic, fg_layer, mask_layer, output_canvas);
         drv_epic.cont_mode = true;
     }
@@ -1927,6 +2016,7 @@ rt_err_t drv_epic_cont_blend(EPIC_LayerConfigTypeDef *input_layers,
             dcache_all_cleaned = mpu_dcache_clean(mask_layer->data, mask_layer->data_size);
         }
 
+        EPIC_PERF_MODEL(LVSF_PERF_EPIC_MASK, fg_layer, 1, output_canvas);
         ret = HAL_EPIC_ContBlendRepeat(h_epic, fg_layer, mask_layer, output_canvas);
     }
 
@@ -2304,6 +2394,65 @@ static void wait_hw_done(void)
     __DEBUG_RENDER_LIST_WAIT_EPIC_END__;
 
 }
+
+static bool is_mergeable_layer(const EPIC_LayerConfigTypeDef *layer)
+{
+    if (EPIC_IS_EZIP_COLOR_MODE(layer->color_mode) || EPIC_IS_YUV_COLOR_MODE(layer->color_mode))
+        return false;
+
+    if ((ALPHA_BLEND_MASK == layer->ax_mode) || (ALPHA_BLEND_OVERWRITE == layer->ax_mode))
+        return false;
+
+    if ((0 != layer->x_offset_frac) || (0 != layer->y_offset_frac))
+        return false;
+
+    if ((0 != layer->transform_cfg.angle)
+            || (EPIC_INPUT_SCALE_NONE != layer->transform_cfg.scale_x)
+            || (EPIC_INPUT_SCALE_NONE != layer->transform_cfg.scale_y)
+            || (0 != layer->transform_cfg.h_mirror)
+            || (0 != layer->transform_cfg.v_mirror))
+        return false;
+
+    return true;
+}
+
+/*
+    Copy fg layers of the blending operations following 'idx' which have the same output area
+    to 'layers'(at most 'max'), so that they are blended in one EPIC pass.
+    Return the number of merged operations.
+*/
+static uint16_t merge_next_blend_ops(priv_render_list_t *rl, uint16_t idx,
+                                     EPIC_LayerConfigTypeDef *layers, uint8_t max)
+{
+    const drv_epic_operation *cur_op = &rl->src_list[idx];
+    uint16_t merged = 0;
+
+    if (drv_epic.dbg_flag_dis_merge_operations & 0x20) return 0;
+    if (cur_op->mask.data) return 0;
+
+    for (uint16_t i = idx + 1; i < rl->src_list_len; i++)
+    {
+        const drv_epic_operation *next_op = &rl->src_list[i];
+
+        if (merged >= max) break;
+
+        if ((DRV_EPIC_COLOR_BLEND != next_op->op)
+                || (NULL != next_op->mask.data)
+                || (0 == next_op->desc.blend.use_dest_as_bg)
+                || (next_op->offset_x != cur_op->offset_x)
+                || (next_op->offset_y != cur_op->offset_y)
+                || !HAL_EPIC_AreaIsIn(&next_op->clip_area, &cur_op->clip_area)
+                || !HAL_EPIC_AreaIsIn(&cur_op->clip_area, &next_op->clip_area)
+                || !is_mergeable_layer(&next_op->desc.blend.layer))
+            break;
+
+        memcpy(&layers[merged], &next_op->desc.blend.layer, sizeof(EPIC_LayerConfigTypeDef));
+        merged++;
+    }
+
+    return merged;
+}
+
 static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
 {
     EPIC_AreaTypeDef dst_area, intersect_area;
@@ -2429,6 +2578,7 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                                 cont_blend_first = 0;
 
                                 render_lock(DRV_EPIC_LETTER_BLEND, fg_addr, bg_addr, mask_addr); //Assume all data at same memory
+                                EPIC_PERF_MODEL(LVSF_PERF_EPIC_MASK, &fg_layer, 1, &output_layer);
                                 ret = HAL_EPIC_ContBlendStart(drv_epic.using_epic, &fg_layer,
                                                               (3 == input_layer_cnt) ? &mask_layer : NULL,
                                                               &output_layer);
@@ -2436,6 +2586,7 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                             }
                             else
                             {
+                                EPIC_PERF_MODEL(LVSF_PERF_EPIC_MASK, &fg_layer, 1, &output_layer);
                                 ret = HAL_EPIC_ContBlendRepeat(drv_epic.using_epic, &fg_layer,
                                                                (3 == input_layer_cnt) ? &mask_layer : NULL,
                                                                &output_layer);
@@ -2500,7 +2651,7 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                 {
                 case DRV_EPIC_COLOR_BLEND:
                 {
-                    EPIC_LayerConfigTypeDef input_layers[3];
+                    EPIC_LayerConfigTypeDef input_layers[MAX_EPIC_LAYER];
 
                     uint8_t input_layer_cnt = 2;
 
@@ -2513,6 +2664,15 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                         mask_addr = (uint32_t) p_operation->mask.data;
                         input_layer_cnt++;
                     }
+                    else
+                    {
+                        //Blend fg layers of the following operations in one pass, dst layer is input only if it's bg
+                        uint8_t used = p_operation->desc.blend.use_dest_as_bg ? 2 : 1;
+                        uint16_t merged = merge_next_blend_ops(rl, i, &input_layers[2], merge_layer_max - used);
+
+                        input_layer_cnt += merged;
+                        i += merged;
+                    }
 
                     if (fg_addr == drv_epic.dbg_src_addr)
                     {
@@ -2526,10 +2686,12 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                         output_layer.color_r  = p_operation->desc.blend.r;
                         output_layer.color_g  = p_operation->desc.blend.g;
                         output_layer.color_b  = p_operation->desc.blend.b;
+                        EPIC_PERF_MODEL(LVSF_PERF_EPIC_BLEND, &input_layers[1], input_layer_cnt - 1, &output_layer);
                         ret = HAL_EPIC_BlendStartEx_IT(drv_epic.using_epic, &input_layers[1], input_layer_cnt - 1, &output_layer);
                     }
                     else
                     {
+                        EPIC_PERF_MODEL(LVSF_PERF_EPIC_BLEND, input_layers, input_layer_cnt, &output_layer);
                         ret = HAL_EPIC_BlendStartEx_IT(drv_epic.using_epic, input_layers, input_layer_cnt, &output_layer);
                     }
                     RT_ASSERT(HAL_OK == ret);
@@ -2559,6 +2721,7 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
 
                         memcpy(&input_layers[0], dst, sizeof(EPIC_LayerConfigTypeDef));
                         if (&drv_epic.epic_handle2 != drv_epic.using_epic) render_lock(DRV_EPIC_COLOR_FILL, fg_addr, bg_addr, mask_addr);
+                        EPIC_PERF_MODEL(LVSF_PERF_EPIC_FILL, input_layers, 3, &output_layer);
                         ret = HAL_EPIC_BlendStartEx_IT(drv_epic.using_epic, input_layers, 3, &output_layer);
                     }
                     else if (p_operation->desc.fill.opa != 255)
@@ -2569,11 +2732,13 @@ static rt_err_t render(drv_epic_render_list_t list, drv_epic_render_cb cb)
                         input_layer.alpha = (0 == opa) ? 255 : (256 - opa);
 
                         output_layer.color_en = true;
+                        EPIC_PERF_MODEL(LVSF_PERF_EPIC_FILL, &input_layer, 1, &output_layer);
                         ret = HAL_EPIC_BlendStartEx_IT(drv_epic.using_epic, &input_layer, 1, &output_layer);
                     }
                     else
                     {
                         output_layer.color_en = true;
+                        EPIC_PERF_MODEL(LVSF_PERF_EPIC_FILL, NULL, 0, &output_layer);
                         ret = HAL_EPIC_BlendStartEx_IT(drv_epic.using_epic, NULL, 0, &output_layer);
                     }
                     RT_ASSERT(HAL_OK == ret);
@@ -2938,6 +3103,135 @@ static bool AreaExcept(EPIC_AreaTypeDef *res_p, const EPIC_AreaTypeDef *aex_p, c
     return false;
 }
 
+static void cmd_buf_record_op(drv_epic_cmd_buf_t *cmd_buf, const drv_epic_operation *op)
+{
+    drv_epic_operation *rec_op;
+
+    if (cmd_buf->overflow) return;
+
+    if (cmd_buf->op_cnt >= cmd_buf->op_max)
+    {
+        cmd_buf->overflow = 1;
+        return;
+    }
+
+    rec_op = &cmd_buf->ops[cmd_buf->op_cnt];
+    memcpy(rec_op, op, sizeof(drv_epic_operation));
+    //Record before moving to the dst buf, offset is got again at replaying
+    rec_op->offset_x = 0;
+    rec_op->offset_y = 0;
+
+    if (DRV_EPIC_LETTER_BLEND == op->op)
+    {
+        uint32_t letter_num = op->desc.label.letter_num;
+
+        if (cmd_buf->letter_cnt + letter_num > cmd_buf->letter_max)
+        {
+            cmd_buf->overflow = 1;
+            return;
+        }
+
+        rec_op->desc.label.p_letters = &cmd_buf->letters[cmd_buf->letter_cnt];
+        if (letter_num > 0)
+            memcpy(rec_op->desc.label.p_letters, op->desc.label.p_letters, letter_num * sizeof(drv_epic_letter_type_t));
+        cmd_buf->letter_cnt += letter_num;
+    }
+
+    cmd_buf->op_cnt++;
+}
+
+void drv_epic_cmd_buf_init(drv_epic_cmd_buf_t *cmd_buf,
+                           drv_epic_operation *ops, uint16_t op_max,
+                           drv_epic_letter_type_t *letters, uint16_t letter_max)
+{
+    RT_ASSERT(cmd_buf);
+    RT_ASSERT(ops);
+
+    memset(cmd_buf, 0, sizeof(drv_epic_cmd_buf_t));
+    cmd_buf->ops = ops;
+    cmd_buf->op_max = op_max;
+    cmd_buf->letters = letters;
+    cmd_buf->letter_max = letters ? letter_max : 0;
+}
+
+rt_err_t drv_epic_cmd_buf_record_start(drv_epic_cmd_buf_t *cmd_buf)
+{
+    RT_ASSERT(cmd_buf);
+
+    if (drv_epic.recording_cb) return -RT_EBUSY;
+
+    cmd_buf->op_cnt = 0;
+    cmd_buf->letter_cnt = 0;
+    cmd_buf->overflow = 0;
+    drv_epic.recording_cb = cmd_buf;
+
+    return RT_EOK;
+}
+
+rt_err_t drv_epic_cmd_buf_record_stop(drv_epic_cmd_buf_t *cmd_buf)
+{
+    RT_ASSERT(cmd_buf == drv_epic.recording_cb);
+
+    drv_epic.recording_cb = NULL;
+
+    if (cmd_buf->overflow)
+    {
+        LOG_W("cmd_buf %p overflow, ops=%d/%d letters=%d/%d", cmd_buf,
+              cmd_buf->op_cnt, cmd_buf->op_max, cmd_buf->letter_cnt, cmd_buf->letter_max);
+        return -RT_EFULL;
+    }
+
+    return RT_EOK;
+}
+
+drv_epic_operation *drv_epic_cmd_buf_get_op(drv_epic_cmd_buf_t *cmd_buf, uint16_t idx)
+{
+    if (idx >= cmd_buf->op_cnt) return NULL;
+
+    return &cmd_buf->ops[idx];
+}
+
+rt_err_t drv_epic_cmd_buf_replay(drv_epic_cmd_buf_t *cmd_buf, drv_epic_render_buf *p_buf)
+{
+    RT_ASSERT(cmd_buf);
+    RT_ASSERT(cmd_buf != drv_epic.recording_cb);
+
+    if (cmd_buf->overflow) return -RT_ERROR;
+
+    for (uint16_t i = 0; i < cmd_buf->op_cnt; i++)
+    {
+        const drv_epic_operation *rec_op = &cmd_buf->ops[i];
+        drv_epic_operation *op;
+        int16_t offset_x, offset_y;
+
+        op = drv_epic_alloc_op(p_buf);
+        if (!op) return -RT_EFULL;
+
+        offset_x = op->offset_x;
+        offset_y = op->offset_y;
+        memcpy(op, rec_op, sizeof(drv_epic_operation));
+        op->offset_x = offset_x;
+        op->offset_y = offset_y;
+
+        if (DRV_EPIC_LETTER_BLEND == rec_op->op)
+        {
+            op->desc.label.letter_num = 0;
+            op->desc.label.p_letters = NULL;
+
+            for (uint32_t j = 0; j < rec_op->desc.label.letter_num; j++)
+            {
+                drv_epic_letter_type_t *p_letter = drv_epic_op_alloc_letter(op);
+
+                memcpy(p_letter, &rec_op->desc.label.p_letters[j], sizeof(drv_epic_letter_type_t));
+            }
+        }
+
+        drv_epic_commit_op(op);
+    }
+
+    return RT_EOK;
+}
+
 drv_epic_render_list_t drv_epic_alloc_render_list(drv_epic_render_buf *p_buf, EPIC_AreaTypeDef *p_ow_area)
 {
     priv_render_list_t *rl_overwrite = NULL;
@@ -3123,6 +3417,8 @@ rt_err_t drv_epic_commit_op(drv_epic_operation *op)
     RT_ASSERT(rl);
     RT_ASSERT(0 == (rl->flag & (rl_flag_rendering)));
 
+    if (drv_epic.recording_cb) cmd_buf_record_op(drv_epic.recording_cb, op);
+
     HAL_EPIC_AreaMove(&op->clip_area, op->offset_x, op->offset_y);
 
 
@@ -194,6 +194,24 @@ typedef struct
 } drv_epic_render_draw_cfg;
 
 
+/**
+ * Recorded operation list.
+ * Operations committed between drv_epic_cmd_buf_record_start/stop are copied
+ * here, and can be replayed to later render lists without rebuilding them.
+ * Storage is provided by caller.
+ */
+typedef struct
+{
+    drv_epic_operation *ops;
+    uint16_t op_max;
+    uint16_t op_cnt;
+    drv_epic_letter_type_t *letters;
+    uint16_t letter_max;
+    uint16_t letter_cnt;
+    uint8_t overflow;
+} drv_epic_cmd_buf_t;
+
+
 typedef struct
 {
     EPIC_MsgIdDef id;
@@ -222,6 +240,34 @@ rt_err_t drv_epic_commit_op(drv_epic_operation *op);
 rt_err_t drv_epic_render_draw_commit(drv_epic_render_draw_cfg *cfg);
 
 
+void drv_epic_cmd_buf_init(drv_epic_cmd_buf_t *cmd_buf,
+                           drv_epic_operation *ops, uint16_t op_max,
+                           drv_epic_letter_type_t *letters, uint16_t letter_max);
+/**
+ * @brief Start copying committed operations of current render list to cmd_buf
+ * @param cmd_buf  buffer to record, previous content is dropped
+ * @return RT_EOK if started, -RT_EBUSY if another buffer is recording
+ */
+rt_err_t drv_epic_cmd_buf_record_start(drv_epic_cmd_buf_t *cmd_buf);
+/**
+ * @brief Stop recording
+ * @return RT_EOK, or -RT_EFULL if cmd_buf was too small and can't be replayed
+ */
+rt_err_t drv_epic_cmd_buf_record_stop(drv_epic_cmd_buf_t *cmd_buf);
+/**
+ * @brief Get recorded operation to patch parameters (e.g. rotation angle) before replay
+ * @return NULL if idx out of range
+ */
+drv_epic_operation *drv_epic_cmd_buf_get_op(drv_epic_cmd_buf_t *cmd_buf, uint16_t idx);
+/**
+ * @brief Append all recorded operations to the render list allocated last
+ * @param cmd_buf  recorded buffer
+ * @param p_buf    same parameter as drv_epic_alloc_op
+ * @return RT_EOK, -RT_EFULL if render list is full, -RT_ERROR if cmd_buf is invalid
+ */
+rt_err_t drv_epic_cmd_buf_replay(drv_epic_cmd_buf_t *cmd_buf, drv_epic_render_buf *p_buf);
+
+
 #endif /* DRV_EPIC_NEW_API */
 
 
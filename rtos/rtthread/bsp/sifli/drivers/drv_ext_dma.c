@@ -47,6 +47,7 @@
 
 #include <rtthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "drv_ext_dma.h"
 #include "bf0_hal_ext_dma.h"
@@ -62,6 +63,16 @@ rt_sem_t ExtDma_sema = NULL;
 static void EXT_DMA_CPLT_CB(EXT_DMA_HandleTypeDef *_hdma);
 static void EXT_DMA_ERR_CB(EXT_DMA_HandleTypeDef *_hdma);
 
+#ifdef BSP_EXT_DMA_QUEUE
+static rt_list_t ext_dma_queue = RT_LIST_OBJECT_INIT(ext_dma_queue);
+/* request owning EXT_DMA, lock is held by queue while it is set */
+static EXT_DMA_ReqTypeDef *ext_dma_cur;
+static uint8_t ext_dma_cur_err;
+static EXT_DMA_QueueStatTypeDef ext_dma_stat;
+
+static void EXT_DMA_QueueStart(EXT_DMA_ReqTypeDef *req);
+#endif /* BSP_EXT_DMA_QUEUE */
+
 
 static int EXT_DMA_Init(void)
 {
@@ -88,8 +99,33 @@ static void EXT_DMA_Unlock(void)
     RT_ASSERT(ExtDma_sema != NULL);
 
     rt_err_t err;
+#ifdef BSP_EXT_DMA_QUEUE
+    rt_base_t level;
+    EXT_DMA_ReqTypeDef *req = NULL;
+
+    /* Hand lock over to next queued request unless a legacy user is waiting,
+       queue is resumed when that user unlocks. */
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&ExtDma_sema->parent.suspend_thread) && !rt_list_isempty(&ext_dma_queue))
+    {
+        req = rt_list_entry(ext_dma_queue.next, EXT_DMA_ReqTypeDef, node);
+        rt_list_remove(&req->node);
+        ext_dma_cur = req;
+        ext_dma_stat.depth--;
+    }
+    else
+    {
+        err = rt_sem_release(ExtDma_sema);
+        RT_ASSERT(RT_EOK == err);
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (req)
+        EXT_DMA_QueueStart(req);
+#else
     err = rt_sem_release(ExtDma_sema);
     RT_ASSERT(RT_EOK == err);
+#endif /* BSP_EXT_DMA_QUEUE */
 }
 
 /**
@@ -239,6 +275,24 @@ static void EXT_DMA_CPLT_CB(EXT_DMA_HandleTypeDef *_hdma)
     rt_pm_hw_device_stop();
 #endif  /* RT_USING_PM */
 
+#ifdef BSP_EXT_DMA_QUEUE
+    if (ext_dma_cur)
+    {
+        EXT_DMA_ReqTypeDef *req = ext_dma_cur;
+        rt_err_t result = ext_dma_cur_err ? -RT_EIO : RT_EOK;
+
+        ext_dma_cur = NULL;
+        ext_dma_cur_err = 0;
+        mpu_dcache_invalidate((void *)req->xfer_dst, req->xfer_words * 4);
+        if (result != RT_EOK)
+            ext_dma_stat.error++;
+        if (req->cb)
+            req->cb(req, result);
+        EXT_DMA_Unlock();
+        return;
+    }
+#endif /* BSP_EXT_DMA_QUEUE */
+
     if (full_cb)
         full_cb();
 
@@ -251,10 +305,244 @@ static void EXT_DMA_ERR_CB(EXT_DMA_HandleTypeDef *_hdma)
     rt_pm_release(PM_SLEEP_MODE_IDLE);
     rt_pm_hw_device_stop();
 #endif  /* RT_USING_PM */
+#ifdef BSP_EXT_DMA_QUEUE
+    if (ext_dma_cur)
+    {
+        ext_dma_cur_err = 1;
+        return;
+    }
+#endif /* BSP_EXT_DMA_QUEUE */
     if (err_cb)
         err_cb();
 }
 
+#ifdef BSP_EXT_DMA_QUEUE
+static void EXT_DMA_CpuDo(EXT_DMA_ReqTypeDef *req, uint32_t offset, uint32_t len)
+{
+    if (len == 0)
+        return;
+    if (EXT_DMA_OP_SET == req->op)
+        memset((uint8_t *)req->dst + offset, req->value, len);
+    else
+        memcpy((uint8_t *)req->dst + offset, (const uint8_t *)req->src + offset, len);
+}
+
+/* Called with lock held by queue, in thread or interrupt */
+static void EXT_DMA_QueueStart(EXT_DMA_ReqTypeDef *req)
+{
+    HAL_StatusTypeDef res;
+    uint32_t src;
+
+    if (EXT_DMA_OP_SET == req->op)
+    {
+        /* read same pattern word for all destination words */
+        src = (uint32_t)&req->pattern;
+        gExtDma.Init.SrcInc = HAL_EXT_DMA_SRC_BURST1;
+    }
+    else
+    {
+        src = (uint32_t)req->src + (req->xfer_dst - (uint32_t)req->dst);
+        gExtDma.Init.SrcInc = HAL_EXT_DMA_SRC_INC | HAL_EXT_DMA_SRC_BURST16;
+    }
+    gExtDma.Init.DstInc = HAL_EXT_DMA_DST_INC | HAL_EXT_DMA_DST_BURST16;
+    gExtDma.Init.cmpr_en = false;
+
+#ifdef RT_USING_PM
+    rt_pm_request(PM_SLEEP_MODE_IDLE);
+    rt_pm_hw_device_start();
+#endif  /* RT_USING_PM */
+
+    HAL_RCC_ResetModule(RCC_MOD_EXTDMA);
+    res = HAL_EXT_DMA_Init(&gExtDma);
+    if (HAL_OK == res)
+    {
+        HAL_NVIC_SetPriority(EXTDMA_IRQn, 0, 0);
+        HAL_NVIC_EnableIRQ(EXTDMA_IRQn);
+        HAL_EXT_DMA_RegisterCallback(&gExtDma, HAL_EXT_DMA_XFER_CPLT_CB_ID, EXT_DMA_CPLT_CB);
+        HAL_EXT_DMA_RegisterCallback(&gExtDma, HAL_EXT_DMA_XFER_ERROR_CB_ID, EXT_DMA_ERR_CB);
+        res = HAL_EXT_DMA_Start_IT(&gExtDma, src, req->xfer_dst, req->xfer_words);
+    }
+    if (HAL_OK != res)
+    {
+        /* complete as error, next request is started by unlock */
+        EXT_DMA_ERR_CB(&gExtDma);
+        EXT_DMA_CPLT_CB(&gExtDma);
+    }
+}
+
+rt_err_t EXT_DMA_Submit(EXT_DMA_ReqTypeDef *req)
+{
+    uint32_t head, tail;
+    rt_base_t level;
+    int start = 0;
+
+    if (!req || !req->dst || (EXT_DMA_OP_COPY == req->op && !req->src) || req->op > EXT_DMA_OP_SET)
+        return -RT_EINVAL;
+    if (ExtDma_sema == NULL)
+        return -RT_ERROR;
+
+    head = (4 - ((uint32_t)req->dst & 3)) & 3;
+    if ((req->len < EXT_DMA_CPU_THRESHOLD) || (req->len < head + 4)
+            || (EXT_DMA_OP_COPY == req->op && (((uint32_t)req->src ^ (uint32_t)req->dst) & 3)))
+    {
+        /* small or misaligned source and destination, CPU is faster */
+        EXT_DMA_CpuDo(req, 0, req->len);
+        level = rt_hw_interrupt_disable();
+        ext_dma_stat.cpu_num++;
+        ext_dma_stat.cpu_bytes += req->len;
+        rt_hw_interrupt_enable(level);
+        if (req->cb)
+            req->cb(req, RT_EOK);
+        return RT_EOK;
+    }
+
+    /* unaligned head and tail bytes are done by CPU now, the word aligned body by DMA */
+    req->xfer_dst = (uint32_t)req->dst + head;
+    req->xfer_words = (req->len - head) >> 2;
+    tail = (req->len - head) & 3;
+    EXT_DMA_CpuDo(req, 0, head);
+    EXT_DMA_CpuDo(req, req->len - tail, tail);
+
+    if (EXT_DMA_OP_SET == req->op)
+    {
+        req->pattern = req->value * 0x01010101UL;
+        mpu_dcache_clean(&req->pattern, sizeof(req->pattern));
+    }
+    else
+    {
+        mpu_dcache_clean((void *)req->src, req->len);
+    }
+    /* write back head/tail and any dirty line before DMA overwrites memory */
+    mpu_dcache_clean(req->dst, req->len);
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&ext_dma_queue, &req->node);
+    ext_dma_stat.dma_num++;
+    ext_dma_stat.dma_bytes += req->len;
+    if (++ext_dma_stat.depth > ext_dma_stat.max_depth)
+        ext_dma_stat.max_depth = ext_dma_stat.depth;
+    /* idle EXT_DMA, take it for queue, otherwise request is started by unlock of current owner */
+    if (RT_EOK == rt_sem_take(ExtDma_sema, 0))
+    {
+        req = rt_list_entry(ext_dma_queue.next, EXT_DMA_ReqTypeDef, node);
+        rt_list_remove(&req->node);
+        ext_dma_cur = req;
+        ext_dma_stat.depth--;
+        start = 1;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (start)
+        EXT_DMA_QueueStart(req);
+
+    return RT_EOK;
+}
+
+void EXT_DMA_GetQueueStat(EXT_DMA_QueueStatTypeDef *stat, rt_bool_t reset)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (stat)
+        *stat = ext_dma_stat;
+    if (reset)
+    {
+        uint32_t depth = ext_dma_stat.depth;
+
+        memset(&ext_dma_stat, 0, sizeof(ext_dma_stat));
+        ext_dma_stat.depth = depth;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+#ifdef RT_USING_FINSH
+#define EXT_DMA_BENCH_REQ_NUM   (4)
+
+static struct rt_semaphore ext_dma_bench_sem;
+
+static void ext_dma_bench_cb(EXT_DMA_ReqTypeDef *req, rt_err_t result)
+{
+    rt_sem_release(&ext_dma_bench_sem);
+}
+
+static uint32_t ext_dma_elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+/* Compare CPU memcpy with queued EXT_DMA copy, and CPU time left while DMA runs */
+static int edma_queue(int argc, char **argv)
+{
+    static EXT_DMA_ReqTypeDef req[EXT_DMA_BENCH_REQ_NUM];
+    EXT_DMA_QueueStatTypeDef stat;
+    uint32_t size, i, start, cpu_us, dma_us, spin;
+    uint8_t *src, *dst;
+
+    if (argc < 2 || strcmp(argv[1], "stat") == 0)
+    {
+        EXT_DMA_GetQueueStat(&stat, argc > 2);
+        rt_kprintf("dma: %d req %d bytes, cpu: %d req %d bytes\n", stat.dma_num, (uint32_t)stat.dma_bytes,
+                   stat.cpu_num, (uint32_t)stat.cpu_bytes);
+        rt_kprintf("error %d, depth %d, max depth %d\n", stat.error, stat.depth, stat.max_depth);
+        rt_kprintf("edma_queue bench <size> | stat [reset]\n");
+        return 0;
+    }
+    if (strcmp(argv[1], "bench") != 0 || argc < 3)
+        return -1;
+
+    size = atoi(argv[2]);
+    src = rt_malloc_align(size, 32);
+    dst = rt_malloc_align(size, 32);
+    if (!src || !dst || size < EXT_DMA_BENCH_REQ_NUM)
+    {
+        rt_kprintf("no memory\n");
+        goto __EXIT;
+    }
+    for (i = 0; i < size; i++)
+        src[i] = (uint8_t)i;
+
+    start = HAL_GTIMER_READ();
+    memcpy(dst, src, size);
+    cpu_us = ext_dma_elapsed_us(start);
+
+    memset(dst, 0, size);
+    rt_sem_init(&ext_dma_bench_sem, "edma_b", 0, RT_IPC_FLAG_FIFO);
+    start = HAL_GTIMER_READ();
+    for (i = 0; i < EXT_DMA_BENCH_REQ_NUM; i++)
+    {
+        req[i].src = src + size / EXT_DMA_BENCH_REQ_NUM * i;
+        req[i].dst = dst + size / EXT_DMA_BENCH_REQ_NUM * i;
+        req[i].len = (i == EXT_DMA_BENCH_REQ_NUM - 1) ? size - size / EXT_DMA_BENCH_REQ_NUM * i : size / EXT_DMA_BENCH_REQ_NUM;
+        req[i].op = EXT_DMA_OP_COPY;
+        req[i].cb = ext_dma_bench_cb;
+        EXT_DMA_Submit(&req[i]);
+    }
+    /* CPU is free while queue drains */
+    spin = 0;
+    for (i = 0; i < EXT_DMA_BENCH_REQ_NUM;)
+    {
+        if (RT_EOK == rt_sem_trytake(&ext_dma_bench_sem))
+            i++;
+        else
+            spin++;
+    }
+    dma_us = ext_dma_elapsed_us(start);
+    rt_sem_detach(&ext_dma_bench_sem);
+
+    rt_kprintf("%d bytes: cpu %d us, dma %d us in %d requests, %d idle loops, %s\n", size, cpu_us, dma_us,
+               EXT_DMA_BENCH_REQ_NUM, spin, memcmp(src, dst, size) ? "mismatch" : "ok");
+
+__EXIT:
+    if (src)
+        rt_free_align(src);
+    if (dst)
+        rt_free_align(dst);
+    return 0;
+}
+MSH_CMD_EXPORT(edma_queue, EXT_DMA queue statistics and benchmark);
+#endif /* RT_USING_FINSH */
+#endif /* BSP_EXT_DMA_QUEUE */
+
 
 INIT_BOARD_EXPORT(EXT_DMA_Init);
 
@@ -112,6 +112,70 @@ rt_err_t EXT_DMA_TRANS_SYNC(uint32_t src, uint32_t dst, uint32_t len, uint32_t t
 
 void EXT_DMA_Wait_ASYNC_Done(void);
 
+#ifdef BSP_EXT_DMA_QUEUE
+/** Requests shorter than this are done by CPU in EXT_DMA_Submit() */
+#ifndef EXT_DMA_CPU_THRESHOLD
+#define EXT_DMA_CPU_THRESHOLD   (256)
+#endif
+
+#define EXT_DMA_OP_COPY         (0)
+#define EXT_DMA_OP_SET          (1)
+
+typedef struct EXT_DMA_Req EXT_DMA_ReqTypeDef;
+
+/**
+ * @brief Completion callback of queued request, called in EXT_DMA interrupt,
+ *        or in EXT_DMA_Submit() if request is done by CPU.
+ * @param[in] req request done, could be submitted again in callback
+ * @param[in] result RT_EOK, or -RT_EIO if EXT_DMA reports error
+ */
+typedef void (*EXT_DMA_ReqCallback)(EXT_DMA_ReqTypeDef *req, rt_err_t result);
+
+/** Queued copy/fill request, owned by caller and must be kept until callback */
+struct EXT_DMA_Req
+{
+    rt_list_t node;             /**< private */
+    void *dst;
+    const void *src;            /**< source of EXT_DMA_OP_COPY */
+    uint32_t len;               /**< in bytes */
+    uint8_t op;                 /**< EXT_DMA_OP_COPY or EXT_DMA_OP_SET */
+    uint8_t value;              /**< fill byte of EXT_DMA_OP_SET */
+    EXT_DMA_ReqCallback cb;
+    void *user_data;
+    uint32_t pattern;           /**< private */
+    uint32_t xfer_dst;          /**< private */
+    uint32_t xfer_words;        /**< private */
+};
+
+typedef struct
+{
+    uint32_t dma_num;           /**< requests done by EXT_DMA */
+    uint64_t dma_bytes;
+    uint32_t cpu_num;           /**< requests done by CPU, below threshold or misaligned */
+    uint64_t cpu_bytes;
+    uint32_t error;
+    uint32_t depth;             /**< requests waiting in queue */
+    uint32_t max_depth;
+} EXT_DMA_QueueStatTypeDef;
+
+/**
+ * @brief Queue memcpy/memset request, could be called in interrupt.
+ *        Cache of source is cleaned and destination is invalidated by driver.
+ *        Requests share EXT_DMA with legacy API, waiting legacy users are served first.
+ *        Copy with source and destination of different word alignment is done by CPU.
+ * @param[in] req request
+ * @return RT_EOK if queued or done
+ */
+rt_err_t EXT_DMA_Submit(EXT_DMA_ReqTypeDef *req);
+
+/**
+ * @brief Get queue statistics
+ * @param[out] stat statistics, could be NULL
+ * @param[in] reset clear statistics after read
+ */
+void EXT_DMA_GetQueueStat(EXT_DMA_QueueStatTypeDef *stat, rt_bool_t reset);
+#endif /* BSP_EXT_DMA_QUEUE */
+
 /// @} drv_dma
 /// @} bsp_driver
 
@@ -67,6 +67,24 @@ extern "C" {
 
 //#define BSP_USING_BBM
 
+/* Suspend NOR erase every NOR_ERASE_SLICE_US to let XIP code and interrupt run for NOR_ERASE_RESUME_MS */
+//#define BSP_USING_NOR_ERASE_SUSPEND
+#ifndef NOR_ERASE_SLICE_US
+    #define NOR_ERASE_SLICE_US              (2000)
+#endif
+#ifndef NOR_ERASE_RESUME_MS
+    #define NOR_ERASE_RESUME_MS             (1)
+#endif
+
+/* Erase in background thread by rt_flash_erase_async */
+//#define BSP_USING_FLASH_ERASE_ASYNC
+#ifndef FLASH_ERASE_THREAD_PRIORITY
+    #define FLASH_ERASE_THREAD_PRIORITY     RT_THREAD_PRIORITY_LOW
+#endif
+#ifndef FLASH_ERASE_THREAD_STACK_SIZE
+    #define FLASH_ERASE_THREAD_STACK_SIZE   (1024)
+#endif
+
 /************type define ***********************/
 
 typedef enum
@@ -117,6 +135,24 @@ int rt_flash_write(uint32_t addr, const uint8_t *buf, int size);
  */
 int rt_flash_erase(uint32_t addr, int size);
 
+/**
+ * @brief Callback of rt_flash_erase_async, called in erase thread.
+ * @param[in] result: RT_EOK if success.
+ */
+typedef void (*rt_flash_erase_cb_t)(uint32_t addr, int size, int result, void *user_data);
+
+/**
+ * @brief Queue flash erase to background thread and return immediately.
+ * @note Requests are done in order, address and size have same alignment request as rt_flash_erase.
+ *       Caller should not access the erasing range before callback.
+ * @param[in] addr: phy start address to erase.
+ * @param[in] size: erase memory size, in bytes.
+ * @param[in] cb: function called after erase done, could be NULL.
+ * @param[in] user_data: parameter for cb.
+ * @return RT_EOK if queued.
+ */
+int rt_flash_erase_async(uint32_t addr, int size, rt_flash_erase_cb_t cb, void *user_data);
+
 //#ifdef SOC_BF_Z0
 
 /**
@@ -321,6 +357,26 @@ int rt_nand_read_page(uint32_t addr, uint8_t *data, int size, uint8_t *spare, in
 */
 int rt_nand_write_page(uint32_t addr, const uint8_t *buf, int size, const uint8_t *spare, int spare_len);
 
+/**
+* @brief  Read continuous nand pages without oob.
+* @note   With BSP_NAND_USING_CACHE_READ, cache read sequential is used to overlap
+*         array load of next page with data out of current page.
+* @param[in]  addr, page aligned flash address.
+* @param[out]  data, output data buffer.
+* @param[in]  size, data size, should be multiple of page size.
+* @retval read data size, less than size if read fail at some page.
+*/
+int rt_nand_read_pages(uint32_t addr, uint8_t *data, int size);
+
+/**
+* @brief  Write continuous nand pages without oob.
+* @param[in]  addr, page aligned flash address.
+* @param[in]  buf, input data buffer.
+* @param[in]  size, data size, should be multiple of page size.
+* @retval written data size, less than size if write fail at some page.
+*/
+int rt_nand_write_pages(uint32_t addr, const uint8_t *buf, int size);
+
 /**
 * @brief  Erase nand flash block.
 * @param[in]  addr, flash address need to erase.
@@ -370,6 +426,8 @@ int rt_nand_init(void);
 #define rt_nand_erase(addr,size) 0
 #define rt_nand_read_page(addr,data,size,spare,spare_len) 0
 #define rt_nand_write_page(addr,buf,size,spare,spare_len) 0
+#define rt_nand_read_pages(addr,data,size) 0
+#define rt_nand_write_pages(addr,buf,size) 0
 #define rt_nand_erase_block(addr) 0
 #define rt_nand_get_total_size(addr) 0
 #define rt_nand_init() 0
@@ -72,6 +72,14 @@
     #define LXT_LP_CYCLE 200
 #endif
 
+#ifdef BSP_USING_IRQ_LATENCY
+    #include "drv_irq_latency.h"
+    /* Sample counter before anything else, it is the latency since update event */
+    #define HWTIMER_LATENCY_SAMPLE(index)   irq_latency_timer_sample(&bf0_hwtimer_obj[index].tim_handle)
+#else
+    #define HWTIMER_LATENCY_SAMPLE(index)
+#endif
+
 #if defined(RT_USING_HWTIMER) || defined(_SIFLI_DOXYGEN_)
 
 
@@ -696,6 +704,7 @@ static rt_uint32_t lp_timer_counter_get(rt_hwtimer_t *timer)
   */
 void ATIM1_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(ATIM1_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[ATIM1_INDEX].tim_handle);
@@ -710,6 +719,7 @@ void ATIM1_IRQHandler(void)
   */
 void ATIM2_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(ATIM2_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[ATIM2_INDEX].tim_handle);
@@ -724,6 +734,7 @@ void ATIM2_IRQHandler(void)
   */
 void GPTIM1_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(GPTIM1_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[GPTIM1_INDEX].tim_handle);
@@ -738,6 +749,7 @@ void GPTIM1_IRQHandler(void)
   */
 void GPTIM2_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(GPTIM2_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[GPTIM2_INDEX].tim_handle);
@@ -752,6 +764,7 @@ void GPTIM2_IRQHandler(void)
   */
 void GPTIM3_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(GPTIM3_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[GPTIM3_INDEX].tim_handle);
@@ -766,6 +779,7 @@ void GPTIM3_IRQHandler(void)
   */
 void GPTIM4_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(GPTIM4_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[GPTIM4_INDEX].tim_handle);
@@ -780,6 +794,7 @@ void GPTIM4_IRQHandler(void)
   */
 void GPTIM5_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(GPTIM5_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[GPTIM5_INDEX].tim_handle);
@@ -792,6 +807,7 @@ void GPTIM5_IRQHandler(void)
 #if defined(BSP_USING_BTIM1) || defined(_SIFLI_DOXYGEN_)
 void BTIM1_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(BTIM1_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[BTIM1_INDEX].tim_handle);
@@ -803,6 +819,7 @@ void BTIM1_IRQHandler(void)
 #if defined(BSP_USING_BTIM2) || defined(_SIFLI_DOXYGEN_)
 void BTIM2_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(BTIM2_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[BTIM2_INDEX].tim_handle);
@@ -814,6 +831,7 @@ void BTIM2_IRQHandler(void)
 #if defined(BSP_USING_BTIM3) || defined(_SIFLI_DOXYGEN_)
 void BTIM3_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(BTIM3_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[BTIM3_INDEX].tim_handle);
@@ -825,6 +843,7 @@ void BTIM3_IRQHandler(void)
 #if defined(BSP_USING_BTIM4) || defined(_SIFLI_DOXYGEN_)
 void BTIM4_IRQHandler(void)
 {
+    HWTIMER_LATENCY_SAMPLE(BTIM4_INDEX);
     /* enter interrupt */
     rt_interrupt_enter();
     HAL_GPT_IRQHandler(&bf0_hwtimer_obj[BTIM4_INDEX].tim_handle);
@@ -0,0 +1,437 @@
+/**
+  ******************************************************************************
+  * @file   drv_hwtimer_sched.c
+  * @author Sifli software development team
+  * @brief High resolution event scheduler on one hardware timer
+  *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <rtdevice.h>
+#include "bf0_hal_tim.h"
+#include "drv_hwtimer_sched.h"
+
+#define DBG_TAG "hwt_sched"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+enum
+{
+    SCHED_IDLE,         /* hardware timer stopped, time runs on GTIMER */
+    SCHED_NEAR,         /* hardware timer running */
+    SCHED_FAR,          /* OS timer running, deep sleep allowed */
+};
+
+static rt_hwtimer_t *sched_timer;
+static GPT_HandleTypeDef *sched_tim;
+static uint32_t sched_freq;
+static uint32_t sched_gt_freq;
+static uint8_t sched_mode;
+static uint8_t sched_pm_held;
+/* Time of start of current shot or GTIMER measurement */
+static uint64_t sched_base_us;
+static uint32_t sched_gt0;
+static uint32_t sched_shot;
+static hwtimer_sched_event_t *sched_head;
+static struct rt_timer sched_os_timer;
+static hwtimer_sched_stat_t sched_stat;
+
+static void sched_pm_hold(bool hold)
+{
+#ifdef RT_USING_PM
+    if (hold && !sched_pm_held)
+        rt_pm_request(PM_SLEEP_MODE_IDLE);
+    else if (!hold && sched_pm_held)
+        rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif
+    sched_pm_held = hold;
+}
+
+static uint32_t sched_gt_elapsed_us(void)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - sched_gt0) * 1000000 / sched_gt_freq);
+}
+
+/* Counter of current shot, shot length if it has expired but ISR is not handled yet */
+static uint32_t sched_shot_count(void)
+{
+    if (__HAL_GPT_GET_FLAG(sched_tim, GPT_FLAG_UPDATE))
+        return sched_shot;
+    return sched_timer->ops->count_get(sched_timer);
+}
+
+/* Called with interrupt disabled */
+static uint64_t sched_now(void)
+{
+    if (SCHED_NEAR == sched_mode)
+        return sched_base_us + (uint64_t)sched_shot_count() * 1000000 / sched_freq;
+    return sched_base_us + sched_gt_elapsed_us();
+}
+
+/* Stop timers and move base to now, called with interrupt disabled */
+static void sched_sync(bool expired)
+{
+    uint32_t cnt, us;
+
+    if (SCHED_NEAR == sched_mode)
+    {
+        if (expired)
+        {
+            cnt = sched_shot;
+        }
+        else
+        {
+            sched_timer->ops->stop(sched_timer);
+            cnt = sched_shot_count();
+            /* ISR of the shot is not needed any more */
+            __HAL_GPT_CLEAR_FLAG(sched_tim, GPT_FLAG_UPDATE);
+        }
+        sched_base_us += (uint64_t)cnt * 1000000 / sched_freq;
+        sched_gt0 = HAL_GTIMER_READ();
+    }
+    else
+    {
+        if (SCHED_FAR == sched_mode)
+            rt_timer_stop(&sched_os_timer);
+        us = sched_gt_elapsed_us();
+        sched_base_us += us;
+        /* keep the fraction for next measurement */
+        sched_gt0 += (uint32_t)((uint64_t)us * sched_gt_freq / 1000000);
+    }
+    sched_mode = SCHED_IDLE;
+}
+
+/* Start timer for the first event, called with interrupt disabled after sched_sync() */
+static void sched_arm(void)
+{
+    uint64_t delta;
+    rt_tick_t tick;
+    uint32_t cnt;
+
+    if (!sched_head)
+    {
+        sched_pm_hold(false);
+        return;
+    }
+
+    delta = (sched_head->expire_us > sched_base_us) ? (sched_head->expire_us - sched_base_us) : 0;
+    if (delta > HWTIMER_SCHED_WAKEUP_US + HWTIMER_SCHED_NEAR_US)
+    {
+        /* Sleep until wakeup latency before expiry, hardware timer does the rest */
+        tick = rt_tick_from_millisecond((rt_int32_t)((delta - HWTIMER_SCHED_WAKEUP_US - HWTIMER_SCHED_NEAR_US) / 1000));
+        if (tick > 0)
+        {
+            sched_pm_hold(false);
+            rt_timer_control(&sched_os_timer, RT_TIMER_CTRL_SET_TIME, &tick);
+            rt_timer_start(&sched_os_timer);
+            sched_mode = SCHED_FAR;
+            return;
+        }
+    }
+
+    sched_pm_hold(true);
+    delta = delta * sched_freq / 1000000;
+    cnt = (delta > sched_timer->info->maxcnt) ? sched_timer->info->maxcnt : (uint32_t)delta;
+    /* Update event is at counter == ARR, i.e. after ARR + 1 counts */
+    if (cnt < 2)
+        cnt = 2;
+    __HAL_GPT_SET_COUNTER(sched_tim, 0);
+    sched_timer->cycles = 1;
+    sched_timer->reload = 1;
+    sched_timer->overflow = 0;
+    sched_timer->ops->start(sched_timer, cnt - 1, HWTIMER_MODE_ONESHOT);
+    sched_shot = cnt;
+    sched_mode = SCHED_NEAR;
+    sched_stat.shots++;
+}
+
+static void sched_insert(hwtimer_sched_event_t *ev)
+{
+    hwtimer_sched_event_t **p = &sched_head;
+
+    while (*p && (*p)->expire_us <= ev->expire_us)
+        p = &(*p)->next;
+    ev->next = *p;
+    *p = ev;
+}
+
+static void sched_remove(hwtimer_sched_event_t *ev)
+{
+    hwtimer_sched_event_t **p = &sched_head;
+
+    while (*p && *p != ev)
+        p = &(*p)->next;
+    if (*p)
+        *p = ev->next;
+    ev->next = NULL;
+}
+
+static void sched_process(bool hw_expired)
+{
+    hwtimer_sched_event_t *fire = NULL, **tail = &fire, *ev, *next;
+    rt_base_t level;
+    uint64_t late;
+    uint32_t skip;
+
+    level = rt_hw_interrupt_disable();
+    sched_sync(hw_expired);
+    while ((ev = sched_head) && ev->expire_us <= sched_base_us)
+    {
+        sched_head = ev->next;
+        late = sched_base_us - ev->expire_us;
+        if (late > sched_stat.max_late_us)
+            sched_stat.max_late_us = (uint32_t)late;
+        sched_stat.fired++;
+        if (ev->period_us)
+        {
+            ev->expire_us += ev->period_us;
+            if (ev->expire_us <= sched_base_us)
+            {
+                skip = (uint32_t)((sched_base_us - ev->expire_us) / ev->period_us) + 1;
+                ev->expire_us += (uint64_t)skip * ev->period_us;
+                sched_stat.overrun += skip;
+            }
+            sched_insert(ev);
+        }
+        else
+        {
+            ev->next = NULL;
+            ev->active = 0;
+        }
+        ev->fire_next = NULL;
+        *tail = ev;
+        tail = &ev->fire_next;
+    }
+    sched_arm();
+    rt_hw_interrupt_enable(level);
+
+    /* Callbacks may start or stop events */
+    for (ev = fire; ev; ev = next)
+    {
+        next = ev->fire_next;
+        ev->cb(ev->arg);
+    }
+}
+
+static rt_err_t sched_hwtimer_timeout(rt_device_t dev, rt_size_t size)
+{
+    sched_process(SCHED_NEAR == sched_mode);
+    return RT_EOK;
+}
+
+static void sched_os_timeout(void *param)
+{
+    sched_stat.sleep_wakes++;
+    sched_process(false);
+}
+
+rt_err_t hwtimer_sched_init(const char *name)
+{
+    rt_device_t dev;
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_ONESHOT;
+    rt_uint32_t freq = 1000000;
+    rt_err_t err;
+
+    if (sched_timer)
+        return -RT_EBUSY;
+
+    dev = rt_device_find(name);
+    if (!dev || RT_Device_Class_Timer != dev->type)
+        return -RT_ERROR;
+    /* LPTIM keeps running in sleep, but resolution is too low */
+    if (((rt_hwtimer_t *)dev)->info->maxfreq <= 32768)
+    {
+        LOG_E("%s not supported", name);
+        return -RT_ERROR;
+    }
+
+    err = rt_device_open(dev, RT_DEVICE_OFLAG_RDWR);
+    if (RT_EOK != err)
+        return err;
+    if (RT_EOK != rt_device_control(dev, HWTIMER_CTRL_FREQ_SET, &freq))
+    {
+        freq = ((rt_hwtimer_t *)dev)->info->maxfreq;
+        rt_device_control(dev, HWTIMER_CTRL_FREQ_SET, &freq);
+    }
+    rt_device_control(dev, HWTIMER_CTRL_MODE_SET, &mode);
+    rt_device_set_rx_indicate(dev, sched_hwtimer_timeout);
+
+    rt_timer_init(&sched_os_timer, "hwt_sched", sched_os_timeout, NULL, 1,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+
+    sched_tim = (GPT_HandleTypeDef *)dev->user_data;
+    sched_freq = freq;
+    sched_gt_freq = (uint32_t)HAL_LPTIM_GetFreq();
+    sched_gt0 = HAL_GTIMER_READ();
+    sched_mode = SCHED_IDLE;
+    sched_timer = (rt_hwtimer_t *)dev;
+    LOG_I("%s freq %d", name, freq);
+
+    return RT_EOK;
+}
+
+void hwtimer_sched_event_init(hwtimer_sched_event_t *ev, hwtimer_sched_cb_t cb, void *arg)
+{
+    memset(ev, 0, sizeof(*ev));
+    ev->cb = cb;
+    ev->arg = arg;
+}
+
+rt_err_t hwtimer_sched_start(hwtimer_sched_event_t *ev, uint32_t delay_us, uint32_t period_us)
+{
+    hwtimer_sched_event_t *head;
+    rt_base_t level;
+
+    if (!sched_timer || !ev || !ev->cb)
+        return -RT_ERROR;
+
+    level = rt_hw_interrupt_disable();
+    head = sched_head;
+    if (ev->active)
+        sched_remove(ev);
+    ev->expire_us = sched_now() + delay_us;
+    ev->period_us = period_us;
+    ev->active = 1;
+    sched_insert(ev);
+    /* Timer is reprogrammed only if the first event changes */
+    if (sched_head != head || head == ev)
+    {
+        sched_sync(false);
+        sched_arm();
+    }
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+void hwtimer_sched_stop(hwtimer_sched_event_t *ev)
+{
+    rt_base_t level;
+    bool was_head;
+
+    if (!sched_timer || !ev)
+        return;
+
+    level = rt_hw_interrupt_disable();
+    if (ev->active)
+    {
+        was_head = (sched_head == ev);
+        sched_remove(ev);
+        ev->active = 0;
+        if (was_head)
+        {
+            sched_sync(false);
+            sched_arm();
+        }
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+uint64_t hwtimer_sched_now(void)
+{
+    rt_base_t level;
+    uint64_t now;
+
+    if (!sched_timer)
+        return 0;
+    level = rt_hw_interrupt_disable();
+    now = sched_now();
+    rt_hw_interrupt_enable(level);
+
+    return now;
+}
+
+void hwtimer_sched_get_stat(hwtimer_sched_stat_t *stat)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    *stat = sched_stat;
+    memset(&sched_stat, 0, sizeof(sched_stat));
+    rt_hw_interrupt_enable(level);
+}
+
+#ifdef RT_USING_FINSH
+static hwtimer_sched_event_t sched_test_ev;
+
+static void sched_test_cb(void *arg)
+{
+}
+
+static int hwtimer_sched(int argc, char **argv)
+{
+    hwtimer_sched_stat_t stat;
+    uint32_t n = 0;
+
+    if (argc >= 3 && 0 == strcmp(argv[1], "init"))
+    {
+        rt_kprintf("init %d\n", hwtimer_sched_init(argv[2]));
+    }
+    else if (argc >= 3 && 0 == strcmp(argv[1], "test"))
+    {
+        hwtimer_sched_event_init(&sched_test_ev, sched_test_cb, NULL);
+        hwtimer_sched_start(&sched_test_ev, atoi(argv[2]), argc > 3 ? atoi(argv[3]) : 0);
+    }
+    else if (argc >= 2 && 0 == strcmp(argv[1], "stop"))
+    {
+        hwtimer_sched_stop(&sched_test_ev);
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("hwtimer_sched [init <hwtimer>|test <delay_us> [period_us]|stop]\n");
+    }
+    else
+    {
+        hwtimer_sched_get_stat(&stat);
+        for (hwtimer_sched_event_t *ev = sched_head; ev; ev = ev->next)
+            n++;
+        rt_kprintf("now %d us, mode %d, %d events\n", (uint32_t)hwtimer_sched_now(), sched_mode, n);
+        rt_kprintf("fired %d, max late %d us, overrun %d, shots %d, sleep wakes %d\n", stat.fired,
+                   stat.max_late_us, stat.overrun, stat.shots, stat.sleep_wakes);
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(hwtimer_sched, Hardware timer scheduler);
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,156 @@
+/**
+  ******************************************************************************
+  * @file   drv_hwtimer_sched.h
+  * @author Sifli software development team
+  * @brief High resolution event scheduler on one hardware timer
+  * @{
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#ifndef __DRV_HWTIMER_SCHED_H_
+#define __DRV_HWTIMER_SCHED_H_
+
+#include <rtthread.h>
+#include <board.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup bsp_driver Driver IO
+  * @{
+  */
+
+/** @defgroup drv_hwtimer_sched Hardware timer scheduler
+  * @brief Many one-shot and periodic events with us resolution on one GPTIM/BTIM.
+  *
+  * - Events are provided by caller, no memory is allocated. Callback is called in ISR context.
+  * - Periodic event is rescheduled from its previous expiry, so period doesn't drift with ISR latency.
+  * - Hardware timer stops in deep sleep. Only when the next event is within
+  *   HWTIMER_SCHED_WAKEUP_US + HWTIMER_SCHED_NEAR_US, the timer runs and deep sleep is disabled.
+  *   For event further away a one-shot OS timer wakes the system up HWTIMER_SCHED_WAKEUP_US
+  *   + HWTIMER_SCHED_NEAR_US earlier and hardware timer takes over for the rest,
+  *   elapsed time in sleep is measured by GTIMER.
+  * @{
+  */
+
+#ifndef HWTIMER_SCHED_WAKEUP_US
+    #define HWTIMER_SCHED_WAKEUP_US     (2000)      /**< wake up latency from deep sleep */
+#endif
+#ifndef HWTIMER_SCHED_NEAR_US
+    #define HWTIMER_SCHED_NEAR_US       (1000)      /**< margin for OS tick and GTIMER resolution */
+#endif
+
+typedef void (*hwtimer_sched_cb_t)(void *arg);
+
+/** Event, owned by caller and must be kept valid while started */
+typedef struct hwtimer_sched_event
+{
+    struct hwtimer_sched_event *next;
+    struct hwtimer_sched_event *fire_next;
+    uint64_t expire_us;
+    uint32_t period_us;             /**< 0 for one-shot */
+    hwtimer_sched_cb_t cb;
+    void *arg;
+    uint8_t active;
+} hwtimer_sched_event_t;
+
+typedef struct
+{
+    uint32_t fired;
+    uint32_t max_late_us;           /**< max time from expiry to callback */
+    uint32_t overrun;               /**< periods skipped as callback of periodic event was too late */
+    uint32_t shots;                 /**< hardware timer start */
+    uint32_t sleep_wakes;           /**< OS timer wakeup before event */
+} hwtimer_sched_stat_t;
+
+/**
+ * @brief Bind scheduler to a hardware timer, it must not be used by others.
+ * @param name - hwtimer device name, e.g. "btim1", low power timer is not supported.
+ * @return RT_EOK if success
+ */
+rt_err_t hwtimer_sched_init(const char *name);
+
+/**
+ * @brief Initialize event.
+ * @param ev - event
+ * @param cb - callback, called in ISR
+ * @param arg - argument of callback
+ */
+void hwtimer_sched_event_init(hwtimer_sched_event_t *ev, hwtimer_sched_cb_t cb, void *arg);
+
+/**
+ * @brief Start or restart event.
+ * @param ev - event
+ * @param delay_us - time from now to first expiry
+ * @param period_us - period after first expiry, 0 for one-shot
+ * @return RT_EOK if success
+ */
+rt_err_t hwtimer_sched_start(hwtimer_sched_event_t *ev, uint32_t delay_us, uint32_t period_us);
+
+/**
+ * @brief Stop event, it can be called in callback.
+ * @param ev - event
+ */
+void hwtimer_sched_stop(hwtimer_sched_event_t *ev);
+
+/**
+ * @brief Get scheduler time.
+ * @return time in us, only difference of two values is meaningful
+ */
+uint64_t hwtimer_sched_now(void);
+
+/**
+ * @brief Get and reset statistics.
+ * @param stat - output
+ */
+void hwtimer_sched_get_stat(hwtimer_sched_stat_t *stat);
+
+/// @} drv_hwtimer_sched
+/// @} bsp_driver
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__DRV_HWTIMER_SCHED_H_ */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -1526,6 +1526,262 @@ int rt_hw_i2c_init(void)
 }
 INIT_BOARD_EXPORT(rt_hw_i2c_init);
 
+#ifdef BSP_I2C_ASYNC
+/*
+ * Asynchronous transaction queue
+ *
+ * Each bus has a worker thread which runs queued transactions one by one. A transaction is a list
+ * of messages, e.g. register address write then repeated start read, all messages of it are done
+ * in one bus session (I2C enabled and PM requested once). Pending transactions are served by
+ * priority of client which submits it (smaller value first), then in submit order, so that touch
+ * read is not stuck behind a slow sensor poll. Callback is called in worker thread.
+ */
+#ifndef BSP_I2C_ASYNC_CLIENT_MAX
+    #define BSP_I2C_ASYNC_CLIENT_MAX        (4)
+#endif
+#ifndef BSP_I2C_ASYNC_STACK_SIZE
+    #define BSP_I2C_ASYNC_STACK_SIZE        (1024)
+#endif
+#ifndef BSP_I2C_ASYNC_THREAD_PRIORITY
+    #define BSP_I2C_ASYNC_THREAD_PRIORITY   (RT_THREAD_PRIORITY_HIGH)
+#endif
+
+typedef struct
+{
+    const char *name;
+    rt_uint8_t priority;
+    rt_i2c_async_client_stat_t stat;
+} i2c_async_client_t;
+
+typedef struct
+{
+    rt_thread_t thread;
+    struct rt_semaphore sem;
+    rt_list_t pending;
+    rt_uint8_t client_num;
+    i2c_async_client_t client[BSP_I2C_ASYNC_CLIENT_MAX];
+    rt_uint64_t busy_us;
+    rt_tick_t stat_tick;
+} i2c_async_bus_t;
+
+static i2c_async_bus_t i2c_async[I2C_NUM];
+
+static rt_uint32_t i2c_async_us(rt_uint32_t start, rt_uint32_t end)
+{
+    return (rt_uint32_t)((rt_uint64_t)(end - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static struct rt_i2c_async_xfer *i2c_async_pop(i2c_async_bus_t *ab)
+{
+    struct rt_i2c_async_xfer *xfer = RT_NULL;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (!rt_list_isempty(&ab->pending))
+    {
+        xfer = rt_list_first_entry(&ab->pending, struct rt_i2c_async_xfer, node);
+        rt_list_remove(&xfer->node);
+    }
+    rt_hw_interrupt_enable(level);
+
+    return xfer;
+}
+
+static void i2c_async_entry(void *param)
+{
+    rt_uint32_t i2c_index = (rt_uint32_t)param;
+    i2c_async_bus_t *ab = &i2c_async[i2c_index];
+    struct rt_i2c_async_xfer *xfer;
+    rt_i2c_async_client_stat_t *stat;
+    rt_uint32_t start, end, latency;
+    rt_size_t ret;
+    rt_base_t level;
+
+    while (1)
+    {
+        rt_sem_take(&ab->sem, RT_WAITING_FOREVER);
+        while ((xfer = i2c_async_pop(ab)) != RT_NULL)
+        {
+            start = HAL_GTIMER_READ();
+            ret = rt_i2c_transfer(&i2c_obj[i2c_index].bus, xfer->msgs, xfer->num);
+            end = HAL_GTIMER_READ();
+            latency = i2c_async_us(xfer->submit_ts, end);
+
+            stat = &ab->client[xfer->client].stat;
+            level = rt_hw_interrupt_disable();
+            ab->busy_us += i2c_async_us(start, end);
+            stat->count++;
+            if (ret != xfer->num)
+                stat->error++;
+            stat->latency_sum_us += latency;
+            if (latency > stat->latency_max_us)
+                stat->latency_max_us = latency;
+            rt_hw_interrupt_enable(level);
+
+            if (xfer->cb)
+                xfer->cb(xfer, (ret == xfer->num) ? RT_EOK : -RT_EIO);
+        }
+    }
+}
+
+int rt_i2c_async_client_register(struct rt_i2c_bus_device *bus, const char *name, rt_uint8_t priority)
+{
+    rt_uint32_t i2c_index = get_index_by_bus_handle(bus);
+    i2c_async_bus_t *ab;
+    char thread_name[RT_NAME_MAX];
+    int client;
+
+    if (i2c_index >= I2C_NUM)
+        return -RT_EINVAL;
+
+    ab = &i2c_async[i2c_index];
+    rt_enter_critical();
+    if (!ab->thread)
+    {
+        rt_list_init(&ab->pending);
+        rt_sem_init(&ab->sem, "i2c_aq", 0, RT_IPC_FLAG_FIFO);
+        rt_snprintf(thread_name, sizeof(thread_name), "%s_aq", i2c_obj[i2c_index].bf0_i2c_cfg->device_name);
+        ab->thread = rt_thread_create(thread_name, i2c_async_entry, (void *)i2c_index,
+                                      BSP_I2C_ASYNC_STACK_SIZE, BSP_I2C_ASYNC_THREAD_PRIORITY, 10);
+        RT_ASSERT(ab->thread);
+        ab->stat_tick = rt_tick_get();
+        rt_thread_startup(ab->thread);
+    }
+
+    if (ab->client_num >= BSP_I2C_ASYNC_CLIENT_MAX)
+    {
+        rt_exit_critical();
+        LOG_E("i2c async client full");
+        return -RT_EFULL;
+    }
+    client = ab->client_num++;
+    ab->client[client].name = name;
+    ab->client[client].priority = priority;
+    rt_memset(&ab->client[client].stat, 0, sizeof(ab->client[client].stat));
+    rt_exit_critical();
+
+    return client;
+}
+
+rt_err_t rt_i2c_async_submit(struct rt_i2c_bus_device *bus, struct rt_i2c_async_xfer *xfer)
+{
+    rt_uint32_t i2c_index = get_index_by_bus_handle(bus);
+    i2c_async_bus_t *ab;
+    struct rt_i2c_async_xfer *pos;
+    rt_uint8_t priority;
+    rt_base_t level;
+
+    RT_ASSERT(xfer);
+    if (i2c_index >= I2C_NUM)
+        return -RT_EINVAL;
+
+    ab = &i2c_async[i2c_index];
+    if (!ab->thread || (xfer->client < 0) || (xfer->client >= ab->client_num) || (0 == xfer->num))
+        return -RT_EINVAL;
+
+    priority = ab->client[xfer->client].priority;
+    xfer->submit_ts = HAL_GTIMER_READ();
+
+    level = rt_hw_interrupt_disable();
+    /* Insert before first transaction of lower priority, keep order of same priority */
+    rt_list_for_each_entry(pos, &ab->pending, node)
+    {
+        if (ab->client[pos->client].priority > priority)
+            break;
+    }
+    rt_list_insert_before(&pos->node, &xfer->node);
+    rt_hw_interrupt_enable(level);
+
+    rt_sem_release(&ab->sem);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_i2c_async_get_stat(struct rt_i2c_bus_device *bus, int client, rt_i2c_async_client_stat_t *stat)
+{
+    rt_uint32_t i2c_index = get_index_by_bus_handle(bus);
+    rt_base_t level;
+
+    if ((i2c_index >= I2C_NUM) || (client < 0) || (client >= i2c_async[i2c_index].client_num) || !stat)
+        return -RT_EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    *stat = i2c_async[i2c_index].client[client].stat;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+rt_uint32_t rt_i2c_async_get_utilization(struct rt_i2c_bus_device *bus)
+{
+    rt_uint32_t i2c_index = get_index_by_bus_handle(bus);
+    rt_uint64_t elapsed_us;
+
+    if ((i2c_index >= I2C_NUM) || !i2c_async[i2c_index].thread)
+        return 0;
+
+    elapsed_us = (rt_uint64_t)(rt_tick_get() - i2c_async[i2c_index].stat_tick) * 1000000 / RT_TICK_PER_SECOND;
+    if (0 == elapsed_us)
+        return 0;
+
+    return (rt_uint32_t)(i2c_async[i2c_index].busy_us * 10000 / elapsed_us);
+}
+
+void rt_i2c_async_reset_stat(struct rt_i2c_bus_device *bus)
+{
+    rt_uint32_t i2c_index = get_index_by_bus_handle(bus);
+    i2c_async_bus_t *ab;
+    rt_base_t level;
+
+    if (i2c_index >= I2C_NUM)
+        return;
+
+    ab = &i2c_async[i2c_index];
+    level = rt_hw_interrupt_disable();
+    for (int i = 0; i < ab->client_num; i++)
+        rt_memset(&ab->client[i].stat, 0, sizeof(ab->client[i].stat));
+    ab->busy_us = 0;
+    ab->stat_tick = rt_tick_get();
+    rt_hw_interrupt_enable(level);
+}
+
+#ifdef RT_USING_FINSH
+static int cmd_i2c_async(int argc, char *argv[])
+{
+    for (int i = 0; i < I2C_NUM; i++)
+    {
+        struct rt_i2c_bus_device *bus = &i2c_obj[i].bus;
+        i2c_async_bus_t *ab = &i2c_async[i];
+        rt_uint32_t util;
+
+        if (!ab->thread)
+            continue;
+
+        if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+        {
+            rt_i2c_async_reset_stat(bus);
+            continue;
+        }
+
+        util = rt_i2c_async_get_utilization(bus);
+        rt_kprintf("%s: busy %d.%02d%%\n", i2c_obj[i].bf0_i2c_cfg->device_name, util / 100, util % 100);
+        for (int j = 0; j < ab->client_num; j++)
+        {
+            rt_i2c_async_client_stat_t stat;
+
+            rt_i2c_async_get_stat(bus, j, &stat);
+            rt_kprintf("  %-8s prio %3d: xfer %d, err %d, latency avg %dus max %dus\n",
+                       ab->client[j].name, ab->client[j].priority, stat.count, stat.error,
+                       stat.count ? (rt_uint32_t)(stat.latency_sum_us / stat.count) : 0, stat.latency_max_us);
+        }
+    }
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_i2c_async, i2c_async, i2c async queue statistics: i2c_async [reset]);
+#endif /* RT_USING_FINSH */
+
+#endif /* BSP_I2C_ASYNC */
+
 #endif /*defined(SOC_SF32LB55X)&&defined(SOC_BF0_LCPU)*/
 
 
@@ -104,5 +104,60 @@ enum
 
 int rt_hw_i2c_init(void);
 
+#ifdef BSP_I2C_ASYNC
+struct rt_i2c_async_xfer;
+
+/**
+ * @brief Completion callback of asynchronous transaction, called in bus worker thread.
+ * @param xfer - completed transaction, could be submitted again in callback
+ * @param result - RT_EOK if all messages are done, -RT_EIO otherwise
+ */
+typedef void (*rt_i2c_async_cb_t)(struct rt_i2c_async_xfer *xfer, rt_err_t result);
+
+/** Asynchronous transaction, owned by caller and must be kept until callback */
+struct rt_i2c_async_xfer
+{
+    rt_list_t node;                 /**< private */
+    struct rt_i2c_msg *msgs;        /**< messages done in one bus session, e.g. write register + read */
+    rt_uint32_t num;                /**< number of messages */
+    int client;                     /**< id from rt_i2c_async_client_register() */
+    rt_i2c_async_cb_t cb;
+    void *user_data;
+    rt_uint32_t submit_ts;          /**< private */
+};
+
+typedef struct
+{
+    rt_uint32_t count;              /**< completed transactions */
+    rt_uint32_t error;              /**< failed transactions */
+    rt_uint64_t latency_sum_us;     /**< submit to completion */
+    rt_uint32_t latency_max_us;
+} rt_i2c_async_client_stat_t;
+
+/**
+ * @brief Register a client of bus asynchronous queue, worker thread of bus is created on first call.
+ * @param bus - I2C bus
+ * @param name - client name, must be kept by caller
+ * @param priority - smaller value is served first, e.g. touch 0, temperature sensor 10
+ * @return client id, or negative error code
+ */
+int rt_i2c_async_client_register(struct rt_i2c_bus_device *bus, const char *name, rt_uint8_t priority);
+
+/**
+ * @brief Queue transaction, could be called in interrupt.
+ * @return RT_EOK if queued
+ */
+rt_err_t rt_i2c_async_submit(struct rt_i2c_bus_device *bus, struct rt_i2c_async_xfer *xfer);
+
+/** @brief Get latency statistics of a client. */
+rt_err_t rt_i2c_async_get_stat(struct rt_i2c_bus_device *bus, int client, rt_i2c_async_client_stat_t *stat);
+
+/** @brief Get bus busy time since last reset, in 0.01% unit. */
+rt_uint32_t rt_i2c_async_get_utilization(struct rt_i2c_bus_device *bus);
+
+/** @brief Reset statistics of bus and all its clients. */
+void rt_i2c_async_reset_stat(struct rt_i2c_bus_device *bus);
+#endif /* BSP_I2C_ASYNC */
+
 #endif
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,417 @@
+/**
+  ******************************************************************************
+  * @file   drv_irq_latency.c
+  * @author Sifli software development team
+  * @brief
+  *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#include <string.h>
+#include <stdlib.h>
+#include <rtdevice.h>
+#include "drv_irq_latency.h"
+
+#define DBG_TAG "irq_lat"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#if defined(__CC_ARM)
+    #define IRQ_LAT_CALLER()        ((uint32_t)__return_address())
+#else
+    #define IRQ_LAT_CALLER()        ((uint32_t)__builtin_return_address(0))
+#endif
+
+#define IRQ_LAT_EXC_MAX             (16 + 128)  /* exception number is IRQn + 16 */
+#define IRQ_LAT_NEST_MAX            (8)
+
+typedef struct
+{
+    int16_t irqn;
+    irq_lat_hist_t hist;
+} isr_slot_t;
+
+static volatile uint8_t irq_lat_on;
+static uint32_t cycle_per_us;
+
+static isr_slot_t isr_slot[IRQ_LAT_ISR_SLOT_NUM];
+static uint8_t isr_slot_num;
+static uint8_t exc_to_slot[IRQ_LAT_EXC_MAX];   /* slot index + 1, 0 if not tracked */
+static uint32_t isr_enter_cycle[IRQ_LAT_NEST_MAX];
+static uint8_t isr_enter_exc[IRQ_LAT_NEST_MAX];
+
+static rt_device_t probe_dev;
+static GPT_HandleTypeDef *probe_tim;
+static uint32_t probe_freq;
+static irq_lat_hist_t probe_hist;
+
+static void hist_add(irq_lat_hist_t *h, uint32_t ns)
+{
+    uint32_t b = 0, t = ns / IRQ_LAT_HIST_BASE_NS;
+
+    while (t && b < IRQ_LAT_HIST_NUM - 1)
+    {
+        t >>= 1;
+        b++;
+    }
+    h->hist[b]++;
+    h->count++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns)
+        h->max_ns = ns;
+}
+
+static uint32_t cycle_to_ns(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000 / cycle_per_us);
+}
+
+/* ISR time ------------------------------------------------------------------------------------*/
+#ifdef RT_USING_HOOK
+/* Both hooks are called with interrupt disabled, enter hook after nest is increased,
+   leave hook after nest is decreased */
+static void isr_enter_hook(void)
+{
+    uint32_t nest = rt_interrupt_get_nest() - 1;
+
+    if (nest < IRQ_LAT_NEST_MAX)
+    {
+        isr_enter_cycle[nest] = DWT->CYCCNT;
+        isr_enter_exc[nest] = (uint8_t)__get_IPSR();
+    }
+}
+
+static void isr_leave_hook(void)
+{
+    uint32_t nest = rt_interrupt_get_nest();
+    uint32_t cycles, exc, slot;
+
+    if (nest >= IRQ_LAT_NEST_MAX || !irq_lat_on)
+        return;
+
+    cycles = DWT->CYCCNT - isr_enter_cycle[nest];
+    exc = isr_enter_exc[nest];
+    if (exc >= IRQ_LAT_EXC_MAX)
+        return;
+    slot = exc_to_slot[exc];
+    if (0 == slot)
+    {
+        if (isr_slot_num >= IRQ_LAT_ISR_SLOT_NUM)
+            return;
+        isr_slot[isr_slot_num].irqn = (int16_t)exc - 16;
+        exc_to_slot[exc] = ++isr_slot_num;
+        slot = isr_slot_num;
+    }
+    /* time of nested ISR is included in outer one */
+    hist_add(&isr_slot[slot - 1].hist, cycle_to_ns(cycles));
+}
+#endif /* RT_USING_HOOK */
+
+/* Interrupt disabled section ------------------------------------------------------------------*/
+#if defined(IRQ_LAT_TRACK_IRQ_OFF) && !defined(__ICCARM__)
+static irq_lat_off_t irq_off_top[IRQ_LAT_OFF_TOP_NUM];
+static uint32_t irq_off_start, irq_off_caller;
+static uint8_t irq_off_open;
+
+static void irq_off_record(uint32_t ns, uint32_t disable_caller, uint32_t enable_caller)
+{
+    irq_lat_off_t *min = &irq_off_top[0];
+    uint32_t i;
+
+    for (i = 0; i < IRQ_LAT_OFF_TOP_NUM; i++)
+    {
+        if (irq_off_top[i].disable_caller == disable_caller)
+        {
+            irq_off_top[i].count++;
+            if (ns > irq_off_top[i].max_ns)
+            {
+                irq_off_top[i].max_ns = ns;
+                irq_off_top[i].enable_caller = enable_caller;
+            }
+            return;
+        }
+        if (irq_off_top[i].max_ns < min->max_ns)
+            min = &irq_off_top[i];
+    }
+    if (ns > min->max_ns)
+    {
+        min->max_ns = ns;
+        min->count = 1;
+        min->disable_caller = disable_caller;
+        min->enable_caller = enable_caller;
+    }
+}
+
+/* Replace weak version in libcpu, only the outermost section is timed */
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    rt_base_t level = __get_PRIMASK();
+
+    __disable_irq();
+    if (0 == level && irq_lat_on)
+    {
+        irq_off_start = DWT->CYCCNT;
+        irq_off_caller = IRQ_LAT_CALLER();
+        irq_off_open = 1;
+    }
+    return level;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    if (0 == level && irq_off_open)
+    {
+        irq_off_open = 0;
+        irq_off_record(cycle_to_ns(DWT->CYCCNT - irq_off_start), irq_off_caller, IRQ_LAT_CALLER());
+    }
+    __set_PRIMASK(level);
+}
+#endif /* IRQ_LAT_TRACK_IRQ_OFF && !__ICCARM__ */
+
+/* Probe ---------------------------------------------------------------------------------------*/
+void irq_latency_timer_sample(GPT_HandleTypeDef *tim)
+{
+    uint32_t ticks;
+
+    if (tim != probe_tim || !__HAL_GPT_GET_FLAG(tim, GPT_FLAG_UPDATE))
+        return;
+
+    /* counter restarts at update event which raised the IRQ */
+    ticks = tim->Instance->CNT;
+    if (GPT_COUNTERMODE_DOWN == tim->Init.CounterMode)
+        ticks = tim->Instance->ARR - ticks;
+    hist_add(&probe_hist, (uint32_t)((uint64_t)ticks * 1000000000 / probe_freq));
+}
+
+rt_err_t irq_latency_probe_start(const char *name, uint32_t freq, uint32_t period_us)
+{
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_PERIOD;
+    rt_hwtimerval_t timeout;
+    rt_device_t dev;
+
+    irq_latency_probe_stop();
+    dev = rt_device_find(name);
+    if (RT_NULL == dev || RT_EOK != rt_device_open(dev, RT_DEVICE_OFLAG_RDWR))
+    {
+        LOG_E("open %s fail", name);
+        return -RT_ERROR;
+    }
+    if (RT_EOK != rt_device_control(dev, HWTIMER_CTRL_FREQ_SET, &freq)
+            || RT_EOK != rt_device_control(dev, HWTIMER_CTRL_MODE_SET, &mode))
+    {
+        LOG_E("%s freq %d not supported", name, freq);
+        rt_device_close(dev);
+        return -RT_ERROR;
+    }
+
+    memset(&probe_hist, 0, sizeof(probe_hist));
+    probe_freq = ((rt_hwtimer_t *)dev)->freq;
+    probe_tim = (GPT_HandleTypeDef *)dev->user_data;
+    probe_dev = dev;
+    timeout.sec = period_us / 1000000;
+    timeout.usec = period_us % 1000000;
+    if (rt_device_write(dev, 0, &timeout, sizeof(timeout)) != sizeof(timeout))
+    {
+        irq_latency_probe_stop();
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+
+void irq_latency_probe_stop(void)
+{
+    if (probe_dev)
+    {
+        rt_device_close(probe_dev);
+        probe_dev = RT_NULL;
+        probe_tim = RT_NULL;
+    }
+}
+
+/* Control -------------------------------------------------------------------------------------*/
+void irq_latency_start(void)
+{
+    rt_base_t level;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    cycle_per_us = HAL_RCC_GetHCLKFreq(CORE_ID_DEFAULT) / 1000000;
+
+    level = rt_hw_interrupt_disable();
+    irq_lat_on = 0;
+    memset(isr_slot, 0, sizeof(isr_slot));
+    memset(exc_to_slot, 0, sizeof(exc_to_slot));
+    isr_slot_num = 0;
+#if defined(IRQ_LAT_TRACK_IRQ_OFF) && !defined(__ICCARM__)
+    memset(irq_off_top, 0, sizeof(irq_off_top));
+    irq_off_open = 0;
+#endif
+#ifdef RT_USING_HOOK
+    rt_interrupt_enter_sethook(isr_enter_hook);
+    rt_interrupt_leave_sethook(isr_leave_hook);
+#endif
+    rt_hw_interrupt_enable(level);
+    irq_lat_on = 1;
+}
+
+void irq_latency_stop(void)
+{
+    irq_lat_on = 0;
+#ifdef RT_USING_HOOK
+    rt_interrupt_enter_sethook(RT_NULL);
+    rt_interrupt_leave_sethook(RT_NULL);
+#endif
+}
+
+rt_err_t irq_latency_get_isr(int irqn, irq_lat_hist_t *hist)
+{
+    uint32_t exc = (uint32_t)(irqn + 16);
+    rt_base_t level;
+
+    if (exc >= IRQ_LAT_EXC_MAX || 0 == exc_to_slot[exc])
+        return -RT_EEMPTY;
+    level = rt_hw_interrupt_disable();
+    memcpy(hist, &isr_slot[exc_to_slot[exc] - 1].hist, sizeof(*hist));
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+void irq_latency_get_probe(irq_lat_hist_t *hist)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    memcpy(hist, &probe_hist, sizeof(*hist));
+    rt_hw_interrupt_enable(level);
+}
+
+int irq_latency_get_off(irq_lat_off_t *off)
+{
+#if defined(IRQ_LAT_TRACK_IRQ_OFF) && !defined(__ICCARM__)
+    rt_base_t level;
+    irq_lat_off_t t;
+    int i, j, n = 0;
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < IRQ_LAT_OFF_TOP_NUM; i++)
+        if (irq_off_top[i].max_ns)
+            off[n++] = irq_off_top[i];
+    rt_hw_interrupt_enable(level);
+
+    for (i = 1; i < n; i++)
+        for (j = i; j > 0 && off[j].max_ns > off[j - 1].max_ns; j--)
+        {
+            t = off[j];
+            off[j] = off[j - 1];
+            off[j - 1] = t;
+        }
+    return n;
+#else
+    return 0;
+#endif
+}
+
+#ifdef RT_USING_FINSH
+static void print_hist(const char *name, irq_lat_hist_t *h)
+{
+    uint32_t i;
+
+    rt_kprintf("%-8s %7d %7d %7d |", name, h->count,
+               h->count ? (uint32_t)(h->sum_ns / h->count) : 0, h->max_ns);
+    for (i = 0; i < IRQ_LAT_HIST_NUM; i++)
+        rt_kprintf(" %d", h->hist[i]);
+    rt_kprintf("\n");
+}
+
+static void irq_lat_show(void)
+{
+    irq_lat_off_t off[IRQ_LAT_OFF_TOP_NUM];
+    irq_lat_hist_t h;
+    char name[12];
+    uint32_t i;
+    int n;
+
+    rt_kprintf("%-8s %7s %7s %7s | histogram, bucket i < %dns << i\n", "irq", "count", "avg_ns", "max_ns",
+               IRQ_LAT_HIST_BASE_NS);
+    if (probe_tim)
+    {
+        irq_latency_get_probe(&h);
+        print_hist("latency", &h);
+    }
+    for (i = 0; i < isr_slot_num; i++)
+    {
+        if (RT_EOK != irq_latency_get_isr(isr_slot[i].irqn, &h))
+            continue;
+        rt_snprintf(name, sizeof(name), "isr%d", isr_slot[i].irqn);
+        print_hist(name, &h);
+    }
+
+    n = irq_latency_get_off(off);
+    if (n)
+        rt_kprintf("longest interrupt disabled:\n%7s %7s %10s %10s\n", "max_ns", "count", "disable", "enable");
+    for (i = 0; i < (uint32_t)n; i++)
+        rt_kprintf("%7d %7d 0x%08x 0x%08x\n", off[i].max_ns, off[i].count, off[i].disable_caller, off[i].enable_caller);
+}
+
+static int irq_lat(int argc, char **argv)
+{
+    if (argc >= 2 && 0 == strcmp(argv[1], "start"))
+        irq_latency_start();
+    else if (argc >= 2 && 0 == strcmp(argv[1], "stop"))
+        irq_latency_stop();
+    else if (argc >= 3 && 0 == strcmp(argv[1], "probe"))
+        irq_latency_probe_start(argv[2], argc > 4 ? atoi(argv[4]) : 1000000, argc > 3 ? atoi(argv[3]) : 1000);
+    else if (argc >= 2 && 0 == strcmp(argv[1], "unprobe"))
+        irq_latency_probe_stop();
+    else if (argc >= 2 && 0 == strcmp(argv[1], "show"))
+        irq_lat_show();
+    else
+    {
+        rt_kprintf("irq_lat start|stop|show\n");
+        rt_kprintf("irq_lat probe <hwtimer> [period_us] [freq]\n");
+        rt_kprintf("irq_lat unprobe\n");
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(irq_lat, Interrupt latency measurement);
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
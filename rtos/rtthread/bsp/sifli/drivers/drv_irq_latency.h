@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file   drv_irq_latency.h
+  * @author Sifli software development team
+  * @brief Interrupt latency measurement
+  * @{
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#ifndef __DRV_IRQ_LATENCY_H_
+#define __DRV_IRQ_LATENCY_H_
+
+#include <rtthread.h>
+#include <board.h>
+#include "bf0_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup bsp_driver Driver IO
+  * @{
+  */
+
+/** @defgroup drv_irq_latency Interrupt latency
+  * @brief Interrupt latency, ISR time and interrupt-disabled section measurement.
+  *
+  * - ISR time of each interrupt is measured by DWT between rt_interrupt_enter() and rt_interrupt_leave(),
+  *   needs RT_USING_HOOK.
+  * - Latency from IRQ assertion to ISR entry is measured by a hwtimer device in period mode,
+  *   its counter value at ISR entry is the time since the update event asserted the IRQ.
+  * - With IRQ_LAT_TRACK_IRQ_OFF, rt_hw_interrupt_disable()/rt_hw_interrupt_enable() are replaced
+  *   to record the longest sections with interrupt disabled and their callers.
+  *   Code using __disable_irq() directly is not seen.
+  * @{
+  */
+
+/* Histogram bucket i counts time < (250ns << i), last bucket counts the rest */
+#define IRQ_LAT_HIST_NUM            (12)
+#define IRQ_LAT_HIST_BASE_NS        (250)
+
+#ifndef IRQ_LAT_ISR_SLOT_NUM
+    #define IRQ_LAT_ISR_SLOT_NUM    (16)        /* Number of different interrupts to track */
+#endif
+#ifndef IRQ_LAT_OFF_TOP_NUM
+    #define IRQ_LAT_OFF_TOP_NUM     (8)         /* Number of longest interrupt-disabled callers kept */
+#endif
+//#define IRQ_LAT_TRACK_IRQ_OFF
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t max_ns;
+    uint64_t sum_ns;
+    uint32_t hist[IRQ_LAT_HIST_NUM];
+} irq_lat_hist_t;
+
+typedef struct
+{
+    uint32_t max_ns;
+    uint32_t count;                 /**< sections from same caller */
+    uint32_t disable_caller;        /**< return address of outermost rt_hw_interrupt_disable() */
+    uint32_t enable_caller;         /**< return address of rt_hw_interrupt_enable() of longest section */
+} irq_lat_off_t;
+
+/**
+ * @brief Reset statistics and start ISR time (and interrupt-disabled section) measurement.
+ */
+void irq_latency_start(void);
+
+/** @brief Stop measurement, statistics are kept. */
+void irq_latency_stop(void);
+
+/**
+ * @brief Start latency probe on a hwtimer device, it must not be used by others.
+ * @param name - hwtimer device name, e.g. "btim1"
+ * @param freq - counter frequency in Hz, resolution of result
+ * @param period_us - interval of probe interrupts
+ * @return RT_EOK if started
+ */
+rt_err_t irq_latency_probe_start(const char *name, uint32_t freq, uint32_t period_us);
+
+/** @brief Stop latency probe and close device. */
+void irq_latency_probe_stop(void);
+
+/**
+ * @brief Called by drv_hwtimer at entry of timer ISR, before rt_interrupt_enter().
+ * @param tim - timer handle
+ */
+void irq_latency_timer_sample(GPT_HandleTypeDef *tim);
+
+/**
+ * @brief Get ISR time statistics.
+ * @param irqn - interrupt number, negative for system exception, e.g. SysTick_IRQn
+ * @param hist - output
+ * @return RT_EOK if interrupt is tracked
+ */
+rt_err_t irq_latency_get_isr(int irqn, irq_lat_hist_t *hist);
+
+/** @brief Get latency statistics of probe. */
+void irq_latency_get_probe(irq_lat_hist_t *hist);
+
+/**
+ * @brief Get longest interrupt-disabled sections, sorted from longest.
+ * @param off - output array of IRQ_LAT_OFF_TOP_NUM
+ * @return number of valid entries
+ */
+int irq_latency_get_off(irq_lat_off_t *off);
+
+/// @} drv_irq_latency
+/// @} bsp_driver
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__DRV_IRQ_LATENCY_H_ */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
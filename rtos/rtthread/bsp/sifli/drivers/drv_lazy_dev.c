@@ -0,0 +1,288 @@
+/**
+  ******************************************************************************
+  * @file   drv_lazy_dev.c
+  * @author Sifli software development team
+  * @brief Lazy initialization of peripheral drivers
+  *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#include <string.h>
+#include <rtdevice.h>
+#include "drv_lazy_dev.h"
+
+#define DBG_TAG "lazy_dev"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+static rt_slist_t lazy_head = RT_SLIST_OBJECT_INIT(lazy_head);
+static struct rt_mutex lazy_lock;
+static uint8_t lazy_lock_inited;
+
+static uint32_t lazy_elapsed_us(uint32_t start)
+{
+    return (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static drv_lazy_dev_t *lazy_find(rt_device_t dev)
+{
+    rt_slist_t *node;
+
+    rt_slist_for_each(node, &lazy_head)
+    {
+        drv_lazy_dev_t *ldev = rt_slist_entry(node, drv_lazy_dev_t, list);
+        if (ldev->dev == dev)
+            return ldev;
+    }
+    return NULL;
+}
+
+void drv_lazy_dev_register(drv_lazy_dev_t *ldev, const char *name, const drv_lazy_dev_ops_t *ops, void *user_data)
+{
+    rt_base_t level;
+
+    RT_ASSERT(ldev && ops && ops->init);
+
+    /* Registered in INIT_XXX_EXPORT by drivers, before any thread uses lazy device */
+    if (!lazy_lock_inited)
+    {
+        rt_mutex_init(&lazy_lock, "lazy_dev", RT_IPC_FLAG_FIFO);
+        lazy_lock_inited = 1;
+    }
+
+    memset(ldev, 0, sizeof(*ldev));
+    ldev->name = name;
+    ldev->ops = ops;
+    ldev->user_data = user_data;
+
+    level = rt_hw_interrupt_disable();
+    rt_slist_append(&lazy_head, &ldev->list);
+    rt_hw_interrupt_enable(level);
+}
+
+rt_err_t drv_lazy_dev_get(drv_lazy_dev_t *ldev)
+{
+    rt_err_t r = RT_EOK;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+    rt_mutex_take(&lazy_lock, RT_WAITING_FOREVER);
+    if (!ldev->up)
+    {
+        uint32_t start = HAL_GTIMER_READ();
+
+        r = ldev->ops->init(ldev);
+        ldev->init_us = lazy_elapsed_us(start);
+        if (RT_EOK == r)
+        {
+            ldev->up = 1;
+            ldev->init_count++;
+            LOG_D("%s up in %d us", ldev->name, ldev->init_us);
+        }
+        else
+        {
+            LOG_E("%s init fail %d", ldev->name, r);
+        }
+    }
+    if (RT_EOK == r)
+        ldev->ref++;
+    rt_mutex_release(&lazy_lock);
+
+    return r;
+}
+
+void drv_lazy_dev_put(drv_lazy_dev_t *ldev)
+{
+    RT_DEBUG_NOT_IN_INTERRUPT;
+    rt_mutex_take(&lazy_lock, RT_WAITING_FOREVER);
+    RT_ASSERT(ldev->ref > 0);
+    ldev->ref--;
+    if ((0 == ldev->ref) && ldev->up && ldev->ops->deinit)
+    {
+        ldev->ops->deinit(ldev);
+        ldev->up = 0;
+        LOG_D("%s down", ldev->name);
+    }
+    rt_mutex_release(&lazy_lock);
+}
+
+void drv_lazy_dev_add_ram(drv_lazy_dev_t *ldev, int32_t bytes)
+{
+    ldev->ram += bytes;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+    #define ORG_OPEN(ldev)     ((ldev)->org_ops->open)
+    #define ORG_CLOSE(ldev)    ((ldev)->org_ops->close)
+#else
+    #define ORG_OPEN(ldev)     ((ldev)->org_open)
+    #define ORG_CLOSE(ldev)    ((ldev)->org_close)
+#endif
+
+static rt_err_t lazy_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    drv_lazy_dev_t *ldev = lazy_find(dev);
+    rt_err_t r = RT_EOK;
+    /* ref_count is increased after open returns, 0 is the first open */
+    uint8_t first = (0 == dev->ref_count);
+
+    RT_ASSERT(ldev);
+    if (first)
+    {
+        r = drv_lazy_dev_get(ldev);
+        if (RT_EOK != r)
+            return r;
+    }
+
+    if (ORG_OPEN(ldev))
+        r = ORG_OPEN(ldev)(dev, oflag);
+    else
+        dev->open_flag = (oflag & RT_DEVICE_OFLAG_MASK);
+
+    if (first && (RT_EOK != r) && (-RT_ENOSYS != r))
+        drv_lazy_dev_put(ldev);
+
+    return r;
+}
+
+/* Only called in last close */
+static rt_err_t lazy_close(rt_device_t dev)
+{
+    drv_lazy_dev_t *ldev = lazy_find(dev);
+    rt_err_t r = RT_EOK;
+
+    RT_ASSERT(ldev);
+    if (ORG_CLOSE(ldev))
+        r = ORG_CLOSE(ldev)(dev);
+
+    if ((RT_EOK == r) || (-RT_ENOSYS == r))
+        drv_lazy_dev_put(ldev);
+
+    return r;
+}
+
+rt_err_t drv_lazy_dev_attach(drv_lazy_dev_t *ldev, rt_device_t dev)
+{
+    RT_ASSERT(ldev && dev);
+
+    if (ldev->dev || dev->ref_count)
+        return -RT_EBUSY;
+
+#ifdef RT_USING_DEVICE_OPS
+    RT_ASSERT(dev->ops);
+    ldev->org_ops = dev->ops;
+    ldev->wrap_ops = *dev->ops;
+    ldev->wrap_ops.open = lazy_open;
+    ldev->wrap_ops.close = lazy_close;
+    dev->ops = &ldev->wrap_ops;
+#else
+    ldev->org_open = dev->open;
+    ldev->org_close = dev->close;
+    dev->open = lazy_open;
+    dev->close = lazy_close;
+#endif
+    ldev->dev = dev;
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_PM
+static int lazy_suspend(const struct rt_device *device, uint8_t mode)
+{
+    rt_slist_t *node;
+
+    rt_slist_for_each(node, &lazy_head)
+    {
+        drv_lazy_dev_t *ldev = rt_slist_entry(node, drv_lazy_dev_t, list);
+        /* Device not brought up needs nothing for sleep */
+        if (ldev->up && ldev->ops->suspend && (0 != ldev->ops->suspend(ldev, mode)))
+            return RT_EBUSY;
+    }
+    return RT_EOK;
+}
+
+/* Also called by PM if any device refused to suspend, same as other PM devices */
+static void lazy_resume(const struct rt_device *device, uint8_t mode)
+{
+    rt_slist_t *node;
+
+    rt_slist_for_each(node, &lazy_head)
+    {
+        drv_lazy_dev_t *ldev = rt_slist_entry(node, drv_lazy_dev_t, list);
+        if (ldev->up && ldev->ops->resume)
+            ldev->ops->resume(ldev, mode);
+    }
+}
+
+static const struct rt_device_pm_ops lazy_pm_op =
+{
+    .suspend = lazy_suspend,
+    .resume = lazy_resume,
+};
+
+static int lazy_dev_pm_register(void)
+{
+    rt_pm_device_register(NULL, &lazy_pm_op);
+    return 0;
+}
+INIT_ENV_EXPORT(lazy_dev_pm_register);
+#endif /* RT_USING_PM */
+
+#ifdef RT_USING_FINSH
+static int lazy_dev(int argc, char **argv)
+{
+    rt_slist_t *node;
+    uint32_t ram = 0;
+
+    rt_kprintf("%-10s %-4s %-4s %-8s %-6s %s\n", "name", "up", "ref", "init_us", "inits", "ram");
+    rt_slist_for_each(node, &lazy_head)
+    {
+        drv_lazy_dev_t *ldev = rt_slist_entry(node, drv_lazy_dev_t, list);
+        rt_kprintf("%-10s %-4d %-4d %-8d %-6d %d\n", ldev->name, ldev->up, ldev->ref,
+                   ldev->init_us, ldev->init_count, ldev->ram);
+        if (ldev->up)
+            ram += ldev->ram;
+    }
+    rt_kprintf("ram in use %d bytes\n", ram);
+    return 0;
+}
+MSH_CMD_EXPORT(lazy_dev, Lazy device status);
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
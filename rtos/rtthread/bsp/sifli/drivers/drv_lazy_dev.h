@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * @file   drv_lazy_dev.h
+  * @author Sifli software development team
+  * @brief Lazy initialization of peripheral drivers
+  * @{
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#ifndef __DRV_LAZY_DEV_H_
+#define __DRV_LAZY_DEV_H_
+
+#include <rtthread.h>
+#include <board.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup bsp_driver Driver IO
+  * @{
+  */
+
+/** @defgroup drv_lazy_dev Lazy device
+  * @brief Register at boot cheaply, bring up hardware on first use and power it down after last use.
+  *
+  * - Driver registers a lazy device with init/deinit ops instead of initializing hardware in INIT_XXX_EXPORT.
+  * - If attached to an rt_device, init is called in first rt_device_open() and deinit in last rt_device_close().
+  *   Driver without rt_device calls drv_lazy_dev_get()/drv_lazy_dev_put() around use instead.
+  * - suspend/resume of powered devices are called from PM, e.g. to restore registers lost in standby.
+  * - Init time and RAM reported by driver are shown by msh command lazy_dev.
+  * @{
+  */
+
+typedef struct drv_lazy_dev drv_lazy_dev_t;
+
+typedef struct
+{
+    rt_err_t (*init)(drv_lazy_dev_t *ldev);                 /**< bring up hardware, called in thread context */
+    void (*deinit)(drv_lazy_dev_t *ldev);                   /**< power down, NULL to keep powered once up */
+    int (*suspend)(drv_lazy_dev_t *ldev, uint8_t mode);     /**< optional, return non 0 to refuse sleep */
+    void (*resume)(drv_lazy_dev_t *ldev, uint8_t mode);     /**< optional, interrupt is disabled */
+} drv_lazy_dev_ops_t;
+
+struct drv_lazy_dev
+{
+    rt_slist_t list;
+    const char *name;
+    const drv_lazy_dev_ops_t *ops;
+    void *user_data;
+    rt_device_t dev;                /**< attached device, NULL if not attached */
+    uint16_t ref;
+    uint8_t up;
+    uint32_t init_us;               /**< duration of last init */
+    uint32_t init_count;
+    uint32_t ram;                   /**< bytes allocated by driver while up */
+
+    /* private */
+#ifdef RT_USING_DEVICE_OPS
+    const struct rt_device_ops *org_ops;
+    struct rt_device_ops wrap_ops;
+#else
+    rt_err_t (*org_open)(rt_device_t dev, rt_uint16_t oflag);
+    rt_err_t (*org_close)(rt_device_t dev);
+#endif
+};
+
+/**
+ * @brief Register lazy device, hardware is not touched.
+ * @param ldev - lazy device, owned by driver
+ * @param name - name for statistics
+ * @param ops - operations
+ * @param user_data - private data of driver
+ */
+void drv_lazy_dev_register(drv_lazy_dev_t *ldev, const char *name, const drv_lazy_dev_ops_t *ops, void *user_data);
+
+/**
+ * @brief Bring up hardware in first open and power down in last close of an registered rt_device.
+ * @param ldev - registered lazy device
+ * @param dev - rt_device, its open/close are wrapped
+ * @return RT_EOK if success
+ */
+rt_err_t drv_lazy_dev_attach(drv_lazy_dev_t *ldev, rt_device_t dev);
+
+/**
+ * @brief Take a reference, hardware is brought up if it is the first one.
+ * @param ldev - lazy device
+ * @return RT_EOK if success, error of init otherwise
+ */
+rt_err_t drv_lazy_dev_get(drv_lazy_dev_t *ldev);
+
+/**
+ * @brief Release a reference, hardware is powered down if it is the last one.
+ * @param ldev - lazy device
+ */
+void drv_lazy_dev_put(drv_lazy_dev_t *ldev);
+
+/**
+ * @brief Account RAM allocated or freed by driver, called in init/deinit.
+ * @param ldev - lazy device
+ * @param bytes - positive if allocated, negative if freed
+ */
+void drv_lazy_dev_add_ram(drv_lazy_dev_t *ldev, int32_t bytes);
+
+/** Whether hardware is brought up */
+#define DRV_LAZY_DEV_IS_UP(ldev)    ((ldev)->up)
+
+/// @} drv_lazy_dev
+/// @} bsp_driver
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__DRV_LAZY_DEV_H_ */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -126,7 +126,12 @@
 #ifdef COPY2COMPRESS_FB_AND_SEND
 
 #define COMPRESS_BUFF_MAGIC_FLAG 0x9527BEEF
-#define COMPRESSED_FRAME_BUF_NUM  (2)
+/* Compressed frame ring, 3 or more let renderer go on while one frame is queued and one is on LCDC */
+#ifdef BSP_LCD_COMPRESS_FB_NUM
+    #define COMPRESSED_FRAME_BUF_NUM  BSP_LCD_COMPRESS_FB_NUM
+#else
+    #define COMPRESSED_FRAME_BUF_NUM  (2)
+#endif
 #if defined(BSP_USING_BOARD_FPGA_A0) || defined(BSP_USING_BOARD_SF32LB58X_FPGA) || defined(BSP_USING_BOARD_BUTTERFLITE_FPGA)
     #define FRAME_BUF_CMPR_RATE   (0)
 #elif defined(BSP_USE_LCDC2_ON_HPSYS)|| !defined(LCDC_SUPPORTED_COMPRESSED_LAYER)
@@ -158,6 +163,24 @@ typedef enum
     FRAME_BUF_FULL
 } frame_buf_status_t;
 
+typedef enum
+{
+    FRAME_BUF_OWNER_FREE,   //Could be allocated by renderer
+    FRAME_BUF_OWNER_DMA,    //Pixels are being copied (compressed) into it
+    FRAME_BUF_OWNER_READY,  //Waiting in lcd_task queue, overwritten if a newer frame comes
+    FRAME_BUF_OWNER_LCDC,   //Being sent to LCD
+} frame_buf_owner_t;
+
+typedef struct
+{
+    uint32_t frames;        //Frames sent to LCD
+    uint32_t dropped;       //Frames overwritten by newer one before sent
+    uint32_t overlap;       //Frames copied while LCDC is sending previous one
+    uint32_t wait_ticks;    //Copy done to LCDC start
+    uint32_t wait_max;
+    uint32_t xfer_ticks;    //LCDC start to end
+    uint32_t xfer_max;
+} frame_buf_stat_t;
 
 
 typedef struct
@@ -172,6 +195,9 @@ typedef struct
     uint32_t end_tick;     //Flushed to LCD (buffer free)
     uint32_t writetimes;  //Been overwrite if large than 1
     struct rt_semaphore sema; //The buf is writting or flushing
+    uint32_t flush_tick;   //Start sending to LCD
+    uint32_t seq;          //Allocation order, larger is newer
+    frame_buf_owner_t owner;
 } frame_buf_t;
 
 typedef struct
@@ -181,6 +207,8 @@ typedef struct
     LCD_AreaDef tmp_window; //Record last 'set_window' area
     frame_buf_t *dma_copy_buf; //Current DMA copy buf
     const char *dma_copy_src_buf;  //Current DMA copy buf source
+    uint32_t seq;
+    frame_buf_stat_t stat;
 } frame_buf_ctx_t;
 
 
@@ -189,10 +217,7 @@ static uint8_t cmpr_rate = FRAME_BUF_CMPR_RATE;
 
 
 L2_NON_RET_BSS_SECT_BEGIN(comp_frambuf)
-L2_NON_RET_BSS_SECT(comp_frambuf, ALIGN(4) static uint32_t compress_buf1[COMPRESS_BUF_SIZE_IN_WORDS + 1 /*Overflow flag*/]);
-#if COMPRESSED_FRAME_BUF_NUM > 1
-    L2_NON_RET_BSS_SECT(comp_frambuf, ALIGN(4) static uint32_t compress_buf2[COMPRESS_BUF_SIZE_IN_WORDS  + 1/*Overflow flag*/]);
-#endif
+L2_NON_RET_BSS_SECT(comp_frambuf, ALIGN(4) static uint32_t compress_buf[COMPRESSED_FRAME_BUF_NUM][COMPRESS_BUF_SIZE_IN_WORDS + 1 /*Overflow flag*/]);
 L2_NON_RET_BSS_SECT_END
 
 #define EventStartA(v) //rt_kprintf("EventStartA <<<<<<<<<<<<<  %d \r\n", v)
@@ -485,6 +510,32 @@ static rt_err_t send_msg_to_lcd_task(LCD_MsgTypeDef *msg)
 }
 
 
+#ifdef BSP_LCD_DSI_ADAPTIVE_ULPS
+/*
+    DSI lanes enter ULPS only if no frame follows within this time after last frame,
+    frames of high refresh rate keep lanes in stop state and save ULPS exit time.
+*/
+#ifndef LCD_DSI_ULPS_IDLE_MS
+    #define LCD_DSI_ULPS_IDLE_MS   (50)
+#endif
+static uint8_t lcd_lp_pending; /*Entering low power is deferred to lcd_task*/
+#endif /* BSP_LCD_DSI_ADAPTIVE_ULPS */
+
+typedef struct
+{
+    uint32_t frames;        /*Frames sent by draw_core*/
+    uint64_t bytes;         /*Bytes sent to LCD*/
+    uint32_t xfer_ticks;    /*Ticks of sending frames*/
+    uint32_t lp_enter;      /*Times of entering low power(ULPS for DSI)*/
+    uint32_t lp_deferred;   /*Frames not followed by low power immediately*/
+    uint32_t lp_ticks;      /*Ticks in low power*/
+    uint32_t lp_start_tick;
+    uint32_t exit_us_sum;   /*Cost of exiting low power*/
+    uint32_t exit_us_max;
+    uint32_t reset_tick;
+} lcd_link_stat_t;
+static lcd_link_stat_t lcd_link_stat;
+
 static void enable_low_power(LCD_DrvTypeDef *p_drvlcd)
 {
     HAL_StatusTypeDef err;
@@ -493,22 +544,76 @@ static void enable_low_power(LCD_DrvTypeDef *p_drvlcd)
 
     if (p_drvlcd->auto_lowpower)
     {
+        uint8_t was_lp = (HAL_LCDC_STATE_LOWPOWER == p_drvlcd->hlcdc.State);
+
         err = HAL_LCDC_Enter_LP(&p_drvlcd->hlcdc);
         if (HAL_OK != err)
         {
             LOG_E("Enter lowpower mode err %d", err);
         }
+        else if (!was_lp && (HAL_LCDC_STATE_LOWPOWER == p_drvlcd->hlcdc.State))
+        {
+            lcd_link_stat.lp_enter++;
+            lcd_link_stat.lp_start_tick = rt_tick_get();
+        }
+    }
+#ifdef BSP_LCD_DSI_ADAPTIVE_ULPS
+    if (lcd_lp_pending)
+    {
+        lcd_lp_pending = 0;
+#ifdef RT_USING_PM
+        rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif  /* RT_USING_PM */
     }
+#endif /* BSP_LCD_DSI_ADAPTIVE_ULPS */
     LOG_D("LCDC Enter lowpower mode done.");
 }
 
+/* Enter low power after a frame is sent */
+static void frame_low_power(LCD_DrvTypeDef *p_drvlcd)
+{
+#ifdef BSP_LCD_DSI_ADAPTIVE_ULPS
+    if (p_drvlcd->auto_lowpower && HAL_LCDC_IS_DSI_IF(p_drvlcd->hlcdc.Init.lcd_itf)
+            && (rt_thread_self() == &p_drvlcd->task))
+    {
+        //lcd_task enters low power if no message comes in LCD_DSI_ULPS_IDLE_MS
+        if (!lcd_lp_pending)
+        {
+            lcd_lp_pending = 1;
+#ifdef RT_USING_PM
+            rt_pm_request(PM_SLEEP_MODE_IDLE); //Not sleep before lanes enter ULPS
+#endif  /* RT_USING_PM */
+        }
+        lcd_link_stat.lp_deferred++;
+        return;
+    }
+#endif /* BSP_LCD_DSI_ADAPTIVE_ULPS */
+    enable_low_power(p_drvlcd);
+}
+
 
 static void disable_low_power(LCD_DrvTypeDef *p_drvlcd)
 {
     HAL_StatusTypeDef err;
 
     LOG_D("LCDC Exit lowpower mode");
-    err = HAL_LCDC_Exit_LP(&p_drvlcd->hlcdc);
+    if (HAL_LCDC_STATE_LOWPOWER == p_drvlcd->hlcdc.State)
+    {
+        uint32_t start = HAL_GTIMER_READ();
+        uint32_t cost_us;
+
+        err = HAL_LCDC_Exit_LP(&p_drvlcd->hlcdc);
+
+        cost_us = (uint32_t)((uint64_t)(HAL_GTIMER_READ() - start) * 1000000 / HAL_LPTIM_GetFreq());
+        lcd_link_stat.lp_ticks += rt_tick_get() - lcd_link_stat.lp_start_tick;
+        lcd_link_stat.exit_us_sum += cost_us;
+        if (cost_us > lcd_link_stat.exit_us_max)
+            lcd_link_stat.exit_us_max = cost_us;
+    }
+    else
+    {
+        err = HAL_LCDC_Exit_LP(&p_drvlcd->hlcdc);
+    }
     if (HAL_OK != err)
     {
         LOG_E("Exit lowpower mode err %d", err);
@@ -1771,6 +1876,13 @@ static rt_err_t draw_core(LCD_DrvTypeDef *p_drvlcd, const uint8_t *pixels, int x
         {
             p_drvlcd->timeout_retry_cnt = MAX_TIMEOUT_RETRY;
             p_drvlcd->end_tick = rt_tick_get();
+
+            lcd_link_stat.frames++;
+            lcd_link_stat.xfer_ticks += p_drvlcd->end_tick - p_drvlcd->start_tick;
+            lcd_link_stat.bytes += (uint32_t)(p_drvlcd->hlcdc.roi.x1 - p_drvlcd->hlcdc.roi.x0 + 1)
+                                   * (p_drvlcd->hlcdc.roi.y1 - p_drvlcd->hlcdc.roi.y0 + 1)
+                                   * ((RTGRAPHIC_PIXEL_FORMAT_RGB888 == p_drvlcd->buf_format) ? 3 :
+                                      (RTGRAPHIC_PIXEL_FORMAT_ARGB888 == p_drvlcd->buf_format) ? 4 : 2);
             if (p_drvlcd->send_time_log)
             {
                 LOG_I("draw_core buf=%x done, cost=%d(rt_ticks)", pixels, (p_drvlcd->end_tick - p_drvlcd->start_tick));
@@ -1844,7 +1956,7 @@ static rt_err_t draw_core(LCD_DrvTypeDef *p_drvlcd, const uint8_t *pixels, int x
             RT_ASSERT(0); //Wait sema err;
         }
 
-        enable_low_power(p_drvlcd);
+        frame_low_power(p_drvlcd);
 #ifdef RT_USING_PM
         rt_pm_release(PM_SLEEP_MODE_IDLE);
         rt_pm_hw_device_stop();
@@ -2344,7 +2456,22 @@ static void lcd_task(void *param)
         LCD_DrvTypeDef *p_drvlcd;
         rt_tick_t start_tick;
 
+#ifdef BSP_LCD_DSI_ADAPTIVE_ULPS
+        err = rt_mq_recv(msg_queue, &msg, sizeof(msg),
+                         lcd_lp_pending ? rt_tick_from_millisecond(LCD_DSI_ULPS_IDLE_MS) : RT_WAITING_FOREVER);
+        if (-RT_ETIMEOUT == err)
+        {
+            //No frame follows last one, enter ULPS now
+            if (RT_EOK == api_lock(&drv_lcd))
+            {
+                enable_low_power(&drv_lcd);
+                api_unlock(&drv_lcd);
+            }
+            continue;
+        }
+#else
         err = rt_mq_recv(msg_queue, &msg, sizeof(msg), RT_WAITING_FOREVER);
+#endif /* BSP_LCD_DSI_ADAPTIVE_ULPS */
 
         RT_ASSERT(RT_EOK == err);
         p_drvlcd = msg.driver;
@@ -2521,6 +2648,8 @@ static void lcd_task(void *param)
 
                 if (RT_EOK == err)
                 {
+                    compressed_buffer->owner = FRAME_BUF_OWNER_LCDC;
+                    compressed_buffer->flush_tick = rt_tick_get();
                     LOG_D("comressed_buf set_window [%d,%d,%d,%d]",
                           compressed_buffer->window.x0, compressed_buffer->window.y0,
                           compressed_buffer->window.x1, compressed_buffer->window.y1);
@@ -2800,15 +2929,17 @@ INIT_BOARD_EXPORT(rt_hw_lcd_init);
 
 static void copy2compress_fb_init(void)
 {
-    compress_fb_ctx.frame_buf[0].addr = compress_buf1;
-    compress_fb_ctx.frame_buf[0].writetimes = 0;
-    rt_sem_init(&compress_fb_ctx.frame_buf[0].sema, "cfbsem0", 1, RT_IPC_FLAG_FIFO);
+    uint32_t i;
+    char name[RT_NAME_MAX];
 
-#if (COMPRESSED_FRAME_BUF_NUM > 1)
-    compress_fb_ctx.frame_buf[1].addr = compress_buf2;
-    compress_fb_ctx.frame_buf[1].writetimes = 0;
-    rt_sem_init(&compress_fb_ctx.frame_buf[1].sema, "cfbsem1", 1, RT_IPC_FLAG_FIFO);
-#endif
+    for (i = 0; i < COMPRESSED_FRAME_BUF_NUM; i++)
+    {
+        compress_fb_ctx.frame_buf[i].addr = compress_buf[i];
+        compress_fb_ctx.frame_buf[i].writetimes = 0;
+        compress_fb_ctx.frame_buf[i].owner = FRAME_BUF_OWNER_FREE;
+        rt_snprintf(name, sizeof(name), "cfbsem%d", i);
+        rt_sem_init(&compress_fb_ctx.frame_buf[i].sema, name, 1, RT_IPC_FLAG_FIFO);
+    }
 
     rt_sem_init(&compress_fb_ctx.dma_sema, "cfbdma", 1, RT_IPC_FLAG_FIFO);
 
@@ -2818,11 +2949,11 @@ static void copy2compress_fb_init(void)
 static void copy2compress_fb_deinit(void)
 {
 
+    uint32_t i;
+
     rt_sem_detach(&compress_fb_ctx.dma_sema);
-    rt_sem_detach(&compress_fb_ctx.frame_buf[0].sema);
-#if (COMPRESSED_FRAME_BUF_NUM > 1)
-    rt_sem_detach(&compress_fb_ctx.frame_buf[1].sema);
-#endif
+    for (i = 0; i < COMPRESSED_FRAME_BUF_NUM; i++)
+        rt_sem_detach(&compress_fb_ctx.frame_buf[i].sema);
 }
 
 
@@ -2850,6 +2981,7 @@ static void copy2compress_fb_dma_done_cb(void)
     //4. Check compressed buffer
     RT_ASSERT(COMPRESS_BUFF_MAGIC_FLAG == compressed_buffer->addr[COMPRESS_BUF_SIZE_IN_WORDS]); //Check overflow
 
+    compressed_buffer->owner = FRAME_BUF_OWNER_READY;
 
     err = rt_sem_release(&(compressed_buffer->sema));
     RT_ASSERT(RT_EOK == err);
@@ -2883,21 +3015,44 @@ static void dma_err_cb(void)
 
 
 
-/* Allocate available frame buffer for write  */
+/* Allocate available frame buffer for write.
+   A free one is preferred, otherwise the newest frame still waiting for LCDC is dropped and overwritten,
+   an older one could not be reused since its message is queued before newer frames. */
 static frame_buf_t *alloc_frame_buf(void)
 {
     frame_buf_t *buf = RT_NULL;
+    frame_buf_t *newest = RT_NULL;
     uint32_t i;
 
     rt_enter_critical(); //In case of sem changed if switch to lcd_task
     for (i = 0; i < COMPRESSED_FRAME_BUF_NUM; i++)
+    {
+        if (FRAME_BUF_OWNER_LCDC == compress_fb_ctx.frame_buf[i].owner)
+            compress_fb_ctx.stat.overlap++;
+    }
+    for (i = 0; i < COMPRESSED_FRAME_BUF_NUM; i++)
     {
         buf = &compress_fb_ctx.frame_buf[i];
 
-        if (RT_EOK == rt_sem_trytake(&buf->sema))
+        if (FRAME_BUF_OWNER_FREE == buf->owner && RT_EOK == rt_sem_trytake(&buf->sema))
         {
             break;
         }
+        if (FRAME_BUF_OWNER_READY == buf->owner && (!newest || (int32_t)(buf->seq - newest->seq) > 0))
+        {
+            newest = buf;
+        }
+    }
+    if (COMPRESSED_FRAME_BUF_NUM == i && newest && RT_EOK == rt_sem_trytake(&newest->sema))
+    {
+        buf = newest;
+        i = 0;
+        compress_fb_ctx.stat.dropped++;
+    }
+    if (COMPRESSED_FRAME_BUF_NUM != i)
+    {
+        buf->owner = FRAME_BUF_OWNER_DMA;
+        buf->seq = ++compress_fb_ctx.seq;
     }
     rt_exit_critical();
 
@@ -2911,6 +3066,8 @@ static frame_buf_t *alloc_frame_buf(void)
             WAIT_SEMA_TIMEOUT();
             return NULL;
         }
+        buf->owner = FRAME_BUF_OWNER_DMA;
+        buf->seq = ++compress_fb_ctx.seq;
 #else
         RT_ASSERT(0); //Always get a buf which is not been flushing
 #endif
@@ -2927,6 +3084,21 @@ static void free_frame_buf(frame_buf_t *buf)
     buf->writetimes = 0;
     buf->end_tick = rt_tick_get();
 
+    if (FRAME_BUF_OWNER_LCDC == buf->owner)
+    {
+        frame_buf_stat_t *stat = &compress_fb_ctx.stat;
+        uint32_t wait = buf->flush_tick - buf->cp_done_tick;
+        uint32_t xfer = buf->end_tick - buf->flush_tick;
+
+        stat->frames++;
+        stat->wait_ticks += wait;
+        stat->xfer_ticks += xfer;
+        if (wait > stat->wait_max)
+            stat->wait_max = wait;
+        if (xfer > stat->xfer_max)
+            stat->xfer_max = xfer;
+    }
+    buf->owner = FRAME_BUF_OWNER_FREE;
 
 
 }
@@ -3532,6 +3704,81 @@ static rt_err_t lcd_ctrl(int argc, char **argv)
             DEBUG_PRINTF("assert= %d\n", v);
         }
     }
+    else if (strcmp(argv[1], "linkstat") == 0)
+    {
+        lcd_link_stat_t stat;
+        uint32_t now, elapsed, lp_ticks, xfer_ms;
+        rt_base_t level;
+
+        level = rt_hw_interrupt_disable();
+        stat = lcd_link_stat;
+        rt_hw_interrupt_enable(level);
+
+        now = rt_tick_get();
+        elapsed = now - stat.reset_tick;
+        lp_ticks = stat.lp_ticks;
+        if (HAL_LCDC_STATE_LOWPOWER == drv_lcd.hlcdc.State)
+            lp_ticks += now - stat.lp_start_tick;
+        xfer_ms = stat.xfer_ticks * 1000 / RT_TICK_PER_SECOND;
+
+        DEBUG_PRINTF("frames %d, %d KB, %d KB/s while sending, avg frame %d ms\n", stat.frames,
+                     (uint32_t)(stat.bytes / 1024), xfer_ms ? (uint32_t)(stat.bytes / xfer_ms) : 0,
+                     stat.frames ? xfer_ms / stat.frames : 0);
+        DEBUG_PRINTF("low power %d.%d%% of %d ticks, entered %d, deferred %d, exit avg %d max %d us\n",
+                     elapsed ? (uint32_t)((uint64_t)lp_ticks * 100 / elapsed) : 0,
+                     elapsed ? (uint32_t)((uint64_t)lp_ticks * 1000 / elapsed % 10) : 0, elapsed,
+                     stat.lp_enter, stat.lp_deferred,
+                     stat.lp_enter ? stat.exit_us_sum / stat.lp_enter : 0, stat.exit_us_max);
+        if (argc > 2 && strcmp(argv[2], "reset") == 0)
+        {
+            level = rt_hw_interrupt_disable();
+            memset(&lcd_link_stat, 0, sizeof(lcd_link_stat));
+            lcd_link_stat.reset_tick = now;
+            lcd_link_stat.lp_start_tick = now;
+            rt_hw_interrupt_enable(level);
+        }
+    }
+    else if (strcmp(argv[1], "bench") == 0)
+    {
+        LCDC_LayerCfgTypeDef *p_layer = &drv_lcd.hlcdc.Layer[drv_lcd.select_layer];
+        uint32_t i, n = (argc > 2) ? strtoul(argv[2], 0, 10) : 60;
+        uint32_t start;
+
+        if (!p_layer->data)
+        {
+            DEBUG_PRINTF("No layer data, draw a frame first\n");
+            return RT_EOK;
+        }
+        //Resend last layer n times back to back, then show statistics of them
+        memset(&lcd_link_stat, 0, sizeof(lcd_link_stat));
+        start = rt_tick_get();
+        lcd_link_stat.reset_tick = start;
+        lcd_link_stat.lp_start_tick = start;
+        for (i = 0; i < n; i++)
+        {
+            api_lcd_draw_rect((const char *)p_layer->data, p_layer->data_area.x0, p_layer->data_area.y0,
+                              p_layer->data_area.x1, p_layer->data_area.y1);
+        }
+        DEBUG_PRINTF("%d frames in %d ticks\n", n, rt_tick_get() - start);
+        {
+            char *args[] = {"lcd_ctrl", "linkstat"};
+            lcd_ctrl(2, args);
+        }
+    }
+#ifdef COPY2COMPRESS_FB_AND_SEND
+    else if (strcmp(argv[1], "fbstat") == 0)
+    {
+        frame_buf_stat_t *stat = &compress_fb_ctx.stat;
+        uint32_t frames = stat->frames ? stat->frames : 1;
+
+        DEBUG_PRINTF("compressed fb num %d: frames %d, dropped %d, copy overlapped with LCDC %d\n",
+                     COMPRESSED_FRAME_BUF_NUM, stat->frames, stat->dropped, stat->overlap);
+        DEBUG_PRINTF("wait LCDC avg %d max %d ticks, send avg %d max %d ticks\n",
+                     stat->wait_ticks / frames, stat->wait_max, stat->xfer_ticks / frames, stat->xfer_max);
+        if (argc > 2 && strcmp(argv[2], "reset") == 0)
+            memset(stat, 0, sizeof(*stat));
+    }
+#endif /* COPY2COMPRESS_FB_AND_SEND */
 
 
 
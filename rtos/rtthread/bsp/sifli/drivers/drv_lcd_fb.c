@@ -69,6 +69,15 @@
 #define LOG_TAG                "drv.lcd_fb"
 #include "log.h"
 
+/*Max separated damage rectangles of one frame, merged to bounding box if exceeded*/
+#ifndef LCD_FB_DAMAGE_RECT_MAX
+    #define LCD_FB_DAMAGE_RECT_MAX  4
+#endif
+/*Cost of one more LCD transaction(set window, restart LCDC) in pixels*/
+#ifndef LCD_FB_RECT_COST_PIXELS
+    #define LCD_FB_RECT_COST_PIXELS 512
+#endif
+
 #define FB_COPY_EXP_MS   (1000)
 #define FB_FLUSH_EXP_MS   (5000)
 #define AreaString "x0y0x1y1=[%d,%d,%d,%d]"
@@ -103,6 +112,15 @@ typedef struct
     lcd_fb_desc_t  fb;     /*Framebuffer description*/
     LCD_AreaDef window;    /*LCD recieve area, origin is LCD's TL*/
 
+    LCD_AreaDef damage[LCD_FB_DAMAGE_RECT_MAX]; /*Written areas not flushed yet, part of 'window'*/
+    uint8_t     damage_num;
+    LCD_AreaDef flush_rects[LCD_FB_DAMAGE_RECT_MAX]; /*Flushing areas of this frame, sorted by y0*/
+    uint8_t     flush_num;
+    uint8_t     flush_idx;
+    //Valid lines limit while flushing, lines of pending flush rects are not writable.
+    int32_t scheme6_limit_y1;
+    drv_lcd_fb_stat_t stat;
+
     uint8_t  flushing_lcd;
 
     //Writeable lines [0 ~ scheme6_valid_y1],  if 'scheme6_valid_y1' is -1 means no valid lines
@@ -192,6 +210,80 @@ static bool is_area_valid(const LCD_AreaDef *a0_p)
     return ((a0_p->x0 <= a0_p->x1) && (a0_p->y0 <= a0_p->y1));
 }
 
+static uint32_t area_size(const LCD_AreaDef *a)
+{
+    return (uint32_t)(a->x1 - a->x0 + 1) * (uint32_t)(a->y1 - a->y0 + 1);
+}
+
+static void area_join(LCD_AreaDef *res_p, const LCD_AreaDef *a0_p, const LCD_AreaDef *a1_p)
+{
+    res_p->x0 = HAL_MIN(a0_p->x0, a1_p->x0);
+    res_p->y0 = HAL_MIN(a0_p->y0, a1_p->y0);
+    res_p->x1 = HAL_MAX(a0_p->x1, a1_p->x1);
+    res_p->y1 = HAL_MAX(a0_p->y1, a1_p->y1);
+}
+
+static uint32_t fb_bytes_per_pixel(void)
+{
+    return (RTGRAPHIC_PIXEL_FORMAT_RGB888 == drv_lcd_fb.fb.format) ? 3 : 2;
+}
+
+/*
+    Extra cost(in pixels) if 'a0_p' and 'a1_p' are flushed as their bounding box
+    instead of 2 transactions, negative value means merging is cheaper.
+*/
+static int32_t merge_cost(const LCD_AreaDef *a0_p, const LCD_AreaDef *a1_p)
+{
+    LCD_AreaDef join_area;
+
+    area_join(&join_area, a0_p, a1_p);
+
+    return (int32_t)area_size(&join_area) - (int32_t)area_size(a0_p) - (int32_t)area_size(a1_p)
+           - LCD_FB_RECT_COST_PIXELS;
+}
+
+static void damage_add(const LCD_AreaDef *area)
+{
+    uint32_t align = (drv_lcd_fb.lcd_info.draw_align > 0) ? drv_lcd_fb.lcd_info.draw_align : 1;
+    LCD_AreaDef new_area;
+
+    //Align to panel constraints, the same as LVGL rounder
+    new_area.x0 = RT_ALIGN_DOWN(area->x0, align);
+    new_area.y0 = RT_ALIGN_DOWN(area->y0, align);
+    new_area.x1 = RT_ALIGN(area->x1 + 1, align) - 1;
+    new_area.y1 = RT_ALIGN(area->y1 + 1, align) - 1;
+
+    while (1)
+    {
+        int32_t best_cost = INT32_MAX;
+        int32_t best_idx = -1;
+
+        for (uint32_t i = 0; i < drv_lcd_fb.damage_num; i++)
+        {
+            int32_t cost = merge_cost(&drv_lcd_fb.damage[i], &new_area);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_idx = i;
+            }
+        }
+
+        if ((best_idx >= 0) && ((best_cost <= 0) || (drv_lcd_fb.damage_num >= LCD_FB_DAMAGE_RECT_MAX)))
+        {
+            //Merge and check again, as the merged rect may cover others.
+            area_join(&new_area, &new_area, &drv_lcd_fb.damage[best_idx]);
+            drv_lcd_fb.damage_num--;
+            drv_lcd_fb.damage[best_idx] = drv_lcd_fb.damage[drv_lcd_fb.damage_num];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    drv_lcd_fb.damage[drv_lcd_fb.damage_num++] = new_area;
+}
+
 static void LCD_area_to_EPIC_area(const LCD_AreaDef *lcd_a, EPIC_AreaTypeDef *epic_a)
 {
     epic_a->x0 = (int16_t)lcd_a->x0;
@@ -262,7 +354,7 @@ void HAL_LCDC_SendLineCpltCbk(LCDC_HandleTypeDef *lcdc, uint32_t line)
     {
         RT_ASSERT(drv_lcd_fb.scheme6_y0 != INT32_MIN);
         LOG_D("SendLineCpltCbk %d \r\n", drv_lcd_fb.scheme6_y0 + line);
-        set_valid_y(drv_lcd_fb.scheme6_y0 + line);
+        set_valid_y(HAL_MIN(drv_lcd_fb.scheme6_y0 + (int32_t)line, drv_lcd_fb.scheme6_limit_y1));
     }
 
 }
@@ -288,12 +380,15 @@ static void SystemView_mark_stop(uint32_t id)
 }
 #endif
 
+static rt_err_t fb_flush_next(void);
+
 static rt_err_t fb_flush_done(rt_device_t dev, void *buffer)
 {
     rt_err_t err;
 
     drv_lcd_fb.flush_end_tick = rt_tick_get();
     drv_lcd_fb.dbg_flush_rsp++;
+    drv_lcd_fb.stat.flush_ticks += drv_lcd_fb.flush_end_tick - drv_lcd_fb.flush_start_tick;
     LOG_D("fb_flush_done %p, cost=%d ticks", buffer, drv_lcd_fb.flush_end_tick - drv_lcd_fb.flush_start_tick);
 #ifdef PKG_USING_SYSTEMVIEW
     SystemView_mark_stop(FLUSH_LCD_SYSTEMVIEW_MARK_ID);
@@ -301,6 +396,10 @@ static rt_err_t fb_flush_done(rt_device_t dev, void *buffer)
 
     if (drv_lcd_fb.fb.p_data == buffer)
     {
+        //Continue with next damage rect of this frame
+        if (drv_lcd_fb.flush_idx < drv_lcd_fb.flush_num)
+            return fb_flush_next();
+
         drv_lcd_fb.flushing_lcd = 0;
         drv_lcd_fb.scheme6_y0 = INT32_MIN;
         set_valid_y(drv_lcd_fb.fb.area.y1);
@@ -310,19 +409,39 @@ static rt_err_t fb_flush_done(rt_device_t dev, void *buffer)
     return err;
 }
 
-static rt_err_t fb_flush_start(void)
+static rt_err_t fb_flush_next(void)
 {
-    rt_err_t err;
+    rt_err_t err = RT_EOK;
     rt_device_t p_lcd_dev = drv_lcd_fb.p_lcd_dev;
-    LCD_AreaDef *p_win_area = &drv_lcd_fb.window;
     LCD_AreaDef *p_fb_area = &drv_lcd_fb.fb.area;
     LCD_AreaDef common_area;/*Relative area of FB will be flushed*/
+    LCD_AreaDef *p_win_area = NULL;
 
+    while (drv_lcd_fb.flush_idx < drv_lcd_fb.flush_num)
+    {
+        LCD_AreaDef *p_rect = &drv_lcd_fb.flush_rects[drv_lcd_fb.flush_idx++];
 
-    if (area_intersect(&common_area, p_win_area, p_fb_area))
+        if (area_intersect(&common_area, p_rect, p_fb_area))
+        {
+            p_win_area = p_rect;
+            break;
+        }
+
+        LOG_D("NoIntersect window:"AreaString" fb:"AreaString" p_data=%p",
+              AreaParams(p_rect), AreaParams(p_fb_area), drv_lcd_fb.fb.p_data);
+    }
+
+    if (p_win_area)
     {
         lcd_flush_info_t flush_info;
-        set_valid_y(common_area.y0 - p_fb_area->y0 - 1);
+
+        //Lines of the following rects are not flushed yet.
+        if (drv_lcd_fb.flush_idx < drv_lcd_fb.flush_num)
+            drv_lcd_fb.scheme6_limit_y1 = drv_lcd_fb.flush_rects[drv_lcd_fb.flush_idx].y0 - p_fb_area->y0 - 1;
+        else
+            drv_lcd_fb.scheme6_limit_y1 = INT32_MAX;
+
+        set_valid_y(HAL_MIN(common_area.y0 - p_fb_area->y0 - 1, drv_lcd_fb.scheme6_limit_y1));
         drv_lcd_fb.scheme6_y0 = common_area.y0 - p_fb_area->y0;
 
 
@@ -330,13 +449,23 @@ static rt_err_t fb_flush_start(void)
         drv_lcd_fb.flush_start_tick = rt_tick_get();
         drv_lcd_fb.dbg_flush_req++;
 
+        drv_lcd_fb.stat.rect_cnt++;
+        drv_lcd_fb.stat.bytes += area_size(&common_area) * fb_bytes_per_pixel();
+
+        if (drv_lcd_fb.flush_idx > 1)
+        {
+            //Only the first rect of one frame waits TE, the others follow it immediately.
+            uint8_t te_on = 0;
+            rt_device_control(p_lcd_dev, RTGRAPHIC_CTRL_SET_NEXT_TE, &te_on);
+        }
+
         //Flush to lcd
         rt_device_set_tx_complete(drv_lcd_fb.p_lcd_dev, fb_flush_done);
 
         flush_info.cmpr_rate = drv_lcd_fb.fb.cmpr_rate;
         flush_info.pixel      = drv_lcd_fb.fb.p_data;
         flush_info.color_format    = drv_lcd_fb.fb.format;
-        memcpy(&flush_info.window, &drv_lcd_fb.window, sizeof(flush_info.window));
+        memcpy(&flush_info.window, p_win_area, sizeof(flush_info.window));
         memcpy(&flush_info.pixel_area, &drv_lcd_fb.fb.area, sizeof(flush_info.pixel_area));
 
 #ifdef PKG_USING_SYSTEMVIEW
@@ -353,16 +482,70 @@ static rt_err_t fb_flush_start(void)
     }
     else
     {
-        LOG_D("NoIntersect window:"AreaString" fb:"AreaString" p_data=%p",
-              AreaParams(p_fb_area), AreaParams(p_win_area), drv_lcd_fb.fb.p_data);
         fb_flush_done(drv_lcd_fb.p_lcd_dev, drv_lcd_fb.fb.p_data);
     }
 
+    return err;
+}
+
+static bool is_damage_split_cheaper(void)
+{
+    uint32_t sum = 0;
+
+    /*
+        Compressed FB must be sent in whole lines,
+        and there is no gain to split if only one damage rect.
+    */
+    if ((drv_lcd_fb.damage_num <= 1) || (0 != drv_lcd_fb.fb.cmpr_rate) || !is_area_valid(&drv_lcd_fb.window))
+        return false;
+
+    for (uint32_t i = 0; i < drv_lcd_fb.damage_num; i++)
+        sum += area_size(&drv_lcd_fb.damage[i]) + LCD_FB_RECT_COST_PIXELS;
+
+    return (sum < area_size(&drv_lcd_fb.window) + LCD_FB_RECT_COST_PIXELS);
+}
+
+static rt_err_t fb_flush_start(void)
+{
+    uint32_t pushed = 0;
+
+    if (is_damage_split_cheaper())
+    {
+        //Sort by y0, so that flushed lines are in order.
+        for (uint32_t i = 0; i < drv_lcd_fb.damage_num; i++)
+        {
+            uint32_t j = i;
+            LCD_AreaDef rect = drv_lcd_fb.damage[i];
+
+            while ((j > 0) && (drv_lcd_fb.flush_rects[j - 1].y0 > rect.y0))
+            {
+                drv_lcd_fb.flush_rects[j] = drv_lcd_fb.flush_rects[j - 1];
+                j--;
+            }
+            drv_lcd_fb.flush_rects[j] = rect;
+            pushed += area_size(&rect);
+        }
+        drv_lcd_fb.flush_num = drv_lcd_fb.damage_num;
+    }
+    else
+    {
+        drv_lcd_fb.flush_rects[0] = drv_lcd_fb.window;
+        drv_lcd_fb.flush_num = 1;
+        if (is_area_valid(&drv_lcd_fb.window)) pushed = area_size(&drv_lcd_fb.window);
+    }
+    drv_lcd_fb.flush_idx = 0;
+
+    drv_lcd_fb.stat.frame_cnt++;
+    drv_lcd_fb.stat.last_rects = drv_lcd_fb.flush_num;
+    drv_lcd_fb.stat.last_bytes = pushed * fb_bytes_per_pixel();
+    if (is_area_valid(&drv_lcd_fb.window))
+        drv_lcd_fb.stat.saved_bytes += (area_size(&drv_lcd_fb.window) - pushed) * fb_bytes_per_pixel();
 
     //Mark current window is flushed.
     memcpy(&drv_lcd_fb.window, &invalid_area, sizeof(LCD_AreaDef));
+    drv_lcd_fb.damage_num = 0;
 
-    return err;
+    return fb_flush_next();
 }
 
 
@@ -545,6 +728,7 @@ static rt_err_t write_fb_async(LCD_AreaDef *clip_area, LCD_AreaDef *src_area, co
     //src_line_addr, dst_line_addr, len are all after clipped
     uint32_t src_line_addr, dst_line_addr, len, bytes_per_pixel;
     uint32_t width, height, src_width;
+    LCD_AreaDef line_area;
 
 
     switch (drv_lcd_fb.fb.format)
@@ -561,6 +745,24 @@ static rt_err_t write_fb_async(LCD_AreaDef *clip_area, LCD_AreaDef *src_area, co
         break;
     }
 
+    if (drv_lcd_fb.fb.cmpr_rate != 0)
+    {
+        /*
+            Each line of compressed FB has fixed size and must be compressed as a whole,
+            so partial update rewrites affected lines only, with full width of source.
+        */
+        if ((src_area->x0 != dst_area->x0) || (src_area->x1 != dst_area->x1))
+        {
+            LOG_E("Compressed FB needs full width src:"AreaString" fb:"AreaString, AreaParams(src_area), AreaParams(dst_area));
+            cb();
+            return -RT_EINVAL;
+        }
+        memcpy(&line_area, clip_area, sizeof(line_area));
+        line_area.x0 = src_area->x0;
+        line_area.x1 = src_area->x1;
+        clip_area = &line_area;
+    }
+
     src_width = src_area->x1 - src_area->x0 + 1;
     width  = clip_area->x1  - clip_area->x0 + 1;
     height = clip_area->y1  - clip_area->y0 + 1;
@@ -573,6 +775,16 @@ static rt_err_t write_fb_async(LCD_AreaDef *clip_area, LCD_AreaDef *src_area, co
                     + (clip_area->y0 - drv_lcd_fb.fb.area.y0) * drv_lcd_fb.fb.line_bytes;
     len = bytes_per_pixel * width * height;
 
+    if (drv_lcd_fb.fb.cmpr_rate != 0)
+    {
+        drv_lcd_fb.stat.cmpr_lines += height;
+        drv_lcd_fb.stat.write_bytes += height * drv_lcd_fb.fb.line_bytes;
+    }
+    else
+    {
+        drv_lcd_fb.stat.write_bytes += len;
+    }
+
     LOG_D("clip area:"AreaString" src area:"AreaString" src=%p", AreaParams(clip_area), AreaParams(src_area), src);
     LOG_D("src_line_addr=0x%x dst_line_addr=0x%x len=0x%x", src_line_addr, dst_line_addr, len);
 
@@ -834,6 +1046,7 @@ uint32_t drv_lcd_fb_init(const char *lcd_dev_name)
     RT_ASSERT(err == RT_EOK);
 
     drv_lcd_fb.dma_faster_than_lcdc = 1; //Assume that DMA copy always fater than LCDC
+    drv_lcd_fb.scheme6_limit_y1 = INT32_MAX;
     return RT_EOK;
 }
 
@@ -849,6 +1062,10 @@ uint32_t drv_lcd_fb_set(lcd_fb_desc_t *fb_desc)
     {
         memcpy(&drv_lcd_fb.fb, fb_desc, sizeof(lcd_fb_desc_t));
         memcpy(&drv_lcd_fb.window, &invalid_area, sizeof(LCD_AreaDef));
+        drv_lcd_fb.damage_num = 0;
+        drv_lcd_fb.flush_num = 0;
+        drv_lcd_fb.flush_idx = 0;
+        drv_lcd_fb.scheme6_limit_y1 = INT32_MAX;
         drv_lcd_fb.scheme6_y0 = INT32_MIN;
         drv_lcd_fb.scheme6_valid_y1 = drv_lcd_fb.fb.area.y1;
         drv_lcd_fb.flushing_lcd = 0;
@@ -946,7 +1163,8 @@ rt_err_t drv_lcd_fb_write_send(LCD_AreaDef *write_area, LCD_AreaDef *src_area, c
             //First time
             memcpy(&drv_lcd_fb.window, write_area, sizeof(LCD_AreaDef));
         }
-        LOG_D("Total window:"AreaString, AreaParams(&drv_lcd_fb.window));
+        damage_add(write_area);
+        LOG_D("Total window:"AreaString", %d damage rects", AreaParams(&drv_lcd_fb.window), drv_lcd_fb.damage_num);
 
 
         if (send)
@@ -984,4 +1202,48 @@ rt_err_t drv_lcd_fb_write_send(LCD_AreaDef *write_area, LCD_AreaDef *src_area, c
     return RT_EOK;
 }
 
+void drv_lcd_fb_get_stat(drv_lcd_fb_stat_t *stat, uint8_t reset)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    memcpy(stat, &drv_lcd_fb.stat, sizeof(drv_lcd_fb_stat_t));
+    if (reset) memset(&drv_lcd_fb.stat, 0, sizeof(drv_lcd_fb_stat_t));
+    rt_hw_interrupt_enable(level);
+
+    if (drv_lcd_fb.fb.p_data)
+    {
+        uint32_t lines = drv_lcd_fb.fb.area.y1 - drv_lcd_fb.fb.area.y0 + 1;
+
+        stat->fb_bytes = lines * drv_lcd_fb.fb.line_bytes;
+        stat->raw_fb_bytes = area_size(&drv_lcd_fb.fb.area) * fb_bytes_per_pixel();
+    }
+    else
+    {
+        stat->fb_bytes = 0;
+        stat->raw_fb_bytes = 0;
+    }
+}
+
+#ifdef RT_USING_FINSH
+static int lcd_fb_stat(int argc, char **argv)
+{
+    drv_lcd_fb_stat_t stat;
+    uint32_t frames;
+
+    drv_lcd_fb_get_stat(&stat, (argc > 1) && (0 == strcmp(argv[1], "reset")));
+    frames = stat.frame_cnt ? stat.frame_cnt : 1;
+
+    rt_kprintf("FB=%p cmpr=%d: %d bytes, %d if not compressed, saved %d bytes\n", drv_lcd_fb.fb.p_data,
+               drv_lcd_fb.fb.cmpr_rate, stat.fb_bytes, stat.raw_fb_bytes,
+               (stat.raw_fb_bytes > stat.fb_bytes) ? (stat.raw_fb_bytes - stat.fb_bytes) : 0);
+    rt_kprintf("frames %d, rects %d, pushed %d bytes(saved %d), last %d bytes in %d rects\n",
+               stat.frame_cnt, stat.rect_cnt, stat.bytes, stat.saved_bytes, stat.last_bytes, stat.last_rects);
+    rt_kprintf("written %d bytes to FB, %d lines recompressed, avg flush %d ticks per frame\n",
+               stat.write_bytes, stat.cmpr_lines, stat.flush_ticks / frames);
+    return 0;
+}
+MSH_CMD_EXPORT(lcd_fb_stat, Show LCD framebuffer statistics: lcd_fb_stat [reset]);
+#endif /* RT_USING_FINSH */
+
 #endif /* BSP_USING_LCD_FRAMEBUFFER */
@@ -60,6 +60,21 @@ typedef struct
 
 typedef void (*write_fb_cbk)(lcd_fb_desc_t *fb_desc);
 
+typedef struct
+{
+    uint32_t frame_cnt;   /*Flushed frames*/
+    uint32_t rect_cnt;    /*LCD transactions of all frames*/
+    uint32_t bytes;       /*Bytes pushed to LCD of all frames*/
+    uint32_t saved_bytes; /*Bytes saved compared with flushing bounding box of each frame*/
+    uint32_t last_bytes;  /*Bytes pushed of last frame*/
+    uint32_t last_rects;  /*Transactions of last frame*/
+    uint32_t write_bytes; /*Bytes written to FB, compressed size if FB is compressed*/
+    uint32_t cmpr_lines;  /*Lines recompressed by partial updates of compressed FB*/
+    uint32_t flush_ticks; /*Ticks of LCD transactions of all frames*/
+    uint32_t fb_bytes;    /*Size of current FB, filled by drv_lcd_fb_get_stat*/
+    uint32_t raw_fb_bytes;/*Size of current FB if not compressed, filled by drv_lcd_fb_get_stat*/
+} drv_lcd_fb_stat_t;
+
 uint32_t drv_lcd_fb_init(const char *lcd_dev_name);
 uint32_t drv_lcd_fb_deinit(void);
 uint32_t drv_lcd_fb_set(lcd_fb_desc_t *fb_desc);
@@ -74,6 +89,9 @@ rt_err_t drv_lcd_fb_write_send(LCD_AreaDef *write_area, LCD_AreaDef *src_area, c
 rt_err_t drv_lcd_fb_get_write_area(LCD_AreaDef *write_area, int32_t wait_ms);
 rt_err_t drv_lcd_fb_send(write_fb_cbk cb);
 
+//Get flushing statistics, reset them if 'reset' is not 0
+void drv_lcd_fb_get_stat(drv_lcd_fb_stat_t *stat, uint8_t reset);
+
 #endif
 
 
@@ -54,6 +54,7 @@
 #include "drv_ext_dma.h"
 #include "mem_section.h"
 #include "string.h"
+#include "sysview_trace.h"
 
 #define  DBG_LEVEL            DBG_ERROR  //DBG_LOG //
 #define LOG_TAG                "drv.lcdp"
@@ -82,7 +83,9 @@ void LCDC1_IRQHandler(void)
         lcdc =  get_drv_lcd_handler();
 
     RT_ASSERT(RT_NULL != lcdc);
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_LCDC, 0, 0);
     HAL_LCDC_IRQHandler(lcdc);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_LCDC);
 
     if (lcdc->ErrorCode)
     {
@@ -59,6 +59,7 @@
 #include "drv_config.h"
 #include "bf0_hal_mailbox.h"
 #include "mailbox_config.h"
+#include "sysview_trace.h"
 
 #define LOG_TAG             "drv.mailbox"
 #include <drv_log.h>
@@ -373,7 +374,9 @@ void LCPU2HCPU_IRQHandler(void)
 {
     /* enter interrupt */
     rt_interrupt_enter();
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_MAILBOX, L2H_MAILBOX, 0);
     mailbox_isr(L2H_MAILBOX);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_MAILBOX);
     /* leave interrupt */
     rt_interrupt_leave();
 }
@@ -386,7 +389,9 @@ __ROM_USED void HCPU2LCPU_IRQHandler(void)
 {
     /* enter interrupt */
     rt_interrupt_enter();
+    SYSVIEW_TRACE_ENTER(SYSVIEW_TRACE_MAILBOX, H2L_MAILBOX, 0);
     mailbox_isr(H2L_MAILBOX);
+    SYSVIEW_TRACE_EXIT(SYSVIEW_TRACE_MAILBOX);
     /* leave interrupt */
     rt_interrupt_leave();
 }
@@ -68,6 +68,17 @@
 
 static NNACC_HandleTypeDef nn_acc = {.instance = hwp_nnacc};
 
+#ifdef BSP_USING_LAZY_DEV
+#include "drv_lazy_dev.h"
+
+static drv_lazy_dev_t nn_acc_lazy;
+
+/* No close in nn_acc API, accelerator is kept powered once used */
+#define NN_ACC_ENSURE_UP()  \
+    do { if (!DRV_LAZY_DEV_IS_UP(&nn_acc_lazy) && (drv_lazy_dev_get(&nn_acc_lazy) != RT_EOK)) return RT_ERROR; } while (0)
+#else
+#define NN_ACC_ENSURE_UP()
+#endif /* BSP_USING_LAZY_DEV */
 
 
 void NNACC_IRQHandler(void)
@@ -82,6 +93,7 @@ rt_err_t nn_acc_start(NNACC_ConfigTypeDef *config)
 {
     HAL_StatusTypeDef ret;
 
+    NN_ACC_ENSURE_UP();
     ret = HAL_NNACC_Start(&nn_acc, config);
 
     if (HAL_OK == ret)
@@ -99,6 +111,7 @@ rt_err_t nn_acc_start_IT(NNACC_ConfigTypeDef *config, nn_acc_cbk cbk)
 {
     HAL_StatusTypeDef ret;
 
+    NN_ACC_ENSURE_UP();
 #ifdef SOC_BF0_HCPU
     NVIC_EnableIRQ(NNACC_IRQn);
 #else
@@ -124,7 +137,7 @@ NNACC_HandleTypeDef *drv_get_nnacc_handle()
     return &nn_acc;
 }
 
-int nn_acc_init(void)
+static rt_err_t nn_acc_hw_init(void)
 {
     HAL_StatusTypeDef ret = RT_ERROR;
 
@@ -140,6 +153,29 @@ int nn_acc_init(void)
         return RT_ERROR;
     }
 }
+
+#ifdef BSP_USING_LAZY_DEV
+static rt_err_t nn_acc_lazy_init(drv_lazy_dev_t *ldev)
+{
+    return nn_acc_hw_init();
+}
+
+static const drv_lazy_dev_ops_t nn_acc_lazy_ops =
+{
+    .init = nn_acc_lazy_init,
+};
+#endif /* BSP_USING_LAZY_DEV */
+
+int nn_acc_init(void)
+{
+#ifdef BSP_USING_LAZY_DEV
+    /* Hardware is brought up in first nn_acc_start */
+    drv_lazy_dev_register(&nn_acc_lazy, "nnacc", &nn_acc_lazy_ops, NULL);
+    return RT_EOK;
+#else
+    return nn_acc_hw_init();
+#endif
+}
 INIT_BOARD_EXPORT(nn_acc_init);
 
 #endif /* BSP_USING_NN_ACC */
@@ -51,6 +51,7 @@
 #include <string.h>
 #include "board.h"
 #include "drv_config.h"
+#include "drv_pdm_audio.h"
 
 #if defined(BSP_USING_PDM) ||defined(_SIFLI_DOXYGEN_)
 
@@ -76,6 +77,14 @@ struct bf0_pdm_audio
     struct rt_audio_device audio_device;    /*!< parent  audio device registerd to OS*/
 
     PDM_HandleTypeDef hpdm;
+#ifdef BSP_PDM_FRAME_MODE
+    rt_uint16_t frame_size;                 /*!< bytes of one frame, 0 for record pipe mode*/
+    rt_uint8_t frame_num;                   /*!< frames in DMA ring*/
+    volatile rt_uint32_t frame_done;        /*!< frames written by DMA*/
+    volatile rt_uint32_t frame_rd;          /*!< frames given back by consumer*/
+    rt_uint32_t frame_held;                 /*!< frame got by consumer*/
+    rt_uint32_t frame_overrun;
+#endif
 };
 
 
@@ -87,10 +96,35 @@ struct bf0_pdm_audio
     static struct bf0_pdm_audio h_pdm_audio2;
 #endif /* BSP_USING_PDM2 */
 
+#ifdef BSP_PDM_FRAME_MODE
+static void pdm_frame_done(struct bf0_pdm_audio *hpdm_audio)
+{
+    rt_uint32_t half = hpdm_audio->frame_num / 2;
+
+    hpdm_audio->frame_done += half;
+    /* DMA goes on in the other half, frames there not given back yet are lost */
+    if (hpdm_audio->frame_done - hpdm_audio->frame_rd > half)
+    {
+        hpdm_audio->frame_overrun += hpdm_audio->frame_done - hpdm_audio->frame_rd - half;
+        hpdm_audio->frame_rd = hpdm_audio->frame_done - half;
+    }
+
+    if (hpdm_audio->audio_device.parent.rx_indicate != RT_NULL)
+        hpdm_audio->audio_device.parent.rx_indicate(&hpdm_audio->audio_device.parent, half * hpdm_audio->frame_size);
+}
+#endif /* BSP_PDM_FRAME_MODE */
+
 void HAL_PDM_RxCpltCallback(PDM_HandleTypeDef *hpdm)
 {
     struct bf0_pdm_audio *hpdm_audio = rt_container_of(hpdm, struct bf0_pdm_audio, hpdm);
     //LOG_I("HAL_PDM_RxCpltCallback\n");
+#ifdef BSP_PDM_FRAME_MODE
+    if (hpdm_audio->frame_size)
+    {
+        pdm_frame_done(hpdm_audio);
+        return;
+    }
+#endif
 #ifdef SF32LB55X
     if (32 == hpdm->Init.ChannelDepth)
     {
@@ -117,6 +151,13 @@ void HAL_PDM_RxHalfCpltCallback(PDM_HandleTypeDef *hpdm)
     struct bf0_pdm_audio *hpdm_audio = rt_container_of(hpdm, struct bf0_pdm_audio, hpdm);
 
     //LOG_I("HAL_PDM_RxHalfCpltCallback\n");
+#ifdef BSP_PDM_FRAME_MODE
+    if (hpdm_audio->frame_size)
+    {
+        pdm_frame_done(hpdm_audio);
+        return;
+    }
+#endif
 #ifdef SF32LB55X
     if (32 == hpdm->Init.ChannelDepth)
     {
@@ -451,6 +492,16 @@ static rt_err_t bf0_audio_start(struct rt_audio_device *audio, int stream)
         {
             hpdm->RxXferSize *= 2;
         }
+#ifdef BSP_PDM_FRAME_MODE
+        if (hpdm_audio->frame_size)
+        {
+            /* each half of DMA ring is frame_num / 2 whole frames */
+            hpdm->RxXferSize = hpdm_audio->frame_size * hpdm_audio->frame_num;
+            hpdm_audio->frame_done = 0;
+            hpdm_audio->frame_rd = 0;
+            hpdm_audio->frame_overrun = 0;
+        }
+#endif
         hpdm->pRxBuffPtr = (uint8_t *) calloc(1, hpdm->RxXferSize);
 
         if (NULL == hpdm->pRxBuffPtr)
@@ -570,6 +621,13 @@ static rt_err_t bf0_audio_stop(struct rt_audio_device *audio, int stream)
             free(hpdm->hdmarx);
             hpdm->hdmarx = NULL;
         }
+#ifdef BSP_PDM_FRAME_MODE
+        if (hpdm_audio->frame_overrun)
+        {
+            LOG_W("PDM frame overrun %d", hpdm_audio->frame_overrun);
+        }
+        hpdm_audio->frame_size = 0;
+#endif
     }
 
     return ret;
@@ -698,6 +756,73 @@ static const struct rt_audio_ops       _g_audio_ops =
 * @} PDM Audio_device
 */
 
+#ifdef BSP_PDM_FRAME_MODE
+rt_err_t bf0_pdm_frame_config(rt_device_t dev, rt_uint16_t frame_size, rt_uint8_t frame_num)
+{
+    struct bf0_pdm_audio *hpdm_audio = (struct bf0_pdm_audio *) dev;
+
+    RT_ASSERT(dev);
+#ifdef SF32LB55X
+    /* 32bit data is shifted on copy to record pipe, could not be used in place */
+    if (32 == hpdm_audio->hpdm.Init.ChannelDepth)
+        return -RT_EINVAL;
+#endif
+    if (hpdm_audio->hpdm.pRxBuffPtr)
+        return -RT_EBUSY;
+    if (frame_size && (frame_num < 2 || (frame_num & 1) || (frame_size & 3)))
+        return -RT_EINVAL;
+
+    hpdm_audio->frame_size = frame_size;
+    hpdm_audio->frame_num = frame_num;
+
+    return RT_EOK;
+}
+
+rt_uint8_t *bf0_pdm_frame_get(rt_device_t dev, rt_size_t *size)
+{
+    struct bf0_pdm_audio *hpdm_audio = (struct bf0_pdm_audio *) dev;
+    rt_uint8_t *frame = RT_NULL;
+    rt_base_t level;
+
+    RT_ASSERT(dev);
+    level = rt_hw_interrupt_disable();
+    if (hpdm_audio->frame_size && hpdm_audio->frame_rd != hpdm_audio->frame_done)
+    {
+        hpdm_audio->frame_held = hpdm_audio->frame_rd;
+        frame = hpdm_audio->hpdm.pRxBuffPtr + (hpdm_audio->frame_rd % hpdm_audio->frame_num) * hpdm_audio->frame_size;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (frame)
+    {
+        mpu_dcache_invalidate(frame, hpdm_audio->frame_size);
+        if (size)
+            *size = hpdm_audio->frame_size;
+    }
+
+    return frame;
+}
+
+void bf0_pdm_frame_release(rt_device_t dev)
+{
+    struct bf0_pdm_audio *hpdm_audio = (struct bf0_pdm_audio *) dev;
+    rt_base_t level;
+
+    RT_ASSERT(dev);
+    level = rt_hw_interrupt_disable();
+    /* frame_rd is moved by interrupt if held frame was overrun */
+    if (hpdm_audio->frame_rd == hpdm_audio->frame_held && hpdm_audio->frame_rd != hpdm_audio->frame_done)
+        hpdm_audio->frame_rd++;
+    rt_hw_interrupt_enable(level);
+}
+
+rt_uint32_t bf0_pdm_frame_get_overrun(rt_device_t dev)
+{
+    RT_ASSERT(dev);
+    return ((struct bf0_pdm_audio *) dev)->frame_overrun;
+}
+#endif /* BSP_PDM_FRAME_MODE */
+
 /**
 * @brief  PDM Audio devices initialization
 */
@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file   drv_pdm_audio.h
+  * @author Sifli software development team
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __DRV_PDM_AUDIO_H__
+#define __DRV_PDM_AUDIO_H__
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <drv_common.h>
+
+int rt_bf0_pdm_audio_init(void);
+
+#ifdef BSP_PDM_FRAME_MODE
+#ifndef BSP_PDM_FRAME_NUM
+#define BSP_PDM_FRAME_NUM       (2)
+#endif
+
+/**
+ * @brief Capture into frame aligned DMA ring instead of record pipe, frames are processed in place.
+ *        Call after AUDIO_CTL_CONFIGURE and before AUDIO_CTL_START, configure is cleared when stopped.
+ *        rx_indicate is called in DMA interrupt each time frame_num / 2 frames are ready.
+ * @param dev - PDM audio device
+ * @param frame_size - bytes of one frame, e.g. 320 for 10ms mono or 1024 for 16ms stereo at 16K 16bit
+ * @param frame_num - frames in ring, even number, 2 for lowest latency
+ * @return RT_EOK if success
+ */
+rt_err_t bf0_pdm_frame_config(rt_device_t dev, rt_uint16_t frame_size, rt_uint8_t frame_num);
+
+/**
+ * @brief Get oldest ready frame, it is kept by caller until bf0_pdm_frame_release().
+ * @param size - output bytes of frame, could be NULL
+ * @return frame, or NULL if no frame is ready
+ */
+rt_uint8_t *bf0_pdm_frame_get(rt_device_t dev, rt_size_t *size);
+
+/** @brief Give frame from bf0_pdm_frame_get() back to DMA. */
+void bf0_pdm_frame_release(rt_device_t dev);
+
+/** @brief Frames dropped because consumer was late. */
+rt_uint32_t bf0_pdm_frame_get_overrun(rt_device_t dev);
+#endif /* BSP_PDM_FRAME_MODE */
+
+#endif /* __DRV_PDM_AUDIO_H__ */
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -72,6 +72,229 @@
 #endif
 
 
+#ifdef BSP_PSRAM_CALIB_CACHE
+/*
+ * Calibrated delay only depends on board, clock, voltage and temperature. Result is kept in
+ * factory config with that key, a matching record is applied and checked by a short write/read
+ * pattern, full calibration only runs if there is no record or the check fails.
+ */
+#include "drv_flash.h"
+#include "bf0_sys_cfg.h"
+
+#ifndef PSRAM_CALIB_TEMP_WINDOW
+    #define PSRAM_CALIB_TEMP_WINDOW     (20)
+#endif
+
+#define PSRAM_CALIB_CHECK_WORDS         (64)
+#define PSRAM_CALIB_TEMP_NONE           (-128)
+
+typedef struct
+{
+    uint16_t hit;
+    uint16_t miss;
+    uint32_t fast_us;       /* last calibration applied from record */
+    uint32_t saved_us;      /* sum of full calibration time avoided */
+} psram_calib_stat_t;
+
+static FACTORY_CFG_PSRAM_CAL_T psram_calib_cfg;
+static uint8_t psram_calib_loaded;
+static psram_calib_stat_t psram_calib_stat;
+static uint32_t psram_calib_save[PSRAM_CALIB_CHECK_WORDS];
+
+static int8_t psram_calib_temperature(void)
+{
+#if defined(HAL_TSEN_MODULE_ENABLED) && defined(hwp_tsen)
+    TSEN_HandleTypeDef htsen;
+    int temp;
+
+    memset(&htsen, 0, sizeof(htsen));
+    htsen.Instance = hwp_tsen;
+    if (HAL_TSEN_Init(&htsen) != HAL_OK)
+        return PSRAM_CALIB_TEMP_NONE;
+    temp = HAL_TSEN_Read(&htsen);
+    HAL_TSEN_DeInit(&htsen);
+
+    return (int8_t)temp;
+#else
+    return PSRAM_CALIB_TEMP_NONE;
+#endif
+}
+
+static uint8_t psram_calib_dvfs(void)
+{
+#if defined(SF32LB52X) && defined(SOC_BF0_HCPU)
+    return (uint8_t)HAL_RCC_HCPU_GetCurrentDvfsMode() + 1;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t psram_calib_us(uint32_t cycles)
+{
+    return cycles / (HAL_RCC_GetHCLKFreq(CORE_ID_DEFAULT) / 1000000);
+}
+
+static FACTORY_CFG_PSRAM_CAL_ITEM_T *psram_calib_find(FACTORY_CFG_PSRAM_CAL_ITEM_T *key, int alloc)
+{
+    FACTORY_CFG_PSRAM_CAL_ITEM_T *item;
+    FACTORY_CFG_PSRAM_CAL_ITEM_T *slot = NULL;
+    int i, dt;
+
+    if (!psram_calib_loaded)
+    {
+        if (rt_flash_config_read(FACTORY_CFG_ID_PSRAM_CAL, (uint8_t *)&psram_calib_cfg, sizeof(psram_calib_cfg)) != sizeof(psram_calib_cfg))
+            memset(&psram_calib_cfg, 0, sizeof(psram_calib_cfg));
+        psram_calib_loaded = 1;
+    }
+
+    for (i = 0; i < FACTORY_CFG_PSRAM_CAL_NUM; i++)
+    {
+        item = &psram_calib_cfg.item[i];
+        if (item->clk == 0 || item->psram_id != key->psram_id)
+        {
+            if (slot == NULL && item->clk == 0)
+                slot = item;
+            continue;
+        }
+        dt = item->temp - key->temp;
+        if (item->clk == key->clk && item->dvfs == key->dvfs
+                && (key->temp == PSRAM_CALIB_TEMP_NONE || (dt < PSRAM_CALIB_TEMP_WINDOW && dt > -PSRAM_CALIB_TEMP_WINDOW)))
+            return item;
+        /* keep one record per controller, replace it when condition changed */
+        slot = item;
+    }
+
+    return alloc ? slot : NULL;
+}
+
+/* Write pattern toggling all bits to start of PSRAM and read it back, called with interrupt disabled */
+static int psram_calib_check(uint32_t base)
+{
+    volatile uint32_t *p = (volatile uint32_t *)base;
+    uint32_t i, v;
+    int ok = 1;
+
+    for (i = 0; i < PSRAM_CALIB_CHECK_WORDS; i++)
+    {
+        v = i * 0x9E3779B9;
+        p[i] = (i & 1) ? ~v : v;
+    }
+    SCB_CleanInvalidateDCache_by_Addr((void *)base, PSRAM_CALIB_CHECK_WORDS * 4);
+    for (i = 0; i < PSRAM_CALIB_CHECK_WORDS; i++)
+    {
+        v = i * 0x9E3779B9;
+        if (p[i] != ((i & 1) ? ~v : v))
+            ok = 0;
+    }
+
+    return ok;
+}
+
+static int psram_calib_cached(char *name, uint8_t *sck, uint8_t *dqs)
+{
+    FACTORY_CFG_PSRAM_CAL_ITEM_T key;
+    FACTORY_CFG_PSRAM_CAL_ITEM_T *item;
+    uint32_t base;
+    uint32_t start, cycles;
+    int level, res = -1, i;
+    int hit = 0;
+
+    if (name == NULL || name[0] == '\0')
+        return -1;
+    base = bsp_psram_get_base(name);
+    if (base == 0)
+        return -1;
+
+    memset(&key, 0, sizeof(key));
+    key.clk = bsp_psram_get_clk(base);
+    key.psram_id = (uint8_t)name[strlen(name) - 1];
+    key.dvfs = psram_calib_dvfs();
+    key.temp = psram_calib_temperature();
+    item = psram_calib_find(&key, 0);
+
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    level = rt_hw_interrupt_disable();
+    start = HAL_DBG_DWT_GetCycles();
+    for (i = 0; i < PSRAM_CALIB_CHECK_WORDS; i++)
+        psram_calib_save[i] = ((volatile uint32_t *)base)[i];
+
+    if (item && bsp_psram_set_delay(name, item->sck, item->dqs) == 0 && psram_calib_check(base))
+    {
+        *sck = item->sck;
+        *dqs = item->dqs;
+        hit = 1;
+        res = 0;
+    }
+    else
+    {
+        res = bsp_psram_auto_calib(name, sck, dqs);
+    }
+
+    for (i = 0; i < PSRAM_CALIB_CHECK_WORDS; i++)
+        ((volatile uint32_t *)base)[i] = psram_calib_save[i];
+    SCB_CleanDCache_by_Addr((void *)base, PSRAM_CALIB_CHECK_WORDS * 4);
+    cycles = HAL_DBG_DWT_GetCycles() - start;
+    rt_hw_interrupt_enable(level);
+
+    if (hit)
+    {
+        psram_calib_stat.hit++;
+        psram_calib_stat.fast_us = psram_calib_us(cycles);
+        if (item->full_us > psram_calib_stat.fast_us)
+            psram_calib_stat.saved_us += item->full_us - psram_calib_stat.fast_us;
+    }
+    else if (res == 0)
+    {
+        psram_calib_stat.miss++;
+        item = psram_calib_find(&key, 1);
+        if (item)
+        {
+            memcpy(item, &key, sizeof(key));
+            item->sck = *sck;
+            item->dqs = *dqs;
+            item->full_us = (uint16_t)psram_calib_us(cycles);
+            if (rt_flash_config_write(FACTORY_CFG_ID_PSRAM_CAL, (uint8_t *)&psram_calib_cfg, sizeof(psram_calib_cfg)) == 0)
+                rt_kprintf("psram calib record write fail\n");
+        }
+    }
+
+    return res;
+}
+
+#ifdef RT_USING_FINSH
+static int psram_cal(int argc, char **argv)
+{
+    uint8_t sck, dqs;
+    int i;
+
+    if (argc > 1)
+    {
+        if (rt_psram_auto_calib(argv[1], &sck, &dqs) != 0)
+        {
+            rt_kprintf("calibrate %s fail\n", argv[1]);
+            return -RT_ERROR;
+        }
+        rt_kprintf("%s sck %d dqs %d\n", argv[1], sck, dqs);
+    }
+
+    for (i = 0; i < FACTORY_CFG_PSRAM_CAL_NUM; i++)
+    {
+        FACTORY_CFG_PSRAM_CAL_ITEM_T *item = &psram_calib_cfg.item[i];
+        if (item->clk == 0)
+            continue;
+        rt_kprintf("psram%c clk %d dvfs %d temp %d: sck %d dqs %d, full %d us\n", item->psram_id, item->clk,
+                   item->dvfs, item->temp, item->sck, item->dqs, item->full_us);
+    }
+    rt_kprintf("hit %d miss %d, last cached %d us, saved %d us\n", psram_calib_stat.hit, psram_calib_stat.miss,
+               psram_calib_stat.fast_us, psram_calib_stat.saved_us);
+    return 0;
+}
+MSH_CMD_EXPORT(psram_cal, Calibrate PSRAM delay with cached record: psram_cal [psram1]);
+#endif /* RT_USING_FINSH */
+#endif /* BSP_PSRAM_CALIB_CACHE */
+
 /* -----------------output apis --------------------------------*/
 
 /**
@@ -134,12 +357,16 @@ int rt_psram_set_pasr(char *name, uint8_t top, uint8_t deno)
 
 int rt_psram_auto_calib(char *name, uint8_t *sck, uint8_t *dqs)
 {
+#ifdef BSP_PSRAM_CALIB_CACHE
+    return psram_calib_cached(name, sck, dqs);
+#else
     int res;
     int level = rt_hw_interrupt_disable();
     res = bsp_psram_auto_calib(name, sck, dqs);
     rt_hw_interrupt_enable(level);
 
     return res;
+#endif
 }
 
 void rt_psram_wait_idle(char *name)
@@ -147,6 +374,203 @@ void rt_psram_wait_idle(char *name)
     bsp_psram_wait_idle(name);
 }
 
+#ifdef BSP_USING_PSRAM_PASR_HEAP
+
+#if !defined(RT_USING_MEMHEAP) || !defined(RT_USING_PM)
+    #error "PSRAM PASR heap depends on RT_USING_MEMHEAP and RT_USING_PM"
+#endif
+
+static struct
+{
+    const psram_pasr_cfg_t *cfg;
+    struct rt_memheap retain;
+    struct rt_memheap transient;
+    uint8_t *transient_start;
+    uint32_t transient_size;
+    uint8_t deno;
+    bool dropped;
+    psram_pasr_stat_t stat;
+    struct
+    {
+        void (*flush)(void *user_data);
+        void *user_data;
+    } cb[PSRAM_PASR_FLUSH_CB_MAX];
+} psram_pasr;
+
+static bool psram_pasr_transient_empty(void)
+{
+    // Lock value checked too, a thread may be preempted inside heap operation
+    return (psram_pasr.transient.actual_used_size == 0) && (psram_pasr.transient.lock.value == 1);
+}
+
+static int psram_pasr_suspend(const struct rt_device *device, uint8_t mode)
+{
+    if (PM_SLEEP_MODE_STANDBY != mode)
+        return RT_EOK;
+
+    psram_pasr.stat.sleep_cnt++;
+    if (psram_pasr_transient_empty()
+            && (0 == rt_psram_set_pasr(psram_pasr.cfg->name, 0, psram_pasr.deno)))
+    {
+        psram_pasr.dropped = true;
+        psram_pasr.stat.pasr_cnt++;
+        psram_pasr.stat.last_refresh = psram_pasr.stat.min_refresh;
+    }
+    else
+    {
+        psram_pasr.stat.last_refresh = psram_pasr.cfg->chip_size;
+    }
+
+    return RT_EOK;
+}
+
+static void psram_pasr_resume(const struct rt_device *device, uint8_t mode)
+{
+    if (!psram_pasr.dropped)
+        return;
+
+    psram_pasr.dropped = false;
+    rt_psram_set_pasr(psram_pasr.cfg->name, 0, 1);
+
+    // Transient region content including heap header is lost, rebuild the empty heap
+    rt_memheap_detach(&psram_pasr.transient);
+    rt_memheap_init(&psram_pasr.transient, "pasr_tmp", psram_pasr.transient_start, psram_pasr.transient_size);
+}
+
+static const struct rt_device_pm_ops psram_pasr_pm_op =
+{
+    .suspend = psram_pasr_suspend,
+    .resume = psram_pasr_resume,
+};
+
+int rt_psram_pasr_heap_init(const psram_pasr_cfg_t *cfg)
+{
+    uint32_t pool_start, pool_end, boundary = 0;
+    uint8_t deno;
+
+    RT_ASSERT(cfg && cfg->name && cfg->retain_size);
+    RT_ASSERT(NULL == psram_pasr.cfg);
+
+    pool_start = (uint32_t)cfg->pool;
+    pool_end = pool_start + cfg->pool_size;
+    if ((pool_start < cfg->chip_base) || (pool_end != cfg->chip_base + cfg->chip_size))
+        return -RT_EINVAL;
+
+    // Largest denominator whose refreshed bottom part still covers retained region
+    for (deno = 16; deno >= 2; deno >>= 1)
+    {
+        boundary = cfg->chip_base + cfg->chip_size / deno;
+        if (boundary >= pool_start + cfg->retain_size)
+            break;
+    }
+    if ((deno < 2) || (boundary >= pool_end))
+        return -RT_EINVAL;
+
+    psram_pasr.cfg = cfg;
+    psram_pasr.deno = deno;
+    psram_pasr.transient_start = (uint8_t *)boundary;
+    psram_pasr.transient_size = pool_end - boundary;
+    psram_pasr.stat.min_refresh = cfg->chip_size / deno;
+
+    rt_memheap_init(&psram_pasr.retain, "pasr_ret", cfg->pool, boundary - pool_start);
+    rt_memheap_init(&psram_pasr.transient, "pasr_tmp", psram_pasr.transient_start, psram_pasr.transient_size);
+    rt_pm_device_register(NULL, &psram_pasr_pm_op);
+
+    rt_kprintf("pasr heap: retain 0x%x-0x%x, transient 0x%x-0x%x, refresh 1/%d\n", pool_start, boundary, boundary, pool_end, deno);
+
+    return RT_EOK;
+}
+
+void *rt_psram_pasr_alloc(rt_size_t size, bool transient)
+{
+    void *p = NULL;
+
+    RT_ASSERT(psram_pasr.cfg);
+
+    if (transient)
+        p = rt_memheap_alloc(&psram_pasr.transient, size);
+
+    // Retained data must never go to transient region
+    if (!p)
+        p = rt_memheap_alloc(&psram_pasr.retain, size);
+
+    return p;
+}
+
+void rt_psram_pasr_free(void *ptr)
+{
+    if (ptr)
+        rt_memheap_free(ptr);
+}
+
+int rt_psram_pasr_flush_register(void (*flush)(void *user_data), void *user_data)
+{
+    int i;
+    int r = -RT_EFULL;
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    for (i = 0; i < PSRAM_PASR_FLUSH_CB_MAX; i++)
+    {
+        if (NULL == psram_pasr.cb[i].flush)
+        {
+            psram_pasr.cb[i].flush = flush;
+            psram_pasr.cb[i].user_data = user_data;
+            r = RT_EOK;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return r;
+}
+
+bool rt_psram_pasr_flush(void)
+{
+    int i;
+
+    if (!psram_pasr.cfg)
+        return false;
+
+    for (i = 0; i < PSRAM_PASR_FLUSH_CB_MAX; i++)
+    {
+        if (psram_pasr.cb[i].flush)
+            psram_pasr.cb[i].flush(psram_pasr.cb[i].user_data);
+    }
+
+    if (psram_pasr.transient.actual_used_size)
+        rt_kprintf("pasr heap: %d bytes transient in use, refresh full\n", psram_pasr.transient.actual_used_size);
+
+    return psram_pasr_transient_empty();
+}
+
+void rt_psram_pasr_get_stat(psram_pasr_stat_t *stat)
+{
+    RT_ASSERT(stat);
+    *stat = psram_pasr.stat;
+}
+
+#ifdef RT_USING_FINSH
+static int cmd_psram_pasr(int argc, char **argv)
+{
+    if (!psram_pasr.cfg)
+    {
+        rt_kprintf("pasr heap not initialized\n");
+        return 0;
+    }
+    rt_kprintf("retain used %d/%d, transient used %d/%d\n",
+               psram_pasr.retain.actual_used_size, psram_pasr.retain.pool_size,
+               psram_pasr.transient.actual_used_size, psram_pasr.transient.pool_size);
+    rt_kprintf("standby %d, with pasr %d, last refreshed %d bytes, min %d bytes\n",
+               psram_pasr.stat.sleep_cnt, psram_pasr.stat.pasr_cnt,
+               psram_pasr.stat.last_refresh, psram_pasr.stat.min_refresh);
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_psram_pasr, psram_pasr, show psram pasr heap status);
+#endif /* RT_USING_FINSH */
+
+#endif /* BSP_USING_PSRAM_PASR_HEAP */
+
 
 //#define DRV_PSRAM_TEST
 #ifdef DRV_PSRAM_TEST
@@ -110,6 +110,78 @@ int rt_psram_auto_calib(char *name, uint8_t *sck, uint8_t *dqs);
 void rt_psram_wait_idle(char *name);
 #endif
 
+/* PSRAM heap split in retained (low) and transient (high) region, high region is
+   dropped from self-refresh by PASR in standby if nothing is allocated in it */
+//#define BSP_USING_PSRAM_PASR_HEAP
+#ifndef PSRAM_PASR_FLUSH_CB_MAX
+    #define PSRAM_PASR_FLUSH_CB_MAX     (4)
+#endif
+
+#if defined(BSP_USING_PSRAM_PASR_HEAP) || defined(_SIFLI_DOXYGEN_)
+/** PASR heap configuration */
+typedef struct
+{
+    char       *name;           /**< PSRAM controller name, e.g. "psram1" */
+    uint32_t    chip_base;      /**< start address of PSRAM device */
+    uint32_t    chip_size;      /**< size of PSRAM device */
+    void       *pool;           /**< heap pool, should end at the end of device */
+    uint32_t    pool_size;      /**< heap pool size */
+    uint32_t    retain_size;    /**< minimum size of retained region at pool bottom */
+} psram_pasr_cfg_t;
+
+/** PASR heap statistics */
+typedef struct
+{
+    uint32_t    sleep_cnt;      /**< standby entered */
+    uint32_t    pasr_cnt;       /**< standby entered with partial refresh */
+    uint32_t    last_refresh;   /**< bytes kept refreshed in last standby */
+    uint32_t    min_refresh;    /**< bytes kept refreshed if transient region is empty */
+} psram_pasr_stat_t;
+
+/**
+ * @brief Initialize PASR heap. Retained region is extended up to the nearest PASR boundary,
+ *        rest of pool is transient region.
+ * @param cfg heap configuration, must be valid during heap lifetime.
+ * @return RT_EOK if success, -RT_EINVAL if no PASR boundary fits in pool.
+ */
+int rt_psram_pasr_heap_init(const psram_pasr_cfg_t *cfg);
+
+/**
+ * @brief Allocate memory from PASR heap.
+ * @param size size to allocate.
+ * @param transient true if data can be dropped before sleep, e.g. frame cache or decode buffer,
+ *        it may be placed in retained region if transient region is full.
+ * @return allocated buffer, NULL if fail.
+ */
+void *rt_psram_pasr_alloc(rt_size_t size, bool transient);
+
+/**
+ * @brief Free memory allocated by rt_psram_pasr_alloc.
+ * @param ptr buffer to free.
+ */
+void rt_psram_pasr_free(void *ptr);
+
+/**
+ * @brief Register callback to release transient buffers, called by rt_psram_pasr_flush.
+ * @param flush callback.
+ * @param user_data parameter of callback.
+ * @return RT_EOK if success, -RT_EFULL if no slot.
+ */
+int rt_psram_pasr_flush_register(void (*flush)(void *user_data), void *user_data);
+
+/**
+ * @brief Call flush callbacks in thread context before system going to sleep.
+ * @return true if transient region is empty, PASR can be applied in standby.
+ */
+bool rt_psram_pasr_flush(void);
+
+/**
+ * @brief Get PASR heap statistics.
+ * @param stat statistics output.
+ */
+void rt_psram_pasr_get_stat(psram_pasr_stat_t *stat);
+#endif /* BSP_USING_PSRAM_PASR_HEAP */
+
 #ifdef __cplusplus
 }
 #endif
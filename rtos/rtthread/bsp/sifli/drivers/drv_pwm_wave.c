@@ -0,0 +1,260 @@
+/**
+  ******************************************************************************
+  * @file   drv_pwm_wave.c
+  * @author Sifli software development team
+  * @brief PWM duty cycle waveform playback by DMA
+  *
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#include <string.h>
+#include <stdlib.h>
+#include "drv_pwm_wave.h"
+
+#define DBG_TAG "pwm_wave"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+static void pwm_wave_start_dma(pwm_wave_t *wave)
+{
+    HAL_DMA_Start_IT(&wave->dma, (uint32_t)wave->cur->ccr,
+                     (uint32_t)(&wave->htim->Instance->CCR1 + (wave->channel - 1)), wave->cur->len);
+}
+
+/* End of one iteration in normal mode, start next iteration or pattern */
+static void pwm_wave_dma_cplt(DMA_HandleTypeDef *hdma)
+{
+    pwm_wave_t *wave = (pwm_wave_t *)hdma->Parent;
+
+    wave->irq_count++;
+    if (!wave->playing)
+        return;
+
+    if ((0 == wave->cur->loop) || (--wave->loop_left > 0))
+    {
+        pwm_wave_start_dma(wave);
+        return;
+    }
+    if (wave->cur->next)
+    {
+        wave->cur = wave->cur->next;
+        wave->loop_left = wave->cur->loop;
+        pwm_wave_start_dma(wave);
+        return;
+    }
+
+    /* Last sample stays in CCRx */
+    __HAL_GPT_DISABLE_DMA(wave->htim, GPT_DMA_UPDATE);
+    wave->playing = 0;
+    if (wave->done)
+        wave->done(wave);
+}
+
+rt_err_t pwm_wave_init(pwm_wave_t *wave, const char *name, uint8_t channel, uint32_t period_ns,
+                       uint16_t hold, uint32_t dma_request)
+{
+#ifdef DMA_SUPPORT_DYN_CHANNEL_ALLOC
+    struct rt_device_pwm *dev;
+    rt_err_t err;
+
+    if (!wave || !name || (channel < 1) || (channel > 4) || (hold < 1))
+        return -RT_EINVAL;
+
+    dev = (struct rt_device_pwm *)rt_device_find(name);
+    if (!dev || (RT_Device_Class_Miscellaneous != dev->parent.type))
+        return -RT_ERROR;
+
+    memset(wave, 0, sizeof(*wave));
+    wave->dev = dev;
+    wave->htim = (GPT_HandleTypeDef *)dev->parent.user_data;
+    wave->channel = channel;
+
+    if (hold > 1)
+    {
+#ifdef HAL_ATIM_MODULE_ENABLED
+        if (IS_GPT_ADVANCED_INSTANCE(wave->htim->Instance) == RESET)
+#endif
+        {
+            LOG_E("%s: hold needs advanced timer", name);
+            return -RT_EINVAL;
+        }
+    }
+
+    err = rt_pwm_set(dev, channel, period_ns, 0);
+    if (RT_EOK == err)
+        err = rt_pwm_enable(dev, channel);
+    if (RT_EOK != err)
+        return err;
+
+    if (hold > 1)
+    {
+        /* Update event and DMA request every hold periods */
+        wave->htim->Instance->RCR = hold - 1;
+        HAL_GPT_GenerateEvent(wave->htim, GPT_EVENTSOURCE_UPDATE);
+    }
+    wave->top = __HAL_GPT_GET_AUTORELOAD(wave->htim) + 1;
+
+    /* Channel is allocated dynamically */
+    wave->dma.Instance                 = DMA1_Channel1;
+    wave->dma.Init.Request             = dma_request;
+    wave->dma.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    wave->dma.Init.PeriphInc           = DMA_PINC_DISABLE;
+    wave->dma.Init.MemInc              = DMA_MINC_ENABLE;
+    wave->dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    wave->dma.Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+    wave->dma.Init.Mode                = DMA_NORMAL;
+    wave->dma.Init.Priority            = DMA_PRIORITY_LOW;
+    wave->dma.Parent                   = wave;
+
+    return RT_EOK;
+#else
+    return -RT_ENOSYS;
+#endif /* DMA_SUPPORT_DYN_CHANNEL_ALLOC */
+}
+
+void pwm_wave_gen(pwm_wave_t *wave, uint16_t *buf, uint16_t len, uint16_t start, uint16_t end,
+                  pwm_wave_shape_t shape)
+{
+    int32_t range = (int32_t)end - start;
+    uint32_t x, permille;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        /* x is position in permille */
+        x = (len > 1) ? (i * PWM_WAVE_PERMILLE_MAX / (len - 1)) : PWM_WAVE_PERMILLE_MAX;
+        if (PWM_WAVE_SHAPE_BREATH == shape)
+        {
+            x = (x <= PWM_WAVE_PERMILLE_MAX / 2) ? (x * 2) : ((PWM_WAVE_PERMILLE_MAX - x) * 2);
+        }
+        if (PWM_WAVE_SHAPE_LINEAR != shape)
+        {
+            x = x * x / PWM_WAVE_PERMILLE_MAX;
+        }
+        permille = (uint32_t)(start + range * (int32_t)x / PWM_WAVE_PERMILLE_MAX);
+        if (permille > PWM_WAVE_PERMILLE_MAX)
+            permille = PWM_WAVE_PERMILLE_MAX;
+        /* compare value of top means 100% high */
+        buf[i] = (uint16_t)(permille * wave->top / PWM_WAVE_PERMILLE_MAX);
+    }
+}
+
+rt_err_t pwm_wave_play(pwm_wave_t *wave, const pwm_wave_pattern_t *pattern, pwm_wave_done_cb_t done)
+{
+    if (!wave || !wave->htim || !pattern || !pattern->ccr || !pattern->len)
+        return -RT_EINVAL;
+
+    pwm_wave_stop(wave);
+
+    /* Only a single pattern running forever doesn't need interrupt at all */
+    wave->dma.Init.Mode = (0 == pattern->loop) ? DMA_CIRCULAR : DMA_NORMAL;
+    if (HAL_OK != HAL_DMA_Init(&wave->dma))
+        return -RT_EBUSY;
+    wave->dma.XferCpltCallback = (DMA_CIRCULAR == wave->dma.Init.Mode) ? NULL : pwm_wave_dma_cplt;
+    wave->dma.XferHalfCpltCallback = NULL;
+
+    wave->cur = pattern;
+    wave->loop_left = pattern->loop;
+    wave->done = done;
+    wave->playing = 1;
+    pwm_wave_start_dma(wave);
+    __HAL_GPT_ENABLE_DMA(wave->htim, GPT_DMA_UPDATE);
+
+    return RT_EOK;
+}
+
+void pwm_wave_stop(pwm_wave_t *wave)
+{
+    if (!wave || !wave->playing)
+        return;
+
+    wave->playing = 0;
+    __HAL_GPT_DISABLE_DMA(wave->htim, GPT_DMA_UPDATE);
+    HAL_DMA_Abort(&wave->dma);
+    HAL_DMA_DeInit(&wave->dma);
+}
+
+#ifdef RT_USING_FINSH
+static pwm_wave_t test_wave;
+static pwm_wave_pattern_t test_pattern;
+static uint16_t *test_buf;
+
+static int pwm_wave(int argc, char **argv)
+{
+    if (argc >= 6 && 0 == strcmp(argv[1], "init"))
+    {
+        /* pwm_wave init <pwm> <channel> <period_ns> <dma_request> [hold] */
+        rt_kprintf("init %d\n", pwm_wave_init(&test_wave, argv[2], atoi(argv[3]), atoi(argv[4]),
+                                              argc > 6 ? atoi(argv[6]) : 1, atoi(argv[5])));
+    }
+    else if (argc >= 3 && 0 == strcmp(argv[1], "breath"))
+    {
+        /* pwm_wave breath <samples> [loop] */
+        pwm_wave_stop(&test_wave);
+        if (test_buf)
+            rt_free(test_buf);
+        test_pattern.len = atoi(argv[2]);
+        test_buf = rt_malloc(test_pattern.len * sizeof(uint16_t));
+        if (!test_buf)
+            return -RT_ENOMEM;
+        pwm_wave_gen(&test_wave, test_buf, test_pattern.len, 0, PWM_WAVE_PERMILLE_MAX, PWM_WAVE_SHAPE_BREATH);
+        test_pattern.ccr = test_buf;
+        test_pattern.loop = argc > 3 ? atoi(argv[3]) : 0;
+        rt_kprintf("play %d\n", pwm_wave_play(&test_wave, &test_pattern, NULL));
+    }
+    else if (argc >= 2 && 0 == strcmp(argv[1], "stop"))
+    {
+        pwm_wave_stop(&test_wave);
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("pwm_wave init <pwm> <channel> <period_ns> <dma_request> [hold]\n");
+        rt_kprintf("pwm_wave breath <samples> [loop]\n");
+        rt_kprintf("pwm_wave stop\n");
+    }
+    else
+    {
+        rt_kprintf("playing %d, top %d, irq %d\n", test_wave.playing, test_wave.top, test_wave.irq_count);
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(pwm_wave, PWM waveform playback);
+#endif /* RT_USING_FINSH */
+
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file   drv_pwm_wave.h
+  * @author Sifli software development team
+  * @brief PWM duty cycle waveform playback by DMA
+  * @{
+  ******************************************************************************
+*/
+/**
+ * @attention
+ * Copyright (c) 2019 - 2022,  Sifli Technology
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Sifli integrated circuit
+ *    in a product or a software update for such product, must reproduce the above
+ *    copyright notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Sifli nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Sifli integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY SIFLI TECHNOLOGY "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL SIFLI TECHNOLOGY OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+
+#ifndef __DRV_PWM_WAVE_H_
+#define __DRV_PWM_WAVE_H_
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <board.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup bsp_driver Driver IO
+  * @{
+  */
+
+/** @defgroup drv_pwm_wave PWM waveform
+  * @brief Play precomputed duty cycle waveform on a PWM channel without CPU.
+  *
+  * Compare values are written to CCRx by DMA on timer update request, one sample every
+  * hold PWM periods, e.g. for breathing LED or haptic pattern of motor.
+  * Patterns can loop and be chained; CPU is only involved at the end of a pattern iteration,
+  * not for each step. A single pattern looping forever runs in DMA circular mode.
+  * @{
+  */
+
+#define PWM_WAVE_PERMILLE_MAX       (1000)
+
+typedef enum
+{
+    PWM_WAVE_SHAPE_LINEAR,          /**< linear ramp from start to end */
+    PWM_WAVE_SHAPE_EASE,            /**< quadratic ramp, looks linear for LED brightness */
+    PWM_WAVE_SHAPE_BREATH,          /**< start to end and back to start with quadratic ramps */
+} pwm_wave_shape_t;
+
+/** Pattern, samples and pattern must be kept valid while playing */
+typedef struct pwm_wave_pattern
+{
+    const uint16_t *ccr;            /**< compare values, see pwm_wave_gen() */
+    uint16_t len;                   /**< number of samples */
+    uint16_t loop;                  /**< number of iterations, 0: forever */
+    const struct pwm_wave_pattern *next;    /**< played after this one, NULL to stop at last sample */
+} pwm_wave_pattern_t;
+
+typedef struct pwm_wave pwm_wave_t;
+
+typedef void (*pwm_wave_done_cb_t)(pwm_wave_t *wave);
+
+struct pwm_wave
+{
+    GPT_HandleTypeDef *htim;
+    struct rt_device_pwm *dev;
+    uint8_t channel;
+    uint8_t playing;
+    uint16_t loop_left;
+    uint32_t top;                   /**< compare value of 100% duty */
+    const pwm_wave_pattern_t *cur;
+    pwm_wave_done_cb_t done;        /**< called in ISR when last pattern ends */
+    uint32_t irq_count;             /**< DMA interrupts, i.e. CPU wakeups */
+    DMA_HandleTypeDef dma;
+};
+
+/**
+ * @brief Configure PWM channel and DMA for waveform playback.
+ * @param wave - wave object
+ * @param name - pwm device name registered by drv_pwm, e.g. "pwm2"
+ * @param channel - timer channel, 1~4
+ * @param period_ns - PWM period
+ * @param hold - PWM periods per sample, larger than 1 needs advanced timer (repetition counter)
+ * @param dma_request - DMA request of the timer update event, see DMA request table of chip
+ * @return RT_EOK if success
+ */
+rt_err_t pwm_wave_init(pwm_wave_t *wave, const char *name, uint8_t channel, uint32_t period_ns,
+                       uint16_t hold, uint32_t dma_request);
+
+/**
+ * @brief Precompute compare values of a waveform.
+ * @param wave - wave object initialized by pwm_wave_init(), for 100% duty compare value
+ * @param buf - output compare values
+ * @param len - number of samples
+ * @param start - duty at start in permille
+ * @param end - duty at end (or at middle for breath) in permille
+ * @param shape - waveform shape
+ */
+void pwm_wave_gen(pwm_wave_t *wave, uint16_t *buf, uint16_t len, uint16_t start, uint16_t end,
+                  pwm_wave_shape_t shape);
+
+/**
+ * @brief Start playing pattern chain, playback in progress is stopped.
+ * @param wave - wave object
+ * @param pattern - first pattern
+ * @param done - callback when last pattern ends, called in ISR, optional
+ * @return RT_EOK if success
+ */
+rt_err_t pwm_wave_play(pwm_wave_t *wave, const pwm_wave_pattern_t *pattern, pwm_wave_done_cb_t done);
+
+/**
+ * @brief Stop playing, output keeps duty of current sample.
+ * @param wave - wave object
+ */
+void pwm_wave_stop(pwm_wave_t *wave);
+
+/// @} drv_pwm_wave
+/// @} bsp_driver
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__DRV_PWM_WAVE_H_ */
+
+/// @} file
+/************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
@@ -74,11 +74,31 @@ static struct sifli_sdadc sifli_sdadc_obj;
 static uint32_t lsdadc_stand_volt = 1000;
 static uint32_t lsdadc_stand_value = 1527884;
 
+#ifdef BSP_USING_LAZY_DEV
+#include "drv_lazy_dev.h"
+
+static drv_lazy_dev_t sdadc_lazy;
+
+/* rt_adc_enable()/rt_adc_read() don't require open, bring up and keep powered if used without open */
+static rt_err_t sdadc_ensure_up(void)
+{
+    if (DRV_LAZY_DEV_IS_UP(&sdadc_lazy))
+        return RT_EOK;
+
+    LOG_W("sdadc used without open");
+    return drv_lazy_dev_get(&sdadc_lazy);
+}
+#endif /* BSP_USING_LAZY_DEV */
+
 static rt_err_t sifli_sdadc_enabled(struct rt_adc_device *device, rt_uint32_t channel, rt_bool_t enabled)
 {
     SDADC_HandleTypeDef *sifli_adc_handler = device->parent.user_data;
 
     RT_ASSERT(device != RT_NULL);
+#ifdef BSP_USING_LAZY_DEV
+    if (sdadc_ensure_up() != RT_EOK)
+        return -RT_ERROR;
+#endif
 
     if (enabled)
     {
@@ -99,6 +119,10 @@ static rt_err_t sifli_get_sdadc_value(struct rt_adc_device *device, rt_uint32_t
 
     RT_ASSERT(device != RT_NULL);
     RT_ASSERT(value != RT_NULL);
+#ifdef BSP_USING_LAZY_DEV
+    if (sdadc_ensure_up() != RT_EOK)
+        return -RT_ERROR;
+#endif
 
     rt_memset(&ADC_ChanConf, 0, sizeof(ADC_ChanConf));
 
@@ -128,6 +152,70 @@ static const struct rt_adc_ops sifli_sdadc_ops =
 };
 
 
+static rt_err_t sdadc_hw_init(void)
+{
+    SDADC_GainConfTypeDef gain;
+    SDADC_AccurateConfTypeDef accu;
+
+    if (HAL_SDADC_Init(&sifli_sdadc_obj.SDADC_Handler) != HAL_OK)
+    {
+        LOG_E("sdadc init failed");
+        return -RT_ERROR;
+    }
+
+    // config gain at initial
+    gain.gain_deno = 4;
+    gain.gain_nume = 1;
+    HAL_SDADC_ConfigGain(&sifli_sdadc_obj.SDADC_Handler, &gain);
+
+    accu.chop1_num = 0x9c;
+    accu.chop2_num = 0xc9;
+    accu.chop3_num = 0x1ff;
+    accu.chop_ref_num = 0x9c;
+    accu.sample_num = 0xe0;
+    HAL_SDADC_ConfigAccu(&sifli_sdadc_obj.SDADC_Handler, &accu);
+
+//#ifdef BSP_USING_SPI_FLASH
+//#include "drv_flash.h"
+
+    HAL_LCPU_CONFIG_SDMADC_T cfg;
+    int len = (int)sizeof(HAL_LCPU_CONFIG_SDMADC_T);
+    //if (rt_flash_config_read(FACTORY_CFG_ID_SDMADC, (uint8_t *)&cfg, sizeof(FACTORY_CFG_SDMADC_T)) > 0)
+    if (BSP_CONFIG_get(FACTORY_CFG_ID_SDMADC, (uint8_t *)&cfg, len))
+    {
+        lsdadc_stand_value = cfg.value;
+        lsdadc_stand_volt = cfg.vol_mv;
+        LOG_D("SDMADC VOL %d, value %d\n", lsdadc_stand_volt, lsdadc_stand_value);
+    }
+    else
+    {
+        LOG_I("Get SDMADC configure fail\n");
+        //    lsdadc_stand_value = 0;
+        //    lsdadc_stand_volt = 0;
+    }
+//#endif
+
+    return RT_EOK;
+}
+
+#ifdef BSP_USING_LAZY_DEV
+static rt_err_t sdadc_lazy_init(drv_lazy_dev_t *ldev)
+{
+    return sdadc_hw_init();
+}
+
+static void sdadc_lazy_deinit(drv_lazy_dev_t *ldev)
+{
+    HAL_SDADC_DeInit(&sifli_sdadc_obj.SDADC_Handler);
+}
+
+static const drv_lazy_dev_ops_t sdadc_lazy_ops =
+{
+    .init = sdadc_lazy_init,
+    .deinit = sdadc_lazy_deinit,
+};
+#endif /* BSP_USING_LAZY_DEV */
+
 static int sifli_sdadc_init(void)
 {
     int result = RT_EOK;
@@ -149,55 +237,26 @@ static int sifli_sdadc_init(void)
     sifli_sdadc_obj.SDADC_Handler.Init.src_sel = HAL_SDADC_SRC_SW;
     sifli_sdadc_obj.SDADC_Handler.Init.vref_sel = HAL_SDADC_VERF_INTERNAL; //HAL_SDADC_VREF_POWER;
 
-    if (HAL_SDADC_Init(&sifli_sdadc_obj.SDADC_Handler) != HAL_OK)
+#ifdef BSP_USING_LAZY_DEV
+    /* Hardware is brought up in first open */
+    drv_lazy_dev_register(&sdadc_lazy, "sdadc", &sdadc_lazy_ops, NULL);
+#else
+    if (sdadc_hw_init() != RT_EOK)
+        return -RT_ERROR;
+#endif
+
+    /* register SDADC device */
+    if (rt_hw_adc_register(&sifli_sdadc_obj.sifli_sdadc_device, name_buf, &sifli_sdadc_ops, &sifli_sdadc_obj.SDADC_Handler) == RT_EOK)
     {
-        LOG_E("%s init failed", name_buf);
-        result = -RT_ERROR;
+        LOG_D("%s init success", name_buf);
+#ifdef BSP_USING_LAZY_DEV
+        drv_lazy_dev_attach(&sdadc_lazy, &sifli_sdadc_obj.sifli_sdadc_device.parent);
+#endif
     }
     else
     {
-        // config gain at initial
-        SDADC_GainConfTypeDef gain;
-        SDADC_AccurateConfTypeDef accu;
-        gain.gain_deno = 4;
-        gain.gain_nume = 1;
-        HAL_SDADC_ConfigGain(&sifli_sdadc_obj.SDADC_Handler, &gain);
-
-        accu.chop1_num = 0x9c;
-        accu.chop2_num = 0xc9;
-        accu.chop3_num = 0x1ff;
-        accu.chop_ref_num = 0x9c;
-        accu.sample_num = 0xe0;
-        HAL_SDADC_ConfigAccu(&sifli_sdadc_obj.SDADC_Handler, &accu);
-        /* register SDADC device */
-        if (rt_hw_adc_register(&sifli_sdadc_obj.sifli_sdadc_device, name_buf, &sifli_sdadc_ops, &sifli_sdadc_obj.SDADC_Handler) == RT_EOK)
-        {
-            LOG_D("%s init success", name_buf);
-        }
-        else
-        {
-            LOG_E("%s register failed", name_buf);
-            result = -RT_ERROR;
-        }
-//#ifdef BSP_USING_SPI_FLASH
-//#include "drv_flash.h"
-
-        HAL_LCPU_CONFIG_SDMADC_T cfg;
-        int len = (int)sizeof(HAL_LCPU_CONFIG_SDMADC_T);
-        //if (rt_flash_config_read(FACTORY_CFG_ID_SDMADC, (uint8_t *)&cfg, sizeof(FACTORY_CFG_SDMADC_T)) > 0)
-        if (BSP_CONFIG_get(FACTORY_CFG_ID_SDMADC, (uint8_t *)&cfg, len))
-        {
-            lsdadc_stand_value = cfg.value;
-            lsdadc_stand_volt = cfg.vol_mv;
-            LOG_D("SDMADC VOL %d, value %d\n", lsdadc_stand_volt, lsdadc_stand_value);
-        }
-        else
-        {
-            LOG_I("Get SDMADC configure fail\n");
-            //    lsdadc_stand_value = 0;
-            //    lsdadc_stand_volt = 0;
-        }
-//#endif
+        LOG_E("%s register failed", name_buf);
+        result = -RT_ERROR;
     }
 
     return result;
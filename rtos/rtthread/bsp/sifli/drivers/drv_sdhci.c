@@ -68,6 +68,18 @@
 #define SDHCI_SLEEP_LITE_MODE       (0)
 
 static struct sdhci_host sdhci_ctx[2];
+
+#ifdef BSP_SDHCI_ADMA_SG
+/* ADMA lines are split at 512KB boundary instead of copying whole buffer */
+#define SDHCI_DMA_BOUNDARY              (0x80000)
+#define SDHCI_NEED_BOUNCE(host, buf, size) \
+    (!((host)->handle.Init.flags & SDHCI_USE_ADMA) && IS_BUF_ACCROSS_512K_BOUNDARY((uint32_t)(buf), (size)))
+#ifndef SD_APP_SET_WR_BLK_ERASE_COUNT
+    #define SD_APP_SET_WR_BLK_ERASE_COUNT   23
+#endif
+#else
+#define SDHCI_NEED_BOUNCE(host, buf, size)  IS_BUF_ACCROSS_512K_BOUNDARY((uint32_t)(buf), (size))
+#endif
 //static uint32_t sdhci_irq_flag = 0;
 
 #ifdef RT_USING_PM
@@ -300,9 +312,24 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct rt_mmcsd_data *da
     {
         host->org_buf = NULL;
         host->cache_buf = NULL;
+#ifdef BSP_SDHCI_ADMA_SG
+        if (host->sg)
+        {
+            uint32_t i;
+
+            for (i = 0; i < host->sg_num; i++)
+            {
+                if (data->flags & DATA_DIR_WRITE)
+                    mpu_dcache_clean((void *)host->sg[i].addr, host->sg[i].len);
+                else if (IS_DCACHED_RAM(host->sg[i].addr))
+                    SCB_InvalidateDCache_by_Addr((void *)host->sg[i].addr, host->sg[i].len);
+            }
+        }
+        else
+#endif
         if (data->flags & DATA_DIR_WRITE)
         {
-            if (IS_BUF_ACCROSS_512K_BOUNDARY((uint32_t)data->buf, (uint32_t)data->blksize * data->blks))
+            if (SDHCI_NEED_BOUNCE(host, data->buf, (uint32_t)data->blksize * data->blks))
             {
                 // buffer accross 512kb boundary, need copy to local buffer to avoid dma limited
                 host->cache_buf = malloc((uint32_t)data->blksize * data->blks);
@@ -320,7 +347,7 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct rt_mmcsd_data *da
         }
         else
         {
-            if (IS_BUF_ACCROSS_512K_BOUNDARY((uint32_t)data->buf, (uint32_t)data->blksize * data->blks))
+            if (SDHCI_NEED_BOUNCE(host, data->buf, (uint32_t)data->blksize * data->blks))
             {
                 // buffer accross 512kb boundary, need copy to local buffer to avoid dma limited
                 host->cache_buf = malloc((uint32_t)data->blksize * data->blks);
@@ -339,7 +366,21 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct rt_mmcsd_data *da
         if (host->handle.Init.flags & SDHCI_USE_ADMA)
         {
             LOG_D("sdhci_prepare_data ADMA, blk size %d\n", data->blksize);
+#ifdef BSP_SDHCI_ADMA_SG
+            if (host->sg)
+                ret = hal_sdhci_adma_table_sg(&host->handle, host->sg, host->sg_num,
+                                              BSP_SDHCI_ADMA_DESC_NUM + 1, SDHCI_DMA_BOUNDARY);
+            else
+            {
+                SDHCI_SgTypeDef sg;
+
+                sg.addr = (uint32_t)data->buf;
+                sg.len = (uint32_t)data->blksize * data->blks;
+                ret = hal_sdhci_adma_table_sg(&host->handle, &sg, 1, BSP_SDHCI_ADMA_DESC_NUM + 1, SDHCI_DMA_BOUNDARY);
+            }
+#else
             ret = hal_sdhci_adma_table_pre(&host->handle, (uint8_t *)data->buf, (uint32_t)data->blksize * data->blks);
+#endif
             if (ret)
             {
                 /*
@@ -782,6 +823,34 @@ static void sdhci_set_ddr(struct sdhci_host *host, unsigned int ddr)
  *                                                                           *
  \*****************************************************************************/
 
+#ifdef BSP_SDHCI_ADMA_SG
+/* ACMD23 tells SD card how many blocks follow, so it could erase them ahead of CMD25 */
+static void sdhci_pre_erase(struct sdhci_host *host, rt_uint32_t blks)
+{
+    struct rt_mmcsd_card *card = host->mmc->card;
+    struct rt_mmcsd_cmd cmd;
+
+    if (card == RT_NULL || card->card_type != CARD_TYPE_SD || blks < 2)
+        return;
+
+    rt_memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd_code = APP_CMD;
+    cmd.arg = card->rca << 16;
+    cmd.flags = RESP_R1 | CMD_AC;
+    sdhci_send_command(host, &cmd);
+    if (cmd.err || !(cmd.resp[0] & R1_APP_CMD))
+        return;
+
+    rt_memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd_code = SD_APP_SET_WR_BLK_ERASE_COUNT;
+    cmd.arg = blks & 0x7FFFFF;
+    cmd.flags = RESP_R1 | CMD_AC;
+    sdhci_send_command(host, &cmd);
+    if (cmd.err)
+        LOG_D("Pre-erase %d blocks fail %d\n", blks, cmd.err);
+}
+#endif /* BSP_SDHCI_ADMA_SG */
+
 static void sdhci_request(struct rt_mmcsd_host *mmc, struct rt_mmcsd_req *mrq)
 {
     struct sdhci_host *host;
@@ -813,6 +882,10 @@ static void sdhci_request(struct rt_mmcsd_host *mmc, struct rt_mmcsd_req *mrq)
     }
     else
     {
+#ifdef BSP_SDHCI_ADMA_SG
+        if (mrq->cmd->cmd_code == WRITE_MULTIPLE_BLOCK && mrq->data)
+            sdhci_pre_erase(host, mrq->data->blks);
+#endif
         LOG_D("Send cmd %d\n", mrq->cmd->cmd_code);
         sdhci_send_command(host, mrq->cmd);
     }
@@ -1451,7 +1524,11 @@ int sdhci_add_host(struct sdhci_host *host)
          * (128) and potentially one alignment transfer for
          * each of those entries.
          */
+#ifdef BSP_SDHCI_ADMA_SG
+        host->handle.Init.adma_desc = (uint8_t *)malloc((BSP_SDHCI_ADMA_DESC_NUM + 1) * sizeof(hal_sdhci_adma_des_line_t));
+#else
         host->handle.Init.adma_desc = (uint8_t *)malloc((128 * 2 + 1) * 4); //??
+#endif
         if (!host->handle.Init.adma_desc)
         {
             LOG_I(" Unable to allocate ADMA buffers. Falling back to standard DMA.\n");
@@ -1604,7 +1681,13 @@ int sdhci_add_host(struct sdhci_host *host)
      * be larger than 64 KiB though.
      */
     if (host->handle.Init.flags & SDHCI_USE_ADMA)
+    {
         mmc->max_seg_size = SDHCI_ADMA_MAX_SIZE;
+#ifdef BSP_SDHCI_ADMA_SG
+        /* other half of lines for split at 512KB boundary */
+        mmc->max_dma_segs = BSP_SDHCI_ADMA_DESC_NUM / 2;
+#endif
+    }
     else
         mmc->max_seg_size = 65536; //512; //SDIO_BUFF_SIZE; //mmc->max_req_size;
 
@@ -1748,6 +1831,187 @@ uint32_t rt_sdmmc_get_clock(int id)
     return host->clock;
 }
 
+#ifdef BSP_SDHCI_ADMA_SG
+/* Check segments against request, and ADMA lines needed against table size */
+static rt_err_t sdhci_check_sg(struct rt_sdhci_req *req)
+{
+    uint32_t i, addr, len, remain, total, lines;
+
+    if (req->sg == RT_NULL || req->sg_num == 0 || req->blks == 0)
+        return -RT_EINVAL;
+
+    total = 0;
+    lines = 0;
+    for (i = 0; i < req->sg_num; i++)
+    {
+        addr = req->sg[i].addr;
+        remain = req->sg[i].len;
+        if ((addr & 3) || (remain & 3) || remain == 0)
+            return -RT_EINVAL;
+        total += remain;
+        while (remain > 0)
+        {
+            len = remain > SDHCI_ADMA_MAX_SIZE ? SDHCI_ADMA_MAX_SIZE : remain;
+            if (((addr & (SDHCI_DMA_BOUNDARY - 1)) + len) > SDHCI_DMA_BOUNDARY)
+                len = SDHCI_DMA_BOUNDARY - (addr & (SDHCI_DMA_BOUNDARY - 1));
+            addr += len;
+            remain -= len;
+            lines++;
+        }
+    }
+
+    if (total != req->blks * SECTOR_SIZE || lines > BSP_SDHCI_ADMA_DESC_NUM)
+        return -RT_EINVAL;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_sdhci_transfer(uint8_t id, struct rt_sdhci_req *req)
+{
+    struct sdhci_host *host;
+    struct rt_mmcsd_card *card;
+    struct rt_mmcsd_cmd cmd, stop;
+    struct rt_mmcsd_data data;
+    struct rt_mmcsd_req mrq;
+    rt_err_t err;
+
+    if (id > 1 || sdhci_ctx[id].mmc == RT_NULL || sdhci_ctx[id].mmc->card == RT_NULL)
+        return -RT_ENOSYS;
+    host = &sdhci_ctx[id];
+    card = host->mmc->card;
+    if (!(host->handle.Init.flags & SDHCI_USE_ADMA))
+        return -RT_ENOSYS;
+    err = sdhci_check_sg(req);
+    if (err != RT_EOK)
+        return err;
+
+    rt_memset(&mrq, 0, sizeof(mrq));
+    rt_memset(&cmd, 0, sizeof(cmd));
+    rt_memset(&stop, 0, sizeof(stop));
+    rt_memset(&data, 0, sizeof(data));
+    mrq.cmd = &cmd;
+    mrq.data = &data;
+
+    cmd.arg = req->sector;
+    if (!(card->flags & CARD_FLAG_SDHC))
+        cmd.arg <<= 9;
+    cmd.flags = RESP_R1 | CMD_ADTC;
+    if (req->blks > 1)
+    {
+        mrq.stop = &stop;
+        stop.cmd_code = STOP_TRANSMISSION;
+        stop.flags = RESP_R1B | CMD_AC;
+        cmd.cmd_code = req->write ? WRITE_MULTIPLE_BLOCK : READ_MULTIPLE_BLOCK;
+    }
+    else
+        cmd.cmd_code = req->write ? WRITE_BLOCK : READ_SINGLE_BLOCK;
+
+    data.blksize = SECTOR_SIZE;
+    data.blks = req->blks;
+    data.flags = req->write ? DATA_DIR_WRITE : DATA_DIR_READ;
+    data.buf = (rt_uint32_t *)req->sg[0].addr;
+    mmcsd_set_data_timeout(&data, card);
+
+    mmcsd_host_lock(host->mmc);
+    host->sg = req->sg;
+    host->sg_num = req->sg_num;
+    mmcsd_send_request(host->mmc, &mrq);
+    host->sg = RT_NULL;
+    host->sg_num = 0;
+
+    /* wait card programming done as block device does */
+    if (req->write && !cmd.err && !data.err)
+    {
+        do
+        {
+            cmd.cmd_code = SEND_STATUS;
+            cmd.arg = card->rca << 16;
+            cmd.flags = RESP_R1 | CMD_AC;
+            if (mmcsd_send_cmd(host->mmc, &cmd, 5))
+                break;
+        }
+        while (!(cmd.resp[0] & R1_READY_FOR_DATA) || (R1_CURRENT_STATE(cmd.resp[0]) == 7));
+    }
+    mmcsd_host_unlock(host->mmc);
+
+    if (cmd.err || data.err || stop.err)
+    {
+        LOG_E("sg %s %d blocks at 0x%x fail %d,%d,%d\n", req->write ? "write" : "read", req->blks, req->sector,
+              cmd.err, data.err, stop.err);
+        return -RT_EIO;
+    }
+
+    return RT_EOK;
+}
+
+static void sdhci_req_entry(void *param)
+{
+    struct sdhci_host *host = (struct sdhci_host *)param;
+    struct rt_sdhci_req *req;
+    rt_base_t level;
+    rt_err_t err;
+
+    while (1)
+    {
+        rt_sem_take(&host->req_sem, RT_WAITING_FOREVER);
+
+        level = rt_hw_interrupt_disable();
+        if (rt_list_isempty(&host->req_list))
+        {
+            rt_hw_interrupt_enable(level);
+            continue;
+        }
+        req = rt_list_first_entry(&host->req_list, struct rt_sdhci_req, node);
+        rt_list_remove(&req->node);
+        rt_hw_interrupt_enable(level);
+
+        err = rt_sdhci_transfer(host == &sdhci_ctx[0] ? 0 : 1, req);
+        if (req->cb)
+            req->cb(req, err);
+    }
+}
+
+rt_err_t rt_sdhci_submit(uint8_t id, struct rt_sdhci_req *req)
+{
+    struct sdhci_host *host;
+    rt_base_t level;
+
+    if (id > 1 || req == RT_NULL)
+        return -RT_EINVAL;
+    host = &sdhci_ctx[id];
+
+    if (host->req_thread == RT_NULL)
+    {
+        rt_thread_t tid;
+
+        tid = rt_thread_create("sd_req", sdhci_req_entry, host, BSP_SDHCI_REQ_STACK_SIZE,
+                               BSP_SDHCI_REQ_THREAD_PRIORITY, 10);
+        if (tid == RT_NULL)
+            return -RT_ENOMEM;
+
+        level = rt_hw_interrupt_disable();
+        if (host->req_thread == RT_NULL)
+        {
+            host->req_thread = tid;
+            rt_hw_interrupt_enable(level);
+            rt_thread_startup(tid);
+        }
+        else
+        {
+            rt_hw_interrupt_enable(level);
+            rt_thread_delete(tid);
+        }
+    }
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&host->req_list, &req->node);
+    rt_hw_interrupt_enable(level);
+    rt_sem_release(&host->req_sem);
+
+    return RT_EOK;
+}
+#endif /* BSP_SDHCI_ADMA_SG */
+
 #ifdef RT_USING_PM
 static rt_err_t rt_sdhci_control(struct rt_device *dev, int cmd, void *args)
 {
@@ -1860,6 +2124,10 @@ int rt_sdhci_init_instance(uint8_t id)
     }
 
     memset(&(sdhci_ctx[id].usr_cfg), 0, sizeof(sdhci_user_config_t));
+#ifdef BSP_SDHCI_ADMA_SG
+    rt_list_init(&sdhci_ctx[id].req_list);
+    rt_sem_init(&sdhci_ctx[id].req_sem, id ? "sd2_req" : "sd1_req", 0, RT_IPC_FLAG_FIFO);
+#endif
     HAL_SDHCI_MspInit(&sdhci_ctx[id].handle);
 
     rt_sdmmc_set_clock(id, rt_sdhci_cfg_def[id].max_freq);
@@ -66,6 +66,40 @@
 
 #define IS_BUF_ACCROSS_512K_BOUNDARY(addr,size) ((addr&0xFFF80000)!=((addr+size)&0xFFF80000))
 
+#ifdef BSP_SDHCI_ADMA_SG
+#ifndef BSP_SDHCI_ADMA_DESC_NUM
+    #define BSP_SDHCI_ADMA_DESC_NUM         (32)    /* ADMA lines of one request, half of them are given to block device as segments */
+#endif
+#ifndef BSP_SDHCI_REQ_STACK_SIZE
+    #define BSP_SDHCI_REQ_STACK_SIZE        (2048)
+#endif
+#ifndef BSP_SDHCI_REQ_THREAD_PRIORITY
+    #define BSP_SDHCI_REQ_THREAD_PRIORITY   (RT_THREAD_PRIORITY_HIGH)
+#endif
+
+struct rt_sdhci_req;
+
+/**
+ * @brief Completion callback of asynchronous request, called in request thread of host.
+ * @param req - completed request, could be submitted again in callback
+ * @param result - RT_EOK if all blocks are done
+ */
+typedef void (*rt_sdhci_req_cb_t)(struct rt_sdhci_req *req, rt_err_t result);
+
+/** Multi-block request over scatter-gather buffers, owned by caller and must be kept until done */
+struct rt_sdhci_req
+{
+    rt_list_t node;                 /**< private */
+    rt_uint32_t sector;             /**< first block on card */
+    rt_uint32_t blks;               /**< number of 512 bytes blocks, total size of segments */
+    const SDHCI_SgTypeDef *sg;      /**< segments, each 4 bytes aligned */
+    rt_uint32_t sg_num;
+    rt_uint8_t write;               /**< 1 for CMD25 write, 0 for CMD18 read */
+    rt_sdhci_req_cb_t cb;
+    void *user_data;
+};
+#endif /* BSP_SDHCI_ADMA_SG */
+
 typedef enum
 {
     SDHCI_SDCARD = 0,
@@ -124,6 +158,14 @@ struct sdhci_host
     rt_uint32_t *cache_buf;
 
     uint32_t irq_flag;
+
+#ifdef BSP_SDHCI_ADMA_SG
+    const SDHCI_SgTypeDef *sg;      /* segments of current data, NULL for data->buf */
+    rt_uint32_t sg_num;
+    rt_thread_t req_thread;
+    struct rt_semaphore req_sem;
+    rt_list_t req_list;
+#endif
 };
 
 struct sdhci_ops_t
@@ -144,6 +186,26 @@ extern int sdhci_add_host(struct sdhci_host *host);
 extern void sdhci_remove_host(struct sdhci_host *host, int dead);
 
 
+#ifdef BSP_SDHCI_ADMA_SG
+/**
+ * @brief Do multi-block request in one ADMA transfer, blocked until done.
+ *        SD card gets ACMD23 pre-erase hint before write.
+ * @param id - host index, 0 for sdmmc1
+ * @param req - request, cb is not used
+ * @return RT_EOK if all blocks are done
+ */
+rt_err_t rt_sdhci_transfer(uint8_t id, struct rt_sdhci_req *req);
+
+/**
+ * @brief Queue request and return, requests are done one by one in request thread of host, so next
+ *        request could be queued while current one is in flight.
+ * @param id - host index, 0 for sdmmc1
+ * @param req - request with cb
+ * @return RT_EOK if queued
+ */
+rt_err_t rt_sdhci_submit(uint8_t id, struct rt_sdhci_req *req);
+#endif /* BSP_SDHCI_ADMA_SG */
+
 //#if DRV_DEBUG
 const char *sd_cmd_name(int index);
 //#endif
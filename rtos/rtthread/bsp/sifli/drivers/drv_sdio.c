@@ -112,6 +112,17 @@ ALIGN(SDIO_ALIGN_LEN)
 //static rt_uint8_t cache_buf[SDIO_BUFF_SIZE];
 HAL_RETM_BSS_SECT(cache_buf, static rt_uint8_t cache_buf[SDIO_BUFF_SIZE]);
 
+/* Data phases by buffer used, see rthw_sdio_request */
+static struct
+{
+    rt_uint32_t direct;     // DMA on caller buffer
+    rt_uint32_t bounce;     // copied through cache_buf
+    rt_uint32_t heap;       // copied through buffer from heap, larger than cache_buf
+    rt_uint32_t nomem;
+    rt_uint32_t blocks;
+    rt_uint32_t bytes;
+} sdio_stat;
+
 
 static rt_uint32_t sifli_sdio_clk_get(SD_TypeDef *hw_sdio)
 {
@@ -607,6 +618,30 @@ static void rthw_sdio_send_command(struct rthw_sdio *sdio, struct sdio_pkg *pkg)
     //LOG_I("set comd func done\n");
 }
 
+/**
+  * @brief  Check if DMA could work on caller buffer directly.
+  * @param  data  request data
+  * @param  size  data length
+  * @retval RT_TRUE if no bounce buffer needed
+  */
+static rt_bool_t rthw_sdio_buf_direct(struct rt_mmcsd_data *data, rt_uint32_t size)
+{
+#ifdef SDIO_USING_DMA
+    rt_uint8_t *buf = (rt_uint8_t *)data->buf;
+
+    // DMA is word based, cache maintenance is by line, a read must not share line with others
+    if (((rt_uint32_t)buf & (SDIO_ALIGN_LEN - 1)) || (size & (SDIO_ALIGN_LEN - 1)))
+        return RT_FALSE;
+    // flash and PSRAM buffers still go through cache_buf
+    if (!HCPU_IS_SRAM_ADDR(buf) || !HCPU_IS_SRAM_ADDR(buf + size - 1))
+        return RT_FALSE;
+
+    return RT_TRUE;
+#else
+    return RT_FALSE;
+#endif
+}
+
 /**
   * @brief  This function send sdio request.
   * @param  sdio  rthw_sdio
@@ -618,6 +653,7 @@ static void rthw_sdio_request(struct rt_mmcsd_host *host, struct rt_mmcsd_req *r
     struct sdio_pkg pkg;
     struct rthw_sdio *sdio = host->private_data;
     struct rt_mmcsd_data *data;
+    rt_uint8_t *bounce = RT_NULL;
 
     RTHW_SDIO_LOCK(sdio);
 
@@ -631,27 +667,70 @@ static void rthw_sdio_request(struct rt_mmcsd_host *host, struct rt_mmcsd_req *r
         {
             rt_uint32_t size = data->blks * data->blksize;
 
-            RT_ASSERT(size <= SDIO_BUFF_SIZE);
+            RT_ASSERT(size <= SDIO_DMA_SEG_SIZE);
 
-            //pkg.buff = data->buf;
-            //if ((rt_uint32_t)data->buf & (SDIO_ALIGN_LEN - 1))
-            // replace buffer any way for SRAM buffer and aligned issue
+            if (rthw_sdio_buf_direct(data, size))
             {
-                SCB_InvalidateDCache_by_Addr(cache_buf, size);
-                pkg.buff = cache_buf;
+                // multi block CMD53/CMD18/CMD25 go to caller buffer without copy
                 if (data->flags & DATA_DIR_WRITE)
+                    SCB_CleanDCache_by_Addr(data->buf, size);
+                else
+                    SCB_InvalidateDCache_by_Addr(data->buf, size);
+                pkg.buff = data->buf;
+                sdio_stat.direct++;
+            }
+            else
+            {
+                // replace buffer for SRAM buffer and aligned issue
+                if (size <= SDIO_BUFF_SIZE)
+                {
+                    bounce = cache_buf;
+                    sdio_stat.bounce++;
+                }
+                else
+                {
+                    bounce = rt_malloc_align(size, SDIO_ALIGN_LEN);
+                    sdio_stat.heap++;
+                }
+
+                if (bounce == RT_NULL)
                 {
-                    memcpy(cache_buf, data->buf, size);
+                    LOG_E("no buffer for %d bytes", size);
+                    sdio_stat.nomem++;
+                    req->cmd->err = -RT_ENOMEM;
+                    RTHW_SDIO_UNLOCK(sdio);
+                    mmcsd_req_complete(sdio->host);
+                    return;
+                }
+
+                SCB_InvalidateDCache_by_Addr(bounce, size);
+                pkg.buff = bounce;
+                if (data->flags & DATA_DIR_WRITE)
+                {
+                    memcpy(bounce, data->buf, size);
                 }
             }
+            sdio_stat.blocks += data->blks;
+            sdio_stat.bytes += size;
         }
 
         rthw_sdio_send_command(sdio, &pkg);
 
-        //if ((data != RT_NULL) && (data->flags & DATA_DIR_READ) && ((rt_uint32_t)data->buf & (SDIO_ALIGN_LEN - 1)))
-        if ((data != RT_NULL) && (data->flags & DATA_DIR_READ)) // always do copy when buffer replaced.
+        if (bounce != RT_NULL)
+        {
+            if (data->flags & DATA_DIR_READ)
+            {
+                memcpy(data->buf, bounce, data->blksize * data->blks);
+            }
+            if (bounce != cache_buf)
+            {
+                rt_free_align(bounce);
+            }
+        }
+        else if ((data != RT_NULL) && (data->flags & DATA_DIR_READ))
         {
-            memcpy(data->buf, cache_buf, data->blksize * data->blks);
+            // drop lines cpu may have fetched while DMA was running
+            SCB_InvalidateDCache_by_Addr(data->buf, data->blksize * data->blks);
         }
     }
 
@@ -873,7 +952,8 @@ void rthw_sdio_irq_process(struct rt_mmcsd_host *host)
     {
         //hw_sdio->icr = HW_SDIO_IT_SDIOIT;
         HAL_SDMMC_CLR_INT(hw_sdio, HW_SDIO_IT_SDIOIT);
-        //sdio_irq_wakeup(host);
+        // card irq is masked until sdio_irq_thread has served function handlers
+        sdio_irq_wakeup(host);
     }
 
     if (complete)
@@ -947,7 +1027,7 @@ struct rt_mmcsd_host *sdio_host_create(struct sifli_sdio_des *sdio_des)
     // set 1 bit only, config it when 4 bits ready
     host->flags = MMCSD_MUTBLKWRITE | MMCSD_SUP_SDIO_IRQ | MMCSD_BUSWIDTH_4;
 
-    host->max_seg_size = SDIO_BUFF_SIZE;
+    host->max_seg_size = SDIO_DMA_SEG_SIZE;
     host->max_dma_segs = 1;
     host->max_blk_size = 512;
     host->max_blk_count = 512;
@@ -1364,6 +1444,24 @@ int rt_hw_sdio_init(void)
 }
 INIT_DEVICE_EXPORT(rt_hw_sdio_init);
 
+#ifdef RT_USING_FINSH
+static int sdio_stat_cmd(int argc, char **argv)
+{
+    if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+    {
+        rt_memset(&sdio_stat, 0, sizeof(sdio_stat));
+        return 0;
+    }
+
+    rt_kprintf("data phase direct %d, bounce %d, heap %d, no memory %d\n",
+               sdio_stat.direct, sdio_stat.bounce, sdio_stat.heap, sdio_stat.nomem);
+    rt_kprintf("blocks %d, bytes %d, max segment %d\n", sdio_stat.blocks, sdio_stat.bytes, SDIO_DMA_SEG_SIZE);
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(sdio_stat_cmd, sdio_stat, sdio_stat [reset]: show SDIO transfers by buffer type);
+#endif /* RT_USING_FINSH */
+
 //#define DRV_SDIO_TEST
 #ifdef DRV_SDIO_TEST
 int cmd_sdcard(int argc, char *argv[])
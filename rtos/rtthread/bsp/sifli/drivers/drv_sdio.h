@@ -87,6 +87,11 @@
     #define SDIO_ALIGN_LEN       (32)
 #endif
 
+/* Largest data phase of one command, request above SDIO_BUFF_SIZE needs DMA capable buffer or heap */
+#ifndef SDIO_DMA_SEG_SIZE
+    #define SDIO_DMA_SEG_SIZE    (SDIO_BUFF_SIZE)
+#endif
+
 #ifndef SDIO_MAX_FREQ
     #define SDIO_MAX_FREQ        (24 * 1000 * 1000)
 #endif
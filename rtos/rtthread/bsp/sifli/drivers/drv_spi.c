@@ -765,8 +765,416 @@ __ROM_USED rt_err_t rt_hw_spi_device_attach(const char *bus_name, const char *de
     return result;
 }
 
+#ifdef BSP_SPI_STREAM
+/*
+ * Continuous streaming and queued transfer
+ *
+ * Streaming keeps one DMA channel running in circular mode over a ring buffer, callback is called
+ * in DMA interrupt each time half of ring is done, so there is no gap and no setup between chunks.
+ *
+ * Queued transfer runs a message list from DMA complete interrupt: CS of previous message is
+ * released (if cs_release) and next message is started right away, instead of waking up calling
+ * thread and doing semaphore/PM/CS handling for each message.
+ */
+typedef struct
+{
+    struct rt_spi_device *device;
+    rt_uint8_t *buf;
+    rt_uint32_t size;
+    rt_spi_stream_cb_t cb;
+    void *arg;
+} spi_stream_t;
+
+typedef struct
+{
+    struct rt_spi_device *device;
+    struct rt_spi_message *msg;         /* message in progress, NULL if queue idle */
+    rt_spi_queue_cb_t cb;
+    void *arg;
+    rt_err_t result;
+    rt_spi_queue_stat_t stat;
+} spi_queue_t;
+
+static spi_stream_t spi_stream[SPI_MAX];
+static spi_queue_t spi_queue[SPI_MAX];
+
+static rt_uint32_t spi_gtimer_us(rt_uint32_t start, rt_uint32_t end)
+{
+    return (rt_uint32_t)((rt_uint64_t)(end - start) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+static rt_bool_t spi_bus_held(struct rt_spi_device *device)
+{
+    return (device->bus->owner == device) && (device->bus->lock.owner == rt_thread_self());
+}
+
+static void spi_stream_half(DMA_HandleTypeDef *hdma)
+{
+    struct sifli_spi *spi_drv = rt_container_of(hdma->Parent, struct sifli_spi, handle);
+    spi_stream_t *st = &spi_stream[get_index_by_bus_handle(&spi_drv->spi_bus)];
+
+    st->cb(st->device, st->buf, st->size / 2, st->arg);
+}
+
+static void spi_stream_full(DMA_HandleTypeDef *hdma)
+{
+    struct sifli_spi *spi_drv = rt_container_of(hdma->Parent, struct sifli_spi, handle);
+    spi_stream_t *st = &spi_stream[get_index_by_bus_handle(&spi_drv->spi_bus)];
+
+    st->cb(st->device, st->buf + st->size / 2, st->size / 2, st->arg);
+}
+
+static void spi_stream_error(DMA_HandleTypeDef *hdma)
+{
+    LOG_E("spi stream dma err");
+}
+
+static void spi_stream_dma_init(DMA_HandleTypeDef *hdma, uint32_t mode, rt_bool_t rx)
+{
+    hdma->Init.Mode = mode;
+    HAL_DMA_Init(hdma);
+    hdma->XferHalfCpltCallback = rx && (DMA_CIRCULAR == mode) ? spi_stream_half : NULL;
+    hdma->XferCpltCallback = rx && (DMA_CIRCULAR == mode) ? spi_stream_full : NULL;
+    hdma->XferErrorCallback = (DMA_CIRCULAR == mode) ? spi_stream_error : NULL;
+    hdma->XferAbortCallback = NULL;
+}
+
+rt_err_t rt_spi_stream_start(struct rt_spi_device *device, rt_uint8_t dir, rt_uint8_t *buf, rt_uint32_t size,
+                             rt_spi_stream_cb_t cb, void *arg)
+{
+    struct sifli_spi *spi_drv;
+    SPI_HandleTypeDef *hspi;
+    spi_stream_t *st;
+    rt_uint32_t count;
+    rt_bool_t rx = (RT_SPI_STREAM_RX == dir);
+    rt_bool_t tx_dma;
+    rt_err_t err;
+
+    RT_ASSERT(device && device->bus && buf && cb);
+
+    spi_drv = rt_container_of(device->bus, struct sifli_spi, spi_bus);
+    hspi = &spi_drv->handle;
+    st = &spi_stream[get_index_by_bus_handle(device->bus)];
+
+    /* Master clocks rx stream by sending ring content, same as HAL_SPI_Receive_DMA */
+    tx_dma = !rx || (SPI_MODE_MASTER == hspi->Init.Mode);
+    count = (device->config.data_width > 8) ? size / 2 : size;
+    if ((count < 4) || (count & 1) || (count > 65535))
+        return -RT_EINVAL;
+    if ((rx && !(device->parent.open_flag & RT_DEVICE_FLAG_DMA_RX))
+            || (tx_dma && !(device->parent.open_flag & RT_DEVICE_FLAG_DMA_TX)))
+        return -RT_ENOSYS;
+    if (st->device)
+        return -RT_EBUSY;
+
+    err = rt_spi_take_bus(device);
+    if (RT_EOK != err)
+        return err;
+
+    st->device = device;
+    st->buf = buf;
+    st->size = size;
+    st->cb = cb;
+    st->arg = arg;
+
+#ifdef RT_USING_PM
+    rt_pm_request(PM_SLEEP_MODE_IDLE);
+    rt_pm_hw_device_start();
+#endif  /* RT_USING_PM */
+
+    /* Keep handle busy so that completion of ring is not reported as transfer done */
+    hspi->State = rx ? HAL_SPI_STATE_BUSY_RX : HAL_SPI_STATE_BUSY_TX;
+    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    __HAL_SPI_DISABLE_IT(hspi, (SPI_IT_TXE | SPI_IT_RXNE | SPI_IT_ERR));
+    __HAL_SPI_TAKE_CS(hspi);
+
+    if (rx)
+    {
+        spi_stream_dma_init(hspi->hdmarx, DMA_CIRCULAR, RT_TRUE);
+        mpu_dcache_invalidate(buf, size);
+        __HAL_SPI_ENABLE_IT(hspi, (SPI_IT_RXNE));
+        hspi->Instance->FIFO_CTRL |= SPI_FIFO_CTRL_RSRE;
+        HAL_DMA_Start_IT(hspi->hdmarx, (uint32_t)&hspi->Instance->DATA, (uint32_t)buf, count);
+    }
+    else
+    {
+        hspi->Instance->FIFO_CTRL &= ~SPI_FIFO_CTRL_RSRE;
+    }
+
+    if (tx_dma)
+    {
+        spi_stream_dma_init(hspi->hdmatx, DMA_CIRCULAR, RT_FALSE);
+        if (!rx)
+        {
+            hspi->hdmatx->XferHalfCpltCallback = spi_stream_half;
+            hspi->hdmatx->XferCpltCallback = spi_stream_full;
+        }
+        __HAL_SPI_ENABLE_IT(hspi, (SPI_IT_TXE));
+        hspi->Instance->FIFO_CTRL |= SPI_FIFO_CTRL_TSRE;
+        HAL_DMA_Start_IT(hspi->hdmatx, (uint32_t)buf, (uint32_t)&hspi->Instance->DATA, count);
+    }
+
+    if ((hspi->Instance->TOP_CTRL & SPI_TOP_CTRL_SSE) != SPI_TOP_CTRL_SSE)
+        __HAL_SPI_ENABLE(hspi);
+    __HAL_SPI_ENABLE_IT(hspi, (SPI_IT_ERR));
+
+    return RT_EOK;
+}
+
+rt_err_t rt_spi_stream_stop(struct rt_spi_device *device)
+{
+    struct sifli_spi *spi_drv;
+    SPI_HandleTypeDef *hspi;
+    spi_stream_t *st;
+
+    RT_ASSERT(device && device->bus);
+
+    spi_drv = rt_container_of(device->bus, struct sifli_spi, spi_bus);
+    hspi = &spi_drv->handle;
+    st = &spi_stream[get_index_by_bus_handle(device->bus)];
+    if (st->device != device)
+        return -RT_EINVAL;
+
+    HAL_SPI_DMAStop(hspi);
+    __HAL_SPI_DISABLE_IT(hspi, (SPI_IT_TXE | SPI_IT_RXNE | SPI_IT_ERR));
+    hspi->Instance->FIFO_CTRL &= ~(SPI_FIFO_CTRL_RSRE | SPI_FIFO_CTRL_TSRE);
+    __HAL_SPI_RELEASE_CS(hspi);
+
+    /* Back to normal mode for rt_spi_transfer() */
+    if (hspi->hdmarx)
+        spi_stream_dma_init(hspi->hdmarx, DMA_NORMAL, RT_TRUE);
+    if (hspi->hdmatx)
+        spi_stream_dma_init(hspi->hdmatx, DMA_NORMAL, RT_FALSE);
+
+#ifdef RT_USING_PM
+    rt_pm_hw_device_stop();
+    rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif  /* RT_USING_PM */
+
+    st->device = RT_NULL;
+    rt_spi_release_bus(device);
+
+    return RT_EOK;
+}
+
+static HAL_StatusTypeDef spi_queue_start_msg(struct sifli_spi *spi_drv, struct rt_spi_message *msg)
+{
+    SPI_HandleTypeDef *hspi = &spi_drv->handle;
+
+    if (msg->cs_take)
+        __HAL_SPI_TAKE_CS(hspi);
+
+    if (msg->send_buf && msg->recv_buf)
+    {
+        mpu_dcache_invalidate(msg->recv_buf, msg->length);
+        return HAL_SPI_TransmitReceive_DMA(hspi, (uint8_t *)msg->send_buf, (uint8_t *)msg->recv_buf, msg->length);
+    }
+    else if (msg->send_buf)
+    {
+        return HAL_SPI_Transmit_DMA(hspi, (uint8_t *)msg->send_buf, msg->length);
+    }
+
+    mpu_dcache_invalidate(msg->recv_buf, msg->length);
+    return HAL_SPI_Receive_DMA(hspi, (uint8_t *)msg->recv_buf, msg->length);
+}
+
+static void spi_queue_done(struct sifli_spi *spi_drv, spi_queue_t *q, rt_err_t result)
+{
+    if (RT_EOK != result)
+    {
+        LOG_E("spi queue err, errcode=%x", HAL_SPI_GetError(&spi_drv->handle));
+        __HAL_SPI_RELEASE_CS(&spi_drv->handle);
+        spi_drv->handle.State = HAL_SPI_STATE_READY;
+    }
+    q->result = result;
+    q->msg = RT_NULL;
+
+#ifdef RT_USING_PM
+    rt_pm_hw_device_stop();
+    rt_pm_release(PM_SLEEP_MODE_IDLE);
+#endif  /* RT_USING_PM */
+
+    if (q->cb)
+        q->cb(q->device, result, q->arg);
+}
+
+/* Called in DMA complete interrupt, return RT_TRUE if it's a queued message */
+static rt_bool_t spi_queue_next(struct sifli_spi *spi_drv)
+{
+    spi_queue_t *q = &spi_queue[get_index_by_bus_handle(&spi_drv->spi_bus)];
+    struct rt_spi_message *msg = q->msg;
+    rt_uint32_t start, gap;
+
+    if (!msg)
+        return RT_FALSE;
+
+    start = HAL_GTIMER_READ();
+    if (msg->cs_release)
+        __HAL_SPI_RELEASE_CS(&spi_drv->handle);
+
+    if (HAL_SPI_ERROR_NONE != HAL_SPI_GetError(&spi_drv->handle))
+    {
+        spi_queue_done(spi_drv, q, -RT_EIO);
+        return RT_TRUE;
+    }
+
+    q->stat.count++;
+    if (!msg->next)
+    {
+        spi_queue_done(spi_drv, q, RT_EOK);
+        return RT_TRUE;
+    }
+
+    q->msg = msg->next;
+    if (HAL_OK != spi_queue_start_msg(spi_drv, q->msg))
+    {
+        spi_queue_done(spi_drv, q, -RT_EIO);
+        return RT_TRUE;
+    }
+
+    gap = spi_gtimer_us(start, HAL_GTIMER_READ());
+    q->stat.gap_sum_us += gap;
+    q->stat.gap_num++;
+    if (gap > q->stat.gap_max_us)
+        q->stat.gap_max_us = gap;
+
+    return RT_TRUE;
+}
+
+rt_err_t rt_spi_queue_start(struct rt_spi_device *device, struct rt_spi_message *message,
+                            rt_spi_queue_cb_t cb, void *arg)
+{
+    struct sifli_spi *spi_drv;
+    struct rt_spi_message *msg;
+    spi_queue_t *q;
+    rt_base_t level;
+
+    RT_ASSERT(device && device->bus && message);
+
+    spi_drv = rt_container_of(device->bus, struct sifli_spi, spi_bus);
+    q = &spi_queue[get_index_by_bus_handle(device->bus)];
+
+    if (!spi_bus_held(device))
+        return -RT_EBUSY;
+
+    for (msg = message; msg; msg = msg->next)
+    {
+        if ((0 == msg->length) || (msg->length > 65535) || (!msg->send_buf && !msg->recv_buf))
+            return -RT_EINVAL;
+        if ((msg->send_buf && !(device->parent.open_flag & RT_DEVICE_FLAG_DMA_TX))
+                || (msg->recv_buf && !(device->parent.open_flag & RT_DEVICE_FLAG_DMA_RX)))
+            return -RT_ENOSYS;
+    }
+
+    level = rt_hw_interrupt_disable();
+    if (q->msg || spi_stream[get_index_by_bus_handle(device->bus)].device)
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+    q->msg = message;
+    rt_hw_interrupt_enable(level);
+
+    q->device = device;
+    q->cb = cb;
+    q->arg = arg;
+    q->result = RT_EOK;
+
+#ifdef RT_USING_PM
+    rt_pm_request(PM_SLEEP_MODE_IDLE);
+    rt_pm_hw_device_start();
+#endif  /* RT_USING_PM */
+
+    if (HAL_OK != spi_queue_start_msg(spi_drv, message))
+    {
+        spi_queue_done(spi_drv, q, -RT_EIO);
+        return -RT_EIO;
+    }
+
+    return RT_EOK;
+}
+
+static void spi_queue_sync_cb(struct rt_spi_device *device, rt_err_t result, void *arg)
+{
+    rt_sem_release((rt_sem_t)arg);
+}
+
+struct rt_spi_message *rt_spi_queue_transfer(struct rt_spi_device *device, struct rt_spi_message *message)
+{
+    struct sifli_spi *spi_drv;
+    spi_queue_t *q;
+    rt_err_t err;
+
+    RT_ASSERT(device && device->bus);
+
+    if (!message)
+        return RT_NULL;
+
+    spi_drv = rt_container_of(device->bus, struct sifli_spi, spi_bus);
+    q = &spi_queue[get_index_by_bus_handle(device->bus)];
+
+    if (RT_EOK != rt_spi_take_bus(device))
+        return message;
+
+    rt_sem_control(spi_drv->spi_sema, RT_IPC_CMD_RESET, 0);
+    err = rt_spi_queue_start(device, message, spi_queue_sync_cb, spi_drv->spi_sema);
+    if (RT_EOK == err)
+    {
+        if (-RT_ETIMEOUT == rt_sem_take(spi_drv->spi_sema, 5000))
+        {
+            LOG_E("spi queue timeout!");
+            HAL_SPI_DMAStop(&spi_drv->handle);
+            /* Message in progress is reported as failed one */
+            message = q->msg ? q->msg : message;
+            q->cb = RT_NULL;
+            spi_queue_done(spi_drv, q, -RT_ETIMEOUT);
+            err = -RT_ETIMEOUT;
+        }
+        else
+        {
+            err = q->result;
+        }
+    }
+    rt_spi_release_bus(device);
+
+    if (RT_EOK != err)
+        rt_set_errno(-RT_EIO);
+
+    /* Same as rt_spi_transfer_message(), NULL if all done */
+    return (RT_EOK == err) ? RT_NULL : message;
+}
+
+rt_err_t rt_spi_queue_get_stat(struct rt_spi_device *device, rt_spi_queue_stat_t *stat, rt_bool_t reset)
+{
+    spi_queue_t *q;
+    rt_base_t level;
+
+    RT_ASSERT(device && device->bus && stat);
+
+    q = &spi_queue[get_index_by_bus_handle(device->bus)];
+    level = rt_hw_interrupt_disable();
+    *stat = q->stat;
+    if (reset)
+        rt_memset(&q->stat, 0, sizeof(q->stat));
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+#endif /* BSP_SPI_STREAM */
+
 #ifdef BSP_USING_SPI
 
+/* Transfer of DMA mode is done */
+static void spi_xfer_cplt(struct sifli_spi *spi_drv)
+{
+#ifdef BSP_SPI_STREAM
+    if (spi_queue_next(spi_drv))
+        return;
+#endif /* BSP_SPI_STREAM */
+
+    rt_sem_release(spi_drv->spi_sema);
+}
+
 static void SPIx_IRQHandler(uint32_t index)
 {
     SPI_HandleTypeDef *handle;
@@ -801,28 +1209,28 @@ void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
 {
     struct sifli_spi *spi_drv =  rt_container_of(hspi, struct sifli_spi, handle);
 
-    rt_sem_release(spi_drv->spi_sema);
+    spi_xfer_cplt(spi_drv);
 }
 
 void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
 {
     struct sifli_spi *spi_drv =  rt_container_of(hspi, struct sifli_spi, handle);
 
-    rt_sem_release(spi_drv->spi_sema);
+    spi_xfer_cplt(spi_drv);
 }
 
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 {
     struct sifli_spi *spi_drv =  rt_container_of(hspi, struct sifli_spi, handle);
 
-    rt_sem_release(spi_drv->spi_sema);
+    spi_xfer_cplt(spi_drv);
 }
 
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
 {
     struct sifli_spi *spi_drv =  rt_container_of(hspi, struct sifli_spi, handle);
 
-    rt_sem_release(spi_drv->spi_sema);
+    spi_xfer_cplt(spi_drv);
 }
 #else
 
@@ -850,7 +1258,7 @@ static void SPIx_DMA_IRQHandler(uint32_t index, uint32_t trx)
         if (((SPI_DMA_TX == trx) && handle->hdmatx->XferCpltCallback)
                 || ((SPI_DMA_RX == trx) && handle->hdmarx->XferCpltCallback))
         {
-            rt_sem_release(spi_bus_obj[index].spi_sema);
+            spi_xfer_cplt(&spi_bus_obj[index]);
         }
     }
 
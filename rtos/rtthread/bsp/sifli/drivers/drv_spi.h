@@ -97,5 +97,68 @@ struct sifli_spi
     rt_sem_t spi_sema;
 };
 
+#ifdef BSP_SPI_STREAM
+#define RT_SPI_STREAM_RX        (0)
+#define RT_SPI_STREAM_TX        (1)
+
+/**
+ * @brief Stream callback, called in DMA interrupt each time half of ring buffer is done.
+ * @param device - SPI device
+ * @param buf - half of ring just received, or just sent and free to be refilled
+ * @param size - size of buf in bytes
+ * @param arg - user argument
+ */
+typedef void (*rt_spi_stream_cb_t)(struct rt_spi_device *device, rt_uint8_t *buf, rt_uint32_t size, void *arg);
+
+/**
+ * @brief Completion callback of queued transfer, called in DMA interrupt.
+ * @param result - RT_EOK if all messages are done
+ */
+typedef void (*rt_spi_queue_cb_t)(struct rt_spi_device *device, rt_err_t result, void *arg);
+
+typedef struct
+{
+    rt_uint32_t count;          /**< messages done by queue */
+    rt_uint32_t gap_num;        /**< back-to-back message starts */
+    rt_uint64_t gap_sum_us;     /**< from previous message done to next message started */
+    rt_uint32_t gap_max_us;
+} rt_spi_queue_stat_t;
+
+/**
+ * @brief Start continuous circular DMA over a ring buffer, bus is held with CS taken until stopped.
+ *        In master mode rx stream clocks data by sending ring content.
+ * @param device - SPI device opened with DMA flag of the direction
+ * @param dir - RT_SPI_STREAM_RX or RT_SPI_STREAM_TX
+ * @param buf - ring buffer, for tx fill it before start and refill each half in callback
+ * @param size - ring size in bytes, each half is reported in callback
+ * @param cb - half/full complete callback
+ * @param arg - user argument of cb
+ * @return RT_EOK if started
+ */
+rt_err_t rt_spi_stream_start(struct rt_spi_device *device, rt_uint8_t dir, rt_uint8_t *buf, rt_uint32_t size,
+                             rt_spi_stream_cb_t cb, void *arg);
+
+/** @brief Stop stream and release bus. */
+rt_err_t rt_spi_stream_stop(struct rt_spi_device *device);
+
+/**
+ * @brief Start message list in DMA mode and return, following messages are started in DMA interrupt.
+ *        CS is handled by cs_take/cs_release of each message. Caller must hold bus by rt_spi_take_bus().
+ * @param message - message list, must be kept until callback, each length up to 65535
+ * @return RT_EOK if started
+ */
+rt_err_t rt_spi_queue_start(struct rt_spi_device *device, struct rt_spi_message *message,
+                            rt_spi_queue_cb_t cb, void *arg);
+
+/**
+ * @brief Blocking version of rt_spi_queue_start(), same usage as rt_spi_transfer_message().
+ * @return RT_NULL if all done, otherwise the message failed
+ */
+struct rt_spi_message *rt_spi_queue_transfer(struct rt_spi_device *device, struct rt_spi_message *message);
+
+/** @brief Get gap statistics of queued transfer on bus of device. */
+rt_err_t rt_spi_queue_get_stat(struct rt_spi_device *device, rt_spi_queue_stat_t *stat, rt_bool_t reset);
+#endif /* BSP_SPI_STREAM */
+
 #endif /*__DRV_SPI_H_ */
 /************************ (C) COPYRIGHT Sifli Technology *******END OF FILE****/
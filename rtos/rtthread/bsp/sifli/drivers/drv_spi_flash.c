@@ -205,6 +205,76 @@ static int rt_nor_read_rom(FLASH_HandleTypeDef *hflash, uint32_t addr, uint8_t *
     return size;
 }
 
+#ifdef BSP_USING_NOR_ERASE_SUSPEND
+// Flash is suspended and readable here, open irq and let other threads run, flash lock still held
+static void nor_erase_yield(FLASH_HandleTypeDef *hflash)
+{
+#if !defined(CFG_FACTORY_DEBUG)
+    rt_base_t level = gflash_lock_value;
+#endif
+
+    if (IsExtFlashAddr(hflash->base))
+        BSP_FLASH_Switch_Main();
+#if !defined(CFG_FACTORY_DEBUG)
+    rt_hw_interrupt_enable(level);
+#endif
+
+    rt_thread_mdelay(NOR_ERASE_RESUME_MS);
+
+#if !defined(CFG_FACTORY_DEBUG)
+    level = rt_hw_interrupt_disable();
+    gflash_lock_value = level;
+#endif
+    if (IsExtFlashAddr(hflash->base))
+        BSP_FLASH_Switch_Ext();
+}
+#endif /* BSP_USING_NOR_ERASE_SUSPEND */
+
+// erase one sector or 64KB block, size is erase unit
+static int rt_nor_erase_unit(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
+{
+    int ret;
+#ifdef BSP_USING_NOR_ERASE_SUSPEND
+    uint32_t start, slice;
+
+    // Nobody can run during suspend in interrupt, scheduler locked or before scheduler, and dual flash status not supported
+    if ((hflash->dualFlash == 0) && (rt_interrupt_get_nest() == 0)
+            && (rt_thread_self() != RT_NULL) && (rt_critical_level() == 0))
+    {
+        slice = (uint32_t)(NOR_ERASE_SLICE_US * HAL_LPTIM_GetFreq() / 1000000);
+        if (slice == 0)
+            slice = 1;
+
+        nor_lock(hflash->base);
+        ret = HAL_QSPIEX_ERASE_START(hflash, addr, size);
+        start = HAL_GTIMER_READ();
+        while ((ret == 0) && HAL_QSPIEX_IS_BUSY(hflash))
+        {
+            // Keep erasing for a whole slice, chip need time between resume and next suspend to make progress
+            if ((HAL_GTIMER_READ() - start) < slice)
+                continue;
+
+            HAL_QSPIEX_SUSPEND(hflash);
+            nor_erase_yield(hflash);
+            HAL_QSPIEX_RESUME(hflash);
+            start = HAL_GTIMER_READ();
+        }
+        nor_unlock(hflash->base);
+
+        return ret;
+    }
+#endif /* BSP_USING_NOR_ERASE_SUSPEND */
+
+    nor_lock(hflash->base);
+    if (size == (QSPI_NOR_BLK64_SIZE << hflash->dualFlash))
+        ret = HAL_QSPIEX_BLK64_ERASE(hflash, addr);
+    else
+        ret = HAL_QSPIEX_SECT_ERASE(hflash, addr);
+    nor_unlock(hflash->base);
+
+    return ret;
+}
+
 static int rt_nor_erase_rom(FLASH_HandleTypeDef *hflash, uint32_t addr, uint32_t size)
 {
     uint32_t al_size;
@@ -257,9 +327,7 @@ alig64k:
         while (al_size >= (QSPI_NOR_BLK64_SIZE << hflash->dualFlash))
         {
 
-            nor_lock(hflash->base);
-            HAL_QSPIEX_BLK64_ERASE(hflash, al_addr);
-            nor_unlock(hflash->base);
+            rt_nor_erase_unit(hflash, al_addr, QSPI_NOR_BLK64_SIZE << hflash->dualFlash);
             al_size -= QSPI_NOR_BLK64_SIZE << hflash->dualFlash;
             al_addr += QSPI_NOR_BLK64_SIZE << hflash->dualFlash;
         }
@@ -271,9 +339,7 @@ alig64k:
         while (al_size >= (QSPI_NOR_SECT_SIZE << hflash->dualFlash))
         {
 
-            nor_lock(hflash->base);
-            HAL_QSPIEX_SECT_ERASE(hflash, al_addr);
-            nor_unlock(hflash->base);
+            rt_nor_erase_unit(hflash, al_addr, QSPI_NOR_SECT_SIZE << hflash->dualFlash);
             al_size -= QSPI_NOR_SECT_SIZE << hflash->dualFlash;
             al_addr += QSPI_NOR_SECT_SIZE << hflash->dualFlash;
             if (IS_ALIGNED((QSPI_NOR_BLK64_SIZE << hflash->dualFlash), al_addr) && (al_size >= (QSPI_NOR_BLK64_SIZE << hflash->dualFlash)))
@@ -604,6 +670,81 @@ __HAL_ROM_USED int rt_flash_erase(uint32_t addr, int size)
     return ret;
 }
 
+#ifdef BSP_USING_FLASH_ERASE_ASYNC
+typedef struct
+{
+    rt_list_t node;
+    uint32_t addr;
+    int size;
+    rt_flash_erase_cb_t cb;
+    void *user_data;
+} flash_erase_req_t;
+
+static rt_list_t flash_erase_list = RT_LIST_OBJECT_INIT(flash_erase_list);
+static struct rt_semaphore flash_erase_sem;
+static rt_thread_t flash_erase_tid;
+
+static void flash_erase_entry(void *param)
+{
+    flash_erase_req_t *req;
+    rt_base_t level;
+    int ret;
+
+    while (1)
+    {
+        rt_sem_take(&flash_erase_sem, RT_WAITING_FOREVER);
+
+        level = rt_hw_interrupt_disable();
+        RT_ASSERT(!rt_list_isempty(&flash_erase_list));
+        req = rt_list_entry(flash_erase_list.next, flash_erase_req_t, node);
+        rt_list_remove(&req->node);
+        rt_hw_interrupt_enable(level);
+
+        ret = rt_flash_erase(req->addr, req->size);
+        LOG_D("async erase 0x%x + %d done %d\n", req->addr, req->size, ret);
+        if (req->cb)
+            req->cb(req->addr, req->size, ret, req->user_data);
+        rt_free(req);
+    }
+}
+
+int rt_flash_erase_async(uint32_t addr, int size, rt_flash_erase_cb_t cb, void *user_data)
+{
+    flash_erase_req_t *req;
+    rt_base_t level;
+
+    if (Addr2Handle(addr) == NULL || size == 0 || flash_erase_tid == RT_NULL)
+        return RT_ERROR;
+
+    req = (flash_erase_req_t *)rt_malloc(sizeof(flash_erase_req_t));
+    if (req == RT_NULL)
+        return RT_ENOMEM;
+    req->addr = addr;
+    req->size = size;
+    req->cb = cb;
+    req->user_data = user_data;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&flash_erase_list, &req->node);
+    rt_hw_interrupt_enable(level);
+    rt_sem_release(&flash_erase_sem);
+
+    return RT_EOK;
+}
+
+static int rt_flash_erase_async_init(void)
+{
+    rt_sem_init(&flash_erase_sem, "flash_er", 0, RT_IPC_FLAG_FIFO);
+    flash_erase_tid = rt_thread_create("flash_er", flash_erase_entry, RT_NULL,
+                                       FLASH_ERASE_THREAD_STACK_SIZE, FLASH_ERASE_THREAD_PRIORITY, RT_THREAD_TICK_DEFAULT);
+    RT_ASSERT(flash_erase_tid);
+    rt_thread_startup(flash_erase_tid);
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(rt_flash_erase_async_init);
+#endif /* BSP_USING_FLASH_ERASE_ASYNC */
+
 __HAL_ROM_USED void rt_flash_set_alias(uint32_t addr, uint32_t start, uint32_t len, uint32_t offset)
 {
     FLASH_HandleTypeDef *fhandle = Addr2Handle(addr);
@@ -1037,6 +1178,306 @@ int rt_sys_spi_flash_init(void)
 
 INIT_BOARD_EXPORT(rt_sys_spi_flash_init);
 
+#if defined(BSP_FLASH_AUTO_MODE) && !defined(SOC_SF32LB55X)
+/******************************** NOR READ MODE SELECTION ***********************************/
+/*
+ * BSP configures quad SDR at init and only uses DTR when the board enables it. With
+ * BSP_FLASH_AUTO_MODE each quad NOR whose table has a DTR read command is switched to DTR here,
+ * read back against a SDR reference and switched back on any mismatch. The result is kept in
+ * factory config, later boots apply the cached rx setting and only run the read back check.
+ * MPI HAL functions are RAM resident already as erase/write run while XIP.
+ */
+#include "mem_section.h"
+#include "bf0_sys_cfg.h"
+
+#ifndef FLASH_AUTO_BW_SIZE
+    #define FLASH_AUTO_BW_SIZE      (64 * 1024)
+#endif
+
+#define FLASH_AUTO_REF_WORDS        (64)
+#define FLASH_AUTO_REF_WIN          (4)
+#define FLASH_AUTO_RX_INV           (1 << 7)
+#define FLASH_AUTO_RX_DEFAULT       (FLASH_AUTO_RX_INV | 0xf)
+
+/* reference windows spread over first quarter of chip where the image usually is */
+#define FLASH_AUTO_WIN_ADDR(hflash, win) \
+    ((hflash)->base + ((((hflash)->size >> 4) * (win)) & ~(FLASH_AUTO_REF_WORDS * 4 - 1)))
+
+enum
+{
+    FLASH_AUTO_NONE,
+    FLASH_AUTO_BSP,
+    FLASH_AUTO_NOT_SUPPORT,
+    FLASH_AUTO_WEAK_REF,
+    FLASH_AUTO_FAIL,
+    FLASH_AUTO_PROBED,
+    FLASH_AUTO_CACHED,
+};
+
+static const char *const flash_auto_state_str[] =
+{
+    "none", "dtr by bsp", "no dtr", "weak pattern", "dtr failed", "dtr probed", "dtr cached"
+};
+
+typedef struct
+{
+    uint32_t dev_id;
+    uint32_t sdr_kbps;
+    uint32_t dtr_kbps;
+    uint8_t state;
+    uint8_t rx_cfg;
+} flash_auto_info_t;
+
+static flash_auto_info_t flash_auto_info[FLASH_MAX_INSTANCE];
+static uint32_t flash_auto_ref[FLASH_AUTO_REF_WIN * FLASH_AUTO_REF_WORDS];
+
+/* Runs from RAM with interrupt disabled, flash can not be fetched until read mode is verified */
+L1_RET_CODE_SECT(flash_auto_dtr_try, static int flash_auto_dtr_try(FLASH_HandleTypeDef *hflash, uint8_t rx_cfg, int cal))
+{
+    volatile uint32_t *src;
+    uint32_t i, j;
+    int ok = 1;
+
+    HAL_FLASH_NOP_CMD(hflash);
+    hflash->ecc_en = rx_cfg;
+#if defined(SF32LB56X) || defined(SF32LB52X)
+    if (cal)
+        HAL_NOR_DTR_CAL(hflash);
+#endif
+    if (HAL_NOR_CFG_DTR(hflash, 1) != HAL_OK)
+        return 0;
+
+    for (j = 0; j < FLASH_AUTO_REF_WIN; j++)
+    {
+        src = (volatile uint32_t *)FLASH_AUTO_WIN_ADDR(hflash, j);
+        SCB_InvalidateDCache_by_Addr((void *)src, FLASH_AUTO_REF_WORDS * 4);
+        for (i = 0; i < FLASH_AUTO_REF_WORDS; i++)
+            if (src[i] != flash_auto_ref[j * FLASH_AUTO_REF_WORDS + i])
+                ok = 0;
+    }
+
+    if (ok)
+    {
+        hflash->buf_mode = 1;
+    }
+    else
+    {
+        HAL_NOR_CFG_DTR(hflash, 0);
+        hflash->ecc_en = 0;
+    }
+    SCB_InvalidateDCache_by_Addr((void *)hflash->base, FLASH_AUTO_REF_WIN * FLASH_AUTO_REF_WORDS * 4);
+
+    return ok;
+}
+
+/* Take SDR reference, reject it unless every data bit toggles so that both edges of all lines are checked */
+static int flash_auto_ref_read(FLASH_HandleTypeDef *hflash)
+{
+    volatile uint32_t *src;
+    uint32_t i, j, toggle = 0;
+    uint32_t *ref = flash_auto_ref;
+
+    for (j = 0; j < FLASH_AUTO_REF_WIN; j++)
+    {
+        src = (volatile uint32_t *)FLASH_AUTO_WIN_ADDR(hflash, j);
+        SCB_InvalidateDCache_by_Addr((void *)src, FLASH_AUTO_REF_WORDS * 4);
+        for (i = 0; i < FLASH_AUTO_REF_WORDS; i++, ref++)
+        {
+            *ref = src[i];
+            if (i > 0)
+                toggle |= ref[0] ^ ref[-1];
+        }
+    }
+
+    return toggle == 0xFFFFFFFF;
+}
+
+/* Uncached read throughput in KB/s */
+static uint32_t flash_auto_bw(FLASH_HandleTypeDef *hflash)
+{
+    volatile uint32_t *src = (volatile uint32_t *)hflash->base;
+    uint32_t i, sum = 0, cycles;
+    uint32_t size = FLASH_AUTO_BW_SIZE;
+    rt_base_t level;
+
+    if (size > hflash->size)
+        size = hflash->size;
+    if (!HAL_DBG_DWT_IsInit())
+        HAL_DBG_DWT_Init();
+
+    level = rt_hw_interrupt_disable();
+    SCB_InvalidateDCache_by_Addr((void *)src, size);
+    cycles = HAL_DBG_DWT_GetCycles();
+    for (i = 0; i < size / 4; i++)
+        sum += src[i];
+    cycles = HAL_DBG_DWT_GetCycles() - cycles;
+    rt_hw_interrupt_enable(level);
+    (void)sum;
+
+    if (cycles == 0)
+        return 0;
+    return (uint32_t)((uint64_t)size * HAL_RCC_GetHCLKFreq(CORE_ID_DEFAULT) / cycles / 1024);
+}
+
+static FACTORY_CFG_FLASH_MODE_ITEM_T *flash_auto_item(FACTORY_CFG_FLASH_MODE_T *cfg, uint8_t id, uint32_t dev_id, int alloc)
+{
+    FACTORY_CFG_FLASH_MODE_ITEM_T *item;
+    FACTORY_CFG_FLASH_MODE_ITEM_T *empty = NULL;
+    int i;
+
+    for (i = 0; i < FACTORY_CFG_FLASH_MODE_NUM; i++)
+    {
+        item = &cfg->item[i];
+        if (item->flash_id == id && item->dev_id != 0)
+        {
+            if (item->dev_id == dev_id)
+                return item;
+            /* chip replaced, old record is useless */
+            item->dev_id = 0;
+        }
+        if (item->dev_id == 0 && empty == NULL)
+            empty = item;
+    }
+    if (alloc && empty)
+    {
+        empty->dev_id = dev_id;
+        empty->flash_id = id;
+        return empty;
+    }
+    return NULL;
+}
+
+static void flash_auto_select(uint8_t id, FACTORY_CFG_FLASH_MODE_T *cfg)
+{
+    QSPI_FLASH_CTX_T *ctx = (QSPI_FLASH_CTX_T *)BSP_Flash_get_handle_by_id(id);
+    FLASH_HandleTypeDef *hflash = &ctx->handle;
+    flash_auto_info_t *info = &flash_auto_info[id];
+    FACTORY_CFG_FLASH_MODE_ITEM_T *item;
+    uint32_t dev_id;
+    int ok = 0;
+
+    if (hflash->isNand != SPI_MODE_NOR)
+        return;
+
+    dev_id = BSP_Flash_read_id(hflash->base);
+    info->dev_id = dev_id;
+    info->sdr_kbps = flash_auto_bw(hflash);
+    if (hflash->buf_mode)
+    {
+        info->state = FLASH_AUTO_BSP;
+        info->rx_cfg = hflash->ecc_en;
+        return;
+    }
+    if (hflash->Mode == HAL_FLASH_NOR_MODE || hflash->ctable == NULL
+            || hflash->ctable->cmd_cfg[SPI_FLASH_CMD_DTR4R].cmd == 0
+            || spi_flash_is_support_dtr(dev_id & 0xff, (dev_id >> 16) & 0xff, (dev_id >> 8) & 0xff) == 0)
+    {
+        info->state = FLASH_AUTO_NOT_SUPPORT;
+        return;
+    }
+
+    item = flash_auto_item(cfg, id, dev_id, 1);
+    if (item && item->dev_id == dev_id && item->dtr == 0 && item->rx_cfg != 0)
+    {
+        /* failed on this chip before, do not probe on every boot */
+        info->state = FLASH_AUTO_FAIL;
+        return;
+    }
+    if (!flash_auto_ref_read(hflash))
+    {
+        info->state = FLASH_AUTO_WEAK_REF;
+        return;
+    }
+
+    nor_lock(hflash->base);
+    if (item && item->dtr)
+        ok = flash_auto_dtr_try(hflash, item->rx_cfg, 0);
+    if (ok)
+    {
+        info->state = FLASH_AUTO_CACHED;
+    }
+    else
+    {
+        ok = flash_auto_dtr_try(hflash, FLASH_AUTO_RX_DEFAULT, 1);
+        if (!ok)
+            ok = flash_auto_dtr_try(hflash, FLASH_AUTO_RX_DEFAULT & ~FLASH_AUTO_RX_INV, 1);
+        info->state = ok ? FLASH_AUTO_PROBED : FLASH_AUTO_FAIL;
+    }
+    info->rx_cfg = ok ? hflash->ecc_en : 0;
+    nor_unlock(hflash->base);
+
+    if (ok)
+        info->dtr_kbps = flash_auto_bw(hflash);
+
+    if (item)
+    {
+        item->dtr = ok;
+        /* rx_cfg of failed record is only a marker that probe has been done */
+        item->rx_cfg = ok ? hflash->ecc_en : 1;
+    }
+}
+
+/**
+* @brief  Select fastest validated read mode for all NOR flash, cache result in factory config.
+* @retval 0 if success.
+*/
+int rt_flash_auto_mode_init(void)
+{
+    FACTORY_CFG_FLASH_MODE_T cfg, old;
+    uint8_t i;
+
+    if (rt_flash_config_read(FACTORY_CFG_ID_FLASH_MODE, (uint8_t *)&cfg, sizeof(cfg)) != sizeof(cfg))
+        memset(&cfg, 0, sizeof(cfg));
+    memcpy(&old, &cfg, sizeof(cfg));
+
+    for (i = 0; i < FLASH_MAX_INSTANCE; i++)
+    {
+        if (flash_is_enabled(i))
+            flash_auto_select(i, &cfg);
+    }
+
+    if (memcmp(&old, &cfg, sizeof(cfg)) != 0)
+        if (rt_flash_config_write(FACTORY_CFG_ID_FLASH_MODE, (uint8_t *)&cfg, sizeof(cfg)) == 0)
+            LOG_E("flash mode cache write fail");
+
+    return 0;
+}
+INIT_ENV_EXPORT(rt_flash_auto_mode_init);
+
+#ifdef RT_USING_FINSH
+static int flash_mode(int argc, char **argv)
+{
+    flash_auto_info_t *info;
+    uint8_t i;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        FACTORY_CFG_FLASH_MODE_T cfg;
+
+        /* probe again on next boot */
+        memset(&cfg, 0, sizeof(cfg));
+        rt_flash_config_write(FACTORY_CFG_ID_FLASH_MODE, (uint8_t *)&cfg, sizeof(cfg));
+        return 0;
+    }
+
+    for (i = 0; i < FLASH_MAX_INSTANCE; i++)
+    {
+        info = &flash_auto_info[i];
+        if (info->state == FLASH_AUTO_NONE)
+            continue;
+        rt_kprintf("flash%d id 0x%06x: %s, rx 0x%02x, sdr %d KB/s", i + 1, info->dev_id,
+                   flash_auto_state_str[info->state], info->rx_cfg, info->sdr_kbps);
+        if (info->dtr_kbps)
+            rt_kprintf(", dtr %d KB/s", info->dtr_kbps);
+        rt_kprintf("\n");
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(flash_mode, Show NOR read mode and XIP bandwidth: flash_mode [reset]);
+#endif /* RT_USING_FINSH */
+
+#endif /* BSP_FLASH_AUTO_MODE && !SOC_SF32LB55X */
+
 /********************************** SPI FLASH TEST CODE *************************************/
 #ifdef RT_USING_FINSH
 
@@ -86,6 +86,15 @@
     #include "sifli_bbm.h"
 #endif
 
+#if defined(BSP_USING_BBM) && defined(BSP_USING_HW_CRC)
+#include "drv_crc.h"
+
+static uint32_t nand_bbm_crc(const uint8_t *buf, uint32_t size)
+{
+    return drv_crc_calc(CRC_32, buf, size);
+}
+#endif
+
 
 // global value
 static int nand_index = -1;   // only ONE nand support in system.
@@ -191,6 +200,15 @@ int rt_nand_read(uint32_t addr, uint8_t *buf, int size)
         tbuf += fill;
         cnt += fill;
     }
+    if (remain >= nand_pagesize)
+    {
+        // pages read fail in batch will be retried below one by one
+        res = rt_nand_read_pages(taddr, tbuf, remain & ~(nand_pagesize - 1));
+        remain -= res;
+        taddr += res;
+        tbuf += res;
+        cnt += res;
+    }
     while (remain >= nand_pagesize)
     {
         res = rt_nand_read_page(taddr, tbuf, nand_pagesize, NULL, 0);
@@ -235,12 +253,13 @@ int rt_nand_write(uint32_t addr, const uint8_t *buf, int size)
         taddr += offset;
         tbuf += offset;
     }
-    while (remain >= nand_pagesize)
+    if (remain >= nand_pagesize)
     {
-        cnt += rt_nand_write_page(taddr, tbuf, nand_pagesize, NULL, 0);
-        remain -= nand_pagesize;
-        taddr += nand_pagesize;
-        tbuf += nand_pagesize;
+        offset = remain & ~(nand_pagesize - 1);
+        cnt += rt_nand_write_pages(taddr, tbuf, offset);
+        remain -= offset;
+        taddr += offset;
+        tbuf += offset;
     }
     if (remain > 0)
     {
@@ -446,6 +465,88 @@ int rt_nand_write_page(uint32_t addr, const uint8_t *buf, int size, const uint8_
     return res;
 }
 
+int rt_nand_read_pages(uint32_t addr, uint8_t *data, int size)
+{
+    int cnt, fill, res;
+    uint32_t taddr;
+
+    if (nand_index < 0)
+        return 0;
+
+    FLASH_HandleTypeDef *hflash = &(spi_nand_handle.handle);
+    if (addr >= hflash->base)
+        addr -= hflash->base;
+    if ((addr & (nand_pagesize - 1)) != 0 || (size & (nand_pagesize - 1)) != 0)
+    {
+        LOG_E("Read nand pages %x + %d must be page aligned\n", addr, size);
+        return 0;
+    }
+
+    cnt = 0;
+    while (cnt < size)
+    {
+#if defined(BSP_NAND_USING_CACHE_READ) && !defined(SOC_SF32LB55X)
+        // cache read sequential does not cross block
+        fill = nand_blksize - ((addr + cnt) & (nand_blksize - 1));
+        if (fill > size - cnt)
+            fill = size - cnt;
+
+        taddr = addr + cnt;
+        rt_nand_lock();
+#ifdef BSP_USING_BBM
+        int blk = bbm_get_phy_blk(taddr / nand_blksize);
+        if (blk < 0)
+        {
+            rt_nand_unlock();
+            break;
+        }
+        taddr = blk * nand_blksize + (taddr & (nand_blksize - 1));
+#endif
+        SCB_InvalidateDCache_by_Addr(data + cnt, fill);
+        res = HAL_NAND_CACHE_READ_SEQ(hflash, taddr, data + cnt, fill / nand_pagesize);
+        rt_nand_unlock();
+        if (res <= 0)
+            LOG_E("NAND cache read error code 0x%x at 0x%x\n", hflash->ErrorCode, taddr);
+#else
+        fill = nand_pagesize;
+        taddr = hflash->base + addr + cnt;
+        res = rt_nand_read_page(taddr, data + cnt, nand_pagesize, NULL, 0);
+#endif
+        if (res > 0)
+            cnt += res;
+        if (res != fill)
+            break;
+    }
+
+    return cnt;
+}
+
+int rt_nand_write_pages(uint32_t addr, const uint8_t *buf, int size)
+{
+    int cnt, res;
+
+    if (nand_index < 0)
+        return 0;
+
+    FLASH_HandleTypeDef *hflash = &(spi_nand_handle.handle);
+    if (addr >= hflash->base)
+        addr -= hflash->base;
+    if ((addr & (nand_pagesize - 1)) != 0 || (size & (nand_pagesize - 1)) != 0)
+    {
+        LOG_E("Write nand pages %x + %d must be page aligned\n", addr, size);
+        return 0;
+    }
+
+    for (cnt = 0; cnt < size; cnt += nand_pagesize)
+    {
+        res = rt_nand_write_page(hflash->base + addr + cnt, buf + cnt, nand_pagesize, NULL, 0);
+        if (res != nand_pagesize)
+            break;
+    }
+
+    return cnt;
+}
+
 int rt_nand_erase_block(uint32_t addr)
 {
     int res;
@@ -674,6 +775,9 @@ int rt_nand_init()
         }
 #endif
         bbm_register_log((bbm_log_func)rt_kprintf);
+#ifdef BSP_USING_HW_CRC
+        bbm_register_crc(nand_bbm_crc);
+#endif
         bbm_set_page_size(nand_pagesize);
         bbm_set_blk_size(nand_blksize);
 #ifdef APP_BSP_TEST
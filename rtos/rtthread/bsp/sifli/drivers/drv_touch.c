@@ -22,6 +22,19 @@
     #endif
 #endif
 
+/*
+    Coalescing: a move not read yet is replaced by the next move, so reader always
+    gets press, latest point and release, and reading thread waits next IRQ instead of
+    fixed delay between reads.
+*/
+#ifndef BSP_TOUCH_COALESCE
+    #define BSP_TOUCH_COALESCE          (1)
+#endif
+#ifndef BSP_TOUCH_PREDICT_MAX_MS
+    #define BSP_TOUCH_PREDICT_MAX_MS    (50)
+#endif
+#define TOUCH_VELOCITY_TIMEOUT_MS       (50)    //No move sample for this long means finger stopped
+
 #define DBG_ENABLE
 #define DBG_SECTION_NAME  "TOUCH"
 #define DBG_LEVEL          DBG_INFO  //DBG_LOG //
@@ -67,6 +80,9 @@ static int8_t pos_rec_beg = 0;//The record that NOT be readed.
 static int8_t pos_rec_end = 0;//The record that can be write into.
 
 static struct touch_message last_rec = {0, 0, TOUCH_EVENT_UP};
+static rt_uint32_t pos_rec_ts[MAX_TOUCH_REC];
+static rt_int8_t merge_pos = -1;    //Record of a move that can be replaced, -1 if none
+static struct touch_state touch_st = {0, 0, TOUCH_EVENT_UP};
 #if (DBG_LEVEL == DBG_LOG)
     static bool enable_tp_buf_log = true;
 #else
@@ -76,7 +92,46 @@ static struct touch_message last_rec = {0, 0, TOUCH_EVENT_UP};
 static bool rotate_180 = false;
 static struct rt_device_rect_info rotate_rect;
 
-static void touch_write_more(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y)
+static rt_uint32_t touch_elapsed_us(rt_uint32_t from, rt_uint32_t to)
+{
+    return (rt_uint32_t)((uint64_t)(to - from) * 1000000 / HAL_LPTIM_GetFreq());
+}
+
+/* Called with more_data_lock taken */
+static void touch_update_state(rt_uint8_t event, rt_uint16_t x, rt_uint16_t y, rt_uint32_t ts)
+{
+    struct touch_state *st = &touch_st;
+
+    if (event == TOUCH_EVENT_DOWN && st->event == TOUCH_EVENT_DOWN)
+    {
+        rt_uint32_t dt = touch_elapsed_us(st->ts, ts);
+
+        if (dt > 0 && dt < TOUCH_VELOCITY_TIMEOUT_MS * 1000)
+        {
+            rt_int32_t vx = (rt_int32_t)((int64_t)((rt_int32_t)x - st->x) * 1000000 / dt);
+            rt_int32_t vy = (rt_int32_t)((int64_t)((rt_int32_t)y - st->y) * 1000000 / dt);
+            /* average with previous to smooth sampling jitter */
+            st->vx = (st->vx + vx) / 2;
+            st->vy = (st->vy + vy) / 2;
+        }
+        else
+        {
+            st->vx = 0;
+            st->vy = 0;
+        }
+    }
+    else
+    {
+        st->vx = 0;
+        st->vy = 0;
+    }
+    st->x = x;
+    st->y = y;
+    st->event = event;
+    st->ts = ts;
+}
+
+static void touch_write_more_ts(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y, rt_uint32_t ts)
 {
     rt_bool_t send_indicate = RT_FALSE;
 
@@ -98,6 +153,22 @@ static void touch_write_more(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y)
 
     rt_mutex_take(more_data_lock, RT_WAITING_FOREVER);
 
+    touch_update_state(event, x, y, ts);
+#if BSP_TOUCH_COALESCE
+    if (event == TOUCH_EVENT_DOWN && merge_pos >= 0
+            && merge_pos == ((pos_rec_end - 1) & (MAX_TOUCH_REC - 1)))
+    {
+        /* previous move is not read yet, reader only needs the latest one */
+        pos_rec[merge_pos].x = x;
+        pos_rec[merge_pos].y = y;
+        pos_rec_ts[merge_pos] = ts;
+        last_rec = pos_rec[merge_pos];
+        touch_st.coalesced++;
+        rt_mutex_release(more_data_lock);
+        return;
+    }
+#endif /* BSP_TOUCH_COALESCE */
+
     if (REC_BUF_FULL())
     {
         static uint8_t g_touch_full  = 0;
@@ -116,9 +187,12 @@ static void touch_write_more(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y)
         LOG_I("touch buffer in[%d][%d, %d %d]\n", pos_rec_end, event, x, y);
     }
 
+    /* first point of a press is kept, moves after it could be merged */
+    merge_pos = (event == TOUCH_EVENT_DOWN && last_rec.event == TOUCH_EVENT_DOWN) ? pos_rec_end : -1;
     pos_rec[pos_rec_end].event = event;
     pos_rec[pos_rec_end].x = x;
     pos_rec[pos_rec_end].y = y;
+    pos_rec_ts[pos_rec_end] = ts;
     last_rec = pos_rec[pos_rec_end];
 
     if (!REC_BUF_FULL())
@@ -139,6 +213,52 @@ static void touch_write_more(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y)
 
 }
 
+static void touch_write_more(rt_uint8_t  event, rt_uint16_t x, rt_uint16_t  y)
+{
+    touch_write_more_ts(event, x, y, HAL_GTIMER_READ());
+}
+
+rt_err_t rt_touch_get_state(struct touch_state *state)
+{
+    if (!state || !more_data_lock)
+        return -RT_EINVAL;
+
+    rt_mutex_take(more_data_lock, RT_WAITING_FOREVER);
+    *state = touch_st;
+    rt_mutex_release(more_data_lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_touch_predict(rt_uint32_t ahead_ms, rt_uint16_t *x, rt_uint16_t *y)
+{
+    struct touch_state st;
+    rt_uint32_t age_ms, horizon;
+    rt_int32_t px, py;
+
+    if (RT_EOK != rt_touch_get_state(&st))
+        return -RT_EINVAL;
+
+    *x = st.x;
+    *y = st.y;
+    if (st.event != TOUCH_EVENT_DOWN)
+        return -RT_EEMPTY;
+
+    age_ms = touch_elapsed_us(st.ts, HAL_GTIMER_READ()) / 1000;
+    if (age_ms >= TOUCH_VELOCITY_TIMEOUT_MS)
+        return RT_EOK;  //Finger stopped
+
+    horizon = age_ms + ahead_ms;
+    if (horizon > BSP_TOUCH_PREDICT_MAX_MS)
+        horizon = BSP_TOUCH_PREDICT_MAX_MS;
+    px = st.x + st.vx * (rt_int32_t)horizon / 1000;
+    py = st.y + st.vy * (rt_int32_t)horizon / 1000;
+    *x = (rt_uint16_t)(px < 0 ? 0 : (px > 0xFFFF ? 0xFFFF : px));
+    *y = (rt_uint16_t)(py < 0 ? 0 : (py > 0xFFFF ? 0xFFFF : py));
+
+    return RT_EOK;
+}
+
 
 static rt_list_t driver_list;
 
@@ -558,6 +678,8 @@ static void tp_read_thread_entry(void *parameter)
 
     while (1)
     {
+        rt_uint32_t ts;
+
         if (rt_sem_take(current_driver->isr_sem, RT_WAITING_FOREVER) != RT_EOK)
         {
             continue;
@@ -566,6 +688,7 @@ static void tp_read_thread_entry(void *parameter)
         //touch->ops->isr_enable(RT_TRUE);
         do
         {
+            ts = HAL_GTIMER_READ();
             touch_api_lock();
             err = current_driver->ops->read_point(&msg);
             touch_api_unlock();
@@ -578,7 +701,7 @@ static void tp_read_thread_entry(void *parameter)
                 rt_device_write(p_remote_touch, 0, &msg, sizeof(msg));
                 LOG_D("rmt touch out[%d, %d %d]", msg.event, msg.x, msg.y);
 #else
-                touch_write_more(msg.event, msg.x, msg.y);
+                touch_write_more_ts(msg.event, msg.x, msg.y, ts);
 #endif /* REMOTE_TOUCH_OUTPUT_DEVICE */
                 //post_down_event(msg.x, msg.y, emouse_id);
                 break;
@@ -588,7 +711,13 @@ static void tp_read_thread_entry(void *parameter)
             default:
                 break;
             }
+#if BSP_TOUCH_COALESCE
+            /* next IRQ wakes up at once, otherwise poll at sample rate while pressed */
+            if (err == RT_EOK)
+                rt_sem_take(current_driver->isr_sem, RT_TICK_PER_SECOND / BSP_TOUCH_SAMPLE_HZ);
+#else
             rt_thread_delay(RT_TICK_PER_SECOND / BSP_TOUCH_SAMPLE_HZ); //Let system breath
+#endif /* BSP_TOUCH_COALESCE */
         }
         while (err == RT_EOK);
 
@@ -764,6 +893,9 @@ static rt_size_t touch_read(struct rt_device *dev, rt_off_t pos, void *buffer, r
         p_touch_data->event   = pos_rec[cur_pos].event;
         p_touch_data->x = pos_rec[cur_pos].x;
         p_touch_data->y = pos_rec[cur_pos].y;
+        touch_st.read_ts = pos_rec_ts[cur_pos];
+        if (cur_pos == merge_pos)
+            merge_pos = -1;
 
         if (enable_tp_buf_log)
         {
@@ -934,6 +1066,7 @@ static rt_err_t tp_ctrl(int argc, char **argv)
         LOG_I("    tp_ctrl log     - Toggle log\n");
         LOG_I("    tp_ctrl click <x> <y>  - Click at specified coordinates <x> <y>\n");
         LOG_I("    tp_ctrl slide <x1> <y1> <x2> <y2>  - Slide from <x1> <y1> to <x2> <y2>\n");
+        LOG_I("    tp_ctrl state   - Show latest point, velocity and coalesced moves\n");
         return RT_EOK;
     }
 
@@ -963,6 +1096,16 @@ static rt_err_t tp_ctrl(int argc, char **argv)
         enable_tp_buf_log = !enable_tp_buf_log;
         LOG_I("enable_tp_buf_log=%d", enable_tp_buf_log);
     }
+    else if (strcmp(argv[1], "state") == 0)
+    {
+        struct touch_state st;
+        rt_uint16_t px, py;
+
+        rt_touch_get_state(&st);
+        rt_touch_predict(0, &px, &py);
+        LOG_I("event=%d,x:%d,y:%d, v:%d,%d px/s, predict now:%d,%d, coalesced=%d",
+              st.event, st.x, st.y, st.vx, st.vy, px, py, st.coalesced);
+    }
     else if (strcmp(argv[1], "click") == 0)
     {
         if (argc < 4)
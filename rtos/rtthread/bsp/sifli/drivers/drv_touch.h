@@ -94,6 +94,30 @@ extern rt_err_t rt_touch_irq_pin_attach(rt_uint32_t mode, void (*hdr)(void *args
 extern rt_err_t rt_touch_irq_pin_detach(void);
 extern rt_err_t rt_touch_irq_pin_enable(rt_uint32_t enabled);
 
+struct touch_state
+{
+    rt_uint16_t x;              /* latest point */
+    rt_uint16_t y;
+    rt_uint8_t  event;
+    rt_int32_t  vx;             /* velocity in pixel per second, 0 if not moving */
+    rt_int32_t  vy;
+    rt_uint32_t ts;             /* HAL_GTIMER_READ() when latest point was sampled */
+    rt_uint32_t read_ts;        /* sample time of point returned by last read of touch device */
+    rt_uint32_t coalesced;      /* moves merged into a later point before read */
+};
+
+/**
+ * @brief Get latest touch point with its velocity and sample time.
+ */
+extern rt_err_t rt_touch_get_state(struct touch_state *state);
+
+/**
+ * @brief Predict where finger will be ahead_ms after now, for drag and scroll.
+ *        Horizon from sample time is clamped by BSP_TOUCH_PREDICT_MAX_MS.
+ * @retval -RT_EEMPTY if not pressed, x/y is latest point then.
+ */
+extern rt_err_t rt_touch_predict(rt_uint32_t ahead_ms, rt_uint16_t *x, rt_uint16_t *y);
+
 
 #ifdef __cplusplus
 }
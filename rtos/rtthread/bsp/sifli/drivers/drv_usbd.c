@@ -62,6 +62,29 @@
 
 static PCD_HandleTypeDef _sifli_pcd;
 static struct udcd _sifli_udc;
+
+#ifdef BSP_USBD_MULTI_PACKET
+/* Endpoint transfer split into packets in interrupt, upper layer is notified once per transfer */
+typedef struct
+{
+    rt_uint8_t *buf;
+    rt_uint32_t len;
+    rt_uint32_t done;
+    rt_uint32_t last;       /* size of packet in flight, for IN */
+} usbd_xfer_t;
+
+static usbd_xfer_t _xfer_in[8];
+static usbd_xfer_t _xfer_out[8];
+
+static struct
+{
+    rt_uint32_t in_bytes;
+    rt_uint32_t out_bytes;
+    rt_uint32_t in_xfer;
+    rt_uint32_t out_xfer;
+    rt_tick_t tick;
+} _usbd_stat;
+#endif /* BSP_USBD_MULTI_PACKET */
 static struct ep_id _ep_pool[] =
 {
     {0x0,  USB_EP_ATTR_CONTROL,     USB_DIR_INOUT,  64,       ID_ASSIGNED  },
@@ -86,6 +109,10 @@ void USBD_IRQHandler(void)
 
 void HAL_PCD_ResetCallback(PCD_HandleTypeDef *pcd)
 {
+#ifdef BSP_USBD_MULTI_PACKET
+    memset(_xfer_in, 0, sizeof(_xfer_in));
+    memset(_xfer_out, 0, sizeof(_xfer_out));
+#endif
     /* open ep0 OUT and IN */
     HAL_PCD_EP_Open(pcd, 0x00, 0x40, EP_TYPE_CTRL);
     HAL_PCD_EP_Open(pcd, 0x80, 0x40, EP_TYPE_CTRL);
@@ -105,6 +132,28 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
     }
     else
     {
+#ifdef BSP_USBD_MULTI_PACKET
+        usbd_xfer_t *x = &_xfer_in[epnum];
+
+        if (x->buf)
+        {
+            x->done += x->last;
+            if (x->done < x->len)
+            {
+                /* next packet, no round trip to usb thread */
+                x->last = x->len - x->done;
+                if (x->last > hpcd->IN_ep[epnum].maxpacket)
+                    x->last = hpcd->IN_ep[epnum].maxpacket;
+                HAL_PCD_EP_Transmit(hpcd, epnum, x->buf + x->done, x->last);
+                return;
+            }
+            x->buf = RT_NULL;
+            _usbd_stat.in_bytes += x->len;
+            _usbd_stat.in_xfer++;
+            rt_usbd_ep_in_handler(&_sifli_udc, 0x80 | epnum, x->len);
+            return;
+        }
+#endif
         rt_usbd_ep_in_handler(&_sifli_udc, 0x80 | epnum, hpcd->IN_ep[epnum].xfer_count);
     }
 }
@@ -128,6 +177,29 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 {
     if (epnum != 0)
     {
+#ifdef BSP_USBD_MULTI_PACKET
+        usbd_xfer_t *x = &_xfer_out[epnum];
+
+        if (x->buf)
+        {
+            rt_uint32_t size;
+
+            /* data is in x->buf + x->done already, release fifo for next packet */
+            size = HAL_PCD_EP_Receive(hpcd, epnum, x->buf + x->done);
+            x->done += size;
+            if (size == hpcd->OUT_ep[epnum].maxpacket && x->done < x->len)
+            {
+                HAL_PCD_EP_Prepare_Receive(hpcd, epnum, x->buf + x->done, x->len - x->done);
+                return;
+            }
+            /* short packet or transfer full */
+            x->buf = RT_NULL;
+            _usbd_stat.out_bytes += x->done;
+            _usbd_stat.out_xfer++;
+            rt_usbd_ep_out_handler(&_sifli_udc, epnum, x->done);
+            return;
+        }
+#endif
         rt_usbd_ep_out_handler(&_sifli_udc, epnum, 0);   // hpcd->OUT_ep[epnum].xfer_count
     }
     else
@@ -220,6 +292,12 @@ static rt_err_t _ep_disable(uep_t ep)
     RT_ASSERT(ep != RT_NULL);
     RT_ASSERT(ep->ep_desc != RT_NULL);
     HAL_PCD_EP_Close(&_sifli_pcd, ep->ep_desc->bEndpointAddress);
+#ifdef BSP_USBD_MULTI_PACKET
+    if (ep->ep_desc->bEndpointAddress & USB_DIR_IN)
+        _xfer_in[ep->ep_desc->bEndpointAddress & 0x7].buf = RT_NULL;
+    else
+        _xfer_out[ep->ep_desc->bEndpointAddress & 0x7].buf = RT_NULL;
+#endif
     return RT_EOK;
 }
 
@@ -236,12 +314,43 @@ static rt_size_t _ep_read_prepare(rt_uint8_t address, void *buffer, rt_size_t si
 {
     //LOG_D("_ep_read_prepare %d, %d\n", address, size);
     //HAL_PCD_EP_Receive(&_sifli_pcd, address, buffer, size);
+#ifdef BSP_USBD_MULTI_PACKET
+    if (address & 0x7F)
+    {
+        usbd_xfer_t *x = &_xfer_out[address & 0x7];
+        rt_base_t level = rt_hw_interrupt_disable();
+
+        x->buf = buffer;
+        x->len = size;
+        x->done = 0;
+        HAL_PCD_EP_Prepare_Receive(&_sifli_pcd, address, buffer, size);
+        rt_hw_interrupt_enable(level);
+        return size;
+    }
+#endif
     HAL_PCD_EP_Prepare_Receive(&_sifli_pcd, address, buffer, size);
     return size;
 }
 
 static rt_size_t _ep_write(rt_uint8_t address, void *buffer, rt_size_t size)
 {
+#ifdef BSP_USBD_MULTI_PACKET
+    if (address & 0x7F)
+    {
+        usbd_xfer_t *x = &_xfer_in[address & 0x7];
+        rt_base_t level = rt_hw_interrupt_disable();
+
+        x->buf = buffer;
+        x->len = size;
+        x->done = 0;
+        x->last = size;
+        if (x->last > _sifli_pcd.IN_ep[address & 0x7].maxpacket)
+            x->last = _sifli_pcd.IN_ep[address & 0x7].maxpacket;
+        HAL_PCD_EP_Transmit(&_sifli_pcd, address, buffer, x->last);
+        rt_hw_interrupt_enable(level);
+        return size;
+    }
+#endif
     HAL_PCD_EP_Transmit(&_sifli_pcd, address, buffer, size);
     return size;
 }
@@ -352,6 +461,9 @@ int sifli_usbd_register(void)
     _sifli_udc.ep0.id = &_ep_pool[0];
 #ifdef SOC_SF32LB58X
     _sifli_udc.device_is_hs = 1;
+#endif
+#ifdef BSP_USBD_MULTI_PACKET
+    _sifli_udc.multi_packet = 1;
 #endif
     rt_device_register((rt_device_t)&_sifli_udc, "usbd", RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE);
     rt_usb_device_init();
@@ -372,6 +484,27 @@ void HAL_DBG_printf(const char *fmt, ...)
 }
 #endif
 
+#if defined(BSP_USBD_MULTI_PACKET) && defined(RT_USING_FINSH)
+static int usbd_stat(int argc, char **argv)
+{
+    rt_tick_t ms = (rt_tick_get() - _usbd_stat.tick) * 1000 / RT_TICK_PER_SECOND;
+
+    if (ms == 0)
+        ms = 1;
+    rt_kprintf("usbd in %d bytes/%d xfers, %d KB/s\n", _usbd_stat.in_bytes, _usbd_stat.in_xfer,
+               (rt_uint32_t)((rt_uint64_t)_usbd_stat.in_bytes * 1000 / 1024 / ms));
+    rt_kprintf("usbd out %d bytes/%d xfers, %d KB/s\n", _usbd_stat.out_bytes, _usbd_stat.out_xfer,
+               (rt_uint32_t)((rt_uint64_t)_usbd_stat.out_bytes * 1000 / 1024 / ms));
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        memset(&_usbd_stat, 0, sizeof(_usbd_stat));
+        _usbd_stat.tick = rt_tick_get();
+    }
+    return 0;
+}
+MSH_CMD_EXPORT(usbd_stat, USB device throughput: usbd_stat [reset]);
+#endif
+
 //#define USBD_FUNC_TEST
 #ifdef USBD_FUNC_TEST
 
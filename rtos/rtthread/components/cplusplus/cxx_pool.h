@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-14     SiFli        The first version
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <new>
+
+#include <rtthread.h>
+
+namespace rtthread {
+
+/**
+ * The ObjectPool class provides fixed number of objects without heap, alloc/free is
+ * a lock-free free list, can be called from ISR. Free list head holds index and a tag
+ * counter in one word to avoid ABA.
+ * @param  T        object type.
+ * @param  pool_sz  number of objects, less than 65535.
+ */
+template<typename T, uint32_t pool_sz>
+class ObjectPool
+{
+public:
+    ObjectPool()
+    {
+        (void)sizeof(char[pool_sz < INVALID ? 1 : -1]);
+        for (uint32_t i = 0; i < pool_sz; i++)
+            mNext[i] = (i + 1 < pool_sz) ? i + 1 : INVALID;
+        mFree = 0;
+    }
+
+    /** Get object constructed by default constructor, NULL if pool is empty. */
+    T* alloc()
+    {
+        void *p = allocRaw();
+
+        return p ? new (p) T() : RT_NULL;
+    }
+
+    /** Destruct object and return it to pool. */
+    void free(T *obj)
+    {
+        if (obj)
+        {
+            obj->~T();
+            freeRaw(obj);
+        }
+    }
+
+    /** Get uninitialized memory of an object, NULL if pool is empty. */
+    void* allocRaw()
+    {
+        uint32_t head = __atomic_load_n(&mFree, __ATOMIC_ACQUIRE);
+        uint32_t next;
+
+        do
+        {
+            if ((head & 0xFFFF) == INVALID)
+                return RT_NULL;
+            next = (head & 0xFFFF0000) + 0x10000 + mNext[head & 0xFFFF];
+        }
+        while (!__atomic_compare_exchange_n(&mFree, &head, next, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+        return &mPool[(head & 0xFFFF) * sizeof(T)];
+    }
+
+    /** Return memory got by allocRaw to pool. */
+    void freeRaw(void *p)
+    {
+        uint32_t idx = ((uint8_t *)p - mPool) / sizeof(T);
+        uint32_t head = __atomic_load_n(&mFree, __ATOMIC_ACQUIRE);
+        uint32_t next;
+
+        RT_ASSERT(idx < pool_sz && (uint8_t *)p == &mPool[idx * sizeof(T)]);
+        do
+        {
+            mNext[idx] = head & 0xFFFF;
+            next = (head & 0xFFFF0000) + 0x10000 + idx;
+        }
+        while (!__atomic_compare_exchange_n(&mFree, &head, next, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    }
+
+    /** Check whether object belongs to this pool. */
+    bool contains(const void *p) const
+    {
+        return (const uint8_t *)p >= mPool && (const uint8_t *)p < mPool + sizeof(mPool);
+    }
+
+private:
+    enum { INVALID = 0xFFFF };
+
+    uint32_t mFree;
+    uint16_t mNext[pool_sz];
+    /* uint64_t keeps the storage aligned for any basic type */
+    union
+    {
+        uint8_t mPool[sizeof(T) * pool_sz];
+        uint64_t mAlign;
+    };
+};
+
+}
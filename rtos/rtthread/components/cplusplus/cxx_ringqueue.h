@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-14     SiFli        The first version
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <rtthread.h>
+
+namespace rtthread {
+
+/*
+ * Lock-free ring queues with capacity fixed at compile time, element is copied by
+ * assignment. Fast path is plain load/store and __atomic builtins without kernel call,
+ * push/pop can be called from ISR. A rt_event could be bound for blocking pop, the
+ * event is only sent and received when consumer may sleep.
+ */
+template<uint32_t sz>
+struct RingQueueCheck
+{
+    enum { ok = (sz >= 2) && ((sz & (sz - 1)) == 0) };
+    typedef char size_must_be_power_of_2[ok ? 1 : -1];
+};
+
+class RingQueueWaiter
+{
+public:
+    RingQueueWaiter() : mEvent(RT_NULL), mSet(0) {}
+
+    /** Bind event used for blocking pop.
+      @param   event  event object, could be shared by several queues with different set.
+      @param   set    event bit of this queue.
+    */
+    void bind(rt_event_t event, rt_uint32_t set)
+    {
+        mEvent = event;
+        mSet = set;
+    }
+
+protected:
+    void notify()
+    {
+        if (mEvent)
+            rt_event_send(mEvent, mSet);
+    }
+
+    /* event is sticky, a push between failed pop and wait isn't lost */
+    bool wait(int32_t millisec)
+    {
+        rt_int32_t tick;
+
+        if (!mEvent || millisec == 0)
+            return false;
+
+        if (millisec < 0)
+            tick = -1;
+        else
+            tick = rt_tick_from_millisecond(millisec);
+
+        return rt_event_recv(mEvent, mSet, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, tick, RT_NULL) == RT_EOK;
+    }
+
+private:
+    rt_event_t mEvent;
+    rt_uint32_t mSet;
+};
+
+/**
+ * Single producer single consumer queue.
+ * @param  T         data type of a single element.
+ * @param  queue_sz  maximum number of elements, must be power of 2.
+ */
+template<typename T, uint32_t queue_sz>
+class SpscQueue : public RingQueueWaiter
+{
+public:
+    SpscQueue() : mHead(0), mTail(0)
+    {
+        (void)sizeof(typename RingQueueCheck<queue_sz>::size_must_be_power_of_2);
+    }
+
+    /** Put an element, return false if queue is full. */
+    bool push(const T& data)
+    {
+        uint32_t tail = mTail;
+
+        if (tail - __atomic_load_n(&mHead, __ATOMIC_ACQUIRE) >= queue_sz)
+            return false;
+
+        mPool[tail & (queue_sz - 1)] = data;
+        __atomic_store_n(&mTail, tail + 1, __ATOMIC_RELEASE);
+        notify();
+
+        return true;
+    }
+
+    /** Get an element without wait, return false if queue is empty. */
+    bool tryPop(T& data)
+    {
+        uint32_t head = mHead;
+
+        if (head == __atomic_load_n(&mTail, __ATOMIC_ACQUIRE))
+            return false;
+
+        data = mPool[head & (queue_sz - 1)];
+        __atomic_store_n(&mHead, head + 1, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+    /** Get an element or wait for it if event is bound.
+      @param   millisec  timeout value, 0 for no wait, negative for wait forever.
+      @return  true if element is got.
+    */
+    bool pop(T& data, int32_t millisec = 0)
+    {
+        while (!tryPop(data))
+        {
+            if (!wait(millisec))
+                return false;
+        }
+
+        return true;
+    }
+
+    uint32_t count() const
+    {
+        return __atomic_load_n(&mTail, __ATOMIC_ACQUIRE) - __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+    }
+
+    bool empty() const
+    {
+        return count() == 0;
+    }
+
+private:
+    volatile uint32_t mHead;
+    volatile uint32_t mTail;
+    T mPool[queue_sz];
+};
+
+/**
+ * Multiple producer single consumer queue, each slot has a sequence number so that
+ * producers claim slots by CAS and consumer never sees partially written element.
+ * @param  T         data type of a single element.
+ * @param  queue_sz  maximum number of elements, must be power of 2.
+ */
+template<typename T, uint32_t queue_sz>
+class MpscQueue : public RingQueueWaiter
+{
+public:
+    MpscQueue() : mHead(0), mTail(0)
+    {
+        (void)sizeof(typename RingQueueCheck<queue_sz>::size_must_be_power_of_2);
+        for (uint32_t i = 0; i < queue_sz; i++)
+            mSlot[i].seq = i;
+    }
+
+    /** Put an element, return false if queue is full. */
+    bool push(const T& data)
+    {
+        uint32_t tail = __atomic_load_n(&mTail, __ATOMIC_RELAXED);
+        Slot *slot;
+
+        while (1)
+        {
+            slot = &mSlot[tail & (queue_sz - 1)];
+            int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - tail);
+
+            if (diff == 0)
+            {
+                if (__atomic_compare_exchange_n(&mTail, &tail, tail + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                /* slot is not consumed yet */
+                return false;
+            }
+            else
+            {
+                tail = __atomic_load_n(&mTail, __ATOMIC_RELAXED);
+            }
+        }
+
+        slot->data = data;
+        __atomic_store_n(&slot->seq, tail + 1, __ATOMIC_RELEASE);
+        notify();
+
+        return true;
+    }
+
+    /** Get an element without wait, return false if queue is empty. */
+    bool tryPop(T& data)
+    {
+        uint32_t head = mHead;
+        Slot *slot = &mSlot[head & (queue_sz - 1)];
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != head + 1)
+            return false;
+
+        data = slot->data;
+        __atomic_store_n(&slot->seq, head + queue_sz, __ATOMIC_RELEASE);
+        mHead = head + 1;
+
+        return true;
+    }
+
+    /** Get an element or wait for it if event is bound.
+      @param   millisec  timeout value, 0 for no wait, negative for wait forever.
+      @return  true if element is got.
+    */
+    bool pop(T& data, int32_t millisec = 0)
+    {
+        while (!tryPop(data))
+        {
+            if (!wait(millisec))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t seq;
+        T data;
+    };
+
+    uint32_t mHead;
+    uint32_t mTail;
+    Slot mSlot[queue_sz];
+};
+
+}
@@ -611,6 +611,38 @@ int dhara_map_gc_all(struct dhara_map *m, dhara_error_t *err)
     return 0;
 }
 
+dhara_page_t dhara_map_gc_headroom(const struct dhara_map *m)
+{
+    const dhara_page_t size = dhara_journal_size(&m->journal);
+    const dhara_sector_t cap = dhara_map_capacity(m);
+
+    if (size >= cap)
+        return 0;
+
+    return cap - size;
+}
+
+int dhara_map_gc_reserve(struct dhara_map *m, dhara_page_t reserve,
+                         int max_steps, dhara_error_t *err)
+{
+    int i;
+
+    for (i = 0; i < max_steps; i++)
+    {
+        if (dhara_map_gc_headroom(m) >= reserve)
+            break;
+
+        /* Only live pages left, collecting would just move them */
+        if (!m->count || (dhara_journal_size(&m->journal) <= m->count))
+            break;
+
+        if (dhara_map_gc(m, err) < 0)
+            return -1;
+    }
+
+    return i;
+}
+
 int dhara_map_get_type(struct dhara_map *m, dhara_page_t p)
 {
     dhara_error_t err;
@@ -115,6 +115,20 @@ int dhara_map_gc(struct dhara_map *m, dhara_error_t *err);
 
 int dhara_map_gc_all(struct dhara_map *m, dhara_error_t *err);
 
+/* Obtain the number of pages which can be written before automatic
+ * garbage collection is interleaved with writes.
+ */
+dhara_page_t dhara_map_gc_headroom(const struct dhara_map *m);
+
+/* Perform up to max_steps garbage collection steps while the headroom
+ * is below reserve pages and the journal still holds garbage. This is
+ * intended to be called when the device is idle, so that later writes
+ * don't pay for collection. Returns the number of steps performed, or
+ * -1 if an error occurs.
+ */
+int dhara_map_gc_reserve(struct dhara_map *m, dhara_page_t reserve,
+                         int max_steps, dhara_error_t *err);
+
 int dhara_map_get_type(struct dhara_map *m, dhara_page_t p);
 
 
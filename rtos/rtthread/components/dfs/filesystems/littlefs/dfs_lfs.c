@@ -5,9 +5,11 @@
 #include <dfs_fs.h>
 
 #include "lfs.h"
+#include "dfs_lfs.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 
 #ifndef RT_DEF_LFS_DRIVERS
     #define RT_DEF_LFS_DRIVERS 1
@@ -41,11 +43,63 @@
     #define LFS_LOOKAHEAD_MAX 128
 #endif
 
+/* Default number of whole blocks cached for metadata, 0 to disable */
+#ifndef LFS_META_CACHE_BLOCKS
+    #define LFS_META_CACHE_BLOCKS 0
+#endif
+
+/* Metadata block cache is not used if block is larger */
+#ifndef LFS_META_CACHE_MAX_BLOCK_SIZE
+    #define LFS_META_CACHE_MAX_BLOCK_SIZE 4096
+#endif
+
+/* Erase in flash erase thread, need BSP_USING_FLASH_ERASE_ASYNC */
+//#define RT_LFS_ASYNC_ERASE
+#ifdef RT_LFS_ASYNC_ERASE
+    #ifndef BSP_USING_FLASH_ERASE_ASYNC
+        #error "RT_LFS_ASYNC_ERASE requires BSP_USING_FLASH_ERASE_ASYNC"
+    #endif
+    #include "drv_flash.h"
+#endif /* RT_LFS_ASYNC_ERASE */
+
+#ifdef SOLUTION_WATCH
+    #include "app_mem.h"
+    #define LFS_CACHE_MALLOC(size)  app_cache_alloc(size, IMAGE_CACHE_PSRAM)
+    #define LFS_CACHE_FREE(p)       app_cache_free(p)
+#else
+    #define LFS_CACHE_MALLOC(size)  rt_malloc(size)
+    #define LFS_CACHE_FREE(p)       rt_free(p)
+#endif /* SOLUTION_WATCH */
+
+#define LFS_BLK_NONE    ((lfs_block_t)-1)
+
+typedef struct
+{
+    lfs_block_t block;
+    uint32_t lru;
+    uint8_t *data;
+} lfs_blk_cache_t;
+
 typedef struct _dfs_lfs_s
 {
     struct lfs lfs;
     struct lfs_config cfg;
     struct rt_mutex lock;
+    dfs_lfs_mount_opt_t opt;
+    bool cache_inited;
+    rt_tick_t mount_ms;
+    /* Whole block cache kept across opens, NOR only */
+    lfs_blk_cache_t *bcache;
+    uint16_t bcache_num;
+    uint32_t bcache_lru;
+    uint32_t bcache_hit;
+    uint32_t bcache_miss;
+#ifdef RT_LFS_ASYNC_ERASE
+    struct rt_semaphore erase_sem;
+    lfs_block_t erase_block;        /* Block being erased */
+    lfs_block_t erase_bad;          /* Block failed to erase */
+    int erase_result;
+#endif /* RT_LFS_ASYNC_ERASE */
 } dfs_lfs_t;
 
 typedef struct _dfs_lfs_fd_s
@@ -410,15 +464,146 @@ static int _get_disk(rt_device_t dev_id)
 #else
 
 
+#ifdef RT_LFS_ASYNC_ERASE
+static void _lfs_erase_done(uint32_t addr, int size, int result, void *user_data)
+{
+    dfs_lfs_t *dfs_lfs = (dfs_lfs_t *)user_data;
+
+    dfs_lfs->erase_result = result;
+    rt_sem_release(&dfs_lfs->erase_sem);
+}
+
+// Wait for pending erase of block, LFS_BLK_NONE to wait for any block
+static void _lfs_erase_wait(dfs_lfs_t *dfs_lfs, lfs_block_t block)
+{
+    if (LFS_BLK_NONE == dfs_lfs->erase_block)
+        return;
+    if ((LFS_BLK_NONE != block) && (block != dfs_lfs->erase_block))
+        return;
+
+    rt_sem_take(&dfs_lfs->erase_sem, RT_WAITING_FOREVER);
+    if (RT_EOK != dfs_lfs->erase_result)
+        dfs_lfs->erase_bad = dfs_lfs->erase_block;
+    dfs_lfs->erase_block = LFS_BLK_NONE;
+}
+#endif /* RT_LFS_ASYNC_ERASE */
+
+static lfs_blk_cache_t *_lfs_bcache_find(dfs_lfs_t *dfs_lfs, lfs_block_t block)
+{
+    for (int i = 0; i < dfs_lfs->bcache_num; i++)
+    {
+        if (dfs_lfs->bcache[i].block == block)
+            return &dfs_lfs->bcache[i];
+    }
+
+    return RT_NULL;
+}
+
+// Get cached block, load it to least recently used entry if missed
+static lfs_blk_cache_t *_lfs_bcache_get(dfs_lfs_t *dfs_lfs, lfs_block_t block)
+{
+    struct rt_mtd_nor_device *mtd_nor = (struct rt_mtd_nor_device *)dfs_lfs->cfg.context;
+    lfs_size_t block_size = dfs_lfs->cfg.block_size;
+    lfs_blk_cache_t *e;
+
+    e = _lfs_bcache_find(dfs_lfs, block);
+    if (e)
+    {
+        dfs_lfs->bcache_hit++;
+    }
+    else
+    {
+        e = &dfs_lfs->bcache[0];
+        for (int i = 1; i < dfs_lfs->bcache_num; i++)
+        {
+            if (LFS_BLK_NONE == e->block)
+                break;
+            if ((LFS_BLK_NONE == dfs_lfs->bcache[i].block) || (dfs_lfs->bcache[i].lru < e->lru))
+                e = &dfs_lfs->bcache[i];
+        }
+
+        dfs_lfs->bcache_miss++;
+        e->block = LFS_BLK_NONE;
+        if (rt_mtd_nor_read(mtd_nor, block * block_size, e->data, block_size) != block_size)
+            return RT_NULL;
+        e->block = block;
+    }
+    e->lru = ++dfs_lfs->bcache_lru;
+
+    return e;
+}
+
+static void _lfs_nor_cache_init(dfs_lfs_t *dfs_lfs)
+{
+    uint16_t num = dfs_lfs->opt.meta_cache_blocks ? dfs_lfs->opt.meta_cache_blocks : LFS_META_CACHE_BLOCKS;
+
+#ifdef RT_LFS_ASYNC_ERASE
+    rt_sem_init(&dfs_lfs->erase_sem, "lfs_er", 0, RT_IPC_FLAG_FIFO);
+    dfs_lfs->erase_block = LFS_BLK_NONE;
+    dfs_lfs->erase_bad = LFS_BLK_NONE;
+#endif /* RT_LFS_ASYNC_ERASE */
+
+    if (!num || (dfs_lfs->cfg.block_size > LFS_META_CACHE_MAX_BLOCK_SIZE))
+        return;
+
+    dfs_lfs->bcache = rt_calloc(num, sizeof(lfs_blk_cache_t));
+    if (!dfs_lfs->bcache)
+        return;
+
+    for (dfs_lfs->bcache_num = 0; dfs_lfs->bcache_num < num; dfs_lfs->bcache_num++)
+    {
+        lfs_blk_cache_t *e = &dfs_lfs->bcache[dfs_lfs->bcache_num];
+
+        e->block = LFS_BLK_NONE;
+        e->data = LFS_CACHE_MALLOC(dfs_lfs->cfg.block_size);
+        if (!e->data)
+            break;
+    }
+}
+
+static void _lfs_nor_cache_deinit(dfs_lfs_t *dfs_lfs)
+{
+#ifdef RT_LFS_ASYNC_ERASE
+    _lfs_erase_wait(dfs_lfs, LFS_BLK_NONE);
+    rt_sem_detach(&dfs_lfs->erase_sem);
+#endif /* RT_LFS_ASYNC_ERASE */
+
+    if (dfs_lfs->bcache)
+    {
+        for (int i = 0; i < dfs_lfs->bcache_num; i++)
+            LFS_CACHE_FREE(dfs_lfs->bcache[i].data);
+        rt_free(dfs_lfs->bcache);
+        dfs_lfs->bcache = RT_NULL;
+        dfs_lfs->bcache_num = 0;
+    }
+}
+
 // Read a region in a block. Negative error codes are propogated
 // to the user.
 static int _lfs_flash_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
 {
     struct rt_mtd_nor_device *mtd_nor;
+    dfs_lfs_t *dfs_lfs = rt_container_of(c, dfs_lfs_t, cfg);
 
     RT_ASSERT(c != RT_NULL);
     RT_ASSERT(c->context != RT_NULL);
 
+#ifdef RT_LFS_ASYNC_ERASE
+    _lfs_erase_wait(dfs_lfs, block);
+#endif /* RT_LFS_ASYNC_ERASE */
+
+    // Cache fills of metadata and small files go through block cache
+    if (dfs_lfs->bcache_num && (size < c->block_size))
+    {
+        lfs_blk_cache_t *e = _lfs_bcache_get(dfs_lfs, block);
+
+        if (e)
+        {
+            memcpy(buffer, e->data + off, size);
+            return LFS_ERR_OK;
+        }
+    }
+
     mtd_nor = (struct rt_mtd_nor_device *)c->context;
     if (rt_mtd_nor_read(mtd_nor, block * c->block_size + off, buffer, size) != size)
     {
@@ -434,16 +619,31 @@ static int _lfs_flash_read(const struct lfs_config *c, lfs_block_t block, lfs_of
 static int _lfs_flash_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     struct rt_mtd_nor_device *mtd_nor;
+    dfs_lfs_t *dfs_lfs = rt_container_of(c, dfs_lfs_t, cfg);
+    lfs_blk_cache_t *e;
 
     RT_ASSERT(c != RT_NULL);
     RT_ASSERT(c->context != RT_NULL);
 
+#ifdef RT_LFS_ASYNC_ERASE
+    _lfs_erase_wait(dfs_lfs, block);
+    if (block == dfs_lfs->erase_bad)
+    {
+        return LFS_ERR_CORRUPT;
+    }
+#endif /* RT_LFS_ASYNC_ERASE */
+
+    e = _lfs_bcache_find(dfs_lfs, block);
     mtd_nor = (struct rt_mtd_nor_device *)c->context;
     if (rt_mtd_nor_write(mtd_nor, block * c->block_size + off, buffer, size) != size)
     {
+        if (e) e->block = LFS_BLK_NONE;
         return LFS_ERR_IO;
     }
 
+    // Block was erased before, so cached copy becomes written data
+    if (e) memcpy(e->data + off, buffer, size);
+
     return LFS_ERR_OK;
 }
 
@@ -454,11 +654,38 @@ static int _lfs_flash_prog(const struct lfs_config *c, lfs_block_t block, lfs_of
 static int _lfs_flash_erase(const struct lfs_config *c, lfs_block_t block)
 {
     struct rt_mtd_nor_device *mtd_nor;
+    dfs_lfs_t *dfs_lfs = rt_container_of(c, dfs_lfs_t, cfg);
+    lfs_blk_cache_t *e;
 
     RT_ASSERT(c != RT_NULL);
     RT_ASSERT(c->context != RT_NULL);
 
+    e = _lfs_bcache_find(dfs_lfs, block);
+    if (e) e->block = LFS_BLK_NONE;
+
     mtd_nor = (struct rt_mtd_nor_device *)c->context;
+#ifdef RT_LFS_ASYNC_ERASE
+    {
+        struct rt_device_phy_addr_mapping mapping;
+
+        // Only one erase in flight, littlefs progs the block soon after
+        _lfs_erase_wait(dfs_lfs, LFS_BLK_NONE);
+        if (block == dfs_lfs->erase_bad)
+            dfs_lfs->erase_bad = LFS_BLK_NONE;
+
+        mapping.logical_addr = mtd_nor->block_start * mtd_nor->block_size + block * c->block_size;
+        if (mtd_nor->ops->control
+                && (RT_EOK == mtd_nor->ops->control(mtd_nor, RT_DEVICE_CTRL_GET_PHY_ADDR, &mapping)))
+        {
+            dfs_lfs->erase_block = block;
+            if (0 == rt_flash_erase_async(mapping.physical_addr, c->block_size, _lfs_erase_done, dfs_lfs))
+            {
+                return LFS_ERR_OK;
+            }
+            dfs_lfs->erase_block = LFS_BLK_NONE;
+        }
+    }
+#endif /* RT_LFS_ASYNC_ERASE */
     if (rt_mtd_nor_erase_block(mtd_nor, block * c->block_size, c->block_size) != RT_EOK)
     {
         return LFS_ERR_IO;
@@ -471,6 +698,9 @@ static int _lfs_flash_erase(const struct lfs_config *c, lfs_block_t block)
 // are propogated to the user.
 static int _lfs_flash_sync(const struct lfs_config *c)
 {
+#ifdef RT_LFS_ASYNC_ERASE
+    _lfs_erase_wait(rt_container_of(c, dfs_lfs_t, cfg), LFS_BLK_NONE);
+#endif /* RT_LFS_ASYNC_ERASE */
     return LFS_ERR_OK;
 }
 static void _lfs_load_config(struct lfs_config *lfs_cfg, struct rt_device *mtd_dev)
@@ -565,6 +795,61 @@ static int _get_disk(rt_device_t dev_id)
 
 #endif /* RT_LFS_DHARA_ENABLED */
 
+// Apply per mount cache sizes and allocate buffers, called after _lfs_load_config
+static void _lfs_cache_config(dfs_lfs_t *dfs_lfs)
+{
+    struct lfs_config *cfg = &dfs_lfs->cfg;
+    uint32_t size;
+
+    size = dfs_lfs->opt.cache_size;
+    if (size && (0 == size % cfg->prog_size) && (0 == size % cfg->read_size) && (0 == cfg->block_size % size))
+    {
+        cfg->cache_size = size;
+    }
+    size = dfs_lfs->opt.lookahead_size;
+    if (size && (0 == size % 8))
+    {
+        cfg->lookahead_size = size;
+    }
+
+    if (dfs_lfs->cache_inited)
+    {
+        return;
+    }
+    dfs_lfs->cache_inited = true;
+
+    if (dfs_lfs->opt.cache_size || dfs_lfs->opt.lookahead_size)
+    {
+        cfg->read_buffer = LFS_CACHE_MALLOC(cfg->cache_size);
+        cfg->prog_buffer = LFS_CACHE_MALLOC(cfg->cache_size);
+        cfg->lookahead_buffer = LFS_CACHE_MALLOC(cfg->lookahead_size);
+    }
+#ifndef RT_LFS_DHARA_ENABLED
+    _lfs_nor_cache_init(dfs_lfs);
+#endif /* !RT_LFS_DHARA_ENABLED */
+}
+
+static void _lfs_cache_deconfig(dfs_lfs_t *dfs_lfs)
+{
+    struct lfs_config *cfg = &dfs_lfs->cfg;
+
+    if (!dfs_lfs->cache_inited)
+    {
+        return;
+    }
+    dfs_lfs->cache_inited = false;
+
+#ifndef RT_LFS_DHARA_ENABLED
+    _lfs_nor_cache_deinit(dfs_lfs);
+#endif /* !RT_LFS_DHARA_ENABLED */
+    if (cfg->read_buffer) LFS_CACHE_FREE(cfg->read_buffer);
+    if (cfg->prog_buffer) LFS_CACHE_FREE(cfg->prog_buffer);
+    if (cfg->lookahead_buffer) LFS_CACHE_FREE(cfg->lookahead_buffer);
+    cfg->read_buffer = RT_NULL;
+    cfg->prog_buffer = RT_NULL;
+    cfg->lookahead_buffer = RT_NULL;
+}
+
 
 static int _lfs_result_to_dfs(int result)
 {
@@ -658,13 +943,21 @@ static int _dfs_lfs_mount(struct dfs_filesystem *dfs, unsigned long rwflag, cons
     }
     rt_memset(dfs_lfs, 0, sizeof(dfs_lfs_t));
     rt_mutex_init(&dfs_lfs->lock, "lfslock", RT_IPC_FLAG_PRIO);
+    if (data)
+    {
+        memcpy(&dfs_lfs->opt, data, sizeof(dfs_lfs->opt));
+    }
     _lfs_load_config(&dfs_lfs->cfg, dfs->dev_id);
+    _lfs_cache_config(dfs_lfs);
 
     /* mount lfs*/
+    dfs_lfs->mount_ms = rt_tick_get_millisecond();
     result = lfs_mount(&dfs_lfs->lfs, &dfs_lfs->cfg);
+    dfs_lfs->mount_ms = rt_tick_get_millisecond() - dfs_lfs->mount_ms;
     if (result != LFS_ERR_OK)
     {
         rt_mutex_detach(&dfs_lfs->lock);
+        _lfs_cache_deconfig(dfs_lfs);
         _lfs_load_deconfig(&dfs_lfs->cfg);
         /* release memory */
         rt_free(dfs_lfs);
@@ -700,6 +993,7 @@ static int _dfs_lfs_unmount(struct dfs_filesystem *dfs)
 
     result = lfs_unmount(&dfs_lfs->lfs);
     rt_mutex_detach(&dfs_lfs->lock);
+    _lfs_cache_deconfig(dfs_lfs);
     _lfs_load_deconfig(&dfs_lfs->cfg);
     rt_free(dfs_lfs);
 
@@ -738,10 +1032,12 @@ static int _dfs_lfs_mkfs(rt_device_t dev_id)
         rt_memset(dfs_lfs, 0, sizeof(dfs_lfs_t));
         rt_mutex_init(&dfs_lfs->lock, "lfslock", RT_IPC_FLAG_PRIO);
         _lfs_load_config(&dfs_lfs->cfg, dev_id);
+        _lfs_cache_config(dfs_lfs);
 
         /* format flash device */
         result = lfs_format(&dfs_lfs->lfs, &dfs_lfs->cfg);
         rt_mutex_detach(&dfs_lfs->lock);
+        _lfs_cache_deconfig(dfs_lfs);
         _lfs_load_deconfig(&dfs_lfs->cfg);
         rt_free(dfs_lfs);
         return _lfs_result_to_dfs(result);
@@ -766,6 +1062,7 @@ static int _dfs_lfs_mkfs(rt_device_t dev_id)
     _lfs_mount_tbl[index] = RT_NULL;
 
     _lfs_load_config(&dfs_lfs->cfg, dev_id);
+    _lfs_cache_config(dfs_lfs);
 
     /* mount lfs*/
     result = lfs_mount(&dfs_lfs->lfs, &dfs_lfs->cfg);
@@ -776,6 +1073,7 @@ static int _dfs_lfs_mkfs(rt_device_t dev_id)
     else
     {
         rt_mutex_detach(&dfs_lfs->lock);
+        _lfs_cache_deconfig(dfs_lfs);
         _lfs_load_deconfig(&dfs_lfs->cfg);
         /* release memory */
         rt_free(dfs_lfs);
@@ -1242,6 +1540,86 @@ static const struct dfs_file_ops _dfs_lfs_fops =
     //    RT_NULL, /* poll interface */
 };
 
+#ifdef RT_USING_FINSH
+#include <dfs_posix.h>
+
+static rt_err_t lfs_cache_stat(int argc, char **argv)
+{
+    for (int i = 0; i < RT_DEF_LFS_DRIVERS; i++)
+    {
+        dfs_lfs_t *dfs_lfs = _lfs_mount_tbl[i];
+
+        if (!dfs_lfs)
+            continue;
+
+        rt_kprintf("lfs%d: mount=%dms cache=%d lookahead=%d\n", i, dfs_lfs->mount_ms,
+                   dfs_lfs->cfg.cache_size, dfs_lfs->cfg.lookahead_size);
+        rt_kprintf("  block cache=%d hit=%d miss=%d\n", dfs_lfs->bcache_num,
+                   dfs_lfs->bcache_hit, dfs_lfs->bcache_miss);
+        if ((argc > 1) && (0 == strcmp(argv[1], "reset")))
+        {
+            dfs_lfs->bcache_hit = 0;
+            dfs_lfs->bcache_miss = 0;
+        }
+    }
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(lfs_cache_stat, lfs_cache_stat [reset]: show littlefs mount time and cache);
+
+/* Open and close every file in a directory, e.g. a watchface asset folder */
+static rt_err_t lfs_bench(int argc, char **argv)
+{
+    char *path;
+    DIR *dir;
+    struct dirent *ent;
+    rt_tick_t start, t, max = 0, total;
+    int fd, count = 0;
+
+    if (argc < 2)
+    {
+        rt_kprintf("usage: lfs_bench <dir>\n");
+        return -RT_EINVAL;
+    }
+
+    path = rt_malloc(DFS_PATH_MAX);
+    RT_ASSERT(path);
+
+    total = rt_tick_get_millisecond();
+    dir = opendir(argv[1]);
+    if (!dir)
+    {
+        rt_kprintf("open %s failed\n", argv[1]);
+        rt_free(path);
+        return -RT_ERROR;
+    }
+    while ((ent = readdir(dir)) != RT_NULL)
+    {
+        if (DT_REG != ent->d_type)
+            continue;
+
+        rt_snprintf(path, DFS_PATH_MAX, "%s/%s", argv[1], ent->d_name);
+        start = rt_tick_get_millisecond();
+        fd = open(path, O_RDONLY);
+        if (fd >= 0)
+            close(fd);
+        t = rt_tick_get_millisecond() - start;
+        if (t > max)
+            max = t;
+        count++;
+    }
+    closedir(dir);
+    total = rt_tick_get_millisecond() - total;
+    rt_free(path);
+
+    rt_kprintf("%d files in %dms, open avg=%dms max=%dms\n", count, total,
+               count ? total / count : 0, max);
+
+    return RT_EOK;
+}
+MSH_CMD_EXPORT(lfs_bench, lfs_bench <dir>: measure littlefs open latency);
+#endif /* RT_USING_FINSH */
+
 static const struct dfs_filesystem_ops _dfs_lfs_ops =
 {
     "lfs",
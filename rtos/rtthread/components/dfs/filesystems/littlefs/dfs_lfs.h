@@ -0,0 +1,29 @@
+#ifndef DFS_LFS_H__
+#define DFS_LFS_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Per mount cache options, pass as data of dfs_mount(), e.g.
+ *
+ *     static const dfs_lfs_mount_opt_t opt = {.cache_size = 4096, .meta_cache_blocks = 8};
+ *     dfs_mount("flash2", "/", "lfs", 0, &opt);
+ *
+ * Buffers are allocated from PSRAM cache heap if available. Zero field keeps default.
+ */
+typedef struct
+{
+    uint32_t cache_size;        /**< Read/prog cache size, multiple of prog size and factor of block size */
+    uint32_t lookahead_size;    /**< Lookahead bitmap size in bytes, multiple of 8 */
+    uint16_t meta_cache_blocks; /**< Number of whole blocks cached across opens, NOR only */
+} dfs_lfs_mount_opt_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFS_LFS_H__ */
@@ -1,8 +1,15 @@
 #include "lfs_util.h"
+#ifdef BSP_USING_HW_CRC
+#include "drv_crc.h"
+#endif
 
 // Software CRC implementation with small lookup table
 uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size)
 {
+#ifdef BSP_USING_HW_CRC
+    /* lfs keeps CRC-32 without final xor */
+    return drv_crc_accumulate(CRC_32, crc, buffer, size);
+#else
     static const uint32_t rtable[16] =
     {
         0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
@@ -20,4 +27,5 @@ uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size)
     }
 
     return crc;
+#endif
 }
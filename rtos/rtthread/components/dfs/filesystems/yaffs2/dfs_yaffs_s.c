@@ -7,6 +7,29 @@
 #include "yaffs/direct/yaffs_flashif.h"
 #include "yaffs/yaffs_mtdif.h"
 
+/* Mounted devices, checkpoint is written to them on shutdown */
+static struct yaffs_dev *yaffs_mounted[DFS_FILESYSTEMS_MAX];
+
+int dfs_yaffs_checkpoint_all(void)
+{
+    int ret = 0;
+
+    for (int i = 0; i < DFS_FILESYSTEMS_MAX; i++)
+    {
+        if (!yaffs_mounted[i])
+            continue;
+
+        /* Full sync writes checkpoint, next mount restores from it instead of scanning */
+        if (yaffs_sync_reldev(yaffs_mounted[i]) < 0)
+        {
+            rt_kprintf("yaffs checkpoint %s failed:%d\n", yaffs_mounted[i]->param.name, yaffsfs_GetLastError());
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
 static int dfs_yfile_open(struct dfs_fd *file)
 {
     struct dfs_filesystem *fs;
@@ -234,9 +257,11 @@ static int dfs_yaffs_mount(struct dfs_filesystem *fs, unsigned long rwflag, cons
 
     mtd_dev->priv = p_yaffs_dev;
 
+    rt_tick_t start = rt_tick_get_millisecond();
     int res = yaffs_mount(fs->path);
 
-    rt_kprintf("mount:%d\n", res);
+    rt_kprintf("mount:%d, %dms, checkpoint:%d\n", res, rt_tick_get_millisecond() - start,
+               p_yaffs_dev->is_checkpointed);
 
     if (res < 0)
     {
@@ -247,6 +272,14 @@ static int dfs_yaffs_mount(struct dfs_filesystem *fs, unsigned long rwflag, cons
     }
 
     fs->data = p_yaffs_dev;
+    for (int i = 0; i < DFS_FILESYSTEMS_MAX; i++)
+    {
+        if (!yaffs_mounted[i])
+        {
+            yaffs_mounted[i] = p_yaffs_dev;
+            break;
+        }
+    }
 
     return 0;
 }
@@ -260,6 +293,11 @@ static int dfs_yaffs_unmount(struct dfs_filesystem *fs)
 
 
     p_yaffs_dev = (struct yaffs_dev *)fs->data;
+    for (int i = 0; i < DFS_FILESYSTEMS_MAX; i++)
+    {
+        if (yaffs_mounted[i] == p_yaffs_dev)
+            yaffs_mounted[i] = RT_NULL;
+    }
 
     yaffs_remove_device(p_yaffs_dev);
     rt_free(p_yaffs_dev);
@@ -47,6 +47,21 @@
     #define DFS_FILESYSTEM_TYPES_MAX 2
 #endif
 
+#ifdef DFS_USING_READAHEAD
+/*
+ * default read-ahead block size of each mount point, 0 to enable it
+ * only by dfs_readahead_set()
+ */
+#ifndef DFS_READAHEAD_SIZE
+    #define DFS_READAHEAD_SIZE       4096
+#endif
+
+/* number of back to back reads before a file is treated as sequential */
+#ifndef DFS_READAHEAD_SEQ_MIN
+    #define DFS_READAHEAD_SEQ_MIN    2
+#endif
+#endif /* DFS_USING_READAHEAD */
+
 #define DFS_FS_FLAG_DEFAULT     0x00    /* default flag */
 #define DFS_FS_FLAG_FULLPATH    0x01    /* set full path to underlaying file system */
 
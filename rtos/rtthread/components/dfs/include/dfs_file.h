@@ -52,11 +52,27 @@ struct dfs_fd
     off_t    pos;                /* Current file position */
 
     void *data;                  /* Specific file system data */
+#ifdef DFS_USING_READAHEAD
+    void *ra;                    /* Read-ahead state of read only file */
+#endif
+};
+
+#ifdef DFS_USING_READAHEAD
+struct dfs_ra_stat
+{
+    uint32_t hit;                /* reads served from read-ahead buffer */
+    uint32_t miss;               /* reads accessed file system */
+    uint32_t prefetch;           /* blocks queued to read-ahead worker */
+    uint32_t block_size;
 };
 
+int dfs_file_readahead_stat(struct dfs_fd *fd, struct dfs_ra_stat *stat);
+#endif
+
 int dfs_file_open(struct dfs_fd *fd, const char *path, int flags);
 int dfs_file_close(struct dfs_fd *fd);
 int dfs_file_ioctl(struct dfs_fd *fd, int cmd, void *args);
+int dfs_file_mmap(struct dfs_fd *fd, off_t offset, size_t len, void **addr);
 int dfs_file_read(struct dfs_fd *fd, void *buf, size_t len);
 int dfs_file_getdents(struct dfs_fd *fd, struct dirent *dirp, size_t nbytes);
 int dfs_file_unlink(const char *path);
@@ -52,6 +52,9 @@ struct dfs_filesystem
     const struct dfs_filesystem_ops *ops; /* Operations for file system type */
 
     void *data;             /* Specific file system data */
+#ifdef DFS_USING_READAHEAD
+    uint32_t ra_size;       /* Read-ahead block size, 0: disabled */
+#endif
 };
 
 /* file system partition table */
@@ -91,6 +94,10 @@ int dfs_unmount(const char *specialfile);
 int dfs_mkfs(const char *fs_name, const char *device_name);
 int dfs_statfs(const char *path, struct statfs *buffer);
 
+#ifdef DFS_USING_READAHEAD
+int dfs_readahead_set(const char *path, uint32_t size);
+#endif
+
 #ifdef RT_USING_DFS_MNTTABLE
 int dfs_mount_table(void);
 int dfs_unmount_table(void);
@@ -72,6 +72,7 @@ int fstat(int fildes, struct stat *buf);
 int fsync(int fildes);
 int fcntl(int fildes, int cmd, ...);
 int ioctl(int fildes, int cmd, ...);
+void *dfs_mmap(int fildes, off_t offset, size_t len);
 
 /* directory api*/
 int rmdir(const char *path);
@@ -25,4 +25,13 @@ extern const struct dfs_mount_tbl mount_table[];
 
 extern char working_directory[];
 
+#ifdef DFS_USING_READAHEAD
+struct dfs_fd;
+int dfs_ra_init(void);
+int dfs_ra_open(struct dfs_fd *fd);
+void dfs_ra_close(struct dfs_fd *fd);
+int dfs_ra_read(struct dfs_fd *fd, void *buf, size_t len);
+int dfs_ra_lseek(struct dfs_fd *fd, off_t offset);
+#endif
+
 #endif
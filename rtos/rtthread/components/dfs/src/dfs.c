@@ -65,6 +65,10 @@ int dfs_init(void)
     /* create device filesystem lock */
     rt_mutex_init(&fslock, "fslock", RT_IPC_FLAG_FIFO);
 
+#ifdef DFS_USING_READAHEAD
+    dfs_ra_init();
+#endif
+
 #ifdef DFS_USING_WORKDIR
     /* set current working directory */
     memset(working_directory, 0, sizeof(working_directory));
@@ -556,6 +560,16 @@ int list_fd(void)
             {
                 rt_kprintf("\n");
             }
+#ifdef DFS_USING_READAHEAD
+            if (fd->ra)
+            {
+                struct dfs_ra_stat stat;
+
+                if (dfs_file_readahead_stat(fd, &stat) == 0)
+                    rt_kprintf("   read-ahead %d: hit %d miss %d prefetch %d\n",
+                               stat.block_size, stat.hit, stat.miss, stat.prefetch);
+            }
+#endif
         }
     }
     rt_exit_critical();
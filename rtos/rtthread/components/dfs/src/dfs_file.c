@@ -110,6 +110,10 @@ int dfs_file_open(struct dfs_fd *fd, const char *path, int flags)
         fd->type = FT_DIRECTORY;
         fd->flags |= DFS_F_DIRECTORY;
     }
+#ifdef DFS_USING_READAHEAD
+    /* file still works without read-ahead */
+    dfs_ra_open(fd);
+#endif
 
     LOG_D("open successful");
     return 0;
@@ -129,6 +133,10 @@ int dfs_file_close(struct dfs_fd *fd)
     if (fd == NULL)
         return -ENXIO;
 
+#ifdef DFS_USING_READAHEAD
+    dfs_ra_close(fd);
+#endif
+
     if (fd->fops->close != NULL)
         result = fd->fops->close(fd);
 
@@ -182,6 +190,39 @@ int dfs_file_ioctl(struct dfs_fd *fd, int cmd, void *args)
     return -ENOSYS;
 }
 
+/**
+ * this function will get the memory mapped (XIP) address of file content, so that
+ * it could be accessed by CPU or DMA without copy. It only succeeds if the file
+ * system stores the file contiguously in memory mapped flash or RAM, e.g. romfs.
+ *
+ * @param fd the file descriptor.
+ * @param offset the offset of mapped content in file.
+ * @param len the length of mapped content.
+ * @param addr the mapped address of offset.
+ *
+ * @return 0 on successful or -1 on failed. Address keeps valid until file is modified.
+ */
+int dfs_file_mmap(struct dfs_fd *fd, off_t offset, size_t len, void **addr)
+{
+    rt_uint32_t phy_addr;
+
+    if (fd == NULL || addr == NULL || fd->type != FT_REGULAR)
+        return -EINVAL;
+
+    if ((offset < 0) || ((size_t)offset + len > fd->size))
+        return -EINVAL;
+
+    if (fd->fops->ioctl == NULL)
+        return -ENOSYS;
+
+    if (fd->fops->ioctl(fd, F_GET_PHY_ADDR, &phy_addr) != 0)
+        return -EIO;
+
+    *addr = (void *)(phy_addr + offset);
+
+    return 0;
+}
+
 /**
  * this function will read specified length data from a file descriptor to a
  * buffer.
@@ -202,7 +243,14 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, size_t len)
     if (fd->fops->read == NULL)
         return -ENOSYS;
 
-    if ((result = fd->fops->read(fd, buf, len)) < 0)
+#ifdef DFS_USING_READAHEAD
+    if (fd->ra)
+        result = dfs_ra_read(fd, buf, len);
+    else
+#endif
+        result = fd->fops->read(fd, buf, len);
+
+    if (result < 0)
         fd->flags |= DFS_F_EOF;
 
     return result;
@@ -338,7 +386,12 @@ int dfs_file_lseek(struct dfs_fd *fd, off_t offset)
     if (fd->fops->lseek == NULL)
         return -ENOSYS;
 
-    result = fd->fops->lseek(fd, offset);
+#ifdef DFS_USING_READAHEAD
+    if (fd->ra)
+        result = dfs_ra_lseek(fd, offset);
+    else
+#endif
+        result = fd->fops->lseek(fd, offset);
 
     /* update current position */
     if (result >= 0)
@@ -327,6 +327,9 @@ int dfs_mount(const char   *device_name,
     fs->path   = fullpath;
     fs->ops    = *ops;
     fs->dev_id = dev_id;
+#ifdef DFS_USING_READAHEAD
+    fs->ra_size = DFS_READAHEAD_SIZE;
+#endif
     /* release filesystem_table lock */
     dfs_unlock();
 
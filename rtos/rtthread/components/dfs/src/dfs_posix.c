@@ -385,6 +385,45 @@ int fstat(int fildes, struct stat *buf)
 }
 RTM_EXPORT(fstat);
 
+/**
+ * this function is not POSIX compliant, which returns the memory mapped (XIP)
+ * address of file content, so that it could be passed to CPU or hardware such as
+ * EPIC/EZIP without being read to RAM. No unmap is needed, the address stays valid
+ * after the file is closed as long as the file is not modified.
+ *
+ * @param fildes the file description
+ * @param offset the offset of content in file
+ * @param len the length of content
+ *
+ * @return the mapped address, RT_NULL if the file is not contiguous in mapped memory.
+ */
+void *dfs_mmap(int fildes, off_t offset, size_t len)
+{
+    struct dfs_fd *d;
+    void *addr;
+    int result;
+
+    d = fd_get(fildes);
+    if (d == NULL)
+    {
+        rt_set_errno(-EBADF);
+
+        return RT_NULL;
+    }
+
+    result = dfs_file_mmap(d, offset, len, &addr);
+    fd_put(d);
+    if (result < 0)
+    {
+        rt_set_errno(result);
+
+        return RT_NULL;
+    }
+
+    return addr;
+}
+RTM_EXPORT(dfs_mmap);
+
 /**
  * this function is a POSIX compliant version, which shall request that all data
  * for the open file descriptor named by fildes is to be transferred to the storage
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ */
+
+#include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_file.h>
+#include <dfs_private.h>
+
+#ifdef DFS_USING_READAHEAD
+
+#ifndef DFS_READAHEAD_THREAD_PRIORITY
+    #define DFS_READAHEAD_THREAD_PRIORITY   (RT_THREAD_PRIORITY_MAX / 3)
+#endif
+
+#ifndef DFS_READAHEAD_THREAD_STACK_SIZE
+    #define DFS_READAHEAD_THREAD_STACK_SIZE 2048
+#endif
+
+/* block buffer alignment, for DMA of underlying device */
+#ifndef DFS_READAHEAD_ALIGN
+    #define DFS_READAHEAD_ALIGN             32
+#endif
+
+#define RA_SLOT_EMPTY       0
+#define RA_SLOT_VALID       1
+#define RA_SLOT_LOADING     2   /* queued to or being filled by worker */
+
+struct dfs_ra_slot
+{
+    uint8_t *buf;
+    off_t    off;               /* file offset of buf */
+    uint32_t len;               /* valid bytes, less than block size at end of file */
+    uint8_t  state;
+};
+
+/*
+ * Read-ahead state of a read only file.
+ *
+ * Two block buffers are used, one serves reads while the worker fills the
+ * next block into the other one. The worker reads through a copy of the fd
+ * so fd->pos always follows the reader, file system position is restored by
+ * lseek before the reader accesses file system directly.
+ *
+ * Lock order: ra_list_lock -> io -> lock
+ */
+struct dfs_ra
+{
+    rt_list_t list;
+    struct dfs_fd *fd;
+    struct rt_mutex io;         /* serializes file system access */
+    struct rt_mutex lock;       /* protects slots and counters */
+    struct dfs_ra_slot slot[2];
+    uint32_t size;              /* block size */
+    off_t    expect;            /* position of next sequential read */
+    uint8_t  seq;               /* number of sequential reads */
+    uint8_t  moved;             /* file system position differs from fd->pos */
+    uint8_t  job;               /* slot index + 1 queued to worker, 0: none */
+    struct dfs_ra_stat stat;
+};
+
+static rt_list_t ra_list = RT_LIST_OBJECT_INIT(ra_list);
+static struct rt_mutex ra_list_lock;
+static struct rt_semaphore ra_sem;
+static rt_thread_t ra_thread;
+
+/* io must be held */
+static void ra_fill(struct dfs_ra *ra, int idx)
+{
+    struct dfs_ra_slot *s = &ra->slot[idx];
+    struct dfs_fd shadow = *ra->fd;
+    int len = -EIO;
+
+    if (ra->fd->fops->lseek(&shadow, s->off) == s->off)
+        len = ra->fd->fops->read(&shadow, s->buf, ra->size);
+    ra->moved = 1;
+
+    rt_mutex_take(&ra->lock, RT_WAITING_FOREVER);
+    if (len > 0)
+    {
+        s->len = len;
+        s->state = RA_SLOT_VALID;
+    }
+    else
+    {
+        s->state = RA_SLOT_EMPTY;
+    }
+    rt_mutex_release(&ra->lock);
+}
+
+/* queue next block of slot cur to worker, lock must be held */
+static void ra_schedule(struct dfs_ra *ra, int cur)
+{
+    struct dfs_ra_slot *s = &ra->slot[cur], *next = &ra->slot[cur ^ 1];
+    off_t off = s->off + ra->size;
+
+    /* end of file reached */
+    if (s->len < ra->size || off >= (off_t)ra->fd->size)
+        return;
+    if (next->state == RA_SLOT_LOADING || (next->state == RA_SLOT_VALID && next->off == off))
+        return;
+
+    next->off = off;
+    next->len = 0;
+    next->state = RA_SLOT_LOADING;
+    ra->job = (cur ^ 1) + 1;
+    ra->stat.prefetch++;
+    rt_sem_release(&ra_sem);
+}
+
+/* copy cached data at fd->pos, lock must be held */
+static size_t ra_copy(struct dfs_ra *ra, uint8_t *buf, size_t len)
+{
+    struct dfs_fd *fd = ra->fd;
+    struct dfs_ra_slot *s;
+    size_t n, total = 0;
+    int i;
+
+    while (len > 0)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            s = &ra->slot[i];
+            if (s->state == RA_SLOT_VALID && fd->pos >= s->off && fd->pos < s->off + (off_t)s->len)
+                break;
+        }
+        if (i == 2)
+            break;
+
+        n = s->off + s->len - fd->pos;
+        if (n > len)
+            n = len;
+        memcpy(buf, s->buf + (fd->pos - s->off), n);
+        buf += n;
+        len -= n;
+        total += n;
+        fd->pos += n;
+
+        ra_schedule(ra, i);
+    }
+
+    return total;
+}
+
+static void ra_worker(void *parameter)
+{
+    struct dfs_ra *ra, *found;
+    int idx;
+
+    while (1)
+    {
+        rt_sem_take(&ra_sem, RT_WAITING_FOREVER);
+
+        do
+        {
+            found = RT_NULL;
+            idx = -1;
+
+            rt_mutex_take(&ra_list_lock, RT_WAITING_FOREVER);
+            rt_list_for_each_entry(ra, &ra_list, list)
+            {
+                if (ra->job)
+                {
+                    found = ra;
+                    break;
+                }
+            }
+            if (found)
+            {
+                /* closing fd waits on io after removed from list */
+                rt_mutex_take(&found->io, RT_WAITING_FOREVER);
+            }
+            rt_mutex_release(&ra_list_lock);
+
+            if (found)
+            {
+                rt_mutex_take(&found->lock, RT_WAITING_FOREVER);
+                idx = found->job - 1;
+                found->job = 0;
+                rt_mutex_release(&found->lock);
+
+                /* job may be taken by reader while waiting io */
+                if (idx >= 0)
+                    ra_fill(found, idx);
+                rt_mutex_release(&found->io);
+            }
+        }
+        while (found);
+    }
+}
+
+static int ra_alloc_buf(struct dfs_ra *ra)
+{
+    uint8_t *buf;
+
+    if (ra->slot[0].buf)
+        return 0;
+
+    buf = rt_malloc_align(ra->size * 2, DFS_READAHEAD_ALIGN);
+    if (buf == RT_NULL)
+    {
+        LOG_W("read-ahead of %s disabled, no memory", ra->fd->path);
+        return -ENOMEM;
+    }
+    ra->slot[0].buf = buf;
+    ra->slot[1].buf = buf + ra->size;
+
+    return 0;
+}
+
+int dfs_ra_init(void)
+{
+    rt_mutex_init(&ra_list_lock, "ra_list", RT_IPC_FLAG_FIFO);
+    rt_sem_init(&ra_sem, "ra", 0, RT_IPC_FLAG_FIFO);
+
+    return 0;
+}
+
+int dfs_ra_open(struct dfs_fd *fd)
+{
+    struct dfs_ra *ra;
+
+    fd->ra = RT_NULL;
+    if (fd->type != FT_REGULAR || (fd->flags & (O_WRONLY | O_RDWR)) || fd->fs->ra_size == 0
+            || fd->fops->lseek == RT_NULL || fd->fops->read == RT_NULL)
+        return 0;
+
+    ra = rt_calloc(1, sizeof(struct dfs_ra));
+    if (ra == RT_NULL)
+        return -ENOMEM;
+
+    ra->fd = fd;
+    ra->size = fd->fs->ra_size;
+    ra->expect = -1;
+    ra->stat.block_size = ra->size;
+    rt_mutex_init(&ra->io, "ra_io", RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&ra->lock, "ra", RT_IPC_FLAG_FIFO);
+
+    rt_mutex_take(&ra_list_lock, RT_WAITING_FOREVER);
+    if (ra_thread == RT_NULL)
+    {
+        ra_thread = rt_thread_create("dfs_ra", ra_worker, RT_NULL,
+                                     DFS_READAHEAD_THREAD_STACK_SIZE, DFS_READAHEAD_THREAD_PRIORITY, 10);
+        if (ra_thread)
+            rt_thread_startup(ra_thread);
+    }
+    if (ra_thread == RT_NULL)
+    {
+        rt_mutex_release(&ra_list_lock);
+        rt_mutex_detach(&ra->io);
+        rt_mutex_detach(&ra->lock);
+        rt_free(ra);
+        return -ENOMEM;
+    }
+    rt_list_insert_before(&ra_list, &ra->list);
+    rt_mutex_release(&ra_list_lock);
+
+    fd->ra = ra;
+
+    return 0;
+}
+
+void dfs_ra_close(struct dfs_fd *fd)
+{
+    struct dfs_ra *ra = fd->ra;
+
+    if (ra == RT_NULL)
+        return;
+
+    rt_mutex_take(&ra_list_lock, RT_WAITING_FOREVER);
+    rt_list_remove(&ra->list);
+    rt_mutex_release(&ra_list_lock);
+
+    /* wait for worker filling this file */
+    rt_mutex_take(&ra->io, RT_WAITING_FOREVER);
+    rt_mutex_release(&ra->io);
+
+    if (ra->slot[0].buf)
+        rt_free_align(ra->slot[0].buf);
+    rt_mutex_detach(&ra->io);
+    rt_mutex_detach(&ra->lock);
+    rt_free(ra);
+    fd->ra = RT_NULL;
+}
+
+int dfs_ra_read(struct dfs_fd *fd, void *buf, size_t len)
+{
+    struct dfs_ra *ra = fd->ra;
+    uint8_t *p = buf;
+    size_t n;
+    int idx, result;
+
+    rt_mutex_take(&ra->lock, RT_WAITING_FOREVER);
+    if (fd->pos == ra->expect)
+    {
+        if (ra->seq < 0xFF)
+            ra->seq++;
+    }
+    else
+    {
+        ra->seq = 0;
+    }
+
+    n = ra_copy(ra, p, len);
+    if (n == len)
+    {
+        ra->stat.hit++;
+        ra->expect = fd->pos;
+        rt_mutex_release(&ra->lock);
+        return n;
+    }
+    rt_mutex_release(&ra->lock);
+
+    rt_mutex_take(&ra->io, RT_WAITING_FOREVER);
+    rt_mutex_take(&ra->lock, RT_WAITING_FOREVER);
+
+    /* worker may have filled the block meanwhile */
+    n += ra_copy(ra, p + n, len - n);
+    if (n < len)
+        ra->stat.miss++;
+
+    /* sequential small read, fill the block holding fd->pos and serve from it */
+    if (n < len && ra->seq >= DFS_READAHEAD_SEQ_MIN && len - n < ra->size
+            && fd->pos < (off_t)fd->size && ra_alloc_buf(ra) == 0)
+    {
+        off_t off = fd->pos - fd->pos % ra->size;
+
+        /* worker isn't running as io is held, a LOADING slot is only queued,
+           take it over if it's the wanted block, otherwise use the other slot */
+        idx = (ra->slot[0].state == RA_SLOT_LOADING) ? 1 : 0;
+        if (ra->slot[idx ^ 1].state == RA_SLOT_LOADING && ra->slot[idx ^ 1].off == off)
+            idx ^= 1;
+        if (ra->job == idx + 1)
+            ra->job = 0;
+
+        ra->slot[idx].off = off;
+        ra->slot[idx].state = RA_SLOT_LOADING;
+        rt_mutex_release(&ra->lock);
+
+        ra_fill(ra, idx);
+
+        rt_mutex_take(&ra->lock, RT_WAITING_FOREVER);
+        n += ra_copy(ra, p + n, len - n);
+    }
+
+    /* random or large read goes to file system directly */
+    if (n < len)
+    {
+        if (ra->moved)
+        {
+            fd->fops->lseek(fd, fd->pos);
+            ra->moved = 0;
+        }
+        result = fd->fops->read(fd, p + n, len - n);
+        if (result < 0 && n == 0)
+        {
+            ra->expect = -1;
+            rt_mutex_release(&ra->lock);
+            rt_mutex_release(&ra->io);
+            return result;
+        }
+        if (result > 0)
+            n += result;
+    }
+
+    ra->expect = fd->pos;
+    rt_mutex_release(&ra->lock);
+    rt_mutex_release(&ra->io);
+
+    return n;
+}
+
+int dfs_ra_lseek(struct dfs_fd *fd, off_t offset)
+{
+    struct dfs_ra *ra = fd->ra;
+    int result;
+
+    /* file is read only, seek inside file only moves fd->pos */
+    if (offset >= 0 && offset <= (off_t)fd->size)
+    {
+        rt_mutex_take(&ra->lock, RT_WAITING_FOREVER);
+        if (offset != fd->pos)
+            ra->moved = 1;
+        rt_mutex_release(&ra->lock);
+        return offset;
+    }
+
+    rt_mutex_take(&ra->io, RT_WAITING_FOREVER);
+    result = fd->fops->lseek(fd, offset);
+    if (result >= 0)
+        ra->moved = 0;
+    rt_mutex_release(&ra->io);
+
+    return result;
+}
+
+/**
+ * this function will get read-ahead counters of a file descriptor.
+ *
+ * @param fd the file descriptor.
+ * @param stat the counters.
+ *
+ * @return 0 on successful, -ENOSYS if read-ahead isn't used by the file.
+ */
+int dfs_file_readahead_stat(struct dfs_fd *fd, struct dfs_ra_stat *stat)
+{
+    struct dfs_ra *ra;
+
+    if (fd == NULL || stat == NULL)
+        return -EINVAL;
+
+    ra = fd->ra;
+    if (ra == RT_NULL)
+        return -ENOSYS;
+
+    /* counters are only informative, no lock so it can be called in critical section */
+    *stat = ra->stat;
+
+    return 0;
+}
+
+/**
+ * this function will set read-ahead block size of a mounted file system,
+ * files opened later use the new size.
+ *
+ * @param path the mount point.
+ * @param size block size in bytes, 0 to disable read-ahead.
+ *
+ * @return 0 on successful, -ENOENT if not mounted.
+ */
+int dfs_readahead_set(const char *path, uint32_t size)
+{
+    struct dfs_filesystem *fs;
+
+    fs = dfs_filesystem_lookup(path);
+    if (fs == NULL || strcmp(fs->path, path) != 0)
+        return -ENOENT;
+
+    fs->ra_size = size;
+
+    return 0;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+static int readahead(int argc, char **argv)
+{
+    struct dfs_filesystem *iter;
+
+    if (argc > 2)
+    {
+        if (dfs_readahead_set(argv[1], strtoul(argv[2], NULL, 0)) != 0)
+            rt_kprintf("%s is not a mount point\n", argv[1]);
+        return 0;
+    }
+
+    rt_kprintf("mount point  block size\n");
+    for (iter = &filesystem_table[0]; iter < &filesystem_table[DFS_FILESYSTEMS_MAX]; iter++)
+    {
+        if (iter->ops == NULL)
+            continue;
+        rt_kprintf("%-12s %d\n", iter->path, iter->ra_size);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(readahead, readahead [mount point] [block size]);
+#endif /* RT_USING_FINSH */
+
+#endif /* DFS_USING_READAHEAD */
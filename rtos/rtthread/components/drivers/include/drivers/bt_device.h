@@ -117,6 +117,7 @@ typedef enum
     BT_CONTROL_PLAY_POWER_OFF_RING,         /**< control play power off ring */
     BT_CONTROL_SLEEP,                       /**< control bt sleep */
     BT_CONTROL_GET_RMT_NAME,                /**< get remote device name */
+    BT_CONTROL_SET_URC_BATCH,               /**< set batching of high rate events, args is bt_urc_batch_cfg_t */
 } bt_common_cmd_t;
 
 typedef enum
@@ -155,6 +156,7 @@ typedef enum
 #endif
     BT_EVENT_KEY_OVERLAID,
     BT_EVENT_RMT_NAME,
+    BT_EVENT_URC_BATCH,                 /**< several batched events, args is bt_urc_batch_t */
 } bt_common_event_t;
 
 #ifdef BT_USING_HF
@@ -711,6 +713,19 @@ typedef struct
     void *args;
 } bt_notify_t;
 
+typedef struct
+{
+    uint16_t flush_ms;          /**< max delay of batched event, 0 to disable batching */
+    uint16_t ref_size;          /**< event with larger payload is not batched and payload is passed by reference */
+} bt_urc_batch_cfg_t;
+
+/* SPP data and PBAP vcard list items are batched. args of items are valid during notify only */
+typedef struct
+{
+    uint16_t num;
+    bt_notify_t *items;         /**< events in original order */
+} bt_urc_batch_t;
+
 typedef struct
 {
     uint8_t conn_idx;
@@ -151,6 +151,37 @@ struct rt_sdio_driver
     struct rt_sdio_device_id *id;
 };
 
+#ifdef RT_SDIO_ASYNC_QUEUE
+/* request may be merged with following writes to same fifo into one multi block CMD53 */
+#define SDIO_ASYNC_FLAG_AGGR    0x01
+
+struct rt_sdio_async_req
+{
+    rt_list_t                list;
+    struct rt_sdio_function *func;
+    rt_int32_t               rw;
+    rt_uint32_t              addr;
+    rt_int32_t               op_code;
+    rt_uint8_t              *buf;
+    rt_uint32_t              len;
+    rt_uint32_t              flags;
+    rt_int32_t               err;
+    /* called in sdio async thread once request is done, req could be reused in it */
+    void (*done)(struct rt_sdio_async_req *req);
+    void                    *user_data;
+};
+
+struct rt_sdio_async_stat
+{
+    rt_uint32_t submitted;
+    rt_uint32_t transfers;      /* sdio_io_rw_extended_block calls */
+    rt_uint32_t merged;         /* requests sent together with previous one */
+    rt_uint32_t errors;
+    rt_uint32_t max_pending;
+    rt_uint32_t max_batch;
+};
+#endif /* RT_SDIO_ASYNC_QUEUE */
+
 rt_int32_t sdio_io_send_op_cond(struct rt_mmcsd_host *host,
                                 rt_uint32_t           ocr,
                                 rt_uint32_t          *cmd5_resp);
@@ -208,6 +239,11 @@ rt_int32_t sdio_io_write_multi_incr_b(struct rt_sdio_function *func,
                                       rt_uint32_t              addr,
                                       rt_uint8_t              *buf,
                                       rt_uint32_t              len);
+#ifdef RT_SDIO_ASYNC_QUEUE
+rt_int32_t sdio_io_rw_extended_async(struct rt_sdio_async_req *req);
+void sdio_async_cancel(struct rt_sdio_function *func);
+void sdio_async_get_stat(struct rt_sdio_async_stat *stat, rt_bool_t reset);
+#endif /* RT_SDIO_ASYNC_QUEUE */
 rt_int32_t init_sdio(struct rt_mmcsd_host *host, rt_uint32_t ocr);
 rt_int32_t sdio_attach_irq(struct rt_sdio_function *func,
                            rt_sdio_irq_handler_t   *handler);
@@ -181,4 +181,24 @@ rt_err_t rt_hw_serial_register(struct rt_serial_device *serial,
                                const char              *name,
                                rt_uint32_t              flag,
                                void                    *data);
+
+/**
+ * Get received data in place, without copy.
+ *
+ * @param dev serial device opened in interrupt or DMA receive mode
+ * @param data return start of data in receive fifo
+ * @param total return all received length, could be larger than return value when data wraps
+ *              fifo end, could be RT_NULL
+ *
+ * @return contiguous length at data. Data is valid until it's consumed or overwritten by new data
+ *         when fifo is full.
+ */
+rt_size_t rt_serial_rx_peek(rt_device_t dev, rt_uint8_t **data, rt_size_t *total);
+
+/**
+ * Release data got by rt_serial_rx_peek().
+ *
+ * @return length consumed
+ */
+rt_size_t rt_serial_rx_consume(rt_device_t dev, rt_size_t len);
 #endif
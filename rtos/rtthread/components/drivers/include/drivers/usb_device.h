@@ -142,6 +142,7 @@ struct udcd
     uep0_stage_t stage;
     struct ep_id *ep_pool;
     rt_uint8_t device_is_hs;
+    rt_uint8_t multi_packet;    /* dcd splits endpoint transfer into packets, reports once done */
 };
 typedef struct udcd *udcd_t;
 
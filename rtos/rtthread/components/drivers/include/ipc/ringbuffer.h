@@ -5,6 +5,7 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-14     SiFli        add span peek/commit and mirror tail
  */
 #ifndef RINGBUFFER_H__
 #define RINGBUFFER_H__
@@ -49,6 +50,11 @@ struct rt_ringbuffer
     /* as we use msb of index as mirror bit, the size should be signed and
      * could only be positive. */
     rt_int16_t buffer_size;
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    /* pool is followed by mirror_size bytes duplicating the pool head,
+     * so that a span across the end of the pool is still contiguous. */
+    rt_uint16_t mirror_size;
+#endif
 };
 
 enum rt_ringbuffer_state
@@ -81,6 +87,25 @@ rt_size_t rt_ringbuffer_get_and_update_len(struct rt_ringbuffer *rb,
 rt_size_t rt_ringbuffer_getchar(struct rt_ringbuffer *rb, rt_uint8_t *ch);
 rt_size_t rt_ringbuffer_data_len(struct rt_ringbuffer *rb);
 
+/**
+ * Zero copy access, data is read or written in place, e.g. by DMA, then committed.
+ * Span functions return contiguous length from current index, which is shorter than
+ * data/space length if it wraps around the end of pool.
+ */
+rt_size_t rt_ringbuffer_get_read_span(struct rt_ringbuffer *rb, rt_uint8_t **ptr);
+rt_size_t rt_ringbuffer_get_read_spans(struct rt_ringbuffer *rb, rt_uint8_t *ptr[2], rt_size_t len[2]);
+rt_size_t rt_ringbuffer_read_commit(struct rt_ringbuffer *rb, rt_uint16_t length);
+rt_size_t rt_ringbuffer_get_write_span(struct rt_ringbuffer *rb, rt_uint8_t **ptr);
+rt_size_t rt_ringbuffer_write_commit(struct rt_ringbuffer *rb, rt_uint16_t length);
+
+#ifdef RT_USING_RINGBUFFER_MIRROR
+/**
+ * pool should have size + mirror_size bytes, spans are extended into the mirror tail
+ * by up to mirror_size bytes, e.g. mirror_size of one DMA block makes every block contiguous.
+ */
+void rt_ringbuffer_mirror_init(struct rt_ringbuffer *rb, rt_uint8_t *pool, rt_int16_t size, rt_uint16_t mirror_size);
+#endif
+
 #ifdef RT_USING_HEAP
 struct rt_ringbuffer *rt_ringbuffer_create(rt_uint16_t length);
 void rt_ringbuffer_destroy(struct rt_ringbuffer *rb);
@@ -26,6 +26,17 @@ enum
     RT_WORK_TYPE_DELAYED     = 0x0001,
 };
 
+/**
+ * priority class of work in workpool, smaller value is taken first
+ */
+enum
+{
+    RT_WORK_PRIO_HIGH,
+    RT_WORK_PRIO_NORMAL,
+    RT_WORK_PRIO_LOW,
+    RT_WORK_PRIO_NUM
+};
+
 /* workqueue implementation */
 struct rt_workqueue
 {
@@ -44,6 +55,15 @@ struct rt_work
     void *work_data;
     rt_uint16_t flags;
     rt_uint16_t type;
+#ifdef RT_USING_WORKPOOL
+    struct rt_workpool *pool;   /* pool the work is submitted to */
+    rt_uint8_t prio;            /* priority class in pool */
+    rt_uint32_t submit_time;    /* rt_workpool_clock when work is queued */
+    rt_uint32_t run_cnt;
+    rt_uint32_t wait_max;       /* maximum latency from queued to run */
+    rt_uint32_t run_max;        /* maximum execution time */
+    rt_uint32_t run_total;
+#endif
 };
 
 struct rt_delayed_work
@@ -53,6 +73,41 @@ struct rt_delayed_work
     struct rt_workqueue *workqueue;
 };
 
+#ifdef RT_USING_WORKPOOL
+#ifndef RT_WORKPOOL_THREADS
+    #define RT_WORKPOOL_THREADS         (3)
+#endif
+#ifndef RT_WORKPOOL_STACKSIZE
+    #define RT_WORKPOOL_STACKSIZE       (2048)
+#endif
+/* thread priority of normal class in system pool, high and low class run one level above and below */
+#ifndef RT_WORKPOOL_PRIORITY
+    #define RT_WORKPOOL_PRIORITY        (RT_THREAD_PRIORITY_MAX / 2)
+#endif
+
+struct rt_workpool_stat
+{
+    rt_uint32_t count;
+    rt_uint32_t wait_max;
+    rt_uint32_t wait_total;
+    rt_uint32_t run_max;
+    rt_uint32_t run_total;
+};
+
+/* workpool implementation, works are shared by all threads of the pool */
+struct rt_workpool
+{
+    const char *name;
+    rt_list_t work_list[RT_WORK_PRIO_NUM];
+    struct rt_semaphore sem;
+    rt_uint8_t thread_prio[RT_WORK_PRIO_NUM];
+    rt_uint8_t thread_num;
+    rt_thread_t *threads;
+    struct rt_workpool_stat stat[RT_WORK_PRIO_NUM];
+    struct rt_workpool *next;
+};
+#endif /* RT_USING_WORKPOOL */
+
 #ifdef RT_USING_HEAP
 /**
  * WorkQueue for DeviceDriver
@@ -78,6 +133,14 @@ rt_inline void rt_work_init(struct rt_work *work, void (*work_func)(struct rt_wo
     work->work_data = work_data;
     work->flags = 0;
     work->type = 0;
+#ifdef RT_USING_WORKPOOL
+    work->pool = RT_NULL;
+    work->prio = RT_WORK_PRIO_NORMAL;
+    work->run_cnt = 0;
+    work->wait_max = 0;
+    work->run_max = 0;
+    work->run_total = 0;
+#endif
 }
 
 void rt_delayed_work_init(struct rt_delayed_work *work, void (*work_func)(struct rt_work *work,
@@ -88,6 +151,21 @@ void rt_delayed_work_init(struct rt_delayed_work *work, void (*work_func)(struct
 struct rt_workqueue *rt_workqueue_init(struct rt_workqueue *queue);
 struct rt_workqueue *rt_workqueue_start(struct rt_workqueue *queue, const char *name, void *stack_start, rt_uint16_t stack_size, rt_uint8_t priority);
 
+#ifdef RT_USING_WORKPOOL
+/**
+ * WorkPool, multiple threads serve works of priority classes, a slow work
+ * doesn't block others as long as a thread is free
+ */
+struct rt_workpool *rt_workpool_create(const char *name, rt_uint8_t thread_num, rt_uint16_t stack_size,
+                                       const rt_uint8_t thread_prio[RT_WORK_PRIO_NUM]);
+rt_err_t rt_workpool_submit(struct rt_workpool *pool, struct rt_work *work, rt_uint8_t prio, rt_tick_t time);
+rt_err_t rt_workpool_cancel(struct rt_work *work);
+rt_err_t rt_workpool_cancel_sync(struct rt_work *work);
+struct rt_workpool *rt_workpool_sys(void);
+rt_err_t rt_work_pool_submit(struct rt_work *work, rt_uint8_t prio, rt_tick_t time);
+rt_uint32_t rt_workpool_clock(void);
+rt_uint32_t rt_workpool_clock_freq(void);
+#endif /* RT_USING_WORKPOOL */
 
 #endif
 
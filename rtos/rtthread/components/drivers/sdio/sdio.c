@@ -26,6 +26,15 @@
 #ifndef RT_SDIO_THREAD_PRIORITY
     #define RT_SDIO_THREAD_PRIORITY  0x40
 #endif
+#ifndef RT_SDIO_ASYNC_STACK_SIZE
+    #define RT_SDIO_ASYNC_STACK_SIZE 1024
+#endif
+#ifndef RT_SDIO_ASYNC_PRIORITY
+    #define RT_SDIO_ASYNC_PRIORITY   RT_SDIO_THREAD_PRIORITY
+#endif
+#ifndef RT_SDIO_AGGR_SIZE
+    #define RT_SDIO_AGGR_SIZE        4096
+#endif
 
 static rt_list_t sdio_cards = RT_LIST_OBJECT_INIT(sdio_cards);
 static rt_list_t sdio_drivers = RT_LIST_OBJECT_INIT(sdio_drivers);
@@ -411,6 +420,225 @@ rt_int32_t sdio_io_write_multi_incr_b(struct rt_sdio_function *func,
     return sdio_io_rw_extended_block(func, 1, addr, 1, buf, len);
 }
 
+#ifdef RT_SDIO_ASYNC_QUEUE
+/*
+ * Requests queued by sdio_io_rw_extended_async() are run one by one in sdio_async
+ * thread, caller prepares next frame while current one is on the bus. Writes flagged
+ * SDIO_ASYNC_FLAG_AGGR to the same fifo address, each padded to cur_blk_size, are
+ * copied back to back into sdio_aggr_buf and sent with one multi block CMD53.
+ */
+static rt_list_t sdio_async_list = RT_LIST_OBJECT_INIT(sdio_async_list);
+static struct rt_semaphore sdio_async_sem;
+static rt_thread_t sdio_async_thread;
+static rt_uint8_t *sdio_aggr_buf;
+static rt_uint32_t sdio_async_pending;
+static struct rt_sdio_async_stat sdio_async_stat;
+
+rt_inline rt_bool_t sdio_async_can_aggr(struct rt_sdio_async_req *req)
+{
+    return (sdio_aggr_buf != RT_NULL) && (req->flags & SDIO_ASYNC_FLAG_AGGR) && req->rw
+           && (req->op_code == 0) && req->func->cur_blk_size
+           && (req->len % req->func->cur_blk_size == 0);
+}
+
+static struct rt_sdio_async_req *sdio_async_pop(struct rt_sdio_async_req *first,
+                                                rt_uint32_t               total)
+{
+    struct rt_sdio_async_req *req = RT_NULL;
+    rt_uint32_t limit;
+
+    rt_enter_critical();
+    if (!rt_list_isempty(&sdio_async_list))
+    {
+        req = rt_list_entry(sdio_async_list.next, struct rt_sdio_async_req, list);
+        if (first)
+        {
+            limit = MIN(RT_SDIO_AGGR_SIZE, first->func->card->host->max_seg_size);
+            if (!sdio_async_can_aggr(req) || (req->func != first->func)
+                    || (req->addr != first->addr) || (total + req->len > limit))
+                req = RT_NULL;
+        }
+        if (req)
+        {
+            rt_list_remove(&req->list);
+            sdio_async_pending--;
+        }
+    }
+    rt_exit_critical();
+
+    return req;
+}
+
+static void sdio_async_entry(void *param)
+{
+    struct rt_sdio_async_req *first, *req;
+    struct rt_mmcsd_host *host;
+    rt_list_t batch;
+    rt_uint32_t total, count;
+    rt_int32_t ret;
+
+    while (1)
+    {
+        rt_sem_take(&sdio_async_sem, RT_WAITING_FOREVER);
+
+        /* semaphore may count requests already taken with a batch */
+        while ((first = sdio_async_pop(RT_NULL, 0)) != RT_NULL)
+        {
+            rt_list_init(&batch);
+            rt_list_insert_before(&batch, &first->list);
+            total = first->len;
+            count = 1;
+
+            if (sdio_async_can_aggr(first))
+            {
+                while ((req = sdio_async_pop(first, total)) != RT_NULL)
+                {
+                    rt_list_insert_before(&batch, &req->list);
+                    total += req->len;
+                    count++;
+                }
+            }
+
+            host = first->func->card->host;
+            mmcsd_host_lock(host);
+            if (count > 1)
+            {
+                rt_uint8_t *dst = sdio_aggr_buf;
+                rt_list_t *pos;
+
+                rt_list_for_each(pos, &batch)
+                {
+                    req = rt_list_entry(pos, struct rt_sdio_async_req, list);
+                    rt_memcpy(dst, req->buf, req->len);
+                    dst += req->len;
+                }
+                ret = sdio_io_rw_extended_block(first->func, 1, first->addr, 0,
+                                                sdio_aggr_buf, total);
+            }
+            else
+            {
+                ret = sdio_io_rw_extended_block(first->func, first->rw, first->addr,
+                                                first->op_code, first->buf, first->len);
+            }
+            mmcsd_host_unlock(host);
+
+            sdio_async_stat.transfers++;
+            sdio_async_stat.merged += count - 1;
+            if (count > sdio_async_stat.max_batch)
+                sdio_async_stat.max_batch = count;
+            if (ret)
+                sdio_async_stat.errors++;
+
+            while (!rt_list_isempty(&batch))
+            {
+                req = rt_list_entry(batch.next, struct rt_sdio_async_req, list);
+                rt_list_remove(&req->list);
+                req->err = ret;
+                if (req->done)
+                    req->done(req);
+            }
+        }
+    }
+}
+
+static void sdio_async_init(void)
+{
+    rt_sem_init(&sdio_async_sem, "sdio_q", 0, RT_IPC_FLAG_FIFO);
+
+    /* cache line aligned so host could DMA from it without bounce */
+    sdio_aggr_buf = rt_malloc_align(RT_SDIO_AGGR_SIZE, 32);
+    if (sdio_aggr_buf == RT_NULL)
+        LOG_W("no aggregation buffer, requests are sent one by one");
+
+    sdio_async_thread = rt_thread_create("sdio_q", sdio_async_entry, RT_NULL,
+                                         RT_SDIO_ASYNC_STACK_SIZE, RT_SDIO_ASYNC_PRIORITY, 20);
+    RT_ASSERT(sdio_async_thread != RT_NULL);
+    rt_thread_startup(sdio_async_thread);
+}
+
+rt_int32_t sdio_io_rw_extended_async(struct rt_sdio_async_req *req)
+{
+    RT_ASSERT(req != RT_NULL);
+    RT_ASSERT(req->func != RT_NULL);
+    RT_ASSERT(req->buf != RT_NULL);
+
+    if (req->len == 0)
+        return -RT_EINVAL;
+    if (sdio_async_thread == RT_NULL)
+        return -RT_ENOSYS;
+
+    req->err = -RT_EBUSY;
+    rt_enter_critical();
+    rt_list_insert_before(&sdio_async_list, &req->list);
+    sdio_async_pending++;
+    sdio_async_stat.submitted++;
+    if (sdio_async_pending > sdio_async_stat.max_pending)
+        sdio_async_stat.max_pending = sdio_async_pending;
+    rt_exit_critical();
+
+    rt_sem_release(&sdio_async_sem);
+
+    return 0;
+}
+
+void sdio_async_cancel(struct rt_sdio_function *func)
+{
+    struct rt_sdio_async_req *req;
+    rt_list_t *pos, *n;
+    rt_list_t cancelled;
+
+    rt_list_init(&cancelled);
+
+    rt_enter_critical();
+    rt_list_for_each_safe(pos, n, &sdio_async_list)
+    {
+        req = rt_list_entry(pos, struct rt_sdio_async_req, list);
+        if (req->func == func)
+        {
+            rt_list_remove(&req->list);
+            rt_list_insert_before(&cancelled, &req->list);
+            sdio_async_pending--;
+        }
+    }
+    rt_exit_critical();
+
+    while (!rt_list_isempty(&cancelled))
+    {
+        req = rt_list_entry(cancelled.next, struct rt_sdio_async_req, list);
+        rt_list_remove(&req->list);
+        req->err = -RT_EIO;
+        if (req->done)
+            req->done(req);
+    }
+}
+
+void sdio_async_get_stat(struct rt_sdio_async_stat *stat, rt_bool_t reset)
+{
+    rt_enter_critical();
+    *stat = sdio_async_stat;
+    if (reset)
+        rt_memset(&sdio_async_stat, 0, sizeof(sdio_async_stat));
+    rt_exit_critical();
+}
+
+#ifdef RT_USING_FINSH
+static int sdio_async(int argc, char **argv)
+{
+    struct rt_sdio_async_stat stat;
+
+    sdio_async_get_stat(&stat, (argc > 1) && (0 == rt_strcmp(argv[1], "reset")));
+    rt_kprintf("submitted %d, transfers %d, merged %d, errors %d\n",
+               stat.submitted, stat.transfers, stat.merged, stat.errors);
+    rt_kprintf("pending %d, max pending %d, max batch %d, aggregation %d bytes\n",
+               sdio_async_pending, stat.max_pending, stat.max_batch,
+               sdio_aggr_buf ? RT_SDIO_AGGR_SIZE : 0);
+
+    return 0;
+}
+MSH_CMD_EXPORT(sdio_async, sdio_async [reset]: show queued SDIO transfers);
+#endif /* RT_USING_FINSH */
+#endif /* RT_SDIO_ASYNC_QUEUE */
+
 static rt_int32_t sdio_read_cccr(struct rt_mmcsd_card *card)
 {
     rt_int32_t ret;
@@ -817,6 +1045,19 @@ rt_int32_t sdio_unregister_card(struct rt_mmcsd_card *card)
     struct sdio_card *sc;
     rt_list_t *l;
 
+#ifdef RT_SDIO_ASYNC_QUEUE
+    {
+        rt_int32_t i;
+
+        /* requests left in queue must not reach functions being removed */
+        for (i = 0; i <= card->sdio_function_num; i++)
+        {
+            if (card->sdio_function[i])
+                sdio_async_cancel(card->sdio_function[i]);
+        }
+    }
+#endif
+
     for (l = (&sdio_cards)->next; l != &sdio_cards; l = l->next)
     {
         sc = (struct sdio_card *)rt_list_entry(l, struct sdio_card, list);
@@ -1422,6 +1663,8 @@ rt_int32_t sdio_unregister_driver(struct rt_sdio_driver *driver)
 
 void rt_sdio_init(void)
 {
-
+#ifdef RT_SDIO_ASYNC_QUEUE
+    sdio_async_init();
+#endif
 }
 
@@ -46,6 +46,8 @@ static void rt_sensor_cb(rt_sensor_t sen)
         return;
     }
 
+    sen->irq_ts = rt_sensor_get_ts();
+
     if (sen->irq_handle != RT_NULL)
     {
         sen->irq_handle(sen);
@@ -63,10 +65,45 @@ static void rt_sensor_cb(rt_sensor_t sen)
     }
     else if (sen->config.mode == RT_SENSOR_MODE_FIFO)
     {
-        sen->parent.rx_indicate(&sen->parent, sen->info.fifo_max);
+        /* Watermark is reached, reader fetches whole fifo in one batch */
+        sen->parent.rx_indicate(&sen->parent, sen->fifo_wm ? sen->fifo_wm : sen->info.fifo_max);
     }
 }
 
+void rt_sensor_fifo_timestamp(rt_sensor_t sensor, struct rt_sensor_data *data, rt_size_t num)
+{
+    rt_uint32_t ref;
+    rt_int32_t  ref_idx, i;
+    rt_uint16_t wm = sensor->fifo_wm ? sensor->fifo_wm : sensor->info.fifo_max;
+
+    if (num == 0)
+    {
+        return;
+    }
+
+    if (sensor->config.odr == 0 || sensor->irq_ts == 0 || wm == 0)
+    {
+        /* No rate or interrupt time, stamp all with read time */
+        ref = rt_sensor_get_ts();
+        for (i = 0; i < (rt_int32_t)num; i++)
+        {
+            data[i].timestamp = ref;
+        }
+        return;
+    }
+
+    /* Sample at watermark raised the interrupt, newer ones arrived before read */
+    ref = sensor->irq_ts;
+    ref_idx = (wm <= num) ? wm - 1 : num - 1;
+    for (i = 0; i < (rt_int32_t)num; i++)
+    {
+        data[i].timestamp = ref + (i - ref_idx) * RT_SENSOR_TS_PER_SECOND / (rt_int32_t)sensor->config.odr;
+    }
+
+    /* Consumed, next batch without interrupt is stamped by read time */
+    sensor->irq_ts = 0;
+}
+
 /* ISR for sensor interrupt */
 static void irq_callback(void *args)
 {
@@ -372,6 +409,21 @@ static rt_err_t rt_sensor_control(rt_device_t dev, int cmd, void *args)
         /* Device self-test */
         result = sensor->ops->control(sensor, RT_SENSOR_CTRL_SELF_TEST, args);
         break;
+    case RT_SENSOR_CTRL_SET_FIFO_WM:
+
+        /* Configuration fifo watermark */
+        if ((rt_uint32_t)args == 0 || (rt_uint32_t)args > sensor->info.fifo_max)
+        {
+            result = -RT_EINVAL;
+            break;
+        }
+        result = sensor->ops->control(sensor, RT_SENSOR_CTRL_SET_FIFO_WM, args);
+        if (result == RT_EOK)
+        {
+            sensor->fifo_wm = (rt_uint32_t)args & 0xFFFF;
+            LOG_D("set fifo watermark %d", sensor->fifo_wm);
+        }
+        break;
     default:
         result = -RT_ERROR;
     }
@@ -20,8 +20,10 @@ extern "C" {
 
 #if defined(RT_USING_RTC)&&!defined(WIN32)
 #define  rt_sensor_get_ts()  time(RT_NULL)   /* API for the sensor to get the timestamp */
+#define  RT_SENSOR_TS_PER_SECOND       (1)
 #else
 #define  rt_sensor_get_ts()  rt_tick_get()   /* API for the sensor to get the timestamp */
+#define  RT_SENSOR_TS_PER_SECOND       RT_TICK_PER_SECOND
 #endif
 
 #define  RT_PIN_NONE                   0xFFFF    /* RT PIN NONE */
@@ -98,7 +100,7 @@ extern "C" {
 #define  RT_SENSOR_MODE_NONE           (0)
 #define  RT_SENSOR_MODE_POLLING        (1)  /* One shot only read a data */
 #define  RT_SENSOR_MODE_INT            (2)  /* TODO: One shot interrupt only read a data */
-#define  RT_SENSOR_MODE_FIFO           (3)  /* TODO: One shot interrupt read all fifo data */
+#define  RT_SENSOR_MODE_FIFO           (3)  /* Watermark interrupt, read all fifo data in one batch */
 
 /* Sensor control cmd types */
 
@@ -109,6 +111,7 @@ extern "C" {
 #define  RT_SENSOR_CTRL_SET_MODE       (0x20 + 4)  /* Set sensor's work mode. ex. RT_SENSOR_MODE_POLLING,RT_SENSOR_MODE_INT */
 #define  RT_SENSOR_CTRL_SET_POWER      (0x20 + 5)  /* Set power mode. args type of sensor power mode. ex. RT_SENSOR_POWER_DOWN,RT_SENSOR_POWER_NORMAL */
 #define  RT_SENSOR_CTRL_SELF_TEST      (0x20 + 6)  /* Take a self test */
+#define  RT_SENSOR_CTRL_SET_FIFO_WM    (0x20 + 7)  /* Set fifo watermark, number of samples to raise interrupt, no more than fifo_max */
 
 struct rt_sensor_info
 {
@@ -157,6 +160,9 @@ struct rt_sensor_device
     struct rt_sensor_module     *module;    /* The sensor module */
 
     rt_err_t (*irq_handle)(rt_sensor_t sensor);             /* Called when an interrupt is generated, registered by the driver */
+
+    rt_uint16_t                  fifo_wm;   /* FIFO watermark in samples, 0 is fifo_max */
+    rt_uint32_t                  irq_ts;    /* Timestamp of last interrupt */
 };
 
 struct rt_sensor_module
@@ -216,6 +222,9 @@ int rt_hw_sensor_register(rt_sensor_t sensor,
                           rt_uint32_t              flag,
                           void                    *data);
 
+/* Stamp a batch read from FIFO in fetch_data, the watermark sample is taken at interrupt time and others are ODR apart */
+void rt_sensor_fifo_timestamp(rt_sensor_t sensor, struct rt_sensor_data *data, rt_size_t num);
+
 #ifdef __cplusplus
 }
 #endif
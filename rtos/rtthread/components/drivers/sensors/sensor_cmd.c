@@ -129,6 +129,11 @@ __ROM_USED void sensor_cmd_fifo(int argc, char **argv)
     rt_device_set_rx_indicate(dev, rx_callback);
 
     rt_device_control(dev, RT_SENSOR_CTRL_SET_ODR, (void *)20);
+    /* Optional watermark, interrupt once per batch */
+    if (argc > 2)
+    {
+        rt_device_control(dev, RT_SENSOR_CTRL_SET_FIFO_WM, (void *)atoi(argv[2]));
+    }
 }
 #ifdef FINSH_USING_MSH
     MSH_CMD_EXPORT(sensor_cmd_fifo, Sensor fifo mode test function);
@@ -1147,6 +1147,69 @@ const static struct rt_device_ops serial_ops =
 };
 #endif
 
+/*
+ * Zero copy access to receive fifo, in interrupt or DMA receive mode. In DMA mode the fifo is the
+ * circular DMA ring which is updated at idle line, half and full transfer.
+ */
+rt_size_t rt_serial_rx_peek(rt_device_t dev, rt_uint8_t **data, rt_size_t *total)
+{
+    struct rt_serial_device *serial = (struct rt_serial_device *)dev;
+    struct rt_serial_rx_fifo *rx_fifo;
+    rt_size_t len, contiguous;
+    rt_base_t level;
+
+    RT_ASSERT(serial != RT_NULL);
+    RT_ASSERT(data != RT_NULL);
+
+    if (total) *total = 0;
+    if (!(dev->open_flag & (RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_DMA_RX))
+            || (serial->config.bufsz == 0) || (serial->serial_rx == RT_NULL))
+        return 0;
+
+    rx_fifo = (struct rt_serial_rx_fifo *) serial->serial_rx;
+
+    level = rt_hw_interrupt_disable();
+    if (rx_fifo->put_index == rx_fifo->get_index)
+        len = (rx_fifo->is_full == RT_FALSE) ? 0 : serial->config.bufsz;
+    else if (rx_fifo->put_index > rx_fifo->get_index)
+        len = rx_fifo->put_index - rx_fifo->get_index;
+    else
+        len = serial->config.bufsz - (rx_fifo->get_index - rx_fifo->put_index);
+
+    contiguous = serial->config.bufsz - rx_fifo->get_index;
+    if (contiguous > len) contiguous = len;
+    *data = rx_fifo->buffer + rx_fifo->get_index;
+    rt_hw_interrupt_enable(level);
+
+    if (total) *total = len;
+
+    return contiguous;
+}
+
+rt_size_t rt_serial_rx_consume(rt_device_t dev, rt_size_t len)
+{
+    struct rt_serial_device *serial = (struct rt_serial_device *)dev;
+    struct rt_serial_rx_fifo *rx_fifo;
+    rt_uint8_t *data;
+    rt_size_t total;
+    rt_base_t level;
+
+    RT_ASSERT(serial != RT_NULL);
+
+    rt_serial_rx_peek(dev, &data, &total);
+    if (len > total) len = total;
+    if (len == 0) return 0;
+
+    rx_fifo = (struct rt_serial_rx_fifo *) serial->serial_rx;
+
+    level = rt_hw_interrupt_disable();
+    rx_fifo->get_index = (rx_fifo->get_index + len) % serial->config.bufsz;
+    rx_fifo->is_full = RT_FALSE;
+    rt_hw_interrupt_enable(level);
+
+    return len;
+}
+
 /*
  * serial register
  */
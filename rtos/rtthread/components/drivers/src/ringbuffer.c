@@ -8,6 +8,7 @@
  * 2012-09-30     Bernard      first version.
  * 2013-05-08     Grissiom     reimplement
  * 2016-08-18     heyuanjie    add interface
+ * 2026-10-14     SiFli        add span peek/commit and mirror tail
  */
 #include <rthw.h>
 #include <rtthread.h>
@@ -50,6 +51,9 @@ __ROM_USED void rt_ringbuffer_init(struct rt_ringbuffer *rb,
     rb->wr_buffer_ptr = pool;
     rb->rd_buffer_ptr = pool;
     rb->buffer_size = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    rb->mirror_size = 0;
+#endif
 }
 RTM_EXPORT(rt_ringbuffer_init);
 
@@ -68,6 +72,9 @@ __ROM_USED void rt_ringbuffer_wr_init(struct rt_ringbuffer *rb,
     /* set buffer pool for write and size */
     rb->wr_buffer_ptr = pool;
     rb->buffer_size = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    rb->mirror_size = 0;
+#endif
 
 }
 RTM_EXPORT(rt_ringbuffer_wr_init);
@@ -428,6 +435,180 @@ __ROM_USED rt_size_t rt_ringbuffer_data_len(struct rt_ringbuffer *rb)
 }
 RTM_EXPORT(rt_ringbuffer_data_len);
 
+/* move read or write index forward, length shall not exceed buffer_size */
+rt_inline void rt_ringbuffer_advance(struct rt_ringbuffer *rb, rt_uint16_t *mirror_ptr, rt_uint16_t length)
+{
+    // Use atomic operation to avoid index and mirror not sync
+    rt_uint32_t *idx_mirror = (rt_uint32_t *)mirror_ptr;
+    rt_uint16_t mirror = (rt_uint16_t)(*idx_mirror & 0xFFFF);
+    rt_uint16_t index = (rt_uint16_t)(*idx_mirror >> 16);
+
+    if (rb->buffer_size - index > length)
+    {
+        index += length;
+    }
+    else
+    {
+        index = length - (rb->buffer_size - index);
+        mirror = ~mirror;
+    }
+    *idx_mirror = ((rt_uint32_t)index << 16) | mirror;
+}
+
+/**
+ * get contiguous data in rb without copy, call rt_ringbuffer_read_commit after it's consumed
+ */
+rt_size_t rt_ringbuffer_get_read_span(struct rt_ringbuffer *rb, rt_uint8_t **ptr)
+{
+    rt_size_t size;
+    rt_size_t span;
+
+    RT_ASSERT(rb != RT_NULL);
+    RT_ASSERT(ptr != RT_NULL);
+
+    size = rt_ringbuffer_data_len(rb);
+    span = rb->buffer_size - rb->read_index;
+    *ptr = &rb->rd_buffer_ptr[rb->read_index];
+    if (size <= span)
+        return size;
+
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    if (rb->mirror_size)
+    {
+        rt_size_t extend = size - span;
+
+        /* refresh mirror tail with wrapped data */
+        if (extend > rb->mirror_size)
+            extend = rb->mirror_size;
+        memcpy(&rb->rd_buffer_ptr[rb->buffer_size], &rb->rd_buffer_ptr[0], extend);
+        span += extend;
+    }
+#endif
+
+    return span;
+}
+RTM_EXPORT(rt_ringbuffer_get_read_span);
+
+/**
+ * get data in rb as up to 2 spans without copy, e.g. for scatter-gather DMA
+ */
+rt_size_t rt_ringbuffer_get_read_spans(struct rt_ringbuffer *rb, rt_uint8_t *ptr[2], rt_size_t len[2])
+{
+    rt_size_t size;
+    rt_size_t span;
+
+    RT_ASSERT(rb != RT_NULL);
+
+    size = rt_ringbuffer_data_len(rb);
+    span = rb->buffer_size - rb->read_index;
+    ptr[0] = &rb->rd_buffer_ptr[rb->read_index];
+    ptr[1] = &rb->rd_buffer_ptr[0];
+    if (size <= span)
+    {
+        len[0] = size;
+        len[1] = 0;
+    }
+    else
+    {
+        len[0] = span;
+        len[1] = size - span;
+    }
+
+    return size;
+}
+RTM_EXPORT(rt_ringbuffer_get_read_spans);
+
+/**
+ * release data got by span functions
+ */
+rt_size_t rt_ringbuffer_read_commit(struct rt_ringbuffer *rb, rt_uint16_t length)
+{
+    rt_size_t size;
+
+    RT_ASSERT(rb != RT_NULL);
+
+    size = rt_ringbuffer_data_len(rb);
+    if (size < length)
+        length = size;
+    if (length)
+        rt_ringbuffer_advance(rb, &rb->read_mirror, length);
+
+    return length;
+}
+RTM_EXPORT(rt_ringbuffer_read_commit);
+
+/**
+ * get contiguous space in rb to write in place, call rt_ringbuffer_write_commit after it's filled
+ */
+rt_size_t rt_ringbuffer_get_write_span(struct rt_ringbuffer *rb, rt_uint8_t **ptr)
+{
+    rt_size_t size;
+    rt_size_t span;
+
+    RT_ASSERT(rb != RT_NULL);
+    RT_ASSERT(ptr != RT_NULL);
+
+    size = rt_ringbuffer_space_len(rb);
+    span = rb->buffer_size - rb->write_index;
+    *ptr = &rb->wr_buffer_ptr[rb->write_index];
+    if (size <= span)
+        return size;
+
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    /* data written into mirror tail is moved to pool head on commit */
+    if (size - span > rb->mirror_size)
+        span += rb->mirror_size;
+    else
+        span = size;
+#endif
+
+    return span;
+}
+RTM_EXPORT(rt_ringbuffer_get_write_span);
+
+/**
+ * publish data filled in space got by rt_ringbuffer_get_write_span
+ */
+rt_size_t rt_ringbuffer_write_commit(struct rt_ringbuffer *rb, rt_uint16_t length)
+{
+    rt_size_t size;
+
+    RT_ASSERT(rb != RT_NULL);
+
+    size = rt_ringbuffer_space_len(rb);
+    if (size < length)
+        length = size;
+    if (!length)
+        return 0;
+
+#ifdef RT_USING_RINGBUFFER_MIRROR
+    if (rb->buffer_size - rb->write_index < length)
+    {
+        rt_uint16_t extend = length - (rb->buffer_size - rb->write_index);
+
+        RT_ASSERT(extend <= rb->mirror_size);
+        memcpy(&rb->wr_buffer_ptr[0], &rb->wr_buffer_ptr[rb->buffer_size], extend);
+    }
+#endif
+    rt_ringbuffer_advance(rb, &rb->write_mirror, length);
+
+    return length;
+}
+RTM_EXPORT(rt_ringbuffer_write_commit);
+
+#ifdef RT_USING_RINGBUFFER_MIRROR
+void rt_ringbuffer_mirror_init(struct rt_ringbuffer *rb,
+                               rt_uint8_t           *pool,
+                               rt_int16_t            size,
+                               rt_uint16_t           mirror_size)
+{
+    rt_ringbuffer_init(rb, pool, size);
+    RT_ASSERT(mirror_size <= rb->buffer_size);
+    rb->mirror_size = mirror_size;
+}
+RTM_EXPORT(rt_ringbuffer_mirror_init);
+#endif
+
 /**
  * empty the rb
  */
@@ -6,11 +6,15 @@
  * Change Logs:
  * Date           Author       Notes
  * 2017-02-27     bernard      fix the re-work issue.
+ * 2026-10-14     SiFli        add multi-thread work pool with priority classes.
  */
 
 #include <rthw.h>
 #include <rtthread.h>
 #include <rtdevice.h>
+#ifdef RT_USING_FINSH
+    #include <finsh.h>
+#endif
 
 #ifdef RT_USING_HEAP
 
@@ -459,4 +463,348 @@ static int rt_work_sys_workqueue_init(void)
 
 INIT_DEVICE_EXPORT(rt_work_sys_workqueue_init);
 #endif
+
+#ifdef RT_USING_WORKPOOL
+static struct rt_workpool *workpool_list;
+
+RT_WEAK rt_uint32_t rt_workpool_clock(void)
+{
+    return rt_tick_get();
+}
+
+RT_WEAK rt_uint32_t rt_workpool_clock_freq(void)
+{
+    return RT_TICK_PER_SECOND;
+}
+
+static void _workpool_thread_entry(void *parameter)
+{
+    struct rt_workpool *pool = (struct rt_workpool *)parameter;
+    struct rt_workpool_stat *stat;
+    struct rt_work *work;
+    rt_thread_t self = rt_thread_self();
+    rt_uint8_t cur_prio = self->init_priority;
+    rt_uint8_t prio;
+    rt_uint32_t start, wait, cost;
+    rt_base_t level;
+    rt_list_t *node;
+    int i;
+
+    while (1)
+    {
+        rt_sem_take(&pool->sem, RT_WAITING_FOREVER);
+
+        work = RT_NULL;
+        level = rt_hw_interrupt_disable();
+        for (i = 0; i < RT_WORK_PRIO_NUM && !work; i++)
+        {
+            rt_list_for_each(node, &pool->work_list[i])
+            {
+                /* Resubmitted by itself, it's taken again after current run is done */
+                if (!(rt_list_entry(node, struct rt_work, list)->flags & RT_WORK_STATE_RUNNING))
+                {
+                    work = rt_list_entry(node, struct rt_work, list);
+                    break;
+                }
+            }
+        }
+        if (!work)
+        {
+            /* Cancelled after semaphore was released */
+            rt_hw_interrupt_enable(level);
+            continue;
+        }
+        rt_list_remove(&work->list);
+        work->flags &= ~RT_WORK_STATE_PENDING;
+        work->flags |= RT_WORK_STATE_RUNNING;
+        prio = work->prio;
+        start = rt_workpool_clock();
+        wait = start - work->submit_time;
+        rt_hw_interrupt_enable(level);
+
+        /* Thread runs at priority of the class it's serving */
+        if (pool->thread_prio[prio] != cur_prio)
+        {
+            cur_prio = pool->thread_prio[prio];
+            rt_thread_control(self, RT_THREAD_CTRL_CHANGE_PRIORITY, &cur_prio);
+        }
+
+        work->work_func(work, work->work_data);
+        cost = rt_workpool_clock() - start;
+
+        level = rt_hw_interrupt_disable();
+        work->flags &= ~RT_WORK_STATE_RUNNING;
+        work->run_cnt++;
+        work->run_total += cost;
+        if (wait > work->wait_max)
+            work->wait_max = wait;
+        if (cost > work->run_max)
+            work->run_max = cost;
+        stat = &pool->stat[prio];
+        stat->count++;
+        stat->wait_total += wait;
+        stat->run_total += cost;
+        if (wait > stat->wait_max)
+            stat->wait_max = wait;
+        if (cost > stat->run_max)
+            stat->run_max = cost;
+        /* Resubmitted while running, its semaphore might be taken by another thread already */
+        i = work->flags & RT_WORK_STATE_PENDING;
+        rt_hw_interrupt_enable(level);
+        if (i)
+            rt_sem_release(&pool->sem);
+    }
+}
+
+static rt_err_t _workpool_queue(struct rt_workpool *pool, struct rt_work *work)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (work->flags & RT_WORK_STATE_PENDING)
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+    rt_list_insert_before(&pool->work_list[work->prio], &work->list);
+    work->flags |= RT_WORK_STATE_PENDING;
+    work->submit_time = rt_workpool_clock();
+    rt_hw_interrupt_enable(level);
+
+    rt_sem_release(&pool->sem);
+
+    return RT_EOK;
+}
+
+static void _workpool_timeout_handler(void *parameter)
+{
+    struct rt_delayed_work *delayed_work;
+    rt_base_t level;
+
+    delayed_work = (struct rt_delayed_work *)parameter;
+    level = rt_hw_interrupt_disable();
+    rt_timer_detach(&(delayed_work->timer));
+    delayed_work->work.flags &= ~RT_WORK_STATE_SUBMITTING;
+    rt_hw_interrupt_enable(level);
+    _workpool_queue(delayed_work->work.pool, &(delayed_work->work));
+}
+
+/**
+ * @brief Create work pool.
+ * @param name name of pool, threads are named with index appended.
+ * @param thread_num number of threads serving the pool.
+ * @param stack_size stack size of each thread.
+ * @param thread_prio thread priority of each class, RT_WORK_PRIO_HIGH first, NULL to use
+ *        RT_WORKPOOL_PRIORITY based default.
+ * @return created pool, NULL if out of memory.
+ */
+struct rt_workpool *rt_workpool_create(const char *name, rt_uint8_t thread_num, rt_uint16_t stack_size,
+                                       const rt_uint8_t thread_prio[RT_WORK_PRIO_NUM])
+{
+    struct rt_workpool *pool;
+    char tname[RT_NAME_MAX];
+    rt_base_t level;
+    int i;
+
+    RT_ASSERT(thread_num > 0);
+
+    pool = rt_calloc(1, sizeof(struct rt_workpool) + thread_num * sizeof(rt_thread_t));
+    if (!pool)
+        return RT_NULL;
+
+    pool->name = name;
+    pool->thread_num = thread_num;
+    pool->threads = (rt_thread_t *)(pool + 1);
+    for (i = 0; i < RT_WORK_PRIO_NUM; i++)
+    {
+        rt_list_init(&pool->work_list[i]);
+        if (thread_prio)
+            pool->thread_prio[i] = thread_prio[i];
+        else
+            pool->thread_prio[i] = RT_WORKPOOL_PRIORITY + i - RT_WORK_PRIO_NORMAL;
+        RT_ASSERT(pool->thread_prio[i] < RT_THREAD_PRIORITY_MAX);
+    }
+    rt_sem_init(&pool->sem, name, 0, RT_IPC_FLAG_FIFO);
+
+    for (i = 0; i < thread_num; i++)
+    {
+        rt_snprintf(tname, sizeof(tname), "%s%d", name, i);
+        pool->threads[i] = rt_thread_create(tname, _workpool_thread_entry, pool, stack_size,
+                                            pool->thread_prio[RT_WORK_PRIO_NORMAL], 10);
+        RT_ASSERT(pool->threads[i]);
+        rt_thread_startup(pool->threads[i]);
+    }
+
+    level = rt_hw_interrupt_disable();
+    pool->next = workpool_list;
+    workpool_list = pool;
+    rt_hw_interrupt_enable(level);
+
+    return pool;
+}
+
+/**
+ * @brief Submit work to pool.
+ * @param pool work pool.
+ * @param work work to submit, it must be rt_delayed_work if time is not 0.
+ * @param prio priority class, RT_WORK_PRIO_HIGH/NORMAL/LOW.
+ * @param time delay in ticks, timer of delayed work is a hard timer.
+ * @return RT_EOK if success, -RT_EBUSY if already pending, -RT_EINVAL if work is active in another pool.
+ */
+rt_err_t rt_workpool_submit(struct rt_workpool *pool, struct rt_work *work, rt_uint8_t prio, rt_tick_t time)
+{
+    struct rt_delayed_work *delayed_work;
+    rt_base_t level;
+    rt_err_t ret;
+
+    RT_ASSERT(pool);
+    RT_ASSERT(work);
+    RT_ASSERT(prio < RT_WORK_PRIO_NUM);
+
+    if (work->pool && work->pool != pool && (work->flags & (RT_WORK_STATE_PENDING | RT_WORK_STATE_SUBMITTING)))
+        return -RT_EINVAL;
+
+    if (!time)
+    {
+        level = rt_hw_interrupt_disable();
+        if (work->flags & RT_WORK_STATE_SUBMITTING)
+        {
+            rt_hw_interrupt_enable(level);
+            return -RT_EBUSY;
+        }
+        work->pool = pool;
+        work->prio = prio;
+        rt_hw_interrupt_enable(level);
+        return _workpool_queue(pool, work);
+    }
+
+    if (!(work->type & RT_WORK_TYPE_DELAYED))
+        return -RT_EINVAL;
+
+    /* Restart delay if it's waiting for timeout */
+    ret = rt_workpool_cancel(work);
+    if (ret != RT_EOK && ret != -RT_EBUSY)
+        return ret;
+
+    delayed_work = (struct rt_delayed_work *)work;
+    level = rt_hw_interrupt_disable();
+    work->pool = pool;
+    work->prio = prio;
+    work->flags |= RT_WORK_STATE_SUBMITTING;
+    rt_timer_init(&(delayed_work->timer), "work", _workpool_timeout_handler, delayed_work, time,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+    rt_hw_interrupt_enable(level);
+    rt_timer_start(&(delayed_work->timer));
+
+    return RT_EOK;
+}
+
+/**
+ * @brief Cancel work in pool, pending or delayed.
+ * @param work work to cancel.
+ * @return RT_EOK if success, -RT_EBUSY if work is running.
+ */
+rt_err_t rt_workpool_cancel(struct rt_work *work)
+{
+    struct rt_delayed_work *delayed_work;
+    rt_base_t level;
+    rt_err_t ret = RT_EOK;
+
+    RT_ASSERT(work);
+
+    level = rt_hw_interrupt_disable();
+    if (work->flags & RT_WORK_STATE_PENDING)
+    {
+        rt_list_remove(&work->list);
+        work->flags &= ~RT_WORK_STATE_PENDING;
+    }
+    else if (work->flags & RT_WORK_STATE_SUBMITTING)
+    {
+        delayed_work = (struct rt_delayed_work *)work;
+        rt_timer_stop(&(delayed_work->timer));
+        rt_timer_detach(&(delayed_work->timer));
+        work->flags &= ~RT_WORK_STATE_SUBMITTING;
+    }
+    if (work->flags & RT_WORK_STATE_RUNNING)
+        ret = -RT_EBUSY;
+    rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+/**
+ * @brief Cancel work in pool and wait until it's not running.
+ * @param work work to cancel, must not be called from its own work function.
+ * @return RT_EOK.
+ */
+rt_err_t rt_workpool_cancel_sync(struct rt_work *work)
+{
+    while (rt_workpool_cancel(work) == -RT_EBUSY)
+    {
+        /* Running work could be resubmitted by itself, cancel again after it's done */
+        rt_thread_mdelay(1);
+    }
+
+    return RT_EOK;
+}
+
+static struct rt_workpool *sys_workpool;
+
+struct rt_workpool *rt_workpool_sys(void)
+{
+    return sys_workpool;
+}
+
+rt_err_t rt_work_pool_submit(struct rt_work *work, rt_uint8_t prio, rt_tick_t time)
+{
+    return rt_workpool_submit(sys_workpool, work, prio, time);
+}
+
+static int rt_work_sys_workpool_init(void)
+{
+    sys_workpool = rt_workpool_create("wpool", RT_WORKPOOL_THREADS, RT_WORKPOOL_STACKSIZE, RT_NULL);
+
+    return RT_EOK;
+}
+INIT_PREV_EXPORT(rt_work_sys_workpool_init);
+
+#ifdef RT_USING_FINSH
+static rt_uint32_t _workpool_to_us(rt_uint32_t clk)
+{
+    return (rt_uint32_t)((rt_uint64_t)clk * 1000000 / rt_workpool_clock_freq());
+}
+
+static void list_workpool(void)
+{
+    static const char *const class_name[RT_WORK_PRIO_NUM] = {"high", "normal", "low"};
+    struct rt_workpool *pool;
+    struct rt_workpool_stat *stat;
+    rt_list_t *node;
+    int i, pending;
+
+    for (pool = workpool_list; pool; pool = pool->next)
+    {
+        rt_kprintf("%s: %d threads, time in us\n", pool->name, pool->thread_num);
+        rt_kprintf("class  prio pending    count avg_wait max_wait  avg_run  max_run\n");
+        for (i = 0; i < RT_WORK_PRIO_NUM; i++)
+        {
+            stat = &pool->stat[i];
+            pending = 0;
+            rt_enter_critical();
+            rt_list_for_each(node, &pool->work_list[i])
+            {
+                pending++;
+            }
+            rt_exit_critical();
+            rt_kprintf("%-6s %4d %7d %8d %8d %8d %8d %8d\n", class_name[i], pool->thread_prio[i], pending,
+                       stat->count, stat->count ? _workpool_to_us(stat->wait_total / stat->count) : 0,
+                       _workpool_to_us(stat->wait_max),
+                       stat->count ? _workpool_to_us(stat->run_total / stat->count) : 0,
+                       _workpool_to_us(stat->run_max));
+        }
+    }
+}
+MSH_CMD_EXPORT(list_workpool, list work pool statistics);
+#endif /* RT_USING_FINSH */
+#endif /* RT_USING_WORKPOOL */
 #endif
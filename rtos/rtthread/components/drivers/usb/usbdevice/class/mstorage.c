@@ -18,6 +18,15 @@
 
 #ifdef RT_USB_DEVICE_MSTORAGE
 
+/* sectors per disk access and per bulk transfer, more than 1 enables ping-pong buffers so
+   next chunk is read from or written to disk while current one is on the bus */
+#ifndef RT_USB_MSTORAGE_BUF_SECTORS
+#define RT_USB_MSTORAGE_BUF_SECTORS     1
+#endif
+#if RT_USB_MSTORAGE_BUF_SECTORS > 1
+#define MSTORAGE_PIPELINE
+#endif
+
 enum STAT
 {
     STAT_CBW,
@@ -66,6 +75,12 @@ struct mstorage
     rt_int32_t size;
     struct scsi_cmd* processing;
     struct rt_device_blk_geometry geometry;    
+#ifdef MSTORAGE_PIPELINE
+    rt_uint8_t *pp_buf[2];
+    rt_uint8_t pp_idx;
+    rt_uint32_t xfer_blks;      /* sectors of current bulk transfer */
+    rt_uint32_t next_blks;      /* sectors read ahead into other buffer */
+#endif
 };
 
 ALIGN(4)
@@ -446,6 +461,40 @@ static rt_size_t _read_capacity(ufunction_t func, ustorage_cbw_t cbw)
     return data->cb_data_size;
 }
 
+#ifdef MSTORAGE_PIPELINE
+static rt_uint32_t _read_chunk(struct mstorage *data, rt_uint8_t *buf, rt_uint32_t block, rt_int32_t count)
+{
+    rt_uint32_t n = count > RT_USB_MSTORAGE_BUF_SECTORS ? RT_USB_MSTORAGE_BUF_SECTORS : count;
+
+    if (count <= 0)
+        return 0;
+    if (rt_device_read(data->disk, block, buf, n) != n)
+        return 0;
+    return n;
+}
+
+static void _send_chunk(ufunction_t func, struct mstorage *data)
+{
+    data->ep_in->request.buffer = data->pp_buf[data->pp_idx];
+    data->ep_in->request.size = data->xfer_blks * data->geometry.bytes_per_sector;
+    data->ep_in->request.req_type = UIO_REQUEST_WRITE;
+    rt_usbd_io_request(func->device, data->ep_in, &data->ep_in->request);
+
+    /* read ahead while current chunk is sent */
+    data->next_blks = _read_chunk(data, data->pp_buf[data->pp_idx ^ 1], data->block + data->xfer_blks,
+                                  data->count - data->xfer_blks);
+}
+
+static void _receive_chunk(ufunction_t func, struct mstorage *data)
+{
+    data->xfer_blks = data->count > RT_USB_MSTORAGE_BUF_SECTORS ? RT_USB_MSTORAGE_BUF_SECTORS : data->count;
+    data->ep_out->request.buffer = data->pp_buf[data->pp_idx];
+    data->ep_out->request.size = data->xfer_blks * data->geometry.bytes_per_sector;
+    data->ep_out->request.req_type = UIO_REQUEST_READ_FULL;
+    rt_usbd_io_request(func->device, data->ep_out, &data->ep_out->request);
+}
+#endif /* MSTORAGE_PIPELINE */
+
 /**
  * This function will handle read_10 request.
  *
@@ -471,6 +520,19 @@ static rt_size_t _read_10(ufunction_t func, ustorage_cbw_t cbw)
     RT_ASSERT(data->count < data->geometry.sector_count);
 
     data->csw_response.data_reside = data->cb_data_size;    
+#ifdef MSTORAGE_PIPELINE
+    data->pp_idx = 0;
+    data->xfer_blks = _read_chunk(data, data->pp_buf[0], data->block, data->count);
+    if(data->xfer_blks == 0)
+    {
+        rt_kprintf("read data error\n");
+        data->xfer_blks = 1;
+    }
+    _send_chunk(func, data);
+    data->status = STAT_SEND;
+
+    return data->xfer_blks * data->geometry.bytes_per_sector;
+#else
     size = rt_device_read(data->disk, data->block, data->ep_in->buffer, 1);
     if(size == 0)
     {
@@ -484,6 +546,7 @@ static rt_size_t _read_10(ufunction_t func, ustorage_cbw_t cbw)
     data->status = STAT_SEND;
     
     return data->geometry.bytes_per_sector;
+#endif
 }
 
 /**
@@ -515,6 +578,13 @@ static rt_size_t _write_10(ufunction_t func, ustorage_cbw_t cbw)
 
     data->csw_response.data_reside = data->cb_data_size;
     
+#ifdef MSTORAGE_PIPELINE
+    data->pp_idx = 0;
+    _receive_chunk(func, data);
+    data->status = STAT_RECEIVE;
+
+    return data->xfer_blks * data->geometry.bytes_per_sector;
+#else
     data->ep_out->request.buffer = data->ep_out->buffer;
     data->ep_out->request.size = data->geometry.bytes_per_sector;    
     data->ep_out->request.req_type = UIO_REQUEST_READ_FULL;
@@ -522,6 +592,7 @@ static rt_size_t _write_10(ufunction_t func, ustorage_cbw_t cbw)
     data->status = STAT_RECEIVE;
     
     return data->geometry.bytes_per_sector;
+#endif
 }
 
 /**
@@ -617,6 +688,29 @@ static rt_err_t _ep_in_handler(ufunction_t func, rt_size_t size)
         _send_status(func);
         break;
      case STAT_SEND:        
+#ifdef MSTORAGE_PIPELINE
+        data->csw_response.data_reside -= data->ep_in->request.size;
+        data->count -= data->xfer_blks;
+        data->block += data->xfer_blks;
+        if(data->count > 0 && data->csw_response.data_reside > 0)
+        {
+            data->pp_idx ^= 1;
+            data->xfer_blks = data->next_blks;
+            if(data->xfer_blks == 0)
+                data->xfer_blks = _read_chunk(data, data->pp_buf[data->pp_idx], data->block, data->count);
+            if(data->xfer_blks == 0)
+            {
+                rt_kprintf("disk read error\n");
+                rt_usbd_ep_set_stall(func->device, data->ep_in);
+                return -RT_ERROR;
+            }
+            _send_chunk(func, data);
+        }
+        else
+        {
+            _send_status(func);
+        }
+#else
         data->csw_response.data_reside -= data->ep_in->request.size;
         data->count--;    
         data->block++;        
@@ -638,6 +732,7 @@ static rt_err_t _ep_in_handler(ufunction_t func, rt_size_t size)
         {
             _send_status(func);            
         }        
+#endif
         break;
      }
 
@@ -854,6 +949,29 @@ static rt_err_t _ep_out_handler(ufunction_t func, rt_size_t size)
         data->size -= size;
         data->csw_response.data_reside -= size;
 
+#ifdef MSTORAGE_PIPELINE
+        {
+            rt_uint8_t *buf = data->pp_buf[data->pp_idx];
+            rt_uint32_t blks = size / data->geometry.bytes_per_sector;
+
+            data->count -= blks;
+            if(data->csw_response.data_reside != 0 && data->count > 0)
+            {
+                /* receive next chunk into other buffer while this one is written */
+                data->pp_idx ^= 1;
+                _receive_chunk(func, data);
+                if(rt_device_write(data->disk, data->block, buf, blks) != blks)
+                    data->csw_response.status = 1;
+                data->block += blks;
+            }
+            else
+            {
+                if(rt_device_write(data->disk, data->block, buf, blks) != blks)
+                    data->csw_response.status = 1;
+                _send_status(func);
+            }
+        }
+#else
         rt_device_write(data->disk, data->block, data->ep_out->buffer, 1);
 
         if(data->csw_response.data_reside != 0)
@@ -868,6 +986,7 @@ static rt_err_t _ep_out_handler(ufunction_t func, rt_size_t size)
         {
             _send_status(func);
         }
+#endif
 
         return RT_EOK;
     }
@@ -984,16 +1103,35 @@ static rt_err_t _function_enable(ufunction_t func)
         return -RT_ERROR;
     }
     
+#ifdef MSTORAGE_PIPELINE
+    data->ep_in->buffer = (rt_uint8_t*)rt_malloc(data->geometry.bytes_per_sector * RT_USB_MSTORAGE_BUF_SECTORS);
+    data->pp_buf[1] = (rt_uint8_t*)rt_malloc(data->geometry.bytes_per_sector * RT_USB_MSTORAGE_BUF_SECTORS);
+    if(data->ep_in->buffer == RT_NULL || data->pp_buf[1] == RT_NULL)
+    {
+        rt_free(data->ep_in->buffer);
+        rt_free(data->pp_buf[1]);
+        data->ep_in->buffer = RT_NULL;
+        data->pp_buf[1] = RT_NULL;
+        rt_kprintf("no memory\n");
+        return -RT_ENOMEM;
+    }
+    data->pp_buf[0] = data->ep_in->buffer;
+#else
     data->ep_in->buffer = (rt_uint8_t*)rt_malloc(data->geometry.bytes_per_sector);
     if(data->ep_in->buffer == RT_NULL)
     {
         rt_kprintf("no memory\n");
         return -RT_ENOMEM;
     }
+#endif
     data->ep_out->buffer = (rt_uint8_t*)rt_malloc(data->geometry.bytes_per_sector);
     if(data->ep_out->buffer == RT_NULL)
     {
         rt_free(data->ep_in->buffer);
+#ifdef MSTORAGE_PIPELINE
+        rt_free(data->pp_buf[1]);
+        data->pp_buf[1] = RT_NULL;
+#endif
         rt_kprintf("no memory\n");
         return -RT_ENOMEM;
     }    
@@ -1033,6 +1171,14 @@ static rt_err_t _function_disable(ufunction_t func)
         rt_free(data->ep_out->buffer);
         data->ep_out->buffer = RT_NULL;
     }
+#ifdef MSTORAGE_PIPELINE
+    if(data->pp_buf[1] != RT_NULL)
+    {
+        rt_free(data->pp_buf[1]);
+        data->pp_buf[1] = RT_NULL;
+    }
+    data->pp_buf[0] = RT_NULL;
+#endif
     if(data->disk != RT_NULL)
     {
         rt_device_close(data->disk);
@@ -857,7 +857,7 @@ static rt_err_t _data_notify(udevice_t device, struct ep_msg *ep_msg)
         }
         else
         {
-            dcd_ep_read_prepare(device->dcd, EP_ADDRESS(ep), ep->request.buffer, ep->request.remain_size > EP_MAXPACKET(ep) ? EP_MAXPACKET(ep) : ep->request.remain_size);
+            rt_usbd_ep_read_prepare(device, ep, ep->request.buffer, ep->request.remain_size);
         }
     }
 
@@ -969,7 +969,12 @@ static rt_size_t rt_usbd_ep_write(udevice_t device, uep_t ep, void *buffer, rt_s
 
     rt_enter_critical();
     maxpacket = EP_MAXPACKET(ep);
-    if (ep->request.remain_size >= maxpacket)
+    if (device->dcd->multi_packet)
+    {
+        dcd_ep_write(device->dcd, EP_ADDRESS(ep), buffer, size);
+        ep->request.remain_size = 0;
+    }
+    else if (ep->request.remain_size >= maxpacket)
     {
         dcd_ep_write(device->dcd, EP_ADDRESS(ep), ep->request.buffer, maxpacket);
         ep->request.remain_size -= maxpacket;
@@ -993,6 +998,9 @@ static rt_size_t rt_usbd_ep_read_prepare(udevice_t device, uep_t ep, void *buffe
     RT_ASSERT(buffer != RT_NULL);
     RT_ASSERT(ep->ep_desc != RT_NULL);
 
+    if (device->dcd->multi_packet)
+        return dcd_ep_read_prepare(device->dcd, EP_ADDRESS(ep), buffer, size);
+
     return dcd_ep_read_prepare(device->dcd, EP_ADDRESS(ep), buffer, size > EP_MAXPACKET(ep) ? EP_MAXPACKET(ep) : size);
 }
 
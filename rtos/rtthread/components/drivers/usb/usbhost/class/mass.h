@@ -33,9 +33,30 @@ struct ustor
     
     struct rt_device dev[MAX_PARTITION_COUNT];
     rt_uint8_t dev_cnt;
+#ifdef RT_USBH_MSTORAGE_CACHE
+    struct udisk_cache* cache;
+#endif
 };    
 typedef struct ustor* ustor_t;
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+struct udisk_cache_stat
+{
+    rt_uint32_t reads;          /* device read calls */
+    rt_uint32_t hits;           /* reads served from read ahead buffer only */
+    rt_uint32_t direct;         /* reads sent to user buffer */
+    rt_uint32_t writes;         /* device write calls */
+    rt_uint32_t merged;         /* writes appended to write back buffer */
+    rt_uint32_t flushes;
+    rt_uint32_t read10;         /* SCSI commands sent */
+    rt_uint32_t write10;
+    rt_uint32_t read_sectors;   /* sectors moved on bus */
+    rt_uint32_t write_sectors;
+};
+
+void rt_udisk_cache_get_stat(struct udisk_cache_stat* stat, rt_bool_t reset);
+#endif
+
 rt_err_t rt_usbh_storage_get_max_lun(struct uhintf* intf, rt_uint8_t* max_lun);
 rt_err_t rt_usbh_storage_reset(struct uhintf* intf);
 rt_err_t rt_usbh_storage_read10(struct uhintf* intf, rt_uint8_t *buffer, 
@@ -42,6 +42,264 @@ static void udisk_free_id(int id)
     _udisk_idset &= ~(1 << id);
 }
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+
+#ifndef UDISK_RA_MIN_SECTORS
+#define UDISK_RA_MIN_SECTORS   8
+#endif
+#ifndef UDISK_RA_MAX_SECTORS
+#define UDISK_RA_MAX_SECTORS   64
+#endif
+#ifndef UDISK_WB_SECTORS
+#define UDISK_WB_SECTORS       64
+#endif
+
+/*
+ * Every bulk only command costs CBW, data and CSW stages on the bus, file system
+ * asks one or a few sectors a time. Sequential reads are served from a read ahead
+ * buffer filled with one READ(10), its window doubles on every sequential miss up to
+ * UDISK_RA_MAX_SECTORS and falls back to UDISK_RA_MIN_SECTORS on random access.
+ * Request not smaller than the window goes to user buffer directly.
+ *
+ * Sequential writes are gathered in write back buffer and sent with one WRITE(10),
+ * it's flushed on non-contiguous write, overlapping read, RT_DEVICE_CTRL_BLK_SYNC
+ * and device close, which is done by unmount.
+ */
+struct udisk_cache
+{
+    struct rt_mutex lock;
+    rt_uint8_t* ra_buf;
+    rt_uint32_t ra_start;
+    rt_uint32_t ra_count;
+    rt_uint32_t ra_window;
+    rt_uint32_t next;           /* sector after last read */
+    rt_uint8_t* wb_buf;
+    rt_uint32_t wb_start;
+    rt_uint32_t wb_count;
+};
+
+static struct udisk_cache_stat _udisk_stat;
+
+static int udisk_timeout(rt_size_t sectors)
+{
+    return (sectors * SECTOR_SIZE > 4096) ? USB_TIMEOUT_LONG * 2 : USB_TIMEOUT_LONG;
+}
+
+static rt_err_t udisk_cache_read10(struct uhintf* intf, rt_uint8_t* buffer,
+    rt_uint32_t sector, rt_size_t count)
+{
+    _udisk_stat.read10++;
+    _udisk_stat.read_sectors += count;
+    return rt_usbh_storage_read10(intf, buffer, sector, count, udisk_timeout(count));
+}
+
+static rt_err_t udisk_cache_write10(struct uhintf* intf, rt_uint8_t* buffer,
+    rt_uint32_t sector, rt_size_t count)
+{
+    _udisk_stat.write10++;
+    _udisk_stat.write_sectors += count;
+    return rt_usbh_storage_write10(intf, buffer, sector, count, udisk_timeout(count));
+}
+
+static struct udisk_cache* udisk_cache_create(void)
+{
+    struct udisk_cache* cache;
+
+    cache = rt_malloc(sizeof(struct udisk_cache));
+    if(cache == RT_NULL) return RT_NULL;
+
+    rt_memset(cache, 0, sizeof(struct udisk_cache));
+    cache->ra_buf = rt_malloc(UDISK_RA_MAX_SECTORS * SECTOR_SIZE);
+    cache->wb_buf = rt_malloc(UDISK_WB_SECTORS * SECTOR_SIZE);
+    if(cache->ra_buf == RT_NULL || cache->wb_buf == RT_NULL)
+    {
+        if(cache->ra_buf) rt_free(cache->ra_buf);
+        if(cache->wb_buf) rt_free(cache->wb_buf);
+        rt_free(cache);
+        return RT_NULL;
+    }
+    cache->ra_window = UDISK_RA_MIN_SECTORS;
+    rt_mutex_init(&cache->lock, "udisk", RT_IPC_FLAG_FIFO);
+
+    return cache;
+}
+
+static void udisk_cache_delete(struct udisk_cache* cache)
+{
+    rt_mutex_detach(&cache->lock);
+    rt_free(cache->ra_buf);
+    rt_free(cache->wb_buf);
+    rt_free(cache);
+}
+
+/* call with cache locked */
+static rt_err_t udisk_cache_flush(struct uhintf* intf, struct udisk_cache* cache)
+{
+    rt_err_t ret;
+
+    if(cache->wb_count == 0) return RT_EOK;
+
+    _udisk_stat.flushes++;
+    ret = udisk_cache_write10(intf, cache->wb_buf, cache->wb_start, cache->wb_count);
+    if(ret != RT_EOK)
+        rt_kprintf("usb mass_storage flush %d sector failed\n", cache->wb_count);
+    /* data is dropped on error, retry would not help on a removed disk */
+    cache->wb_count = 0;
+
+    return ret;
+}
+
+rt_inline rt_bool_t udisk_overlap(rt_uint32_t start1, rt_uint32_t count1,
+    rt_uint32_t start2, rt_uint32_t count2)
+{
+    return (count1 != 0) && (count2 != 0)
+        && (start1 < start2 + count2) && (start2 < start1 + count1);
+}
+
+static rt_size_t udisk_cache_read(struct uhintf* intf, struct udisk_cache* cache,
+    rt_uint32_t pos, rt_uint8_t* buffer, rt_size_t size)
+{
+    ustor_t stor = (ustor_t)intf->user_data;
+    rt_size_t left = size;
+    rt_uint32_t n;
+    rt_bool_t sequential, hit = RT_TRUE;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    _udisk_stat.reads++;
+
+    if(udisk_overlap(cache->wb_start, cache->wb_count, pos, size))
+        udisk_cache_flush(intf, cache);
+
+    sequential = (pos == cache->next);
+    if(!sequential) cache->ra_window = UDISK_RA_MIN_SECTORS;
+    cache->next = pos + size;
+
+    while(left > 0)
+    {
+        if(pos >= cache->ra_start && pos < cache->ra_start + cache->ra_count)
+        {
+            n = cache->ra_start + cache->ra_count - pos;
+            if(n > left) n = left;
+            rt_memcpy(buffer, cache->ra_buf + (pos - cache->ra_start) * SECTOR_SIZE,
+                n * SECTOR_SIZE);
+        }
+        else if(left >= cache->ra_window)
+        {
+            /* large request, no copy */
+            hit = RT_FALSE;
+            _udisk_stat.direct++;
+            n = left;
+            if(udisk_cache_read10(intf, buffer, pos, n) != RT_EOK) break;
+        }
+        else
+        {
+            hit = RT_FALSE;
+            n = cache->ra_window;
+            if(pos + n > stor->capicity[0])
+                n = (pos < stor->capicity[0]) ? stor->capicity[0] - pos : 0;
+            if(n < left) n = left;
+
+            cache->ra_count = 0;
+            if(udisk_cache_read10(intf, cache->ra_buf, pos, n) != RT_EOK) break;
+            cache->ra_start = pos;
+            cache->ra_count = n;
+            continue;
+        }
+
+        left -= n;
+        pos += n;
+        buffer += n * SECTOR_SIZE;
+    }
+
+    if(!hit && sequential && cache->ra_window < UDISK_RA_MAX_SECTORS)
+    {
+        cache->ra_window *= 2;
+        if(cache->ra_window > UDISK_RA_MAX_SECTORS) cache->ra_window = UDISK_RA_MAX_SECTORS;
+    }
+    if(hit) _udisk_stat.hits++;
+
+    rt_mutex_release(&cache->lock);
+
+    return size - left;
+}
+
+static rt_size_t udisk_cache_write(struct uhintf* intf, struct udisk_cache* cache,
+    rt_uint32_t pos, const rt_uint8_t* buffer, rt_size_t size)
+{
+    rt_err_t ret = RT_EOK;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    _udisk_stat.writes++;
+
+    if(udisk_overlap(cache->ra_start, cache->ra_count, pos, size))
+        cache->ra_count = 0;
+
+    if(cache->wb_count != 0 && pos == cache->wb_start + cache->wb_count
+        && cache->wb_count + size <= UDISK_WB_SECTORS)
+    {
+        _udisk_stat.merged++;
+        rt_memcpy(cache->wb_buf + cache->wb_count * SECTOR_SIZE, buffer, size * SECTOR_SIZE);
+        cache->wb_count += size;
+    }
+    else
+    {
+        ret = udisk_cache_flush(intf, cache);
+        if(ret == RT_EOK && size >= UDISK_WB_SECTORS)
+        {
+            ret = udisk_cache_write10(intf, (rt_uint8_t*)buffer, pos, size);
+        }
+        else if(ret == RT_EOK)
+        {
+            rt_memcpy(cache->wb_buf, buffer, size * SECTOR_SIZE);
+            cache->wb_start = pos;
+            cache->wb_count = size;
+        }
+    }
+
+    rt_mutex_release(&cache->lock);
+
+    return (ret == RT_EOK) ? size : 0;
+}
+
+static rt_err_t udisk_cache_sync(struct uhintf* intf, struct udisk_cache* cache)
+{
+    rt_err_t ret;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    ret = udisk_cache_flush(intf, cache);
+    rt_mutex_release(&cache->lock);
+
+    return ret;
+}
+
+void rt_udisk_cache_get_stat(struct udisk_cache_stat* stat, rt_bool_t reset)
+{
+    rt_enter_critical();
+    *stat = _udisk_stat;
+    if(reset) rt_memset(&_udisk_stat, 0, sizeof(_udisk_stat));
+    rt_exit_critical();
+}
+
+#ifdef RT_USING_FINSH
+static int udisk_cache(int argc, char** argv)
+{
+    struct udisk_cache_stat stat;
+
+    rt_udisk_cache_get_stat(&stat, (argc > 1) && (rt_strcmp(argv[1], "reset") == 0));
+    rt_kprintf("read %d, hit %d, direct %d, READ(10) %d, %d sectors\n", stat.reads,
+        stat.hits, stat.direct, stat.read10, stat.read_sectors);
+    rt_kprintf("write %d, merged %d, flush %d, WRITE(10) %d, %d sectors\n", stat.writes,
+        stat.merged, stat.flushes, stat.write10, stat.write_sectors);
+    rt_kprintf("read ahead %d-%d sectors, write back %d sectors\n",
+        UDISK_RA_MIN_SECTORS, UDISK_RA_MAX_SECTORS, UDISK_WB_SECTORS);
+
+    return 0;
+}
+MSH_CMD_EXPORT(udisk_cache, udisk_cache [reset]: show usb mass storage cache);
+#endif
+
+#endif /* RT_USBH_MSTORAGE_CACHE */
+
 /**
  * This function will initialize the udisk device
  *
@@ -81,6 +339,19 @@ static rt_size_t rt_udisk_read(rt_device_t dev, rt_off_t pos, void* buffer,
     data = (struct ustor_data*)dev->user_data;
     intf = data->intf;
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+    if(((ustor_t)intf->user_data)->cache != RT_NULL)
+    {
+        if(udisk_cache_read(intf, ((ustor_t)intf->user_data)->cache, pos,
+            (rt_uint8_t*)buffer, size) != size)
+        {
+            rt_kprintf("usb mass_storage read failed\n");
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     ret = rt_usbh_storage_read10(intf, (rt_uint8_t*)buffer, pos, size, timeout);
 
     if (ret != RT_EOK)
@@ -119,6 +390,19 @@ static rt_size_t rt_udisk_write (rt_device_t dev, rt_off_t pos, const void* buff
     data = (struct ustor_data*)dev->user_data;
     intf = data->intf;
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+    if(((ustor_t)intf->user_data)->cache != RT_NULL)
+    {
+        if(udisk_cache_write(intf, ((ustor_t)intf->user_data)->cache, pos,
+            (const rt_uint8_t*)buffer, size) != size)
+        {
+            rt_kprintf("usb mass_storage write %d sector failed\n", size);
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     ret = rt_usbh_storage_write10(intf, (rt_uint8_t*)buffer, pos, size, timeout);
     if (ret != RT_EOK)
     {
@@ -159,16 +443,39 @@ static rt_err_t rt_udisk_control(rt_device_t dev, int cmd, void *args)
         geometry->block_size = stor->capicity[1];
         geometry->sector_count = stor->capicity[0];
     }
+#ifdef RT_USBH_MSTORAGE_CACHE
+    else if (cmd == RT_DEVICE_CTRL_BLK_SYNC)
+    {
+        if (stor->cache != RT_NULL)
+            return udisk_cache_sync(data->intf, stor->cache);
+    }
+#endif
 
     return RT_EOK;
 }
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+static rt_err_t rt_udisk_close(rt_device_t dev)
+{
+    struct ustor_data* data = (struct ustor_data*)dev->user_data;
+    ustor_t stor = (ustor_t)data->intf->user_data;
+
+    /* dfs_unmount closes device, nothing should stay in write back buffer */
+    if (stor->cache != RT_NULL)
+        udisk_cache_sync(data->intf, stor->cache);
+
+    return RT_EOK;
+}
+#else
+#define rt_udisk_close RT_NULL
+#endif
+
 #ifdef RT_USING_DEVICE_OPS
 const static struct rt_device_ops udisk_device_ops =
 {
     rt_udisk_init,
     RT_NULL,
-    RT_NULL,
+    rt_udisk_close,
     rt_udisk_read,
     rt_udisk_write,
     rt_udisk_control
@@ -304,6 +611,13 @@ rt_err_t rt_udisk_run(struct uhintf* intf)
 
     RT_DEBUG_LOG(RT_DEBUG_USB, ("finished reading partition\n"));
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+    /* cache is shared by all partitions of the disk */
+    stor->cache = udisk_cache_create();
+    if(stor->cache == RT_NULL)
+        rt_kprintf("no memory for udisk cache, access disk directly\n");
+#endif
+
     for(i=0; i<MAX_PARTITION_COUNT; i++)
     {
         /* get the first partition */
@@ -324,6 +638,7 @@ rt_err_t rt_udisk_run(struct uhintf* intf)
             stor->dev[i].ops     = &udisk_device_ops;
 #else
             stor->dev[i].init    = rt_udisk_init;
+            stor->dev[i].close   = rt_udisk_close;
             stor->dev[i].read    = rt_udisk_read;
             stor->dev[i].write   = rt_udisk_write;
             stor->dev[i].control = rt_udisk_control;
@@ -366,6 +681,7 @@ rt_err_t rt_udisk_run(struct uhintf* intf)
                 stor->dev[i].ops     = &udisk_device_ops;
 #else
                 stor->dev[0].init    = rt_udisk_init;
+                stor->dev[0].close   = rt_udisk_close;
                 stor->dev[0].read    = rt_udisk_read;
                 stor->dev[0].write   = rt_udisk_write;
                 stor->dev[0].control = rt_udisk_control;
@@ -435,6 +751,14 @@ rt_err_t rt_udisk_stop(struct uhintf* intf)
         rt_device_unregister(&stor->dev[i]);
     }
 
+#ifdef RT_USBH_MSTORAGE_CACHE
+    if(stor->cache != RT_NULL)
+    {
+        udisk_cache_delete(stor->cache);
+        stor->cache = RT_NULL;
+    }
+#endif
+
     return RT_EOK;
 }
 
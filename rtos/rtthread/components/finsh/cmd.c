@@ -504,12 +504,21 @@ static long _list_timer(struct rt_list_node *list)
     struct rt_timer *timer;
     struct rt_list_node *node;
     const char *item_title = "timer";
+#ifdef RT_TIMER_EXEC_STAT
+    rt_uint32_t freq = rt_timer_exec_clock_freq();
+#endif
 
     maxlen = object_name_maxlen(item_title, list);
 
+#ifdef RT_TIMER_EXEC_STAT
+    rt_kprintf("%-*.s  periodic   timeout       flag        count   avg_us   max_us\n", maxlen, item_title);
+    object_split(maxlen);
+    rt_kprintf(" ---------- ---------- ----------- -------- -------- --------\n");
+#else
     rt_kprintf("%-*.s  periodic   timeout       flag\n", maxlen, item_title);
     object_split(maxlen);
     rt_kprintf(" ---------- ---------- -----------\n");
+#endif /* RT_TIMER_EXEC_STAT */
     for (node = list->next; node != list; node = node->next)
     {
         timer = (struct rt_timer *)(rt_list_entry(node, struct rt_object, list));
@@ -518,10 +527,19 @@ static long _list_timer(struct rt_list_node *list)
                    timer->parent.name,
                    timer->init_tick,
                    timer->timeout_tick);
+#ifdef RT_TIMER_EXEC_STAT
+        /* execution count, average and max time of timeout function in us */
+        rt_kprintf("%-11s %8d %8d %8d\n",
+                   (timer->parent.flag & RT_TIMER_FLAG_ACTIVATED) ? "activated" : "deactivated",
+                   timer->exec_cnt,
+                   timer->exec_cnt ? (rt_uint32_t)((rt_uint64_t)timer->exec_total * 1000000 / freq / timer->exec_cnt) : 0,
+                   (rt_uint32_t)((rt_uint64_t)timer->exec_max * 1000000 / freq));
+#else
         if (timer->parent.flag & RT_TIMER_FLAG_ACTIVATED)
             rt_kprintf("activated\n");
         else
             rt_kprintf("deactivated\n");
+#endif /* RT_TIMER_EXEC_STAT */
     }
 
     rt_kprintf("current tick:0x%08x\n", rt_tick_get());
@@ -67,8 +67,109 @@ static void dlmodule_write_exec_mem(struct rt_dlmodule *module, rt_uint32_t offs
     module->wr_offset += wr_len;
 }
 
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+/* sections which are written only by relocation and are reached PC relative from code */
+static rt_bool_t dlmodule_is_ro_after_reloc(const char *name)
+{
+    static const char *const names[] =
+    {
+        ".got", ".got.plt", ".dynamic", ".init_array", ".fini_array", ".preinit_array", ".data.rel.ro",
+    };
+    rt_uint32_t i;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        if (rt_strcmp(name, names[i]) == 0)
+            return RT_TRUE;
+
+    return RT_FALSE;
+}
+
+/* find writable data which could run in RAM window while the rest of module runs in flash */
+static void dlmodule_xip_data_split(struct rt_dlmodule *module, void *module_ptr)
+{
+    rt_bool_t textrel = RT_FALSE;
+    Elf32_Addr rw_start = 0, rw_end = 0, file_end = 0, keep_end, ram_start;
+    rt_uint8_t *shstrab = (rt_uint8_t *)module_ptr + shdr[elf_module->e_shstrndx].sh_offset;
+    rt_uint8_t *window;
+    rt_uint32_t win_size, pad;
+    rt_uint32_t index;
+
+    module->data_size = 0;
+
+    for (index = 0; index < elf_module->e_phnum; index++)
+    {
+        if (phdr[index].p_type == PT_DYNAMIC)
+        {
+            Elf32_Dyn *dyn = (Elf32_Dyn *)((rt_uint8_t *)module_ptr + phdr[index].p_offset);
+
+            for (; dyn->d_tag != DT_NULL; dyn++)
+                if (dyn->d_tag == DT_TEXTREL || (dyn->d_tag == DT_FLAGS && (dyn->d_val & DF_TEXTREL)))
+                    textrel = RT_TRUE;
+        }
+        else if (phdr[index].p_type == PT_LOAD && (phdr[index].p_flags & PF_W))
+        {
+            rw_start = phdr[index].p_vaddr;
+            rw_end = rw_start + phdr[index].p_memsz;
+            file_end = rw_start + phdr[index].p_filesz;
+        }
+    }
+
+    /* code of position independent module reaches data PC relative, can't be moved */
+    if (!textrel || rw_end == rw_start)
+    {
+        LOG_I("%s: data kept with code", module->parent.name);
+        return;
+    }
+
+    keep_end = rw_start;
+    ram_start = rw_end;
+    for (index = 0; index < elf_module->e_shnum; index++)
+    {
+        if (!IS_AW(shdr[index]) || shdr[index].sh_addr < rw_start || shdr[index].sh_addr >= rw_end)
+            continue;
+
+        if (dlmodule_is_ro_after_reloc((const char *)(shstrab + shdr[index].sh_name)))
+        {
+            if (shdr[index].sh_addr + shdr[index].sh_size > keep_end)
+                keep_end = shdr[index].sh_addr + shdr[index].sh_size;
+        }
+        else if (shdr[index].sh_addr < ram_start)
+        {
+            ram_start = shdr[index].sh_addr;
+        }
+    }
+
+    window = dlmodule_xip_data_window(&win_size);
+    /* keep alignment of data */
+    pad = ram_start & 31;
+    if (ram_start < keep_end || ram_start == rw_end || rw_end - ram_start + pad > win_size)
+    {
+        LOG_W("%s: data %d bytes can't be moved to RAM", module->parent.name, rw_end - ram_start);
+        return;
+    }
+
+    module->data_vaddr = ram_start;
+    module->data_size = rw_end - ram_start;
+    module->data_init_size = (file_end > ram_start) ? file_end - ram_start : 0;
+    module->data_space = window + pad;
+    LOG_I("%s: data 0x%x, %d bytes in RAM, %d bytes XIP", module->parent.name,
+          module->data_space, module->data_size, rw_end - module->vstart_addr - module->data_size);
+}
+#endif /* RT_DLMODULE_XIP_DATA_SIZE */
+
 #endif /* RT_USING_XIP_MODULE */
 
+/* runtime address of module address */
+static Elf32_Addr dlmodule_map_addr(struct rt_dlmodule *module, Elf32_Addr vaddr)
+{
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+    if (module->data_size && vaddr >= module->data_vaddr && vaddr <= module->data_vaddr + module->data_size)
+        return (Elf32_Addr)module->data_space + vaddr - module->data_vaddr;
+#endif
+
+    return (Elf32_Addr)module->exec_mem_space + vaddr - module->vstart_addr;
+}
+
 rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_ptr, uint8_t module_mode)
 {
     rt_bool_t linked   = RT_FALSE;
@@ -156,6 +257,9 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
             return -RT_ENOMEM;
         }
         module->mem_size = module_size;
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+        dlmodule_xip_data_split(module, module_ptr);
+#endif
         for (index = 0; index < elf_module->e_phnum; index++)
         {
             if (phdr[index].p_type == PT_LOAD)
@@ -209,6 +313,8 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
         Elf32_Rel *rel;
         rt_uint8_t *strtab;
         rt_bool_t unsolved = RT_FALSE;
+        Elf32_Addr *sym_cache;
+        rt_uint32_t nr_sym, nr_lookup = 0;
 
         if (!IS_REL(shdr[index]))
             continue;
@@ -223,6 +329,12 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
                  shdr[shdr[shdr[index].sh_link].sh_link].sh_offset;
         nr_reloc = (rt_uint32_t)(shdr[index].sh_size / sizeof(Elf32_Rel));
 
+        /* kernel symbol of each dynamic symbol is looked up once, many relocations share it */
+        nr_sym = shdr[shdr[index].sh_link].sh_size / sizeof(Elf32_Sym);
+        sym_cache = dlm_malloc(nr_sym * sizeof(Elf32_Addr));
+        if (sym_cache)
+            rt_memset(sym_cache, 0, nr_sym * sizeof(Elf32_Addr));
+
         /* relocate every items */
         for (i = 0; i < nr_reloc; i ++)
         {
@@ -232,7 +344,17 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
             {
                 Elf32_Addr addr;
 
-                addr = (Elf32_Addr)(module->exec_mem_space + sym->st_value - vstart_addr);
+                addr = dlmodule_map_addr(module, sym->st_value);
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+                if (module->data_size && ELF32_R_TYPE(rel->r_info) == R_ARM_RELATIVE)
+                {
+                    /* target is given by link address stored at place, it may be data or code */
+                    Elf32_Addr target = *(Elf32_Addr *)((rt_uint8_t *)module->exec_mem_space
+                                                        + rel->r_offset - vstart_addr);
+
+                    addr = dlmodule_map_addr(module, target) - target;
+                }
+#endif
                 dlmodule_relocate(module, rel, addr, module_mode);
                 LOG_D("relocate symbol1: %s, %x, %x", strtab + sym->st_name, addr, module->relocated_value);
                 if (DL_INSTALL == module_mode)
@@ -247,7 +369,14 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
                 Elf32_Addr addr;
 
                 /* need to resolve symbol in kernel symbol table */
-                addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                addr = sym_cache ? sym_cache[ELF32_R_SYM(rel->r_info)] : 0;
+                if (addr == 0)
+                {
+                    addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                    if (sym_cache)
+                        sym_cache[ELF32_R_SYM(rel->r_info)] = addr;
+                    nr_lookup++;
+                }
                 LOG_D("relocate symbol2: %s, %x", strtab + sym->st_name, addr);
                 if (addr == 0)
                 {
@@ -267,6 +396,10 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
             }
             rel ++;
         }
+        if (sym_cache)
+            dlm_free(sym_cache);
+        LOG_D("%d relocations, %d kernel symbol lookups", nr_reloc, nr_lookup);
+
         if (DL_INSTALL == module_mode)
         {
             /* flush data to storage */
@@ -330,8 +463,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
 
             length = rt_strlen((const char *)(strtab + symtab[i].st_name)) + 1;
 
-            module->symtab[count].addr =
-                (void *)(module->exec_mem_space + symtab[i].st_value - module->vstart_addr);
+            module->symtab[count].addr = (void *)dlmodule_map_addr(module, symtab[i].st_value);
             module->symtab[count].name = dlm_malloc(length);
             RT_ASSERT(module->symtab[count].name);
             rt_memset((void *)module->symtab[count].name, 0, length);
@@ -239,6 +239,21 @@ typedef struct
 #define PF_W                    2
 #define PF_R                    4
 
+/* Dynamic section entry */
+typedef struct
+{
+    Elf32_Sword d_tag;                         /* entry type */
+    Elf32_Word  d_val;                         /* integer value or address */
+} Elf32_Dyn;
+
+/* d_tag */
+#define DT_NULL                 0
+#define DT_TEXTREL              22
+#define DT_FLAGS                30
+
+/* DT_FLAGS */
+#define DF_TEXTREL              0x4
+
 /* sh_type */
 #define SHT_NULL                0              /* inactive */
 #define SHT_PROGBITS            1              /* program defined information */
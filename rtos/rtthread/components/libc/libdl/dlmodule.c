@@ -32,6 +32,23 @@ static dlmodule_symbol_resolver dlmodule_ex_sym_resolver;
 #ifdef RT_USING_XIP_MODULE
 const char *make_full_module_path(struct rt_dlmodule *module, const char *install_path);
 
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+/* data of XIP module is linked to this window at install time */
+ALIGN(32) static rt_uint8_t dlm_xip_data[RT_DLMODULE_XIP_DATA_SIZE];
+static struct rt_dlmodule *dlm_xip_data_owner;
+#endif
+
+rt_uint8_t *dlmodule_xip_data_window(rt_uint32_t *size)
+{
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+    *size = sizeof(dlm_xip_data);
+    return dlm_xip_data;
+#else
+    *size = 0;
+    return RT_NULL;
+#endif
+}
+
 
 
 static const char *_dlmodule_get_module_file_path(const char *install_path, const char *module_name)
@@ -369,6 +386,11 @@ rt_err_t dlmodule_deserialize(struct rt_dlmodule *module, const char *install_pa
     module->nref = temp.nref;
     module->nsym = temp.nsym;
     module->exec_mem_space = temp.exec_mem_space;
+    module->vstart_addr = temp.vstart_addr;
+    module->data_vaddr = temp.data_vaddr;
+    module->data_size = temp.data_size;
+    module->data_init_size = temp.data_init_size;
+    module->data_space = temp.data_space;
     module->user_data = RT_NULL;
     module->user_data_size = 0;
 
@@ -626,6 +648,13 @@ rt_err_t dlmodule_destroy(struct rt_dlmodule *module)
         dlm_free(module->symtab);
     }
 
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+    if (dlm_xip_data_owner == module)
+    {
+        dlm_xip_data_owner = RT_NULL;
+    }
+#endif
+
     /* destory module */
     if (module->mem_space)
     {
@@ -921,6 +950,7 @@ struct rt_dlmodule *dlmodule_run(const char *module_name, const char *install_pa
 
     struct rt_dlmodule *module = RT_NULL;
     rt_err_t err;
+    rt_tick_t tick = rt_tick_get();
 
     module = dlmodule_create();
     if (!module)
@@ -939,6 +969,40 @@ struct rt_dlmodule *dlmodule_run(const char *module_name, const char *install_pa
         goto __ERROR;
     }
 
+    if (module->data_size)
+    {
+#ifdef RT_DLMODULE_XIP_DATA_SIZE
+        rt_uint32_t win_size;
+        rt_uint8_t *window = dlmodule_xip_data_window(&win_size);
+
+        /* window is moved by firmware update */
+        if ((rt_uint8_t *)module->data_space < window
+                || (rt_uint8_t *)module->data_space + module->data_size > window + win_size)
+        {
+            rt_kprintf("dlmodule_run: %s must be reinstalled\n", module_name);
+            goto __ERROR;
+        }
+        if (dlm_xip_data_owner)
+        {
+            rt_kprintf("dlmodule_run: data window is used by %s\n", dlm_xip_data_owner->parent.name);
+            goto __ERROR;
+        }
+        dlm_xip_data_owner = module;
+        rt_memcpy(module->data_space,
+                  (rt_uint8_t *)module->exec_mem_space + module->data_vaddr - module->vstart_addr,
+                  module->data_init_size);
+        rt_memset((rt_uint8_t *)module->data_space + module->data_init_size, 0,
+                  module->data_size - module->data_init_size);
+#else
+        rt_kprintf("dlmodule_run: %s needs RT_DLMODULE_XIP_DATA_SIZE\n", module_name);
+        goto __ERROR;
+#endif
+    }
+
+    rt_kprintf("dlmodule_run: %s %d ms, XIP %d bytes, RAM %d bytes\n", module_name,
+               (rt_tick_get() - tick) * 1000 / RT_TICK_PER_SECOND,
+               module->mem_size - module->data_size, module->data_size);
+
     /* increase module reference count */
     module->nref++;
 
@@ -67,6 +67,12 @@ struct rt_dlmodule
 
     void *res_mng;
     void *res_module;
+
+    /* writable data of XIP module which runs in RAM, see RT_DLMODULE_XIP_DATA_SIZE */
+    rt_uint32_t data_vaddr;
+    rt_uint32_t data_size;
+    rt_uint32_t data_init_size;     /* bytes copied from installed image, rest is zeroed */
+    rt_addr_t data_space;
 };
 
 typedef rt_uint32_t (*dlmodule_symbol_resolver)(const char *sym_str);
@@ -103,6 +109,14 @@ struct rt_dlmodule *dlmodule_exec(const char *pgname, const char *cmd, int cmd_s
 void dlmodule_exit(int ret_code);
 
 #ifdef RT_USING_XIP_MODULE
+    /*
+     * If RT_DLMODULE_XIP_DATA_SIZE is defined, install places .data/.bss of a module linked
+     * without -fPIC (it has text relocations) in a RAM window of that size, code, rodata and
+     * GOT stay in flash, data is initialized from flash copy when module runs. Only one
+     * module with data could run at a time. Position independent module is installed as a
+     * whole and must keep its state by dlmodule_get_user_data().
+     */
+    rt_uint8_t *dlmodule_xip_data_window(rt_uint32_t *size);
     rt_err_t dlmodule_install(const char *module_name, rt_uint8_t *module_ptr, const char *install_path);
     rt_err_t dlmodule_uninstall(const char *module_name, const char *install_path);
     struct rt_dlmodule *dlmodule_run(const char *module_name, const char *install_path);
@@ -298,6 +298,10 @@
     #define PBUF_POOL_BUFSIZE            RT_LWIP_PBUF_POOL_BUFSIZE
 #endif
 
+/* LWIP_SUPPORT_CUSTOM_PBUF: let netif drivers pass received frames in their own
+   buffers, which are freed by callback when stack is done with them (BT PAN). */
+#define LWIP_SUPPORT_CUSTOM_PBUF    1
+
 /* PBUF_LINK_HLEN: the number of bytes that should be allocated for a
    link level header. */
 #define PBUF_LINK_HLEN              16
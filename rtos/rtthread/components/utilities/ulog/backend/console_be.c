@@ -22,6 +22,64 @@ static struct ulog_backend console;
     static struct rt_semaphore output_sem;
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+/* coalesce logs of one async batch into one console write, 0 to disable */
+#ifndef ULOG_CONSOLE_BATCH_SIZE
+    #define ULOG_CONSOLE_BATCH_SIZE   (512)
+#endif
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
+#if defined(ULOG_USING_ASYNC_OUTPUT) && defined(ULOG_CONSOLE_BATCH_SIZE) && (ULOG_CONSOLE_BATCH_SIZE > 0)
+#define CONSOLE_BATCH_ENABLED
+/* one buffer is filled while the other is sent by DMA */
+static char batch_buf[2][ULOG_CONSOLE_BATCH_SIZE];
+static rt_uint8_t batch_idx;
+static rt_size_t batch_len;
+static rt_bool_t batch_tx_pending;
+
+static void console_batch_wait_tx(void)
+{
+    if (batch_tx_pending)
+    {
+        rt_sem_take(&output_sem, RT_WAITING_FOREVER);
+        batch_tx_pending = RT_FALSE;
+    }
+}
+
+static void console_batch_send(rt_device_t dev)
+{
+    rt_uint16_t old_flag;
+
+    if (0 == batch_len)
+        return;
+
+    console_batch_wait_tx();
+
+    old_flag = dev->open_flag;
+    dev->open_flag |= RT_DEVICE_FLAG_STREAM;
+    rt_device_write(dev, 0, batch_buf[batch_idx], batch_len);
+    dev->open_flag = old_flag;
+    if (dev->open_flag & RT_DEVICE_FLAG_DMA_TX)
+    {
+        /* wait for done before buffer is reused */
+        batch_tx_pending = RT_TRUE;
+    }
+    batch_idx ^= 1;
+    batch_len = 0;
+}
+
+static void ulog_console_backend_flush(struct ulog_backend *backend)
+{
+    rt_device_t dev = rt_console_get_device();
+
+    if (dev)
+    {
+        console_batch_send(dev);
+        console_batch_wait_tx();
+    }
+}
+#endif /* CONSOLE_BATCH_ENABLED */
+
 #ifdef ULOG_USING_ASYNC_OUTPUT
 static rt_err_t ulog_tx_done(rt_device_t dev, void *buffer)
 {
@@ -46,6 +104,23 @@ __ROM_USED void ulog_console_backend_output(struct ulog_backend *backend, rt_uin
     }
     else
     {
+#ifdef CONSOLE_BATCH_ENABLED
+        if ((is_raw != RAW_BIN_MIX) && (len <= ULOG_CONSOLE_BATCH_SIZE) && (rt_interrupt_get_nest() == 0))
+        {
+            if (batch_len + len > ULOG_CONSOLE_BATCH_SIZE)
+            {
+                console_batch_send(dev);
+            }
+            rt_memcpy(&batch_buf[batch_idx][batch_len], log, len);
+            batch_len += len;
+            return;
+        }
+        /* keep output order */
+        if (rt_interrupt_get_nest() == 0)
+        {
+            ulog_console_backend_flush(backend);
+        }
+#endif /* CONSOLE_BATCH_ENABLED */
         rt_uint16_t old_flag = dev->open_flag;
         if (is_raw != RAW_BIN_MIX)
             dev->open_flag |= RT_DEVICE_FLAG_STREAM;
@@ -82,6 +157,9 @@ __ROM_USED int ulog_console_backend_init(void)
 #endif
     ulog_init();
     console.output = ulog_console_backend_output;
+#ifdef CONSOLE_BATCH_ENABLED
+    console.flush = ulog_console_backend_flush;
+#endif /* CONSOLE_BATCH_ENABLED */
 
 #ifdef ULOG_USING_ASYNC_OUTPUT
     rt_sem_init(&output_sem, "cons_be", 0, RT_IPC_FLAG_FIFO);
@@ -74,6 +74,37 @@
     #error "the log line buffer size must more than 80"
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+#ifndef ULOG_USING_ASYNC_OUTPUT
+    #error "ULOG_USING_DEFERRED_FORMAT depends on ULOG_USING_ASYNC_OUTPUT"
+#endif
+/* max bytes of arguments saved in one deferred log */
+#ifndef ULOG_DEFERRED_ARGS_MAX
+    #define ULOG_DEFERRED_ARGS_MAX         (128)
+#endif
+
+/*
+ * Log saved by producer with format pointer and raw arguments, formatted by async output thread.
+ * Arguments are saved as 32bit words, 64bit arguments take two words,
+ * string arguments are copied as length word and padded content.
+ */
+struct ulog_deferred_frame
+{
+    /* magic word is 0x11 */
+    rt_uint32_t magic: 8;
+    rt_uint32_t newline: 1;
+    rt_uint32_t is_isr: 1;
+    rt_uint32_t args_len: 22;
+    rt_uint32_t level;
+    const char *format;
+    const char *tag;
+    rt_tick_t tick;
+    char thread_name[RT_NAME_MAX];
+    rt_uint32_t args[0];
+};
+typedef struct ulog_deferred_frame *ulog_deferred_frame_t;
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 struct rt_ulog
 {
     rt_bool_t init_ok;
@@ -100,6 +131,13 @@ struct rt_ulog
     rt_uint32_t loss_bytes;
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    /* frame being formatted by async output */
+    ulog_deferred_frame_t deferred;
+    char deferred_body[ULOG_LINE_BUF_SIZE + 1];
+    char log_buf_deferred[ULOG_LINE_BUF_SIZE + 1];
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 #ifdef ULOG_USING_FILTER
     struct
     {
@@ -290,7 +328,12 @@ RT_WEAK rt_size_t ulog_formater(char *log_buf, rt_uint32_t level, const char *ta
         static rt_size_t tick_len = 0;
 
         log_buf[log_len] = '[';
-        tick_len = ulog_ultoa(log_buf + log_len + 1, ulog_get_tick());
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        if (ulog.deferred)
+            tick_len = ulog_ultoa(log_buf + log_len + 1, ulog.deferred->tick);
+        else
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+            tick_len = ulog_ultoa(log_buf + log_len + 1, ulog_get_tick());
         log_buf[log_len + 1 + tick_len] = ']';
         log_buf[log_len + 1 + tick_len + 1] = '\0';
 #endif /* ULOG_TIME_USING_TIMESTAMP */
@@ -327,6 +370,23 @@ RT_WEAK rt_size_t ulog_formater(char *log_buf, rt_uint32_t level, const char *ta
         log_len += ulog_strcpy(log_len, log_buf + log_len, " ");
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        if (ulog.deferred)
+        {
+            if (ulog.deferred->is_isr)
+            {
+                log_len += ulog_strcpy(log_len, log_buf + log_len, "ISR");
+            }
+            else
+            {
+                rt_size_t name_len = rt_strnlen(ulog.deferred->thread_name, RT_NAME_MAX);
+
+                rt_strncpy(log_buf + log_len, ulog.deferred->thread_name, name_len);
+                log_len += name_len;
+            }
+        }
+        else
+#endif /* ULOG_USING_DEFERRED_FORMAT */
         /* is not in interrupt context */
         if (rt_interrupt_get_nest() == 0)
         {
@@ -494,6 +554,294 @@ static void do_output(rt_uint32_t level, const char *tag, rt_bool_t is_raw, cons
 #endif /* ULOG_USING_ASYNC_OUTPUT */
 }
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+static rt_bool_t is_spec_flag(char c)
+{
+    return (c == '-') || (c == '+') || (c == ' ') || (c == '#') || (c == '.') || ((c >= '0') && (c <= '9'));
+}
+
+static rt_bool_t is_spec_length(char c)
+{
+    return (c == 'h') || (c == 'l') || (c == 'z') || (c == 'j') || (c == 't');
+}
+
+/*
+ * Walk arguments of format, save them to args if it's not NULL.
+ * Return saved bytes, or -1 if format is not supported by deferred formatting.
+ */
+static int deferred_save_args(rt_uint32_t *args, const char *format, va_list ap)
+{
+    rt_size_t len = 0, str_len;
+    rt_uint32_t word_num;
+    int long_num;
+    const char *s;
+    union
+    {
+        rt_uint32_t w[2];
+        long long ll;
+        double d;
+    } v;
+
+    for (; *format; format++)
+    {
+        if ('%' != *format)
+            continue;
+        format++;
+
+        /* flags, width and precision, '*' is not supported */
+        while (is_spec_flag(*format))
+            format++;
+
+        long_num = 0;
+        while (is_spec_length(*format))
+        {
+            if ('l' == *format)
+                long_num++;
+            format++;
+        }
+
+        word_num = 1;
+        switch (*format)
+        {
+        case '%':
+            continue;
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+        case 'p':
+            if (long_num >= 2)
+            {
+                v.ll = va_arg(ap, long long);
+                word_num = 2;
+            }
+            else
+            {
+                v.w[0] = va_arg(ap, rt_uint32_t);
+            }
+            break;
+#ifdef ULOG_OUTPUT_FLOAT
+        case 'f':
+        case 'e':
+        case 'g':
+            v.d = va_arg(ap, double);
+            word_num = 2;
+            break;
+#endif /* ULOG_OUTPUT_FLOAT */
+        case 's':
+            /* copy string as it may be freed before formatting */
+            s = va_arg(ap, const char *);
+            if (!s)
+                s = "(null)";
+            str_len = rt_strnlen(s, ULOG_LINE_BUF_SIZE);
+            if (len + sizeof(rt_uint32_t) + str_len + 1 > ULOG_DEFERRED_ARGS_MAX)
+                return -1;
+            if (args)
+            {
+                args[len / sizeof(rt_uint32_t)] = str_len;
+                rt_memcpy((char *)args + len + sizeof(rt_uint32_t), s, str_len);
+                ((char *)args)[len + sizeof(rt_uint32_t) + str_len] = '\0';
+            }
+            len += sizeof(rt_uint32_t) + RT_ALIGN(str_len + 1, sizeof(rt_uint32_t));
+            continue;
+        default:
+            return -1;
+        }
+
+        if (len + word_num * sizeof(rt_uint32_t) > ULOG_DEFERRED_ARGS_MAX)
+            return -1;
+        if (args)
+            rt_memcpy((char *)args + len, &v, word_num * sizeof(rt_uint32_t));
+        len += word_num * sizeof(rt_uint32_t);
+    }
+
+    return len;
+}
+
+/*
+ * Save log to async ring without formatting, no lock is taken.
+ * Return RT_FALSE if it should be formatted immediately.
+ */
+static rt_bool_t deferred_output(rt_uint32_t level, const char *tag, rt_bool_t newline, const char *format, va_list args)
+{
+    rt_rbb_blk_t log_blk;
+    ulog_deferred_frame_t frame;
+    va_list ap;
+    int args_len;
+
+#ifdef ULOG_USING_FILTER
+    /* keyword filter needs formatted log */
+    if (ulog.filter.keyword[0] != '\0')
+        return RT_FALSE;
+#endif /* ULOG_USING_FILTER */
+
+    va_copy(ap, args);
+    args_len = deferred_save_args(RT_NULL, format, ap);
+    va_end(ap);
+    if (args_len < 0)
+        return RT_FALSE;
+
+    log_blk = rt_rbb_blk_alloc(ulog.async_rbb, RT_ALIGN(sizeof(struct ulog_deferred_frame) + args_len, RT_ALIGN_SIZE));
+    if (!log_blk)
+    {
+        ulog.loss_cnt++;
+        ulog.loss_bytes += sizeof(struct ulog_deferred_frame) + args_len;
+        return RT_TRUE;
+    }
+
+    frame = (ulog_deferred_frame_t)log_blk->buf;
+    frame->magic = ULOG_DEFERRED_FRAME_MAGIC;
+    frame->newline = newline;
+    frame->is_isr = (rt_interrupt_get_nest() != 0);
+    frame->args_len = args_len;
+    frame->level = level;
+    frame->format = format;
+    frame->tag = tag;
+#ifdef ULOG_OUTPUT_TIME
+    frame->tick = ulog_get_tick();
+#else
+    frame->tick = rt_tick_get();
+#endif
+    if (!frame->is_isr && rt_thread_self())
+        rt_strncpy(frame->thread_name, rt_thread_self()->name, RT_NAME_MAX);
+    else
+        frame->thread_name[0] = '\0';
+    va_copy(ap, args);
+    deferred_save_args(frame->args, format, ap);
+    va_end(ap);
+    rt_rbb_blk_put(log_blk);
+
+#ifdef RT_USING_PM
+    if (!ulog.suspended)
+#endif  /* RT_USING_PM */
+    {
+        rt_sem_release(&ulog.async_notice);
+    }
+
+    return RT_TRUE;
+}
+
+/* Format saved arguments one conversion a time */
+static rt_size_t deferred_format_body(char *buf, rt_size_t size, const char *format, const rt_uint32_t *args)
+{
+    char spec[16];
+    rt_size_t len = 0, spec_len, str_len;
+    const char *start;
+    int long_num;
+    int ret;
+    union
+    {
+        rt_uint32_t w[2];
+        long long ll;
+        double d;
+    } v;
+
+    while (*format && (len < size))
+    {
+        if ('%' != *format)
+        {
+            buf[len++] = *format++;
+            continue;
+        }
+
+        start = format++;
+        while (is_spec_flag(*format))
+            format++;
+        long_num = 0;
+        while (is_spec_length(*format))
+        {
+            if ('l' == *format)
+                long_num++;
+            format++;
+        }
+        if (!*format)
+            break;
+
+        spec_len = format - start + 1;
+        if (spec_len >= sizeof(spec))
+            spec_len = sizeof(spec) - 1;
+        rt_memcpy(spec, start, spec_len);
+        spec[spec_len] = '\0';
+        format++;
+
+        switch (spec[spec_len - 1])
+        {
+        case '%':
+            buf[len++] = '%';
+            continue;
+        case 's':
+            str_len = *args++;
+            ret = rt_snprintf(buf + len, size - len, spec, (const char *)args);
+            args += RT_ALIGN(str_len + 1, sizeof(rt_uint32_t)) / sizeof(rt_uint32_t);
+            break;
+#ifdef ULOG_OUTPUT_FLOAT
+        case 'f':
+        case 'e':
+        case 'g':
+            rt_memcpy(&v, args, sizeof(double));
+            args += 2;
+            ret = snprintf(buf + len, size - len, spec, v.d);
+            break;
+#endif /* ULOG_OUTPUT_FLOAT */
+        default:
+            if (long_num >= 2)
+            {
+                rt_memcpy(&v, args, sizeof(long long));
+                args += 2;
+                ret = rt_snprintf(buf + len, size - len, spec, v.ll);
+            }
+            else
+            {
+                ret = rt_snprintf(buf + len, size - len, spec, *args++);
+            }
+            break;
+        }
+
+        if (ret > 0)
+            len += ret;
+    }
+
+    return (len < size) ? len : size;
+}
+
+static rt_size_t deferred_formater(char *log_buf, rt_uint32_t level, const char *tag, rt_bool_t newline,
+                                   const char *format, ...)
+{
+    va_list args;
+    rt_size_t log_len;
+
+    va_start(args, format);
+#ifndef ULOG_USING_SYSLOG
+    log_len = ulog_formater(log_buf, level, tag, newline, format, args);
+#else
+    extern rt_size_t syslog_formater(char *log_buf, rt_uint8_t level, const char *tag, rt_bool_t newline, const char *format, va_list args);
+    log_len = syslog_formater(log_buf, level, tag, newline, format, args);
+#endif /* ULOG_USING_SYSLOG */
+    va_end(args);
+
+    return log_len;
+}
+
+static void deferred_frame_output(ulog_deferred_frame_t frame)
+{
+    rt_size_t log_len;
+
+    /* formatter uses static variables */
+    output_lock();
+    ulog.deferred = frame;
+    log_len = deferred_format_body(ulog.deferred_body, ULOG_LINE_BUF_SIZE, frame->format, frame->args);
+    ulog.deferred_body[log_len] = '\0';
+    log_len = deferred_formater(ulog.log_buf_deferred, frame->level, frame->tag, frame->newline, "%s", ulog.deferred_body);
+    ulog.deferred = RT_NULL;
+    output_unlock();
+
+    ulog_output_to_all_backend(frame->level, frame->tag, RT_FALSE, ulog.log_buf_deferred, log_len);
+}
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 /**
  * output the log by variable argument list
  *
@@ -546,6 +894,13 @@ __ROM_USED void ulog_voutput(rt_uint32_t level, const char *tag, rt_bool_t newli
     }
 #endif /* ULOG_USING_FILTER */
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    if (deferred_output(level, tag, newline, format, args))
+    {
+        return;
+    }
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
     /* get log buffer */
     log_buf = get_log_buf();
 
@@ -1239,9 +1594,17 @@ __ROM_USED void ulog_async_output(void)
 {
     rt_rbb_blk_t log_blk;
     ulog_frame_t log_frame;
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    rt_slist_t *node;
+    ulog_backend_t backend;
+    rt_bool_t has_log = RT_FALSE;
+#endif /* ULOG_USING_DEFERRED_FORMAT */
 
     while ((log_blk = rt_rbb_blk_get(ulog.async_rbb)) != NULL)
     {
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        has_log = RT_TRUE;
+#endif /* ULOG_USING_DEFERRED_FORMAT */
         log_frame = (ulog_frame_t) log_blk->buf;
         if (log_frame->magic == ULOG_FRAME_MAGIC)
         {
@@ -1249,6 +1612,12 @@ __ROM_USED void ulog_async_output(void)
             ulog_output_to_all_backend(log_frame->level, log_frame->tag, log_frame->is_raw, log_frame->log,
                                        log_frame->log_len);
         }
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        else if (log_frame->magic == ULOG_DEFERRED_FRAME_MAGIC)
+        {
+            deferred_frame_output((ulog_deferred_frame_t)log_blk->buf);
+        }
+#endif /* ULOG_USING_DEFERRED_FORMAT */
         rt_rbb_blk_free(ulog.async_rbb, log_blk);
     }
 
@@ -1294,6 +1663,18 @@ __ROM_USED void ulog_async_output(void)
             }
         }
     }
+
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    /* end of batch, backends may write out coalesced output, e.g. console DMA */
+    for (node = rt_slist_first(&ulog.backend_list); has_log && node; node = rt_slist_next(node))
+    {
+        backend = rt_slist_entry(node, struct ulog_backend, list);
+        if (backend->flush)
+        {
+            backend->flush(backend);
+        }
+    }
+#endif /* ULOG_USING_DEFERRED_FORMAT */
 }
 
 /**
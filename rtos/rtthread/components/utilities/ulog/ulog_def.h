@@ -186,6 +186,7 @@ extern "C" {
 #endif
 
 #define ULOG_FRAME_MAGIC               0x10
+#define ULOG_DEFERRED_FRAME_MAGIC      0x11
 
 /* tag's level filter */
 struct ulog_tag_lvl_filter
@@ -0,0 +1,523 @@
+/*
+ * COPYRIGHT (C) 2012, Real-Thread Information Technology Ltd
+ * All rights reserved
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Receive files to and send files from DFS by YMODEM.
+ *
+ * File I/O is done by a worker thread through RYM_DFS_BUF_NUM buffers, so that
+ * packets keep coming while the previous buffer is written to or read from
+ * flash. Buffers are handed to worker in turn and it serves them in order,
+ * buffer is reused once as many 'done' as its pending requests are taken.
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include "ymodem.h"
+
+#ifdef RT_USING_DFS
+#include <dfs_posix.h>
+
+#ifndef RYM_DFS_BUF_SIZE
+#define RYM_DFS_BUF_SIZE    (8 * 1024)
+#endif
+
+#ifndef RYM_DFS_BUF_NUM
+#define RYM_DFS_BUF_NUM     2
+#endif
+
+#ifndef RYM_DFS_THREAD_STACK
+#define RYM_DFS_THREAD_STACK 2048
+#endif
+
+#if RYM_DFS_BUF_NUM < 2
+#error "RYM_DFS_BUF_NUM must be at least 2"
+#endif
+
+enum rym_io_op
+{
+    RYM_IO_WRITE,
+    RYM_IO_READ,
+    RYM_IO_CLOSE,
+    RYM_IO_QUIT,
+};
+
+struct rym_io_req
+{
+    rt_uint8_t op;
+    rt_uint8_t idx;
+    int fd;
+    rt_size_t len;
+};
+
+struct rym_dfs_ctx
+{
+    /* must be first, callbacks get it as ctx */
+    struct rym_ctx parent;
+
+    rt_uint8_t *buf[RYM_DFS_BUF_NUM];
+    rt_int32_t blen[RYM_DFS_BUF_NUM];   /* bytes read in buffer */
+    rt_size_t pos;                      /* bytes filled or used in current buffer */
+    rt_uint8_t cur;
+    rt_uint8_t pending;                 /* buffer requests not done */
+    rt_mq_t mq;
+    struct rt_semaphore done;
+    rt_err_t io_err;
+
+    int fd;
+    rt_int32_t flen;                    /* bytes left, -1 if sender gives no size */
+    const char *dir;
+    char **paths;
+    int path_num;
+    int path_idx;
+
+    rt_uint32_t files;
+    rt_uint32_t bytes;
+    rt_tick_t wait_tick;                /* time protocol waits for I/O */
+    char path[DFS_PATH_MAX];
+};
+
+static void rym_io_entry(void *param)
+{
+    struct rym_dfs_ctx *ctx = (struct rym_dfs_ctx *)param;
+    struct rym_io_req req;
+    int len;
+
+    while (rt_mq_recv(ctx->mq, &req, sizeof(req), RT_WAITING_FOREVER) == RT_EOK)
+    {
+        switch (req.op)
+        {
+        case RYM_IO_WRITE:
+            len = write(req.fd, ctx->buf[req.idx], req.len);
+            if (len != (int)req.len)
+                ctx->io_err = -RT_EIO;
+            break;
+        case RYM_IO_READ:
+            len = read(req.fd, ctx->buf[req.idx], req.len);
+            ctx->blen[req.idx] = len;
+            if (len < 0)
+                ctx->io_err = -RT_EIO;
+            break;
+        case RYM_IO_CLOSE:
+            close(req.fd);
+            /* no buffer, nothing to wait for */
+            continue;
+        default:
+            rt_sem_release(&ctx->done);
+            return;
+        }
+        rt_sem_release(&ctx->done);
+    }
+}
+
+static void rym_io_wait(struct rym_dfs_ctx *ctx)
+{
+    rt_tick_t start = rt_tick_get();
+
+    rt_sem_take(&ctx->done, RT_WAITING_FOREVER);
+    ctx->pending--;
+    ctx->wait_tick += rt_tick_get() - start;
+}
+
+static void rym_io_post(struct rym_dfs_ctx *ctx, rt_uint8_t op, rt_uint8_t idx, rt_size_t len)
+{
+    struct rym_io_req req;
+
+    req.op = op;
+    req.idx = idx;
+    req.fd = ctx->fd;
+    req.len = len;
+    /* queue holds every buffer and a few closes, full only for a moment */
+    while (rt_mq_send(ctx->mq, &req, sizeof(req)) == -RT_EFULL)
+        rt_thread_mdelay(1);
+    if (op == RYM_IO_WRITE || op == RYM_IO_READ)
+        ctx->pending++;
+}
+
+static void rym_io_drain(struct rym_dfs_ctx *ctx)
+{
+    while (ctx->pending)
+        rym_io_wait(ctx);
+}
+
+static rt_err_t rym_io_start(struct rym_dfs_ctx *ctx)
+{
+    rt_thread_t tid;
+    int i;
+
+    for (i = 0; i < RYM_DFS_BUF_NUM; i++)
+    {
+        ctx->buf[i] = rt_malloc(RYM_DFS_BUF_SIZE);
+        if (!ctx->buf[i])
+            return -RT_ENOMEM;
+    }
+
+    ctx->fd = -1;
+    /* below protocol thread, which must drain the UART first */
+    tid = rt_thread_create("rymio", rym_io_entry, ctx, RYM_DFS_THREAD_STACK,
+                           rt_thread_self()->current_priority + 1, 10);
+    if (!tid)
+        return -RT_ENOMEM;
+
+    ctx->mq = rt_mq_create("rymio", sizeof(struct rym_io_req), RYM_DFS_BUF_NUM + 4, RT_IPC_FLAG_FIFO);
+    if (!ctx->mq)
+    {
+        rt_thread_delete(tid);
+        return -RT_ENOMEM;
+    }
+    rt_sem_init(&ctx->done, "rymio", 0, RT_IPC_FLAG_FIFO);
+    rt_thread_startup(tid);
+
+    return RT_EOK;
+}
+
+static void rym_io_stop(struct rym_dfs_ctx *ctx)
+{
+    int i;
+
+    if (ctx->mq)
+    {
+        rym_io_drain(ctx);
+        if (ctx->fd >= 0)
+            rym_io_post(ctx, RYM_IO_CLOSE, 0, 0);
+        rym_io_post(ctx, RYM_IO_QUIT, 0, 0);
+        rt_sem_take(&ctx->done, RT_WAITING_FOREVER);
+        rt_mq_delete(ctx->mq);
+        rt_sem_detach(&ctx->done);
+    }
+
+    for (i = 0; i < RYM_DFS_BUF_NUM; i++)
+    {
+        if (ctx->buf[i])
+            rt_free(ctx->buf[i]);
+    }
+}
+
+/* hand current buffer to worker and switch to next, waiting until it is free */
+static void rym_io_flush(struct rym_dfs_ctx *ctx)
+{
+    if (ctx->pos == 0)
+        return;
+
+    rym_io_post(ctx, RYM_IO_WRITE, ctx->cur, ctx->pos);
+    ctx->cur = (ctx->cur + 1) % RYM_DFS_BUF_NUM;
+    ctx->pos = 0;
+    if (ctx->pending == RYM_DFS_BUF_NUM)
+        rym_io_wait(ctx);
+}
+
+static enum rym_code _rym_recv_begin(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+    const char *name = (const char *)buf;
+    const char *base = strrchr(name, '/');
+
+    /* never print here, console may be the line */
+    base = base ? base + 1 : name;
+    rt_snprintf(cctx->path, sizeof(cctx->path), "%s/%s", cctx->dir, base);
+    cctx->fd = open(cctx->path, O_CREAT | O_WRONLY | O_TRUNC, 0);
+    if (cctx->fd < 0)
+        return RYM_CODE_CAN;
+
+    cctx->flen = atoi(name + strlen(name) + 1);
+    if (cctx->flen == 0)
+        cctx->flen = -1;
+    cctx->pos = 0;
+
+    return RYM_CODE_ACK;
+}
+
+static enum rym_code _rym_recv_data(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+    rt_size_t n;
+
+    if (cctx->io_err)
+        return RYM_CODE_CAN;
+
+    /* padding of last packet is dropped if size is known */
+    if (cctx->flen >= 0 && len > (rt_size_t)cctx->flen)
+        len = cctx->flen;
+    if (cctx->flen > 0)
+        cctx->flen -= len;
+    cctx->bytes += len;
+
+    while (len)
+    {
+        n = RYM_DFS_BUF_SIZE - cctx->pos;
+        if (n > len)
+            n = len;
+        memcpy(cctx->buf[cctx->cur] + cctx->pos, buf, n);
+        cctx->pos += n;
+        buf += n;
+        len -= n;
+        if (cctx->pos == RYM_DFS_BUF_SIZE)
+            rym_io_flush(cctx);
+    }
+
+    return RYM_CODE_ACK;
+}
+
+static enum rym_code _rym_recv_end(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+
+    if (cctx->fd < 0)
+        return RYM_CODE_ACK;
+
+    rym_io_flush(cctx);
+    rym_io_post(cctx, RYM_IO_CLOSE, 0, 0);
+    cctx->fd = -1;
+    cctx->files++;
+
+    return RYM_CODE_ACK;
+}
+
+static rt_err_t rym_report(struct rym_dfs_ctx *ctx, const char *what, rt_err_t res, rt_tick_t start)
+{
+    rt_tick_t used = rt_tick_get() - start;
+
+    if (res == RT_EOK && ctx->io_err)
+        res = ctx->io_err;
+    rt_kprintf("%s %d files, %d bytes in %d ms, %d KB/s, io wait %d ms, result %d\n", what,
+               ctx->files, ctx->bytes, used * 1000 / RT_TICK_PER_SECOND,
+               used ? (rt_uint32_t)((rt_uint64_t)ctx->bytes * RT_TICK_PER_SECOND / used / 1024) : 0,
+               ctx->wait_tick * 1000 / RT_TICK_PER_SECOND, res);
+
+    return res;
+}
+
+rt_err_t rym_recv_to_dir(rt_device_t dev, const char *dir, enum rym_code hs_code)
+{
+    struct rym_dfs_ctx *ctx;
+    rt_err_t res;
+    rt_tick_t start;
+
+    ctx = rt_calloc(1, sizeof(*ctx));
+    if (!ctx)
+        return -RT_ENOMEM;
+    ctx->dir = dir;
+
+    res = rym_io_start(ctx);
+    if (res == RT_EOK)
+    {
+        start = rt_tick_get();
+        res = rym_recv_on_device_ex(&ctx->parent, dev, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_DMA_RX,
+                                    hs_code, _rym_recv_begin, _rym_recv_data, _rym_recv_end, 100);
+        /* file of failed session is kept up to the last good packet */
+        if (ctx->fd >= 0)
+            rym_io_flush(ctx);
+        rym_io_stop(ctx);
+        res = rym_report(ctx, "received", res, start);
+    }
+    else
+    {
+        rym_io_stop(ctx);
+    }
+    rt_free(ctx);
+
+    return res;
+}
+
+static void rym_send_close(struct rym_dfs_ctx *ctx)
+{
+    rym_io_drain(ctx);
+    if (ctx->fd >= 0)
+        rym_io_post(ctx, RYM_IO_CLOSE, 0, 0);
+    ctx->fd = -1;
+}
+
+static enum rym_code _rym_send_begin(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+    struct stat st;
+    const char *path, *base;
+    int i;
+
+    /* skip files which can't be opened, e.g. logger rotating them */
+    while (cctx->path_idx < cctx->path_num)
+    {
+        path = cctx->paths[cctx->path_idx++];
+        if (stat(path, &st) < 0 || S_ISDIR(st.st_mode))
+            continue;
+        cctx->fd = open(path, O_RDONLY, 0);
+        if (cctx->fd < 0)
+            continue;
+
+        base = strrchr(path, '/');
+        base = base ? base + 1 : path;
+        rt_snprintf((char *)buf, len - 12, "%s", base);
+        rt_snprintf((char *)buf + strlen((char *)buf) + 1, 12, "%d", (int)st.st_size);
+
+        /* prefetch first buffers while packet 0 is on the line */
+        cctx->cur = 0;
+        cctx->pos = 0;
+        for (i = 0; i < RYM_DFS_BUF_NUM; i++)
+            rym_io_post(cctx, RYM_IO_READ, i, RYM_DFS_BUF_SIZE);
+        rym_io_wait(cctx);
+
+        return RYM_CODE_ACK;
+    }
+
+    return RYM_CODE_EOT;
+}
+
+static enum rym_code _rym_send_data(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+    rt_int32_t avail = cctx->blen[cctx->cur] - (rt_int32_t)cctx->pos;
+
+    if (cctx->io_err)
+        return RYM_CODE_CAN;
+
+    if (avail <= 0)
+    {
+        /* short read is end of file */
+        if (cctx->blen[cctx->cur] < RYM_DFS_BUF_SIZE)
+            return RYM_CODE_EOT;
+
+        /* refill used buffer, next one is the oldest request */
+        rym_io_post(cctx, RYM_IO_READ, cctx->cur, RYM_DFS_BUF_SIZE);
+        cctx->cur = (cctx->cur + 1) % RYM_DFS_BUF_NUM;
+        cctx->pos = 0;
+        rym_io_wait(cctx);
+        if (cctx->io_err)
+            return RYM_CODE_CAN;
+        avail = cctx->blen[cctx->cur];
+        if (avail <= 0)
+            return RYM_CODE_EOT;
+    }
+
+    if ((rt_size_t)avail > len)
+        avail = len;
+    memcpy(buf, cctx->buf[cctx->cur] + cctx->pos, avail);
+    cctx->pos += avail;
+    cctx->bytes += avail;
+    ctx->len = avail;
+
+    return RYM_CODE_ACK;
+}
+
+static enum rym_code _rym_send_end(
+    struct rym_ctx *ctx,
+    rt_uint8_t *buf,
+    rt_size_t len)
+{
+    struct rym_dfs_ctx *cctx = (struct rym_dfs_ctx *)ctx;
+
+    rym_send_close(cctx);
+    cctx->files++;
+
+    return RYM_CODE_ACK;
+}
+
+rt_err_t rym_send_files(rt_device_t dev, char **paths, int num)
+{
+    struct rym_dfs_ctx *ctx;
+    rt_err_t res;
+    rt_tick_t start;
+
+    ctx = rt_calloc(1, sizeof(*ctx));
+    if (!ctx)
+        return -RT_ENOMEM;
+    ctx->paths = paths;
+    ctx->path_num = num;
+
+    res = rym_io_start(ctx);
+    if (res == RT_EOK)
+    {
+        start = rt_tick_get();
+        res = rym_send_on_device(&ctx->parent, dev, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_DMA_RX,
+                                 _rym_send_begin, _rym_send_data, _rym_send_end, 100);
+        rym_send_close(ctx);
+        rym_io_stop(ctx);
+        res = rym_report(ctx, "sent", res, start);
+    }
+    else
+    {
+        rym_io_stop(ctx);
+    }
+    rt_free(ctx);
+
+    return res;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+#include <shell.h>
+
+static rt_device_t rym_get_device(int *argc, char ***argv)
+{
+    const char *name = finsh_get_device();
+    rt_device_t dev;
+
+    if (*argc > 2 && 0 == strcmp((*argv)[1], "-d"))
+    {
+        name = (*argv)[2];
+        *argc -= 2;
+        *argv += 2;
+    }
+    dev = rt_device_find(name);
+    if (!dev)
+        rt_kprintf("could not find device %s\n", name);
+
+    return dev;
+}
+
+static int rym_rx(int argc, char **argv)
+{
+    enum rym_code hs_code = RYM_CODE_C;
+    rt_device_t dev;
+
+    dev = rym_get_device(&argc, &argv);
+    if (!dev)
+        return -RT_ERROR;
+    if (argc > 1 && 0 == strcmp(argv[1], "-g"))
+    {
+        hs_code = RYM_CODE_G;
+        argc--;
+        argv++;
+    }
+
+    return rym_recv_to_dir(dev, argc > 1 ? argv[1] : "", hs_code);
+}
+MSH_CMD_EXPORT(rym_rx, rym_rx [-d dev] [-g] [dir]: receive files by YMODEM-1K or YMODEM-G);
+
+static int rym_tx(int argc, char **argv)
+{
+    rt_device_t dev;
+
+    dev = rym_get_device(&argc, &argv);
+    if (!dev)
+        return -RT_ERROR;
+    if (argc < 2)
+    {
+        rt_kprintf("usage: rym_tx [-d dev] file...\n");
+        return -RT_EINVAL;
+    }
+
+    return rym_send_files(dev, argv + 1, argc - 1);
+}
+MSH_CMD_EXPORT(rym_tx, rym_tx [-d dev] file...: send files by YMODEM-1K or YMODEM-G);
+#endif /* RT_USING_FINSH */
+
+#endif /* RT_USING_DFS */
@@ -11,6 +11,9 @@
 
 #include <rthw.h>
 #include "ymodem.h"
+#ifdef BSP_USING_HW_CRC
+    #include "drv_crc.h"
+#endif
 
 static const rt_uint16_t ccitt_table[256] = {
     0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
@@ -48,11 +51,16 @@ static const rt_uint16_t ccitt_table[256] = {
 };
 rt_uint16_t CRC16(unsigned char *q, int len)
 {
+#ifdef BSP_USING_HW_CRC
+    /* CRC-16/XMODEM, engine is fed by DMA for 1K packets */
+    return (rt_uint16_t)drv_crc_calc(CRC_16_XMODEM, q, len);
+#else
     rt_uint16_t crc = 0;
 
     while (len-- > 0)
         crc = (crc << 8) ^ ccitt_table[((crc >> 8) ^ *q++) & 0xff];
     return crc;
+#endif
 }
 
 // we could only use global varible because we could not use
@@ -68,13 +76,16 @@ static rt_err_t _rym_rx_ind(rt_device_t dev, rt_size_t size)
 #define _RYM_SOH_PKG_SZ (1+2+128+2)
 #define _RYM_STX_PKG_SZ (1+2+1024+2)
 
+/* code is not read into ctx->buf, sender keeps the packet there for resend */
 static enum rym_code _rym_read_code(
         struct rym_ctx *ctx,
         rt_tick_t timeout)
 {
+    rt_uint8_t code;
+
     /* Fast path */
-    if (rt_device_read(ctx->dev, 0, ctx->buf, 1) == 1)
-        return (enum rym_code)(*ctx->buf);
+    if (rt_device_read(ctx->dev, 0, &code, 1) == 1)
+        return (enum rym_code)code;
 
     /* Slow path */
     do {
@@ -85,9 +96,9 @@ static enum rym_code _rym_read_code(
             return RYM_CODE_NONE;
 
         /* Try to read one */
-        rsz = rt_device_read(ctx->dev, 0, ctx->buf, 1);
+        rsz = rt_device_read(ctx->dev, 0, &code, 1);
         if (rsz == 1)
-            return (enum rym_code)(*ctx->buf);
+            return (enum rym_code)code;
     } while (1);
 }
 
@@ -117,6 +128,15 @@ static rt_size_t _rym_putchar(struct rym_ctx *ctx, rt_uint8_t code)
     return 1;
 }
 
+static void _rym_send_can(struct rym_ctx *ctx)
+{
+    rt_size_t i;
+
+    /* the spec require multiple CAN */
+    for (i = 0; i < RYM_END_SESSION_SEND_CAN_NUM; i++)
+        _rym_putchar(ctx, RYM_CODE_CAN);
+}
+
 static rt_err_t _rym_do_handshake(
         struct rym_ctx *ctx,
         int tm_sec)
@@ -131,7 +151,7 @@ static rt_err_t _rym_do_handshake(
     /* send C every second, so the sender could know we are waiting for it. */
     for (i = 0; i < tm_sec; i++)
     {
-        _rym_putchar(ctx, RYM_CODE_C);
+        _rym_putchar(ctx, ctx->hs_code);
         code = _rym_read_code(ctx,
                 RYM_CHD_INTV_TICK);
         if (code == RYM_CODE_SOH)
@@ -225,14 +245,14 @@ static rt_err_t _rym_trans_data(
 static rt_err_t _rym_do_trans(struct rym_ctx *ctx)
 {
     _rym_putchar(ctx, RYM_CODE_ACK);
-    _rym_putchar(ctx, RYM_CODE_C);
+    _rym_putchar(ctx, ctx->hs_code);
     ctx->stage = RYM_STAGE_ESTABLISHED;
 
     while (1)
     {
         rt_err_t err;
         enum rym_code code;
-        rt_size_t data_sz, i;
+        rt_size_t data_sz;
 
         code = _rym_read_code(ctx,
                 RYM_WAIT_PKG_TICK);
@@ -256,13 +276,12 @@ static rt_err_t _rym_do_trans(struct rym_ctx *ctx)
         switch (code)
         {
         case RYM_CODE_CAN:
-            /* the spec require multiple CAN */
-            for (i = 0; i < RYM_END_SESSION_SEND_CAN_NUM; i++) {
-                _rym_putchar(ctx, RYM_CODE_CAN);
-            }
+            _rym_send_can(ctx);
             return -RYM_ERR_CAN;
         case RYM_CODE_ACK:
-            _rym_putchar(ctx, RYM_CODE_ACK);
+            /* YMODEM-G sender streams data packets without waiting for ACK */
+            if (ctx->hs_code != RYM_CODE_G)
+                _rym_putchar(ctx, RYM_CODE_ACK);
             break;
         default:
             // wrong code
@@ -284,13 +303,17 @@ static rt_err_t _rym_do_fin(struct rym_ctx *ctx)
     if (ctx->on_end)
         ctx->on_end(ctx, ctx->buf+3, 128);
 
-    _rym_putchar(ctx, RYM_CODE_NAK);
-    code = _rym_read_code(ctx, RYM_WAIT_PKG_TICK);
-    if (code != RYM_CODE_EOT)
-        return -RYM_ERR_CODE;
+    /* YMODEM-G sender sends EOT only once */
+    if (ctx->hs_code != RYM_CODE_G)
+    {
+        _rym_putchar(ctx, RYM_CODE_NAK);
+        code = _rym_read_code(ctx, RYM_WAIT_PKG_TICK);
+        if (code != RYM_CODE_EOT)
+            return -RYM_ERR_CODE;
+    }
 
     _rym_putchar(ctx, RYM_CODE_ACK);
-    _rym_putchar(ctx, RYM_CODE_C);
+    _rym_putchar(ctx, ctx->hs_code);
 
     code = _rym_read_code(ctx, RYM_WAIT_PKG_TICK);
     if (code == RYM_CODE_SOH)
@@ -304,8 +327,9 @@ static rt_err_t _rym_do_fin(struct rym_ctx *ctx)
     else
         return -RYM_ERR_CODE;
 
-    i = _rym_read_data(ctx, _RYM_SOH_PKG_SZ-1);
-    if (i != (_RYM_SOH_PKG_SZ-1))
+    /* header of next file may be a 1K packet */
+    i = _rym_read_data(ctx, data_sz-1);
+    if (i != (data_sz-1))
         return -RYM_ERR_DSZ;
 
     /* sanity check
@@ -313,8 +337,8 @@ static rt_err_t _rym_do_fin(struct rym_ctx *ctx)
     if (ctx->buf[1] != 0 || ctx->buf[2] != 0xFF)
         return -RYM_ERR_SEQ;
 
-    recv_crc = (rt_uint16_t)(*(ctx->buf+_RYM_SOH_PKG_SZ-2) << 8) | *(ctx->buf+_RYM_SOH_PKG_SZ-1);
-    if (recv_crc != CRC16(ctx->buf+3, _RYM_SOH_PKG_SZ-5))
+    recv_crc = (rt_uint16_t)(*(ctx->buf+data_sz-2) << 8) | *(ctx->buf+data_sz-1);
+    if (recv_crc != CRC16(ctx->buf+3, data_sz-5))
         return -RYM_ERR_CRC;
 
     /*next file transmission*/
@@ -353,25 +377,207 @@ static rt_err_t _rym_do_recv(
     {
         err = _rym_do_trans(ctx);
         if (err != RT_EOK)
-            return err;
+            break;
 
         err = _rym_do_fin(ctx);
         if (err != RT_EOK)
-            return err;
+            break;
         if (ctx->stage == RYM_STAGE_FINISHED)
             break;
     }
+
+    /* YMODEM-G has no retransmission, stop the sender instead of letting it
+     * stream into a dead session. CAN is already sent in that case. */
+    if (err != RT_EOK && err != -RYM_ERR_CAN && ctx->hs_code == RYM_CODE_G)
+        _rym_send_can(ctx);
+
     return err;
 }
 
-rt_err_t rym_recv_on_device(
+/* wait for C or G from receiver, which also tells the mode */
+static rt_err_t _rym_wait_start(
+        struct rym_ctx *ctx,
+        int tm)
+{
+    enum rym_code code;
+    int i;
+
+    for (i = 0; i < tm; i++)
+    {
+        code = _rym_read_code(ctx, RYM_CHD_INTV_TICK);
+        if (code == RYM_CODE_C || code == RYM_CODE_G)
+        {
+            rt_uint8_t c;
+
+            /* drop C repeated while we were not ready, it would be taken as NAK */
+            while (rt_device_read(ctx->dev, 0, &c, 1) == 1)
+                ;
+            ctx->hs_code = code;
+            return RT_EOK;
+        }
+        if (code == RYM_CODE_CAN)
+            return -RYM_ERR_CAN;
+    }
+
+    return -RYM_ERR_TMO;
+}
+
+/* CAN is the only code a YMODEM-G receiver sends while data is streaming */
+static rt_err_t _rym_check_can(struct rym_ctx *ctx)
+{
+    rt_uint8_t code;
+
+    while (rt_device_read(ctx->dev, 0, &code, 1) == 1)
+    {
+        if (code == RYM_CODE_CAN)
+            return -RYM_ERR_CAN;
+    }
+
+    return RT_EOK;
+}
+
+/* send packet in ctx->buf until it is acknowledged */
+static rt_err_t _rym_send_pkg(
+        struct rym_ctx *ctx,
+        enum rym_code code,
+        rt_uint8_t seq,
+        rt_size_t data_sz,
+        rt_bool_t stream)
+{
+    rt_uint16_t crc;
+    rt_size_t i;
+
+    crc = CRC16(ctx->buf+3, data_sz);
+    ctx->buf[0] = code;
+    ctx->buf[1] = seq;
+    ctx->buf[2] = 0xFF - seq;
+    ctx->buf[3+data_sz] = (rt_uint8_t)(crc >> 8);
+    ctx->buf[4+data_sz] = (rt_uint8_t)crc;
+
+    for (i = 0; i < RYM_MAX_RETRY; i++)
+    {
+        rt_device_write(ctx->dev, 0, ctx->buf, data_sz + 5);
+        if (stream)
+            return _rym_check_can(ctx);
+
+        code = _rym_read_code(ctx, RYM_WAIT_PKG_TICK);
+        if (code == RYM_CODE_ACK)
+            return RT_EOK;
+        if (code == RYM_CODE_CAN)
+            return -RYM_ERR_CAN;
+        /* NAK, timeout or C left from handshake, send again */
+    }
+
+    return -RYM_ERR_TMO;
+}
+
+static rt_err_t _rym_send_eot(struct rym_ctx *ctx)
+{
+    enum rym_code code;
+    rt_size_t i;
+
+    /* YMODEM receiver NAKs the first EOT, YMODEM-G one ACKs it at once */
+    for (i = 0; i < RYM_MAX_RETRY; i++)
+    {
+        _rym_putchar(ctx, RYM_CODE_EOT);
+        code = _rym_read_code(ctx, RYM_WAIT_PKG_TICK);
+        if (code == RYM_CODE_ACK)
+            return RT_EOK;
+        if (code == RYM_CODE_CAN)
+            return -RYM_ERR_CAN;
+    }
+
+    return -RYM_ERR_TMO;
+}
+
+static rt_err_t _rym_do_send(
+        struct rym_ctx *ctx,
+        int handshake_timeout)
+{
+    rt_err_t err;
+    enum rym_code code;
+    rt_uint8_t seq;
+
+    ctx->stage = RYM_STAGE_NONE;
+
+    ctx->buf = rt_malloc(_RYM_STX_PKG_SZ);
+    if (ctx->buf == RT_NULL)
+        return -RT_ENOMEM;
+
+    ctx->stage = RYM_STAGE_ESTABLISHING;
+    err = _rym_wait_start(ctx, handshake_timeout);
+    if (err != RT_EOK)
+        return err;
+
+    while (1)
+    {
+        /* packet 0 is file name and size, empty name ends the batch */
+        rt_memset(ctx->buf+3, 0, 128);
+        code = ctx->on_begin ? ctx->on_begin(ctx, ctx->buf+3, 128) : RYM_CODE_EOT;
+        if (code == RYM_CODE_CAN)
+        {
+            _rym_send_can(ctx);
+            return -RYM_ERR_CAN;
+        }
+        if (code != RYM_CODE_ACK)
+            break;
+
+        err = _rym_send_pkg(ctx, RYM_CODE_SOH, 0, 128, RT_FALSE);
+        if (err != RT_EOK)
+            return err;
+        ctx->stage = RYM_STAGE_ESTABLISHED;
+
+        err = _rym_wait_start(ctx, 1);
+        if (err != RT_EOK)
+            return err;
+        ctx->stage = RYM_STAGE_TRANSMITTING;
+
+        for (seq = 1; ; seq++)
+        {
+            ctx->len = 0;
+            code = ctx->on_data ? ctx->on_data(ctx, ctx->buf+3, 1024) : RYM_CODE_EOT;
+            if (code == RYM_CODE_CAN)
+            {
+                _rym_send_can(ctx);
+                return -RYM_ERR_CAN;
+            }
+            if (code == RYM_CODE_EOT || ctx->len == 0)
+                break;
+            RT_ASSERT(ctx->len <= 1024);
+
+            /* pad last packet with CPMEOF */
+            rt_memset(ctx->buf+3+ctx->len, 0x1A, 1024 - ctx->len);
+            err = _rym_send_pkg(ctx, RYM_CODE_STX, seq, 1024, ctx->hs_code == RYM_CODE_G);
+            if (err != RT_EOK)
+                return err;
+        }
+
+        ctx->stage = RYM_STAGE_FINISHING;
+        err = _rym_send_eot(ctx);
+        if (ctx->on_end)
+            ctx->on_end(ctx, ctx->buf+3, 128);
+        if (err != RT_EOK)
+            return err;
+
+        err = _rym_wait_start(ctx, 1);
+        if (err != RT_EOK)
+            return err;
+    }
+
+    rt_memset(ctx->buf+3, 0, 128);
+    err = _rym_send_pkg(ctx, RYM_CODE_SOH, 0, 128, RT_FALSE);
+    if (err == RT_EOK)
+        ctx->stage = RYM_STAGE_FINISHED;
+
+    return err;
+}
+
+static rt_err_t _rym_run_on_device(
         struct rym_ctx *ctx,
         rt_device_t dev,
         rt_uint16_t oflag,
-        rym_callback on_begin,
-        rym_callback on_data,
-        rym_callback on_end,
-        int handshake_timeout)
+        int handshake_timeout,
+        rt_err_t (*proc)(struct rym_ctx *ctx, int handshake_timeout))
 {
     rt_err_t res;
     rt_err_t (*odev_rx_ind)(rt_device_t dev, rt_size_t size);
@@ -381,11 +587,9 @@ rt_err_t rym_recv_on_device(
     RT_ASSERT(_rym_the_ctx == 0);
     _rym_the_ctx = ctx;
 
-    ctx->on_begin = on_begin;
-    ctx->on_data  = on_data;
-    ctx->on_end   = on_end;
     ctx->dev      = dev;
     ctx->buf      = NULL;
+    ctx->len      = 0;
     rt_sem_init(&ctx->sem, "rymsem", 0, RT_IPC_FLAG_FIFO);
 
     odev_rx_ind = dev->rx_indicate;
@@ -403,7 +607,7 @@ rt_err_t rym_recv_on_device(
     if (res != RT_EOK)
         goto __exit;
 
-    res = _rym_do_recv(ctx, handshake_timeout);
+    res = proc(ctx, handshake_timeout);
 
     rt_device_close(dev);
 
@@ -419,7 +623,58 @@ __exit:
 
     if (ctx->buf)
         rt_free(ctx->buf);
+    ctx->buf = RT_NULL;
     _rym_the_ctx = RT_NULL;
 
     return res;
 }
+
+rt_err_t rym_recv_on_device_ex(
+        struct rym_ctx *ctx,
+        rt_device_t dev,
+        rt_uint16_t oflag,
+        enum rym_code hs_code,
+        rym_callback on_begin,
+        rym_callback on_data,
+        rym_callback on_end,
+        int handshake_timeout)
+{
+    RT_ASSERT(hs_code == RYM_CODE_C || hs_code == RYM_CODE_G);
+
+    ctx->on_begin = on_begin;
+    ctx->on_data  = on_data;
+    ctx->on_end   = on_end;
+    ctx->hs_code  = hs_code;
+
+    return _rym_run_on_device(ctx, dev, oflag, handshake_timeout, _rym_do_recv);
+}
+
+rt_err_t rym_recv_on_device(
+        struct rym_ctx *ctx,
+        rt_device_t dev,
+        rt_uint16_t oflag,
+        rym_callback on_begin,
+        rym_callback on_data,
+        rym_callback on_end,
+        int handshake_timeout)
+{
+    return rym_recv_on_device_ex(ctx, dev, oflag, RYM_CODE_C,
+            on_begin, on_data, on_end, handshake_timeout);
+}
+
+rt_err_t rym_send_on_device(
+        struct rym_ctx *ctx,
+        rt_device_t dev,
+        rt_uint16_t oflag,
+        rym_callback on_begin,
+        rym_callback on_data,
+        rym_callback on_end,
+        int handshake_timeout)
+{
+    ctx->on_begin = on_begin;
+    ctx->on_data  = on_data;
+    ctx->on_end   = on_end;
+    ctx->hs_code  = RYM_CODE_NONE;
+
+    return _rym_run_on_device(ctx, dev, oflag, handshake_timeout, _rym_do_send);
+}
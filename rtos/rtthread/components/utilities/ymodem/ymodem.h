@@ -25,6 +25,7 @@ enum rym_code {
     RYM_CODE_NAK  = 0x15,
     RYM_CODE_CAN  = 0x18,
     RYM_CODE_C    = 0x43,
+    RYM_CODE_G    = 0x47,
 };
 
 /* RYM error code
@@ -58,6 +59,11 @@ enum rym_code {
 #define RYM_CHD_INTV_TICK (RT_TICK_PER_SECOND * 3)
 #endif
 
+/* how many times a packet or EOT is sent before sender gives up. */
+#ifndef RYM_MAX_RETRY
+#define RYM_MAX_RETRY 10
+#endif
+
 /* how many CAN be sent when user active end the session. */
 #ifndef RYM_END_SESSION_SEND_CAN_NUM
 #define RYM_END_SESSION_SEND_CAN_NUM  0x07
@@ -83,11 +89,11 @@ struct rym_ctx;
 /* when receiving files, the buf will be the data received from ymodem protocol
  * and the len is the data size.
  *
- * TODO:
  * When sending files, the len is the buf size in RYM. The callback need to
- * fill the buf with data to send. Returning RYM_CODE_EOT will terminate the
- * transfer and the buf will be discarded. Any other return values will cause
- * the transfer continue.
+ * fill the buf with data to send and set ctx->len to the bytes filled.
+ * Returning RYM_CODE_EOT or filling nothing will terminate the file and the
+ * buf will be discarded, RYM_CODE_CAN aborts the session. Any other return
+ * values will cause the transfer continue.
  */
 typedef enum rym_code (*rym_callback)(struct rym_ctx *ctx, rt_uint8_t *buf, rt_size_t len);
 
@@ -110,6 +116,12 @@ struct rym_ctx
     struct rt_semaphore sem;
 
     rt_device_t dev;
+
+    /* RYM_CODE_C for YMODEM(-1K), RYM_CODE_G for YMODEM-G which streams
+     * data packets without ACK. Sender gets it from the receiver. */
+    enum rym_code hs_code;
+    /* bytes filled by on_data when sending */
+    rt_size_t len;
 };
 
 /** recv a file on device dev with ymodem session ctx.
@@ -141,4 +153,54 @@ rt_err_t rym_recv_on_device(struct rym_ctx *ctx, rt_device_t dev, rt_uint16_t of
         rym_callback on_begin, rym_callback on_data, rym_callback on_end,
         int handshake_timeout);
 
+/** recv files like rym_recv_on_device, hs_code selects the mode.
+ *
+ * @param hs_code RYM_CODE_C for YMODEM and YMODEM-1K, RYM_CODE_G for
+ * YMODEM-G. In YMODEM-G data packets are not acknowledged and not
+ * retransmitted, any error cancels the session, so on_data must keep up with
+ * the line, e.g. by handing buffers to another thread. Serial driver should be
+ * opened with RT_DEVICE_FLAG_DMA_RX and a RT_SERIAL_RB_BUFSZ covering the
+ * longest stall of on_data.
+ */
+rt_err_t rym_recv_on_device_ex(struct rym_ctx *ctx, rt_device_t dev, rt_uint16_t oflag,
+        enum rym_code hs_code, rym_callback on_begin, rym_callback on_data,
+        rym_callback on_end, int handshake_timeout);
+
+/** send files on device dev with ymodem session ctx.
+ *
+ * Data is sent in 1K packets. Mode follows the receiver, packets wait for
+ * ACK if it starts with C and are streamed if it starts with G.
+ *
+ * @param on_begin The callback will be invoked before each file. It should
+ * fill the buf with file name, a NUL and the file size in decimal. Returning
+ * anything but RYM_CODE_ACK ends the batch, RYM_CODE_CAN aborts it.
+ *
+ * @param on_data The callback will be invoked for each packet, see
+ * rym_callback.
+ *
+ * @param on_end The callback will be invoked when the file is finished, the
+ * return value is ignored.
+ *
+ * @param handshake_timeout the timeout when waiting for receiver, same as
+ * rym_recv_on_device.
+ */
+rt_err_t rym_send_on_device(struct rym_ctx *ctx, rt_device_t dev, rt_uint16_t oflag,
+        rym_callback on_begin, rym_callback on_data, rym_callback on_end,
+        int handshake_timeout);
+
+#ifdef RT_USING_DFS
+/** recv files into dir, file is written by another thread through double
+ * buffers while packets keep coming. Result is printed after the session.
+ *
+ * @param hs_code RYM_CODE_C or RYM_CODE_G, see rym_recv_on_device_ex.
+ */
+rt_err_t rym_recv_to_dir(rt_device_t dev, const char *dir, enum rym_code hs_code);
+
+/** send files, e.g. ones of file_logger or metrics_collector. Next buffer is
+ * read by another thread while current one is on the line, files can't be
+ * opened are skipped.
+ */
+rt_err_t rym_send_files(rt_device_t dev, char **paths, int num);
+#endif
+
 #endif
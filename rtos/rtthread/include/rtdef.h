@@ -208,6 +208,7 @@ typedef int (*init_fn_t)(void);
 #ifdef _MSC_VER /* we do not support MS VC++ compiler */
 
 #if RT_DEBUG_INIT
+#define RT_INIT_USING_DESC
 struct rt_init_desc
 {
     const char *fn_name;
@@ -225,16 +226,39 @@ struct rt_init_desc
 #endif
 
 #else
-#if RT_DEBUG_INIT
+#if RT_DEBUG_INIT || defined(RT_USING_INIT_PROFILE) || defined(RT_USING_INIT_ASYNC)
+/* init table keeps function name */
+#define RT_INIT_USING_DESC
+#endif
+
+#ifdef RT_INIT_USING_DESC
+/* initialization runs in worker thread */
+#define RT_INIT_FLAG_ASYNC              (0x01)
+/* initialization waits for rt_components_deferred_init */
+#define RT_INIT_FLAG_DEFERRED           (0x02)
+
 struct rt_init_desc
 {
     const char *fn_name;
     const init_fn_t fn;
+#ifdef RT_USING_INIT_ASYNC
+    /* name of initialization functions it depends on, separated by space */
+    const char *deps;
+    rt_uint32_t flags;
+#endif
 };
-#define INIT_EXPORT(fn, level)                                                       \
-            const char __rti_##fn##_name[] = #fn;                                            \
-            RT_USED const struct rt_init_desc __rt_init_desc_##fn SECTION(".rti_fn." level) = \
-            { __rti_##fn##_name, fn};
+#ifdef RT_USING_INIT_ASYNC
+#define INIT_EXPORT_FLAG(fn, level, sublevel, deps, flags)                                  \
+            static const char __rti_##fn##_name[] = #fn;                                    \
+            RT_USED const struct rt_init_desc __rt_init_desc_##fn SECTION(".rti_fn." level sublevel) = \
+            { __rti_##fn##_name, fn, deps, flags}
+#define INIT_EXPORT(fn, level, sublevel)    INIT_EXPORT_FLAG(fn, level, sublevel, RT_NULL, 0)
+#else
+#define INIT_EXPORT(fn, level, sublevel)                                                    \
+            static const char __rti_##fn##_name[] = #fn;                                    \
+            RT_USED const struct rt_init_desc __rt_init_desc_##fn SECTION(".rti_fn." level sublevel) = \
+            { __rti_##fn##_name, fn}
+#endif
 #else
 #define INIT_EXPORT(fn, level, sublevel)                                                       \
             RT_USED const init_fn_t __rt_init_##fn SECTION(".rti_fn." level sublevel) = fn
@@ -293,6 +317,24 @@ struct rt_init_desc
 
 #endif
 
+/* initialization which nothing but the functions listing it in deps relies on,
+ * deps is space separated names of initialization functions it needs, e.g. "rt_hw_lcd_init"
+ */
+#if defined(RT_USING_INIT_ASYNC) && !defined(_MSC_VER)
+#define INIT_DEVICE_ASYNC_EXPORT(fn, deps)      INIT_EXPORT_FLAG(fn, "3", "5", deps, RT_INIT_FLAG_ASYNC)
+#define INIT_COMPONENT_ASYNC_EXPORT(fn, deps)   INIT_EXPORT_FLAG(fn, "4", "5", deps, RT_INIT_FLAG_ASYNC)
+#define INIT_ENV_ASYNC_EXPORT(fn, deps)         INIT_EXPORT_FLAG(fn, "5", "5", deps, RT_INIT_FLAG_ASYNC)
+#define INIT_APP_ASYNC_EXPORT(fn, deps)         INIT_EXPORT_FLAG(fn, "7", "5", deps, RT_INIT_FLAG_ASYNC)
+/* non-critical initialization, run after rt_components_deferred_init is called, e.g. first screen is drawn */
+#define INIT_DEFERRED_EXPORT(fn, deps)          INIT_EXPORT_FLAG(fn, "7", "5", deps, RT_INIT_FLAG_ASYNC | RT_INIT_FLAG_DEFERRED)
+#else
+#define INIT_DEVICE_ASYNC_EXPORT(fn, deps)      INIT_DEVICE_EXPORT(fn)
+#define INIT_COMPONENT_ASYNC_EXPORT(fn, deps)   INIT_COMPONENT_EXPORT(fn)
+#define INIT_ENV_ASYNC_EXPORT(fn, deps)         INIT_ENV_EXPORT(fn)
+#define INIT_APP_ASYNC_EXPORT(fn, deps)         INIT_APP_EXPORT(fn)
+#define INIT_DEFERRED_EXPORT(fn, deps)          INIT_APP_EXPORT(fn)
+#endif
+
 
 #if !defined(RT_USING_FINSH)
 /* define these to empty, even if not include finsh.h file */
@@ -511,6 +553,17 @@ struct rt_object_information
 #define RT_TIMER_SKIP_LIST_MASK         0x3
 #endif
 
+#ifdef RT_USING_TIMER_WHEEL
+/* hierarchical timer wheel, RT_TIMER_WHEEL_BITS * RT_TIMER_WHEEL_LEVELS shall be less than 32 */
+#ifndef RT_TIMER_WHEEL_BITS
+#define RT_TIMER_WHEEL_BITS             5               /**< log2 of slots per level, max 5 */
+#endif
+#ifndef RT_TIMER_WHEEL_LEVELS
+#define RT_TIMER_WHEEL_LEVELS           4
+#endif
+#define RT_TIMER_WHEEL_SLOTS            (1 << RT_TIMER_WHEEL_BITS)
+#endif /* RT_USING_TIMER_WHEEL */
+
 /**
  * timer structure
  */
@@ -527,6 +580,15 @@ struct rt_timer
 
     rt_tick_t        init_tick;                         /**< timer timeout tick */
     rt_tick_t        timeout_tick;                      /**< timeout tick */
+#ifdef RT_USING_TIMER_WHEEL
+    rt_uint8_t       wheel_level;                       /**< wheel level of row[0], RT_TIMER_WHEEL_LEVELS for overflow list */
+    rt_uint8_t       wheel_slot;                        /**< wheel slot of row[0] */
+#endif
+#ifdef RT_TIMER_EXEC_STAT
+    rt_uint32_t      exec_cnt;                          /**< timeout function called count */
+    rt_uint32_t      exec_max;                          /**< max execution time of timeout function, in exec clock */
+    rt_uint32_t      exec_total;                        /**< total execution time of timeout function, in exec clock */
+#endif
 };
 typedef struct rt_timer *rt_timer_t;
 
@@ -851,6 +913,65 @@ struct rt_memheap
 };
 #endif
 
+#ifdef RT_USING_TLSFHEAP
+#ifndef RT_TLSFHEAP_FL_MAX
+#define RT_TLSFHEAP_FL_MAX      26                      /**< log2 of the largest pool size supported */
+#endif
+#define RT_TLSFHEAP_SL_LOG2     4                       /**< log2 of second level list count */
+#define RT_TLSFHEAP_SL_COUNT    (1 << RT_TLSFHEAP_SL_LOG2)
+#define RT_TLSFHEAP_FL_SHIFT    (RT_TLSFHEAP_SL_LOG2 + 3) /**< 8 bytes alignment */
+#define RT_TLSFHEAP_FL_COUNT    (RT_TLSFHEAP_FL_MAX - RT_TLSFHEAP_FL_SHIFT + 1)
+
+/**
+ * memory block on the tlsf heap
+ */
+struct rt_tlsfheap_block
+{
+    struct rt_tlsfheap_block *prev_phys;                /**< physically previous block */
+    rt_uint32_t               size;                     /**< payload size, bit0 is set if block is free */
+    struct rt_tlsfheap       *heap;                     /**< owner of the block */
+    rt_uint32_t               magic;                    /**< magic number for tlsf heap */
+
+    /* following fields are only valid while the block is free */
+    struct rt_tlsfheap_block *next_free;                /**< next free block in the same list */
+    struct rt_tlsfheap_block *prev_free;                /**< prev free block in the same list */
+};
+
+/**
+ * Two level segregated fit memory heap, allocation and free are O(1)
+ */
+struct rt_tlsfheap
+{
+    char                      name[RT_NAME_MAX];        /**< name of heap */
+    rt_list_t                 list;                     /**< node on tlsf heap list */
+
+    void                     *start_addr;               /**< pool start address */
+    rt_uint32_t               pool_size;                /**< pool size */
+    rt_uint32_t               available_size;           /**< available size */
+    rt_uint32_t               max_used_size;            /**< maximum allocated size */
+    rt_uint32_t               free_blocks;              /**< number of free blocks */
+
+    rt_uint32_t               fl_bitmap;                /**< non-empty first level lists */
+    rt_uint32_t               sl_bitmap[RT_TLSFHEAP_FL_COUNT];  /**< non-empty second level lists */
+    struct rt_tlsfheap_block *blocks[RT_TLSFHEAP_FL_COUNT][RT_TLSFHEAP_SL_COUNT];
+
+    struct rt_semaphore       lock;                     /**< semaphore lock */
+};
+
+/**
+ * tlsf heap usage and fragmentation
+ */
+struct rt_tlsfheap_info
+{
+    rt_uint32_t pool_size;                              /**< pool size */
+    rt_uint32_t available_size;                         /**< total free size */
+    rt_uint32_t max_used_size;                          /**< maximum allocated size */
+    rt_uint32_t largest_free_size;                      /**< largest free block */
+    rt_uint32_t free_blocks;                            /**< number of free blocks */
+    rt_uint32_t frag_permille;                          /**< 1000 * (1 - largest_free / available) */
+};
+#endif
+
 #ifdef RT_USING_MEMPOOL
 /**
  * Base structure of Memory pool object
@@ -115,6 +115,10 @@ struct rt_timer *rt_timer_next_timer(void);
 #ifdef RT_USING_TIMER_SOFT
 struct rt_timer *rt_timer_next_soft_timer(void);
 #endif /* RT_USING_TIMER_SOFT */
+#ifdef RT_TIMER_EXEC_STAT
+rt_uint32_t rt_timer_exec_clock(void);
+rt_uint32_t rt_timer_exec_clock_freq(void);
+#endif /* RT_TIMER_EXEC_STAT */
 
 
 #ifdef RT_USING_PM
@@ -331,6 +335,24 @@ rt_err_t rt_memheap_remove_from_sys(struct rt_memheap *heap);
 
 #endif
 
+#ifdef RT_USING_TLSFHEAP
+/**
+ * tlsf heap object interface
+ */
+rt_err_t rt_tlsfheap_init(struct rt_tlsfheap *heap,
+                          const char         *name,
+                          void               *start_addr,
+                          rt_size_t          size);
+rt_err_t rt_tlsfheap_detach(struct rt_tlsfheap *heap);
+void *rt_tlsfheap_alloc(struct rt_tlsfheap *heap, rt_size_t size);
+void *rt_tlsfheap_realloc(struct rt_tlsfheap *heap, void *ptr, rt_size_t newsize);
+void rt_tlsfheap_free(void *ptr);
+void *rt_tlsfheap_calloc(struct rt_tlsfheap *heap, rt_size_t count, rt_size_t size);
+rt_size_t rt_tlsfheap_size(void *ptr);
+void rt_tlsfheap_get_info(struct rt_tlsfheap *heap, struct rt_tlsfheap_info *info);
+void rt_tlsfheap_dump(struct rt_tlsfheap *heap);
+#endif
+
 /**@}*/
 
 /**
@@ -506,6 +528,11 @@ void rt_interrupt_leave_sethook(void (*hook)(void));
 #ifdef RT_USING_COMPONENTS_INIT
 void rt_components_init(void);
 void rt_components_board_init(void);
+void rt_components_deferred_init(void);
+#ifdef RT_USING_INIT_PROFILE
+rt_uint32_t rt_init_profile_clock(void);
+rt_uint32_t rt_init_profile_clock_freq(void);
+#endif /* RT_USING_INIT_PROFILE */
 #endif
 
 /**
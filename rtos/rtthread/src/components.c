@@ -14,6 +14,7 @@
  * 2015-05-04     Bernard      Rename it to components.c because compiling issue
  *                             in some IDEs.
  * 2015-07-29     Arda.Fu      Add support to use RT_USING_USER_MAIN with IAR
+ * 2026-10-14     SiFli        Add initialization profile and async initialization
  */
 #include <stdint.h>
 #include <rthw.h>
@@ -96,19 +97,355 @@ static int rti_end(void)
     INIT_EXPORT(rti_end, STR_CONCAT(rti_fn$, 7, 9.end));
 #endif
 
+#if defined(RT_USING_INIT_PROFILE) && defined(RT_INIT_USING_DESC)
+#define RTI_PROFILE
+#endif
+
+#if defined(RT_USING_INIT_ASYNC) && !defined(_MSC_VER)
+#define RTI_ASYNC
+#endif
+
+#ifdef RTI_PROFILE
+#ifndef RT_INIT_PROFILE_NUM
+    #define RT_INIT_PROFILE_NUM         (128)
+#endif
+
+struct rti_prof
+{
+    /* start time relative to first board initialization */
+    rt_uint32_t start;
+    rt_uint32_t cost;
+};
+
+static struct rti_prof rti_prof[RT_INIT_PROFILE_NUM];
+static rt_uint32_t rti_prof_base;
+static rt_bool_t rti_prof_started;
+
+/**
+ * This function returns clock to measure initialization time,
+ * BSP could provide a finer one.
+ */
+RT_WEAK rt_uint32_t rt_init_profile_clock(void)
+{
+    return rt_tick_get();
+}
+
+RT_WEAK rt_uint32_t rt_init_profile_clock_freq(void)
+{
+    return RT_TICK_PER_SECOND;
+}
+#endif /* RTI_PROFILE */
+
+#ifdef RT_INIT_USING_DESC
+static int rti_call(const struct rt_init_desc *desc)
+{
+    int result;
+#ifdef RTI_PROFILE
+    rt_uint32_t start;
+    rt_uint32_t index;
+
+    start = rt_init_profile_clock();
+    if (!rti_prof_started)
+    {
+        rti_prof_base = start;
+        rti_prof_started = RT_TRUE;
+    }
+#endif /* RTI_PROFILE */
+
+    result = desc->fn();
+
+#ifdef RTI_PROFILE
+    index = desc - &__rt_init_desc_rti_start;
+    if (index < RT_INIT_PROFILE_NUM)
+    {
+        rti_prof[index].start = start - rti_prof_base;
+        rti_prof[index].cost = rt_init_profile_clock() - start;
+    }
+#endif /* RTI_PROFILE */
+
+#if RT_DEBUG_INIT
+    rt_kprintf("initialize %s:%d done\n", desc->fn_name, result);
+#endif
+
+    return result;
+}
+#endif /* RT_INIT_USING_DESC */
+
+#ifdef RTI_ASYNC
+#ifndef RT_INIT_ASYNC_WORKERS
+    #define RT_INIT_ASYNC_WORKERS       (2)
+#endif
+#ifndef RT_INIT_ASYNC_STACK_SIZE
+    #define RT_INIT_ASYNC_STACK_SIZE    (2048)
+#endif
+#ifndef RT_INIT_ASYNC_PRIORITY
+    #define RT_INIT_ASYNC_PRIORITY      (RT_THREAD_PRIORITY_MAX / 3)
+#endif
+
+#define RTI_FIRST                   (&__rt_init_desc_rti_board_end)
+#define RTI_LAST                    (&__rt_init_desc_rti_end)
+#define RTI_INDEX(desc)             ((desc) - RTI_FIRST)
+
+enum
+{
+    RTI_STATE_IDLE,
+    RTI_STATE_QUEUED,
+    RTI_STATE_RUNNING,
+    RTI_STATE_DONE
+};
+
+/* state of each initialization after board level, NULL if all run serially */
+static rt_uint8_t *rti_state;
+/* number of queued and running async initialization */
+static rt_uint32_t rti_pending;
+static rt_uint32_t rti_running;
+/* serial initialization has finished */
+static rt_bool_t rti_serial_done;
+static rt_bool_t rti_workers_started;
+static rt_bool_t rti_deferred_started;
+static struct rt_semaphore rti_kick;
+
+static const struct rt_init_desc *rti_find(const char *name, rt_size_t len)
+{
+    const struct rt_init_desc *desc;
+
+    for (desc = RTI_FIRST; desc < RTI_LAST; desc++)
+    {
+        if (desc->fn_name && (0 == rt_strncmp(desc->fn_name, name, len)) && ('\0' == desc->fn_name[len]))
+        {
+            return desc;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* unknown dependency, e.g. board initialization or one not compiled, is regarded as done */
+static rt_bool_t rti_ready(const struct rt_init_desc *desc)
+{
+    const struct rt_init_desc *dep_desc;
+    const char *dep;
+    const char *end;
+
+    dep = desc->deps;
+    if (RT_NULL == dep)
+    {
+        return RT_TRUE;
+    }
+
+    while (*dep)
+    {
+        while (' ' == *dep)
+        {
+            dep++;
+        }
+        for (end = dep; *end && (' ' != *end); end++);
+        if (end > dep)
+        {
+            dep_desc = rti_find(dep, end - dep);
+            if (dep_desc && (RTI_STATE_DONE != rti_state[RTI_INDEX(dep_desc)]))
+            {
+                return RT_FALSE;
+            }
+        }
+        dep = end;
+    }
+
+    return RT_TRUE;
+}
+
+static const struct rt_init_desc *rti_take(void)
+{
+    const struct rt_init_desc *desc;
+    const struct rt_init_desc *first;
+    rt_bool_t forced;
+
+    forced = RT_FALSE;
+    first = RT_NULL;
+    rt_enter_critical();
+    for (desc = RTI_FIRST; desc < RTI_LAST; desc++)
+    {
+        if (RTI_STATE_QUEUED == rti_state[RTI_INDEX(desc)])
+        {
+            if (RT_NULL == first)
+            {
+                first = desc;
+            }
+            if (rti_ready(desc))
+            {
+                break;
+            }
+        }
+    }
+    if (desc == RTI_LAST)
+    {
+        desc = RT_NULL;
+        /* nothing can make progress, dependency is deferred or circular */
+        if (rti_serial_done && (0 == rti_running) && first)
+        {
+            desc = first;
+            forced = RT_TRUE;
+        }
+    }
+    if (desc)
+    {
+        rti_state[RTI_INDEX(desc)] = RTI_STATE_RUNNING;
+        rti_running++;
+    }
+    rt_exit_critical();
+
+    if (forced)
+    {
+        rt_kprintf("init %s: dependency \"%s\" not satisfied\n", desc->fn_name, desc->deps);
+    }
+
+    return desc;
+}
+
+static void rti_done(const struct rt_init_desc *desc, rt_bool_t async)
+{
+    rt_enter_critical();
+    rti_state[RTI_INDEX(desc)] = RTI_STATE_DONE;
+    if (async)
+    {
+        rti_running--;
+        rti_pending--;
+    }
+    rt_exit_critical();
+    rt_sem_release(&rti_kick);
+}
+
+static void rti_work(void)
+{
+    const struct rt_init_desc *desc;
+
+    while (1)
+    {
+        desc = rti_take();
+        if (desc)
+        {
+            rti_call(desc);
+            rti_done(desc, RT_TRUE);
+            continue;
+        }
+        if (rti_serial_done && (0 == rti_pending))
+        {
+            break;
+        }
+        /* kick may be consumed by another worker, poll as well */
+        rt_sem_take(&rti_kick, rt_tick_from_millisecond(10));
+    }
+}
+
+static void rti_worker_entry(void *parameter)
+{
+    rti_work();
+}
+
+static void rti_start_workers(void)
+{
+    rt_thread_t tid;
+    char name[RT_NAME_MAX];
+    int i;
+
+    for (i = 0; i < RT_INIT_ASYNC_WORKERS; i++)
+    {
+        rt_snprintf(name, sizeof(name), "init%d", i);
+        tid = rt_thread_create(name, rti_worker_entry, RT_NULL, RT_INIT_ASYNC_STACK_SIZE,
+                               RT_INIT_ASYNC_PRIORITY, RT_THREAD_TICK_DEFAULT);
+        if (tid)
+        {
+            rt_thread_startup(tid);
+        }
+    }
+}
+
+static void rti_queue(const struct rt_init_desc *desc)
+{
+    rt_enter_critical();
+    rti_state[RTI_INDEX(desc)] = RTI_STATE_QUEUED;
+    rti_pending++;
+    rt_exit_critical();
+    rt_sem_release(&rti_kick);
+}
+
+/* return RT_TRUE if desc is left to worker */
+static rt_bool_t rti_async(const struct rt_init_desc *desc)
+{
+    if (!rti_state || !(desc->flags & RT_INIT_FLAG_ASYNC))
+    {
+        return RT_FALSE;
+    }
+
+    if (0 == (desc->flags & RT_INIT_FLAG_DEFERRED))
+    {
+        rti_queue(desc);
+        if (!rti_workers_started)
+        {
+            rti_workers_started = RT_TRUE;
+            rti_start_workers();
+        }
+    }
+
+    return RT_TRUE;
+}
+
+static void rti_async_init(void)
+{
+    rti_state = rt_calloc(RTI_LAST - RTI_FIRST, sizeof(rti_state[0]));
+    if (rti_state)
+    {
+        rt_sem_init(&rti_kick, "rti", 0, RT_IPC_FLAG_FIFO);
+    }
+}
+
+/**
+ * Start initialization exported by INIT_DEFERRED_EXPORT in worker threads,
+ * it's called by application when critical work is done, e.g. first screen is drawn.
+ */
+void rt_components_deferred_init(void)
+{
+    const struct rt_init_desc *desc;
+    rt_bool_t started;
+
+    rt_enter_critical();
+    started = rti_deferred_started;
+    rti_deferred_started = RT_TRUE;
+    rt_exit_critical();
+    if (started || !rti_state)
+    {
+        /* deferred initialization is run serially in rt_components_init if no state memory */
+        return;
+    }
+
+    for (desc = RTI_FIRST; desc < RTI_LAST; desc++)
+    {
+        if (desc->fn_name && desc->fn && (desc->flags & RT_INIT_FLAG_DEFERRED))
+        {
+            rti_queue(desc);
+        }
+    }
+    if (rti_pending)
+    {
+        rti_start_workers();
+    }
+}
+#else
+void rt_components_deferred_init(void)
+{
+}
+#endif /* RTI_ASYNC */
+
 /**
  * RT-Thread Components Initialization for board
  */
 __ROM_USED void rt_components_board_init(void)
 {
-#if RT_DEBUG_INIT
-    int result;
+#ifdef RT_INIT_USING_DESC
     const struct rt_init_desc *desc;
     for (desc = &__rt_init_desc_rti_board_start; desc < &__rt_init_desc_rti_board_end; desc ++)
     {
-        rt_kprintf("initialize %s", desc->fn_name);
-        result = desc->fn();
-        rt_kprintf(":%d done\n", result);
+        rti_call(desc);
     }
 #else
     const init_fn_t *fn_ptr;
@@ -125,20 +462,42 @@ __ROM_USED void rt_components_board_init(void)
  */
 __ROM_USED void rt_components_init(void)
 {
-#if RT_DEBUG_INIT
-    int result;
+#ifdef RT_INIT_USING_DESC
     const struct rt_init_desc *desc;
 
+#if RT_DEBUG_INIT
     rt_kprintf("do components initialization.\n");
+#endif
+#ifdef RTI_ASYNC
+    rti_async_init();
+#endif /* RTI_ASYNC */
     for (desc = &__rt_init_desc_rti_board_end; desc < &__rt_init_desc_rti_end; desc ++)
     {
         if (desc->fn_name && desc->fn)
         {
-            rt_kprintf("initialize %s", desc->fn_name);
-            result = desc->fn();
-            rt_kprintf(":%d done\n", result);
+#ifdef RTI_ASYNC
+            if (rti_async(desc))
+            {
+                continue;
+            }
+#endif /* RTI_ASYNC */
+            rti_call(desc);
+#ifdef RTI_ASYNC
+            if (rti_state)
+            {
+                rti_done(desc, RT_FALSE);
+            }
+#endif /* RTI_ASYNC */
         }
     }
+#ifdef RTI_ASYNC
+    /* help workers until all async initialization except deferred is done */
+    rti_serial_done = RT_TRUE;
+    if (rti_state)
+    {
+        rti_work();
+    }
+#endif /* RTI_ASYNC */
 #else
     const init_fn_t *fn_ptr;
 
@@ -152,6 +511,49 @@ __ROM_USED void rt_components_init(void)
 #endif
 }
 
+#if defined(RTI_PROFILE) && defined(RT_USING_FINSH)
+#include <finsh.h>
+
+static int list_init(void)
+{
+    const struct rt_init_desc *desc;
+    rt_uint32_t freq;
+    rt_uint32_t index;
+    rt_uint32_t total;
+
+    freq = rt_init_profile_clock_freq();
+    total = 0;
+    rt_kprintf("%-32s %10s %10s\n", "function", "start(us)", "cost(us)");
+    for (desc = &__rt_init_desc_rti_start; desc < &__rt_init_desc_rti_end; desc++)
+    {
+        index = desc - &__rt_init_desc_rti_start;
+        if (index >= RT_INIT_PROFILE_NUM)
+        {
+            rt_kprintf("more than %d functions, increase RT_INIT_PROFILE_NUM\n", RT_INIT_PROFILE_NUM);
+            break;
+        }
+        if (!desc->fn_name || !desc->fn || (0 == rti_prof[index].cost))
+        {
+            continue;
+        }
+        total += rti_prof[index].cost;
+        rt_kprintf("%-32.32s %10d %10d%s\n", desc->fn_name,
+                   (rt_uint32_t)((rt_uint64_t)rti_prof[index].start * 1000000 / freq),
+                   (rt_uint32_t)((rt_uint64_t)rti_prof[index].cost * 1000000 / freq),
+#ifdef RTI_ASYNC
+                   (desc->flags & RT_INIT_FLAG_DEFERRED) ? " deferred" : ((desc->flags & RT_INIT_FLAG_ASYNC) ? " async" : "")
+#else
+                   ""
+#endif /* RTI_ASYNC */
+                  );
+    }
+    rt_kprintf("sum of cost: %dus\n", (rt_uint32_t)((rt_uint64_t)total * 1000000 / freq));
+
+    return 0;
+}
+MSH_CMD_EXPORT(list_init, list execution time of initialization functions);
+#endif /* RTI_PROFILE && RT_USING_FINSH */
+
 #ifdef RT_USING_USER_MAIN
 
 void rt_application_init(void);
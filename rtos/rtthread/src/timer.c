@@ -16,14 +16,55 @@
  * 2012-12-15     Bernard      fix the next timeout issue in soft timer
  * 2014-07-12     Bernard      does not lock scheduler when invoking soft-timer
  *                             timeout function.
+ * 2026-10-14     SiFli        add hierarchical timer wheel and timeout function
+ *                             execution statistics.
  */
 
 #include <rtthread.h>
 #include <rthw.h>
 #include "mem_section.h"
 
+#ifdef RT_USING_TIMER_WHEEL
+#if (RT_TIMER_WHEEL_BITS > 5) || (RT_TIMER_WHEEL_BITS * RT_TIMER_WHEEL_LEVELS >= 32)
+    #error "Invalid timer wheel configuration"
+#endif
+
+#define RT_TIMER_WHEEL_MASK             (RT_TIMER_WHEEL_SLOTS - 1)
+#define RT_TIMER_WHEEL_BITMAP_MASK      (0xFFFFFFFFUL >> (32 - RT_TIMER_WHEEL_SLOTS))
+#define RT_TIMER_WHEEL_SHIFT(lvl)       ((lvl) * RT_TIMER_WHEEL_BITS)
+#define RT_TIMER_WHEEL_NONE             0xFF
+
+/*
+ * Timer is linked by row[0] into the slot of the lowest level which can hold
+ * its timeout tick in one rotation. When wheel tick crosses a slot boundary of
+ * upper level, timers of that slot are cascaded to lower levels. Timers reached
+ * in level 0 are moved to expired list in timeout order.
+ */
+struct rt_timer_wheel
+{
+    rt_tick_t   tick;                                       /* wheel time, slots up to this tick are processed */
+    rt_uint32_t bitmap[RT_TIMER_WHEEL_LEVELS];              /* non-empty slots of each level */
+    rt_list_t   slot[RT_TIMER_WHEEL_LEVELS][RT_TIMER_WHEEL_SLOTS];
+    rt_list_t   overflow;                                   /* timers beyond the top level */
+    rt_list_t   expired;                                    /* timers which are due */
+};
+typedef struct rt_timer_wheel *rt_timer_head_t;
+
+/* hard timer wheel */
+static struct rt_timer_wheel rt_timer_wheel;
+#define RT_TIMER_HARD_HEAD              (&rt_timer_wheel)
+#ifdef RT_USING_TIMER_SOFT
+    /* soft timer wheel */
+    static struct rt_timer_wheel rt_soft_timer_wheel;
+    #define RT_TIMER_SOFT_HEAD          (&rt_soft_timer_wheel)
+#endif
+#else
+typedef rt_list_t *rt_timer_head_t;
+
 /* hard timer list */
 __ROM_USED rt_list_t rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
+#define RT_TIMER_HARD_HEAD              (rt_timer_list)
+#endif /* RT_USING_TIMER_WHEEL */
 
 #ifdef RT_USING_TIMER_SOFT
 
@@ -40,8 +81,11 @@ __ROM_USED rt_list_t rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
 
     /* soft timer status */
     static rt_uint8_t soft_timer_status = RT_SOFT_TIMER_IDLE;
-    /* soft timer list */
-    __ROM_USED rt_list_t rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
+    #ifndef RT_USING_TIMER_WHEEL
+        /* soft timer list */
+        __ROM_USED rt_list_t rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
+        #define RT_TIMER_SOFT_HEAD          (rt_soft_timer_list)
+    #endif
     static struct rt_thread timer_thread;
     L1_NON_RET_BSS_SECT_BEGIN(timer_thread_stack)
     ALIGN(RT_ALIGN_SIZE)
@@ -49,6 +93,14 @@ __ROM_USED rt_list_t rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
     L1_NON_RET_BSS_SECT_END
 #endif
 
+#ifdef RT_TIMER_EXEC_STAT
+    /* timer whose timeout function is running, cleared if it's detached or deleted */
+    static rt_timer_t rt_timer_running;
+    #ifdef RT_USING_TIMER_SOFT
+        static rt_timer_t rt_soft_timer_running;
+    #endif
+#endif /* RT_TIMER_EXEC_STAT */
+
 #ifdef RT_USING_HOOK
 extern void (*rt_object_take_hook)(struct rt_object *object);
 extern void (*rt_object_put_hook)(struct rt_object *object);
@@ -117,10 +169,315 @@ static void _rt_timer_init(rt_timer_t timer,
     {
         rt_list_init(&(timer->row[i]));
     }
+
+#ifdef RT_USING_TIMER_WHEEL
+    timer->wheel_level = RT_TIMER_WHEEL_NONE;
+    timer->wheel_slot  = 0;
+#endif
+#ifdef RT_TIMER_EXEC_STAT
+    timer->exec_cnt   = 0;
+    timer->exec_max   = 0;
+    timer->exec_total = 0;
+#endif
+}
+
+static struct rt_timer *rt_timer_list_next_timer(rt_list_t *timer_list)
+{
+    struct rt_timer *timer;
+
+    if (rt_list_isempty(timer_list))
+        return NULL;
+
+    timer = rt_list_entry(timer_list->next,
+                          struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+
+    return timer;
+}
+
+#ifdef RT_USING_TIMER_WHEEL
+rt_inline rt_timer_head_t _rt_timer_head(rt_timer_t timer)
+{
+#ifdef RT_USING_TIMER_SOFT
+    if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
+        return RT_TIMER_SOFT_HEAD;
+#endif
+    return RT_TIMER_HARD_HEAD;
+}
+
+static void _rt_timer_wheel_init(struct rt_timer_wheel *wheel)
+{
+    int i, j;
+
+    wheel->tick = rt_tick_get();
+    for (i = 0; i < RT_TIMER_WHEEL_LEVELS; i++)
+    {
+        wheel->bitmap[i] = 0;
+        for (j = 0; j < RT_TIMER_WHEEL_SLOTS; j++)
+        {
+            rt_list_init(&wheel->slot[i][j]);
+        }
+    }
+    rt_list_init(&wheel->overflow);
+    rt_list_init(&wheel->expired);
+}
+
+/* put timer into the lowest level which can hold it in one rotation */
+static void _rt_timer_wheel_add(struct rt_timer_wheel *wheel, rt_timer_t timer)
+{
+    rt_tick_t delta = timer->timeout_tick - wheel->tick;
+    rt_list_t *head;
+    rt_uint32_t idx = 0;
+    int lvl;
+
+    if ((delta == 0) || (delta >= RT_TICK_MAX / 2))
+    {
+        head = &wheel->expired;
+        lvl = RT_TIMER_WHEEL_NONE;
+    }
+    else
+    {
+        for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVELS; lvl++)
+        {
+            delta = ((timer->timeout_tick >> RT_TIMER_WHEEL_SHIFT(lvl)) - (wheel->tick >> RT_TIMER_WHEEL_SHIFT(lvl)))
+                    & (RT_TICK_MAX >> RT_TIMER_WHEEL_SHIFT(lvl));
+            if (delta < RT_TIMER_WHEEL_SLOTS)
+                break;
+        }
+
+        if (lvl < RT_TIMER_WHEEL_LEVELS)
+        {
+            idx = (timer->timeout_tick >> RT_TIMER_WHEEL_SHIFT(lvl)) & RT_TIMER_WHEEL_MASK;
+            head = &wheel->slot[lvl][idx];
+            wheel->bitmap[lvl] |= 1UL << idx;
+        }
+        else
+        {
+            head = &wheel->overflow;
+        }
+    }
+
+    timer->wheel_level = lvl;
+    timer->wheel_slot  = idx;
+    rt_list_insert_before(head, &timer->row[0]);
+}
+
+/* re-add all timers of list, used for cascade */
+static void _rt_timer_wheel_move(struct rt_timer_wheel *wheel, rt_list_t *head)
+{
+    struct rt_timer *t;
+    rt_list_t list;
+
+    if (rt_list_isempty(head))
+        return;
+
+    /* detach all from head as they may be added back to overflow list */
+    list.next = head->next;
+    list.prev = head->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    rt_list_init(head);
+
+    while (!rt_list_isempty(&list))
+    {
+        t = rt_list_entry(list.next, struct rt_timer, row[0]);
+        rt_list_remove(&t->row[0]);
+        _rt_timer_wheel_add(wheel, t);
+    }
+}
+
+/* process slots of wheel->tick, upper levels cascade first */
+static void _rt_timer_wheel_tick(struct rt_timer_wheel *wheel)
+{
+    rt_tick_t tick = wheel->tick;
+    rt_uint32_t idx;
+    int lvl;
+
+    if (0 == (tick & ((1UL << RT_TIMER_WHEEL_SHIFT(RT_TIMER_WHEEL_LEVELS)) - 1)))
+        _rt_timer_wheel_move(wheel, &wheel->overflow);
+
+    for (lvl = RT_TIMER_WHEEL_LEVELS - 1; lvl >= 0; lvl--)
+    {
+        if (tick & ((1UL << RT_TIMER_WHEEL_SHIFT(lvl)) - 1))
+            continue;
+
+        idx = (tick >> RT_TIMER_WHEEL_SHIFT(lvl)) & RT_TIMER_WHEEL_MASK;
+        if (wheel->bitmap[lvl] & (1UL << idx))
+        {
+            wheel->bitmap[lvl] &= ~(1UL << idx);
+            _rt_timer_wheel_move(wheel, &wheel->slot[lvl][idx]);
+        }
+    }
+}
+
+/* distance in slot from current slot to next non-empty slot of level, 0 if level is empty */
+static rt_uint32_t _rt_timer_wheel_next_slot(struct rt_timer_wheel *wheel, int lvl)
+{
+    rt_uint32_t bitmap = wheel->bitmap[lvl];
+    rt_uint32_t s;
+
+    if (!bitmap)
+        return 0;
+
+    /* rotate bitmap so that bit 0 is the slot next to current one */
+    s = ((wheel->tick >> RT_TIMER_WHEEL_SHIFT(lvl)) + 1) & RT_TIMER_WHEEL_MASK;
+    if (s)
+        bitmap = ((bitmap >> s) | (bitmap << (RT_TIMER_WHEEL_SLOTS - s))) & RT_TIMER_WHEEL_BITMAP_MASK;
+
+    return __rt_ffs(bitmap);
+}
+
+/* ticks to the next tick which has slot to be processed, 0 if wheel is empty */
+static rt_tick_t _rt_timer_wheel_next_event(struct rt_timer_wheel *wheel)
+{
+    rt_tick_t next = 0;
+    rt_tick_t delta;
+    rt_uint32_t n;
+    int lvl;
+
+    for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVELS; lvl++)
+    {
+        n = _rt_timer_wheel_next_slot(wheel, lvl);
+        if (!n)
+            continue;
+
+        delta = (((wheel->tick >> RT_TIMER_WHEEL_SHIFT(lvl)) + n) << RT_TIMER_WHEEL_SHIFT(lvl)) - wheel->tick;
+        if (!next || (delta < next))
+            next = delta;
+    }
+
+    if (!rt_list_isempty(&wheel->overflow))
+    {
+        lvl = RT_TIMER_WHEEL_LEVELS;
+        delta = (((wheel->tick >> RT_TIMER_WHEEL_SHIFT(lvl)) + 1) << RT_TIMER_WHEEL_SHIFT(lvl)) - wheel->tick;
+        if (!next || (delta < next))
+            next = delta;
+    }
+
+    return next;
+}
+
+/* process wheel up to current tick, only ticks with non-empty slot are visited */
+static void _rt_timer_wheel_advance(struct rt_timer_wheel *wheel, rt_tick_t current_tick)
+{
+    rt_tick_t delta;
+    rt_tick_t next;
+
+    while (1)
+    {
+        delta = current_tick - wheel->tick;
+        if ((delta == 0) || (delta >= RT_TICK_MAX / 2))
+            break;
+
+        next = _rt_timer_wheel_next_event(wheel);
+        if (!next || (next > delta))
+        {
+            wheel->tick = current_tick;
+            break;
+        }
+        wheel->tick += next;
+        _rt_timer_wheel_tick(wheel);
+    }
+}
+
+/* earliest timer in list, first one is returned if several have same timeout tick */
+static struct rt_timer *_rt_timer_wheel_scan(struct rt_timer_wheel *wheel, rt_list_t *head,
+        struct rt_timer *best)
+{
+    struct rt_timer *t;
+    rt_list_t *node;
+
+    for (node = head->next; node != head; node = node->next)
+    {
+        t = rt_list_entry(node, struct rt_timer, row[0]);
+        if (!best || ((t->timeout_tick - wheel->tick) < (best->timeout_tick - wheel->tick)))
+            best = t;
+    }
+
+    return best;
+}
+
+static struct rt_timer *_rt_timer_wheel_first(struct rt_timer_wheel *wheel)
+{
+    struct rt_timer *best = RT_NULL;
+    rt_uint32_t n;
+    int lvl;
+
+    if (!rt_list_isempty(&wheel->expired))
+        return rt_list_entry(wheel->expired.next, struct rt_timer, row[0]);
+
+    /* slots of one level are in timeout order, only first non-empty slot of each level is checked */
+    for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVELS; lvl++)
+    {
+        n = _rt_timer_wheel_next_slot(wheel, lvl);
+        if (!n)
+            continue;
+
+        n = ((wheel->tick >> RT_TIMER_WHEEL_SHIFT(lvl)) + n) & RT_TIMER_WHEEL_MASK;
+        best = _rt_timer_wheel_scan(wheel, &wheel->slot[lvl][n], best);
+    }
+
+    return _rt_timer_wheel_scan(wheel, &wheel->overflow, best);
 }
+#endif /* RT_USING_TIMER_WHEEL */
 
-/* the fist timer always in the last row */
-static rt_tick_t rt_timer_list_next_timeout(rt_list_t timer_list[])
+rt_inline void _rt_timer_remove(rt_timer_t timer)
+{
+    int i;
+
+#ifdef RT_USING_TIMER_WHEEL
+    if (timer->wheel_level < RT_TIMER_WHEEL_LEVELS)
+    {
+        rt_timer_head_t wheel = _rt_timer_head(timer);
+        rt_list_t *head = &wheel->slot[timer->wheel_level][timer->wheel_slot];
+
+        rt_list_remove(&timer->row[0]);
+        if (rt_list_isempty(head))
+            wheel->bitmap[timer->wheel_level] &= ~(1UL << timer->wheel_slot);
+    }
+    timer->wheel_level = RT_TIMER_WHEEL_NONE;
+#endif /* RT_USING_TIMER_WHEEL */
+
+    for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL; i++)
+    {
+        rt_list_remove(&timer->row[i]);
+    }
+}
+
+/* the earliest timer */
+static struct rt_timer *_rt_timer_first(rt_timer_head_t head)
+{
+#ifdef RT_USING_TIMER_WHEEL
+    return _rt_timer_wheel_first(head);
+#else
+    /* the fist timer always in the last row */
+    return rt_timer_list_next_timer(&head[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+#endif
+}
+
+/* the earliest timer if it's timeout */
+static struct rt_timer *_rt_timer_first_due(rt_timer_head_t head, rt_tick_t current_tick)
+{
+    struct rt_timer *t;
+
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_advance(head, current_tick);
+    t = RT_NULL;
+    if (!rt_list_isempty(&head->expired))
+        t = rt_list_entry(head->expired.next, struct rt_timer, row[0]);
+#else
+    t = _rt_timer_first(head);
+    /*
+     * It supposes that the new tick shall less than the half duration of
+     * tick max.
+     */
+    if (t && ((current_tick - t->timeout_tick) >= RT_TICK_MAX / 2))
+        t = RT_NULL;
+#endif
+
+    return t;
+}
+
+static rt_tick_t rt_timer_list_next_timeout(rt_timer_head_t head)
 {
     struct rt_timer *timer;
     register rt_base_t level;
@@ -129,12 +486,9 @@ static rt_tick_t rt_timer_list_next_timeout(rt_list_t timer_list[])
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
-    if (!rt_list_isempty(&timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]))
-    {
-        timer = rt_list_entry(timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1].next,
-                              struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+    timer = _rt_timer_first(head);
+    if (timer)
         timeout_tick = timer->timeout_tick;
-    }
 
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
@@ -142,27 +496,126 @@ static rt_tick_t rt_timer_list_next_timeout(rt_list_t timer_list[])
     return timeout_tick;
 }
 
-static struct rt_timer *rt_timer_list_next_timer(rt_list_t *timer_list)
+static void _rt_timer_insert(rt_timer_head_t timer_list, rt_timer_t timer)
 {
-    struct rt_timer *timer;
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_add(timer_list, timer);
+#else
+    unsigned int row_lvl;
+    rt_list_t *row_head[RT_TIMER_SKIP_LIST_LEVEL];
+    unsigned int tst_nr;
+    static unsigned int random_nr;
 
-    if (rt_list_isempty(timer_list))
-        return NULL;
+    row_head[0]  = &timer_list[0];
+    for (row_lvl = 0; row_lvl < RT_TIMER_SKIP_LIST_LEVEL; row_lvl++)
+    {
+        for (; row_head[row_lvl] != timer_list[row_lvl].prev;
+                row_head[row_lvl]  = row_head[row_lvl]->next)
+        {
+            struct rt_timer *t;
+            rt_list_t *p = row_head[row_lvl]->next;
 
-    timer = rt_list_entry(timer_list->next,
-                          struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+            /* fix up the entry pointer */
+            t = rt_list_entry(p, struct rt_timer, row[row_lvl]);
 
-    return timer;
+            /* If we have two timers that timeout at the same time, it's
+             * preferred that the timer inserted early get called early.
+             * So insert the new timer to the end the the some-timeout timer
+             * list.
+             */
+            if ((t->timeout_tick - timer->timeout_tick) == 0)
+            {
+                continue;
+            }
+            else if ((t->timeout_tick - timer->timeout_tick) < RT_TICK_MAX / 2)
+            {
+                break;
+            }
+        }
+        if (row_lvl != RT_TIMER_SKIP_LIST_LEVEL - 1)
+            row_head[row_lvl + 1] = row_head[row_lvl] + 1;
+    }
+
+    /* Interestingly, this super simple timer insert counter works very very
+     * well on distributing the list height uniformly. By means of "very very
+     * well", I mean it beats the randomness of timer->timeout_tick very easily
+     * (actually, the timeout_tick is not random and easy to be attacked). */
+    random_nr++;
+    tst_nr = random_nr;
+
+    rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - 1],
+                         &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
+    for (row_lvl = 2; row_lvl <= RT_TIMER_SKIP_LIST_LEVEL; row_lvl++)
+    {
+        if (!(tst_nr & RT_TIMER_SKIP_LIST_MASK))
+            rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - row_lvl],
+                                 &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - row_lvl]));
+        else
+            break;
+        /* Shift over the bits we have tested. Works well with 1 bit and 2
+         * bits. */
+        tst_nr >>= (RT_TIMER_SKIP_LIST_MASK + 1) >> 1;
+    }
+#endif /* RT_USING_TIMER_WHEEL */
 }
 
-rt_inline void _rt_timer_remove(rt_timer_t timer)
+#ifdef RT_TIMER_EXEC_STAT
+/**
+ * Clock used to measure execution time of timeout function, tick by default,
+ * BSP could provide a finer one.
+ */
+RT_WEAK rt_uint32_t rt_timer_exec_clock(void)
 {
-    int i;
+    return rt_tick_get();
+}
 
-    for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL; i++)
+RT_WEAK rt_uint32_t rt_timer_exec_clock_freq(void)
+{
+    return RT_TICK_PER_SECOND;
+}
+#endif /* RT_TIMER_EXEC_STAT */
+
+/* call timeout function, timer may be deleted in it */
+rt_inline void _rt_timer_invoke(rt_timer_t t)
+{
+#ifdef RT_TIMER_EXEC_STAT
+    rt_timer_t *running = &rt_timer_running;
+    rt_uint32_t start;
+    rt_uint32_t cost;
+
+#ifdef RT_USING_TIMER_SOFT
+    if (t->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
+        running = &rt_soft_timer_running;
+#endif
+    *running = t;
+    start = rt_timer_exec_clock();
+#endif
+
+    t->timeout_func(t->parameter);
+
+#ifdef RT_TIMER_EXEC_STAT
+    cost = rt_timer_exec_clock() - start;
+    if (*running == t)
     {
-        rt_list_remove(&timer->row[i]);
+        t->exec_cnt++;
+        t->exec_total += cost;
+        if (cost > t->exec_max)
+            t->exec_max = cost;
     }
+    *running = RT_NULL;
+#endif
+}
+
+rt_inline void _rt_timer_forget(rt_timer_t timer)
+{
+#ifdef RT_TIMER_EXEC_STAT
+    if (rt_timer_running == timer)
+        rt_timer_running = RT_NULL;
+#ifdef RT_USING_TIMER_SOFT
+    if (rt_soft_timer_running == timer)
+        rt_soft_timer_running = RT_NULL;
+#endif
+#endif /* RT_TIMER_EXEC_STAT */
 }
 
 #if RT_DEBUG_TIMER
@@ -251,6 +704,7 @@ __ROM_USED rt_err_t rt_timer_detach(rt_timer_t timer)
     _rt_timer_remove(timer);
     /* stop timer */
     timer->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+    _rt_timer_forget(timer);
 
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
@@ -281,6 +735,7 @@ __ROM_USED rt_timer_t rt_timer_create(const char *name,
 {
     struct rt_timer *timer;
 
+#ifndef RT_USING_TIMER_WHEEL
     // Just for one list
     rt_list_t *list = &rt_timer_list[0];
     rt_timer_t timer_1 = rt_timer_list_next_timer(list);
@@ -294,6 +749,7 @@ __ROM_USED rt_timer_t rt_timer_create(const char *name,
         list = list->next;
         timer_1 = rt_timer_list_next_timer(list);
     }
+#endif /* !RT_USING_TIMER_WHEEL */
 
 
     /* allocate a object */
@@ -331,6 +787,7 @@ __ROM_USED rt_err_t rt_timer_delete(rt_timer_t timer)
     _rt_timer_remove(timer);
     /* stop timer */
     timer->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+    _rt_timer_forget(timer);
 
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
@@ -351,12 +808,8 @@ RTM_EXPORT(rt_timer_delete);
  */
 __ROM_USED rt_err_t rt_timer_start(rt_timer_t timer)
 {
-    unsigned int row_lvl;
-    rt_list_t *timer_list;
+    rt_timer_head_t timer_list;
     register rt_base_t level;
-    rt_list_t *row_head[RT_TIMER_SKIP_LIST_LEVEL];
-    unsigned int tst_nr;
-    static unsigned int random_nr;
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
@@ -382,65 +835,16 @@ __ROM_USED rt_err_t rt_timer_start(rt_timer_t timer)
     if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
     {
         /* insert timer to soft timer list */
-        timer_list = rt_soft_timer_list;
+        timer_list = RT_TIMER_SOFT_HEAD;
     }
     else
 #endif
     {
         /* insert timer to system timer list */
-        timer_list = rt_timer_list;
-    }
-
-    row_head[0]  = &timer_list[0];
-    for (row_lvl = 0; row_lvl < RT_TIMER_SKIP_LIST_LEVEL; row_lvl++)
-    {
-        for (; row_head[row_lvl] != timer_list[row_lvl].prev;
-                row_head[row_lvl]  = row_head[row_lvl]->next)
-        {
-            struct rt_timer *t;
-            rt_list_t *p = row_head[row_lvl]->next;
-
-            /* fix up the entry pointer */
-            t = rt_list_entry(p, struct rt_timer, row[row_lvl]);
-
-            /* If we have two timers that timeout at the same time, it's
-             * preferred that the timer inserted early get called early.
-             * So insert the new timer to the end the the some-timeout timer
-             * list.
-             */
-            if ((t->timeout_tick - timer->timeout_tick) == 0)
-            {
-                continue;
-            }
-            else if ((t->timeout_tick - timer->timeout_tick) < RT_TICK_MAX / 2)
-            {
-                break;
-            }
-        }
-        if (row_lvl != RT_TIMER_SKIP_LIST_LEVEL - 1)
-            row_head[row_lvl + 1] = row_head[row_lvl] + 1;
+        timer_list = RT_TIMER_HARD_HEAD;
     }
 
-    /* Interestingly, this super simple timer insert counter works very very
-     * well on distributing the list height uniformly. By means of "very very
-     * well", I mean it beats the randomness of timer->timeout_tick very easily
-     * (actually, the timeout_tick is not random and easy to be attacked). */
-    random_nr++;
-    tst_nr = random_nr;
-
-    rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - 1],
-                         &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
-    for (row_lvl = 2; row_lvl <= RT_TIMER_SKIP_LIST_LEVEL; row_lvl++)
-    {
-        if (!(tst_nr & RT_TIMER_SKIP_LIST_MASK))
-            rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - row_lvl],
-                                 &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - row_lvl]));
-        else
-            break;
-        /* Shift over the bits we have tested. Works well with 1 bit and 2
-         * bits. */
-        tst_nr >>= (RT_TIMER_SKIP_LIST_MASK + 1) >> 1;
-    }
+    _rt_timer_insert(timer_list, timer);
 
     timer->parent.flag |= RT_TIMER_FLAG_ACTIVATED;
 
@@ -563,51 +967,40 @@ __ROM_USED void rt_timer_check(void)
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
-    while (!rt_list_isempty(&rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]))
+    while ((t = _rt_timer_first_due(RT_TIMER_HARD_HEAD, current_tick)) != RT_NULL)
     {
-        t = rt_list_entry(rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1].next,
-                          struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+        RT_OBJECT_HOOK_CALL(rt_timer_enter_hook, (t));
 
-        /*
-         * It supposes that the new tick shall less than the half duration of
-         * tick max.
-         */
-        if ((current_tick - t->timeout_tick) < RT_TICK_MAX / 2)
+        /* remove timer from timer list firstly */
+        _rt_timer_remove(t);
+        if (!(t->parent.flag & RT_TIMER_FLAG_PERIODIC))
         {
-            RT_OBJECT_HOOK_CALL(rt_timer_enter_hook, (t));
+            t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+        }
+        /* add timer to temporary list  */
+        rt_list_insert_after(&list, &(t->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
+        /* call timeout function */
+        _rt_timer_invoke(t);
 
-            /* remove timer from timer list firstly */
-            _rt_timer_remove(t);
-            if (!(t->parent.flag & RT_TIMER_FLAG_PERIODIC))
-            {
-                t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
-            }
-            /* add timer to temporary list  */
-            rt_list_insert_after(&list, &(t->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
-            /* call timeout function */
-            t->timeout_func(t->parameter);
+        /* re-get tick */
+        current_tick = rt_tick_get();
 
-            /* re-get tick */
-            current_tick = rt_tick_get();
+        RT_OBJECT_HOOK_CALL(rt_timer_exit_hook, (t));
+        RT_DEBUG_LOG(RT_DEBUG_TIMER, ("current tick: %d\n", current_tick));
 
-            RT_OBJECT_HOOK_CALL(rt_timer_exit_hook, (t));
-            RT_DEBUG_LOG(RT_DEBUG_TIMER, ("current tick: %d\n", current_tick));
-
-            /* Check whether the timer object is detached or started again */
-            if (rt_list_isempty(&list))
-            {
-                continue;
-            }
-            rt_list_remove(&(t->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
-            if ((t->parent.flag & RT_TIMER_FLAG_PERIODIC) &&
-                    (t->parent.flag & RT_TIMER_FLAG_ACTIVATED))
-            {
-                /* start it */
-                t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
-                rt_timer_start(t);
-            }
+        /* Check whether the timer object is detached or started again */
+        if (rt_list_isempty(&list))
+        {
+            continue;
+        }
+        rt_list_remove(&(t->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
+        if ((t->parent.flag & RT_TIMER_FLAG_PERIODIC) &&
+                (t->parent.flag & RT_TIMER_FLAG_ACTIVATED))
+        {
+            /* start it */
+            t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+            rt_timer_start(t);
         }
-        else break;
     }
 
     /* enable interrupt */
@@ -623,7 +1016,7 @@ __ROM_USED void rt_timer_check(void)
  */
 __ROM_USED rt_tick_t rt_timer_next_timeout_tick(void)
 {
-    return rt_timer_list_next_timeout(rt_timer_list);
+    return rt_timer_list_next_timeout(RT_TIMER_HARD_HEAD);
 }
 
 
@@ -631,14 +1024,14 @@ __ROM_USED struct rt_timer *rt_timer_next_timer(void)
 {
     rt_timer_t next_timer;
 
-    next_timer = rt_timer_list_next_timer(&rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+    next_timer = _rt_timer_first(RT_TIMER_HARD_HEAD);
 
 #ifdef RT_USING_TIMER_SOFT
 
     if (next_timer
             && (0 == rt_strncmp(next_timer->parent.name, "timer", RT_NAME_MAX)))
     {
-        next_timer = rt_timer_list_next_timer(&rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+        next_timer = _rt_timer_first(RT_TIMER_SOFT_HEAD);
     }
 #endif /* RT_USING_TIMER_SOFT */
 
@@ -651,7 +1044,7 @@ struct rt_timer *rt_timer_next_soft_timer(void)
 {
     rt_timer_t next_timer;
 
-    next_timer = rt_timer_list_next_timer(&rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+    next_timer = _rt_timer_first(RT_TIMER_SOFT_HEAD);
 
     return next_timer;
 }
@@ -674,18 +1067,12 @@ __ROM_USED void rt_soft_timer_check(void)
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
-    while (!rt_list_isempty(&rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]))
+    while (1)
     {
-        t = rt_list_entry(rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1].next,
-                          struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
-
         current_tick = rt_tick_get();
 
-        /*
-         * It supposes that the new tick shall less than the half duration of
-         * tick max.
-         */
-        if ((current_tick - t->timeout_tick) < RT_TICK_MAX / 2)
+        t = _rt_timer_first_due(RT_TIMER_SOFT_HEAD, current_tick);
+        if (t)
         {
             RT_OBJECT_HOOK_CALL(rt_timer_enter_hook, (t));
 
@@ -703,7 +1090,7 @@ __ROM_USED void rt_soft_timer_check(void)
             rt_hw_interrupt_enable(level);
 
             /* call timeout function */
-            t->timeout_func(t->parameter);
+            _rt_timer_invoke(t);
 
             RT_OBJECT_HOOK_CALL(rt_timer_exit_hook, (t));
             RT_DEBUG_LOG(RT_DEBUG_TIMER, ("current tick: %d\n", current_tick));
@@ -742,7 +1129,7 @@ static void rt_thread_timer_entry(void *parameter)
     while (1)
     {
         /* get the next timeout tick */
-        next_timeout = rt_timer_list_next_timeout(rt_soft_timer_list);
+        next_timeout = rt_timer_list_next_timeout(RT_TIMER_SOFT_HEAD);
         if (next_timeout == RT_TICK_MAX)
         {
             /* no software timer exist, suspend self. */
@@ -778,12 +1165,16 @@ static void rt_thread_timer_entry(void *parameter)
  */
 __ROM_USED void rt_system_timer_init(void)
 {
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_init(RT_TIMER_HARD_HEAD);
+#else
     int i;
 
     for (i = 0; i < sizeof(rt_timer_list) / sizeof(rt_timer_list[0]); i++)
     {
         rt_list_init(rt_timer_list + i);
     }
+#endif /* RT_USING_TIMER_WHEEL */
 }
 
 /**
@@ -794,6 +1185,9 @@ __ROM_USED void rt_system_timer_init(void)
 __ROM_USED void rt_system_timer_thread_init(void)
 {
 #ifdef RT_USING_TIMER_SOFT
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_init(RT_TIMER_SOFT_HEAD);
+#else
     int i;
 
     for (i = 0;
@@ -802,6 +1196,7 @@ __ROM_USED void rt_system_timer_thread_init(void)
     {
         rt_list_init(rt_soft_timer_list + i);
     }
+#endif /* RT_USING_TIMER_WHEEL */
 
     /* start software timer thread */
     rt_thread_init(&timer_thread,
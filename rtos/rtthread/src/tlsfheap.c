@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * File      : tlsfheap.c
+ *
+ * Two level segregated fit heap. Free blocks are kept in size class lists
+ * indexed by two bitmaps, so allocation and free take constant time
+ * independent of the number of blocks in the pool.
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-14     SiFli        first implementation
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_TLSFHEAP
+
+#define TLSF_MAGIC              0x71f5ea70
+#define TLSF_BLOCK_FREE         0x01
+#define TLSF_ALIGN_SIZE         8
+
+/* header preceding user data, free list pointers overlap the payload */
+#define TLSF_HDR_SIZE           ((rt_uint32_t)(rt_ubase_t)&(((struct rt_tlsfheap_block *)0)->next_free))
+#define TLSF_MIN_SIZE           (sizeof(struct rt_tlsfheap_block) - TLSF_HDR_SIZE)
+#define TLSF_SMALL_SIZE         (1UL << RT_TLSFHEAP_FL_SHIFT)
+#define TLSF_MAX_SIZE           (1UL << RT_TLSFHEAP_FL_MAX)
+
+#define BLOCK_SIZE(b)           ((b)->size & ~TLSF_BLOCK_FREE)
+#define BLOCK_IS_FREE(b)        ((b)->size & TLSF_BLOCK_FREE)
+#define BLOCK_NEXT(b)           ((struct rt_tlsfheap_block *)((rt_uint8_t *)(b) + TLSF_HDR_SIZE + BLOCK_SIZE(b)))
+#define BLOCK_TO_PTR(b)         ((void *)((rt_uint8_t *)(b) + TLSF_HDR_SIZE))
+#define PTR_TO_BLOCK(p)         ((struct rt_tlsfheap_block *)((rt_uint8_t *)(p) - TLSF_HDR_SIZE))
+
+#if RT_TLSFHEAP_FL_COUNT > 31
+    #error "RT_TLSFHEAP_FL_MAX too large"
+#endif
+
+static rt_list_t _tlsfheap_list = RT_LIST_OBJECT_INIT(_tlsfheap_list);
+
+/* index of most significant bit, x must not be 0 */
+rt_inline int tlsf_fls(rt_uint32_t x)
+{
+#if defined(__GNUC__) || defined(__CLANG_ARM)
+    return 31 - __builtin_clz(x);
+#elif defined(__CC_ARM)
+    return 31 - __clz(x);
+#else
+    int bit = 31;
+
+    while (!(x & 0x80000000UL))
+    {
+        x <<= 1;
+        bit--;
+    }
+    return bit;
+#endif
+}
+
+/* index of least significant bit, x must not be 0 */
+rt_inline int tlsf_ffs(rt_uint32_t x)
+{
+    return tlsf_fls(x & (~x + 1));
+}
+
+static void mapping_insert(rt_uint32_t size, int *fl, int *sl)
+{
+    if (size < TLSF_SMALL_SIZE)
+    {
+        *fl = 0;
+        *sl = size / (TLSF_SMALL_SIZE / RT_TLSFHEAP_SL_COUNT);
+    }
+    else
+    {
+        int f = tlsf_fls(size);
+
+        *sl = (size >> (f - RT_TLSFHEAP_SL_LOG2)) ^ RT_TLSFHEAP_SL_COUNT;
+        *fl = f - (RT_TLSFHEAP_FL_SHIFT - 1);
+    }
+}
+
+/* round size up to next list, so that any block found in it is large enough */
+static void mapping_search(rt_uint32_t size, int *fl, int *sl)
+{
+    if (size >= TLSF_SMALL_SIZE)
+        size += (1UL << (tlsf_fls(size) - RT_TLSFHEAP_SL_LOG2)) - 1;
+
+    mapping_insert(size, fl, sl);
+}
+
+static struct rt_tlsfheap_block *search_suitable_block(struct rt_tlsfheap *heap, int *fl, int *sl)
+{
+    rt_uint32_t sl_map;
+
+    if (*fl >= RT_TLSFHEAP_FL_COUNT)
+        return RT_NULL;
+
+    sl_map = heap->sl_bitmap[*fl] & (~0UL << *sl);
+    if (!sl_map)
+    {
+        rt_uint32_t fl_map = heap->fl_bitmap & (~0UL << (*fl + 1));
+
+        if (!fl_map)
+            return RT_NULL;
+
+        *fl = tlsf_ffs(fl_map);
+        sl_map = heap->sl_bitmap[*fl];
+    }
+    *sl = tlsf_ffs(sl_map);
+
+    return heap->blocks[*fl][*sl];
+}
+
+static void remove_free_block(struct rt_tlsfheap *heap, struct rt_tlsfheap_block *block)
+{
+    int fl, sl;
+
+    mapping_insert(BLOCK_SIZE(block), &fl, &sl);
+
+    if (block->next_free)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free)
+        block->prev_free->next_free = block->next_free;
+
+    if (heap->blocks[fl][sl] == block)
+    {
+        heap->blocks[fl][sl] = block->next_free;
+        if (!block->next_free)
+        {
+            heap->sl_bitmap[fl] &= ~(1UL << sl);
+            if (!heap->sl_bitmap[fl])
+                heap->fl_bitmap &= ~(1UL << fl);
+        }
+    }
+    heap->free_blocks--;
+}
+
+static void insert_free_block(struct rt_tlsfheap *heap, struct rt_tlsfheap_block *block)
+{
+    int fl, sl;
+
+    mapping_insert(BLOCK_SIZE(block), &fl, &sl);
+
+    block->size |= TLSF_BLOCK_FREE;
+    block->prev_free = RT_NULL;
+    block->next_free = heap->blocks[fl][sl];
+    if (block->next_free)
+        block->next_free->prev_free = block;
+    heap->blocks[fl][sl] = block;
+
+    heap->fl_bitmap |= 1UL << fl;
+    heap->sl_bitmap[fl] |= 1UL << sl;
+    heap->free_blocks++;
+}
+
+/* split tail of used block off if it is big enough, return tail or RT_NULL */
+static struct rt_tlsfheap_block *split_block(struct rt_tlsfheap_block *block, rt_uint32_t size)
+{
+    struct rt_tlsfheap_block *remain;
+    rt_uint32_t block_size = BLOCK_SIZE(block);
+
+    if (block_size < size + TLSF_HDR_SIZE + TLSF_MIN_SIZE)
+        return RT_NULL;
+
+    remain = (struct rt_tlsfheap_block *)((rt_uint8_t *)block + TLSF_HDR_SIZE + size);
+    remain->size      = block_size - size - TLSF_HDR_SIZE;
+    remain->prev_phys = block;
+    remain->heap      = block->heap;
+    remain->magic     = TLSF_MAGIC;
+    BLOCK_NEXT(remain)->prev_phys = remain;
+
+    block->size = size;
+
+    return remain;
+}
+
+/* put a block back to heap, merge with free neighbours */
+static void release_block(struct rt_tlsfheap *heap, struct rt_tlsfheap_block *block)
+{
+    struct rt_tlsfheap_block *next;
+
+    heap->available_size += BLOCK_SIZE(block);
+
+    if (block->prev_phys && BLOCK_IS_FREE(block->prev_phys))
+    {
+        struct rt_tlsfheap_block *prev = block->prev_phys;
+
+        remove_free_block(heap, prev);
+        prev->size = BLOCK_SIZE(prev) + TLSF_HDR_SIZE + BLOCK_SIZE(block);
+        heap->available_size += TLSF_HDR_SIZE;
+        block = prev;
+        BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    next = BLOCK_NEXT(block);
+    if (BLOCK_IS_FREE(next))
+    {
+        remove_free_block(heap, next);
+        block->size = BLOCK_SIZE(block) + TLSF_HDR_SIZE + BLOCK_SIZE(next);
+        heap->available_size += TLSF_HDR_SIZE;
+        BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    insert_free_block(heap, block);
+}
+
+rt_inline rt_uint32_t adjust_size(rt_size_t size)
+{
+    size = RT_ALIGN(size, TLSF_ALIGN_SIZE);
+    if (size < TLSF_MIN_SIZE)
+        size = TLSF_MIN_SIZE;
+
+    return size;
+}
+
+rt_inline void update_max_used(struct rt_tlsfheap *heap)
+{
+    if (heap->pool_size - heap->available_size > heap->max_used_size)
+        heap->max_used_size = heap->pool_size - heap->available_size;
+}
+
+/*
+ * The initialized pool will be:
+ * +--------+----------------------------------+-----------------+
+ * | header | whole free block                 | sentinel header |
+ * +--------+----------------------------------+-----------------+
+ *
+ * The sentinel is a used block of size 0, which prevents merging beyond pool.
+ */
+rt_err_t rt_tlsfheap_init(struct rt_tlsfheap *heap,
+                          const char         *name,
+                          void               *start_addr,
+                          rt_size_t          size)
+{
+    struct rt_tlsfheap_block *block, *sentinel;
+    rt_ubase_t begin, end;
+
+    RT_ASSERT(heap != RT_NULL);
+
+    begin = RT_ALIGN((rt_ubase_t)start_addr, TLSF_ALIGN_SIZE);
+    end   = RT_ALIGN_DOWN((rt_ubase_t)start_addr + size, TLSF_ALIGN_SIZE);
+    if (end <= begin || end - begin < 2 * TLSF_HDR_SIZE + TLSF_MIN_SIZE || end - begin > TLSF_MAX_SIZE)
+        return -RT_EINVAL;
+
+    rt_memset(heap, 0, sizeof(*heap));
+    rt_strncpy(heap->name, name, RT_NAME_MAX);
+    heap->start_addr     = (void *)begin;
+    heap->pool_size      = end - begin;
+    heap->available_size = heap->pool_size - 2 * TLSF_HDR_SIZE;
+    heap->max_used_size  = heap->pool_size - heap->available_size;
+
+    block            = (struct rt_tlsfheap_block *)begin;
+    block->prev_phys = RT_NULL;
+    block->size      = heap->available_size;
+    block->heap      = heap;
+    block->magic     = TLSF_MAGIC;
+
+    sentinel            = BLOCK_NEXT(block);
+    sentinel->prev_phys = block;
+    sentinel->size      = 0;
+    sentinel->heap      = heap;
+    sentinel->magic     = TLSF_MAGIC;
+
+    insert_free_block(heap, block);
+
+    rt_sem_init(&(heap->lock), "tlsfheap", 1, RT_IPC_FLAG_FIFO);
+
+    rt_enter_critical();
+    rt_list_insert_after(&_tlsfheap_list, &(heap->list));
+    rt_exit_critical();
+
+    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
+                 ("tlsfheap init, start address 0x%x, size %d\n",
+                  begin, heap->pool_size));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_tlsfheap_init);
+
+rt_err_t rt_tlsfheap_detach(struct rt_tlsfheap *heap)
+{
+    RT_ASSERT(heap);
+
+    rt_enter_critical();
+    rt_list_remove(&(heap->list));
+    rt_exit_critical();
+
+    rt_sem_detach(&(heap->lock));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_tlsfheap_detach);
+
+void *rt_tlsfheap_alloc(struct rt_tlsfheap *heap, rt_size_t size)
+{
+    struct rt_tlsfheap_block *block, *remain;
+    int fl, sl;
+    rt_err_t result;
+
+    RT_ASSERT(heap != RT_NULL);
+
+    if (size == 0 || size >= TLSF_MAX_SIZE)
+        return RT_NULL;
+    size = adjust_size(size);
+
+    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    if (result != RT_EOK)
+    {
+        rt_set_errno(result);
+
+        return RT_NULL;
+    }
+
+    mapping_search(size, &fl, &sl);
+    block = search_suitable_block(heap, &fl, &sl);
+    if (block == RT_NULL)
+    {
+        rt_sem_release(&(heap->lock));
+        RT_DEBUG_LOG(RT_DEBUG_MEMHEAP, ("tlsfheap %.*s: no block for %d\n",
+                                        RT_NAME_MAX, heap->name, size));
+
+        return RT_NULL;
+    }
+
+    remove_free_block(heap, block);
+    block->size = BLOCK_SIZE(block);
+
+    remain = split_block(block, size);
+    if (remain)
+    {
+        insert_free_block(heap, remain);
+        heap->available_size -= size + TLSF_HDR_SIZE;
+    }
+    else
+    {
+        heap->available_size -= BLOCK_SIZE(block);
+    }
+    update_max_used(heap);
+
+    rt_sem_release(&(heap->lock));
+
+    return BLOCK_TO_PTR(block);
+}
+RTM_EXPORT(rt_tlsfheap_alloc);
+
+void rt_tlsfheap_free(void *ptr)
+{
+    struct rt_tlsfheap_block *block;
+    struct rt_tlsfheap *heap;
+    rt_err_t result;
+
+    if (!ptr)
+        return;
+
+    block = PTR_TO_BLOCK(ptr);
+    RT_ASSERT(block->magic == TLSF_MAGIC);
+    RT_ASSERT(!BLOCK_IS_FREE(block));
+    heap = block->heap;
+    RT_ASSERT(heap);
+
+    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    if (result != RT_EOK)
+    {
+        rt_set_errno(result);
+
+        return;
+    }
+
+    release_block(heap, block);
+
+    rt_sem_release(&(heap->lock));
+}
+RTM_EXPORT(rt_tlsfheap_free);
+
+void *rt_tlsfheap_realloc(struct rt_tlsfheap *heap, void *ptr, rt_size_t newsize)
+{
+    struct rt_tlsfheap_block *block, *next, *remain;
+    rt_uint32_t oldsize;
+    rt_err_t result;
+    void *new_ptr;
+
+    if (ptr == RT_NULL)
+        return rt_tlsfheap_alloc(heap, newsize);
+    if (newsize == 0)
+    {
+        rt_tlsfheap_free(ptr);
+
+        return RT_NULL;
+    }
+    if (newsize >= TLSF_MAX_SIZE)
+        return RT_NULL;
+
+    block = PTR_TO_BLOCK(ptr);
+    RT_ASSERT(block->magic == TLSF_MAGIC);
+    RT_ASSERT(!BLOCK_IS_FREE(block));
+    heap = block->heap;
+    newsize = adjust_size(newsize);
+
+    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    if (result != RT_EOK)
+    {
+        rt_set_errno(result);
+
+        return RT_NULL;
+    }
+
+    oldsize = BLOCK_SIZE(block);
+    next = BLOCK_NEXT(block);
+    if (newsize > oldsize && BLOCK_IS_FREE(next)
+            && oldsize + TLSF_HDR_SIZE + BLOCK_SIZE(next) >= newsize)
+    {
+        /* grow in place by absorbing next free block */
+        remove_free_block(heap, next);
+        heap->available_size -= BLOCK_SIZE(next);
+        block->size = oldsize + TLSF_HDR_SIZE + BLOCK_SIZE(next);
+        BLOCK_NEXT(block)->prev_phys = block;
+        oldsize = block->size;
+    }
+
+    if (newsize <= oldsize)
+    {
+        remain = split_block(block, newsize);
+        if (remain)
+            release_block(heap, remain);
+        update_max_used(heap);
+        rt_sem_release(&(heap->lock));
+
+        return ptr;
+    }
+    rt_sem_release(&(heap->lock));
+
+    new_ptr = rt_tlsfheap_alloc(heap, newsize);
+    if (new_ptr != RT_NULL)
+    {
+        rt_memcpy(new_ptr, ptr, oldsize);
+        rt_tlsfheap_free(ptr);
+    }
+
+    return new_ptr;
+}
+RTM_EXPORT(rt_tlsfheap_realloc);
+
+void *rt_tlsfheap_calloc(struct rt_tlsfheap *heap, rt_size_t count, rt_size_t size)
+{
+    void *ptr;
+    rt_size_t total_size;
+
+    total_size = count * size;
+    if (size && total_size / size != count)
+        return RT_NULL;
+
+    ptr = rt_tlsfheap_alloc(heap, total_size);
+    if (ptr != RT_NULL)
+        rt_memset(ptr, 0, total_size);
+
+    return ptr;
+}
+RTM_EXPORT(rt_tlsfheap_calloc);
+
+rt_size_t rt_tlsfheap_size(void *ptr)
+{
+    struct rt_tlsfheap_block *block;
+
+    if (!ptr)
+        return 0;
+
+    block = PTR_TO_BLOCK(ptr);
+    RT_ASSERT(block->magic == TLSF_MAGIC);
+
+    return BLOCK_SIZE(block);
+}
+RTM_EXPORT(rt_tlsfheap_size);
+
+void rt_tlsfheap_get_info(struct rt_tlsfheap *heap, struct rt_tlsfheap_info *info)
+{
+    struct rt_tlsfheap_block *block;
+    rt_uint32_t largest = 0;
+
+    RT_ASSERT(heap && info);
+
+    rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+
+    /* largest block lives in the highest non-empty list */
+    if (heap->fl_bitmap)
+    {
+        int fl = tlsf_fls(heap->fl_bitmap);
+        int sl = tlsf_fls(heap->sl_bitmap[fl]);
+
+        for (block = heap->blocks[fl][sl]; block; block = block->next_free)
+        {
+            if (BLOCK_SIZE(block) > largest)
+                largest = BLOCK_SIZE(block);
+        }
+    }
+
+    info->pool_size         = heap->pool_size;
+    info->available_size    = heap->available_size;
+    info->max_used_size     = heap->max_used_size;
+    info->largest_free_size = largest;
+    info->free_blocks       = heap->free_blocks;
+    info->frag_permille     = heap->available_size ?
+                              1000 - (rt_uint32_t)((rt_uint64_t)largest * 1000 / heap->available_size) : 0;
+
+    rt_sem_release(&(heap->lock));
+}
+RTM_EXPORT(rt_tlsfheap_get_info);
+
+void rt_tlsfheap_dump(struct rt_tlsfheap *heap)
+{
+    struct rt_tlsfheap_info info;
+    rt_uint32_t hist[32];
+    rt_uint32_t i;
+    int fl, sl;
+
+    RT_ASSERT(heap);
+
+    rt_tlsfheap_get_info(heap, &info);
+    rt_kprintf("%-*.*s total %d, free %d, max used %d, largest free %d, free blocks %d, frag %d.%d%%\n",
+               RT_NAME_MAX, RT_NAME_MAX, heap->name, info.pool_size, info.available_size,
+               info.max_used_size, info.largest_free_size, info.free_blocks,
+               info.frag_permille / 10, info.frag_permille % 10);
+
+    /* histogram of free blocks by power of two size */
+    rt_memset(hist, 0, sizeof(hist));
+    rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    for (fl = 0; fl < RT_TLSFHEAP_FL_COUNT; fl++)
+    {
+        if (!(heap->fl_bitmap & (1UL << fl)))
+            continue;
+        for (sl = 0; sl < RT_TLSFHEAP_SL_COUNT; sl++)
+        {
+            struct rt_tlsfheap_block *block;
+
+            for (block = heap->blocks[fl][sl]; block; block = block->next_free)
+                hist[tlsf_fls(BLOCK_SIZE(block))]++;
+        }
+    }
+    rt_sem_release(&(heap->lock));
+
+    for (i = 0; i < 32; i++)
+    {
+        if (hist[i])
+            rt_kprintf("  [%8u, %8u): %d\n", 1U << i, (i < 31) ? (2U << i) : 0xFFFFFFFFU, hist[i]);
+    }
+}
+RTM_EXPORT(rt_tlsfheap_dump);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int list_tlsfheap(int argc, char **argv)
+{
+    rt_list_t *node;
+
+    rt_list_for_each(node, &_tlsfheap_list)
+    {
+        struct rt_tlsfheap *heap = rt_list_entry(node, struct rt_tlsfheap, list);
+
+        if (argc > 1 && rt_strncmp(heap->name, argv[1], RT_NAME_MAX))
+            continue;
+        rt_tlsfheap_dump(heap);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(list_tlsfheap, list tlsf heap and free block histogram: list_tlsfheap [name]);
+#endif
+
+#endif
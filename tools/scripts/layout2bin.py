@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+#
+# Compile XML layout to precompiled layout loaded by lv_load_layout_bin(), see
+# middleware/lvgl/lvsf/lv_layout_bin.h for the format
+#
+# usage: layout2bin.py <layout.xml> [-o OUT] [--c NAME] [--dump]
+#   -o      output file, .bin by default, C source if --c is given
+#   --c     generate C array NAME, to be registered by APP_WATCHFACE_LAYOUT_REGISTER(id, NAME)
+#   --dump  print decoded widgets and props
+#
+# Element tag is widget type, children are child widgets. Attributes x, y, w, h and name
+# are common, others are props of widget with the same names as text layout, e.g.
+#   <obj w="240" h="240">
+#     <anaclock name="clock" x="0" y="0" bg="clock_bg" hour="hour" min="min" second="sec" refr_inteval="1000"/>
+#     <label name="date" y="20" text="MON 01" color="FF8000" font_size="SUBTITLE" align="OUT_BOTTOM_MID:clock"/>
+#   </obj>
+#
+
+import argparse
+import os
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+MAGIC = 0x424C564C
+VERSION = 1
+NO_STR = 0xFFFF
+ROOT = -1
+
+# lv_layout_bin_type_t
+TYPES = ['obj', 'image', 'label', 'anaclock', 'idximg', 'watchface', 'details', 'roundbar', 'weather', 'icon']
+
+# lv_layout_bin_align_t
+ALIGNS = ['TOP_LEFT', 'TOP_MID', 'TOP_RIGHT', 'BOTTOM_LEFT', 'BOTTOM_MID', 'BOTTOM_RIGHT', 'LEFT_MID',
+          'RIGHT_MID', 'CENTER', 'OUT_TOP_LEFT', 'OUT_TOP_MID', 'OUT_TOP_RIGHT', 'OUT_BOTTOM_LEFT',
+          'OUT_BOTTOM_MID', 'OUT_BOTTOM_RIGHT', 'OUT_LEFT_TOP', 'OUT_LEFT_MID', 'OUT_LEFT_BOTTOM',
+          'OUT_RIGHT_TOP', 'OUT_RIGHT_MID', 'OUT_RIGHT_BOTTOM']
+
+# LVSF_FONT_SIZES
+FONTS = ['SMALL', 'NORMAL', 'SUBTITLE', 'TITLE', 'BIGL', 'HUGE', 'SUPER']
+
+# (attribute, widget type or None for all) -> (lv_layout_bin_prop_id_t, kind)
+PROPS = {
+    ('align', None): (0, 'align'),
+    ('src', 'image'): (1, 'str'),
+    ('text', 'label'): (2, 'str'),
+    ('color', 'label'): (3, 'color'),
+    ('font_size', 'label'): (4, 'font'),
+    ('hoff', 'anaclock'): (5, 'int'),
+    ('moff', 'anaclock'): (6, 'int'),
+    ('soff', 'anaclock'): (7, 'int'),
+    ('bg', 'anaclock'): (8, 'str'),
+    ('hour', 'anaclock'): (9, 'str'),
+    ('min', 'anaclock'): (10, 'str'),
+    ('second', 'anaclock'): (11, 'str'),
+    ('refr_inteval', 'anaclock'): (12, 'int'),
+    ('dig_hour_img', 'watchface'): (13, 'list'),
+    ('dig_min_img', 'watchface'): (14, 'list'),
+    ('dig_sec_img', 'watchface'): (15, 'list'),
+    ('dig_sep_img', 'watchface'): (16, 'list'),
+    ('type', 'watchface'): (17, 'int'),
+    ('bg_color', 'roundbar'): (18, 'color'),
+    ('indic_color', 'roundbar'): (19, 'color'),
+    ('line_width', 'roundbar'): (20, 'int'),
+    ('start_angle', 'roundbar'): (21, 'int'),
+    ('end_angle', 'roundbar'): (22, 'int'),
+    ('value', 'roundbar'): (23, 'int'),
+}
+PROP_NAMES = {v[0]: k[0] for k, v in PROPS.items()}
+
+COMMON = ('x', 'y', 'w', 'h', 'name')
+
+
+class LayoutError(Exception):
+    pass
+
+
+class Pool:
+    """String pool, strings are deduplicated and lists are 2-byte aligned"""
+
+    def __init__(self):
+        self.data = bytearray()
+        self.strs = {}
+
+    def add_str(self, s):
+        if s not in self.strs:
+            self.strs[s] = len(self.data)
+            self.data += s.encode('utf-8') + b'\0'
+        return self.strs[s]
+
+    def add_list(self, items):
+        offs = [self.add_str(i) for i in items]
+        if len(self.data) & 1:
+            self.data += b'\0'
+        off = len(self.data)
+        self.data += struct.pack('<%dH' % (len(offs) + 1), len(offs), *offs)
+        return off
+
+    def finish(self):
+        # Pool must end with terminator so that any offset is a valid string
+        if not self.data or self.data[-1] != 0:
+            self.data += b'\0'
+        while len(self.data) & 3:
+            self.data += b'\0'
+        if len(self.data) > 0xFFFF:
+            raise LayoutError('string pool too large: %d bytes' % len(self.data))
+
+
+def parse_int(s, what):
+    try:
+        return int(s, 0)
+    except ValueError:
+        raise LayoutError('invalid %s "%s"' % (what, s))
+
+
+def encode_value(kind, s, names, pool, where):
+    """Return (aux, value)"""
+    if kind == 'int':
+        return 0, parse_int(s, where) & 0xFFFFFFFF
+    if kind == 'color':
+        s = s.lstrip('#')
+        if len(s) != 6:
+            raise LayoutError('%s: color must be RRGGBB' % where)
+        return 0, int(s, 16)
+    if kind == 'font':
+        if s.upper() not in FONTS:
+            raise LayoutError('%s: unknown font size %s' % (where, s))
+        return 0, FONTS.index(s.upper())
+    if kind == 'str':
+        return 0, pool.add_str(s)
+    if kind == 'list':
+        return 0, pool.add_list(s.split())
+    if kind == 'align':
+        align, _, target = s.partition(':')
+        if align not in ALIGNS:
+            raise LayoutError('%s: unknown align %s' % (where, align))
+        aux = 0
+        if target:
+            # Target must be created before, i.e. appears earlier in file
+            if target not in names:
+                raise LayoutError('%s: align target %s not defined before' % (where, target))
+            aux = names[target] + 1
+        return aux, ALIGNS.index(align)
+    raise LayoutError('unknown kind ' + kind)
+
+
+def compile_layout(root):
+    widgets = []
+    props = []
+    names = {}
+    pool = Pool()
+
+    def walk(elem, parent):
+        typ = elem.tag.lower()
+        if typ not in TYPES:
+            raise LayoutError('unknown widget <%s>' % elem.tag)
+        idx = len(widgets)
+        name = elem.get('name')
+        where = '<%s %s>' % (typ, name or idx)
+        wprops = []
+        for attr, s in elem.attrib.items():
+            if attr in COMMON:
+                continue
+            key = (attr, typ) if (attr, typ) in PROPS else (attr, None)
+            if key not in PROPS:
+                raise LayoutError('%s: unknown prop %s' % (where, attr))
+            pid, kind = PROPS[key]
+            aux, value = encode_value(kind, s, names, pool, where + ' ' + attr)
+            wprops.append((pid, aux, value))
+        widgets.append({
+            'type': TYPES.index(typ),
+            'parent': parent,
+            'x': parse_int(elem.get('x', '0'), where + ' x'),
+            'y': parse_int(elem.get('y', '0'), where + ' y'),
+            'w': parse_int(elem.get('w', '0'), where + ' w'),
+            'h': parse_int(elem.get('h', '0'), where + ' h'),
+            'name': pool.add_str(name) if name else NO_STR,
+            'prop_idx': len(props),
+            'prop_num': len(wprops),
+        })
+        props.extend(wprops)
+        if name:
+            if name in names:
+                raise LayoutError('%s: duplicated name' % where)
+            names[name] = idx
+        for child in elem:
+            walk(child, idx)
+
+    # Root element without widget type only groups widgets, e.g. <layout>
+    if root.tag.lower() in TYPES:
+        walk(root, ROOT)
+    else:
+        for child in root:
+            walk(child, ROOT)
+
+    if len(widgets) > 0xFFFF or len(props) > 0xFFFF:
+        raise LayoutError('too many widgets or props')
+    for w in widgets:
+        if w['prop_num'] > 0xFF:
+            raise LayoutError('too many props of one widget')
+    pool.finish()
+
+    out = bytearray(struct.pack('<IHHHHI', MAGIC, VERSION, len(widgets), len(props), 0, len(pool.data)))
+    for w in widgets:
+        out += struct.pack('<BBhhhhhHH', w['type'], w['prop_num'], w['parent'], w['x'], w['y'], w['w'], w['h'],
+                           w['name'], w['prop_idx'])
+    for pid, aux, value in props:
+        out += struct.pack('<BBHI', pid, 0, aux, value)
+    out += pool.data
+    return bytes(out)
+
+
+def dump(data):
+    magic, ver, wnum, pnum, _, pool_size = struct.unpack_from('<IHHHHI', data)
+    wbase = 16
+    pbase = wbase + wnum * 16
+    pool = data[pbase + pnum * 8:]
+
+    def s(off):
+        return pool[off:pool.index(b'\0', off)].decode('utf-8')
+
+    print('version %d, %d widgets, %d props, pool %d bytes, total %d bytes' % (ver, wnum, pnum, pool_size, len(data)))
+    for i in range(wnum):
+        typ, prop_num, parent, x, y, w, h, name, prop_idx = struct.unpack_from('<BBhhhhhHH', data, wbase + i * 16)
+        print('%3d %-10s parent %3d (%d,%d %dx%d) %s' % (i, TYPES[typ], parent, x, y, w, h,
+                                                          s(name) if name != NO_STR else ''))
+        for j in range(prop_idx, prop_idx + prop_num):
+            pid, _, aux, value = struct.unpack_from('<BBHI', data, pbase + j * 8)
+            print('      %-14s aux %d value 0x%x' % (PROP_NAMES[pid], aux, value))
+
+
+def to_c(data, name, src):
+    lines = ['/* Generated by layout2bin.py from %s, do not edit */' % os.path.basename(src),
+             '#include <rtthread.h>', '',
+             'ALIGN(4) const uint8_t %s[%d] =' % (name, len(data)), '{']
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    lines += ['};', '']
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile XML layout to precompiled layout')
+    parser.add_argument('xml')
+    parser.add_argument('-o', '--output')
+    parser.add_argument('--c', metavar='NAME')
+    parser.add_argument('--dump', action='store_true')
+    args = parser.parse_args()
+
+    try:
+        data = compile_layout(ET.parse(args.xml).getroot())
+    except (LayoutError, ET.ParseError) as e:
+        sys.exit('%s: %s' % (args.xml, e))
+
+    out = args.output or os.path.splitext(args.xml)[0] + ('.c' if args.c else '.bin')
+    if args.c:
+        with open(out, 'w') as f:
+            f.write(to_c(data, args.c, args.xml))
+    else:
+        with open(out, 'wb') as f:
+            f.write(data)
+    if args.dump:
+        dump(data)
+    print('%s: %d bytes' % (out, len(data)))
+
+
+if __name__ == '__main__':
+    main()
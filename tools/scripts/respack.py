@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+#
+# Pack fonts subset to glyphs actually used by UI strings, and images, into resource bundle
+# mapped in place by lv_res_bundle_mount(), see middleware/lvgl/lvsf/lv_res_bundle.h for the format
+#
+# usage: respack.py -o OUT [--lang FILE ...] [--src PATH ...] [--font NAME=FILE ...]
+#                   [--img NAME=FILE ...] [--img-dir DIR] [--align N] [--c NAME] [--ranges DIR] [--dump]
+#   --lang      language pack, JSON object of key: string (locale from "locale" key or file name,
+#               e.g. zh_cn.json) or C source whose string literals are the strings of file name locale
+#   --src       layout XML / C source or directory of them, strings found are used by every locale
+#   --font      TTF/OTF font NAME as registered by LVSF_FONT_REGISTER, one subset per locale is packed
+#   --img       LVGL binary image (lv_img_conv .bin with lv_img_header_t), NAME defaults to file name
+#   --img-dir   add every .bin under DIR as image
+#   --align     payload alignment, 64 by default, use flash page size to map payloads by MPU
+#   --c         generate C array NAME instead of binary
+#   --ranges    write <locale>.txt of used characters for lv_font_conv --symbols, for bitmap fonts
+#   --dump      print entries of bundle
+#
+# Font subsetting requires fontTools (pip install fonttools).
+#
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+MAGIC = 0x4252564C
+VERSION = 1
+NO_STR = 0xFFFF
+
+# lv_res_bundle_type_t
+TYPE_FONT = 0
+TYPE_IMG = 1
+TYPES = ['font', 'img']
+
+HEADER = '<IHHIII'
+ENTRY = '<IIIHHBBH'
+
+# Digits and punctuation are formatted at run time, e.g. time and step count
+ALWAYS = set(range(0x20, 0x7F))
+
+C_STR = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+
+
+class PackError(Exception):
+    pass
+
+
+def fnv1a(s):
+    h = 0x811C9DC5
+    for b in s.encode('utf-8'):
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def c_unescape(s):
+    # Source is UTF-8, only unescape ASCII escapes so multi-byte characters survive
+    return re.sub(r'\\(x[0-9a-fA-F]{1,2}|u[0-9a-fA-F]{4}|.)',
+                  lambda m: (chr(int(m.group(1)[1:], 16)) if m.group(1)[0] in 'xu'
+                             else {'n': '\n', 't': '\t', 'r': '\r'}.get(m.group(1), m.group(1))), s)
+
+
+def strings_of(path):
+    ext = os.path.splitext(path)[1].lower()
+    with open(path, encoding='utf-8', errors='replace') as f:
+        text = f.read()
+    if ext == '.json':
+        out = []
+
+        def walk(v):
+            if isinstance(v, str):
+                out.append(v)
+            elif isinstance(v, dict):
+                for k, x in v.items():
+                    if k != 'locale':
+                        walk(x)
+            elif isinstance(v, list):
+                for x in v:
+                    walk(x)
+        walk(json.loads(text))
+        return out
+    if ext == '.xml':
+        return [v for e in ET.fromstring(text).iter() for v in list(e.attrib.values()) + [e.text or '']]
+    return [c_unescape(m.group(1)) for m in C_STR.finditer(text)]
+
+
+def lang_locale(path):
+    if path.lower().endswith('.json'):
+        with open(path, encoding='utf-8') as f:
+            obj = json.load(f)
+        if isinstance(obj, dict) and isinstance(obj.get('locale'), str):
+            return obj['locale']
+    return os.path.splitext(os.path.basename(path))[0]
+
+
+def source_files(paths):
+    for p in paths:
+        if os.path.isdir(p):
+            for root, _, files in os.walk(p):
+                for f in sorted(files):
+                    if os.path.splitext(f)[1].lower() in ('.c', '.h', '.xml', '.json'):
+                        yield os.path.join(root, f)
+        else:
+            yield p
+
+
+def collect_chars(langs, srcs):
+    """Return {locale: set of codepoints}, locale '' if no language pack given"""
+    common = set(ALWAYS)
+    for path in source_files(srcs):
+        for s in strings_of(path):
+            common.update(ord(c) for c in s)
+    used = {}
+    for path in langs:
+        chars = used.setdefault(lang_locale(path), set(common))
+        for s in strings_of(path):
+            chars.update(ord(c) for c in s)
+    if not used:
+        used[''] = common
+    for chars in used.values():
+        chars.difference_update(c for c in list(chars) if c < 0x20)
+    return used
+
+
+def subset_font(data, chars):
+    try:
+        from fontTools import subset
+        from fontTools.ttLib import TTFont
+    except ImportError:
+        raise PackError('fontTools required to subset fonts, pip install fonttools')
+    import io
+    opts = subset.Options()
+    opts.notdef_outline = True
+    opts.hinting = False          # FreeType autohinter is used on device
+    opts.name_IDs = []
+    opts.drop_tables += ['DSIG', 'GPOS', 'GSUB', 'GDEF']
+    font = TTFont(io.BytesIO(data))
+    sub = subset.Subsetter(opts)
+    sub.populate(unicodes=chars)
+    sub.subset(font)
+    glyphs = len(font.getGlyphOrder())
+    out = io.BytesIO()
+    font.save(out)
+    return out.getvalue(), glyphs
+
+
+def parse_named(items, what):
+    out = []
+    for item in items:
+        name, sep, path = item.partition('=')
+        if not sep:
+            path = name
+            name = os.path.splitext(os.path.basename(path))[0]
+        if not name or not os.path.isfile(path):
+            raise PackError('invalid %s "%s"' % (what, item))
+        out.append((name, path))
+    return out
+
+
+class Pool:
+    def __init__(self):
+        self.data = bytearray()
+        self.strs = {}
+
+    def add_str(self, s):
+        if s not in self.strs:
+            self.strs[s] = len(self.data)
+            self.data += s.encode('utf-8') + b'\0'
+        return self.strs[s]
+
+
+def pack(fonts, imgs, used, align):
+    """fonts/imgs are [(name, path)], return (bundle, report rows)"""
+    entries = []
+    report = []
+    for name, path in fonts:
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] not in (b'\x00\x01\x00\x00', b'true', b'OTTO'):
+            raise PackError('%s: not a TTF/OTF font' % path)
+        for locale, chars in sorted(used.items()):
+            sub, glyphs = subset_font(data, chars)
+            entries.append((TYPE_FONT, name, locale, sub))
+            report.append(('font', name, locale or '*', len(data), len(sub), '%d glyphs' % glyphs))
+    for name, path in imgs:
+        with open(path, 'rb') as f:
+            data = f.read()
+        if len(data) < 4:
+            raise PackError('%s: not an LVGL image' % path)
+        entries.append((TYPE_IMG, name, '', data))
+        report.append(('img', name, '*', len(data), len(data), ''))
+
+    if len(entries) > 0xFFFF:
+        raise PackError('too many entries')
+    keys = set()
+    for typ, name, locale, _ in entries:
+        if (typ, name, locale) in keys:
+            raise PackError('duplicated %s %s %s' % (TYPES[typ], name, locale))
+        keys.add((typ, name, locale))
+
+    pool = Pool()
+    table = []
+    for typ, name, locale, data in entries:
+        table.append([fnv1a(name), typ, pool.add_str(name), pool.add_str(locale) if locale else NO_STR, data])
+    if len(pool.data) > 0xFFFF:
+        raise PackError('string pool too large: %d bytes' % len(pool.data))
+    while len(pool.data) & 3:
+        pool.data += b'\0'
+    # Sorted by hash for binary search on device, entries of same name stay together
+    table.sort(key=lambda e: (e[0], e[1], e[2], e[3]))
+
+    def pad(n):
+        return (n + align - 1) // align * align
+
+    head_size = struct.calcsize(HEADER) + len(table) * struct.calcsize(ENTRY) + len(pool.data)
+    off = pad(head_size)
+    payloads = {}
+    offsets = []
+    for e in table:
+        # Same subset for several locales, e.g. Latin ones, is stored once
+        data = bytes(e[4])
+        if data not in payloads:
+            payloads[data] = off
+            off = pad(off + len(data))
+        offsets.append(payloads[data])
+
+    out = bytearray(struct.pack(HEADER, MAGIC, VERSION, len(table), align, len(pool.data), off))
+    for e, o in zip(table, offsets):
+        out += struct.pack(ENTRY, e[0], o, len(e[4]), e[2], e[3], e[1], 0, 0)
+    out += pool.data
+    for data, o in sorted(payloads.items(), key=lambda x: x[1]):
+        out += b'\0' * (o - len(out)) + data
+    out += b'\0' * (off - len(out))
+    return bytes(out), report
+
+
+def dump(data):
+    magic, ver, num, align, pool_size, total = struct.unpack_from(HEADER, data)
+    base = struct.calcsize(HEADER)
+    pool = data[base + num * struct.calcsize(ENTRY):]
+
+    def s(off):
+        return pool[off:pool.index(b'\0', off)].decode('utf-8') if off != NO_STR else '*'
+
+    print('version %d, %d entries, align %d, pool %d bytes, total %d bytes' % (ver, num, align, pool_size, total))
+    for i in range(num):
+        h, off, size, name, locale, typ, _, _ = struct.unpack_from(ENTRY, data, base + i * struct.calcsize(ENTRY))
+        print('%3d %08x %-4s %-24s %-8s 0x%08x %8d' % (i, h, TYPES[typ], s(name), s(locale), off, size))
+
+
+def print_report(report, bundle, fonts, imgs, used):
+    print('%-4s %-24s %-8s %10s %10s  %s' % ('type', 'name', 'locale', 'input', 'packed', ''))
+    for r in report:
+        print('%-4s %-24s %-8s %10d %10d  %s' % r)
+    full = sum(os.path.getsize(p) for _, p in fonts) + sum(os.path.getsize(p) for _, p in imgs)
+    print('flash: %d bytes of full fonts and images -> %d bytes bundle, saved %d bytes (%.1f%%)' %
+          (full, len(bundle), full - len(bundle), (full - len(bundle)) * 100.0 / max(full, 1)))
+    # Payloads are used in place, lv_img_dsc_t is the only RAM cost, fonts loaded by
+    # FT_New_Memory_Face need no copy and fewer glyphs shrink FreeType charmap and cache
+    print('ram: %d images need %d bytes of descriptors, fonts used in place (%d locales)' %
+          (len(imgs), len(imgs) * 12, len(used)))
+
+
+def to_c(data, name):
+    lines = ['/* Generated by respack.py, do not edit */',
+             '#include <rtthread.h>', '',
+             'ALIGN(64) const uint8_t %s[%d] =' % (name, len(data)), '{']
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    lines += ['};', '']
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack subset fonts and images to resource bundle')
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('--lang', action='append', default=[])
+    parser.add_argument('--src', action='append', default=[])
+    parser.add_argument('--font', action='append', default=[])
+    parser.add_argument('--img', action='append', default=[])
+    parser.add_argument('--img-dir')
+    parser.add_argument('--align', type=int, default=64)
+    parser.add_argument('--c', metavar='NAME')
+    parser.add_argument('--ranges', metavar='DIR')
+    parser.add_argument('--dump', action='store_true')
+    args = parser.parse_args()
+
+    if args.align < 4 or args.align & (args.align - 1):
+        sys.exit('align must be power of 2 and at least 4')
+
+    try:
+        used = collect_chars(args.lang, args.src)
+        fonts = parse_named(args.font, 'font')
+        imgs = parse_named(args.img, 'image')
+        if args.img_dir:
+            for root, _, files in os.walk(args.img_dir):
+                imgs += [(os.path.splitext(f)[0], os.path.join(root, f)) for f in sorted(files) if f.endswith('.bin')]
+        bundle, report = pack(fonts, imgs, used, args.align)
+    except (PackError, OSError, ValueError, ET.ParseError) as e:
+        sys.exit(str(e))
+
+    if args.ranges:
+        os.makedirs(args.ranges, exist_ok=True)
+        for locale, chars in used.items():
+            with open(os.path.join(args.ranges, (locale or 'all') + '.txt'), 'w', encoding='utf-8') as f:
+                f.write(''.join(chr(c) for c in sorted(chars)))
+
+    if args.c:
+        with open(args.output, 'w') as f:
+            f.write(to_c(bundle, args.c))
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(bundle)
+    if args.dump:
+        dump(bundle)
+    print_report(report, bundle, fonts, imgs, used)
+    print('%s: %d bytes' % (args.output, len(bundle)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+#
+# Post-link code size report: size per module and memory region, functions duplicating ROM code,
+# and hot functions per region as placement candidates
+#
+# usage: size_report.py <app.elf> [--map APP.map] [--rom ROM.sym ...] [--prof cpu_pc.log]
+#                       [--depth N] [--top N] [--json OUT] [--nm arm-none-eabi-nm]
+#   app.elf   linked image, GCC or armlink (fromelf --elf output works as well)
+#   --map     linker map, GCC "-Map" or armlink "--map --list", gives region names and modules
+#   --rom     ROM symbol table, e.g. drivers/hal/sifli_rom_52x.sym or the _gcc.sym variant
+#   --prof    console log with "cpu_pc dump" output, see middleware/cpu_usage_profiler/hot_func.py
+#   --depth   leading directories of object path used as module name, library is used if in an archive
+#
+# Without map file, regions are guessed from address.
+#
+
+import argparse
+import bisect
+import json
+import os
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..',
+                                'middleware', 'cpu_usage_profiler'))
+import hot_func  # noqa: E402
+
+# Used if map file doesn't list memory regions
+DEFAULT_REGIONS = (
+    ('ROM', 0x00000000, 0x00100000),
+    ('XIP', 0x10000000, 0x10000000),
+    ('RAM', 0x20000000, 0x10000000),
+    ('XIP2', 0x60000000, 0x10000000),
+)
+
+RE_GCC_MEM = re.compile(r'^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+RE_GCC_SECT = re.compile(r'^ (\.[\w.$]+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+RE_GCC_CONT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+RE_ARM_ER = re.compile(r'Execution Region (\w+) \(Exec base: 0x([0-9a-fA-F]+),.*Max: 0x([0-9a-fA-F]+)')
+RE_ARM_SECT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+(?:0x[0-9a-fA-F]+|-)\s+0x([0-9a-fA-F]+)\s+'
+                         r'(Code|Data|Zero|PAD)\s+(RO|RW)\s+\d+\s+(\S+)\s+(\S+)')
+RE_SYM_ARM = re.compile(r'^0x([0-9a-fA-F]+)\s+[TtDdNn]\s+(\S+)')
+RE_SYM_GCC = re.compile(r'^(\S+)\s*=\s*0x([0-9a-fA-F]+)\s*;')
+# Not loaded to target
+SKIP_SECT = ('.debug', '.comment', '.ARM.attributes', '.stab', '.note', '.gnu')
+
+
+def module_name(obj, depth):
+    obj = obj.replace('\\', '/')
+    m = re.match(r'(.*?\.(?:a|lib))\((.*)\)$', obj)
+    if m:
+        return os.path.basename(m.group(1))
+    parts = [p for p in os.path.dirname(obj).split('/') if p not in ('', '.', '..', 'build')]
+    return '/'.join(parts[:depth]) if parts else os.path.basename(obj)
+
+
+def parse_map(path, depth):
+    """Return (regions, sections), section is (addr, size, name, module)"""
+    regions = []
+    sections = []
+    in_mem = False
+    pending = None
+    with open(path, 'r', errors='ignore') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            # GCC
+            if line.startswith('Memory Configuration'):
+                in_mem = True
+                continue
+            if in_mem:
+                if line.startswith('Linker script and memory map'):
+                    in_mem = False
+                    continue
+                m = RE_GCC_MEM.match(line)
+                if m and m.group(1) != 'Name' and m.group(1) != '*default*':
+                    regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+                continue
+            if pending:
+                m = RE_GCC_CONT.match(line)
+                if m:
+                    addr, size = int(m.group(1), 16), int(m.group(2), 16)
+                    if size:
+                        sections.append((addr, size, pending, module_name(m.group(3), depth)))
+                pending = None
+                continue
+            m = RE_GCC_SECT.match(line)
+            if m:
+                if m.group(1).startswith(SKIP_SECT):
+                    continue
+                if m.group(2) is None:
+                    pending = m.group(1)
+                else:
+                    addr, size = int(m.group(2), 16), int(m.group(3), 16)
+                    if size:
+                        sections.append((addr, size, m.group(1), module_name(m.group(4), depth)))
+                continue
+            # armlink
+            m = RE_ARM_ER.search(line)
+            if m:
+                regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+                continue
+            m = RE_ARM_SECT.match(line)
+            if m:
+                addr, size = int(m.group(1), 16), int(m.group(2), 16)
+                if size and m.group(3) != 'PAD':
+                    sections.append((addr, size, m.group(5), module_name(m.group(6), depth)))
+    return regions, sections
+
+
+def load_rom(paths):
+    rom = {}
+    for path in paths:
+        with open(path, 'r', errors='ignore') as f:
+            for line in f:
+                m = RE_SYM_ARM.match(line)
+                if m:
+                    rom[m.group(2)] = int(m.group(1), 16) & ~1
+                    continue
+                m = RE_SYM_GCC.match(line)
+                if m:
+                    rom[m.group(1)] = int(m.group(2), 16) & ~1
+    return rom
+
+
+def load_all_symbols(elf, nm):
+    out = subprocess.check_output([nm, '-S', '--defined-only', elf], universal_newlines=True)
+    syms = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 4:
+            continue
+        syms.append((int(fields[0], 16) & ~1, int(fields[1], 16), fields[2], fields[3]))
+    syms.sort()
+    return syms
+
+
+class Regions:
+    def __init__(self, regions):
+        # Overlapped regions (e.g. load and exec view), the smallest one wins
+        self.regions = sorted(regions or DEFAULT_REGIONS, key=lambda r: r[2])
+
+    def find(self, addr):
+        for name, base, size in self.regions:
+            if base <= addr < base + size:
+                return name
+        return 'other'
+
+
+def size_by_module(sections, regions):
+    table = {}
+    for addr, size, name, module in sections:
+        region = regions.find(addr)
+        m = table.setdefault(module, {})
+        m[region] = m.get(region, 0) + size
+    return table
+
+
+def size_by_symbol(syms, regions):
+    """Used without map file, module is unknown"""
+    table = {}
+    for addr, size, typ, name in syms:
+        if size:
+            region = regions.find(addr)
+            table[region] = table.get(region, 0) + size
+    return {'(all)': table}
+
+
+def rom_duplicates(syms, rom, regions):
+    dup = []
+    for addr, size, typ, name in syms:
+        if typ not in 'tTwW' or name not in rom or addr == rom[name]:
+            continue
+        dup.append({'name': name, 'size': size, 'region': regions.find(addr), 'addr': addr, 'rom': rom[name]})
+    dup.sort(key=lambda x: -x['size'])
+    return dup
+
+
+def hot_by_region(log, syms, regions, top):
+    funcs = [s for s in syms if s[2] in 'tTwW' and s[1]]
+    starts = [s[0] for s in funcs]
+    hot = {}
+    total = 0
+    for pc, count in log['bins'].items():
+        i = bisect.bisect_right(starts, pc) - 1
+        if i < 0 or pc >= funcs[i][0] + funcs[i][1]:
+            name, size = '0x%08x' % pc, 0
+        else:
+            name, size = funcs[i][3], funcs[i][1]
+        region = regions.find(pc)
+        f = hot.setdefault(region, {}).setdefault(name, [0, size])
+        f[0] += count
+        total += count
+    result = {}
+    for region, fs in hot.items():
+        ranked = sorted(fs.items(), key=lambda x: -x[1][0])
+        result[region] = {
+            'samples': sum(c for c, _ in fs.values()),
+            'top': [{'name': n, 'samples': c, 'size': s} for n, (c, s) in ranked[:top]],
+        }
+    return result, total
+
+
+def print_modules(table):
+    regions = sorted({r for m in table.values() for r in m})
+    print('%-32s' % 'module' + ''.join('%10s' % r for r in regions) + '%10s' % 'total')
+    totals = dict.fromkeys(regions, 0)
+    for module, m in sorted(table.items(), key=lambda x: -sum(x[1].values())):
+        print('%-32.32s' % module + ''.join('%10d' % m.get(r, 0) for r in regions) + '%10d' % sum(m.values()))
+        for r in regions:
+            totals[r] += m.get(r, 0)
+    print('%-32s' % 'total' + ''.join('%10d' % totals[r] for r in regions) + '%10d' % sum(totals.values()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Code size per module and region, ROM reuse and placement')
+    parser.add_argument('elf')
+    parser.add_argument('--map')
+    parser.add_argument('--rom', action='append', default=[])
+    parser.add_argument('--prof')
+    parser.add_argument('--depth', type=int, default=2)
+    parser.add_argument('--top', type=int, default=20)
+    parser.add_argument('--json')
+    parser.add_argument('--nm', default='arm-none-eabi-nm')
+    args = parser.parse_args()
+
+    syms = load_all_symbols(args.elf, args.nm)
+    if args.map:
+        map_regions, sections = parse_map(args.map, args.depth)
+        regions = Regions(map_regions)
+        modules = size_by_module(sections, regions)
+    else:
+        regions = Regions(None)
+        modules = size_by_symbol(syms, regions)
+    report = {'modules': modules}
+
+    print('== size per module and region (bytes)')
+    print_modules(modules)
+
+    if args.rom:
+        dup = rom_duplicates(syms, load_rom(args.rom), regions)
+        report['rom_duplicates'] = dup
+        print('\n== functions also in ROM, %d bytes could be saved by binding to ROM' % sum(d['size'] for d in dup))
+        print('%8s %-8s %10s %10s  %s' % ('size', 'region', 'addr', 'rom', 'function'))
+        for d in dup[:args.top]:
+            print('%8d %-8s 0x%08x 0x%08x  %s' % (d['size'], d['region'], d['addr'], d['rom'], d['name']))
+
+    if args.prof:
+        hot, total = hot_by_region(hot_func.parse_log(args.prof), syms, regions, args.top)
+        report['hot'] = hot
+        print('\n== hot functions per region, %d samples' % total)
+        for region, h in sorted(hot.items(), key=lambda x: -x[1]['samples']):
+            print('-- %s: %d samples (%.1f%%)' % (region, h['samples'], h['samples'] * 100.0 / max(total, 1)))
+            cum_size = 0
+            for f in h['top']:
+                cum_size += f['size']
+                print('%8d %6.1f%% %8d %8d  %s' % (f['samples'], f['samples'] * 100.0 / max(total, 1),
+                                                   f['size'], cum_size, f['name']))
+        print('Place hot XIP functions in RAM with hot_func.py --budget --ld/--sct')
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(report, f, indent=1)
+
+
+if __name__ == '__main__':
+    main()